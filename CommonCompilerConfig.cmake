@@ -395,7 +395,7 @@ else()
 	set(COMMON_OS_LIBS ${extra_lib_for_filesystem})
 
 	if("${PLATFORM}" STREQUAL "linux")
-	  list(APPEND COMMON_OS_LIBS pthread dl)
+	  list(APPEND COMMON_OS_LIBS pthread dl rt)  # rt: shm_open before glibc 2.34
 	elseif("${PLATFORM}" STREQUAL "darwin")
 	  list(APPEND COMMON_OS_LIBS c++abi)
 	elseif(MSYS OR MINGW)
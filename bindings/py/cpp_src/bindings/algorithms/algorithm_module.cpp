@@ -32,6 +32,7 @@ namespace htm_ext
     void init_TemporalMemory(py::module&);
     void init_SDR_Classifier(py::module&);
     void init_Spatial_Pooler(py::module&);
+    void init_ParameterSweep(py::module&);
 
 } // namespace htm_ext
 
@@ -44,4 +45,5 @@ PYBIND11_MODULE(algorithms, m) {
     init_TemporalMemory(m);
     init_SDR_Classifier(m);
     init_Spatial_Pooler(m);
+    init_ParameterSweep(m);
 }
@@ -25,8 +25,10 @@
 #include <pybind11/numpy.h>
 #include <pybind11/stl.h>
 
+#include <memory>
 #include <string>
 #include <sstream>
+#include <vector>
 
 #include <htm/algorithms/Connections.hpp>
 
@@ -35,6 +37,29 @@ using namespace htm;
 
 namespace htm_ext
 {
+  // A numpy array which owns the vector, without copying it.
+  template<typename T>
+  static py::array_t<T> ownedArray_(std::vector<T> &&values) {
+    auto owner = new std::vector<T>(std::move(values));
+    py::capsule destructor(owner, [](void *ptr) { delete static_cast<std::vector<T>*>(ptr); });
+    return py::array_t<T>(owner->size(), owner->data(), destructor);
+  }
+
+  // A read-only numpy array over a snapshot of the Connections' topology.
+  template<typename T>
+  static py::array_t<T> viewArray_(const T *data, const size_t size, const std::shared_ptr<const void> &owner) {
+    auto holder = new std::shared_ptr<const void>(owner);
+    py::capsule destructor(holder, [](void *ptr) { delete static_cast<std::shared_ptr<const void>*>(ptr); });
+    py::array_t<T> array(size, data, destructor);
+    array.attr("setflags")(py::arg("write") = false);
+    return array;
+  }
+
+  template<typename T>
+  static std::vector<T> toVector_(const py::array_t<T, py::array::c_style | py::array::forcecast> &array) {
+    return std::vector<T>(array.data(), array.data() + array.size());
+  }
+
   void init_Connections(py::module& m)
   {
     py::class_<Connections> py_Connections(m, "Connections",
@@ -61,6 +86,86 @@ R"(Compatibility Warning: This classes API is unstable and may change without wa
         py::arg("presynaticCell"),
         py::arg("permanence"));
 
+    py_Connections.def("createSynapses", &Connections::createSynapses,
+        py::arg("segment"),
+        py::arg("presynapticCells"),
+        py::arg("permanences"));
+
+    py_Connections.def("bulkLoad",
+        [](Connections &self,
+           const py::array_t<CellIdx,    py::array::c_style | py::array::forcecast> &segmentCells,
+           const py::array_t<Synapse,    py::array::c_style | py::array::forcecast> &synapseOffsets,
+           const py::array_t<CellIdx,    py::array::c_style | py::array::forcecast> &presynapticCells,
+           const py::array_t<Permanence, py::array::c_style | py::array::forcecast> &permanences,
+           const py::array_t<UInt32,     py::array::c_style | py::array::forcecast> &lastUsed) {
+            self.bulkLoad(toVector_(segmentCells), toVector_(synapseOffsets),
+                          toVector_(presynapticCells), toVector_(permanences), toVector_(lastUsed));
+        },
+        py::arg("segmentCells"),
+        py::arg("synapseOffsets"),
+        py::arg("presynapticCells"),
+        py::arg("permanences"),
+        py::arg("lastUsed") = py::array_t<UInt32>(0),
+R"(Builds all segments and synapses of an empty Connections at once, from
+numpy arrays in the CSR layout of bulkExport(). lastUsed is optional.)");
+
+    py_Connections.def("bulkExport",
+        [](const Connections &self) {
+            std::vector<CellIdx> segmentCells, presynapticCells;
+            std::vector<Synapse> synapseOffsets;
+            std::vector<Permanence> permanences;
+            std::vector<UInt32> lastUsed;
+            self.bulkExport(segmentCells, synapseOffsets, presynapticCells, permanences, lastUsed);
+            return py::make_tuple(ownedArray_(std::move(segmentCells)),
+                                  ownedArray_(std::move(synapseOffsets)),
+                                  ownedArray_(std::move(presynapticCells)),
+                                  ownedArray_(std::move(permanences)),
+                                  ownedArray_(std::move(lastUsed)));
+        },
+R"(Returns all existing segments and synapses as numpy arrays, in one call:
+    (segmentCells, synapseOffsets, presynapticCells, permanences, lastUsed)
+The synapses of segment i are [synapseOffsets[i], synapseOffsets[i+1]).
+bulkLoad() into an empty Connections rebuilds the model from them, edited or not.)");
+
+    py_Connections.def("presynapticCellsArray",
+        [](const Connections &self) {
+            const auto view = self.synapseArrays();
+            return viewArray_(view.presynapticCell, view.size, view.owner); },
+R"(The presynaptic cell of every synapse, indexed by Synapse, incl. the destroyed
+ones. A read-only view without copying, of the model as it is now: learning
+afterwards copies the model first, so drop the arrays before learning.)");
+
+    py_Connections.def("segmentForSynapseArray",
+        [](const Connections &self) {
+            const auto view = self.synapseArrays();
+            return viewArray_(view.segment, view.size, view.owner); },
+R"(The segment of every synapse, indexed by Synapse, see presynapticCellsArray().)");
+
+    py_Connections.def("permanencesArray",
+        [](const Connections &self) -> py::array_t<Permanence> {
+            const auto view = self.synapseArrays();
+            if( view.permanence != nullptr )
+                return viewArray_(view.permanence, view.size, view.owner);
+            return ownedArray_(self.synapsePermanences()); },
+R"(The permanence of every synapse, indexed by Synapse, -1 if destroyed. A view
+as presynapticCellsArray() for float32 precision, else a copy.)");
+
+    py_Connections.def("cellForSegmentArray",
+        [](const Connections &self) {
+            std::vector<CellIdx> cells;
+            std::vector<UInt32> lastUsed;
+            self.segmentArrays(cells, lastUsed);
+            return ownedArray_(std::move(cells)); },
+R"(The cell of every segment, indexed by Segment, numCells() if destroyed.)");
+
+    py_Connections.def("lastUsedArray",
+        [](const Connections &self) {
+            std::vector<CellIdx> cells;
+            std::vector<UInt32> lastUsed;
+            self.segmentArrays(cells, lastUsed);
+            return ownedArray_(std::move(lastUsed)); },
+R"(The lastUsed iteration of every segment, indexed by Segment.)");
+
     py_Connections.def("growSynapses", &Connections::growSynapses,
         py::arg("segment"),
 	py::arg("growthCandidates"),
@@ -90,12 +195,12 @@ R"(Compatibility Warning: This classes API is unstable and may change without wa
 
     py_Connections.def("permanenceForSynapse",
         [](Connections &self, Synapse idx) {
-            auto &synData = self.dataForSynapse( idx );
+            const auto synData = self.dataForSynapse( idx );
             return synData.permanence; });
 
     py_Connections.def("presynapticCellForSynapse",
         [](Connections &self, Synapse idx) {
-            auto &synData = self.dataForSynapse( idx );
+            const auto synData = self.dataForSynapse( idx );
             return synData.presynapticCell; });
 
     py_Connections.def("getSegment", &Connections::getSegment);
@@ -108,8 +213,12 @@ R"(Compatibility Warning: This classes API is unstable and may change without wa
 
     py_Connections.def("computeActivity",
         [](Connections &self, SDR &activePresynapticCells, bool learn=true) {
-            // Call the C++ method.
-            auto activeConnectedSynapses = self.computeActivity(activePresynapticCells.getSparse(), learn);
+            // Call the C++ method, other Python threads may run meanwhile.
+            std::vector<SynapseIdx> activeConnectedSynapses;
+            {
+                py::gil_scoped_release release;
+                activeConnectedSynapses = self.computeActivity(activePresynapticCells.getSparse(), learn);
+            }
             // Wrap vector in numpy array.
             return py::array(activeConnectedSynapses.size(),
                              activeConnectedSynapses.data());
@@ -124,10 +233,14 @@ R"(Returns numActiveConnectedSynapsesForSegment)");
             auto potentialDestructor = py::capsule( activePotentialSynapses,
                 [](void *dataPtr) { 
 		delete reinterpret_cast<std::vector<SynapseIdx>*>(dataPtr);});
-            // Call the C++ method.
-            auto activeConnectedSynapses = self.computeActivity(*activePotentialSynapses,
+            // Call the C++ method, other Python threads may run meanwhile.
+            std::vector<SynapseIdx> activeConnectedSynapses;
+            {
+                py::gil_scoped_release release;
+                activeConnectedSynapses = self.computeActivity(*activePotentialSynapses,
                                             activePresynapticCells.getSparse(), 
 					    learn);
+            }
             // Wrap vector in numpy array.
             return py::make_tuple(
                     py::array(activeConnectedSynapses.size(),
@@ -169,6 +282,9 @@ R"(Returns pair of:
     py_Connections.def("numSynapses",
         [](Connections &self, Segment seg) { return self.numSynapses(seg); });
 
+    py_Connections.def("memoryUsage", &Connections::memoryUsage,
+        "Bytes of memory by category: cells, segments, synapses, presynapticMaps, flatIndex, caches.");
+
     py_Connections.def("numConnectedSynapses",
         [](Connections &self, Segment seg) {
             auto &segData = self.dataForSegment( seg );
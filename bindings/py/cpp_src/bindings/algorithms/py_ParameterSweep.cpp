@@ -0,0 +1,155 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * PyBind11 bindings for ParameterSweep class
+ */
+
+#include <bindings/suppress_register.hpp>  //include before pybind11.h
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <sstream>
+
+#include <htm/algorithms/ParameterSweep.hpp>
+
+namespace htm_ext
+{
+    namespace py = pybind11;
+    using namespace std;
+    using namespace htm;
+
+    void init_ParameterSweep(py::module& m)
+    {
+        py::class_<EncodedDataset> py_Dataset(m, "EncodedDataset",
+R"(A sequence of encoded records, optionally labeled, for a ParameterSweep.
+Encode the dataset once, the sweep shares it between all configurations.
+
+Example Usage:
+    data = EncodedDataset( encoder.dimensions )
+    for value, label in rows:
+        data.add( encoder.encode( value ), label )
+)");
+
+        py_Dataset.def(py::init<const vector<UInt>&>(), py::arg("dimensions"));
+
+        py_Dataset.def("add", &EncodedDataset::add,
+R"(Append a record, an SDR of the dimensions of the dataset. Without a label
+the record does not count for the accuracy.)",
+            py::arg("record"), py::arg("label") = EncodedDataset::NO_LABEL);
+
+        py_Dataset.def("__len__", &EncodedDataset::size);
+
+        py_Dataset.def("__getitem__", [](const EncodedDataset &self, size_t i) {
+            if (i >= self.size()) throw py::index_error();
+            SDR record(self.getDimensions());
+            self[i].copyTo(record);
+            return record;
+        }, "A copy of record i.");
+
+        py_Dataset.def("getLabel", &EncodedDataset::getLabel);
+        py_Dataset.def_property_readonly("dimensions", &EncodedDataset::getDimensions);
+        py_Dataset.def_readonly_static("NO_LABEL", &EncodedDataset::NO_LABEL);
+
+
+        py::class_<SweepConfig> py_Config(m, "SweepConfig",
+R"(The parameters of one SpatialPooler, and optionally of a TemporalMemory on
+its active columns, as in their constructors, for a ParameterSweep.)");
+
+        py_Config.def(py::init<>());
+        py_Config.def_readwrite("name",                      &SweepConfig::name);
+        py_Config.def_readwrite("columnDimensions",          &SweepConfig::columnDimensions);
+        py_Config.def_readwrite("potentialRadius",           &SweepConfig::potentialRadius);
+        py_Config.def_readwrite("potentialPct",              &SweepConfig::potentialPct);
+        py_Config.def_readwrite("globalInhibition",          &SweepConfig::globalInhibition);
+        py_Config.def_readwrite("localAreaDensity",          &SweepConfig::localAreaDensity);
+        py_Config.def_readwrite("stimulusThreshold",         &SweepConfig::stimulusThreshold);
+        py_Config.def_readwrite("synPermInactiveDec",        &SweepConfig::synPermInactiveDec);
+        py_Config.def_readwrite("synPermActiveInc",          &SweepConfig::synPermActiveInc);
+        py_Config.def_readwrite("synPermConnected",          &SweepConfig::synPermConnected);
+        py_Config.def_readwrite("minPctOverlapDutyCycles",   &SweepConfig::minPctOverlapDutyCycles);
+        py_Config.def_readwrite("dutyCyclePeriod",           &SweepConfig::dutyCyclePeriod);
+        py_Config.def_readwrite("boostStrength",             &SweepConfig::boostStrength);
+        py_Config.def_readwrite("wrapAround",                &SweepConfig::wrapAround);
+        py_Config.def_readwrite("seed",                      &SweepConfig::seed);
+        py_Config.def_readwrite("useTM",                     &SweepConfig::useTM);
+        py_Config.def_readwrite("cellsPerColumn",            &SweepConfig::cellsPerColumn);
+        py_Config.def_readwrite("activationThreshold",       &SweepConfig::activationThreshold);
+        py_Config.def_readwrite("initialPermanence",         &SweepConfig::initialPermanence);
+        py_Config.def_readwrite("connectedPermanence",       &SweepConfig::connectedPermanence);
+        py_Config.def_readwrite("minThreshold",              &SweepConfig::minThreshold);
+        py_Config.def_readwrite("maxNewSynapseCount",        &SweepConfig::maxNewSynapseCount);
+        py_Config.def_readwrite("permanenceIncrement",       &SweepConfig::permanenceIncrement);
+        py_Config.def_readwrite("permanenceDecrement",       &SweepConfig::permanenceDecrement);
+        py_Config.def_readwrite("predictedSegmentDecrement", &SweepConfig::predictedSegmentDecrement);
+        py_Config.def_readwrite("maxSegmentsPerCell",        &SweepConfig::maxSegmentsPerCell);
+        py_Config.def_readwrite("maxSynapsesPerSegment",     &SweepConfig::maxSynapsesPerSegment);
+        py_Config.def_readwrite("classifierAlpha",           &SweepConfig::classifierAlpha);
+        py_Config.def_readwrite("epochs",                    &SweepConfig::epochs);
+
+
+        py::class_<SweepResult> py_Result(m, "SweepResult",
+R"(How one configuration of a ParameterSweep did on the test records. A metric
+which does not apply (no labels, no TM) is NaN.)");
+
+        py_Result.def_readonly("name",             &SweepResult::name);
+        py_Result.def_readonly("accuracy",         &SweepResult::accuracy);
+        py_Result.def_readonly("meanAnomaly",      &SweepResult::meanAnomaly);
+        py_Result.def_readonly("spSparsity",       &SweepResult::spSparsity);
+        py_Result.def_readonly("spEntropy",        &SweepResult::spEntropy);
+        py_Result.def_readonly("trainSeconds",     &SweepResult::trainSeconds);
+        py_Result.def_readonly("testSeconds",      &SweepResult::testSeconds);
+        py_Result.def_readonly("recordsPerSecond", &SweepResult::recordsPerSecond);
+        py_Result.def("__str__", [](const SweepResult &self) {
+            stringstream buf;
+            buf << self;
+            return buf.str();
+        });
+
+
+        py::class_<ParameterSweep> py_Sweep(m, "ParameterSweep",
+R"(Trains and tests many SpatialPooler / TemporalMemory configurations on one
+encoded dataset, in parallel threads.
+
+Each configuration learns on the first numTrain records, for config.epochs
+passes, then runs on the rest without learning. The results are the accuracy
+of a Classifier of the SP's active columns, the mean anomaly of the TM, the
+sparsity and entropy of the SP's active columns, and the throughput.
+
+Example Usage:
+    configs = []
+    for inc in [0.01, 0.03, 0.05]:
+        c = SweepConfig()
+        c.name = "inc=%g" % inc
+        c.synPermActiveInc = inc
+        configs.append( c )
+    sweep = ParameterSweep( data, numTrain = len(data) * 4 // 5 )
+    for result in sweep.run( configs ):
+        print( result )
+)");
+
+        py_Sweep.def(py::init<const EncodedDataset&, size_t, size_t>(),
+            py::arg("data"), py::arg("numTrain"), py::arg("numThreads") = 0u,
+            py::keep_alive<1, 2>());
+
+        py_Sweep.def("run",
+            py::overload_cast<const vector<SweepConfig>&>(&ParameterSweep::run, py::const_),
+            "Run all configurations in parallel, results in the same order.",
+            py::arg("configs"), py::call_guard<py::gil_scoped_release>());
+    }
+
+} // namespace htm_ext
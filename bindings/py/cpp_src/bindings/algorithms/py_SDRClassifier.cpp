@@ -80,7 +80,7 @@ R"(Argument alpha is used to adapt the weight matrix during learning.
 A larger alpha results in faster adaptation to the data.)",
             py::arg("alpha") = 0.001);
 
-        py_Classifier.def("infer", &Classifier::infer,
+        py_Classifier.def("infer", (PDF (Classifier::*)(const SDR &) const) &Classifier::infer,
 R"(Compute the likelihoods for each category / bucket.
 
 Argument pattern is the SDR containing the active input bits.
@@ -90,7 +90,20 @@ The PDF is a list of probablilities which sums to 1.  Each index in this list is
 a category label, and each value is the likelihood of the that category.
 Use "numpy.argmax" to find the category with the greatest probablility.)",
 
-            py::arg("pattern"));
+            py::arg("pattern"),
+            py::call_guard<py::gil_scoped_release>());
+
+        py_Classifier.def("inferTopK", &Classifier::inferTopK,
+R"(Compute only the k most likely categories.
+
+Returns a list of (category, probability) pairs, the most likely first.
+Faster than infer() when there are many categories.)",
+            py::arg("pattern"), py::arg("k") = 1u,
+            py::call_guard<py::gil_scoped_release>());
+
+        py_Classifier.def_property("fastSoftmax", &Classifier::getFastSoftmax, &Classifier::setFastSoftmax,
+R"(Compute the softmax with a vectorized approximation of exp(), default True.
+False reproduces the results of older versions exactly.)");
 
         py_Classifier.def("learn", &Classifier::learn,
 R"(Learn from example data.
@@ -100,12 +113,17 @@ Argument pattern is the SDR containing the active input bits.
 Argument classification is the current category or bucket index.
 This may also be a list for when the input has multiple categories.)",
                 py::arg("pattern"),
-                py::arg("classification"));
+                py::arg("classification"),
+                py::call_guard<py::gil_scoped_release>());
 
         py_Classifier.def("learn", [](Classifier &self, const SDR &pattern, UInt categoryIdx)
             { self.learn( pattern, {categoryIdx} ); },
                 py::arg("pattern"),
-                py::arg("classification"));
+                py::arg("classification"),
+                py::call_guard<py::gil_scoped_release>());
+
+        py_Classifier.def("memoryUsage", &Classifier::memoryUsage,
+            "Bytes of memory by category: weights, caches.");
 
         // TODO: Pickle support
 
@@ -166,7 +184,19 @@ Argument pattern is the SDR containing the active input bits.
 
 Returns a dictionary whos keys are prediction steps, and values are PDFs.
 See help(Classifier.infer) for details about PDFs.)",
-            py::arg("pattern"));
+            py::arg("pattern"),
+            py::call_guard<py::gil_scoped_release>());
+
+        py_Predictor.def("inferTopK", &Predictor::inferTopK,
+R"(Compute the k most likely categories for each prediction step.
+
+Returns a dictionary whos keys are prediction steps, and values are lists of
+(category, probability) pairs. See help(Classifier.inferTopK).)",
+            py::arg("pattern"), py::arg("k") = 1u,
+            py::call_guard<py::gil_scoped_release>());
+
+        py_Predictor.def_property("fastSoftmax", &Predictor::getFastSoftmax, &Predictor::setFastSoftmax,
+R"(See help(Classifier.fastSoftmax), for the classifiers of all steps.)");
 
         py_Predictor.def("learn", &Predictor::learn,
 R"(Learn from example data.
@@ -180,13 +210,18 @@ Argument classification is the current category or bucket index.
 This may also be a list for when the input has multiple categories.)",
             py::arg("recordNum"),
             py::arg("pattern"),
-            py::arg("classification"));
+            py::arg("classification"),
+            py::call_guard<py::gil_scoped_release>());
 
         py_Predictor.def("learn", [](Predictor &self, UInt recordNum, const SDR &pattern, UInt categoryIdx)
             { self.learn( recordNum, pattern, {categoryIdx} ); },
                 py::arg("recordNum"),
                 py::arg("pattern"),
-                py::arg("classification"));
+                py::arg("classification"),
+                py::call_guard<py::gil_scoped_release>());
+
+        py_Predictor.def("memoryUsage", &Predictor::memoryUsage,
+            "Bytes of memory by category: history, weights, caches.");
 
         // TODO: Pickle support
     }
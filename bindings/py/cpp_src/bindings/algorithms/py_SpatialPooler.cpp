@@ -62,7 +62,8 @@ using namespace htm;
             , Real
             , Int
             , UInt
-            , bool>()
+            , bool
+            , Random::Engine>()
             , py::call_guard<py::scoped_ostream_redirect,
                              py::scoped_estream_redirect>(),
 R"(
@@ -182,6 +183,10 @@ Argument spVerbosity spVerbosity level: 0, 1, 2, or 3
 Argument wrapAround boolean value that determines whether or not inputs
         at the beginning and end of an input dimension are considered
         neighbors for the purpose of mapping inputs to columns.
+
+Argument rngEngine Random.Engine.MT19937 (default) or Random.Engine.COUNTER,
+        which gives every column its own random stream so that the columns
+        can be initialized in parallel, see SpatialPooler.hpp.
 )"
             , py::arg("inputDimensions") = vector<UInt>({ 32, 32 })
             , py::arg("columnDimensions") = vector<UInt>({ 64, 64 })
@@ -200,6 +205,7 @@ Argument wrapAround boolean value that determines whether or not inputs
             , py::arg("seed") = 1
             , py::arg("spVerbosity") = 0
             , py::arg("wrapAround") = true
+            , py::arg("rngEngine") = Random::MT19937
         );
 
         py_SpatialPooler.def("getColumnDimensions", &SpatialPooler::getColumnDimensions);
@@ -276,7 +282,12 @@ Argument wrapAround boolean value that determines whether or not inputs
         // compute
         py_SpatialPooler.def("compute", [](SpatialPooler& self, const SDR& input, const bool learn, SDR& output)
             { 
-	      const auto& overlaps = self.compute( input, learn, output ); 
+	      std::vector<SynapseIdx> overlaps;
+	      {
+	        // pure C++, other Python threads may run meanwhile
+	        py::gil_scoped_release release;
+	        overlaps = self.compute( input, learn, output );
+	      }
 	      return py::array_t<SynapseIdx>( overlaps.size(), overlaps.data());  
 	    },
 R"(
@@ -307,6 +318,61 @@ Argument output An SDR representing the winning columns after
         py::arg("output")
         ); 
 
+        py_SpatialPooler.def("compute_async", [](py::object self, py::object input, const bool learn, py::object output)
+            {
+              SpatialPooler &sp = self.cast<SpatialPooler &>();
+              const SDR &in = input.cast<const SDR &>();
+              SDR &out = output.cast<SDR &>();
+              auto overlaps = std::make_shared<std::vector<SynapseIdx>>();
+              return runAsync( &sp, py::make_tuple(self, input, output),
+                [&sp, &in, &out, learn, overlaps]() { *overlaps = sp.compute( in, learn, out ); },
+                [overlaps]() -> py::object { return py::array_t<SynapseIdx>( overlaps->size(), overlaps->data() ); });
+            },
+R"(Awaitable compute(), for asyncio: computes on a background thread and
+returns a future of the running event loop, resolved with the overlaps when
+the output SDR holds the active columns.  The computes of one SpatialPooler
+happen one at a time, in the order they were started.  Do not change the
+input or read the output until the future is done.)",
+        py::arg("input"),
+        py::arg("learn") = true,
+        py::arg("output"));
+
+        py_SpatialPooler.def("compute_many", [](SpatialPooler& self, py::object inputs, const bool learn)
+            {
+              const auto batch = toSDRBatch( inputs, self.getInputDimensions() );
+              py::array_t<Byte> result({ batch.size(), (size_t) self.getNumColumns() });
+              Byte *rows = result.mutable_data();
+              {
+                py::gil_scoped_release release;
+                if( learn ) {
+                  SDR active( self.getColumnDimensions() );
+                  for(size_t i = 0; i < batch.size(); i++) {
+                    self.compute( batch[i], true, active );
+                    storeDenseRow( rows, i, active );
+                  }
+                }
+                else {
+                  vector<SDR> outputs( batch.size(), SDR( self.getColumnDimensions() ));
+                  self.computeBatch( batch, outputs );
+                  for(size_t i = 0; i < outputs.size(); i++)
+                    storeDenseRow( rows, i, outputs[i] );
+                }
+              }
+              return result;
+            },
+R"(Computes a whole sequence of inputs in C++, with the GIL released.
+
+Argument inputs is a 2-D numpy array with one dense input per row, or a list
+of sparse index arrays.
+
+Argument learn as in compute(). Without learning the inputs are computed with
+computeBatch(), which uses the threads of setNumThreads().
+
+Returns a 2-D numpy array of uint8 with the active columns of each input per row,
+the same as calling compute() for every input in order.)",
+        py::arg("inputs"),
+        py::arg("learn") = true);
+
         // setBoostFactors
         py_SpatialPooler.def("setBoostFactors", [](SpatialPooler& self, py::array& x)
         {
@@ -430,6 +496,9 @@ Argument output An SDR representing the winning columns after
 
         py_SpatialPooler.def_property_readonly("connections", &SpatialPooler::getConnections, "SP's internal connections (read-only) Warning: the Connections is subject to change.");
 
+        py_SpatialPooler.def("memoryUsage", &SpatialPooler::memoryUsage,
+            "Bytes of memory by category: connections.*, dutyCycles, boostFactors, caches.");
+
         // pickle
         py_SpatialPooler.def(py::pickle(
             [](const SpatialPooler& sp) // __getstate__
@@ -236,12 +236,14 @@ Argument anomalyMode (optional, default ANMode::RAW) selects mode for `TM.anomal
         },
 R"(Calculate the active cells, using the current active columns and
 dendrite segments.  Grow and reinforce synapses.)"
-            , py::arg("activeColumns"), py::arg("learn") = true);
+            , py::arg("activeColumns"), py::arg("learn") = true,
+            py::call_guard<py::gil_scoped_release>());
 
         py_HTM.def("compute", [](HTM_t& self, const SDR &activeColumns, bool learn)
             { self.compute(activeColumns, learn); },
                 py::arg("activeColumns"),
-                py::arg("learn") = true);
+                py::arg("learn") = true,
+                py::call_guard<py::gil_scoped_release>());
 
         py_HTM.def("compute", [](HTM_t& self, const SDR &activeColumns, bool learn,
                                  const SDR &externalPredictiveInputsActive, const SDR &externalPredictiveInputsWinners)
@@ -270,7 +272,65 @@ Argument externalPredictiveInputsWinners
                 py::arg("activeColumns"),
                 py::arg("learn") = true,
                 py::arg("externalPredictiveInputsActive"),
-                py::arg("externalPredictiveInputsWinners"));
+                py::arg("externalPredictiveInputsWinners"),
+                py::call_guard<py::gil_scoped_release>());
+
+        py_HTM.def("compute_async", [](py::object self, py::object activeColumns, bool learn)
+            {
+              HTM_t &tm = self.cast<HTM_t &>();
+              const SDR &columns = activeColumns.cast<const SDR &>();
+              return runAsync( &tm, py::make_tuple(self, activeColumns),
+                [&tm, &columns, learn]() { tm.compute( columns, learn ); },
+                []() -> py::object { return py::none(); });
+            },
+R"(Awaitable compute(), for asyncio: computes on a background thread and
+returns a future of the running event loop, resolved with None when done.
+The computes of one TemporalMemory happen one at a time, in the order they
+were started.  Do not change activeColumns or use the TemporalMemory
+otherwise until the future is done.)",
+                py::arg("activeColumns"),
+                py::arg("learn") = true);
+
+        py_HTM.def("compute_sequence", [](HTM_t& self, py::object activeColumns, bool learn)
+            {
+              const auto batch = toSDRBatch( activeColumns, self.getColumnDimensions() );
+              auto dims = self.getColumnDimensions();
+              dims.push_back( static_cast<UInt32>(self.getCellsPerColumn()) );
+              const size_t numCells = self.numberOfCells();
+              py::array_t<Byte>  active({ batch.size(), numCells });
+              py::array_t<Byte>  predictive({ batch.size(), numCells });
+              py::array_t<Real>  anomaly( batch.size() );
+              Byte *activeRows     = active.mutable_data();
+              Byte *predictiveRows = predictive.mutable_data();
+              Real *anomalies      = anomaly.mutable_data();
+              {
+                py::gil_scoped_release release;
+                SDR cells( dims );
+                for(size_t i = 0; i < batch.size(); i++) {
+                  self.compute( batch[i], learn );
+                  anomalies[i] = self.anomaly;
+                  self.getActiveCells( cells );
+                  storeDenseRow( activeRows, i, cells );
+                  // Predictions for the next step; the next compute() reuses them.
+                  self.activateDendrites( learn );
+                  storeDenseRow( predictiveRows, i, self.getPredictiveCellsRef() );
+                }
+              }
+              return py::make_tuple( active, anomaly, predictive );
+            },
+R"(Computes a whole sequence of active columns in C++, with the GIL released.
+
+Argument activeColumns is a 2-D numpy array with one dense SDR of the columns per
+row, or a list of sparse index arrays.
+
+Argument learn as in compute().
+
+Returns a tuple (activeCells, anomaly, predictiveCells): 2-D uint8 arrays with the
+flattened cells of each step per row, and the anomaly of each step. The
+predictive cells of a row are the predictions for the next step. Results are the
+same as calling compute(), activateDendrites() and the getters in a loop.)",
+                py::arg("activeColumns"),
+                py::arg("learn") = true);
 
         py_HTM.def("reset", &HTM_t::reset,
 R"(Indicates the start of a new sequence.
@@ -289,7 +349,8 @@ Resets sequence state of the TM.)");
             SDR externalPredictiveInputs({ self.externalPredictiveInputs });
             self.activateDendrites(learn, externalPredictiveInputs, externalPredictiveInputs);
         },
-            py::arg("learn"));
+            py::arg("learn"),
+            py::call_guard<py::gil_scoped_release>());
 
         py_HTM.def("activateDendrites",
             [](HTM_t &self, bool learn,const SDR &externalPredictiveInputsActive, const SDR &externalPredictiveInputsWinners)
@@ -315,7 +376,8 @@ Argument externalPredictiveInputsWinners
 See TM.compute() for details of the parameters.)",
             py::arg("learn"),
             py::arg("externalPredictiveInputsActive"),
-            py::arg("externalPredictiveInputsWinners"));
+            py::arg("externalPredictiveInputsWinners"),
+            py::call_guard<py::gil_scoped_release>());
 
         py_HTM.def("getPredictiveCells", [](const HTM_t& self)
             { return self.getPredictiveCells();},
@@ -341,7 +403,7 @@ R"()");
 
         py_HTM.def("cellsForColumn", [](HTM_t& self, UInt columnIdx)
         {
-            auto cells = self.cellsForColumn(columnIdx);
+            const std::vector<htm::CellIdx> cells = self.cellsForColumn(columnIdx);
 
             return py::array_t<htm::UInt32>(cells.size(), cells.data());
         },
@@ -381,6 +443,9 @@ R"(Returns the number of cells in this TemporalMemory.)");
         py_HTM.def("numberOfColumns", &HTM_t::numberOfColumns,
 R"(Returns the total number of mini-columns.)");
 
+        py_HTM.def("memoryUsage", &HTM_t::memoryUsage,
+            "Bytes of memory by category: connections.*, cellState, caches, anomalyLikelihood.history.");
+
         py_HTM.def_property_readonly("connections", [](const HTM_t &self)
             { return self.connections; },
 R"(Internal Connections object. Danger!
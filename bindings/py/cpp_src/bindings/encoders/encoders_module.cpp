@@ -31,6 +31,8 @@ namespace htm_ext
     void init_RDSE(py::module&);
     void init_SimHashDocumentEncoder(py::module&);
     void init_DateEncoder(py::module&);
+    void init_CoordinateEncoder(py::module&);
+    void init_CategoryEncoder(py::module&);
 }
 
 using namespace htm_ext;
@@ -58,10 +60,16 @@ CategoryEncoders:
 
     To encode categories of input, make a ScalarEncoder or a Random Distributed
 Scalar Encoder (RDSE), and set the parameter category=True.  Then enumerate your
-categories into integers before encoding them. )";
+categories into integers before encoding them.
+
+    To encode categories given as strings, such as host names, use the
+CategoryEncoder.  It interns every category it sees, so that encoding a
+known category is a table lookup. )";
 
     init_ScalarEncoder(m);
     init_RDSE(m);
     init_SimHashDocumentEncoder(m);
     init_DateEncoder(m);
+    init_CoordinateEncoder(m);
+    init_CategoryEncoder(m);
 }
@@ -0,0 +1,127 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * py_CategoryEncoder.cpp
+ */
+
+#include <bindings/suppress_register.hpp>  //include before pybind11.h
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+#include <pybind11/iostream.h>
+
+#include <htm/encoders/CategoryEncoder.hpp>
+
+namespace py = pybind11;
+
+using namespace htm;
+using namespace std;
+
+namespace htm_ext
+{
+    void init_CategoryEncoder(py::module& m)
+    {
+        py::class_<CategoryEncoderParameters> py_CatArgs(m, "CategoryEncoderParameters",
+R"(Parameters for the CategoryEncoder
+
+Members "activeBits" & "sparsity" are mutually exclusive, specify exactly one
+of them.)");
+
+        py_CatArgs.def(py::init<>());
+
+        py_CatArgs.def_readwrite("size", &CategoryEncoderParameters::size,
+R"(Member "size" is the total number of bits in the encoded output SDR.)");
+
+        py_CatArgs.def_readwrite("activeBits", &CategoryEncoderParameters::activeBits,
+R"(Member "activeBits" is the number of true bits in the encoded output SDR.)");
+
+        py_CatArgs.def_readwrite("sparsity", &CategoryEncoderParameters::sparsity,
+R"(Member "sparsity" is the fraction of bits in the encoded output which this
+encoder will activate. This is an alternative way to specify the member
+"activeBits".)");
+
+        py_CatArgs.def_readwrite("seed", &CategoryEncoderParameters::seed,
+R"(Member "seed" forces different encoders to produce different outputs, even if
+the inputs and all other parameters are the same.  Two encoders with the same
+seed, parameters, and input will produce identical outputs.
+
+The seed 0 is special.  Seed 0 is replaced with a random number.)");
+
+        py_CatArgs.def_readwrite("maxCategories", &CategoryEncoderParameters::maxCategories,
+R"(Member "maxCategories" limits the number of categories which are interned.
+Categories seen after the table is full are hashed again every time they are
+encoded. The default 0 is no limit.)");
+
+
+        py::class_<CategoryEncoder> py_CatEnc(m, "CategoryEncoder",
+R"(Encodes a categorical value, such as a host name or a status code, as an SDR.
+
+Every category activates activeBits pseudo random bits, hashed from the
+category string. Different categories have unrelated encodings.
+
+The first time a category is seen it is interned: it is given the next
+category id, and its encoding is stored, so that encoding a known category is
+a table lookup and a copy.)");
+        py_CatEnc.def(py::init<CategoryEncoderParameters>());
+
+        py_CatEnc.def_property_readonly("parameters",
+            [](CategoryEncoder &self) { return self.parameters; },
+R"(Contains the parameter structure which this encoder uses internally. All
+fields are filled in automatically.)");
+
+        py_CatEnc.def_property_readonly("dimensions",
+            [](CategoryEncoder &self) { return self.dimensions; });
+        py_CatEnc.def_property_readonly("size",
+            [](CategoryEncoder &self) { return self.size; });
+
+        py_CatEnc.def_property_readonly("categories",
+            [](CategoryEncoder &self) { return self.categories; },
+R"(The interned categories, in order of their category ids.)");
+
+        py_CatEnc.def("getCategoryId", &CategoryEncoder::getCategoryId,
+R"(Returns the id of an interned category, or -1 if it is not interned.)");
+
+        py_CatEnc.def("encode", &CategoryEncoder::encode, R"()");
+
+        py_CatEnc.def("encode", [](CategoryEncoder &self, std::string category) {
+            auto sdr = new SDR({self.size});
+            self.encode(category, *sdr);
+            return sdr;
+        });
+
+        py_CatEnc.def("encodeBatch", [](CategoryEncoder &self, const std::vector<std::string> &column) {
+            std::vector<SDR> outputs( column.size(), SDR({self.size}) );
+            self.encodeBatch(column, outputs);
+            return outputs;
+        },
+R"(Encodes a column of categories, returns a list of SDRs.)");
+
+        // Serialization
+        // loadFromString
+        py_CatEnc.def("loadFromString", [](CategoryEncoder& self, const py::bytes& inString) {
+          std::stringstream inStream(inString.cast<std::string>());
+          self.load(inStream, JSON);
+        });
+
+        // writeToString
+        py_CatEnc.def("writeToString", [](const CategoryEncoder& self) {
+          std::ostringstream os;
+          self.save(os, JSON);
+          return py::bytes( os.str() );
+        });
+    }
+}
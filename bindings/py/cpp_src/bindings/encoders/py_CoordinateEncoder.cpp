@@ -0,0 +1,126 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * py_CoordinateEncoder.cpp
+ */
+
+#include <bindings/suppress_register.hpp>  //include before pybind11.h
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+#include <pybind11/iostream.h>
+
+#include <htm/encoders/CoordinateEncoder.hpp>
+
+namespace py = pybind11;
+
+using namespace htm;
+using namespace std;
+
+namespace htm_ext
+{
+    void init_CoordinateEncoder(py::module& m)
+    {
+        py::class_<CoordinateEncoderParameters> py_CoordArgs(m, "CoordinateEncoderParameters",
+R"(Parameters for the CoordinateEncoder
+
+Members "activeBits" & "sparsity" are mutually exclusive, specify exactly one
+of them.)");
+
+        py_CoordArgs.def(py::init<>());
+
+        py_CoordArgs.def_readwrite("size", &CoordinateEncoderParameters::size,
+R"(Member "size" is the total number of bits in the encoded output SDR.)");
+
+        py_CoordArgs.def_readwrite("activeBits", &CoordinateEncoderParameters::activeBits,
+R"(Member "activeBits" is the number of true bits in the encoded output SDR.)");
+
+        py_CoordArgs.def_readwrite("sparsity", &CoordinateEncoderParameters::sparsity,
+R"(Member "sparsity" is the fraction of bits in the encoded output which this
+encoder will activate. This is an alternative way to specify the member
+"activeBits".)");
+
+        py_CoordArgs.def_readwrite("numDimensions", &CoordinateEncoderParameters::numDimensions,
+R"(Member "numDimensions" is the number of coordinates of an input, for example
+2 for positions on a map.)");
+
+        py_CoordArgs.def_readwrite("radius", &CoordinateEncoderParameters::radius,
+R"(Member "radius" is the half width of the neighborhood (a hypercube of
+2 * radius + 1 coordinates per side) which the active bits are chosen from.
+It must be large enough for the neighborhood to have at least activeBits
+points.)");
+
+        py_CoordArgs.def_readwrite("seed", &CoordinateEncoderParameters::seed,
+R"(Member "seed" forces different encoders to produce different outputs, even if
+the inputs and all other parameters are the same.  Two encoders with the same
+seed, parameters, and input will produce identical outputs.
+
+The seed 0 is special.  Seed 0 is replaced with a random number.)");
+
+        py_CoordArgs.def_readwrite("cacheSize", &CoordinateEncoderParameters::cacheSize,
+R"(Member "cacheSize" is the number of coordinates whose hashes are kept in a
+least-recently-used cache, so that consecutive nearby inputs only hash the
+coordinates which are new. The default 0 disables the cache.  This does not
+change the output encoding, and is not saved by serialization.)");
+
+
+        py::class_<CoordinateEncoder> py_CoordEnc(m, "CoordinateEncoder",
+R"(Encodes a point in an integer coordinate space, such as a position on a grid
+or a quantized GPS location, as an SDR.
+
+Every coordinate of the space is given a hashed rank and a hashed output bit.
+An input activates the bits of the activeBits highest ranked coordinates in
+its neighborhood, the hypercube of the given radius around it. Nearby inputs
+have overlapping neighborhoods, and so share some of their output bits.
+
+To encode real valued positions, scale them so that one unit is the desired
+resolution.)");
+        py_CoordEnc.def(py::init<CoordinateEncoderParameters>());
+
+        py_CoordEnc.def_property_readonly("parameters",
+            [](CoordinateEncoder &self) { return self.parameters; },
+R"(Contains the parameter structure which this encoder uses internally. All
+fields are filled in automatically.)");
+
+        py_CoordEnc.def_property_readonly("dimensions",
+            [](CoordinateEncoder &self) { return self.dimensions; });
+        py_CoordEnc.def_property_readonly("size",
+            [](CoordinateEncoder &self) { return self.size; });
+
+        py_CoordEnc.def("encode", &CoordinateEncoder::encode, R"()");
+
+        py_CoordEnc.def("encode", [](CoordinateEncoder &self, std::vector<Int64> coordinate) {
+            auto sdr = new SDR({self.size});
+            self.encode(coordinate, *sdr);
+            return sdr;
+        });
+
+        // Serialization
+        // loadFromString
+        py_CoordEnc.def("loadFromString", [](CoordinateEncoder& self, const py::bytes& inString) {
+          std::stringstream inStream(inString.cast<std::string>());
+          self.load(inStream, JSON);
+        });
+
+        // writeToString
+        py_CoordEnc.def("writeToString", [](const CoordinateEncoder& self) {
+          std::ostringstream os;
+          self.save(os, JSON);
+          return py::bytes( os.str() );
+        });
+    }
+}
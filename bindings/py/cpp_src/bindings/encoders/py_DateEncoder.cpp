@@ -25,10 +25,36 @@ namespace py = pybind11;
 #include <htm/encoders/DateEncoder.hpp>
 #include <htm/types/Sdr.hpp>
 
+#include <algorithm>
+#include <ctime>
+#include <limits>
+
+#include "bindings/engine/py_utils.hpp"
+
 namespace htm_ext
 {
   using namespace htm;
 
+  // A numpy.datetime64 in seconds is a wall clock time without time zone,
+  // like a naive datetime.datetime: the local time_t of the same wall clock.
+  static std::time_t wallClockToLocal(const int64_t seconds)
+  {
+    const int64_t secondOfDay = ((seconds % 86400) + 86400) % 86400;
+    // days since 1970-01-01 to the civil date, see
+    // http://howardhinnant.github.io/date_algorithms.html#civil_from_days
+    const int64_t days = (seconds - secondOfDay) / 86400 + 719468;
+    const int64_t era  = (days >= 0 ? days : days - 146096) / 146097;
+    const int64_t doe  = days - era * 146097;
+    const int64_t yoe  = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int64_t doy  = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const int64_t mp   = (5 * doy + 2) / 153;
+    const int     day  = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    const int     mon  = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    const int     year = static_cast<int>(yoe + era * 400 + (mon <= 2));
+    return DateEncoder::mktime(year, mon, day, static_cast<int>(secondOfDay / 3600),
+                               static_cast<int>(secondOfDay / 60 % 60), static_cast<int>(secondOfDay % 60));
+  }
+
   void init_DateEncoder(py::module& m)
   {
   
@@ -160,6 +186,33 @@ R"(Encodes a .py datetime.datetime into an SDR structure. )",
         self.encode( time_point, *output );
         return output; },
 R"(Encodes a .py datetime.datetime into an SDR structure. )");
+
+    py_DateEnc.def("encodeBatch", [](DateEncoder &self, py::array values, py::object dense) {
+        NTA_CHECK( values.ndim() == 1 ) << "Expected a 1-D array of times!";
+        const bool wallClock = values.dtype().kind() == 'M';
+        if( wallClock ) {
+          values = values.attr("astype")("datetime64[s]").attr("astype")("int64").cast<py::array>();
+        }
+        auto seconds = py::array_t<int64_t, py::array::c_style | py::array::forcecast>::ensure(values);
+        NTA_CHECK( seconds ) << "Expected an array of numpy.datetime64 or of seconds since the epoch!";
+        std::vector<std::time_t> inputs( seconds.data(), seconds.data() + seconds.size() );
+        if( wallClock ) {
+          NTA_CHECK( std::find( inputs.begin(), inputs.end(), std::numeric_limits<int64_t>::min() ) == inputs.end() )
+            << "NaT can not be encoded!";
+          std::transform( inputs.begin(), inputs.end(), inputs.begin(), wallClockToLocal );
+        }
+        return encodeBatch( self, inputs, dense ); },
+R"(Encodes a 1-D numpy array of times with one call, without the GIL.
+
+The values are numpy.datetime64, encoded like encode() of the same naive
+datetime.datetime; or integers of unix time (seconds since the epoch, UTC),
+which are encoded in local time, and 0 means now.
+
+Returns the encodings as CSR, a tuple (indptr, indices) of numpy arrays: the
+active bits of values[i] are indices[indptr[i] : indptr[i + 1]].  With
+argument "dense", a writable C ordered uint8 array of shape (len(values),
+size), writes one encoding per row into it and returns it.)",
+      py::arg("values"), py::arg("dense") = py::none());
   }
 
 }
@@ -18,9 +18,12 @@
 #include <bindings/suppress_register.hpp>  //include before pybind11.h
 #include <pybind11/pybind11.h>
 #include <pybind11/iostream.h>
+#include <pybind11/numpy.h>
 
 #include <htm/encoders/RandomDistributedScalarEncoder.hpp>
 
+#include "bindings/engine/py_utils.hpp"
+
 namespace py = pybind11;
 
 using namespace htm;
@@ -74,6 +77,12 @@ seed, parameters, and input will produce identical outputs.
 
 The seed 0 is special.  Seed 0 is replaced with a random number.)");
 
+        py_RDSE_args.def_readwrite("cacheSize", &RDSE_Parameters::cacheSize,
+R"(Member "cacheSize" is the maximum number of buckets whose encodings are
+memoized, so that encoding a value in a cached bucket skips hashing.  The cache
+fills lazily and stops growing once full.  The default 0 disables the cache.
+This does not change the output encoding, and is not saved by serialization.)");
+
 
         py::class_<RDSE> py_RDSE(m, "RDSE",
 R"(Encodes a real number as a set of randomly generated activations.
@@ -116,6 +125,21 @@ fields are filled in automatically.)");
             return sdr;
         });
 
+        py_RDSE.def("encodeBatch", [](RDSE &self, py::array_t<Real64, py::array::c_style | py::array::forcecast> values, py::object dense) {
+            NTA_CHECK( values.ndim() == 1 ) << "Expected a 1-D array of values!";
+            const std::vector<Real64> inputs( values.data(), values.data() + values.size() );
+            return encodeBatch( self, inputs, dense );
+        },
+R"(Encodes a 1-D numpy array of values with one call, without the GIL.
+
+Returns the encodings as CSR, a tuple (indptr, indices) of numpy arrays: the
+active bits of values[i] are indices[indptr[i] : indptr[i + 1]], e.g. for
+scipy.sparse.csr_matrix((numpy.ones(len(indices)), indices, indptr)).
+
+With argument "dense", a writable C ordered uint8 array of shape
+(len(values), size), writes one encoding per row into it and returns it.)",
+            py::arg("values"), py::arg("dense") = py::none());
+
 
 	// Serialization
 	// loadFromString
@@ -24,6 +24,8 @@ namespace py = pybind11;
 #include <htm/encoders/ScalarEncoder.hpp>
 #include <htm/types/Sdr.hpp>
 
+#include "bindings/engine/py_utils.hpp"
+
 namespace htm_ext
 {
   using namespace htm;
@@ -122,5 +124,19 @@ fields are filled in automatically.)");
         self.encode( value, *output );
         return output; },
 R"()");
+
+    py_ScalarEnc.def("encodeBatch", [](ScalarEncoder &self, py::array_t<Real64, py::array::c_style | py::array::forcecast> values, py::object dense) {
+        NTA_CHECK( values.ndim() == 1 ) << "Expected a 1-D array of values!";
+        const std::vector<Real64> inputs( values.data(), values.data() + values.size() );
+        return encodeBatch( self, inputs, dense ); },
+R"(Encodes a 1-D numpy array of values with one call, without the GIL.
+
+Returns the encodings as CSR, a tuple (indptr, indices) of numpy arrays: the
+active bits of values[i] are indices[indptr[i] : indptr[i + 1]], e.g. for
+scipy.sparse.csr_matrix((numpy.ones(len(indices)), indices, indptr)).
+
+With argument "dense", a writable C ordered uint8 array of shape
+(len(values), size), writes one encoding per row into it and returns it.)",
+      py::arg("values"), py::arg("dense") = py::none());
   }
 }
@@ -122,6 +122,14 @@ This is the total number of bits in the encoded output SDR.
 R"(
 This is an alternate way (percentage) to specify the the number of active bits.
 Specify only one of: activeBits or sparsity.
+)");
+
+    py_SimHashDocumentEncoderParameters.def_readwrite("tokenCacheSize",
+      &SimHashDocumentEncoderParameters::tokenCacheSize,
+R"(
+Number of token (and letter) hash digests kept in a least-recently-used cache,
+so that tokens which repeat across documents are only hashed once. A setting of
+0 disables the cache. This does not change the output encoding.
 )");
 
     py_SimHashDocumentEncoderParameters.def_readwrite("tokenSimilarity",
@@ -272,6 +280,27 @@ Documents can contain any number of tokens > 0. Token order in the document is
   `encodeOrphans` param. Tokens in the `exclude` list will always be discarded.
 )");
 
+    py_SimHashDocumentEncoder.def("encodeBatch",
+      [](SimHashDocumentEncoder &self, const std::vector<std::vector<std::string>> &documents) {
+        std::vector<SDR> outputs(documents.size(), SDR({ self.size }));
+        {
+          py::gil_scoped_release release;
+          self.encodeBatch( documents, outputs );
+        }
+        return outputs;
+      },
+R"(
+Encode a list of documents (each a list of token strings) into a list of SDRs,
+in the same order. With setNumThreads(n > 1) the documents are hashed in
+parallel, the results are those of encode().
+)");
+
+    py_SimHashDocumentEncoder.def("setNumThreads", &SimHashDocumentEncoder::setNumThreads,
+R"(
+Number of threads encodeBatch() uses, 0 or 1 is single threaded (default).
+)");
+    py_SimHashDocumentEncoder.def("getNumThreads", &SimHashDocumentEncoder::getNumThreads);
+
     /**
      * Serialization
      */
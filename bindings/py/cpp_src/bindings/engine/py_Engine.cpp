@@ -43,6 +43,8 @@ PyBind11 bindings for Engine classes
 #include <plugin/PyBindRegion.hpp>
 #include <plugin/RegisteredRegionImplPy.hpp>
 
+#include "bindings/engine/py_utils.hpp"
+
 namespace py = pybind11;
 using namespace htm;
 
@@ -264,6 +266,9 @@ namespace htm_ext
                 self.load(ss);
                 return self;
         }));
+        // Pickle protocol 5: out of band buffers, see reduceEx().
+        py_Region.def("__reduce_ex__", &htm_ext::reduceEx<Region>)
+            .def_static("_fromPickleBuffer", &htm_ext::fromPickleBuffer<Region>);
 
         py_Region.def("getSpec", &htm::Region::getSpec);
         
@@ -429,7 +434,53 @@ namespace htm_ext
             .def("getMinEnabledPhase", &htm::Network::getMinPhase)
             .def("getMaxEnabledPhase", &htm::Network::getMaxPhase)
             .def("setPhases",          &htm::Network::setPhases)
-            .def("run",                &htm::Network::run);
+            .def("run",                &htm::Network::run,
+                 "Runs n iterations. The GIL is released, Python regions take it back while they compute.",
+                 py::call_guard<py::gil_scoped_release>())
+            .def("run_async", [](py::object self, int n) {
+                    htm::Network &net = self.cast<htm::Network &>();
+                    return runAsync( &net, py::make_tuple(self), [&net, n]() { net.run(n); },
+                                     []() -> py::object { return py::none(); });
+                 },
+R"(Awaitable run(n), for asyncio: runs the n iterations on a background
+thread and returns a future of the running event loop, resolved with None
+when done.  The runs of one Network happen one at a time, in the order
+they were started; many Networks run in parallel.  Do not use the Network
+otherwise until the future is done.)",
+                 py::arg("n") = 1)
+            .def("setNumThreads",      &htm::Network::setNumThreads,
+                 "Compute the independent regions of a phase concurrently, see Network::setNumThreads. 0 or 1 is the serial run.")
+            .def("getNumThreads",      &htm::Network::getNumThreads)
+            .def("setBatchSize",       &htm::Network::setBatchSize,
+                 "Run n iterations at a time through Region.computeBatch, see Network::setBatchSize.")
+            .def("getBatchSize",       &htm::Network::getBatchSize)
+            .def("setIterationBudget", &htm::Network::setIterationBudget,
+                 "Degrade the regions of degradeOrder, first to last, when an iteration would take longer than seconds, see Network::setIterationBudget. 0 turns it off.",
+                 py::arg("seconds"), py::arg("degradeOrder") = std::vector<std::string>())
+            .def("getIterationBudget", &htm::Network::getIterationBudget)
+            .def("getDegradedComputes", &htm::Network::getDegradedComputes,
+                 "Dict of region name to the number of its degraded computes.")
+            .def("getDeadlineMisses",  &htm::Network::getDeadlineMisses)
+            .def("resetDegradationCounts", &htm::Network::resetDegradationCounts)
+            .def("startCapture",       &htm::Network::startCapture,
+                 "Capture the data of the INPUT outputs sources (all if empty) of each iteration into a binary log at path, see Network::startCapture.",
+                 py::arg("path"), py::arg("sources") = std::vector<std::string>())
+            .def("stopCapture",        &htm::Network::stopCapture,
+                 "Close the log of startCapture, returns the number of records.")
+            .def("isCapturing",        &htm::Network::isCapturing)
+            .def("replayCapture",      &htm::Network::replayCapture,
+                 "Run the records of a log of startCapture; speed 0 as fast as possible, else at the pace of the capture times speed. Returns the number of records run.",
+                 py::arg("path"), py::arg("speed") = 0.0, py::arg("maxRecords") = 0u,
+                 py::call_guard<py::gil_scoped_release>());
+
+        py_Network.def("enableProfiling",   &htm::Network::enableProfiling)
+            .def("disableProfiling",       &htm::Network::disableProfiling)
+            .def("resetProfiling",         &htm::Network::resetProfiling)
+            .def("getProfile",             &htm::Network::getProfile,
+                 "Latency histograms (count, mean, p50, p90, p99, max in seconds) of the regions, links and callbacks, as JSON.");
+
+        py_Network.def("memoryUsage", &htm::Network::memoryUsage,
+            "Bytes of memory by category, e.g. 'sp.connections.synapses', 'sp.outputs', 'links'.");
 
         py_Network.def("initialize", &htm::Network::initialize);
 
@@ -451,6 +502,8 @@ namespace htm_ext
                 self.load(ss);
                 return self;  
         }));
+        py_Network.def("__reduce_ex__", &htm_ext::reduceEx<Network>)
+            .def_static("_fromPickleBuffer", &htm_ext::fromPickleBuffer<Network>);
 
         py_Network.def("link", &htm::Network::link
             , "Defines a link between regions"
@@ -459,28 +512,53 @@ namespace htm_ext
             , py::arg("srcOutput") = "", py::arg("destInput") = ""
             , py::arg("propagationDelay") = 0);
             
-        py_Network.def("setInputData", [](Network& net, const std::string& name, py::buffer& b)
+        // The NTA_BasicType of the elements of a numpy buffer.
+        auto bufferType = [](const py::buffer_info& info) {
+                if      (((info.format == "i") || (info.format == "l") ) && info.itemsize == 4) return NTA_BasicType_Int32;
+                else if (((info.format == "I") || (info.format == "L") ) && info.itemsize == 4) return NTA_BasicType_UInt32;
+                else if ((info.format == "l") || (info.format == "q") ) return NTA_BasicType_Int64;
+                else if ((info.format == "L") || (info.format == "Q") ) return NTA_BasicType_UInt64;
+                else if (info.format == "f") return NTA_BasicType_Real32;
+                else if (info.format == "d") return NTA_BasicType_Real64;
+                else if (info.format == py::format_descriptor<bool>::format()) return NTA_BasicType_Bool;
+                else if (info.format == py::format_descriptor<Byte>::format()) return NTA_BasicType_Byte;
+                NTA_THROW << "setInputData(): Unexpected data type in the array!  info.format=" << info.format;
+                // for info.format codes, see https://docs.python.org/3.7/library/array.html
+        };
+
+        py_Network.def("setInputData", [bufferType](Network& net, const std::string& name, py::buffer& b)
             { 
                 // Set data into source of "INPUT" link at runtime.  Link must be previously declared.
                 py::buffer_info info = b.request();  /* Request a buffer descriptor from Python */
                 if (info.ndim != 1)
                     throw std::runtime_error("Expected a one dimensional array!");
-                size_t size = static_cast<size_t>(info.shape[0]);
-                NTA_BasicType type;
-                if      (((info.format == "i") || (info.format == "l") ) && info.itemsize == 4) type = NTA_BasicType_Int32;
-                else if (((info.format == "I") || (info.format == "L") ) && info.itemsize == 4) type = NTA_BasicType_UInt32;
-                else if ((info.format == "l") || (info.format == "q") ) type = NTA_BasicType_Int64;
-                else if ((info.format == "L") || (info.format == "Q") ) type = NTA_BasicType_UInt64;
-                else if (info.format == "f") type = NTA_BasicType_Real32;
-                else if (info.format == "d") type = NTA_BasicType_Real64;
-                else if (info.format == py::format_descriptor<bool>::format()) type = NTA_BasicType_Bool;
-                else if (info.format == py::format_descriptor<Byte>::format()) type = NTA_BasicType_Byte;
-                else NTA_THROW << "setInputData(): Unexpected data type in the array!  info.format=" << info.format;
-                // for info.format codes, see https://docs.python.org/3.7/library/array.html
-                Array s(type, info.ptr, size);
-                std::cout << "src: " << s << std::endl;
+                const size_t size = static_cast<size_t>(info.shape[0]);
+                if (info.strides[0] != info.itemsize)
+                    throw std::runtime_error("Expected a contiguous array!");
+                const NTA_BasicType type = bufferType(info);
+                const NTA_BasicType target = net.getRegion("INPUT")->getOutput(name)->getData().getType();
+                if (type == target || target == NTA_BasicType_SDR) {
+                    net.setInputData(name, type, info.ptr, size);  // no copy but into the input
+                } else {
+                    Array s(type, info.ptr, size);  // converted
+                    net.setInputData(name, s);
+                }
+            });
+
+        py_Network.def("setInputSparse", [](Network& net, const std::string& name, py::array_t<UInt32, py::array::c_style | py::array::forcecast> sparse)
+            {
+                net.setInputSparse(name, static_cast<const UInt*>(sparse.data()), static_cast<size_t>(sparse.size()));
+            }, "Set the SDR of an \"INPUT\" link from its sorted active indices.");
 
-                net.setInputData(name, s);
+        py_Network.def("setInputBatch", [bufferType](Network& net, const std::string& name, py::buffer& b)
+            {
+                // One record per row, for the next batched run, see setBatchSize().
+                py::buffer_info info = b.request();
+                if (info.ndim != 2)
+                    throw std::runtime_error("Expected a two dimensional array, one record per row!");
+                if (info.strides[1] != info.itemsize || info.strides[0] != info.itemsize * info.shape[1])
+                    throw std::runtime_error("Expected a contiguous array!");
+                net.setInputBatch(name, bufferType(info), info.ptr, static_cast<size_t>(info.shape[0]));
             });
             
 
@@ -26,8 +26,21 @@ Utility functions for PyBind11 bindings
 
 #include <bindings/suppress_register.hpp>  //include before pybind11.h
 #include <pybind11/pybind11.h>
+#include <pybind11/iostream.h>
 #include <pybind11/numpy.h>
 
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include <htm/types/Sdr.hpp>
+#include <htm/utils/TaskQueue.hpp>
+
 namespace py = pybind11;
 
 namespace htm_ext {
@@ -43,6 +56,236 @@ namespace htm_ext {
 
     template<typename T> T* get_end(py::array& a) { return (static_cast<T*>(a.request().ptr)) + a.size(); }
 
+    /**
+     * A batch of SDR values from Python, for the batched compute entry points.
+     * inputs is either a 2-D numpy array with one dense row per SDR, or a list
+     * of sparse index arrays. Call with the GIL held.
+     */
+    inline std::vector<htm::SDR> toSDRBatch(py::handle inputs, const std::vector<htm::UInt> &dimensions)
+    {
+        std::vector<htm::SDR> batch;
+        if( py::isinstance<py::array>(inputs) ) {
+            auto dense = py::array_t<htm::Byte, py::array::c_style | py::array::forcecast>::ensure(inputs);
+            NTA_CHECK( dense && dense.ndim() == 2 ) << "Expected a 2-D array with one input per row!";
+            const size_t rows = (size_t) dense.shape(0);
+            batch.reserve( rows );
+            for(size_t r = 0; r < rows; r++) {
+                batch.emplace_back( dimensions );
+                NTA_CHECK( (size_t) dense.shape(1) == batch.back().size )
+                    << "Bad input row size! expected " << batch.back().size << ", got " << dense.shape(1);
+                batch.back().setDense( dense.data(r, 0) );
+            }
+            return batch;
+        }
+        for(const auto item : inputs) {
+            auto sparse = py::array_t<htm::ElemSparse, py::array::c_style | py::array::forcecast>::ensure(item);
+            NTA_CHECK( sparse && sparse.ndim() <= 1 ) << "Expected a list of sparse index arrays!";
+            htm::SDR_sparse_t indices( sparse.data(), sparse.data() + sparse.size() );
+            std::sort( indices.begin(), indices.end() );
+            batch.emplace_back( dimensions );
+            NTA_CHECK( std::adjacent_find( indices.begin(), indices.end() ) == indices.end() )
+                << "Sparse data must not contain duplicates!";
+            NTA_CHECK( indices.empty() || indices.back() < batch.back().size )
+                << "Index out of bounds of the SDR!";
+            batch.back().setSparse( indices );
+        }
+        return batch;
+    }
+
+    /** Copies the dense value of sdr into row r of a 2-D array, no GIL needed. */
+    inline void storeDenseRow(htm::Byte *rows, size_t r, const htm::SDR &sdr)
+    {
+        std::memcpy( rows + r * sdr.size, sdr.getDense().data(), sdr.size * sizeof(htm::Byte) );
+    }
+
+    /** A 1-D numpy array which owns vector, without a copy. */
+    template<typename T> py::array_t<T> toArray(std::vector<T> &&vector)
+    {
+        auto *owned = new std::vector<T>(std::move(vector));
+        py::capsule owner(owned, [](void *p) { delete static_cast<std::vector<T> *>(p); });
+        return py::array_t<T>({ owned->size() }, { sizeof(T) }, owned->data(), owner);
+    }
+
+    /**
+     * The batch encoding entry point of the encoders: encodes values with
+     * encoder.encodeBatch(), in chunks into reused SDRs, without the GIL.
+     *
+     * Without dense, returns the encodings as CSR: a tuple (indptr, indices)
+     * of numpy arrays, the active bits of value i are
+     * indices[indptr[i] : indptr[i + 1]].  With dense, a writable C ordered
+     * 2-D array of 1 byte items and shape (len(values), encoder.size), writes
+     * one encoding per row into it and returns it.
+     */
+    template<typename Encoder, typename T>
+    py::object encodeBatch(Encoder &encoder, const std::vector<T> &values, py::object dense)
+    {
+        constexpr size_t chunkSize = 1024u;
+        htm::Byte *rows = nullptr;
+        if( !dense.is_none() ) {
+            auto out = dense.cast<py::array>();
+            NTA_CHECK( out.ndim() == 2 && (size_t) out.shape(0) == values.size() && (size_t) out.shape(1) == encoder.size )
+                << "Expected an output array of shape (" << values.size() << ", " << encoder.size << ")!";
+            NTA_CHECK( out.writeable() && (out.flags() & py::array::c_style) )
+                << "Expected a writable, C ordered output array!";
+            rows = get_it<htm::Byte>(out);
+        }
+        std::vector<int64_t>         indptr( 1u, 0 );
+        std::vector<htm::ElemSparse> indices;
+        {
+            py::gil_scoped_release release;
+            std::vector<htm::SDR> outputs( std::min(chunkSize, values.size()), htm::SDR(encoder.dimensions) );
+            std::vector<T> chunk;
+            if( rows == nullptr ) indptr.reserve( values.size() + 1u );
+            for( size_t begin = 0u; begin < values.size(); begin += chunkSize ) {
+                const size_t end = std::min(begin + chunkSize, values.size());
+                chunk.assign( values.begin() + begin, values.begin() + end );
+                outputs.resize( chunk.size(), htm::SDR(encoder.dimensions) );
+                encoder.encodeBatch( chunk, outputs );
+                for( size_t i = 0u; i < chunk.size(); i++ ) {
+                    if( rows != nullptr ) {
+                        storeDenseRow( rows, begin + i, outputs[i] );
+                    } else {
+                        const auto &sparse = outputs[i].getSparse();
+                        indices.insert( indices.end(), sparse.begin(), sparse.end() );
+                        indptr.push_back( (int64_t) indices.size() );
+                    }
+                }
+            }
+        }
+        if( rows != nullptr ) return dense;
+        return py::make_tuple( toArray(std::move(indptr)), toArray(std::move(indices)) );
+    }
+
+    /** A std::streambuf which appends to a string, so save() writes straight into it. */
+    class StringSink : public std::streambuf
+    {
+    public:
+        explicit StringSink(std::string &bytes) : bytes_(bytes) {}
+    protected:
+        std::streamsize xsputn(const char *s, std::streamsize n) override
+            { bytes_.append(s, static_cast<size_t>(n)); return n; }
+        int_type overflow(int_type c) override
+        {
+            if( !traits_type::eq_int_type(c, traits_type::eof()) )
+                bytes_.push_back(traits_type::to_char_type(c));
+            return traits_type::not_eof(c);
+        }
+    private:
+        std::string &bytes_;
+    };
+
+    /** A read only std::streambuf over memory, so load() reads a Python buffer in place. */
+    class MemorySource : public std::streambuf
+    {
+    public:
+        MemorySource(const char *data, size_t size)
+        {
+            char *p = const_cast<char *>(data); // never written, see the protected members
+            setg(p, p, p + size);
+        }
+    };
+
+    /**
+     * __reduce_ex__ for a class T with save() and load(), and a static
+     * _fromPickleBuffer() which calls fromPickleBuffer<T>().
+     *
+     * The state is saved once, into memory which Python then owns without a
+     * copy. With pickle protocol 5 it is a PickleBuffer, which
+     * pickle.dumps(obj, protocol=5, buffer_callback=...) hands out of band,
+     * eg. to multiprocessing or an object store, and pickle.loads(data,
+     * buffers=...) loads in place. Older protocols embed it as bytes.
+     */
+    template<typename T> py::tuple reduceEx(py::object self, int protocol)
+    {
+        const T &obj = self.cast<const T &>();
+        auto *bytes = new std::string();
+        py::capsule owner(bytes, [](void *p) { delete static_cast<std::string *>(p); });
+        {
+            StringSink sink(*bytes);
+            std::ostream out(&sink);
+            obj.save(out);
+        }
+        py::object state;
+        if( protocol >= 5 ) {
+            py::array_t<uint8_t> view({ bytes->size() }, { sizeof(uint8_t) },
+                                      reinterpret_cast<const uint8_t *>(bytes->data()), owner);
+            state = py::module::import("pickle").attr("PickleBuffer")(view);
+        } else {
+            state = py::bytes(bytes->data(), bytes->size());
+        }
+        py::handle cls(reinterpret_cast<PyObject *>(Py_TYPE(self.ptr())));
+        return py::make_tuple(cls.attr("_fromPickleBuffer"), py::make_tuple(state));
+    }
+
+    /** Loads a T from any contiguous buffer: bytes, or an out of band PickleBuffer. */
+    template<typename T> T fromPickleBuffer(const py::buffer &buffer)
+    {
+        const py::buffer_info info = buffer.request();
+        MemorySource source(static_cast<const char *>(info.ptr), static_cast<size_t>(info.size * info.itemsize));
+        std::istream in(&source);
+        T self;
+        self.load(in);
+        return self;
+    }
+
+    /**
+     * The worker threads of the *_async methods.  Never destroyed, since
+     * Python may exit while tasks are queued.
+     */
+    inline htm::TaskQueue &asyncQueue()
+    {
+        static htm::TaskQueue *queue = new htm::TaskQueue();
+        return *queue;
+    }
+
+    /**
+     * The *_async methods: runs work() on asyncQueue() without the GIL, after
+     * the earlier tasks of key (the model), and returns an asyncio.Future of
+     * the running event loop.  The future resolves to result(), called with
+     * the GIL, or to a RuntimeError if work() throws.  keepAlive holds the
+     * Python objects which work() uses until it is done; work() and result()
+     * must not hold Python objects themselves.  Call from a coroutine.
+     */
+    template<typename Work, typename Result>
+    py::object runAsync(const void *key, py::tuple keepAlive, Work work, Result result)
+    {
+        struct Pending { py::object loop; py::object future; py::tuple keepAlive; };
+        py::object loop = py::module::import("asyncio").attr("get_running_loop")();
+        py::object future = loop.attr("create_future")();
+        auto pending = std::make_shared<Pending>(Pending{ loop, future, std::move(keepAlive) });
+        asyncQueue().submit( key, [pending, work, result]() mutable {
+            std::string error;
+            try {
+                work();
+            } catch( const std::exception &e ) {
+                error = e.what();
+            } catch( ... ) {
+                error = "unknown error";
+            }
+            if( !Py_IsInitialized() ) {
+                new std::shared_ptr<Pending>( std::move(pending) ); // leaked, no Python to release it to
+                return;
+            }
+            py::gil_scoped_acquire gil;
+            try {
+                py::object value = error.empty() ? py::object( result() ) : py::object( py::none() );
+                py::object done  = pending->future;
+                py::cpp_function resolve( [done, value, error]() {
+                    if( done.attr("done")().cast<bool>() ) return; // cancelled
+                    if( error.empty() )
+                        done.attr("set_result")( value );
+                    else
+                        done.attr("set_exception")( py::module::import("builtins").attr("RuntimeError")( error ) );
+                });
+                pending->loop.attr("call_soon_threadsafe")( resolve );
+            } catch( py::error_already_set & ) {
+                // the event loop is closed, nobody awaits the future
+            }
+            pending.reset(); // the Python objects, while holding the GIL
+        });
+        return future;
+    }
+
     inline void enable_cout()
     {
         py::scoped_ostream_redirect stream(
@@ -41,10 +41,19 @@ namespace htm_ext {
 
         py::class_<Random_t> Random(m, "Random");
 
-        Random.def(py::init<htm::UInt64>(), py::arg("seed") = 0)
+        py::enum_<Random_t::Engine>(Random, "Engine")
+            .value("MT19937", Random_t::MT19937)
+            .value("COUNTER", Random_t::COUNTER)
+            .export_values();
+
+        Random.def(py::init<htm::UInt64, Random_t::Engine>(), py::arg("seed") = 0, py::arg("engine") = Random_t::MT19937)
               .def("getUInt32", &Random_t::getUInt32, py::arg("max") = (htm::UInt32)-1l)
               .def("getReal64", &Random_t::getReal64)
 	      .def("getSeed", &Random_t::getSeed)
+              .def("getEngine", &Random_t::getEngine)
+              .def("getSteps", &Random_t::getSteps)
+              .def("seek", &Random_t::seek, py::arg("steps"))
+              .def("split", &Random_t::split, py::arg("stream"))
               .def("max", &Random_t::max)
               .def("min", &Random_t::min)
               .def("__eq__", [](Random_t const & self, Random_t const & other) { return self == other; }, py::is_operator()); //operator==
@@ -22,6 +22,8 @@
 
 #include <htm/types/Sdr.hpp>
 
+#include "bindings/engine/py_utils.hpp"
+
 #include <memory> // shared_ptr
 
 namespace py = pybind11;
@@ -31,9 +33,43 @@ using namespace htm;
 
 namespace htm_ext
 {
+    // Persistent, writable buffer of sparse indices for an SDR, see SDR.sparse_view().
+    struct SparseView {
+        shared_ptr<SDR> sdr;
+        SDR_sparse_t    buffer;
+    };
+
+    // Checks sparse indices like SDR::setSparseInplace does in debug builds,
+    // sorts them in place if needed.
+    static void checkSparse(const SDR &sdr, ElemSparse *data, size_t num) {
+        NTA_CHECK( num <= sdr.size );
+        if( ! is_sorted( data, data + num ))
+            sort( data, data + num );
+        UInt previous = -1;
+        for(size_t i = 0; i < num; i++) {
+            NTA_CHECK( data[i] != previous )
+                << "Sparse data must not contain duplicates!";
+            previous = data[i];
+        }
+        if( num > 0 ) {
+            NTA_CHECK( data[num - 1] < sdr.size ) << "Index out of bounds of the SDR!";
+        }
+    }
+
+    // numpy view of the dense buffer, kept alive by the Python SDR object 'base'.
+    static py::array denseView(SDR &sdr, py::handle base) {
+        vector<UInt> strides( sdr.dimensions.size(), 0u );
+        auto z = sizeof(Byte);
+        for(int i = (int)sdr.dimensions.size() - 1; i >= 0; --i) {
+            strides[i] = (UInt)z;
+            z *= sdr.dimensions[i];
+        }
+        return py::array(sdr.dimensions, strides, sdr.getDense().data(), base);
+    }
+
     void init_SDR(py::module& m)
     {
-        py::class_<SDR, shared_ptr<SDR>> py_SDR(m, "SDR",
+        py::class_<SDR, shared_ptr<SDR>> py_SDR(m, "SDR", py::buffer_protocol(),
 R"(Sparse Distributed Representation
 
 This class manages the specification and momentary value of a Sparse Distributed
@@ -138,18 +174,11 @@ other.)",
 R"(Set all of the values in the SDR to false.  This method overwrites the SDRs
 current value.)");
 
+        // The views below use the Python SDR object as their base, which keeps
+        // the SDR alive without allocating a capsule on every access.
         py_SDR.def_property("dense",
-            [](shared_ptr<SDR> self) {
-                auto destructor = py::capsule( new shared_ptr<SDR>( self ),
-                    [](void *keepAlive) {
-                        delete reinterpret_cast<shared_ptr<SDR>*>(keepAlive); });
-                vector<UInt> strides( self->dimensions.size(), 0u );
-                auto z = sizeof(Byte);
-                for(int i = (int)self->dimensions.size() - 1; i >= 0; --i) {
-                    strides[i] = (UInt)z;
-                    z *= self->dimensions[i];
-                }
-                return py::array(self->dimensions, strides, self->getDense().data(), destructor);
+            [](py::object self) {
+                return denseView( self.cast<SDR&>(), self );
             },
             [](SDR &self, py::array_t<Byte> dense) {
                 py::buffer_info buf = dense.request();
@@ -179,24 +208,30 @@ to notify the SDR that its dense array has changed and its cached data is out of
 date.  If you did't copy this data, then SDR won't copy either.)");
 
         py_SDR.def_property("sparse",
-            [](shared_ptr<SDR> self) {
-                auto destructor = py::capsule( new shared_ptr<SDR>( self ),
-                    [](void *keepAlive) {
-                        delete reinterpret_cast<shared_ptr<SDR>*>(keepAlive); });
-                return py::array(self->getSum(), self->getSparse().data(), destructor);
+            [](py::object self) {
+                auto &sdr = self.cast<SDR&>();
+                return py::array(sdr.getSum(), sdr.getSparse().data(), self);
             },
-            [](SDR &self, SDR_sparse_t data) {
-                NTA_CHECK( data.size() <= self.size );
-                // Sort data and check for duplicates.
-                if( ! is_sorted( data.begin(), data.end() ))
-                    sort( data.begin(), data.end() );
-                UInt previous = -1;
-                for( const UInt idx : data ) {
-                    NTA_CHECK( idx != previous )
-                        << "Sparse data must not contain duplicates!";
-                    previous = idx;
+            [](SDR &self, py::array_t<ElemSparse, py::array::c_style | py::array::forcecast> data) {
+                NTA_CHECK( data.ndim() <= 1 ) << "Sparse data must be a flat list of indices!";
+                const size_t num = (size_t) data.size();
+                NTA_CHECK( num <= self.size );
+                ElemSparse *ptr = data.mutable_data();
+                if( num > 0 and ptr == self.getSparse().data() ) {
+                    // We got our own data back, set inplace instead of copying.
+                    checkSparse( self, ptr, num );
+                    self.setSparse( self.getSparse() );
+                    return;
+                }
+                // Sort data and check for duplicates, without changing the caller's array.
+                if( ! is_sorted( ptr, ptr + num )) {
+                    SDR_sparse_t sorted( ptr, ptr + num );
+                    checkSparse( self, sorted.data(), num );
+                    self.setSparse( sorted );
+                    return;
                 }
-                self.setSparse( data ); },
+                checkSparse( self, ptr, num );
+                self.setSparse( ptr, (UInt) num ); },
 R"(A numpy array containing the indices of only the true values in the SDR.
 These are indices into the flattened SDR. This format allows for quickly
 accessing all of the true bits in the SDR.
@@ -204,14 +239,12 @@ accessing all of the true bits in the SDR.
 Sparse data must contain no duplicates.)");
 
         py_SDR.def_property("coordinates",
-            [](shared_ptr<SDR> self) {
-                auto destructor = py::capsule( new shared_ptr<SDR>( self ),
-                    [](void *keepAlive) {
-                        delete reinterpret_cast<shared_ptr<SDR>*>(keepAlive); });
+            [](py::object self) {
+                auto &sdr    = self.cast<SDR&>();
                 auto outer   = py::list();
-                auto coords  = self->getCoordinates().data();
-                for(auto dim = 0u; dim < self->dimensions.size(); ++dim) {
-                    auto vec = py::array(coords[dim].size(), coords[dim].data(), destructor);
+                auto coords  = sdr.getCoordinates().data();
+                for(auto dim = 0u; dim < sdr.dimensions.size(); ++dim) {
+                    auto vec = py::array(coords[dim].size(), coords[dim].data(), self);
                     outer.append(vec);
                 }
                 return outer;
@@ -227,6 +260,67 @@ location of each true bit inside of the SDR's dimensional space.
 
 Coordinate data must be sorted and contain no duplicates.)");
 
+        py_SDR.def_buffer([](SDR &self) -> py::buffer_info {
+            vector<py::ssize_t> shape( self.dimensions.begin(), self.dimensions.end() );
+            vector<py::ssize_t> strides( shape.size(), 0 );
+            py::ssize_t z = sizeof(Byte);
+            for(int i = (int)shape.size() - 1; i >= 0; --i) {
+                strides[i] = z;
+                z *= shape[i];
+            }
+            return py::buffer_info( self.getDense().data(), sizeof(Byte),
+                                    py::format_descriptor<Byte>::format(),
+                                    (py::ssize_t) shape.size(), shape, strides );
+        });
+
+        py::class_<SparseView, shared_ptr<SparseView>> py_SparseView(m, "SDRSparseView", py::buffer_protocol(),
+R"(Writable buffer of sparse indices for an SDR, see SDR.sparse_view().)");
+
+        py_SparseView.def_buffer([](SparseView &self) -> py::buffer_info {
+            return py::buffer_info( self.buffer.data(), self.buffer.size() );
+        });
+
+        py_SparseView.def_property_readonly("capacity",
+            [](const SparseView &self) { return self.buffer.size(); });
+
+        py_SparseView.def("commit", [](SparseView &self, size_t num) {
+                NTA_CHECK( num <= self.buffer.size() )
+                    << "commit(" << num << ") but the view holds only " << self.buffer.size() << " indices!";
+                checkSparse( *self.sdr, self.buffer.data(), num );
+                // Copies into the SDR's own sparse buffer, which does not
+                // allocate once it has held this many indices.
+                self.sdr->setSparse( self.buffer.data(), (UInt) num );
+                return self.sdr; },
+R"(Sets the value of the SDR to the first num indices of this view.
+They are sorted in place if needed, and must not contain duplicates.
+Returns the SDR.)",
+            py::arg("num"));
+
+        py_SDR.def("sparse_view", [](shared_ptr<SDR> self, size_t capacity) {
+                NTA_CHECK( capacity <= self->size ) << "capacity must not exceed the size of the SDR!";
+                auto view = make_shared<SparseView>();
+                view->sdr = self;
+                view->buffer.resize( capacity );
+                self->getSparse().reserve( capacity );
+                return view; },
+R"(Returns a persistent buffer for writing sparse indices without copies from Python.
+
+Wrap it once, ie. with numpy.asarray(view), write the indices of the true bits
+into its front and call view.commit(num) every step. Only the num indices are
+copied into the SDR, no memory is allocated and no Python objects are created.
+
+The SDR's dense data is also exported with the buffer protocol, so
+numpy.asarray(sdr) and memoryview(sdr) give its dense view.
+
+Example Usage:
+    view   = X.sparse_view( 40 )
+    buffer = numpy.asarray( view )
+    for step in data:
+        num = fill( buffer )  # write indices of the true bits into buffer[:num]
+        view.commit( num )
+)",
+            py::arg("capacity"));
+
         py_SDR.def("setSDR", [](SDR *self, SDR &other) {
             NTA_CHECK( self->dimensions == other.dimensions );
             self->setSDR( other );
@@ -243,11 +337,24 @@ R"(Calculates the sparsity of the SDR, which is the fraction of bits which are
 true out of the total number of bits in the SDR.
 I.E.  sparsity = sdr.getSum() / sdr.size)");
 
+        py_SDR.def("memoryUsage", &SDR::memoryUsage,
+            "Bytes of memory held by the buffers of all formats of the SDR.");
+
         py_SDR.def("getOverlap", [](SDR &self, SDR &other) {
             NTA_CHECK( self.dimensions == other.dimensions );
             return self.getOverlap( other ); },
 "Calculates the number of true bits which both SDRs have in common.");
 
+        py_SDR.def("contains", [](const SDR &self, UInt index) {
+            NTA_CHECK( index < self.size ) << "SDR.contains: index out of bounds";
+            return self.contains( index ); },
+R"(Is the bit at this flat index true?  Uses a format which is already valid, so
+huge SDRs are not converted to the dense format.)");
+
+        py_SDR.def("compress", [](SDR &self) { self.getCompressed(); },
+R"(Make the compressed (Roaring bitmap) format of this SDR, for very large and very
+sparse SDRs.  Overlaps of two compressed SDRs and contains() use it.)");
+
         py_SDR.def("randomize",
             [](SDR *self, Real sparsity, UInt seed) {
             Random rng( seed );
@@ -325,6 +432,9 @@ magic seed 0.  Use the same seed to consistently kill the same cells.)",
                 self.load(ss);
                 return self;
         }));
+        // Pickle protocol 5: out of band buffers, see reduceEx().
+        py_SDR.def("__reduce_ex__", &htm_ext::reduceEx<SDR>)
+            .def_static("_fromPickleBuffer", &htm_ext::fromPickleBuffer<SDR>);
 
         py_SDR.def("reshape", [](SDR *self, const vector<UInt> &dimensions)
             { self->reshape( dimensions ); return self; },
@@ -20,6 +20,14 @@
 /** @file
 Implementation for the PyBindRegion class.  This class acts as the base class for all Python implemented Regions.
 In this case, the C++ engine is actually calling into the Python code.
+
+The bindings release the GIL during Network.run(), so the engine may call a
+region from any thread, without the GIL. Every method that touches Python
+therefore takes the GIL itself with py::gil_scoped_acquire.
+
+The numpy views of the input and output buffers, and the dicts holding them,
+are created once and reused by every compute(). A view is only rebuilt when its
+buffer is reallocated, resized or retyped.
 */
 
 #include "PyBindRegion.hpp"
@@ -253,6 +261,7 @@ namespace py = pybind11;
         , module_(module)
         , className_(className)
     {
+        py::gil_scoped_acquire gil;
         NTA_CHECK(region != NULL);
 
         std::string realClassName(className);
@@ -292,6 +301,7 @@ namespace py = pybind11;
         , className_(className)
 
     {
+        py::gil_scoped_acquire gil;
         // Make a local copy of the Spec
         createSpec(module_.c_str(), nodeSpec_, className_.c_str());
 
@@ -300,10 +310,24 @@ namespace py = pybind11;
 
     PyBindRegion::~PyBindRegion()
     {
+        // the last reference to the Python node must be dropped with the GIL held
+        if (Py_IsInitialized()) {
+            py::gil_scoped_acquire gil;
+            inputViews_.clear();
+            outputViews_.clear();
+            batchInputViews_.clear();
+            batchOutputViews_.clear();
+            inputs_ = py::dict();
+            outputs_ = py::dict();
+            batchInputs_ = py::dict();
+            batchOutputs_ = py::dict();
+            node_ = py::object();
+        }
     }
 
     std::string PyBindRegion::pickleSerialize() const
     {
+        py::gil_scoped_acquire gil;
         // 1. serialize main state using pickle
         // 2. call class method to serialize external state
 
@@ -344,6 +368,7 @@ namespace py = pybind11;
     }
     std::string PyBindRegion::extraSerialize() const
     {
+        py::gil_scoped_acquire gil;
 		    std::string tmp_extra = "extra.tmp";
 
         // 2. External state
@@ -364,6 +389,7 @@ namespace py = pybind11;
     }
 
 		void PyBindRegion::pickleDeserialize(std::string p) {
+		    py::gil_scoped_acquire gil;
         // 1. deserialize main state using pickle
         // 2. call class method to deserialize external state
         //
@@ -397,6 +423,7 @@ namespace py = pybind11;
 		}
 
 		void PyBindRegion::extraDeserialize(std::string e) {
+		    py::gil_scoped_acquire gil;
         // 2. External state
 		    std::string tmp_extra = "extra.tmp";
 			  std::ofstream efile(tmp_extra.c_str(), std::ios::binary);
@@ -416,6 +443,7 @@ namespace py = pybind11;
     template<typename T>
     T PyBindRegion::getParameterT(const std::string & name, Int64 index) const
     {
+        py::gil_scoped_acquire gil;
         try
         {
             py::args args = py::make_tuple(name, index);
@@ -446,6 +474,7 @@ namespace py = pybind11;
     template <typename T>
     void PyBindRegion::setParameterT(const std::string & name, Int64 index, T value)
     {
+        py::gil_scoped_acquire gil;
         NTA_CHECK(nodeSpec_.parameters.contains(name)) 
                << "module " << module_ << "; Parameter '" << name 
                << "' is not known. Cannot be set.";
@@ -562,6 +591,7 @@ namespace py = pybind11;
 
     void PyBindRegion::getParameterArray(const std::string& name, Int64 index, Array & a) const
     {
+        py::gil_scoped_acquire gil;
         try {
           auto args = py::make_tuple(name, index, create_numpy_view(a));
           node_.attr("getParameterArray")(*args);
@@ -590,18 +620,21 @@ namespace py = pybind11;
 
     void PyBindRegion::setParameterArray(const std::string& name, Int64 index, const Array & a)
     {
+        py::gil_scoped_acquire gil;
         auto args = py::make_tuple(name, index, create_numpy_view(a));
         node_.attr("setParameterArray")(*args);
     }
 
     std::string PyBindRegion::getParameterString(const std::string& name, Int64 index) const
     {
+        py::gil_scoped_acquire gil;
         py::args args = py::make_tuple(name, index);
         return node_.attr("getParameter")(*args).cast<std::string>();
     }
 
     void PyBindRegion::setParameterString(const std::string& name, Int64 index, const std::string& value)
     {
+        py::gil_scoped_acquire gil;
         py::args args = py::make_tuple(name, index, value);
         node_.attr("setParameter")(*args);
     }
@@ -610,6 +643,7 @@ namespace py = pybind11;
 
     size_t PyBindRegion::getParameterArrayCount(const std::string& name, Int64 index) const
     {
+        py::gil_scoped_acquire gil;
         py::args args = py::make_tuple(name, index);
         return node_.attr("getParameterArrayCount")(*args).cast<size_t>();
     }
@@ -621,6 +655,7 @@ namespace py = pybind11;
 
     size_t PyBindRegion::getNodeOutputElementCount(const std::string& outputName) const
     {
+        py::gil_scoped_acquire gil;
         py::args args = py::make_tuple(outputName);
         return (size_t)node_.attr("getOutputElementCount")(*args).cast<int>();
     }
@@ -630,6 +665,7 @@ namespace py = pybind11;
 
     std::string PyBindRegion::executeCommand(const std::vector<std::string>& args, Int64 index)
     {
+        py::gil_scoped_acquire gil;
         //py::Tuple t(args.size() - 1);
         //for (size_t i = 1; i < args.size(); ++i)
         //{
@@ -645,12 +681,26 @@ namespace py = pybind11;
         return s;
     }
 
+    bool PyBindRegion::refreshView(PortView &v, const ArrayBase &a)
+    {
+        const void *buffer = a.getBuffer();
+        if (v.view && v.buffer == buffer && v.count == a.getCount() && v.type == a.getType())
+            return false;
+        v.buffer = buffer;
+        v.count = a.getCount();
+        v.type = a.getType();
+        v.view = create_numpy_view(a);
+        return true;
+    }
+
     void PyBindRegion::compute()
     {
+        py::gil_scoped_acquire gil;
         const Spec& ns = nodeSpec_;
+        inputViews_.resize(ns.inputs.getCount());
+        outputViews_.resize(ns.outputs.getCount());
 
-        // Prepare the inputs dict
-        py::dict inputs;
+        // Update the inputs dict
         for (size_t i = 0; i < ns.inputs.getCount(); ++i)
         {
             const std::pair<std::string, InputSpec> & p = ns.inputs.getByIndex(i);
@@ -663,19 +713,21 @@ namespace py = pybind11;
             const htm::Array * pa = &(inp->getData());
 
             // Skip unlinked inputs of size 0
-    		    if (pa->getCount() == 0)
+            if (pa->getCount() == 0)
+            {
+                if (inputViews_[i].view) {
+                    inputViews_[i] = PortView();
+                    inputs_.attr("pop")(p.first, py::none());
+                }
                 continue;
+            }
 
-
-            // Create a numpy array from pa, which wil be either
-            // the original input array or a stored input array copy
-            // (if a splitter map is needed)
-            inputs[p.first.c_str()] = create_numpy_view(*pa);
+            // Create a numpy view of pa only when its buffer changed.
+            if (refreshView(inputViews_[i], *pa))
+                inputs_[p.first.c_str()] = inputViews_[i].view;
         }
 
-        // Prepare the outputs dict
-        py::dict outputs;
-
+        // Update the outputs dict
         for (size_t i = 0; i < ns.outputs.getCount(); ++i)
         {
             // Get the current OutputSpec object
@@ -687,12 +739,61 @@ namespace py = pybind11;
             if (!out)
                 continue;
 
-            const Array & data = out->getData();
-            outputs[p.first.c_str()] = create_numpy_view(data);
+            if (refreshView(outputViews_[i], out->getData()))
+                outputs_[p.first.c_str()] = outputViews_[i].view;
+        }
+
+        node_.attr("guardedCompute")(inputs_, outputs_);
+    }
+
+    bool PyBindRegion::canComputeBatch() const
+    {
+        py::gil_scoped_acquire gil;
+        return py::hasattr(node_, "computeBatch");
+    }
+
+    void PyBindRegion::updateBatchViews(const std::string &name, std::vector<Array> &records,
+                                        std::vector<PortView> &views, py::dict &dict, size_t n)
+    {
+        bool changed = views.size() != n;
+        views.resize(n);
+        for (size_t i = 0; i < n; ++i)
+            changed |= refreshView(views[i], records[i]);
+        if (!changed)
+            return;
+        py::list list(n);
+        for (size_t i = 0; i < n; ++i)
+            list[i] = views[i].view;
+        dict[name.c_str()] = list;
+    }
+
+    void PyBindRegion::computeBatch(size_t n)
+    {
+        py::gil_scoped_acquire gil;
+        const Spec& ns = nodeSpec_;
+        batchInputViews_.resize(ns.inputs.getCount());
+        batchOutputViews_.resize(ns.outputs.getCount());
+
+        // Each port is a list of n numpy views, one per record.
+        for (size_t i = 0; i < ns.inputs.getCount(); ++i)
+        {
+            const std::string &name = ns.inputs.getByIndex(i).first;
+            auto inp = region_->getInput(name);
+            NTA_CHECK(inp);
+            if (inp->getData().getCount() == 0)
+                continue;
+            updateBatchViews(name, inp->getBatch(), batchInputViews_[i], batchInputs_, n);
+        }
+        for (size_t i = 0; i < ns.outputs.getCount(); ++i)
+        {
+            const std::string &name = ns.outputs.getByIndex(i).first;
+            auto out = region_->getOutput(name);
+            if (!out)
+                continue;
+            updateBatchViews(name, out->getBatch(), batchOutputViews_[i], batchOutputs_, n);
         }
 
-        py::args args = py::make_tuple(inputs, outputs);
-        node_.attr("guardedCompute")(*args);
+        node_.attr("guardedComputeBatch")(n, batchInputs_, batchOutputs_);
     }
 
 
@@ -703,6 +804,7 @@ namespace py = pybind11;
     //
     void PyBindRegion::createSpec(const char * module, Spec& ns, const char* className)
     {
+        py::gil_scoped_acquire gil;
     
         std::string realClassName(className);
         if (realClassName.empty())
@@ -993,6 +1095,7 @@ namespace py = pybind11;
 
     void PyBindRegion::initialize()
     {
+        py::gil_scoped_acquire gil;
         node_.attr("initialize")();
     }
 
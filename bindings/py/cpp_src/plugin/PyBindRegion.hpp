@@ -28,9 +28,12 @@ Definition of the PyBindRegion class.  The base class for all Python Region impl
 #include <bindings/suppress_register.hpp>  //include before pybind11.h
 #include <pybind11/pybind11.h>
 
+#include <vector>
+
 #include <htm/types/Types.hpp>
 #include <htm/engine/RegionImpl.hpp>
 #include <htm/engine/Spec.hpp>
+#include <htm/ntypes/Array.hpp>
 #include <htm/ntypes/Value.hpp>
 
 namespace htm
@@ -95,6 +98,8 @@ namespace htm
 
         void initialize() override;
         void compute() override;
+        bool canComputeBatch() const override;
+        void computeBatch(size_t n) override;
         std::string executeCommand(const std::vector<std::string>& args, Int64 index) override;
 
         size_t getParameterArrayCount(const std::string& name, Int64 index) const override;
@@ -140,6 +145,29 @@ namespace htm
 
         Spec nodeSpec_;   // locally cached version of spec.
 
+        // A numpy view of an input or output buffer, kept between calls to
+        // compute() and rebuilt only when the buffer is reallocated.
+        struct PortView {
+          const void *buffer = nullptr;
+          size_t count = 0u;
+          NTA_BasicType type = NTA_BasicType_Last;
+          pybind11::object view;
+        };
+        // Returns true when the view of 'a' had to be rebuilt.
+        static bool refreshView(PortView &v, const ArrayBase &a);
+        // The dicts passed to compute(), one view per port in spec order.
+        pybind11::dict inputs_;
+        pybind11::dict outputs_;
+        std::vector<PortView> inputViews_;
+        std::vector<PortView> outputViews_;
+        // Same for computeBatch(), one list of views per port.
+        pybind11::dict batchInputs_;
+        pybind11::dict batchOutputs_;
+        std::vector<std::vector<PortView>> batchInputViews_;
+        std::vector<std::vector<PortView>> batchOutputViews_;
+        void updateBatchViews(const std::string &name, std::vector<Array> &records,
+                              std::vector<PortView> &views, pybind11::dict &dict, size_t n);
+
         std::string pickleSerialize() const;
         std::string extraSerialize() const;
 				void pickleDeserialize(std::string p);
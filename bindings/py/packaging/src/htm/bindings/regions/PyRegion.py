@@ -199,6 +199,23 @@ class PyRegion(_PyRegionMeta):
     return self.compute(inputs, DictReadOnlyWrapper(outputs))
 
 
+  def guardedComputeBatch(self, n, inputs, outputs):
+    """The C++ entry point to computeBatch.
+    The subclass should not implement.
+
+    A region which defines the optional method computeBatch(n, inputs, outputs)
+    is computed n iterations at a time when Network.setBatchSize() is used.
+    inputs and outputs are dictionaries of lists with one numpy array per
+    record; record i of every output must be written from record i of the
+    inputs, as if compute() was called n times.
+
+    :param n: (int) number of records
+    :param inputs: (dict) of lists of numpy arrays (one list per input)
+    :param outputs: (dict) of lists of numpy arrays (one list per output)
+    """
+    return self.computeBatch(n, inputs, DictReadOnlyWrapper(outputs))
+
+
   def getOutputElementCount(self, name):
     """
     Return the number of elements in this output.  i.e. its width.
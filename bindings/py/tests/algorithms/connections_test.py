@@ -448,7 +448,45 @@ class ConnectionsTest(unittest.TestCase):
     self.assertEqual(co.numSegments(), 0, "segment should have been removed")
     with pytest.raises(RuntimeError):
       n2 = co.numConnectedSynapses(seg)
-    
+
+
+  def testBulkArrays(self):
+    co = Connections(NUM_CELLS, 0.5)
+    for cell in range(10):
+      seg = co.createSegment(cell, 20)
+      co.createSynapses(seg, [cell + 100, cell + 200, cell + 300], [0.2, 0.6, 0.9])
+    co.destroySegment(3)
+
+    presynaptic = co.presynapticCellsArray()
+    permanences = co.permanencesArray()
+    segments    = co.segmentForSynapseArray()
+    self.assertEqual(len(presynaptic), 30) # with the destroyed synapses
+    self.assertFalse(presynaptic.flags.writeable)
+    for syn in co.synapsesForSegment(5):
+      self.assertEqual(presynaptic[syn], co.presynapticCellForSynapse(syn))
+      self.assertAlmostEqual(permanences[syn], co.permanenceForSynapse(syn))
+      self.assertEqual(segments[syn], 5)
+    self.assertTrue(np.all(permanences[segments == 3] == -1))
+    cells = co.cellForSegmentArray()
+    self.assertEqual(cells[3], NUM_CELLS) # destroyed
+    self.assertEqual(list(cells[4:]), list(range(4, 10)))
+    self.assertEqual(len(co.lastUsedArray()), 10)
+
+    # The views are a snapshot.
+    co.destroySegment(5)
+    self.assertEqual(presynaptic[co.synapsesForSegment(6)[0]], 106)
+    self.assertTrue(np.all(permanences[segments == 5] >= 0))
+
+    segmentCells, offsets, presyn, perms, lastUsed = co.bulkExport()
+    self.assertEqual(list(segmentCells), [0, 1, 2, 4, 6, 7, 8, 9])
+    self.assertEqual(offsets[-1], co.numSynapses())
+    perms[:] = 0.9 # edited offline
+    edited = Connections(NUM_CELLS, 0.5)
+    edited.bulkLoad(segmentCells, offsets, presyn, perms, lastUsed)
+    self.assertEqual(edited.numSynapses(), co.numSynapses())
+    self.assertEqual(edited.numConnectedSynapses(0), 3)
+    self.assertTrue(np.array_equal(edited.lastUsedArray(), lastUsed))
+
 
 
 
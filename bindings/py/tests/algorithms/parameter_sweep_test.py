@@ -0,0 +1,62 @@
+# ----------------------------------------------------------------------
+# HTM Community Edition of NuPIC
+# Copyright (C) 2020, Numenta, Inc.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Affero Public License version 3 as
+# published by the Free Software Foundation.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+# See the GNU Affero Public License for more details.
+#
+# You should have received a copy of the GNU Affero Public License
+# along with this program.  If not, see http://www.gnu.org/licenses.
+# ----------------------------------------------------------------------
+
+""" Unit tests for the ParameterSweep class. """
+
+import math
+import unittest
+
+from htm.bindings.sdr import SDR
+from htm.bindings.algorithms import EncodedDataset, SweepConfig, ParameterSweep
+
+
+class ParameterSweepTest(unittest.TestCase):
+
+  def testSweep(self):
+    patterns = [SDR( 200 ).randomize( 0.1 ) for _ in range(4)]
+    data = EncodedDataset( [200] )
+    for i in range(400):
+      data.add( SDR( patterns[i % 4] ).addNoise( 0.05 ), i % 4 )
+    self.assertEqual( len(data), 400 )
+    self.assertEqual( data[0].dimensions, [200] )
+    self.assertEqual( data.getLabel( 2 ), 2 )
+
+    configs = []
+    for useTM in [False, True]:
+      c = SweepConfig()
+      c.name = "tm" if useTM else "sp"
+      c.columnDimensions = [256]
+      c.localAreaDensity = 0.04
+      c.useTM = useTM
+      c.cellsPerColumn = 4
+      c.activationThreshold = 6
+      c.minThreshold = 4
+      c.maxNewSynapseCount = 10
+      c.classifierAlpha = 0.1
+      configs.append( c )
+
+    results = ParameterSweep( data, numTrain = 300, numThreads = 2 ).run( configs )
+    self.assertEqual( [r.name for r in results], ["sp", "tm"] )
+    for r in results:
+      self.assertGreater( r.accuracy, 0.9, str(r) )
+      self.assertGreater( r.recordsPerSecond, 0 )
+    self.assertTrue( math.isnan( results[0].meanAnomaly ))
+    self.assertLess( results[1].meanAnomaly, 0.5 )
+
+
+if __name__ == "__main__":
+  unittest.main()
@@ -15,6 +15,7 @@
 # along with this program.  If not, see http://www.gnu.org/licenses.
 # ----------------------------------------------------------------------
 
+import asyncio
 import unittest
 import pytest
 import sys
@@ -38,6 +39,51 @@ class SpatialPoolerTest(unittest.TestCase):
     assert( active.getSum() > 0 )
 
 
+  def testComputeMany(self):
+    """ compute_many() gives the same columns as compute() in a loop. """
+    inputs = [ SDR( 100 ).randomize( .05, seed ) for seed in range(1, 11) ]
+    dense  = np.array([ x.dense for x in inputs ], dtype=np.uint8)
+    sparse = [ x.sparse for x in inputs ]
+    for learn in (True, False):
+      spA = SP( [100], [200], stimulusThreshold = 1, seed = 42 )
+      spB = SP( [100], [200], stimulusThreshold = 1, seed = 42 )
+      spC = SP( [100], [200], stimulusThreshold = 1, seed = 42 )
+      rowsB = spB.compute_many( dense, learn )
+      rowsC = spC.compute_many( sparse, learn )
+      assert( rowsB.shape == (10, 200) )
+      active = SDR( 200 )
+      for i, x in enumerate(inputs):
+        spA.compute( x, learn, active )
+        assert( np.array_equal( rowsB[i], active.dense ) )
+        assert( np.array_equal( rowsC[i], active.dense ) )
+
+
+  def testComputeAsync(self):
+    """ compute_async() gives the same columns and overlaps as compute(). """
+    inputs = [ SDR( 100 ).randomize( .05, seed ) for seed in range(1, 11) ]
+    spA = SP( [100], [200], stimulusThreshold = 1, seed = 42 )
+    spB = SP( [100], [200], stimulusThreshold = 1, seed = 42 )
+    async def run():
+      results = []
+      for x in inputs:
+        active = SDR( 200 )
+        overlaps = await spB.compute_async( x, True, active )
+        results.append( (overlaps, active) )
+      return results
+    results = asyncio.run( run() )
+    active = SDR( 200 )
+    for x, (overlaps, activeB) in zip(inputs, results):
+      expected = spA.compute( x, True, active )
+      assert( np.array_equal( overlaps, expected ) )
+      assert( activeB == active )
+
+    # errors are raised by the await
+    async def bad():
+      await spB.compute_async( SDR( 7 ), True, SDR( 200 ) )
+    with pytest.raises(RuntimeError):
+      asyncio.run( bad() )
+
+
   def _runGetPermanenceTrial(self, float_type):
     """ 
     Check that getPermanence() returns values for a given float_type. 
@@ -15,6 +15,7 @@
 # along with this program.  If not, see http://www.gnu.org/licenses.
 # ----------------------------------------------------------------------
 
+import asyncio
 import unittest
 import pytest
 import pickle
@@ -59,6 +60,38 @@ class TemporalMemoryBindingsTest(unittest.TestCase):
     active = tm.getActiveCells()
     self.assertTrue( active.getSum() > 0 )
 
+  def testComputeSequence(self):
+    """ compute_sequence() gives the same results as compute() in a loop. """
+    sequence = [ SDR( 100 ).randomize( .05, seed ) for seed in range(1, 5) ] * 5
+    tmA = TM( [100], cellsPerColumn = 4, seed = 42 )
+    tmB = TM( [100], cellsPerColumn = 4, seed = 42 )
+    active, anomaly, predictive = tmB.compute_sequence( [ x.sparse for x in sequence ] )
+    self.assertEqual( active.shape, (len(sequence), 400) )
+    self.assertEqual( predictive.shape, (len(sequence), 400) )
+    self.assertEqual( anomaly.shape, (len(sequence),) )
+    for i, x in enumerate(sequence):
+      tmA.compute( x, True )
+      self.assertAlmostEqual( anomaly[i], tmA.anomaly, places=5 )
+      self.assertTrue( np.array_equal( active[i], tmA.getActiveCells().dense.flatten() ) )
+      tmA.activateDendrites( True )
+      self.assertTrue( np.array_equal( predictive[i], tmA.getPredictiveCells().dense.flatten() ) )
+
+
+  def testComputeAsync(self):
+    """ Many TMs computed concurrently with compute_async() learn as compute() does. """
+    sequence = [ SDR( 100 ).randomize( .05, seed ) for seed in range(1, 5) ] * 5
+    tmA = TM( [100], cellsPerColumn = 4, seed = 42 )
+    tms = [ TM( [100], cellsPerColumn = 4, seed = 42 ) for _ in range(8) ]
+    async def run():
+      for x in sequence:
+        await asyncio.gather( *[ tm.compute_async( x, True ) for tm in tms ] )
+    asyncio.run( run() )
+    for x in sequence:
+      tmA.compute( x, True )
+    for tm in tms:
+      self.assertEqual( tm.getActiveCells(), tmA.getActiveCells() )
+      self.assertAlmostEqual( tm.anomaly, tmA.anomaly, places=5 )
+
 
   def testPerformanceLarge(self):
     LARGE = 9000
@@ -273,7 +273,32 @@ class DateEncoder_Test(unittest.TestCase):
       d = d+datetime.timedelta(days=1)
       self.assertEqual( e.encode(d), e2.encode(d) )
 
-  
+
+  def testEncodeBatch(self):
+    """ A numpy.datetime64 batch gives the bits of encode() of the same times. """
+    p = DateEncoderParameters()
+    p.season_width = 3
+    p.dayOfWeek_width = 1
+    p.timeOfDay_width = 5
+    e = DateEncoder(p)
+    times = numpy.arange('2019-12-30T00:00', '2020-01-03T00:00', numpy.timedelta64(7, 'h'), dtype='datetime64[s]')
+    indptr, indices = e.encodeBatch(times)
+    self.assertEqual(len(indptr), len(times) + 1)
+    dense = numpy.zeros((len(times), e.size), dtype=numpy.uint8)
+    e.encodeBatch(times, dense)
+    for i, t in enumerate(times):
+      expected = e.encode(t.astype(datetime.datetime))
+      self.assertEqual(list(indices[indptr[i] : indptr[i + 1]]), list(expected.sparse))
+      self.assertEqual(list(numpy.flatnonzero(dense[i])), list(expected.sparse))
+
+    # unix time
+    unix = [int(datetime.datetime(2020, 1, 1, 12).timestamp())]
+    indptr, indices = e.encodeBatch(numpy.array(unix))
+    self.assertEqual(list(indices), list(e.encode(datetime.datetime(2020, 1, 1, 12)).sparse))
+
+    with self.assertRaises(RuntimeError):
+      e.encodeBatch(numpy.array(['NaT'], dtype='datetime64[s]'))
+
  
 if __name__ == "__main__":
   unittest.main()
@@ -256,6 +256,33 @@ class RDSE_Test(unittest.TestCase):
         assert( A != B )
 
 
+    def testEncodeBatch(self):
+        """ The CSR and the dense batches hold the same bits as encode(). """
+        P = RDSE_Parameters()
+        P.size     = 500
+        P.sparsity = .05
+        P.radius   = 4
+        P.seed     = 42
+        R = RDSE( P )
+        values = np.linspace( -100, 100, 3001 ) # more than one chunk
+        indptr, indices = R.encodeBatch( values )
+        assert( len(indptr) == len(values) + 1 )
+        assert( indptr[-1] == len(indices) )
+        dense = np.zeros( (len(values), R.size), dtype=np.uint8 )
+        assert( R.encodeBatch( values, dense ) is dense )
+        for i in [0, 1, 1500, 3000]:
+            expected = R.encode( values[i] )
+            assert( list(indices[indptr[i] : indptr[i + 1]]) == list(expected.sparse) )
+            assert( list(np.flatnonzero( dense[i] )) == list(expected.sparse) )
+
+        with self.assertRaises(RuntimeError):
+            R.encodeBatch( values, np.zeros( (10, R.size), dtype=np.uint8 ) )
+        with self.assertRaises(RuntimeError):
+            R.encodeBatch( values.reshape( (3001, 1) ) )
+        empty_indptr, empty_indices = R.encodeBatch( np.array([]) )
+        assert( list(empty_indptr) == [0] and len(empty_indices) == 0 )
+
+
     def testPickle(self):
         """
         The pickling is successfull if pickle serializes and de-serialize the
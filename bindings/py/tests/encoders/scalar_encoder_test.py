@@ -301,6 +301,24 @@ class ScalarEncoder_Test(unittest.TestCase):
         assert( mtr.activationFrequency.max() < 1.75 * .10 )
         assert( mtr.overlap.min() > .85 )
 
+    def testEncodeBatch(self):
+        p = ScalarEncoderParameters()
+        p.size       = 100
+        p.activeBits = 10
+        p.minimum    = 0
+        p.maximum    = 20
+        p.clipInput  = True
+        enc = ScalarEncoder( p )
+        values = [-1, 0, 3.3, 10, 19.5, 20, 25]
+        indptr, indices = enc.encodeBatch( np.array(values) )
+        assert( list(indptr) == list(range(0, 71, 10)) )
+        dense = np.zeros( (len(values), enc.size), dtype=np.uint8 )
+        enc.encodeBatch( values, dense=dense )
+        for i, value in enumerate(values):
+            expected = enc.encode( value )
+            assert( list(indices[indptr[i] : indptr[i + 1]]) == list(expected.sparse) )
+            assert( list(np.flatnonzero( dense[i] )) == list(expected.sparse) )
+
     @pytest.mark.skip(reason="Known issue: https://github.com/htm-community/htm.core/issues/160")
     def testPickle(self):
         assert(False) # TODO: Unimplemented
@@ -456,6 +456,20 @@ class SimHashDocumentEncoder_Test(unittest.TestCase):
         assert(output2.getOverlap(output3) > output3.getOverlap(output4))
         assert(output3.getOverlap(output4) > output1.getOverlap(output3))
 
+    # Test batch encoding, in parallel. Same outputs as encode(), in order.
+    def testEncodeBatch(self):
+        docs = [["alpha", "bravo"], ["charlie"], ["bravo", "delta", "echo"], []]
+        params = SimHashDocumentEncoderParameters()
+        params.size = 400
+        params.activeBits = 21
+        encoder = SimHashDocumentEncoder(params)
+        encoder.setNumThreads(2)
+        assert(encoder.getNumThreads() == 2)
+        outputs = encoder.encodeBatch(docs)
+        assert(len(outputs) == len(docs))
+        for doc, output in zip(docs, outputs):
+            assert(output == encoder.encode(doc))
+
     # Test encoding with weighted tokens. Make sure output changes accordingly.
     def testTokenWeightMap(self):
         weights = {
@@ -237,5 +237,21 @@ class TestNupicRandom(unittest.TestCase):
     v = r.getUInt32()
     self.assertEqual(v, 1651991554)
 
+  def testCounterEngine(self):
+    r = Random(42, Random.COUNTER)
+    self.assertEqual(r.getEngine(), Random.COUNTER)
+    self.assertEqual([r.getUInt32() for _ in range(3)], [3184996902, 686809907, 1196582743])
+    r.seek(1)
+    self.assertEqual(r.getUInt32(), 686809907)
+    self.assertEqual(r.getSteps(), 2)
+
+    s0 = r.split(0)
+    self.assertEqual(s0, Random(42, Random.COUNTER).split(0))
+    self.assertNotEqual(s0, r.split(1))
+
+    restored = pickle.loads(pickle.dumps(r))
+    self.assertEqual(restored, r)
+    self.assertEqual(restored.getUInt32(), r.getUInt32())
+
 if __name__ == "__main__":
   unittest.main()
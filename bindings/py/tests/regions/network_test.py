@@ -15,6 +15,7 @@
 # along with this program.  If not, see http://www.gnu.org/licenses.
 # ----------------------------------------------------------------------
 
+import asyncio
 import json
 import unittest
 import pytest
@@ -22,6 +23,7 @@ import numpy as np
 import sys
 import os
 import pickle
+import tempfile
 
     
 from htm.bindings.regions.PyRegion import PyRegion
@@ -93,6 +95,24 @@ class LinkRegion(PyRegion):
       "parameters": { }
     }
 
+class BatchLinkRegion(LinkRegion):
+  """
+  Test region which computes several records per call
+  """
+  batchCalls = 0
+
+  def computeBatch(self, n, inputs, outputs):
+    BatchLinkRegion.batchCalls += 1
+    for key in inputs:
+      for i in range(n):
+        outputs[key][i][:] = inputs[key][i]
+
+  @classmethod
+  def getSpec(cls):
+    spec = LinkRegion.getSpec()
+    spec["description"] = BatchLinkRegion.__doc__
+    return spec
+
 class NetworkTest(unittest.TestCase):
 
   def setUp(self):
@@ -269,6 +289,57 @@ class NetworkTest(unittest.TestCase):
     to_input = np.array(r_to.getInputArray("UInt32"))
     self.assertTrue(np.array_equal(to_input, TEST_DATA))
 
+  def testSetInputBatch(self):
+    """
+    setInputBatch() feeds one row per iteration of a batched run.
+    """
+    engine.Network.registerPyRegion(LinkRegion.__module__, LinkRegion.__name__)
+
+    network = engine.Network()
+    r_from = network.addRegion("from", "py.LinkRegion", "")
+    r_to = network.addRegion("to", "py.LinkRegion", "")
+    network.link("INPUT", "from", "", "{dim: [5]}", "UInt32_source", "UInt32")
+    network.link("from", "to", "", "", "UInt32", "UInt32")
+    network.initialize()
+
+    records = np.array([TEST_DATA, TEST_DATA[::-1]], dtype=np.uint32)
+    network.setBatchSize(2)
+    network.setInputBatch("UInt32_source", records)
+    network.run(2)
+
+    to_input = np.array(r_to.getInputArray("UInt32"))
+    self.assertTrue(np.array_equal(to_input, records[1]))
+
+  def testCaptureReplay(self):
+    """
+    A capture of the INPUT data replays into another network.
+    """
+    engine.Network.registerPyRegion(LinkRegion.__module__, LinkRegion.__name__)
+
+    def build():
+      network = engine.Network()
+      network.addRegion("from", "py.LinkRegion", "")
+      network.addRegion("to", "py.LinkRegion", "")
+      network.link("INPUT", "from", "", "{dim: [5]}", "UInt32_source", "UInt32")
+      network.link("from", "to", "", "", "UInt32", "UInt32")
+      network.initialize()
+      return network
+
+    with tempfile.TemporaryDirectory() as folder:
+      path = os.path.join(folder, "capture.bin")
+      live = build()
+      live.startCapture(path)
+      self.assertTrue(live.isCapturing())
+      for record in [TEST_DATA, TEST_DATA[::-1]]:
+        live.setInputData("UInt32_source", np.array(record))
+        live.run(1)
+      self.assertEqual(live.stopCapture(), 2)
+
+      replayed = build()
+      self.assertEqual(replayed.replayCapture(path), 2)
+      to_input = np.array(replayed.getRegion("to").getInputArray("UInt32"))
+      self.assertTrue(np.array_equal(to_input, TEST_DATA[::-1]))
+
   def testGetOutputArray(self):
     """
     This tests whether the final output of the network is accessible
@@ -286,6 +357,64 @@ class NetworkTest(unittest.TestCase):
     output = r_to.getOutputArray("UInt32")
     self.assertTrue(np.array_equal(output, TEST_DATA))
 
+  def testRunFromThreads(self):
+    """
+    Network.run() releases the GIL; Python regions must take it back.
+    Runs two networks of Python regions concurrently from Python threads.
+    """
+    import threading
+    engine.Network.registerPyRegion(LinkRegion.__module__, LinkRegion.__name__)
+
+    def build():
+      network = engine.Network()
+      network.addRegion("from", "py.LinkRegion", "")
+      network.addRegion("to", "py.LinkRegion", "")
+      network.link("from", "to", "", "", "UInt32", "UInt32")
+      network.link("INPUT", "from", "", "{dim: [5]}", "UInt32_source", "UInt32")
+      network.initialize()
+      network.setInputData("UInt32_source", np.array(TEST_DATA))
+      return network
+
+    networks = [build(), build()]
+    errors = []
+    def work(network):
+      try:
+        network.run(50)
+      except Exception as e:
+        errors.append(e)
+    threads = [threading.Thread(target=work, args=(n,)) for n in networks]
+    for t in threads: t.start()
+    for t in threads: t.join()
+
+    self.assertEqual(errors, [])
+    for network in networks:
+      output = network.getRegion("to").getOutputArray("UInt32")
+      self.assertTrue(np.array_equal(output, TEST_DATA))
+
+
+  def testComputeBatch(self):
+    """
+    A Python region with computeBatch() is called once per batch.
+    """
+    engine.Network.registerPyRegion(LinkRegion.__module__, LinkRegion.__name__)
+    engine.Network.registerPyRegion(BatchLinkRegion.__module__, BatchLinkRegion.__name__)
+    network = engine.Network()
+    network.addRegion("from", "py.LinkRegion", "")
+    network.addRegion("to", "py.BatchLinkRegion", "")
+    network.link("from", "to", "", "", "UInt32", "UInt32")
+    network.link("INPUT", "from", "", "{dim: [5]}", "UInt32_source", "UInt32")
+    network.initialize()
+    network.setInputData("UInt32_source", np.array(TEST_DATA))
+
+    BatchLinkRegion.batchCalls = 0
+    network.setBatchSize(10)
+    self.assertEqual(network.getBatchSize(), 10)
+    network.run(20)
+    self.assertEqual(BatchLinkRegion.batchCalls, 2)
+    output = network.getRegion("to").getOutputArray("UInt32")
+    self.assertTrue(np.array_equal(output, TEST_DATA))
+    engine.Network.unregisterPyRegion(BatchLinkRegion.__name__)
+
     
 
   def testBuiltInRegions(self):
@@ -321,6 +450,26 @@ class NetworkTest(unittest.TestCase):
     #print(EXPECTED_RESULT3)
     self.assertTrue(np.array_equal(sdr.sparse, EXPECTED_RESULT3))
 
+  def testRunAsync(self):
+    """ run_async() computes the same as run(), without blocking the event loop. """
+    def network():
+      net = engine.Network()
+      net.addRegion("encoder", "ScalarSensor", "{n: 6, w: 2}")
+      net.addRegion("sp", "SPRegion", "{columnCount: 200}")
+      net.link("encoder", "sp")
+      net.initialize()
+      net.getRegion("encoder").setParameterReal64("sensedValue", 0.8)
+      return net
+    expected = network()
+    expected.run(3)
+    nets = [ network() for _ in range(4) ]
+    async def run():
+      await asyncio.gather( *[ net.run_async(3) for net in nets ] )
+    asyncio.run( run() )
+    for net in nets:
+      sdr = net.getRegion("sp").getOutputArray("bottomUpOut").getSDR()
+      self.assertTrue(np.array_equal(sdr.sparse, expected.getRegion("sp").getOutputArray("bottomUpOut").getSDR().sparse))
+
   def testExecuteCommand1(self):
     """
     Check to confirm that the ExecuteCommand( ) funtion works.
@@ -379,4 +528,26 @@ class NetworkTest(unittest.TestCase):
     self.assertEqual(s1,"Hello World says: arg1=26 arg2=64")
     self.assertEqual(s1, s2,  "Simple Network pickle/unpickle failed.")
 
+  @pytest.mark.skipif(sys.version_info < (3, 8), reason="pickle protocol 5 needs Python 3.8")
+  def testNetworkPickleOutOfBand(self):
+    """
+    With pickle protocol 5 the saved Network is one out of band buffer.
+    """
+    network = engine.Network()
+    network.addRegion("encoder", "RDSEEncoderRegion", "{size: 1000, activeBits: 40, resolution: 0.5}")
+    network.addRegion("sp", "SPRegion", "{columnCount: 1000}")
+    network.link("encoder", "sp", "", "", "encoded", "bottomUpIn")
+    network.initialize()
+
+    buffers = []
+    data = pickle.dumps(network, protocol=5, buffer_callback=buffers.append)
+    self.assertEqual(len(buffers), 1)
+    self.assertGreater(buffers[0].raw().nbytes, 10 * len(data))
+    network2 = pickle.loads(data, buffers=buffers)
+    self.assertTrue(network == network2)
+
+    # In band, and the older protocols.
+    for protocol in (2, 4, 5):
+      self.assertTrue(network == pickle.loads(pickle.dumps(network, protocol)))
+
 
@@ -170,6 +170,45 @@ class SdrTest(unittest.TestCase):
         else:
             self.fail()
 
+    def testSparseView(self):
+        A = SDR((10, 10))
+        view   = A.sparse_view( 5 )
+        buffer = np.asarray( view )
+        assert( view.capacity == 5 )
+        assert( buffer.dtype == np.uint32 )
+        # The same buffer is reused for every step.
+        for step in range(3):
+            buffer[:3] = [ 7 + step, 2, 50 ]
+            assert( view.commit( 3 ) is A )
+            assert( list(A.sparse) == sorted([ 7 + step, 2, 50 ]) )
+        view.commit( 0 )
+        assert( A.getSum() == 0 )
+
+        buffer[:2] = [ 4, 4 ]
+        self.assertRaises( RuntimeError, view.commit, 2 )   # duplicates
+        buffer[:1] = [ 100 ]
+        self.assertRaises( RuntimeError, view.commit, 1 )   # out of bounds
+        self.assertRaises( RuntimeError, view.commit, 6 )   # beyond capacity
+        self.assertRaises( RuntimeError, A.sparse_view, 101 )
+
+        # Sparse assignment from numpy, unsorted data is not modified.
+        data = np.array([ 9, 3 ], dtype=np.uint32)
+        A.sparse = data
+        assert( list(A.sparse) == [3, 9] )
+        assert( list(data) == [9, 3] )
+
+    def testBufferProtocol(self):
+        A = SDR((3, 4))
+        A.sparse = [ 1, 11 ]
+        dense = np.asarray( A )
+        assert( dense.shape == (3, 4) )
+        assert( dense.sum() == 2 and dense[0, 1] == 1 and dense[2, 3] == 1 )
+        assert( memoryview( A ).nbytes == A.size )
+        # No copy: the export shares its data with SDR.dense
+        dense[0, 0] = 1
+        A.dense = A.dense
+        assert( A.getSum() == 3 )
+
     def testCoordinates(self):
         A = SDR((103,))
         B = SDR((100, 100, 1))
@@ -0,0 +1,117 @@
+# ----------------------------------------------------------------------
+# HTM Community Edition of NuPIC
+# Copyright (C) 2020, Numenta, Inc.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Affero Public License version 3 as
+# published by the Free Software Foundation.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+# See the GNU Affero Public License for more details.
+#
+# You should have received a copy of the GNU Affero Public License
+# along with this program.    If not, see http://www.gnu.org/licenses.
+#
+# http://numenta.org/licenses/
+# ----------------------------------------------------------------------
+
+"""
+Reader for the binary files of htm::Watcher (Watcher::BINARY format).
+
+Usage:
+    python watcher_reader.py watch.bin watch.csv
+    python watcher_reader.py watch.bin watch.parquet   # needs pandas + pyarrow
+"""
+
+import csv
+import struct
+import sys
+
+MAGIC = b"HTMWATCH"
+VERSION = 1
+
+# NTA_BasicType order, see src/htm/types/Types.hpp
+TYPES = [
+    ("Byte", "b"), ("Int16", "h"), ("UInt16", "H"), ("Int32", "i"),
+    ("UInt32", "I"), ("Int64", "q"), ("UInt64", "Q"), ("Real32", "f"),
+    ("Real64", "d"), ("Handle", None), ("Bool", "?"), ("SDR", "B"),
+    ("String", None),
+]
+STR_TYPE = 12
+SPARSE = 1
+
+_RECORD = struct.Struct("=QIHHQQ")
+
+
+def readRecords(path):
+    """
+    Yields one dict per record: iteration, watchID, name, type, size, sparse
+    and values (a list of numbers, the sparse indices if sparse, or a str).
+    """
+    with open(path, "rb") as f:
+        if f.read(len(MAGIC)) != MAGIC:
+            raise ValueError("%s is not a binary watcher file" % path)
+        version, numWatches = struct.unpack("=II", f.read(8))
+        if version != VERSION:
+            raise ValueError("unsupported watcher file version %d" % version)
+        names = {}
+        for _ in range(numWatches):
+            watchID, _type, length = struct.unpack("=III", f.read(12))
+            names[watchID] = f.read(length).decode("utf-8")
+
+        while True:
+            header = f.read(_RECORD.size)
+            if len(header) < _RECORD.size:
+                break
+            iteration, watchID, type_, encoding, size, count = _RECORD.unpack(header)
+            if type_ == STR_TYPE:
+                values = f.read(count).decode("utf-8")
+            else:
+                code = "I" if encoding == SPARSE else TYPES[type_][1]
+                payload = f.read(count * struct.calcsize(code))
+                values = list(struct.unpack("=%d%s" % (count, code), payload))
+            yield {
+                "iteration": iteration,
+                "watchID":   watchID,
+                "name":      names.get(watchID, ""),
+                "type":      TYPES[type_][0],
+                "size":      size,
+                "sparse":    encoding == SPARSE,
+                "values":    values,
+            }
+
+
+def toCSV(binaryFile, csvFile):
+    """Same columns as Watcher::toCSV(), values separated by spaces."""
+    with open(csvFile, "w", newline="") as out:
+        writer = csv.writer(out)
+        writer.writerow(["iteration", "watchID", "name", "type", "size", "values"])
+        for r in readRecords(binaryFile):
+            values = r["values"]
+            if not isinstance(values, str):
+                values = " ".join(str(v) for v in values)
+            writer.writerow([r["iteration"], r["watchID"], r["name"], r["type"],
+                             r["size"], values])
+
+
+def toParquet(binaryFile, parquetFile):
+    """Writes the records with pandas, one row per record."""
+    import pandas as pd
+    pd.DataFrame(list(readRecords(binaryFile))).to_parquet(parquetFile)
+
+
+def main(argv):
+    if len(argv) != 3:
+        print(__doc__)
+        return 1
+    if argv[2].endswith(".parquet"):
+        toParquet(argv[1], argv[2])
+    else:
+        toCSV(argv[1], argv[2])
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
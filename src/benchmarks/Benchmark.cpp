@@ -0,0 +1,145 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+#include "Benchmark.hpp"
+
+#include <htm/ntypes/Value.hpp>
+#include <htm/os/PerfCounters.hpp>
+#include <htm/os/Timer.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace benchmarks {
+
+using namespace std;
+using namespace htm;
+
+void Registry::add(const string &name, const vector<UInt> &sizes, Setup setup) {
+  NTA_CHECK(!sizes.empty()) << "Benchmark " << name << " has no sizes.";
+  cases_.push_back(Case{name, sizes, setup});
+}
+
+
+vector<string> Registry::names() const {
+  vector<string> names;
+  for (const auto &c : cases_) names.push_back(c.name);
+  return names;
+}
+
+
+vector<Result> Registry::run(const string &filter, const vector<UInt> &sizes,
+                             const Real64 minTime, ostream &log, const bool perfCounters) const {
+  vector<Result> results;
+  for (const auto &c : cases_) {
+    for (const UInt size : sizes.empty() ? c.sizes : sizes) {
+      Result r;
+      r.name = c.name + "/" + to_string(size);
+      if (r.name.find(filter) == string::npos) continue;
+
+      Step step = c.setup(size);
+      step(); // warm-up: caches, lazily built indexes, first allocations
+
+      Timer timer;
+      PerfCounters counters;
+      UInt64 batch = 1u;
+      while (timer.getElapsed() < minTime) {
+        if (perfCounters) counters.start();
+        timer.start();
+        for (UInt64 i = 0u; i < batch; i++) step();
+        timer.stop();
+        if (perfCounters) counters.stop();
+        r.iterations += batch;
+        batch *= 2u;
+      }
+      r.seconds = timer.getElapsed();
+      if (perfCounters)
+        r.counters = counters.toJSON(static_cast<Real64>(r.iterations));
+      log << left << setw(40) << r.name << right << setw(12) << r.iterations << " iters "
+          << setw(14) << fixed << setprecision(1) << r.rate() << " /s";
+      if (perfCounters)
+        log << "  " << (counters.isAvailable() ? r.counters : "(counters not available)");
+      log << endl;
+      results.push_back(r);
+    }
+  }
+  return results;
+}
+
+
+string Registry::toJson(const vector<Result> &results) {
+  stringstream ss;
+  ss << "{\"benchmarks\": [";
+  for (size_t i = 0; i < results.size(); i++) {
+    const auto &r = results[i];
+    ss << (i == 0u ? "\n" : ",\n")
+       << "  {\"name\": " << Value::json_string(r.name)
+       << ", \"iterations\": " << r.iterations
+       << ", \"seconds\": " << setprecision(9) << r.seconds
+       << ", \"rate\": " << setprecision(9) << r.rate();
+    if (!r.counters.empty() && r.counters != "{}")
+      ss << ", \"counters\": " << r.counters;
+    ss << "}";
+  }
+  ss << "\n]}\n";
+  return ss.str();
+}
+
+
+vector<Result> Registry::fromJson(const string &json) {
+  Value v;
+  v.parse(json);
+  const Value &list = v["benchmarks"];
+  NTA_CHECK(list.isSequence()) << "Not a benchmark results file, missing 'benchmarks' list.";
+  vector<Result> results;
+  for (size_t i = 0; i < list.size(); i++) {
+    Result r;
+    r.name       = list[i]["name"].str();
+    r.iterations = list[i]["iterations"].as<UInt64>();
+    r.seconds    = list[i]["seconds"].as<Real64>();
+    results.push_back(r);
+  }
+  return results;
+}
+
+
+bool Registry::compare(const vector<Result> &results, const vector<Result> &baseline,
+                       const Real64 tolerance, ostream &out) {
+  map<string, Real64> base;
+  for (const auto &b : baseline) base[b.name] = b.rate();
+
+  bool ok = true;
+  for (const auto &r : results) {
+    out << left << setw(40) << r.name << right;
+    const auto it = base.find(r.name);
+    if (it == base.end() || it->second <= 0.0) {
+      out << "  no baseline" << endl;
+      continue;
+    }
+    const Real64 ratio = r.rate() / it->second;
+    const bool slower = ratio < 1.0 - tolerance;
+    ok = ok && !slower;
+    out << setw(14) << fixed << setprecision(1) << r.rate() << " /s  vs "
+        << setw(14) << it->second << " /s  " << setw(7) << setprecision(3) << ratio << "x"
+        << (slower ? "  REGRESSION" : "") << endl;
+  }
+  return ok;
+}
+
+} // namespace benchmarks
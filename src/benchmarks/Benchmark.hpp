@@ -0,0 +1,99 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Minimal harness of the htm_benchmarks executable.
+ */
+
+#ifndef NTA_BENCHMARKS_BENCHMARK_HPP
+#define NTA_BENCHMARKS_BENCHMARK_HPP
+
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <htm/types/Types.hpp>
+
+namespace benchmarks {
+
+using htm::Real64;
+using htm::UInt;
+using htm::UInt64;
+
+/** One iteration of a benchmark, timed repeatedly. */
+using Step = std::function<void()>;
+
+/** Builds the benchmarked objects for the given size (not timed) and returns the step. */
+using Setup = std::function<Step(UInt size)>;
+
+struct Result {
+  std::string name; // "<case>/<size>"
+  UInt64 iterations = 0u;
+  Real64 seconds = 0.0;
+  std::string counters; // JSON object of hardware counters per iteration, empty if not measured
+
+  /** Throughput, iterations per second. */
+  Real64 rate() const { return seconds > 0.0 ? static_cast<Real64>(iterations) / seconds : 0.0; }
+};
+
+/**
+ * The benchmark cases and the tools around them: running, writing the
+ * results as JSON and comparing them with a stored baseline.
+ *
+ * Each case is run once per size. After one untimed warm-up call, the step is
+ * repeated in growing batches until it has run for at least minTime seconds.
+ */
+class Registry {
+public:
+  void add(const std::string &name, const std::vector<UInt> &sizes, Setup setup);
+
+  /**
+   * @param filter - run only the benchmarks whose "<case>/<size>" name contains it.
+   * @param sizes - if not empty, replaces the sizes of every case.
+   * @param minTime - seconds each benchmark runs at least.
+   * @param log - progress, one line per benchmark.
+   * @param perfCounters - also read the hardware counters, see htm::PerfCounters.
+   */
+  std::vector<Result> run(const std::string &filter, const std::vector<UInt> &sizes,
+                          Real64 minTime, std::ostream &log, bool perfCounters = false) const;
+
+  /** Names of all the cases, without sizes. */
+  std::vector<std::string> names() const;
+
+  static std::string toJson(const std::vector<Result> &results);
+  static std::vector<Result> fromJson(const std::string &json);
+
+  /**
+   * Print the throughput of each result relative to the baseline of the same
+   * name. Results without a baseline are reported and ignored.
+   * @return false if any result is slower than (1 - tolerance) * baseline.
+   */
+  static bool compare(const std::vector<Result> &results, const std::vector<Result> &baseline,
+                      Real64 tolerance, std::ostream &out);
+
+private:
+  struct Case {
+    std::string name;
+    std::vector<UInt> sizes;
+    Setup setup;
+  };
+  std::vector<Case> cases_;
+};
+
+} // namespace benchmarks
+#endif // NTA_BENCHMARKS_BENCHMARK_HPP
@@ -0,0 +1,351 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * htm_loadgen: open-loop load of encoder -> SP -> TM -> classifier networks,
+ * one per stream, in this process or through the REST server, see README.md.
+ *
+ *   htm_loadgen [--streams N] [--rate PER_SEC] [--duration SEC] [--warmup SEC]
+ *               [--columns N] [--cells N] [--no-learn]
+ *               [--rest HOST:PORT] [--json OUT.json]
+ *
+ * Exit status is 1 if any request failed, 2 on errors.
+ */
+
+#include <cmath> // sin
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !defined(NTA_OS_WINDOWS)
+#include <time.h>   // clock_gettime
+#include <unistd.h> // sysconf
+#endif
+
+// save diagnostic state
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wsign-compare"
+#include <httplib.h>
+#pragma GCC diagnostic pop
+
+#include <htm/engine/Network.hpp>
+#include <htm/ntypes/Value.hpp>
+#include <htm/utils/LatencyHistogram.hpp>
+#include <htm/utils/Log.hpp>
+
+using namespace std;
+using namespace htm;
+
+namespace {
+
+struct Options {
+  size_t streams = 4u;
+  Real64 rate = 100.0;    // requests per second, per stream
+  Real64 duration = 10.0; // seconds measured
+  Real64 warmup = 1.0;    // seconds before, not measured
+  UInt columns = 2048u;
+  UInt cells = 8u;
+  bool learn = true;
+  string rest;            // "host:port", empty to run the networks in this process
+  string jsonOut;
+};
+
+struct StreamResult {
+  LatencyHistogram latency; // from the scheduled time of a request to its reply
+  UInt64 errors = 0u;
+  string error;             // the first one
+  Real64 cpuSeconds = 0.0;  // of the stream's thread while measured
+  size_t memoryBytes = 0u;  // of its network at the end, see Network::memoryUsage()
+};
+
+
+// Same network as examples/napi_hello and the REST client, with a classifier
+// of the encoder's buckets on the TM's cells.
+string networkConfig(const Options &o) {
+  stringstream ss;
+  ss << "{network: [\n"
+     << "  {addRegion: {name: encoder, type: RDSEEncoderRegion,"
+     << " params: {size: 1000, sparsity: 0.2, radius: 0.03, seed: 2019, noise: 0.01}}},\n"
+     << "  {addRegion: {name: sp, type: SPRegion,"
+     << " params: {columnCount: " << o.columns << ", globalInhibition: true, learningMode: " << (o.learn ? 1 : 0) << "}}},\n"
+     << "  {addRegion: {name: tm, type: TMRegion,"
+     << " params: {cellsPerColumn: " << o.cells << ", learningMode: " << (o.learn ? "true" : "false") << "}}},\n"
+     << "  {addRegion: {name: classifier, type: ClassifierRegion, params: {learn: " << (o.learn ? "true" : "false") << "}}},\n"
+     << "  {addLink: {src: encoder.encoded, dest: sp.bottomUpIn}},\n"
+     << "  {addLink: {src: sp.bottomUpOut, dest: tm.bottomUpIn}},\n"
+     << "  {addLink: {src: tm.bottomUpOut, dest: classifier.pattern}},\n"
+     << "  {addLink: {src: encoder.bucket, dest: classifier.bucket}}\n"
+     << "]}";
+  return ss.str();
+}
+
+// CPU time of the calling thread, 0 where it is not available.
+Real64 threadCpuSeconds() {
+#if !defined(NTA_OS_WINDOWS)
+  timespec t;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t) == 0)
+    return static_cast<Real64>(t.tv_sec) + static_cast<Real64>(t.tv_nsec) * 1.0e-9;
+#endif
+  return 0.0;
+}
+
+// Resident memory of the process in bytes, 0 where it is not available.
+size_t residentBytes() {
+#if !defined(NTA_OS_WINDOWS)
+  ifstream statm("/proc/self/statm");
+  size_t pages = 0u, resident = 0u;
+  if (statm >> pages >> resident)
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+  return 0u;
+}
+
+
+/** One stream: a network, and a request to it. */
+class Stream {
+public:
+  virtual ~Stream() = default;
+  /** One record: sets the encoder's value and runs the network once. Throws on errors. */
+  virtual void request(Real64 value) = 0;
+  virtual size_t memoryBytes() = 0;
+};
+
+class LocalStream : public Stream {
+public:
+  explicit LocalStream(const Options &o) {
+    net_.configure(networkConfig(o));
+    net_.initialize();
+    encoder_ = net_.getRegion("encoder");
+  }
+  void request(Real64 value) override {
+    encoder_->setParameterReal64("sensedValue", value);
+    net_.run(1);
+  }
+  size_t memoryBytes() override { return memory::total(net_.memoryUsage()); }
+
+private:
+  Network net_;
+  shared_ptr<Region> encoder_;
+};
+
+// The calls of examples/rest/client.cpp: PUT the encoder's sensedValue, GET run.
+class RestStream : public Stream {
+public:
+  RestStream(const Options &o, const string &host, int port) : client_(host.c_str(), port) {
+    auto res = client_.Post("/network", networkConfig(o), "application/json");
+    NTA_CHECK(res && res->status / 100 == 2) << "htm_loadgen: no reply of " << host << ":" << port;
+    id_ = trim(res->body);
+    NTA_CHECK(id_.find("err") == string::npos) << "htm_loadgen: configure failed: " << id_;
+  }
+  ~RestStream() override { client_.Delete(("/network/" + id_ + "/ALL").c_str()); }
+
+  void request(Real64 value) override {
+    stringstream path;
+    path << "/network/" << id_ << "/region/encoder/param/sensedValue?data=" << value;
+    check(client_.Put(path.str().c_str(), httplib::Params()), "param");
+    check(client_.Get(("/network/" + id_ + "/run").c_str()), "run");
+  }
+
+  size_t memoryBytes() override {
+    auto res = client_.Get(("/network/" + id_ + "/memory").c_str());
+    if (!res || res->status / 100 != 2)
+      return 0u;
+    Value reply;
+    reply.parse(res->body);
+    return reply.contains("result") ? static_cast<size_t>(reply["result"]["total"].as<UInt64>()) : 0u;
+  }
+
+private:
+  static string trim(const string &s) {
+    const size_t begin = s.find_first_not_of(" \t\r\n");
+    const size_t end = s.find_last_not_of(" \t\r\n");
+    return begin == string::npos ? string() : s.substr(begin, end - begin + 1u);
+  }
+  template <typename Reply> static void check(const Reply &res, const char *what) {
+    NTA_CHECK(res) << "htm_loadgen: " << what << ": no reply";
+    NTA_CHECK(res->status / 100 == 2 && trim(res->body) == "OK") << "htm_loadgen: " << what << ": " << trim(res->body);
+  }
+
+  httplib::Client client_;
+  string id_;
+};
+
+
+/**
+ * Open loop: request k of a stream is due at start + k / rate whatever the
+ * replies before it, and its latency counts from then, not from when it was
+ * sent. A stream which falls behind sends at once, and the time it waited
+ * is part of the latency, so a slow network shows in the tail instead of
+ * lowering the offered rate (no "coordinated omission").
+ */
+void runStream(Stream &stream, const Options &o, const UInt64 start, const size_t index, StreamResult &result) {
+  const Real64 period = 1.0e9 / o.rate;
+  const UInt64 measured = start + static_cast<UInt64>(o.warmup * 1.0e9);
+  const UInt64 end = measured + static_cast<UInt64>(o.duration * 1.0e9);
+  // the streams start spread over one period, not all at once
+  const Real64 offset = period * static_cast<Real64>(index) / static_cast<Real64>(o.streams);
+  Real64 cpuStart = -1.0;
+  for (UInt64 k = 0u;; k++) {
+    const UInt64 due = start + static_cast<UInt64>(offset + period * static_cast<Real64>(k));
+    if (due >= end)
+      break;
+    const UInt64 now = LatencyHistogram::now();
+    if (due > now)
+      this_thread::sleep_for(chrono::nanoseconds(due - now));
+    if (due >= measured && cpuStart < 0.0)
+      cpuStart = threadCpuSeconds();
+    try {
+      stream.request(std::sin(0.01 * static_cast<Real64>(k)));
+    } catch (const exception &e) {
+      if (due >= measured && result.errors++ == 0u)
+        result.error = e.what();
+      continue;
+    }
+    if (due >= measured)
+      result.latency.record(LatencyHistogram::now() - due);
+  }
+  if (cpuStart >= 0.0)
+    result.cpuSeconds = threadCpuSeconds() - cpuStart;
+  result.memoryBytes = stream.memoryBytes();
+}
+
+
+string toJson(const Options &o, const vector<StreamResult> &results, const LatencyHistogram &all,
+              const Real64 throughput, const size_t rss) {
+  stringstream ss;
+  ss << "{\"streams\": " << o.streams << ", \"rate\": " << o.rate << ", \"duration\": " << o.duration
+     << ", \"columns\": " << o.columns << ", \"cells\": " << o.cells << ", \"learn\": " << (o.learn ? "true" : "false")
+     << ", \"target\": \"" << (o.rest.empty() ? "local" : o.rest) << "\""
+     << ", \"throughput\": " << throughput << ", \"p999\": " << all.getPercentile(99.9)
+     << ", \"latency\": " << all.toJSON() << ", \"rss\": " << rss << ",\n \"perStream\": [";
+  for (size_t i = 0u; i < results.size(); i++) {
+    const auto &r = results[i];
+    ss << (i ? ",\n  " : "\n  ") << "{\"throughput\": " << static_cast<Real64>(r.latency.getCount()) / o.duration
+       << ", \"errors\": " << r.errors << ", \"cpu\": " << r.cpuSeconds / o.duration
+       << ", \"memory\": " << r.memoryBytes << ", \"p999\": " << r.latency.getPercentile(99.9)
+       << ", \"latency\": " << r.latency.toJSON() << "}";
+  }
+  ss << "]}\n";
+  return ss.str();
+}
+
+void printRow(ostream &out, const string &name, const LatencyHistogram &latency, const Real64 throughput,
+              const UInt64 errors, const Real64 cpu, const size_t memory) {
+  out << left << setw(8) << name << right << fixed << setprecision(1) << setw(10) << throughput
+      << setprecision(3) << setw(10) << latency.getPercentile(50.0) * 1e3 << setw(10)
+      << latency.getPercentile(99.0) * 1e3 << setw(10) << latency.getPercentile(99.9) * 1e3 << setw(10)
+      << latency.getMax() * 1e3 << setw(8) << errors << setprecision(1) << setw(8) << cpu * 100.0 << setw(10)
+      << static_cast<Real64>(memory) / (1u << 20u) << endl;
+}
+
+} // namespace
+
+
+int main(int argc, char *argv[]) {
+  Options o;
+  try {
+    for (int a = 1; a < argc; a++) {
+      const string arg = argv[a];
+      const auto value = [&]() -> string {
+        NTA_CHECK(a + 1 < argc) << "Missing value of " << arg;
+        return argv[++a];
+      };
+      if      (arg == "--streams")  o.streams = stoul(value());
+      else if (arg == "--rate")     o.rate = stod(value());
+      else if (arg == "--duration") o.duration = stod(value());
+      else if (arg == "--warmup")   o.warmup = stod(value());
+      else if (arg == "--columns")  o.columns = static_cast<UInt>(stoul(value()));
+      else if (arg == "--cells")    o.cells = static_cast<UInt>(stoul(value()));
+      else if (arg == "--no-learn") o.learn = false;
+      else if (arg == "--rest")     o.rest = value();
+      else if (arg == "--json")     o.jsonOut = value();
+      else NTA_THROW << "Unknown argument " << arg << ", see the header of src/benchmarks/loadgen.cpp";
+    }
+    NTA_CHECK(o.streams > 0u && o.rate > 0.0 && o.duration > 0.0 && o.warmup >= 0.0)
+        << "--streams, --rate and --duration must be positive";
+#ifndef NDEBUG
+    cerr << "Warning: this is a Debug build, the timings are not representative." << endl;
+#endif
+
+    string host;
+    int port = 8050;
+    if (!o.rest.empty()) {
+      const size_t colon = o.rest.rfind(':');
+      host = o.rest.substr(0u, colon);
+      if (colon != string::npos)
+        port = stoi(o.rest.substr(colon + 1u));
+    }
+    vector<unique_ptr<Stream>> streams;
+    for (size_t i = 0u; i < o.streams; i++) {
+      if (o.rest.empty())
+        streams.emplace_back(new LocalStream(o));
+      else
+        streams.emplace_back(new RestStream(o, host, port));
+    }
+
+    cout << o.streams << " streams of " << o.rate << " requests/s for " << o.duration << " s (after "
+         << o.warmup << " s warm-up), " << (o.rest.empty() ? "in process" : "REST server " + o.rest) << endl;
+    vector<StreamResult> results(o.streams);
+    vector<thread> threads;
+    const UInt64 start = LatencyHistogram::now() + 10000000u; // 10 ms to start the threads
+    for (size_t i = 0u; i < o.streams; i++)
+      threads.emplace_back(runStream, ref(*streams[i]), cref(o), start, i, ref(results[i]));
+    for (auto &t : threads)
+      t.join();
+
+    LatencyHistogram all;
+    UInt64 errors = 0u;
+    Real64 cpu = 0.0;
+    size_t memory = 0u;
+    cout << "\n" << left << setw(8) << "stream" << right << setw(10) << "req/s" << setw(10) << "p50 ms"
+         << setw(10) << "p99 ms" << setw(10) << "p999 ms" << setw(10) << "max ms" << setw(8) << "errors"
+         << setw(8) << "cpu %" << setw(10) << "MiB" << endl;
+    for (size_t i = 0u; i < results.size(); i++) {
+      const auto &r = results[i];
+      printRow(cout, to_string(i), r.latency, static_cast<Real64>(r.latency.getCount()) / o.duration, r.errors,
+               r.cpuSeconds / o.duration, r.memoryBytes);
+      all.merge(r.latency);
+      errors += r.errors;
+      cpu += r.cpuSeconds;
+      memory += r.memoryBytes;
+    }
+    const Real64 throughput = static_cast<Real64>(all.getCount()) / o.duration;
+    printRow(cout, "all", all, throughput, errors, cpu / o.duration, memory);
+    const size_t rss = residentBytes();
+    if (rss > 0u)
+      cout << "resident memory of htm_loadgen: " << setprecision(1) << static_cast<Real64>(rss) / (1u << 20u) << " MiB"
+           << endl;
+    for (size_t i = 0u; i < results.size(); i++) {
+      if (results[i].errors > 0u)
+        cerr << "stream " << i << ": " << results[i].errors << " errors, first: " << results[i].error << endl;
+    }
+
+    if (!o.jsonOut.empty()) {
+      ofstream f(o.jsonOut);
+      f << toJson(o, results, all, throughput, rss);
+    }
+    return errors > 0u ? 1 : 0;
+  } catch (const exception &e) {
+    cerr << "htm_loadgen: " << e.what() << endl;
+    return 2;
+  }
+}
@@ -0,0 +1,343 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * htm_benchmarks: throughput of the main algorithms, see README.md.
+ *
+ *   htm_benchmarks [--filter SUBSTR] [--sizes N,N,..] [--min-time SEC] [--perf]
+ *                  [--json OUT.json] [--baseline BASE.json] [--tolerance FRACTION]
+ *   htm_benchmarks --compare RESULTS.json BASE.json [--tolerance FRACTION]
+ *   htm_benchmarks --list
+ *
+ * --perf also reads the hardware counters (Linux perf_event) and reports them
+ * per iteration.
+ *
+ * Exit status is 1 if a result is slower than the baseline by more than the
+ * tolerance (default 0.1, ie. 10%), 2 on errors.
+ */
+
+#include <cmath> // sin
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+#include "Benchmark.hpp"
+
+#include <htm/algorithms/Connections.hpp>
+#include <htm/algorithms/SpatialPooler.hpp>
+#include <htm/algorithms/TemporalMemory.hpp>
+#include <htm/encoders/RandomDistributedScalarEncoder.hpp>
+#include <htm/encoders/ScalarEncoder.hpp>
+#include <htm/engine/Network.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/utils/Random.hpp>
+
+using namespace std;
+using namespace htm;
+using namespace benchmarks;
+
+namespace {
+
+const UInt SEED = 42u;
+const UInt NUM_INPUTS = 100u; // distinct inputs the steps cycle through
+
+vector<SDR> randomSDRs(const vector<UInt> &dimensions, const Real sparsity, Random &rng) {
+  vector<SDR> sdrs(NUM_INPUTS, SDR(dimensions));
+  for (auto &sdr : sdrs) sdr.randomize(sparsity, rng);
+  return sdrs;
+}
+
+
+void addConnections(Registry &r) {
+  // One segment per cell with 32 synapses to random cells, 2% of the cells active.
+  struct State {
+    Connections connections;
+    vector<vector<CellIdx>> activeCells;
+    vector<SDR> inputs;
+    vector<Segment> segments;
+    SegmentActivity activity;
+    size_t i = 0u;
+  };
+  const auto build = [](const UInt size) {
+    auto s = make_shared<State>();
+    Random rng(SEED);
+    s->connections.initialize(size);
+    for (CellIdx cell = 0u; cell < size; cell++) {
+      const Segment seg = s->connections.createSegment(cell);
+      for (UInt syn = 0u; syn < 32u; syn++) {
+        s->connections.createSynapse(seg, rng.getUInt32(size), static_cast<Permanence>(rng.getReal64()));
+      }
+    }
+    s->inputs = randomSDRs({size}, 0.02f, rng);
+    for (const auto &sdr : s->inputs) s->activeCells.push_back(sdr.getSparse());
+    for (UInt n = 0u; n < 40u; n++) s->segments.push_back(rng.getUInt32(size));
+    return s;
+  };
+
+  r.add("Connections/computeActivity", {16384u, 65536u}, [build](UInt size) -> Step {
+    auto s = build(size);
+    return [s]() {
+      s->connections.computeActivity(s->activity, s->activeCells[s->i++ % NUM_INPUTS], false);
+    };
+  });
+  r.add("Connections/adaptSegment", {16384u, 65536u}, [build](UInt size) -> Step {
+    auto s = build(size);
+    return [s]() {
+      const SDR &input = s->inputs[s->i++ % NUM_INPUTS];
+      for (const auto seg : s->segments) s->connections.adaptSegment(seg, input, 0.01f, 0.01f);
+    };
+  });
+}
+
+
+void addSpatialPooler(Registry &r) {
+  const auto sp = [](const bool global) {
+    return [global](UInt size) -> Step {
+      Random rng(SEED);
+      auto inputs = make_shared<vector<SDR>>(randomSDRs({1000u}, 0.2f, rng));
+      auto sp = make_shared<SpatialPooler>(vector<UInt>{1000u}, vector<UInt>{size});
+      sp->setGlobalInhibition(global);
+      auto out = make_shared<SDR>(vector<UInt>{size});
+      auto i = make_shared<size_t>(0u);
+      return [=]() { sp->compute((*inputs)[(*i)++ % NUM_INPUTS], true, *out); };
+    };
+  };
+  r.add("SP/global", {1024u, 4096u}, sp(true));
+  r.add("SP/local",  {1024u},        sp(false));
+}
+
+
+void addTemporalMemory(Registry &r) {
+  r.add("TM/compute", {1024u, 2048u}, [](UInt size) -> Step {
+    Random rng(SEED);
+    auto inputs = make_shared<vector<SDR>>(randomSDRs({size}, 0.02f, rng));
+    auto tm = make_shared<TemporalMemory>(vector<CellIdx>{size}, 8u);
+    auto i = make_shared<size_t>(0u);
+    return [=]() { tm->compute((*inputs)[(*i)++ % NUM_INPUTS], true); };
+  });
+}
+
+
+void addEncoders(Registry &r) {
+  r.add("Encoder/RDSE", {1000u, 10000u}, [](UInt size) -> Step {
+    RDSE_Parameters p;
+    p.size = size;
+    p.sparsity = 0.02f;
+    p.radius = 0.03f;
+    p.seed = SEED;
+    auto enc = make_shared<RandomDistributedScalarEncoder>(p);
+    auto out = make_shared<SDR>(enc->dimensions);
+    auto x = make_shared<Real64>(0.0);
+    return [=]() { enc->encode(std::sin(*x += 0.01), *out); };
+  });
+  r.add("Encoder/Scalar", {1000u, 10000u}, [](UInt size) -> Step {
+    ScalarEncoderParameters p;
+    p.minimum = -1.0;
+    p.maximum = 1.0;
+    p.size = size;
+    p.sparsity = 0.02f;
+    auto enc = make_shared<ScalarEncoder>(p);
+    auto out = make_shared<SDR>(enc->dimensions);
+    auto x = make_shared<Real64>(0.0);
+    return [=]() { enc->encode(std::sin(*x += 0.01), *out); };
+  });
+}
+
+
+void addSDR(Registry &r) {
+  struct State {
+    vector<SDR> a, b;
+    SDR out;
+    size_t i = 0u;
+    UInt sum = 0u;
+    State(const UInt size, Random &rng) : a(randomSDRs({size}, 0.02f, rng)),
+                                          b(randomSDRs({size}, 0.02f, rng)), out({size}) {}
+  };
+  r.add("SDR/sparseToDense", {2048u, 65536u}, [](UInt size) -> Step {
+    Random rng(SEED);
+    auto s = make_shared<State>(size, rng);
+    return [s]() {
+      s->out.setSparse(s->a[s->i++ % NUM_INPUTS].getSparse());
+      s->sum += s->out.getDense()[0];
+    };
+  });
+  r.add("SDR/intersection", {2048u, 65536u}, [](UInt size) -> Step {
+    Random rng(SEED);
+    auto s = make_shared<State>(size, rng);
+    return [s]() {
+      const size_t n = s->i++ % NUM_INPUTS;
+      s->out.intersection(s->a[n], s->b[n]);
+    };
+  });
+  r.add("SDR/getOverlap", {2048u, 65536u}, [](UInt size) -> Step {
+    Random rng(SEED);
+    auto s = make_shared<State>(size, rng);
+    return [s]() {
+      const size_t n = s->i++ % NUM_INPUTS;
+      s->sum += s->a[n].getOverlap(s->b[n]);
+    };
+  });
+}
+
+
+void addNetwork(Registry &r) {
+  // A chain of TestNodes, the cost is mostly moving the outputs along the links.
+  r.add("Link/chain4", {1000u, 100000u}, [](UInt size) -> Step {
+    auto net = make_shared<Network>();
+    const string params = "{dim: [" + to_string(size) + "]}";
+    for (int n = 0; n < 4; n++) net->addRegion("node" + to_string(n), "TestNode", params);
+    for (int n = 1; n < 4; n++) net->link("node" + to_string(n - 1), "node" + to_string(n));
+    net->initialize();
+    return [net]() { net->run(1); };
+  });
+
+  // Same network as examples/napi_hello, without the file output.
+  r.add("Network/run", {1024u, 2048u}, [](UInt size) -> Step {
+    auto net = make_shared<Network>();
+    auto encoder = net->addRegion("encoder", "RDSEEncoderRegion",
+                                  "{size: 1000, sparsity: 0.2, radius: 0.03, seed: 2019, noise: 0.01}");
+    net->addRegion("sp", "SPRegion", "{columnCount: " + to_string(size) + ", globalInhibition: true}");
+    net->addRegion("tm", "TMRegion", "{cellsPerColumn: 8, orColumnOutputs: true}");
+    net->link("encoder", "sp", "", "", "encoded", "bottomUpIn");
+    net->link("sp", "tm", "", "", "bottomUpOut", "bottomUpIn");
+    net->initialize();
+    auto x = make_shared<Real64>(0.0);
+    return [=]() {
+      encoder->setParameterReal64("sensedValue", std::sin(*x += 0.01));
+      net->run(1);
+    };
+  });
+}
+
+
+void addSerialization(Registry &r) {
+  // Models trained on 100 inputs, saved to and loaded from memory.
+  r.add("Serialize/SP", {1024u, 4096u}, [](UInt size) -> Step {
+    Random rng(SEED);
+    auto sp = make_shared<SpatialPooler>(vector<UInt>{1000u}, vector<UInt>{size});
+    SDR out({size});
+    for (const auto &in : randomSDRs({1000u}, 0.2f, rng)) sp->compute(in, true, out);
+    return [sp]() {
+      stringstream ss;
+      sp->save(ss);
+      SpatialPooler loaded;
+      loaded.load(ss);
+    };
+  });
+  r.add("Serialize/TM", {1024u, 2048u}, [](UInt size) -> Step {
+    Random rng(SEED);
+    auto tm = make_shared<TemporalMemory>(vector<CellIdx>{size}, 8u);
+    const auto inputs = randomSDRs({size}, 0.02f, rng);
+    for (int epoch = 0; epoch < 3; epoch++) {
+      for (const auto &in : inputs) tm->compute(in, true);
+    }
+    return [tm]() {
+      stringstream ss;
+      tm->save(ss);
+      TemporalMemory loaded;
+      loaded.load(ss);
+    };
+  });
+}
+
+
+vector<UInt> parseSizes(const string &list) {
+  vector<UInt> sizes;
+  stringstream ss(list);
+  string item;
+  while (getline(ss, item, ',')) sizes.push_back(static_cast<UInt>(stoul(item)));
+  return sizes;
+}
+
+string readFile(const string &path) {
+  ifstream f(path);
+  NTA_CHECK(f.is_open()) << "Cannot open " << path;
+  stringstream ss;
+  ss << f.rdbuf();
+  return ss.str();
+}
+
+} // namespace
+
+
+int main(int argc, char *argv[]) {
+  string filter, jsonOut, baselineFile, compareFile;
+  vector<UInt> sizes;
+  Real64 minTime = 0.5;
+  Real64 tolerance = 0.1;
+  bool list = false;
+  bool perf = false;
+
+  try {
+    for (int a = 1; a < argc; a++) {
+      const string arg = argv[a];
+      const auto value = [&]() -> string {
+        NTA_CHECK(a + 1 < argc) << "Missing value of " << arg;
+        return argv[++a];
+      };
+      if      (arg == "--filter")    filter = value();
+      else if (arg == "--sizes")     sizes = parseSizes(value());
+      else if (arg == "--min-time")  minTime = stod(value());
+      else if (arg == "--json")      jsonOut = value();
+      else if (arg == "--baseline")  baselineFile = value();
+      else if (arg == "--tolerance") tolerance = stod(value());
+      else if (arg == "--compare")   { compareFile = value(); baselineFile = value(); }
+      else if (arg == "--list")      list = true;
+      else if (arg == "--perf")      perf = true;
+      else NTA_THROW << "Unknown argument " << arg << ", see the header of src/benchmarks/main.cpp";
+    }
+
+    Registry registry;
+    addConnections(registry);
+    addSpatialPooler(registry);
+    addTemporalMemory(registry);
+    addEncoders(registry);
+    addSDR(registry);
+    addNetwork(registry);
+    addSerialization(registry);
+
+    if (list) {
+      for (const auto &name : registry.names()) cout << name << endl;
+      return 0;
+    }
+
+    vector<Result> results;
+    if (!compareFile.empty()) {
+      results = Registry::fromJson(readFile(compareFile));
+    } else {
+#ifndef NDEBUG
+      cerr << "Warning: this is a Debug build, the timings are not representative." << endl;
+#endif
+      results = registry.run(filter, sizes, minTime, cout, perf);
+    }
+
+    if (!jsonOut.empty()) {
+      ofstream f(jsonOut);
+      f << Registry::toJson(results);
+    }
+
+    if (!baselineFile.empty()) {
+      cout << "\nCompared with " << baselineFile << " (tolerance " << tolerance << "):" << endl;
+      const bool ok = Registry::compare(results, Registry::fromJson(readFile(baselineFile)), tolerance, cout);
+      return ok ? 0 : 1;
+    }
+  } catch (const exception &e) {
+    cerr << "htm_benchmarks: " << e.what() << endl;
+    return 2;
+  }
+  return 0;
+}
@@ -10,6 +10,8 @@
 // To run as https, define SERVER_CERT_FILE and SERVER_PRIVATE_KEY_FILE
 // which must point to a certification.
 // See server_core.hpp for more details.
+//
+// Usage: server [port [interface [store [idle_seconds hibernation_dir]]]]
 
 
 //#define SERVER_CERT_FILE "./cert.pem"
@@ -69,15 +71,34 @@ int main(int argc, char** argv) {
   std::string net_interface = DEFAULT_INTERFACE;
   int port = DEFAULT_PORT;
 
+  std::string store;
+
   if(argc == 2) {
     port = std::stoi(argv[1]);
   }
-  else if(argc == 3) {
+  else if(argc >= 3) {
     port = std::stoi(argv[1]);
     net_interface = argv[2];
   }
+  if(argc >= 4) {
+    store = argv[3];  // directory with the saved networks
+  }
+  unsigned int idle_seconds = 0u;
+  std::string hibernation;
+  if(argc == 6) {
+    idle_seconds = static_cast<unsigned int>(std::stoul(argv[4]));
+    hibernation = argv[5];  // directory for the checkpoints of idle networks
+  }
 
   RESTserver  server;
+  if (!store.empty()) {
+    size_t found = RESTapi::getInstance()->open_store(store);
+    VERBOSE << "Found " << found << " saved networks in " << store << std::endl;
+  }
+  if (idle_seconds > 0u) {
+    RESTapi::getInstance()->set_hibernation(idle_seconds, hibernation);
+    VERBOSE << "Hibernating networks idle for " << idle_seconds << "s to " << hibernation << std::endl;
+  }
  
 
   // How to perform logging.
@@ -40,10 +40,15 @@
 //       Get the value of a region's parameter.
 //  PUT  /network/<id>/input/<input name>?data=<JSON encoded array>
 //       Set the value of a region's input. The <data> could also be in the body.
+//       With Content-Type application/x-htm-array the body is a binary frame.
 //  GET  /network/<id>/region/<region name>/input/<input name>
 //       Get the value of a region's input. Returns a JSON encoded array.
 //  GET  /network/<id>/region/<region name>/output/<output name>
-//       Get the value of a region's output. Returns a JSON encoded array.
+//       Get the value of a region's output. Returns a JSON encoded array,
+//       or a binary frame if the Accept header is application/x-htm-array.
+//  POST /network/<id>/stream?input=<input name>&output=<region name>.<output name>
+//       Run one iteration per binary input frame in the body. Returns the
+//       binary output frames, one per iteration.
 //  DELETE /network/<id>/region/<region name>
 //       Deletes a region. Must not be in any links.
 //  DELETE /network/<id>/link/<source_name>/<dest_name>
@@ -52,11 +57,35 @@
 //       Deletes the entire Network object
 //  GET  /network/<id>/run?iterations=<iterations>
 //       Execute all regions in phase order. Repeat <iterations> times.
+//  POST /network/<id>/step
+//       Set several inputs, run and return selected outputs in one request.
+//       The body is {inputs: {<input name>: {data: [...]}}, outputs: ["<region>.<output>"],
+//       iterations: <iterations>}, or {records: [...], ...} for a batch of records.
 //  GET  /network/<id>/region/<region name>/command?data=<command>
 //       Execute a predefined command on a region. <command> must start with the
 //       command name followed by the arguments.
 //       The data could also be in the body.
+//  PUT  /network/<id>/region/<region name>/swap?file=<path>
+//       Hot swap: load a saved region of the same type in the background and
+//       swap it in before the next iteration, see Network::swapRegionAsync().
+//  GET  /network/<id>/region/<region name>/swap
+//       The state of the last swap of the region: "pending" or "swapped".
+//  GET  /network/<id>/save?wait=<true|false>
+//       Save the network to the store in the background, see RESTapi::open_store().
+//       With wait=true it returns when the file is written.
+//  GET  /network/<id>/load
+//       Replace the network with the one last saved in the store.
+//  GET  /network/<id>/profile?action=<action>
+//       Return the latency histograms (p50/p99/max) of the regions, links and callbacks.
+//       <action> is optional: enable, disable or reset the profiling.
+//  GET  /network/<id>/metrics
+//       Return runtime statistics in the Prometheus text exposition format.
+//  GET  /network/<id>/memory
+//       Return the bytes of memory of the network by category, and the total.
 //
+//  GET  /hibernation
+//       Return the hibernated networks and the hit / miss latencies, see
+//       RESTapi::set_hibernation().
 //  GET  /hi
 //       Respond with "Hello World\n" as a way to check client to server connection.
 //  GET  /stop
@@ -186,12 +215,17 @@ public:
       std::vector<std::string> flds = Path::split(req.path, '/');
       std::string id = flds[2];
       std::string input_name = flds[4];
+      RESTapi *interface = RESTapi::getInstance();
+      if (req.get_header_value("Content-Type") == RESTapi::BINARY_CONTENT_TYPE) {
+        std::string result = interface->put_input_binary_request(id, input_name, req.body);
+        res.set_content(result + "\n", "application/json");
+        return;
+      }
       std::string data = req.body;
       auto ix = req.params.find("data");
       if (ix != req.params.end())
         data = ix->second;
 
-      RESTapi *interface = RESTapi::getInstance();
       std::string result = interface->put_input_request(id, input_name, data);
       res.set_content(result + "\n", "application/json");
     });
@@ -218,10 +252,32 @@ public:
       std::string output_name = flds[6];
 
       RESTapi *interface = RESTapi::getInstance();
+      if (req.get_header_value("Accept") == RESTapi::BINARY_CONTENT_TYPE) {
+        set_binary_content(res, interface->get_output_binary_request(id, region_name, output_name));
+        return;
+      }
       std::string result = interface->get_output_request(id, region_name, output_name);
       res.set_content(result + "\n", "application/json");
     });
 
+    //  POST /network/<id>/stream?input=<input name>&output=<region name>.<output name>
+    //       The body is a sequence of binary input frames. For each frame the input
+    //       is set and the network runs one iteration. Returns one binary output
+    //       frame per iteration; many iterations over one request.
+    svr.Post("/network/.*/stream", [](const Request &req, Response &res) {
+      std::vector<std::string> flds = Path::split(req.path, '/');
+      std::string id = flds[2];
+      std::string input_name = req.get_param_value("input");
+      std::vector<std::string> output = Path::split(req.get_param_value("output"), '.');
+      if (output.size() != 2u) {
+        res.set_content("{\"err\": \"Expected syntax output=<region>.<output>\"}\n", "application/json");
+        return;
+      }
+
+      RESTapi *interface = RESTapi::getInstance();
+      set_binary_content(res, interface->stream_request(id, input_name, output[0], output[1], req.body));
+    });
+
     //  DELETE /network/<id>/region/<region name>
     //       Deletes a region. Must not be in any links.
     svr.Delete("/network/.*/region/.*", [](const Request &req, Response &res) {
@@ -274,6 +330,17 @@ public:
       res.set_content(result + "\n", "application/json");
     });
 
+    // POST /network/<id>/step
+    //    Set inputs, run and capture outputs in one round trip, see RESTapi::step_request().
+    svr.Post("/network/.*/step", [](const Request &req, Response &res) {
+      std::vector<std::string> flds = Path::split(req.path, '/');
+      std::string id = flds[2];
+
+      RESTapi *interface = RESTapi::getInstance();
+      std::string result = interface->step_request(id, req.body);
+      res.set_content(result + "\n", "application/json");
+    });
+
     //  GET  /network/<id>/region/<region name>/command?data=<command>
     //       Execute a predefined command on a region. <command> must start with the
     //       command name followed by the arguments.
@@ -292,7 +359,107 @@ public:
       res.set_content(result + "\n", "application/json");
     });
 
-    //  GET /stop
+    //  PUT  /network/<id>/region/<region name>/swap?file=<path>
+    //       Load a saved region in the background, swap it in before the next iteration.
+    svr.Put("/network/.*/region/.*/swap", [](const Request &req, Response &res) {
+      std::vector<std::string> flds = Path::split(req.path, '/');
+      std::string id = flds[2];
+      std::string region_name = flds[4];
+      std::string file = req.body;
+      auto ix = req.params.find("file");
+      if (ix != req.params.end())
+        file = ix->second;
+
+      RESTapi *interface = RESTapi::getInstance();
+      std::string result = file.empty() ? "{\"err\": \"swap: no file.\"}"
+                                        : interface->swap_request(id, region_name, file);
+      res.set_content(result + "\n", "application/json");
+    });
+
+    //  GET  /network/<id>/region/<region name>/swap
+    //       The state of the last swap of the region.
+    svr.Get("/network/.*/region/.*/swap", [](const Request &req, Response &res) {
+      std::vector<std::string> flds = Path::split(req.path, '/');
+      std::string id = flds[2];
+      std::string region_name = flds[4];
+
+      RESTapi *interface = RESTapi::getInstance();
+      std::string result = interface->swap_request(id, region_name, "");
+      res.set_content(result + "\n", "application/json");
+    });
+
+    //  GET /network/<id>/save?wait=<true|false>
+    //       Save the network into the store, in the background unless wait=true.
+    svr.Get("/network/.*/save", [](const Request &req, Response &res) {
+      std::vector<std::string> flds = Path::split(req.path, '/');
+      std::string id = flds[2];
+      bool wait = req.get_param_value("wait") == "true";
+
+      RESTapi *interface = RESTapi::getInstance();
+      std::string result = interface->save_request(id, wait);
+      res.set_content(result + "\n", "application/json");
+    });
+
+    //  GET /network/<id>/load
+    //       Replace the network with the one last saved in the store.
+    svr.Get("/network/.*/load", [](const Request &req, Response &res) {
+      std::vector<std::string> flds = Path::split(req.path, '/');
+      std::string id = flds[2];
+
+      RESTapi *interface = RESTapi::getInstance();
+      std::string result = interface->load_request(id);
+      res.set_content(result + "\n", "application/json");
+    });
+
+    //  GET /network/<id>/profile?action=<action>
+    //       Return the latency histograms of the regions, links and callbacks.
+    //       <action> is optional: enable, disable or reset the profiling instead.
+    svr.Get("/network/.*/profile", [](const Request &req, Response &res) {
+      std::vector<std::string> flds = Path::split(req.path, '/');
+      std::string id = flds[2];
+      std::string action;
+      auto ix = req.params.find("action");
+      if (ix != req.params.end())
+        action = ix->second;
+
+      RESTapi *interface = RESTapi::getInstance();
+      std::string result = interface->profile_request(id, action);
+      res.set_content(result + "\n", "application/json");
+    });
+
+    //  GET /network/<id>/metrics
+    //       Return runtime statistics in the Prometheus text exposition format.
+    svr.Get("/network/.*/metrics", [](const Request &req, Response &res) {
+      std::vector<std::string> flds = Path::split(req.path, '/');
+      std::string id = flds[2];
+
+      RESTapi *interface = RESTapi::getInstance();
+      std::string result = interface->metrics_request(id);
+      if (result.compare(0, 7, "{\"err\":") == 0)
+        res.set_content(result + "\n", "application/json");
+      else
+        res.set_content(result, "text/plain; version=0.0.4");
+    });
+
+    //  GET /network/<id>/memory
+    //       Return the bytes of memory of the network by category, and the total.
+    svr.Get("/network/.*/memory", [](const Request &req, Response &res) {
+      std::vector<std::string> flds = Path::split(req.path, '/');
+      std::string id = flds[2];
+
+      RESTapi *interface = RESTapi::getInstance();
+      std::string result = interface->memory_request(id);
+      res.set_content(result + "\n", "application/json");
+    });
+
+    //  GET /hibernation
+    //       Return the hibernated networks and the hit / miss latencies.
+    svr.Get("/hibernation", [](const Request & /*req*/, Response &res) {
+      RESTapi *interface = RESTapi::getInstance();
+      std::string result = interface->hibernation_request();
+      res.set_content(result + "\n", "application/json");
+    });
+
     //    Halt the server.
     svr.Get("/stop", [&](const Request & /*req*/, Response & /*res*/) { svr.stop(); });
 
@@ -336,6 +503,14 @@ public:
     return escaped.str();
   }
 
+  // Binary results are sent as is, errors as JSON.
+  static void set_binary_content(Response &res, const std::string &result) {
+    if (result.compare(0, 7, "{\"err\":") == 0)
+      res.set_content(result + "\n", "application/json");
+    else
+      res.set_content(result, RESTapi::BINARY_CONTENT_TYPE.c_str());
+  }
+
   inline bool is_running() { return svr.is_running(); }
   inline void stop() { svr.stop(); }
 
@@ -15,6 +15,8 @@
  * along with this program.  If not, see http://www.gnu.org/licenses.
  * --------------------------------------------------------------------- */
 
+#include <algorithm>
+
 #include "htm/algorithms/Anomaly.hpp"
 #include "htm/utils/Log.hpp"
 
@@ -23,23 +25,97 @@ using namespace htm;
 
 namespace htm {
 
+UInt sparseOverlap(const ElemSparse *a, size_t numA,
+                   const ElemSparse *b, size_t numB) {
+  if (numA > numB) {
+    std::swap(a, b);
+    std::swap(numA, numB);
+  }
+  const ElemSparse *aEnd = a + numA;
+  const ElemSparse *bEnd = b + numB;
+  UInt overlap = 0u;
+
+  // Few against many: numA * log(numB) comparisons instead of numA + numB.
+  if (numA * 16u < numB) {
+    for (; a != aEnd and b != bEnd; ++a) {
+      b = std::lower_bound(b, bEnd, *a);
+      if (b != bEnd and *b == *a) {
+        overlap++;
+        ++b;
+      }
+    }
+    return overlap;
+  }
+
+  while (a != aEnd and b != bEnd) {
+    if (*a < *b)      ++a;
+    else if (*b < *a) ++b;
+    else { overlap++; ++a; ++b; }
+  }
+  return overlap;
+}
+
+
+UInt packedOverlap(const UInt64 *a, const UInt64 *b, const size_t numWords) {
+  UInt overlap = 0u;
+  for (size_t w = 0u; w < numWords; w++) {
+    UInt64 word = a[w] & b[w];
+#if defined(__GNUC__)
+    overlap += static_cast<UInt>(__builtin_popcountll(word));
+#else
+    for (; word != 0u; word &= word - 1u) overlap++;
+#endif
+  }
+  return overlap;
+}
+
+
 Real computeRawAnomalyScore(const SDR& active,
                             const SDR& predicted) {
 
   NTA_ASSERT(active.dimensions == predicted.dimensions);
 
   // Return 0 if no active columns are present
-  if (active.getSum() == 0) {
+  const UInt numActive = active.getSum();
+  if (numActive == 0u) {
     return static_cast<Real>(0);
   }
 
   // Calculate and return percent of active columns that were not predicted.
-  SDR both(active.dimensions);
-  both.intersection(active, predicted);
-
-  const Real score = (active.getSum() - both.getSum()) / static_cast<Real>(active.getSum());
+  // getOverlap() counts without an intersection SDR: a merge of the sparse
+  // indices, or a popcount of the packed bits.
+  const Real score = rawAnomalyScore(numActive, active.getOverlap(predicted));
   NTA_ASSERT(score >= 0.0f and score <= 1.0f) << "Anomaly score out of bounds!";
   return score;
 }
 
+
+vector<Real> computeRawAnomalyScores(const vector<SDR>& active,
+                                     const vector<SDR>& predicted) {
+  NTA_CHECK(active.size() == predicted.size())
+    << "computeRawAnomalyScores: " << active.size() << " active and "
+    << predicted.size() << " predicted.";
+  vector<Real> scores(active.size());
+  for (size_t i = 0u; i < active.size(); i++) {
+    scores[i] = computeRawAnomalyScore(active[i], predicted[i]);
+  }
+  return scores;
+}
+
+
+void computeRawAnomalyScores(const ElemSparse *active, const size_t *activeEnds,
+                             const ElemSparse *predicted, const size_t *predictedEnds,
+                             const size_t n, Real *scores) {
+  size_t activeBegin = 0u, predictedBegin = 0u;
+  for (size_t i = 0u; i < n; i++) {
+    const size_t numActive    = activeEnds[i]    - activeBegin;
+    const size_t numPredicted = predictedEnds[i] - predictedBegin;
+    const UInt overlap = sparseOverlap(active + activeBegin, numActive,
+                                       predicted + predictedBegin, numPredicted);
+    scores[i] = rawAnomalyScore(static_cast<UInt>(numActive), overlap);
+    activeBegin    = activeEnds[i];
+    predictedBegin = predictedEnds[i];
+  }
+}
+
 } // End namespace
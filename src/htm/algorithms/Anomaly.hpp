@@ -18,11 +18,38 @@
 #ifndef HTM_ALGORITHMS_ANOMALY_HPP
 #define HTM_ALGORITHMS_ANOMALY_HPP
 
+#include <vector>
+
 #include <htm/types/Types.hpp>
 #include <htm/types/Sdr.hpp> // sdr::SDR
 
 namespace htm {
 
+/**
+ * The raw anomaly score from counts: the fraction of the numActive active
+ * columns which were not among the numPredictedActive predicted ones.
+ * Every score below is this of an overlap; TemporalMemory uses it with the
+ * counts of activateCells().
+ */
+inline Real32 rawAnomalyScore(const UInt numActive, const UInt numPredictedActive) {
+  if (numActive == 0u) return 0.0f;
+  return static_cast<Real32>(numActive - numPredictedActive) / static_cast<Real32>(numActive);
+}
+
+/**
+ * Number of indices in both of two sorted, unique sparse lists.  Merges the
+ * two, or when one is much longer than the other, binary searches it for
+ * each index of the shorter one.
+ */
+UInt sparseOverlap(const ElemSparse *a, size_t numA,
+                   const ElemSparse *b, size_t numB);
+
+/**
+ * Number of bits set in both of two bitmaps of numWords 64-bit words, as
+ * SDR::getPacked().
+ */
+UInt packedOverlap(const UInt64 *a, const UInt64 *b, size_t numWords);
+
 
 /**
  * Computes the raw anomaly score.
@@ -38,6 +65,24 @@ namespace htm {
 Real32 computeRawAnomalyScore(const SDR& active, 
                               const SDR& predicted);
 
+/**
+ * Raw anomaly scores of many (active, predicted) pairs, eg. of many streams
+ * at one step: scores[i] of active[i] and predicted[i].  Allocates nothing
+ * but the result.
+ */
+std::vector<Real32> computeRawAnomalyScores(const std::vector<SDR>& active,
+                                            const std::vector<SDR>& predicted);
+
+/**
+ * Raw anomaly scores of n pairs kept as sparse indices in flat buffers, eg.
+ * recorded for a replay: pair i is active[activeEnds[i - 1], activeEnds[i])
+ * and predicted[predictedEnds[i - 1], predictedEnds[i]) (from 0 for i = 0),
+ * each sorted.  Writes scores[0, n), allocates nothing.
+ */
+void computeRawAnomalyScores(const ElemSparse *active, const size_t *activeEnds,
+                             const ElemSparse *predicted, const size_t *predictedEnds,
+                             size_t n, Real32 *scores);
+
 } //end-ns
 
 #endif // HTM_ALGORITHMS_ANOMALY_HPP
@@ -1,5 +1,6 @@
 #include <htm/algorithms/AnomalyLikelihood.hpp>
 
+#include <algorithm> //minmax_element
 #include <iostream>
 #include <numeric> //accumulate, inner_product
 
@@ -15,10 +16,11 @@ static Real compute_var(const vector<Real>& v, Real mean);
 static UInt calcSkipRecords_(UInt numIngested, UInt windowSize, UInt learningPeriod);
 
 
-AnomalyLikelihood::AnomalyLikelihood(UInt learningPeriod, UInt estimationSamples, UInt historicWindowSize, UInt reestimationPeriod, UInt aggregationWindow) :
+AnomalyLikelihood::AnomalyLikelihood(UInt learningPeriod, UInt estimationSamples, UInt historicWindowSize, UInt reestimationPeriod, UInt aggregationWindow, bool streaming) :
     learningPeriod(learningPeriod),
     reestimationPeriod(reestimationPeriod),
     probationaryPeriod(learningPeriod+estimationSamples),
+    streaming(streaming),
     averagedAnomaly_(aggregationWindow),
     runningLikelihoods_(historicWindowSize),
     runningRawAnomalyScores_(historicWindowSize),
@@ -48,18 +50,30 @@ Real AnomalyLikelihood::anomalyProbability(Real anomalyScore, int timestamp) {
     const UInt timeElapsed = (UInt)(timestamp - initialTimestamp_);  //this will be used, relative time since first timestamp (the "first" can be reseted)
 
     // store into relevant variables
-    this->runningRawAnomalyScores_.append(anomalyScore);
+    if (not streaming) {
+      this->runningRawAnomalyScores_.append(anomalyScore);
+    }
     auto newAvg = this->averagedAnomaly_.compute(anomalyScore);
-    this->runningAverageAnomalies_.append(newAvg);
+    Real droppedAvg = 0.0f;
+    const bool dropped = this->runningAverageAnomalies_.append(newAvg, &droppedAvg);
+    if (streaming) {
+      likelihood = streamingLikelihood_(newAvg, dropped, droppedAvg); // also updates the statistics, so before the probation check
+    }
     this->iteration_++;
 
     // We ignore the first probationaryPeriod data points - as we cannot reliably compute distribution statistics for estimating likelihood
     if (timeElapsed < this->probationaryPeriod) {
-      this->runningLikelihoods_.append(likelihood); //after that, pushed below with real likelihood; here just 0.5
+      if (not streaming) {
+        this->runningLikelihoods_.append(DEFAULT_ANOMALY); //after that, pushed below with real likelihood; here just 0.5
+      }
       return DEFAULT_ANOMALY;
     } //else {
 
-    const auto anomalies = this->runningAverageAnomalies_.getData();
+    if (streaming) {
+      return likelihood;
+    }
+
+    const auto &anomalies = this->runningAverageAnomalies_.getData();
 
       // On a rolling basis we re-estimate the distribution
       if ((timeElapsed >= initialTimestamp_ + reestimationPeriod)   || distribution_.name == "unknown" ) {
@@ -133,9 +147,56 @@ Real AnomalyLikelihood::tailProbability_(Real x) const {
 }
 
 
+Real AnomalyLikelihood::streamingLikelihood_(const Real newAverage, const bool dropped, const Real droppedAverage) {
+  // Welford's update, and its inverse for the score leaving the window. Only
+  // the scores after the learningPeriod are in the statistics (iteration_ is
+  // the index of the new score).
+  if (dropped and iteration_ >= runningAverageAnomalies_.maxCapacity + learningPeriod) {
+    if (statsCount_ <= 1u) {
+      statsCount_ = 0u;
+      statsMean_  = 0.0;
+      statsM2_    = 0.0;
+    } else {
+      const Real64 delta = droppedAverage - statsMean_;
+      statsCount_--;
+      statsMean_ -= delta / statsCount_;
+      statsM2_   -= delta * (droppedAverage - statsMean_);
+      statsM2_    = std::max(statsM2_, 0.0); // rounding
+    }
+  }
+  if (iteration_ >= learningPeriod) {
+    statsCount_++;
+    const Real64 delta = newAverage - statsMean_;
+    statsMean_ += delta / statsCount_;
+    statsM2_   += delta * (newAverage - statsMean_);
+  }
+
+  if (statsCount_ == 0u) {
+    distribution_ = DistributionParams("normal", 0.5, 1e6, 1e3); //null distribution
+  } else {
+    distribution_ = normal_((Real)statsMean_, (Real)(statsM2_ / statsCount_), true);
+  }
+
+  // same filter as filterLikelihoods_(), on the previous filtered value
+  const Real redThreshold    = 1.0f - 0.99999f;
+  const Real yellowThreshold = 1.0f - 0.999f;
+  Real tail = tailProbability_(newAverage);
+  if (tail <= redThreshold and lastTail_ <= redThreshold) {
+    tail = yellowThreshold;
+  }
+  lastTail_ = tail;
+  return 1.0f - tail;
+}
+
+
 DistributionParams AnomalyLikelihood::estimateNormal_(const vector<Real>& anomalyScores, bool performLowerBoundCheck) {
     auto mean = compute_mean(anomalyScores);
     auto var = compute_var(anomalyScores, mean);
+    return normal_(mean, var, performLowerBoundCheck);
+}
+
+
+DistributionParams AnomalyLikelihood::normal_(Real mean, Real var, bool performLowerBoundCheck) const {
   DistributionParams params = DistributionParams("normal", mean, var, 0.0);
 
   if (performLowerBoundCheck) {
@@ -313,6 +374,31 @@ static UInt calcSkipRecords_(UInt numIngested, UInt windowSize, UInt learningPer
 
 
 
+void AnomalyLikelihood::quantize_(const SlidingWindow<Real> &window, Real &low, Real &high, vector<UInt16> &codes) {
+  codes.resize(window.size());
+  low  = 0.0f;
+  high = 0.0f;
+  if (window.size() == 0u) return;
+  const auto &data = window.getData();
+  const auto minMax = std::minmax_element(data.cbegin(), data.cend());
+  low  = *minMax.first;
+  high = *minMax.second;
+  const Real scale = high > low ? 65535.0f / (high - low) : 0.0f;
+  for (UInt i = 0u; i < codes.size(); i++) {
+    codes[i] = static_cast<UInt16>(std::lround((window[i] - low) * scale));
+  }
+}
+
+
+void AnomalyLikelihood::dequantize_(const Real low, const Real high, const vector<UInt16> &codes, SlidingWindow<Real> &window) {
+  window.clear();
+  const Real step = (high - low) / 65535.0f;
+  for (const auto code : codes) {
+    window.append(code == 65535u ? high : low + code * step);
+  }
+}
+
+
 bool AnomalyLikelihood::operator==(const AnomalyLikelihood &a) const {
   if (learningPeriod != a.learningPeriod) return false;
   if (reestimationPeriod != a.reestimationPeriod) return false;
@@ -327,6 +413,11 @@ bool AnomalyLikelihood::operator==(const AnomalyLikelihood &a) const {
   if (averagedAnomaly_ != a.averagedAnomaly_) return false;
   if (runningLikelihoods_ != a.runningLikelihoods_) return false;
   if (runningRawAnomalyScores_ != a.runningRawAnomalyScores_) return false;
+  if (streaming != a.streaming) return false;
+  if (statsCount_ != a.statsCount_) return false;
+  if (statsMean_ != a.statsMean_) return false;
+  if (statsM2_ != a.statsM2_) return false;
+  if (lastTail_ != a.lastTail_) return false;
   return true;
 }
 
@@ -6,6 +6,7 @@
 #include <htm/utils/MovingAverage.hpp>
 #include <htm/utils/SlidingWindow.hpp>
 #include <htm/utils/Log.hpp>
+#include <htm/utils/MemoryUsage.hpp>
 
 #include <string>
 #include <vector>
@@ -89,8 +90,19 @@ class AnomalyLikelihood : public Serializable {
       number as long as it is small relative to the total number of records
       processed.
 
+    @param streaming - (bool) if true, the Gaussian is kept up to date with
+      running (Welford) mean & variance of the averaged anomaly scores in the
+      historic window, adding the new and evicting the dropped score on each
+      call. Every call is then O(1) and the distribution is re-estimated each
+      iteration (reestimationPeriod is not used). The scores of the first
+      learningPeriod iterations are left out of the estimate.
+      If false (default), the exact batch estimation over the whole window is
+      re-run every reestimationPeriod iterations.
+      The streaming mode keeps only the window of averaged scores (the raw
+      scores and likelihoods are not needed for the estimate).
+
   **/
-    AnomalyLikelihood(UInt learningPeriod=288, UInt estimationSamples=100, UInt historicWindowSize=8640, UInt reestimationPeriod=100, UInt aggregationWindow=10);
+    AnomalyLikelihood(UInt learningPeriod=288, UInt estimationSamples=100, UInt historicWindowSize=8640, UInt reestimationPeriod=100, UInt aggregationWindow=10, bool streaming=false);
 
 
     /**
@@ -121,9 +133,32 @@ class AnomalyLikelihood : public Serializable {
   }
 
 
+  /**
+    Compact checkpoints: if enabled, save() stores the sliding windows
+    quantized to 16 bits per value (linear between the window's min & max,
+    so about 1.5e-5 relative error), a quarter of the size of the default
+    format. This is lossy, a loaded model gives slightly different
+    likelihoods. load() accepts both formats.
+   **/
+  void setCompactSerialization(bool compact) { compactSerialization_ = compact; }
+  bool getCompactSerialization() const { return compactSerialization_; }
+
+  /**
+    Bytes of memory by category: history (the sliding windows of the scores
+    and likelihoods).
+   **/
+  MemoryUsage memoryUsage() const {
+    return {{"history", averagedAnomaly_.memoryUsage() + runningLikelihoods_.memoryUsage() +
+                        runningRawAnomalyScores_.memoryUsage() + runningAverageAnomalies_.memoryUsage()}};
+  }
+
   CerealAdapter;
   template<class Archive>
   void save_ar(Archive & ar) const {
+    if(compactSerialization_) {
+      saveCompact_(ar);
+      return;
+    }
     std::string name("AnomalyLikelhood");
     ar(CEREAL_NVP(name),
        CEREAL_NVP(distribution_.name),
@@ -138,12 +173,22 @@ class AnomalyLikelihood : public Serializable {
        CEREAL_NVP(runningRawAnomalyScores_),
        CEREAL_NVP(runningAverageAnomalies_)
     );
+    if(streaming) {
+      ar(CEREAL_NVP(statsCount_),
+         CEREAL_NVP(statsMean_),
+         CEREAL_NVP(statsM2_),
+         CEREAL_NVP(lastTail_));
+    }
   }
   template<class Archive>
   void load_ar(Archive & ar) {
-    std::string name; // for debugging
-    ar(CEREAL_NVP(name),
-       CEREAL_NVP(distribution_.name),
+    std::string name; // for debugging, and tells the compact format
+    ar(CEREAL_NVP(name));
+    if(name == COMPACT_NAME_) {
+      loadCompact_(ar);
+      return;
+    }
+    ar(CEREAL_NVP(distribution_.name),
        CEREAL_NVP(distribution_.mean),
        CEREAL_NVP(distribution_.variance),
        CEREAL_NVP(distribution_.stdev),
@@ -154,7 +199,13 @@ class AnomalyLikelihood : public Serializable {
     ar(CEREAL_NVP(runningLikelihoods_));
     ar(CEREAL_NVP(runningRawAnomalyScores_));
     ar(CEREAL_NVP(runningAverageAnomalies_));
-    // Note: learningPeriod, reestimationPeriod, probationaryPeriod already set by constructor.
+    if(streaming) {
+      ar(CEREAL_NVP(statsCount_),
+         CEREAL_NVP(statsMean_),
+         CEREAL_NVP(statsM2_),
+         CEREAL_NVP(lastTail_));
+    }
+    // Note: learningPeriod, reestimationPeriod, probationaryPeriod, streaming already set by constructor.
   }
 
 
@@ -177,13 +228,85 @@ class AnomalyLikelihood : public Serializable {
     const Real THRESHOLD_MEAN = 0.03f;
     const Real THRESHOLD_VARIANCE = 0.0003f;
 
-    const UInt learningPeriod; //these 3 are from constructor
+    const UInt learningPeriod; //these 4 are from constructor
     const UInt reestimationPeriod;
     const UInt probationaryPeriod;
+    const bool streaming;
 
   private:
     //methods:
 
+    static constexpr const char *COMPACT_NAME_ = "AnomalyLikelihoodCompact";
+
+    // window <-> (min, max, 16 bit codes), oldest value first
+    static void quantize_(const SlidingWindow<Real> &window, Real &low, Real &high, vector<UInt16> &codes);
+    static void dequantize_(Real low, Real high, const vector<UInt16> &codes, SlidingWindow<Real> &window);
+
+    template<class Archive>
+    void saveCompactWindow_(Archive & ar, const SlidingWindow<Real> &window) const {
+      Real low, high;
+      vector<UInt16> codes;
+      quantize_(window, low, high, codes);
+      ar(CEREAL_NVP(low), CEREAL_NVP(high), CEREAL_NVP(codes));
+    }
+    template<class Archive>
+    void loadCompactWindow_(Archive & ar, SlidingWindow<Real> &window) {
+      Real low, high;
+      vector<UInt16> codes;
+      ar(CEREAL_NVP(low), CEREAL_NVP(high), CEREAL_NVP(codes));
+      NTA_CHECK(codes.size() <= window.maxCapacity) << "AnomalyLikelihood: window in archive is too large.";
+      dequantize_(low, high, codes, window);
+    }
+
+    template<class Archive>
+    void saveCompact_(Archive & ar) const {
+      std::string name(COMPACT_NAME_);
+      ar(CEREAL_NVP(name),
+         CEREAL_NVP(streaming),
+         CEREAL_NVP(distribution_.name),
+         CEREAL_NVP(distribution_.mean),
+         CEREAL_NVP(distribution_.variance),
+         CEREAL_NVP(distribution_.stdev),
+         CEREAL_NVP(iteration_),
+         CEREAL_NVP(lastTimestamp_),
+         CEREAL_NVP(initialTimestamp_),
+         CEREAL_NVP(averagedAnomaly_));
+      saveCompactWindow_(ar, runningAverageAnomalies_);
+      if(streaming) {
+        ar(CEREAL_NVP(statsCount_),
+           CEREAL_NVP(statsMean_),
+           CEREAL_NVP(statsM2_),
+           CEREAL_NVP(lastTail_));
+      } else {
+        saveCompactWindow_(ar, runningLikelihoods_);
+        saveCompactWindow_(ar, runningRawAnomalyScores_);
+      }
+    }
+    template<class Archive>
+    void loadCompact_(Archive & ar) {
+      bool wasStreaming;
+      ar(CEREAL_NVP(wasStreaming));
+      NTA_CHECK(wasStreaming == streaming) << "AnomalyLikelihood: archive has a different streaming mode.";
+      ar(CEREAL_NVP(distribution_.name),
+         CEREAL_NVP(distribution_.mean),
+         CEREAL_NVP(distribution_.variance),
+         CEREAL_NVP(distribution_.stdev),
+         CEREAL_NVP(iteration_),
+         CEREAL_NVP(lastTimestamp_),
+         CEREAL_NVP(initialTimestamp_),
+         CEREAL_NVP(averagedAnomaly_));
+      loadCompactWindow_(ar, runningAverageAnomalies_);
+      if(streaming) {
+        ar(CEREAL_NVP(statsCount_),
+           CEREAL_NVP(statsMean_),
+           CEREAL_NVP(statsM2_),
+           CEREAL_NVP(lastTail_));
+      } else {
+        loadCompactWindow_(ar, runningLikelihoods_);
+        loadCompactWindow_(ar, runningRawAnomalyScores_);
+      }
+    }
+
   /**
   Given a series of anomaly scores, compute the likelihood for each score. This
   function should be called once on a bunch of historical anomaly scores for an
@@ -238,6 +361,14 @@ class AnomalyLikelihood : public Serializable {
       the ``anomalyScores``.
   **/
     DistributionParams estimateNormal_(const vector<Real>& anomalyScores, bool performLowerBoundCheck=true);
+    DistributionParams normal_(Real mean, Real variance, bool performLowerBoundCheck) const;
+
+  /**
+  Streaming mode: update the running statistics with the newest averaged score
+  and the one dropped out of the window, then return the filtered likelihood
+  of the newest score.
+  **/
+    Real streamingLikelihood_(Real newAverage, bool dropped, Real droppedAverage);
 
 
     //private variables
@@ -252,6 +383,14 @@ class AnomalyLikelihood : public Serializable {
     htm::SlidingWindow<Real> runningRawAnomalyScores_;
     htm::SlidingWindow<Real> runningAverageAnomalies_; //sliding window of running averages of anomaly scores
 
+    // streaming mode: Welford statistics of the averaged scores in the window
+    UInt   statsCount_ = 0u;
+    Real64 statsMean_  = 0.0;
+    Real64 statsM2_    = 0.0; // sum of squared differences from the mean
+    Real   lastTail_   = 1.0f; // previous filtered tail probability
+
+    bool compactSerialization_ = false;
+
 };
 
 } //end-ns
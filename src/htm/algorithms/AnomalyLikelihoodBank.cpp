@@ -0,0 +1,166 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the AnomalyLikelihoodBank
+ */
+
+#include <algorithm> // max
+#include <cmath> // erfc, sqrt
+
+#include <htm/algorithms/AnomalyLikelihoodBank.hpp>
+#include <htm/utils/Log.hpp>
+
+using namespace std;
+
+namespace htm {
+
+// Same constants as AnomalyLikelihood.
+static const Real DEFAULT_ANOMALY    = 0.5f;
+static const Real THRESHOLD_MEAN     = 0.03f;
+static const Real THRESHOLD_VARIANCE = 0.0003f;
+static const Real RED_THRESHOLD      = 1.0f - 0.99999f;
+static const Real YELLOW_THRESHOLD   = 1.0f - 0.999f;
+
+
+AnomalyLikelihoodBank::AnomalyLikelihoodBank(UInt numStreams, UInt learningPeriod, UInt estimationSamples,
+                                             UInt historicWindowSize, UInt aggregationWindow)
+  { initialize(numStreams, learningPeriod, estimationSamples, historicWindowSize, aggregationWindow); }
+
+
+void AnomalyLikelihoodBank::initialize(UInt numStreams, UInt learningPeriod, UInt estimationSamples,
+                                       UInt historicWindowSize, UInt aggregationWindow) {
+  NTA_CHECK(numStreams > 0u);
+  NTA_CHECK(historicWindowSize >= estimationSamples);
+  NTA_CHECK(aggregationWindow > 0u && aggregationWindow < historicWindowSize);
+  numStreams_         = numStreams;
+  learningPeriod_     = learningPeriod;
+  probationaryPeriod_ = learningPeriod + estimationSamples;
+  windowSize_         = historicWindowSize;
+  aggregationWindow_  = aggregationWindow;
+
+  iteration_  = 0u;
+  statsCount_ = 0u;
+  aggregated_.assign(static_cast<size_t>(aggregationWindow_) * numStreams_, 0.0f);
+  history_.assign(static_cast<size_t>(windowSize_) * numStreams_, 0.0f);
+  aggregatedTotal_.assign(numStreams_, 0.0f);
+  mean_.assign(numStreams_, 0.0);
+  m2_.assign(numStreams_, 0.0);
+  lastTail_.assign(numStreams_, 1.0f);
+}
+
+
+void AnomalyLikelihoodBank::anomalyProbability(const vector<Real> &anomalyScores, vector<Real> &likelihoods) {
+  NTA_CHECK(anomalyScores.size() == numStreams_)
+    << "AnomalyLikelihoodBank: expected " << numStreams_ << " scores, got " << anomalyScores.size();
+  likelihoods.resize(numStreams_);
+  const size_t n = numStreams_;
+
+  // Window positions and the number of scores in the statistics are the
+  // same for every stream.
+  const bool aggDropped  = iteration_ >= aggregationWindow_;
+  const Real aggSize     = static_cast<Real>(aggDropped ? aggregationWindow_ : iteration_ + 1u);
+  Real *aggregated       = aggregated_.data() + static_cast<size_t>(iteration_ % aggregationWindow_) * n;
+  Real *history          = history_.data()    + static_cast<size_t>(iteration_ % windowSize_) * n;
+  const bool evict       = iteration_ >= windowSize_ + learningPeriod_;
+  const bool add         = iteration_ >= learningPeriod_;
+  const UInt countBefore = statsCount_;
+  UInt count = countBefore;
+  if (evict) count = count <= 1u ? 0u : count - 1u;
+  if (add)   count++;
+  const bool clear = evict and countBefore <= 1u;
+
+  // Pass 1: moving average, sliding windows and Welford statistics.
+  const Real *scores = anomalyScores.data();
+  Real *totals = aggregatedTotal_.data();
+  Real64 *means = mean_.data();
+  Real64 *m2s   = m2_.data();
+  for (size_t i = 0u; i < n; i++) {
+    NTA_ASSERT(not std::isnan(scores[i]));
+    Real total = totals[i];
+    if (aggDropped) total -= aggregated[i];
+    total += scores[i];
+    aggregated[i] = scores[i];
+    totals[i] = total;
+    const Real average = total / aggSize;
+
+    const Real dropped = history[i];
+    history[i] = average;
+
+    Real64 mean = means[i];
+    Real64 m2   = m2s[i];
+    if (clear) {
+      mean = 0.0;
+      m2   = 0.0;
+    } else if (evict) {
+      const Real64 delta = dropped - mean;
+      mean -= delta / (countBefore - 1u);
+      m2   -= delta * (dropped - mean);
+      m2    = std::max(m2, 0.0);
+    }
+    if (add) {
+      const Real64 delta = average - mean;
+      mean += delta / count;
+      m2   += delta * (average - mean);
+    }
+    means[i] = mean;
+    m2s[i]   = m2;
+  }
+
+  // Pass 2: Gaussian tail probability of the new averages, and the red-zone filter.
+  const bool probation = iteration_ < probationaryPeriod_;
+  for (size_t i = 0u; i < n; i++) {
+    Real mean  = 0.5f; // null distribution
+    Real stdev = 1e3f;
+    if (count > 0u) {
+      mean = std::max(static_cast<Real>(means[i]), THRESHOLD_MEAN);
+      const Real variance = std::max(static_cast<Real>(m2s[i] / count), THRESHOLD_VARIANCE);
+      stdev = std::sqrt(variance);
+    }
+    Real x = history[i];
+    if (x < mean) x = 2 * mean - x; // symmetric around the mean
+    const Real z = (x - mean) / stdev;
+    Real tail = static_cast<Real>(0.5 * erfc(z / 1.4142));
+    if (tail <= RED_THRESHOLD and lastTail_[i] <= RED_THRESHOLD) {
+      tail = YELLOW_THRESHOLD;
+    }
+    lastTail_[i] = tail;
+    likelihoods[i] = probation ? DEFAULT_ANOMALY : 1.0f - tail;
+  }
+
+  statsCount_ = count;
+  iteration_++;
+}
+
+
+bool AnomalyLikelihoodBank::operator==(const AnomalyLikelihoodBank &o) const {
+  return numStreams_ == o.numStreams_ and
+         learningPeriod_ == o.learningPeriod_ and
+         probationaryPeriod_ == o.probationaryPeriod_ and
+         windowSize_ == o.windowSize_ and
+         aggregationWindow_ == o.aggregationWindow_ and
+         iteration_ == o.iteration_ and
+         statsCount_ == o.statsCount_ and
+         aggregated_ == o.aggregated_ and
+         aggregatedTotal_ == o.aggregatedTotal_ and
+         history_ == o.history_ and
+         mean_ == o.mean_ and
+         m2_ == o.m2_ and
+         lastTail_ == o.lastTail_;
+}
+
+} // namespace htm
@@ -0,0 +1,136 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the AnomalyLikelihoodBank
+ */
+
+#ifndef HTM_ALGORITHMS_ANOMALY_LIKELIHOOD_BANK_HPP_
+#define HTM_ALGORITHMS_ANOMALY_LIKELIHOOD_BANK_HPP_
+
+#include <vector>
+#include <htm/types/Types.hpp>
+#include <htm/types/Serializable.hpp>
+
+namespace htm {
+
+/**
+ * Anomaly likelihood of many metrics at once.
+ *
+ * Equivalent to one AnomalyLikelihood per stream, constructed with
+ * streaming=true and used without timestamps, all of them updated in the
+ * same iteration. Because the streams advance in lockstep, the window
+ * positions are shared and each stream's state is stored in a structure of
+ * arrays: window slot s of all streams is one contiguous row. One call of
+ * anomalyProbability() runs a single pass over these rows instead of a
+ * loop over separate objects and their sliding windows.
+ *
+ * Example usage:
+ *
+ *     AnomalyLikelihoodBank bank(numMetrics);
+ *     vector<Real> likelihoods;
+ *     while(true) {
+ *       <compute the raw anomaly score of each metric into scores>
+ *       bank.anomalyProbability(scores, likelihoods);
+ *     }
+ */
+class AnomalyLikelihoodBank : public Serializable
+{
+public:
+  AnomalyLikelihoodBank() {}
+
+  /**
+   * @param numStreams - number of independent metrics.
+   * Other parameters are the same as for AnomalyLikelihood.
+   */
+  AnomalyLikelihoodBank(UInt numStreams, UInt learningPeriod=288, UInt estimationSamples=100,
+                        UInt historicWindowSize=8640, UInt aggregationWindow=10);
+
+  void initialize(UInt numStreams, UInt learningPeriod=288, UInt estimationSamples=100,
+                  UInt historicWindowSize=8640, UInt aggregationWindow=10);
+
+  /**
+   * Same as AnomalyLikelihood::anomalyProbability(), for each stream.
+   *
+   * @param anomalyScores - the current anomaly score of each stream,
+   *   numStreams long.
+   * @param likelihoods - output, the anomaly likelihood of each stream.
+   */
+  void anomalyProbability(const std::vector<Real> &anomalyScores, std::vector<Real> &likelihoods);
+
+  UInt getNumStreams() const { return numStreams_; }
+  UInt getIteration() const { return iteration_; }
+
+  CerealAdapter;
+  template<class Archive>
+  void save_ar(Archive & ar) const {
+    ar(CEREAL_NVP(numStreams_),
+       CEREAL_NVP(learningPeriod_),
+       CEREAL_NVP(probationaryPeriod_),
+       CEREAL_NVP(windowSize_),
+       CEREAL_NVP(aggregationWindow_),
+       CEREAL_NVP(iteration_),
+       CEREAL_NVP(statsCount_),
+       CEREAL_NVP(aggregated_),
+       CEREAL_NVP(aggregatedTotal_),
+       CEREAL_NVP(history_),
+       CEREAL_NVP(mean_),
+       CEREAL_NVP(m2_),
+       CEREAL_NVP(lastTail_));
+  }
+  template<class Archive>
+  void load_ar(Archive & ar) {
+    ar(CEREAL_NVP(numStreams_),
+       CEREAL_NVP(learningPeriod_),
+       CEREAL_NVP(probationaryPeriod_),
+       CEREAL_NVP(windowSize_),
+       CEREAL_NVP(aggregationWindow_),
+       CEREAL_NVP(iteration_),
+       CEREAL_NVP(statsCount_),
+       CEREAL_NVP(aggregated_),
+       CEREAL_NVP(aggregatedTotal_),
+       CEREAL_NVP(history_),
+       CEREAL_NVP(mean_),
+       CEREAL_NVP(m2_),
+       CEREAL_NVP(lastTail_));
+  }
+
+  bool operator==(const AnomalyLikelihoodBank &o) const;
+  inline bool operator!=(const AnomalyLikelihoodBank &o) const { return not (*this == o); }
+
+private:
+  UInt numStreams_ = 0u;
+  UInt learningPeriod_ = 0u;
+  UInt probationaryPeriod_ = 0u;
+  UInt windowSize_ = 0u;
+  UInt aggregationWindow_ = 0u;
+
+  UInt iteration_ = 0u;
+  UInt statsCount_ = 0u; // the same for all streams
+
+  // [slot * numStreams_ + stream]
+  std::vector<Real> aggregated_;      // window of the raw scores, for the moving average
+  std::vector<Real> history_;         // window of the averaged scores
+  // [stream]
+  std::vector<Real> aggregatedTotal_;
+  std::vector<Real64> mean_;
+  std::vector<Real64> m2_;
+  std::vector<Real> lastTail_;
+};
+
+} // namespace htm
+#endif // HTM_ALGORITHMS_ANOMALY_LIKELIHOOD_BANK_HPP_
@@ -0,0 +1,148 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the BackgroundLearningTM class
+ */
+
+#include <chrono>
+
+#include <htm/algorithms/BackgroundLearningTM.hpp>
+
+using namespace htm;
+
+namespace {
+  const auto IDLE = std::chrono::microseconds(100);
+}
+
+
+BackgroundLearningTM::~BackgroundLearningTM() {
+  stop_ = true;
+  if(thread_.joinable()) thread_.join();
+}
+
+
+void BackgroundLearningTM::setPublishInterval(const UInt steps) {
+  NTA_CHECK(steps > 0u) << "BackgroundLearningTM: publishInterval must be at least 1.";
+  NTA_CHECK(not thread_.joinable()) << "BackgroundLearningTM: set publishInterval before the first compute().";
+  publishInterval_ = steps;
+}
+
+
+void BackgroundLearningTM::setQueueCapacity(const UInt steps) {
+  NTA_CHECK(steps > 0u) << "BackgroundLearningTM: queueCapacity must be at least 1.";
+  NTA_CHECK(not thread_.joinable()) << "BackgroundLearningTM: set queueCapacity before the first compute().";
+  queueCapacity_ = steps;
+}
+
+
+void BackgroundLearningTM::start_() {
+  Step prototype;
+  prototype.columns.reserve(inference_.numberOfColumns());
+  queue_.reset(new SpscQueue<Step>(queueCapacity_, prototype));
+  thread_ = std::thread(&BackgroundLearningTM::run_, this);
+}
+
+
+void BackgroundLearningTM::run_() {
+  try {
+    SDR columns(learner_.getColumnDimensions());
+    UInt sincePublish = 0u;
+    while(not stop_) {
+      Step *step = queue_->front();
+      if(step == nullptr) {
+        std::this_thread::sleep_for(IDLE);
+        continue;
+      }
+      if(step->reset) learner_.reset();
+      columns.setSparse(step->columns);
+      learner_.compute(columns, step->learn);
+      queue_->pop();
+      if(++sincePublish >= publishInterval_) {
+        publish_();
+        sincePublish = 0u;
+      }
+      learned_.fetch_add(1u, std::memory_order_release);
+    }
+  }
+  catch(const std::exception &e) {
+    error_ = e.what();
+    failed_ = true;
+  }
+}
+
+
+void BackgroundLearningTM::publish_() {
+  auto snapshot = std::make_shared<Connections>();
+  snapshot->shareFrom(learner_.connections_);
+  std::atomic_store(&published_, snapshot);
+}
+
+
+void BackgroundLearningTM::adopt_(Connections &snapshot) {
+  // The segments of the inference state belong to the old Connections, so
+  // they are recomputed by the next activateDendrites().
+  NTA_ASSERT(not inference_.segmentsValid_);
+  inference_.connections_.shareFrom(snapshot);
+  epoch_++;
+}
+
+
+void BackgroundLearningTM::checkFailed_() const {
+  NTA_CHECK(not failed_) << "BackgroundLearningTM: learning failed: " << error_;
+}
+
+
+void BackgroundLearningTM::compute(const SDR &activeColumns, const bool learn) {
+  checkFailed_();
+  if(not thread_.joinable()) start_();
+
+  const auto snapshot = std::atomic_exchange(&published_, std::shared_ptr<Connections>());
+  if(snapshot) adopt_(*snapshot);
+  inference_.compute(activeColumns, false);
+
+  Step *step = queue_->back();
+  if(step == nullptr) {
+    dropped_++;
+    resetPending_ = true;
+    return;
+  }
+  step->columns.assign(activeColumns.getSparse().begin(), activeColumns.getSparse().end());
+  step->learn = learn;
+  step->reset = resetPending_;
+  resetPending_ = false;
+  queue_->push();
+  queued_++;
+}
+
+
+void BackgroundLearningTM::reset() {
+  inference_.reset();
+  resetPending_ = true;
+}
+
+
+void BackgroundLearningTM::sync() {
+  while(learned_.load(std::memory_order_acquire) < queued_) {
+    checkFailed_();
+    std::this_thread::sleep_for(IDLE);
+  }
+  checkFailed_();
+  // The thread is idle until the next compute(), so the learner is read here.
+  std::atomic_store(&published_, std::shared_ptr<Connections>());
+  adopt_(learner_.connections_);
+}
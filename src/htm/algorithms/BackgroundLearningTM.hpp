@@ -0,0 +1,163 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the BackgroundLearningTM class
+ */
+
+#ifndef NTA_BACKGROUND_LEARNING_TM_HPP
+#define NTA_BACKGROUND_LEARNING_TM_HPP
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <htm/algorithms/Connections.hpp>
+#include <htm/algorithms/TemporalMemory.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/utils/SpscQueue.hpp>
+
+namespace htm {
+
+/**
+ * A TemporalMemory which learns on a background thread, so that compute()
+ * costs only inference.
+ *
+ * It holds two TemporalMemory with the same parameters. compute() runs the
+ * inference one with learn=false, and queues the input for the learning one,
+ * which a background thread computes with learn=true. Every
+ * "publishInterval" steps the thread publishes a snapshot of the learned
+ * Connections (an epoch), and the next compute() swaps it in. The snapshot
+ * shares the synapses with the learner until the learner changes them (see
+ * Connections::shareFrom()), so publishing costs about one copy of the
+ * Connections, on the learning thread.
+ *
+ * The predictions therefore use Connections which lag the inputs by
+ * getLag() steps plus up to publishInterval. When the learner falls
+ * "queueCapacity" steps behind, compute() does not wait: the step is not
+ * learned (see getDropped()) and the learner starts a new sequence at the
+ * next one.
+ *
+ * Only for TemporalMemory without external predictive inputs. Not
+ * serialized: call sync() and save getLearner().
+ *
+ * Example usage:
+ *
+ *     BackgroundLearningTM tm(vector<CellIdx>{2048}, 32);
+ *     while (true) {
+ *        sp.compute(input, true, activeColumns);
+ *        tm.compute(activeColumns);
+ *        alert(tm.getInference().anomaly);
+ *     }
+ */
+class BackgroundLearningTM
+{
+public:
+  /** The same arguments as the TemporalMemory constructor. */
+  template<typename... Args>
+  explicit BackgroundLearningTM(const Args &... args)
+    : learner_(args...), inference_(args...) {
+    NTA_CHECK(learner_.externalPredictiveInputs_ == 0u)
+      << "BackgroundLearningTM: external predictive inputs are not supported.";
+  }
+
+  BackgroundLearningTM(const BackgroundLearningTM &) = delete;
+  BackgroundLearningTM &operator=(const BackgroundLearningTM &) = delete;
+
+  /** Waits for the step being learned, drops the rest of the queue. */
+  ~BackgroundLearningTM();
+
+  /**
+   * Steps learned between two snapshots, default 1. Larger values copy the
+   * Connections less often, and predict with older ones.
+   */
+  void setPublishInterval(UInt steps);
+  UInt getPublishInterval() const { return publishInterval_; }
+
+  /** Steps the learner may fall behind, default 64. Before the first compute(). */
+  void setQueueCapacity(UInt steps);
+  UInt getQueueCapacity() const { return queueCapacity_; }
+
+  /**
+   * Infer on the latest snapshot, and queue the step for learning.
+   * With learn=false the learner follows the sequence but does not learn.
+   * Throws if the learning thread failed.
+   */
+  void compute(const SDR &activeColumns, bool learn = true);
+
+  /** Start a new sequence, on both TemporalMemory. */
+  void reset();
+
+  /**
+   * Wait until all queued steps are learned, then infer with all of it.
+   * Afterwards, and until the next compute(), getLearner() may be read.
+   */
+  void sync();
+
+  /** Active and predictive cells, anomaly. */
+  const TemporalMemory &getInference() const { return inference_; }
+
+  /**
+   * The learning TemporalMemory. Configure it (ie. setFlatIndex()) before
+   * the first compute(); afterwards read it only after sync().
+   */
+  TemporalMemory &getLearner() { return learner_; }
+  const TemporalMemory &getLearner() const { return learner_; }
+
+  /** Snapshots swapped in by compute() and sync(). */
+  UInt64 getEpoch() const { return epoch_; }
+  /** Steps queued and not learned yet. */
+  UInt64 getLag() const { return queued_ - learned_.load(std::memory_order_acquire); }
+  /** Steps not learned because the queue was full. */
+  UInt64 getDropped() const { return dropped_; }
+
+private:
+  struct Step {
+    SDR_sparse_t columns;
+    bool learn = true;
+    bool reset = false;
+  };
+
+  void start_();
+  void run_();          // the thread
+  void publish_();      // on the thread
+  void adopt_(Connections &snapshot);
+  void checkFailed_() const;
+
+  TemporalMemory learner_;    // owned by the thread once started
+  TemporalMemory inference_;
+  UInt publishInterval_ = 1u;
+  UInt queueCapacity_   = 64u;
+
+  std::unique_ptr<SpscQueue<Step>> queue_;
+  std::shared_ptr<Connections> published_;  // the latest snapshot, atomic_load/store only
+  bool resetPending_ = false; // the next queued step starts a sequence
+  UInt64 queued_  = 0u;
+  UInt64 dropped_ = 0u;
+  UInt64 epoch_   = 0u;
+  std::atomic<UInt64> learned_{0u};
+  std::atomic<bool>   stop_{false};
+  std::atomic<bool>   failed_{false};
+  std::string error_;         // of the thread, once failed_
+  std::thread thread_;
+};
+
+} // namespace htm
+
+#endif // NTA_BACKGROUND_LEARNING_TM_HPP
@@ -19,13 +19,27 @@
  * Implementation of Connections
  */
 
+#include <atomic> // atomic_thread_fence
 #include <algorithm> // nth_element
 #include <climits>
+#include <cmath> // lround
+#include <functional> // greater_equal
 #include <iomanip>
 #include <iostream>
+#include <numeric> // iota
 #include <set>
 
 #include <htm/algorithms/Connections.hpp>
+#include <htm/os/Probe.hpp>
+#include <htm/utils/CpuDispatch.hpp>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #define HTM_CONNECTIONS_X86_SIMD
+  #include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  #define HTM_CONNECTIONS_NEON
+  #include <arm_neon.h>
+#endif
 
 using std::endl;
 using std::string;
@@ -35,22 +49,25 @@ using namespace htm;
 
 Connections::Connections(const CellIdx numCells, 
 		         const Permanence connectedThreshold, 
-			 const bool timeseries) {
-  initialize(numCells, connectedThreshold, timeseries);
-}
-
-void Connections::initialize(CellIdx numCells, Permanence connectedThreshold, bool timeseries) {
-  cells_ = vector<CellData>(numCells);
-  segments_.clear();
-  synapses_.clear();
-  potentialSynapsesForPresynapticCell_.clear();
-  connectedSynapsesForPresynapticCell_.clear();
-  potentialSegmentsForPresynapticCell_.clear();
-  connectedSegmentsForPresynapticCell_.clear();
+			 const bool timeseries,
+			 const PermanencePrecision precision) {
+  initialize(numCells, connectedThreshold, timeseries, precision);
+}
+
+void Connections::initialize(CellIdx numCells, Permanence connectedThreshold, bool timeseries,
+                             PermanencePrecision precision) {
   eventHandlers_.clear();
+  changeLog_.clear();
+  setTrackChangedSegments(false);
   NTA_CHECK(connectedThreshold >= minPermanence);
   NTA_CHECK(connectedThreshold <= maxPermanence);
   connectedThreshold_ = connectedThreshold - htm::Epsilon;
+  // A new topology, copies of this Connections keep the old one.
+  auto topology = std::make_shared<Topology>(topology_->resource);
+  topology->cells.resize(numCells);
+  topology->synapses.permanence.setPrecision(precision);
+  topology->synapses.permanence.setConnectedThreshold(connectedThreshold_);
+  topology_ = std::move(topology);
   iteration_ = 0;
 
   nextEventToken_ = 0;
@@ -59,20 +76,105 @@ void Connections::initialize(CellIdx numCells, Permanence connectedThreshold, bo
   reset();
 }
 
+Connections::Topology &Connections::mutable_() {
+  if(topology_.use_count() != 1) {
+    topology_ = std::make_shared<Topology>(*topology_);
+  } else {
+    // The last other owner may just have let go, see its reads before writing.
+    std::atomic_thread_fence(std::memory_order_acquire);
+  }
+  return const_cast<Topology &>(*topology_);
+}
+
 UInt32 Connections::subscribe(ConnectionsEventHandler *handler) {
   UInt32 token = nextEventToken_++;
   eventHandlers_[token] = handler;
+  updateObserved_();
   return token;
 }
 
 void Connections::unsubscribe(UInt32 token) {
   delete eventHandlers_.at(token);
   eventHandlers_.erase(token);
+  updateObserved_();
+}
+
+
+void Connections::setChangeLog(const bool enable) {
+  changeLogEnabled_ = enable;
+  if(not enable) changeLog_.clear();
+  updateObserved_();
+}
+
+
+void Connections::setTrackChangedSegments(const bool enable) {
+  trackChangedSegments_ = enable;
+  allSegmentsChanged_ = false;
+  changedSegments_.clear();
+  isChangedSegment_.clear();
+  updateObserved_();
+}
+
+
+bool Connections::takeChangedSegments(vector<Segment> &out) {
+  out.clear();
+  if(allSegmentsChanged_) {
+    allSegmentsChanged_ = false;
+    changedSegments_.clear();
+    isChangedSegment_.clear();
+    return false;
+  }
+  out.swap(changedSegments_);
+  for(const auto segment : out) isChangedSegment_[segment] = false;
+  return true;
+}
+
+
+void Connections::segmentChanged_(const ConnectionsChange::Kind kind, const UInt32 id) {
+  if(allSegmentsChanged_) return;
+  Segment segment;
+  switch(kind) {
+    case ConnectionsChange::CREATE_SEGMENT:
+    case ConnectionsChange::DESTROY_SEGMENT:
+      segment = id;
+      break;
+    case ConnectionsChange::COMPACT:
+      allSegmentsChanged_ = true;
+      return;
+    default:
+      segment = topology_->synapses.segment[id];
+  }
+  if(segment >= isChangedSegment_.size()) isChangedSegment_.resize(topology_->segments.size(), false);
+  if(not isChangedSegment_[segment]) {
+    isChangedSegment_[segment] = true;
+    changedSegments_.push_back(segment);
+  }
+}
+
+
+void Connections::takeChangeLog(vector<ConnectionsChange> &out) {
+  out.clear();
+  out.swap(changeLog_);
 }
 
 
 void Connections::pruneLRUSegment_(const CellIdx& cell) {
+  mutable_(); //own the topology before reading it, the calls below change it
   const auto& destroyCandidates = segmentsForCell(cell);
+  if(segmentEviction_ == SegmentEviction::SAMPLED_LRU and destroyCandidates.size() > evictionSampleSize_) {
+    const auto numCandidates = static_cast<UInt32>(destroyCandidates.size());
+    Segment oldest = destroyCandidates[evictionRng_.getUInt32(numCandidates)];
+    for(UInt i = 1u; i < evictionSampleSize_; i++) {
+      const Segment seg = destroyCandidates[evictionRng_.getUInt32(numCandidates)];
+      const auto used = dataForSegment(seg).lastUsed;
+      if(used < dataForSegment(oldest).lastUsed or (used == dataForSegment(oldest).lastUsed and seg < oldest)) {
+        oldest = seg;
+      }
+    }
+    destroySegment(oldest);
+    return;
+  }
+
 #ifdef NTA_ASSERTIONS_ON
   const auto numBefore = destroyCandidates.size();
 #endif
@@ -99,6 +201,7 @@ void Connections::pruneLRUSegment_(const CellIdx& cell) {
 
 Segment Connections::createSegment(const CellIdx cell, 
 	                           const SegmentIdx maxSegmentsPerCell) {
+  Topology &topology = mutable_();
 
   //limit number of segmets per cell. If exceeded, remove the least recently used ones.
   NTA_CHECK(maxSegmentsPerCell > 0);
@@ -109,18 +212,17 @@ Segment Connections::createSegment(const CellIdx cell,
   NTA_ASSERT(numSegments(cell) <= maxSegmentsPerCell);
 
   //proceed to create a new segment
-  NTA_CHECK(segments_.size() < std::numeric_limits<Segment>::max()) << "Add segment failed: Range of Segment (data-type) insufficinet size."
-	    << (size_t)segments_.size() << " < " << (size_t)std::numeric_limits<Segment>::max();
-  const Segment segment = static_cast<Segment>(segments_.size());
-  const SegmentData& segmentData = SegmentData(cell, iteration_, nextSegmentOrdinal_++);
-  segments_.push_back(segmentData);
+  NTA_CHECK(topology.segments.size() < std::numeric_limits<Segment>::max()) << "Add segment failed: Range of Segment (data-type) insufficinet size."
+	    << (size_t)topology.segments.size() << " < " << (size_t)std::numeric_limits<Segment>::max();
+  const Segment segment = static_cast<Segment>(topology.segments.size());
+  const SegmentData& segmentData = SegmentData(cell, iteration_, topology.nextSegmentOrdinal++);
+  topology.segments.push_back(segmentData);
 
-  CellData &cellData = cells_[cell];
+  CellData &cellData = topology.cells[cell];
   cellData.segments.push_back(segment); //assign the new segment to its mother-cell
 
-  for (auto h : eventHandlers_) {
-    h.second->onCreateSegment(segment);
-  }
+  notify_(ConnectionsChange::CREATE_SEGMENT, segment, 0.0f,
+          [&](ConnectionsEventHandler *h) { h->onCreateSegment(segment); });
 
   return segment;
 }
@@ -129,6 +231,7 @@ Segment Connections::createSegment(const CellIdx cell,
 Synapse Connections::createSynapse(Segment segment,
                                    CellIdx presynapticCell,
                                    Permanence permanence) {
+  Topology &topology = mutable_();
 
   // Skip cells that are already synapsed on by this segment
   // Biological motivation (?):
@@ -141,7 +244,7 @@ Synapse Connections::createSynapse(Segment segment,
   // Synapses are supposed to have binary effects (0 or 1) but duplicate synapses give
   // them (synapses 0/1) varying levels of strength.
   for (const Synapse& syn : synapsesForSegment(segment)) {
-    const CellIdx existingPresynapticCell = dataForSynapse(syn).presynapticCell; //TODO 1; add way to get all presynaptic cells for segment (fast)
+    const CellIdx existingPresynapticCell = topology.synapses.presynapticCell[syn]; //TODO 1; add way to get all presynaptic cells for segment (fast)
     if (presynapticCell == existingPresynapticCell) {
       //synapse (connecting to this presyn cell) already exists on the segment; don't create a new one, exit early and return the existing
       NTA_ASSERT(synapseExists_(syn));
@@ -151,37 +254,258 @@ Synapse Connections::createSynapse(Segment segment,
       //3. create a duplicit new synapse -- NO. This is the only choice that is incorrect! HTM works on binary synapses, duplicates would break that.
       //4. update to the max of the permanences (default)
 
-      auto& synData = synapses_[syn];
-      if(permanence > synData.permanence) updateSynapsePermanence(syn, permanence);
+      if(permanence > topology.synapses.permanence[syn]) updateSynapsePermanence(syn, permanence);
       return syn;
     }
   } //else: the new synapse is not duplicit, so keep creating it. 
 
+  return createSynapse_(segment, presynapticCell, permanence);
+}
+
+void Connections::createSynapses(const Segment segment,
+                                 const vector<CellIdx> &presynapticCells,
+                                 const vector<Permanence> &permanences) {
+  Topology &topology = mutable_();
+  NTA_CHECK(presynapticCells.size() == permanences.size())
+    << "createSynapses: " << presynapticCells.size() << " cells but " << permanences.size() << " permanences";
+  NTA_CHECK(segmentExists_(segment));
+
+  const bool unique = topology.segments[segment].synapses.empty() and
+    std::adjacent_find(presynapticCells.cbegin(), presynapticCells.cend(),
+                       std::greater_equal<CellIdx>()) == presynapticCells.cend();
+  if(not unique) {
+    for(size_t i = 0; i < presynapticCells.size(); i++) {
+      createSynapse(segment, presynapticCells[i], permanences[i]);
+    }
+    return;
+  }
+  topology.segments[segment].synapses.reserve(presynapticCells.size());
+  for(size_t i = 0; i < presynapticCells.size(); i++) {
+    createSynapse_(segment, presynapticCells[i], permanences[i]);
+  }
+}
+
+void Connections::bulkLoad(const vector<CellIdx> &segmentCells,
+                           const vector<Synapse> &synapseOffsets,
+                           const vector<CellIdx> &presynapticCells,
+                           const vector<Permanence> &permanences,
+                           const vector<UInt32> &lastUsed) {
+  Topology &topology = mutable_();
+  NTA_CHECK(topology.segments.empty() and topology.synapses.size() == 0u)
+    << "bulkLoad: the Connections must be empty, call initialize() first.";
+  NTA_CHECK(synapseOffsets.size() == segmentCells.size() + 1u)
+    << "bulkLoad: expected " << segmentCells.size() + 1u << " synapse offsets, got " << synapseOffsets.size();
+  NTA_CHECK(presynapticCells.size() == permanences.size())
+    << "bulkLoad: " << presynapticCells.size() << " presynaptic cells but " << permanences.size() << " permanences";
+  NTA_CHECK(synapseOffsets.front() == 0u and synapseOffsets.back() == presynapticCells.size())
+    << "bulkLoad: the synapse offsets must start at 0 and end at " << presynapticCells.size();
+  NTA_CHECK(lastUsed.empty() or lastUsed.size() == segmentCells.size())
+    << "bulkLoad: " << segmentCells.size() << " segments but " << lastUsed.size() << " lastUsed";
+  NTA_CHECK(segmentCells.size() < std::numeric_limits<Segment>::max());
+  const Segment numSegments = static_cast<Segment>(segmentCells.size());
+  const Synapse numSynapses = static_cast<Synapse>(presynapticCells.size());
+
+  // Check everything before changing anything.
+  for(Segment segment = 0; segment < numSegments; segment++) {
+    NTA_CHECK(segmentCells[segment] < numCells())
+      << "bulkLoad: cell " << segmentCells[segment] << " of segment " << segment << " is out of range";
+    NTA_CHECK(synapseOffsets[segment] <= synapseOffsets[segment + 1u])
+      << "bulkLoad: the synapse offsets must be ascending, at segment " << segment;
+  }
+  const size_t numTasks = threadPool_ == nullptr ? 1u : threadPool_->size();
+  vector<Segment> duplicateOn(numTasks, numSegments); //first segment of each task with a duplicate
+  const auto findDuplicates = [&](const size_t task) {
+    vector<CellIdx> sorted;
+    for(size_t segment = task; segment < numSegments; segment += numTasks) {
+      sorted.assign(presynapticCells.cbegin() + synapseOffsets[segment],
+                    presynapticCells.cbegin() + synapseOffsets[segment + 1u]);
+      std::sort(sorted.begin(), sorted.end());
+      if(std::adjacent_find(sorted.cbegin(), sorted.cend()) != sorted.cend()) {
+        duplicateOn[task] = static_cast<Segment>(segment);
+        return;
+      }
+    }
+  };
+  if(numTasks == 1u) {
+    findDuplicates(0u);
+  } else {
+    threadPool_->parallelFor(numTasks, findDuplicates);
+  }
+  const Segment duplicate = *std::min_element(duplicateOn.cbegin(), duplicateOn.cend());
+  NTA_CHECK(duplicate == numSegments) << "bulkLoad: a presynaptic cell repeats on segment " << duplicate;
+
+  topology.segments.reserve(numSegments);
+  for(Segment segment = 0; segment < numSegments; segment++) {
+    const CellIdx cell = segmentCells[segment];
+    topology.segments.push_back(SegmentData(cell, iteration_, topology.nextSegmentOrdinal++));
+    if(not lastUsed.empty()) topology.segments.back().lastUsed = lastUsed[segment];
+    topology.cells[cell].segments.push_back(segment);
+    auto &synapses = topology.segments.back().synapses;
+    synapses.resize(synapseOffsets[segment + 1u] - synapseOffsets[segment]);
+    std::iota(synapses.begin(), synapses.end(), synapseOffsets[segment]);
+  }
+
+  // The synapses, they start connected or disconnected so the presynaptic
+  // maps are the same as if createSynapse() had moved them there.
+  topology.synapses.reserve(numSynapses);
+  std::unordered_map<CellIdx, std::pair<Synapse, Synapse>, identity> counts; //potential, connected
+  for(Segment segment = 0; segment < numSegments; segment++) {
+    for(Synapse synapse = synapseOffsets[segment]; synapse < synapseOffsets[segment + 1u]; synapse++) {
+      Permanence permanence = std::min(std::max(permanences[synapse], minPermanence), maxPermanence);
+      permanence = topology.synapses.permanence.quantize(permanence);
+      SynapseData data;
+      data.presynapticCell = presynapticCells[synapse];
+      data.segment         = segment;
+      data.id              = topology.nextSynapseOrdinal++;
+      data.permanence      = permanence;
+      auto &count = counts[data.presynapticCell];
+      if(topology.synapses.permanence.isConnectedValue(permanence)) {
+        data.presynapticMapIndex_ = count.second++;
+        topology.segments[segment].numConnected++;
+      } else {
+        data.presynapticMapIndex_ = count.first++;
+      }
+      topology.synapses.push_back(data);
+    }
+  }
+  topology.potentialSynapsesForPresynapticCell.reserve(counts.size());
+  topology.potentialSegmentsForPresynapticCell.reserve(counts.size());
+  for(const auto &count : counts) {
+    // createSynapse() adds every presynaptic cell to the potential maps
+    topology.potentialSynapsesForPresynapticCell[count.first].reserve(count.second.first);
+    topology.potentialSegmentsForPresynapticCell[count.first].reserve(count.second.first);
+    if(count.second.second > 0u) {
+      topology.connectedSynapsesForPresynapticCell[count.first].reserve(count.second.second);
+      topology.connectedSegmentsForPresynapticCell[count.first].reserve(count.second.second);
+    }
+  }
+  for(Synapse synapse = 0; synapse < numSynapses; synapse++) {
+    const CellIdx presyn  = topology.synapses.presynapticCell[synapse];
+    const Segment segment = topology.synapses.segment[synapse];
+    if(topology.synapses.permanence.isConnected(synapse)) {
+      topology.connectedSynapsesForPresynapticCell[presyn].push_back(synapse);
+      topology.connectedSegmentsForPresynapticCell[presyn].push_back(segment);
+    } else {
+      topology.potentialSynapsesForPresynapticCell[presyn].push_back(synapse);
+      topology.potentialSegmentsForPresynapticCell[presyn].push_back(segment);
+    }
+  }
+  topology.connectedFlatIndex.valid = false; //rebuilt lazily, if used
+  topology.potentialFlatIndex.valid = false;
+
+  if(observed_) {
+    for(Segment segment = 0; segment < numSegments; segment++) {
+      notify_(ConnectionsChange::CREATE_SEGMENT, segment, 0.0f,
+              [&](ConnectionsEventHandler *h) { h->onCreateSegment(segment); });
+      for(const Synapse synapse : topology.segments[segment].synapses) {
+        notify_(ConnectionsChange::CREATE_SYNAPSE, synapse, 0.0f,
+                [&](ConnectionsEventHandler *h) { h->onCreateSynapse(synapse); });
+      }
+    }
+  }
+}
+
+
+void Connections::bulkExport(vector<CellIdx> &segmentCells,
+                             vector<Synapse> &synapseOffsets,
+                             vector<CellIdx> &presynapticCells,
+                             vector<Permanence> &permanences,
+                             vector<UInt32> &lastUsed) const {
+  const Topology &topology = *topology_;
+  vector<bool> exists(topology.segments.size(), false);
+  for(const auto &cellData : topology.cells) {
+    for(const Segment segment : cellData.segments) exists[segment] = true;
+  }
+  const size_t numSegments = topology.segments.size() - topology.destroyedSegments;
+  const size_t numSynapses = topology.synapses.size() - topology.destroyedSynapses;
+  segmentCells.clear();
+  segmentCells.reserve(numSegments);
+  lastUsed.clear();
+  lastUsed.reserve(numSegments);
+  synapseOffsets.assign(1u, 0u);
+  synapseOffsets.reserve(numSegments + 1u);
+  presynapticCells.clear();
+  presynapticCells.reserve(numSynapses);
+  permanences.clear();
+  permanences.reserve(numSynapses);
+  for(Segment segment = 0; segment < topology.segments.size(); segment++) {
+    if(not exists[segment]) continue;
+    const SegmentData &segmentData = topology.segments[segment];
+    segmentCells.push_back(segmentData.cell);
+    lastUsed.push_back(segmentData.lastUsed);
+    for(const Synapse synapse : segmentData.synapses) {
+      presynapticCells.push_back(topology.synapses.presynapticCell[synapse]);
+      permanences.push_back(topology.synapses.permanence[synapse]);
+    }
+    synapseOffsets.push_back(static_cast<Synapse>(presynapticCells.size()));
+  }
+}
+
+
+Connections::SynapseArraysView Connections::synapseArrays() const {
+  SynapseArraysView view;
+  view.owner           = topology_;
+  view.size            = topology_->synapses.size();
+  view.presynapticCell = topology_->synapses.presynapticCell.data();
+  view.segment         = topology_->synapses.segment.data();
+  if(topology_->synapses.permanence.precision == PermanencePrecision::FLOAT32) {
+    view.permanence = topology_->synapses.permanence.f32.data();
+  }
+  return view;
+}
+
+
+vector<Permanence> Connections::synapsePermanences() const {
+  const auto &permanence = topology_->synapses.permanence;
+  vector<Permanence> permanences(permanence.size());
+  for(Synapse synapse = 0; synapse < permanences.size(); synapse++) {
+    permanences[synapse] = permanence[synapse];
+  }
+  return permanences;
+}
+
+
+void Connections::segmentArrays(vector<CellIdx> &cells, vector<UInt32> &lastUsed) const {
+  const Topology &topology = *topology_;
+  cells.assign(topology.segments.size(), static_cast<CellIdx>(numCells()));
+  lastUsed.resize(topology.segments.size());
+  for(const auto &cellData : topology.cells) {
+    for(const Segment segment : cellData.segments) cells[segment] = topology.segments[segment].cell;
+  }
+  for(Segment segment = 0; segment < topology.segments.size(); segment++) {
+    lastUsed[segment] = topology.segments[segment].lastUsed;
+  }
+}
+
+Synapse Connections::createSynapse_(const Segment segment,
+                                    const CellIdx presynapticCell,
+                                    Permanence permanence) {
+  Topology &topology = mutable_();
   // Get an index into the synapses_ list, for the new synapse to reside at.
-  NTA_ASSERT(synapses_.size() < std::numeric_limits<Synapse>::max()) << "Add synapse failed: Range of Synapse (data-type) insufficient size."
-	    << synapses_.size() << " < " << (size_t)std::numeric_limits<Synapse>::max();
-  const Synapse synapse = static_cast<Synapse>(synapses_.size()); //TODO work on cache locality. Have all Synapse, SynapseData on Segment in continuous mem block ?
-  synapses_.emplace_back(SynapseData());
+  NTA_ASSERT(topology.synapses.size() < std::numeric_limits<Synapse>::max()) << "Add synapse failed: Range of Synapse (data-type) insufficient size."
+	    << topology.synapses.size() << " < " << (size_t)std::numeric_limits<Synapse>::max();
+  const Synapse synapse = static_cast<Synapse>(topology.synapses.size()); //TODO work on cache locality. Have all Synapse, SynapseData on Segment in continuous mem block ?
 
   // Fill in the new synapse's data
-  SynapseData &synapseData    = synapses_[synapse];
+  SynapseData synapseData;
   synapseData.presynapticCell = presynapticCell;
   synapseData.segment         = segment;
-  synapseData.id              = nextSynapseOrdinal_++; //TODO move these to SynData constructor
+  synapseData.id              = topology.nextSynapseOrdinal++; //TODO move these to SynData constructor
   // Start in disconnected state.
   synapseData.permanence           = connectedThreshold_ - 1.0f;
   synapseData.presynapticMapIndex_ = 
-    (Synapse)potentialSynapsesForPresynapticCell_[presynapticCell].size();
-  potentialSynapsesForPresynapticCell_[presynapticCell].push_back(synapse);
-  potentialSegmentsForPresynapticCell_[presynapticCell].push_back(segment);
+    (Synapse)topology.potentialSynapsesForPresynapticCell[presynapticCell].size();
+  topology.synapses.push_back(synapseData);
+  topology.potentialSynapsesForPresynapticCell[presynapticCell].push_back(synapse);
+  topology.potentialSegmentsForPresynapticCell[presynapticCell].push_back(segment);
+  if(useFlatIndex_) topology.potentialFlatIndex.insert(presynapticCell, segment);
 
-  SegmentData &segmentData = segments_[segment];
+  SegmentData &segmentData = topology.segments[segment];
   segmentData.synapses.push_back(synapse);
 
 
-  for (auto h : eventHandlers_) {
-    h.second->onCreateSynapse(synapse);
-  }
+  notify_(ConnectionsChange::CREATE_SYNAPSE, synapse, 0.0f,
+          [&](ConnectionsEventHandler *h) { h->onCreateSynapse(synapse); });
 
   updateSynapsePermanence(synapse, permanence);
 
@@ -189,35 +513,34 @@ Synapse Connections::createSynapse(Segment segment,
 }
 
 bool Connections::segmentExists_(const Segment segment) const {
-  if(segment >= segments_.size()) return false; //OOB segment
+  if(segment >= topology_->segments.size()) return false; //OOB segment
 
-  const SegmentData &segmentData = segments_[segment];
-  const vector<Segment> &segmentsOnCell = cells_[segmentData.cell].segments;
+  const SegmentData &segmentData = topology_->segments[segment];
+  const vector<Segment> &segmentsOnCell = topology_->cells[segmentData.cell].segments;
   return (std::find(segmentsOnCell.cbegin(), segmentsOnCell.cend(), segment) != segmentsOnCell.cend()); //TODO if too slow, also create "fast" variant, as synapseExists_()
 }
 
 bool Connections::synapseExists_(const Synapse synapse, bool fast) const {
-  if(synapse >= synapses_.size()) return false; //out of bounds. Can happen after serialization, where only existing synapses are stored.
+  if(synapse >= topology_->synapses.size()) return false; //out of bounds. Can happen after serialization, where only existing synapses are stored.
 
 #ifdef NTA_ASSERTIONS_ON
   fast = false; //in Debug, do the proper, slow check always
 #endif
   if(!fast) {
   //proper but slow method to check for valid, existing synapse
-  const SynapseData &synapseData = synapses_[synapse];
   const vector<Synapse> &synapsesOnSegment =
-      segments_[synapseData.segment].synapses;
+      topology_->segments[topology_->synapses.segment[synapse]].synapses;
   const bool found = (std::find(synapsesOnSegment.begin(), synapsesOnSegment.end(), synapse) != synapsesOnSegment.end());
   //validate the fast & slow methods for same result:
 #ifdef NTA_ASSERTIONS_ON
-  const bool removed = synapses_[synapse].permanence == -1;
+  const bool removed = topology_->synapses.permanence[synapse] == -1;
   NTA_ASSERT( (removed and not found) or (not removed and found) );
 #endif
   return found;
 
   } else {
   //quick method. Relies on hack in destroySynapse() where we set synapseData.permanence == -1
-  return synapses_[synapse].permanence != -1;
+  return topology_->synapses.permanence[synapse] != -1;
   }
 }
 
@@ -230,12 +553,13 @@ void Connections::removeSynapseFromPresynapticMap_(
     vector<Synapse> &preSynapses,
     vector<Segment> &preSegments)
 {
+  Topology &topology = mutable_();
   NTA_ASSERT( !preSynapses.empty() );
   NTA_ASSERT( index < preSynapses.size() );
   NTA_ASSERT( preSynapses.size() == preSegments.size() );
 
   const auto move = preSynapses.back();
-  synapses_[move].presynapticMapIndex_ = index;
+  topology.synapses.presynapticMapIndex[move] = index;
   preSynapses[index] = move;
   preSynapses.pop_back();
 
@@ -245,72 +569,74 @@ void Connections::removeSynapseFromPresynapticMap_(
 
 
 void Connections::destroySegment(const Segment segment) {
+  Topology &topology = mutable_();
   if(not segmentExists_(segment)) return;
 
-  for (auto h : eventHandlers_) {
-    h.second->onDestroySegment(segment);
-  }
+  notify_(ConnectionsChange::DESTROY_SEGMENT, segment, 0.0f,
+          [&](ConnectionsEventHandler *h) { h->onDestroySegment(segment); });
 
-  SegmentData &segmentData = segments_[segment];
+  SegmentData &segmentData = topology.segments[segment];
 
   // Destroy synapses from the end of the list, so that the index-shifting is
   // easier to do.
   while( !segmentData.synapses.empty() )
     destroySynapse(segmentData.synapses.back());
 
-  CellData &cellData = cells_[segmentData.cell];
+  CellData &cellData = topology.cells[segmentData.cell];
 
   const auto segmentOnCell = std::find(cellData.segments.cbegin(), cellData.segments.cend(), segment);
   NTA_ASSERT(segmentOnCell != cellData.segments.cend()) << "Segment to be destroyed not found on the cell!";
   NTA_ASSERT(*segmentOnCell == segment);
 
   cellData.segments.erase(segmentOnCell);
-  destroyedSegments_++;
+  topology.destroyedSegments++;
 
   NTA_ASSERT(not segmentExists_(segment));
 }
 
 
 void Connections::destroySynapse(const Synapse synapse) {
+  Topology &topology = mutable_();
   if(not synapseExists_(synapse, true)) return;
 
-  for (auto h : eventHandlers_) {
-    h.second->onDestroySynapse(synapse);
-  }
+  notify_(ConnectionsChange::DESTROY_SYNAPSE, synapse, 0.0f,
+          [&](ConnectionsEventHandler *h) { h->onDestroySynapse(synapse); });
 
-  SynapseData& synapseData = synapses_[synapse]; //like dataForSynapse() but here we need writeable access
-  SegmentData &segmentData = segments_[synapseData.segment];
-  const auto   presynCell  = synapseData.presynapticCell;
+  const Segment segment    = topology.synapses.segment[synapse];
+  SegmentData &segmentData = topology.segments[segment];
+  const auto   presynCell  = topology.synapses.presynapticCell[synapse];
 
-  if( synapseData.permanence >= connectedThreshold_ ) {
+  if( topology.synapses.permanence.isConnected(synapse) ) {
     segmentData.numConnected--;
 
     removeSynapseFromPresynapticMap_(
-      synapseData.presynapticMapIndex_,
-      connectedSynapsesForPresynapticCell_.at( presynCell ),
-      connectedSegmentsForPresynapticCell_.at( presynCell ));
-
-    if( connectedSynapsesForPresynapticCell_.at( presynCell ).empty() ){
-      connectedSynapsesForPresynapticCell_.erase( presynCell );
-      connectedSegmentsForPresynapticCell_.erase( presynCell );
+      topology.synapses.presynapticMapIndex[synapse],
+      topology.connectedSynapsesForPresynapticCell.at( presynCell ),
+      topology.connectedSegmentsForPresynapticCell.at( presynCell ));
+    if(useFlatIndex_) topology.connectedFlatIndex.erase(presynCell, topology.synapses.presynapticMapIndex[synapse], segment);
+
+    if( topology.connectedSynapsesForPresynapticCell.at( presynCell ).empty() ){
+      topology.connectedSynapsesForPresynapticCell.erase( presynCell );
+      topology.connectedSegmentsForPresynapticCell.erase( presynCell );
     }
   }
   else {
     removeSynapseFromPresynapticMap_(
-      synapseData.presynapticMapIndex_,
-      potentialSynapsesForPresynapticCell_.at( presynCell ),
-      potentialSegmentsForPresynapticCell_.at( presynCell ));
-
-    if( potentialSynapsesForPresynapticCell_.at( presynCell ).empty() ){
-      potentialSynapsesForPresynapticCell_.erase( presynCell );
-      potentialSegmentsForPresynapticCell_.erase( presynCell );
+      topology.synapses.presynapticMapIndex[synapse],
+      topology.potentialSynapsesForPresynapticCell.at( presynCell ),
+      topology.potentialSegmentsForPresynapticCell.at( presynCell ));
+    if(useFlatIndex_) topology.potentialFlatIndex.erase(presynCell, topology.synapses.presynapticMapIndex[synapse], segment);
+
+    if( topology.potentialSynapsesForPresynapticCell.at( presynCell ).empty() ){
+      topology.potentialSynapsesForPresynapticCell.erase( presynCell );
+      topology.potentialSegmentsForPresynapticCell.erase( presynCell );
     }
   }
   
   const auto synapseOnSegment = std::lower_bound(segmentData.synapses.cbegin(), 
 		                          segmentData.synapses.cend(),
 					  synapse,
-					  [&](const Synapse a, const Synapse b) -> bool { return dataForSynapse(a).id < dataForSynapse(b).id;}
+					  [&](const Synapse a, const Synapse b) -> bool { return topology.synapses.id[a] < topology.synapses.id[b];}
 					  ); 
 
   NTA_ASSERT(synapseOnSegment != segmentData.synapses.cend());
@@ -319,64 +645,80 @@ void Connections::destroySynapse(const Synapse synapse) {
   segmentData.synapses.erase(synapseOnSegment);
   //Note: dataForSynapse(synapse) are not deleted, unfortunately. And are still accessible. 
   //To mark them as "removed", we set SynapseData.permanence = -1, this can be used for a quick check later
-  synapseData.permanence = -1; //marking as "removed"
-  destroyedSynapses_++;
+  topology.synapses.permanence.markRemoved(synapse); //marking as "removed", reads as permanence -1
+  topology.destroyedSynapses++;
   NTA_ASSERT(not synapseExists_(synapse));
 }
 
 
 void Connections::updateSynapsePermanence(const Synapse synapse,
                                           Permanence permanence) {
+  Topology &topology = mutable_();
   permanence = std::min(permanence, maxPermanence );
   permanence = std::max(permanence, minPermanence );
+  permanence = topology.synapses.permanence.quantize(permanence);
 
-  auto &synData = synapses_[synapse];
-  
-  const bool before = synData.permanence >= connectedThreshold_;
-  const bool after  = permanence         >= connectedThreshold_;
+  const bool before = topology.synapses.permanence.isConnected(synapse);
 
   // update the permanence
-  synData.permanence = permanence;
+  topology.synapses.permanence.set(synapse, permanence);
+
+  const bool after  = topology.synapses.permanence.isConnected(synapse);
 
   if( before == after ) { //no change in dis/connected status
       return;
   }
-    const auto &presyn    = synData.presynapticCell;
-    auto &potentialPresyn = potentialSynapsesForPresynapticCell_[presyn];
-    auto &potentialPreseg = potentialSegmentsForPresynapticCell_[presyn];
-    auto &connectedPresyn = connectedSynapsesForPresynapticCell_[presyn];
-    auto &connectedPreseg = connectedSegmentsForPresynapticCell_[presyn];
-    const auto &segment   = synData.segment;
-    auto &segmentData     = segments_[segment];
-    
-    if( after ) { //connect
+  reconnectSynapse_(synapse, after, permanence);
+}
+
+
+void Connections::reconnectSynapse_(const Synapse synapse, const bool connected,
+                                    const Permanence permanence) {
+  Topology &topology = mutable_();
+    const auto presyn     = topology.synapses.presynapticCell[synapse];
+    auto &potentialPresyn = topology.potentialSynapsesForPresynapticCell[presyn];
+    auto &potentialPreseg = topology.potentialSegmentsForPresynapticCell[presyn];
+    auto &connectedPresyn = topology.connectedSynapsesForPresynapticCell[presyn];
+    auto &connectedPreseg = topology.connectedSegmentsForPresynapticCell[presyn];
+    const auto segment    = topology.synapses.segment[synapse];
+    auto &segmentData     = topology.segments[segment];
+    const Synapse index   = topology.synapses.presynapticMapIndex[synapse]; //position in the presynaptic lists
+
+    if( connected ) { //connect
       segmentData.numConnected++;
 
       // Remove this synapse from presynaptic potential synapses.
-      removeSynapseFromPresynapticMap_( synData.presynapticMapIndex_,
-                                        potentialPresyn, potentialPreseg );
+      removeSynapseFromPresynapticMap_( index, potentialPresyn, potentialPreseg );
 
       // Add this synapse to the presynaptic connected synapses.
-      synData.presynapticMapIndex_ = (Synapse)connectedPresyn.size();
+      topology.synapses.presynapticMapIndex[synapse] = (Synapse)connectedPresyn.size();
       connectedPresyn.push_back( synapse );
       connectedPreseg.push_back( segment );
+
+      if(useFlatIndex_) {
+        topology.potentialFlatIndex.erase(presyn, index, segment);
+        topology.connectedFlatIndex.insert(presyn, segment);
+      }
     }
     else { //disconnected
       segmentData.numConnected--;
 
       // Remove this synapse from presynaptic connected synapses.
-      removeSynapseFromPresynapticMap_( synData.presynapticMapIndex_,
-                                        connectedPresyn, connectedPreseg );
+      removeSynapseFromPresynapticMap_( index, connectedPresyn, connectedPreseg );
 
       // Add this synapse to the presynaptic connected synapses.
-      synData.presynapticMapIndex_ = (Synapse)potentialPresyn.size();
+      topology.synapses.presynapticMapIndex[synapse] = (Synapse)potentialPresyn.size();
       potentialPresyn.push_back( synapse );
       potentialPreseg.push_back( segment );
-    }
 
-    for (auto h : eventHandlers_) { //TODO handle callbacks in performance-critical method only in Debug?
-      h.second->onUpdateSynapsePermanence(synapse, permanence);
+      if(useFlatIndex_) {
+        topology.connectedFlatIndex.erase(presyn, index, segment);
+        topology.potentialFlatIndex.insert(presyn, segment);
+      }
     }
+
+    notify_(ConnectionsChange::UPDATE_SYNAPSE_PERMANENCE, synapse, permanence,
+            [&](ConnectionsEventHandler *h) { h->onUpdateSynapsePermanence(synapse, permanence); });
 }
 
 
@@ -389,8 +731,8 @@ SegmentIdx Connections::idxOnCellForSegment(const Segment segment) const {
 
 
 bool Connections::compareSegments(const Segment a, const Segment b) const {
-  const SegmentData &aData = segments_[a];
-  const SegmentData &bData = segments_[b];
+  const SegmentData &aData = topology_->segments[a];
+  const SegmentData &bData = topology_->segments[b];
   // default sort by cell
   if (aData.cell == bData.cell)
     //fallback to ordinals:
@@ -402,13 +744,13 @@ bool Connections::compareSegments(const Segment a, const Segment b) const {
 vector<Synapse> Connections::synapsesForPresynapticCell(const CellIdx presynapticCell) const {
   vector<Synapse> all;
 
-  if (potentialSynapsesForPresynapticCell_.count(presynapticCell)) {
-    const auto& potential = potentialSynapsesForPresynapticCell_.at(presynapticCell);
+  if (topology_->potentialSynapsesForPresynapticCell.count(presynapticCell)) {
+    const auto& potential = topology_->potentialSynapsesForPresynapticCell.at(presynapticCell);
     all.assign(potential.cbegin(), potential.cend());
   }
 
-  if (connectedSynapsesForPresynapticCell_.count(presynapticCell)) {
-    const auto& connected = connectedSynapsesForPresynapticCell_.at(presynapticCell);
+  if (topology_->connectedSynapsesForPresynapticCell.count(presynapticCell)) {
+    const auto& connected = topology_->connectedSynapsesForPresynapticCell.at(presynapticCell);
     all.insert( all.cend(), connected.cbegin(), connected.cend());
   }
 
@@ -425,9 +767,60 @@ void Connections::reset() noexcept
   currentUpdates_.clear();
 }
 
-vector<SynapseIdx> Connections::computeActivity(const vector<CellIdx> &activePresynapticCells, const bool learn) {
+void Connections::setSynapseBudget(std::shared_ptr<SynapseBudget> budget, const bool destroySegments) {
+  budgetMember_ = budget == nullptr ? nullptr : budget->attach();
+  budget_ = std::move(budget);
+  budgetDestroysSegments_ = destroySegments;
+}
+
+
+void Connections::pruneToBudget_() {
+  const size_t target = budgetMember_->target.load(std::memory_order_relaxed);
+  if(numSynapses() > target) {
+    const size_t goal = numSynapses() - std::min(numSynapses() - target, budget_->getMaxPrunePerCompute());
+
+    // All segments, least recently used first.
+    // Read only, mutable_() (and the copy of a shared topology) waits for the victims.
+    const Topology &topology = *topology_;
+    vector<Segment> segments;
+    segments.reserve(numSegments());
+    for(const auto &cellData : topology.cells) {
+      segments.insert(segments.end(), cellData.segments.cbegin(), cellData.segments.cend());
+    }
+    std::sort(segments.begin(), segments.end(), [&topology](const Segment a, const Segment b) {
+      const auto usedA = topology.segments[a].lastUsed;
+      const auto usedB = topology.segments[b].lastUsed;
+      return usedA == usedB ? a < b : usedA < usedB;
+    });
+
+    const size_t before = numSynapses();
+    if(budgetDestroysSegments_) {
+      for(size_t i = 0u; i < segments.size() and numSynapses() > goal; i++) {
+        destroySegment(segments[i]);
+      }
+    } else {
+      // Spread over the segments, the weakest synapses of each.
+      const size_t perSegment = segments.empty() ? 0u :
+        std::max<size_t>(1u, (numSynapses() - goal + segments.size() - 1u) / segments.size());
+      for(size_t i = 0u; i < segments.size() and numSynapses() > goal; i++) {
+        destroyMinPermanenceSynapses(segments[i], std::min(perSegment, numSynapses() - goal), {});
+      }
+    }
+    budgetPrunedSynapses_ += before - numSynapses();
+  }
+  budgetMember_->synapses.store(numSynapses(), std::memory_order_relaxed);
+}
+
+
+void Connections::startComputeActivity_(const bool learn) {
+  if(learn and budgetMember_ != nullptr) pruneToBudget_(); //before compact(), which then reclaims the space
+  if(compactThreshold_ > 0.0f and
+     (topology_->destroyedSegments >= compactThreshold_ * topology_->segments.size() or
+      topology_->destroyedSynapses >= compactThreshold_ * topology_->synapses.size()) and
+     topology_->destroyedSegments + topology_->destroyedSynapses > 0u) {
+    compact();
+  }
 
-  vector<SynapseIdx> numActiveConnectedSynapsesForSegment(segments_.size(), 0);
   if(learn) iteration_++;
 
   if( timeseries_ ) {
@@ -436,16 +829,122 @@ vector<SynapseIdx> Connections::computeActivity(const vector<CellIdx> &activePre
     previousUpdates_.swap( currentUpdates_ );
     currentUpdates_.clear();
   }
+}
+
+
+vector<SynapseIdx> Connections::computeActivity(const vector<CellIdx> &activePresynapticCells, const bool learn) {
+  startComputeActivity_(learn);
+  vector<SynapseIdx> numActiveConnectedSynapsesForSegment(topology_->segments.size(), 0);
 
   // Iterate through all connected synapses.
-  for (const auto& cell : activePresynapticCells) {
-    if (connectedSegmentsForPresynapticCell_.count(cell)) {
-      for(const auto& segment : connectedSegmentsForPresynapticCell_.at(cell)) {
-        ++numActiveConnectedSynapsesForSegment[segment];
-      }
+  countSegments_(true, activePresynapticCells, numActiveConnectedSynapsesForSegment);
+  return numActiveConnectedSynapsesForSegment;
+}
+
+
+void Connections::computeActivity(SegmentActivity &activity,
+                                  const vector<CellIdx> &activePresynapticCells,
+                                  const bool learn,
+                                  const bool countPotential) {
+  static const vector<CellIdx> noCells;
+  computeActivity(activity, activePresynapticCells, noCells, 0u, learn, countPotential);
+}
+
+
+void Connections::computeActivity(SegmentActivity &activity,
+                                  const vector<CellIdx> &activePresynapticCells,
+                                  const vector<CellIdx> &externalCells,
+                                  const CellIdx externalOffset,
+                                  const bool learn,
+                                  const bool countPotential) {
+  HTM_PROBE("Connections::computeActivity");
+  startComputeActivity_(learn);
+  if(not countPotential and threadPool_ == nullptr and externalCells.empty()) {
+    prepareFlatIndex_(true);
+    computeConnectedActivity(activity, activePresynapticCells);
+    return;
+  }
+  resetActivity_(activity, countPotential);
+  auto &connected = activity.numActiveConnected;
+  auto &potential = activity.numActivePotential;
+
+  if(not countPotential) {
+    countSegments_(true, activePresynapticCells, connected);
+    if(not externalCells.empty()) countSegments_(true, externalCells, connected, externalOffset);
+    for(Segment segment = 0; segment < connected.size(); segment++) {
+      if(connected[segment] > 0) activity.touched.push_back(segment);
     }
+    return;
   }
-  return numActiveConnectedSynapsesForSegment;
+
+  if(threadPool_ != nullptr) {
+    countSegments_(true, activePresynapticCells, connected);
+    if(not externalCells.empty()) countSegments_(true, externalCells, connected, externalOffset);
+    std::copy(connected.begin(), connected.end(), potential.begin());
+    countSegments_(false, activePresynapticCells, potential);
+    if(not externalCells.empty()) countSegments_(false, externalCells, potential, externalOffset);
+    for(Segment segment = 0; segment < potential.size(); segment++) {
+      if(potential[segment] > 0) activity.touched.push_back(segment);
+    }
+    return;
+  }
+
+  prepareFlatIndex_(true);
+  prepareFlatIndex_(false);
+  auto &touched = activity.touched;
+  const auto countConnected = [&](const Segment segment) {
+    if(potential[segment] == 0) touched.push_back(segment);
+    ++connected[segment];
+    ++potential[segment];
+  };
+  const auto countPotentialOnly = [&](const Segment segment) {
+    if(potential[segment] == 0) touched.push_back(segment);
+    ++potential[segment];
+  };
+  const CellIdx *cellsBegin = activePresynapticCells.data();
+  const CellIdx *cellsEnd   = cellsBegin + activePresynapticCells.size();
+  const CellIdx *externalBegin = externalCells.data();
+  const CellIdx *externalEnd   = externalBegin + externalCells.size();
+  forEachSegment_(true,  cellsBegin,    cellsEnd,    countConnected);
+  forEachSegment_(true,  externalBegin, externalEnd, countConnected, externalOffset);
+  forEachSegment_(false, cellsBegin,    cellsEnd,    countPotentialOnly);
+  forEachSegment_(false, externalBegin, externalEnd, countPotentialOnly, externalOffset);
+}
+
+
+void Connections::computeConnectedActivity(SegmentActivity &activity,
+                                           const vector<CellIdx> &activePresynapticCells) const {
+  NTA_ASSERT(not useFlatIndex_ or topology_->connectedFlatIndex.valid) << "call prepareConcurrentActivity() first";
+  resetActivity_(activity, false);
+  auto &connected = activity.numActiveConnected;
+  auto &touched   = activity.touched;
+  forEachSegment_(true, activePresynapticCells.data(),
+                  activePresynapticCells.data() + activePresynapticCells.size(),
+                  [&](const Segment segment) {
+    if(connected[segment]++ == 0) touched.push_back(segment);
+  });
+}
+
+
+void Connections::resetActivity_(SegmentActivity &activity, const bool countPotential) const {
+  auto &connected = activity.numActiveConnected;
+  auto &potential = activity.numActivePotential;
+
+  // Zero the counters from the previous call, only where they were touched.
+  if(activity.touchedValid and (potential.empty() or connected.size() == potential.size())) {
+    for(const auto segment : activity.touched) {
+      if(segment >= connected.size()) continue; //after compact()
+      connected[segment] = 0;
+      if(not potential.empty()) potential[segment] = 0;
+    }
+  } else {
+    std::fill(connected.begin(), connected.end(), static_cast<SynapseIdx>(0));
+    std::fill(potential.begin(), potential.end(), static_cast<SynapseIdx>(0));
+  }
+  connected.resize(topology_->segments.size(), 0);
+  potential.resize(countPotential ? topology_->segments.size() : 0u, 0);
+  activity.touched.clear();
+  activity.touchedValid = true;
 }
 
 
@@ -453,28 +952,739 @@ vector<SynapseIdx> Connections::computeActivity(
     vector<SynapseIdx> &numActivePotentialSynapsesForSegment,
     const vector<CellIdx> &activePresynapticCells,
     const bool learn) {
-  NTA_ASSERT(numActivePotentialSynapsesForSegment.size() == segments_.size());
+  NTA_ASSERT(numActivePotentialSynapsesForSegment.size() == topology_->segments.size());
 
   // Iterate through all connected synapses.
   const vector<SynapseIdx>& numActiveConnectedSynapsesForSegment = computeActivity( activePresynapticCells, learn );
-  NTA_ASSERT(numActiveConnectedSynapsesForSegment.size() == segments_.size());
+  NTA_ASSERT(numActiveConnectedSynapsesForSegment.size() == topology_->segments.size());
+  numActivePotentialSynapsesForSegment.resize(topology_->segments.size()); //shrinks if compacted
 
   // Iterate through all potential synapses.
   std::copy( numActiveConnectedSynapsesForSegment.begin(),
              numActiveConnectedSynapsesForSegment.end(),
              numActivePotentialSynapsesForSegment.begin());
 
-  for (const auto& cell : activePresynapticCells) {
-    if (potentialSegmentsForPresynapticCell_.count(cell)) {
-      for(const auto& segment : potentialSegmentsForPresynapticCell_.at(cell)) {
-        ++numActivePotentialSynapsesForSegment[segment];
+  countSegments_(false, activePresynapticCells, numActivePotentialSynapsesForSegment);
+  return numActiveConnectedSynapsesForSegment;
+}
+
+
+void Connections::prepareFlatIndex_(const bool connected) {
+  if(not useFlatIndex_) return;
+  if(not (connected ? topology_->connectedFlatIndex : topology_->potentialFlatIndex).valid) {
+    Topology &topology = mutable_();
+    FlatIndex &index = connected ? topology.connectedFlatIndex : topology.potentialFlatIndex;
+    index.build(connected ? topology.connectedSegmentsForPresynapticCell : topology.potentialSegmentsForPresynapticCell);
+  }
+}
+
+
+template<typename Visit>
+void Connections::forEachSegment_(const bool connected,
+                                  const CellIdx *cellsBegin, const CellIdx *cellsEnd,
+                                  Visit &&visit, const CellIdx cellOffset) const {
+  if(useFlatIndex_) {
+    const FlatIndex &index = connected ? topology_->connectedFlatIndex : topology_->potentialFlatIndex;
+    const size_t rows = index.size.size();
+    const Segment *segments = index.segments.data();
+    for(const CellIdx *cell = cellsBegin; cell != cellsEnd; ++cell) {
+      const CellIdx presyn = *cell + cellOffset;
+      if (presyn >= rows) continue; //no synapses from this cell
+      const Segment *it  = segments + index.begin[presyn];
+      const Segment *end = it + index.size[presyn];
+      for( ; it != end; ++it) {
+        visit(*it);
       }
     }
+    return;
+  }
+
+  const auto &segmentsForPresynapticCell = connected ? topology_->connectedSegmentsForPresynapticCell
+                                                     : topology_->potentialSegmentsForPresynapticCell;
+  for(const CellIdx *cell = cellsBegin; cell != cellsEnd; ++cell) {
+    const auto found = segmentsForPresynapticCell.find(*cell + cellOffset);
+    if (found == segmentsForPresynapticCell.end()) continue;
+    for(const auto& segment : found->second) {
+      visit(segment);
+    }
   }
-  return numActiveConnectedSynapsesForSegment;
 }
 
 
+void Connections::countSegments_(const bool connected,
+                                 const vector<CellIdx> &activePresynapticCells,
+                                 vector<SynapseIdx> &numActiveSynapsesForSegment,
+                                 const CellIdx cellOffset) {
+  prepareFlatIndex_(connected);
+
+  const size_t numCells = activePresynapticCells.size();
+  const size_t numSegments = numActiveSynapsesForSegment.size();
+  const size_t numChunks = threadPool_ == nullptr ? 1u :
+                           std::min(threadPool_->size(), numCells / MIN_CELLS_PER_THREAD);
+  if(numChunks <= 1u) {
+    countSegmentsRange_(connected, activePresynapticCells.data(),
+                        activePresynapticCells.data() + numCells,
+                        numActiveSynapsesForSegment.data(), cellOffset);
+    return;
+  }
+
+  // Each chunk of the active cells counts into its own array, chunk 0 directly
+  // into the output. The partial arrays are then summed over ranges of segments.
+  // The counters are unsigned, so the result is the same as the serial loop.
+  if(partialCounts_.size() < numChunks - 1u) partialCounts_.resize(numChunks - 1u);
+  threadPool_->parallelFor(numChunks, [&](const size_t chunk) {
+    SynapseIdx *counts = numActiveSynapsesForSegment.data();
+    if(chunk > 0u) {
+      auto &partial = partialCounts_[chunk - 1u];
+      partial.assign(numSegments, 0);
+      counts = partial.data();
+    }
+    const CellIdx *cells = activePresynapticCells.data();
+    countSegmentsRange_(connected, cells + numCells * chunk / numChunks,
+                        cells + numCells * (chunk + 1u) / numChunks, counts, cellOffset);
+  });
+
+  threadPool_->parallelFor(numChunks, [&](const size_t chunk) {
+    const size_t begin = numSegments * chunk / numChunks;
+    const size_t end   = numSegments * (chunk + 1u) / numChunks;
+    SynapseIdx *counts = numActiveSynapsesForSegment.data();
+    for(size_t p = 0; p < numChunks - 1u; p++) {
+      const SynapseIdx *partial = partialCounts_[p].data();
+      for(size_t segment = begin; segment < end; segment++) {
+        counts[segment] = static_cast<SynapseIdx>(counts[segment] + partial[segment]);
+      }
+    }
+  });
+}
+
+
+void Connections::countSegmentsRange_(const bool connected,
+                                      const CellIdx *cellsBegin, const CellIdx *cellsEnd,
+                                      SynapseIdx *numActiveSynapsesForSegment,
+                                      const CellIdx cellOffset) const {
+  forEachSegment_(connected, cellsBegin, cellsEnd, [numActiveSynapsesForSegment](const Segment segment) {
+    ++numActiveSynapsesForSegment[segment];
+  }, cellOffset);
+}
+
+
+void Connections::setNumThreads(const UInt numThreads) {
+  if(numThreads <= 1u) {
+    threadPool_.reset();
+  } else if(threadPool_ == nullptr or threadPool_->size() != numThreads) {
+    threadPool_ = std::make_shared<ThreadPool>(numThreads);
+  }
+  partialCounts_.clear();
+}
+
+
+void Connections::setThreadPool(const std::shared_ptr<ThreadPool> &pool) {
+  threadPool_ = pool != nullptr and pool->size() > 1u ? pool : nullptr;
+  partialCounts_.clear();
+}
+
+
+void Connections::setMemoryResource(const std::shared_ptr<MemoryResource> &resource) {
+  if(resource == topology_->resource) return;
+  auto topology = std::make_shared<Topology>(resource);
+  *topology = *topology_; //the arrays keep their resource, and copy
+  topology->resource = resource;
+  topology_ = std::move(topology);
+}
+
+
+namespace {
+/**
+ * Scalar tail / fallback for Connections::filterSegmentsByActivity
+ */
+void filterSegmentsScalar_(const SynapseIdx *connected, const SynapseIdx activationThreshold,
+                           const SynapseIdx *potential, const SynapseIdx matchingThreshold,
+                           const size_t begin, const size_t end,
+                           vector<Segment> &active, vector<Segment> &matching) {
+  for(size_t segment = begin; segment < end; segment++) {
+    if(connected[segment] >= activationThreshold) active.push_back(static_cast<Segment>(segment));
+    if(potential[segment] >= matchingThreshold)   matching.push_back(static_cast<Segment>(segment));
+  }
+}
+
+#ifdef HTM_CONNECTIONS_X86_SIMD
+// Append the segments of the set bits in `mask` (bit i == segment base+i).
+inline void appendMask_(UInt32 mask, const size_t base, vector<Segment> &out) {
+  while(mask) {
+    out.push_back(static_cast<Segment>(base + __builtin_ctz(mask)));
+    mask &= mask - 1u;
+  }
+}
+
+__attribute__((target("avx512bw")))
+size_t filterSegmentsAvx512_(const SynapseIdx *connected, const SynapseIdx activationThreshold,
+                             const SynapseIdx *potential, const SynapseIdx matchingThreshold,
+                             const size_t n, vector<Segment> &active, vector<Segment> &matching) {
+  const __m512i actThr = _mm512_set1_epi16(static_cast<short>(activationThreshold));
+  const __m512i matThr = _mm512_set1_epi16(static_cast<short>(matchingThreshold));
+  size_t i = 0;
+  for(; i + 32u <= n; i += 32u) {
+    const __m512i c = _mm512_loadu_si512(reinterpret_cast<const void*>(connected + i));
+    const __m512i p = _mm512_loadu_si512(reinterpret_cast<const void*>(potential + i));
+    appendMask_(_mm512_cmpge_epu16_mask(c, actThr), i, active);
+    appendMask_(_mm512_cmpge_epu16_mask(p, matThr), i, matching);
+  }
+  return i;
+}
+
+// AVX2 has no unsigned 16bit compare: a >= t  <=>  max(a, t) == a.
+// movemask_epi8 yields 2 bits per 16bit lane, keep the even ones.
+__attribute__((target("avx2,bmi2")))
+size_t filterSegmentsAvx2_(const SynapseIdx *connected, const SynapseIdx activationThreshold,
+                           const SynapseIdx *potential, const SynapseIdx matchingThreshold,
+                           const size_t n, vector<Segment> &active, vector<Segment> &matching) {
+  const __m256i actThr = _mm256_set1_epi16(static_cast<short>(activationThreshold));
+  const __m256i matThr = _mm256_set1_epi16(static_cast<short>(matchingThreshold));
+  size_t i = 0;
+  for(; i + 16u <= n; i += 16u) {
+    const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(connected + i));
+    const __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(potential + i));
+    const UInt32 cMask = static_cast<UInt32>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(_mm256_max_epu16(c, actThr), c)));
+    const UInt32 pMask = static_cast<UInt32>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(_mm256_max_epu16(p, matThr), p)));
+    if((cMask | pMask) == 0u) continue; //common case, nothing active in this block
+    appendMask_(_pext_u32(cMask, 0x55555555u), i, active);
+    appendMask_(_pext_u32(pMask, 0x55555555u), i, matching);
+  }
+  return i;
+}
+#endif // HTM_CONNECTIONS_X86_SIMD
+
+#ifdef HTM_CONNECTIONS_NEON
+// NEON: test 8 lanes at once, only blocks with any hit are resolved by the scalar code.
+size_t filterSegmentsNeon_(const SynapseIdx *connected, const SynapseIdx activationThreshold,
+                           const SynapseIdx *potential, const SynapseIdx matchingThreshold,
+                           const size_t n, vector<Segment> &active, vector<Segment> &matching) {
+  const uint16x8_t actThr = vdupq_n_u16(activationThreshold);
+  const uint16x8_t matThr = vdupq_n_u16(matchingThreshold);
+  size_t i = 0;
+  for(; i + 8u <= n; i += 8u) {
+    const uint16x8_t hits = vorrq_u16(vcgeq_u16(vld1q_u16(connected + i), actThr),
+                                      vcgeq_u16(vld1q_u16(potential + i), matThr));
+    if(vmaxvq_u16(hits) == 0u) continue;
+    filterSegmentsScalar_(connected, activationThreshold, potential, matchingThreshold, i, i + 8u, active, matching);
+  }
+  return i;
+}
+#endif // HTM_CONNECTIONS_NEON
+
+// The SIMD part of filterSegmentsByActivity(), returns how many were done.
+using FilterSegmentsFn = size_t (*)(const SynapseIdx *, SynapseIdx, const SynapseIdx *, SynapseIdx,
+                                    size_t, vector<Segment> &, vector<Segment> &);
+FilterSegmentsFn filterSegmentsSimd_() {
+  static const FilterSegmentsFn fn = CpuDispatch::bind<FilterSegmentsFn>("connections.filterSegments", {
+#if defined(HTM_CONNECTIONS_X86_SIMD)
+      {"avx512", CPU_AVX512BW, filterSegmentsAvx512_},
+      {"avx2", CPU_AVX2 | CPU_BMI2, filterSegmentsAvx2_},
+#elif defined(HTM_CONNECTIONS_NEON)
+      {"neon", CPU_NEON, filterSegmentsNeon_},
+#endif
+      {"scalar", 0u, [](const SynapseIdx *, SynapseIdx, const SynapseIdx *, SynapseIdx, size_t,
+                        vector<Segment> &, vector<Segment> &) -> size_t { return 0u; }}});
+  return fn;
+}
+} // anonymous namespace
+
+
+void Connections::filterSegmentsByActivity(const vector<SynapseIdx> &numActiveConnected,
+                                           const SynapseIdx activationThreshold,
+                                           const vector<SynapseIdx> &numActivePotential,
+                                           const SynapseIdx matchingThreshold,
+                                           vector<Segment> &active,
+                                           vector<Segment> &matching) {
+  NTA_CHECK(numActiveConnected.size() == numActivePotential.size());
+  static_assert(sizeof(SynapseIdx) == 2, "SIMD kernels assume 16bit SynapseIdx");
+  active.clear();
+  matching.clear();
+  const size_t n = numActiveConnected.size();
+  const SynapseIdx *connected = numActiveConnected.data();
+  const SynapseIdx *potential = numActivePotential.data();
+
+  const size_t done = filterSegmentsSimd_()(connected, activationThreshold, potential, matchingThreshold,
+                                             n, active, matching);
+  filterSegmentsScalar_(connected, activationThreshold, potential, matchingThreshold, done, n, active, matching);
+}
+
+
+void Connections::PermanenceArray::push_back(const Permanence permanence) {
+  switch(precision) {
+    case PermanencePrecision::UINT16:
+      u16.push_back(permanence == -1.0f ? REMOVED16 : static_cast<UInt16>(level(permanence)));
+      break;
+    case PermanencePrecision::UINT8:
+      u8.push_back(permanence == -1.0f ? REMOVED8 : static_cast<uint8_t>(level(permanence)));
+      break;
+    default:
+      f32.push_back(permanence);
+  }
+}
+
+
+void Connections::PermanenceArray::clear() {
+  f32.clear();
+  u16.clear();
+  u8.clear();
+}
+
+
+void Connections::PermanenceArray::reserve(const size_t numSynapses) {
+  switch(precision) {
+    case PermanencePrecision::UINT16: u16.reserve(numSynapses); break;
+    case PermanencePrecision::UINT8:  u8.reserve(numSynapses);  break;
+    default:                          f32.reserve(numSynapses);
+  }
+}
+
+
+void Connections::PermanenceArray::setPrecision(const PermanencePrecision newPrecision) {
+  // keep the current values, in the old precision
+  vector<Permanence> values(size());
+  for(Synapse syn = 0; syn < values.size(); syn++) {
+    values[syn] = (*this)[syn];
+  }
+  clear();
+
+  switch(newPrecision) {
+    case PermanencePrecision::FLOAT32: steps = 1.0f; break;
+    case PermanencePrecision::UINT16:  steps = static_cast<Real32>(REMOVED16 - 1u); break;
+    case PermanencePrecision::UINT8:   steps = static_cast<Real32>(REMOVED8 - 1u);  break;
+    default: NTA_THROW << "Connections: unknown permanence precision " << static_cast<UInt>(newPrecision);
+  }
+  precision = newPrecision;
+  stepSize  = 1.0f / steps;
+  setConnectedThreshold(connectedThreshold);
+
+  reserve(values.size());
+  for(const auto value : values) {
+    push_back(value);
+  }
+}
+
+
+void Connections::PermanenceArray::setConnectedThreshold(const Permanence threshold) {
+  connectedThreshold = threshold;
+  if(precision == PermanencePrecision::FLOAT32) {
+    connectedLevel = 0u; //not used
+    return;
+  }
+  // lowest level whose (dequantized) permanence is >= threshold
+  const UInt32 maxLevel = static_cast<UInt32>(steps);
+  UInt32 lvl = level(threshold);
+  while(lvl > 0u and static_cast<Permanence>(lvl - 1u) * stepSize >= threshold) lvl--;
+  while(lvl < maxLevel and static_cast<Permanence>(lvl) * stepSize < threshold) lvl++;
+  connectedLevel = lvl;
+}
+
+
+namespace {
+// Bump a contiguous run of stored values and flag the ones whose connected
+// state changes. No branches, so the compiler vectorizes it.
+// `Value` is Real32 for FLOAT32 permanences, Int32 levels for the quantized ones.
+template<typename T, typename Value>
+void bumpRun_(T *values, const size_t n, const Value delta, const Value lo, const Value hi,
+              const Value threshold, uint8_t *crossed) {
+  for(size_t i = 0; i < n; i++) {
+    const Value before = static_cast<Value>(values[i]);
+    const Value after  = std::min(std::max(before + delta, lo), hi);
+    crossed[i] = static_cast<uint8_t>((before >= threshold) != (after >= threshold));
+    values[i]  = static_cast<T>(after);
+  }
+}
+
+// Same for synapses anywhere in the array.
+template<typename T, typename Value>
+void bumpGather_(T *values, const vector<Synapse> &synapses, const Value delta, const Value lo,
+                 const Value hi, const Value threshold, vector<Synapse> &crossed) {
+  for(const auto syn : synapses) {
+    const Value before = static_cast<Value>(values[syn]);
+    const Value after  = std::min(std::max(before + delta, lo), hi);
+    if((before >= threshold) != (after >= threshold)) crossed.push_back(syn);
+    values[syn] = static_cast<T>(after);
+  }
+}
+
+template<typename T, typename Value>
+void bumpValues_(T *values, const vector<Synapse> &synapses, const Value delta, const Value lo,
+                 const Value hi, const Value threshold, vector<uint8_t> &scratch, vector<Synapse> &crossed) {
+  // The synapses of a segment are created together, so usually they are one run
+  // of synapse indexes, in any order (nth_element sorts them in place).
+  // Being distinct, they are a run iff max - min + 1 == size.
+  const auto range = std::minmax_element(synapses.begin(), synapses.end());
+  const Synapse first = *range.first;
+  if(static_cast<size_t>(*range.second - first) + 1u != synapses.size()) {
+    bumpGather_(values, synapses, delta, lo, hi, threshold, crossed);
+    return;
+  }
+  scratch.resize(synapses.size());
+  bumpRun_(values + first, synapses.size(), delta, lo, hi, threshold, scratch.data());
+  for(size_t i = 0; i < scratch.size(); i++) {
+    if(scratch[i]) crossed.push_back(static_cast<Synapse>(first + i));
+  }
+}
+} // anonymous namespace
+
+
+void Connections::PermanenceArray::bump(const vector<Synapse> &synapses, const Permanence delta,
+                                        vector<uint8_t> &scratch, vector<Synapse> &crossed) {
+  if(synapses.empty()) return;
+  // The quantized values are levels; delta is whole steps, see quantizeDelta().
+  const Int32 levels = static_cast<Int32>(std::lround(delta * steps));
+  const Int32 maxLevel = static_cast<Int32>(steps);
+  const Int32 threshold = static_cast<Int32>(connectedLevel);
+  switch(precision) {
+    case PermanencePrecision::UINT16:
+      bumpValues_(u16.data(), synapses, levels, 0, maxLevel, threshold, scratch, crossed);
+      break;
+    case PermanencePrecision::UINT8:
+      bumpValues_(u8.data(), synapses, levels, 0, maxLevel, threshold, scratch, crossed);
+      break;
+    default:
+      bumpValues_(f32.data(), synapses, delta, minPermanence, maxPermanence, connectedThreshold, scratch, crossed);
+  }
+}
+
+
+bool Connections::PermanenceArray::operator==(const PermanenceArray &o) const {
+  return precision == o.precision and f32 == o.f32 and u16 == o.u16 and u8 == o.u8;
+}
+
+
+void Connections::SynapseArrays::clear() {
+  presynapticCell.clear();
+  permanence.clear();
+  segment.clear();
+  presynapticMapIndex.clear();
+  id.clear();
+}
+
+
+void Connections::SynapseArrays::reserve(const size_t numSynapses) {
+  presynapticCell.reserve(numSynapses);
+  permanence.reserve(numSynapses);
+  segment.reserve(numSynapses);
+  presynapticMapIndex.reserve(numSynapses);
+  id.reserve(numSynapses);
+}
+
+
+void Connections::SynapseArrays::push_back(const SynapseData &data) {
+  presynapticCell.push_back(data.presynapticCell);
+  permanence.push_back(data.permanence);
+  segment.push_back(data.segment);
+  presynapticMapIndex.push_back(data.presynapticMapIndex_);
+  id.push_back(data.id);
+}
+
+
+SynapseData Connections::SynapseArrays::operator[](const Synapse synapse) const {
+  NTA_ASSERT(synapse < size());
+  SynapseData data;
+  data.presynapticCell      = presynapticCell[synapse];
+  data.permanence           = permanence[synapse];
+  data.segment              = segment[synapse];
+  data.presynapticMapIndex_ = presynapticMapIndex[synapse];
+  data.id                   = id[synapse];
+  return data;
+}
+
+
+bool Connections::SynapseArrays::operator==(const SynapseArrays &o) const {
+  return presynapticCell     == o.presynapticCell and
+         permanence          == o.permanence and
+         segment             == o.segment and
+         presynapticMapIndex == o.presynapticMapIndex and
+         id                  == o.id;
+}
+
+
+void Connections::compact() {
+  Topology &topology = mutable_();
+  const Segment noSegment = std::numeric_limits<Segment>::max();
+  const Synapse noSynapse = std::numeric_limits<Synapse>::max();
+
+  // New order of the segments: by cell, on a cell in order of creation.
+  vector<Segment> newSegments(topology.segments.size(), noSegment);
+  ResourceVector<SegmentData> segments(topology.resource.get());
+  segments.reserve(topology.segments.size() - topology.destroyedSegments);
+  for(auto &cellData : topology.cells) {
+    for(auto &segment : cellData.segments) {
+      newSegments[segment] = static_cast<Segment>(segments.size());
+      segments.push_back(std::move(topology.segments[segment]));
+      segment = newSegments[segment];
+    }
+  }
+
+  // New order of the synapses: the synapses of a segment are next to each other.
+  vector<Synapse> newSynapses(topology.synapses.size(), noSynapse);
+  SynapseArrays synapses(topology.resource.get());
+  synapses.permanence.setPrecision(topology.synapses.permanence.precision);
+  synapses.permanence.setConnectedThreshold(connectedThreshold_);
+  synapses.reserve(topology.synapses.size() - topology.destroyedSynapses);
+  for(Segment segment = 0; segment < segments.size(); segment++) {
+    for(auto &synapse : segments[segment].synapses) {
+      SynapseData data = topology.synapses[synapse];
+      data.segment = segment;
+      newSynapses[synapse] = static_cast<Synapse>(synapses.size());
+      synapses.push_back(data);
+      synapse = newSynapses[synapse];
+    }
+  }
+  topology.segments.swap(segments);
+  std::swap(topology.synapses, synapses);
+  topology.destroyedSegments = 0;
+  topology.destroyedSynapses = 0;
+
+  // Rebuild the presynaptic maps, segments in each list are then in ascending order.
+  topology.potentialSynapsesForPresynapticCell.clear();
+  topology.connectedSynapsesForPresynapticCell.clear();
+  topology.potentialSegmentsForPresynapticCell.clear();
+  topology.connectedSegmentsForPresynapticCell.clear();
+  for(Synapse synapse = 0; synapse < topology.synapses.size(); synapse++) {
+    const CellIdx presyn = topology.synapses.presynapticCell[synapse];
+    const bool connected = topology.synapses.permanence.isConnected(synapse);
+    auto &presynSynapses = connected ? topology.connectedSynapsesForPresynapticCell[presyn] : topology.potentialSynapsesForPresynapticCell[presyn];
+    auto &presynSegments = connected ? topology.connectedSegmentsForPresynapticCell[presyn] : topology.potentialSegmentsForPresynapticCell[presyn];
+    topology.synapses.presynapticMapIndex[synapse] = static_cast<Synapse>(presynSynapses.size());
+    presynSynapses.push_back(synapse);
+    presynSegments.push_back(topology.synapses.segment[synapse]);
+  }
+  topology.connectedFlatIndex.valid = false;
+  topology.potentialFlatIndex.valid = false;
+
+  // timeseries: the updates are per synapse
+  for(auto *updates : {&previousUpdates_, &currentUpdates_}) {
+    if(updates->empty()) continue;
+    std::unordered_map<Synapse, Permanence, identity> remapped;
+    remapped.reserve(updates->size());
+    for(const auto &update : *updates) {
+      if(update.first < newSynapses.size() and newSynapses[update.first] != noSynapse) {
+        remapped[newSynapses[update.first]] = update.second;
+      }
+    }
+    updates->swap(remapped);
+  }
+
+  notify_(ConnectionsChange::COMPACT, 0u, 0.0f,
+          [&](ConnectionsEventHandler *h) { h->onCompact(newSegments, newSynapses); });
+}
+
+
+std::pair<size_t, size_t> Connections::prune(const Permanence minPermanence, const UInt32 maxSegmentAge,
+                                             const bool destroyEmptySegments) {
+  const size_t synapsesBefore = numSynapses();
+  const size_t segmentsBefore = numSegments();
+  vector<Segment> segments;
+  vector<Synapse> synapses;
+  for(CellIdx cell = 0; cell < numCells(); cell++) {
+    segments = segmentsForCell(cell); //copy, destroying changes the list
+    for(const Segment segment : segments) {
+      if(maxSegmentAge > 0u and iteration_ - dataForSegment(segment).lastUsed > maxSegmentAge) {
+        destroySegment(segment);
+        continue;
+      }
+      synapses = synapsesForSegment(segment);
+      for(const Synapse synapse : synapses) {
+        if(topology_->synapses.permanence[synapse] < minPermanence) destroySynapse(synapse);
+      }
+      if(destroyEmptySegments and synapsesForSegment(segment).empty()) destroySegment(segment);
+    }
+  }
+  compact();
+  for(auto &segmentData : mutable_().segments) segmentData.synapses.shrink_to_fit();
+  return {synapsesBefore - numSynapses(), segmentsBefore - numSegments()};
+}
+
+
+void Connections::setCompactThreshold(const Real fraction) {
+  NTA_CHECK(fraction >= 0.0f and fraction <= 1.0f) << "Connections: compact threshold must be within [0, 1], got " << fraction;
+  compactThreshold_ = fraction;
+}
+
+
+void Connections::setSegmentEviction(const SegmentEviction policy, const UInt sampleSize, const UInt64 seed) {
+  NTA_CHECK(sampleSize > 0u) << "Connections: segment eviction needs a sample size of at least 1.";
+  segmentEviction_    = policy;
+  evictionSampleSize_ = sampleSize;
+  evictionRng_        = Random(seed);
+}
+
+
+void Connections::setPermanencePrecision(const PermanencePrecision precision) {
+  Topology &topology = mutable_();
+  PermanenceArray &permanences = topology.synapses.permanence;
+  vector<bool> wasConnected(permanences.size());
+  for(Synapse syn = 0; syn < wasConnected.size(); syn++) {
+    wasConnected[syn] = permanences.isConnected(syn);
+  }
+  permanences.setPrecision(precision);
+
+  // Rounding to the new steps can move a permanence across the connected
+  // threshold, such synapses move between the presynaptic maps.
+  bool reconnected = false;
+  for(Synapse syn = 0; syn < wasConnected.size(); syn++) {
+    const bool connected = permanences.isConnected(syn);
+    if(connected == wasConnected[syn]) continue;
+    reconnectSynapse_(syn, connected, permanences[syn]);
+    reconnected = true;
+  }
+  if(reconnected) {
+    topology.connectedFlatIndex.valid = false; //rebuilt lazily, if used
+    topology.potentialFlatIndex.valid = false;
+  }
+  // previousUpdates_ / currentUpdates_ are kept, they are (unquantized) deltas
+}
+
+
+void Connections::setFlatIndex(const bool enable) {
+  Topology &topology = mutable_();
+  useFlatIndex_ = enable;
+  topology.connectedFlatIndex.clear();
+  topology.potentialFlatIndex.clear();
+}
+
+
+MemoryUsage Connections::memoryUsage() const {
+  const Topology &topology = *topology_;
+  MemoryUsage usage;
+  usage["cells"] = memory::bytes(topology.cells);
+  for(const auto &cell : topology.cells) usage["cells"] += memory::bytes(cell.segments);
+  usage["segments"] = memory::bytes(topology.segments);
+  for(const auto &segment : topology.segments) usage["segments"] += memory::bytes(segment.synapses);
+  const SynapseArrays &synapses = topology.synapses;
+  usage["synapses"] = memory::bytes(synapses.presynapticCell) + memory::bytes(synapses.permanence.f32) +
+                      memory::bytes(synapses.permanence.u16) + memory::bytes(synapses.permanence.u8) +
+                      memory::bytes(synapses.segment) + memory::bytes(synapses.presynapticMapIndex) +
+                      memory::bytes(synapses.id);
+  usage["presynapticMaps"] = memory::bytes(topology.potentialSynapsesForPresynapticCell) +
+                             memory::bytes(topology.connectedSynapsesForPresynapticCell) +
+                             memory::bytes(topology.potentialSegmentsForPresynapticCell) +
+                             memory::bytes(topology.connectedSegmentsForPresynapticCell);
+  usage["flatIndex"] = 0u;
+  for(const FlatIndex *index : {&topology.connectedFlatIndex, &topology.potentialFlatIndex}) {
+    usage["flatIndex"] += memory::bytes(index->begin) + memory::bytes(index->size) + memory::bytes(index->segments);
+  }
+  usage["caches"] = memory::bytes(bumpScratch_) + memory::bytes(bumpCrossed_) +
+                    memory::bytes(competitionScratch_) + memory::bytes(growCandidates_) +
+                    memory::bytes(growMask_) + memory::bytes(growNew_) + memory::bytes(partialCounts_) +
+                    memory::bytes(previousUpdates_) + memory::bytes(currentUpdates_);
+  return usage;
+}
+
+
+void Connections::shareFrom(Connections &other) {
+  if(&other == this) return;
+  other.prepareFlatIndex_(true);
+  other.prepareFlatIndex_(false);
+
+  auto eventHandlers = std::move(eventHandlers_);
+  const UInt32 nextEventToken = nextEventToken_;
+  const bool changeLogEnabled = changeLogEnabled_;
+  auto changeLog = std::move(changeLog_);
+  const bool trackChangedSegments = trackChangedSegments_;
+  auto threadPool = std::move(threadPool_);
+  auto budget = std::move(budget_);
+  auto budgetMember = std::move(budgetMember_);
+  const bool budgetDestroysSegments = budgetDestroysSegments_;
+
+  *this = other; //shares the topology_
+  eventHandlers_ = std::move(eventHandlers);
+  nextEventToken_ = nextEventToken;
+  changeLogEnabled_ = changeLogEnabled;
+  changeLog_ = std::move(changeLog);
+  setTrackChangedSegments(trackChangedSegments);
+  allSegmentsChanged_ = trackChangedSegments;
+  threadPool_ = std::move(threadPool);
+  budget_ = std::move(budget);
+  budgetMember_ = std::move(budgetMember);
+  budgetDestroysSegments_ = budgetDestroysSegments;
+  budgetPrunedSynapses_ = 0u;
+  partialCounts_.clear();
+  updateObserved_();
+}
+
+
+void Connections::FlatIndex::build(const std::unordered_map<CellIdx, vector<Segment>, identity> &segmentsForPresynapticCell) {
+  size_t rows = 0;
+  for(const auto &row : segmentsForPresynapticCell) {
+    rows = std::max(rows, static_cast<size_t>(row.first) + 1u);
+  }
+  // Reserve some spare room in each row, so the common small changes
+  // (a synapse connecting, a new synapse) can be patched in place.
+  const auto capacity = [](const size_t n) { return n + n / 4u + 2u; };
+
+  size.assign(rows, 0);
+  for(const auto &row : segmentsForPresynapticCell) {
+    size[row.first] = static_cast<UInt32>(row.second.size());
+  }
+  begin.resize(rows + 1u);
+  size_t total = 0;
+  for(size_t cell = 0; cell < rows; cell++) {
+    begin[cell] = static_cast<UInt32>(total);
+    total += capacity(size[cell]);
+  }
+  NTA_CHECK(total < std::numeric_limits<UInt32>::max()) << "Connections flat index: too many synapses.";
+  begin[rows] = static_cast<UInt32>(total);
+
+  segments.resize(total);
+  for(const auto &row : segmentsForPresynapticCell) {
+    std::copy(row.second.cbegin(), row.second.cend(), segments.begin() + begin[row.first]);
+  }
+  valid = true;
+}
+
+
+void Connections::FlatIndex::insert(const CellIdx cell, const Segment segment) {
+  if(not valid) return;
+  if(cell >= size.size() or begin[cell] + size[cell] == begin[cell + 1]) {
+    valid = false; //no room, rebuild on next use
+    return;
+  }
+  segments[begin[cell] + size[cell]++] = segment;
+}
+
+
+void Connections::FlatIndex::erase(const CellIdx cell, const Synapse index, const Segment segment) {
+  if(not valid) return;
+  NTA_ASSERT(cell < size.size());
+  NTA_ASSERT(index < size[cell]);
+  Segment *first = segments.data() + begin[cell];
+  NTA_ASSERT(first[index] == segment) << "Connections flat index out of sync.";
+  UNUSED(segment);
+  first[index] = first[size[cell] - 1u]; //same swap-remove as removeSynapseFromPresynapticMap_
+  size[cell]--;
+}
+
+
+void Connections::FlatIndex::clear() {
+  valid = false;
+  begin.clear();
+  size.clear();
+  segments.clear();
+}
+
+
+namespace {
+// Larger inputs are not expanded to a dense array of their size for learning.
+constexpr UInt DENSE_INPUT_LIMIT = 1u << 20;
+
+// The dense inputs, or nullptr if they are huge: then isInput_() looks the
+// cells up in the formats the SDR already has, see SDR::contains().
+const ElemDense *denseInputs_(const SDR &inputs) {
+  if(inputs.size <= DENSE_INPUT_LIMIT) return inputs.getDense().data();
+  inputs.getSparse(); //so contains() never converts, also when called by several threads
+  return nullptr;
+}
+
+inline bool isInput_(const SDR &inputs, const ElemDense *inputArray, const CellIdx cell) {
+  return inputArray != nullptr ? inputArray[cell] != 0 : inputs.contains(cell);
+}
+} // anonymous namespace
+
+
 void Connections::adaptSegment(const Segment segment, 
                                const SDR &inputs,
                                const Permanence increment,
@@ -482,19 +1692,90 @@ void Connections::adaptSegment(const Segment segment,
 			       const bool pruneZeroSynapses, 
 			       const UInt segmentThreshold)
 {
-  const auto &inputArray = inputs.getDense();
+  HTM_PROBE("Connections::adaptSegment");
+  mutable_(); //own the topology before reading it, the calls below change it
+  const ElemDense *inputArray = denseInputs_(inputs);
 
-  if( timeseries_ ) {
-    previousUpdates_.resize( synapses_.size(), minPermanence );
-    currentUpdates_.resize(  synapses_.size(), minPermanence );
+  vector<Synapse> destroyLater;
+  adaptSegmentSynapses_(segment, inputs, inputArray, increment, decrement, pruneZeroSynapses, destroyLater);
+
+  //destroy synapses accumulated for pruning
+  for(const auto pruneSyn : destroyLater) {
+    destroySynapse(pruneSyn);
   }
 
+  //destroy segment if it has too few synapses left -> will never be able to connect again
+  #ifdef NTA_ASSERTIONS_ON
+  if(segmentThreshold > 0) {
+    NTA_ASSERT(pruneZeroSynapses) << "Setting segmentThreshold only makes sense when pruneZeroSynapses is allowed.";
+  }
+  #endif
+  if(pruneZeroSynapses and synapsesForSegment(segment).size() < segmentThreshold) { 
+    destroySegment(segment);
+    prunedSegs_++; //statistics
+  }
+}
+
+
+void Connections::adaptSegments(const vector<Segment> &segments,
+                                const SDR &inputs,
+                                const Permanence increment,
+                                const Permanence decrement,
+                                const bool pruneZeroSynapses,
+                                const UInt segmentThreshold)
+{
+  mutable_(); //own the topology before reading it, the calls below change it
+  #ifdef NTA_ASSERTIONS_ON
+  if(segmentThreshold > 0) {
+    NTA_ASSERT(pruneZeroSynapses) << "Setting segmentThreshold only makes sense when pruneZeroSynapses is allowed.";
+  }
+  #endif
+  if(segments.empty()) return;
+  const ElemDense *inputArray = denseInputs_(inputs);
+
+  // segments are independent, process them in memory order
+  const vector<Segment> *ordered = &segments;
+  vector<Segment> sorted;
+  if(not std::is_sorted(segments.cbegin(), segments.cend())) {
+    sorted = segments;
+    std::sort(sorted.begin(), sorted.end());
+    ordered = &sorted;
+  }
+  NTA_ASSERT(std::adjacent_find(ordered->cbegin(), ordered->cend()) == ordered->cend())
+    << "adaptSegments: duplicate segment";
+
   vector<Synapse> destroyLater;
+  for(const auto segment : *ordered) {
+    adaptSegmentSynapses_(segment, inputs, inputArray, increment, decrement, pruneZeroSynapses, destroyLater);
+  }
+  if(not pruneZeroSynapses) return;
+
+  for(const auto pruneSyn : destroyLater) {
+    destroySynapse(pruneSyn);
+  }
+  for(const auto segment : *ordered) {
+    if(synapsesForSegment(segment).size() < segmentThreshold) {
+      destroySegment(segment);
+      prunedSegs_++; //statistics
+    }
+  }
+}
+
+
+void Connections::adaptSegmentSynapses_(const Segment segment,
+                                        const SDR &inputs,
+                                        const ElemDense *inputArray,
+                                        const Permanence increment,
+                                        const Permanence decrement,
+                                        const bool pruneZeroSynapses,
+                                        vector<Synapse> &destroyLater)
+{
+  Topology &topology = mutable_();
   for(const auto synapse: synapsesForSegment(segment)) {
-      const SynapseData &synapseData = dataForSynapse(synapse);
+      const Permanence permanence = topology.synapses.permanence[synapse];
 
       Permanence update;
-      if( inputArray[synapseData.presynapticCell] ) {
+      if( isInput_(inputs, inputArray, topology.synapses.presynapticCell[synapse]) ) {
         update = increment;
       } else {
         update = -decrement;
@@ -502,7 +1783,7 @@ void Connections::adaptSegment(const Segment segment,
 
     //prune permanences that reached zero
     if (pruneZeroSynapses and 
-        synapseData.permanence + update < htm::minPermanence + htm::Epsilon) { //new value will disconnect the synapse
+        permanence + update < htm::minPermanence + htm::Epsilon) { //new value will disconnect the synapse
       destroyLater.push_back(synapse);
       prunedSyns_++; //for statistics
       continue;
@@ -510,28 +1791,99 @@ void Connections::adaptSegment(const Segment segment,
 
     //update synapse, but for TS only if changed
     if(timeseries_) {
-      if( update != previousUpdates_[synapse] ) {
-        updateSynapsePermanence(synapse, synapseData.permanence + update);
+      if( update != previousUpdate_(synapse) ) {
+        updateSynapsePermanence(synapse, permanence + update);
       }
       currentUpdates_[ synapse ] = update;
     } else {
-      updateSynapsePermanence(synapse, synapseData.permanence + update);
+      updateSynapsePermanence(synapse, permanence + update);
     }
   }
+}
 
-  //destroy synapses accumulated for pruning
-  for(const auto pruneSyn : destroyLater) {
-    destroySynapse(pruneSyn);
+
+void Connections::prepareAdaptSegments(vector<SegmentAdaptation> &adaptations,
+                                       const SDR &inputs,
+                                       const bool pruneZeroSynapses)
+{
+  Topology &topology = mutable_();
+  if(adaptations.empty()) return;
+  const ElemDense *inputArray = denseInputs_(inputs);
+
+  // Each task writes only the permanences of its own segments' synapses, so
+  // the tasks don't share any data. The timeseries updates are collected per
+  // adaptation and stored afterwards, on this thread.
+  const auto adaptRange = [&](const size_t begin, const size_t end) {
+    for(size_t i = begin; i < end; i++) {
+      auto &adaptation = adaptations[i];
+      adaptation.crossing.clear();
+      adaptation.prune.clear();
+      adaptation.updates.clear();
+
+      for(const auto synapse: synapsesForSegment(adaptation.segment)) {
+        const Permanence permanence = topology.synapses.permanence[synapse];
+        const Permanence update = isInput_(inputs, inputArray, topology.synapses.presynapticCell[synapse]) ?
+                                  adaptation.increment : -adaptation.decrement;
+
+        if (pruneZeroSynapses and
+            permanence + update < htm::minPermanence + htm::Epsilon) {
+          adaptation.prune.push_back(synapse);
+          continue;
+        }
+        if(timeseries_) {
+          adaptation.updates.emplace_back(synapse, update);
+          if(update == previousUpdate_(synapse)) continue;
+        }
+
+        // same as updateSynapsePermanence(), unless the connected state changes
+        const Permanence clipped = std::min(std::max(permanence + update, minPermanence), maxPermanence);
+        const Permanence stored  = topology.synapses.permanence.quantize(clipped);
+        if(topology.synapses.permanence.isConnected(synapse) == topology.synapses.permanence.isConnectedValue(stored)) {
+          topology.synapses.permanence.set(synapse, stored);
+        } else {
+          adaptation.crossing.emplace_back(synapse, permanence + update);
+        }
+      }
+    }
+  };
+
+  const size_t numTasks = threadPool_ == nullptr ? 1u :
+                          std::min(adaptations.size(), threadPool_->size() * 4u);
+  if(numTasks <= 1u) {
+    adaptRange(0u, adaptations.size());
+  } else {
+    threadPool_->parallelFor(numTasks, [&](const size_t task) {
+      adaptRange(adaptations.size() * task / numTasks,
+                 adaptations.size() * (task + 1u) / numTasks);
+    });
+  }
+  if(timeseries_) {
+    for(const auto &adaptation : adaptations) {
+      for(const auto &update : adaptation.updates) currentUpdates_[update.first] = update.second;
+    }
   }
+}
 
-  //destroy segment if it has too few synapses left -> will never be able to connect again
+
+void Connections::finishAdaptSegment(const SegmentAdaptation &adaptation,
+                                     const bool pruneZeroSynapses,
+                                     const UInt segmentThreshold)
+{
+  mutable_(); //own the topology before reading it, the calls below change it
   #ifdef NTA_ASSERTIONS_ON
   if(segmentThreshold > 0) {
     NTA_ASSERT(pruneZeroSynapses) << "Setting segmentThreshold only makes sense when pruneZeroSynapses is allowed.";
   }
   #endif
-  if(pruneZeroSynapses and synapsesForSegment(segment).size() < segmentThreshold) { 
-    destroySegment(segment);
+  for(const auto &update : adaptation.crossing) {
+    updateSynapsePermanence(update.first, update.second);
+  }
+  prunedSyns_ += static_cast<Synapse>(adaptation.prune.size()); //statistics
+  for(const auto pruneSyn : adaptation.prune) {
+    destroySynapse(pruneSyn);
+  }
+  if(pruneZeroSynapses and synapsesForSegment(adaptation.segment).size() < segmentThreshold) {
+    destroySegment(adaptation.segment);
     prunedSegs_++; //statistics
   }
 }
@@ -546,11 +1898,12 @@ void Connections::raisePermanencesToThreshold(
                   const Segment    segment,
                   const UInt       segmentThreshold)
 {
+  Topology &topology = mutable_();
   if( segmentThreshold == 0 ) // No synapses requested to be connected, done.
     return;
 
-  NTA_ASSERT(segment < segments_.size()) << "Accessing segment out of bounds.";
-  auto &segData = segments_[segment];
+  NTA_ASSERT(segment < topology.segments.size()) << "Accessing segment out of bounds.";
+  auto &segData = topology.segments[segment];
   if( segData.numConnected >= segmentThreshold )
     return;   // The segment already satisfies the requirement, done.
 
@@ -580,11 +1933,11 @@ void Connections::raisePermanencesToThreshold(
   auto minPermSynPtr = synapses.begin() + threshold - 1;
 
   const auto permanencesGreater = [&](const Synapse &A, const Synapse &B)
-    { return synapses_[A].permanence > synapses_[B].permanence; };
+    { return topology.synapses.permanence[A] > topology.synapses.permanence[B]; };
   // Do a partial sort, it's faster than a full sort.
   std::nth_element(synapses.begin(), minPermSynPtr, synapses.end(), permanencesGreater);
 
-  const Real increment = connectedThreshold_ - synapses_[ *minPermSynPtr ].permanence;
+  const Real increment = connectedThreshold_ - topology.synapses.permanence[ *minPermSynPtr ];
   if( increment <= 0 ) // If minPermSynPtr is already connected then ...
     return;            // Enough synapses are already connected.
 
@@ -598,6 +1951,7 @@ void Connections::synapseCompetition(
                     const SynapseIdx minimumSynapses,
                     const SynapseIdx maximumSynapses)
 {
+  Topology &topology = mutable_();
   NTA_ASSERT( minimumSynapses <= maximumSynapses);
   NTA_ASSERT( maximumSynapses > 0 );
 
@@ -631,9 +1985,10 @@ void Connections::synapseCompetition(
   //   Corner case: there are no synapses on this segment.
   // }
 
-  vector<Permanence> permanences; permanences.reserve( segData.synapses.size() );
+  auto &permanences = competitionScratch_;
+  permanences.clear();
   for( Synapse syn : segData.synapses )
-    permanences.push_back( synapses_[syn].permanence );
+    permanences.push_back( topology.synapses.permanence[syn] );
 
   // Do a partial sort, it's faster than a full sort.
   auto minPermPtr = permanences.begin() + (segData.synapses.size() - 1 - desiredConnected);
@@ -646,10 +2001,16 @@ void Connections::synapseCompetition(
 }
 
 
-void Connections::bumpSegment(const Segment segment, const Permanence delta) {
-  // TODO: vectorize?
-  for( const auto syn : synapsesForSegment(segment) ) {
-    updateSynapsePermanence(syn, synapses_[syn].permanence + delta);
+void Connections::bumpSegment(const Segment segment, Permanence delta) {
+  Topology &topology = mutable_();
+  delta = topology.synapses.permanence.quantizeDelta(delta); //whole steps, so the bump is not rounded away
+  if( delta == 0.0f ) return;
+  // Same as updateSynapsePermanence() for each synapse, but only the few
+  // synapses which cross the connected threshold touch the presynaptic maps.
+  bumpCrossed_.clear();
+  topology.synapses.permanence.bump(synapsesForSegment(segment), delta, bumpScratch_, bumpCrossed_);
+  for( const auto syn : bumpCrossed_ ) {
+    reconnectSynapse_(syn, topology.synapses.permanence.isConnected(syn), topology.synapses.permanence[syn]);
   }
 }
 
@@ -657,8 +2018,7 @@ void Connections::bumpSegment(const Segment segment, const Permanence delta) {
 vector<CellIdx> Connections::presynapticCellsForSegment(const Segment segment) const { //TODO optimize by storing the vector in SegmentData?
   set<CellIdx> presynCells;
   for(const auto synapse: synapsesForSegment(segment)) {
-    const auto presynapticCell = dataForSynapse(synapse).presynapticCell;
-    presynCells.insert(presynapticCell);
+    presynCells.insert(topology_->synapses.presynapticCell[synapse]);
   }
   return vector<CellIdx>(std::begin(presynCells), std::end(presynCells));
 }
@@ -669,10 +2029,11 @@ void Connections::destroyMinPermanenceSynapses(
 			      const size_t nDestroy,
                               const vector<CellIdx> &excludeCells)
 {
+  Topology &topology = mutable_();
   // Don't destroy any cells that are in excludeCells.
   vector<Synapse> destroyCandidates;
   for( Synapse synapse : synapsesForSegment(segment)) {
-    const CellIdx presynapticCell = dataForSynapse(synapse).presynapticCell;
+    const CellIdx presynapticCell = topology.synapses.presynapticCell[synapse];
 
     if( not std::binary_search(excludeCells.cbegin(), excludeCells.cend(), presynapticCell)) {
       destroyCandidates.push_back(synapse);
@@ -680,8 +2041,8 @@ void Connections::destroyMinPermanenceSynapses(
   }
 
   const auto comparePermanences = [&](const Synapse A, const Synapse B) {
-    const Permanence A_perm = dataForSynapse(A).permanence;
-    const Permanence B_perm = dataForSynapse(B).permanence;
+    const Permanence A_perm = topology.synapses.permanence[A];
+    const Permanence B_perm = topology.synapses.permanence[B];
     if( A_perm == B_perm ) {
       return A < B;
     }
@@ -705,9 +2066,25 @@ void Connections::growSynapses(const Segment segment,
 					  Random& rng,
 					  const size_t maxNew,
 					  const size_t maxSynapsesPerSegment) {
+  static const vector<CellIdx> noCells;
+  growSynapses(segment, growthCandidates, noCells, 0u, initialPermanence, rng, maxNew, maxSynapsesPerSegment);
+}
+
 
-  //0. copy input vector - candidate cells on input
-  vector<CellIdx> candidates(growthCandidates.begin(), growthCandidates.end());
+void Connections::growSynapses(const Segment segment,
+                               const vector<CellIdx>& growthCandidates,
+                               const vector<CellIdx>& externalCandidates,
+                               const CellIdx externalOffset,
+                               const Permanence initialPermanence,
+                               Random& rng,
+                               const size_t maxNew,
+                               const size_t maxSynapsesPerSegment) {
+  mutable_(); //own the topology before reading it, the calls below change it
+
+  //0. copy input vector - candidate cells on input, it is shuffled below
+  vector<CellIdx> &candidates = growCandidates_;
+  candidates.assign(growthCandidates.begin(), growthCandidates.end());
+  for(const CellIdx cell : externalCandidates) candidates.push_back(cell + externalOffset);
 
   //1. figure the number of new synapses to grow
   size_t nActual = std::min(maxNew, candidates.size());
@@ -724,16 +2101,312 @@ void Connections::growSynapses(const Segment segment,
   }
   if(nActual == 0) return;
 
-  //2. Pick nActual cells randomly.
-  if(maxNew > 0 and maxNew < candidates.size()) {
-    rng.shuffle(candidates.begin(), candidates.end());
+  //2. Mark the presynaptic cells on the segment in a bitmap, so that the
+  //   candidates are checked for duplicates without scanning the segment.
+  //   Huge cell indexes are not mapped, those are looked up the slow way.
+  Topology &topology = mutable_();
+  const auto mapped = [&](const CellIdx cell) { return cell < GROW_MASK_CELLS; };
+  const auto marked = [&](const CellIdx cell) {
+    return (growMask_[cell / 64u] >> (cell % 64u)) & 1u;
+  };
+  const auto mark = [&](const CellIdx cell) {
+    const size_t word = cell / 64u;
+    if(word >= growMask_.size()) growMask_.resize(word + 1u, 0u);
+    growMask_[word] |= UInt64(1u) << (cell % 64u);
+  };
+  for(const Synapse synapse : topology.segments[segment].synapses) {
+    const CellIdx cell = topology.synapses.presynapticCell[synapse];
+    if(mapped(cell)) mark(cell);
   }
-  const size_t nDesired = numSynapses(segment) + nActual; //num synapses on seg after this function (+-), see #COND
-  for (const auto syn : candidates) {
+
+  //3. Pick nActual new cells randomly: from all candidates shuffled, or one
+  //   at a time (partial Fisher-Yates) so only the candidates which are tried
+  //   cost a random number, see setSampledGrowth(). A cell which is on the
+  //   segment already keeps the larger of the permanences, as with createSynapse().
+  const bool pickRandomly = maxNew > 0 and maxNew < candidates.size();
+  if(pickRandomly and not sampledGrowth_) rng.shuffle(candidates.begin(), candidates.end());
+  vector<CellIdx> &newCells = growNew_;
+  newCells.clear();
+  for (size_t i = 0; i < candidates.size(); i++) {
     // #COND: this loop finishes two folds: a) we ran out of candidates (above), b) we grew the desired number of new synapses (below)
-    if(numSynapses(segment) == nDesired) break;
-    createSynapse(segment, syn, initialPermanence); //TODO createSynapse consider creating a vector of new synapses at once?
+    if(newCells.size() == nActual) break;
+    if(pickRandomly and sampledGrowth_) rng.sampleInPlace(candidates.begin() + i, candidates.end(), 1u);
+    const CellIdx cell = candidates[i];
+    if(not mapped(cell) or (cell / 64u < growMask_.size() and marked(cell))) {
+      bool found = false;
+      for(const Synapse synapse : topology.segments[segment].synapses) {
+        if(topology.synapses.presynapticCell[synapse] != cell) continue;
+        if(initialPermanence > topology.synapses.permanence[synapse]) updateSynapsePermanence(synapse, initialPermanence);
+        found = true;
+        break;
+      }
+      if(found) continue;
+      if(mapped(cell) or std::find(newCells.cbegin(), newCells.cend(), cell) != newCells.cend()) continue; //picked already
+    }
+    if(mapped(cell)) mark(cell);
+    newCells.push_back(cell);
+  }
+
+  //4. Insert the new synapses at once. They are created as createSynapse()
+  //   would, so the result is the same; observers are told about each one.
+  SegmentData &segmentData = topology.segments[segment];
+  for(const Synapse synapse : segmentData.synapses) { //unmark, for the next call
+    const CellIdx cell = topology.synapses.presynapticCell[synapse];
+    if(mapped(cell) and cell / 64u < growMask_.size()) growMask_[cell / 64u] = 0u;
+  }
+  for(const CellIdx cell : newCells) {
+    if(mapped(cell)) growMask_[cell / 64u] = 0u;
+  }
+  if(observed_) {
+    for(const CellIdx cell : newCells) createSynapse_(segment, cell, initialPermanence);
+    return;
+  }
+
+  NTA_ASSERT(topology.synapses.size() + newCells.size() < std::numeric_limits<Synapse>::max())
+    << "Add synapse failed: Range of Synapse (data-type) insufficient size.";
+  Permanence permanence = std::min(std::max(initialPermanence, minPermanence), maxPermanence);
+  permanence = topology.synapses.permanence.quantize(permanence);
+  const bool connected = topology.synapses.permanence.isConnectedValue(permanence);
+  for(const CellIdx cell : newCells) {
+    const Synapse synapse = static_cast<Synapse>(topology.synapses.size());
+    SynapseData data;
+    data.presynapticCell = cell;
+    data.segment         = segment;
+    data.id              = topology.nextSynapseOrdinal++;
+    data.permanence      = permanence;
+    // createSynapse() adds every presynaptic cell to the potential maps
+    auto &potentialSynapses = topology.potentialSynapsesForPresynapticCell[cell];
+    auto &potentialSegments = topology.potentialSegmentsForPresynapticCell[cell];
+    if(connected) {
+      auto &connectedSynapses = topology.connectedSynapsesForPresynapticCell[cell];
+      data.presynapticMapIndex_ = static_cast<Synapse>(connectedSynapses.size());
+      connectedSynapses.push_back(synapse);
+      topology.connectedSegmentsForPresynapticCell[cell].push_back(segment);
+      if(useFlatIndex_) topology.connectedFlatIndex.insert(cell, segment);
+      segmentData.numConnected++;
+    } else {
+      data.presynapticMapIndex_ = static_cast<Synapse>(potentialSynapses.size());
+      potentialSynapses.push_back(synapse);
+      potentialSegments.push_back(segment);
+      if(useFlatIndex_) topology.potentialFlatIndex.insert(cell, segment);
+    }
+    topology.synapses.push_back(data);
+    segmentData.synapses.push_back(synapse);
+  }
+}
+
+
+namespace {
+// nested vectors are stored as one flat array of the values and UInt64 offsets (size + 1)
+template<typename Outer, typename A, typename Get>
+void writeNested(CheckpointWriter &writer, const string &name, const vector<Outer, A> &outer, Get get) {
+  using Value = typename std::decay<decltype(get(outer.front()))>::type::value_type;
+  vector<UInt64> offsets;
+  offsets.reserve(outer.size() + 1u);
+  offsets.push_back(0u);
+  for(const auto &o : outer) offsets.push_back(offsets.back() + get(o).size());
+  vector<Value> values;
+  values.reserve(static_cast<size_t>(offsets.back()));
+  for(const auto &o : outer) values.insert(values.end(), get(o).begin(), get(o).end());
+  writer.write(name + ".offsets", offsets);
+  writer.write(name, values);
+}
+
+template<typename Value>
+std::pair<const Value*, const UInt64*> viewNested(const CheckpointReader &reader, const string &name, const size_t size) {
+  const auto offsets = reader.view<UInt64>(name + ".offsets");
+  const auto values  = reader.view<Value>(name);
+  NTA_CHECK(offsets.second == size + 1u and offsets.first[size] == values.second)
+    << "Connections checkpoint: section " << name << " is inconsistent";
+  return {values.first, offsets.first};
+}
+
+template<typename Map>
+void writeMap(CheckpointWriter &writer, const string &name, const Map &map) {
+  vector<CellIdx> keys;
+  keys.reserve(map.size());
+  vector<typename Map::mapped_type> rows;
+  rows.reserve(map.size());
+  for(const auto &kv : map) {
+    keys.push_back(kv.first);
+    rows.push_back(kv.second);
+  }
+  writer.write(name + ".keys", keys);
+  writeNested(writer, name, rows, [](const typename Map::mapped_type &row) -> const typename Map::mapped_type & { return row; });
+}
+
+template<typename Map>
+void readMap(const CheckpointReader &reader, const string &name, Map &map) {
+  using Value = typename Map::mapped_type::value_type;
+  const auto keys = reader.view<CellIdx>(name + ".keys");
+  const auto rows = viewNested<Value>(reader, name, keys.second);
+  map.clear();
+  map.reserve(keys.second);
+  for(size_t i = 0; i < keys.second; i++) {
+    map[keys.first[i]].assign(rows.first + rows.second[i], rows.first + rows.second[i + 1u]);
+  }
+}
+} // namespace
+
+
+void Connections::saveCheckpointScalars_(CheckpointWriter &writer, const string &prefix) const {
+  writer.writeValue(prefix + "connectedThreshold", connectedThreshold_);
+  writer.writeValue(prefix + "iteration", iteration_);
+  writer.writeValue(prefix + "destroyedSynapses", static_cast<UInt64>(topology_->destroyedSynapses));
+  writer.writeValue(prefix + "destroyedSegments", static_cast<UInt64>(topology_->destroyedSegments));
+  writer.writeValue(prefix + "nextSegmentOrdinal", topology_->nextSegmentOrdinal);
+  writer.writeValue(prefix + "nextSynapseOrdinal", topology_->nextSynapseOrdinal);
+  writer.writeValue(prefix + "timeseries", static_cast<uint8_t>(timeseries_));
+  writer.writeValue(prefix + "prunedSynapses", prunedSyns_);
+  writer.writeValue(prefix + "prunedSegments", prunedSegs_);
+  for(const auto &updates : {std::make_pair("previousUpdates", &previousUpdates_),
+                             std::make_pair("currentUpdates", &currentUpdates_)}) {
+    vector<Synapse> synapses;
+    vector<Permanence> values;
+    for(const auto &update : *updates.second) {
+      synapses.push_back(update.first);
+      values.push_back(update.second);
+    }
+    writer.write(prefix + updates.first + ".synapses", synapses);
+    writer.write(prefix + updates.first + ".values", values);
+  }
+  writer.writeValue(prefix + "numCells", static_cast<UInt64>(topology_->cells.size()));
+  writer.writeValue(prefix + "numSegments", static_cast<UInt64>(topology_->segments.size()));
+  writer.writeValue(prefix + "synapses.precision", static_cast<uint8_t>(topology_->synapses.permanence.precision));
+}
+
+
+void Connections::saveCheckpoint(CheckpointWriter &writer, const string &prefix) const {
+  saveCheckpointScalars_(writer, prefix);
+  writeNested(writer, prefix + "cells.segments", topology_->cells,
+              [](const CellData &cell) -> const vector<Segment> & { return cell.segments; });
+
+  writeNested(writer, prefix + "segments.synapses", topology_->segments,
+              [](const SegmentData &seg) -> const vector<Synapse> & { return seg.synapses; });
+  vector<CellIdx> segCell(topology_->segments.size());
+  vector<SynapseIdx> segNumConnected(topology_->segments.size());
+  vector<UInt32> segLastUsed(topology_->segments.size());
+  vector<Segment> segId(topology_->segments.size());
+  for(size_t i = 0; i < topology_->segments.size(); i++) {
+    segCell[i]         = topology_->segments[i].cell;
+    segNumConnected[i] = topology_->segments[i].numConnected;
+    segLastUsed[i]     = topology_->segments[i].lastUsed;
+    segId[i]           = topology_->segments[i].id;
+  }
+  writer.write(prefix + "segments.cell", segCell);
+  writer.write(prefix + "segments.numConnected", segNumConnected);
+  writer.write(prefix + "segments.lastUsed", segLastUsed);
+  writer.write(prefix + "segments.id", segId);
+
+  const auto &perm = topology_->synapses.permanence;
+  switch(perm.precision) {
+    case PermanencePrecision::UINT16: writer.write(prefix + "synapses.permanence", perm.u16); break;
+    case PermanencePrecision::UINT8:  writer.write(prefix + "synapses.permanence", perm.u8);  break;
+    default:                          writer.write(prefix + "synapses.permanence", perm.f32);
   }
+  writer.write(prefix + "synapses.presynapticCell", topology_->synapses.presynapticCell);
+  writer.write(prefix + "synapses.segment", topology_->synapses.segment);
+  writer.write(prefix + "synapses.presynapticMapIndex", topology_->synapses.presynapticMapIndex);
+  writer.write(prefix + "synapses.id", topology_->synapses.id);
+
+  writeMap(writer, prefix + "potentialSynapsesForPresynapticCell", topology_->potentialSynapsesForPresynapticCell);
+  writeMap(writer, prefix + "connectedSynapsesForPresynapticCell", topology_->connectedSynapsesForPresynapticCell);
+  writeMap(writer, prefix + "potentialSegmentsForPresynapticCell", topology_->potentialSegmentsForPresynapticCell);
+  writeMap(writer, prefix + "connectedSegmentsForPresynapticCell", topology_->connectedSegmentsForPresynapticCell);
+}
+
+
+void Connections::loadCheckpointScalars_(const CheckpointReader &reader, const string &prefix) {
+  Topology &topology = mutable_();
+  connectedThreshold_ = reader.readValue<Permanence>(prefix + "connectedThreshold");
+  iteration_          = reader.readValue<UInt32>(prefix + "iteration");
+  topology.destroyedSynapses  = static_cast<size_t>(reader.readValue<UInt64>(prefix + "destroyedSynapses"));
+  topology.destroyedSegments  = static_cast<size_t>(reader.readValue<UInt64>(prefix + "destroyedSegments"));
+  topology.nextSegmentOrdinal = reader.readValue<Segment>(prefix + "nextSegmentOrdinal");
+  topology.nextSynapseOrdinal = reader.readValue<Synapse>(prefix + "nextSynapseOrdinal");
+  timeseries_         = reader.readValue<uint8_t>(prefix + "timeseries") != 0u;
+  prunedSyns_         = reader.readValue<Synapse>(prefix + "prunedSynapses");
+  prunedSegs_         = reader.readValue<Segment>(prefix + "prunedSegments");
+  for(const auto &updates : {std::make_pair("previousUpdates", &previousUpdates_),
+                             std::make_pair("currentUpdates", &currentUpdates_)}) {
+    const auto synapses = reader.view<Synapse>(prefix + updates.first + ".synapses");
+    const auto values   = reader.view<Permanence>(prefix + updates.first + ".values");
+    NTA_CHECK(synapses.second == values.second) << "Checkpoint: corrupt " << updates.first;
+    updates.second->clear();
+    updates.second->reserve(synapses.second);
+    for(size_t i = 0; i < synapses.second; i++) {
+      (*updates.second)[synapses.first[i]] = values.first[i];
+    }
+  }
+}
+
+
+void Connections::loadCheckpoint(const CheckpointReader &reader, const string &prefix) {
+  topology_ = std::make_shared<Topology>(); //copies keep the old one
+  loadCheckpointScalars_(reader, prefix);
+  Topology &topology = mutable_();
+
+  const auto numCells = static_cast<size_t>(reader.readValue<UInt64>(prefix + "numCells"));
+  const auto cellSegments = viewNested<Segment>(reader, prefix + "cells.segments", numCells);
+  topology.cells.resize(numCells);
+  for(size_t i = 0; i < numCells; i++) {
+    topology.cells[i].segments.assign(cellSegments.first + cellSegments.second[i],
+                              cellSegments.first + cellSegments.second[i + 1u]);
+  }
+
+  const auto numSegments = static_cast<size_t>(reader.readValue<UInt64>(prefix + "numSegments"));
+  const auto segSynapses     = viewNested<Synapse>(reader, prefix + "segments.synapses", numSegments);
+  const auto segCell         = reader.view<CellIdx>(prefix + "segments.cell");
+  const auto segNumConnected = reader.view<SynapseIdx>(prefix + "segments.numConnected");
+  const auto segLastUsed     = reader.view<UInt32>(prefix + "segments.lastUsed");
+  const auto segId           = reader.view<Segment>(prefix + "segments.id");
+  NTA_CHECK(segCell.second == numSegments and segNumConnected.second == numSegments and
+            segLastUsed.second == numSegments and segId.second == numSegments)
+    << "Connections checkpoint: the segment sections are inconsistent";
+  topology.segments.clear();
+  topology.segments.reserve(numSegments);
+  for(size_t i = 0; i < numSegments; i++) {
+    topology.segments.emplace_back(segCell.first[i], segId.first[i], segLastUsed.first[i]);
+    topology.segments.back().numConnected = segNumConnected.first[i];
+    topology.segments.back().synapses.assign(segSynapses.first + segSynapses.second[i],
+                                     segSynapses.first + segSynapses.second[i + 1u]);
+  }
+
+  topology.synapses.clear();
+  auto &perm = topology.synapses.permanence;
+  perm.setPrecision(static_cast<PermanencePrecision>(reader.readValue<uint8_t>(prefix + "synapses.precision")));
+  perm.setConnectedThreshold(connectedThreshold_);
+  switch(perm.precision) {
+    case PermanencePrecision::UINT16: reader.read(prefix + "synapses.permanence", perm.u16); break;
+    case PermanencePrecision::UINT8:  reader.read(prefix + "synapses.permanence", perm.u8);  break;
+    default:                          reader.read(prefix + "synapses.permanence", perm.f32);
+  }
+  reader.read(prefix + "synapses.presynapticCell", topology.synapses.presynapticCell);
+  reader.read(prefix + "synapses.segment", topology.synapses.segment);
+  reader.read(prefix + "synapses.presynapticMapIndex", topology.synapses.presynapticMapIndex);
+  reader.read(prefix + "synapses.id", topology.synapses.id);
+  const size_t numSynapses = topology.synapses.id.size();
+  NTA_CHECK(perm.size() == numSynapses and topology.synapses.presynapticCell.size() == numSynapses and
+            topology.synapses.segment.size() == numSynapses and topology.synapses.presynapticMapIndex.size() == numSynapses)
+    << "Connections checkpoint: the synapse sections are inconsistent";
+
+  readMap(reader, prefix + "potentialSynapsesForPresynapticCell", topology.potentialSynapsesForPresynapticCell);
+  readMap(reader, prefix + "connectedSynapsesForPresynapticCell", topology.connectedSynapsesForPresynapticCell);
+  readMap(reader, prefix + "potentialSegmentsForPresynapticCell", topology.potentialSegmentsForPresynapticCell);
+  readMap(reader, prefix + "connectedSegmentsForPresynapticCell", topology.connectedSegmentsForPresynapticCell);
+}
+
+
+void Connections::saveCheckpoint(const string &path) const {
+  CheckpointWriter writer(path);
+  saveCheckpoint(writer);
+  writer.close();
+}
+
+
+void Connections::loadCheckpoint(const string &path) {
+  const CheckpointReader reader(path);
+  loadCheckpoint(reader);
 }
 
 
@@ -744,9 +2417,9 @@ namespace htm {
 std::ostream& operator<< (std::ostream& stream, const Connections& self)
 {
   stream << "Connections:" << std::endl;
-  const auto numPresyns = self.potentialSynapsesForPresynapticCell_.size();
+  const auto numPresyns = self.topology_->potentialSynapsesForPresynapticCell.size();
   stream << "    Inputs (" << numPresyns
-         << ") ~> Outputs (" << self.cells_.size()
+         << ") ~> Outputs (" << self.topology_->cells.size()
          << ") via Segments (" << self.numSegments() << ")" << std::endl;
 
   UInt        segmentsMin   = -1;
@@ -760,7 +2433,7 @@ std::ostream& operator<< (std::ostream& stream, const Connections& self)
   SynapseIdx  connectedMax  = 0;
   UInt        synapsesDead      = 0;
   UInt        synapsesSaturated = 0;
-  for( const auto cellData : self.cells_ )
+  for( const auto cellData : self.topology_->cells )
   {
     const UInt numSegments = (UInt) cellData.segments.size();
     segmentsMin   = std::min( segmentsMin, numSegments );
@@ -780,10 +2453,10 @@ std::ostream& operator<< (std::ostream& stream, const Connections& self)
       connectedMean += segData.numConnected;
 
       for( const auto syn : segData.synapses ) {
-        const auto &synData = self.dataForSynapse( syn );
-        if( synData.permanence <= minPermanence + Epsilon )
+        const Permanence permanence = self.permanenceForSynapse( syn );
+        if( permanence <= minPermanence + Epsilon )
           { synapsesDead++; }
-        else if( synData.permanence >= maxPermanence - Epsilon )
+        else if( permanence >= maxPermanence - Epsilon )
           { synapsesSaturated++; }
       }
     }
@@ -803,8 +2476,8 @@ std::ostream& operator<< (std::ostream& stream, const Connections& self)
          << "%) Saturated (" <<   (Real) synapsesSaturated / self.numSynapses() << "%)" << std::endl;
   stream << "    Synapses pruned (" << (Real) self.prunedSyns_ / self.numSynapses() 
 	 << "%) Segments pruned (" << (Real) self.prunedSegs_ / self.numSegments() << "%)" << std::endl;
-  stream << "    Buffer for destroyed synapses: " << self.destroyedSynapses_
-	 << "    Buffer for destroyed segments: " << self.destroyedSegments_ << std::endl;
+  stream << "    Buffer for destroyed synapses: " << self.topology_->destroyedSynapses
+	 << "    Buffer for destroyed segments: " << self.topology_->destroyedSegments << std::endl;
 
   return stream;
 }
@@ -814,42 +2487,44 @@ std::ostream& operator<< (std::ostream& stream, const Connections& self)
 
 bool Connections::operator==(const Connections &o) const {
   try {
-  NTA_CHECK (cells_.size() == o.cells_.size()) << "Connections equals: cells_" << cells_.size() << " vs. " << o.cells_.size();
-  NTA_CHECK (cells_ == o.cells_) << "Connections equals: cells_" << cells_.size() << " vs. " << o.cells_.size();
-
-  NTA_CHECK (segments_ == o.segments_ ) << "Connections equals: segments_";
-  NTA_CHECK (destroyedSegments_ == o.destroyedSegments_ ) << "Connections equals: destroyedSegments_";
-
-  NTA_CHECK (synapses_ == o.synapses_ ) << "Connections equals: synapses_";
-  NTA_CHECK (destroyedSynapses_ == o.destroyedSynapses_ ) << "Connections equals: destroyedSynapses_";
-
-
-  //also check underlying datastructures (segments, and subsequently synapses). Can be time consuming.
-  //1.cells:
-  for(const auto cellD : cells_) {
-    //2.segments:
-    const auto& segments = cellD.segments;
-    for(const auto seg : segments) {
-      NTA_CHECK( dataForSegment(seg) == o.dataForSegment(seg) ) << "CellData equals: segmentData";
-      //3.synapses: 
-      const auto& synapses = dataForSegment(seg).synapses;
-      for(const auto syn : synapses) {
-        NTA_CHECK(dataForSynapse(syn) == o.dataForSynapse(syn) ) << "SegmentData equals: synapseData";
+  NTA_CHECK (connectedThreshold_ == o.connectedThreshold_ ) << "Connections equals: connectedThreshold_";
+  NTA_CHECK (iteration_ == o.iteration_ ) << "Connections equals: iteration_"; 
+
+  if(topology_ != o.topology_) { //copies share the topology until one changes
+    NTA_CHECK (topology_->cells.size() == o.topology_->cells.size()) << "Connections equals: cells_" << topology_->cells.size() << " vs. " << o.topology_->cells.size();
+    NTA_CHECK (topology_->cells == o.topology_->cells) << "Connections equals: cells_" << topology_->cells.size() << " vs. " << o.topology_->cells.size();
+
+    NTA_CHECK (topology_->segments == o.topology_->segments ) << "Connections equals: segments_";
+    NTA_CHECK (topology_->destroyedSegments == o.topology_->destroyedSegments ) << "Connections equals: destroyedSegments_";
+
+    NTA_CHECK (topology_->synapses == o.topology_->synapses ) << "Connections equals: synapses_";
+    NTA_CHECK (topology_->destroyedSynapses == o.topology_->destroyedSynapses ) << "Connections equals: destroyedSynapses_";
+
+
+    //also check underlying datastructures (segments, and subsequently synapses). Can be time consuming.
+    //1.cells:
+    for(const auto cellD : topology_->cells) {
+      //2.segments:
+      const auto& segments = cellD.segments;
+      for(const auto seg : segments) {
+        NTA_CHECK( dataForSegment(seg) == o.dataForSegment(seg) ) << "CellData equals: segmentData";
+        //3.synapses: 
+        const auto& synapses = dataForSegment(seg).synapses;
+        for(const auto syn : synapses) {
+          NTA_CHECK(dataForSynapse(syn) == o.dataForSynapse(syn) ) << "SegmentData equals: synapseData";
+        }
       }
     }
-  }
 
 
-  NTA_CHECK (connectedThreshold_ == o.connectedThreshold_ ) << "Connections equals: connectedThreshold_";
-  NTA_CHECK (iteration_ == o.iteration_ ) << "Connections equals: iteration_"; 
-
-  NTA_CHECK(potentialSynapsesForPresynapticCell_ == o.potentialSynapsesForPresynapticCell_);
-  NTA_CHECK(connectedSynapsesForPresynapticCell_ == o.connectedSynapsesForPresynapticCell_);
-  NTA_CHECK(potentialSegmentsForPresynapticCell_ == o.potentialSegmentsForPresynapticCell_);
-  NTA_CHECK(connectedSegmentsForPresynapticCell_ == o.connectedSegmentsForPresynapticCell_);
+    NTA_CHECK(topology_->potentialSynapsesForPresynapticCell == o.topology_->potentialSynapsesForPresynapticCell);
+    NTA_CHECK(topology_->connectedSynapsesForPresynapticCell == o.topology_->connectedSynapsesForPresynapticCell);
+    NTA_CHECK(topology_->potentialSegmentsForPresynapticCell == o.topology_->potentialSegmentsForPresynapticCell);
+    NTA_CHECK(topology_->connectedSegmentsForPresynapticCell == o.topology_->connectedSegmentsForPresynapticCell);
 
-  NTA_CHECK (nextSegmentOrdinal_ == o.nextSegmentOrdinal_ ) << "Connections equals: nextSegmentOrdinal_";
-  NTA_CHECK (nextSynapseOrdinal_ == o.nextSynapseOrdinal_ ) << "Connections equals: nextSynapseOrdinal_";
+    NTA_CHECK (topology_->nextSegmentOrdinal == o.topology_->nextSegmentOrdinal ) << "Connections equals: nextSegmentOrdinal_";
+    NTA_CHECK (topology_->nextSynapseOrdinal == o.topology_->nextSynapseOrdinal ) << "Connections equals: nextSynapseOrdinal_";
+  }
 
   NTA_CHECK (timeseries_ == o.timeseries_ ) << "Connections equals: timeseries_";
   NTA_CHECK (previousUpdates_ == o.previousUpdates_ ) << "Connections equals: previousUpdates_";
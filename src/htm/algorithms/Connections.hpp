@@ -22,6 +22,7 @@
 #ifndef NTA_CONNECTIONS_HPP
 #define NTA_CONNECTIONS_HPP
 
+#include <cmath>
 #include <limits>
 #include <map>
 #include <unordered_map>
@@ -29,10 +30,19 @@
 #include <utility>
 #include <vector>
 #include <deque>
+#include <string>
+#include <functional>
+#include <memory>
 
 #include <htm/types/Types.hpp>
 #include <htm/types/Serializable.hpp>
 #include <htm/types/Sdr.hpp>
+#include <htm/utils/Random.hpp>
+#include <htm/algorithms/SynapseBudget.hpp>
+#include <htm/utils/Checkpoint.hpp>
+#include <htm/utils/MemoryResource.hpp>
+#include <htm/utils/MemoryUsage.hpp>
+#include <htm/utils/ThreadPool.hpp>
 
 namespace htm {
 
@@ -46,6 +56,35 @@ using Permanence= Real32; //TODO experiment with half aka float16
 constexpr const Permanence minPermanence = 0.0f;
 constexpr const Permanence maxPermanence = 1.0f;
 
+/**
+ * Storage precision of the synapse permanences in Connections.
+ *
+ * FLOAT32 stores the Permanence as is (default). UINT16 and UINT8 store it as
+ * fixed point in [minPermanence, maxPermanence] with 65534 / 254 steps, which
+ * makes the permanence array 2x / 4x smaller. Every update is rounded to the
+ * nearest step, so an increment smaller than half of a step (1/508 for UINT8)
+ * does not change the permanence.
+ */
+enum class PermanencePrecision : uint8_t {
+  FLOAT32 = 32,
+  UINT16  = 16,
+  UINT8   = 8
+};
+
+/**
+ * Which segment `Connections::createSegment()` destroys when the cell is full.
+ *
+ * LRU destroys the least recently used segment (smallest `SegmentData.lastUsed`),
+ * looking at every segment of the cell (default). SAMPLED_LRU destroys the least
+ * recently used of a few randomly picked segments of the cell, so its cost does
+ * not grow with `maxSegmentsPerCell`; it is an approximation, a recently used
+ * segment is destroyed only if all the picked segments are as recent.
+ */
+enum class SegmentEviction : uint8_t {
+  LRU         = 0,
+  SAMPLED_LRU = 1
+};
+
 
 
 /**
@@ -59,8 +98,13 @@ constexpr const Permanence maxPermanence = 1.0f;
  *
  * @param permanence
  * Permanence of synapse.
+ *
+ * Note: Connections stores the synapses as a structure of arrays, this struct
+ * is the (copied) view of a single synapse, see `Connections::dataForSynapse()`.
+ * It has no virtual methods and it is not `Serializable` on its own, it is serialized
+ * as a member of Connections.
  */
-struct SynapseData: public Serializable {
+struct SynapseData {
   CellIdx presynapticCell;
   Permanence permanence;
   Segment segment;
@@ -70,7 +114,6 @@ struct SynapseData: public Serializable {
   SynapseData() {}
 
   //Serialization
-  CerealAdapter;
   template<class Archive>
   void save_ar(Archive & ar) const {
     ar(CEREAL_NVP(permanence),
@@ -117,8 +160,10 @@ struct SynapseData: public Serializable {
  *
  * @param cell
  * The cell that this segment is on.
+ *
+ * Not `Serializable` on its own (no vtable), it is serialized as a member of Connections.
  */
-struct SegmentData: public Serializable {
+struct SegmentData {
   SegmentData(const CellIdx cell, Segment id, UInt32 lastUsed = 0) : cell(cell), numConnected(0), lastUsed(lastUsed), id(id) {} //default constructor
 
   std::vector<Synapse> synapses;
@@ -129,7 +174,6 @@ struct SegmentData: public Serializable {
 
   //Serialize
   SegmentData() {}; //empty constructor for serialization, do not use
-  CerealAdapter;
   template<class Archive>
   void save_ar(Archive & ar) const {
     ar(CEREAL_NVP(synapses),
@@ -173,12 +217,12 @@ struct SegmentData: public Serializable {
  * @param segments
  * Segments on this cell.
  *
+ * Plain struct, serialized as part of Connections.
  */
-struct CellData : public Serializable {
+struct CellData {
   std::vector<Segment> segments;
 
   //Serialization
-  CerealAdapter;
   template<class Archive>
   void save_ar(Archive & ar) const {
     ar(CEREAL_NVP(segments)
@@ -204,6 +248,60 @@ struct CellData : public Serializable {
 };
 
 
+/**
+ * Reusable output of `Connections::computeActivity(SegmentActivity&, ...)`.
+ *
+ * Keep one instance per caller and pass it to every call: the counters are
+ * resized to `segmentFlatListLength()`, and only the entries touched by the
+ * previous call are zeroed, so in the steady state nothing is allocated.
+ */
+struct SegmentActivity {
+  std::vector<SynapseIdx> numActiveConnected; //active connected synapses, per segment
+  std::vector<SynapseIdx> numActivePotential; //active potential synapses (incl. connected), per segment
+  std::vector<Segment>    touched;            //segments with numActivePotential > 0, unordered
+                                              //(numActiveConnected > 0 if the potential is not counted)
+  bool touchedValid = false; //false: the counters were changed elsewhere, next call zeroes all of them
+};
+
+/**
+ * One segment of a two phase `adaptSegment()`, see
+ * `Connections::prepareAdaptSegments()` and `Connections::finishAdaptSegment()`.
+ * The caller fills in the segment and the permanence changes,
+ * `prepareAdaptSegments()` fills in the pending structural changes.
+ */
+struct SegmentAdaptation {
+  Segment    segment;
+  Permanence increment;
+  Permanence decrement;
+  std::vector<std::pair<Synapse, Permanence>> crossing; //synapses that (dis)connect, with their new permanence
+  std::vector<Synapse> prune;                           //synapses that reached minPermanence
+  std::vector<std::pair<Synapse, Permanence>> updates;  //timeseries: the update of each adapted synapse
+};
+
+/**
+ * One record of the Connections change log, see `Connections::setChangeLog()`.
+ *
+ * `id` is the Segment or Synapse, `value` the new permanence of
+ * UPDATE_SYNAPSE_PERMANENCE (0 otherwise). The records are the same events as
+ * those of ConnectionsEventHandler; COMPACT means all previous ids are renumbered.
+ */
+struct ConnectionsChange {
+  enum Kind : uint8_t {
+    CREATE_SEGMENT = 0,
+    DESTROY_SEGMENT,
+    CREATE_SYNAPSE,
+    DESTROY_SYNAPSE,
+    UPDATE_SYNAPSE_PERMANENCE,
+    COMPACT
+  };
+  Kind       kind;
+  UInt32     id;
+  Permanence value;
+
+  bool operator==(const ConnectionsChange &o) const {
+    return kind == o.kind and id == o.id and value == o.value; }
+};
+
 /**
  * A base class for Connections event handlers.
  *
@@ -239,6 +337,14 @@ public:
    */
   virtual void onUpdateSynapsePermanence(Synapse synapse,
                                          Permanence permanence) {}
+
+  /**
+   * Called after `Connections::compact()` renumbered the segments and synapses.
+   * Index with the old Segment / Synapse to get the new one, destroyed
+   * ones map to std::numeric_limits<Segment/Synapse>::max().
+   */
+  virtual void onCompact(const std::vector<Segment> &newSegments,
+                         const std::vector<Synapse> &newSynapses) {}
 };
 
 /**
@@ -297,7 +403,8 @@ public:
    */
   Connections(const CellIdx numCells, 
 	      const Permanence connectedThreshold = 0.5f,
-              const bool timeseries = false);
+              const bool timeseries = false,
+              const PermanencePrecision precision = PermanencePrecision::FLOAT32);
 
   virtual ~Connections() {} 
 
@@ -308,10 +415,12 @@ public:
    * @param connectedThreshold Permanence threshold for synapses connecting or
    *                           disconnecting.
    * @param timeseries         See constructor.
+   * @param precision          Storage of the permanences, see PermanencePrecision.
    */
   void initialize(const CellIdx numCells, 
 		  const Permanence connectedThreshold = 0.5f,
-                  const bool timeseries = false);
+                  const bool timeseries = false,
+                  const PermanencePrecision precision = PermanencePrecision::FLOAT32);
 
   /**
    * Creates a segment on the specified cell.
@@ -320,8 +429,8 @@ public:
    *
    * @param maxSegmetsPerCell Optional. Enforce limit on maximum number of segments that can be
    * created on a Cell. If the limit is exceeded, call `destroySegment` to remove least used segments 
-   * (ordered by LRU `SegmentData.lastUsed`). Default value is numeric_limits::max() of the data-type, 
-   * so effectively disabled. 
+   * (ordered by LRU `SegmentData.lastUsed`, see `setSegmentEviction()`). Default value is 
+   * numeric_limits::max() of the data-type, so effectively disabled. 
    *
    * @retval Unique ID of the created segment `seg`. Use `dataForSegment(seg)` to obtain the segment's data. 
    * Use  `idxOfSegmentOnCell()` to get SegmentIdx of `seg` on this `cell`. 
@@ -361,6 +470,87 @@ public:
                         const CellIdx presynapticCell,
                         Permanence permanence);
 
+  /**
+   * Creates many synapses on a segment, the same as calling
+   * `createSynapse(segment, presynapticCells[i], permanences[i])` for each i
+   * in order, but without the duplicate check of every call when the segment
+   * has no synapses yet and the presynaptic cells are strictly ascending.
+   *
+   * @param segment           Segment to create the synapses on.
+   * @param presynapticCells  Cells to synapse on.
+   * @param permanences       Initial permanences, same length as presynapticCells.
+   */
+  void createSynapses(const Segment segment,
+                      const std::vector<CellIdx> &presynapticCells,
+                      const std::vector<Permanence> &permanences);
+
+  /**
+   * Builds all segments and synapses of an empty Connections at once, from
+   * arrays in the compressed sparse row (CSR) layout. The result is the same
+   * as calling `createSegment(segmentCells[s])` for every segment s, and
+   * `createSynapse(s, presynapticCells[i], permanences[i])` for each i in
+   * [synapseOffsets[s], synapseOffsets[s + 1]), but the presynaptic maps are
+   * sized once and filled in one pass. The per segment checks run on the
+   * threads of `setNumThreads()`.
+   *
+   * @param segmentCells      The cell of each segment, in the order of the segments.
+   * @param synapseOffsets    numSegments + 1 ascending offsets into the synapse
+   *                          arrays, starting at 0 and ending at the number of synapses.
+   * @param presynapticCells  The presynaptic cell of each synapse. Must not repeat
+   *                          within a segment.
+   * @param permanences       The permanence of each synapse.
+   * @param lastUsed          (optional) The `SegmentData.lastUsed` of each
+   *                          segment, default the current iteration.
+   *
+   * Throws if the Connections has any segments, or the arrays are inconsistent.
+   */
+  void bulkLoad(const std::vector<CellIdx> &segmentCells,
+                const std::vector<Synapse> &synapseOffsets,
+                const std::vector<CellIdx> &presynapticCells,
+                const std::vector<Permanence> &permanences,
+                const std::vector<UInt32> &lastUsed = {});
+
+  /**
+   * The inverse of `bulkLoad()`: copies all existing segments and synapses out
+   * into its CSR layout, the segments in order, without the destroyed ones.
+   * Loading the arrays into an empty Connections gives the same model, with the
+   * segments and synapses numbered as after `compact()`. The arrays may be
+   * edited in between, to change a model offline.
+   */
+  void bulkExport(std::vector<CellIdx> &segmentCells,
+                  std::vector<Synapse> &synapseOffsets,
+                  std::vector<CellIdx> &presynapticCells,
+                  std::vector<Permanence> &permanences,
+                  std::vector<UInt32> &lastUsed) const;
+
+  /**
+   * The synapse arrays, indexed by Synapse, for reading all synapses at once
+   * without copying them. They include the destroyed synapses (until
+   * `compact()`), whose permanence is -1.
+   *
+   * The view holds a reference to the topology, so it stays valid and unchanged
+   * while this Connections goes on learning: the next change copies the
+   * topology first, as for `shareFrom()`. Let go of it before learning to
+   * avoid the copy.
+   */
+  struct SynapseArraysView {
+    std::shared_ptr<const void> owner;
+    size_t            size            = 0u;
+    const CellIdx    *presynapticCell = nullptr;
+    const Segment    *segment         = nullptr;
+    const Permanence *permanence      = nullptr; //only with PermanencePrecision::FLOAT32, else see synapsePermanences()
+  };
+  SynapseArraysView synapseArrays() const;
+
+  /** The permanence of every synapse, indexed by Synapse, -1 if destroyed. */
+  std::vector<Permanence> synapsePermanences() const;
+
+  /**
+   * The cell and `SegmentData.lastUsed` of every segment, indexed by Segment.
+   * Destroyed segments (until `compact()`) have the cell numCells().
+   */
+  void segmentArrays(std::vector<CellIdx> &cells, std::vector<UInt32> &lastUsed) const;
+
 
 
   /**
@@ -379,6 +569,8 @@ public:
    * @param maxSynapsesPerSegment - (optional) size_t, default=0/off. If >0: enforce limit on max
    *   number of synapses on a segment. If reached, weak synapses will be purged to make space.
    *
+   * The result is the same as with createSynapse() for each picked candidate,
+   * but the new synapses are inserted at once.
    **/
   void growSynapses(const Segment segment, 
 		                    const std::vector<Synapse>& growthCandidates, 
@@ -388,6 +580,20 @@ public:
 				    const size_t maxSynapsesPerSegment = 0
 				    );
 
+  /**
+   * Same as above with the candidates in two ranges, growthCandidates and
+   * externalCandidates + externalOffset, as if they were concatenated.  See
+   * the two-range computeActivity().
+   */
+  void growSynapses(const Segment segment,
+                    const std::vector<CellIdx>& growthCandidates,
+                    const std::vector<CellIdx>& externalCandidates,
+                    const CellIdx externalOffset,
+                    const Permanence initialPermanence,
+                    Random& rng,
+                    const size_t maxNew = 0,
+                    const size_t maxSynapsesPerSegment = 0);
+
   /**
    * Destroys segment.
    *
@@ -420,7 +626,7 @@ public:
    * @retval Segments on cell.
    */
   const std::vector<Segment> &segmentsForCell(const CellIdx cell) const {
-    return cells_[cell].segments;
+    return topology_->cells[cell].segments;
   }
 
   /**
@@ -431,8 +637,8 @@ public:
    * @retval Synapses on segment.
    */
   const std::vector<Synapse> &synapsesForSegment(const Segment segment) const {
-    NTA_ASSERT(segment < segments_.size()) << "Segment out of bounds! " << segment;
-    return segments_[segment].synapses;
+    NTA_ASSERT(segment < topology_->segments.size()) << "Segment out of bounds! " << segment;
+    return topology_->segments[segment].synapses;
   }
 
   /**
@@ -444,7 +650,7 @@ public:
    */
   CellIdx cellForSegment(const Segment segment) const {
     NTA_ASSERT(segmentExists_(segment));
-    return segments_[segment].cell;
+    return topology_->segments[segment].cell;
   }
 
   /**
@@ -471,7 +677,24 @@ public:
    * @retval Segment that this synapse is on.
    */
   Segment segmentForSynapse(const Synapse synapse) const {
-    return synapses_[synapse].segment;
+    return topology_->synapses.segment[synapse];
+  }
+
+  /**
+   * Gets the permanence / presynaptic cell of a synapse. Cheaper than
+   * `dataForSynapse()` as only the one field is read.
+   */
+  Permanence permanenceForSynapse(const Synapse synapse) const {
+    NTA_ASSERT(synapse < topology_->synapses.size());
+    return topology_->synapses.permanence[synapse];
+  }
+  CellIdx presynapticCellForSynapse(const Synapse synapse) const {
+    NTA_ASSERT(synapse < topology_->synapses.size());
+    return topology_->synapses.presynapticCell[synapse];
+  }
+  bool isConnected(const Synapse synapse) const {
+    NTA_ASSERT(synapse < topology_->synapses.size());
+    return topology_->synapses.permanence.isConnected(synapse);
   }
 
   /**
@@ -483,11 +706,11 @@ public:
    */
   const SegmentData &dataForSegment(const Segment segment) const {
     NTA_CHECK(segmentExists_(segment));
-    return segments_[segment];
+    return topology_->segments[segment];
   }
   SegmentData& dataForSegment(const Segment segment) { //editable access, needed by SP
     NTA_CHECK(segmentExists_(segment));
-    return segments_[segment];
+    return mutable_().segments[segment];
   }
 
   /**
@@ -495,11 +718,11 @@ public:
    *
    * @param synapse Synapse to get data for.
    *
-   * @retval Synapse data.
+   * @retval Synapse data, a copy assembled from the synapse arrays.
    */
-  inline const SynapseData& dataForSynapse(const Synapse synapse) const {
+  inline SynapseData dataForSynapse(const Synapse synapse) const {
     NTA_CHECK(synapseExists_(synapse, true));
-    return synapses_[synapse];
+    return topology_->synapses[synapse];
   }
 
   /**
@@ -511,7 +734,7 @@ public:
    * @retval Segment
    */
   inline Segment getSegment(const CellIdx cell, const SegmentIdx idx) const {
-    return cells_[cell].segments[idx];
+    return topology_->cells[cell].segments[idx];
   }
 
   /**
@@ -519,7 +742,60 @@ public:
    *
    * @retval A vector length
    */
-  inline size_t segmentFlatListLength() const noexcept { return segments_.size(); };
+  inline size_t segmentFlatListLength() const noexcept { return topology_->segments.size(); };
+
+  /**
+   * Remove the destroyed segments and synapses from the internal storage.
+   *
+   * Destroyed segments and synapses keep their slots in the flat lists, so
+   * `segmentFlatListLength()` only grows. Compacting renumbers all live
+   * segments in the order of their cell (same as `compareSegments()`), and the
+   * synapses of each segment next to each other, then rebuilds the presynaptic
+   * maps. All previously obtained Segment and Synapse indices become invalid,
+   * subscribers get the mapping in `ConnectionsEventHandler::onCompact()`.
+   * The ids (ordinals) of the segments and synapses are not changed.
+   */
+  void compact();
+
+  /**
+   * Prune a trained model offline, then compact().
+   *
+   * Destroys the synapses whose permanence is below `minPermanence`, with
+   * `maxSegmentAge` > 0 the segments not used (see `SegmentData.lastUsed`)
+   * in the last `maxSegmentAge` iterations, and with `destroyEmptySegments`
+   * the segments left without synapses.  Models which index their segments
+   * by cell (the SpatialPooler) must keep the empty segments.
+   *
+   * @returns the numbers of destroyed synapses (incl. those of the destroyed
+   * segments) and of destroyed segments.
+   */
+  std::pair<size_t, size_t> prune(Permanence minPermanence, UInt32 maxSegmentAge = 0u,
+                                  bool destroyEmptySegments = false);
+
+  /**
+   * Compact automatically at the start of `computeActivity()`, when the
+   * fraction of destroyed segments or synapses in the flat lists reaches
+   * `fraction`. 0 (default) turns it off. This setting is not serialized.
+   *
+   * Note that the Segment indices change at that call, the segment lists
+   * returned before it must not be used afterwards.
+   */
+  void setCompactThreshold(const Real fraction);
+  Real getCompactThreshold() const noexcept { return compactThreshold_; }
+
+  /**
+   * Choose the segment destroyed by `createSegment()` when the cell has
+   * `maxSegmentsPerCell` segments, see SegmentEviction.
+   *
+   * The setting is not serialized, default is the exact LRU.
+   *
+   * @param policy - SegmentEviction.
+   * @param sampleSize - number of segments SAMPLED_LRU picks (with repetition),
+   *   at least 1. A cell with no more segments than that uses the exact LRU.
+   * @param seed - of the random picks, so the runs are reproducible.
+   */
+  void setSegmentEviction(const SegmentEviction policy, const UInt sampleSize = 4u, const UInt64 seed = 42u);
+  SegmentEviction getSegmentEviction() const noexcept { return segmentEviction_; }
 
   /**
    * Compare two segments. Returns true if a < b.
@@ -575,6 +851,181 @@ public:
   std::vector<SynapseIdx> computeActivity(const std::vector<CellIdx> &activePresynapticCells, 
 		                          const bool learn = true);
 
+  /**
+   * Same as above, but writes both the connected and the potential counts to
+   * the caller's buffers, see SegmentActivity. Does not allocate once the
+   * buffers have reached their size.
+   *
+   * @param countPotential (default true) false counts only the connected
+   * synapses, `activity.numActivePotential` is left empty.
+   */
+  void computeActivity(SegmentActivity &activity,
+                       const std::vector<CellIdx> &activePresynapticCells,
+                       const bool learn = true,
+                       const bool countPotential = true);
+
+  /**
+   * Same as above for presynaptic cells in two index ranges: the active
+   * cells, and the external inputs which are presynaptic cells from
+   * externalOffset on, eg. the context of a TemporalMemory after its own
+   * cells.  The counts are those of the concatenation of activePresynapticCells
+   * and externalCells + externalOffset, which is never made.
+   */
+  void computeActivity(SegmentActivity &activity,
+                       const std::vector<CellIdx> &activePresynapticCells,
+                       const std::vector<CellIdx> &externalCells,
+                       const CellIdx externalOffset,
+                       const bool learn = true,
+                       const bool countPotential = true);
+
+  /**
+   * Read-only `computeActivity(activity, cells, false, false)`, which can be
+   * called from several threads at once, each with its own `activity`.
+   * Doesn't compact, doesn't use the thread pool and leaves the iteration and
+   * the timeseries state alone.
+   * Call `prepareConcurrentActivity()` once before, from a single thread.
+   */
+  void computeConnectedActivity(SegmentActivity &activity,
+                                const std::vector<CellIdx> &activePresynapticCells) const;
+  void prepareConcurrentActivity() { prepareFlatIndex_(true); }
+
+  /**
+   * Turn the activity counters from `computeActivity()` into lists of segments,
+   * in one pass over both counter vectors.
+   *
+   * @param numActiveConnected - connected synapse counts per segment.
+   * @param activationThreshold - segments with numActiveConnected >= this are appended to `active`.
+   * @param numActivePotential - potential synapse counts per segment, same length as numActiveConnected.
+   * @param matchingThreshold - segments with numActivePotential >= this are appended to `matching`.
+   * @param active, matching - output, cleared first. Segments are in ascending order.
+   *
+   * The scan is vectorized (AVX-512BW, AVX2 or NEON, selected at runtime by the CPU),
+   * the results are the same as a plain loop.
+   */
+  static void filterSegmentsByActivity(const std::vector<SynapseIdx> &numActiveConnected,
+                                       const SynapseIdx activationThreshold,
+                                       const std::vector<SynapseIdx> &numActivePotential,
+                                       const SynapseIdx matchingThreshold,
+                                       std::vector<Segment> &active,
+                                       std::vector<Segment> &matching);
+
+  /**
+   * Use a flat (CSR-like) presynaptic index in `computeActivity()`.
+   *
+   * When enabled, the segments of each presynaptic cell are additionally kept
+   * in one contiguous array (row offsets + segments), so computing the activity
+   * is a single linear scan per active cell, without hashing. The index is
+   * rebuilt lazily on the next `computeActivity()` after larger changes of the
+   * synapses, small changes (a synapse (dis)connecting, new synapses) are patched
+   * in place. Results are identical to the default (hash-map) path, the index
+   * costs extra memory (about one Segment per synapse, 2 UInt32 per presynaptic cell).
+   *
+   * The setting is not serialized, default is off.
+   *
+   * @param enable - bool, turn the flat index on/off.
+   */
+  void setFlatIndex(const bool enable);
+  bool getFlatIndex() const noexcept { return useFlatIndex_; }
+
+  /**
+   * How growSynapses() picks maxNew of more candidates. The default (off)
+   * shuffles all the candidates first, which draws a random number per
+   * candidate. When enabled, it picks them one at a time (partial
+   * Fisher-Yates, see Random::sampleInPlace()), so only the candidates which
+   * are tried cost a random number. Both pick uniformly, but they consume the
+   * random sequence differently, so turning this on changes the results for
+   * the same seed; keep it off to reproduce older results.
+   *
+   * The setting is not serialized, default is off.
+   */
+  void setSampledGrowth(const bool enable) { sampledGrowth_ = enable; }
+  bool getSampledGrowth() const noexcept { return sampledGrowth_; }
+
+  /**
+   * Make this a copy of `other` which shares the cells, segments and synapses
+   * with it. Whichever of the two changes them first copies them then, so a
+   * copy for inference costs almost no memory. The flat indexes of `other`
+   * are built before, else each copy would build (and so copy) its own.
+   *
+   * The subscribers, the change log, the threads and the synapse budget of
+   * this Connections are kept, those of `other` are not copied.
+   */
+  void shareFrom(Connections &other);
+
+  /** True while this and `other` share the cells, segments and synapses, see shareFrom(). */
+  bool sharesTopology(const Connections &other) const noexcept { return topology_ == other.topology_; }
+
+  /**
+   * Compute the activity in `computeActivity()` with several threads.
+   *
+   * The active presynaptic cells are split between the threads, each counts
+   * into its own array of counters, which are summed afterwards. Results are
+   * identical to the single threaded computation. Small inputs (less than
+   * MIN_CELLS_PER_THREAD active cells per thread) are computed on the calling
+   * thread only.
+   *
+   * The setting is not serialized, default is 1 (no extra threads).
+   *
+   * @param numThreads - number of threads including the caller, 0 or 1 turns
+   *   the threading off.
+   */
+  void setNumThreads(const UInt numThreads);
+  UInt getNumThreads() const noexcept {
+    return threadPool_ == nullptr ? 1u : static_cast<UInt>(threadPool_->size()); }
+  /**
+   * The threads of `setNumThreads()`, for the algorithms which own this
+   * Connections. nullptr when single threaded.
+   */
+  ThreadPool *getThreadPool() const noexcept { return threadPool_.get(); }
+  /**
+   * As `setNumThreads()`, with threads shared with others, eg. a pool of a
+   * Network (see Network::addThreadPool()). Their loops take turns.
+   */
+  void setThreadPool(const std::shared_ptr<ThreadPool> &pool);
+
+  static constexpr const size_t MIN_CELLS_PER_THREAD = 64u;
+
+  /**
+   * Where the arrays of the cells, segments, synapses and flat indexes get
+   * their memory, e.g. a HugePageResource or a NumaResource (see
+   * MemoryResource.hpp); null for operator new. The current state is copied
+   * there, so set it before the model grows. initialize() and loading keep
+   * the resource, copies of this Connections share it.
+   *
+   * The setting is not serialized.
+   */
+  void setMemoryResource(const std::shared_ptr<MemoryResource> &resource);
+  MemoryResource *getMemoryResource() const noexcept { return topology_->resource.get(); }
+
+  /**
+   * Attach to a synapse budget shared with other models, nullptr detaches.
+   *
+   * At the start of each learning computeActivity() the number of synapses is
+   * published to the budget (so a model which only infers, e.g. a copy which
+   * shares the synapses of another, does not count), and if it is over the
+   * target the budget set,
+   * up to SynapseBudget::getMaxPrunePerCompute() synapses are pruned, from
+   * the least recently used segments on:
+   *   with destroySegments, whole segments are destroyed (TemporalMemory),
+   *   else only the weakest synapses of each, see destroyMinPermanenceSynapses()
+   *   (SpatialPooler, whose segments are its columns).
+   *
+   * Not serialized. shareFrom() keeps the budget of this Connections.
+   */
+  void setSynapseBudget(std::shared_ptr<SynapseBudget> budget, bool destroySegments = true);
+  std::shared_ptr<SynapseBudget> getSynapseBudget() const noexcept { return budget_; }
+
+  /** Number of synapses pruned to keep within the synapse budget. */
+  size_t numBudgetPrunedSynapses() const noexcept { return budgetPrunedSynapses_; }
+
+  /**
+   * Change the storage precision of the permanences, see PermanencePrecision.
+   * Existing permanences are converted (rounded to the nearest step).
+   * The precision is serialized.
+   */
+  void setPermanencePrecision(const PermanencePrecision precision);
+  PermanencePrecision getPermanencePrecision() const noexcept { return topology_->synapses.permanence.precision; }
+
   /**
    * The primary method in charge of learning.   Adapts the permanence values of
    * the synapses based on the input SDR.  Learning is applied to a single
@@ -601,6 +1052,50 @@ public:
 		    const bool pruneZeroSynapses = false,
 		    const UInt segmentThreshold = 0);
 
+  /**
+   * Same as calling `adaptSegment()` for each of the segments, but the setup
+   * (dense view of the inputs, timeseries buffers) is done only once, the
+   * segments are processed in ascending (memory) order and all the pruning is
+   * done in one sweep at the end.
+   *
+   * @param segments  Segments to apply learning to, each at most once.
+   * Other params see `adaptSegment()`.
+   */
+  void adaptSegments(const std::vector<Segment> &segments,
+                     const SDR &inputs,
+                     const Permanence increment,
+                     const Permanence decrement,
+                     const bool pruneZeroSynapses = false,
+                     const UInt segmentThreshold = 0);
+
+  /**
+   * First half of `adaptSegment()` for many segments, run on the threads set
+   * by `setNumThreads()`. Only the permanences of synapses that keep their
+   * connected state are written, everything that changes the presynaptic maps
+   * (connecting, disconnecting and pruning synapses) is recorded in the
+   * adaptations and must be applied with `finishAdaptSegment()`.
+   *
+   * A segment may appear only once. Between the two phases the caller may
+   * change other segments, but not the synapses of the prepared ones.
+   *
+   * @param adaptations  Segments with their increment & decrement.
+   * Other params see `adaptSegment()`.
+   */
+  void prepareAdaptSegments(std::vector<SegmentAdaptation> &adaptations,
+                            const SDR &inputs,
+                            const bool pruneZeroSynapses = false);
+
+  /**
+   * Second half of `adaptSegment()`, see `prepareAdaptSegments()`.
+   * Calling both halves for a segment has the same effect as `adaptSegment()`,
+   * including the order of the changes to the presynaptic maps and the events.
+   *
+   * Other params see `adaptSegment()`.
+   */
+  void finishAdaptSegment(const SegmentAdaptation &adaptation,
+                          const bool pruneZeroSynapses = false,
+                          const UInt segmentThreshold = 0);
+
   /**
    * Ensures a minimum number of connected synapses.  This raises permance
    * values until the desired number of synapses have permanences above the
@@ -670,28 +1165,36 @@ public:
    * Print diagnostic info
    */
   friend std::ostream& operator<< (std::ostream& stream, const Connections& self);
+  friend class ConnectionsDelta;
 
 
   // Serialization
   CerealAdapter;
   template<class Archive>
   void save_ar(Archive & ar) const {
+    if(externalSerialization_ != nullptr) {
+      externalSerialization_->save(*this);
+      return;
+    }
     ar(CEREAL_NVP(connectedThreshold_));
     ar(CEREAL_NVP(iteration_));
-    ar(CEREAL_NVP(cells_));
-    ar(CEREAL_NVP(segments_));
-    ar(CEREAL_NVP(synapses_));
+    const Topology &topology = *topology_;
+    ar(cereal::make_nvp("cells_", topology.cells));
+    ar(cereal::make_nvp("segments_", topology.segments));
+    const uint8_t permanencePrecision = static_cast<uint8_t>(topology.synapses.permanence.precision);
+    ar(CEREAL_NVP(permanencePrecision));
+    ar(cereal::make_nvp("synapses_", topology.synapses));
 
-    ar(CEREAL_NVP(destroyedSynapses_));
-    ar(CEREAL_NVP(destroyedSegments_));
+    ar(cereal::make_nvp("destroyedSynapses_", topology.destroyedSynapses));
+    ar(cereal::make_nvp("destroyedSegments_", topology.destroyedSegments));
 
-    ar(CEREAL_NVP(potentialSynapsesForPresynapticCell_));
-    ar(CEREAL_NVP(connectedSynapsesForPresynapticCell_));
-    ar(CEREAL_NVP(potentialSegmentsForPresynapticCell_));
-    ar(CEREAL_NVP(connectedSegmentsForPresynapticCell_));
+    ar(cereal::make_nvp("potentialSynapsesForPresynapticCell_", topology.potentialSynapsesForPresynapticCell));
+    ar(cereal::make_nvp("connectedSynapsesForPresynapticCell_", topology.connectedSynapsesForPresynapticCell));
+    ar(cereal::make_nvp("potentialSegmentsForPresynapticCell_", topology.potentialSegmentsForPresynapticCell));
+    ar(cereal::make_nvp("connectedSegmentsForPresynapticCell_", topology.connectedSegmentsForPresynapticCell));
 
-    ar(CEREAL_NVP(nextSegmentOrdinal_));
-    ar(CEREAL_NVP(nextSynapseOrdinal_));
+    ar(cereal::make_nvp("nextSegmentOrdinal_", topology.nextSegmentOrdinal));
+    ar(cereal::make_nvp("nextSynapseOrdinal_", topology.nextSynapseOrdinal));
 
     ar(CEREAL_NVP(timeseries_));
     ar(CEREAL_NVP(previousUpdates_));
@@ -703,24 +1206,35 @@ public:
 
   template<class Archive>
   void load_ar(Archive & ar) {
+    if(externalSerialization_ != nullptr) {
+      externalSerialization_->load(*this);
+      return;
+    }
     ar(CEREAL_NVP(connectedThreshold_));
     ar(CEREAL_NVP(iteration_));
     //!initialize(numCells, connectedThreshold_); //initialize Connections //Note: we actually don't call Connections
     //initialize() as all the members are de/serialized. 
-    ar(CEREAL_NVP(cells_));
-    ar(CEREAL_NVP(segments_));
-    ar(CEREAL_NVP(synapses_));
-
-    ar(CEREAL_NVP(destroyedSynapses_));
-    ar(CEREAL_NVP(destroyedSegments_));
-
-    ar(CEREAL_NVP(potentialSynapsesForPresynapticCell_));
-    ar(CEREAL_NVP(connectedSynapsesForPresynapticCell_));
-    ar(CEREAL_NVP(potentialSegmentsForPresynapticCell_));
-    ar(CEREAL_NVP(connectedSegmentsForPresynapticCell_));
-
-    ar(CEREAL_NVP(nextSegmentOrdinal_));
-    ar(CEREAL_NVP(nextSynapseOrdinal_));
+    // Into a new topology, the old one may be shared with copies.
+    auto topology = std::make_shared<Topology>(topology_->resource);
+    ar(cereal::make_nvp("cells_", topology->cells));
+    ar(cereal::make_nvp("segments_", topology->segments));
+    uint8_t permanencePrecision;
+    ar(CEREAL_NVP(permanencePrecision));
+    topology->synapses.permanence.setPrecision(static_cast<PermanencePrecision>(permanencePrecision));
+    topology->synapses.permanence.setConnectedThreshold(connectedThreshold_);
+    ar(cereal::make_nvp("synapses_", topology->synapses));
+
+    ar(cereal::make_nvp("destroyedSynapses_", topology->destroyedSynapses));
+    ar(cereal::make_nvp("destroyedSegments_", topology->destroyedSegments));
+
+    ar(cereal::make_nvp("potentialSynapsesForPresynapticCell_", topology->potentialSynapsesForPresynapticCell));
+    ar(cereal::make_nvp("connectedSynapsesForPresynapticCell_", topology->connectedSynapsesForPresynapticCell));
+    ar(cereal::make_nvp("potentialSegmentsForPresynapticCell_", topology->potentialSegmentsForPresynapticCell));
+    ar(cereal::make_nvp("connectedSegmentsForPresynapticCell_", topology->connectedSegmentsForPresynapticCell));
+
+    ar(cereal::make_nvp("nextSegmentOrdinal_", topology->nextSegmentOrdinal));
+    ar(cereal::make_nvp("nextSynapseOrdinal_", topology->nextSynapseOrdinal));
+    topology_ = std::move(topology); //the flat indexes are rebuilt lazily, if used
 
     ar(CEREAL_NVP(timeseries_));
     ar(CEREAL_NVP(previousUpdates_));
@@ -730,23 +1244,87 @@ public:
     ar(CEREAL_NVP(prunedSegs_));
   }
 
+  /**
+   * Save / load the state to a flat checkpoint, see CheckpointWriter.
+   * Holds the same state as save_ar() / load_ar(), but every member is one
+   * (or a few, for the nested vectors) raw array section, so loading is a
+   * memory map and a memcpy per array rather than parsing each synapse.
+   * The flat indexes are not stored, they are rebuilt lazily after a load.
+   *
+   * @param prefix of the section names, to store several models in one file.
+   */
+  void saveCheckpoint(CheckpointWriter &writer, const std::string &prefix = "connections.") const;
+  void loadCheckpoint(const CheckpointReader &reader, const std::string &prefix = "connections.");
+  void saveCheckpoint(const std::string &path) const;
+  void loadCheckpoint(const std::string &path);
+
+  /**
+   * While alive, save_ar() / load_ar() of all Connections on this thread
+   * don't use the archive, they call `save` / `load` instead. These get a
+   * name for the Connections, "connections<n>." with n counting the
+   * Connections in the order of serialization, so the same Connections gets
+   * the same name when it is loaded.
+   *
+   * The checkpoints of the algorithms and networks store their Connections
+   * like this in sections of their own, e.g. with saveCheckpoint(), and the
+   * rest of the state with cereal. The Connections which are created while
+   * loading, like those of the regions of a Network, are covered too.
+   */
+  class ExternalSerialization {
+  public:
+    using Save = std::function<void(const Connections &connections, const std::string &name)>;
+    using Load = std::function<void(Connections &connections, const std::string &name)>;
+
+    ExternalSerialization(Save save, Load load)
+        : save_(std::move(save)), load_(std::move(load)), outer_(externalSerialization_) {
+      externalSerialization_ = this;
+    }
+    ~ExternalSerialization() { externalSerialization_ = outer_; }
+    ExternalSerialization(const ExternalSerialization &) = delete;
+    ExternalSerialization &operator=(const ExternalSerialization &) = delete;
+
+    void save(const Connections &connections) {
+      NTA_CHECK(save_) << "Connections: no external save";
+      save_(connections, nextName_());
+    }
+    void load(Connections &connections) {
+      NTA_CHECK(load_) << "Connections: no external load";
+      load_(connections, nextName_());
+    }
+
+  private:
+    std::string nextName_() { return "connections" + std::to_string(count_++) + "."; }
+    Save save_;
+    Load load_;
+    ExternalSerialization *outer_;
+    size_t count_ = 0u;
+  };
+
   /**
    * Gets the number of cells.
    *
    * @retval Number of cells.
    */
-  size_t numCells() const noexcept { return cells_.size(); }
+  size_t numCells() const noexcept { return topology_->cells.size(); }
 
   constexpr Permanence getConnectedThreshold() const noexcept { return connectedThreshold_; }
 
+  /**
+   * Gets the number of synapses and segments removed so far by pruning
+   * (adaptSegment with pruneZeroSynapses, and the segment limits of
+   * createSegment / createSynapse).
+   */
+  size_t numPrunedSynapses() const noexcept { return prunedSyns_; }
+  size_t numPrunedSegments() const noexcept { return prunedSegs_; }
+
   /**
    * Gets the number of segments.
    *
    * @retval Number of segments.
    */
   size_t numSegments() const { 
-	  NTA_ASSERT(segments_.size() >= destroyedSegments_);
-	  return segments_.size() - destroyedSegments_; 
+	  NTA_ASSERT(topology_->segments.size() >= topology_->destroyedSegments);
+	  return topology_->segments.size() - topology_->destroyedSegments; 
   }
 
   /**
@@ -755,7 +1333,7 @@ public:
    * @retval Number of segments.
    */
   size_t numSegments(const CellIdx cell) const { 
-	  return cells_[cell].segments.size(); 
+	  return topology_->cells[cell].segments.size(); 
   }
 
   /**
@@ -764,8 +1342,8 @@ public:
    * @retval Number of synapses.
    */
   size_t numSynapses() const {
-    NTA_ASSERT(synapses_.size() >= destroyedSynapses_);
-    return synapses_.size() - destroyedSynapses_;
+    NTA_ASSERT(topology_->synapses.size() >= topology_->destroyedSynapses);
+    return topology_->synapses.size() - topology_->destroyedSynapses;
   }
 
   /**
@@ -774,9 +1352,21 @@ public:
    * @retval Number of synapses.
    */
   size_t numSynapses(const Segment segment) const { 
-	  return segments_[segment].synapses.size(); 
+	  return topology_->segments[segment].synapses.size(); 
   }
 
+  /**
+   * Bytes of memory by category:
+   *   cells, segments, synapses - the flat lists, incl. the destroyed ones
+   *                               until compact()
+   *   presynapticMaps           - the maps from the presynaptic cells
+   *   flatIndex                 - see setFlatIndex()
+   *   caches                    - buffers reused between calls, the timeseries
+   *                               updates
+   * Copies which share the topology (see shareFrom()) each report it in full.
+   */
+  MemoryUsage memoryUsage() const;
+
   /**
    * Comparison operator.
    */
@@ -807,6 +1397,44 @@ public:
    */
   void unsubscribe(UInt32 token);
 
+  /**
+   * Record the changes to a log, the batched alternative to subscribe().
+   *
+   * Each event is appended as a ConnectionsChange to a buffer instead of a
+   * virtual call per handler, the owner takes the records after each step
+   * with takeChangeLog(), eg. for delta checkpoints or replication. The
+   * Connections is changed by one thread at a time, so the buffer is a plain
+   * append without locks. Without handlers and the log, the mutating methods
+   * skip the events with a single test.
+   *
+   * The setting and the records are not serialized, default is off.
+   */
+  void setChangeLog(const bool enable);
+  bool getChangeLog() const noexcept { return changeLogEnabled_; }
+
+  /**
+   * Move the records since the previous call to `out` (its content is
+   * replaced). The buffers are swapped, so taking every step reuses memory.
+   */
+  void takeChangeLog(std::vector<ConnectionsChange> &out);
+
+  /**
+   * Track which segments changed, for a copy of the synapses elsewhere (eg.
+   * on a GPU, see SpatialPoolerGpu) which is updated in batches: a segment
+   * changes when it is created or destroyed, or one of its synapses is
+   * created, destroyed or crosses the connected threshold.
+   *
+   * The setting and the changes are not serialized, default is off.
+   */
+  void setTrackChangedSegments(const bool enable);
+
+  /**
+   * Move the segments changed since the previous call to `out`, each once.
+   * @returns false if all segments must be taken as changed (after compact()
+   *   renumbered them, or shareFrom()), then `out` is empty.
+   */
+  bool takeChangedSegments(std::vector<Segment> &out);
+
 protected:
   /**
    * Check whether this segment still exists on its cell.
@@ -835,6 +1463,13 @@ protected:
    */
   bool synapseExists_(const Synapse synapse, bool fast = false) const;
 
+  /**
+   * createSynapse() without the check for an existing synapse.
+   */
+  Synapse createSynapse_(const Segment segment,
+                         const CellIdx presynapticCell,
+                         Permanence permanence);
+
   /**
    * Remove a synapse from presynaptic maps.
    *
@@ -860,11 +1495,201 @@ protected:
   void pruneLRUSegment_(const CellIdx& cell);
 
 private:
-  std::vector<CellData>    cells_;
-  std::vector<SegmentData> segments_;
-  size_t                   destroyedSegments_ = 0;
-  std::vector<SynapseData> synapses_;
-  size_t                   destroyedSynapses_ = 0;
+  /**
+   * Common start of all `computeActivity()`: auto-compaction, iteration, timeseries.
+   */
+  void startComputeActivity_(const bool learn);
+  /**
+   * Zero (only where touched before) and resize the counters in `activity`.
+   */
+  void resetActivity_(SegmentActivity &activity, const bool countPotential) const;
+  /**
+   * The learning loop of `adaptSegment()` for one segment, synapses to be
+   * pruned are appended to `destroyLater`. Timeseries buffers must be sized already.
+   * `inputArray` is the dense `inputs`, or nullptr for huge inputs.
+   */
+  void adaptSegmentSynapses_(const Segment segment,
+                             const SDR &inputs,
+                             const ElemDense *inputArray,
+                             const Permanence increment,
+                             const Permanence decrement,
+                             const bool pruneZeroSynapses,
+                             std::vector<Synapse> &destroyLater);
+  void prepareFlatIndex_(const bool connected);
+  /**
+   * Move a synapse whose permanence is stored already between the potential and
+   * the connected presynaptic maps (and flat indexes), after its connected state
+   * changed to `connected`.
+   */
+  void reconnectSynapse_(const Synapse synapse, const bool connected, const Permanence permanence);
+  // the members of a checkpoint which are not arrays, also part of each delta
+  void saveCheckpointScalars_(CheckpointWriter &writer, const std::string &prefix) const;
+  void loadCheckpointScalars_(const CheckpointReader &reader, const std::string &prefix);
+  /**
+   * Call visit(segment) for each connected (or potential) synapse of each
+   * cell in the range, the cells are offset by cellOffset.
+   */
+  template<typename Visit>
+  void forEachSegment_(const bool connected,
+                       const CellIdx *cellsBegin, const CellIdx *cellsEnd,
+                       Visit &&visit, const CellIdx cellOffset = 0u) const;
+  /**
+   * Add +1 to `numActiveSynapsesForSegment` for each connected (or potential)
+   * synapse of each active cell (+ cellOffset). Uses the flat index and the
+   * threads, if enabled.
+   */
+  void countSegments_(const bool connected,
+                      const std::vector<CellIdx> &activePresynapticCells,
+                      std::vector<SynapseIdx> &numActiveSynapsesForSegment,
+                      const CellIdx cellOffset = 0u);
+  void countSegmentsRange_(const bool connected,
+                           const CellIdx *cellsBegin, const CellIdx *cellsEnd,
+                           SynapseIdx *numActiveSynapsesForSegment,
+                           const CellIdx cellOffset = 0u) const;
+
+private:
+  /**
+   * Permanences of all synapses, stored with the selected PermanencePrecision.
+   * Only the vector matching the precision is used. Destroyed synapses read as -1.
+   * The quantized modes compare against the connected threshold as integers,
+   * `connectedLevel` is the lowest stored level that is connected.
+   */
+  struct PermanenceArray {
+    explicit PermanenceArray(MemoryResource *resource = nullptr) : f32(resource), u16(resource), u8(resource) {}
+
+    PermanencePrecision        precision = PermanencePrecision::FLOAT32;
+    ResourceVector<Permanence> f32;
+    ResourceVector<UInt16>     u16;
+    ResourceVector<uint8_t>    u8;
+    Real32     steps = 1.0f;    //number of steps between min and maxPermanence
+    Real32     stepSize = 1.0f; //1 / steps
+    Permanence connectedThreshold = 0.0f;
+    UInt32     connectedLevel = 0u;
+
+    static constexpr const UInt16 REMOVED16 = 0xFFFFu;
+    static constexpr const uint8_t  REMOVED8  = 0xFFu;
+
+    size_t size() const noexcept {
+      switch(precision) {
+        case PermanencePrecision::UINT16: return u16.size();
+        case PermanencePrecision::UINT8:  return u8.size();
+        default:                          return f32.size();
+      }
+    }
+    Permanence operator[](const Synapse synapse) const {
+      switch(precision) {
+        case PermanencePrecision::UINT16:
+          return u16[synapse] == REMOVED16 ? -1.0f : static_cast<Permanence>(u16[synapse]) * stepSize;
+        case PermanencePrecision::UINT8:
+          return u8[synapse]  == REMOVED8  ? -1.0f : static_cast<Permanence>(u8[synapse]) * stepSize;
+        default:
+          return f32[synapse];
+      }
+    }
+    bool isConnected(const Synapse synapse) const {
+      switch(precision) {
+        case PermanencePrecision::UINT16: return u16[synapse] >= connectedLevel and u16[synapse] != REMOVED16;
+        case PermanencePrecision::UINT8:  return u8[synapse]  >= connectedLevel and u8[synapse]  != REMOVED8;
+        default:                          return f32[synapse] >= connectedThreshold;
+      }
+    }
+    /** Would a quantized permanence be connected once it was stored? */
+    bool isConnectedValue(const Permanence permanence) const {
+      if(precision == PermanencePrecision::FLOAT32) return permanence >= connectedThreshold;
+      return level(permanence) >= connectedLevel;
+    }
+    /** Nearest stored level of a permanence, clipped to [min, maxPermanence]. */
+    UInt32 level(const Permanence permanence) const {
+      const Real32 clipped = std::min(std::max(permanence, minPermanence), maxPermanence);
+      return static_cast<UInt32>(clipped * steps + 0.5f);
+    }
+    /** The value a permanence will have after it is stored. */
+    Permanence quantize(const Permanence permanence) const {
+      if(precision == PermanencePrecision::FLOAT32) return permanence;
+      return static_cast<Permanence>(level(permanence)) * stepSize;
+    }
+    /** Round a change of permanence away from zero to whole steps, so it always has an effect. */
+    Permanence quantizeDelta(const Permanence delta) const {
+      if(precision == PermanencePrecision::FLOAT32 or delta == 0.0f) return delta;
+      const Real32 numSteps = std::ceil(std::fabs(delta) * steps - 1.0e-3f);
+      return std::copysign(std::max(numSteps, 1.0f) * stepSize, delta);
+    }
+    void set(const Synapse synapse, const Permanence permanence) {
+      switch(precision) {
+        case PermanencePrecision::UINT16: u16[synapse] = static_cast<UInt16>(level(permanence)); break;
+        case PermanencePrecision::UINT8:  u8[synapse]  = static_cast<uint8_t>(level(permanence));  break;
+        default:                          f32[synapse] = permanence;
+      }
+    }
+    /**
+     * Add a (quantized) delta to the permanences of `synapses`, clipped to
+     * [min, maxPermanence]. Synapses whose connected state changed are appended
+     * to `crossed`, the caller must move them in the presynaptic maps.
+     * If the synapses are a contiguous run the loop has no branches and vectorizes.
+     */
+    void bump(const std::vector<Synapse> &synapses, const Permanence delta,
+              std::vector<uint8_t> &scratch, std::vector<Synapse> &crossed);
+    void markRemoved(const Synapse synapse) {
+      switch(precision) {
+        case PermanencePrecision::UINT16: u16[synapse] = REMOVED16; break;
+        case PermanencePrecision::UINT8:  u8[synapse]  = REMOVED8;  break;
+        default:                          f32[synapse] = -1.0f;
+      }
+    }
+    void push_back(const Permanence permanence);
+    void clear();
+    void reserve(const size_t numSynapses);
+    void setPrecision(const PermanencePrecision newPrecision);
+    void setConnectedThreshold(const Permanence threshold);
+    bool operator==(const PermanenceArray &o) const;
+  };
+
+  /**
+   * All synapses, indexed by Synapse, as a structure of arrays. The hot loops
+   * (adaptSegment, synapseCompetition, ...) only touch the permanences and
+   * presynaptic cells, so these are kept in separate, contiguous arrays.
+   * Serialized in the same format as a std::vector<SynapseData>.
+   */
+  struct SynapseArrays {
+    explicit SynapseArrays(MemoryResource *resource = nullptr)
+      : presynapticCell(resource), permanence(resource), segment(resource),
+        presynapticMapIndex(resource), id(resource) {}
+
+    ResourceVector<CellIdx> presynapticCell;
+    PermanenceArray         permanence;
+    ResourceVector<Segment> segment;
+    ResourceVector<Synapse> presynapticMapIndex;
+    ResourceVector<Synapse> id;
+
+    size_t size() const noexcept { return id.size(); }
+    void clear();
+    void reserve(const size_t numSynapses);
+    void push_back(const SynapseData &data);
+    SynapseData operator[](const Synapse synapse) const;
+    bool operator==(const SynapseArrays &o) const;
+
+    template<class Archive>
+    void save_ar(Archive & ar) const {
+      cereal::size_type numSynapses = size();
+      ar(cereal::make_size_tag(numSynapses));
+      for(Synapse syn = 0; syn < size(); syn++) {
+        const SynapseData data = (*this)[syn];
+        ar(data);
+      }
+    }
+    template<class Archive>
+    void load_ar(Archive & ar) {
+      cereal::size_type numSynapses;
+      ar(cereal::make_size_tag(numSynapses));
+      clear();
+      reserve(static_cast<size_t>(numSynapses));
+      for(cereal::size_type i = 0; i < numSynapses; i++) {
+        SynapseData data;
+        ar(data);
+        push_back(data);
+      }
+    }
+  };
   Permanence               connectedThreshold_; //TODO make const
   UInt32 iteration_ = 0;
 
@@ -872,27 +1697,123 @@ private:
  
   struct identity { constexpr size_t operator()( const CellIdx t ) const noexcept { return t; };   };	//TODO in c++20 use std::identity 
 
-  std::unordered_map<CellIdx, std::vector<Synapse>, identity> potentialSynapsesForPresynapticCell_;
-  std::unordered_map<CellIdx, std::vector<Synapse>, identity> connectedSynapsesForPresynapticCell_;
-  std::unordered_map<CellIdx, std::vector<Segment>, identity> potentialSegmentsForPresynapticCell_;
-  std::unordered_map<CellIdx, std::vector<Segment>, identity> connectedSegmentsForPresynapticCell_;
 
-  Segment nextSegmentOrdinal_ = 0;
-  Synapse nextSynapseOrdinal_ = 0;
+  /**
+   * Flat copy of one of the `*SegmentsForPresynapticCell_` maps, see `setFlatIndex()`.
+   * Segments of presynaptic cell `c` are `segments[begin[c] .. begin[c] + size[c])`,
+   * the remaining entries up to `begin[c+1]` are spare capacity for in-place updates.
+   * If an update does not fit, the index is invalidated and rebuilt on next use.
+   * A row keeps the order of the map's vector (append, swap-remove at the
+   * synapse's presynapticMapIndex), so erasing is O(1) too.
+   */
+  struct FlatIndex {
+    explicit FlatIndex(MemoryResource *resource = nullptr) : begin(resource), size(resource), segments(resource) {}
+
+    bool valid = false;
+    ResourceVector<UInt32>  begin;
+    ResourceVector<UInt32>  size;
+    ResourceVector<Segment> segments;
+
+    void build(const std::unordered_map<CellIdx, std::vector<Segment>, identity> &segmentsForPresynapticCell);
+    void insert(const CellIdx cell, const Segment segment);
+    void erase(const CellIdx cell, const Synapse index, const Segment segment);
+    void clear();
+  };
+  bool      useFlatIndex_ = false;
+  bool      sampledGrowth_ = false; // see setSampledGrowth()
+
+  /**
+   * The learned state: the cells, segments and synapses, and the indexes over
+   * them. Copies of a Connections share it until one of them changes it, see
+   * mutable_(), so copying a trained model for inference costs little memory.
+   */
+  struct Topology {
+    explicit Topology(const std::shared_ptr<MemoryResource> &memory = nullptr)
+      : resource(memory), cells(memory.get()), segments(memory.get()), synapses(memory.get()),
+        connectedFlatIndex(memory.get()), potentialFlatIndex(memory.get()) {}
+
+    // Of the arrays, null for operator new; first, so that it is released last.
+    std::shared_ptr<MemoryResource> resource;
+    ResourceVector<CellData>    cells;
+    ResourceVector<SegmentData> segments;
+    size_t                   destroyedSegments = 0;
+    SynapseArrays            synapses;
+    size_t                   destroyedSynapses = 0;
+    std::unordered_map<CellIdx, std::vector<Synapse>, identity> potentialSynapsesForPresynapticCell;
+    std::unordered_map<CellIdx, std::vector<Synapse>, identity> connectedSynapsesForPresynapticCell;
+    std::unordered_map<CellIdx, std::vector<Segment>, identity> potentialSegmentsForPresynapticCell;
+    std::unordered_map<CellIdx, std::vector<Segment>, identity> connectedSegmentsForPresynapticCell;
+    FlatIndex connectedFlatIndex;
+    FlatIndex potentialFlatIndex;
+    Segment nextSegmentOrdinal = 0;
+    Synapse nextSynapseOrdinal = 0;
+  };
+  std::shared_ptr<const Topology> topology_ = std::make_shared<Topology>();
+  /** The topology for writing, copied first if it is shared with another Connections. */
+  Topology &mutable_();
+
+  Real                                 compactThreshold_ = 0.0f; //see setCompactThreshold()
+  // reused buffers of bumpSegment(), synapseCompetition() and growSynapses(), not serialized
+  std::vector<uint8_t>    bumpScratch_;
+  std::vector<Synapse>    bumpCrossed_;
+  std::vector<Permanence> competitionScratch_;
+  std::vector<CellIdx>    growCandidates_;
+  std::vector<UInt64>     growMask_; //bit per presynaptic cell, all clear between calls
+  std::vector<CellIdx>    growNew_;
+  static constexpr CellIdx GROW_MASK_CELLS = 1u << 24; //larger cell indexes are not in growMask_
+  SegmentEviction                      segmentEviction_ = SegmentEviction::LRU; //see setSegmentEviction()
+  UInt                                 evictionSampleSize_ = 4u;
+  Random                               evictionRng_{42u};
+  std::shared_ptr<ThreadPool>          threadPool_; //null: single threaded, see setNumThreads()
+  std::vector<std::vector<SynapseIdx>> partialCounts_; //per thread counters but the caller's
+  std::shared_ptr<SynapseBudget>         budget_; //see setSynapseBudget(), not serialized
+  std::shared_ptr<SynapseBudget::Member> budgetMember_;
+  bool                                   budgetDestroysSegments_ = true;
+  size_t                                 budgetPrunedSynapses_ = 0u;
+  void pruneToBudget_();
+
 
   // These three members should be used when working with highly correlated
   // data. The vectors store the permanence changes made by adaptSegment.
+  // Sparse: only the synapses adapted in the previous / current step are kept,
+  // a synapse which is not there had no update (minPermanence).
   bool timeseries_;
-  std::vector<Permanence> previousUpdates_;
-  std::vector<Permanence> currentUpdates_;
+  std::unordered_map<Synapse, Permanence, identity> previousUpdates_;
+  std::unordered_map<Synapse, Permanence, identity> currentUpdates_;
+  Permanence previousUpdate_(const Synapse synapse) const {
+    const auto it = previousUpdates_.find(synapse);
+    return it == previousUpdates_.end() ? minPermanence : it->second;
+  }
 
   //for prune statistics
   Synapse prunedSyns_ = 0; //how many synapses have been removed?
   Segment prunedSegs_ = 0;
 
+  static inline thread_local ExternalSerialization *externalSerialization_ = nullptr;
+
   //for listeners //TODO listeners are not serialized, nor included in equals ==
-  UInt32 nextEventToken_;
+  UInt32 nextEventToken_ = 0u;
   std::map<UInt32, ConnectionsEventHandler *> eventHandlers_;
+  bool changeLogEnabled_ = false;
+  std::vector<ConnectionsChange> changeLog_;
+  bool observed_ = false; //any handler, the change log or the tracking, see notify_()
+
+  /** Send an event to the change log and the handlers, if there are any. */
+  template<typename Dispatch>
+  void notify_(const ConnectionsChange::Kind kind, const UInt32 id, const Permanence value, Dispatch &&dispatch) {
+    if(not observed_) return;
+    if(changeLogEnabled_) changeLog_.push_back({kind, id, value});
+    if(trackChangedSegments_) segmentChanged_(kind, id);
+    for(const auto &h : eventHandlers_) dispatch(h.second);
+  }
+  void updateObserved_() { observed_ = changeLogEnabled_ or trackChangedSegments_ or not eventHandlers_.empty(); }
+
+  // see setTrackChangedSegments()
+  bool trackChangedSegments_ = false;
+  bool allSegmentsChanged_ = false;
+  std::vector<Segment> changedSegments_;
+  std::vector<bool>    isChangedSegment_; //by Segment, the members of changedSegments_
+  void segmentChanged_(const ConnectionsChange::Kind kind, const UInt32 id);
 }; // end class Connections
 
 } // end namespace htm
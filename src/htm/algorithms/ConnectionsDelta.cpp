@@ -0,0 +1,317 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the ConnectionsDelta class
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include <htm/algorithms/ConnectionsDelta.hpp>
+
+using std::string;
+using std::vector;
+using namespace htm;
+
+namespace {
+const size_t BLOCK_BYTES = 4096u;
+
+template<typename Key>
+vector<Key> sorted(const std::unordered_set<Key> &keys) {
+  vector<Key> result(keys.begin(), keys.end());
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+// An array as the blocks which differ from the same array in the base.
+template<typename T, typename A>
+void writeArray(CheckpointWriter &writer, const CheckpointReader &base, const string &name, const vector<T, A> &values) {
+  const auto old = base.view<T>(name);
+  const size_t perBlock = BLOCK_BYTES / sizeof(T);
+  vector<UInt64> blocks;
+  vector<T> changed;
+  for(size_t begin = 0; begin < values.size(); begin += perBlock) {
+    const size_t end = std::min(values.size(), begin + perBlock);
+    if(end <= old.second and std::memcmp(values.data() + begin, old.first + begin, (end - begin) * sizeof(T)) == 0)
+      continue;
+    blocks.push_back(begin / perBlock);
+    changed.insert(changed.end(), values.begin() + begin, values.begin() + end);
+  }
+  writer.writeValue(name + ".size", static_cast<UInt64>(values.size()));
+  writer.write(name + ".blocks", blocks);
+  writer.write(name, changed);
+}
+
+// `values` hold the base and are updated
+template<typename T, typename A>
+void readArray(const CheckpointReader &delta, const string &name, vector<T, A> &values) {
+  values.resize(static_cast<size_t>(delta.readValue<UInt64>(name + ".size")));
+  const auto blocks  = delta.view<UInt64>(name + ".blocks");
+  const auto changed = delta.view<T>(name);
+  const size_t perBlock = BLOCK_BYTES / sizeof(T);
+  size_t pos = 0;
+  for(size_t i = 0; i < blocks.second; i++) {
+    const size_t begin = static_cast<size_t>(blocks.first[i]) * perBlock;
+    NTA_CHECK(begin < values.size()) << "Connections delta: section " << name << " is inconsistent";
+    const size_t n = std::min(perBlock, values.size() - begin);
+    NTA_CHECK(pos + n <= changed.second) << "Connections delta: section " << name << " is inconsistent";
+    std::memcpy(values.data() + begin, changed.first + pos, n * sizeof(T));
+    pos += n;
+  }
+  NTA_CHECK(pos == changed.second) << "Connections delta: section " << name << " is inconsistent";
+}
+
+// Some rows of a nested vector, as keys, UInt64 offsets and the values.
+template<typename Key, typename Row>
+void writeRows(CheckpointWriter &writer, const string &name, const vector<Key> &keys, Row row) {
+  using Value = typename std::decay<decltype(row(keys.front()))>::type::value_type;
+  vector<UInt64> offsets{0u};
+  vector<Value> values;
+  for(const auto key : keys) {
+    const auto &r = row(key);
+    values.insert(values.end(), r.begin(), r.end());
+    offsets.push_back(values.size());
+  }
+  writer.write(name + ".keys", keys);
+  writer.write(name + ".offsets", offsets);
+  writer.write(name, values);
+}
+
+template<typename Key, typename Value, typename Assign>
+void readRows(const CheckpointReader &delta, const string &name, Assign assign) {
+  const auto keys    = delta.view<Key>(name + ".keys");
+  const auto offsets = delta.view<UInt64>(name + ".offsets");
+  const auto values  = delta.view<Value>(name);
+  NTA_CHECK(offsets.second == keys.second + 1u and offsets.first[keys.second] == values.second)
+    << "Connections delta: section " << name << " is inconsistent";
+  for(size_t i = 0; i < keys.second; i++) {
+    NTA_CHECK(offsets.first[i] <= offsets.first[i + 1u]) << "Connections delta: section " << name << " is inconsistent";
+    assign(keys.first[i], values.first + offsets.first[i], values.first + offsets.first[i + 1u]);
+  }
+}
+
+// The rows of the changed presynaptic cells; erased ones are stored empty, with present = 0.
+template<typename Map>
+void writeMapRows(CheckpointWriter &writer, const string &name, const vector<CellIdx> &keys, const Map &map) {
+  const typename Map::mapped_type none;
+  vector<uint8_t> present;
+  for(const auto key : keys) present.push_back(map.count(key) > 0u);
+  writer.write(name + ".present", present);
+  writeRows(writer, name, keys, [&](const CellIdx key) -> const typename Map::mapped_type & {
+    const auto it = map.find(key);
+    return it == map.end() ? none : it->second;
+  });
+}
+
+template<typename Map>
+void readMapRows(const CheckpointReader &delta, const string &name, Map &map) {
+  using Value = typename Map::mapped_type::value_type;
+  const auto present = delta.view<uint8_t>(name + ".present");
+  size_t i = 0;
+  readRows<CellIdx, Value>(delta, name, [&](const CellIdx key, const Value *begin, const Value *end) {
+    NTA_CHECK(i < present.second) << "Connections delta: section " << name << " is inconsistent";
+    if(present.first[i++]) map[key].assign(begin, end);
+    else                   map.erase(key);
+  });
+}
+} // namespace
+
+
+struct ConnectionsDelta::Tracker : public ConnectionsEventHandler {
+  explicit Tracker(const Connections &connections) : connections(connections) {}
+
+  void onCreateSegment(Segment segment) override {
+    segments.insert(segment);
+    cells.insert(connections.cellForSegment(segment));
+  }
+  void onDestroySegment(Segment segment) override {
+    onCreateSegment(segment);
+  }
+  void onCreateSynapse(Synapse synapse) override {
+    segments.insert(connections.segmentForSynapse(synapse));
+    presynapticCells.insert(connections.presynapticCellForSynapse(synapse));
+  }
+  void onDestroySynapse(Synapse synapse) override {
+    onCreateSynapse(synapse);
+  }
+  void onUpdateSynapsePermanence(Synapse synapse, Permanence) override { //only when it (dis)connects
+    presynapticCells.insert(connections.presynapticCellForSynapse(synapse));
+  }
+  void onCompact(const vector<Segment> &, const vector<Synapse> &) override {
+    compacted = true;
+  }
+
+  void clear() {
+    segments.clear();
+    cells.clear();
+    presynapticCells.clear();
+    compacted = false;
+  }
+
+  const Connections &connections;
+  std::unordered_set<Segment> segments;
+  std::unordered_set<CellIdx> cells;
+  std::unordered_set<CellIdx> presynapticCells;
+  bool hasBase   = false;
+  bool compacted = false;
+};
+
+
+ConnectionsDelta::ConnectionsDelta(Connections &connections)
+    : connections_(connections), tracker_(new Tracker(connections)) {
+  token_ = connections_.subscribe(tracker_);
+}
+
+ConnectionsDelta::~ConnectionsDelta() {
+  connections_.unsubscribe(token_); //deletes the tracker
+}
+
+bool ConnectionsDelta::needsBase() const {
+  return not tracker_->hasBase or tracker_->compacted;
+}
+
+size_t ConnectionsDelta::numChangedSegments() const { return tracker_->segments.size(); }
+size_t ConnectionsDelta::numChangedCells() const { return tracker_->cells.size(); }
+size_t ConnectionsDelta::numChangedPresynapticCells() const { return tracker_->presynapticCells.size(); }
+
+
+void ConnectionsDelta::saveBase(CheckpointWriter &writer, const string &prefix) {
+  connections_.saveCheckpoint(writer, prefix);
+  tracker_->clear();
+  tracker_->hasBase = true;
+}
+
+
+void ConnectionsDelta::saveDelta(CheckpointWriter &writer, const CheckpointReader &base, const string &prefix) const {
+  NTA_CHECK(not needsBase()) << "ConnectionsDelta: save a new base first, the connections "
+                             << (tracker_->hasBase ? "were compacted" : "have no base");
+  const Connections &c = connections_;
+  const auto &perm = c.topology_->synapses.permanence;
+  NTA_CHECK(base.readValue<uint8_t>(prefix + "synapses.precision") == static_cast<uint8_t>(perm.precision))
+    << "ConnectionsDelta: the permanence precision changed since the base, save a new base first";
+  c.saveCheckpointScalars_(writer, prefix);
+
+  switch(perm.precision) {
+    case PermanencePrecision::UINT16: writeArray(writer, base, prefix + "synapses.permanence", perm.u16); break;
+    case PermanencePrecision::UINT8:  writeArray(writer, base, prefix + "synapses.permanence", perm.u8);  break;
+    default:                          writeArray(writer, base, prefix + "synapses.permanence", perm.f32);
+  }
+  writeArray(writer, base, prefix + "synapses.presynapticCell", c.topology_->synapses.presynapticCell);
+  writeArray(writer, base, prefix + "synapses.segment", c.topology_->synapses.segment);
+  writeArray(writer, base, prefix + "synapses.presynapticMapIndex", c.topology_->synapses.presynapticMapIndex);
+  writeArray(writer, base, prefix + "synapses.id", c.topology_->synapses.id);
+
+  const size_t numSegments = c.topology_->segments.size();
+  vector<CellIdx> segCell(numSegments);
+  vector<SynapseIdx> segNumConnected(numSegments);
+  vector<UInt32> segLastUsed(numSegments);
+  vector<Segment> segId(numSegments);
+  for(size_t i = 0; i < numSegments; i++) {
+    segCell[i]         = c.topology_->segments[i].cell;
+    segNumConnected[i] = c.topology_->segments[i].numConnected;
+    segLastUsed[i]     = c.topology_->segments[i].lastUsed;
+    segId[i]           = c.topology_->segments[i].id;
+  }
+  writeArray(writer, base, prefix + "segments.cell", segCell);
+  writeArray(writer, base, prefix + "segments.numConnected", segNumConnected);
+  writeArray(writer, base, prefix + "segments.lastUsed", segLastUsed);
+  writeArray(writer, base, prefix + "segments.id", segId);
+
+  writeRows(writer, prefix + "segments.synapses", sorted(tracker_->segments),
+            [&](const Segment segment) -> const vector<Synapse> & { return c.topology_->segments[segment].synapses; });
+  writeRows(writer, prefix + "cells.segments", sorted(tracker_->cells),
+            [&](const CellIdx cell) -> const vector<Segment> & { return c.topology_->cells[cell].segments; });
+
+  const auto presyns = sorted(tracker_->presynapticCells);
+  writeMapRows(writer, prefix + "potentialSynapsesForPresynapticCell", presyns, c.topology_->potentialSynapsesForPresynapticCell);
+  writeMapRows(writer, prefix + "connectedSynapsesForPresynapticCell", presyns, c.topology_->connectedSynapsesForPresynapticCell);
+  writeMapRows(writer, prefix + "potentialSegmentsForPresynapticCell", presyns, c.topology_->potentialSegmentsForPresynapticCell);
+  writeMapRows(writer, prefix + "connectedSegmentsForPresynapticCell", presyns, c.topology_->connectedSegmentsForPresynapticCell);
+}
+
+
+void ConnectionsDelta::load(Connections &c, const CheckpointReader &base, const CheckpointReader &delta, const string &prefix) {
+  c.loadCheckpoint(base, prefix);
+  Connections::Topology &topology = c.mutable_(); //just loaded, not shared
+  auto &perm = topology.synapses.permanence;
+  NTA_CHECK(delta.readValue<uint8_t>(prefix + "synapses.precision") == static_cast<uint8_t>(perm.precision) and
+            delta.readValue<UInt64>(prefix + "numCells") == topology.cells.size())
+    << "ConnectionsDelta: the delta does not belong to this base";
+  c.loadCheckpointScalars_(delta, prefix);
+  perm.setConnectedThreshold(c.connectedThreshold_);
+
+  switch(perm.precision) {
+    case PermanencePrecision::UINT16: readArray(delta, prefix + "synapses.permanence", perm.u16); break;
+    case PermanencePrecision::UINT8:  readArray(delta, prefix + "synapses.permanence", perm.u8);  break;
+    default:                          readArray(delta, prefix + "synapses.permanence", perm.f32);
+  }
+  readArray(delta, prefix + "synapses.presynapticCell", topology.synapses.presynapticCell);
+  readArray(delta, prefix + "synapses.segment", topology.synapses.segment);
+  readArray(delta, prefix + "synapses.presynapticMapIndex", topology.synapses.presynapticMapIndex);
+  readArray(delta, prefix + "synapses.id", topology.synapses.id);
+  const size_t numSynapses = topology.synapses.id.size();
+  NTA_CHECK(perm.size() == numSynapses and topology.synapses.presynapticCell.size() == numSynapses and
+            topology.synapses.segment.size() == numSynapses and topology.synapses.presynapticMapIndex.size() == numSynapses)
+    << "Connections delta: the synapse sections are inconsistent";
+
+  const size_t numBaseSegments = topology.segments.size();
+  vector<CellIdx> segCell(numBaseSegments);
+  vector<SynapseIdx> segNumConnected(numBaseSegments);
+  vector<UInt32> segLastUsed(numBaseSegments);
+  vector<Segment> segId(numBaseSegments);
+  for(size_t i = 0; i < numBaseSegments; i++) {
+    segCell[i]         = topology.segments[i].cell;
+    segNumConnected[i] = topology.segments[i].numConnected;
+    segLastUsed[i]     = topology.segments[i].lastUsed;
+    segId[i]           = topology.segments[i].id;
+  }
+  readArray(delta, prefix + "segments.cell", segCell);
+  readArray(delta, prefix + "segments.numConnected", segNumConnected);
+  readArray(delta, prefix + "segments.lastUsed", segLastUsed);
+  readArray(delta, prefix + "segments.id", segId);
+  const size_t numSegments = static_cast<size_t>(delta.readValue<UInt64>(prefix + "numSegments"));
+  NTA_CHECK(segCell.size() == numSegments and segNumConnected.size() == numSegments and
+            segLastUsed.size() == numSegments and segId.size() == numSegments)
+    << "Connections delta: the segment sections are inconsistent";
+  topology.segments.resize(numSegments);
+  for(size_t i = 0; i < numSegments; i++) {
+    topology.segments[i].cell         = segCell[i];
+    topology.segments[i].numConnected = segNumConnected[i];
+    topology.segments[i].lastUsed     = segLastUsed[i];
+    topology.segments[i].id           = segId[i];
+  }
+
+  readRows<Segment, Synapse>(delta, prefix + "segments.synapses",
+    [&](const Segment segment, const Synapse *begin, const Synapse *end) {
+      NTA_CHECK(segment < numSegments) << "Connections delta: segment " << segment << " out of range";
+      topology.segments[segment].synapses.assign(begin, end);
+    });
+  readRows<CellIdx, Segment>(delta, prefix + "cells.segments",
+    [&](const CellIdx cell, const Segment *begin, const Segment *end) {
+      NTA_CHECK(cell < topology.cells.size()) << "Connections delta: cell " << cell << " out of range";
+      topology.cells[cell].segments.assign(begin, end);
+    });
+
+  readMapRows(delta, prefix + "potentialSynapsesForPresynapticCell", topology.potentialSynapsesForPresynapticCell);
+  readMapRows(delta, prefix + "connectedSynapsesForPresynapticCell", topology.connectedSynapsesForPresynapticCell);
+  readMapRows(delta, prefix + "potentialSegmentsForPresynapticCell", topology.potentialSegmentsForPresynapticCell);
+  readMapRows(delta, prefix + "connectedSegmentsForPresynapticCell", topology.connectedSegmentsForPresynapticCell);
+
+  topology.connectedFlatIndex.valid = false; //rebuilt lazily, if used
+  topology.potentialFlatIndex.valid = false;
+}
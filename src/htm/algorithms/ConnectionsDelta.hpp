@@ -0,0 +1,93 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the ConnectionsDelta class
+ */
+
+#ifndef NTA_CONNECTIONS_DELTA_HPP
+#define NTA_CONNECTIONS_DELTA_HPP
+
+#include <string>
+#include <unordered_set>
+
+#include <htm/algorithms/Connections.hpp>
+#include <htm/utils/Checkpoint.hpp>
+
+namespace htm {
+
+/**
+ * Incremental checkpoints of a Connections. After a base checkpoint,
+ * saveDelta() writes only what changed since that base.
+ *
+ * The structural changes (segments and synapses created or destroyed,
+ * synapses which (dis)connect) are recorded with a ConnectionsEventHandler,
+ * they select the per segment, per cell and per presynaptic cell lists which
+ * go into a delta. The flat arrays indexed by Synapse or Segment
+ * (permanences, lastUsed, ...) also change without events, these are
+ * compared with the memory mapped base in blocks of 4 KiB instead, only the
+ * blocks which differ are stored.
+ *
+ * Deltas are cumulative: the state is restored from the base and the latest
+ * delta alone, see load(). They grow as the model learns; compact them by
+ * writing a new base with saveBase() from time to time.
+ * Connections::compact() renumbers all segments and synapses, afterwards a
+ * new base is required, see needsBase().
+ *
+ * The Connections must outlive this object, it is subscribed to its events.
+ */
+class ConnectionsDelta {
+public:
+  explicit ConnectionsDelta(Connections &connections);
+  ~ConnectionsDelta();
+  ConnectionsDelta(const ConnectionsDelta &) = delete;
+  ConnectionsDelta &operator=(const ConnectionsDelta &) = delete;
+
+  /** Saves a full checkpoint (Connections::saveCheckpoint) and tracks the changes from it. */
+  void saveBase(CheckpointWriter &writer, const std::string &prefix = "connections.");
+
+  /**
+   * Saves the changes since the last saveBase().
+   * @param base - the checkpoint written by that saveBase().
+   */
+  void saveDelta(CheckpointWriter &writer, const CheckpointReader &base,
+                 const std::string &prefix = "connections.") const;
+
+  /** Restores `connections` from a base and a delta of it. */
+  static void load(Connections &connections, const CheckpointReader &base,
+                   const CheckpointReader &delta, const std::string &prefix = "connections.");
+
+  /** No base was saved yet, or the connections were compacted since. */
+  bool needsBase() const;
+
+  const Connections &getConnections() const noexcept { return connections_; }
+
+  // Sizes of the tracked changes, since the base.
+  size_t numChangedSegments() const;
+  size_t numChangedCells() const;
+  size_t numChangedPresynapticCells() const;
+
+private:
+  struct Tracker;
+  Connections &connections_;
+  Tracker *tracker_; // owned by connections_, see Connections::subscribe()
+  UInt32 token_;
+};
+
+} // namespace htm
+
+#endif // NTA_CONNECTIONS_DELTA_HPP
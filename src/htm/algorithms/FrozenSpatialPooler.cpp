@@ -0,0 +1,128 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the FrozenSpatialPooler
+ */
+
+#include <algorithm>
+
+#include <htm/algorithms/FrozenSpatialPooler.hpp>
+#include <htm/utils/Log.hpp>
+
+using namespace std;
+using namespace htm;
+
+
+FrozenSpatialPooler::FrozenSpatialPooler(const SpatialPooler &sp)
+  : inputDimensions_(sp.getInputDimensions()),
+    columnDimensions_(sp.getColumnDimensions()),
+    numInputs_(sp.getNumInputs()),
+    numColumns_(sp.getNumColumns()),
+    globalInhibition_(sp.isGlobalInhibition_()),
+    density_(sp.inhibitionDensity_()),
+    stimulusThreshold_(sp.getStimulusThreshold()),
+    inhibitionRadius_(sp.getInhibitionRadius()),
+    wrapAround_(sp.getWrapAround()) {
+  const Connections &connections = sp.getConnections();
+
+  // Count the connected synapses per input bit, then fill the rows. The
+  // columns of each row are in ascending order.
+  inputBegin_.assign(numInputs_ + 1u, 0u);
+  for(UInt column = 0; column < numColumns_; column++) {
+    for(const auto segment : connections.segmentsForCell(column)) {
+      for(const auto synapse : connections.synapsesForSegment(segment)) {
+        if(connections.isConnected(synapse)) {
+          inputBegin_[connections.presynapticCellForSynapse(synapse) + 1u]++;
+        }
+      }
+    }
+  }
+  for(UInt input = 0; input < numInputs_; input++) {
+    inputBegin_[input + 1u] += inputBegin_[input];
+  }
+  connectedColumns_.resize(inputBegin_[numInputs_]);
+  vector<UInt32> next(inputBegin_.begin(), inputBegin_.end() - 1);
+  for(UInt column = 0; column < numColumns_; column++) {
+    for(const auto segment : connections.segmentsForCell(column)) {
+      for(const auto synapse : connections.synapsesForSegment(segment)) {
+        if(connections.isConnected(synapse)) {
+          connectedColumns_[next[connections.presynapticCellForSynapse(synapse)]++] = column;
+        }
+      }
+    }
+  }
+
+  if(sp.getBoostStrength() >= htm::Epsilon) {
+    boostFactors_.resize(numColumns_);
+    sp.getBoostFactors(boostFactors_.data());
+  }
+}
+
+
+const vector<SynapseIdx> &FrozenSpatialPooler::compute(const SDR &input, SDR &active) {
+  input.reshape(  inputDimensions_ );
+  active.reshape( columnDimensions_ );
+
+  // Zero the columns of the previous input only.
+  if(overlaps_.size() != numColumns_) {
+    overlaps_.assign(numColumns_, 0u);
+    boostedOverlaps_.assign(numColumns_, 0.0f);
+    touched_.clear();
+  }
+  for(const auto column : touched_) {
+    overlaps_[column] = 0u;
+    boostedOverlaps_[column] = 0.0f;
+  }
+  touched_.clear();
+
+  for(const auto input : input.getSparse()) {
+    const CellIdx *it  = connectedColumns_.data() + inputBegin_[input];
+    const CellIdx *end = connectedColumns_.data() + inputBegin_[input + 1u];
+    for( ; it != end; ++it) {
+      if(overlaps_[*it]++ == 0u) touched_.push_back(*it);
+    }
+  }
+
+  if(boostFactors_.empty()) {
+    for(const auto column : touched_) boostedOverlaps_[column] = static_cast<Real>(overlaps_[column]);
+  } else {
+    for(const auto column : touched_) boostedOverlaps_[column] = overlaps_[column] * boostFactors_[column];
+  }
+
+  auto activeVector = globalInhibition_ ?
+      SpatialPooler::inhibitColumnsGlobal(boostedOverlaps_, density_, stimulusThreshold_, &touched_) :
+      SpatialPooler::inhibitColumnsLocal(boostedOverlaps_, density_, stimulusThreshold_,
+                                         columnDimensions_, inhibitionRadius_, wrapAround_);
+  sort( activeVector.begin(), activeVector.end() );
+  active.setSparse( activeVector );
+  return overlaps_;
+}
+
+
+bool FrozenSpatialPooler::operator==(const FrozenSpatialPooler &o) const {
+  return inputDimensions_   == o.inputDimensions_ and
+         columnDimensions_  == o.columnDimensions_ and
+         inputBegin_        == o.inputBegin_ and
+         connectedColumns_  == o.connectedColumns_ and
+         boostFactors_      == o.boostFactors_ and
+         globalInhibition_  == o.globalInhibition_ and
+         density_           == o.density_ and
+         stimulusThreshold_ == o.stimulusThreshold_ and
+         inhibitionRadius_  == o.inhibitionRadius_ and
+         wrapAround_        == o.wrapAround_;
+}
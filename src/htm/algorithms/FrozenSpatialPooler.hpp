@@ -0,0 +1,135 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the inference only FrozenSpatialPooler
+ */
+
+#ifndef NTA_FROZEN_SPATIAL_POOLER_HPP
+#define NTA_FROZEN_SPATIAL_POOLER_HPP
+
+#include <vector>
+#include <htm/algorithms/SpatialPooler.hpp>
+#include <htm/types/Types.hpp>
+#include <htm/types/Serializable.hpp>
+#include <htm/types/Sdr.hpp>
+
+namespace htm {
+
+/**
+ * Read-only snapshot of a trained SpatialPooler, for inference.
+ *
+ * Keeps only the connected synapses, as a list of connected columns per
+ * input bit (CSR), the boost factors and the inhibition parameters. No
+ * potential pools, permanences, duty cycles or Connections, so it is much
+ * smaller in memory and when serialized.
+ *
+ * compute(input, active) gives the same active columns as
+ * SpatialPooler::compute(input, false, active) of the SP it was made from.
+ * Later changes to that SP are not seen.
+ *
+ * Example usage:
+ *
+ *     SpatialPooler sp(...);
+ *     <train sp>
+ *     FrozenSpatialPooler frozen(sp);
+ *     frozen.compute(input, active);
+ */
+class FrozenSpatialPooler : public Serializable
+{
+public:
+  FrozenSpatialPooler() {}
+  explicit FrozenSpatialPooler(const SpatialPooler &sp);
+
+  /**
+   * Same as SpatialPooler::compute(input, false, active).
+   *
+   * @return the overlap of each column, valid until the next compute().
+   */
+  const vector<SynapseIdx> &compute(const SDR &input, SDR &active);
+
+  const vector<UInt> &getInputDimensions() const { return inputDimensions_; }
+  const vector<UInt> &getColumnDimensions() const { return columnDimensions_; }
+  UInt getNumInputs() const { return numInputs_; }
+  UInt getNumColumns() const { return numColumns_; }
+  /** @return total number of connected synapses */
+  size_t getNumSynapses() const { return connectedColumns_.size(); }
+
+  CerealAdapter;  // see Serializable.hpp
+  template<class Archive>
+  void save_ar(Archive& ar) const {
+    ar(CEREAL_NVP(inputDimensions_),
+       CEREAL_NVP(columnDimensions_),
+       CEREAL_NVP(numInputs_),
+       CEREAL_NVP(numColumns_),
+       CEREAL_NVP(inputBegin_),
+       CEREAL_NVP(connectedColumns_),
+       CEREAL_NVP(boostFactors_),
+       CEREAL_NVP(globalInhibition_),
+       CEREAL_NVP(density_),
+       CEREAL_NVP(stimulusThreshold_),
+       CEREAL_NVP(inhibitionRadius_),
+       CEREAL_NVP(wrapAround_));
+  }
+  template<class Archive>
+  void load_ar(Archive& ar) {
+    ar(CEREAL_NVP(inputDimensions_),
+       CEREAL_NVP(columnDimensions_),
+       CEREAL_NVP(numInputs_),
+       CEREAL_NVP(numColumns_),
+       CEREAL_NVP(inputBegin_),
+       CEREAL_NVP(connectedColumns_),
+       CEREAL_NVP(boostFactors_),
+       CEREAL_NVP(globalInhibition_),
+       CEREAL_NVP(density_),
+       CEREAL_NVP(stimulusThreshold_),
+       CEREAL_NVP(inhibitionRadius_),
+       CEREAL_NVP(wrapAround_));
+    overlaps_.clear();
+    boostedOverlaps_.clear();
+    touched_.clear();
+  }
+
+  bool operator==(const FrozenSpatialPooler &o) const;
+  inline bool operator!=(const FrozenSpatialPooler &o) const { return !operator==(o); }
+
+private:
+  vector<UInt>    inputDimensions_;
+  vector<UInt>    columnDimensions_;
+  UInt            numInputs_  = 0u;
+  UInt            numColumns_ = 0u;
+
+  // The columns with a connected synapse to input bit i are
+  // connectedColumns_[inputBegin_[i] .. inputBegin_[i + 1]).
+  vector<UInt32>  inputBegin_;
+  vector<CellIdx> connectedColumns_;
+
+  vector<Real>    boostFactors_; //empty if the SP had no boosting
+  bool            globalInhibition_  = true;
+  Real            density_           = 0.0f;
+  UInt            stimulusThreshold_ = 0u;
+  UInt            inhibitionRadius_  = 0u;
+  bool            wrapAround_        = true;
+
+  // reused by compute(), not serialized
+  vector<SynapseIdx> overlaps_;
+  vector<Real>       boostedOverlaps_;
+  vector<CellIdx>    touched_; //the columns with overlap > 0
+};
+
+} // end namespace htm
+#endif // NTA_FROZEN_SPATIAL_POOLER_HPP
@@ -0,0 +1,155 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the FrozenTemporalMemory
+ */
+
+#include <algorithm>
+
+#include <htm/algorithms/FrozenTemporalMemory.hpp>
+#include <htm/algorithms/Anomaly.hpp>
+#include <htm/utils/Log.hpp>
+
+using namespace std;
+using namespace htm;
+
+
+FrozenTemporalMemory::FrozenTemporalMemory(const TemporalMemory &tm)
+  : columnDimensions_(tm.getColumnDimensions()),
+    cellsPerColumn_(static_cast<CellIdx>(tm.getCellsPerColumn())),
+    numCells_(static_cast<CellIdx>(tm.numberOfCells())),
+    activationThreshold_(tm.getActivationThreshold()) {
+  NTA_CHECK(activationThreshold_ > 0u) << "FrozenTemporalMemory: activationThreshold must be at least 1.";
+  const Connections &connections = tm.connections;
+
+  // Number the segments which can become active in cell order, and count
+  // their connected synapses per presynaptic cell.
+  presynapticBegin_.assign(numCells_ + 1u, 0u);
+  vector<Segment> kept;
+  for(CellIdx cell = 0; cell < numCells_; cell++) {
+    for(const auto segment : connections.segmentsForCell(cell)) {
+      if(connections.dataForSegment(segment).numConnected < activationThreshold_) continue;
+      kept.push_back(segment);
+      segmentCell_.push_back(cell);
+      for(const auto synapse : connections.synapsesForSegment(segment)) {
+        if(not connections.isConnected(synapse)) continue;
+        const CellIdx presynapticCell = connections.presynapticCellForSynapse(synapse);
+        NTA_CHECK(presynapticCell < numCells_)
+          << "FrozenTemporalMemory: external predictive inputs are not supported.";
+        presynapticBegin_[presynapticCell + 1u]++;
+      }
+    }
+  }
+  for(CellIdx cell = 0; cell < numCells_; cell++) {
+    presynapticBegin_[cell + 1u] += presynapticBegin_[cell];
+  }
+  // The segments of each row are in ascending order.
+  connectedSegments_.resize(presynapticBegin_[numCells_]);
+  vector<UInt32> next(presynapticBegin_.begin(), presynapticBegin_.end() - 1);
+  for(UInt32 s = 0; s < kept.size(); s++) {
+    for(const auto synapse : connections.synapsesForSegment(kept[s])) {
+      if(connections.isConnected(synapse)) {
+        connectedSegments_[next[connections.presynapticCellForSynapse(synapse)]++] = s;
+      }
+    }
+  }
+  reset();
+}
+
+
+void FrozenTemporalMemory::reset() {
+  activeCells_.clear();
+  auto dimensions = vector<UInt>(columnDimensions_.begin(), columnDimensions_.end());
+  dimensions.push_back(cellsPerColumn_);
+  if(predictiveCells_.dimensions != dimensions) predictiveCells_.initialize(dimensions);
+  predictiveCells_.zero();
+  anomaly_ = 0.5f;
+}
+
+
+void FrozenTemporalMemory::compute(const SDR &activeColumns) {
+  NTA_CHECK(activeColumns.dimensions.size() == columnDimensions_.size())
+    << "FrozenTemporalMemory: invalid input dimensions " << activeColumns.dimensions.size()
+    << " vs. " << columnDimensions_.size();
+  for(size_t i = 0; i < columnDimensions_.size(); i++) {
+    NTA_CHECK(activeColumns.dimensions[i] == columnDimensions_[i]) << "Dimensions must be the same.";
+  }
+
+  // A predicted column activates its predicted cells, else it bursts. The
+  // predicted cells are sorted, so they are walked along with the columns.
+  const auto &columns   = activeColumns.getSparse();
+  const auto &predicted = predictiveCells_.getSparse();
+  auto cell = predicted.cbegin();
+  activeCells_.clear();
+  UInt bursting = 0u;
+  for(const auto column : columns) {
+    while(cell != predicted.cend() and *cell / cellsPerColumn_ < column) ++cell;
+    const auto begin = cell;
+    while(cell != predicted.cend() and *cell / cellsPerColumn_ == column) ++cell;
+    if(begin != cell) {
+      activeCells_.insert(activeCells_.end(), begin, cell);
+    } else {
+      bursting++;
+      for(CellIdx c = column * cellsPerColumn_; c < (column + 1u) * cellsPerColumn_; c++) {
+        activeCells_.push_back(c);
+      }
+    }
+  }
+  const UInt numColumns = static_cast<UInt>(columns.size());
+  anomaly_ = rawAnomalyScore(numColumns, numColumns - bursting);
+
+  activateDendrites_();
+}
+
+
+void FrozenTemporalMemory::activateDendrites_() {
+  if(overlaps_.size() != segmentCell_.size()) {
+    overlaps_.assign(segmentCell_.size(), 0u);
+    touched_.clear();
+  }
+  for(const auto cell : activeCells_) {
+    const UInt32 *it  = connectedSegments_.data() + presynapticBegin_[cell];
+    const UInt32 *end = connectedSegments_.data() + presynapticBegin_[cell + 1u];
+    for( ; it != end; ++it) {
+      if(overlaps_[*it]++ == 0u) touched_.push_back(*it);
+    }
+  }
+
+  // Reuse the SDR's own buffer; zero the touched segments for the next step.
+  auto &cells = predictiveCells_.getSparse();
+  cells.clear();
+  for(const auto segment : touched_) {
+    if(overlaps_[segment] >= activationThreshold_) cells.push_back(segmentCell_[segment]);
+    overlaps_[segment] = 0u;
+  }
+  touched_.clear();
+  std::sort(cells.begin(), cells.end());
+  cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+  predictiveCells_.setSparse(cells);
+}
+
+
+bool FrozenTemporalMemory::operator==(const FrozenTemporalMemory &o) const {
+  return columnDimensions_    == o.columnDimensions_ and
+         cellsPerColumn_      == o.cellsPerColumn_ and
+         numCells_            == o.numCells_ and
+         activationThreshold_ == o.activationThreshold_ and
+         segmentCell_         == o.segmentCell_ and
+         presynapticBegin_    == o.presynapticBegin_ and
+         connectedSegments_   == o.connectedSegments_;
+}
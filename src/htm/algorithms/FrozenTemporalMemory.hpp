@@ -0,0 +1,138 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the inference only FrozenTemporalMemory
+ */
+
+#ifndef NTA_FROZEN_TEMPORAL_MEMORY_HPP
+#define NTA_FROZEN_TEMPORAL_MEMORY_HPP
+
+#include <vector>
+#include <htm/algorithms/TemporalMemory.hpp>
+#include <htm/types/Types.hpp>
+#include <htm/types/Serializable.hpp>
+#include <htm/types/Sdr.hpp>
+
+namespace htm {
+
+/**
+ * Read-only snapshot of a trained TemporalMemory, for inference.
+ *
+ * Keeps only the segments which can become active (with at least
+ * activationThreshold connected synapses) and their connected synapses, as
+ * a list of segments per presynaptic cell (CSR), and the cell of each
+ * segment. No potential synapses, permanences, matching segments, winner
+ * cells or segment bookkeeping, so it is much smaller in memory and when
+ * serialized.
+ *
+ * compute(activeColumns) gives the same active cells and raw anomaly as
+ * TemporalMemory::compute(activeColumns, false) of the TM it was made from,
+ * and getPredictiveCells() the same cells as the TM's after a following
+ * activateDendrites(false): the predictions for the next input. Each step
+ * counts the segment activity once. Later changes to that TM are not seen.
+ *
+ * Example usage:
+ *
+ *     TemporalMemory tm(...);
+ *     <train tm>
+ *     FrozenTemporalMemory frozen(tm);
+ *     frozen.compute(activeColumns);
+ *     frozen.getAnomaly();
+ */
+class FrozenTemporalMemory : public Serializable
+{
+public:
+  FrozenTemporalMemory() {}
+  explicit FrozenTemporalMemory(const TemporalMemory &tm);
+
+  /** Same as TemporalMemory::compute(activeColumns, false). */
+  void compute(const SDR &activeColumns);
+
+  /** Start a new sequence. */
+  void reset();
+
+  const vector<CellIdx> &getActiveCells() const { return activeCells_; }
+  /** The cells predicted for the next compute(). */
+  const SDR &getPredictiveCells() const { return predictiveCells_; }
+  /** Raw anomaly score of the last compute(), 0.5 before the first. */
+  Real getAnomaly() const { return anomaly_; }
+
+  const vector<CellIdx> &getColumnDimensions() const { return columnDimensions_; }
+  CellIdx getCellsPerColumn() const { return cellsPerColumn_; }
+  CellIdx numberOfCells() const { return numCells_; }
+  SynapseIdx getActivationThreshold() const { return activationThreshold_; }
+  size_t getNumSegments() const { return segmentCell_.size(); }
+  /** @return total number of connected synapses */
+  size_t getNumSynapses() const { return connectedSegments_.size(); }
+
+  CerealAdapter;  // see Serializable.hpp
+  template<class Archive>
+  void save_ar(Archive& ar) const {
+    ar(CEREAL_NVP(columnDimensions_),
+       CEREAL_NVP(cellsPerColumn_),
+       CEREAL_NVP(numCells_),
+       CEREAL_NVP(activationThreshold_),
+       CEREAL_NVP(segmentCell_),
+       CEREAL_NVP(presynapticBegin_),
+       CEREAL_NVP(connectedSegments_));
+  }
+  // The sequence state is not serialized, a loaded one starts a new sequence.
+  template<class Archive>
+  void load_ar(Archive& ar) {
+    ar(CEREAL_NVP(columnDimensions_),
+       CEREAL_NVP(cellsPerColumn_),
+       CEREAL_NVP(numCells_),
+       CEREAL_NVP(activationThreshold_),
+       CEREAL_NVP(segmentCell_),
+       CEREAL_NVP(presynapticBegin_),
+       CEREAL_NVP(connectedSegments_));
+    overlaps_.clear();
+    touched_.clear();
+    reset();
+  }
+
+  bool operator==(const FrozenTemporalMemory &o) const;
+  inline bool operator!=(const FrozenTemporalMemory &o) const { return !operator==(o); }
+
+private:
+  void activateDendrites_(); //predictiveCells_ from activeCells_
+
+  vector<CellIdx> columnDimensions_;
+  CellIdx         cellsPerColumn_      = 0u;
+  CellIdx         numCells_            = 0u;
+  SynapseIdx      activationThreshold_ = 0u;
+
+  // Segment s is on cell segmentCell_[s], the segments are in cell order.
+  // The segments with a connected synapse from cell i are
+  // connectedSegments_[presynapticBegin_[i] .. presynapticBegin_[i + 1]).
+  vector<CellIdx> segmentCell_;
+  vector<UInt32>  presynapticBegin_;
+  vector<UInt32>  connectedSegments_;
+
+  // the sequence, not serialized
+  vector<CellIdx> activeCells_;
+  SDR             predictiveCells_{{0u}};
+  Real            anomaly_ = 0.5f;
+
+  // reused by compute(), not serialized
+  vector<SynapseIdx> overlaps_;
+  vector<UInt32>     touched_; //the segments with overlap > 0
+};
+
+} // end namespace htm
+#endif // NTA_FROZEN_TEMPORAL_MEMORY_HPP
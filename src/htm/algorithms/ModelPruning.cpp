@@ -0,0 +1,204 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the offline pruning of trained models
+ */
+
+#include <htm/algorithms/ModelPruning.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+#include <string>
+
+#include <htm/algorithms/SpatialPooler.hpp>
+#include <htm/algorithms/TemporalMemory.hpp>
+#include <htm/engine/Network.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/utils/Log.hpp>
+#include <htm/utils/MemoryUsage.hpp>
+
+using namespace htm;
+
+namespace {
+
+bool isPrunable(const Region &region) {
+  return region.getType() == "SPRegion" or region.getType() == "TMRegion";
+}
+
+/** The synapses and segments of the SP / TM regions. */
+void countNetwork(const Network &net, size_t &synapses, size_t &segments) {
+  synapses = segments = 0u;
+  auto regions = net.getRegions();
+  for (const auto &entry : regions) {
+    if (not isPrunable(*entry.second)) continue;
+    const auto metrics = entry.second->getMetrics();
+    const auto syn = metrics.find("connections_synapses");
+    const auto seg = metrics.find("connections_segments");
+    if (syn != metrics.end()) synapses += static_cast<size_t>(syn->second);
+    if (seg != metrics.end()) segments += static_cast<size_t>(seg->second);
+  }
+}
+
+void compareAnomaly(const Real original, const Real pruned, const Real tolerance, ValidationReport &report) {
+  const Real delta = std::fabs(original - pruned);
+  if (delta > tolerance) report.anomalyChanged++;
+  report.maxAnomalyDelta = std::max(report.maxAnomalyDelta, delta);
+}
+
+} // namespace
+
+
+PruneReport htm::prune(SpatialPooler &sp, const PruneOptions &options) {
+  PruneReport report;
+  report.synapsesBefore = sp.connections.numSynapses();
+  report.segmentsBefore = sp.connections.numSegments();
+  report.bytesBefore    = memory::total(sp.memoryUsage());
+  sp.prune(options.minPermanence);
+  report.synapsesAfter  = sp.connections.numSynapses();
+  report.segmentsAfter  = sp.connections.numSegments();
+  report.bytesAfter     = memory::total(sp.memoryUsage());
+  return report;
+}
+
+
+PruneReport htm::prune(TemporalMemory &tm, const PruneOptions &options) {
+  PruneReport report;
+  report.synapsesBefore = tm.connections.numSynapses();
+  report.segmentsBefore = tm.connections.numSegments();
+  report.bytesBefore    = memory::total(tm.memoryUsage());
+  tm.prune(options.minPermanence, options.maxSegmentAge);
+  report.synapsesAfter  = tm.connections.numSynapses();
+  report.segmentsAfter  = tm.connections.numSegments();
+  report.bytesAfter     = memory::total(tm.memoryUsage());
+  return report;
+}
+
+
+PruneReport htm::prune(Network &net, const PruneOptions &options) {
+  PruneReport report;
+  countNetwork(net, report.synapsesBefore, report.segmentsBefore);
+  report.bytesBefore = memory::total(net.memoryUsage());
+  auto regions = net.getRegions();
+  for (const auto &entry : regions) {
+    Region &region = *entry.second;
+    if (not isPrunable(region)) continue;
+    std::vector<std::string> command = {"prune", std::to_string(options.minPermanence)};
+    if (region.getType() == "TMRegion") command.push_back(std::to_string(options.maxSegmentAge));
+    region.executeCommand(command);
+  }
+  countNetwork(net, report.synapsesAfter, report.segmentsAfter);
+  report.bytesAfter = memory::total(net.memoryUsage());
+  return report;
+}
+
+
+ValidationReport htm::validate(SpatialPooler &original, SpatialPooler &pruned,
+                               const std::vector<SDR> &inputs) {
+  NTA_CHECK(original.getColumnDimensions() == pruned.getColumnDimensions())
+    << "validate: the SpatialPoolers have other column dimensions.";
+  ValidationReport report;
+  SDR a(original.getColumnDimensions());
+  SDR b(pruned.getColumnDimensions());
+  for (const auto &input : inputs) {
+    original.compute(input, false, a);
+    pruned.compute(input, false, b);
+    if (a != b) report.activeChanged++;
+    report.steps++;
+  }
+  return report;
+}
+
+
+ValidationReport htm::validate(TemporalMemory &original, TemporalMemory &pruned,
+                               const std::vector<SDR> &activeColumns, const Real anomalyTolerance) {
+  NTA_CHECK(original.numberOfCells() == pruned.numberOfCells())
+    << "validate: the TemporalMemories have other numbers of cells.";
+  ValidationReport report;
+  original.reset();
+  pruned.reset();
+  for (const auto &columns : activeColumns) {
+    original.compute(columns, false);
+    pruned.compute(columns, false);
+    original.activateDendrites(false); //the predictions for the next step
+    pruned.activateDendrites(false);
+    if (original.getPredictiveCells() != pruned.getPredictiveCells()) report.predictionsChanged++;
+    compareAnomaly(original.anomaly, pruned.anomaly, anomalyTolerance, report);
+    report.steps++;
+  }
+  return report;
+}
+
+
+ValidationReport htm::validate(Network &original, Network &pruned, const size_t steps,
+                               const Real anomalyTolerance) {
+  std::vector<std::string> spRegions, tmRegions;
+  auto regions = original.getRegions();
+  for (const auto &entry : regions) {
+    const std::string type = entry.second->getType();
+    if (not isPrunable(*entry.second)) continue;
+    NTA_CHECK(pruned.getRegion(entry.first)->getType() == type)
+      << "validate: region " << entry.first << " is not a " << type << " in the pruned network.";
+    (type == "SPRegion" ? spRegions : tmRegions).push_back(entry.first);
+  }
+  for (Network *net : {&original, &pruned}) {
+    for (const auto &name : spRegions) net->getRegion(name)->setParameterUInt32("learningMode", 0u);
+    for (const auto &name : tmRegions) net->getRegion(name)->setParameterBool("learningMode", false);
+  }
+
+  ValidationReport report;
+  for (size_t step = 0u; step < steps; step++) {
+    original.run(1);
+    pruned.run(1);
+    bool active = false, predictions = false;
+    for (const auto &name : spRegions) {
+      active |= not (original.getRegion(name)->getOutputData("bottomUpOut")
+                     == pruned.getRegion(name)->getOutputData("bottomUpOut"));
+    }
+    Real delta = 0.0f;
+    for (const auto &name : tmRegions) {
+      const auto a = original.getRegion(name);
+      const auto b = pruned.getRegion(name);
+      predictions |= not (a->getOutputData("predictiveCells") == b->getOutputData("predictiveCells"));
+      delta = std::max(delta, std::fabs(static_cast<const Real *>(a->getOutputData("anomaly").getBuffer())[0] -
+                                        static_cast<const Real *>(b->getOutputData("anomaly").getBuffer())[0]));
+    }
+    if (active) report.activeChanged++;
+    if (predictions) report.predictionsChanged++;
+    compareAnomaly(0.0f, delta, anomalyTolerance, report);
+    report.steps++;
+  }
+  return report;
+}
+
+
+std::ostream &htm::operator<<(std::ostream &out, const PruneReport &report) {
+  out << "synapses " << report.synapsesBefore << " -> " << report.synapsesAfter
+      << ", segments " << report.segmentsBefore << " -> " << report.segmentsAfter
+      << ", bytes " << report.bytesBefore << " -> " << report.bytesAfter << std::endl;
+  return out;
+}
+
+
+std::ostream &htm::operator<<(std::ostream &out, const ValidationReport &report) {
+  out << report.steps << " steps: active columns changed " << report.activeChanged
+      << ", predictions changed " << report.predictionsChanged
+      << ", anomaly changed " << report.anomalyChanged
+      << " (max delta " << report.maxAnomalyDelta << ")" << std::endl;
+  return out;
+}
@@ -0,0 +1,124 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Offline pruning of trained models, and its validation
+ */
+
+#ifndef NTA_MODEL_PRUNING_HPP
+#define NTA_MODEL_PRUNING_HPP
+
+#include <iosfwd>
+#include <vector>
+
+#include <htm/algorithms/Connections.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+class Network;
+class SpatialPooler;
+class TemporalMemory;
+
+/**
+ * What to prune, see Connections::prune().
+ *
+ * A trained model keeps many synapses which decayed towards 0 and segments
+ * which stopped matching; they cost memory and compute time but rarely
+ * change an output.
+ */
+struct PruneOptions
+{
+  /** Destroy the synapses with a lower permanence.  Below the connected
+   *  permanence the active cells / columns do not change, only learning does. */
+  Permanence minPermanence = 0.0f;
+
+  /** Destroy the TM segments not used in the last maxSegmentAge iterations,
+   *  0 for no limit.  The SpatialPooler keeps its segments. */
+  UInt32 maxSegmentAge = 0u;
+};
+
+
+/** The size of a model before and after pruning. */
+struct PruneReport
+{
+  size_t synapsesBefore = 0u;
+  size_t synapsesAfter  = 0u;
+  size_t segmentsBefore = 0u;
+  size_t segmentsAfter  = 0u;
+  size_t bytesBefore    = 0u;   // memory::total() of memoryUsage()
+  size_t bytesAfter     = 0u;
+};
+
+
+/**
+ * How often a pruned model disagreed with the original on a validation
+ * stream, both not learning.
+ */
+struct ValidationReport
+{
+  size_t steps              = 0u;
+  size_t activeChanged      = 0u;   // SP: steps with other active columns
+  size_t predictionsChanged = 0u;   // TM: steps with other predictive cells
+  size_t anomalyChanged     = 0u;   // TM: steps with another anomaly score
+  Real   maxAnomalyDelta    = 0.0f;
+};
+
+
+/**
+ * Prune a trained model in place, see SpatialPooler::prune(),
+ * TemporalMemory::prune().  The TM starts a new sequence.
+ */
+PruneReport prune(SpatialPooler &sp, const PruneOptions &options);
+PruneReport prune(TemporalMemory &tm, const PruneOptions &options);
+
+/**
+ * Prune every SPRegion and TMRegion of an initialized network, with their
+ * "prune" commands.  The counts are from the regions' metrics.
+ */
+PruneReport prune(Network &net, const PruneOptions &options);
+
+/**
+ * Run the original and the pruned model on the same stream, without
+ * learning, and count the steps where they differ.  The TMs are reset first.
+ *
+ * @param inputs - of the SP, or the active columns of the TM.
+ * @param anomalyTolerance - anomaly scores closer than this are the same.
+ */
+ValidationReport validate(SpatialPooler &original, SpatialPooler &pruned,
+                          const std::vector<SDR> &inputs);
+ValidationReport validate(TemporalMemory &original, TemporalMemory &pruned,
+                          const std::vector<SDR> &activeColumns, Real anomalyTolerance = 0.0f);
+
+/**
+ * Run both networks for "steps" iterations, their sensors reading the same
+ * data, and compare the outputs of the regions of the same name: SPRegion
+ * bottomUpOut, TMRegion predictiveCells and anomaly.  Turns off the
+ * learningMode of these regions in both.  Prune the original with the
+ * default PruneOptions first (this destroys nothing) so that its TMs start
+ * the same new sequence.
+ */
+ValidationReport validate(Network &original, Network &pruned, size_t steps,
+                          Real anomalyTolerance = 0.0f);
+
+std::ostream &operator<<(std::ostream &out, const PruneReport &report);
+std::ostream &operator<<(std::ostream &out, const ValidationReport &report);
+
+} // namespace htm
+
+#endif // NTA_MODEL_PRUNING_HPP
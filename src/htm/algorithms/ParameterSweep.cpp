@@ -0,0 +1,165 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the ParameterSweep class
+ */
+
+#include <htm/algorithms/ParameterSweep.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <ostream>
+
+#include <htm/algorithms/SDRClassifier.hpp>
+#include <htm/algorithms/SpatialPooler.hpp>
+#include <htm/algorithms/TemporalMemory.hpp>
+#include <htm/os/Timer.hpp>
+#include <htm/utils/Log.hpp>
+#include <htm/utils/SdrMetrics.hpp>
+#include <htm/utils/ThreadPool.hpp>
+
+using namespace htm;
+
+
+EncodedDataset::EncodedDataset(const std::vector<UInt> &dimensions)
+  : dimensions_(dimensions) {
+  NTA_CHECK(!dimensions_.empty()) << "EncodedDataset: no dimensions.";
+}
+
+
+void EncodedDataset::add(const SDR &record, const UInt label) {
+  NTA_CHECK(record.dimensions == dimensions_) << "EncodedDataset: the record has other dimensions.";
+  const auto &sparse = record.getSparse();
+  sparse_.insert(sparse_.end(), sparse.begin(), sparse.end());
+  ends_.push_back(sparse_.size());
+  labels_.push_back(label);
+}
+
+
+SDRView EncodedDataset::operator[](const size_t i) const {
+  NTA_ASSERT(i < size());
+  const size_t begin = i == 0u ? 0u : ends_[i - 1u];
+  return SDRView(dimensions_, sparse_.data() + begin, ends_[i] - begin);
+}
+
+
+size_t EncodedDataset::memoryUsage() const {
+  return sparse_.capacity() * sizeof(ElemSparse) + ends_.capacity() * sizeof(size_t)
+       + labels_.capacity() * sizeof(UInt);
+}
+
+
+ParameterSweep::ParameterSweep(const EncodedDataset &data, const size_t numTrain, const size_t numThreads)
+  : data_(data), numTrain_(numTrain), numThreads_(numThreads) {
+  NTA_CHECK(numTrain_ <= data_.size())
+    << "ParameterSweep: " << numTrain_ << " training records of " << data_.size();
+}
+
+
+std::vector<SweepResult> ParameterSweep::run(const std::vector<SweepConfig> &configs) const {
+  std::vector<SweepResult> results(configs.size());
+  ThreadPool pool(numThreads_);
+  pool.parallelFor(configs.size(), [&](const size_t i) { results[i] = run(configs[i]); });
+  return results;
+}
+
+
+SweepResult ParameterSweep::run(const SweepConfig &config) const {
+  const auto &inputDims = data_.getDimensions();
+  SpatialPooler sp(inputDims, config.columnDimensions,
+      config.potentialRadius, config.potentialPct, config.globalInhibition,
+      config.localAreaDensity, 0u, config.stimulusThreshold,
+      config.synPermInactiveDec, config.synPermActiveInc, config.synPermConnected,
+      config.minPctOverlapDutyCycles, config.dutyCyclePeriod, config.boostStrength,
+      config.seed, 0u, config.wrapAround);
+  std::unique_ptr<TemporalMemory> tm;
+  if (config.useTM) {
+    tm.reset(new TemporalMemory(config.columnDimensions, config.cellsPerColumn,
+        config.activationThreshold, config.initialPermanence, config.connectedPermanence,
+        config.minThreshold, config.maxNewSynapseCount, config.permanenceIncrement,
+        config.permanenceDecrement, config.predictedSegmentDecrement, config.seed,
+        config.maxSegmentsPerCell, config.maxSynapsesPerSegment));
+  }
+  Classifier classifier(config.classifierAlpha);
+
+  SDR input(inputDims);
+  SDR columns(config.columnDimensions);
+  SweepResult result;
+  result.name = config.name;
+
+  Timer train(true);
+  for (UInt epoch = 0u; epoch < config.epochs; epoch++) {
+    if (tm) tm->reset();
+    for (size_t i = 0u; i < numTrain_; i++) {
+      data_[i].copyTo(input);
+      sp.compute(input, true, columns);
+      if (tm) tm->compute(columns, true);
+      if (data_.getLabel(i) != EncodedDataset::NO_LABEL)
+        classifier.learn(columns, {data_.getLabel(i)});
+    }
+  }
+  train.stop();
+
+  const size_t numTest = data_.size() - numTrain_;
+  Sparsity sparsity(columns.dimensions, static_cast<UInt>(std::max<size_t>(numTest, 1u)));
+  ActivationFrequency frequency(columns.dimensions, static_cast<UInt>(std::max<size_t>(numTest, 1u)));
+  size_t labeled = 0u, correct = 0u;
+  Real64 anomaly = 0.0;
+
+  Timer test(true);
+  if (tm) tm->reset();
+  for (size_t i = numTrain_; i < data_.size(); i++) {
+    data_[i].copyTo(input);
+    sp.compute(input, false, columns);
+    sparsity.addData(columns);
+    frequency.addData(columns);
+    if (tm) {
+      tm->compute(columns, false);
+      anomaly += tm->anomaly;
+    }
+    if (data_.getLabel(i) != EncodedDataset::NO_LABEL) {
+      labeled++;
+      const PDF pdf = classifier.infer(columns);
+      if (!pdf.empty() && argmax(pdf) == data_.getLabel(i)) correct++;
+    }
+  }
+  test.stop();
+
+  if (labeled > 0u) result.accuracy = static_cast<Real>(correct) / labeled;
+  if (tm && numTest > 0u) result.meanAnomaly = static_cast<Real>(anomaly / numTest);
+  if (numTest > 0u) {
+    result.spSparsity = sparsity.mean();
+    result.spEntropy  = frequency.entropy();
+  }
+  result.trainSeconds = train.getElapsed();
+  result.testSeconds  = test.getElapsed();
+  const Real64 seconds = result.trainSeconds + result.testSeconds;
+  if (seconds > 0.0)
+    result.recordsPerSecond = (static_cast<Real64>(numTrain_) * config.epochs + numTest) / seconds;
+  return result;
+}
+
+
+std::ostream &htm::operator<<(std::ostream &out, const SweepResult &result) {
+  out << result.name << ": accuracy " << result.accuracy
+      << ", mean anomaly " << result.meanAnomaly
+      << ", SP sparsity " << result.spSparsity << ", SP entropy " << result.spEntropy
+      << ", " << result.recordsPerSecond << " records/s"
+      << " (train " << result.trainSeconds << " s, test " << result.testSeconds << " s)" << std::endl;
+  return out;
+}
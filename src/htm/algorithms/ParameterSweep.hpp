@@ -0,0 +1,190 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the ParameterSweep class
+ */
+
+#ifndef NTA_PARAMETER_SWEEP_HPP
+#define NTA_PARAMETER_SWEEP_HPP
+
+#include <iosfwd>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <htm/algorithms/Connections.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/types/SdrView.hpp>
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * A sequence of encoded records, optionally labeled: the sparse indices of
+ * all records in one buffer.  Encode a dataset into it once, then any number
+ * of threads read it.
+ */
+class EncodedDataset
+{
+public:
+  static constexpr UInt NO_LABEL = std::numeric_limits<UInt>::max();
+
+  explicit EncodedDataset(const std::vector<UInt> &dimensions);
+
+  /** Append a record, of the dimensions of the dataset. */
+  void add(const SDR &record, UInt label = NO_LABEL);
+
+  size_t size() const { return labels_.size(); }
+  const std::vector<UInt> &getDimensions() const { return dimensions_; }
+
+  /** A view of record i, valid until the next add(). */
+  SDRView operator[](size_t i) const;
+  UInt getLabel(size_t i) const { return labels_[i]; }
+
+  size_t memoryUsage() const;
+
+private:
+  std::vector<UInt> dimensions_;
+  std::vector<ElemSparse> sparse_;
+  std::vector<size_t> ends_;   // record i is [ends_[i - 1], ends_[i]) of sparse_
+  std::vector<UInt> labels_;
+};
+
+
+/**
+ * The parameters of one SpatialPooler, and optionally of a TemporalMemory on
+ * its active columns, as in their constructors.
+ */
+struct SweepConfig
+{
+  std::string name;
+
+  // SpatialPooler
+  std::vector<UInt> columnDimensions   = {2048u};
+  UInt   potentialRadius               = 16u;
+  Real   potentialPct                  = 0.5f;
+  bool   globalInhibition              = true;
+  Real   localAreaDensity              = 0.05f;
+  UInt   stimulusThreshold             = 0u;
+  Real   synPermInactiveDec            = 0.008f;
+  Real   synPermActiveInc              = 0.05f;
+  Real   synPermConnected              = 0.1f;
+  Real   minPctOverlapDutyCycles       = 0.001f;
+  UInt   dutyCyclePeriod               = 1000u;
+  Real   boostStrength                 = 0.0f;
+  bool   wrapAround                    = true;
+  Int    seed                          = 1;
+
+  // TemporalMemory
+  bool       useTM                     = false;
+  CellIdx    cellsPerColumn            = 32u;
+  SynapseIdx activationThreshold       = 13u;
+  Permanence initialPermanence         = 0.21f;
+  Permanence connectedPermanence       = 0.50f;
+  SynapseIdx minThreshold              = 10u;
+  SynapseIdx maxNewSynapseCount        = 20u;
+  Permanence permanenceIncrement       = 0.10f;
+  Permanence permanenceDecrement       = 0.10f;
+  Permanence predictedSegmentDecrement = 0.0f;
+  SegmentIdx maxSegmentsPerCell        = 255u;
+  SynapseIdx maxSynapsesPerSegment     = 255u;
+
+  // Classifier of the SP's active columns, for the accuracy.
+  Real classifierAlpha = 0.001f;
+
+  /** Passes over the training records. */
+  UInt epochs = 1u;
+};
+
+
+/**
+ * How one configuration did on the test records.  A metric which does not
+ * apply (no labels, no TM) is NaN.
+ */
+struct SweepResult
+{
+  std::string name;
+  Real   accuracy           = std::numeric_limits<Real>::quiet_NaN();
+  Real   meanAnomaly        = std::numeric_limits<Real>::quiet_NaN();
+  Real   spSparsity         = 0.0f;   // mean, of the active columns
+  Real   spEntropy          = 0.0f;   // of the activation frequencies, 1 is even use of all columns
+  Real64 trainSeconds       = 0.0;
+  Real64 testSeconds        = 0.0;
+  Real64 recordsPerSecond   = 0.0;    // trained and tested
+};
+
+
+/**
+ * Trains and tests many SpatialPooler / TemporalMemory configurations on one
+ * encoded dataset, in parallel.
+ *
+ * The dataset is encoded once and shared read only; each configuration runs
+ * on one thread of a ThreadPool, with its own models.  A configuration
+ * learns on the first "numTrain" records for "epochs" passes (the TM starts
+ * a new sequence at each pass), then runs on the rest without learning:
+ *   - accuracy: of a Classifier of the SP's active columns, trained on the
+ *     labeled training records, over the labeled test records.
+ *   - meanAnomaly: of the TM, over the test records.
+ *   - spSparsity, spEntropy: of the SP's active columns, over the test records.
+ *
+ * Example usage:
+ *
+ *     RDSE enc(params);
+ *     EncodedDataset data(enc.dimensions);
+ *     SDR sdr(enc.dimensions);
+ *     for (const auto &row : csv) {
+ *       enc.encode(row.value, sdr);
+ *       data.add(sdr, row.label);
+ *     }
+ *     vector<SweepConfig> configs;
+ *     for (Real inc : {0.01f, 0.03f, 0.05f}) {
+ *       SweepConfig c;
+ *       c.name = "inc=" + to_string(inc);
+ *       c.synPermActiveInc = inc;
+ *       configs.push_back(c);
+ *     }
+ *     ParameterSweep sweep(data, data.size() * 4 / 5);
+ *     for (const auto &result : sweep.run(configs)) cout << result;
+ */
+class ParameterSweep
+{
+public:
+  /**
+   * @param data - must outlive the sweep, and not change during run().
+   * @param numTrain - the records [0, numTrain) are learned, the rest tested.
+   * @param numThreads - configurations run at once, 0 for all cores.
+   */
+  ParameterSweep(const EncodedDataset &data, size_t numTrain, size_t numThreads = 0u);
+
+  /** Run all configurations, results in the same order. */
+  std::vector<SweepResult> run(const std::vector<SweepConfig> &configs) const;
+
+  /** Run one configuration on the calling thread. */
+  SweepResult run(const SweepConfig &config) const;
+
+private:
+  const EncodedDataset &data_;
+  size_t numTrain_;
+  size_t numThreads_;
+};
+
+std::ostream &operator<<(std::ostream &out, const SweepResult &result);
+
+} // namespace htm
+
+#endif // NTA_PARAMETER_SWEEP_HPP
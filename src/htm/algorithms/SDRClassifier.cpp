@@ -16,10 +16,13 @@
  * along with this program.  If not, see http://www.gnu.org/licenses.
  * --------------------------------------------------------------------- */
 
+#include <algorithm> // upper_bound
 #include <cmath> // exp
+#include <limits> // numeric_limits
 #include <numeric> // accumulate
 
 #include <htm/algorithms/SDRClassifier.hpp>
+#include <htm/utils/FastMath.hpp>
 #include <htm/utils/Log.hpp>
 
 using namespace htm;
@@ -40,6 +43,7 @@ void Classifier::initialize(const Real alpha)
   alpha_ = alpha;
   dimensions_ = 0;
   numCategories_ = 0u;
+  stride_ = 0u;
   weights_.clear();
 }
 
@@ -56,76 +60,165 @@ PDF Classifier::infer(const SDR & pattern) const {
 
   // Accumulate feed forward input.
   PDF probabilities( numCategories_, 0.0f );
-  for( const auto bit : pattern.getSparse() ) {
-    for( size_t i = 0; i < numCategories_; i++ ) {
-      probabilities[i] += weights_[bit][i];
-    }
-  }
+  accumulate_( pattern.getSparse(), probabilities.data() );
 
   // Convert from accumulated votes to probability density function.
-  softmax( probabilities.begin(), probabilities.end() );
+  softmax( probabilities.begin(), probabilities.end(), fastSoftmax_ );
   return probabilities;
 }
 
 
+vector<PDF> Classifier::infer(const vector<SDR> & patterns) const {
+  if (dimensions_ == 0) {
+    NTA_WARN << "Classifier: must call `learn` before `infer`.";
+    return vector<PDF>(patterns.size(), PDF(numCategories_, std::nan("")));
+  }
+  vector<PDF> results( patterns.size(), PDF(numCategories_, 0.0f) );
+  for( size_t p = 0u; p < patterns.size(); p++ ) {
+    NTA_CHECK(patterns[p].size == dimensions_) << "Input SDR does not match previously seen size!";
+    accumulate_( patterns[p].getSparse(), results[p].data() );
+    softmax( results[p].begin(), results[p].end(), fastSoftmax_ );
+  }
+  return results;
+}
+
+
+TopK Classifier::inferTopK(const SDR & pattern, const UInt k) const {
+  NTA_CHECK(pattern.size > 0) << "No Data pased to Classifier. Pattern is empty.";
+  if (dimensions_ == 0) {
+    NTA_WARN << "Classifier: must call `learn` before `infer`.";
+    return {};
+  }
+  NTA_ASSERT(pattern.size == dimensions_) << "Input SDR does not match previously seen size!";
+
+  vector<Real64> votes( numCategories_, 0.0f );
+  accumulate_( pattern.getSparse(), votes.data() );
+  return topK_( votes.data(), numCategories_, k, fastSoftmax_ );
+}
+
+
+TopK Classifier::topK_(const Real64 *votes, const UInt numCategories, const UInt k,
+                       const bool fastSoftmax) {
+  const auto exp = [fastSoftmax](const Real64 x) { return fastSoftmax ? fastmath::exp(x) : std::exp(x); };
+  // One pass: running max & softmax denominator (rescaled when the max grows),
+  // and the k best votes kept sorted, best first.
+  TopK best;
+  if( k == 0u ) return best;
+  best.reserve( std::min<size_t>(k, numCategories) + 1u );
+  Real64 maxVote = -std::numeric_limits<Real64>::infinity();
+  Real64 sum     = 0.0;
+  for( UInt category = 0u; category < numCategories; category++ ) {
+    const Real64 vote = votes[category];
+    if( vote > maxVote ) {
+      sum = sum * exp(maxVote - vote) + 1.0;
+      maxVote = vote;
+    }
+    else {
+      sum += exp(vote - maxVote);
+    }
+    if( best.size() < k or vote > best.back().second ) {
+      auto pos = std::upper_bound( best.begin(), best.end(), vote,
+                    [](const Real64 v, const std::pair<UInt, Real64> &b) { return v > b.second; });
+      best.insert( pos, {category, vote} );
+      if( best.size() > k ) best.pop_back();
+    }
+  }
+  for( auto &entry : best ) {
+    entry.second = exp(entry.second - maxVote) / sum;
+  }
+  return best;
+}
+
+
+void Classifier::accumulate_(const SDR_sparse_t &bits, Real64 *votes) const {
+  // Each active bit adds one contiguous row, the inner loop vectorizes.
+  const size_t numCategories = numCategories_;
+  const Real64 *weights = weights_.data();
+  for( const auto bit : bits ) {
+    const Real64 *row = weights + bit * stride_;
+    for( size_t i = 0u; i < numCategories; i++ ) {
+      votes[i] += row[i];
+    }
+  }
+}
+
+
 void Classifier::learn(const SDR &pattern, const vector<UInt> &categoryIdxList)
+  { learn_( pattern.size, pattern.getSparse(), categoryIdxList ); }
+
+
+void Classifier::learn_(const UInt size, const SDR_sparse_t &bits, const vector<UInt> &categoryIdxList)
 {
   // If this is the first time the Classifier is being used, weights are empty, 
   // so we set the dimensions to that of the input `pattern`
   if( dimensions_ == 0 ) {
-    dimensions_ = pattern.size;
-    while( weights_.size() < pattern.size ) {
-      const auto initialEmptyWeights = PDF( numCategories_, 0.0f );
-      weights_.push_back( initialEmptyWeights );
-    }
+    dimensions_ = size;
+    weights_.assign( static_cast<size_t>(dimensions_) * stride_, 0.0f );
   }
-  NTA_CHECK(pattern.size > 0) << "No Data passed to Classifier. Pattern is empty.";
-  NTA_ASSERT(pattern.size == dimensions_) << "Input SDR does not match previously seen size!";
+  NTA_CHECK(size > 0) << "No Data passed to Classifier. Pattern is empty.";
+  NTA_ASSERT(size == dimensions_) << "Input SDR does not match previously seen size!";
 
   // Check if this is a new category & resize the weights table to hold it.
   const auto maxCategoryIdx = *max_element(categoryIdxList.cbegin(), categoryIdxList.cend());
   if( maxCategoryIdx >= numCategories_ ) {
-    numCategories_ = maxCategoryIdx + 1;
-    for( auto & vec : weights_ ) {
-      while( vec.size() < numCategories_ ) {
-        vec.push_back( 0.0f );
-      }
+    reserveCategories_( maxCategoryIdx + 1u );
+    numCategories_ = maxCategoryIdx + 1u;
+  }
+
+  // Predicted likelihoods, computed in the scratch buffer.
+  error_.assign( numCategories_, 0.0f );
+  accumulate_( bits, error_.data() );
+  softmax( error_.begin(), error_.end(), fastSoftmax_ );
+
+  // Error signal = target distribution - prediction, in place.
+  const Real64 target = 1.0f / categoryIdxList.size();
+  for( auto &e : error_ ) {
+    e = -e;
+  }
+  for( size_t i = 0u; i < categoryIdxList.size(); i++ ) {
+    const UInt category = categoryIdxList[i];
+    if( std::find(categoryIdxList.cbegin(), categoryIdxList.cbegin() + i, category)
+          == categoryIdxList.cbegin() + i ) { // each category is counted once
+      error_[category] += target;
     }
   }
 
-  // Compute errors and update weights.
-  const auto& error = calculateError_(categoryIdxList, pattern);
-  for( const auto& bit : pattern.getSparse() ) {
-    for(size_t i = 0u; i < numCategories_; i++) {
-      weights_[bit][i] += alpha_ * error[i];
+  // Update weights.
+  const size_t numCategories = numCategories_;
+  const Real64 alpha = alpha_;
+  const Real64 *error = error_.data();
+  for( const auto& bit : bits ) {
+    Real64 *row = weights_.data() + bit * stride_;
+    for(size_t i = 0u; i < numCategories; i++) {
+      row[i] += alpha * error[i];
     }
   }
 }
 
 
-// Helper function to compute the error signal in learning.
-std::vector<Real64> Classifier::calculateError_(const std::vector<UInt> &categoryIdxList, 
-		                                const SDR &pattern) const {
-  // compute predicted likelihoods
-  auto likelihoods = infer(pattern);
-
-  // Compute target likelihoods
-  PDF targetDistribution(numCategories_ + 1u, 0.0f);
-  for( size_t i = 0u; i < categoryIdxList.size(); i++ ) {
-    targetDistribution[categoryIdxList[i]] = 1.0f / categoryIdxList.size();
+void Classifier::reserveCategories_(const UInt numCategories) {
+  if( numCategories <= stride_ ) {
+    return; // the zero padding already holds the new categories
   }
-
-  for( size_t i = 0u; i < likelihoods.size(); i++ ) {
-    likelihoods[i] = targetDistribution[i] - likelihoods[i];
+  const UInt newStride = std::max( numCategories, stride_ + stride_ / 2u );
+  vector<Real64> grown( static_cast<size_t>(dimensions_) * newStride, 0.0f );
+  for( size_t bit = 0u; bit < dimensions_; bit++ ) {
+    const auto row = weights_.cbegin() + bit * stride_;
+    std::copy( row, row + numCategories_, grown.begin() + bit * newStride );
   }
-  return likelihoods;
+  weights_.swap( grown );
+  stride_ = newStride;
 }
 
 
-void htm::softmax(PDF::iterator begin, PDF::iterator end) {
+void htm::softmax(PDF::iterator begin, PDF::iterator end, const bool approximate) {
   if( begin == end ) {
     return;
   }
+  if( approximate ) {
+    fastmath::softmax( &*begin, &*begin + (end - begin) );
+    return;
+  }
   const auto maxVal = *max_element(begin, end);
   for (auto itr = begin; itr != end; ++itr) {
     *itr = std::exp(*itr - maxVal); // x[i] = e ^ (x[i] - maxVal)
@@ -139,16 +232,20 @@ void htm::softmax(PDF::iterator begin, PDF::iterator end) {
 }
 
 
+MemoryUsage Classifier::memoryUsage() const {
+  return {{"weights", memory::bytes(weights_)},
+          {"caches",  memory::bytes(error_)}};
+}
+
+
 bool Classifier::operator==(const Classifier &other) const {
   if (alpha_ != other.alpha_) return false;
   if (dimensions_ != other.dimensions_) return false; 
   if (numCategories_ != other.numCategories_) return false;
-  if (weights_.size() != other.weights_.size()) return false;
-  for (size_t i = 0; i < weights_.size();  i++) {
-    if (weights_[i].size() != other.weights_[i].size()) return false;
-    for (size_t j = 0; j < weights_[i].size(); j++) {
-      if (weights_[i][j] != other.weights_[i][j]) return false;
-    }
+  for (size_t bit = 0u; bit < dimensions_; bit++) {
+    const auto row      = weights_.cbegin()       + bit * stride_;
+    const auto otherRow = other.weights_.cbegin() + bit * other.stride_;
+    if (not std::equal(row, row + numCategories_, otherRow)) return false;
   }
   return true;
 }
@@ -166,9 +263,11 @@ void Predictor::initialize(const vector<UInt> &steps, const Real alpha)
   NTA_CHECK( not steps.empty() ) << "Required argument steps is empty!";
   steps_ = steps;
   sort(steps_.begin(), steps_.end());
+  steps_.erase( unique(steps_.begin(), steps_.end()), steps_.end() );
 
-  for( const auto step : steps_ ) {
-    classifiers_.emplace( step, alpha );
+  classifiers_.assign( steps_.size(), Classifier(alpha) );
+  for( auto &classifier : classifiers_ ) {
+    classifier.setFastSoftmax( fastSoftmax_ );
   }
 
   reset();
@@ -176,54 +275,207 @@ void Predictor::initialize(const vector<UInt> &steps, const Real alpha)
 
 
 void Predictor::reset() {
-  patternHistory_.clear();
-  recordNumHistory_.clear();
+  historyBegin_ = 0u;
+  historySize_  = 0u;
+  patternHistory_.resize( historyCapacity_() );
+  recordNumHistory_.resize( historyCapacity_() );
 }
 
 
 Predictions Predictor::infer(const SDR &pattern) const {
+  NTA_CHECK(pattern.size > 0) << "No Data pased to Predictor. Pattern is empty.";
+  const size_t numSteps = steps_.size();
   Predictions result;
-  for( const auto step : steps_ ) {
-    result.insert({step, classifiers_.at(step).infer( pattern )});
+  result.reserve( numSteps );
+  vector<PDF *>    pdfs( numSteps );
+  vector<Real64 *> votes( numSteps, nullptr );
+  for( size_t i = 0u; i < numSteps; i++ ) {
+    const Classifier &classifier = classifiers_[i];
+    pdfs[i] = &result[steps_[i]];
+    if( classifier.dimensions_ == 0u ) {
+      NTA_WARN << "Classifier: must call `learn` before `infer`.";
+      pdfs[i]->assign( classifier.numCategories_, std::nan("") ); //empty array []
+      continue;
+    }
+    NTA_ASSERT(pattern.size == classifier.dimensions_) << "Input SDR does not match previously seen size!";
+    pdfs[i]->assign( classifier.numCategories_, 0.0f );
+    votes[i] = pdfs[i]->data();
   }
+
+  const auto &bits = pattern.getSparse();
+  forRanges_( numSteps, [&](const size_t begin, const size_t end) {
+    accumulate_( bits, begin, end, votes.data() );
+    for( size_t i = begin; i < end; i++ ) {
+      if( votes[i] != nullptr ) {
+        softmax( pdfs[i]->begin(), pdfs[i]->end(), classifiers_[i].fastSoftmax_ );
+      }
+    }
+  });
+  return result;
+}
+
+
+std::unordered_map<UInt, TopK> Predictor::inferTopK(const SDR &pattern, const UInt k) const {
+  NTA_CHECK(pattern.size > 0) << "No Data pased to Predictor. Pattern is empty.";
+  const size_t numSteps = steps_.size();
+  std::unordered_map<UInt, TopK> result;
+  result.reserve( numSteps );
+  vector<TopK *>         best( numSteps );
+  vector<vector<Real64>> votes( numSteps );
+  vector<Real64 *>       rows( numSteps, nullptr );
+  for( size_t i = 0u; i < numSteps; i++ ) {
+    const Classifier &classifier = classifiers_[i];
+    best[i] = &result[steps_[i]];
+    if( classifier.dimensions_ == 0u ) {
+      NTA_WARN << "Classifier: must call `learn` before `infer`.";
+      continue;
+    }
+    NTA_ASSERT(pattern.size == classifier.dimensions_) << "Input SDR does not match previously seen size!";
+    votes[i].assign( classifier.numCategories_, 0.0f );
+    rows[i] = votes[i].data();
+  }
+
+  const auto &bits = pattern.getSparse();
+  forRanges_( numSteps, [&](const size_t begin, const size_t end) {
+    accumulate_( bits, begin, end, rows.data() );
+    for( size_t i = begin; i < end; i++ ) {
+      if( rows[i] != nullptr ) {
+        *best[i] = Classifier::topK_( rows[i], classifiers_[i].numCategories_, k, classifiers_[i].fastSoftmax_ );
+      }
+    }
+  });
   return result;
 }
 
 
+void Predictor::accumulate_(const SDR_sparse_t &bits, const size_t begin, const size_t end,
+                            Real64 *const *votes) const {
+  // Each active bit adds its row of every classifier, while the votes stay in cache.
+  for( const auto bit : bits ) {
+    for( size_t i = begin; i < end; i++ ) {
+      Real64 *vote = votes[i];
+      if( vote == nullptr ) continue;
+      const Classifier &classifier = classifiers_[i];
+      const Real64 *row = classifier.weights_.data() + bit * classifier.stride_;
+      const size_t numCategories = classifier.numCategories_;
+      for( size_t category = 0u; category < numCategories; category++ ) {
+        vote[category] += row[category];
+      }
+    }
+  }
+}
+
+
+void Predictor::forRanges_(const size_t numTasks, const std::function<void(size_t, size_t)> &task) const {
+  const size_t numRanges = threadPool_ == nullptr ? 1u
+                         : std::min( threadPool_->size(), numTasks / MIN_STEPS_PER_THREAD );
+  if( numRanges <= 1u ) {
+    task( 0u, numTasks );
+    return;
+  }
+  threadPool_->parallelFor( numRanges, [&](const size_t range) {
+    task( range * numTasks / numRanges, (range + 1u) * numTasks / numRanges );
+  });
+}
+
+
+void Predictor::setNumThreads(const UInt numThreads) {
+  if( numThreads <= 1u ) {
+    threadPool_.reset();
+  } else if( threadPool_ == nullptr or threadPool_->size() != numThreads ) {
+    threadPool_ = std::make_shared<ThreadPool>( numThreads );
+  }
+}
+
+
+void Predictor::setThreadPool(const std::shared_ptr<ThreadPool> &pool)
+  { threadPool_ = pool != nullptr and pool->size() > 1u ? pool : nullptr; }
+
+
 void Predictor::learn(const UInt recordNum, //TODO make recordNum optional, autoincrement as steps 
 		      const SDR &pattern,
                       const std::vector<UInt> &bucketIdxList)
 {
   checkMonotonic_(recordNum);
+  NTA_CHECK( historySize_ == 0u or pattern.dimensions == patternDimensions_ )
+    << "Predictor: input SDR does not match previously seen dimensions!";
 
   // Update pattern history if this is a new record.
-  const UInt lastRecordNum = recordNumHistory_.empty() ? 0 : recordNumHistory_.back();
-  if (recordNumHistory_.size() == 0u || recordNum > lastRecordNum) {
-    patternHistory_.emplace_back( pattern );
-    recordNumHistory_.push_back(recordNum);
-    if (patternHistory_.size() > steps_.back() + 1u) { //steps_ are sorted, so steps_.back() is the "oldest/deepest" N-th step (ie 10 of [1,2,10])
-      patternHistory_.pop_front();
-      recordNumHistory_.pop_front();
-    }
+  if (historySize_ == 0u || recordNum > lastRecordNum_()) {
+    pushHistory_( recordNum, pattern );
   }
+  const size_t capacity = historyCapacity_();
 
-  // Iterate through all recently given inputs, starting from the furthest in the past.
-  auto pastPattern   = patternHistory_.begin();
-  auto pastRecordNum = recordNumHistory_.begin();
-  for( ; pastRecordNum != recordNumHistory_.cend(); pastPattern++, pastRecordNum++ )
+  // Iterate through all recently given inputs, starting from the furthest in
+  // the past, and find their classifiers. The record numbers in the history
+  // are distinct, so each classifier learns at most one pattern.
+  learnTasks_.clear();
+  for( size_t i = 0u; i < historySize_; i++ )
   {
-    const UInt nSteps = recordNum - *pastRecordNum;
+    const size_t slot  = (historyBegin_ + i) % capacity;
+    const UInt nSteps = recordNum - recordNumHistory_[slot];
+    const auto step = lower_bound( steps_.begin(), steps_.end(), nSteps );
+    if( step != steps_.end() and *step == nSteps ) {
+      learnTasks_.emplace_back( step - steps_.begin(), slot );
+    }
+  }
 
-    // Update weights.
-    if( binary_search( steps_.begin(), steps_.end(), nSteps )) {
-      classifiers_.at(nSteps).learn( *pastPattern, bucketIdxList );
+  // Update weights.
+  forRanges_( learnTasks_.size(), [&](const size_t begin, const size_t end) {
+    for( size_t i = begin; i < end; i++ ) {
+      classifiers_[learnTasks_[i].first].learn_( pattern.size, patternHistory_[learnTasks_[i].second], bucketIdxList );
     }
+  });
+}
+
+
+void Predictor::pushHistory_(const UInt recordNum, const SDR &pattern) {
+  const size_t capacity = historyCapacity_(); //steps_ are sorted, so steps_.back() is the "oldest/deepest" N-th step (ie 10 of [1,2,10])
+  if( historySize_ == 0u ) {
+    patternDimensions_ = pattern.dimensions;
+  }
+  size_t slot;
+  if( historySize_ < capacity ) {
+    slot = (historyBegin_ + historySize_) % capacity;
+    historySize_++;
   }
+  else { // full, overwrite the oldest
+    slot = historyBegin_;
+    historyBegin_ = (historyBegin_ + 1u) % capacity;
+  }
+  const auto &sparse = pattern.getSparse();
+  patternHistory_[slot].assign( sparse.begin(), sparse.end() );
+  recordNumHistory_[slot] = recordNum;
+}
+
+
+void Predictor::setFastSoftmax(const bool enable) {
+  fastSoftmax_ = enable;
+  for( auto &classifier : classifiers_ ) {
+    classifier.setFastSoftmax( enable );
+  }
+}
+
+
+MemoryUsage Predictor::memoryUsage() const {
+  MemoryUsage usage = {{"history", memory::bytes(patternHistory_) + memory::bytes(recordNumHistory_)}};
+  usage["weights"] = 0u;
+  usage["caches"]  = 0u;
+  usage["caches"] += memory::bytes(learnTasks_);
+  for( const auto &classifier : classifiers_ ) {
+    memory::add( usage, "", classifier.memoryUsage() );
+  }
+  return usage;
+}
+
+
+UInt Predictor::lastRecordNum_() const {
+  if( historySize_ == 0u ) return 0u;
+  return recordNumHistory_[(historyBegin_ + historySize_ - 1u) % historyCapacity_()];
 }
 
 
 void Predictor::checkMonotonic_(const UInt recordNum) const {
   // Ensure that recordNum increases monotonically.
-  const UInt lastRecordNum = recordNumHistory_.empty() ? 0 : recordNumHistory_.back();
-  NTA_CHECK(recordNum >= lastRecordNum) << "The record number must increase monotonically.";
+  NTA_CHECK(recordNum >= lastRecordNum_()) << "The record number must increase monotonically.";
 }
@@ -37,12 +37,17 @@
 #define NTA_SDR_CLASSIFIER_HPP
 
 #include <deque>
+#include <functional>
+#include <memory>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <htm/types/Types.hpp>
 #include <htm/types/Sdr.hpp>
 #include <htm/types/Serializable.hpp>
+#include <htm/utils/MemoryUsage.hpp>
+#include <htm/utils/ThreadPool.hpp>
 
 namespace htm {
 
@@ -61,6 +66,12 @@ using PDF = std::vector<Real64>; //Real64 (not Real/float) must be used here,
  */
 UInt argmax( const PDF & data );
 
+/**
+ * The k most likely categories, as (category, probability) pairs ordered from
+ * the most likely. Ties are ordered by category.
+ */
+using TopK = std::vector<std::pair<UInt, Real64>>;
+
 /**
  * The SDR Classifier takes the form of a single layer classification network.
  * It accepts SDRs as input and outputs a predicted distribution of categories.
@@ -132,6 +143,22 @@ public:
    */
   PDF infer(const SDR & pattern) const;
 
+  /**
+   * Batched version of infer(pattern), returns one PDF per pattern.
+   */
+  std::vector<PDF> infer(const std::vector<SDR> & patterns) const;
+
+  /**
+   * Like infer(), but only returns the k most likely categories.
+   * The softmax normalization is computed in one streaming pass, and the
+   * full PDF is never built.
+   * @param pattern: The SDR containing the active input bits.
+   * @param k: Number of categories to return, k=1 is argmax.
+   * @returns: At most k (category, probability) pairs, or empty if k=0 or
+   *           Classifier hasn't called learn() before.
+   */
+  TopK inferTopK(const SDR & pattern, UInt k = 1u) const;
+
   /**
    * Learn from example data.
    *
@@ -140,22 +167,53 @@ public:
    */
   void learn(const SDR & pattern, const std::vector<UInt> & categoryIdxList);
 
+  /**
+   * Compute the softmax of infer() and learn() with the vectorizable exp() of
+   * htm/utils/FastMath.hpp.  The probabilities differ by less than 1e-7,
+   * relative, as the exact softmax() rounds its sum to Real.  Default true,
+   * false uses std::exp() for reproducing older results exactly.  The
+   * setting is not serialized.
+   */
+  void setFastSoftmax(bool enable) { fastSoftmax_ = enable; }
+  bool getFastSoftmax() const { return fastSoftmax_; }
+
+  /**
+   * Bytes of memory by category: weights, caches (the buffer of learn()).
+   */
+  MemoryUsage memoryUsage() const;
+
   CerealAdapter;
   template<class Archive>
   void save_ar(Archive & ar) const
   {
+    // The archive keeps one row per input bit, as before the weights were flattened.
+    std::vector<std::vector<Real64>> weights(dimensions_);
+    for( UInt bit = 0u; bit < dimensions_; bit++ ) {
+      const auto row = weights_.cbegin() + bit * stride_;
+      weights[bit].assign( row, row + numCategories_ );
+    }
     ar(cereal::make_nvp("alpha",         alpha_),
        cereal::make_nvp("dimensions",    dimensions_),
        cereal::make_nvp("numCategories", numCategories_),
-       cereal::make_nvp("weights",       weights_));
+       cereal::make_nvp("weights",       weights));
   }
 
   template<class Archive>
   void load_ar(Archive & ar) {
+    std::vector<std::vector<Real64>> weights;
     ar(cereal::make_nvp("alpha", alpha_), 
        cereal::make_nvp("dimensions", dimensions_),
        cereal::make_nvp("numCategories", numCategories_), 
-       cereal::make_nvp("weights", weights_));
+       cereal::make_nvp("weights", weights));
+    weights_.clear();
+    weights_.reserve( static_cast<size_t>(dimensions_) * numCategories_ );
+    for( const auto &row : weights ) {
+      NTA_CHECK( row.size() == numCategories_ ) << "Classifier: corrupt weights in archive.";
+      weights_.insert( weights_.end(), row.begin(), row.end() );
+    }
+    NTA_CHECK( weights_.size() == static_cast<size_t>(dimensions_) * numCategories_ )
+      << "Classifier: corrupt weights in archive.";
+    stride_ = numCategories_;
   }
 
   bool operator==(const Classifier &other) const;
@@ -165,24 +223,41 @@ private:
   Real alpha_;
   UInt dimensions_;
   UInt numCategories_;
+  UInt stride_; // capacity of each row, >= numCategories_, padding is zero
 
   /**
-   * 2D map used to store the data.
-   * Use as: weights_[ input-bit ][ category-index ]
+   * 2D map used to store the data, one contiguous row-major matrix.
+   * Use as: weights_[ input-bit * stride_ + category-index ]
    * Real64 (not just Real) so the computations do not lose precision.
    */
-  std::vector<std::vector<Real64>> weights_;
+  std::vector<Real64> weights_;
+
+  // Scratch buffer for learn(), holds the PDF and then the error signal.
+  std::vector<Real64> error_;
+
+  bool fastSoftmax_ = true; // see setFastSoftmax()
 
-  // Helper function to compute the error signal for learning.
-  std::vector<Real64> calculateError_(const std::vector<UInt> &bucketIdxList,
-                                      const SDR &pattern) const;
+  // Sum the weight rows of the active bits into `votes` (numCategories_ long).
+  void accumulate_(const SDR_sparse_t &bits, Real64 *votes) const;
+
+  // The k largest of `votes`, with their softmax probabilities.
+  static TopK topK_(const Real64 *votes, UInt numCategories, UInt k, bool fastSoftmax);
+
+  // learn() on a pattern of `size` bits, given by its active bits.
+  friend class Predictor;
+  void learn_(UInt size, const SDR_sparse_t &bits, const std::vector<UInt> &categoryIdxList);
+
+  // Make room for categories [0, numCategories), growing rows geometrically.
+  void reserveCategories_(UInt numCategories);
 };
 
 /**
  * Helper function for Classifier::infer.  Converts the raw data accumulators
  * into a PDF.
+ *
+ * @param approximate - with fastmath::softmax(), see Classifier::setFastSoftmax().
  */
-void softmax(PDF::iterator begin, PDF::iterator end);
+void softmax(PDF::iterator begin, PDF::iterator end, bool approximate = false);
 
 
 /******************************************************************************/
@@ -199,7 +274,9 @@ using Predictions = std::unordered_map<UInt, PDF>;
  * The Predictor class does N-Step ahead predictions.
  *
  * Internally, this class uses Classifiers to associate SDRs with future values.
- * This class handles missing datapoints.
+ * This class handles missing datapoints.  Inference reads the active bits of
+ * the pattern once for all steps; with setNumThreads() the steps are split
+ * between threads.
  *
  * Compatibility Note:  This class is the replacement for the old SDRClassifier.
  * It no longer provides estimates of the actual value. Instead, users can get a rough estimate
@@ -268,6 +345,12 @@ public:
    */
   Predictions infer(const SDR &pattern) const;
 
+  /**
+   * Compute the k most likely categories for each prediction step,
+   * see Classifier::inferTopK.
+   */
+  std::unordered_map<UInt, TopK> inferTopK(const SDR &pattern, UInt k = 1u) const;
+
   /**
    * Learn from example data.
    *
@@ -280,31 +363,120 @@ public:
 	     const SDR &pattern,
              const std::vector<UInt> &bucketIdxList);
 
+  /**
+   * See Classifier::setFastSoftmax(), for the classifiers of all steps, also
+   * after initialize() and loading.  Default true.
+   */
+  void setFastSoftmax(bool enable);
+  bool getFastSoftmax() const { return fastSoftmax_; }
+
+  /**
+   * Bytes of memory by category: history (the input patterns kept for the
+   * steps), weights and caches of the classifiers, see Classifier::memoryUsage().
+   */
+  MemoryUsage memoryUsage() const;
+
+  /**
+   * Split the steps of infer(), inferTopK() and learn() between threads,
+   * at least MIN_STEPS_PER_THREAD steps per thread. The results are
+   * identical to the single threaded computation.
+   *
+   * The setting is not serialized, default is 1 (no extra threads).
+   *
+   * @param numThreads - number of threads including the caller, 0 or 1 turns
+   *   the threading off.
+   */
+  void setNumThreads(UInt numThreads);
+  UInt getNumThreads() const noexcept {
+    return threadPool_ == nullptr ? 1u : static_cast<UInt>(threadPool_->size()); }
+  /**
+   * As `setNumThreads()`, with threads shared with others, eg. a pool of a
+   * Network (see Network::addThreadPool()).
+   */
+  void setThreadPool(const std::shared_ptr<ThreadPool> &pool);
+
+  static constexpr const size_t MIN_STEPS_PER_THREAD = 4u;
+
   CerealAdapter;
   template<class Archive>
   void save_ar(Archive & ar) const
   {
+    // The archive keeps the history as SDRs, the format used before the ring buffer.
+    std::deque<SDR>  patternHistory;
+    std::deque<UInt> recordNumHistory;
+    for( size_t i = 0u; i < historySize_; i++ ) {
+      const size_t slot = (historyBegin_ + i) % historyCapacity_();
+      patternHistory.emplace_back( patternDimensions_ );
+      patternHistory.back().setSparse( SDR_sparse_t(patternHistory_[slot]) );
+      recordNumHistory.push_back( recordNumHistory_[slot] );
+    }
+    // ... and the classifiers by step.
+    std::unordered_map<UInt, Classifier> classifiers;
+    for( size_t i = 0u; i < steps_.size(); i++ ) {
+      classifiers.emplace( steps_[i], classifiers_[i] );
+    }
     ar(cereal::make_nvp("steps",            steps_),
-       cereal::make_nvp("patternHistory",   patternHistory_),
-       cereal::make_nvp("recordNumHistory", recordNumHistory_),
-       cereal::make_nvp("classifiers",      classifiers_));
+       cereal::make_nvp("patternHistory",   patternHistory),
+       cereal::make_nvp("recordNumHistory", recordNumHistory),
+       cereal::make_nvp("classifiers",      classifiers));
   }
 
   template<class Archive>
-  void load_ar(Archive & ar)
-    { ar( steps_, patternHistory_, recordNumHistory_, classifiers_ ); }
+  void load_ar(Archive & ar) {
+    std::deque<SDR>  patternHistory;
+    std::deque<UInt> recordNumHistory;
+    std::unordered_map<UInt, Classifier> classifiers;
+    ar( steps_, patternHistory, recordNumHistory, classifiers );
+    NTA_CHECK( patternHistory.size() == recordNumHistory.size() and
+               patternHistory.size() <= historyCapacity_() )
+      << "Predictor: corrupt history in archive.";
+    classifiers_.clear();
+    for( const auto step : steps_ ) {
+      const auto classifier = classifiers.find( step );
+      NTA_CHECK( classifier != classifiers.end() ) << "Predictor: no classifier of step " << step << " in archive.";
+      classifiers_.push_back( std::move(classifier->second) );
+      classifiers_.back().setFastSoftmax( fastSoftmax_ );
+    }
+    reset();
+    for( size_t i = 0u; i < patternHistory.size(); i++ ) {
+      pushHistory_( recordNumHistory[i], patternHistory[i] );
+    }
+  }
 
 private:
   // The list of prediction steps to learn and infer.
   std::vector<UInt> steps_;
 
-  // Stores the input pattern history, starting with the previous input.
-  std::deque<SDR>  patternHistory_;
-  std::deque<UInt> recordNumHistory_;
+  // Stores the input pattern history, oldest first, as a ring buffer of
+  // sparse index arrays with room for steps_.back() + 1 patterns. The
+  // slots are reused, so once full, learning does not allocate.
+  std::vector<SDR_sparse_t> patternHistory_;
+  std::vector<UInt>         recordNumHistory_;
+  size_t historyBegin_ = 0u; // slot of the oldest pattern
+  size_t historySize_  = 0u;
+  std::vector<UInt> patternDimensions_;
+
+  size_t historyCapacity_() const { return steps_.empty() ? 0u : steps_.back() + 1u; }
+  void pushHistory_(UInt recordNum, const SDR &pattern);
+  UInt lastRecordNum_() const;
   void checkMonotonic_(UInt recordNum) const;
 
-  // One per prediction step
-  std::unordered_map<UInt, Classifier> classifiers_;
+  // One per prediction step, in the order of steps_
+  std::vector<Classifier> classifiers_;
+  bool fastSoftmax_ = true; // see setFastSoftmax()
+
+  // Scratch buffer of learn(): (index of the step, history slot) to learn.
+  std::vector<std::pair<size_t, size_t>> learnTasks_;
+
+  std::shared_ptr<ThreadPool> threadPool_; //null: single threaded, see setNumThreads()
+
+  // Run task(begin, end) on ranges covering [0, numTasks), in parallel when
+  // there are enough tasks for the threads.
+  void forRanges_(size_t numTasks, const std::function<void(size_t, size_t)> &task) const;
+
+  // Sum the weight rows of the active bits of the classifiers [begin, end)
+  // into their votes, reading each bit once; null votes are skipped.
+  void accumulate_(const SDR_sparse_t &bits, size_t begin, size_t end, Real64 *const *votes) const;
 
 };      // End of Predictor class
 
@@ -0,0 +1,116 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the ShardedConnections class
+ */
+
+#include <algorithm> // upper_bound
+
+#include <htm/algorithms/ShardedConnections.hpp>
+
+using namespace std;
+using namespace htm;
+
+
+ShardedConnections::ShardedConnections(const CellIdx numCells,
+                                       const UInt numShards,
+                                       const Permanence connectedThreshold,
+                                       const bool timeseries,
+                                       const PermanencePrecision precision)
+  : shards_(numShards),
+    shardActive_(numShards),
+    shardMatching_(numShards),
+    workers_(numShards + 1u, true) //the caller waits while the shards work
+{
+  NTA_CHECK(numShards > 0u) << "ShardedConnections: needs at least 1 shard";
+  NTA_CHECK(numShards <= numCells) << "ShardedConnections: more shards (" << numShards
+                                   << ") than cells (" << numCells << ")";
+  firstCell_.resize(numShards + 1u);
+  for(UInt s = 0; s <= numShards; s++) {
+    firstCell_[s] = static_cast<CellIdx>(static_cast<UInt64>(numCells) * s / numShards);
+  }
+  // allocated by the (pinned) worker, so the memory is on its node
+  workers_.forEachWorker([&](const size_t s) {
+    shards_[s].reset(new Connections(firstCell_[s + 1] - firstCell_[s],
+                                     connectedThreshold, timeseries, precision));
+  });
+}
+
+
+UInt ShardedConnections::shardForCell(const CellIdx cell) const {
+  NTA_ASSERT(cell < numCells()) << "ShardedConnections: cell out of bounds " << cell;
+  const auto it = upper_bound(firstCell_.begin(), firstCell_.end(), cell);
+  return static_cast<UInt>(it - firstCell_.begin()) - 1u;
+}
+
+
+ShardSegment ShardedConnections::createSegment(const CellIdx cell, const SegmentIdx maxSegmentsPerCell) {
+  const UInt s = shardForCell(cell);
+  return { s, shards_[s]->createSegment(cell - firstCell_[s], maxSegmentsPerCell) };
+}
+
+
+size_t ShardedConnections::numSegments() const {
+  size_t n = 0;
+  for(const auto &c : shards_) n += c->numSegments();
+  return n;
+}
+
+
+size_t ShardedConnections::numSynapses() const {
+  size_t n = 0;
+  for(const auto &c : shards_) n += c->numSynapses();
+  return n;
+}
+
+
+void ShardedConnections::forEachShard(const function<void(Connections &, UInt)> &task) {
+  workers_.forEachWorker([&](const size_t s) {
+    task(*shards_[s], static_cast<UInt>(s));
+  });
+}
+
+
+void ShardedConnections::computeActivity(vector<SegmentActivity> &activity,
+                                         const vector<CellIdx> &activePresynapticCells,
+                                         const bool learn) {
+  activity.resize(shards_.size());
+  forEachShard([&](Connections &c, const UInt s) {
+    c.computeActivity(activity[s], activePresynapticCells, learn);
+  });
+}
+
+
+void ShardedConnections::filterSegmentsByActivity(const vector<SegmentActivity> &activity,
+                                                  const SynapseIdx activationThreshold,
+                                                  const SynapseIdx matchingThreshold,
+                                                  vector<ShardSegment> &active,
+                                                  vector<ShardSegment> &matching) {
+  NTA_CHECK(activity.size() == shards_.size()) << "ShardedConnections: one SegmentActivity per shard";
+  forEachShard([&](Connections &, const UInt s) {
+    Connections::filterSegmentsByActivity(activity[s].numActiveConnected, activationThreshold,
+                                          activity[s].numActivePotential, matchingThreshold,
+                                          shardActive_[s], shardMatching_[s]);
+  });
+  active.clear();
+  matching.clear();
+  for(UInt s = 0; s < numShards(); s++) {
+    for(const auto seg : shardActive_[s])   active.push_back({s, seg});
+    for(const auto seg : shardMatching_[s]) matching.push_back({s, seg});
+  }
+}
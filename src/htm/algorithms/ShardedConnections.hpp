@@ -0,0 +1,134 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the ShardedConnections class
+ */
+
+#ifndef NTA_SHARDED_CONNECTIONS_HPP
+#define NTA_SHARDED_CONNECTIONS_HPP
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <htm/algorithms/Connections.hpp>
+#include <htm/utils/ThreadPool.hpp>
+
+namespace htm {
+
+/**
+ * A segment of a ShardedConnections: the shard and the segment in it.
+ */
+struct ShardSegment {
+  UInt32  shard;
+  Segment segment;
+  bool operator==(const ShardSegment &o) const { return shard == o.shard and segment == o.segment; }
+  bool operator!=(const ShardSegment &o) const { return not operator==(o); }
+};
+
+/**
+ * Connections of a large model, split into shards for machines with several
+ * NUMA nodes (sockets).
+ *
+ * The cells are split into `numShards` contiguous blocks, each shard is a
+ * Connections of its block, with its own segments, synapses and presynaptic
+ * index. The presynaptic cells are not split, each shard sees the whole input.
+ *
+ * Each shard has a worker thread, pinned to NUMA node `shard % numNumaNodes`.
+ * A shard is created on its worker, and `computeActivity()` and
+ * `forEachShard()` run on the workers too, so the memory of a shard is first
+ * touched (and allocated) on its node and stays local. Structural changes made
+ * by the caller (e.g. `createSegment()`) work as well, but memory they grow is
+ * allocated on the caller's node; batch learning per shard in `forEachShard()`.
+ *
+ * Cells are global in this interface, `shard(s)` uses the local cells
+ * `cell - firstCell(s)`.
+ */
+class ShardedConnections {
+public:
+  /**
+   * @param numCells  Number of cells, over all shards.
+   * @param numShards Number of shards, e.g. ThreadPool::numNumaNodes(). At least 1.
+   * Other parameters: see Connections.
+   */
+  ShardedConnections(const CellIdx numCells,
+                     const UInt numShards,
+                     const Permanence connectedThreshold = 0.5f,
+                     const bool timeseries = false,
+                     const PermanencePrecision precision = PermanencePrecision::FLOAT32);
+  ShardedConnections(const ShardedConnections &) = delete;
+  ShardedConnections &operator=(const ShardedConnections &) = delete;
+
+  UInt numShards() const noexcept { return static_cast<UInt>(shards_.size()); }
+  CellIdx numCells() const noexcept { return firstCell_.back(); }
+
+  /** The shard owning a (global) cell. */
+  UInt shardForCell(const CellIdx cell) const;
+  /** The first (global) cell of a shard, its cells are [firstCell(s), firstCell(s+1)). */
+  CellIdx firstCell(const UInt shard) const { return firstCell_[shard]; }
+
+  Connections &shard(const UInt shard) { return *shards_[shard]; }
+  const Connections &shard(const UInt shard) const { return *shards_[shard]; }
+
+  /** Same as Connections::createSegment(), on the shard of the (global) cell. */
+  ShardSegment createSegment(const CellIdx cell,
+                             const SegmentIdx maxSegmentsPerCell = std::numeric_limits<SegmentIdx>::max());
+  /** The (global) cell of a segment. */
+  CellIdx cellForSegment(const ShardSegment segment) const {
+    return firstCell_[segment.shard] + shards_[segment.shard]->cellForSegment(segment.segment);
+  }
+
+  size_t numSegments() const;
+  size_t numSynapses() const;
+
+  /**
+   * Run task(shard(s), s) for each shard, in parallel, each on the worker of its shard.
+   * If a task throws, the first exception is rethrown here.
+   */
+  void forEachShard(const std::function<void(Connections &, UInt)> &task);
+
+  /**
+   * Connections::computeActivity() of each shard, on its worker.
+   * `activity[s]` are the counters of the segments of shard s; reuse `activity`
+   * between calls so each shard's counters stay on its node.
+   */
+  void computeActivity(std::vector<SegmentActivity> &activity,
+                       const std::vector<CellIdx> &activePresynapticCells,
+                       const bool learn = true);
+
+  /**
+   * Connections::filterSegmentsByActivity() of each shard, on its worker,
+   * then merged into lists of ShardSegment (ordered by shard, then segment).
+   */
+  void filterSegmentsByActivity(const std::vector<SegmentActivity> &activity,
+                                const SynapseIdx activationThreshold,
+                                const SynapseIdx matchingThreshold,
+                                std::vector<ShardSegment> &active,
+                                std::vector<ShardSegment> &matching);
+
+private:
+  std::vector<CellIdx> firstCell_; //numShards + 1 entries
+  std::vector<std::unique_ptr<Connections>> shards_;
+  std::vector<std::vector<Segment>> shardActive_;   //per shard buffers of filterSegmentsByActivity()
+  std::vector<std::vector<Segment>> shardMatching_;
+  ThreadPool workers_;
+};
+
+} // namespace htm
+
+#endif // NTA_SHARDED_CONNECTIONS_HPP
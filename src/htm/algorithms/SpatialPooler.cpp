@@ -24,48 +24,28 @@
 #include <iterator> //begin()
 #include <cmath> //fmod
 #include <numeric> //iota
+#include <cstring> //memcpy
+#include <type_traits>
+#include <sstream>
+#include <iomanip> //hexfloat
+#include <mutex>
+#include <random> //random_device
 
 #include <htm/algorithms/SpatialPooler.hpp>
+#include <htm/algorithms/SpatialPoolerBitset.hpp>
+#include <htm/algorithms/SpatialPoolerIncremental.hpp>
+#include <htm/algorithms/SpatialPoolerLocality.hpp>
+#include <htm/algorithms/SpatialPoolerGpu.hpp>
+#include <htm/os/Directory.hpp>
+#include <htm/os/Path.hpp>
+#include <htm/types/Coordinates.hpp>
+#include <htm/utils/FastMath.hpp>
 #include <htm/utils/Topology.hpp>
 #include <htm/utils/VectorHelpers.hpp>
 
 using namespace std;
 using namespace htm;
 
-class CoordinateConverterND {
-
-public:
-  CoordinateConverterND(const vector<UInt> &dimensions) {
-    NTA_ASSERT(!dimensions.empty());
-
-    dimensions_ = dimensions;
-    UInt b = 1u;
-    for (Size i = dimensions.size(); i > 0u; i--) {
-      bounds_.insert(bounds_.begin(), b);
-      b *= dimensions[i-1];
-    }
-  }
-
-  void toCoord(UInt index, vector<UInt> &coord) const {
-    coord.clear();
-    for (Size i = 0u; i < bounds_.size(); i++) {
-      coord.push_back((index / bounds_[i]) % dimensions_[i]);
-    }
-  };
-
-  UInt toIndex(vector<UInt> &coord) const {
-    UInt index = 0;
-    for (Size i = 0; i < coord.size(); i++) {
-      index += coord[i] * bounds_[i];
-    }
-    return index;
-  };
-
-private:
-  vector<UInt> dimensions_;
-  vector<UInt> bounds_;
-};
-
 SpatialPooler::SpatialPooler() {
   // The current version number.
   version_ = 2;
@@ -77,7 +57,8 @@ SpatialPooler::SpatialPooler(
     Real localAreaDensity, UInt numActiveColumnsPerInhArea,
     UInt stimulusThreshold, Real synPermInactiveDec, Real synPermActiveInc,
     Real synPermConnected, Real minPctOverlapDutyCycles, UInt dutyCyclePeriod,
-    Real boostStrength, Int seed, UInt spVerbosity, bool wrapAround)
+    Real boostStrength, Int seed, UInt spVerbosity, bool wrapAround,
+    Random::Engine rngEngine)
     : SpatialPooler::SpatialPooler()
 {
   // The current version number for serialzation.
@@ -99,7 +80,8 @@ SpatialPooler::SpatialPooler(
              boostStrength,
              seed,
              spVerbosity,
-             wrapAround);
+             wrapAround,
+             rngEngine);
 }
 
 vector<UInt> SpatialPooler::getColumnDimensions() const {
@@ -163,10 +145,7 @@ UInt SpatialPooler::getInhibitionRadius() const { return inhibitionRadius_; }
 
 void SpatialPooler::setInhibitionRadius(UInt inhibitionRadius) {
   NTA_ASSERT(inhibitionRadius > 0);
-  if (inhibitionRadius_ != inhibitionRadius) {
-    inhibitionRadius_ = inhibitionRadius;
-    neighborMap_ = Neighborhood::updateAllNeighbors(inhibitionRadius_, columnDimensions_, wrapAround_, /*skip_center=*/true);
-  }
+  inhibitionRadius_ = inhibitionRadius;
 }
 
 UInt SpatialPooler::getDutyCyclePeriod() const { return dutyCyclePeriod_; }
@@ -257,6 +236,64 @@ void SpatialPooler::getBoostFactors(Real boostFactors[]) const { //TODO make vec
 
 void SpatialPooler::setBoostFactors(Real boostFactors[]) {
   boostFactors_.assign(&boostFactors[0], &boostFactors[numColumns_]);
+  if(gpu_) gpu_->markBoostDirty();
+}
+
+void SpatialPooler::setGpuEnabled(const bool enable) {
+  NTA_CHECK(not enable or SpatialPoolerGpu::available())
+      << "SpatialPooler: GPU not available, build with HTM_CUDA and a CUDA device.";
+  NTA_CHECK(not (enable and bitsetEnabled_)) << "SpatialPooler: the GPU and the bitset overlaps exclude each other.";
+  NTA_CHECK(not (enable and incrementalEnabled_)) << "SpatialPooler: the GPU and the incremental overlaps exclude each other.";
+  NTA_CHECK(not (enable and localityEnabled_)) << "SpatialPooler: the GPU and the locality order exclude each other.";
+  gpuEnabled_ = enable;
+  if(not enable) gpu_.reset();
+}
+
+void SpatialPooler::setBitsetEnabled(const bool enable) {
+  NTA_CHECK(not (enable and gpuEnabled_)) << "SpatialPooler: the GPU and the bitset overlaps exclude each other.";
+  NTA_CHECK(not (enable and incrementalEnabled_)) << "SpatialPooler: the bitset and the incremental overlaps exclude each other.";
+  NTA_CHECK(not (enable and localityEnabled_)) << "SpatialPooler: the bitset overlaps and the locality order exclude each other.";
+  bitsetEnabled_ = enable;
+  if(not enable) bitset_.reset();
+}
+
+void SpatialPooler::setIncrementalEnabled(const bool enable) {
+  NTA_CHECK(not (enable and gpuEnabled_)) << "SpatialPooler: the GPU and the incremental overlaps exclude each other.";
+  NTA_CHECK(not (enable and bitsetEnabled_)) << "SpatialPooler: the bitset and the incremental overlaps exclude each other.";
+  NTA_CHECK(not (enable and localityEnabled_)) << "SpatialPooler: the incremental overlaps and the locality order exclude each other.";
+  incrementalEnabled_ = enable;
+  if(not enable) incremental_.reset();
+}
+
+void SpatialPooler::setLocalityEnabled(const bool enable) {
+  NTA_CHECK(not (enable and gpuEnabled_)) << "SpatialPooler: the GPU and the locality order exclude each other.";
+  NTA_CHECK(not (enable and bitsetEnabled_)) << "SpatialPooler: the bitset overlaps and the locality order exclude each other.";
+  NTA_CHECK(not (enable and incrementalEnabled_)) << "SpatialPooler: the incremental overlaps and the locality order exclude each other.";
+  localityEnabled_ = enable;
+  if(not enable) locality_.reset();
+}
+
+void SpatialPooler::syncBitset_() {
+  if(not bitset_ or not bitset_->mirrors(connections_)) { //first compute, or this SP was copied
+    bitset_ = std::make_shared<SpatialPoolerBitset>(connections_, numInputs_, numColumns_);
+  } else {
+    bitset_->sync();
+  }
+}
+
+void SpatialPooler::syncIncremental_() {
+  if(not incremental_ or not incremental_->mirrors(connections_)) { //first compute, or this SP was copied
+    incremental_ = std::make_shared<SpatialPoolerIncremental>(connections_, numInputs_, numColumns_);
+  }
+  incremental_->sync();
+}
+
+void SpatialPooler::syncLocality_() {
+  if(not locality_ or not locality_->mirrors(connections_)) { //first compute, or this SP was copied
+    locality_ = std::make_shared<SpatialPoolerLocality>(connections_, inputDimensions_, columnDimensions_);
+  } else {
+    locality_->sync();
+  }
 }
 
 void SpatialPooler::getOverlapDutyCycles(Real overlapDutyCycles[]) const {
@@ -292,8 +329,7 @@ void SpatialPooler::getPotential(UInt column, UInt potential[]) const {
   std::fill( potential, potential + numInputs_, 0 );
   const auto &synapses = connections_.synapsesForSegment( column );
   for(const auto syn : synapses) {
-    const auto &synData = connections_.dataForSynapse( syn );
-    potential[synData.presynapticCell] = 1;
+    potential[connections_.presynapticCellForSynapse( syn )] = 1;
   }
 }
 
@@ -320,9 +356,9 @@ vector<Real> SpatialPooler::getPermanence(const UInt column,
   const auto &synapses = connections_.synapsesForSegment( column );
   vector<Real> permanences(numInputs_, 0.0f);
   for( const auto syn : synapses ) {
-    const auto &synData = connections_.dataForSynapse( syn );
-    if( synData.permanence >= threshold) { // there must be >= for default case 0.0 where we want all permanences
-      permanences[ synData.presynapticCell ] = synData.permanence;
+    const Permanence permanence = connections_.permanenceForSynapse( syn );
+    if( permanence >= threshold) { // there must be >= for default case 0.0 where we want all permanences
+      permanences[ connections_.presynapticCellForSynapse( syn ) ] = permanence;
     }
   }
   return permanences;
@@ -341,8 +377,7 @@ void SpatialPooler::setPermanence(UInt column, const Real permanences[]) {
 
   const auto synapses = connections_.synapsesForSegment( column );
   for(const auto &syn : synapses) {
-    const auto &synData = connections_.dataForSynapse( syn );
-    const auto &presyn  = synData.presynapticCell;
+    const auto presyn = connections_.presynapticCellForSynapse( syn );
     connections_.updateSynapsePermanence( syn, permanences[presyn] );
 
 #ifndef NDEBUG
@@ -388,7 +423,46 @@ void SpatialPooler::initialize(
     Real boostStrength, 
     Int seed, 
     UInt spVerbosity, 
-    bool wrapAround) {
+    bool wrapAround,
+    Random::Engine rngEngine) {
+
+  // See setInitializationCache(). The key holds every parameter which
+  // the initial state depends on, all but spVerbosity.
+  const string cacheDirectory = seed == 0 ? string() : getInitializationCache();
+  string cachePath;
+  string cacheKey;
+  if (not cacheDirectory.empty()) {
+    stringstream key;
+    key << hexfloat << "SpatialPooler::initialize " << version_ << " Real" << sizeof(Real) << " input";
+    for (const auto d : inputDimensions) key << ' ' << d;
+    key << " columns";
+    for (const auto d : columnDimensions) key << ' ' << d;
+    key << " potentialRadius " << potentialRadius << " potentialPct " << potentialPct
+        << " globalInhibition " << globalInhibition << " localAreaDensity " << localAreaDensity
+        << " numActiveColumnsPerInhArea " << numActiveColumnsPerInhArea
+        << " stimulusThreshold " << stimulusThreshold << " synPermInactiveDec " << synPermInactiveDec
+        << " synPermActiveInc " << synPermActiveInc << " synPermConnected " << synPermConnected
+        << " minPctOverlapDutyCycles " << minPctOverlapDutyCycles << " dutyCyclePeriod " << dutyCyclePeriod
+        << " boostStrength " << boostStrength << " seed " << seed << " wrapAround " << wrapAround
+        << " rngEngine " << static_cast<int>(rngEngine);
+    cacheKey = key.str();
+    UInt64 hash = 14695981039346656037ull; // FNV-1a
+    for (const char c : cacheKey) {
+      hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+    stringstream name;
+    name << "sp-" << hex << setw(16) << setfill('0') << hash << ".ckpt";
+    cachePath = Path::join(cacheDirectory, name.str());
+    if (loadInitializationCache_(cachePath, cacheKey)) {
+      spVerbosity_ = spVerbosity;
+      if (spVerbosity_ > 0) {
+        printParameters();
+        std::cout << "CPP SP seed                 = " << seed << " (from " << cachePath << ")" << std::endl;
+      }
+      return;
+    }
+    // else also after a failed load: everything below is set from scratch.
+  }
 
   numInputs_ = 1u;
   inputDimensions_.clear();
@@ -418,7 +492,7 @@ void SpatialPooler::initialize(
     setLocalAreaDensity(localAreaDensity); 
   }
 
-  rng_ = Random(seed);
+  rng_ = Random(seed, rngEngine);
 
   potentialRadius_ = potentialRadius > numInputs_ ? numInputs_ : potentialRadius;
   NTA_CHECK(potentialPct > 0 && potentialPct <= 1);
@@ -443,27 +517,58 @@ void SpatialPooler::initialize(
   activeDutyCycles_.assign(numColumns_, 0);
   minOverlapDutyCycles_.assign(numColumns_, 0.0);
   boostFactors_.assign(numColumns_, 1.0); //1 is neutral value for boosting
-  boostedOverlaps_.resize(numColumns_);
+  boostedOverlaps_.assign(numColumns_, 0.0f);
+  boostedColumns_.clear();
+  boostedValid_ = true;
 
   inhibitionRadius_ = 0;
 
   connections_.initialize(numColumns_, synPermConnected_);
-  for (Size i = 0; i < numColumns_; ++i) {
-    connections_.createSegment( static_cast<CellIdx>(i) , 1 /* max segments per cell is fixed for SP to 1 */);
-
-    // Note: initMapPotential_ & initPermanence_ return dense arrays.
-    vector<UInt> potential = initMapPotential_((UInt)i, wrapAround_);
-    vector<Real> perm = initPermanence_(potential, initConnectedPct_);
-    for(size_t presyn = 0; presyn < numInputs_; presyn++) {
-      if( potential[presyn] )
-        connections_.createSynapse( static_cast<Segment>(i), static_cast<htm::CellIdx>(presyn), perm[presyn] );
+  gpu_.reset();
+  bitset_.reset();
+  incremental_.reset();
+  locality_.reset();
+
+  // With per column random streams, blocks of columns are drawn in parallel
+  // and then inserted into the Connections in order, by this thread.
+  const bool columnStreams = rng_.getEngine() == Random::COUNTER;
+  ThreadPool *threads = columnStreams ? connections_.getThreadPool() : nullptr;
+  const UInt numTasks = threads == nullptr ? 1u : static_cast<UInt>(threads->size());
+  const UInt blockSize = numTasks * MIN_COLUMNS_PER_TILE;
+  vector<NeighborhoodStencil> inputNeighborhoods(numTasks,
+      NeighborhoodStencil(potentialRadius_, inputDimensions_, wrapAround_));
+  vector<vector<UInt>> potential(std::min(blockSize, numColumns_));
+  vector<vector<Real>> perm(potential.size());
+  for (UInt begin = 0u; begin < numColumns_; begin += blockSize) {
+    const UInt end = std::min(begin + blockSize, numColumns_);
+    const auto initColumns = [&](const size_t task) {
+      for (UInt column = begin + static_cast<UInt>(task); column < end; column += numTasks) {
+        Random columnRng(1u, Random::COUNTER);
+        if (columnStreams) columnRng = rng_.split(column);
+        Random &rng = columnStreams ? columnRng : rng_;
+        initMapPotential_(column, inputNeighborhoods[task], rng, potential[column - begin]);
+        initPermanence_(potential[column - begin], initConnectedPct_, rng, perm[column - begin]);
+      }
+    };
+    if (numTasks == 1u) {
+      initColumns(0u);
+    } else {
+      threads->parallelFor(numTasks, initColumns);
     }
 
-    connections_.raisePermanencesToThreshold( (Segment)i, stimulusThreshold_ );
+    for (UInt column = begin; column < end; column++) {
+      const Segment segment = connections_.createSegment( column, 1 /* max segments per cell is fixed for SP to 1 */);
+      connections_.createSynapses( segment, potential[column - begin], perm[column - begin] );
+      connections_.raisePermanencesToThreshold( segment, stimulusThreshold_ );
+    }
   }
 
   updateInhibitionRadius_();
 
+  if (not cachePath.empty()) {
+    saveInitializationCache_(cachePath, cacheKey);
+  }
+
   if (spVerbosity_ > 0) {
     printParameters();
     std::cout << "CPP SP seed                 = " << seed << std::endl;
@@ -476,11 +581,41 @@ const vector<SynapseIdx> SpatialPooler::compute(const SDR &input, const bool lea
   active.reshape( columnDimensions_ );
   updateBookeepingVars_(learn);
 
-  const auto& overlaps = connections_.computeActivity(input.getSparse(), learn);
-
-  boostOverlaps_(overlaps, boostedOverlaps_);
-
-  auto activeVector = inhibitColumns_(boostedOverlaps_);
+  vector<CellIdx> activeVector;
+  if(gpuEnabled_) {
+    if(not gpu_ or not gpu_->mirrors(connections_)) { //first compute, or this SP was copied
+      gpu_ = std::make_shared<SpatialPoolerGpu>(connections_, numInputs_, numColumns_);
+    }
+    connections_.computeActivity(overlapActivity_, {}, learn, false); //the bookkeeping only
+    gpu_->computeOverlaps(input.getSparse(), overlapActivity_);
+    boostOverlaps_(overlapActivity_.numActiveConnected, overlapActivity_.touched, boostedOverlaps_);
+    if(isGlobalInhibition_()) {
+      activeVector = gpu_->inhibitColumnsGlobal(boostFactors_, boostStrength_ >= htm::Epsilon,
+                                                inhibitionDensity_(), stimulusThreshold_);
+    } else {
+      activeVector = inhibitColumns_(boostedOverlaps_, &overlapActivity_.touched);
+    }
+  } else {
+    if(bitsetEnabled_) {
+      connections_.computeActivity(overlapActivity_, {}, learn, false); //the bookkeeping only
+      syncBitset_();
+      bitset_->computeOverlaps(input, overlapActivity_);
+    } else if(incrementalEnabled_) {
+      connections_.computeActivity(overlapActivity_, {}, learn, false); //the bookkeeping only
+      syncIncremental_();
+      incremental_->computeOverlaps(input, overlapActivity_);
+    } else if(localityEnabled_) {
+      connections_.computeActivity(overlapActivity_, {}, learn, false); //the bookkeeping only
+      syncLocality_();
+      locality_->computeOverlaps(input, overlapActivity_);
+    } else {
+      // only the connected synapses, `touched` lists the columns with overlap > 0
+      connections_.computeActivity(overlapActivity_, input.getSparse(), learn, false);
+    }
+    boostOverlaps_(overlapActivity_.numActiveConnected, overlapActivity_.touched, boostedOverlaps_);
+    activeVector = inhibitColumns_(boostedOverlaps_, &overlapActivity_.touched);
+  }
+  const auto &overlaps = overlapActivity_.numActiveConnected;
   // Notify the active SDR that its internal data vector has changed.  Always
   // call SDR's setter methods even if when modifying the SDR's own data
   // inplace.
@@ -488,10 +623,13 @@ const vector<SynapseIdx> SpatialPooler::compute(const SDR &input, const bool lea
   active.setSparse( activeVector );
 
   if (learn) {
-    adaptSynapses_(input, active);
-    updateDutyCycles_(overlaps, active);
-    bumpUpWeakColumns_();
-    updateBoostFactors_();
+    if(learnFraction_ < 1.0f or learnEvery_ > 1u) {
+      adaptSynapsesThrottled_(input, active);
+    } else {
+      adaptSynapses_(input, active);
+    }
+    updateColumnStates_(overlaps, active);
+    if(gpu_) gpu_->markBoostDirty();
     if (isUpdateRound_()) {
       updateInhibitionRadius_();
       updateMinDutyCycles_();
@@ -502,14 +640,70 @@ const vector<SynapseIdx> SpatialPooler::compute(const SDR &input, const bool lea
 }
 
 
-void SpatialPooler::boostOverlaps_(const vector<SynapseIdx> &overlaps, //TODO use Eigen sparse vector here
-                                   vector<Real> &boosted) const {
-  if(boostStrength_ < htm::Epsilon) { //boost ~ 0.0, we can skip these computations, just copy the data
-    boosted.assign(overlaps.begin(), overlaps.end());
-    return;
+void SpatialPooler::computeBatch(const vector<SDR> &inputs, vector<SDR> &outputs) {
+  NTA_CHECK(inputs.size() == outputs.size())
+      << "computeBatch: " << inputs.size() << " inputs but " << outputs.size() << " outputs";
+  if(inputs.empty()) return;
+  for(size_t i = 0; i < inputs.size(); i++) {
+    inputs[i].reshape(  inputDimensions_ );
+    outputs[i].reshape( columnDimensions_ );
+    if(bitsetEnabled_) inputs[i].getPacked(); //convert now, not concurrently
+    else inputs[i].getSparse();
   }
-  for (size_t i = 0; i < numColumns_; i++) {
-    boosted[i] = overlaps[i] * boostFactors_[i];
+  iterationNum_ += static_cast<UInt>(inputs.size());
+  if(bitsetEnabled_) syncBitset_();
+  else connections_.prepareConcurrentActivity();
+
+  ThreadPool *threads = connections_.getThreadPool();
+  const size_t numChunks = threads == nullptr ? 1u : std::min(threads->size(), inputs.size());
+  if(batchBuffers_.size() < numChunks) batchBuffers_.resize(numChunks);
+
+  const auto computeChunk = [&](const size_t chunk) {
+    auto &buffer = batchBuffers_[chunk];
+    if(buffer.boostedOverlaps.size() != numColumns_) buffer.boostedOverlaps.assign(numColumns_, 0.0f);
+    const auto &touched = buffer.activity.touched;
+    const size_t end = inputs.size() * (chunk + 1u) / numChunks;
+    for(size_t i = inputs.size() * chunk / numChunks; i < end; i++) {
+      if(bitsetEnabled_) bitset_->computeOverlaps(inputs[i], buffer.activity);
+      else connections_.computeConnectedActivity(buffer.activity, inputs[i].getSparse());
+      boostNonZero_(buffer.activity.numActiveConnected, touched, buffer.boostedOverlaps);
+      auto activeVector = inhibitColumns_(buffer.boostedOverlaps, &touched, numChunks == 1u);
+      for(const auto column : touched) buffer.boostedOverlaps[column] = 0.0f;
+      sort( activeVector.begin(), activeVector.end() );
+      outputs[i].setSparse( activeVector );
+    }
+  };
+  if(numChunks == 1u) {
+    computeChunk(0u);
+  } else {
+    threads->parallelFor(numChunks, computeChunk);
+  }
+}
+
+
+void SpatialPooler::boostOverlaps_(const vector<SynapseIdx> &overlaps,
+                                   const vector<CellIdx> &nonZero,
+                                   vector<Real> &boosted) {
+  // Zero columns stay zero when boosted, so only the columns which were
+  // non-zero last time must be reset.
+  if(not boostedValid_) {
+    boosted.assign(numColumns_, 0.0f);
+  } else {
+    for(const auto column : boostedColumns_) boosted[column] = 0.0f;
+  }
+  boostNonZero_(overlaps, nonZero, boosted);
+  boostedColumns_.assign(nonZero.begin(), nonZero.end());
+  boostedValid_ = true;
+}
+
+
+void SpatialPooler::boostNonZero_(const vector<SynapseIdx> &overlaps,
+                                  const vector<CellIdx> &nonZero,
+                                  vector<Real> &boosted) const {
+  if(boostStrength_ < htm::Epsilon) { //boost ~ 0.0, we can skip these computations, just copy the data
+    for(const auto column : nonZero) boosted[column] = static_cast<Real>(overlaps[column]);
+  } else {
+    for(const auto column : nonZero) boosted[column] = overlaps[column] * boostFactors_[column];
   }
 }
 
@@ -517,8 +711,7 @@ void SpatialPooler::boostOverlaps_(const vector<SynapseIdx> &overlaps, //TODO us
 UInt SpatialPooler::initMapColumn_(UInt column) const {
   NTA_ASSERT(column < numColumns_);
   vector<UInt> columnCoords;
-  const CoordinateConverterND columnConv(columnDimensions_);
-  columnConv.toCoord(column, columnCoords);
+  CoordinateConverter::get(columnDimensions_)->toCoordinates(column, columnCoords);
 
   vector<UInt> inputCoords;
   inputCoords.reserve(columnCoords.size());
@@ -528,53 +721,81 @@ UInt SpatialPooler::initMapColumn_(UInt column) const {
     inputCoords.push_back((UInt32)floor(inputCoord));
   }
 
-  const CoordinateConverterND inputConv(inputDimensions_);
-  return inputConv.toIndex(inputCoords);
+  return CoordinateConverter::get(inputDimensions_)->toIndex(inputCoords);
 }
 
 
 vector<UInt> SpatialPooler::initMapPotential_(UInt column, bool wrapAround) {
+  NeighborhoodStencil inputNeighborhood(potentialRadius_, inputDimensions_, wrapAround);
+  vector<UInt> selectedInputs;
+  initMapPotential_(column, inputNeighborhood, rng_, selectedInputs);
+  return VectorHelpers::sparseToBinary<UInt>(selectedInputs, numInputs_);
+}
+
+
+void SpatialPooler::initMapPotential_(UInt column, NeighborhoodStencil &inputNeighborhood,
+                                      Random &rng, vector<UInt> &potential) const {
   NTA_ASSERT(column < numColumns_);
   const UInt centerInput = initMapColumn_(column);
 
+  // The order of the inputs matters, it determines which ones are sampled.
   vector<UInt> columnInputs;
-  for (const auto input : Neighborhood(centerInput, potentialRadius_, inputDimensions_, wrapAround, /*skip_center=*/false)) {
+  inputNeighborhood.forEachNeighbor(centerInput, [&](const UInt input) {
       columnInputs.push_back(input);
-  }
+      return true;
+  });
 
   const UInt numPotential = static_cast<UInt>(round(columnInputs.size() * potentialPct_));
-  const auto selectedInputs = rng_.sample<UInt>(columnInputs, numPotential);
-  const vector<UInt> potential = VectorHelpers::sparseToBinary<UInt>(selectedInputs, numInputs_);
-  return potential;
+  potential = rng.sample<UInt>(columnInputs, numPotential);
+  std::sort(potential.begin(), potential.end());
 }
 
 
 Real SpatialPooler::initPermConnected_() {
-  return rng_.realRange(synPermConnected_, maxPermanence);
+  return initPermConnected_(rng_);
+}
+
+Real SpatialPooler::initPermConnected_(Random &rng) const {
+  return rng.realRange(synPermConnected_, maxPermanence);
 }
 
 
 Real SpatialPooler::initPermNonConnected_() {
-  return rng_.realRange(minPermanence, synPermConnected_);
+  return initPermNonConnected_(rng_);
+}
+
+Real SpatialPooler::initPermNonConnected_(Random &rng) const {
+  return rng.realRange(minPermanence, synPermConnected_);
 }
 
 
-vector<Real> SpatialPooler::initPermanence_(const vector<UInt> &potential, //TODO make potential sparse
+vector<Real> SpatialPooler::initPermanence_(const vector<UInt> &potential,
                                             Real connectedPct) {
+  vector<UInt> inputs;
+  for (UInt i = 0; i < numInputs_; i++) {
+    if (potential[i] >= 1) inputs.push_back(i);
+  }
+  vector<Real> inputPerm;
+  initPermanence_(inputs, connectedPct, rng_, inputPerm);
+
   vector<Real> perm(numInputs_, 0);
-  for (size_t i = 0; i < numInputs_; i++) {
-    if (potential[i] < 1) {
-      continue;
-    }
+  for (size_t i = 0; i < inputs.size(); i++) {
+    perm[inputs[i]] = inputPerm[i];
+  }
+  return perm;
+}
+
 
-    if (rng_.getReal64() <= connectedPct) {
-      perm[i] = initPermConnected_();
+void SpatialPooler::initPermanence_(const vector<UInt> &potential, Real connectedPct,
+                                    Random &rng, vector<Real> &perm) const {
+  perm.resize(potential.size());
+  for (size_t i = 0; i < potential.size(); i++) {
+    if (rng.getReal64() <= connectedPct) {
+      perm[i] = initPermConnected_(rng);
     } else {
-      perm[i] = initPermNonConnected_();
+      perm[i] = initPermNonConnected_(rng);
     }
   }
-
-  return perm;
 }
 
 
@@ -619,12 +840,14 @@ void SpatialPooler::updateMinDutyCyclesGlobal_() {
 
 
 void SpatialPooler::updateMinDutyCyclesLocal_() {
+  NeighborhoodRanges hood(inhibitionRadius_, columnDimensions_, wrapAround_);
   for (UInt i = 0; i < numColumns_; i++) {
     Real maxOverlapDuty = overlapDutyCycles_[i]; //start with the center, which is column 'i'
-    const auto& hood = neighborMap_[i];
-    for(const auto column : hood) {
+    hood.setCenter(i);
+    hood.forEach([&](const UInt column) {
       maxOverlapDuty = max(maxOverlapDuty, overlapDutyCycles_[column]);
-    }
+      return true;
+    });
     minOverlapDutyCycles_[i] = maxOverlapDuty * minPctOverlapDutyCycles_;
   }
 }
@@ -635,17 +858,17 @@ void SpatialPooler::updateDutyCycles_(const vector<SynapseIdx> &overlaps,
 
   // Turn the overlaps array into an SDR. Convert directly to flat-sparse to
   // avoid copies and  type convertions.
-  SDR newOverlap({ numColumns_ });
-  auto &overlapsSparseVec = newOverlap.getSparse();
+  SDR::Scratch newOverlap({ numColumns_ });
+  auto &overlapsSparseVec = newOverlap->getSparse();
   for (UInt i = 0; i < numColumns_; i++) {
     if( overlaps[i] != 0 )
       overlapsSparseVec.push_back( i );
   }
-  newOverlap.setSparse( overlapsSparseVec );
+  newOverlap->setSparse( overlapsSparseVec );
 
   const UInt period = std::min(dutyCyclePeriod_, iterationNum_);
 
-  updateDutyCyclesHelper_(overlapDutyCycles_, newOverlap, period);
+  updateDutyCyclesHelper_(overlapDutyCycles_, *newOverlap, period);
   updateDutyCyclesHelper_(activeDutyCycles_, active, period);
 }
 
@@ -672,14 +895,14 @@ Real SpatialPooler::avgConnectedSpanForColumnND_(const UInt column) const {
   vector<UInt> maxCoord(numDimensions, 0);
   vector<UInt> minCoord(numDimensions, *max_element(inputDimensions_.begin(),
                                                     inputDimensions_.end()));
-  const CoordinateConverterND conv(inputDimensions_);
+  const auto conv = CoordinateConverter::get(inputDimensions_);
+  vector<UInt> columnCoord;
   bool all_zero = true;
   for(UInt i = 0; i < numInputs_; i++) {
     if( connectedDense[i] < synPermConnected_ ) // 0.0 for empty == not-conected values
       continue;
     all_zero = false;
-    vector<UInt> columnCoord;
-    conv.toCoord(i, columnCoord);
+    conv->toCoordinates(i, columnCoord);
     for (size_t j = 0; j < columnCoord.size(); j++) {
       maxCoord[j] = max(maxCoord[j], columnCoord[j]); //FIXME this computation may be flawed
       minCoord[j] = min(minCoord[j], columnCoord[j]);
@@ -698,19 +921,68 @@ Real SpatialPooler::avgConnectedSpanForColumnND_(const UInt column) const {
 
 void SpatialPooler::adaptSynapses_(const SDR &input,
                                    const SDR &active) {
-  for(const auto &column : active.getSparse()) {
-    connections_.adaptSegment(column, input, synPermActiveInc_, synPermInactiveDec_);
+  const auto &columns = active.getSparse(); //column == segment in SP
+  connections_.adaptSegments(columns, input, synPermActiveInc_, synPermInactiveDec_);
+  for(const auto &column : columns) {
+    connections_.raisePermanencesToThreshold( column, stimulusThreshold_ );
+  }
+}
+
+
+void SpatialPooler::adaptSynapsesThrottled_(const SDR &input,
+                                            const SDR &active) {
+  const auto &columns = active.getSparse();
+  throttleActive_ += static_cast<Real64>(columns.size());
+  bumpScale_ = 0.0f;
+  if(++throttleStep_ % learnEvery_ != 0u) return;
+
+  const Real scale = scaleIncrements_ ? learnEvery_ / learnFraction_ : 1.0f;
+  bumpScale_ = scaleIncrements_ ? static_cast<Real>(learnEvery_) : 1.0f;
+  const UInt numLearn = std::min(static_cast<UInt>(columns.size()),
+                                 static_cast<UInt>(std::ceil(learnFraction_ * columns.size())));
+  learnColumns_.assign(columns.begin(), columns.end());
+  throttleRng_.sampleInPlace(learnColumns_.begin(), learnColumns_.end(), numLearn);
+  learnColumns_.resize(numLearn);
+  std::sort(learnColumns_.begin(), learnColumns_.end());
+
+  connections_.adaptSegments(learnColumns_, input, synPermActiveInc_ * scale, synPermInactiveDec_ * scale);
+  for(const auto column : learnColumns_) {
     connections_.raisePermanencesToThreshold( column, stimulusThreshold_ );
   }
+  throttleAdapted_ += static_cast<Real64>(numLearn) * scale;
+}
+
+
+void SpatialPooler::setLearningThrottle(const Real learnFraction, const UInt learnEvery,
+                                        const bool scaleIncrements, const UInt seed) {
+  NTA_CHECK(learnFraction > 0.0f and learnFraction <= 1.0f)
+      << "SpatialPooler: learnFraction must be within (0, 1], got " << learnFraction;
+  NTA_CHECK(learnEvery >= 1u) << "SpatialPooler: learnEvery must be at least 1.";
+  learnFraction_   = learnFraction;
+  learnEvery_      = learnEvery;
+  scaleIncrements_ = scaleIncrements;
+  throttleRng_     = Random(seed);
+  throttleStep_    = 0u;
+  bumpScale_       = 1.0f;
+  throttleAdapted_ = 0.0;
+  throttleActive_  = 0.0;
+}
+
+
+Real SpatialPooler::getEffectiveLearningRate() const {
+  if(throttleActive_ <= 0.0) return 1.0f;
+  return static_cast<Real>(throttleAdapted_ / throttleActive_);
 }
 
 
 void SpatialPooler::bumpUpWeakColumns_() {
+  if(bumpScale_ <= 0.0f) return; //skipped by the throttle, see setLearningThrottle()
+  const Permanence increment = synPermBelowStimulusInc_ * bumpScale_;
   for (size_t i = 0; i < numColumns_; i++) {
     if (overlapDutyCycles_[i] >= minOverlapDutyCycles_[i]) {
       continue;
     }
-    connections_.bumpSegment( static_cast<Segment>(i), synPermBelowStimulusInc_ );
+    connections_.bumpSegment( static_cast<Segment>(i), increment );
   }
 }
 
@@ -750,51 +1022,96 @@ void applyBoosting_(const size_t i,
 		    const Real targetDensity, 
 		    const vector<Real>& actualDensity,
 		    const Real boost,
-	            vector<Real>& output) {
+	            vector<Real>& output,
+		    const bool approximate = false) {
   if(boost < htm::Epsilon) return; //skip for disabled boosting
-  output[i] = exp((targetDensity - actualDensity[i]) * boost); //TODO doc this code
+  const Real exponent = (targetDensity - actualDensity[i]) * boost; //TODO doc this code
+  output[i] = approximate ? fastmath::exp(exponent) : exp(exponent);
 }
 
 
-void SpatialPooler::updateBoostFactorsGlobal_() {
-  Real targetDensity;
+Real SpatialPooler::globalTargetDensity_() const {
   if (numActiveColumnsPerInhArea_ > 0) {
     UInt inhibitionArea = 1u;
     for(const auto dim : columnDimensions_) {
       inhibitionArea *= min(dim, 2 * inhibitionRadius_ + 1);
     } 
     NTA_ASSERT(inhibitionArea > 0 && inhibitionArea <= numColumns_);
-    targetDensity = ((Real)numActiveColumnsPerInhArea_) / inhibitionArea;
-    targetDensity = min(targetDensity, (Real)MAX_LOCALAREADENSITY);
-  } else {
-    targetDensity = localAreaDensity_;
+    const Real targetDensity = ((Real)numActiveColumnsPerInhArea_) / inhibitionArea;
+    return min(targetDensity, (Real)MAX_LOCALAREADENSITY);
   }
-  
+  return localAreaDensity_;
+}
+
+
+void SpatialPooler::updateBoostFactorsGlobal_() {
+  const Real targetDensity = globalTargetDensity_();
   for (size_t i = 0; i < numColumns_; ++i) { 
-    applyBoosting_(i, targetDensity, activeDutyCycles_, boostStrength_, boostFactors_);
+    applyBoosting_(i, targetDensity, activeDutyCycles_, boostStrength_, boostFactors_, fastBoosting_);
+  }
+}
+
+
+void SpatialPooler::updateColumnStates_(const vector<SynapseIdx> &overlaps,
+                                        const SDR &active) {
+  // Same as updateDutyCycles_(), bumpUpWeakColumns_() and updateBoostFactors_(),
+  // but the per column updates are done in one branch free pass over the
+  // column arrays, which the compiler vectorizes.
+  NTA_ASSERT(overlaps.size() == numColumns_);
+  const UInt period = std::min(dutyCyclePeriod_, iterationNum_);
+  NTA_ASSERT(period > 0);
+  const Real decay     = (period - 1) / static_cast<Real>(period);
+  const Real increment = 1.0f / period;
+  const bool boostGlobal = globalInhibition_ and boostStrength_ >= htm::Epsilon;
+  const Real targetDensity = boostGlobal ? globalTargetDensity_() : 0.0f;
+  const Real boostStrength = boostStrength_;
+
+  const SynapseIdx *overlap = overlaps.data();
+  const ElemDense  *isActive = active.getDense().data();
+  Real *overlapDuty = overlapDutyCycles_.data();
+  Real *activeDuty  = activeDutyCycles_.data();
+  Real *boost       = boostFactors_.data();
+  const auto updateDutyCycles = [&](const UInt i) {
+    overlapDuty[i] = overlapDuty[i] * decay + (overlap[i]  != 0 ? increment : 0.0f);
+    activeDuty[i]  = activeDuty[i]  * decay + (isActive[i] != 0 ? increment : 0.0f);
+  };
+  if (boostGlobal and fastBoosting_) {
+    for (UInt i = 0; i < numColumns_; i++) {
+      updateDutyCycles(i);
+      boost[i] = fastmath::exp((targetDensity - activeDuty[i]) * boostStrength);
+    }
+  } else if (boostGlobal) {
+    for (UInt i = 0; i < numColumns_; i++) {
+      updateDutyCycles(i);
+      boost[i] = exp((targetDensity - activeDuty[i]) * boostStrength);
+    }
+  } else {
+    for (UInt i = 0; i < numColumns_; i++) {
+      updateDutyCycles(i);
+    }
+  }
+
+  bumpUpWeakColumns_();
+  if (not globalInhibition_) {
+    updateBoostFactorsLocal_(); //needs the duty cycles of all neighbors
   }
 }
 
 
 void SpatialPooler::updateBoostFactorsLocal_() {
+  NeighborhoodRanges hood(inhibitionRadius_, columnDimensions_, wrapAround_);
   for (UInt i = 0; i < numColumns_; ++i) {
     Real localActivityDensity = 0.0f;
     
-    const auto& hood = neighborMap_[i]; //hood is vector<> of cached neighborhood values
-    //optimization: In wrapAround, number of neighbors to be considered is solely a function of the inhibition radius,
-    // the number of dimensions, and of the size of each of those dimenions. 
-    // Or in non-wrap, if we use cached hood, we obtain the value the same as hood.size()
-    const UInt numNeighbors = hood.size() + 1; 
-    //start by adding the center ('i') which is not included in the hood
-    localActivityDensity += activeDutyCycles_[i]; //include the center, which is 'i' (not included in hood)
-
-    //for(auto neighbor: Neighborhood(i, inhibitionRadius_, columnDimensions_, wrapAround_)) {
-    for (const auto neighbor : hood) {
-      localActivityDensity += activeDutyCycles_[neighbor];
-      //numNeighbors++;
-    }
+    const UInt numNeighbors = hood.setCenter(i); //includes the center
+    //start by adding the center ('i'), then the neighbors in ascending order
+    localActivityDensity += activeDutyCycles_[i];
+    hood.forEach([&](const UInt neighbor) {
+      if (neighbor != i) localActivityDensity += activeDutyCycles_[neighbor];
+      return true;
+    });
     const Real targetDensity = localActivityDensity / numNeighbors;
-    applyBoosting_(i, targetDensity, activeDutyCycles_, boostStrength_, boostFactors_);
+    applyBoosting_(i, targetDensity, activeDutyCycles_, boostStrength_, boostFactors_, fastBoosting_);
   }
 }
 
@@ -828,7 +1145,7 @@ UInt getAreaND_(const vector<UInt>& dimensions, const Real radius) {
   return area;
 }
 
-vector<CellIdx> SpatialPooler::inhibitColumns_(const vector<Real> &overlaps) const {
+Real SpatialPooler::inhibitionDensity_() const {
   Real density = localAreaDensity_; //option 1: used localAreaDensity
   if (numActiveColumnsPerInhArea_ > 0) { //option 2: used numActiveColumnsPerInhArea in constructor
     const UInt inhibitionArea = getAreaND_(columnDimensions_, inhibitionRadius_); 
@@ -837,100 +1154,244 @@ vector<CellIdx> SpatialPooler::inhibitColumns_(const vector<Real> &overlaps) con
     density = min(density, (Real)MAX_LOCALAREADENSITY);
   }
   NTA_ASSERT(density > 0.0f and density < 1.0f);
+  return density;
+}
 
-  if (globalInhibition_ ||
-      inhibitionRadius_ > *max_element(columnDimensions_.begin(), columnDimensions_.end())) {
-    return inhibitColumnsGlobal_(overlaps, density);
+
+bool SpatialPooler::isGlobalInhibition_() const {
+  return globalInhibition_ ||
+         inhibitionRadius_ > *max_element(columnDimensions_.begin(), columnDimensions_.end());
+}
+
+
+vector<CellIdx> SpatialPooler::inhibitColumns_(const vector<Real> &overlaps,
+                                               const vector<CellIdx> *candidates,
+                                               const bool parallel) const {
+  const Real density = inhibitionDensity_();
+  if (isGlobalInhibition_()) {
+    return inhibitColumnsGlobal_(overlaps, density, candidates);
   } else {
-    return inhibitColumnsLocal_(overlaps, density);
+    return inhibitColumnsLocal_(overlaps, density, parallel);
   }
 }
 
 
-vector<CellIdx> SpatialPooler::inhibitColumnsGlobal_(const vector<Real> &overlaps,
-                                          const Real density) const {
-  const UInt numDesired = static_cast<UInt>((density * numColumns_));
-  NTA_CHECK(numDesired > 0) << "Not enough columns (" << numColumns_ << ") "
-                            << "for desired density (" << density << ").";
-  // Sort the columns by the amount of overlap.  First make a list of all of the
-  // column indexes.
-  vector<CellIdx> activeColumns(numColumns_);
-  std::iota(activeColumns.begin(), activeColumns.end(), 0); //fill with sequence 0,1,..N
-
-  // Compare the column indexes by their overlap.
-  auto compare = [&overlaps](const UInt &a, const UInt &b) -> bool
-    {return (overlaps[a] == overlaps[b]) ? (a > b) : (overlaps[a] > overlaps[b]) ;};  //for determinism if overlaps match (tieBreaker does not solve that),
-  //otherwise we'd return just `return overlaps[a] > overlaps[b]`. 
-
-  // Do a partial sort to divide the winners from the losers.  This sort is
-  // faster than a regular sort because it stops after it partitions the
-  // elements about the Nth element, with all elements on their correct side of
-  // the Nth element.
-  std::nth_element(
-    activeColumns.begin(),
-    activeColumns.begin() + numDesired,
-    activeColumns.end(),
-    compare);
-  // Remove the columns which lost the competition.
-  activeColumns.resize(numDesired);
-  // Finish sorting the winner columns by their overlap.
-  std::sort(activeColumns.begin(), activeColumns.end(), compare);
-  // Remove sub-threshold winners
-  while( !activeColumns.empty() &&
-         overlaps[activeColumns.back()] < stimulusThreshold_) {
-      activeColumns.pop_back();
-  }
-  
-  activeColumns.shrink_to_fit();
-  return activeColumns;
+/**
+ * Maps a Real to an unsigned integer of the same size, such that the integers
+ * are in the same order as the Reals (NaN excluded).
+ */
+using RealKey = std::conditional<sizeof(Real) == 8u, UInt64, UInt32>::type;
+static inline RealKey sortableKey(const Real value) {
+  static_assert(sizeof(RealKey) == sizeof(Real), "RealKey must have the same size as Real");
+  RealKey bits;
+  std::memcpy(&bits, &value, sizeof(Real));
+  constexpr RealKey signBit = RealKey(1u) << (sizeof(RealKey) * 8u - 1u);
+  return (bits & signBit) ? ~bits : (bits | signBit);
 }
 
 
-vector<CellIdx> SpatialPooler::inhibitColumnsLocal_(const vector<Real> &overlaps,
-                                                    const Real density) const {
+vector<CellIdx> SpatialPooler::inhibitColumnsGlobal_(const vector<Real> &overlaps,
+                                                     const Real density,
+                                                     const vector<CellIdx> *candidates) const {
   NTA_ASSERT(overlaps.size() == numColumns_);
+  return inhibitColumnsGlobal(overlaps, density, stimulusThreshold_, candidates);
+}
+
+
+vector<CellIdx> SpatialPooler::inhibitColumnsGlobal(const vector<Real> &overlaps,
+                                                    const Real density,
+                                                    const UInt stimulusThreshold,
+                                                    const vector<CellIdx> *candidates) {
+  const UInt numColumns = static_cast<UInt>(overlaps.size());
+  const UInt numDesired = static_cast<UInt>((density * numColumns));
+  NTA_CHECK(numDesired > 0) << "Not enough columns (" << numColumns << ") "
+                            << "for desired density (" << density << ").";
+  // Order by overlap, for determinism the higher index wins if overlaps match.
+  const auto byOverlap = [&overlaps](const UInt a, const UInt b) -> bool
+    {return (overlaps[a] == overlaps[b]) ? (a > b) : (overlaps[a] > overlaps[b]);};
+
+  // Only columns above the stimulus threshold can win. With candidates, only
+  // those with a positive overlap are visited, the others are all zero.
+  const auto forEachEligible = [&](const bool sparse, auto &&visit) {
+    if (sparse) {
+      for (const auto column : *candidates) {
+        if (overlaps[column] > 0.0f and overlaps[column] >= stimulusThreshold) visit(column);
+      }
+    } else {
+      for (UInt column = 0; column < numColumns; column++) {
+        if (overlaps[column] >= stimulusThreshold) visit(column);
+      }
+    }
+  };
+  UInt numEligible = 0u;
+  bool sparse = candidates != nullptr;
+  forEachEligible(sparse, [&](const UInt) { numEligible++; });
+  if (sparse and stimulusThreshold == 0u and numEligible < numDesired) {
+    // zero overlap columns win too, and they are not among the candidates
+    sparse = false;
+    numEligible = 0u;
+    forEachEligible(sparse, [&](const UInt) { numEligible++; });
+  }
+
   vector<CellIdx> activeColumns;
-  //optimization: reserve for numDesired approximation
-  const UInt approxNumDesired = static_cast<UInt>(density * numColumns_); //note: this is just a heuristic, not precise number. It can be used for global inh, 
-  //..but here the density is requested for inhibition radius. The guess is it correlates to the global somehow. 
-  activeColumns.reserve(approxNumDesired); 
+  activeColumns.reserve(std::min(numDesired, numEligible));
+  if (numEligible <= numDesired) { //everyone wins
+    forEachEligible(sparse, [&](const UInt column) { activeColumns.push_back(column); });
+    std::sort(activeColumns.begin(), activeColumns.end(), byOverlap);
+    return activeColumns;
+  }
 
-  // Tie-breaking: when overlaps are equal, columns that have already been
-  // selected are treated as "bigger".
-  vector<bool> alreadyUsedColumn(numColumns_, false); // in tie we prefer already used columns
+  // Radix select of the numDesired-th largest overlap: one histogram pass per
+  // byte of the overlaps' sortable keys, from the most significant byte down,
+  // each pass narrowing the bucket (prefix) which contains the desired rank.
+  // No comparisons between columns.
+  RealKey prefix = 0u; //the selected high bytes
+  RealKey mask   = 0u; //which bytes of prefix are selected
+  UInt remaining = numDesired; //how many columns to take from within the prefix
+  UInt inPrefix  = numEligible; //how many columns have the prefix
+  for (Int shift = sizeof(RealKey) * 8 - 8; shift >= 0; shift -= 8) {
+    UInt histogram[256] = {0u};
+    forEachEligible(sparse, [&](const UInt column) {
+      const RealKey key = sortableKey(overlaps[column]);
+      if ((key & mask) == prefix) {
+        histogram[(key >> shift) & 0xFFu]++;
+      }
+    });
+    UInt digit = 255u;
+    while (histogram[digit] < remaining) {
+      remaining -= histogram[digit];
+      digit--;
+    }
+    prefix  |= static_cast<RealKey>(digit) << shift;
+    mask    |= static_cast<RealKey>(0xFFu) << shift;
+    inPrefix = histogram[digit];
+    if (inPrefix == remaining) break; //the whole bucket wins, no need to look closer
+  }
 
-  for (UInt column = 0; column < numColumns_; column++) {
-    if (overlaps[column] < stimulusThreshold_) { //TODO make connections.computeActivity() already drop sub-threshold columns
-      continue;
+  // Winners are all columns above the prefix and the `remaining` highest
+  // indices with the prefix, which is the same tie-break as byOverlap.
+  vector<CellIdx> ties;
+  forEachEligible(sparse, [&](const UInt column) {
+    const RealKey high = sortableKey(overlaps[column]) & mask;
+    if (high > prefix) {
+      activeColumns.push_back(column);
+    } else if (high == prefix) {
+      ties.push_back(column);
     }
+  });
+  NTA_ASSERT(ties.size() == inPrefix);
+  if (remaining < inPrefix) {
+    std::nth_element(ties.begin(), ties.begin() + (inPrefix - remaining), ties.end());
+  }
+  activeColumns.insert(activeColumns.end(), ties.end() - remaining, ties.end());
+  NTA_ASSERT(activeColumns.size() == numDesired);
 
-    UInt otherBigger = 0; //how many neighbor columns are bigger/better than this column 'column'. 
-    //..aka. how many times this column lost. 
+  // Sort the (few) winners by their overlap, as documented.
+  std::sort(activeColumns.begin(), activeColumns.end(), byOverlap);
+  return activeColumns;
+}
 
-    const auto& hood = neighborMap_.at(column);
-    // Optimization: In wrapAround, number of neighbors to be considered is solely a function of the inhibition radius, 
-    // the number of dimensions, and of the size of each of those dimenion
-    const UInt numNeighbors = hood.size();
-    //const UInt numDesiredLocalActive = static_cast<UInt>(ceil(density * (numNeighbors + 1)));
-    const UInt numDesiredLocalActive = static_cast<UInt>(0.5f + (density * (numNeighbors + 1)));
-    NTA_ASSERT(numDesiredLocalActive > 0);
-    
-    //for(auto neighbor: Neighborhood(column, inhibitionRadius_,columnDimensions_, wrapAround_, false /*skip center*/)) { 
-    for (const auto neighbor: hood) {
-      NTA_ASSERT(neighbor != column);
 
-      if (overlaps[neighbor] > overlaps[column] || ( (overlaps[neighbor] == overlaps[column]) && alreadyUsedColumn[neighbor])) { //this column lost to a neighbor
-        otherBigger++;
-	if (otherBigger >= numDesiredLocalActive) { break; }
+vector<CellIdx> SpatialPooler::inhibitColumnsLocal_(const vector<Real> &overlaps,
+                                                    const Real density,
+                                                    const bool parallel) const {
+  NTA_ASSERT(overlaps.size() == numColumns_);
+  return inhibitColumnsLocal(overlaps, density, stimulusThreshold_, columnDimensions_,
+                             inhibitionRadius_, wrapAround_,
+                             parallel ? connections_.getThreadPool() : nullptr);
+}
+
+
+vector<CellIdx> SpatialPooler::inhibitColumnsLocal(const vector<Real> &overlaps,
+                                                   const Real density,
+                                                   const UInt stimulusThreshold,
+                                                   const vector<UInt> &columnDimensions,
+                                                   const UInt inhibitionRadius,
+                                                   const bool wrapAround,
+                                                   ThreadPool *threads) {
+  const UInt numColumns = static_cast<UInt>(overlaps.size());
+
+  // A column wins if less than numDesiredLocalActive of its neighbors are
+  // bigger / better than it. Tie-breaking: when overlaps are equal, columns
+  // that have already been selected are treated as "bigger". The columns are
+  // selected in ascending order, so only the ties with earlier (lower index)
+  // neighbors depend on the order.
+  //
+  // 1st pass, in parallel over tiles of columns: count the bigger neighbors
+  // and the earlier ties, this decides every column which doesn't depend on
+  // how its ties were resolved.
+  // 2nd pass, serial in ascending order: resolve the remaining columns.
+  // The neighborhoods are walked as ranges, see NeighborhoodRanges.
+  enum : uint8_t { LOST = 0u, WON = 1u, TIE = 2u };
+  vector<uint8_t> state(numColumns, LOST);
+  vector<UInt>    otherBigger(numColumns, 0u); //how many times the column lost, for TIE only
+
+  const auto numDesiredLocalActive = [density](const UInt numPoints) {
+    return static_cast<UInt>(0.5f + (density * numPoints)); };
+
+  const auto decideTile = [&](const UInt begin, const UInt end) {
+    NeighborhoodRanges hood(inhibitionRadius, columnDimensions, wrapAround);
+    for (UInt column = begin; column < end; column++) {
+      const Real overlap = overlaps[column];
+      if (overlap < stimulusThreshold) { //TODO make connections.computeActivity() already drop sub-threshold columns
+        continue;
       }
-    } 
+      const UInt numDesired = numDesiredLocalActive(hood.setCenter(column));
+      NTA_ASSERT(numDesired > 0);
+
+      UInt bigger = 0u; //neighbors with a bigger overlap
+      UInt ties   = 0u; //earlier neighbors with the same overlap
+      hood.forEach([&](const UInt neighbor) {
+        if (overlaps[neighbor] > overlap) {
+          bigger++;
+          return bigger < numDesired; //lost, stop
+        }
+        if (overlaps[neighbor] == overlap and neighbor < column) ties++;
+        return true;
+      });
+
+      if (bigger >= numDesired) {
+        state[column] = LOST;
+      } else if (bigger + ties < numDesired) {
+        state[column] = WON;
+      } else {
+        state[column] = TIE;
+        otherBigger[column] = bigger;
+      }
+    }
+  };
+
+  const UInt numTiles = threads == nullptr ? 1u :
+                        std::min<UInt>(static_cast<UInt>(threads->size()) * 4u, numColumns / MIN_COLUMNS_PER_TILE);
+  if (numTiles <= 1u) {
+    decideTile(0u, numColumns);
+  } else {
+    threads->parallelFor(numTiles, [&](const size_t tile) {
+      decideTile(static_cast<UInt>(numColumns * tile / numTiles),
+                 static_cast<UInt>(numColumns * (tile + 1u) / numTiles));
+    });
+  }
 
-    if (otherBigger < numDesiredLocalActive) { //successful column, add it
+  NeighborhoodRanges hood(inhibitionRadius, columnDimensions, wrapAround);
+  vector<CellIdx> activeColumns;
+  //optimization: reserve for numDesired approximation
+  activeColumns.reserve(static_cast<UInt>(density * numColumns)); //note: this is just a heuristic, not precise number.
+  for (UInt column = 0; column < numColumns; column++) {
+    if (state[column] == TIE) {
+      const Real overlap    = overlaps[column];
+      const UInt numDesired = numDesiredLocalActive(hood.setCenter(column));
+      UInt bigger = otherBigger[column];
+      hood.forEach([&](const UInt neighbor) {
+        if (neighbor >= column) return false; //later neighbors are not selected yet
+        if (overlaps[neighbor] == overlap and state[neighbor] == WON) bigger++;
+        return bigger < numDesired;
+      });
+      state[column] = bigger < numDesired ? WON : LOST;
+    }
+    if (state[column] == WON) {
       activeColumns.push_back(column);
-      alreadyUsedColumn[column] = true;
     }
   }
-  //activeColumns.shrink_to_fit();
   return activeColumns;
 }
 
@@ -939,6 +1400,137 @@ bool SpatialPooler::isUpdateRound_() const {
   return (iterationNum_ % updatePeriod_) == 0;
 }
 
+
+void SpatialPooler::saveCheckpoint(const string &path) const {
+  CheckpointWriter writer(path);
+  saveCheckpoint_(writer);
+  writer.close();
+}
+
+
+void SpatialPooler::loadCheckpoint(const string &path) {
+  const CheckpointReader reader(path);
+  loadCheckpoint_(reader);
+}
+
+
+void SpatialPooler::saveCheckpoint_(CheckpointWriter &writer) const {
+  stringstream state;
+  {
+    const Connections::ExternalSerialization external(
+        [&](const Connections &connections, const string &name) { connections.saveCheckpoint(writer, "sp." + name); },
+        nullptr);
+    save(state, SerializableFormat::BINARY);
+  }
+  const string bytes = state.str();
+  writer.write("sp.state", bytes.data(), bytes.size());
+}
+
+
+void SpatialPooler::loadCheckpoint_(const CheckpointReader &reader) {
+  const auto bytes = reader.section("sp.state");
+  stringstream state(string(bytes.first, bytes.second));
+  const Connections::ExternalSerialization external(
+      nullptr,
+      [&](Connections &connections, const string &name) { connections.loadCheckpoint(reader, "sp." + name); });
+  load(state, SerializableFormat::BINARY);
+}
+
+
+namespace {
+  std::mutex initializationCacheMutex;
+  string initializationCacheDirectory;
+}
+
+void SpatialPooler::setInitializationCache(const string &directory) {
+  if (not directory.empty() and not Directory::exists(directory)) {
+    Directory::create(directory, false, true);
+  }
+  std::lock_guard<std::mutex> lock(initializationCacheMutex);
+  initializationCacheDirectory = directory;
+}
+
+
+string SpatialPooler::getInitializationCache() {
+  std::lock_guard<std::mutex> lock(initializationCacheMutex);
+  return initializationCacheDirectory;
+}
+
+
+bool SpatialPooler::loadInitializationCache_(const string &path, const string &key) {
+  if (not Path::exists(path)) return false;
+  try {
+    const CheckpointReader reader(path); //maps the file
+    const string keySection = "sp.initializationKey";
+    if (not reader.has(keySection) or reader.readSection(keySection) != key) {
+      return false; //a hash collision, replaced by this initialization
+    }
+    loadCheckpoint_(reader);
+    return true;
+  } catch (const std::exception &e) {
+    NTA_WARN << "SpatialPooler: ignoring the initialization cache " << path << ": " << e.what();
+    return false;
+  }
+}
+
+
+void SpatialPooler::saveInitializationCache_(const string &path, const string &key) const {
+  // Written aside and renamed, so that processes initializing the same model
+  // at once never read a partial file.
+  string partial;
+  try {
+    std::random_device entropy;
+    partial = path + ".partial." + to_string(entropy()) + to_string(entropy());
+    {
+      CheckpointWriter writer(partial);
+      writer.write("sp.initializationKey", key.data(), key.size());
+      saveCheckpoint_(writer);
+      writer.close();
+    }
+    Path::rename(partial, path);
+  } catch (const std::exception &e) {
+    NTA_WARN << "SpatialPooler: cannot write the initialization cache " << path << ": " << e.what();
+    try {
+      if (not partial.empty() and Path::exists(partial)) Path::remove(partial);
+    } catch (const std::exception &) {
+    }
+  }
+}
+
+
+size_t SpatialPooler::prune(const Permanence minPermanence) {
+  // One segment per column, indexed by column: keep them all.
+  const size_t destroyed = connections_.prune(minPermanence, 0u, false).first;
+  gpu_.reset();    //the mirrors are rebuilt by the next compute
+  bitset_.reset();
+  incremental_.reset();
+  locality_.reset();
+  return destroyed;
+}
+
+
+MemoryUsage SpatialPooler::memoryUsage() const {
+  MemoryUsage usage;
+  memory::add(usage, "connections.", connections_.memoryUsage());
+  usage["dutyCycles"] = memory::bytes(overlapDutyCycles_) + memory::bytes(activeDutyCycles_) +
+                        memory::bytes(minOverlapDutyCycles_) + memory::bytes(minActiveDutyCycles_);
+  usage["boostFactors"] = memory::bytes(boostFactors_);
+  size_t caches = memory::bytes(boostedOverlaps_) + memory::bytes(boostedColumns_) +
+                  memory::bytes(overlapActivity_.numActiveConnected) +
+                  memory::bytes(overlapActivity_.numActivePotential) +
+                  memory::bytes(overlapActivity_.touched) +
+                  memory::bytes(batchBuffers_);
+  for(const auto &buffer : batchBuffers_) {
+    caches += memory::bytes(buffer.activity.numActiveConnected) + memory::bytes(buffer.activity.numActivePotential) +
+              memory::bytes(buffer.activity.touched) + memory::bytes(buffer.boostedOverlaps);
+  }
+  if(bitset_) caches += bitset_->memoryUsage();
+  if(incremental_) caches += incremental_->memoryUsage();
+  if(locality_) caches += locality_->memoryUsage();
+  usage["caches"] = caches;
+  return usage;
+}
+
 namespace htm {
 std::ostream& operator<< (std::ostream& stream, const SpatialPooler& self)
 {
@@ -26,6 +26,7 @@
 #include <vector>
 #include <unordered_map>
 #include <iomanip> // std::setprecision
+#include <memory>
 #include <htm/algorithms/Connections.hpp>
 #include <htm/types/Types.hpp>
 #include <htm/types/Serializable.hpp>
@@ -37,6 +38,11 @@ namespace htm {
 
 using namespace std;
 
+class SpatialPoolerBitset;
+class SpatialPoolerIncremental;
+class SpatialPoolerLocality;
+class SpatialPoolerGpu;
+
 /**
  * ### Description
  * The Spatial Pooler is responsible for creating a sparse distributed
@@ -77,7 +83,8 @@ public:
     Real boostStrength = 0.0f,
     Int seed = 1, 
     UInt spVerbosity = 0u, 
-    bool wrapAround = true);
+    bool wrapAround = true,
+    Random::Engine rngEngine = Random::MT19937);
 
   virtual ~SpatialPooler() {}
 
@@ -210,6 +217,13 @@ public:
         at the beginning and end of an input dimension are considered
         neighbors for the purpose of mapping inputs to columns.
 
+  @param rngEngine Random::MT19937 (default) draws the potential pools and
+        permanences of all columns from one stream, one column after another.
+        Random::COUNTER gives every column its own stream (Random::split), so
+        the columns are initialized on the threads of setNumThreads() (call
+        it before initialize()). The model is the same for any number of
+        threads, but differs from the MT19937 one with the same seed.
+
    */
   virtual void
   initialize(const vector<UInt>& inputDimensions, 
@@ -223,7 +237,8 @@ public:
              Real synPermInactiveDec = 0.01f, Real synPermActiveInc = 0.1f,
              Real synPermConnected = 0.1f, Real minPctOverlapDutyCycles = 0.001f,
              UInt dutyCyclePeriod = 1000u, Real boostStrength = 0.0f,
-             Int seed = 1, UInt spVerbosity = 0u, bool wrapAround = true);
+             Int seed = 1, UInt spVerbosity = 0u, bool wrapAround = true,
+             Random::Engine rngEngine = Random::MT19937);
 
 
   /**
@@ -259,6 +274,22 @@ public:
    */
   virtual const vector<SynapseIdx> compute(const SDR &input, const bool learn, SDR &active);
 
+  /**
+  Inference over a batch of inputs, for example when scoring recorded
+  data. outputs[i] is set to the same columns as
+  compute(inputs[i], false, outputs[i]) would, and getIterationNum()
+  advances by inputs.size(). Nothing else changes (no learning, the
+  boosted overlaps of the last compute() are kept), and the overlap buffers
+  are reused between calls.
+
+  With setNumThreads() > 1 the inputs are split between the threads,
+  each input is computed by a single thread.
+
+  @param inputs SDRs of the size getNumInputs().
+  @param outputs receives the active columns, must have the same length as inputs.
+   */
+  void computeBatch(const vector<SDR> &inputs, vector<SDR> &outputs);
+
 
   /**
    * Get the version number of this spatial pooler.
@@ -351,11 +382,41 @@ public:
     ar(CEREAL_NVP(rng_));
     ar(CEREAL_NVP(minActiveDutyCycles_));
     ar(CEREAL_NVP(boostedOverlaps_));
-
-    //re-initialize map
-    neighborMap_ = Neighborhood::updateAllNeighbors(inhibitionRadius_, columnDimensions_, wrapAround_, /*skip_center=*/true);
+    boostedColumns_.clear();
+    boostedValid_ = false;
+    batchBuffers_.clear();
+    gpu_.reset();
+    bitset_.reset();
+    incremental_.reset();
+    locality_.reset();
   }
 
+  /**
+   * Save / load the state to a flat checkpoint file, see CheckpointWriter.
+   * The connections are stored as raw arrays (Connections::saveCheckpoint),
+   * the small rest of the state as a cereal section, so a large, trained
+   * model loads without parsing each synapse.
+   */
+  void saveCheckpoint(const std::string &path) const;
+  void loadCheckpoint(const std::string &path);
+
+  /**
+   * Opt-in, process wide cache of initialize() results on disk.
+   *
+   * initialize() with a fixed seed is deterministic, so its result is saved
+   * to a checkpoint file in this directory, named after a hash of all the
+   * parameters, and later initializations with the same parameters (in
+   * any process) map that file instead of drawing the potential pools and
+   * permanences again.  A file which does not match, or fails to load, is
+   * recomputed and replaced; failing to write only warns.  seed 0 (a
+   * random seed) is never cached.
+   *
+   * @param directory - created if missing; empty (the default) disables
+   *   the cache.
+   */
+  static void setInitializationCache(const std::string &directory);
+  static std::string getInitializationCache();
+
   /**
   Returns the dimensions of the columns in the region.
 
@@ -456,6 +517,35 @@ public:
   */
   void setLocalAreaDensity(Real localAreaDensity);
 
+  /**
+  Use several threads for the overlaps (see `Connections::setNumThreads()`)
+  and for the local inhibition, which is split into tiles of at least
+  MIN_COLUMNS_PER_TILE columns. Results are identical to a single thread.
+  The setting is not serialized.
+
+  @param numThreads number of threads including the caller, 0 or 1 turns the
+  threading off.
+  */
+  void setNumThreads(UInt numThreads) { connections_.setNumThreads(numThreads); }
+  UInt getNumThreads() const { return connections_.getNumThreads(); }
+  void setThreadPool(const std::shared_ptr<ThreadPool> &pool) { connections_.setThreadPool(pool); }
+
+  /**
+  Put the synapses on a MemoryResource, e.g. huge pages or a NUMA node, see
+  `Connections::setMemoryResource()`. The setting is not serialized.
+  */
+  void setMemoryResource(const std::shared_ptr<MemoryResource> &resource) { connections_.setMemoryResource(resource); }
+
+  /**
+  Share a synapse budget with other models, see `Connections::setSynapseBudget()`.
+  Over its target the SP drops the weakest synapses of its columns, the
+  columns themselves are kept. Not serialized.
+  */
+  void setSynapseBudget(std::shared_ptr<SynapseBudget> budget) {
+    connections_.setSynapseBudget(std::move(budget), false); }
+
+  static constexpr const UInt MIN_COLUMNS_PER_TILE = 256u;
+
   /**
   Returns the stimulus threshold.
 
@@ -512,6 +602,89 @@ public:
   */
   void setBoostStrength(Real boostStrength);
 
+  /**
+  Compute the boost factors with a vectorizable approximation of exp(),
+  with a relative error below 5e-7, instead of std::exp(), see
+  htm/utils/FastMath.hpp.  Default false. The setting is not serialized.
+  */
+  void setFastBoosting(bool enable) { fastBoosting_ = enable; }
+  bool getFastBoosting() const { return fastBoosting_; }
+
+  /**
+  Compute the overlaps and the global inhibition on a CUDA device, see
+  SpatialPoolerGpu. Learning stays on the host, the columns it changed are
+  uploaded in one batch before the next compute. Local inhibition and
+  computeBatch() are always computed on the host. The results are identical.
+  Throws if not available, see SpatialPoolerGpu::available().
+  Default false. The setting is not serialized.
+  */
+  void setGpuEnabled(bool enable);
+  bool isGpuEnabled() const { return gpuEnabled_; }
+
+  /**
+  Compute the overlaps, in compute() and computeBatch(), as popcount(row AND
+  input) of a bit matrix of the connected synapses, one row per column, see
+  SpatialPoolerBitset. Faster than the presynaptic lists of the Connections
+  for dense-ish inputs. Learning updates the rows of the columns it changed
+  before the next compute. Excludes setGpuEnabled(). The results are identical.
+  Default false. The setting is not serialized.
+  */
+  void setBitsetEnabled(bool enable);
+  bool isBitsetEnabled() const { return bitsetEnabled_; }
+
+  /**
+  Compute the overlaps in compute() incrementally, see
+  SpatialPoolerIncremental: the overlaps of the previous input are kept and
+  only the synapses of the input bits which turned on or off are visited.
+  For slowly changing inputs (smooth metrics, video frames) the cost per
+  compute follows how much the input changed.  The columns changed by
+  learning are recounted before the next compute.  computeBatch() is not
+  affected.  Excludes setGpuEnabled() and setBitsetEnabled().  The results
+  are identical.  Default false. The setting is not serialized.
+  */
+  void setIncrementalEnabled(bool enable);
+  bool isIncrementalEnabled() const { return incrementalEnabled_; }
+
+  /**
+  Compute the overlaps in compute() with the inputs and the columns
+  renumbered in Z-order, see SpatialPoolerLocality: neighbors in a 2-D or
+  3-D topology are then near each other in memory, the presynaptic lists of
+  an input patch are adjacent and so are the overlap counters of the
+  columns they reach.  The SDRs stay in C-order, the input and the touched
+  columns are renumbered at the boundary.  The inhibition and learning keep
+  the C-order, local inhibition already walks the neighborhoods as
+  contiguous ranges.  Pays off for large topological SPs (eg. 256x256
+  columns), 1-D SPs keep their order.  computeBatch() is not affected.
+  Excludes setGpuEnabled(), setBitsetEnabled() and setIncrementalEnabled().
+  The results are identical.  Default false. The setting is not serialized.
+  */
+  void setLocalityEnabled(bool enable);
+  bool isLocalityEnabled() const { return localityEnabled_; }
+
+  /**
+  Bound the synapse learning per compute: adapt the synapses only every
+  `learnEvery`-th learning compute, and then only those of a random
+  `learnFraction` of the active columns (rounded up). With `scaleIncrements`
+  the permanence increments and decrements are multiplied by
+  learnEvery / learnFraction and the bump of the weak columns by learnEvery,
+  so that the expected change per compute stays the same.
+  The duty cycles and boost factors are still updated every learning compute.
+  The columns are chosen by a random generator of its own, seeded with
+  `seed`, so the other random choices of the SP do not change.
+  Default (1.0, 1): no throttle. The setting is not serialized.
+  */
+  void setLearningThrottle(Real learnFraction, UInt learnEvery, bool scaleIncrements = true, UInt seed = 1u);
+  Real getLearnFraction() const { return learnFraction_; }
+  UInt getLearnEvery() const { return learnEvery_; }
+
+  /**
+  The permanence change applied since setLearningThrottle(), relative to
+  learning all active columns every compute: the adapted columns times their
+  increment scale, over the active columns. 1.0 without a throttle, about
+  1.0 with scaleIncrements, about learnFraction / learnEvery without.
+  */
+  Real getEffectiveLearningRate() const;
+
   /**
   Returns the iteration number.
 
@@ -791,7 +964,24 @@ public:
   // NOT part of the public API
 
 
-  void boostOverlaps_(const vector<SynapseIdx> &overlaps, vector<Real> &boostedOverlaps) const;
+  /**
+   * Boosts the overlaps of the `nonZero` columns (overlap > 0, any order),
+   * all others are zero. Keeps track of the non-zero entries of
+   * `boostedOverlaps` in boostedColumns_, so it must always be called with
+   * the same vector.
+   */
+  void boostOverlaps_(const vector<SynapseIdx> &overlaps,
+                      const vector<CellIdx> &nonZero,
+                      vector<Real> &boostedOverlaps);
+
+  /**
+   * Writes the boosted overlaps of the `nonZero` columns only, the other
+   * entries of `boostedOverlaps` are left as they are. Shared by
+   * boostOverlaps_() and computeBatch().
+   */
+  void boostNonZero_(const vector<SynapseIdx> &overlaps,
+                     const vector<CellIdx> &nonZero,
+                     vector<Real> &boostedOverlaps) const;
 
   /**
     Maps a column to its respective input index, keeping to the topology of
@@ -848,6 +1038,14 @@ public:
   */
   vector<UInt> initMapPotential_(UInt column, bool wrapAround);
 
+  /**
+   * Same as above, walking a precomputed neighborhood of the input space
+   * and drawing from rng.
+   * @param potential receives the sorted indices of the potential inputs.
+   */
+  void initMapPotential_(UInt column, NeighborhoodStencil &inputNeighborhood,
+                         Random &rng, vector<UInt> &potential) const;
+
   /**
   Returns a randomly generated permanence value for a synapses that is
   initialized in a connected state.
@@ -863,6 +1061,7 @@ public:
   that is initialized in a connected state.
   */
   Real initPermConnected_();
+  Real initPermConnected_(Random &rng) const;
   /**
       Returns a randomly generated permanence value for a synapses that is to be
       initialized in a non-connected state.
@@ -871,6 +1070,7 @@ public:
      synapses that is to be initialized in a non-connected state.
   */
   Real initPermNonConnected_();
+  Real initPermNonConnected_(Random &rng) const;
 
   /**
     Initializes the permanences of a column. The method
@@ -888,6 +1088,13 @@ public:
   */
   vector<Real> initPermanence_(const vector<UInt> &potential, Real connectedPct);
 
+  /**
+   * Same as above, for the sorted indices of the potential inputs.
+   * @param perm receives the permanence of each potential input.
+   */
+  void initPermanence_(const vector<UInt> &potential, Real connectedPct,
+                       Random &rng, vector<Real> &perm) const;
+
   void clip_(vector<Real> &perm) const;
 
   /**
@@ -901,11 +1108,28 @@ public:
      in a "connected state" (connected synapses) that are connected to input
      bits which are turned on.
 
+      @param candidates (optional) the columns with overlap > 0, in any order.
+     All other overlaps must be 0. Global inhibition then only visits these.
+
       @return activeColumns
       a sparse SDR vector containing the indices of the active columns.
       Internally delegates to local/global inhibition functions.
   */
-  std::vector<CellIdx> inhibitColumns_(const vector<Real> &overlaps) const;
+  std::vector<CellIdx> inhibitColumns_(const vector<Real> &overlaps,
+                                       const vector<CellIdx> *candidates = nullptr,
+                                       const bool parallel = true) const;
+
+  /**
+     The density used by inhibitColumns_(), from either localAreaDensity or
+     numActiveColumnsPerInhArea.
+  */
+  Real inhibitionDensity_() const;
+
+  /**
+     Whether inhibitColumns_() inhibits globally, which it also does when the
+     inhibition radius covers all columns.
+  */
+  bool isGlobalInhibition_() const;
 
   /**
      Perform global inhibition.
@@ -925,10 +1149,24 @@ public:
      @param density
      a real number of the fraction of columns to survive inhibition.
 
+     @param candidates (optional) the columns with overlap > 0, see inhibitColumns_().
+     Falls back to all columns if zero overlaps can win.
+
      @return activeColumns
-     an (sprase SDR) vector containing the indices of the active columns.
+     an (sprase SDR) vector containing the indices of the active columns,
+     sorted by overlap (descending). Columns with equal overlap are ranked
+     by their index, the higher index wins.
   */
-  std::vector<CellIdx> inhibitColumnsGlobal_(const vector<Real> &overlaps, const Real density) const;
+  std::vector<CellIdx> inhibitColumnsGlobal_(const vector<Real> &overlaps, const Real density,
+                                             const vector<CellIdx> *candidates = nullptr) const;
+
+  /**
+     inhibitColumnsGlobal_() with the parameters of the SP passed in,
+     for use without a SpatialPooler, see FrozenSpatialPooler.
+  */
+  static std::vector<CellIdx> inhibitColumnsGlobal(const vector<Real> &overlaps, const Real density,
+                                                   const UInt stimulusThreshold,
+                                                   const vector<CellIdx> *candidates = nullptr);
 
   /**
      Performs local inhibition.
@@ -953,10 +1191,26 @@ public:
      local fashion, the exact fraction of surviving columns is likely to
      vary.
 
+     @param parallel
+     false: don't use the thread pool, eg. when already called from it.
+
      @return activeColumns
      an (sparse SDR) vector containing the indices of the active columns.
   */
-  std::vector<CellIdx> inhibitColumnsLocal_(const vector<Real> &overlaps, const Real density) const;
+  std::vector<CellIdx> inhibitColumnsLocal_(const vector<Real> &overlaps, const Real density,
+                                            const bool parallel = true) const;
+
+  /**
+     inhibitColumnsLocal_() with the parameters of the SP passed in,
+     for use without a SpatialPooler, see FrozenSpatialPooler.
+     @param threads (optional) to split the columns between, see setNumThreads().
+  */
+  static std::vector<CellIdx> inhibitColumnsLocal(const vector<Real> &overlaps, const Real density,
+                                                  const UInt stimulusThreshold,
+                                                  const vector<UInt> &columnDimensions,
+                                                  const UInt inhibitionRadius,
+                                                  const bool wrapAround,
+                                                  ThreadPool *threads = nullptr);
 
   /**
       The primary method in charge of learning.
@@ -977,6 +1231,9 @@ public:
    */
   void adaptSynapses_(const SDR &input, const SDR &active);
 
+  /** adaptSynapses_() of a subset of the columns, see setLearningThrottle(). */
+  void adaptSynapsesThrottled_(const SDR &input, const SDR &active);
+
   /**
       This method increases the permanence values of synapses of columns whose
       activity level has been too low. Such columns are identified by having an
@@ -1133,6 +1390,17 @@ public:
   */
   void updateBoostFactorsGlobal_();
 
+  /**
+  The target activation level for global inhibition, see updateBoostFactorsGlobal_().
+  */
+  Real globalTargetDensity_() const;
+
+  /**
+  All of the per-column bookkeeping of a learning step in one pass: same as
+  updateDutyCycles_(), bumpUpWeakColumns_() and updateBoostFactors_().
+  */
+  void updateColumnStates_(const vector<SynapseIdx> &overlaps, const SDR &active);
+
   /**
   Updates counter instance variables each round.
 
@@ -1144,12 +1412,33 @@ public:
    */
   void updateBookeepingVars_(bool learn);
 
+  /** Create or update bitset_ to the current connections, see setBitsetEnabled(). */
+  void syncBitset_();
+
+  /** Create or update incremental_ to the current connections, see setIncrementalEnabled(). */
+  void syncIncremental_();
+
+  /** Create or update locality_ to the current connections, see setLocalityEnabled(). */
+  void syncLocality_();
+
   /**
   @returns boolean value indicating whether enough rounds have passed to warrant
   updates of duty cycles
   */
   bool isUpdateRound_() const;
 
+  /** The sections of saveCheckpoint(), loadCheckpoint(). */
+  void saveCheckpoint_(CheckpointWriter &writer) const;
+  void loadCheckpoint_(const CheckpointReader &reader);
+
+  /**
+   * See setInitializationCache().  The key lists the parameters of
+   * initialize(), the file stores it to tell hash collisions apart.
+   * @returns whether the state was loaded from the cache.
+   */
+  bool loadInitializationCache_(const std::string &path, const std::string &key);
+  void saveInitializationCache_(const std::string &path, const std::string &key) const;
+
   //-------------------------------------------------------------------
   // Debugging helpers
   //-------------------------------------------------------------------
@@ -1214,6 +1503,33 @@ protected:
   Connections connections_;
 
   vector<Real> boostedOverlaps_;
+  vector<CellIdx> boostedColumns_; //the non-zero entries of boostedOverlaps_, see boostOverlaps_()
+  bool boostedValid_ = false;      //false: boostedColumns_ is unknown, eg. after load
+  bool fastBoosting_ = false;      //see setFastBoosting()
+  bool gpuEnabled_ = false;        //see setGpuEnabled()
+  std::shared_ptr<SpatialPoolerGpu> gpu_; //the device copy, created on demand, not serialized
+  bool bitsetEnabled_ = false;     //see setBitsetEnabled()
+  std::shared_ptr<SpatialPoolerBitset> bitset_; //created on demand, not serialized
+  bool incrementalEnabled_ = false; //see setIncrementalEnabled()
+  std::shared_ptr<SpatialPoolerIncremental> incremental_; //created on demand, not serialized
+  bool localityEnabled_ = false;   //see setLocalityEnabled()
+  std::shared_ptr<SpatialPoolerLocality> locality_; //created on demand, not serialized
+  // see setLearningThrottle(), not serialized
+  Real   learnFraction_ = 1.0f;
+  UInt   learnEvery_ = 1u;
+  bool   scaleIncrements_ = true;
+  Random throttleRng_;
+  UInt   throttleStep_ = 0u;
+  Real   bumpScale_ = 1.0f; //of synPermBelowStimulusInc_ in this compute, 0 skips bumpUpWeakColumns_()
+  Real64 throttleAdapted_ = 0.0;
+  Real64 throttleActive_ = 0.0;
+  vector<CellIdx> learnColumns_;
+  SegmentActivity overlapActivity_; //reused by computeActivity(), not serialized
+  struct BatchBuffer {
+    SegmentActivity activity;
+    vector<Real>    boostedOverlaps; //zero except while an input is computed
+  };
+  vector<BatchBuffer> batchBuffers_; //one per thread, see computeBatch(), not serialized
 
 
   UInt version_;
@@ -1222,8 +1538,23 @@ protected:
 public:
   const Connections& connections = connections_; //for inspection of details in connections. Const, so users cannot break the SP internals.
   const Connections& getConnections() const { return connections_; } // as above, but for use in pybind11
-private:
-  std::unordered_map<UInt, std::vector<UInt>> neighborMap_; // col -> vector neighbors
+
+  /**
+   * Prune the trained model offline: destroys the potential synapses with a
+   * permanence below minPermanence, see `Connections::prune()`.  These can
+   * not grow back, learning never adds to the potential pools.  Below
+   * synPermConnected the active columns do not change.
+   *
+   * @returns the number of destroyed synapses.
+   */
+  size_t prune(Permanence minPermanence);
+
+  /**
+   * Bytes of memory by category: connections.<category> (see
+   * Connections::memoryUsage()), dutyCycles and boostFactors (per column),
+   * caches (buffers reused between computes).
+   */
+  MemoryUsage memoryUsage() const;
 };
 
 std::ostream & operator<<(std::ostream & out, const SpatialPooler &sp);
@@ -0,0 +1,245 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the SpatialPoolerBitset class
+ */
+
+#include <htm/algorithms/SpatialPoolerBitset.hpp>
+
+#include <algorithm>
+#include <array>
+#include <string>
+
+#include <htm/utils/CpuDispatch.hpp>
+#include <htm/utils/Log.hpp>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #define HTM_SP_BITSET_X86
+  #include <immintrin.h>
+#endif
+
+using namespace htm;
+
+namespace {
+  constexpr size_t BITS_PER_WORD = 64u;
+
+  using OverlapsFn = SpatialPoolerBitset::OverlapsFn;
+
+  // The overlaps of all rows with the input, one function per instruction set.
+  void overlapsScalar_(const UInt64 *rows, const size_t wordsPerRow, const UInt numRows,
+                       const UInt64 *input, SynapseIdx *overlaps) {
+    for(UInt r = 0u; r < numRows; r++, rows += wordsPerRow) {
+      UInt count = 0u;
+      for(size_t w = 0u; w < wordsPerRow; w++) {
+        UInt64 word = rows[w] & input[w];
+        word = word - ((word >> 1) & 0x5555555555555555ull);
+        word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+        word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+        count += static_cast<UInt>((word * 0x0101010101010101ull) >> 56);
+      }
+      overlaps[r] = static_cast<SynapseIdx>(count);
+    }
+  }
+
+#ifdef HTM_SP_BITSET_X86
+  __attribute__((target("popcnt")))
+  void overlapsPopcnt_(const UInt64 *rows, const size_t wordsPerRow, const UInt numRows,
+                       const UInt64 *input, SynapseIdx *overlaps) {
+    for(UInt r = 0u; r < numRows; r++, rows += wordsPerRow) {
+      UInt count = 0u;
+      for(size_t w = 0u; w < wordsPerRow; w++) {
+        count += static_cast<UInt>(__builtin_popcountll(rows[w] & input[w]));
+      }
+      overlaps[r] = static_cast<SynapseIdx>(count);
+    }
+  }
+
+  // VPOPCNTQ on 8 words at once, the tail of each row with a masked load.
+  __attribute__((target("avx512f,avx512vpopcntdq")))
+  void overlapsAvx512_(const UInt64 *rows, const size_t wordsPerRow, const UInt numRows,
+                       const UInt64 *input, SynapseIdx *overlaps) {
+    const size_t full = wordsPerRow - wordsPerRow % 8u;
+    const __mmask8 tail = static_cast<__mmask8>((1u << (wordsPerRow % 8u)) - 1u);
+    for(UInt r = 0u; r < numRows; r++, rows += wordsPerRow) {
+      __m512i sum = _mm512_setzero_si512();
+      for(size_t w = 0u; w < full; w += 8u) {
+        const __m512i a = _mm512_loadu_si512(reinterpret_cast<const void*>(rows + w));
+        const __m512i b = _mm512_loadu_si512(reinterpret_cast<const void*>(input + w));
+        sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(_mm512_and_si512(a, b)));
+      }
+      if(tail != 0u) {
+        const __m512i a = _mm512_maskz_loadu_epi64(tail, rows + full);
+        const __m512i b = _mm512_maskz_loadu_epi64(tail, input + full);
+        sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(_mm512_and_si512(a, b)));
+      }
+      overlaps[r] = static_cast<SynapseIdx>(_mm512_reduce_add_epi64(sum));
+    }
+  }
+#endif
+
+  // The same kernels with the row width fixed at compile time: the input is
+  // held on the stack (or in registers) and the inner loops are unrolled.
+  template<size_t Words>
+  void overlapsScalarFixed_(const UInt64 *rows, const size_t, const UInt numRows,
+                            const UInt64 *input, SynapseIdx *overlaps) {
+    std::array<UInt64, Words> in;
+    std::copy(input, input + Words, in.begin());
+    for(UInt r = 0u; r < numRows; r++, rows += Words) {
+      UInt count = 0u;
+      for(size_t w = 0u; w < Words; w++) {
+        UInt64 word = rows[w] & in[w];
+        word = word - ((word >> 1) & 0x5555555555555555ull);
+        word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+        word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+        count += static_cast<UInt>((word * 0x0101010101010101ull) >> 56);
+      }
+      overlaps[r] = static_cast<SynapseIdx>(count);
+    }
+  }
+
+#ifdef HTM_SP_BITSET_X86
+  template<size_t Words>
+  __attribute__((target("popcnt")))
+  void overlapsPopcntFixed_(const UInt64 *rows, const size_t, const UInt numRows,
+                            const UInt64 *input, SynapseIdx *overlaps) {
+    std::array<UInt64, Words> in;
+    std::copy(input, input + Words, in.begin());
+    for(UInt r = 0u; r < numRows; r++, rows += Words) {
+      UInt count = 0u;
+      for(size_t w = 0u; w < Words; w++) {
+        count += static_cast<UInt>(__builtin_popcountll(rows[w] & in[w]));
+      }
+      overlaps[r] = static_cast<SynapseIdx>(count);
+    }
+  }
+
+  template<size_t Words>
+  __attribute__((target("avx512f,avx512vpopcntdq")))
+  void overlapsAvx512Fixed_(const UInt64 *rows, const size_t, const UInt numRows,
+                            const UInt64 *input, SynapseIdx *overlaps) {
+    static_assert(Words % 8u == 0u, "whole vectors only");
+    constexpr size_t numVectors = Words / 8u;
+    __m512i in[numVectors];
+    for(size_t v = 0u; v < numVectors; v++) {
+      in[v] = _mm512_loadu_si512(reinterpret_cast<const void*>(input + 8u * v));
+    }
+    for(UInt r = 0u; r < numRows; r++, rows += Words) {
+      __m512i sum = _mm512_setzero_si512();
+      for(size_t v = 0u; v < numVectors; v++) {
+        const __m512i a = _mm512_loadu_si512(reinterpret_cast<const void*>(rows + 8u * v));
+        sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(_mm512_and_si512(a, in[v])));
+      }
+      overlaps[r] = static_cast<SynapseIdx>(_mm512_reduce_add_epi64(sum));
+    }
+  }
+#endif
+
+  template<size_t Words>
+  OverlapsFn fixedFn_() {
+    static const OverlapsFn fn = CpuDispatch::bind<OverlapsFn>(
+      ("spBitset.overlaps" + std::to_string(Words * BITS_PER_WORD)).c_str(), {
+    #ifdef HTM_SP_BITSET_X86
+        {"avx512", CPU_AVX512F | CPU_AVX512VPOPCNTDQ, overlapsAvx512Fixed_<Words>},
+        {"popcnt", CPU_POPCNT, overlapsPopcntFixed_<Words>},
+    #endif
+        {"scalar", 0u, overlapsScalarFixed_<Words>}});
+    return fn;
+  }
+
+  // The registered row widths, in words of 64 inputs. Add a width here to
+  // specialize the kernels for it, multiples of 8 only.
+  template<size_t... Words> struct FixedWords_ {
+    static OverlapsFn find(const size_t wordsPerRow) {
+      OverlapsFn fn = nullptr;
+      ((fn = wordsPerRow == Words ? fixedFn_<Words>() : fn), ...);
+      return fn;
+    }
+  };
+  using Registered_ = FixedWords_<8u, 16u, 32u, 64u>; // 512, 1024, 2048 and 4096 inputs
+
+  OverlapsFn selectKernel_(const size_t wordsPerRow) {
+    const OverlapsFn fixed = Registered_::find(wordsPerRow);
+    if(fixed != nullptr) return fixed;
+    static const OverlapsFn fn = CpuDispatch::bind<OverlapsFn>("spBitset.overlaps", {
+    #ifdef HTM_SP_BITSET_X86
+      {"avx512", CPU_AVX512F | CPU_AVX512VPOPCNTDQ, overlapsAvx512_},
+      {"popcnt", CPU_POPCNT, overlapsPopcnt_},
+    #endif
+      {"scalar", 0u, overlapsScalar_}});
+    return fn;
+  }
+} // namespace
+
+
+SpatialPoolerBitset::SpatialPoolerBitset(Connections &connections, const UInt numInputs, const UInt numColumns)
+  : connections_(&connections), numInputs_(numInputs), numColumns_(numColumns),
+    wordsPerRow_((static_cast<size_t>(numInputs) + BITS_PER_WORD - 1u) / BITS_PER_WORD),
+    overlapsFn_(selectKernel_(wordsPerRow_)),
+    fixedShape_(Registered_::find(wordsPerRow_) != nullptr) {
+  NTA_CHECK(connections.numSegments() == numColumns) << "SpatialPoolerBitset: one segment per column expected.";
+  connections.setTrackChangedSegments(true);
+  buildAll_();
+}
+
+
+void SpatialPoolerBitset::buildRow_(const Segment column) {
+  UInt64 *row = rows_.data() + column * wordsPerRow_;
+  std::fill(row, row + wordsPerRow_, 0u);
+  for(const auto synapse : connections_->synapsesForSegment(column)) {
+    if(not connections_->isConnected(synapse)) continue;
+    const CellIdx input = connections_->presynapticCellForSynapse(synapse);
+    NTA_ASSERT(input < numInputs_);
+    row[input / BITS_PER_WORD] |= UInt64(1u) << (input % BITS_PER_WORD);
+  }
+}
+
+
+void SpatialPoolerBitset::buildAll_() {
+  rows_.assign(numColumns_ * wordsPerRow_, 0u);
+  for(Segment column = 0u; column < numColumns_; column++) buildRow_(column);
+}
+
+
+void SpatialPoolerBitset::sync() {
+  if(not connections_->takeChangedSegments(changed_)) {
+    buildAll_();
+    return;
+  }
+  for(const Segment column : changed_) {
+    if(column < numColumns_) buildRow_(column);
+  }
+}
+
+
+void SpatialPoolerBitset::computeOverlaps(const SDR &input, SegmentActivity &activity) const {
+  NTA_ASSERT(input.size == numInputs_);
+  const auto &packed = input.getPacked();
+  auto &overlaps = activity.numActiveConnected;
+  overlaps.resize(numColumns_);
+  overlapsFn_(rows_.data(), wordsPerRow_, numColumns_, packed.data(), overlaps.data());
+  activity.touched.clear();
+  for(Segment column = 0u; column < numColumns_; column++) {
+    if(overlaps[column] > 0u) activity.touched.push_back(column);
+  }
+  activity.touchedValid = true;
+}
+
+
+size_t SpatialPoolerBitset::memoryUsage() const {
+  return rows_.capacity() * sizeof(UInt64) + changed_.capacity() * sizeof(Segment);
+}
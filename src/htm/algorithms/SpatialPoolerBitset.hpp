@@ -0,0 +1,105 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the SpatialPoolerBitset class
+ */
+
+#ifndef HTM_ALGORITHMS_SPATIAL_POOLER_BITSET_HPP
+#define HTM_ALGORITHMS_SPATIAL_POOLER_BITSET_HPP
+
+#include <vector>
+
+#include <htm/algorithms/Connections.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * The connected synapses of a SpatialPooler as a bit matrix, one row of
+ * packed words per column, bit i of a row set if the column has a connected
+ * synapse to input i. See SpatialPooler::setBitsetEnabled().
+ *
+ * The overlap of a column is popcount(row AND input), with the input in the
+ * packed format of the SDR (see SDR::getPacked()). This reads every word of
+ * every row, regardless of the input, so it wins over the presynaptic lists
+ * of Connections::computeActivity() when the inputs are dense-ish and the
+ * potential pools are large.
+ *
+ * The Connections stay the master copy: they track which columns changed
+ * while learning (see Connections::setTrackChangedSegments()), and sync()
+ * rebuilds the rows of those.
+ *
+ * Results are identical to Connections::computeActivity().
+ */
+class SpatialPoolerBitset {
+public:
+  /**
+   * Builds the matrix. Each column must have one segment, with the index of
+   * the column, as in the SpatialPooler.
+   */
+  SpatialPoolerBitset(Connections &connections, UInt numInputs, UInt numColumns);
+
+  SpatialPoolerBitset(const SpatialPoolerBitset &) = delete;
+  SpatialPoolerBitset &operator=(const SpatialPoolerBitset &) = delete;
+
+  /** Is this the matrix of these connections? Not after they were copied or moved. */
+  bool mirrors(const Connections &connections) const noexcept { return &connections == connections_; }
+
+  /** Rebuild the rows of the columns which changed since the last sync(). */
+  void sync();
+
+  /**
+   * The connected overlaps of the input, into activity.numActiveConnected,
+   * and activity.touched the columns with a non-zero overlap. Call sync()
+   * first. Read-only, can be called from several threads at once, each with
+   * its own activity, if the input's packed format is already valid.
+   */
+  void computeOverlaps(const SDR &input, SegmentActivity &activity) const;
+
+  /** Bytes of the matrix. */
+  size_t memoryUsage() const;
+
+  /**
+   * Are the kernels specialized for this number of inputs at compile time?
+   * Registered are 512, 1024, 2048 and 4096 inputs (rounded up to 64), see
+   * FixedWords_ in SpatialPoolerBitset.cpp. Other sizes use the runtime loops.
+   */
+  bool isFixedShape() const noexcept { return fixedShape_; }
+
+  /** A kernel: the overlaps of all rows with the packed input. */
+  using OverlapsFn = void (*)(const UInt64 *rows, size_t wordsPerRow, UInt numRows,
+                              const UInt64 *input, SynapseIdx *overlaps);
+
+private:
+  void buildRow_(Segment column);
+  void buildAll_();
+
+  Connections *connections_;
+  UInt numInputs_;
+  UInt numColumns_;
+  size_t wordsPerRow_;
+  OverlapsFn overlapsFn_;
+  bool fixedShape_;
+  std::vector<UInt64>  rows_; //numColumns_ * wordsPerRow_
+  std::vector<Segment> changed_; //reused by sync()
+};
+
+} // namespace htm
+
+#endif // HTM_ALGORITHMS_SPATIAL_POOLER_BITSET_HPP
@@ -0,0 +1,153 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the SpatialPoolerGpu class, the host side
+ */
+
+#include <htm/algorithms/SpatialPoolerGpu.hpp>
+#include <htm/algorithms/SpatialPoolerGpuDevice.hpp>
+
+#include <algorithm>
+
+#include <htm/utils/Log.hpp>
+
+using namespace htm;
+
+#ifndef HTM_CUDA
+// Built without the device side: not available.
+namespace htm {
+namespace gpu {
+  bool deviceAvailable() { return false; }
+  SpDevice *create(UInt32, UInt32, UInt32) {
+    NTA_THROW << "SpatialPoolerGpu: built without HTM_CUDA.";
+  }
+  void destroy(SpDevice *) {}
+  void uploadAll(SpDevice *, const UInt32 *, const uint8_t *, const UInt32 *) {}
+  void uploadColumns(SpDevice *, UInt32, const UInt32 *, const UInt32 *, const uint8_t *, const UInt32 *) {}
+  void uploadBoostFactors(SpDevice *, const Real *) {}
+  void computeOverlaps(SpDevice *, UInt32, const UInt32 *, UInt16 *) {}
+  UInt32 inhibitGlobal(SpDevice *, bool, Real, UInt32, UInt32 *) { return 0u; }
+} // namespace gpu
+} // namespace htm
+#endif
+
+
+bool SpatialPoolerGpu::available() { return gpu::deviceAvailable(); }
+
+
+SpatialPoolerGpu::SpatialPoolerGpu(Connections &connections, const UInt numInputs, const UInt numColumns)
+  : connections_(&connections), numInputs_(numInputs), numColumns_(numColumns) {
+  NTA_CHECK(available()) << "SpatialPoolerGpu: built without HTM_CUDA, or no CUDA device found.";
+  NTA_CHECK(connections.numSegments() == numColumns) << "SpatialPoolerGpu: one segment per column expected.";
+  connections.setTrackChangedSegments(true);
+  uploadAll_();
+}
+
+
+SpatialPoolerGpu::~SpatialPoolerGpu() {
+  gpu::destroy(device_);
+}
+
+
+void SpatialPoolerGpu::uploadAll_() {
+  UInt capacity = 1u;
+  for(Segment column = 0u; column < numColumns_; column++) {
+    capacity = std::max(capacity, static_cast<UInt>(connections_->numSynapses(column)));
+  }
+  if(device_ == nullptr or capacity > capacity_) {
+    gpu::destroy(device_);
+    device_ = nullptr;
+    capacity_ = capacity + capacity / 8u; // some room for synapses added later
+    device_ = gpu::create(numInputs_, numColumns_, capacity_);
+  }
+
+  presyn_.assign(static_cast<size_t>(capacity_) * numColumns_, 0u);
+  connected_.assign(presyn_.size(), 0u);
+  count_.resize(numColumns_);
+  for(Segment column = 0u; column < numColumns_; column++) {
+    const auto &synapses = connections_->synapsesForSegment(column);
+    count_[column] = static_cast<UInt32>(synapses.size());
+    for(size_t j = 0u; j < synapses.size(); j++) {
+      const size_t slot = j * numColumns_ + column;
+      presyn_[slot]    = connections_->presynapticCellForSynapse(synapses[j]);
+      connected_[slot] = connections_->isConnected(synapses[j]) ? 1u : 0u;
+    }
+  }
+  gpu::uploadAll(device_, presyn_.data(), connected_.data(), count_.data());
+  boostDirty_ = true;
+}
+
+
+void SpatialPoolerGpu::sync_() {
+  if(not connections_->takeChangedSegments(changed_)) {
+    uploadAll_();
+    return;
+  }
+  if(changed_.empty()) return;
+
+  columns_.clear();
+  presyn_.assign(static_cast<size_t>(capacity_) * changed_.size(), 0u);
+  connected_.assign(presyn_.size(), 0u);
+  count_.clear();
+  for(const Segment column : changed_) {
+    if(column >= numColumns_) continue;
+    const auto &synapses = connections_->synapsesForSegment(column);
+    if(synapses.size() > capacity_) { // outgrew the device buffers
+      uploadAll_();
+      return;
+    }
+    const size_t offset = columns_.size() * static_cast<size_t>(capacity_);
+    for(size_t j = 0u; j < synapses.size(); j++) {
+      presyn_[offset + j]    = connections_->presynapticCellForSynapse(synapses[j]);
+      connected_[offset + j] = connections_->isConnected(synapses[j]) ? 1u : 0u;
+    }
+    columns_.push_back(column);
+    count_.push_back(static_cast<UInt32>(synapses.size()));
+  }
+  gpu::uploadColumns(device_, static_cast<UInt32>(columns_.size()), columns_.data(),
+                     presyn_.data(), connected_.data(), count_.data());
+}
+
+
+void SpatialPoolerGpu::computeOverlaps(const std::vector<UInt> &activeInputs, SegmentActivity &activity) {
+  sync_();
+  auto &overlaps = activity.numActiveConnected;
+  overlaps.resize(numColumns_);
+  gpu::computeOverlaps(device_, static_cast<UInt32>(activeInputs.size()), activeInputs.data(), overlaps.data());
+  activity.touched.clear();
+  for(Segment column = 0u; column < numColumns_; column++) {
+    if(overlaps[column] > 0u) activity.touched.push_back(column);
+  }
+  activity.touchedValid = true;
+}
+
+
+std::vector<CellIdx> SpatialPoolerGpu::inhibitColumnsGlobal(const std::vector<Real> &boostFactors, const bool boost,
+                                                            const Real density, const UInt stimulusThreshold) {
+  const UInt numDesired = static_cast<UInt>((density * numColumns_));
+  NTA_CHECK(numDesired > 0) << "Not enough columns (" << numColumns_ << ") "
+                            << "for desired density (" << density << ").";
+  if(boost and boostDirty_) {
+    NTA_ASSERT(boostFactors.size() == numColumns_);
+    gpu::uploadBoostFactors(device_, boostFactors.data());
+    boostDirty_ = false;
+  }
+  std::vector<CellIdx> winners(numDesired);
+  winners.resize(gpu::inhibitGlobal(device_, boost, static_cast<Real>(stimulusThreshold), numDesired, winners.data()));
+  return winners;
+}
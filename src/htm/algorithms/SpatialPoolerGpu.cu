@@ -0,0 +1,257 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the SpatialPoolerGpu class, the device side.
+ * Only built with HTM_CUDA.
+ */
+
+#include <htm/algorithms/SpatialPoolerGpuDevice.hpp>
+
+#include <cuda_runtime.h>
+#include <thrust/count.h>
+#include <thrust/execution_policy.h>
+#include <thrust/functional.h>
+#include <thrust/sort.h>
+#include <vector>
+
+#include <htm/utils/Log.hpp>
+
+#define HTM_CUDA_CHECK(call)                                                                       \
+  do {                                                                                             \
+    const cudaError_t err = (call);                                                                \
+    NTA_CHECK(err == cudaSuccess) << "CUDA: " << cudaGetErrorString(err);                          \
+  } while (0)
+
+namespace htm {
+namespace gpu {
+
+static_assert(sizeof(Real) == 4u, "SpatialPoolerGpu: the sort keys hold a 32 bit Real and the column");
+
+static constexpr UInt32 BLOCK = 256u;
+static inline UInt32 blocks(const UInt32 n) { return (n + BLOCK - 1u) / BLOCK; }
+
+struct SpDevice {
+  UInt32 numInputs;
+  UInt32 numColumns;
+  UInt32 capacity;
+  UInt32   *presyn    = nullptr; // capacity * numColumns, slot-major
+  uint8_t  *connected = nullptr;
+  UInt32   *count     = nullptr; // per column
+  uint8_t  *input     = nullptr; // per input, 1 if active
+  UInt16   *overlaps  = nullptr; // per column
+  Real     *boost     = nullptr; // per column
+  unsigned long long *keys = nullptr; // per column, see keysKernel
+
+  // staging, grown as needed
+  UInt32   *active = nullptr;
+  UInt32   activeCapacity = 0u;
+  UInt32   *batchColumns = nullptr;
+  UInt32   *batchPresyn  = nullptr;
+  uint8_t  *batchConnected = nullptr;
+  UInt32   *batchCount = nullptr;
+  UInt32   batchCapacity = 0u; // columns
+};
+
+template <typename T> static void alloc(T *&p, const size_t n) {
+  HTM_CUDA_CHECK(cudaMalloc(reinterpret_cast<void **>(&p), (n > 0u ? n : 1u) * sizeof(T)));
+}
+template <typename T> static void release(T *&p) {
+  if (p != nullptr) cudaFree(p);
+  p = nullptr;
+}
+
+
+__global__ void setInputsKernel(const UInt32 *active, const UInt32 n, uint8_t *input, const uint8_t value) {
+  const UInt32 i = blockIdx.x * blockDim.x + threadIdx.x;
+  if (i < n) input[active[i]] = value;
+}
+
+// One thread per column, the threads of a warp read consecutive slots.
+__global__ void overlapsKernel(const UInt32 *presyn, const uint8_t *connected, const UInt32 *count,
+                               const uint8_t *input, const UInt32 numColumns, UInt16 *overlaps) {
+  const UInt32 column = blockIdx.x * blockDim.x + threadIdx.x;
+  if (column >= numColumns) return;
+  UInt32 sum = 0u;
+  const UInt32 n = count[column];
+  for (UInt32 j = 0u; j < n; j++) {
+    const size_t slot = static_cast<size_t>(j) * numColumns + column;
+    sum += connected[slot] & input[presyn[slot]];
+  }
+  overlaps[column] = static_cast<UInt16>(sum);
+}
+
+// One block per uploaded column.
+__global__ void scatterKernel(const UInt32 *columns, const UInt32 *srcPresyn, const uint8_t *srcConnected,
+                              const UInt32 *srcCount, const UInt32 capacity, const UInt32 numColumns,
+                              UInt32 *presyn, uint8_t *connected, UInt32 *count) {
+  const UInt32 i = blockIdx.x;
+  const UInt32 column = columns[i];
+  const UInt32 n = srcCount[i];
+  for (UInt32 j = threadIdx.x; j < n; j += blockDim.x) {
+    const size_t slot = static_cast<size_t>(j) * numColumns + column;
+    presyn[slot]    = srcPresyn[static_cast<size_t>(i) * capacity + j];
+    connected[slot] = srcConnected[static_cast<size_t>(i) * capacity + j];
+  }
+  if (threadIdx.x == 0u) count[column] = n;
+}
+
+// Same order as the Reals, see sortableKey() in SpatialPooler.cpp.
+__device__ inline UInt32 sortableKey(const float value) {
+  const UInt32 bits = __float_as_uint(value);
+  return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+// The boosted overlap in the high half and the column in the low half, so
+// sorting in decreasing order breaks ties by the higher column as on the
+// host. Columns below the stimulus threshold get 0, which sorts last.
+__global__ void keysKernel(const UInt16 *overlaps, const Real *boost, const bool useBoost,
+                           const Real stimulusThreshold, const UInt32 numColumns,
+                           unsigned long long *keys) {
+  const UInt32 column = blockIdx.x * blockDim.x + threadIdx.x;
+  if (column >= numColumns) return;
+  const Real boosted = useBoost ? overlaps[column] * boost[column] : static_cast<Real>(overlaps[column]);
+  keys[column] = boosted >= stimulusThreshold
+                     ? (static_cast<unsigned long long>(sortableKey(boosted)) << 32u) | column
+                     : 0ull;
+}
+
+
+bool deviceAvailable() {
+  int numDevices = 0;
+  return cudaGetDeviceCount(&numDevices) == cudaSuccess && numDevices > 0;
+}
+
+
+SpDevice *create(const UInt32 numInputs, const UInt32 numColumns, const UInt32 capacity) {
+  auto *d = new SpDevice();
+  d->numInputs  = numInputs;
+  d->numColumns = numColumns;
+  d->capacity   = capacity;
+  try {
+    alloc(d->presyn, static_cast<size_t>(capacity) * numColumns);
+    alloc(d->connected, static_cast<size_t>(capacity) * numColumns);
+    alloc(d->count, numColumns);
+    alloc(d->input, numInputs);
+    alloc(d->overlaps, numColumns);
+    alloc(d->boost, numColumns);
+    alloc(d->keys, numColumns);
+    HTM_CUDA_CHECK(cudaMemset(d->input, 0, numInputs > 0u ? numInputs : 1u));
+    HTM_CUDA_CHECK(cudaMemset(d->count, 0, numColumns * sizeof(UInt32)));
+  } catch (...) {
+    destroy(d);
+    throw;
+  }
+  return d;
+}
+
+
+void destroy(SpDevice *d) {
+  if (d == nullptr) return;
+  release(d->presyn);
+  release(d->connected);
+  release(d->count);
+  release(d->input);
+  release(d->overlaps);
+  release(d->boost);
+  release(d->keys);
+  release(d->active);
+  release(d->batchColumns);
+  release(d->batchPresyn);
+  release(d->batchConnected);
+  release(d->batchCount);
+  delete d;
+}
+
+
+void uploadAll(SpDevice *d, const UInt32 *presyn, const uint8_t *connected, const UInt32 *count) {
+  const size_t n = static_cast<size_t>(d->capacity) * d->numColumns;
+  HTM_CUDA_CHECK(cudaMemcpy(d->presyn, presyn, n * sizeof(UInt32), cudaMemcpyHostToDevice));
+  HTM_CUDA_CHECK(cudaMemcpy(d->connected, connected, n, cudaMemcpyHostToDevice));
+  HTM_CUDA_CHECK(cudaMemcpy(d->count, count, d->numColumns * sizeof(UInt32), cudaMemcpyHostToDevice));
+}
+
+
+void uploadColumns(SpDevice *d, const UInt32 n, const UInt32 *columns,
+                   const UInt32 *presyn, const uint8_t *connected, const UInt32 *count) {
+  if (n == 0u) return;
+  if (n > d->batchCapacity) {
+    release(d->batchColumns);
+    release(d->batchPresyn);
+    release(d->batchConnected);
+    release(d->batchCount);
+    d->batchCapacity = n + n / 2u;
+    alloc(d->batchColumns, d->batchCapacity);
+    alloc(d->batchPresyn, static_cast<size_t>(d->batchCapacity) * d->capacity);
+    alloc(d->batchConnected, static_cast<size_t>(d->batchCapacity) * d->capacity);
+    alloc(d->batchCount, d->batchCapacity);
+  }
+  const size_t slots = static_cast<size_t>(n) * d->capacity;
+  HTM_CUDA_CHECK(cudaMemcpy(d->batchColumns, columns, n * sizeof(UInt32), cudaMemcpyHostToDevice));
+  HTM_CUDA_CHECK(cudaMemcpy(d->batchPresyn, presyn, slots * sizeof(UInt32), cudaMemcpyHostToDevice));
+  HTM_CUDA_CHECK(cudaMemcpy(d->batchConnected, connected, slots, cudaMemcpyHostToDevice));
+  HTM_CUDA_CHECK(cudaMemcpy(d->batchCount, count, n * sizeof(UInt32), cudaMemcpyHostToDevice));
+  scatterKernel<<<n, 128u>>>(d->batchColumns, d->batchPresyn, d->batchConnected, d->batchCount,
+                              d->capacity, d->numColumns, d->presyn, d->connected, d->count);
+  HTM_CUDA_CHECK(cudaGetLastError());
+}
+
+
+void uploadBoostFactors(SpDevice *d, const Real *boostFactors) {
+  HTM_CUDA_CHECK(cudaMemcpy(d->boost, boostFactors, d->numColumns * sizeof(Real), cudaMemcpyHostToDevice));
+}
+
+
+void computeOverlaps(SpDevice *d, const UInt32 numActive, const UInt32 *active, UInt16 *overlaps) {
+  if (numActive > d->activeCapacity) {
+    release(d->active);
+    d->activeCapacity = numActive + numActive / 2u;
+    alloc(d->active, d->activeCapacity);
+  }
+  if (numActive > 0u) {
+    HTM_CUDA_CHECK(cudaMemcpy(d->active, active, numActive * sizeof(UInt32), cudaMemcpyHostToDevice));
+    setInputsKernel<<<blocks(numActive), BLOCK>>>(d->active, numActive, d->input, 1u);
+  }
+  overlapsKernel<<<blocks(d->numColumns), BLOCK>>>(d->presyn, d->connected, d->count, d->input,
+                                                   d->numColumns, d->overlaps);
+  if (numActive > 0u) { // clear the input for the next call
+    setInputsKernel<<<blocks(numActive), BLOCK>>>(d->active, numActive, d->input, 0u);
+  }
+  HTM_CUDA_CHECK(cudaGetLastError());
+  HTM_CUDA_CHECK(cudaMemcpy(overlaps, d->overlaps, d->numColumns * sizeof(UInt16), cudaMemcpyDeviceToHost));
+}
+
+
+UInt32 inhibitGlobal(SpDevice *d, const bool boost, const Real stimulusThreshold, const UInt32 numDesired,
+                     UInt32 *winners) {
+  const UInt32 n = d->numColumns;
+  keysKernel<<<blocks(n), BLOCK>>>(d->overlaps, d->boost, boost, stimulusThreshold, n, d->keys);
+  HTM_CUDA_CHECK(cudaGetLastError());
+  thrust::sort(thrust::device, d->keys, d->keys + n, thrust::greater<unsigned long long>());
+  const auto numEligible = static_cast<UInt32>(n - thrust::count(thrust::device, d->keys, d->keys + n, 0ull));
+  const UInt32 numWinners = numEligible < numDesired ? numEligible : numDesired;
+
+  std::vector<unsigned long long> keys(numWinners);
+  HTM_CUDA_CHECK(cudaMemcpy(keys.data(), d->keys, numWinners * sizeof(unsigned long long), cudaMemcpyDeviceToHost));
+  for (UInt32 i = 0u; i < numWinners; i++) {
+    winners[i] = static_cast<UInt32>(keys[i] & 0xFFFFFFFFull);
+  }
+  return numWinners;
+}
+
+} // namespace gpu
+} // namespace htm
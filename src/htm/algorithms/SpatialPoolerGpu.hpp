@@ -0,0 +1,109 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the SpatialPoolerGpu class
+ */
+
+#ifndef HTM_ALGORITHMS_SPATIAL_POOLER_GPU_HPP
+#define HTM_ALGORITHMS_SPATIAL_POOLER_GPU_HPP
+
+#include <memory>
+#include <vector>
+
+#include <htm/algorithms/Connections.hpp>
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+namespace gpu {
+  struct SpDevice; // the device buffers, see SpatialPoolerGpu.cu
+}
+
+/**
+ * A copy of the synapses of a SpatialPooler on a CUDA device, which computes
+ * the overlaps and the global inhibition there, see
+ * SpatialPooler::setGpuEnabled().
+ *
+ * The potential synapses of column c are in slots j * numColumns + c, so
+ * that the threads of neighbouring columns read neighbouring memory, with a
+ * flag whether each is connected.  The Connections on the host stay the
+ * master copy: they track which columns changed while learning (see
+ * Connections::setTrackChangedSegments()), and before the next compute all
+ * of those are uploaded in one batch.
+ *
+ * Results are identical to the computation on the host.
+ *
+ * Only available when built with HTM_CUDA (cmake -DHTM_CUDA=ON) on a host
+ * with a CUDA device.
+ */
+class SpatialPoolerGpu {
+public:
+  /** Built with HTM_CUDA and a device is present. */
+  static bool available();
+
+  /**
+   * Copies the synapses to the device. Each column must have one segment,
+   * with the index of the column, as in the SpatialPooler.
+   */
+  SpatialPoolerGpu(Connections &connections, UInt numInputs, UInt numColumns);
+  ~SpatialPoolerGpu();
+
+  SpatialPoolerGpu(const SpatialPoolerGpu &) = delete;
+  SpatialPoolerGpu &operator=(const SpatialPoolerGpu &) = delete;
+
+  /** Is this the copy of these connections? Not after they were copied or moved. */
+  bool mirrors(const Connections &connections) const noexcept { return &connections == connections_; }
+
+  /**
+   * The connected overlaps of the input, into activity.numActiveConnected,
+   * and activity.touched the columns with a non-zero overlap.
+   */
+  void computeOverlaps(const std::vector<UInt> &activeInputs, SegmentActivity &activity);
+
+  /**
+   * SpatialPooler::inhibitColumnsGlobal() of the boosted overlaps of the last
+   * computeOverlaps(): overlap * boostFactors[column] if boost, else the overlap.
+   */
+  std::vector<CellIdx> inhibitColumnsGlobal(const std::vector<Real> &boostFactors, bool boost,
+                                            Real density, UInt stimulusThreshold);
+
+  /** The boost factors changed, upload them with the next inhibitColumnsGlobal(). */
+  void markBoostDirty() noexcept { boostDirty_ = true; }
+
+private:
+  void sync_();
+  void uploadAll_();
+
+  Connections *connections_;
+  UInt numInputs_;
+  UInt numColumns_;
+  UInt capacity_ = 0u; // potential synapses per column on the device
+  bool boostDirty_ = true;
+  gpu::SpDevice *device_ = nullptr;
+
+  // reused host buffers
+  std::vector<Segment>    changed_;
+  std::vector<UInt32>     columns_;
+  std::vector<UInt32>     presyn_;
+  std::vector<uint8_t>    connected_;
+  std::vector<UInt32>     count_;
+};
+
+} // namespace htm
+
+#endif // HTM_ALGORITHMS_SPATIAL_POOLER_GPU_HPP
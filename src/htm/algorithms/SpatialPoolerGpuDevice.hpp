@@ -0,0 +1,64 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * The device side of SpatialPoolerGpu, implemented in SpatialPoolerGpu.cu.
+ * Internal, include SpatialPoolerGpu.hpp.
+ */
+
+#ifndef HTM_ALGORITHMS_SPATIAL_POOLER_GPU_DEVICE_HPP
+#define HTM_ALGORITHMS_SPATIAL_POOLER_GPU_DEVICE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <htm/types/Types.hpp>
+
+namespace htm {
+namespace gpu {
+
+struct SpDevice;
+
+bool deviceAvailable();
+
+SpDevice *create(UInt32 numInputs, UInt32 numColumns, UInt32 capacity);
+void destroy(SpDevice *device);
+
+/** All columns, slot j of column c at j * numColumns + c. */
+void uploadAll(SpDevice *device, const UInt32 *presyn, const uint8_t *connected, const UInt32 *count);
+
+/** Some columns, column columns[i] at [i * capacity, i * capacity + count[i]). */
+void uploadColumns(SpDevice *device, UInt32 n, const UInt32 *columns,
+                   const UInt32 *presyn, const uint8_t *connected, const UInt32 *count);
+
+void uploadBoostFactors(SpDevice *device, const Real *boostFactors);
+
+/** Connected overlaps of the active inputs, per column, into overlaps (host). */
+void computeOverlaps(SpDevice *device, UInt32 numActive, const UInt32 *active, UInt16 *overlaps);
+
+/**
+ * Winners of the global inhibition of the last computeOverlaps(), into winners
+ * (host, numDesired entries), by decreasing boosted overlap then index.
+ * @returns the number of winners, at most numDesired.
+ */
+UInt32 inhibitGlobal(SpDevice *device, bool boost, Real stimulusThreshold, UInt32 numDesired,
+                     UInt32 *winners);
+
+} // namespace gpu
+} // namespace htm
+
+#endif // HTM_ALGORITHMS_SPATIAL_POOLER_GPU_DEVICE_HPP
@@ -0,0 +1,110 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the SpatialPoolerIncremental class
+ */
+
+#include <htm/algorithms/SpatialPoolerIncremental.hpp>
+
+#include <algorithm>
+
+#include <htm/utils/Log.hpp>
+
+using namespace htm;
+
+
+SpatialPoolerIncremental::SpatialPoolerIncremental(Connections &connections, const UInt numInputs,
+                                                   const UInt numColumns)
+  : connections_(&connections), numInputs_(numInputs), numColumns_(numColumns),
+    overlaps_(numColumns, 0), isPrevious_(numInputs, false) {
+  NTA_CHECK(connections.numSegments() == numColumns) << "SpatialPoolerIncremental: one segment per column expected.";
+  connections.setTrackChangedSegments(true);
+  changed_.clear();
+  connections.takeChangedSegments(changed_); //nothing to recount, the previous input is empty
+}
+
+
+SynapseIdx SpatialPoolerIncremental::countColumn_(const Segment column) const {
+  SynapseIdx overlap = 0;
+  for(const auto synapse : connections_->synapsesForSegment(column)) {
+    if(connections_->isConnected(synapse) and isPrevious_[connections_->presynapticCellForSynapse(synapse)]) {
+      overlap++;
+    }
+  }
+  return overlap;
+}
+
+
+void SpatialPoolerIncremental::sync() {
+  connections_->prepareConcurrentActivity();
+  if(not connections_->takeChangedSegments(changed_)) {
+    for(Segment column = 0u; column < numColumns_; column++) overlaps_[column] = countColumn_(column);
+    return;
+  }
+  for(const Segment column : changed_) {
+    if(column < numColumns_) overlaps_[column] = countColumn_(column);
+  }
+}
+
+
+void SpatialPoolerIncremental::computeOverlaps(const SDR &input, SegmentActivity &activity) {
+  NTA_ASSERT(input.size == numInputs_);
+  // The symmetric difference of the sorted inputs.
+  const auto &sparse = input.getSparse();
+  on_.clear();
+  off_.clear();
+  std::set_difference(sparse.begin(), sparse.end(), previous_.begin(), previous_.end(), std::back_inserter(on_));
+  std::set_difference(previous_.begin(), previous_.end(), sparse.begin(), sparse.end(), std::back_inserter(off_));
+  numChanged_ = on_.size() + off_.size();
+
+  if(not on_.empty()) {
+    connections_->computeConnectedActivity(onActivity_, on_);
+    for(const auto column : onActivity_.touched) {
+      overlaps_[column] = static_cast<SynapseIdx>(overlaps_[column] + onActivity_.numActiveConnected[column]);
+    }
+  }
+  if(not off_.empty()) {
+    connections_->computeConnectedActivity(offActivity_, off_);
+    for(const auto column : offActivity_.touched) {
+      NTA_ASSERT(overlaps_[column] >= offActivity_.numActiveConnected[column]);
+      overlaps_[column] = static_cast<SynapseIdx>(overlaps_[column] - offActivity_.numActiveConnected[column]);
+    }
+  }
+  for(const auto cell : on_)  isPrevious_[cell] = true;
+  for(const auto cell : off_) isPrevious_[cell] = false;
+  previous_.assign(sparse.begin(), sparse.end());
+
+  auto &overlaps = activity.numActiveConnected;
+  overlaps.assign(overlaps_.begin(), overlaps_.end());
+  activity.touched.clear();
+  for(Segment column = 0u; column < numColumns_; column++) {
+    if(overlaps[column] > 0u) activity.touched.push_back(column);
+  }
+  activity.touchedValid = true;
+}
+
+
+size_t SpatialPoolerIncremental::memoryUsage() const {
+  const auto activityBytes = [](const SegmentActivity &a) {
+    return (a.numActiveConnected.capacity() + a.numActivePotential.capacity()) * sizeof(SynapseIdx) +
+           a.touched.capacity() * sizeof(Segment);
+  };
+  return overlaps_.capacity() * sizeof(SynapseIdx) + previous_.capacity() * sizeof(ElemSparse) +
+         isPrevious_.capacity() / 8u + (on_.capacity() + off_.capacity()) * sizeof(CellIdx) +
+         activityBytes(onActivity_) + activityBytes(offActivity_) + changed_.capacity() * sizeof(Segment);
+}
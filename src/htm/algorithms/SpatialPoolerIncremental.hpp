@@ -0,0 +1,95 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the SpatialPoolerIncremental class
+ */
+
+#ifndef HTM_ALGORITHMS_SPATIAL_POOLER_INCREMENTAL_HPP
+#define HTM_ALGORITHMS_SPATIAL_POOLER_INCREMENTAL_HPP
+
+#include <vector>
+
+#include <htm/algorithms/Connections.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * The connected overlaps of a SpatialPooler, kept from one input to the
+ * next and updated by the difference of the inputs: only the synapses of
+ * the bits which turned on (+1) or off (-1) are visited, so a compute costs
+ * in proportion to how much the input changed, not to its size.  See
+ * SpatialPooler::setIncrementalEnabled().
+ *
+ * The Connections stay the master copy: they track which columns changed
+ * while learning, which includes every synapse crossing the connected
+ * threshold (see Connections::setTrackChangedSegments()), and sync()
+ * recounts the overlaps of those with the previous input.
+ *
+ * Results are identical to Connections::computeActivity().
+ */
+class SpatialPoolerIncremental {
+public:
+  /**
+   * Starts with an empty previous input. Each column must have one
+   * segment, with the index of the column, as in the SpatialPooler.
+   */
+  SpatialPoolerIncremental(Connections &connections, UInt numInputs, UInt numColumns);
+
+  SpatialPoolerIncremental(const SpatialPoolerIncremental &) = delete;
+  SpatialPoolerIncremental &operator=(const SpatialPoolerIncremental &) = delete;
+
+  /** Are these the overlaps of these connections? Not after they were copied or moved. */
+  bool mirrors(const Connections &connections) const noexcept { return &connections == connections_; }
+
+  /** Recount the overlaps of the columns which changed since the last sync(). */
+  void sync();
+
+  /**
+   * The connected overlaps of the input, into activity.numActiveConnected,
+   * and activity.touched the columns with a non-zero overlap.  Call sync()
+   * first.  The input becomes the previous input.
+   */
+  void computeOverlaps(const SDR &input, SegmentActivity &activity);
+
+  /** Bits which turned on plus bits which turned off, in the last computeOverlaps(). */
+  size_t getNumChangedInputs() const noexcept { return numChanged_; }
+
+  /** Bytes of the state. */
+  size_t memoryUsage() const;
+
+private:
+  SynapseIdx countColumn_(Segment column) const;
+
+  Connections *connections_;
+  UInt numInputs_;
+  UInt numColumns_;
+  std::vector<SynapseIdx> overlaps_;  //with the previous input, by column
+  SDR_sparse_t previous_;             //the previous input, sorted
+  std::vector<bool> isPrevious_;      //dense previous_
+  size_t numChanged_ = 0u;
+  // reused buffers
+  std::vector<CellIdx> on_, off_;
+  SegmentActivity onActivity_, offActivity_;
+  std::vector<Segment> changed_;
+};
+
+} // namespace htm
+
+#endif // HTM_ALGORITHMS_SPATIAL_POOLER_INCREMENTAL_HPP
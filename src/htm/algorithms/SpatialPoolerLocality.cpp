@@ -0,0 +1,172 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the SpatialPoolerLocality class
+ */
+
+#include <htm/algorithms/SpatialPoolerLocality.hpp>
+
+#include <algorithm>
+#include <functional> //multiplies
+#include <numeric> //iota, accumulate
+
+#include <htm/utils/Log.hpp>
+
+using namespace htm;
+
+
+std::vector<UInt> SpatialPoolerLocality::zOrder(const std::vector<UInt> &dimensions) {
+  const UInt size = std::accumulate(dimensions.begin(), dimensions.end(), 1u, std::multiplies<UInt>());
+  std::vector<UInt> position(size);
+  std::iota(position.begin(), position.end(), 0u);
+  const size_t numAxes = dimensions.size();
+  UInt bits = 0u; //per axis
+  for(const auto dim : dimensions) {
+    while(bits < 32u and (UInt64(1u) << bits) < dim) bits++;
+  }
+  if(numAxes <= 1u or bits * numAxes > 64u) return position;
+
+  std::vector<UInt64> keys(size);
+  std::vector<UInt> coordinates(numAxes, 0u);
+  for(UInt index = 0u; index < size; index++) {
+    UInt64 key = 0u;
+    for(UInt bit = 0u; bit < bits; bit++) {
+      for(size_t axis = 0u; axis < numAxes; axis++) {
+        const UInt64 value = (coordinates[axis] >> bit) & 1u;
+        key |= value << (bit * numAxes + (numAxes - 1u - axis));
+      }
+    }
+    keys[index] = key;
+    for(size_t axis = numAxes; axis-- > 0u; ) { //next C-order coordinates
+      if(++coordinates[axis] < dimensions[axis]) break;
+      coordinates[axis] = 0u;
+    }
+  }
+  std::vector<UInt> byKey(size);
+  std::iota(byKey.begin(), byKey.end(), 0u);
+  std::sort(byKey.begin(), byKey.end(), [&keys](const UInt a, const UInt b) { return keys[a] < keys[b]; });
+  for(UInt p = 0u; p < size; p++) position[byKey[p]] = p;
+  return position;
+}
+
+
+SpatialPoolerLocality::SpatialPoolerLocality(Connections &connections,
+                                             const std::vector<UInt> &inputDimensions,
+                                             const std::vector<UInt> &columnDimensions)
+  : connections_(&connections),
+    inputPosition_(zOrder(inputDimensions)), columnPosition_(zOrder(columnDimensions)) {
+  numInputs_  = static_cast<UInt>(inputPosition_.size());
+  numColumns_ = static_cast<UInt>(columnPosition_.size());
+  NTA_CHECK(connections.numSegments() == numColumns_) << "SpatialPoolerLocality: one segment per column expected.";
+  columnAt_.resize(numColumns_);
+  for(UInt column = 0u; column < numColumns_; column++) columnAt_[columnPosition_[column]] = column;
+  connectedColumns_.resize(numInputs_);
+  connectedInputs_.resize(numColumns_);
+  counts_.assign(numColumns_, 0);
+
+  connections.setTrackChangedSegments(true);
+  connections.takeChangedSegments(changed_); //all columns are built below
+  for(UInt position = 0u; position < numColumns_; position++) syncColumn_(columnAt_[position]);
+}
+
+
+void SpatialPoolerLocality::syncColumn_(const Segment column) {
+  inputs_.clear();
+  for(const auto synapse : connections_->synapsesForSegment(column)) {
+    if(connections_->isConnected(synapse)) {
+      inputs_.push_back(inputPosition_[connections_->presynapticCellForSynapse(synapse)]);
+    }
+  }
+  std::sort(inputs_.begin(), inputs_.end());
+
+  // Only the synapses which crossed the threshold change the lists.
+  const UInt position = columnPosition_[column];
+  auto &before = connectedInputs_[column];
+  auto b = before.begin();
+  auto n = inputs_.cbegin();
+  while(b != before.end() or n != inputs_.cend()) {
+    if(n == inputs_.cend() or (b != before.end() and *b < *n)) { //disconnected
+      auto &columns = connectedColumns_[*b];
+      const auto found = std::find(columns.begin(), columns.end(), position);
+      NTA_ASSERT(found != columns.end());
+      *found = columns.back();
+      columns.pop_back();
+      ++b;
+    } else if(b == before.end() or *n < *b) { //connected
+      connectedColumns_[*n].push_back(position);
+      ++n;
+    } else {
+      ++b;
+      ++n;
+    }
+  }
+  before.assign(inputs_.begin(), inputs_.end());
+}
+
+
+void SpatialPoolerLocality::sync() {
+  if(not connections_->takeChangedSegments(changed_)) {
+    for(UInt position = 0u; position < numColumns_; position++) syncColumn_(columnAt_[position]);
+    return;
+  }
+  for(const Segment column : changed_) {
+    if(column < numColumns_) syncColumn_(column);
+  }
+}
+
+
+void SpatialPoolerLocality::computeOverlaps(const SDR &input, SegmentActivity &activity) {
+  NTA_ASSERT(input.size == numInputs_);
+  active_.clear();
+  for(const auto cell : input.getSparse()) active_.push_back(inputPosition_[cell]);
+  std::sort(active_.begin(), active_.end());
+
+  touched_.clear();
+  for(const auto cell : active_) {
+    for(const auto position : connectedColumns_[cell]) {
+      if(counts_[position]++ == 0u) touched_.push_back(position);
+    }
+  }
+
+  // Back to the columns of the SDR, resetting the counters for the next call.
+  auto &overlaps = activity.numActiveConnected;
+  if(activity.touchedValid and overlaps.size() == numColumns_) {
+    for(const auto column : activity.touched) overlaps[column] = 0;
+  } else {
+    overlaps.assign(numColumns_, 0);
+  }
+  activity.touched.clear();
+  for(const auto position : touched_) {
+    const UInt column = columnAt_[position];
+    overlaps[column] = counts_[position];
+    counts_[position] = 0;
+    activity.touched.push_back(column);
+  }
+  activity.touchedValid = true;
+}
+
+
+size_t SpatialPoolerLocality::memoryUsage() const {
+  size_t bytes = (inputPosition_.capacity() + columnPosition_.capacity() + columnAt_.capacity() +
+                  active_.capacity() + touched_.capacity() + inputs_.capacity()) * sizeof(UInt) +
+                 counts_.capacity() * sizeof(SynapseIdx) + changed_.capacity() * sizeof(Segment) +
+                 (connectedColumns_.capacity() + connectedInputs_.capacity()) * sizeof(std::vector<UInt>);
+  for(const auto &columns : connectedColumns_) bytes += columns.capacity() * sizeof(UInt);
+  for(const auto &inputs : connectedInputs_) bytes += inputs.capacity() * sizeof(UInt);
+  return bytes;
+}
@@ -0,0 +1,107 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the SpatialPoolerLocality class
+ */
+
+#ifndef HTM_ALGORITHMS_SPATIAL_POOLER_LOCALITY_HPP
+#define HTM_ALGORITHMS_SPATIAL_POOLER_LOCALITY_HPP
+
+#include <vector>
+
+#include <htm/algorithms/Connections.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * The connected synapses of a SpatialPooler with the inputs and the columns
+ * renumbered in Z-order (Morton order), see SpatialPooler::setLocalityEnabled().
+ *
+ * In the C-order of the SDRs, cells which are neighbors along an outer axis
+ * of a 2-D or 3-D topology are a whole row apart.  The potential pool of a
+ * column is a patch of inputs and the columns reached from an input are a
+ * patch of columns, so counting the overlaps jumps between rows of the
+ * column array for every synapse.  In Z-order a patch is a few runs of
+ * nearby positions: the presynaptic lists of neighboring active inputs are
+ * adjacent, and so are the counters they increment.  The input is
+ * renumbered on the way in, and only the touched columns on the way out.
+ *
+ * The Connections stay the master copy: they track which columns changed
+ * while learning (see Connections::setTrackChangedSegments()), and sync()
+ * updates the lists for the synapses of those which crossed the connected
+ * threshold.
+ *
+ * Results are identical to Connections::computeActivity().
+ */
+class SpatialPoolerLocality {
+public:
+  /**
+   * Builds the lists. Each column must have one segment, with the index of
+   * the column, as in the SpatialPooler.
+   */
+  SpatialPoolerLocality(Connections &connections, const std::vector<UInt> &inputDimensions,
+                        const std::vector<UInt> &columnDimensions);
+
+  SpatialPoolerLocality(const SpatialPoolerLocality &) = delete;
+  SpatialPoolerLocality &operator=(const SpatialPoolerLocality &) = delete;
+
+  /** Are these the lists of these connections? Not after they were copied or moved. */
+  bool mirrors(const Connections &connections) const noexcept { return &connections == connections_; }
+
+  /** Update the lists of the columns which changed since the last sync(). */
+  void sync();
+
+  /**
+   * The connected overlaps of the input, into activity.numActiveConnected,
+   * and activity.touched the columns with a non-zero overlap, in the C-order
+   * of the SDRs.  Call sync() first.
+   */
+  void computeOverlaps(const SDR &input, SegmentActivity &activity);
+
+  /** Bytes of the lists and buffers. */
+  size_t memoryUsage() const;
+
+  /**
+   * The Z-order of a topology: the position of each cell (by its C-order
+   * index) when the cells are ordered by their interleaved coordinate bits,
+   * the last axis in the lowest bit.  1-D topologies keep their order.
+   */
+  static std::vector<UInt> zOrder(const std::vector<UInt> &dimensions);
+
+private:
+  void syncColumn_(Segment column);
+
+  Connections *connections_;
+  UInt numInputs_;
+  UInt numColumns_;
+  std::vector<UInt> inputPosition_;   //by input
+  std::vector<UInt> columnPosition_;  //by column
+  std::vector<UInt> columnAt_;        //by column position, the column
+  std::vector<std::vector<UInt>> connectedColumns_; //by input position, the column positions connected to it
+  std::vector<std::vector<UInt>> connectedInputs_;  //by column, its connected input positions, sorted
+  std::vector<SynapseIdx> counts_;    //by column position, zero between the calls
+  // reused buffers
+  std::vector<UInt> active_, touched_, inputs_;
+  std::vector<Segment> changed_;
+};
+
+} // namespace htm
+
+#endif // HTM_ALGORITHMS_SPATIAL_POOLER_LOCALITY_HPP
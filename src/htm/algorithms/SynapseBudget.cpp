@@ -0,0 +1,142 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the SynapseBudget class
+ */
+
+#include <htm/algorithms/SynapseBudget.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace htm;
+
+namespace {
+std::mutex processBudgetMutex_;
+std::shared_ptr<SynapseBudget> processBudget_;
+} // namespace
+
+
+SynapseBudget::SynapseBudget(size_t maxSynapses, UInt32 periodMs)
+  : maxSynapses_(maxSynapses), periodMs_(periodMs) {
+  if(periodMs_ == 0u) return;
+  thread_ = std::thread([this]() { run_(); });
+#if defined(__linux__)
+  // The pruner only reads a few counters, it must not take CPU from the models.
+  sched_param param{};
+  param.sched_priority = 0;
+  pthread_setschedparam(thread_.native_handle(), SCHED_IDLE, &param); // best effort
+#endif
+}
+
+
+SynapseBudget::~SynapseBudget() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  if(thread_.joinable()) thread_.join();
+}
+
+
+std::shared_ptr<SynapseBudget::Member> SynapseBudget::attach() {
+  auto member = std::make_shared<Member>();
+  std::lock_guard<std::mutex> lock(mutex_);
+  members_.push_back(member);
+  return member;
+}
+
+
+void SynapseBudget::rebalance() {
+  std::vector<std::shared_ptr<Member>> members;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    members_.erase(std::remove_if(members_.begin(), members_.end(),
+                                  [](const std::weak_ptr<Member> &m) { return m.expired(); }),
+                   members_.end());
+    for(const auto &weak : members_) {
+      if(auto member = weak.lock()) members.push_back(std::move(member));
+    }
+  }
+
+  std::vector<size_t> synapses(members.size());
+  size_t total = 0u;
+  for(size_t i = 0u; i < members.size(); i++) {
+    synapses[i] = members[i]->synapses.load(std::memory_order_relaxed);
+    total += synapses[i];
+  }
+  numModels_ = members.size();
+  numSynapses_ = total;
+
+  const size_t unlimited = std::numeric_limits<size_t>::max();
+  const size_t budget = maxSynapses_;
+  if(total <= budget or members.empty()) {
+    for(const auto &member : members) member->target.store(unlimited, std::memory_order_relaxed);
+    return;
+  }
+
+  // The excess is taken from the models over their fair share, in proportion
+  // to how far over they are. The overs sum to at least the excess, so no
+  // model goes below its fair share.
+  const size_t fairShare = budget / members.size();
+  const size_t excess = total - budget;
+  double sumOver = 0.0;
+  for(const size_t n : synapses) {
+    if(n > fairShare) sumOver += static_cast<double>(n - fairShare);
+  }
+  for(size_t i = 0u; i < members.size(); i++) {
+    size_t target = unlimited;
+    if(synapses[i] > fairShare) {
+      const double over = static_cast<double>(synapses[i] - fairShare);
+      const auto prune  = static_cast<size_t>(std::ceil(excess * over / sumOver));
+      target = synapses[i] - std::min(prune, synapses[i] - fairShare);
+    }
+    members[i]->target.store(target, std::memory_order_relaxed);
+  }
+}
+
+
+void SynapseBudget::run_() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while(not stop_) {
+    wake_.wait_for(lock, std::chrono::milliseconds(periodMs_));
+    if(stop_) break;
+    lock.unlock();
+    rebalance();
+    lock.lock();
+  }
+}
+
+
+void SynapseBudget::setProcessBudget(std::shared_ptr<SynapseBudget> budget) {
+  std::lock_guard<std::mutex> lock(processBudgetMutex_);
+  processBudget_ = std::move(budget);
+}
+
+
+std::shared_ptr<SynapseBudget> SynapseBudget::getProcessBudget() {
+  std::lock_guard<std::mutex> lock(processBudgetMutex_);
+  return processBudget_;
+}
@@ -0,0 +1,123 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the SynapseBudget class
+ */
+
+#ifndef HTM_ALGORITHMS_SYNAPSE_BUDGET_HPP
+#define HTM_ALGORITHMS_SYNAPSE_BUDGET_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * A limit on the number of synapses of many models together, e.g. of all the
+ * TemporalMemories served by one process.
+ *
+ * Example:
+ *     auto budget = std::make_shared<SynapseBudget>(50000000u);
+ *     for(auto &tm : models) tm.setSynapseBudget(budget);
+ *
+ * Each Connections attached to the budget (see Connections::setSynapseBudget())
+ * publishes its number of synapses. A background thread wakes up every
+ * `periodMs`, and when the sum is over the budget it gives the models which
+ * are over their fair share (the budget / number of models) a target, the
+ * furthest over the lowest one. A model is never asked to go below its fair
+ * share.
+ *
+ * The pruning itself is done by the model, at the start of its next learning
+ * `computeActivity()`, so the background thread never touches a model while
+ * it computes, and a compute never waits for the pruner or for another model.
+ * See Connections::setSynapseBudget() for what is pruned.
+ *
+ * A byte budget can be converted with the bytes per synapse of
+ * Connections::memoryUsage().
+ */
+class SynapseBudget {
+public:
+  /**
+   * @param maxSynapses - of all attached models together.
+   * @param periodMs - how often the targets are recomputed, 0 does not start
+   *   the background thread, then call rebalance().
+   */
+  explicit SynapseBudget(size_t maxSynapses, UInt32 periodMs = 100u);
+  ~SynapseBudget();
+
+  SynapseBudget(const SynapseBudget&) = delete;
+  SynapseBudget &operator=(const SynapseBudget&) = delete;
+
+  void setMaxSynapses(size_t maxSynapses) noexcept { maxSynapses_ = maxSynapses; }
+  size_t getMaxSynapses() const noexcept { return maxSynapses_; }
+
+  /** Most synapses one model may prune in one compute, default 100000. */
+  void setMaxPrunePerCompute(size_t n) noexcept { maxPrunePerCompute_ = n; }
+  size_t getMaxPrunePerCompute() const noexcept { return maxPrunePerCompute_; }
+
+  /** Recompute the targets now, what the background thread does every period. */
+  void rebalance();
+
+  /** Number of attached models, as of the last rebalance(). */
+  size_t numModels() const noexcept { return numModels_; }
+
+  /** Synapses of all attached models, as published at the last rebalance(). */
+  size_t numSynapses() const noexcept { return numSynapses_; }
+
+  /**
+   * The budget which the algorithm regions (SPRegion, TMRegion) attach to
+   * when initialized or loaded, nullptr (default) for none.
+   */
+  static void setProcessBudget(std::shared_ptr<SynapseBudget> budget);
+  static std::shared_ptr<SynapseBudget> getProcessBudget();
+
+  /** What a model shares with the budget, see Connections::setSynapseBudget(). */
+  struct Member {
+    std::atomic<size_t> synapses{0u};
+    std::atomic<size_t> target{std::numeric_limits<size_t>::max()};
+  };
+
+  /** Attach a model. It stays attached while the returned Member lives. */
+  std::shared_ptr<Member> attach();
+
+private:
+  void run_();
+
+  std::atomic<size_t> maxSynapses_;
+  std::atomic<size_t> maxPrunePerCompute_{100000u};
+  std::atomic<size_t> numModels_{0u};
+  std::atomic<size_t> numSynapses_{0u};
+  const UInt32        periodMs_;
+
+  std::mutex                          mutex_;
+  std::condition_variable             wake_;
+  bool                                stop_ = false;
+  std::vector<std::weak_ptr<Member>>  members_;
+  std::thread                         thread_;
+};
+
+} // namespace htm
+
+#endif // HTM_ALGORITHMS_SYNAPSE_BUDGET_HPP
@@ -29,20 +29,22 @@
  */
 
 #include <algorithm> //is_sorted
+#include <array>
+#include <limits>
 #include <climits>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <sstream>
 #include <string>
 #include <vector>
-#include <set>
 
 
 #include <htm/algorithms/TemporalMemory.hpp>
 
-#include <htm/utils/GroupBy.hpp>
 #include <htm/algorithms/Anomaly.hpp>
+#include <htm/os/Probe.hpp>
 
 using namespace std;
 using namespace htm;
@@ -118,6 +120,7 @@ void TemporalMemory::initialize(
 
   
   cellsPerColumn_ = cellsPerColumn; //TODO add checks
+  updateColumnShift_();
   activationThreshold_ = activationThreshold;
   initialPermanence_ = initialPermanence;
   connectedPermanence_ = connectedPermanence;
@@ -144,6 +147,27 @@ void TemporalMemory::initialize(
 CellIdx TemporalMemory::getLeastUsedCell_(const CellIdx column) {
   if(cellsPerColumn_ == 1) return column;
 
+  if(singlePassLeastUsedCell_) {
+    // Reservoir sampling over the cells with the fewest segments: the k-th tie
+    // replaces the choice with probability 1/k, so each tie is equally likely.
+    const CellIdx first = column * cellsPerColumn_;
+    CellIdx leastUsed   = first;
+    size_t  fewest      = connections.numSegments(first);
+    UInt32  numTies     = 1u;
+    for(CellIdx cell = first + 1u; cell < first + cellsPerColumn_; cell++) {
+      const size_t numSegments = connections.numSegments(cell);
+      if(numSegments < fewest) {
+        leastUsed = cell;
+        fewest    = numSegments;
+        numTies   = 1u;
+      }
+      else if(numSegments == fewest and rng_.getUInt32(++numTies) == 0u) {
+        leastUsed = cell;
+      }
+    }
+    return leastUsed;
+  }
+
   vector<CellIdx> cells = cellsForColumn(column);
 
   //TODO: decide if we need to choose randomly from the "least used" cells, or if 1st is fine. 
@@ -160,11 +184,37 @@ CellIdx TemporalMemory::getLeastUsedCell_(const CellIdx column) {
 }
 
 
+void TemporalMemory::adaptSegment_(const Segment segment,
+                                   const SDR &prevActiveCells,
+                                   const Permanence increment,
+                                   const Permanence decrement) {
+  if(nextAdaptation_ < adaptations_.size()) { //parallel learning, the permanences are done
+    const auto &adaptation = adaptations_[nextAdaptation_++];
+    NTA_ASSERT(adaptation.segment == segment);
+    connections_.finishAdaptSegment(adaptation, true, minThreshold_);
+    return;
+  }
+  connections_.adaptSegment(segment, prevActiveCells, increment, decrement, true, minThreshold_);
+}
+
+
+vector<Segment>::const_iterator TemporalMemory::bestMatchingSegment_(
+    vector<Segment>::const_iterator columnMatchingSegmentsBegin,
+    vector<Segment>::const_iterator columnMatchingSegmentsEnd) const {
+  return std::max_element(columnMatchingSegmentsBegin, columnMatchingSegmentsEnd,
+                          [&](Segment a, Segment b) {
+                            return (segmentActivity_.numActivePotential[a] <
+                                    segmentActivity_.numActivePotential[b]);
+                          });
+}
+
+
 void TemporalMemory::activatePredictedColumn_(
     vector<Segment>::const_iterator columnActiveSegmentsBegin,
     vector<Segment>::const_iterator columnActiveSegmentsEnd,
     const SDR &prevActiveCells,
     const vector<CellIdx> &prevWinnerCells,
+    const vector<CellIdx> &prevExternalWinners,
     const bool learn) {
 
   auto activeSegment = columnActiveSegmentsBegin;
@@ -176,14 +226,14 @@ void TemporalMemory::activatePredictedColumn_(
     // This cell might have multiple active segments.
     do {
       if (learn) { 
-        connections_.adaptSegment(*activeSegment, prevActiveCells,
-                     permanenceIncrement_, permanenceDecrement_, true, minThreshold_);
+        adaptSegment_(*activeSegment, prevActiveCells, permanenceIncrement_, permanenceDecrement_);
 
         const Int32 nGrowDesired =
             static_cast<Int32>(maxNewSynapseCount_) -
-            numActivePotentialSynapsesForSegment_[*activeSegment];
+            segmentActivity_.numActivePotential[*activeSegment];
         if (nGrowDesired > 0) {
-          connections_.growSynapses(*activeSegment, prevWinnerCells, initialPermanence_, rng_, nGrowDesired, maxSynapsesPerSegment_);
+          connections_.growSynapses(*activeSegment, prevWinnerCells, prevExternalWinners, static_cast<CellIdx>(numberOfCells()),
+                                    initialPermanence_, rng_, nGrowDesired, maxSynapsesPerSegment_);
         }
       }
     } while (++activeSegment != columnActiveSegmentsEnd &&
@@ -198,23 +248,19 @@ void TemporalMemory::burstColumn_(
             vector<Segment>::const_iterator columnMatchingSegmentsEnd,
             const SDR &prevActiveCells,
             const vector<CellIdx> &prevWinnerCells,
+            const vector<CellIdx> &prevExternalWinners,
             const bool learn) {
 
   // Calculate the active cells: active become ALL the cells in this mini-column
   const auto newCells = cellsForColumn(column);
   activeCells_.insert(activeCells_.end(), newCells.begin(), newCells.end());
 
-  const auto bestMatchingSegment =
-      std::max_element(columnMatchingSegmentsBegin, columnMatchingSegmentsEnd,
-                       [&](Segment a, Segment b) {
-                         return (numActivePotentialSynapsesForSegment_[a] <
-                                 numActivePotentialSynapsesForSegment_[b]);
-                       });
+  const auto bestMatchingSegment = bestMatchingSegment_(columnMatchingSegmentsBegin, columnMatchingSegmentsEnd);
 
   const CellIdx winnerCell =
       (bestMatchingSegment != columnMatchingSegmentsEnd)
           ? connections.cellForSegment(*bestMatchingSegment)
-          : getLeastUsedCell_(column); //TODO replace (with random?) this is extremely costly, removing makes TM 6x faster!
+          : getLeastUsedCell_(column); //see setSinglePassLeastUsedCell()
 
   winnerCells_.push_back(winnerCell);
 
@@ -222,12 +268,12 @@ void TemporalMemory::burstColumn_(
   if (learn) {
     if (bestMatchingSegment != columnMatchingSegmentsEnd) {
       // Learn on the best matching segment.
-      connections_.adaptSegment(*bestMatchingSegment, prevActiveCells,
-                   permanenceIncrement_, permanenceDecrement_, true, minThreshold_); //TODO consolidate SP.stimulusThreshold_ & TM.minThreshold_ into Conn.stimulusThreshold ? (replacing segmentThreshold arg used in some methods in Conn) 
+      adaptSegment_(*bestMatchingSegment, prevActiveCells, permanenceIncrement_, permanenceDecrement_); //TODO consolidate SP.stimulusThreshold_ & TM.minThreshold_ into Conn.stimulusThreshold ? (replacing segmentThreshold arg used in some methods in Conn) 
 
-      const Int32 nGrowDesired = maxNewSynapseCount_ - numActivePotentialSynapsesForSegment_[*bestMatchingSegment];
+      const Int32 nGrowDesired = maxNewSynapseCount_ - segmentActivity_.numActivePotential[*bestMatchingSegment];
       if (nGrowDesired > 0) {
-        connections_.growSynapses(*bestMatchingSegment, prevWinnerCells, initialPermanence_, rng_, nGrowDesired, maxSynapsesPerSegment_);
+        connections_.growSynapses(*bestMatchingSegment, prevWinnerCells, prevExternalWinners, static_cast<CellIdx>(numberOfCells()),
+                                  initialPermanence_, rng_, nGrowDesired, maxSynapsesPerSegment_);
       }
     } else {
       // No matching segments.
@@ -235,12 +281,13 @@ void TemporalMemory::burstColumn_(
 
       // Don't grow a segment that will never match.
       const UInt32 nGrowExact =
-          std::min(static_cast<UInt32>(maxNewSynapseCount_), static_cast<UInt32>(prevWinnerCells.size()));
+          std::min(static_cast<UInt32>(maxNewSynapseCount_), static_cast<UInt32>(prevWinnerCells.size() + prevExternalWinners.size()));
       if (nGrowExact > 0) {
         const Segment segment =
             connections_.createSegment(winnerCell, maxSegmentsPerCell_);
 
-        connections_.growSynapses(segment, prevWinnerCells, initialPermanence_, rng_, nGrowExact, maxSynapsesPerSegment_);
+        connections_.growSynapses(segment, prevWinnerCells, prevExternalWinners, static_cast<CellIdx>(numberOfCells()),
+                                  initialPermanence_, rng_, nGrowExact, maxSynapsesPerSegment_);
         NTA_ASSERT(connections.numSynapses(segment) == nGrowExact);
       }
     }
@@ -255,13 +302,56 @@ void TemporalMemory::punishPredictedColumn_(
   if (predictedSegmentDecrement_ > 0.0) {
     for (auto matchingSegment = columnMatchingSegmentsBegin;
          matchingSegment != columnMatchingSegmentsEnd; matchingSegment++) {
-      connections_.adaptSegment(*matchingSegment, prevActiveCells,
-                   -predictedSegmentDecrement_, 0.0, true, minThreshold_);
+      adaptSegment_(*matchingSegment, prevActiveCells, -predictedSegmentDecrement_, 0.0f);
     }
   }
 }
 
+using SegmentIter = vector<Segment>::const_iterator;
+
+template<typename Visit>
+void TemporalMemory::forEachColumn_(const vector<CellIdx> &activeColumns, Visit &&visit) const {
+  constexpr UInt NONE = std::numeric_limits<UInt>::max();
+  const auto columnOf = [&](const SegmentIter segment, const SegmentIter end) -> UInt {
+    return segment == end ? NONE : columnForCell(connections.cellForSegment(*segment));
+  };
+
+  auto column = activeColumns.cbegin();
+  SegmentIter active   = activeSegments_.cbegin();
+  SegmentIter matching = matchingSegments_.cbegin();
+  UInt activeColumn   = columnOf(active,   activeSegments_.cend());
+  UInt matchingColumn = columnOf(matching, matchingSegments_.cend());
+  while (true) {
+    const UInt nextActive = column == activeColumns.cend() ? NONE : static_cast<UInt>(*column);
+    const UInt current = std::min(nextActive, std::min(activeColumn, matchingColumn));
+    if (current == NONE) break;
+
+    const bool isActiveColumn = nextActive == current;
+    if (isActiveColumn) ++column;
+    const SegmentIter activeBegin = active;
+    while (activeColumn == current) {
+      activeColumn = columnOf(++active, activeSegments_.cend());
+    }
+    const SegmentIter matchingBegin = matching;
+    while (matchingColumn == current) {
+      matchingColumn = columnOf(++matching, matchingSegments_.cend());
+    }
+    visit(current, isActiveColumn, activeBegin, active, matchingBegin, matching);
+  }
+}
+
+
 void TemporalMemory::activateCells(const SDR &activeColumns, const bool learn) {
+  activateCells_(activeColumns, learn, externalActive_, externalWinners_);
+  externalActive_.clear();
+  externalWinners_.clear();
+}
+
+
+void TemporalMemory::activateCells_(const SDR &activeColumns, const bool learn,
+                                    const vector<CellIdx> &externalActive,
+                                    const vector<CellIdx> &externalWinners) {
+    HTM_PROBE("TemporalMemory::activateCells");
     NTA_CHECK(columnDimensions_.size() > 0) << "TM constructed using the default TM() constructor, which may only be used for serialization. "
 	    << "Use TM constructor where you provide at least column dimensions, eg: TM tm({32});";
 
@@ -273,59 +363,74 @@ void TemporalMemory::activateCells(const SDR &activeColumns, const bool learn) {
     }
     auto &sparse = activeColumns.getSparse();
 
-  SDR prevActiveCells({static_cast<CellIdx>(numberOfCells() + externalPredictiveInputs_)});
-  prevActiveCells.setSparse(activeCells_);
+  SDR::Scratch prevActive({static_cast<CellIdx>(numberOfCells() + externalPredictiveInputs_)});
+  SDR &prevActiveCells = *prevActive;
+  if (learn) {
+    // Only learning reads prevActiveCells, adaptSegment() as a dense array of
+    // all the presynaptic cells, so the external ones are added here.
+    const CellIdx offset = static_cast<CellIdx>(numberOfCells());
+    for (const auto active : externalActive)
+      activeCells_.push_back(active + offset);
+  }
+  prevActiveCells.setSparse(activeCells_); // swaps, activeCells_ gets the scratch buffer
   activeCells_.clear();
 
   const vector<CellIdx> prevWinnerCells = std::move(winnerCells_);
 
-  //maps segment S to a new segment that is at start of a column where
-  //S belongs. 
-  //for 3 cells per columns: 
-  //s1_1, s1_2, s1_3, s2_1, s2_2, s2_3, ...
-  //columnForSegment (for short here CFS)
-  //CFS(s1_1) = s1_1 = "start of column 1"
-  //CFS(s1_2) = s1_1
-  //CFS(s1_3) = s1_1
-  //CFS(s2_1) = s2_1 = "column 2"
-  //CFS(s2_2) = s2_1
-  //...
-  const auto toColumns = [&](const Segment segment) {
-    return connections.cellForSegment(segment) / cellsPerColumn_;
-  };
-  const auto identity = [](const ElemSparse a) {return a;}; //TODO use std::identity when c++20
-
-  for (auto &&columnData : groupBy( //group by columns, and convert activeSegments & matchingSegments to cols. 
-           sparse, identity,
-           activeSegments_,   toColumns,
-           matchingSegments_, toColumns)) {
-
-    Segment column; //we say "column", but it's the first segment of n-segments/cells that belong to the column
-    vector<Segment>::const_iterator activeColumnsBegin, activeColumnsEnd, 
-	                            columnActiveSegmentsBegin, columnActiveSegmentsEnd, 
-                                    columnMatchingSegmentsBegin, columnMatchingSegmentsEnd;
-
-    // for column in activeColumns (the 'sparse' above):
-    //   get its active segments ( >= connectedThr)
-    //   get its matching segs   ( >= TODO
-    std::tie(column, 
-             activeColumnsBegin, activeColumnsEnd, 
-             columnActiveSegmentsBegin, columnActiveSegmentsEnd, 
-             columnMatchingSegmentsBegin, columnMatchingSegmentsEnd
-	) = columnData;
-
-    const bool isActiveColumn = activeColumnsBegin != activeColumnsEnd;
+  // Parallel learning: collect all adaptSegment() calls of this step in the
+  // order the column loop below makes them and adapt the permanences at once.
+  // The segments belong to distinct columns and none of them is touched by the
+  // structural changes of other columns, so this is equivalent to the serial loop.
+  adaptations_.clear();
+  nextAdaptation_ = 0u;
+  if (learn and connections_.getNumThreads() > 1u) {
+    const auto addAdaptation = [&](const Segment segment, const Permanence increment, const Permanence decrement) {
+      adaptations_.push_back({segment, increment, decrement, {}, {}, {}});
+    };
+    forEachColumn_(sparse, [&](const UInt, const bool isActiveColumn,
+                               const SegmentIter columnActiveSegmentsBegin, const SegmentIter columnActiveSegmentsEnd,
+                               const SegmentIter columnMatchingSegmentsBegin, const SegmentIter columnMatchingSegmentsEnd) {
+      if (isActiveColumn) {
+        if (columnActiveSegmentsBegin != columnActiveSegmentsEnd) {
+          for (auto segment = columnActiveSegmentsBegin; segment != columnActiveSegmentsEnd; segment++) {
+            addAdaptation(*segment, permanenceIncrement_, permanenceDecrement_);
+          }
+        } else if (columnMatchingSegmentsBegin != columnMatchingSegmentsEnd) {
+          addAdaptation(*bestMatchingSegment_(columnMatchingSegmentsBegin, columnMatchingSegmentsEnd),
+                        permanenceIncrement_, permanenceDecrement_);
+        }
+      } else if (predictedSegmentDecrement_ > 0.0) {
+        for (auto segment = columnMatchingSegmentsBegin; segment != columnMatchingSegmentsEnd; segment++) {
+          addAdaptation(*segment, -predictedSegmentDecrement_, 0.0f);
+        }
+      }
+    });
+    connections_.prepareAdaptSegments(adaptations_, prevActiveCells, true);
+  }
+
+  // Counted for the raw anomaly, see calculateAnomalyScore_().
+  numActiveColumns_   = 0u;
+  numBurstingColumns_ = 0u;
+
+  // for column in activeColumns (the 'sparse' above) and the predicted ones:
+  //   get its active segments ( >= connectedThr)
+  //   get its matching segs   ( >= TODO
+  forEachColumn_(sparse, [&](const UInt column, const bool isActiveColumn,
+                             const SegmentIter columnActiveSegmentsBegin, const SegmentIter columnActiveSegmentsEnd,
+                             const SegmentIter columnMatchingSegmentsBegin, const SegmentIter columnMatchingSegmentsEnd) {
     if (isActiveColumn) { //current active column...
+      numActiveColumns_++;
       if (columnActiveSegmentsBegin != columnActiveSegmentsEnd) {
 	//...was also predicted -> learn :o)
         activatePredictedColumn_(
             columnActiveSegmentsBegin, columnActiveSegmentsEnd,
-            prevActiveCells, prevWinnerCells, learn);
+            prevActiveCells, prevWinnerCells, externalWinners, learn);
       } else {
 	//...has not been predicted -> 
+        numBurstingColumns_++;
         burstColumn_(column,
                      columnMatchingSegmentsBegin, columnMatchingSegmentsEnd,
-                     prevActiveCells, prevWinnerCells, 
+                     prevActiveCells, prevWinnerCells, externalWinners,
 		     learn);
       }
 
@@ -334,14 +439,16 @@ void TemporalMemory::activateCells(const SDR &activeColumns, const bool learn) {
         punishPredictedColumn_(columnMatchingSegmentsBegin, columnMatchingSegmentsEnd, prevActiveCells);
       }
     } //else: not predicted & not active -> no activity -> does not show up at all
-  }
+  });
+  NTA_ASSERT(nextAdaptation_ == adaptations_.size());
+  adaptations_.clear();
+  nextAdaptation_ = 0u;
   segmentsValid_ = false;
 }
 
 
-void TemporalMemory::activateDendrites(const bool learn,
-                                       const SDR &externalPredictiveInputsActive,
-                                       const SDR &externalPredictiveInputsWinners)
+void TemporalMemory::checkExternalInputs_(const SDR &externalPredictiveInputsActive,
+                                          const SDR &externalPredictiveInputsWinners) const
 {
     if( externalPredictiveInputs_ > 0 )
     {
@@ -349,9 +456,9 @@ void TemporalMemory::activateDendrites(const bool learn,
         NTA_CHECK( externalPredictiveInputsWinners.size == externalPredictiveInputs_ );
 	NTA_CHECK( externalPredictiveInputsActive.dimensions == externalPredictiveInputsWinners.dimensions);
 #ifdef NTA_ASSERTIONS_ON
-  SDR both(externalPredictiveInputsActive.dimensions);
-  both.intersection(externalPredictiveInputsActive, externalPredictiveInputsWinners);
-  NTA_ASSERT(both == externalPredictiveInputsWinners) << "externalPredictiveInputsWinners must be a subset of externalPredictiveInputsActive";
+  SDR::Scratch both(externalPredictiveInputsActive.dimensions);
+  both->intersection(externalPredictiveInputsActive, externalPredictiveInputsWinners);
+  NTA_ASSERT(*both == externalPredictiveInputsWinners) << "externalPredictiveInputsWinners must be a subset of externalPredictiveInputsActive";
 #endif
     }
     else
@@ -359,54 +466,110 @@ void TemporalMemory::activateDendrites(const bool learn,
         NTA_CHECK( externalPredictiveInputsActive.getSum() == 0u && externalPredictiveInputsWinners.getSum() == 0u )
             << "External predictive inputs must be declared to TM constructor!";
     }
+}
 
 
+void TemporalMemory::activateDendrites(const bool learn,
+                                       const SDR &externalPredictiveInputsActive,
+                                       const SDR &externalPredictiveInputsWinners)
+{
+  checkExternalInputs_(externalPredictiveInputsActive, externalPredictiveInputsWinners);
   if( segmentsValid_ )
     return;
 
-  for(const auto &active : externalPredictiveInputsActive.getSparse()) {
-      NTA_ASSERT( active < externalPredictiveInputs_ );
-      activeCells_.push_back( static_cast<CellIdx>(active + numberOfCells()) ); 
-  }
-  for(const auto &winner : externalPredictiveInputsWinners.getSparse()) {
-      NTA_ASSERT( winner < externalPredictiveInputs_ );
-      winnerCells_.push_back( static_cast<CellIdx>(winner + numberOfCells()) );
-  }
+  // Kept for activateCells(), compute() passes the SDRs on instead.
+  externalActive_  = externalPredictiveInputsActive.getSparse();
+  externalWinners_ = externalPredictiveInputsWinners.getSparse();
+  activateDendrites_(learn, externalActive_);
+}
 
-  const size_t length = connections.segmentFlatListLength();
 
-  numActivePotentialSynapsesForSegment_.assign(length, 0);
-  numActiveConnectedSynapsesForSegment_ = connections_.computeActivity(
-                              numActivePotentialSynapsesForSegment_,
-                              activeCells_,
-			      learn);
+void TemporalMemory::activateDendrites_(const bool learn, const vector<CellIdx> &externalActive) {
+  HTM_PROBE("TemporalMemory::activateDendrites");
+  // The external inputs are the presynaptic cells after this TM's cells.
+  connections_.computeActivity(segmentActivity_, activeCells_, externalActive,
+                               static_cast<CellIdx>(numberOfCells()), learn);
 
-  // Active segments, connected synapses.
-  activeSegments_.clear();
-  for (size_t segment = 0; segment < numActiveConnectedSynapsesForSegment_.size(); segment++) {
-    if (numActiveConnectedSynapsesForSegment_[segment] >= activationThreshold_) { //TODO move to SegmentData.numConnected?
-      activeSegments_.push_back(static_cast<UInt>(segment));
-    }
-  }
-  const auto compareSegments = [&](const Segment a, const Segment b) { return connections.compareSegments(a, b); };
-  std::sort( activeSegments_.begin(), activeSegments_.end(), compareSegments); //SDR requires sorted when constructed from activeSegments_
+  // Active segments (connected synapses) & matching segments (potential synapses).
+  Connections::filterSegmentsByActivity(segmentActivity_.numActiveConnected, activationThreshold_,
+                                        segmentActivity_.numActivePotential, minThreshold_,
+                                        activeSegments_, matchingSegments_);
+  sortSegmentsByCell_(activeSegments_); //SDR requires sorted when constructed from activeSegments_
   // Update segment bookkeeping.
   if (learn) {
     for (const auto segment : activeSegments_) {
-      connections_.dataForSegment(segment).lastUsed = connections.iteration(); //TODO the destroySegments based on LRU is expensive. Better random? or "energy" based on sum permanences?
+      connections_.dataForSegment(segment).lastUsed = connections.iteration(); //for the LRU segment eviction, see setSegmentEviction()
     }
   }
 
-  // Matching segments, potential synapses.
-  matchingSegments_.clear();
-  for (size_t segment = 0; segment < numActivePotentialSynapsesForSegment_.size(); segment++) {
-    if (numActivePotentialSynapsesForSegment_[segment] >= minThreshold_) {
-      matchingSegments_.push_back(static_cast<UInt>(segment));
+  sortSegmentsByCell_(matchingSegments_);
+
+  updatePredictiveCells_();
+  segmentsValid_ = true;
+}
+
+
+void TemporalMemory::sortSegmentsByCell_(vector<Segment> &segments) {
+  // filterSegmentsByActivity() lists the segments in ascending order, which
+  // on each cell is the order of creation (segments are only appended, and
+  // compact() keeps it), the tie break of compareSegments().
+  NTA_ASSERT(std::is_sorted(segments.cbegin(), segments.cend()));
+  const size_t n = segments.size();
+  auto &cells = sortCells_;
+  cells.resize(n);
+  for(size_t i = 0; i < n; i++) cells[i] = connections.cellForSegment(segments[i]);
+
+  if(n <= 32u) { //insertion sort, stable
+    for(size_t i = 1; i < n; i++) {
+      const CellIdx cell = cells[i];
+      const Segment segment = segments[i];
+      size_t j = i;
+      for( ; j > 0 and cells[j - 1] > cell; j--) {
+        cells[j] = cells[j - 1];
+        segments[j] = segments[j - 1];
+      }
+      cells[j] = cell;
+      segments[j] = segment;
+    }
+  } else { //LSD radix sort, 8 bits of the cell per pass
+    sortCellsScratch_.resize(n);
+    sortSegmentsScratch_.resize(n);
+    const CellIdx maxCell = static_cast<CellIdx>(numberOfCells());
+    for(UInt shift = 0; shift < 32u and (maxCell >> shift) > 0u; shift += 8u) {
+      std::array<size_t, 257> begin{};
+      for(const auto cell : cells) begin[((cell >> shift) & 0xFFu) + 1u]++;
+      if(std::find(begin.cbegin() + 1, begin.cend(), n) != begin.cend()) continue; //one digit: already in order
+      for(size_t d = 0; d < 256u; d++) begin[d + 1u] += begin[d];
+      for(size_t i = 0; i < n; i++) {
+        const size_t to = begin[(cells[i] >> shift) & 0xFFu]++;
+        sortCellsScratch_[to]    = cells[i];
+        sortSegmentsScratch_[to] = segments[i];
+      }
+      cells.swap(sortCellsScratch_);
+      segments.swap(sortSegmentsScratch_);
     }
   }
-  std::sort( matchingSegments_.begin(), matchingSegments_.end(), compareSegments);
+  NTA_ASSERT(std::is_sorted(segments.cbegin(), segments.cend(),
+    [&](const Segment a, const Segment b) { return connections.compareSegments(a, b); }));
+}
 
-  segmentsValid_ = true;
+
+void TemporalMemory::updatePredictiveCells_() {
+  if( predictiveCells_.size != numberOfCells() ) {
+    auto correctDims = getColumnDimensions();
+    correctDims.push_back(static_cast<CellIdx>(getCellsPerColumn()));
+    predictiveCells_.initialize(correctDims);
+  }
+  // Reuse the SDR's own buffer, activeSegments_ are sorted by cell so
+  // duplicates are adjacent.
+  auto &cells = predictiveCells_.getSparse();
+  cells.clear();
+  for (const auto segment : activeSegments_) {
+    const CellIdx cell = connections.cellForSegment(segment);
+    if( cells.empty() or cells.back() != cell )
+      cells.push_back(cell);
+  }
+  predictiveCells_.setSparse(cells);
 }
 
 
@@ -415,18 +578,30 @@ void TemporalMemory::compute(const SDR &activeColumns,
                              const SDR &externalPredictiveInputsActive,
                              const SDR &externalPredictiveInputsWinners)
 {
-  activateDendrites(learn, externalPredictiveInputsActive, externalPredictiveInputsWinners);
+  checkExternalInputs_(externalPredictiveInputsActive, externalPredictiveInputsWinners);
+  if( segmentsValid_ ) { // activateDendrites() was called already, with its own inputs
+    activateCells(activeColumns, learn);
+  } else {
+    activateDendrites_(learn, externalPredictiveInputsActive.getSparse());
+    activateCells_(activeColumns, learn, externalPredictiveInputsActive.getSparse(),
+                   externalPredictiveInputsWinners.getSparse());
+  }
 
-  calculateAnomalyScore_(activeColumns);
+  calculateAnomalyScore_();
+}
 
-  activateCells(activeColumns, learn);
+Real TemporalMemory::rawAnomalyScore_() const {
+  // Same as computeRawAnomalyScore(activeColumns, cellsToColumns(predictiveCells)):
+  // a column was predicted iff it has an active segment, which activateCells()
+  // already knows for every active column.
+  return rawAnomalyScore(numActiveColumns_, numActiveColumns_ - numBurstingColumns_);
 }
 
-void TemporalMemory::calculateAnomalyScore_(const SDR &activeColumns){
+void TemporalMemory::calculateAnomalyScore_(){
 
   // Update Anomaly Metric.  The anomaly is the percent of active columns that
   // were not predicted. 
-  // Must be computed here, between `activateDendrites()` and `activateCells()`.
+  // Must be computed right after `activateCells()`, from its column counts.
   switch(tmAnomaly_.mode_) {
 
 	case ANMode::DISABLED: {
@@ -434,22 +609,16 @@ void TemporalMemory::calculateAnomalyScore_(const SDR &activeColumns){
 			   } break;
 
 	case ANMode::RAW: {
-	  tmAnomaly_.anomaly_ = computeRawAnomalyScore(
-							 activeColumns,
-							 cellsToColumns( getPredictiveCells() ));
+	  tmAnomaly_.anomaly_ = rawAnomalyScore_();
 			  } break;
 
 	case ANMode::LIKELIHOOD: {
-	  const Real raw = computeRawAnomalyScore(
-						 activeColumns,
-						 cellsToColumns( getPredictiveCells() ));
+	  const Real raw = rawAnomalyScore_();
 	  tmAnomaly_.anomaly_ = tmAnomaly_.anomalyLikelihood_.anomalyProbability(raw);
 				 } break;
 
 	case ANMode::LOGLIKELIHOOD: {
-	  const Real raw = computeRawAnomalyScore(
-						 activeColumns,
-						 cellsToColumns( getPredictiveCells() ));
+	  const Real raw = rawAnomalyScore_();
 	  const Real like = tmAnomaly_.anomalyLikelihood_.anomalyProbability(raw);
 	  const Real log  = tmAnomaly_.anomalyLikelihood_.computeLogLikelihood(like);
 	  tmAnomaly_.anomaly_ = log;
@@ -462,91 +631,138 @@ void TemporalMemory::calculateAnomalyScore_(const SDR &activeColumns){
 }
 
 void TemporalMemory::compute(const SDR &activeColumns, const bool learn) {
-  SDR externalPredictiveInputsActive({ externalPredictiveInputs_ });
-  SDR externalPredictiveInputsWinners({ externalPredictiveInputs_ });
-  compute( activeColumns, learn, externalPredictiveInputsActive, externalPredictiveInputsWinners );
+  SDR::Scratch externalPredictiveInputsActive({ externalPredictiveInputs_ });
+  SDR::Scratch externalPredictiveInputsWinners({ externalPredictiveInputs_ });
+  compute( activeColumns, learn, *externalPredictiveInputsActive, *externalPredictiveInputsWinners );
+}
+
+void TemporalMemory::compute(TMStreamState &stream, const SDR &activeColumns, const bool learn) {
+  NTA_CHECK( externalPredictiveInputs_ == 0u )
+    << "TM.compute(stream): streams do not support external predictive inputs!";
+  NTA_CHECK( not segmentsValid_ )
+    << "TM.compute(stream) must not be called between TM.activateDendrites() and TM.activateCells()!";
+
+  // Lend the stream's state to this TM for one step. Swapping vectors is
+  // O(1), and the rest (segmentActivity_, predictiveCells_) is scratch
+  // which activateDendrites() recomputes.
+  const auto swapState = [&]() {
+    activeCells_.swap(stream.activeCells_);
+    winnerCells_.swap(stream.winnerCells_);
+    activeSegments_.swap(stream.activeSegments_);
+    matchingSegments_.swap(stream.matchingSegments_);
+  };
+  swapState();
+  try {
+    activateDendrites(learn);
+    activateCells(activeColumns, learn);
+    if( tmAnomaly_.mode_ != ANMode::DISABLED ) {
+      stream.anomaly_ = rawAnomalyScore_();
+    }
+  }
+  catch(...) {
+    segmentsValid_ = false;
+    swapState();
+    throw;
+  }
+  swapState();
 }
 
+
+void TMStreamState::reset() {
+  activeCells_.clear();
+  winnerCells_.clear();
+  activeSegments_.clear();
+  matchingSegments_.clear();
+  anomaly_ = 0.5f;
+}
+
+
 void TemporalMemory::reset(void) {
   activeCells_.clear();
   winnerCells_.clear();
+  externalActive_.clear();
+  externalWinners_.clear();
   activeSegments_.clear();
   matchingSegments_.clear();
   segmentsValid_ = false;
+  updatePredictiveCells_();
   tmAnomaly_.anomaly_ = -1.0f; //TODO reset rather to 0.5 as default (undecided) anomaly
 }
 
 // ==============================
 //  Helper functions
 // ==============================
-UInt TemporalMemory::columnForCell(const CellIdx cell) const {
-  NTA_ASSERT(cell < numberOfCells());
-  return cell / cellsPerColumn_;
+void TemporalMemory::updateColumnShift_() {
+  columnShift_ = -1;
+  if(cellsPerColumn_ == 0u or (cellsPerColumn_ & (cellsPerColumn_ - 1u)) != 0u) return;
+  columnShift_ = 0;
+  while((static_cast<CellIdx>(1u) << columnShift_) != cellsPerColumn_) columnShift_++;
 }
 
 
 SDR TemporalMemory::cellsToColumns(const SDR& cells) const {
+  SDR cols(getColumnDimensions());
+  cellsToColumns(cells, cols);
+  return cols;
+}
+
+
+void TemporalMemory::cellsToColumns(const SDR& cells, SDR& cols) const {
+  cellsToColumns(SDRView(cells), cols);
+}
+
+
+void TemporalMemory::cellsToColumns(const SDRView& cells, SDR& cols) const {
   auto correctDims = getColumnDimensions(); //nD column dimensions (eg 10x100)
   correctDims.push_back(static_cast<CellIdx>(getCellsPerColumn())); //add n+1-th dimension for cellsPerColumn (eg. 10x100x8)
 
-  NTA_ASSERT(cells.dimensions.size() == correctDims.size()) 
+  NTA_ASSERT(cells.getDimensions().size() == correctDims.size()) 
 	  << "cells.dimensions must match TM's (column dims x cellsPerColumn) ";
 
   for(size_t i = 0; i<correctDims.size(); i++) 
-	  NTA_CHECK(correctDims[i] == cells.dimensions[i]);
-
-  SDR cols(getColumnDimensions());
-  auto& dense = cols.getDense();
-  for(const auto cell : cells.getSparse()) {
+	  NTA_CHECK(correctDims[i] == cells.getDimensions()[i]);
+
+  NTA_CHECK(cols.size == numColumns_);
+  cols.reshape(getColumnDimensions());
+  // The cells are sorted, so are their columns.
+  SDR_sparse_t &sparse = cols.getSparse();
+  sparse.clear();
+  cells.forEach([&](const UInt cell) {
     const auto col = columnForCell(cell);
-    dense[col] = static_cast<ElemDense>(1);
-  }
-  cols.setDense(dense);
-
-  NTA_ASSERT(cols.size == numColumns_); 
-  return cols;
+    if(sparse.empty() or sparse.back() != col)
+      sparse.push_back(col);
+  });
+  cols.setSparse(sparse);
 }
 
 
-vector<CellIdx> TemporalMemory::cellsForColumn(const CellIdx column) const { 
-  const CellIdx start = cellsPerColumn_ * column;
-
-  vector<CellIdx> cellsInColumn(cellsPerColumn_);
-  std::iota(std::begin(cellsInColumn), std::end(cellsInColumn), start); //fill with start, start+1, start+2, ...
-
-  return cellsInColumn;
-}
-
 vector<CellIdx> TemporalMemory::getActiveCells() const { return activeCells_; }
 
 void TemporalMemory::getActiveCells(SDR &activeCells) const
 {
   UInt nbr_cells = static_cast<UInt>(numberOfCells());
   NTA_CHECK( activeCells.size == nbr_cells );
-  activeCells.setSparse( getActiveCells() );
+  activeCells.setSparse( activeCells_ );
 }
 
+SDRView TemporalMemory::cellsView_(const vector<CellIdx> &cells) const {
+  auto dimensions = getColumnDimensions();
+  dimensions.push_back(static_cast<UInt>(getCellsPerColumn()));
+  return SDRView(dimensions, cells.data(), cells.size());
+}
 
-SDR TemporalMemory::getPredictiveCells() const {
-
-  NTA_CHECK( segmentsValid_ )
-    << "Call TM.activateDendrites() before TM.getPredictiveCells()!";
+SDRView TemporalMemory::getActiveCellsView() const { return cellsView_(activeCells_); }
 
-  auto correctDims = getColumnDimensions();
-  correctDims.push_back(static_cast<CellIdx>(getCellsPerColumn()));
-  SDR predictive(correctDims);
 
-  std::set<CellIdx> uniqueCells;
-  //uniqueCells.reserve(activeSegments_.size());
+SDR TemporalMemory::getPredictiveCells() const {
+  return getPredictiveCellsRef();
+}
 
-  for (const auto segment : activeSegments_) {
-    const CellIdx cell = connections.cellForSegment(segment);
-    uniqueCells.insert(cell); //set keeps the cells unique
-  }
 
-  vector<CellIdx> predictiveCells(uniqueCells.begin(), uniqueCells.end());
-  predictive.setSparse(predictiveCells);
-  return predictive;
+const SDR &TemporalMemory::getPredictiveCellsRef() const {
+  NTA_CHECK( segmentsValid_ )
+    << "Call TM.activateDendrites() before TM.getPredictiveCells()!";
+  return predictiveCells_;
 }
 
 
@@ -555,9 +771,11 @@ vector<CellIdx> TemporalMemory::getWinnerCells() const { return winnerCells_; }
 void TemporalMemory::getWinnerCells(SDR &winnerCells) const
 {
   NTA_CHECK( winnerCells.size == numberOfCells() );
-  winnerCells.setSparse( getWinnerCells() );
+  winnerCells.setSparse( winnerCells_ );
 }
 
+SDRView TemporalMemory::getWinnerCellsView() const { return cellsView_(winnerCells_); }
+
 vector<Segment> TemporalMemory::getActiveSegments() const
 {
   NTA_CHECK( segmentsValid_ )
@@ -698,6 +916,59 @@ bool TemporalMemory::operator==(const TemporalMemory &other) const {
   return true;
 }
 
+
+void TemporalMemory::saveCheckpoint(const string &path) const {
+  CheckpointWriter writer(path);
+  stringstream state;
+  {
+    const Connections::ExternalSerialization external(
+        [&](const Connections &connections, const string &name) { connections.saveCheckpoint(writer, "tm." + name); },
+        nullptr);
+    save(state, SerializableFormat::BINARY);
+  }
+  const string bytes = state.str();
+  writer.write("tm.state", bytes.data(), bytes.size());
+  writer.close();
+}
+
+
+void TemporalMemory::loadCheckpoint(const string &path) {
+  const CheckpointReader reader(path);
+  const auto bytes = reader.section("tm.state");
+  stringstream state(string(bytes.first, bytes.second));
+  const Connections::ExternalSerialization external(
+      nullptr,
+      [&](Connections &connections, const string &name) { connections.loadCheckpoint(reader, "tm." + name); });
+  load(state, SerializableFormat::BINARY);
+}
+
+
+std::pair<size_t, size_t> TemporalMemory::prune(const Permanence minPermanence, const UInt32 maxSegmentAge) {
+  const auto destroyed = connections_.prune(minPermanence, maxSegmentAge, true);
+  reset(); //the segment lists refer to the old numbering
+  return destroyed;
+}
+
+
+MemoryUsage TemporalMemory::memoryUsage() const {
+  MemoryUsage usage;
+  memory::add(usage, "connections.", connections_.memoryUsage());
+  usage["cellState"] = memory::bytes(activeCells_) + memory::bytes(winnerCells_) +
+                       memory::bytes(activeSegments_) + memory::bytes(matchingSegments_) +
+                       predictiveCells_.memoryUsage();
+  size_t caches = memory::bytes(segmentActivity_.numActiveConnected) +
+                  memory::bytes(segmentActivity_.numActivePotential) +
+                  memory::bytes(segmentActivity_.touched) + memory::bytes(adaptations_) +
+                  memory::bytes(sortCells_) + memory::bytes(sortCellsScratch_) +
+                  memory::bytes(sortSegmentsScratch_);
+  for(const auto &adaptation : adaptations_) {
+    caches += memory::bytes(adaptation.crossing) + memory::bytes(adaptation.prune) + memory::bytes(adaptation.updates);
+  }
+  usage["caches"] = caches;
+  memory::add(usage, "anomalyLikelihood.", tmAnomaly_.anomalyLikelihood_.memoryUsage());
+  return usage;
+}
+
 //----------------------------------------------------------------------
 // Debugging helpers
 //----------------------------------------------------------------------
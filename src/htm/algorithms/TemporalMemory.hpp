@@ -25,10 +25,12 @@
 #include <htm/algorithms/Connections.hpp>
 #include <htm/types/Types.hpp>
 #include <htm/types/Sdr.hpp>
+#include <htm/types/SdrView.hpp>
 #include <htm/types/Serializable.hpp>
 #include <htm/utils/Random.hpp>
 #include <htm/algorithms/AnomalyLikelihood.hpp>
 
+#include <iterator>
 #include <vector>
 
 
@@ -37,6 +39,39 @@ namespace htm {
 using namespace std;
 using namespace htm;
 
+/**
+ * Per-stream state of a TemporalMemory, see TemporalMemory::compute(stream, ...).
+ *
+ * Holds only what differs between independent sequences (active & winner
+ * cells, segment bookkeeping, raw anomaly); the learned Connections stay in
+ * the one TemporalMemory shared by all streams.
+ */
+class TMStreamState
+{
+public:
+  const vector<CellIdx> &getActiveCells() const { return activeCells_; }
+  const vector<CellIdx> &getWinnerCells() const { return winnerCells_; }
+
+  /**
+   * Raw anomaly score of this stream's last compute(), 0.5 before the
+   * first step or if the TM's anomaly mode is DISABLED.
+   */
+  Real getAnomaly() const { return anomaly_; }
+
+  /**
+   * Start a new sequence on this stream.
+   */
+  void reset();
+
+private:
+  friend class TemporalMemory;
+  vector<CellIdx> activeCells_;
+  vector<CellIdx> winnerCells_;
+  vector<Segment> activeSegments_;
+  vector<Segment> matchingSegments_;
+  Real anomaly_ = 0.5f;
+};
+
 
 /**
  * Temporal Memory implementation in C++.
@@ -270,6 +305,27 @@ public:
   virtual void compute(const SDR &activeColumns, 
                        const bool learn = true);
 
+  /**
+   * Perform one time step for an independent sequence, whose state lives in
+   * `stream` instead of this TM. All streams share this TM's Connections,
+   * so one set of weights can serve many sensor streams.
+   *
+   * With learn=false the Connections are not modified. With learn=true all
+   * streams train the same shared Connections.
+   *
+   * Streams do not support external predictive inputs, and the anomaly
+   * stored in the stream is always the raw score (keep an AnomalyLikelihood
+   * per stream if needed). This TM's own state (getActiveCells() etc.) is
+   * not affected. Not thread safe: one stream at a time per TM.
+   *
+   * @param stream State of the sequence, updated in place.
+   * @param activeColumns Sorted SDR of active columns.
+   * @param learn Whether or not learning is enabled.
+   */
+  void compute(TMStreamState &stream,
+               const SDR &activeColumns,
+               const bool learn = false);
+
   // ==============================
   //  Helper functions
   // ==============================
@@ -297,14 +353,161 @@ public:
   }
   void destroySynapse(const Synapse syn) { connections_.destroySynapse(syn); }
 
+  /**
+   * Use the flat presynaptic index in the underlying connections,
+   * see `Connections::setFlatIndex()`. Call after `initialize()`.
+   */
+  void setFlatIndex(const bool enable) { connections_.setFlatIndex(enable); }
+
+  /**
+   * Pick the cells of growSynapses() one at a time in the underlying
+   * connections, see `Connections::setSampledGrowth()`. Changes the results
+   * for the same seed. Call after `initialize()`.
+   */
+  void setSampledGrowth(const bool enable) { connections_.setSampledGrowth(enable); }
+
+  /**
+   * Compute the segment activity with several threads,
+   * see `Connections::setNumThreads()`. Call after `initialize()`.
+   *
+   * With more than one thread, `activateCells()` also learns in parallel:
+   * the permanences of all segments are adapted at once, then the structural
+   * changes (connecting, pruning & growing synapses, creating segments) are
+   * applied column by column, in the same order as with one thread.
+   * The results are identical to the serial run for the same seed.
+   */
+  void setNumThreads(const UInt numThreads) { connections_.setNumThreads(numThreads); }
+  void setThreadPool(const std::shared_ptr<ThreadPool> &pool) { connections_.setThreadPool(pool); }
+
+  /**
+   * Put the cells, segments and synapses on a MemoryResource, e.g. huge pages
+   * or a NUMA node, see `Connections::setMemoryResource()`. Call after
+   * `initialize()`. The setting is not serialized.
+   */
+  void setMemoryResource(const std::shared_ptr<MemoryResource> &resource) { connections_.setMemoryResource(resource); }
+
+  /**
+   * Share a synapse budget with other models, see `Connections::setSynapseBudget()`.
+   * Over its target the TM destroys its least recently used segments.
+   * Not serialized.
+   */
+  void setSynapseBudget(std::shared_ptr<SynapseBudget> budget) {
+    connections_.setSynapseBudget(std::move(budget), true); }
+
+  /**
+   * Compact the underlying connections automatically,
+   * see `Connections::setCompactThreshold()`. Call after `initialize()`.
+   */
+  void setCompactThreshold(const Real fraction) { connections_.setCompactThreshold(fraction); }
+
+  /**
+   * Choose which segment is destroyed when a cell reaches maxSegmentsPerCell,
+   * see `Connections::setSegmentEviction()`. Call after `initialize()`.
+   */
+  void setSegmentEviction(const SegmentEviction policy, const UInt sampleSize = 4u, const UInt64 seed = 42u) {
+    connections_.setSegmentEviction(policy, sampleSize, seed); }
+
+  /**
+   * Pick the winner cell of a bursting column without a matching segment (the
+   * cell with the fewest segments, random among ties) in a single pass over
+   * the column, with no allocation and one random number per tie only.
+   *
+   * The default (off) shuffles all the cells of the column first and takes
+   * the first cell with the fewest segments, which draws cellsPerColumn - 1
+   * random numbers per such column. Both choose uniformly among the ties, but
+   * they consume the random sequence differently, so turning this on changes
+   * the results for the same seed; keep it off to reproduce older results.
+   * The setting is not serialized.
+   */
+  void setSinglePassLeastUsedCell(const bool enable) { singlePassLeastUsedCell_ = enable; }
+  bool getSinglePassLeastUsedCell() const noexcept { return singlePassLeastUsedCell_; }
+
+  /**
+   * Prune the trained model offline, see `Connections::prune()`: destroys
+   * the synapses with a permanence below minPermanence, the segments not
+   * used in the last maxSegmentAge iterations (0 for no limit) and the
+   * segments left without synapses.  The TM starts a new sequence (reset()).
+   *
+   * @returns the numbers of destroyed synapses and segments.
+   */
+  std::pair<size_t, size_t> prune(Permanence minPermanence, UInt32 maxSegmentAge = 0u);
+
+  /**
+   * Bytes of memory by category: connections.<category> (see
+   * Connections::memoryUsage()), cellState (active / winner cells and
+   * segments), caches (buffers reused between computes) and
+   * anomalyLikelihood.history.
+   */
+  MemoryUsage memoryUsage() const;
+
+  /**
+   * Store the permanences with less precision, to save memory,
+   * see `Connections::setPermanencePrecision()`. Call after `initialize()`.
+   */
+  void setPermanencePrecision(const PermanencePrecision precision) {
+    connections_.setPermanencePrecision(precision); }
+
+  /**
+   * The cells of a mini-column: the consecutive indices [front, front + size).
+   * Iterable like a const vector<CellIdx>, but nothing is allocated.
+   * Converts to vector<CellIdx> where a container is needed.
+   */
+  class CellRange {
+  public:
+    class const_iterator {
+    public:
+      using iterator_category = std::random_access_iterator_tag;
+      using value_type        = CellIdx;
+      using difference_type   = std::ptrdiff_t;
+      using pointer           = const CellIdx*;
+      using reference         = CellIdx;
+
+      const_iterator() = default;
+      explicit const_iterator(const CellIdx cell) : cell_(cell) {}
+      CellIdx operator*() const { return cell_; }
+      CellIdx operator[](const difference_type n) const { return static_cast<CellIdx>(cell_ + n); }
+      const_iterator &operator++() { ++cell_; return *this; }
+      const_iterator operator++(int) { return const_iterator(cell_++); }
+      const_iterator &operator--() { --cell_; return *this; }
+      const_iterator operator--(int) { return const_iterator(cell_--); }
+      const_iterator &operator+=(const difference_type n) { cell_ = static_cast<CellIdx>(cell_ + n); return *this; }
+      const_iterator &operator-=(const difference_type n) { cell_ = static_cast<CellIdx>(cell_ - n); return *this; }
+      const_iterator operator+(const difference_type n) const { return const_iterator(static_cast<CellIdx>(cell_ + n)); }
+      const_iterator operator-(const difference_type n) const { return const_iterator(static_cast<CellIdx>(cell_ - n)); }
+      difference_type operator-(const const_iterator &o) const {
+        return static_cast<difference_type>(cell_) - static_cast<difference_type>(o.cell_); }
+      bool operator==(const const_iterator &o) const { return cell_ == o.cell_; }
+      bool operator!=(const const_iterator &o) const { return cell_ != o.cell_; }
+      bool operator<(const const_iterator &o) const { return cell_ < o.cell_; }
+    private:
+      CellIdx cell_ = 0u;
+    };
+    using iterator = const_iterator;
+
+    CellRange(const CellIdx front, const CellIdx size) : front_(front), size_(size) {}
+    const_iterator begin() const { return const_iterator(front_); }
+    const_iterator end() const { return const_iterator(front_ + size_); }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0u; }
+    CellIdx front() const { return front_; }
+    CellIdx back() const { return front_ + size_ - 1u; }
+    CellIdx operator[](const size_t i) const { return static_cast<CellIdx>(front_ + i); }
+    operator vector<CellIdx>() const { return vector<CellIdx>(begin(), end()); }
+
+  private:
+    CellIdx front_;
+    CellIdx size_;
+  };
+
   /**
    * Returns the indices of cells that belong to a mini-column.
    *
    * @param column Column index
    *
-   * @return (vector<CellIdx>) Cell indices
+   * @return (CellRange) Cell indices, convertible to vector<CellIdx>
    */
-  vector<CellIdx> cellsForColumn(const CellIdx column) const;
+  CellRange cellsForColumn(const CellIdx column) const {
+    return CellRange(cellsPerColumn_ * column, cellsPerColumn_); }
 
   /**
    * Returns the number of cells in this layer.
@@ -321,12 +524,34 @@ public:
   vector<CellIdx> getActiveCells() const; //TODO remove
   void getActiveCells(SDR &activeCells) const;
 
+  /**
+   * Same as getActiveCells(SDR&), but a view of the TM's own vector, no
+   * copy.  The dimensions are {TM column dims x TM cells per column}, the
+   * active external predictive inputs are not part of it.  Valid until the
+   * next compute(), activateCells() or reset().
+   */
+  SDRView getActiveCellsView() const;
+
+  /**
+   * The TM's own sorted vector of active cell indices, no copy.  Valid and
+   * unchanged until the next compute(), activateCells() or reset().
+   */
+  const vector<CellIdx> &getActiveCellsRef() const { return activeCells_; }
+
   /**
    * @return SDR with indices of the predictive cells.
    * SDR dimensions are {TM column dims x TM cells per column}
    */
   SDR getPredictiveCells() const;
 
+  /**
+   * Same as getPredictiveCells(), but returns a reference to the SDR which
+   * TM keeps up to date in activateDendrites(). No copy, no allocation.
+   * The reference stays valid for the lifetime of the TM, its content
+   * changes with the next call to activateDendrites() or reset().
+   */
+  const SDR &getPredictiveCellsRef() const;
+
   /**
    * Returns the indices of the winner cells.
    *
@@ -335,6 +560,12 @@ public:
   vector<CellIdx> getWinnerCells() const; //TODO remove?
   void getWinnerCells(SDR &winnerCells) const;
 
+  /** Same as getActiveCellsView(), for the winner cells. */
+  SDRView getWinnerCellsView() const;
+
+  /** Same as getActiveCellsRef(), for the winner cells. */
+  const vector<CellIdx> &getWinnerCellsRef() const { return winnerCells_; }
+
   vector<Segment> getActiveSegments() const;
   vector<Segment> getMatchingSegments() const;
 
@@ -490,6 +721,8 @@ public:
        CEREAL_NVP(columnDimensions_),
        CEREAL_NVP(activeCells_),
        CEREAL_NVP(winnerCells_),
+       CEREAL_NVP(externalActive_),
+       CEREAL_NVP(externalWinners_),
        CEREAL_NVP(segmentsValid_),
        CEREAL_NVP(tmAnomaly_.anomaly_),
        CEREAL_NVP(tmAnomaly_.mode_),
@@ -511,7 +744,7 @@ public:
                             segments.begin(), 
                             std::find(segments.begin(), 
                             segments.end(), segment));
-        c.syn = numActiveConnectedSynapsesForSegment_[segment];
+        c.syn = segmentActivity_.numActiveConnected[segment];
         ar(c); // to keep iteration counts correct, only serialize one item per iteration.
       }
     }
@@ -527,7 +760,7 @@ public:
         const vector<Segment> &segments = connections.segmentsForCell(c.cell);
 
         c.idx = (SegmentIdx)std::distance(segments.begin(), std::find(segments.begin(), segments.end(), segment));
-        c.syn = numActivePotentialSynapsesForSegment_[segment];
+        c.syn = segmentActivity_.numActivePotential[segment];
         ar(c);
       }
     }
@@ -553,16 +786,19 @@ public:
        CEREAL_NVP(columnDimensions_),
        CEREAL_NVP(activeCells_),
        CEREAL_NVP(winnerCells_),
+       CEREAL_NVP(externalActive_),
+       CEREAL_NVP(externalWinners_),
        CEREAL_NVP(segmentsValid_),
        CEREAL_NVP(tmAnomaly_.anomaly_),
        CEREAL_NVP(tmAnomaly_.mode_),
        CEREAL_NVP(tmAnomaly_.anomalyLikelihood_),
        CEREAL_NVP(connections_));
     
+    segmentActivity_.touchedValid = false; //counters are restored below
     size_t activeSize;
     ar(CEREAL_NVP(activeSize));
     if (activeSize > 0) {
-      numActiveConnectedSynapsesForSegment_.assign(connections.segmentFlatListLength(), 0);
+      segmentActivity_.numActiveConnected.assign(connections.segmentFlatListLength(), 0);
       cereal::size_type numActiveSegments;
       ar(cereal::make_size_tag(numActiveSegments));
       activeSegments_.resize(static_cast<size_t>(numActiveSegments));
@@ -571,13 +807,13 @@ public:
         ar(c);  
         Segment segment = connections.getSegment(c.cell, c.idx);
         activeSegments_[i] = segment;
-        numActiveConnectedSynapsesForSegment_[segment] = c.syn;
+        segmentActivity_.numActiveConnected[segment] = c.syn;
       }
     }
     size_t matchSize;
     ar(CEREAL_NVP(matchSize));
     if (matchSize > 0) {
-      numActivePotentialSynapsesForSegment_.assign(connections.segmentFlatListLength(), 0);
+      segmentActivity_.numActivePotential.assign(connections.segmentFlatListLength(), 0);
       cereal::size_type numMatchingSegments;
       ar(cereal::make_size_tag(numMatchingSegments));
       matchingSegments_.resize(static_cast<size_t>(numMatchingSegments));
@@ -586,11 +822,22 @@ public:
         ar(c);
         Segment segment = connections.getSegment(c.cell, c.idx);
         matchingSegments_[i] = segment;
-        numActivePotentialSynapsesForSegment_[segment] = c.syn;
+        segmentActivity_.numActivePotential[segment] = c.syn;
       }
     }
+    updateColumnShift_();
+    updatePredictiveCells_();
   }
 
+  /**
+   * Save / load the state to a flat checkpoint file, see CheckpointWriter.
+   * The connections are stored as raw arrays (Connections::saveCheckpoint),
+   * the small rest of the state as a cereal section, so a large, trained
+   * model loads without parsing each synapse.
+   */
+  void saveCheckpoint(const std::string &path) const;
+  void loadCheckpoint(const std::string &path);
+
 
   virtual bool operator==(const TemporalMemory &other) const;
   inline bool operator!=(const TemporalMemory &other) const { return not this->operator==(other); }
@@ -603,6 +850,7 @@ public:
    * Print diagnostic info
    */
   friend std::ostream& operator<< (std::ostream& stream, const TemporalMemory& self);
+  friend class BackgroundLearningTM;
 
   /**
    * Print the main TM creation parameters
@@ -623,7 +871,10 @@ public:
    *
    * @return (int) Column index
    */
-  UInt columnForCell(const CellIdx cell) const;
+  UInt columnForCell(const CellIdx cell) const {
+    NTA_ASSERT(cell < numberOfCells());
+    return columnShift_ >= 0 ? cell >> columnShift_ : cell / cellsPerColumn_;
+  }
 
   /**
    *  cellsToColumns
@@ -638,6 +889,17 @@ public:
    *
    */
   SDR cellsToColumns(const SDR& cells) const;
+
+  /**
+   *  Same, into an existing SDR of TM's getColumnDimensions() size, which
+   *  allocates nothing once cols has the capacity.
+   */
+  void cellsToColumns(const SDR& cells, SDR& cols) const;
+
+  /**
+   *  Same, from a view of the cells, eg. getActiveCellsView().
+   */
+  void cellsToColumns(const SDRView& cells, SDR& cols) const;
 private:
   void punishPredictedColumn_(vector<Segment>::const_iterator columnMatchingSegmentsBegin, 
 		              vector<Segment>::const_iterator columnMatchingSegmentsEnd, 
@@ -647,6 +909,7 @@ private:
 		                vector<Segment>::const_iterator columnActiveSegmentsEnd,
 				const SDR &prevActiveCells,
 				const vector<CellIdx> &prevWinnerCells,
+				const vector<CellIdx> &prevExternalWinners,
 				const bool learn);
 
   void burstColumn_(const UInt column,
@@ -654,21 +917,78 @@ private:
 				    vector<Segment>::const_iterator columnMatchingSegmentsEnd,
 				    const SDR &prevActiveCells,
 				    const vector<CellIdx> &prevWinnerCells,
+				    const vector<CellIdx> &prevExternalWinners,
 				    const bool learn);
 
+  /**
+   * activateDendrites() and activateCells() with the sparse external
+   * predictive inputs, which are presynaptic cells numberOfCells() + index.
+   * compute() passes those of its SDRs, without a copy.
+   */
+  void checkExternalInputs_(const SDR &externalPredictiveInputsActive,
+                            const SDR &externalPredictiveInputsWinners) const;
+  void activateDendrites_(const bool learn, const vector<CellIdx> &externalActive);
+  void activateCells_(const SDR &activeColumns, const bool learn,
+                      const vector<CellIdx> &externalActive,
+                      const vector<CellIdx> &externalWinners);
+
+  /**
+   * adaptSegment() which uses the results of the parallel phase, if there is one.
+   */
+  void adaptSegment_(const Segment segment,
+                     const SDR &prevActiveCells,
+                     const Permanence increment,
+                     const Permanence decrement);
+
+  vector<Segment>::const_iterator bestMatchingSegment_(vector<Segment>::const_iterator columnMatchingSegmentsBegin,
+                                                       vector<Segment>::const_iterator columnMatchingSegmentsEnd) const;
+
+  /**
+   * Merge-join of the (sorted) active columns with activeSegments_ and
+   * matchingSegments_, which are sorted by column too. For each column with any
+   * of them, in ascending order, calls
+   *   visit(column, isActiveColumn, activeBegin, activeEnd, matchingBegin, matchingEnd)
+   * with the column's ranges of active and matching segments. The column of each
+   * segment is looked up once, before the column which precedes it is visited.
+   */
+  template<typename Visit>
+  void forEachColumn_(const vector<CellIdx> &activeColumns, Visit &&visit) const;
+
   void growSynapses_(const Segment& segment,
 		     const SynapseIdx nDesiredNewSynapses,
 		     const vector<CellIdx> &prevWinnerCells);
 
   CellIdx getLeastUsedCell_(const CellIdx column);
 
-  void calculateAnomalyScore_(const SDR &activeColumns);
+  /** Set columnShift_ for cellsPerColumn_, after initialize() and load. */
+  void updateColumnShift_();
+
+  void calculateAnomalyScore_();
+  Real rawAnomalyScore_() const;
+
+  /**
+   * Rebuild predictiveCells_ from activeSegments_ (which are sorted by cell).
+   */
+  void updatePredictiveCells_();
+
+  /**
+   * View of the TM's cells in activeCells_ or winnerCells_.
+   */
+  SDRView cellsView_(const vector<CellIdx> &cells) const;
+
+  /**
+   * Sort segments, given in ascending order, as connections.compareSegments()
+   * does: a stable radix sort on the cell keeps the segments of a cell in
+   * order of creation.
+   */
+  void sortSegmentsByCell_(vector<Segment> &segments);
 
 protected:
   //all these could be const
   CellIdx numColumns_;
   vector<CellIdx> columnDimensions_;
   CellIdx cellsPerColumn_;
+  Int columnShift_ = -1; //log2(cellsPerColumn_) if a power of 2, else -1: columnForCell() shifts rather than divides
   SynapseIdx activationThreshold_;
   SynapseIdx minThreshold_;
   SynapseIdx maxNewSynapseCount_;
@@ -685,11 +1005,20 @@ protected:
 private:
   vector<CellIdx> activeCells_;
   vector<CellIdx> winnerCells_;
+  vector<CellIdx> externalActive_;  //of activateDendrites(), for activateCells()
+  vector<CellIdx> externalWinners_;
   bool segmentsValid_;
   vector<Segment> activeSegments_;
   vector<Segment> matchingSegments_;
-  vector<SynapseIdx> numActiveConnectedSynapsesForSegment_;
-  vector<SynapseIdx> numActivePotentialSynapsesForSegment_;
+  SDR predictiveCells_{{0u}}; //cells of activeSegments_, not serialized
+  SegmentActivity segmentActivity_; //numActiveConnected/Potential synapses for each segment
+  vector<SegmentAdaptation> adaptations_; //parallel learning: prepared adaptSegment() calls, in serial order
+  size_t nextAdaptation_ = 0u;
+  vector<CellIdx> sortCells_, sortCellsScratch_; //reused by sortSegmentsByCell_()
+  vector<Segment> sortSegmentsScratch_;
+  bool singlePassLeastUsedCell_ = false; //see setSinglePassLeastUsedCell(), not serialized
+  UInt numActiveColumns_   = 0u; //of the last activateCells(), for the raw anomaly, not serialized
+  UInt numBurstingColumns_ = 0u;
 
   Random rng_;
 
@@ -62,6 +62,20 @@ public:
 
     virtual void encode(DataType input, SDR &output) = 0;
 
+    /**
+     * Encode many inputs, each into the output SDR at the same index.
+     * The default implementation calls encode() once per input, subclasses
+     * can override it with a cheaper loop.
+     */
+    virtual void encodeBatch(const std::vector<DataType> &inputs, std::vector<SDR> &outputs) {
+        NTA_CHECK( inputs.size() == outputs.size() )
+            << "encodeBatch needs one output SDR per input, got "
+            << outputs.size() << " outputs for " << inputs.size() << " inputs.";
+        for( size_t i = 0; i < inputs.size(); ++i ) {
+            encode( inputs[i], outputs[i] );
+        }
+    }
+
     virtual ~BaseEncoder() {}
 
 protected:
@@ -0,0 +1,137 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the CategoryEncoder
+ */
+
+#include <algorithm> // sort, unique
+#include <cmath>     // round
+
+#include <htm/encoders/CategoryEncoder.hpp>
+#include <murmurhash3/MurmurHash3.hpp>
+#include <htm/utils/Random.hpp>
+
+namespace htm {
+
+CategoryEncoder::CategoryEncoder( const CategoryEncoderParameters &parameters )
+  { initialize( parameters ); }
+
+void CategoryEncoder::initialize( const CategoryEncoderParameters &parameters )
+{
+  NTA_CHECK( parameters.size > 0u ) << "Missing argument 'size'.";
+  NTA_CHECK( (parameters.activeBits > 0u) != (parameters.sparsity > 0.0f) )
+      << "Need exactly one argument of: 'activeBits' or 'sparsity'.";
+  NTA_CHECK( parameters.sparsity >= 0.0f && parameters.sparsity <= 1.0f )
+      << "Argument 'sparsity' must be in the range 0.0-1.0.";
+
+  args_ = parameters;
+  if( args_.sparsity > 0.0f ) {
+    args_.activeBits = (UInt) std::round( args_.size * args_.sparsity );
+    NTA_CHECK( args_.activeBits > 0u );
+  }
+  NTA_CHECK( args_.activeBits <= args_.size )
+      << "Argument 'activeBits' must not be larger than 'size'.";
+  // Always calculate this even if it was given, to correct for rounding error.
+  args_.sparsity = (Real) args_.activeBits / args_.size;
+
+  while( args_.seed == 0u ) {
+    args_.seed = Random().getUInt32();
+  }
+
+  ids_.clear();
+  categories_.clear();
+  patterns_.clear();
+
+  BaseEncoder<std::string>::initialize({ args_.size });
+}
+
+void CategoryEncoder::hash_(const std::string &category, SDR_sparse_t &pattern) const
+{
+  // Hash the category once, and derive every active bit from that hash and
+  // the bit's offset.
+  UInt32 bitKey[2] = { MurmurHash3_x86_32( category.data(), (int) category.size(), args_.seed ), 0u };
+  pattern.resize( args_.activeBits );
+  for( UInt offset = 0u; offset < args_.activeBits; ++offset ) {
+    bitKey[1] = offset;
+    pattern[offset] = MurmurHash3_x86_32( bitKey, sizeof(bitKey), args_.seed ) % size;
+  }
+  std::sort( pattern.begin(), pattern.end() );
+  pattern.erase( std::unique( pattern.begin(), pattern.end() ), pattern.end() );
+}
+
+Int CategoryEncoder::intern_(const std::string &category)
+{
+  const auto found = ids_.find( category );
+  if( found != ids_.end() ) {
+    return (Int) found->second;
+  }
+  if( args_.maxCategories != 0u and categories_.size() >= args_.maxCategories ) {
+    return -1;
+  }
+  const UInt id = (UInt) categories_.size();
+  patterns_.emplace_back();
+  hash_( category, patterns_.back() );
+  categories_.push_back( category );
+  ids_.emplace( category, id );
+  return (Int) id;
+}
+
+Int CategoryEncoder::getCategoryId(const std::string &category) const
+{
+  const auto found = ids_.find( category );
+  return found == ids_.end() ? -1 : (Int) found->second;
+}
+
+void CategoryEncoder::encode(std::string input, SDR &output)
+{
+  NTA_CHECK( output.size == size );
+  const Int id = intern_( input );
+  if( id >= 0 ) {
+    // Copies the interned encoding, setSparse(const) does not swap it out.
+    const SDR_sparse_t &pattern = patterns_[id];
+    output.setSparse( pattern );
+  }
+  else {
+    hash_( input, pattern_ );
+    output.setSparse( pattern_ ); // swaps the scratch buffer
+  }
+}
+
+void CategoryEncoder::encodeBatch(const std::vector<std::string> &inputs, std::vector<SDR> &outputs)
+{
+  NTA_CHECK( inputs.size() == outputs.size() )
+    << "encodeBatch needs one output SDR per input, got "
+    << outputs.size() << " outputs for " << inputs.size() << " inputs.";
+  for( size_t i = 0; i < inputs.size(); ++i ) {
+    CategoryEncoder::encode( inputs[i], outputs[i] );
+  }
+}
+
+std::ostream & operator<<(std::ostream & out, const CategoryEncoder &self)
+{
+  out << "CategoryEncoder \n";
+  out << "  size:          " << self.parameters.size          << ",\n";
+  out << "  activeBits:    " << self.parameters.activeBits    << ",\n";
+  out << "  sparsity:      " << self.parameters.sparsity      << ",\n";
+  out << "  seed:          " << self.parameters.seed          << ",\n";
+  out << "  maxCategories: " << self.parameters.maxCategories << ",\n";
+  out << "  categories:    " << self.categories.size()        << ",\n";
+  return out;
+}
+
+} // end namespace htm
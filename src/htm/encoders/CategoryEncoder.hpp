@@ -0,0 +1,184 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Define the CategoryEncoder
+ */
+
+#ifndef NTA_ENCODERS_CATEGORY
+#define NTA_ENCODERS_CATEGORY
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <htm/types/Types.hpp>
+#include <htm/encoders/BaseEncoder.hpp>
+
+namespace htm {
+
+/**
+ * Parameters for the CategoryEncoder
+ *
+ * Members "activeBits" & "sparsity" are mutually exclusive, specify exactly one
+ * of them.
+ */
+struct CategoryEncoderParameters
+{
+  /**
+   * Member "size" is the total number of bits in the encoded output SDR.
+   */
+  UInt size = 0u;
+
+  /**
+   * Member "activeBits" is the number of true bits in the encoded output SDR.
+   */
+  UInt activeBits = 0u;
+
+  /**
+   * Member "sparsity" is the fraction of bits in the encoded output which this
+   * encoder will activate. This is an alternative way to specify the member
+   * "activeBits".
+   */
+  Real sparsity = 0.0f;
+
+  /**
+   * Member "seed" forces different encoders to produce different outputs, even
+   * if the inputs and all other parameters are the same.  Two encoders with the
+   * same seed, parameters, and input will produce identical outputs.
+   *
+   * The seed 0 is special.  Seed 0 is replaced with a random number.
+   */
+  UInt seed = 0u;
+
+  /**
+   * Member "maxCategories" limits the number of categories which are interned,
+   * see CategoryEncoder. Categories seen after the table is full are hashed
+   * again every time they are encoded. The default 0 is no limit.
+   */
+  UInt maxCategories = 0u;
+};
+
+/**
+ * Encodes a categorical value, such as a host name or a status code, as an
+ * SDR.
+ *
+ * Description:
+ * Every category activates activeBits pseudo random bits, hashed from the
+ * category string with MurmurHash3, as in the RDSE.  Different categories have
+ * unrelated encodings: apart from chance, they share no active bits.  Hash
+ * collisions of the output bits can reduce the number of active bits slightly.
+ *
+ * The first time a category is seen it is interned: it is given the next
+ * category id, and its sparse encoding is stored.  Encoding a known category
+ * is then a hash table lookup and a copy of its encoding.
+ *
+ * Example:
+ *    CategoryEncoderParameters params;
+ *    params.size       = 400u;
+ *    params.activeBits = 21u;
+ *    CategoryEncoder encoder( params );
+ *    SDR output( encoder.dimensions );
+ *    encoder.encode( "eu-west-1", output );
+ */
+class CategoryEncoder : public BaseEncoder<std::string>
+{
+public:
+  CategoryEncoder() {}
+  CategoryEncoder( const CategoryEncoderParameters &parameters );
+  void initialize( const CategoryEncoderParameters &parameters );
+
+  const CategoryEncoderParameters &parameters = args_;
+
+  void encode(std::string input, SDR &output) override;
+
+  /**
+   * Batch version of encode(), for a column of categories, see
+   * BaseEncoder::encodeBatch.
+   */
+  void encodeBatch(const std::vector<std::string> &inputs, std::vector<SDR> &outputs) override;
+
+  /**
+   * The interned categories, in order of their category ids.
+   */
+  const std::vector<std::string> &categories = categories_;
+
+  /**
+   * Returns the id of an interned category, or -1 if it is not interned.
+   */
+  Int getCategoryId(const std::string &category) const;
+
+  ~CategoryEncoder() override {};
+
+  CerealAdapter;  // see Serializable.hpp
+  // FOR Cereal Serialization
+  template<class Archive>
+  void save_ar(Archive& ar) const {
+    std::string name = "CategoryEncoder";
+    ar(cereal::make_nvp("name", name));
+    ar(cereal::make_nvp("size", args_.size));
+    ar(cereal::make_nvp("activeBits", args_.activeBits));
+    ar(cereal::make_nvp("seed", args_.seed));
+    ar(cereal::make_nvp("maxCategories", args_.maxCategories));
+    ar(cereal::make_nvp("categories", categories_));
+  }
+
+  // FOR Cereal Deserialization
+  template<class Archive>
+  void load_ar(Archive& ar) {
+    std::string name;
+    ar(cereal::make_nvp("name", name));
+    NTA_CHECK(name == "CategoryEncoder");
+    CategoryEncoderParameters p;
+    ar(cereal::make_nvp("size", p.size));
+    ar(cereal::make_nvp("activeBits", p.activeBits));
+    ar(cereal::make_nvp("seed", p.seed));
+    ar(cereal::make_nvp("maxCategories", p.maxCategories));
+    std::vector<std::string> categories;
+    ar(cereal::make_nvp("categories", categories));
+    initialize( p );
+    // Intern the categories again, in order, so that they keep their ids.
+    for( const auto &category : categories ) {
+      intern_( category );
+    }
+  }
+
+private:
+  CategoryEncoderParameters args_;
+
+  // The interning table: category string -> category id, and the category
+  // and sparse encoding of every id.
+  std::unordered_map<std::string, UInt> ids_;
+  std::vector<std::string>  categories_;
+  std::vector<SDR_sparse_t> patterns_;
+
+  // Scratch buffer for categories which are not interned.
+  SDR_sparse_t pattern_;
+
+  void hash_(const std::string &category, SDR_sparse_t &pattern) const;
+
+  /**
+   * Returns the id of the category, interning it if there is room.  Returns
+   * -1 if the category is not interned.
+   */
+  Int intern_(const std::string &category);
+};
+
+std::ostream & operator<<(std::ostream & out, const CategoryEncoder &self);
+
+} // end namespace htm
+#endif // NTA_ENCODERS_CATEGORY
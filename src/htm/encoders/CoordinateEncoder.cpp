@@ -0,0 +1,191 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the CoordinateEncoder
+ */
+
+#include <algorithm> // nth_element, sort, unique
+#include <cmath>     // round
+
+#include <htm/encoders/CoordinateEncoder.hpp>
+#include <murmurhash3/MurmurHash3.hpp>
+#include <htm/utils/Random.hpp>
+#include <htm/utils/Topology.hpp>
+
+namespace htm {
+
+static const UInt CACHE_NIL = std::numeric_limits<UInt>::max();
+
+CoordinateEncoder::CoordinateEncoder( const CoordinateEncoderParameters &parameters )
+  { initialize( parameters ); }
+
+void CoordinateEncoder::initialize( const CoordinateEncoderParameters &parameters )
+{
+  NTA_CHECK( parameters.size > 0u ) << "Missing argument 'size'.";
+  NTA_CHECK( parameters.numDimensions > 0u ) << "Missing argument 'numDimensions'.";
+  NTA_CHECK( (parameters.activeBits > 0u) != (parameters.sparsity > 0.0f) )
+      << "Need exactly one argument of: 'activeBits' or 'sparsity'.";
+  NTA_CHECK( parameters.sparsity >= 0.0f && parameters.sparsity <= 1.0f )
+      << "Argument 'sparsity' must be in the range 0.0-1.0.";
+
+  args_ = parameters;
+  if( args_.sparsity > 0.0f ) {
+    args_.activeBits = (UInt) std::round( args_.size * args_.sparsity );
+    NTA_CHECK( args_.activeBits > 0u );
+  }
+  // Always calculate this even if it was given, to correct for rounding error.
+  args_.sparsity = (Real) args_.activeBits / args_.size;
+
+  while( args_.seed == 0u ) {
+    args_.seed = Random().getUInt32();
+  }
+
+  // The neighborhood is the same box around every center, list its offsets
+  // once by walking the whole box around its middle point.
+  const UInt side = 2u * args_.radius + 1u;
+  const std::vector<UInt> box( args_.numDimensions, side );
+  const std::vector<UInt> middle( args_.numDimensions, args_.radius );
+  offsets_.clear();
+  UInt numPoints = 0u;
+  for( const UInt point : Neighborhood( indexFromCoordinates( middle, box ), args_.radius, box )) {
+    for( const UInt c : coordinatesFromIndex( point, box )) {
+      offsets_.push_back( (Int64) c - (Int64) args_.radius );
+    }
+    numPoints++;
+  }
+  NTA_CHECK( numPoints >= args_.activeBits )
+      << "The neighborhood of radius " << args_.radius << " has only " << numPoints
+      << " points, need at least activeBits = " << args_.activeBits << ".";
+  candidates_.resize( numPoints );
+  coordinate_.resize( args_.numDimensions );
+
+  cache_.clear();
+  cacheIndex_.clear();
+  cacheHead_ = CACHE_NIL;
+  cacheTail_ = CACHE_NIL;
+
+  BaseEncoder<std::vector<Int64>>::initialize({ args_.size });
+}
+
+size_t CoordinateEncoder::CoordinateHash_::operator()(const std::vector<Int64> &coordinate) const
+{
+  return MurmurHash3_x86_32( coordinate.data(), (int) (coordinate.size() * sizeof(Int64)), 0u );
+}
+
+CoordinateEncoder::Hashes_ CoordinateEncoder::hash_(const std::vector<Int64> &coordinate) const
+{
+  const int len = (int) (coordinate.size() * sizeof(Int64));
+  Hashes_ h;
+  h.rank = MurmurHash3_x86_32( coordinate.data(), len, args_.seed );
+  h.bit  = MurmurHash3_x86_32( coordinate.data(), len, ~args_.seed ) % size;
+  return h;
+}
+
+CoordinateEncoder::Hashes_ CoordinateEncoder::cachedHash_(const std::vector<Int64> &coordinate)
+{
+  if( args_.cacheSize == 0u ) {
+    return hash_( coordinate );
+  }
+
+  const auto unlink = [&](const UInt idx) {
+    auto &entry = cache_[idx];
+    if( entry.prev != CACHE_NIL ) cache_[entry.prev].next = entry.next;
+    else cacheHead_ = entry.next;
+    if( entry.next != CACHE_NIL ) cache_[entry.next].prev = entry.prev;
+    else cacheTail_ = entry.prev;
+  };
+  const auto pushFront = [&](const UInt idx) {
+    auto &entry = cache_[idx];
+    entry.prev = CACHE_NIL;
+    entry.next = cacheHead_;
+    if( cacheHead_ != CACHE_NIL ) cache_[cacheHead_].prev = idx;
+    cacheHead_ = idx;
+    if( cacheTail_ == CACHE_NIL ) cacheTail_ = idx;
+  };
+
+  const auto found = cacheIndex_.find( coordinate );
+  if( found != cacheIndex_.end() ) {
+    const UInt idx = found->second;
+    if( idx != cacheHead_ ) {
+      unlink( idx );
+      pushFront( idx );
+    }
+    return cache_[idx].hashes;
+  }
+
+  UInt idx;
+  if( cache_.size() < args_.cacheSize ) {
+    idx = (UInt) cache_.size();
+    cache_.push_back({ coordinate, {}, CACHE_NIL, CACHE_NIL });
+  }
+  else { // evict the least recently used coordinate
+    idx = cacheTail_;
+    unlink( idx );
+    cacheIndex_.erase( cache_[idx].coordinate );
+    cache_[idx].coordinate = coordinate;
+  }
+  cache_[idx].hashes = hash_( coordinate );
+  pushFront( idx );
+  cacheIndex_[coordinate] = idx;
+  return cache_[idx].hashes;
+}
+
+void CoordinateEncoder::encode(std::vector<Int64> input, SDR &output)
+{
+  NTA_CHECK( output.size == size );
+  NTA_CHECK( input.size() == args_.numDimensions )
+      << "Input has " << input.size() << " coordinates, expected " << args_.numDimensions << ".";
+
+  const size_t dims = args_.numDimensions;
+  for( size_t point = 0; point < candidates_.size(); ++point ) {
+    for( size_t d = 0; d < dims; ++d ) {
+      coordinate_[d] = input[d] + offsets_[point * dims + d];
+    }
+    candidates_[point] = cachedHash_( coordinate_ );
+  }
+
+  // Highest ranks first, ties broken by the bit so that the result does not
+  // depend on the order of the neighborhood.
+  const auto higher = [](const Hashes_ &a, const Hashes_ &b) {
+    return a.rank > b.rank or (a.rank == b.rank and a.bit > b.bit); };
+  std::nth_element( candidates_.begin(), candidates_.begin() + (args_.activeBits - 1u),
+                    candidates_.end(), higher );
+
+  auto &sparse = output.getSparse();
+  sparse.resize( args_.activeBits );
+  for( UInt i = 0u; i < args_.activeBits; ++i ) {
+    sparse[i] = candidates_[i].bit;
+  }
+  std::sort( sparse.begin(), sparse.end() );
+  sparse.erase( std::unique( sparse.begin(), sparse.end() ), sparse.end() );
+  output.setSparse( sparse );
+}
+
+std::ostream & operator<<(std::ostream & out, const CoordinateEncoder &self)
+{
+  out << "CoordinateEncoder \n";
+  out << "  size:          " << self.parameters.size          << ",\n";
+  out << "  activeBits:    " << self.parameters.activeBits    << ",\n";
+  out << "  sparsity:      " << self.parameters.sparsity      << ",\n";
+  out << "  numDimensions: " << self.parameters.numDimensions << ",\n";
+  out << "  radius:        " << self.parameters.radius        << ",\n";
+  out << "  seed:          " << self.parameters.seed          << ",\n";
+  return out;
+}
+
+} // end namespace htm
@@ -0,0 +1,192 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Define the CoordinateEncoder
+ */
+
+#ifndef NTA_ENCODERS_COORDINATE
+#define NTA_ENCODERS_COORDINATE
+
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include <htm/types/Types.hpp>
+#include <htm/encoders/BaseEncoder.hpp>
+
+namespace htm {
+
+/**
+ * Parameters for the CoordinateEncoder
+ *
+ * Members "activeBits" & "sparsity" are mutually exclusive, specify exactly one
+ * of them.
+ */
+struct CoordinateEncoderParameters
+{
+  /**
+   * Member "size" is the total number of bits in the encoded output SDR.
+   */
+  UInt size = 0u;
+
+  /**
+   * Member "activeBits" is the number of true bits in the encoded output SDR.
+   */
+  UInt activeBits = 0u;
+
+  /**
+   * Member "sparsity" is the fraction of bits in the encoded output which this
+   * encoder will activate. This is an alternative way to specify the member
+   * "activeBits".
+   */
+  Real sparsity = 0.0f;
+
+  /**
+   * Member "numDimensions" is the number of coordinates of an input, for
+   * example 2 for positions on a map.
+   */
+  UInt numDimensions = 0u;
+
+  /**
+   * Member "radius" is the half width of the neighborhood (a hypercube of
+   * 2 * radius + 1 coordinates per side) which the active bits are chosen
+   * from. Two inputs closer than 2 * radius in every dimension share part of
+   * their neighborhood, and so in general part of their active bits. It must
+   * be large enough for the neighborhood to have at least activeBits points.
+   */
+  UInt radius = 0u;
+
+  /**
+   * Member "seed" forces different encoders to produce different outputs, even
+   * if the inputs and all other parameters are the same.  Two encoders with the
+   * same seed, parameters, and input will produce identical outputs.
+   *
+   * The seed 0 is special.  Seed 0 is replaced with a random number.
+   */
+  UInt seed = 0u;
+
+  /**
+   * Member "cacheSize" is the number of coordinates whose hashes are kept in a
+   * least-recently-used cache. Consecutive nearby inputs share most of their
+   * neighborhood, so with a cache larger than one neighborhood they hash only
+   * the coordinates which are new. The default 0 disables the cache.  This
+   * does not change the output encoding, and is not saved by serialization.
+   */
+  UInt cacheSize = 0u;
+};
+
+/**
+ * Encodes a point in an integer coordinate space, such as a position on a
+ * grid or a quantized GPS location, as an SDR.
+ *
+ * Description:
+ * Every coordinate of the space is given a hashed rank and a hashed output
+ * bit. An input activates the bits of the activeBits highest ranked
+ * coordinates in its neighborhood, the hypercube of the given radius around
+ * it. Nearby inputs have overlapping neighborhoods, so they share the highest
+ * ranked coordinates of the overlap and thus some of their output bits; the
+ * closer the inputs the more bits they share. Hash collisions of the output
+ * bits can reduce the number of active bits slightly.
+ *
+ * The input is an integer vector of length numDimensions. To encode real
+ * valued positions, scale them so that one unit is the desired resolution.
+ *
+ * The neighborhood offsets are computed once with the Topology
+ * Neighborhood iterator, and the hashes are MurmurHash3, as in the RDSE.
+ */
+class CoordinateEncoder : public BaseEncoder<std::vector<Int64>>
+{
+public:
+  CoordinateEncoder() {}
+  CoordinateEncoder( const CoordinateEncoderParameters &parameters );
+  void initialize( const CoordinateEncoderParameters &parameters );
+
+  const CoordinateEncoderParameters &parameters = args_;
+
+  void encode(std::vector<Int64> input, SDR &output) override;
+
+  ~CoordinateEncoder() override {};
+
+  CerealAdapter;  // see Serializable.hpp
+  // FOR Cereal Serialization
+  template<class Archive>
+  void save_ar(Archive& ar) const {
+    std::string name = "CoordinateEncoder";
+    ar(cereal::make_nvp("name", name));
+    ar(cereal::make_nvp("size", args_.size));
+    ar(cereal::make_nvp("activeBits", args_.activeBits));
+    ar(cereal::make_nvp("numDimensions", args_.numDimensions));
+    ar(cereal::make_nvp("radius", args_.radius));
+    ar(cereal::make_nvp("seed", args_.seed));
+  }
+
+  // FOR Cereal Deserialization
+  template<class Archive>
+  void load_ar(Archive& ar) {
+    std::string name;
+    ar(cereal::make_nvp("name", name));
+    NTA_CHECK(name == "CoordinateEncoder");
+    CoordinateEncoderParameters p;
+    ar(cereal::make_nvp("size", p.size));
+    ar(cereal::make_nvp("activeBits", p.activeBits));
+    ar(cereal::make_nvp("numDimensions", p.numDimensions));
+    ar(cereal::make_nvp("radius", p.radius));
+    ar(cereal::make_nvp("seed", p.seed));
+    p.cacheSize = args_.cacheSize;
+    initialize( p );
+  }
+
+private:
+  CoordinateEncoderParameters args_;
+
+  // Offsets of the neighborhood points from its center, numDimensions per point.
+  std::vector<Int64> offsets_;
+
+  // Hashed rank and output bit of a coordinate.
+  struct Hashes_ {
+    UInt32 rank;
+    UInt   bit;
+  };
+
+  // Coordinate hash cache (least-recently-used), see cacheSize.
+  struct CoordinateHash_ {
+    size_t operator()(const std::vector<Int64> &coordinate) const;
+  };
+  struct CacheEntry_ {
+    std::vector<Int64> coordinate;
+    Hashes_ hashes;
+    UInt prev;
+    UInt next;
+  };
+  std::vector<CacheEntry_> cache_;
+  std::unordered_map<std::vector<Int64>, UInt, CoordinateHash_> cacheIndex_;
+  UInt cacheHead_ = std::numeric_limits<UInt>::max(); // most recently used
+  UInt cacheTail_ = std::numeric_limits<UInt>::max(); // least recently used
+
+  // Scratch buffers, reused between calls to encode().
+  std::vector<Int64> coordinate_;
+  std::vector<Hashes_> candidates_;
+
+  Hashes_ hash_(const std::vector<Int64> &coordinate) const;
+  Hashes_ cachedHash_(const std::vector<Int64> &coordinate);
+};
+
+std::ostream & operator<<(std::ostream & out, const CoordinateEncoder &self);
+
+} // end namespace htm
+#endif // NTA_ENCODERS_COORDINATE
@@ -24,6 +24,8 @@
 #include <memory> // make_shared()
 #include <time.h> // localtime(), struct tm
 #include <iostream> // cerr
+#include <cmath>    // round()
+#include <limits>   // quiet_NaN()
 
 #include <htm/encoders/DateEncoder.hpp>
 #include <htm/encoders/ScalarEncoder.hpp>
@@ -40,6 +42,14 @@ DateEncoder::DateEncoder(const DateEncoderParameters &parameters) { initialize(p
 
 void DateEncoder::initialize(const DateEncoderParameters &parameters) {
   args_ = parameters;
+  buckets_.clear();
+  seasonEncoder_.reset();
+  dayOfWeekEncoder_.reset();
+  weekendEncoder_.reset();
+  customDaysEncoder_.reset();
+  holidayEncoder_.reset();
+  timeOfDayEncoder_.reset();
+  customDays_.clear();
 
   // Check parameters
   size_t size = 0;
@@ -193,6 +203,30 @@ void DateEncoder::initialize(const DateEncoderParameters &parameters) {
 
   NTA_CHECK(size > 0u) << "DateEncoder: No parameters were provided.";
   BaseEncoder::initialize({static_cast<UInt32>(size)});
+
+  // Per attribute output cache, in the same order as buckets_.
+  fieldOutputs_.clear();
+  for (const auto &encoder : {seasonEncoder_, dayOfWeekEncoder_, weekendEncoder_,
+                              customDaysEncoder_, holidayEncoder_, timeOfDayEncoder_}) {
+    if (encoder) {
+      fieldOutputs_.emplace_back(encoder->dimensions);
+    }
+  }
+  fieldKeys_.assign(buckets_.size(), std::numeric_limits<Real64>::quiet_NaN());
+  holidayYear_ = -1;
+  holidayTimes_.clear();
+}
+
+const SDR &DateEncoder::encodeField_(ScalarEncoder &encoder, size_t attribute, Real64 value) {
+  const size_t field = bucketMap_[attribute];
+  // The sub-encoders' output only depends on the input's bucket.
+  const Real64 key = std::round((value - encoder.parameters.minimum) / encoder.parameters.resolution);
+  if (!(key == fieldKeys_[field])) { // NaN never matches
+    fieldKeys_[field] = std::numeric_limits<Real64>::quiet_NaN();
+    encoder.encode(value, fieldOutputs_[field]);
+    fieldKeys_[field] = key;
+  }
+  return fieldOutputs_[field];
 }
 
 
@@ -223,12 +257,6 @@ void DateEncoder::encode(struct std::tm timeinfo, SDR &output) {
   // -------------------------------------------------------------------------
   // Encode each sub-field
   std::vector<const SDR *> sdrs;
-  SDR season_output;
-  SDR dayOfWeek_output;
-  SDR weekend_output;
-  SDR customDay_output;
-  SDR holiday_output;
-  SDR timeOfDay_output;
   
    VERBOSE << "DateEncoder for " 
            <<  std::string(asctime(&timeinfo)).substr(0, 24) 
@@ -238,8 +266,7 @@ void DateEncoder::encode(struct std::tm timeinfo, SDR &output) {
   if (seasonEncoder_) {
     // Number the days into the year starting at 0 for Jan 1.
     Real64 dayOfYear = static_cast<Real64>(timeinfo.tm_yday);
-    season_output = SDR(seasonEncoder_->dimensions);
-    seasonEncoder_->encode(dayOfYear, season_output);
+    const SDR &season_output = encodeField_(*seasonEncoder_, SEASON, dayOfYear);
     buckets_[bucketMap_[SEASON]] = std::floor(dayOfYear/seasonEncoder_->parameters.radius);
     VERBOSE << "  season: " << dayOfYear << " ==> " << season_output;
     sdrs.push_back(&season_output);
@@ -247,8 +274,7 @@ void DateEncoder::encode(struct std::tm timeinfo, SDR &output) {
   if (dayOfWeekEncoder_) {
     // shift tm_wday so monday is 0.
     Real64 dayOfWeek = static_cast<Real64>((timeinfo.tm_wday + 6) % 7);
-    dayOfWeek_output = SDR(dayOfWeekEncoder_->dimensions);
-    dayOfWeekEncoder_->encode(dayOfWeek, dayOfWeek_output);
+    const SDR &dayOfWeek_output = encodeField_(*dayOfWeekEncoder_, DAYOFWEEK, dayOfWeek);
     buckets_[bucketMap_[DAYOFWEEK]] = dayOfWeek - std::fmod(dayOfWeek, dayOfWeekEncoder_->parameters.radius);
     VERBOSE << "  dayOfWeek: " << dayOfWeek << " ==> " << dayOfWeek_output;
     sdrs.push_back(&dayOfWeek_output);
@@ -261,8 +287,7 @@ void DateEncoder::encode(struct std::tm timeinfo, SDR &output) {
     } else {
       val = 0.0;
     }
-    weekend_output = SDR(weekendEncoder_->dimensions);
-    weekendEncoder_->encode(val, weekend_output);
+    const SDR &weekend_output = encodeField_(*weekendEncoder_, WEEKEND, val);
     buckets_[bucketMap_[WEEKEND]] = val;
     VERBOSE << "  weekend: " << val << " ==> " << weekend_output;
     sdrs.push_back(&weekend_output);
@@ -273,8 +298,7 @@ void DateEncoder::encode(struct std::tm timeinfo, SDR &output) {
     if (customDays_.find(timeinfo.tm_wday) != customDays_.end()) {
         customDay = 1.0;
     }
-    customDay_output = SDR(customDaysEncoder_->dimensions);
-    customDaysEncoder_->encode(customDay, customDay_output);
+    const SDR &customDay_output = encodeField_(*customDaysEncoder_, CUSTOM, customDay);
     buckets_[bucketMap_[CUSTOM]] = customDay;
     VERBOSE << "  custom Day: " << customDay << " ==> " << customDay_output;
     sdrs.push_back(&customDay_output);
@@ -287,13 +311,19 @@ void DateEncoder::encode(struct std::tm timeinfo, SDR &output) {
     Real64 val = 0.0;
     double SECONDS_PER_DAY = 86400.0;
     time_t input = std::mktime(&timeinfo);
-    for (auto h : args_.holiday_dates) {
-      std::time_t hdate;
-      if (h.size() == 3) {
-        hdate = mktime(h[0], h[1], h[2]);
-      } else {
-        hdate = mktime(timeinfo.tm_year + 1900, h[0], h[1]);
+    if (timeinfo.tm_year != holidayYear_) {
+      // Yearly holidays move with the year, convert them once per year.
+      holidayYear_ = timeinfo.tm_year;
+      holidayTimes_.clear();
+      for (const auto &h : args_.holiday_dates) {
+        if (h.size() == 3) {
+          holidayTimes_.push_back(mktime(h[0], h[1], h[2]));
+        } else {
+          holidayTimes_.push_back(mktime(timeinfo.tm_year + 1900, h[0], h[1]));
+        }
       }
+    }
+    for (const std::time_t hdate : holidayTimes_) {
       if (input > hdate) {
         // start of holiday is in the past.
         std::time_t diff = input - hdate;
@@ -317,16 +347,14 @@ void DateEncoder::encode(struct std::tm timeinfo, SDR &output) {
         }
       }
     }
-    holiday_output = SDR(holidayEncoder_->dimensions);
-    holidayEncoder_->encode(val, holiday_output);
+    const SDR &holiday_output = encodeField_(*holidayEncoder_, HOLIDAY, val);
     buckets_[bucketMap_[HOLIDAY]] = std::floor(val);
     VERBOSE << "  holiday: " << val << " ==> " << holiday_output;
     sdrs.push_back(&holiday_output);
   }
   if (timeOfDayEncoder_) {
     Real64 timeOfDay = timeinfo.tm_hour + timeinfo.tm_min / 60.0f + timeinfo.tm_sec / (60.0 * 60.0);
-    timeOfDay_output = SDR(timeOfDayEncoder_->dimensions);
-    timeOfDayEncoder_->encode(timeOfDay, timeOfDay_output);
+    const SDR &timeOfDay_output = encodeField_(*timeOfDayEncoder_, TIMEOFDAY, timeOfDay);
     buckets_[bucketMap_[TIMEOFDAY]] = timeOfDay - std::fmod(timeOfDay, timeOfDayEncoder_->parameters.radius);
     VERBOSE << "  timeOfDay: " << timeOfDay << "hrs ==> " << timeOfDay_output;
     sdrs.push_back(&timeOfDay_output);
@@ -233,6 +233,22 @@ private:
   size_t bucketMap_[6];
   std::vector<Real64> buckets_;
 
+  // Sub-encoder outputs from the last encoding, indexed like buckets_, and
+  // the quantized input which produced each of them (NaN if none yet).
+  std::vector<SDR> fieldOutputs_;
+  std::vector<Real64> fieldKeys_;
+
+  // Holiday start times for the year holidayYear_, in holiday_dates order.
+  int holidayYear_ = -1;
+  std::vector<std::time_t> holidayTimes_;
+
+  /**
+   * Encode one attribute with its sub-encoder, unless the quantized value
+   * is the same as last time, in which case the previous output is reused.
+   * Returns the attribute's output SDR.
+   */
+  const SDR &encodeField_(ScalarEncoder &encoder, size_t attribute, Real64 value);
+
 }; // end class DateEncoder
 
 std::ostream &operator<<(std::ostream &out, const DateEncoder &self);
@@ -0,0 +1,96 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the DeltaEncoder
+ */
+
+#include <htm/encoders/DeltaEncoder.hpp>
+
+namespace htm {
+
+DeltaEncoder::DeltaEncoder( const std::shared_ptr<BaseEncoder<Real64>> &encoder,
+                            const DeltaEncoderParameters &parameters )
+  { initialize( encoder, parameters ); }
+
+void DeltaEncoder::initialize( const std::shared_ptr<BaseEncoder<Real64>> &encoder,
+                               const DeltaEncoderParameters &parameters )
+{
+  NTA_CHECK( encoder != nullptr ) << "DeltaEncoder: missing the encoder to wrap.";
+  encoder_ = encoder;
+  args_    = parameters;
+  reset();
+  BaseEncoder<Real64>::initialize( encoder_->dimensions );
+}
+
+void DeltaEncoder::reset()
+{
+  hasPrevious_  = false;
+  previous_     = 0.0;
+  previousTime_ = 0.0;
+  delta_        = std::numeric_limits<Real64>::quiet_NaN();
+}
+
+void DeltaEncoder::encode(Real64 input, SDR &output)
+  { encode( input, previousTime_ + 1.0, output ); }
+
+void DeltaEncoder::encode(Real64 input, Real64 time, SDR &output)
+{
+  NTA_CHECK( output.size == size );
+  if( not hasPrevious_ ) {
+    delta_ = std::numeric_limits<Real64>::quiet_NaN();
+    output.zero();
+  }
+  else {
+    delta_ = input - previous_;
+    if( args_.rate ) {
+      NTA_CHECK( time > previousTime_ )
+        << "DeltaEncoder: time must increase, got " << time << " after " << previousTime_;
+      delta_ /= time - previousTime_;
+    }
+    encoder_->encode( delta_, output );
+  }
+  hasPrevious_  = true;
+  previous_     = input;
+  previousTime_ = time;
+}
+
+void DeltaEncoder::encodeBatch(const std::vector<Real64> &inputs, std::vector<SDR> &outputs)
+{
+  NTA_CHECK( inputs.size() == outputs.size() )
+    << "encodeBatch needs one output SDR per input, got "
+    << outputs.size() << " outputs for " << inputs.size() << " inputs.";
+  for( size_t i = 0; i < inputs.size(); ++i ) {
+    DeltaEncoder::encode( inputs[i], previousTime_ + 1.0, outputs[i] );
+  }
+}
+
+void DeltaEncoder::encodeBatch(const std::vector<Real64> &inputs, const std::vector<Real64> &times,
+                               std::vector<SDR> &outputs)
+{
+  NTA_CHECK( inputs.size() == outputs.size() )
+    << "encodeBatch needs one output SDR per input, got "
+    << outputs.size() << " outputs for " << inputs.size() << " inputs.";
+  NTA_CHECK( inputs.size() == times.size() )
+    << "encodeBatch needs one time per input, got "
+    << times.size() << " times for " << inputs.size() << " inputs.";
+  for( size_t i = 0; i < inputs.size(); ++i ) {
+    DeltaEncoder::encode( inputs[i], times[i], outputs[i] );
+  }
+}
+
+} // end namespace htm
@@ -0,0 +1,159 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Define the DeltaEncoder
+ */
+
+#ifndef NTA_ENCODERS_DELTA
+#define NTA_ENCODERS_DELTA
+
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <htm/types/Types.hpp>
+#include <htm/encoders/BaseEncoder.hpp>
+
+namespace htm {
+
+/**
+ * Parameters for the DeltaEncoder
+ */
+struct DeltaEncoderParameters
+{
+  /**
+   * Member "rate": if false the change of the value since the previous input
+   * is encoded, if true that change divided by the time elapsed since the
+   * previous input.  The time of an input is given to encode(), inputs
+   * without a time are one time unit after the previous input.
+   */
+  bool rate = false;
+};
+
+/**
+ * Encodes the change of a value between consecutive inputs, ie. its first
+ * difference or its rate of change, with another scalar encoder.
+ *
+ * Description:
+ * The DeltaEncoder keeps the previous input, and encodes the difference of
+ * every input to it with the wrapped encoder.  There is no previous input for
+ * the first input after construction or reset(), its output is empty.  The
+ * wrapped encoder determines the dimensions of the output, and must accept the
+ * range of the differences, for example a ScalarEncoder centered on zero or an
+ * RDSE.
+ *
+ * Serialization saves the previous input and the parameters, but not the
+ * wrapped encoder, which its owner serializes.  Deserialize into a
+ * DeltaEncoder which already wraps the restored encoder.
+ *
+ * Example:
+ *    auto rdse = std::make_shared<RDSE>( rdseParams );
+ *    DeltaEncoder encoder( rdse );
+ *    SDR output( encoder.dimensions );
+ *    encoder.encode( 10.0, output ); // empty
+ *    encoder.encode( 12.5, output ); // encodes 2.5
+ */
+class DeltaEncoder : public BaseEncoder<Real64>
+{
+public:
+  DeltaEncoder() {}
+  DeltaEncoder( const std::shared_ptr<BaseEncoder<Real64>> &encoder,
+                const DeltaEncoderParameters &parameters = DeltaEncoderParameters() );
+  void initialize( const std::shared_ptr<BaseEncoder<Real64>> &encoder,
+                   const DeltaEncoderParameters &parameters = DeltaEncoderParameters() );
+
+  const DeltaEncoderParameters &parameters = args_;
+
+  /**
+   * The wrapped encoder.
+   */
+  const std::shared_ptr<BaseEncoder<Real64>> &getEncoder() const { return encoder_; }
+
+  /**
+   * Forget the previous input, the next input is the first one again.
+   */
+  void reset() override;
+
+  /**
+   * Encode the change since the previous input.  The input is one time unit
+   * after the previous input.
+   */
+  void encode(Real64 input, SDR &output) override;
+
+  /**
+   * Encode the change since the previous input, at the given time.  The times
+   * of consecutive inputs must increase.
+   */
+  void encode(Real64 input, Real64 time, SDR &output);
+
+  /**
+   * Encode a sequence of inputs in order, see BaseEncoder::encodeBatch.  The
+   * first input is differenced against the previous input, the last input
+   * becomes the previous input of the next call.
+   */
+  void encodeBatch(const std::vector<Real64> &inputs, std::vector<SDR> &outputs) override;
+  void encodeBatch(const std::vector<Real64> &inputs, const std::vector<Real64> &times,
+                   std::vector<SDR> &outputs);
+
+  /**
+   * The difference or rate which the last input was encoded as.  This is NaN
+   * if there was no previous input.
+   */
+  Real64 getDelta() const { return delta_; }
+
+  ~DeltaEncoder() override {};
+
+  CerealAdapter;  // see Serializable.hpp
+  // FOR Cereal Serialization
+  template<class Archive>
+  void save_ar(Archive& ar) const {
+    std::string name = "DeltaEncoder";
+    ar(cereal::make_nvp("name", name));
+    ar(cereal::make_nvp("rate", args_.rate));
+    ar(cereal::make_nvp("hasPrevious", hasPrevious_));
+    ar(cereal::make_nvp("previous", previous_));
+    ar(cereal::make_nvp("previousTime", previousTime_));
+  }
+
+  // FOR Cereal Deserialization
+  template<class Archive>
+  void load_ar(Archive& ar) {
+    std::string name;
+    ar(cereal::make_nvp("name", name));
+    NTA_CHECK(name == "DeltaEncoder");
+    NTA_CHECK(encoder_ != nullptr)
+      << "DeltaEncoder: load into an encoder which wraps the restored encoder.";
+    ar(cereal::make_nvp("rate", args_.rate));
+    ar(cereal::make_nvp("hasPrevious", hasPrevious_));
+    ar(cereal::make_nvp("previous", previous_));
+    ar(cereal::make_nvp("previousTime", previousTime_));
+    delta_ = std::numeric_limits<Real64>::quiet_NaN();
+  }
+
+private:
+  DeltaEncoderParameters args_;
+  std::shared_ptr<BaseEncoder<Real64>> encoder_;
+
+  bool   hasPrevious_  = false;
+  Real64 previous_     = 0.0;
+  Real64 previousTime_ = 0.0;
+  Real64 delta_        = std::numeric_limits<Real64>::quiet_NaN();
+};
+
+} // end namespace htm
+#endif // NTA_ENCODERS_DELTA
@@ -0,0 +1,88 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the MultiEncoder
+ */
+
+#include <htm/encoders/MultiEncoder.hpp>
+
+namespace htm {
+
+MultiEncoder::MultiEncoder( const std::vector<std::shared_ptr<BaseEncoder<Real64>>> &encoders )
+  { initialize( encoders ); }
+
+void MultiEncoder::initialize( const std::vector<std::shared_ptr<BaseEncoder<Real64>>> &encoders )
+{
+  NTA_CHECK( not encoders.empty() ) << "MultiEncoder needs at least one sub-encoder.";
+  encoders_ = encoders;
+  offsets_.clear();
+  fieldOutputs_.clear();
+  UInt offset = 0u;
+  for( const auto &encoder : encoders_ ) {
+    NTA_CHECK( encoder != nullptr );
+    offsets_.push_back( offset );
+    fieldOutputs_.emplace_back( encoder->dimensions );
+    offset += encoder->size;
+  }
+  BaseEncoder<std::vector<Real64>>::initialize({ offset });
+}
+
+void MultiEncoder::encode(std::vector<Real64> input, SDR &output)
+{
+  NTA_CHECK( input.size() == encoders_.size() )
+    << "MultiEncoder expects one value per field, got " << input.size()
+    << " values for " << encoders_.size() << " fields.";
+  NTA_CHECK( output.size == size );
+
+  const auto encodeField = [&](const size_t field) {
+    encoders_[field]->encode( input[field], fieldOutputs_[field] );
+    fieldOutputs_[field].getSparse(); // convert on this thread
+  };
+  if( threadPool_ != nullptr and encoders_.size() > 1u ) {
+    threadPool_->parallelFor( encoders_.size(), encodeField );
+  }
+  else {
+    for( size_t field = 0; field < encoders_.size(); ++field ) {
+      encodeField( field );
+    }
+  }
+
+  // The fields are in output order, so shifting each field's sorted bits by
+  // its offset gives the sorted output.
+  auto &sparse = output.getSparse();
+  sparse.clear();
+  for( size_t field = 0; field < encoders_.size(); ++field ) {
+    const UInt offset = offsets_[field];
+    for( const auto bit : fieldOutputs_[field].getSparse() ) {
+      sparse.push_back( bit + offset );
+    }
+  }
+  output.setSparse( sparse );
+}
+
+void MultiEncoder::setNumThreads(const UInt numThreads)
+{
+  if( numThreads <= 1u ) {
+    threadPool_.reset();
+  }
+  else if( threadPool_ == nullptr or threadPool_->size() != numThreads ) {
+    threadPool_ = std::make_shared<ThreadPool>( numThreads );
+  }
+}
+
+} // end namespace htm
@@ -0,0 +1,159 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Define the MultiEncoder
+ */
+
+#ifndef NTA_ENCODERS_MULTI
+#define NTA_ENCODERS_MULTI
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <htm/types/Types.hpp>
+#include <htm/encoders/BaseEncoder.hpp>
+#include <htm/encoders/RandomDistributedScalarEncoder.hpp>
+#include <htm/encoders/ScalarEncoder.hpp>
+#include <htm/utils/ThreadPool.hpp>
+
+namespace htm {
+
+  /**
+   * The MultiEncoder encodes a record of several numeric fields into one SDR.
+   * Each field has its own sub-encoder, and the output is the concatenation
+   * of the sub-encodings in field order: field i occupies the bits
+   * [offsets[i], offsets[i] + encoder i's size).
+   *
+   * The sub-encodings are kept in SDRs owned by the MultiEncoder, which are
+   * reused for every record, and their bits are shifted straight into the
+   * output SDR. Compared with encoding into separate SDRs and calling
+   * SDR::concatenate, this allocates nothing in steady state.
+   *
+   * Example:
+   *    auto temperature = std::make_shared<ScalarEncoder>(scalarParams);
+   *    auto pressure    = std::make_shared<RandomDistributedScalarEncoder>(rdseParams);
+   *    MultiEncoder encoder({ temperature, pressure });
+   *    SDR output( encoder.dimensions );
+   *    encoder.encode({ 21.5, 1013.0 }, output);
+   *
+   * Serialization supports the sub-encoders ScalarEncoder and
+   * RandomDistributedScalarEncoder.
+   */
+  class MultiEncoder : public BaseEncoder<std::vector<Real64>>
+  {
+  public:
+    MultiEncoder() {};
+    MultiEncoder( const std::vector<std::shared_ptr<BaseEncoder<Real64>>> &encoders );
+    void initialize( const std::vector<std::shared_ptr<BaseEncoder<Real64>>> &encoders );
+
+    /**
+     * Number of fields in a record, and the first output bit of each field.
+     */
+    size_t numFields() const { return encoders_.size(); }
+    const std::vector<UInt> &offsets = offsets_;
+
+    /**
+     * The sub-encoder of a field.
+     */
+    const std::shared_ptr<BaseEncoder<Real64>> &getEncoder(const size_t field) const
+      { return encoders_.at( field ); }
+
+    /**
+     * Encode one record, one value per field, into an output SDR of this
+     * encoder's size.
+     */
+    void encode(std::vector<Real64> input, SDR &output) override;
+
+    /**
+     * Run the sub-encoders of a record on several threads. This pays off for
+     * wide records of costly sub-encoders; the output is the same either way.
+     * When threaded, each field must have its own encoder instance, as the
+     * encoders are not thread safe.
+     * The setting is not serialized, default is 1 (no extra threads).
+     *
+     * @param numThreads - number of threads including the caller, 0 or 1 turns
+     *   the threading off.
+     */
+    void setNumThreads(const UInt numThreads);
+    UInt getNumThreads() const noexcept {
+      return threadPool_ == nullptr ? 1u : static_cast<UInt>(threadPool_->size()); }
+
+    CerealAdapter;  // see Serializable.hpp
+    // FOR Cereal Serialization
+    template<class Archive>
+    void save_ar(Archive& ar) const {
+      std::string name = "MultiEncoder";
+      ar(cereal::make_nvp("name", name));
+      const size_t fields = encoders_.size();
+      ar(cereal::make_nvp("fields", fields));
+      for( const auto &encoder : encoders_ ) {
+        if( auto scalar = std::dynamic_pointer_cast<ScalarEncoder>( encoder )) {
+          ar(cereal::make_nvp("type", std::string("ScalarEncoder")));
+          ar(cereal::make_nvp("encoder", *scalar));
+        }
+        else if( auto rdse = std::dynamic_pointer_cast<RandomDistributedScalarEncoder>( encoder )) {
+          ar(cereal::make_nvp("type", std::string("RandomDistributedScalarEncoder")));
+          ar(cereal::make_nvp("encoder", *rdse));
+        }
+        else {
+          NTA_THROW << "MultiEncoder: can not serialize this type of sub-encoder.";
+        }
+      }
+    }
+
+    // FOR Cereal Deserialization
+    template<class Archive>
+    void load_ar(Archive& ar) {
+      std::string name;
+      ar(cereal::make_nvp("name", name));
+      NTA_CHECK( name == "MultiEncoder" );
+      size_t fields;
+      ar(cereal::make_nvp("fields", fields));
+      std::vector<std::shared_ptr<BaseEncoder<Real64>>> encoders;
+      for( size_t i = 0; i < fields; ++i ) {
+        std::string type;
+        ar(cereal::make_nvp("type", type));
+        if( type == "ScalarEncoder" ) {
+          auto scalar = std::make_shared<ScalarEncoder>();
+          ar(cereal::make_nvp("encoder", *scalar));
+          encoders.push_back( scalar );
+        }
+        else if( type == "RandomDistributedScalarEncoder" ) {
+          auto rdse = std::make_shared<RandomDistributedScalarEncoder>();
+          ar(cereal::make_nvp("encoder", *rdse));
+          encoders.push_back( rdse );
+        }
+        else {
+          NTA_THROW << "MultiEncoder: unknown sub-encoder type " << type;
+        }
+      }
+      initialize( encoders );
+    }
+
+    ~MultiEncoder() override {};
+
+  private:
+    std::vector<std::shared_ptr<BaseEncoder<Real64>>> encoders_;
+    std::vector<UInt> offsets_;
+    std::vector<SDR>  fieldOutputs_;
+    std::shared_ptr<ThreadPool> threadPool_; //null: single threaded
+  };   // end class MultiEncoder
+
+} // end namespace htm
+#endif // NTA_ENCODERS_MULTI
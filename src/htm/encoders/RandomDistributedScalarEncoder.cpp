@@ -22,7 +22,7 @@
 #include <htm/encoders/RandomDistributedScalarEncoder.hpp>
 #include <murmurhash3/MurmurHash3.hpp>
 #include <htm/utils/Random.hpp>
-#include <algorithm> // fill
+#include <algorithm> // sort, unique
 
 using namespace std;
 using namespace htm;
@@ -86,6 +86,7 @@ void RandomDistributedScalarEncoder::initialize( const RDSE_Parameters &paramete
   while( args_.seed == 0u ) {
     args_.seed = Random().getUInt32();
   }
+  cache_.clear();
 }
 
 void RandomDistributedScalarEncoder::encode(Real64 input, SDR &output)
@@ -101,10 +102,27 @@ void RandomDistributedScalarEncoder::encode(Real64 input, SDR &output)
       << "Input to category encoder must be an unsigned integer!";
   }
 
-  auto &data = output.getDense();
-  fill( data.begin(), data.end(), 0u );
-
   const UInt index = (UInt) (input / args_.resolution);
+  if( args_.cacheSize > 0u ) {
+    const auto cached = cache_.find( index );
+    if( cached != cache_.end() ) {
+      const SDR_sparse_t &bits = cached->second; // copy, do not swap
+      output.setSparse( bits );
+      return;
+    }
+  }
+
+  auto &sparse = output.getSparse();
+  hashBucket_( index, sparse );
+  if( cache_.size() < args_.cacheSize ) {
+    cache_.emplace( index, sparse );
+  }
+  output.setSparse( sparse );
+}
+
+void RandomDistributedScalarEncoder::hashBucket_(const UInt index, SDR_sparse_t &sparse) const
+{
+  sparse.resize( args_.activeBits );
   for(auto offset = 0u; offset < args_.activeBits; ++offset)
   {
     UInt hash_buffer = index + offset;
@@ -121,9 +139,22 @@ void RandomDistributedScalarEncoder::encode(Real64 input, SDR &output)
     // Exercise for the reader: Calculate the probability of a hash collision
     // and account for it in the sparsity.
 
-    data[bucket] = 1u;
+    sparse[offset] = bucket;
+  }
+  // Colliding buckets set the same bit, so the SDR is the same as if every
+  // bucket was written into a dense array.
+  std::sort( sparse.begin(), sparse.end() );
+  sparse.erase( std::unique( sparse.begin(), sparse.end() ), sparse.end() );
+}
+
+void RandomDistributedScalarEncoder::encodeBatch(const std::vector<Real64> &inputs, std::vector<SDR> &outputs)
+{
+  NTA_CHECK( inputs.size() == outputs.size() )
+    << "encodeBatch needs one output SDR per input, got "
+    << outputs.size() << " outputs for " << inputs.size() << " inputs.";
+  for( size_t i = 0; i < inputs.size(); ++i ) {
+    RandomDistributedScalarEncoder::encode( inputs[i], outputs[i] );
   }
-  output.setDense( data );
 }
 
 std::ostream & htm::operator<<(std::ostream & out, const RandomDistributedScalarEncoder &self)
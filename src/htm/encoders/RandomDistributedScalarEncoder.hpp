@@ -22,6 +22,7 @@
 #ifndef NTA_ENCODERS_RDSE
 #define NTA_ENCODERS_RDSE
 
+#include <unordered_map>
 #include <htm/encoders/BaseEncoder.hpp>
 #include <htm/utils/Log.hpp>
 
@@ -84,6 +85,16 @@ struct RDSE_Parameters
    * The seed 0 is special.  Seed 0 is replaced with a random number.
    */
   UInt seed = 0u;
+
+  /**
+   * Member "cacheSize" is the maximum number of buckets whose encodings are
+   * memoized, so that encoding a value in a cached bucket skips hashing.  The
+   * cache fills lazily with the first distinct buckets seen, and stops growing
+   * once full.  It uses about (activeBits * 4) bytes per bucket.  The default 0
+   * disables the cache.  This does not change the output encoding, and is not
+   * saved by serialization.
+   */
+  UInt cacheSize = 0u;
 };
 
 /**
@@ -120,6 +131,11 @@ public:
 
   void encode(Real64 input, SDR &output) override;
 
+  /**
+   * Batch version of encode(), see BaseEncoder::encodeBatch.
+   */
+  void encodeBatch(const std::vector<Real64> &inputs, std::vector<SDR> &outputs) override;
+
 
   ~RandomDistributedScalarEncoder() override {};
 
@@ -153,9 +169,18 @@ public:
     ar(cereal::make_nvp("category", args_.category));
     ar(cereal::make_nvp("seed", args_.seed));
     BaseEncoder<Real64>::initialize({ parameters.size });
+    cache_.clear();
   }
 private:
   RDSE_Parameters args_;
+
+  // Memoized encodings, see RDSE_Parameters::cacheSize.
+  std::unordered_map<UInt, SDR_sparse_t> cache_;
+
+  /**
+   * Compute the sorted active bits for the bucket "index".
+   */
+  void hashBucket_(const UInt index, SDR_sparse_t &sparse) const;
 };
 
 typedef RandomDistributedScalarEncoder RDSE;
@@ -133,6 +133,15 @@ void ScalarEncoder::initialize(const ScalarEncoderParameters &parameters)
 
   // Initialize parent class.
   BaseEncoder<Real64>::initialize({ args_.size });
+  initializeRun_();
+}
+
+void ScalarEncoder::initializeRun_()
+{
+  runTemplate_.resize( args_.size );
+  std::iota( runTemplate_.begin(), runTemplate_.end(), 0u );
+  run_.clear();
+  run_.reserve( args_.activeBits );
 }
 
 void ScalarEncoder::encode(Real64 input, SDR &output)
@@ -172,20 +181,33 @@ void ScalarEncoder::encode(Real64 input, SDR &output)
     start = std::min(start, output.size - parameters.activeBits);
   }
 
-  auto &sparse = output.getSparse();
-  sparse.resize( parameters.activeBits );
-  std::iota( sparse.begin(), sparse.end(), start );
-
   if( parameters.periodic ) {
-    for( auto & bit : sparse ) {
-      if( bit >= output.size ) {
-        bit -= output.size;
-      }
-    }
-    std::sort( sparse.begin(),  sparse.end() );
+    start = start % output.size;
+  }
+  const auto run = runTemplate_.cbegin();
+  if( parameters.periodic and start + parameters.activeBits > output.size ) {
+    // The block wraps around the end of the SDR: the bits which wrapped come
+    // first in sorted order, followed by the rest of the block.
+    const UInt wrapped = start + parameters.activeBits - output.size;
+    run_.assign( run, run + wrapped );
+    run_.insert( run_.end(), run + start, runTemplate_.cend() );
   }
+  else {
+    run_.assign( run + start, run + start + parameters.activeBits );
+  }
+
+  // Swaps the output's previous sparse buffer into run_, for the next call.
+  output.setSparse( run_ );
+}
 
-  output.setSparse( sparse );
+void ScalarEncoder::encodeBatch(const std::vector<Real64> &inputs, std::vector<SDR> &outputs)
+{
+  NTA_CHECK( inputs.size() == outputs.size() )
+    << "encodeBatch needs one output SDR per input, got "
+    << outputs.size() << " outputs for " << inputs.size() << " inputs.";
+  for( size_t i = 0; i < inputs.size(); ++i ) {
+    ScalarEncoder::encode( inputs[i], outputs[i] );
+  }
 }
 
 std::ostream & operator<<(std::ostream & out, const ScalarEncoder &self)
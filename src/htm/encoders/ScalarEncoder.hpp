@@ -130,6 +130,11 @@ namespace htm {
 
     void encode(Real64 input, SDR &output) override;
 
+    /**
+     * Batch version of encode(), see BaseEncoder::encodeBatch.
+     */
+    void encodeBatch(const std::vector<Real64> &inputs, std::vector<SDR> &outputs) override;
+
 
     CerealAdapter;  // see Serializable.hpp
     // FOR Cereal Serialization
@@ -164,12 +169,26 @@ namespace htm {
       ar(cereal::make_nvp("size", args_.size));
       ar(cereal::make_nvp("radius", args_.radius));
       ar(cereal::make_nvp("resolution", args_.resolution));
+      BaseEncoder<Real64>::initialize({ args_.size });
+      initializeRun_();
     }
 
     ~ScalarEncoder() override {};
 
   private:
     ScalarEncoderParameters args_;
+
+    /**
+     * The output is always one contiguous run of active bits, or two runs when
+     * a periodic encoding wraps around the end of the SDR.  Every run is a
+     * slice of the identity template [0, size), so encode() copies slices of
+     * it into a scratch buffer which is then swapped into the output SDR.
+     * This never reads the output's previous value.
+     */
+    SDR_sparse_t runTemplate_;
+    SDR_sparse_t run_;
+
+    void initializeRun_();
   };   // end class ScalarEncoder
 
   std::ostream & operator<<(std::ostream & out, const ScalarEncoder &self);
@@ -22,7 +22,7 @@
  */
 
 #include <algorithm>  // transform
-#include <bitset>     // to_string
+#include <array>
 #include <cctype>     // tolower
 #include <climits>    // CHAR_BIT
 #include <regex>
@@ -36,6 +36,8 @@
 
 namespace htm {
 
+  static const UInt CACHE_NIL = std::numeric_limits<UInt>::max();
+
   /**
    * Constructor
    * @see SimHashDocumentEncoder.hpp
@@ -107,6 +109,8 @@ namespace htm {
 
     // Initialize parent class with finalized params
     BaseEncoder<std::vector<std::string>>::initialize({ args_.size });
+
+    clearCache_();
   } // end method initialize
 
   /**
@@ -116,20 +120,26 @@ namespace htm {
    */
   void SimHashDocumentEncoder::encode(const std::vector<std::string> input, SDR &output)
   {
-    Eigen::MatrixXi adders(args_.size, 0u);
-    Eigen::VectorXi hashBits(args_.size);
-    std::map<std::string, UInt> histogramToken = {};
-    SDR result({ args_.size });
-    std::vector<UInt> simBits(args_.size, 0u);
+    encodeDocument_(input, output, scratch_, false);
+  } // end method encode
 
-    hashBits = Eigen::VectorXi::Zero(args_.size);
-    result.zero();
+  /**
+   * EncodeDocument_
+   * @see SimHashDocumentEncoder.hpp
+   */
+  void SimHashDocumentEncoder::encodeDocument_(const std::vector<std::string> &input, SDR &output,
+                                               Scratch_ &scratch, const bool sharedCache)
+  {
+    std::map<std::string, UInt> histogramToken = {};
 
     if (!input.size()) {
-      output.setDense(result.getDense());
+      output.zero();
       return;
     }
 
+    // padded to whole bytes, see addBitsToSums_()
+    scratch.sums.assign(((args_.size + CHAR_BIT - 1u) / CHAR_BIT) * CHAR_BIT, 0);
+
     for (const auto& member : input) {
       std::string token = member;
       UInt tokenWeight = 1;  // default weight for non-vocab and vocab-orphan
@@ -184,24 +194,19 @@ namespace htm {
           }
 
           // hash character
-          hashToken_(letterStr, hashBits);
-          bitsToWeightedAdder_(charWeight, hashBits);
-          addVectorToMatrix_(hashBits, adders);
+          addBitsToSums_(charWeight, tokenBits_(letterStr, scratch.hashBits, sharedCache), scratch.sums);
         }
         tokenWeight = (UInt) (tokenWeight * 1.5); // try to balance token with letters
       }
 
       // generate hash digest for whole token string
-      hashToken_(token, hashBits);
-      bitsToWeightedAdder_(tokenWeight, hashBits);
-      addVectorToMatrix_(hashBits, adders);
+      addBitsToSums_(tokenWeight, tokenBits_(token, scratch.hashBits, sharedCache), scratch.sums);
     }
 
     // simhash
-    simHashAdders_(adders, simBits);
-    result.setDense(simBits);
-    output.setDense(result.getDense());
-  } // end method encode
+    simHashSums_(scratch.sums, scratch.simBits);
+    output.setDense(scratch.simBits);
+  } // end method encodeDocument_
 
   /**
    * Encode (Alternate calling style: Simple string method)
@@ -222,84 +227,209 @@ namespace htm {
   } // end method encode (string alternate)
 
   /**
-   * AddVectorToMatrix_
+   * Encode Batch
    * @see SimHashDocumentEncoder.hpp
    */
-  void SimHashDocumentEncoder::addVectorToMatrix_(const Eigen::VectorXi vector, Eigen::MatrixXi &matrix)
+  void SimHashDocumentEncoder::encodeBatch(const std::vector<std::vector<std::string>> &inputs,
+                                           std::vector<SDR> &outputs)
   {
-    matrix.conservativeResize(Eigen::NoChange, matrix.cols() + 1u);
-    matrix.col(matrix.cols() - 1u) = vector;
-  } // end method addVectorToMatrix_
+    NTA_CHECK(inputs.size() == outputs.size())
+      << "encodeBatch needs one output SDR per input, got "
+      << outputs.size() << " outputs for " << inputs.size() << " inputs.";
+    if (threadPool_ == nullptr || inputs.size() < 2u) {
+      for (size_t i = 0u; i < inputs.size(); i++) {
+        encodeDocument_(inputs[i], outputs[i], scratch_, false);
+      }
+      return;
+    }
+
+    // One contiguous chunk of documents per thread, with its own scratch.
+    const size_t chunks = std::min(threadPool_->size(), inputs.size());
+    batchScratch_.resize(chunks);
+    threadPool_->parallelFor(chunks, [&](const size_t chunk) {
+      const size_t begin = inputs.size() * chunk / chunks;
+      const size_t end = inputs.size() * (chunk + 1u) / chunks;
+      for (size_t i = begin; i < end; i++) {
+        encodeDocument_(inputs[i], outputs[i], batchScratch_[chunk], true);
+        outputs[i].getSparse(); // convert on this thread
+      }
+    });
+  } // end method encodeBatch
 
   /**
-   * BitsToWeightedAdder_
+   * SetNumThreads
    * @see SimHashDocumentEncoder.hpp
    */
-  void SimHashDocumentEncoder::bitsToWeightedAdder_(const UInt weight, Eigen::VectorXi &vector)
+  void SimHashDocumentEncoder::setNumThreads(const UInt numThreads)
   {
-    // convert hash bit columns to int adder columns (0 => -1)
-    vector = (vector.array() == 0u).select(-1, vector);
-    // weight the adders
-    vector *= weight;
-  } // end method bitsToWeightedAdder_
+    if (numThreads <= 1u) {
+      threadPool_.reset();
+      batchScratch_.clear();
+    }
+    else if (threadPool_ == nullptr || threadPool_->size() != numThreads) {
+      threadPool_ = std::make_shared<ThreadPool>(numThreads);
+    }
+  } // end method setNumThreads
 
   /**
-   * bytesToBits_
+   * AddBitsToSums_
    * @see SimHashDocumentEncoder.hpp
    */
-  void SimHashDocumentEncoder::bytesToBits_(const std::vector<unsigned char> bytes, Eigen::VectorXi &bits)
+  void SimHashDocumentEncoder::addBitsToSums_(const UInt weight, const std::vector<unsigned char> &bits,
+                                              std::vector<Int> &sums) const
   {
-    UInt bitcount = 0u;
-    bits = Eigen::VectorXi::Zero(args_.size);
-
-    for (const auto& byte : bytes) {
-      for (const auto& bit : std::bitset<CHAR_BIT>(byte).to_string()) {
-        bits(bitcount) = (UInt) (bit - '0');
-        bitcount++;
-        if (bitcount >= args_.size - 1) break;
+    // adders for all 256 byte values, most significant bit first (0 => -1)
+    static const auto adders = []() {
+      std::array<std::array<Int, CHAR_BIT>, 256u> table;
+      for (UInt byte = 0u; byte < 256u; byte++) {
+        for (UInt bit = 0u; bit < CHAR_BIT; bit++) {
+          table[byte][bit] = ((byte >> (CHAR_BIT - 1u - bit)) & 1u) ? 1 : -1;
+        }
+      }
+      return table;
+    }();
+
+    const Int w = (Int) weight;
+    Int *sum = sums.data();
+    for (const auto byte : bits) {
+      const auto &adder = adders[byte];
+      for (UInt bit = 0u; bit < CHAR_BIT; bit++) {
+        sum[bit] += w * adder[bit];
       }
+      sum += CHAR_BIT;
     }
-  } // end method bytesToBits_
+  } // end method addBitsToSums_
+
+  /**
+   * ClearCache_
+   * @see SimHashDocumentEncoder.hpp
+   */
+  void SimHashDocumentEncoder::clearCache_()
+  {
+    cache_.clear();
+    cacheIndex_.clear();
+    cacheHead_ = CACHE_NIL;
+    cacheTail_ = CACHE_NIL;
+  } // end method clearCache_
 
   /**
    * HashToken_
    * @see SimHashDocumentEncoder.hpp
    */
-  void SimHashDocumentEncoder::hashToken_(const std::string token, Eigen::VectorXi &hashBits)
+  void SimHashDocumentEncoder::hashToken_(const std::string &token, std::vector<unsigned char> &hashBits) const
   {
     digestpp::shake256 hasher;
-    std::vector<unsigned char> digest;
+    const UInt numBytes = (args_.size / CHAR_BIT) + 1u;
 
+    hashBits.resize(numBytes);
     hasher.absorb(token);
-    hasher.squeeze((UInt) ((args_.size / CHAR_BIT) + 1u), back_inserter(digest));
-    bytesToBits_(digest, hashBits);
+    hasher.squeeze(numBytes, hashBits.begin());
+
+    // The digest stream supplies bits 0 to size-2. The last bit is the
+    // leading bit of the byte after them, which the digest only has when
+    // 'size' is 0 or 1 modulo 8, and stays 0 otherwise.
+    const UInt last = args_.size - 1u;
+    const unsigned char mask = (unsigned char) (0x80u >> (last % CHAR_BIT));
+    const UInt next = ((args_.size - 2u) / CHAR_BIT) + 1u;
+    const bool lastBit = (next < numBytes) && (hashBits[next] & 0x80u);
+    hashBits.resize((args_.size + CHAR_BIT - 1u) / CHAR_BIT);
+    if (lastBit) {
+      hashBits[last / CHAR_BIT] |= mask;
+    }
+    else {
+      hashBits[last / CHAR_BIT] &= (unsigned char) ~mask;
+    }
+    // zero the padding past 'size'
+    if (args_.size % CHAR_BIT) {
+      hashBits.back() &= (unsigned char) (0xFFu << (CHAR_BIT - args_.size % CHAR_BIT));
+    }
   } // end method hashToken_
 
   /**
-   * SimHashAdders_
+   * TokenBits_
+   * @see SimHashDocumentEncoder.hpp
+   */
+  const std::vector<unsigned char> &SimHashDocumentEncoder::tokenBits_(const std::string &token,
+                                                                      std::vector<unsigned char> &hashBits,
+                                                                      const bool sharedCache)
+  {
+    if (args_.tokenCacheSize == 0u) {
+      hashToken_(token, hashBits);
+      return hashBits;
+    }
+    if (sharedCache) {
+      const auto found = cacheIndex_.find(token);
+      if (found != cacheIndex_.end()) {
+        return cache_[found->second].bits;
+      }
+      hashToken_(token, hashBits);
+      return hashBits;
+    }
+
+    const auto unlink = [&](const UInt idx) {
+      auto &entry = cache_[idx];
+      if (entry.prev != CACHE_NIL) cache_[entry.prev].next = entry.next;
+      else cacheHead_ = entry.next;
+      if (entry.next != CACHE_NIL) cache_[entry.next].prev = entry.prev;
+      else cacheTail_ = entry.prev;
+    };
+    const auto pushFront = [&](const UInt idx) {
+      auto &entry = cache_[idx];
+      entry.prev = CACHE_NIL;
+      entry.next = cacheHead_;
+      if (cacheHead_ != CACHE_NIL) cache_[cacheHead_].prev = idx;
+      cacheHead_ = idx;
+      if (cacheTail_ == CACHE_NIL) cacheTail_ = idx;
+    };
+
+    const auto found = cacheIndex_.find(token);
+    if (found != cacheIndex_.end()) {
+      const UInt idx = found->second;
+      if (idx != cacheHead_) {
+        unlink(idx);
+        pushFront(idx);
+      }
+      return cache_[idx].bits;
+    }
+
+    UInt idx;
+    if (cache_.size() < args_.tokenCacheSize) {
+      idx = (UInt) cache_.size();
+      cache_.push_back({ token, {}, CACHE_NIL, CACHE_NIL });
+    }
+    else { // evict the least recently used digest
+      idx = cacheTail_;
+      unlink(idx);
+      cacheIndex_.erase(cache_[idx].token);
+      cache_[idx].token = token;
+    }
+    hashToken_(token, cache_[idx].bits);
+    pushFront(idx);
+    cacheIndex_[token] = idx;
+    return cache_[idx].bits;
+  } // end method tokenBits_
+
+  /**
+   * SimHashSums_
    * @see SimHashDocumentEncoder.hpp
    */
-  void SimHashDocumentEncoder::simHashAdders_(const Eigen::MatrixXi adders, std::vector<UInt> &simhash)
+  void SimHashDocumentEncoder::simHashSums_(std::vector<Int> &sums, SDR_dense_t &simhash) const
   {
-    Eigen::VectorXi::Index maxIndex;  // array index of current max member
-    Int minValue;                     // min value, used to neuter max vals during sparsify
-    Eigen::VectorXi sums(args_.size); // for bit sums of all hashes passed in
+    const auto begin = sums.begin();
+    const auto end = sums.begin() + args_.size; // skip byte padding
 
-    std::fill(simhash.begin(), simhash.end(), 0u);
-    sums = Eigen::VectorXi::Zero(adders.cols());
+    simhash.assign(args_.size, 0u);
 
-    // sum adder columns
-    sums = adders.rowwise().sum();
     // sparse simhash: top-N sums replaced with a binary 1, rest 0.
-    minValue = sums.minCoeff();
+    const Int minValue = *std::min_element(begin, end);
     for (UInt bit = 0u; bit < args_.activeBits; bit++) {
       // get index of current max value from vector, set bit in output
-      sums.maxCoeff(&maxIndex);
-      simhash[maxIndex] = 1u;
+      const auto maxIt = std::max_element(begin, end);
+      simhash[maxIt - begin] = 1u;
       // neuter this max value so next iteration will get next highest max
-      sums(maxIndex) = minValue;
+      *maxIt = minValue;
     }
-  } // end method simHashAdders_
+  } // end method simHashSums_
 
 
   // Debug
@@ -314,6 +444,7 @@ namespace htm {
     out << "  excludes.size:    " << self.parameters.excludes.size()   << ",\n";
     out << "  size:             " << self.parameters.size              << ",\n";
     out << "  sparsity:         " << self.parameters.sparsity          << ",\n";
+    out << "  tokenCacheSize:   " << self.parameters.tokenCacheSize    << ",\n";
     out << "  tokenSimilarity:  " << self.parameters.tokenSimilarity   << ",\n";
     out << "  vocabulary.size:  " << self.parameters.vocabulary.size() << ",\n";
     return out;
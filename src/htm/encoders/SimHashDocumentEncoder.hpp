@@ -24,12 +24,15 @@
 #ifndef NTA_ENCODERS_SIMHASH_DOCUMENT
 #define NTA_ENCODERS_SIMHASH_DOCUMENT
 
-#include <Eigen/Dense>
+#include <limits>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <htm/encoders/BaseEncoder.hpp>
 #include <htm/types/Types.hpp>
+#include <htm/utils/ThreadPool.hpp>
 
 
 namespace htm {
@@ -103,6 +106,14 @@ namespace htm {
      */
     Real sparsity = 0.0f;
 
+    /**
+     * @param :tokenCacheSize: Number of token (and letter) hash digests kept
+     *  in a least-recently-used cache, so that tokens which repeat across
+     *  documents are only hashed once. A setting of 0 disables the cache.
+     *  This does not change the output encoding.
+     */
+    UInt tokenCacheSize = 1024u;
+
     /**
      * @param :tokenSimilarity: In addition to document similarity, we can also
      *  achieve a kind of token similarity. Default is FALSE (providing better
@@ -194,10 +205,10 @@ namespace htm {
      * Encode (Main calling style)
      *
      * Each token will be hashed with SHA3+SHAKE256 to get a binary digest
-     * output of desired `size`. These vectors will be stored in a matrix for
-     * the next step of processing. Weights from the `vocabulary` are added in
-     * during hashing and simhashing. After the loop, we SimHash the matrix of
-     * hashes, resulting in an output SDR. If param "tokenSimilarity" is set,
+     * output of desired `size`. Each digest is added (bit 1 => +weight,
+     * bit 0 => -weight) into a running vector of adder sums, using weights
+     * from the `vocabulary`. After the loop, we SimHash the adder sums,
+     * resulting in an output SDR. If param "tokenSimilarity" is set,
      * we'll also loop and hash through all the letters in the tokens.
      *
      * @param :input: Document token strings to encode, ex: {"what","is","up"}.
@@ -226,6 +237,30 @@ namespace htm {
      */
     void encode(const std::string input, SDR &output);
 
+    /**
+     * Encode Batch
+     *
+     * Encode many independent documents, each into the output SDR at the
+     * same index, see BaseEncoder::encodeBatch. With setNumThreads() > 1 the
+     * documents are tokenized and hashed in parallel, each thread with its
+     * own adder sums; the vocabulary, the exclusions and the token cache are
+     * only read then, tokens missing from the cache are hashed without
+     * caching them. The outputs are those of encode(), in input order.
+     *
+     * @param :inputs: Documents, as for encode().
+     * @param :outputs: One SDR of this encoder's dimensions per document.
+     */
+    void encodeBatch(const std::vector<std::vector<std::string>> &inputs,
+                     std::vector<SDR> &outputs) override;
+
+    /**
+     * Number of threads encodeBatch() uses, including the caller; 0 or 1 is
+     * single threaded (default). Not serialized.
+     */
+    void setNumThreads(const UInt numThreads);
+    UInt getNumThreads() const {
+      return threadPool_ == nullptr ? 1u : static_cast<UInt>(threadPool_->size()); }
+
     /**
      * Serialization
      */
@@ -262,6 +297,7 @@ namespace htm {
       ar(cereal::make_nvp("tokenSimilarity", args_.tokenSimilarity));
       ar(cereal::make_nvp("vocabulary", args_.vocabulary));
       BaseEncoder<std::vector<std::string>>::initialize({ args_.size });
+      clearCache_();
     }
 
     ~SimHashDocumentEncoder() override {};
@@ -271,64 +307,104 @@ namespace htm {
     // Private Params
     SimHashDocumentEncoderParameters args_;
 
+    // Token digest cache (least-recently-used), see `tokenCacheSize`.
+    struct CacheEntry_ {
+      std::string token;
+      std::vector<unsigned char> bits;
+      UInt prev;
+      UInt next;
+    };
+    std::vector<CacheEntry_> cache_;
+    std::unordered_map<std::string, UInt> cacheIndex_;
+    UInt cacheHead_ = std::numeric_limits<UInt>::max(); // most recently used
+    UInt cacheTail_ = std::numeric_limits<UInt>::max(); // least recently used
+
+    // Scratch buffers, reused between calls to encode(); encodeBatch() has
+    // one per thread.
+    struct Scratch_ {
+      std::vector<unsigned char> hashBits;
+      std::vector<Int> sums;
+      SDR_dense_t simBits;
+    };
+    Scratch_ scratch_;
+    std::vector<Scratch_> batchScratch_;
+    std::shared_ptr<ThreadPool> threadPool_; //null: single threaded
+
     /**
-     * AddVectorToMatrix_
+     * AddBitsToSums_
+     *
+     * Add a packed hash digest to the running adder sums, as weighted
+     *  "Adder" columns: a bit 1 adds `weight`, a bit 0 subtracts it. For
+     *  example:
+     *    In Bits     = { 0, 1,  0,  0, 1,  0}
+     *    In Weight   = 3
+     *    Sums       += {-3, 3, -3, -3, 3, -3}
      *
-     * @param :vector: Source eigen vector column to be attached.
-     * @param :matrix: Target eigen matrix that will be added to.
+     * @param :weight: Weight of the digest (positive integer, usually 1).
+     * @param :bits: Packed hash digest, most significant bit first.
+     * @param :sums: Adder sums, `size` padded to whole bytes.
      */
-    void addVectorToMatrix_(const Eigen::VectorXi vector, Eigen::MatrixXi &matrix);
+    void addBitsToSums_(const UInt weight, const std::vector<unsigned char> &bits,
+                        std::vector<Int> &sums) const;
 
     /**
-     * BitsToWeightedAdder_
+     * ClearCache_
      *
-     * Take the bits from a hash, convert 0 to -1, and multiply by provided
-     *  weighting factor. For example:
-     *    In Column   = { 0, 1,  0,  0, 1,  0}
-     *    In Weight   = 3
-     *    Out Result  = {-3, 3, -3, -3, 3, -3}
+     * Drop all cached token digests, they depend on the `size` parameter.
+     */
+    void clearCache_();
+
+    /**
+     * HashToken_
+     *
+     * Hash (SHA3+SHAKE256) a string into a byte digest, packed 8 bits per
+     *  byte (most significant bit first), `size` bits in total.
      *
-     * @param :weight: Weight to add to column (positive integer, usually 1).
-     * @param :vector: Target eigen vector column to add weighting to.
+     * @param :token: Source text to be hashed.
+     * @param :hashBits: Byte vector to store result binary hash digest in.
      */
-    void bitsToWeightedAdder_(const UInt weight, Eigen::VectorXi &vector);
+    void hashToken_(const std::string &token, std::vector<unsigned char> &hashBits) const;
 
     /**
-     * BytesToBits_
+     * EncodeDocument_
      *
-     * Convert vector of hashed digest bytes to longer vector of bits.
+     * The body of encode(), with the given scratch buffers.
      *
-     * @param :bytes: Source hash (eigen byte vector) for binary conversion.
-     * @param :bits: Eigen vector to store converted binary hash digest in.
+     * @param :sharedCache: Only read the token cache, see encodeBatch().
      */
-    void bytesToBits_(const std::vector<unsigned char> bytes, Eigen::VectorXi &bits);
+    void encodeDocument_(const std::vector<std::string> &input, SDR &output,
+                         Scratch_ &scratch, bool sharedCache);
 
     /**
-     * HashToken_
+     * TokenBits_
      *
-     * Hash (SHA3+SHAKE256) a string into a byte digest.
-     * Convert the byte vector to a binary vector and set output.
+     * Packed hash digest of a token, looked up in the token cache first and
+     *  hashed (and cached) on a miss. The returned reference is only valid
+     *  until the next call.
      *
      * @param :token: Source text to be hashed.
-     * @param :hashBits: Eigen vector to store result binary hash digest in.
+     * @param :hashBits: Buffer for the digest of a token which is not cached.
+     * @param :sharedCache: Neither update nor add to the cache, which other
+     *  threads read meanwhile.
      */
-    void hashToken_(const std::string token, Eigen::VectorXi &hashBits);
+    const std::vector<unsigned char> &tokenBits_(const std::string &token,
+                                                 std::vector<unsigned char> &hashBits,
+                                                 bool sharedCache);
 
     /**
-     * SimHashAdders_
+     * SimHashSums_
      *
-     * Create a SimHash SDR from Eigen vector array (matrix) of Hash digest
-     *  bits (in slightly modified "Adder" SimHash form).
-     * Sum all these "Adder" vectors to get a type of binary histogram.
+     * Create a SimHash SDR from the summed hash digest "Adder" vectors, a
+     *  type of binary histogram.
      * Choose the desired number (activeBits) of max values, use their indices
      *  to set output On bits. Rest of bits are Off. We now have our result
      *  sparse SimHash. (In an ordinary dense SimHash, sums >= 0 become
      *  binary 1, the rest 0.)
      *
-     * @param :hashes: Source eigen matrix of hashes to be simhashed.
-     * @param :simhash: Stadard vector to store dense binary simhash result in.
+     * @param :sums: Adder sums, overwritten.
+     * @param :simhash: Dense binary vector to store the simhash result in.
      */
-    void simHashAdders_(const Eigen::MatrixXi adders, std::vector<UInt> &simhash);
+    void simHashSums_(std::vector<Int> &sums, SDR_dense_t &simhash) const;
     // end private
 
   }; // end class SimHashDocumentEncoder
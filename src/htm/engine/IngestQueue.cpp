@@ -0,0 +1,106 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the IngestQueue class
+ */
+
+#include <htm/engine/IngestQueue.hpp>
+
+#include <chrono>
+#include <thread>
+
+#include <htm/engine/Network.hpp>
+#include <htm/engine/Output.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+namespace {
+  // How long the producer sleeps when the queue is full, see beginPush().
+  const std::chrono::microseconds FULL_WAIT(50);
+} // namespace
+
+IngestQueue::Record::Record(const std::vector<Array> &data) {
+  for (const Array &a : data)
+    data_.push_back(a.copy());
+}
+
+IngestQueue::Record::Record(const Record &other) { *this = other; }
+
+IngestQueue::Record &IngestQueue::Record::operator=(const Record &other) {
+  if (this != &other) {
+    data_.clear();
+    for (const Array &a : other.data_)
+      data_.push_back(a.copy());
+  }
+  return *this;
+}
+
+namespace {
+  // A record of the current data of the INPUT outputs.
+  IngestQueue::Record prototype_(Network &net, const std::vector<std::string> &sources) {
+    NTA_CHECK(!sources.empty()) << "IngestQueue: no sources.";
+    net.initialize();
+    std::shared_ptr<Region> input = net.getRegion("INPUT");
+    std::vector<Array> data;
+    for (const auto &name : sources) {
+      std::shared_ptr<Output> out = input->getOutput(name);
+      NTA_CHECK(out != nullptr) << "IngestQueue: no link from the INPUT output '" << name << "'.";
+      const Array &a = out->getData();
+      NTA_CHECK(a.getCount() > 0u) << "IngestQueue: the INPUT output '" << name << "' has no dimensions.";
+      NTA_CHECK(a.getType() != NTA_BasicType_Str) << "IngestQueue: the INPUT output '" << name << "' is a string.";
+      data.push_back(a);
+    }
+    return IngestQueue::Record(data);
+  }
+} // namespace
+
+IngestQueue::IngestQueue(Network &net, const std::vector<std::string> &sources, const size_t capacity)
+    : sources_(sources), queue_(capacity, prototype_(net, sources)) {}
+
+IngestQueue::Record *IngestQueue::tryBeginPush() {
+  NTA_CHECK(!isClosed()) << "IngestQueue: push after close().";
+  return queue_.back();
+}
+
+IngestQueue::Record *IngestQueue::beginPush() {
+  Record *record = tryBeginPush();
+  if (record == nullptr) {
+    fullWaits_.fetch_add(1u, std::memory_order_relaxed);
+    do {
+      std::this_thread::sleep_for(FULL_WAIT); // backpressure: the Network is behind
+      record = queue_.back();
+    } while (record == nullptr);
+  }
+  return record;
+}
+
+void IngestQueue::endPush() {
+  queue_.push();
+  pushed_.fetch_add(1u, std::memory_order_release);
+}
+
+void IngestQueue::close() { closed_.store(true, std::memory_order_release); }
+
+void IngestQueue::pop_() {
+  queue_.pop();
+  popped_.fetch_add(1u, std::memory_order_release);
+}
+
+} // namespace htm
@@ -0,0 +1,135 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the IngestQueue class
+ */
+
+#ifndef NTA_INGEST_QUEUE_HPP
+#define NTA_INGEST_QUEUE_HPP
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <htm/ntypes/Array.hpp>
+#include <htm/types/Types.hpp>
+#include <htm/utils/SpscQueue.hpp>
+
+namespace htm {
+
+class Network;
+
+/**
+ * Records for the "INPUT" outputs of a Network (see RawInput), pushed by a
+ * producer thread while Network::runFromQueue() computes them on another,
+ * so that reading and parsing the input overlaps with the compute.
+ *
+ * A record holds the data of each of the named "INPUT" outputs, an Array of
+ * the output's type and size; an SDR is set through getSDR() or its dense
+ * getBuffer().  The records live in the slots of a bounded lock-free queue
+ * (SpscQueue), which the producer fills in place: nothing is allocated or
+ * locked per record.  When the queue is full beginPush() waits, which holds
+ * the producer back to the pace of the Network.
+ *
+ * Exactly one producer thread and one thread running the Network.
+ *
+ * Example:
+ *    net.link("INPUT", "encoder", "", "{dim: 1}", "value", "values");
+ *    net.initialize();
+ *    IngestQueue queue(net, {"value"}, 256);
+ *    std::thread producer([&]() {
+ *      while (parse(line)) {
+ *        IngestQueue::Record &r = *queue.beginPush();
+ *        static_cast<Real64 *>(r[0].getBuffer())[0] = parseValue(line);
+ *        queue.endPush();
+ *      }
+ *      queue.close();
+ *    });
+ *    net.runFromQueue(queue);  // until closed and empty
+ *    producer.join();
+ */
+class IngestQueue {
+public:
+  /** The data of one record, by the index of the output in sources(). */
+  class Record {
+  public:
+    Record() = default;
+    // Copies the buffers, so that the slots of the queue never share them.
+    explicit Record(const std::vector<Array> &data);
+    Record(const Record &other);
+    Record &operator=(const Record &other);
+
+    Array &operator[](size_t source) { return data_[source]; }
+    const Array &operator[](size_t source) const { return data_[source]; }
+    size_t size() const noexcept { return data_.size(); }
+
+  private:
+    std::vector<Array> data_;
+  };
+
+  /**
+   * @param net - an initialized Network, its "INPUT" outputs give the type
+   *   and size of the records.
+   * @param sources - names of the "INPUT" outputs a record sets.
+   * @param capacity - records buffered between the producer and the Network.
+   */
+  IngestQueue(Network &net, const std::vector<std::string> &sources, size_t capacity);
+
+  IngestQueue(const IngestQueue &) = delete;
+  IngestQueue &operator=(const IngestQueue &) = delete;
+
+  const std::vector<std::string> &sources() const noexcept { return sources_; }
+  size_t capacity() const { return queue_.capacity(); }
+
+  /**
+   * Producer: the record to fill next, it keeps the data of the record
+   * which was in the slot before.  Waits while the queue is full.
+   */
+  Record *beginPush();
+  /** Producer: as beginPush(), nullptr when the queue is full. */
+  Record *tryBeginPush();
+  /** Producer: makes the record of beginPush() visible to the Network. */
+  void endPush();
+  /** Producer: no more records follow, runFromQueue() returns once all ran. */
+  void close();
+
+  bool isClosed() const noexcept { return closed_.load(std::memory_order_acquire); }
+  /** Records pushed and not yet run. */
+  size_t available() const noexcept {
+    return static_cast<size_t>(pushed_.load(std::memory_order_acquire) - popped_.load(std::memory_order_acquire));
+  }
+  UInt64 getPushed() const noexcept { return pushed_.load(std::memory_order_relaxed); }
+  /** How many times beginPush() found the queue full. */
+  UInt64 getFullWaits() const noexcept { return fullWaits_.load(std::memory_order_relaxed); }
+
+private:
+  friend class Network; // the consumer, see Network::runFromQueue()
+  const Record *front_() { return queue_.front(); }
+  void pop_();
+
+  std::vector<std::string> sources_;
+  SpscQueue<Record> queue_;
+  std::atomic<bool> closed_{false};
+  std::atomic<UInt64> pushed_{0u};
+  std::atomic<UInt64> popped_{0u};
+  std::atomic<UInt64> fullWaits_{0u};
+};
+
+} // namespace htm
+
+#endif // NTA_INGEST_QUEUE_HPP
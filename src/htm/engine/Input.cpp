@@ -101,11 +101,30 @@ std::shared_ptr<Link> Input::findLink(const std::string &srcRegionName,
   return nullptr;
 }
 
-void Input::prepare() {
+void Input::prepare(bool snapshot) {
+  // The sources hold the data this input has already.
+  held_ = !links_.empty() && std::all_of(links_.begin(), links_.end(), [](const std::shared_ptr<Link> &link) {
+    return link->getPropagationDelay() == 0u && link->getSrc()->isHeld();
+  });
+  if (held_)
+    return;
+
+  // A Fan-In of SDRs merges the sparse indices of its sources, each offset
+  // to its section, rather than copying their dense buffers.
+  if (links_.size() > 1 && data_.getType() == NTA_BasicType_SDR
+      && std::all_of(links_.begin(), links_.end(), [](const std::shared_ptr<Link> &link) { return link->isSparse(); })) {
+    sparse_.clear();
+    for (auto &link : links_) {
+      link->appendSparse(sparse_);
+    }
+    data_.getSDRNoRefresh().setSparse(sparse_); // swaps, sparse_ is reused next time.
+    return;
+  }
+
   // Each link copies data into its section of the overall input
   // TODO: initialization check?
   for (auto &elem : links_) {
-    (elem)->compute();
+    (elem)->compute(snapshot);
   }
 }
 
@@ -316,6 +335,13 @@ void Input::initialize() {
   }
 
   initialized_ = true;
+
+  // For a Fan-In, sources may write straight into their slice of the buffer.
+  if (links_.size() > 1) {
+    for (auto &link : links_) {
+      link->shareDestinationBuffer();
+    }
+  }
 }
 
 void Input::uninitialize() {
@@ -341,6 +367,11 @@ void Input::resize() {
   }
   dim_ = {static_cast<UInt32>(count)};
   data_.allocateBuffer(count);
+  if (links_.size() > 1) {
+    for (auto &link : links_) {
+      link->shareDestinationBuffer();
+    }
+  }
 }
 
 namespace htm {
@@ -136,8 +136,17 @@ public:
    * Make input data available.
    *
    * Called by Region.prepareInputs()
+   *
+   * @param snapshot - see Link::compute()
+   */
+  void prepare(bool snapshot = false);
+
+  /**
+   * Did all links come from held outputs at the last prepare(), see
+   * Output::isHeld()?  Then prepare() copied nothing.  Delayed links are
+   * never held.
    */
-  void prepare();
+  bool isHeld() const { return held_; }
 
   /**
    *
@@ -148,11 +157,28 @@ public:
    */
   Array &getData() { NTA_CHECK(initialized_); return data_; }
   const Array &getData() const { NTA_CHECK(initialized_); return data_; }
+
+  /**
+   * The records of a batched run, filled only for regions which compute the
+   * batch at once, see RegionImpl::canComputeBatch().
+   * Record i is the value of this input in the i-th iteration of the batch.
+   */
+  std::vector<Array> &getBatch() { return batch_; }
+  const std::vector<Array> &getBatch() const { return batch_; }
   /**
    *  Get the data type of the output
    */
   NTA_BasicType getDataType() const { return data_.getType(); }
 
+  /**
+   * Change the data type given by the Spec, before the input is initialized.
+   * For regions which accept any type, see SharedMemoryOutputRegion.
+   */
+  void setDataType(NTA_BasicType type) {
+    NTA_CHECK(!initialized_) << "Input " << name_ << ": can't change the type once initialized";
+    data_ = Array(type);
+  }
+
   /**
    *
    * Get the Region that the input belongs to.
@@ -226,8 +252,13 @@ private:
   std::vector<std::shared_ptr<Link>> links_;
 
   bool initialized_;
+  bool held_ = false;
   Dimensions dim_;
   Array data_;
+  std::vector<Array> batch_;
+
+  // scratch for merging the sparse indices of a Fan-In of SDRs.
+  SDR_sparse_t sparse_;
 
   // Useful for us to know our own name
   std::string name_;
@@ -27,6 +27,7 @@
 #include <htm/ntypes/Array.hpp>
 #include <htm/ntypes/BasicType.hpp>
 #include <htm/utils/Log.hpp>
+#include <htm/utils/Tracer.hpp>
 
 // By calling  Network::setLogLevel(LogLevel_Verbose)
 // you can enable the NTA_DEBUG macros below.
@@ -112,6 +113,7 @@ void Link::initialize(size_t destinationOffset, bool is_FanIn) {
       delayedbuffer.zeroBuffer();
       propagationDelayBuffer_.push_back(delayedbuffer);
     }
+    delayHead_ = 0;
   }
 
   initialized_ = true;
@@ -206,7 +208,23 @@ Input* Link::getDest() const {
 }
 
 
-void Link::compute() {
+void Link::compute(bool snapshot) {
+  const bool traced = Tracer::isActive();
+  if (!profilingEnabled_ && !traced) {
+    compute_(snapshot);
+    return;
+  }
+  const UInt64 t0 = LatencyHistogram::now();
+  const char *copy = compute_(snapshot);
+  if (profilingEnabled_)
+    profile_.record(LatencyHistogram::now() - t0);
+  if (traced) {
+    const Array &src = src_->getData();
+    Tracer::record("link", getMoniker(), t0, src.getCount(), copy, BasicType::getName(src.getType()));
+  }
+}
+
+const char *Link::compute_(bool snapshot) {
   NTA_CHECK(initialized_);
 
   if (propagationDelay_) {
@@ -216,7 +234,7 @@ void Link::compute() {
 
   // Copy data from source to destination. For delayed links, will copy from
   // head of circular queue; otherwise directly from source.
-  const Array &src = propagationDelay_ ? propagationDelayBuffer_.front() : src_->getData();
+  const Array &src = propagationDelay_ ? propagationDelayBuffer_[delayHead_] : src_->getData();
   Array &dest = dest_->getData();
 
   NTA_DEBUG << "compute Link: copying " << getMoniker()
@@ -228,33 +246,148 @@ void Link::compute() {
         << "Not enough room in buffer to propogate to " << destRegionName_
         << " " << destInputName_ << ". ";
 
-  if (src.getType() == dest.getType() && !is_FanIn_ && propagationDelay_==0) {
-    dest = src;   // Performs a shallow copy. Data not copied but passed in shared_ptr.
+  if (isSharingDestinationBuffer_()) {
+    // The source already wrote its output in place.
+    if (snapshot) {
+      // The source will compute its next output while the destination still
+      // reads this one, so from now on the source needs its own buffer again.
+      src_->getData() = src.copy();
+    }
+    return "shared";
+  }
+
+  if (src.getType() == dest.getType() && !is_FanIn_ && propagationDelay_==0 && !sparseCopy_) {
+    if (snapshot)
+      dest = src.copy(); // The destination may share the source's buffer, replace it.
+    else
+      dest = src;   // Performs a shallow copy. Data not copied but passed in shared_ptr.
+    return snapshot ? "deep" : "shallow";
+  } else if (!is_FanIn_ && isSparse()) {
+    // Delayed SDR; only the active bits are copied.
+    const SDR_sparse_t &sparse = sourceSDR_().getSparse();
+    dest.getSDRNoRefresh().setSparse(sparse);
+    return "sparse";
   } else {
     // we must perform a deep copy with possible type conversion.
     // It is copied into the destination Input
     // buffer at the specified offset so an Input with multiple incoming links
     // has the Output buffers appended into a single large Input buffer.
     src.convertInto(dest, destOffset_, dest.getCount());
+    return "deep";
   }
 }
 
+void Link::shareDestinationBuffer() {
+  NTA_CHECK(initialized_);
+  Array &src = src_->getData();
+  Array &dest = dest_->getData();
+  const NTA_BasicType type = src.getType();
+  if (!is_FanIn_ || propagationDelay_ > 0 || src_->getLinkCount() != 1
+      || type != dest.getType() || type == NTA_BasicType_SDR || type == NTA_BasicType_Str
+      || src.getCount() + destOffset_ > dest.getCount())
+    return;
+
+  // Keep what the source has already written (normally zeros).
+  src.convertInto(dest, destOffset_, dest.getCount());
+  src.setBuffer(dest, destOffset_, src.getCount());
+}
+
+void Link::setSparseCopy(const bool sparseCopy) {
+  NTA_CHECK(!sparseCopy || isSparse()) << "Link " << getMoniker() << ": setSparseCopy needs SDRs at both ends";
+  sparseCopy_ = sparseCopy;
+  if (!sparseCopy_)
+    return;
+  // After a shallow copy the destination still holds the source's SDR.
+  Array &dest = dest_->getData();
+  if (!is_FanIn_ && dest.has_buffer() && &dest.getSDRNoRefresh() == &src_->getData().getSDRNoRefresh())
+    dest = dest.copy();
+}
+
+bool Link::isSparse() const {
+  return src_->getDataType() == NTA_BasicType_SDR
+      && dest_->getData().getType() == NTA_BasicType_SDR;
+}
+
+const SDR &Link::sourceSDR_() const {
+  // The delay queue is only written through the SDR, no need to refresh it.
+  if (propagationDelay_)
+    return propagationDelayBuffer_[delayHead_].getSDRNoRefresh();
+  if (sparseCopy_)
+    return src_->getData().getSDRNoRefresh(); // refreshed by Network::run()
+  return src_->getData().getSDR();
+}
+
+void Link::appendSparse(SDR_sparse_t &sparse) const {
+  const bool traced = Tracer::isActive();
+  if (!profilingEnabled_ && !traced) {
+    appendSparse_(sparse);
+    return;
+  }
+  const UInt64 t0 = LatencyHistogram::now();
+  appendSparse_(sparse);
+  if (profilingEnabled_)
+    profile_.record(LatencyHistogram::now() - t0);
+  if (traced)
+    Tracer::record("link", getMoniker(), t0, sourceSDR_().getSum(), "sparse", "SDR");
+}
+
+void Link::appendSparse_(SDR_sparse_t &sparse) const {
+  NTA_CHECK(initialized_);
+  const SDR &src = sourceSDR_();
+  NTA_CHECK(src.size + destOffset_ <= dest_->getData().getCount())
+      << "Not enough room in buffer to propogate to " << destRegionName_
+      << " " << destInputName_ << ". ";
+  const UInt offset = static_cast<UInt>(destOffset_);
+  for (const UInt idx : src.getSparse()) {
+    sparse.push_back(idx + offset);
+  }
+}
+
+bool Link::isSharingDestinationBuffer_() const {
+  if (!is_FanIn_ || propagationDelay_ > 0)
+    return false;
+  const Array &src = src_->getData();
+  const Array &dest = dest_->getData();
+  if (src.getType() != dest.getType() || src.getType() == NTA_BasicType_SDR || !src.has_buffer() || !dest.has_buffer())
+    return false;
+  return src.getBuffer() == static_cast<const char *>(dest.getBuffer()) + destOffset_ * BasicType::getSize(dest.getType());
+}
+
 void Link::shiftBufferedData() {
   if (propagationDelay_) {   // Source buffering is not used in 0-delay links
     Array& from = src_->getData();
     NTA_CHECK(propagationDelayBuffer_.size() == (propagationDelay_));
 
-    // push a copy of the source Output buffer on the back of the queue.
-    // This must be a deep copy.
-    Array a = from.copy();
-    propagationDelayBuffer_.push_back(a);
+    // The oldest slot was already copied to the destination, overwrite it in
+    // place with the current source. The slots are private to this link.
+    Array &slot = propagationDelayBuffer_[delayHead_];
+    if (from.getType() == NTA_BasicType_SDR) {
+      // only the sparse indices are copied.
+      const SDR_sparse_t &sparse = from.getSDR().getSparse();
+      slot.getSDRNoRefresh().setSparse(sparse);
+    } else if (slot.getType() == from.getType() && slot.getCount() == from.getCount()) {
+      from.convertInto(slot, 0, slot.getCount());
+    } else {
+      slot = from.copy();  // the source was resized
+    }
 
-    // Pop the head of the queue
-    // The top of the queue now becomes the value to copy to destination.
-    propagationDelayBuffer_.pop_front();
+    // The next slot now holds the value to copy to destination.
+    delayHead_ = (delayHead_ + 1) % propagationDelay_;
+    delayedEpoch_++;
   }
 }
 
+UInt64 Link::getEpoch() const {
+  return propagationDelay_ ? delayedEpoch_ : src_->getEpoch();
+}
+
+std::deque<Array> Link::getDelayBuffer() const {
+  std::deque<Array> delay;
+  for (size_t i = 0; i < propagationDelayBuffer_.size(); i++)
+    delay.push_back(propagationDelayBuffer_[(delayHead_ + i) % propagationDelayBuffer_.size()]);
+  return delay;
+}
+
 std::deque<Array> Link::preSerialize() const {
   std::deque<Array> delay;
   if (propagationDelay_ > 0) {
@@ -275,9 +408,9 @@ std::deque<Array> Link::preSerialize() const {
     Array a = dest_->getData().subset(destOffset_, srcCount);
     delay.push_back(a); // our part of the current Dest Input buffer.
 
-    for (auto itr = propagationDelayBuffer_.begin();
-          itr != propagationDelayBuffer_.end(); itr++) {
-      if (itr + 1 == propagationDelayBuffer_.end())
+    const std::deque<Array> buffered = getDelayBuffer();
+    for (auto itr = buffered.begin(); itr != buffered.end(); itr++) {
+      if (itr + 1 == buffered.end())
         break; // skip the last buffer. Its the current output.
       delay.push_back(*itr);
     } // end for
@@ -316,7 +449,7 @@ std::ostream &operator<<(std::ostream &f, const Link &link) {
   f << "  propagationDelay: " << link.getPropagationDelay()<< ",\n";
   if (link.getPropagationDelay() > 0) {
   	f <<   "   [\n";
-	  for (auto buf : link.propagationDelayBuffer_) {
+	  for (auto buf : link.getDelayBuffer()) {
 		  f << "    " << buf << "\n";
 	  }
 	  f <<   "   ]\n";
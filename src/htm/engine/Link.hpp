@@ -24,11 +24,13 @@
 
 #include <string>
 #include <deque>
+#include <vector>
 
 #include <htm/ntypes/Array.hpp>
 #include <htm/ntypes/Dimensions.hpp>
 #include <htm/types/Types.hpp>
 #include <htm/types/Serializable.hpp>
+#include <htm/utils/LatencyHistogram.hpp>
 
 namespace htm {
 
@@ -384,6 +386,18 @@ public:
    */
   size_t getPropagationDelay() const { return propagationDelay_; }
 
+  /**
+   * The outputs in flight on a delayed link, oldest first.
+   */
+  std::deque<Array> getDelayBuffer() const;
+
+  /**
+   * The change epoch of the data this link passes to the destination, see
+   * Output::getEpoch(): the source's, or for a delayed link one more on
+   * every shiftBufferedData().
+   */
+  UInt64 getEpoch() const;
+
   /**
    * @}
    *
@@ -427,13 +441,58 @@ public:
    *
    * @note This method must be called on a fully initialized link(all 4 phases).
    *
+   * @param snapshot - always deep copy the data, so that the destination keeps
+   *   it while the source computes its next output. Without it, a link may
+   *   pass the source's buffer to the destination.
    */
-  void compute();
+  void compute(bool snapshot = false);
+
+  /**
+   * For a Fan-In link, let the source Output write directly into this link's
+   * slice of the destination Input buffer, so compute() has nothing to copy.
+   * Called by Input::initialize() once its buffer is allocated.
+   * Does nothing unless the link has no delay, both ends have the same numeric
+   * type (not SDR or Str) and this is the only link of the source Output.
+   */
+  void shareDestinationBuffer();
+
+  /**
+   * @returns true if both ends of the link are SDRs, so the link can pass
+   *   the sparse indices rather than the dense buffer.
+   */
+  bool isSparse() const;
+
+  /**
+   * Copy the source's sparse indices into the destination's own SDR, rather
+   * than pass the source's SDR, and read the source without refreshing it.
+   * Set by Network::run() while several regions which read the source
+   * compute concurrently; the source's sparse indices must be valid.
+   * Only for links which are isSparse().
+   */
+  void setSparseCopy(bool sparseCopy);
+
+  /**
+   * Append the source's sparse indices, offset to this link's slice of the
+   * destination. Used by Input::prepare() to merge a Fan-In of SDRs.
+   * For delayed links the source is the head of the delay queue.
+   */
+  void appendSparse(SDR_sparse_t &sparse) const;
+
+  /**
+   * Record the latency of each compute() (or appendSparse()) in a histogram.
+   * Enabled by Region::enableProfiling() of the destination region.
+   */
+  void enableProfiling() { profilingEnabled_ = true; }
+  void disableProfiling() { profilingEnabled_ = false; }
+  void resetProfiling() { profile_.reset(); }
+  const LatencyHistogram &getProfile() const { return profile_; }
 
 
   /*
-   * No-op for links without delay; for delayed links, remove head element of
-   * the propagation delay buffer and push back the current value from source.
+   * No-op for links without delay; for delayed links, copy the current value
+   * from source over the oldest slot of the propagation delay ring, which the
+   * destination has already received, and advance the ring. The slots are
+   * allocated once, in initialize().
    *
    * NOTE It's intended that this method be called exactly once on all links
    * within a network at the end of every time step. Network::run calls it
@@ -491,6 +550,7 @@ public:
        cereal::make_nvp("is_FanIn", is_FanIn_),
        cereal::make_nvp("propagationDelay", propagationDelay_),
        cereal::make_nvp("propagationDelayBuffer", propagationDelayBuffer_));
+    delayHead_ = 0;
     initialized_ = false;
   }
 
@@ -506,6 +566,16 @@ private:
 
   std::deque<Array> preSerialize() const;
 
+  // true if the source Output currently writes into the destination buffer.
+  bool isSharingDestinationBuffer_() const;
+
+  // returns how the data was moved: "shared", "shallow", "sparse" or "deep"
+  const char *compute_(bool snapshot);
+  void appendSparse_(SDR_sparse_t &sparse) const;
+
+  // The SDR to propagate: the source Output or the head of the delay queue.
+  const SDR &sourceSDR_() const;
+
 
   std::string srcRegionName_;
   std::string destRegionName_;
@@ -526,10 +596,17 @@ private:
   size_t destOffset_;
   bool is_FanIn_;
 
-  // Queue buffer for delayed source data buffering
-  std::deque<Array> propagationDelayBuffer_;
+  // Ring of propagationDelay_ slots for delayed source data buffering,
+  // the oldest (next to be copied to the destination) at delayHead_.
+  std::vector<Array> propagationDelayBuffer_;
+  size_t delayHead_ = 0;
   // Number of delay slots
   size_t propagationDelay_;
+  UInt64 delayedEpoch_ = 0u;
+
+  bool profilingEnabled_ = false;
+  bool sparseCopy_ = false;
+  mutable LatencyHistogram profile_; // appendSparse() is const
 
   // link must be initialized before it can compute()
   bool initialized_;
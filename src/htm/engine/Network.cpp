@@ -19,22 +19,44 @@
 Implementation of the Network class
 */
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <limits>
+#include <mutex>
+#include <set>
 #include <sstream>
 #include <stdexcept>
+#include <thread>
 
+#if !defined(NTA_OS_WINDOWS)
+#include <cerrno>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <htm/algorithms/ConnectionsDelta.hpp>
+#include <htm/engine/IngestQueue.hpp>
 #include <htm/engine/Input.hpp>
 #include <htm/engine/Link.hpp>
 #include <htm/engine/Network.hpp>
 #include <htm/engine/Output.hpp>
 #include <htm/engine/Region.hpp>
+#include <htm/engine/RegionImpl.hpp>
 #include <htm/engine/RegionImplFactory.hpp>
 #include <htm/engine/Spec.hpp>
+#include <htm/engine/TrafficCapture.hpp>
 #include <htm/os/Directory.hpp>
 #include <htm/os/Path.hpp>
 #include <htm/ntypes/BasicType.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/utils/Compression.hpp>
 #include <htm/utils/Log.hpp>
+#include <htm/utils/Tracer.hpp>
 #include <htm/ntypes/Value.hpp>
 
 namespace htm {
@@ -51,11 +73,34 @@ Network::Network() {
 // move constructor
 Network::Network(Network &&n) noexcept {
   regions_ = std::move(n.regions_);
+  for (auto &r : regions_)
+    r.second->network_ = this;
   minEnabledPhase_ = n.minEnabledPhase_;
   maxEnabledPhase_ = n.maxEnabledPhase_;
   phaseInfo_ = std::move(n.phaseInfo_);
   callbacks_ = n.callbacks_;
   iteration_ = n.iteration_;
+  threadPool_ = std::move(n.threadPool_);
+  pipelined_ = n.pipelined_;
+  pipelineFill_ = n.pipelineFill_;
+  batchSize_ = n.batchSize_;
+  arenaEnabled_ = n.arenaEnabled_;
+  arena_ = std::move(n.arena_);
+  nodeArenas_ = std::move(n.nodeArenas_);
+  defaultPlacement_ = std::move(n.defaultPlacement_);
+  threadPools_ = std::move(n.threadPools_);
+  checkpointBase_ = std::move(n.checkpointBase_);
+  checkpointBaseId_ = n.checkpointBaseId_;
+  deltas_ = std::move(n.deltas_);
+  {
+    std::lock_guard<std::mutex> lock(n.swapsMutex_);
+    swaps_ = std::move(n.swaps_);
+    numSwaps_ = n.numSwaps_.exchange(0u);
+  }
+  profilingEnabled_ = n.profilingEnabled_;
+  callbackProfile_ = std::move(n.callbackProfile_);
+  capture_ = std::move(n.capture_);
+  captureOutputs_ = std::move(n.captureOutputs_);
 }
 
 Network::Network(const std::string& filename) {
@@ -80,6 +125,9 @@ Network::~Network() {
    * - delete the regions themselves.
    */
 
+  deltas_.clear(); // they refer to the Connections of the regions
+  swaps_.clear();  // waits for the loads, which read the regions
+
   // 1. uninitialize
   for(auto p: regions_) {
     std::shared_ptr<Region> r = p.second;
@@ -97,6 +145,28 @@ Network::~Network() {
 }
 
 
+namespace {
+  // {cpus: [<CPU>, ...], numaNode: <node>, pool: <name>}, all optional.
+  Placement parsePlacement(Value &v) {
+    NTA_CHECK(v.isMap()) << "Expected a placement {cpus: [...], numaNode: <node>, pool: <name>}.";
+    Placement placement;
+    if (v.contains("cpus")) {
+      Value &cpus = v["cpus"];
+      if (cpus.isSequence()) {
+        for (size_t i = 0; i < cpus.size(); i++)
+          placement.cpus.push_back(cpus[i].as<int>());
+      } else {
+        placement.cpus.push_back(cpus.as<int>());
+      }
+    }
+    if (v.contains("numaNode"))
+      placement.numaNode = v["numaNode"].as<int>();
+    if (v.contains("pool"))
+      placement.pool = v["pool"].str();
+    return placement;
+  }
+} // namespace
+
 void Network::configure(const std::string &yaml) {
   ValueMap vm;
   vm.parse(yaml);
@@ -118,7 +188,9 @@ void Network::configure(const std::string &yaml) {
         std::string type = cmd.second["type"].str();
         ValueMap params;
         if (cmd.second.contains("params")) params = cmd.second["params"];
-        addRegion(name, type, params);
+        Placement placement;
+        if (cmd.second.contains("placement")) placement = parsePlacement(cmd.second["placement"]);
+        addRegion(name, type, params, placement);
 
         UInt32 phase = 0;
         if (cmd.second.contains("phase")) {
@@ -127,6 +199,13 @@ void Network::configure(const std::string &yaml) {
           phases.insert(phase);
           setPhases(name, phases);
         }
+      } else if (cmd.first == "placement") {
+        setDefaultPlacement(parsePlacement(cmd.second));
+      } else if (cmd.first == "addThreadPool") {
+        std::string name = cmd.second["name"].str();
+        NTA_CHECK(cmd.second.contains("threads")) << "addThreadPool " << name << ": expected threads.";
+        const Placement placement = parsePlacement(cmd.second);
+        addThreadPool(name, cmd.second["threads"].as<UInt>(), placement.cpuSet());
       } else if (cmd.first == "addLink") {
         std::string src = cmd.second["src"].str();
         std::string dest = cmd.second["dest"].str();
@@ -151,10 +230,12 @@ void Network::configure(const std::string &yaml) {
 
 std::shared_ptr<Region> Network::addRegion(const std::string &name, 
                                            const std::string &nodeType,
-                                           const std::string &nodeParams) {
+                                           const std::string &nodeParams,
+                                           const Placement &placement) {
   if (regions_.find(name) != regions_.end())
     NTA_THROW << "Region with name '" << name << "' already exists in network";
   std::shared_ptr<Region> r = std::make_shared<Region>(name, nodeType, nodeParams, this);
+  r->setPlacement(placement);
   regions_[name] = r;
   initialized_ = false;
 
@@ -165,10 +246,12 @@ std::shared_ptr<Region> Network::addRegion(const std::string &name,
 
 std::shared_ptr<Region> Network::addRegion(const std::string &name, 
                                            const std::string &nodeType,
-                                           ValueMap& vm) {
+                                           ValueMap& vm,
+                                           const Placement &placement) {
   if (regions_.find(name) != regions_.end())
     NTA_THROW << "Region with name '" << name << "' already exists in network";
   std::shared_ptr<Region> r = std::make_shared<Region>(name, nodeType, vm, this);
+  r->setPlacement(placement);
   regions_[name] = r;
   initialized_ = false;
 
@@ -276,6 +359,8 @@ void Network::removeRegion(const std::string &name) {
   if (r->hasOutgoingLinks())
     NTA_THROW << "Unable to remove region '" << name
               << "' because it has one or more outgoing links";
+  deltas_.clear(); // their Connections may go away, a new base is needed
+  checkpointBase_.clear();
 
   // Network does not have to be uninitialized -- removing a region
   // has no effect on the network as long as it has no outgoing links,
@@ -391,6 +476,23 @@ std::shared_ptr<Link> Network::link(const std::string &srcRegionName,
   return link;
 }
 
+std::vector<std::shared_ptr<Region>> Network::addEnsemble(const std::string &name, const std::string &nodeType,
+                                                          const std::vector<std::string> &params,
+                                                          const std::string &srcName,
+                                                          const std::string &srcOutput,
+                                                          const std::string &destInput) {
+  NTA_CHECK(!params.empty()) << "Network::addEnsemble -- '" << name << "' needs the parameters of at least one member";
+  NTA_CHECK(regions_.find(srcName) != regions_.end())
+      << "Network::addEnsemble -- source region '" << srcName << "' does not exist";
+  std::vector<std::shared_ptr<Region>> members;
+  for (size_t i = 0; i < params.size(); i++) {
+    const std::string member = name + std::to_string(i);
+    members.push_back(addRegion(member, nodeType, params[i]));
+    link(srcName, member, "", "", srcOutput, destInput);
+  }
+  return members;
+}
+
 void Network::removeLink(const std::string &srcRegionName,
                          const std::string &destRegionName,
                          const std::string &srcOutputName,
@@ -445,7 +547,8 @@ void Network::removeLink(const std::string &srcRegionName,
 void Network::setInputData(const std::string& sourceName, const Array& data) {
   // The placeholder region "INPUT" with an output of <sourceName> should already exist if the link was defined.
   std::shared_ptr<Region> region = getRegion("INPUT"); 
-  Array &a = region->getOutput(sourceName)->getData(); // we actually populate an output buffer that will be moved to input.
+  std::shared_ptr<Output> out = region->getOutput(sourceName);
+  Array &a = out->getData(); // we actually populate an output buffer that will be moved to input.
   NTA_CHECK(a.getCount() == data.getCount())
       << "setInputData: Number of elements in buffer ( " << a.getCount() << " ) do not match target dimensions.";
   if (a.getType() == data.getType()) {
@@ -453,6 +556,7 @@ void Network::setInputData(const std::string& sourceName, const Array& data) {
   }  else {
     data.convertInto(a);  // copy the data with conversion.
   }
+  out->update();
 }
 
 void Network::setInputData(const std::string &sourceName, const Value& vm) {
@@ -476,8 +580,284 @@ void Network::setInputData(const std::string &sourceName, const Value& vm) {
   }
 
   a.fromValue(vm);
+  region->getOutput(sourceName)->update();
+}
+
+namespace {
+  template <typename T>
+  void setDense_(SDR &sdr, const void *data) { sdr.setDense(static_cast<const T *>(data)); }
+
+  // Copies one record of count values of the given type into a, see
+  // Network::setInputData(name, type, data, count).
+  void writeRecord_(Array &a, const NTA_BasicType type, const void *data, const size_t count,
+                    const std::string &sourceName) {
+    NTA_CHECK(type != NTA_BasicType_SDR && type != NTA_BasicType_Str)
+        << "setInputData: the data must be numeric, for the SDR use setInputSparse().";
+    NTA_CHECK(a.getCount() == count)
+        << "setInputData: Number of elements in buffer ( " << a.getCount() << " ) do not match target dimensions.";
+    if (a.getType() == type) {
+      std::memcpy(a.getBuffer(), data, count * BasicType::getSize(type));
+      return;
+    }
+    NTA_CHECK(a.getType() == NTA_BasicType_SDR)
+        << "setInputData: input '" << sourceName << "' is " << BasicType::getName(a.getType())
+        << ", the data is " << BasicType::getName(type) << ". Use setInputData(name, Array) to convert.";
+    SDR &sdr = a.getSDRNoRefresh();
+    switch (type) {
+    case NTA_BasicType_Byte:   setDense_<Byte>(sdr, data);   break;
+    case NTA_BasicType_Int16:  setDense_<Int16>(sdr, data);  break;
+    case NTA_BasicType_UInt16: setDense_<UInt16>(sdr, data); break;
+    case NTA_BasicType_Int32:  setDense_<Int32>(sdr, data);  break;
+    case NTA_BasicType_UInt32: setDense_<UInt32>(sdr, data); break;
+    case NTA_BasicType_Int64:  setDense_<Int64>(sdr, data);  break;
+    case NTA_BasicType_UInt64: setDense_<UInt64>(sdr, data); break;
+    case NTA_BasicType_Real32: setDense_<Real32>(sdr, data); break;
+    case NTA_BasicType_Real64: setDense_<Real64>(sdr, data); break;
+    case NTA_BasicType_Bool:   setDense_<bool>(sdr, data);   break;
+    default:
+      NTA_THROW << "setInputData: can not set the SDR of input '" << sourceName << "' from "
+                << BasicType::getName(type) << ".";
+    }
+  }
+
+  // The records of a batch, each of the type and count of the output's data.
+  std::vector<Array> &resizeBatch_(Output &out, const size_t numRecords) {
+    const Array &data = out.getData();
+    std::vector<Array> &batch = out.getBatch();
+    batch.resize(numRecords);
+    for (Array &record : batch) {
+      if (record.getType() != data.getType() || record.getCount() != data.getCount())
+        record = data.copy();
+    }
+    return batch;
+  }
+} // namespace
+
+void Network::setInputData(const std::string &sourceName, const NTA_BasicType type,
+                           const void *data, const size_t count) {
+  std::shared_ptr<Output> out = getRegion("INPUT")->getOutput(sourceName);
+  writeRecord_(out->getData(), type, data, count, sourceName);
+  out->update();
+}
+
+void Network::setInputSparse(const std::string &sourceName, const UInt *sparse, const size_t count) {
+  std::shared_ptr<Output> out = getRegion("INPUT")->getOutput(sourceName);
+  Array &a = out->getData();
+  NTA_CHECK(a.getType() == NTA_BasicType_SDR)
+      << "setInputSparse: input '" << sourceName << "' is not an SDR.";
+  a.getSDRNoRefresh().setSparse(sparse, static_cast<UInt>(count));
+  out->update();
+}
+
+void Network::setInputBatch(const std::string &sourceName, const NTA_BasicType type,
+                            const void *data, const size_t numRecords) {
+  std::shared_ptr<Output> out = getRegion("INPUT")->getOutput(sourceName);
+  const size_t count = out->getData().getCount();
+  const size_t stride = count * BasicType::getSize(type);
+  std::vector<Array> &batch = resizeBatch_(*out, numRecords);
+  for (size_t i = 0; i < numRecords; i++)
+    writeRecord_(batch[i], type, static_cast<const char *>(data) + i * stride, count, sourceName);
 }
 
+void Network::setInputSparseBatch(const std::string &sourceName, const UInt *sparse,
+                                  const size_t *ends, const size_t numRecords) {
+  std::shared_ptr<Output> out = getRegion("INPUT")->getOutput(sourceName);
+  NTA_CHECK(out->getData().getType() == NTA_BasicType_SDR)
+      << "setInputSparseBatch: input '" << sourceName << "' is not an SDR.";
+  std::vector<Array> &batch = resizeBatch_(*out, numRecords);
+  size_t begin = 0u;
+  for (size_t i = 0; i < numRecords; i++) {
+    batch[i].getSDRNoRefresh().setSparse(sparse + begin, static_cast<UInt>(ends[i] - begin));
+    begin = ends[i];
+  }
+}
+
+namespace {
+  // How long runFromQueue() sleeps when the queue is empty.
+  const std::chrono::microseconds INGEST_WAIT(50);
+
+  // A record of IngestQueue into the buffer of the output of the same type and size.
+  void copyRecord_(const Array &from, Array &to) {
+    if (from.getType() == NTA_BasicType_SDR)
+      to.getSDRNoRefresh().setSDR(from.getSDR());
+    else
+      std::memcpy(to.getBuffer(), from.getBuffer(), from.getCount() * BasicType::getSize(from.getType()));
+  }
+} // namespace
+
+size_t Network::runFromQueue(IngestQueue &queue, const size_t maxRecords) {
+  std::shared_ptr<Region> input = getRegion("INPUT");
+  std::vector<std::shared_ptr<Output>> outputs;
+  for (const auto &name : queue.sources())
+    outputs.push_back(input->getOutput(name));
+
+  size_t done = 0u;
+  while (maxRecords == 0u || done < maxRecords) {
+    // Whatever arrived, up to a batch: a micro-batch under load, single
+    // records with the latency of the producer otherwise.
+    size_t records = std::min<size_t>(queue.available(), batchSize_);
+    if (maxRecords != 0u)
+      records = std::min(records, maxRecords - done);
+    if (records == 0u) {
+      if (queue.isClosed() && queue.available() == 0u)
+        break;
+      std::this_thread::sleep_for(INGEST_WAIT);
+      continue;
+    }
+
+    if (batchSize_ > 1u) {
+      std::vector<std::vector<Array> *> batches;
+      for (auto &out : outputs)
+        batches.push_back(&resizeBatch_(*out, records));
+      for (size_t i = 0; i < records; i++) {
+        const IngestQueue::Record &record = *queue.front_();
+        for (size_t s = 0; s < outputs.size(); s++)
+          copyRecord_(record[s], (*batches[s])[i]);
+        queue.pop_();
+      }
+    } else {
+      const IngestQueue::Record &record = *queue.front_();
+      for (size_t s = 0; s < outputs.size(); s++) {
+        copyRecord_(record[s], outputs[s]->getData());
+        outputs[s]->update();
+      }
+      queue.pop_(); // before the compute, the producer may refill the slot meanwhile
+    }
+    run(static_cast<int>(records));
+    done += records;
+  }
+  return done;
+}
+
+void Network::startCapture(const std::string &path, const std::vector<std::string> &sources) {
+  NTA_CHECK(capture_ == nullptr) << "startCapture: already capturing to " << capture_->getPath();
+  if (!initialized_)
+    initialize();
+  std::shared_ptr<Region> input = getRegion("INPUT");
+  std::vector<std::string> names = sources;
+  if (names.empty()) {
+    for (const auto &output : input->getOutputs()) {
+      if (output.second->getData().getType() != NTA_BasicType_Str)
+        names.push_back(output.first);
+    }
+  }
+  NTA_CHECK(!names.empty()) << "startCapture: no INPUT outputs to capture.";
+  std::vector<std::shared_ptr<Output>> outputs;
+  std::vector<const Array *> prototypes;
+  for (const auto &name : names) {
+    std::shared_ptr<Output> out = input->getOutput(name);
+    NTA_CHECK(out != nullptr) << "startCapture: no link from the INPUT output '" << name << "'.";
+    outputs.push_back(out);
+    prototypes.push_back(&out->getData());
+  }
+  capture_ = std::make_shared<TrafficCapture>(path, names, prototypes);
+  captureOutputs_ = std::move(outputs);
+}
+
+UInt64 Network::stopCapture() {
+  NTA_CHECK(capture_ != nullptr) << "stopCapture: not capturing.";
+  capture_->close();
+  const UInt64 records = capture_->getRecords();
+  capture_.reset();
+  captureOutputs_.clear();
+  return records;
+}
+
+void Network::captureIteration_(const bool batched, const size_t batchIndex) {
+  std::vector<const Array *> data;
+  data.reserve(captureOutputs_.size());
+  for (const auto &out : captureOutputs_) {
+    const std::vector<Array> &batch = out->getBatch();
+    data.push_back(batched && batchIndex < batch.size() ? &batch[batchIndex] : &out->getData());
+  }
+  capture_->record(data);
+}
+
+size_t Network::replayCapture(const std::string &path, const Real64 speed, const size_t maxRecords) {
+  NTA_CHECK(speed >= 0.0) << "replayCapture: the speed must not be negative.";
+  if (!initialized_)
+    initialize();
+  TrafficReplay replay(path);
+  std::shared_ptr<Region> input = getRegion("INPUT");
+  std::vector<std::shared_ptr<Output>> outputs;
+  for (const auto &name : replay.names()) {
+    std::shared_ptr<Output> out = input->getOutput(name);
+    NTA_CHECK(out != nullptr) << "replayCapture: no link from the INPUT output '" << name << "'.";
+    outputs.push_back(out);
+  }
+  // Checks the type and size of the records against the outputs, once.
+  const auto checkRecord = [&]() {
+    for (size_t s = 0; s < outputs.size(); s++) {
+      const Array &data = outputs[s]->getData();
+      NTA_CHECK(replay[s].getType() == data.getType() && replay[s].getCount() == data.getCount())
+          << "replayCapture: the INPUT output '" << replay.names()[s] << "' is "
+          << BasicType::getName(data.getType()) << " of " << data.getCount() << ", the log has "
+          << BasicType::getName(replay[s].getType()) << " of " << replay[s].getCount() << ".";
+    }
+  };
+
+  size_t done = 0u;
+  bool more = (maxRecords == 0u || done < maxRecords) && replay.next();
+  if (more)
+    checkRecord();
+
+  if (speed == 0.0 && batchSize_ > 1u) {
+    std::vector<std::vector<Array> *> batches(outputs.size());
+    while (more) {
+      for (size_t s = 0; s < outputs.size(); s++)
+        batches[s] = &resizeBatch_(*outputs[s], batchSize_);
+      size_t records = 0u;
+      while (more && records < batchSize_) {
+        for (size_t s = 0; s < outputs.size(); s++)
+          copyRecord_(replay[s], (*batches[s])[records]);
+        records++;
+        more = (maxRecords == 0u || done + records < maxRecords) && replay.next();
+      }
+      for (auto batch : batches)
+        batch->resize(records); // the last batch of the log
+      run(static_cast<int>(records));
+      done += records;
+    }
+    return done;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  Real64 due = 0.0; // nanoseconds after start, at the pace of the capture
+  while (more) {
+    if (speed > 0.0) {
+      due += static_cast<Real64>(replay.getDelay()) / speed;
+      std::this_thread::sleep_until(start + std::chrono::nanoseconds(static_cast<Int64>(due)));
+    }
+    for (size_t s = 0; s < outputs.size(); s++) {
+      copyRecord_(replay[s], outputs[s]->getData());
+      outputs[s]->update();
+    }
+    run(1);
+    done++;
+    more = (maxRecords == 0u || done < maxRecords) && replay.next();
+  }
+  return done;
+}
+
+namespace {
+  // The span of one iteration of Network::run(), see Tracer.
+  class IterationTrace {
+  public:
+    explicit IterationTrace(UInt64 iteration) : iteration_(iteration) {
+      Tracer::beginIteration(iteration);
+      start_ = Tracer::isActive() ? LatencyHistogram::now() : 0u;
+    }
+    ~IterationTrace() {
+      if (start_ != 0u)
+        Tracer::record("network", "iteration " + std::to_string(iteration_), start_);
+      Tracer::endIteration();
+    }
+
+  private:
+    UInt64 iteration_;
+    UInt64 start_;
+  };
+} // namespace
 
 void Network::run(int n) {
   if (!initialized_) {
@@ -490,22 +870,181 @@ void Network::run(int n) {
   NTA_CHECK(maxEnabledPhase_ < phaseInfo_.size())
       << "maxphase: " << maxEnabledPhase_ << " size: " << phaseInfo_.size();
 
-  for (int iter = 0; iter < n; iter++) {
-    iteration_++;
+  if (batchSize_ > 1u) {
+    const auto stages = pipelineStages_("Batched");
+    for (int iter = 0; iter < n;) {
+      applyRegionSwaps();
+      const UInt size = std::min(batchSize_, static_cast<UInt>(n - iter));
+      IterationTrace trace(iteration_ + 1u);
+      if (capture_ != nullptr) {
+        for (UInt i = 0; i < size; i++)
+          captureIteration_(true, i);
+      }
+      {
+        SDR::DeferCallbacks deferCallbacks;
+        for (const auto stage : stages) {
+          for (Region *r : *stage) {
+            if (r->getName() != "INPUT") // keeps the records of setInputBatch()
+              r->computeBatch(size);
+          }
+        }
+      }
+      iteration_ += size;
+      iter += static_cast<int>(size);
+      runCallbacks_();
+    }
+    // A region which is not batched next time must not read stale records.
+    for (const auto &p : regions_) {
+      for (const auto &output : p.second->getOutputs())
+        output.second->getBatch().clear();
+      for (const auto &input : p.second->getInputs())
+        input.second->getBatch().clear();
+    }
+    return;
+  }
+
+  if (pipelined_) {
+    const auto stages = pipelineStages_();
+    for (int iter = 0; iter < n; iter++) {
+      applyRegionSwaps();
+      iteration_++;
+      IterationTrace trace(iteration_);
+      if (capture_ != nullptr)
+        captureIteration_(false);
+      {
+        SDR::DeferCallbacks deferCallbacks;
+        runPipelineStep_(stages, 0u);
+        if (pipelineFill_ + 1u < stages.size())
+          pipelineFill_++;
+      }
+      runCallbacks_();
+    }
+    return;
+  }
 
-    // compute on all enabled regions in phase order
+  // The links can not change while running, so the dependency graphs of the
+  // phases are built once per call.
+  std::vector<PhaseSchedule_> schedules;
+  if (threadPool_ != nullptr) {
     for (UInt32 phase = minEnabledPhase_; phase <= maxEnabledPhase_; phase++) {
-      for (auto r : phaseInfo_[phase]) {
-        r->prepareInputs();
-        r->compute();
+      schedules.push_back(buildPhaseSchedule_({phaseInfo_[phase].begin(), phaseInfo_[phase].end()}));
+    }
+  }
+  // The readers of a shared SDR copy its active bits during this call only,
+  // in a serial run they may share the SDR again.
+  struct SparseCopies {
+    std::vector<Link *> links;
+    ~SparseCopies() { for (Link *link : links) link->setSparseCopy(false); }
+  } sparseCopies;
+  for (const auto &schedule : schedules) {
+    if (schedule.regions.size() < 2u)
+      continue;
+    for (Link *link : schedule.sparseCopyLinks) {
+      link->setSparseCopy(true);
+      sparseCopies.links.push_back(link);
+    }
+  }
+  // Computes the sparse indices, before the readers use them concurrently.
+  const auto refreshShared = [](const PhaseSchedule_ &schedule, const Region *r) {
+    const auto found = schedule.sharedOutputs.find(r);
+    if (found == schedule.sharedOutputs.end())
+      return;
+    for (Output *out : found->second)
+      out->getData().getSDR().getSparse();
+  };
+
+  // The regions computing in the background, see RegionImpl::isAsync().
+  struct AsyncComputes {
+    std::vector<std::pair<const Region *, std::future<void>>> running;
+
+    void wait(const Region *r) {
+      for (auto it = running.begin(); it != running.end(); ++it) {
+        if (it->first == r) {
+          std::future<void> done = std::move(it->second);
+          running.erase(it);
+          done.get(); // rethrows
+          return;
+        }
       }
     }
+    // For the regions which r reads from.
+    void waitForSources(const Region *r) {
+      if (running.empty())
+        return;
+      for (const auto &input : r->getInputs()) {
+        for (const auto &link : input.second->getLinks())
+          wait(link->getSrc()->getRegion());
+      }
+    }
+    void waitAll() {
+      while (!running.empty())
+        wait(running.front().first);
+    }
+    ~AsyncComputes() { // after an exception, the impls must stay alive until done
+      for (auto &r : running)
+        r.second.wait();
+    }
+  } async;
 
-    // invoke callbacks
-    for (UInt32 i = 0; i < callbacks_.getCount(); i++) {
-      const std::pair<std::string, callbackItem> &callback = callbacks_.getByIndex(i);
-      callback.second.first(this, iteration_, callback.second.second);
+  // The serial order of the regions, see setIterationBudget().
+  std::vector<BudgetedCompute_> budgeted;
+  if (iterationBudget_ > 0.0 && threadPool_ == nullptr) {
+    for (UInt32 phase = minEnabledPhase_; phase <= maxEnabledPhase_; phase++) {
+      for (Region *r : phaseInfo_[phase]) {
+        const auto found = std::find(degradeOrder_.begin(), degradeOrder_.end(), r->getName());
+        const size_t rank = (found == degradeOrder_.end() || r->isAsync())
+                                ? NOT_DEGRADABLE : static_cast<size_t>(found - degradeOrder_.begin());
+        budgeted.push_back({r, &computeCosts_[r->getName()], rank, false});
+      }
     }
+  }
+
+  for (int iter = 0; iter < n; iter++) {
+    applyRegionSwaps(); // between two iterations, see swapRegionAsync()
+    iteration_++;
+    IterationTrace trace(iteration_);
+    if (capture_ != nullptr)
+      captureIteration_(false);
+    const UInt64 iterationStart = budgeted.empty() ? 0u : LatencyHistogram::now();
+    size_t nextBudgeted = 0u;
+    for (auto &b : budgeted)
+      b.degraded = false;
+
+    // compute on all enabled regions in phase order. The SDR callbacks
+    // (ie. metrics) run once per iteration, after all regions computed.
+    {
+      SDR::DeferCallbacks deferCallbacks;
+      for (UInt32 phase = minEnabledPhase_; phase <= maxEnabledPhase_; phase++) {
+        if (threadPool_ != nullptr && phaseInfo_[phase].size() > 1u) {
+          async.waitAll();
+          const PhaseSchedule_ &schedule = schedules[phase - minEnabledPhase_];
+          refreshShared(schedule, nullptr); // computed in an earlier phase
+          runPhaseParallel_(schedule, [this, &schedule, &refreshShared](Region *r) {
+            r->prepareInputs();
+            r->compute(skipUnchanged_);
+            refreshShared(schedule, r);
+          });
+          continue;
+        }
+        for (auto r : phaseInfo_[phase]) {
+          async.waitForSources(r);
+          r->prepareInputs();
+          if (r->isAsync())
+            async.running.emplace_back(r, r->computeAsync(skipUnchanged_));
+          else if (!budgeted.empty())
+            computeBudgeted_(budgeted, nextBudgeted, iterationStart);
+          else
+            r->compute(skipUnchanged_);
+          nextBudgeted++;
+        }
+      }
+      async.waitAll();
+    }
+    if (!budgeted.empty() &&
+        static_cast<Real64>(LatencyHistogram::now() - iterationStart) > iterationBudget_ * 1.0e9)
+      deadlineMisses_++;
+
+    runCallbacks_();
 
     // Refresh all links in the network at the end of every timestamp so that
     // data in delayed links appears to change atomically between iterations
@@ -524,6 +1063,370 @@ void Network::run(int n) {
   return;
 }
 
+void Network::setIterationBudget(const Real64 seconds, const std::vector<std::string> &degradeOrder) {
+  NTA_CHECK(seconds >= 0.0) << "setIterationBudget: the budget must not be negative.";
+  for (const auto &name : degradeOrder) {
+    NTA_CHECK(getRegion(name)->canDegrade()) << "setIterationBudget: region " << name << " can not degrade.";
+  }
+  iterationBudget_ = seconds;
+  degradeOrder_ = degradeOrder;
+}
+
+void Network::resetDegradationCounts() {
+  degradedComputes_.clear();
+  deadlineMisses_ = 0u;
+}
+
+void Network::computeBudgeted_(std::vector<BudgetedCompute_> &schedule, const size_t next, const UInt64 start) {
+  const auto cost = [](const BudgetedCompute_ &b) { return b.degraded ? b.cost->degraded : b.cost->full; };
+  Real64 predicted = static_cast<Real64>(LatencyHistogram::now() - start);
+  for (size_t i = next; i < schedule.size(); i++)
+    predicted += cost(schedule[i]);
+  // Degrade the regions still to come, in the declared order, until the iteration fits.
+  while (predicted > iterationBudget_ * 1.0e9) {
+    BudgetedCompute_ *first = nullptr;
+    for (size_t i = next; i < schedule.size(); i++) {
+      BudgetedCompute_ &b = schedule[i];
+      if (b.rank != NOT_DEGRADABLE && !b.degraded && (first == nullptr || b.rank < first->rank))
+        first = &b;
+    }
+    if (first == nullptr)
+      break;
+    predicted -= cost(*first);
+    first->degraded = true;
+    predicted += cost(*first);
+  }
+
+  BudgetedCompute_ &current = schedule[next];
+  Region *r = current.region;
+  struct Restore {
+    Region *r;
+    ~Restore() { r->setDegraded(false); }
+  } restore{r};
+  r->setDegraded(current.degraded);
+  const UInt64 t0 = LatencyHistogram::now();
+  r->compute(skipUnchanged_);
+  const Real64 took = static_cast<Real64>(LatencyHistogram::now() - t0);
+  Real64 &average = current.degraded ? current.cost->degraded : current.cost->full;
+  average = average == 0.0 ? took : average + (took - average) / 8.0;
+  if (current.degraded)
+    degradedComputes_[r->getName()]++;
+}
+
+void Network::setNumThreads(const UInt numThreads) {
+  if (numThreads <= 1u) {
+    threadPool_.reset();
+  } else if (threadPool_ == nullptr || threadPool_->size() != numThreads) {
+    threadPool_ = std::make_shared<ThreadPool>(numThreads);
+  }
+}
+
+std::shared_future<void> Network::swapRegionAsync(const std::string &region, const std::string &path,
+                                                  const SerializableFormat fmt) {
+  return swapRegionAsync(region, [path, fmt](Region *r) { return r->loadImpl(path, fmt); });
+}
+
+std::shared_future<void> Network::swapRegionAsync(const std::string &region,
+                                                  const std::function<RegionImpl *(Region *)> &load) {
+  Region *r = getRegion(region).get();
+  NTA_CHECK(r->isInitialized()) << "swapRegionAsync: region " << region << " is not initialized.";
+  RegionSwap_ swap;
+  swap.region = region;
+  swap.loaded = std::async(std::launch::async, [r, load]() {
+    return std::unique_ptr<RegionImpl>(load(r));
+  });
+  std::shared_future<void> swapped = swap.swapped.get_future().share();
+  std::lock_guard<std::mutex> lock(swapsMutex_);
+  swaps_.push_back(std::move(swap));
+  numSwaps_ = swaps_.size();
+  return swapped;
+}
+
+size_t Network::applyRegionSwaps() {
+  if (numSwaps_ == 0u)
+    return 0u;
+  size_t swapped = 0u;
+  std::set<std::string> waiting; // for an earlier swap, which must not win
+  std::lock_guard<std::mutex> lock(swapsMutex_);
+  for (auto swap = swaps_.begin(); swap != swaps_.end();) {
+    if (waiting.count(swap->region) ||
+        swap->loaded.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      waiting.insert(swap->region);
+      ++swap;
+      continue;
+    }
+    try {
+      std::unique_ptr<RegionImpl> impl = swap->loaded.get();
+      NTA_CHECK(impl != nullptr) << "swapRegionAsync: nothing loaded for region " << swap->region;
+      const auto found = regions_.find(swap->region);
+      NTA_CHECK(found != regions_.end()) << "swapRegionAsync: region " << swap->region << " was removed.";
+      Region *r = found->second.get();
+      r->impl_ = std::move(impl);
+      r->computed_ = false; // the skipped computes are of the old state
+      const Placement placement = getPlacement(swap->region);
+      if (!placement.pool.empty()) {
+        if (auto pool = getThreadPool(placement.pool))
+          r->impl_->setThreadPool(pool);
+      }
+      // The deltas refer to the Connections of the old impl.
+      deltas_.erase(swap->region);
+      checkpointBase_.clear();
+      swap->swapped.set_value();
+      swapped++;
+    } catch (...) {
+      swap->swapped.set_exception(std::current_exception());
+    }
+    swap = swaps_.erase(swap);
+  }
+  numSwaps_ = swaps_.size();
+  return swapped;
+}
+
+void Network::setPlacement(const std::string &region, const Placement &placement) {
+  getRegion(region)->setPlacement(placement);
+}
+
+Placement Network::getPlacement(const std::string &region) const {
+  Placement placement = getRegion(region)->getPlacement();
+  if (placement.cpus.empty())
+    placement.cpus = defaultPlacement_.cpus;
+  if (placement.numaNode < 0)
+    placement.numaNode = defaultPlacement_.numaNode;
+  if (placement.pool.empty())
+    placement.pool = defaultPlacement_.pool;
+  return placement;
+}
+
+void Network::addThreadPool(const std::string &name, const UInt numThreads, const std::vector<int> &cpus) {
+  NTA_CHECK(!name.empty()) << "addThreadPool: the pool has no name.";
+  auto pool = std::make_shared<ThreadPool>(std::max(numThreads, 1u));
+  if (!cpus.empty())
+    pool->pinWorkers(cpus);
+  threadPools_[name] = pool;
+}
+
+std::shared_ptr<ThreadPool> Network::getThreadPool(const std::string &name) const {
+  const auto found = threadPools_.find(name);
+  return found == threadPools_.end() ? nullptr : found->second;
+}
+
+const Arena *Network::getArena(const int numaNode) const {
+  if (numaNode < 0)
+    return arena_.get();
+  const auto found = nodeArenas_.find(numaNode);
+  return found == nodeArenas_.end() ? nullptr : found->second.get();
+}
+
+std::shared_ptr<Arena> Network::arenaOf_(const Placement &placement) {
+  if (!arenaEnabled_)
+    return nullptr;
+  const int node = placement.node();
+  if (node < 0)
+    return arena_;
+  auto &arena = nodeArenas_[node];
+  if (arena == nullptr)
+    arena = std::make_shared<Arena>(1u << 20u, node);
+  return arena;
+}
+
+Network::PhaseSchedule_ Network::buildPhaseSchedule_(std::vector<Region *> regions) const {
+  PhaseSchedule_ schedule;
+  schedule.regions = std::move(regions);
+  const size_t n = schedule.regions.size();
+  std::map<const Region *, size_t> order;
+  for (size_t i = 0; i < n; i++) {
+    order[schedule.regions[i]] = i;
+  }
+
+  // Edges from the earlier to the later region in the serial order, which
+  // keeps the graph acyclic.
+  std::vector<std::set<size_t>> successors(n);
+  const auto addEdge = [&](size_t a, size_t b) {
+    if (a == b) return;
+    if (a > b) std::swap(a, b);
+    successors[a].insert(b);
+  };
+  std::map<Output *, std::vector<size_t>> readers;
+  std::map<Output *, std::vector<Link *>> readerLinks;
+  for (size_t dest = 0; dest < n; dest++) {
+    for (const auto &input : schedule.regions[dest]->getInputs()) {
+      for (const auto &link : input.second->getLinks()) {
+        if (link->getPropagationDelay() > 0)
+          continue;
+        Output *src = link->getSrc();
+        readers[src].push_back(dest);
+        readerLinks[src].push_back(link.get());
+        const auto found = order.find(src->getRegion());
+        if (found != order.end())
+          addEdge(found->second, dest);
+      }
+    }
+  }
+  for (const auto &output : readers) {
+    const auto &dests = output.second;
+    if (dests.size() < 2u)
+      continue;
+    // The readers of an SDR through sparse links each copy its active bits,
+    // so they need not wait for each other.
+    const auto &links = readerLinks[output.first];
+    if (std::all_of(links.begin(), links.end(), [](const Link *link) { return link->isSparse(); })) {
+      const Region *src = output.first->getRegion();
+      schedule.sharedOutputs[order.count(src) ? src : nullptr].push_back(output.first);
+      schedule.sparseCopyLinks.insert(schedule.sparseCopyLinks.end(), links.begin(), links.end());
+      continue;
+    }
+    for (size_t i = 1; i < dests.size(); i++) {
+      addEdge(dests[i - 1], dests[i]);
+    }
+  }
+
+  schedule.successors.resize(n);
+  schedule.numPredecessors.assign(n, 0u);
+  for (size_t i = 0; i < n; i++) {
+    schedule.successors[i].assign(successors[i].begin(), successors[i].end());
+    for (const size_t s : successors[i]) {
+      schedule.numPredecessors[s]++;
+    }
+  }
+  return schedule;
+}
+
+void Network::runPhaseParallel_(const PhaseSchedule_ &schedule, const std::function<void(Region *)> &task) {
+  const size_t n = schedule.regions.size();
+  std::vector<size_t> waiting(schedule.numPredecessors);
+  std::vector<size_t> ready;
+  for (size_t i = n; i-- > 0;) { // the first region is on top
+    if (waiting[i] == 0u)
+      ready.push_back(i);
+  }
+  std::mutex mutex;
+  std::condition_variable changed;
+  size_t finished = 0u;
+  bool failed = false;
+
+  threadPool_->parallelFor(threadPool_->size(), [&](size_t) {
+    // This worker's SDR callbacks run when it leaves the loop.
+    SDR::DeferCallbacks deferCallbacks;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      changed.wait(lock, [&]() { return failed || finished == n || !ready.empty(); });
+      if (failed || finished == n)
+        return;
+      const size_t i = ready.back();
+      ready.pop_back();
+      lock.unlock();
+      try {
+        task(schedule.regions[i]);
+      } catch (...) {
+        lock.lock();
+        failed = true;
+        changed.notify_all();
+        throw;
+      }
+      lock.lock();
+      finished++;
+      for (const size_t s : schedule.successors[i]) {
+        if (--waiting[s] == 0u)
+          ready.push_back(s);
+      }
+      changed.notify_all();
+    }
+  });
+}
+
+void Network::setPipelined(const bool pipelined) {
+  if (pipelined == pipelined_)
+    return;
+  if (pipelined) {
+    NTA_CHECK(batchSize_ <= 1u) << "setPipelined: the network runs batched, see setBatchSize().";
+    if (!initialized_)
+      initialize();
+    pipelineStages_(); // check that the network can be pipelined
+    pipelineFill_ = 0u;
+  } else {
+    // Drain: in step d the stages after the first d lag behind still.
+    const auto stages = pipelineStages_();
+    SDR::DeferCallbacks deferCallbacks;
+    for (size_t d = 1u; d <= pipelineFill_; d++) {
+      runPipelineStep_(stages, d);
+    }
+    pipelineFill_ = 0u;
+  }
+  pipelined_ = pipelined;
+}
+
+void Network::setBatchSize(const UInt batchSize) {
+  if (batchSize > 1u) {
+    NTA_CHECK(!pipelined_) << "setBatchSize: the network runs pipelined, see setPipelined().";
+    if (!initialized_)
+      initialize();
+    pipelineStages_("Batched"); // check that the network can be batched
+  }
+  batchSize_ = std::max(batchSize, 1u);
+}
+
+std::vector<const std::set<Region *> *> Network::pipelineStages_(const char *mode) const {
+  std::vector<const std::set<Region *> *> stages;
+  std::map<const Region *, size_t> stageOf;
+  for (UInt32 phase = minEnabledPhase_; phase <= maxEnabledPhase_ && phase < phaseInfo_.size(); phase++) {
+    bool computes = false;
+    for (const Region *r : phaseInfo_[phase]) {
+      // The data of "INPUT" is set from outside, see setInputData(), it
+      // is not a stage and the links from it may go anywhere.
+      if (r->getName() == "INPUT")
+        continue;
+      NTA_CHECK(stageOf.count(r) == 0u)
+        << mode << " run: region " << r->getName() << " is in more than one phase.";
+      stageOf[r] = stages.size();
+      computes = true;
+    }
+    if (computes)
+      stages.push_back(&phaseInfo_[phase]);
+  }
+  for (const auto &region : stageOf) {
+    for (const auto &input : region.first->getInputs()) {
+      for (const auto &link : input.second->getLinks()) {
+        NTA_CHECK(link->getPropagationDelay() == 0u)
+          << mode << " run: link " << link->toString() << " has a propagation delay.";
+        const auto src = stageOf.find(link->getSrc()->getRegion());
+        NTA_CHECK(src == stageOf.end() || src->second < region.second)
+          << mode << " run: link " << link->toString() << " does not go to a later phase.";
+      }
+    }
+  }
+  return stages;
+}
+
+void Network::runPipelineStep_(const std::vector<const std::set<Region *> *> &stages,
+                               size_t firstStage) {
+  if (stages.empty())
+    return;
+  const size_t lastStage = std::min(pipelineFill_, stages.size() - 1u);
+  if (firstStage > lastStage)
+    return;
+  // All inputs are copied before any stage computes, so each stage works on
+  // the previous output of the stage before it.
+  for (size_t k = firstStage; k <= lastStage; k++) {
+    for (Region *r : *stages[k])
+      r->prepareInputs(true);
+  }
+  const auto computeStage = [&](size_t k) {
+    for (Region *r : *stages[k])
+      r->compute();
+  };
+  const size_t numStages = lastStage - firstStage + 1u;
+  if (threadPool_ != nullptr && numStages > 1u) {
+    threadPool_->parallelFor(numStages, [&](size_t i) {
+      // This stage's SDR callbacks run when it is done.
+      SDR::DeferCallbacks deferCallbacks;
+      computeStage(firstStage + i);
+    });
+  } else {
+    for (size_t k = firstStage; k <= lastStage; k++)
+      computeStage(k);
+  }
+}
+
 void Network::initialize() {
 
   /*
@@ -536,22 +1439,55 @@ void Network::initialize() {
   if (initialized_)
     return;
 
+  if (arenaEnabled_ && arena_ == nullptr)
+    arena_ = std::make_shared<Arena>();
+  Arena::Scope arenaScope(arenaEnabled_ ? arena_ : nullptr);
+
+  // The placements with the defaults, see setPlacement().
+  std::map<const Region *, std::shared_ptr<Arena>> arenas;
+  std::map<const Region *, std::shared_ptr<ThreadPool>> pools;
+  for (const auto &p : regions_) {
+    const Placement placement = getPlacement(p.first);
+    Region *r = p.second.get();
+    r->cpus_ = placement.cpuSet();
+    r->arena_ = arenas[r] = arenaOf_(placement);
+    if (!placement.pool.empty()) {
+      pools[r] = getThreadPool(placement.pool);
+      NTA_CHECK(pools[r] != nullptr)
+        << "Region " << p.first << ": no thread pool '" << placement.pool << "', see addThreadPool().";
+    }
+  }
+
   /*
-   * 1. Calculate all Input/Output dimensions by evaluating links.
+   * 1. Calculate all Input/Output dimensions by evaluating links, in one
+   *    pass with the sources before their destinations.
    */
-  for (auto phase : phaseInfo_) { // evaluate regions in execution order
-    for (auto r : phase) {
-      r->evaluateLinks();
-    }
+  std::vector<Region *> order = linkOrder_();
+  for (Region *r : order) {
+    Arena::Scope regionScope(arenas[r]);
+    r->evaluateLinks();
   }
 
 
   /*
-   * 2. initialize region/impl
+   * 2. initialize region/impl. The dimensions and buffers are all set, so
+   *    only regions which share a buffer depend on each other (as in run()),
+   *    the others are initialized concurrently, see setNumThreads().
    */
-  for (auto p: regions_) {
-    std::shared_ptr<Region> r = p.second;
-    r->initialize();
+  if (threadPool_ != nullptr && order.size() > 1u) {
+    runPhaseParallel_(buildPhaseSchedule_(std::move(order)), [&arenas](Region *r) {
+      Arena::Scope workerScope(arenas.at(r));
+      r->initialize();
+    });
+  } else {
+    for (auto p: regions_) {
+      std::shared_ptr<Region> r = p.second;
+      Arena::Scope regionScope(arenas[r.get()]);
+      r->initialize();
+    }
+  }
+  for (const auto &p : pools) {
+    p.first->impl_->setThreadPool(p.second);
   }
 
   /*
@@ -565,6 +1501,70 @@ void Network::initialize() {
   initialized_ = true;
 }
 
+std::vector<Region *> Network::linkOrder_() const {
+  // Kahn's algorithm over the links without propagation delay, the ready
+  // regions in phase order. Links with a delay may close a cycle, the
+  // regions left in one are appended in phase order.
+  std::vector<Region *> serial;
+  std::map<const Region *, size_t> position;
+  for (const auto &phase : phaseInfo_) {
+    for (Region *r : phase) {
+      if (position.emplace(r, serial.size()).second)
+        serial.push_back(r);
+    }
+  }
+  for (const auto &p : regions_) { // not in a phase
+    if (position.emplace(p.second.get(), serial.size()).second)
+      serial.push_back(p.second.get());
+  }
+
+  const size_t n = serial.size();
+  std::vector<std::vector<size_t>> successors(n);
+  std::vector<size_t> numPredecessors(n, 0u);
+  for (size_t dest = 0; dest < n; dest++) {
+    for (const auto &input : serial[dest]->getInputs()) {
+      for (const auto &link : input.second->getLinks()) {
+        if (link->getPropagationDelay() > 0)
+          continue;
+        const auto src = position.find(link->getSrc()->getRegion());
+        if (src == position.end() || src->second == dest)
+          continue;
+        successors[src->second].push_back(dest);
+        numPredecessors[dest]++;
+      }
+    }
+  }
+
+  std::vector<Region *> order;
+  std::vector<bool> done(n, false);
+  std::set<size_t> ready;
+  for (size_t i = 0; i < n; i++) {
+    if (numPredecessors[i] == 0u)
+      ready.insert(i);
+  }
+  while (order.size() < n) {
+    if (ready.empty()) { // a cycle
+      for (size_t i = 0; i < n; i++) {
+        if (!done[i]) {
+          ready.insert(i);
+          break;
+        }
+      }
+    }
+    const size_t i = *ready.begin();
+    ready.erase(ready.begin());
+    if (done[i])
+      continue;
+    done[i] = true;
+    order.push_back(serial[i]);
+    for (const size_t s : successors[i]) {
+      if (--numPredecessors[s] == 0u && !done[s])
+        ready.insert(s);
+    }
+  }
+  return order;
+}
+
 const Collection<std::shared_ptr<Region>> Network::getRegions() const { 
   Collection<std::shared_ptr<Region>> regions;
   for(auto r: regions_) {
@@ -658,6 +1658,7 @@ void Network::post_load(std::vector<std::shared_ptr<Link>>& links) {
                      alink->getDestInputName(),
                      alink->getPropagationDelay());
       l->propagationDelayBuffer_ = alink->propagationDelayBuffer_;
+      l->delayHead_ = alink->delayHead_;
     }
     post_load();
 }
@@ -722,7 +1723,7 @@ std::string Network::phasesToString() const {
   ss << "]}";
   return ss.str();
 }
-void Network::phasesFromString(const std::string& phaseString) {
+void Network::phasesFromString(const std::string& phaseString, bool skipMissing) {
   std::string content = phaseString;
   content.erase(std::remove(content.begin(), content.end(), ','), content.end());
   std::stringstream ss(content);
@@ -751,8 +1752,10 @@ void Network::phasesFromString(const std::string& phaseString) {
       while (ss.peek() != ']') {
         ss >> tag;
         auto it = regions_.find(tag);
-        NTA_CHECK(it != regions_.end()) << "Region '" << tag << "' not found while decoding phase.";
-        phase.insert(it->second.get());
+        if (it != regions_.end())
+          phase.insert(it->second.get());
+        else
+          NTA_CHECK(skipMissing) << "Region '" << tag << "' not found while decoding phase.";
         ss >> std::ws;
       }
       ss.ignore(1); // ']'
@@ -765,14 +1768,453 @@ void Network::phasesFromString(const std::string& phaseString) {
 }
 
 
-void Network::enableProfiling() {
+void Network::runCallbacks_() {
+  for (UInt32 i = 0; i < callbacks_.getCount(); i++) {
+    const std::pair<std::string, callbackItem> &callback = callbacks_.getByIndex(i);
+    Tracer::Span span("callback", callback.first);
+    if (!profilingEnabled_) {
+      callback.second.first(this, iteration_, callback.second.second);
+      continue;
+    }
+    const UInt64 t0 = LatencyHistogram::now();
+    callback.second.first(this, iteration_, callback.second.second);
+    callbackProfile_[callback.first].record(LatencyHistogram::now() - t0);
+  }
+}
+
+std::string Network::getProfile() const {
+  std::stringstream ss;
+  ss << "{\"regions\": {";
+  const char *sep = "";
+  for (const auto &p : regions_) {
+    ss << sep << "\n  " << Value::json_string(p.first)
+       << ": {\"compute\": " << p.second->getComputeProfile().toJSON()
+       << ", \"prepareInputs\": " << p.second->getPrepareInputsProfile().toJSON();
+    const PerfCounters &counters = p.second->getComputeCounters();
+    if (counters.isAvailable())
+      ss << ", \"counters\": " << counters.toJSON();
+    ss << "}";
+    sep = ",";
+  }
+  ss << "},\n \"links\": {";
+  sep = "";
+  for (const auto &link : getLinks()) {
+    ss << sep << "\n  " << Value::json_string(link->getMoniker()) << ": " << link->getProfile().toJSON();
+    sep = ",";
+  }
+  ss << "},\n \"callbacks\": {";
+  sep = "";
+  for (const auto &p : callbackProfile_) {
+    ss << sep << "\n  " << Value::json_string(p.first) << ": " << p.second.toJSON();
+    sep = ",";
+  }
+  ss << "}}";
+  return ss.str();
+}
+
+namespace {
+  // One metric family of the Prometheus text format; all samples of a family
+  // must be consecutive, following its HELP and TYPE lines.
+  struct MetricFamily {
+    std::string type;
+    std::string help;
+    std::stringstream samples;
+  };
+
+  std::string metricLabel(const std::string &name, const std::string &value) {
+    std::string escaped;
+    for (char c : value) {
+      if (c == '\\' || c == '"') escaped += '\\';
+      if (c == '\n') { escaped += "\\n"; continue; }
+      escaped += c;
+    }
+    return name + "=\"" + escaped + "\"";
+  }
+
+  // Integral values (counts) are written exactly, others with 6 significant digits.
+  std::string metricValue(Real64 value) {
+    if (value == std::floor(value) && std::fabs(value) < 1e15)
+      return std::to_string(static_cast<Int64>(value));
+    std::stringstream ss;
+    ss << value;
+    return ss.str();
+  }
+
+  std::string metricLabels(const std::string &extra, const std::string &labels) {
+    if (extra.empty() && labels.empty()) return "";
+    if (extra.empty() || labels.empty()) return "{" + extra + labels + "}";
+    return "{" + extra + "," + labels + "}";
+  }
+} // namespace
+
+std::string Network::getMetrics(const std::string &labels) const {
+  std::map<std::string, MetricFamily> families;
+  auto family = [&families](const std::string &name, const char *type,
+                            const std::string &help) -> std::stringstream & {
+    MetricFamily &f = families[name];
+    if (f.type.empty()) {
+      f.type = type;
+      f.help = help;
+    }
+    return f.samples;
+  };
+
+  family("htm_network_iterations_total", "counter", "Number of iterations run.")
+      << "htm_network_iterations_total" << metricLabels("", labels) << " " << iteration_ << "\n";
+  if (iterationBudget_ > 0.0) {
+    family("htm_network_deadline_misses_total", "counter", "Iterations over the budget of setIterationBudget().")
+        << "htm_network_deadline_misses_total" << metricLabels("", labels) << " " << deadlineMisses_ << "\n";
+  }
+  for (const auto &d : degradedComputes_) {
+    family("htm_region_degraded_computes_total", "counter", "Computes degraded to meet the iteration budget.")
+        << "htm_region_degraded_computes_total" << metricLabels(metricLabel("region", d.first), labels) << " "
+        << d.second << "\n";
+  }
+
+  for (const auto &p : regions_) {
+    const Region &region = *p.second;
+    const std::string regionLabel = metricLabel("region", p.first);
+
+    const LatencyHistogram &h = region.getComputeProfile();
+    if (h.getCount() > 0u) {
+      auto &s = family("htm_region_compute_seconds", "summary",
+                       "Duration of Region::compute(), recorded while profiling.");
+      for (const auto &q : {std::make_pair("0.5", 50.0), std::make_pair("0.9", 90.0),
+                            std::make_pair("0.99", 99.0)}) {
+        s << "htm_region_compute_seconds"
+          << metricLabels(regionLabel + "," + metricLabel("quantile", q.first), labels) << " "
+          << metricValue(h.getPercentile(q.second)) << "\n";
+      }
+      s << "htm_region_compute_seconds_sum" << metricLabels(regionLabel, labels) << " "
+        << metricValue(h.getMean() * static_cast<Real64>(h.getCount())) << "\n";
+      s << "htm_region_compute_seconds_count" << metricLabels(regionLabel, labels) << " "
+        << h.getCount() << "\n";
+    }
+
+    for (const auto &out : region.getOutputs()) {
+      const Array &data = out.second->getData();
+      if (data.getType() != NTA_BasicType_SDR || data.getCount() == 0u)
+        continue;
+      family("htm_region_output_sparsity", "gauge", "Fraction of active bits of an SDR output.")
+          << "htm_region_output_sparsity"
+          << metricLabels(regionLabel + "," + metricLabel("output", out.first), labels) << " "
+          << metricValue(data.getSDRNoRefresh().getSparsity()) << "\n";
+    }
+
+    for (const auto &m : region.getMetrics()) {
+      const std::string name = "htm_region_" + m.first;
+      const bool counter = name.size() > 6u && name.compare(name.size() - 6u, 6u, "_total") == 0;
+      family(name, counter ? "counter" : "gauge", "Reported by the region implementation.")
+          << name << metricLabels(regionLabel, labels) << " " << metricValue(m.second) << "\n";
+    }
+  }
+
+  std::stringstream ss;
+  for (const auto &f : families) {
+    ss << "# HELP " << f.first << " " << f.second.help << "\n"
+       << "# TYPE " << f.first << " " << f.second.type << "\n"
+       << f.second.samples.str();
+  }
+  return ss.str();
+}
+
+
+MemoryUsage Network::memoryUsage() const {
+  MemoryUsage usage;
+  std::set<const void *> counted; // shared buffers, e.g. of an output and the linked input
+  const auto arrayBytes = [&counted](const Array &a) -> size_t {
+    if (!a.has_buffer())
+      return 0u;
+    if (a.getType() == NTA_BasicType_SDR) {
+      const SDR &sdr = a.getSDRNoRefresh();
+      return counted.insert(&sdr).second ? sdr.memoryUsage() : 0u;
+    }
+    return counted.insert(a.getBuffer()).second ? a.getCount() * BasicType::getSize(a.getType()) : 0u;
+  };
+
+  // outputs first, so that the inputs which share their buffers add nothing
+  for (const auto &p : regions_) {
+    size_t &bytes = usage[p.first + ".outputs"];
+    for (const auto &out : p.second->getOutputs()) {
+      bytes += arrayBytes(out.second->getData());
+      for (const auto &a : out.second->getBatch())
+        bytes += arrayBytes(a);
+    }
+  }
+  for (const auto &p : regions_) {
+    memory::add(usage, p.first + ".", p.second->memoryUsage());
+    size_t &bytes = usage[p.first + ".inputs"];
+    for (const auto &in : p.second->getInputs()) {
+      bytes += arrayBytes(in.second->getData());
+      for (const auto &a : in.second->getBatch())
+        bytes += arrayBytes(a);
+    }
+  }
+  size_t &links = usage["links"];
+  for (const auto &link : getLinks()) {
+    for (const auto &a : link->getDelayBuffer())
+      links += arrayBytes(a);
+  }
+  return usage;
+}
+
+
+void Network::saveCheckpointState_(CheckpointWriter &writer,
+                                   const std::function<void(const Connections &, const std::string &)> &saveConnections) const {
+  std::stringstream state;
+  {
+    const Connections::ExternalSerialization external(saveConnections, nullptr);
+    save(state, SerializableFormat::BINARY);
+  }
+  const std::string bytes = state.str();
+  writer.write("network.state", bytes.data(), bytes.size());
+}
+
+void Network::saveCheckpoint(const std::string &path) {
+  // identifies the base in its deltas
+  const UInt64 id = static_cast<UInt64>(std::chrono::steady_clock::now().time_since_epoch().count()) ^ (iteration_ << 32u);
+  CheckpointWriter writer(path);
+  writer.writeValue("network.base", id);
+  std::map<std::string, std::shared_ptr<ConnectionsDelta>> deltas;
+  saveCheckpointState_(writer, [&](const Connections &connections, const std::string &name) {
+    const auto tracked = deltas_.find(name);
+    std::shared_ptr<ConnectionsDelta> delta;
+    if (tracked != deltas_.end() && &tracked->second->getConnections() == &connections)
+      delta = tracked->second;
+    else // the network owns the regions, and so their Connections
+      delta = std::make_shared<ConnectionsDelta>(const_cast<Connections &>(connections));
+    delta->saveBase(writer, name);
+    deltas[name] = delta;
+  });
+  writer.close();
+  deltas_ = std::move(deltas);
+  checkpointBase_ = path;
+  checkpointBaseId_ = id;
+}
+
+void Network::saveDeltaCheckpoint(const std::string &path) {
+  NTA_CHECK(!checkpointBase_.empty()) << "saveDeltaCheckpoint: there is no base, call saveCheckpoint() first";
+  const CheckpointReader base(checkpointBase_);
+  NTA_CHECK(base.readValue<UInt64>("network.base") == checkpointBaseId_)
+      << "saveDeltaCheckpoint: the base " << checkpointBase_ << " was replaced, call saveCheckpoint()";
+  CheckpointWriter writer(path);
+  writer.writeValue("network.delta", checkpointBaseId_);
+  saveCheckpointState_(writer, [&](const Connections &connections, const std::string &name) {
+    const auto delta = deltas_.find(name);
+    NTA_CHECK(delta != deltas_.end() && &delta->second->getConnections() == &connections &&
+              !delta->second->needsBase())
+        << "saveDeltaCheckpoint: the Connections changed structurally since the base, call saveCheckpoint()";
+    delta->second->saveDelta(writer, base, name);
+  });
+  writer.close();
+}
+
+void Network::loadCheckpoint(const std::string &basePath, const std::string &deltaPath) {
+  const CheckpointReader base(basePath);
+  std::unique_ptr<CheckpointReader> delta;
+  if (!deltaPath.empty()) {
+    delta.reset(new CheckpointReader(deltaPath));
+    NTA_CHECK(delta->has("network.delta") &&
+              delta->readValue<UInt64>("network.delta") == base.readValue<UInt64>("network.base"))
+        << "loadCheckpoint: " << deltaPath << " is not a delta of " << basePath;
+  }
+  const auto bytes = (delta ? *delta : base).section("network.state");
+  std::stringstream state(std::string(bytes.first, bytes.second));
+  const Connections::ExternalSerialization external(nullptr, [&](Connections &connections, const std::string &name) {
+    if (delta)
+      ConnectionsDelta::load(connections, base, *delta, name);
+    else
+      connections.loadCheckpoint(base, name);
+  });
+  load(state, SerializableFormat::BINARY);
+}
+
+Network Network::clone() const {
+  std::vector<Connections *> connections;
+  std::stringstream state;
+  {
+    const Connections::ExternalSerialization external([&](const Connections &c, const std::string &) {
+      // the network owns the regions, and so their Connections
+      connections.push_back(&const_cast<Connections &>(c));
+    }, nullptr);
+    save(state, SerializableFormat::BINARY);
+  }
+  Network copy;
+  size_t next = 0u;
+  const Connections::ExternalSerialization external(nullptr, [&](Connections &c, const std::string &name) {
+    NTA_CHECK(next < connections.size()) << "Network::clone: no " << name << " in the source";
+    c.shareFrom(*connections[next++]);
+  });
+  copy.load(state, SerializableFormat::BINARY);
+  return copy;
+}
+
+void Network::saveToChunkedFile(const std::string &path, size_t numThreads, bool compress) const {
+  FileSink file(path);
+  saveToChunkedFile(file, numThreads, compress);
+}
+
+void Network::saveToChunkedFile(CheckpointSink &sink, size_t numThreads, bool compress) const {
+  std::vector<std::string> names;
+  std::vector<std::shared_ptr<Region>> regions;
+  for (const auto &r : regions_) {
+    names.push_back(r.first);
+    regions.push_back(r.second);
+  }
+  std::stringstream header;
+  {
+    cereal::BinaryOutputArchive ar(header);
+    const std::vector<std::shared_ptr<Link>> links = getLinks();
+    ar(iteration_, names, links, phasesToString(), compress);
+  }
+  CheckpointWriter writer(sink);
+  const std::string bytes = header.str();
+  writer.write("network.chunked", bytes.data(), bytes.size());
+
+  // The pool takes the regions in order, so a thread waits at most for the
+  // ones taken before its own to be written.
+  std::mutex mutex;
+  std::condition_variable written;
+  size_t next = 0u;
+  bool failed = false;
+  const size_t cores = numThreads > 0u ? numThreads : std::thread::hardware_concurrency();
+  ThreadPool pool(std::max<size_t>(1u, std::min(cores, regions.size())));
+  pool.parallelFor(regions.size(), [&](size_t i) {
+    try {
+      std::string block;
+      {
+        std::stringstream ss;
+        regions[i]->save(ss, SerializableFormat::BINARY);
+        block = compress ? Compression::compress(ss.str()) : ss.str();
+      }
+      std::unique_lock<std::mutex> lock(mutex);
+      written.wait(lock, [&]() { return next == i || failed; });
+      if (failed)
+        return;
+      writer.write("region." + names[i], block.data(), block.size());
+      next++;
+    } catch (...) {
+      {
+        const std::lock_guard<std::mutex> lock(mutex);
+        failed = true;
+        writer.abandon();
+      }
+      written.notify_all();
+      throw;
+    }
+    written.notify_all();
+  });
+  writer.close();
+}
+
+void Network::loadFromChunkedFile(const std::string &path, const std::vector<std::string> &regions, size_t numThreads) {
+  NTA_CHECK(regions_.empty()) << "loadFromChunkedFile: the network must be empty";
+  const CheckpointReader reader(path);
+  loadFromChunked_(reader, regions, numThreads);
+}
+
+void Network::loadFromChunkedFile(const CheckpointSource &source, const std::vector<std::string> &regions,
+                                  size_t numThreads) {
+  NTA_CHECK(regions_.empty()) << "loadFromChunkedFile: the network must be empty";
+  const CheckpointReader reader(source);
+  loadFromChunked_(reader, regions, numThreads);
+}
+
+void Network::loadFromChunked_(const CheckpointReader &reader, const std::vector<std::string> &regions,
+                               size_t numThreads) {
+  UInt64 iteration;
+  std::vector<std::string> names;
+  std::vector<std::shared_ptr<Link>> links;
+  std::string phases;
+  bool compressed;
+  {
+    std::stringstream header(reader.readSection("network.chunked"));
+    cereal::BinaryInputArchive ar(header);
+    ar(iteration, names, links, phases, compressed);
+  }
+  const std::vector<std::string> &selected = regions.empty() ? names : regions;
+  for (const auto &name : selected) {
+    NTA_CHECK(std::find(names.begin(), names.end(), name) != names.end())
+        << "loadFromChunkedFile: no region '" << name << "'";
+  }
+
+  std::vector<std::shared_ptr<Region>> loaded(selected.size());
+  const size_t cores = numThreads > 0u ? numThreads : std::thread::hardware_concurrency();
+  ThreadPool pool(std::max<size_t>(1u, std::min(cores, selected.size())));
+  pool.parallelFor(selected.size(), [&](size_t i) {
+    std::stringstream ss;
+    {
+      const std::string block = reader.readSection("region." + selected[i]);
+      ss.str(compressed ? Compression::decompress(block.data(), block.size()) : block);
+    }
+    auto region = std::make_shared<Region>(this);
+    region->load(ss, SerializableFormat::BINARY);
+    loaded[i] = region;
+  });
+
+  iteration_ = iteration;
+  for (const auto &region : loaded)
+    regions_[region->getName()] = region;
+  std::vector<std::shared_ptr<Link>> kept;
+  for (const auto &link : links) {
+    if (regions_.count(link->getSrcRegionName()) && regions_.count(link->getDestRegionName()))
+      kept.push_back(link);
+  }
+  post_load(kept);
+  phasesFromString(phases, !regions.empty());
+}
+
+std::future<void> Network::saveAsync(const std::string &path, SerializableFormat fmt) const {
+  const std::string partial = path + ".partial";
+#if defined(NTA_OS_WINDOWS)
+  auto bytes = std::make_shared<std::string>();
+  {
+    std::stringstream ss;
+    save(ss, fmt);
+    *bytes = ss.str();
+  }
+  return std::async(std::launch::async, [bytes, partial, path]() {
+    {
+      std::ofstream out(partial, std::ios::binary | std::ios::trunc);
+      out.write(bytes->data(), static_cast<std::streamsize>(bytes->size()));
+      NTA_CHECK(out.good()) << "saveAsync: cannot write " << partial;
+    }
+    Path::rename(partial, path);
+  });
+#else
+  const pid_t pid = fork();
+  NTA_CHECK(pid >= 0) << "saveAsync: fork failed, errno " << errno;
+  if (pid == 0) {
+    // child: the address space is a copy-on-write snapshot of the caller
+    int status = 1;
+    try {
+      saveToFile(partial, fmt);
+      status = 0;
+    } catch (...) {
+    }
+    _exit(status);
+  }
+  return std::async(std::launch::async, [pid, partial, path]() {
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0) {
+      NTA_CHECK(errno == EINTR) << "saveAsync: waitpid failed, errno " << errno;
+    }
+    NTA_CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0) << "saveAsync: saving " << path << " failed";
+    Path::rename(partial, path);
+  });
+#endif
+}
+
+void Network::enableProfiling(bool perfCounters) {
+  profilingEnabled_ = true;
   for (auto p: regions_) {
     std::shared_ptr<Region> r = p.second;
-    r->enableProfiling();
+    r->enableProfiling(perfCounters);
   }
 }
 
 void Network::disableProfiling() {
+  profilingEnabled_ = false;
   for (auto p: regions_) {
     std::shared_ptr<Region> r = p.second;
     r->disableProfiling();
@@ -780,6 +2222,7 @@ void Network::disableProfiling() {
 }
 
 void Network::resetProfiling() {
+  callbackProfile_.clear();
   for (auto p: regions_) {
     std::shared_ptr<Region>  r = p.second;
     r->resetProfiling();
@@ -22,8 +22,13 @@
 #ifndef NTA_NETWORK_HPP
 #define NTA_NETWORK_HPP
 
+#include <atomic>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <list>
 #include <map>
+#include <mutex>
 #include <set>
 #include <string>
 #include <vector>
@@ -34,18 +39,30 @@
 
 #include <htm/types/Serializable.hpp>
 #include <htm/types/Types.hpp>
+#include <htm/utils/Arena.hpp>
+#include <htm/utils/Checkpoint.hpp>
+#include <htm/utils/LatencyHistogram.hpp>
 #include <htm/utils/Log.hpp>
+#include <htm/utils/ThreadPool.hpp>
 
 namespace htm {
 
 class Region;
 class Dimensions;
+class IngestQueue;
+class TrafficCapture;
 class RegisteredRegionImpl;
 class Link;
+class Connections;
+class ConnectionsDelta;
 
 /**
  * Represents an HTM network. A network is a collection of regions.
  *
+ * A Network is not thread-safe: use each Network from one thread at a time.
+ * Different Networks can be built and run on different threads concurrently,
+ * see NetworkExecutor.  The log level (setLogLevel) is per thread.
+ *
  * @nosubgrouping
  */
   class Network : public Serializable
@@ -92,6 +109,15 @@ public:
    *             type: <region type>
    *             params: <list of parameters>  (optional)
    *             phase:  <optonal phase number> (optional)
+   *             placement: <placement> (optional, see setPlacement())
+   *
+   *         - placement: <placement>   (default of all regions, see setDefaultPlacement())
+   *
+   *         - addThreadPool:
+   *             name: <pool name>
+   *             threads: <number of threads>
+   *             cpus: <list of CPUs> (optional)
+   *             numaNode: <NUMA node> (optional)
    *
    *         - addLink:
    *             src: <Name of the source region "." Output name>
@@ -104,12 +130,16 @@ public:
    *       {addRegion: {name: <region name>, type: <region type>, params: {<parameters>}, phase: <phase>}},
    *       {addLink:   {src: "<region name>.<output name>", dest: "<region name>.<output name>", delay: <delay>}},
    *    ]}
+   *   where a <placement> is {cpus: [<CPU>, ...], numaNode: <node>, pool: <pool name>}, all optional.
   *
    * JSON example:
    *   {network: [
+   *       {addThreadPool: {name: "node0", threads: 4, numaNode: 0}},
    *       {addRegion: {name: "encoder", type: "RDSERegion", params: {size: 1000, sparsity: 0.2, radius: 0.03, seed: 2019, noise: 0.01}}},
-   *       {addRegion: {name: "sp", type: "SPRegion", params: {columnCount: 2048, globalInhibition: true}}},
-   *       {addRegion: {name: "tm", type: "TMRegion", params: {cellsPerColumn: 8, orColumnOutputs: true}}},
+   *       {addRegion: {name: "sp", type: "SPRegion", params: {columnCount: 2048, globalInhibition: true},
+   *                    placement: {numaNode: 0, pool: "node0"}}},
+   *       {addRegion: {name: "tm", type: "TMRegion", params: {cellsPerColumn: 8, orColumnOutputs: true},
+   *                    placement: {numaNode: 0, pool: "node0"}}},
    *       {addLink:   {src: "encoder.encoded", dest: "sp.bottomUpIn"}},
    *       {addLink:   {src: "sp.bottomUpOut", dest: "tm.bottomUpIn"}}
    *    ]}
@@ -139,9 +169,33 @@ public:
    * before Network.run(). However, if you don't call it, Network.run() will
    * call it for you. Also sets up various memory buffers etc. once the Network
    *  structure has been finalized.
+   *
+   * The buffers allocated meanwhile -- the Input and Output data, the delay
+   * buffers of the links, the SDR objects of SDR buffers -- come from an
+   * Arena of this network, unless setArenaEnabled(false) was called: the
+   * arena of the NUMA node of the region, see setPlacement().
    */
   void initialize();
 
+  /**
+   * Whether initialize() allocates the buffers of the network from its own
+   * Arena: a few large chunks (huge pages where available) rather than one
+   * heap allocation per buffer, released together when the network and the
+   * last copy of its buffers are gone. Default is on; not serialized.
+   */
+  void setArenaEnabled(bool enabled) { arenaEnabled_ = enabled; }
+  bool isArenaEnabled() const noexcept { return arenaEnabled_; }
+
+  /**
+   * @return the arena of the buffers, or null before initialize().
+   */
+  const Arena *getArena() const noexcept { return arena_.get(); }
+  /**
+   * @return the arena of the buffers of the regions on NUMA node `numaNode`,
+   *   or null if there are none.
+   */
+  const Arena *getArena(int numaNode) const;
+
   /**
    * @}
    *
@@ -187,6 +241,8 @@ public:
     std::string name, phases;
     ar(cereal::make_nvp("name", name));  // ignore value
     ar(cereal::make_nvp("iteration", iteration_));
+    deltas_.clear(); //before the regions, and their Connections, are replaced
+    checkpointBase_.clear();
     ar(cereal::make_nvp("Regions", regions_));
     ar(cereal::make_nvp("links", links));
     ar(cereal::make_nvp("phases", phases));
@@ -195,6 +251,118 @@ public:
     phasesFromString(phases);
   }
 
+  /**
+   * Incremental checkpoints, for networks which change little between saves.
+   *
+   *    saveCheckpoint(path)        A full checkpoint, the base of the deltas.
+   *    saveDeltaCheckpoint(path)   Only what changed since the last base.
+   *    loadCheckpoint(base [, delta])
+   *
+   * The Connections of the regions (e.g. of SPRegion and TMRegion) are
+   * stored as flat arrays, and a delta holds only their segments and
+   * synapses changed since the base, see ConnectionsDelta. Everything else of
+   * the network is small and is saved in full, in the cereal BINARY format,
+   * each time.
+   *
+   * Deltas are cumulative: restore from the base and the latest delta alone.
+   * They grow as the network learns; compact them into a new base with
+   * saveCheckpoint() from time to time. A new base is also required after
+   * regions were added or removed, or Connections were compacted;
+   * saveDeltaCheckpoint() throws then. The base file must stay in place while deltas of it are written.
+   */
+  void saveCheckpoint(const std::string &path);
+  void saveDeltaCheckpoint(const std::string &path);
+  void loadCheckpoint(const std::string &basePath, const std::string &deltaPath = "");
+
+  /**
+   * A copy of this network, e.g. one of many streams run from a trained
+   * template. The Connections of the regions share their segments and
+   * synapses with the template until either of the two changes them (see
+   * Connections::shareFrom()), so a clone which only infers costs little
+   * memory and is made quickly; one which learns copies them on its first
+   * learning compute. Everything else of the network is small and is copied
+   * by a save() and load() in memory.
+   *
+   * Like after load(), the settings which are not serialized (threads,
+   * pipeline, batch size, callbacks) are the defaults in the clone.
+   */
+  Network clone() const;
+
+  /**
+   * Chunked serialization: each region is serialized (cereal BINARY) and
+   * compressed on its own thread into a section of a CheckpointWriter file,
+   * next to a small section with the iteration, links and phases. The
+   * section table is the index, so loading also runs in parallel and can
+   * pick out some of the regions.
+   *
+   * @param numThreads - 0 is one per core, at most one per region.
+   * @param compress   - with Compression, else stored.
+   * @param regions    - the regions to load, all if empty. The links
+   *                     between loaded regions are kept, others dropped.
+   *
+   * loadFromChunkedFile() requires an empty network.
+   *
+   * The sink and source overloads stream the checkpoint instead of a local
+   * file, eg. a MultipartSink uploads it to object storage while the regions
+   * are still being serialized, and a RangeSource restores straight from
+   * it. Each section is written as soon as it and those before it are done,
+   * and each region is fetched only by the thread which loads it, so about
+   * numThreads regions are in memory at a time, not the whole checkpoint.
+   */
+  void saveToChunkedFile(const std::string &path, size_t numThreads = 0u, bool compress = true) const;
+  void saveToChunkedFile(CheckpointSink &sink, size_t numThreads = 0u, bool compress = true) const;
+  void loadFromChunkedFile(const std::string &path, const std::vector<std::string> &regions = {},
+                           size_t numThreads = 0u);
+  void loadFromChunkedFile(const CheckpointSource &source, const std::vector<std::string> &regions = {},
+                           size_t numThreads = 0u);
+
+  /**
+   * Saves a snapshot of the network in the background, like saveToFile().
+   * The snapshot is taken when saveAsync() is called and costs about as
+   * much as a fork: on POSIX a child process writes its copy-on-write image
+   * of the model while run() continues here. On Windows the state is
+   * serialized to memory first and only the file write is in the background.
+   *
+   * The file is written as path + ".partial" and renamed when complete.
+   * The returned future becomes ready then; get() rethrows a failure.
+   * Call it between run()s, not from a callback inside one.
+   */
+  std::future<void> saveAsync(const std::string &path,
+                              SerializableFormat fmt = SerializableFormat::BINARY) const;
+
+  /**
+   * Hot swap: replaces the state of a region while the network keeps
+   * running, eg. with an SPRegion or TMRegion retrained offline.
+   *
+   * The replacement is loaded on a background thread: from a file of
+   * Region::saveToFile() of a region of the same type and dimensions (see
+   * Region::loadImpl()), or made by `load`. It is swapped in between two
+   * iterations, at the start of the first iteration of run() after it is
+   * loaded, or by applyRegionSwaps(). Only the impl of the region is
+   * replaced; its links, buffers and current outputs stay, so there is
+   * nothing to initialize. A later swap of the same region wins.
+   *
+   * Swapping a region starts a new base of the delta checkpoints, see
+   * saveCheckpoint().
+   *
+   * @returns a future which is ready when the region is swapped in. get()
+   *   rethrows a failure to load, which leaves the region as it was.
+   */
+  std::shared_future<void> swapRegionAsync(const std::string &region, const std::string &path,
+                                           SerializableFormat fmt = SerializableFormat::BINARY);
+  std::shared_future<void> swapRegionAsync(const std::string &region,
+                                           const std::function<RegionImpl *(Region *)> &load);
+
+  /**
+   * Swap in the replacements which are loaded, now (run() does so before
+   * each iteration). Not during run().
+   * @returns the number of regions swapped in.
+   */
+  size_t applyRegionSwaps();
+
+  /** @returns whether swaps of swapRegionAsync() are pending. */
+  bool hasPendingSwaps() const noexcept { return numSwaps_ > 0u; }
+
   /**
    * @}
    *
@@ -212,15 +380,19 @@ public:
    *        Type of node in the region, e.g. "FDRNode"
    * @param nodeParams
    *        A JSON-encoded string specifying writable params
+   * @param placement
+   *        Where the region computes and its buffers are, see setPlacement()
    *
    * @returns A pointer to the newly created Region
    */
   std::shared_ptr<Region> addRegion(const std::string &name,
   					                        const std::string &nodeType,
-                                    const std::string &nodeParams);
+                                    const std::string &nodeParams,
+                                    const Placement &placement = Placement());
   std::shared_ptr<Region> addRegion(const std::string &name, 
                                     const std::string &nodeType,
-                                    ValueMap& vm);
+                                    ValueMap& vm,
+                                    const Placement &placement = Placement());
   /**
     * Add a region in a network from deserialized region
     *
@@ -265,6 +437,27 @@ public:
             const std::string &destInput = "",
             const size_t propagationDelay = 0);
 
+  /**
+   * Add an ensemble: regions of the same type which all read one output,
+   * eg. TemporalMemories with different seeds or parameters on one
+   * SpatialPooler, so the encoder and the SpatialPooler compute once for all
+   * of them.  With setNumThreads() the members compute concurrently, each
+   * with a copy of the active bits of the shared SDR, see there.
+   *
+   * @param name - the members are named name + "0", name + "1", ...
+   * @param nodeType - type of the members, eg. "TMRegion"
+   * @param params - the parameters of each member, one entry per member.
+   * @param srcName, srcOutput - the output they all read, "" for the default.
+   * @param destInput - the input of each member it is linked to, "" for the default.
+   *
+   * @returns the members, in order.
+   */
+  std::vector<std::shared_ptr<Region>> addEnsemble(const std::string &name, const std::string &nodeType,
+                                                   const std::vector<std::string> &params,
+                                                   const std::string &srcName,
+                                                   const std::string &srcOutput = "",
+                                                   const std::string &destInput = "");
+
   /**
    * Removes a link.
    *
@@ -288,6 +481,87 @@ public:
   virtual void setInputData(const std::string &sourceName, const Array &data);
   virtual void setInputData(const std::string &sourceName, const Value &vm);
 
+  /**
+   * Typed setInputData(), for callers which push many records: copies count
+   * values straight into the buffer of the "INPUT" output <sourceName>,
+   * without a Value tree or an Array.  The values must be of the type of that
+   * output (setInputData(Array) converts), or the output an SDR, which takes
+   * them as dense values, non-zero is true.
+   */
+  void setInputData(const std::string &sourceName, NTA_BasicType type,
+                    const void *data, size_t count);
+  template <typename T>
+  void setInputData(const std::string &sourceName, const T *data, size_t count) {
+    setInputData(sourceName, BasicType::getType<T>(), data, count);
+  }
+  template <typename T>
+  void setInputData(const std::string &sourceName, const std::vector<T> &data) {
+    setInputData(sourceName, BasicType::getType<T>(), data.data(), data.size());
+  }
+
+  /**
+   * Set the SDR of the "INPUT" output <sourceName> from its sorted active
+   * indices, without the dense values.
+   */
+  void setInputSparse(const std::string &sourceName, const UInt *sparse, size_t count);
+  void setInputSparse(const std::string &sourceName, const std::vector<UInt> &sparse) {
+    setInputSparse(sourceName, sparse.data(), sparse.size());
+  }
+
+  /**
+   * Push the next numRecords records of the "INPUT" output <sourceName> at
+   * once, for a batched run (see setBatchSize()): data holds the records one
+   * after another, each of the count of the output.  run(numRecords) then
+   * feeds record i to iteration i.  The records are used by the next run()
+   * only, with a batch size of at least numRecords.
+   */
+  void setInputBatch(const std::string &sourceName, NTA_BasicType type,
+                     const void *data, size_t numRecords);
+  template <typename T>
+  void setInputBatch(const std::string &sourceName, const T *data, size_t numRecords) {
+    setInputBatch(sourceName, BasicType::getType<T>(), data, numRecords);
+  }
+
+  /**
+   * As setInputBatch(), for an SDR output: record i has the active indices
+   * sparse[ends[i - 1], ends[i]) (from 0 for i = 0).
+   */
+  void setInputSparseBatch(const std::string &sourceName, const UInt *sparse,
+                           const size_t *ends, size_t numRecords);
+
+  /**
+   * Run the records of queue as a producer thread pushes them, until the
+   * queue is closed and empty or maxRecords ran (0 is no limit).  Each
+   * record sets the "INPUT" outputs of queue.sources() for an iteration.
+   * With setBatchSize() > 1, the records which are waiting run together in
+   * a batched run, up to the batch size.  Returns the number of records run.
+   * See IngestQueue.
+   */
+  size_t runFromQueue(IngestQueue &queue, size_t maxRecords = 0u);
+
+  /**
+   * Capture the data of the "INPUT" outputs <sources> (all of them if
+   * empty) into a binary log at path, a record per iteration which run()
+   * computes, until stopCapture().  Whichever way the data was set:
+   * setInputData(), setInputBatch(), runFromQueue(), ...
+   * replayCapture() then feeds the log into a Network with the same "INPUT"
+   * outputs, eg. a benchmark on real traffic.  See TrafficCapture.
+   */
+  void startCapture(const std::string &path, const std::vector<std::string> &sources = {});
+  /** Writes the rest of the log and closes it, returns the number of records. */
+  UInt64 stopCapture();
+  bool isCapturing() const noexcept { return capture_ != nullptr; }
+
+  /**
+   * Run the records of a log of startCapture(), each sets the "INPUT"
+   * outputs of the log for one iteration, until the end of the log or
+   * maxRecords ran (0 is no limit).  With speed 0 the records run as fast
+   * as they can, with setBatchSize() > 1 in batched runs; else one at a time,
+   * at the pace of the capture times speed (1 is the original timing).
+   * Returns the number of records run.
+   */
+  size_t replayCapture(const std::string &path, Real64 speed = 0.0, size_t maxRecords = 0u);
+
   /**
    * @}
    *
@@ -392,6 +666,175 @@ public:
    */
   void run(int n);
 
+  /**
+   * Compute the independent regions of a phase concurrently.
+   *
+   * run() then builds a dependency graph of the regions in each phase from
+   * their links, and computes a region on the next free thread as soon as
+   * the regions it depends on are done.  Region B depends on region A, of
+   * the same phase, if
+   *   - a link without propagation delay connects them, in either direction:
+   *     the one which comes first in the serial order goes first, or
+   *   - both read the same Output through links without propagation delay,
+   *     as the Input buffers can share the Output's data; except an SDR
+   *     Output read only by such links (eg. the SpatialPooler of an ensemble,
+   *     see addEnsemble()).  Its sparse indices are computed once, when it
+   *     is done, and each reader gets a copy of them rather than the Output's
+   *     SDR, whose caches are not safe to refresh from several threads.
+   * Links with a propagation delay read buffered data and add no dependency,
+   * and the phases still run one after another.  So each region sees the
+   * same inputs as in the serial run, and the results are identical.
+   *
+   * The regions of a phase must not share any state other than through
+   * links.  The SDR callbacks of a region's outputs run once per iteration
+   * as in the serial run, but on the thread which computed the region, as
+   * soon as it has no more ready regions.
+   *
+   * initialize() initializes the regions (e.g. builds the SpatialPooler
+   * and TemporalMemory) concurrently too, with the same dependencies, once
+   * the dimensions of all links are resolved.  Set it before initialize()
+   * to shorten the cold start.
+   *
+   * The setting is not serialized, default is 1: the serial run.
+   *
+   * @param numThreads - number of threads including the caller, 0 or 1 turns
+   *   the threading off.
+   */
+  void setNumThreads(const UInt numThreads);
+  UInt getNumThreads() const noexcept {
+    return threadPool_ == nullptr ? 1u : static_cast<UInt>(threadPool_->size()); }
+
+  /**
+   * Placement of a region, eg. an SP and the TM reading from it on the CPUs
+   * of one cache or NUMA node (see Placement):
+   *   - cpus, numaNode: the thread computing the region (on any path of
+   *     run(), and in initialize()) is pinned to these CPUs, or to those of
+   *     the node, while it does.  Regions which compute in the background
+   *     (RegionImpl::isAsync()) are pinned only until they start.
+   *   - numaNode, else the node of the first of cpus: the buffers of the
+   *     region come from an Arena of that node, and the memory which the
+   *     region allocates in initialize() is first touched there.
+   *   - pool: a thread pool of addThreadPool(), which the region's algorithm
+   *     uses for its own parallel work (eg. the Connections of SPRegion and
+   *     TMRegion) instead of threads of its own.
+   * A member left empty is taken from setDefaultPlacement().  They are all
+   * hints: where the system does not support them they are ignored.
+   *
+   * Placements apply from the next initialize(); they are not serialized.
+   */
+  void setPlacement(const std::string &region, const Placement &placement);
+  void setDefaultPlacement(const Placement &placement) { defaultPlacement_ = placement; }
+  const Placement &getDefaultPlacement() const noexcept { return defaultPlacement_; }
+  /** @return the placement of a region, with the defaults filled in. */
+  Placement getPlacement(const std::string &region) const;
+
+  /**
+   * Add a named thread pool for the placements of regions, see setPlacement().
+   * The regions which name it share its threads and take turns in using them.
+   *
+   * @param numThreads - number of threads including the caller.
+   * @param cpus - the CPUs to pin its workers to, empty for any.
+   */
+  void addThreadPool(const std::string &name, UInt numThreads, const std::vector<int> &cpus = {});
+  /** @return the pool of addThreadPool(), or null. */
+  std::shared_ptr<ThreadPool> getThreadPool(const std::string &name) const;
+
+  /**
+   * Pipelined run, for feed forward networks such as inference over recorded
+   * data.
+   *
+   * Each enabled phase is a stage of the pipeline.  In every iteration all
+   * stages first copy their inputs, and then compute concurrently (with
+   * setNumThreads() > 1): stage k works on the record which stage k-1
+   * computed in the previous iteration.  So the output of stage k lags k
+   * iterations behind the output of the first stage.  Each region computes
+   * the same sequence of records as in the serial run, with the same
+   * results; the stages which have no record yet do not compute.
+   *
+   * The links must all be without propagation delay, and go from a region
+   * to a region of a later phase; each region must be in one phase.
+   *
+   * Turning the pipeline off drains it: the stages which lag behind compute
+   * until all of them processed the last record.  Run callbacks see the
+   * network mid pipeline.  Save the network after turning the pipeline off;
+   * the setting is not serialized, default is off.
+   */
+  void setPipelined(const bool pipelined);
+  bool isPipelined() const noexcept { return pipelined_; }
+
+  /**
+   * Batched run, for feed forward networks such as inference over recorded
+   * data.
+   *
+   * run() computes batchSize iterations at a time, phase after phase: each
+   * region computes all records of the batch before the next region starts,
+   * see Region::computeBatch().  Source regions (file readers, encoders)
+   * thus produce batchSize records, which regions whose impl
+   * canComputeBatch() (e.g. SPRegion with learningMode off) process
+   * together; all others compute them one by one.  The results are those of
+   * the serial run, but the run callbacks and the SDR callbacks run once per
+   * batch, afterwards.
+   *
+   * The network must satisfy the conditions of setPipelined(), which is
+   * exclusive with this.  The setting is not serialized, default is 1: no
+   * batching.
+   */
+  void setBatchSize(const UInt batchSize);
+  UInt getBatchSize() const noexcept { return batchSize_; }
+
+  /**
+   * Skip the regions whose inputs did not change, for networks which see
+   * long runs of the same input (flat metrics, idle sensors).
+   *
+   * Each output counts the changes of its data in an epoch, compared by a
+   * hash of the data after every compute(), see Output::getEpoch().  A region
+   * whose impl isPure() (eg. the encoders, SPRegion and ClassifierRegion
+   * without learning) does not compute when the epochs of all its incoming
+   * links are those of its last compute, and keeps its outputs; so their
+   * epochs do not change either and the regions after it may skip too.
+   * A delayed link counts a change in every iteration.  Setting a parameter
+   * or executing a command makes the region compute again.
+   *
+   * Data must come in through links and setInputData(); an output or input
+   * buffer written by other means is not noticed.  Applies to the serial and
+   * threaded run(), not to the pipelined or batched run.  The setting is not
+   * serialized, default is off.
+   */
+  void setSkipUnchanged(const bool skipUnchanged) { skipUnchanged_ = skipUnchanged; }
+  bool isSkipUnchanged() const noexcept { return skipUnchanged_; }
+
+  /**
+   * A time budget per iteration, for services with a fixed latency per
+   * record: rather than fall behind in a burst, the regions of degradeOrder
+   * trade quality for time (see RegionImpl::canDegrade(); SPRegion, TMRegion
+   * and ClassifierRegion skip learning), the first of them first.
+   *
+   * Before each region computes, run() predicts the end of the iteration
+   * from the time elapsed and a moving average of the compute time of each
+   * region still to come, degraded or not.  While the prediction is over
+   * the budget, the next region of degradeOrder which is still to come
+   * computes degraded in this iteration.  The compute time of a degraded
+   * region is assumed to be zero until it was measured once.  Regions which
+   * compute in the background (RegionImpl::isAsync()) do not degrade.  The
+   * outputs which nobody reads are skipped anyway, see
+   * RegionImpl::isDemanded().
+   *
+   * Applies to the serial run(), not to the threaded, pipelined or batched
+   * run.  The setting, the averages and the counters are not serialized.
+   *
+   * @param seconds - the budget of the computes of an iteration; 0 turns
+   *   it off.
+   * @param degradeOrder - names of regions which canDegrade().
+   */
+  void setIterationBudget(Real64 seconds, const std::vector<std::string> &degradeOrder);
+  Real64 getIterationBudget() const noexcept { return iterationBudget_; }
+
+  /** How many computes of each region of the degradeOrder were degraded. */
+  const std::map<std::string, UInt64> &getDegradedComputes() const noexcept { return degradedComputes_; }
+  /** The iterations which took longer than the budget, degraded or not. */
+  UInt64 getDeadlineMisses() const noexcept { return deadlineMisses_; }
+  void resetDegradationCounts();
+
   /**
    * The type of run callback function.
    *
@@ -425,9 +868,12 @@ public:
    */
 
   /**
-   * Start profiling for all regions of this network.
+   * Start profiling for all regions, links and run callbacks of this network.
+   *
+   * @param perfCounters - also count the hardware events (cycles, instructions,
+   *        cache and branch misses) of each region's compute(), see PerfCounters.
    */
-  void enableProfiling();
+  void enableProfiling(bool perfCounters = false);
 
   /**
    * Stop profiling for all regions of this network.
@@ -438,6 +884,53 @@ public:
    * Reset profiling timers for all regions of this network.
    */
   void resetProfiling();
+
+  /**
+   * Latency histograms recorded while profiling, as a JSON string:
+   *
+   *     {"regions": {"<region>": {"compute": H, "prepareInputs": H [, "counters": C]}, ...},
+   *      "links": {"<src>.<output>--><dest>.<input>": H, ...},
+   *      "callbacks": {"<callback>": H, ...}}
+   *
+   * where each H is {"count", "mean", "min", "p50", "p90", "p99", "max"}, in
+   * seconds, see LatencyHistogram::toJSON(). C are the hardware counters of
+   * compute(), when enabled with enableProfiling(true) and available, see
+   * PerfCounters::toJSON().
+   */
+  std::string getProfile() const;
+
+  /**
+   * Runtime statistics in the Prometheus text exposition format (version 0.0.4):
+   *
+   *   htm_network_iterations_total               counter
+   *   htm_region_compute_seconds{region}         summary (p50, p90, p99), while profiling
+   *   htm_region_output_sparsity{region,output}  gauge, for SDR outputs
+   *   htm_network_deadline_misses_total          counter, with setIterationBudget()
+   *   htm_region_degraded_computes_total{region} counter, of the degradeOrder
+   *   htm_region_<name>{region}                  from RegionImpl::getMetrics(), e.g.
+   *                                              htm_region_connections_synapses
+   *
+   * Nothing is collected for this besides the profiling; everything is read
+   * from the current state when called, so an unscraped network pays nothing.
+   *
+   * @param labels - extra labels for every sample, already formatted,
+   *                 e.g. 'network="3"'. May be empty.
+   */
+  std::string getMetrics(const std::string &labels = "") const;
+
+  /**
+   * Bytes of memory by category, for sizing hosts:
+   *
+   *   <region>.<category>  of the region's algorithm, see RegionImpl::memoryUsage(),
+   *                        e.g. sp.connections.synapses
+   *   <region>.outputs     buffers of its outputs
+   *   <region>.inputs      buffers of its inputs, unless shared with an output
+   *   links                outputs in flight on delayed links
+   *
+   * A buffer shared by outputs, inputs and links is counted once. Like the
+   * metrics, everything is read from the current state when called.
+   */
+  MemoryUsage memoryUsage() const;
 	
   /**
    * Set one of the debug levels: LogLevel_None = 0, LogLevel_Minimal, LogLevel_Normal, LogLevel_Verbose
@@ -516,7 +1009,27 @@ private:
   // the network
   void resetEnabledPhases_();
   std::string phasesToString() const;
-  void phasesFromString(const std::string& phaseString);
+  void phasesFromString(const std::string& phaseString, bool skipMissing = false);
+
+  // Dependency graph of the regions of one phase (or of all regions in
+  // initialize()), see setNumThreads().
+  struct PhaseSchedule_ {
+    std::vector<Region *> regions;                // in serial order
+    std::vector<std::vector<size_t>> successors;  // indices into regions
+    std::vector<size_t> numPredecessors;
+    // SDR Outputs whose readers compute concurrently, by the region which
+    // computes them (nullptr if not in the phase), and the readers' links.
+    std::map<const Region *, std::vector<Output *>> sharedOutputs;
+    std::vector<Link *> sparseCopyLinks;
+  };
+  PhaseSchedule_ buildPhaseSchedule_(std::vector<Region *> regions) const; // in serial order
+  // All regions, each after the sources of its links without propagation delay.
+  std::vector<Region *> linkOrder_() const;
+  void runPhaseParallel_(const PhaseSchedule_ &schedule, const std::function<void(Region *)> &task);
+
+  // Pipelined run, see setPipelined(). The stages are also those of the batched run.
+  std::vector<const std::set<Region *> *> pipelineStages_(const char *mode = "Pipelined") const;
+  void runPipelineStep_(const std::vector<const std::set<Region *> *> &stages, size_t firstStage);
 
   bool initialized_;
 	
@@ -537,9 +1050,73 @@ private:
 
   // we invoke these callbacks at every iteration
   Collection<callbackItem> callbacks_;
+  void runCallbacks_();
+
+  bool profilingEnabled_ = false;
+  std::map<std::string, LatencyHistogram> callbackProfile_;
 
   // number of elapsed iterations
   UInt64 iteration_;
+
+  std::shared_ptr<ThreadPool> threadPool_; //null: serial run, see setNumThreads()
+
+  bool   pipelined_ = false;
+  bool   skipUnchanged_ = false;
+  size_t pipelineFill_ = 0u; // stages which hold a record, minus one
+
+  UInt batchSize_ = 1u; // see setBatchSize()
+
+  // see startCapture()
+  void captureIteration_(bool batched, size_t batchIndex = 0u);
+  std::shared_ptr<TrafficCapture> capture_;
+  std::vector<std::shared_ptr<Output>> captureOutputs_;
+
+  // see setIterationBudget()
+  struct ComputeCost_ {
+    Real64 full = 0.0;     // nanoseconds, moving averages
+    Real64 degraded = 0.0;
+  };
+  struct BudgetedCompute_ {
+    Region *region;
+    ComputeCost_ *cost;
+    size_t rank;           // in degradeOrder_, NOT_DEGRADABLE if not in it
+    bool degraded;         // in this iteration
+  };
+  static constexpr size_t NOT_DEGRADABLE = ~size_t(0);
+  void computeBudgeted_(std::vector<BudgetedCompute_> &schedule, size_t next, UInt64 start);
+  Real64 iterationBudget_ = 0.0;
+  std::vector<std::string> degradeOrder_;
+  std::map<std::string, ComputeCost_> computeCosts_; // by region
+  std::map<std::string, UInt64> degradedComputes_;
+  UInt64 deadlineMisses_ = 0u;
+
+  bool arenaEnabled_ = true;
+  std::shared_ptr<Arena> arena_; // see initialize()
+  std::map<int, std::shared_ptr<Arena>> nodeArenas_; // by NUMA node, see setPlacement()
+  std::shared_ptr<Arena> arenaOf_(const Placement &placement);
+
+  Placement defaultPlacement_;
+  std::map<std::string, std::shared_ptr<ThreadPool>> threadPools_; // see addThreadPool()
+
+  // see loadFromChunkedFile()
+  void loadFromChunked_(const CheckpointReader &reader, const std::vector<std::string> &regions, size_t numThreads);
+
+  // see saveCheckpoint()
+  void saveCheckpointState_(CheckpointWriter &writer,
+                            const std::function<void(const Connections &, const std::string &)> &saveConnections) const;
+  std::string checkpointBase_;
+  UInt64 checkpointBaseId_ = 0u;
+  std::map<std::string, std::shared_ptr<ConnectionsDelta>> deltas_; // per region
+
+  // see swapRegionAsync(); destroyed before the regions, after the loads.
+  struct RegionSwap_ {
+    std::string region;
+    std::future<std::unique_ptr<RegionImpl>> loaded;
+    std::promise<void> swapped;
+  };
+  std::list<RegionSwap_> swaps_;
+  std::mutex swapsMutex_;            // guards swaps_
+  std::atomic<size_t> numSwaps_{0u}; // of swaps_
 };
 
 } // namespace htm
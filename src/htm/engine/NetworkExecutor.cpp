@@ -0,0 +1,79 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the NetworkExecutor class
+ */
+
+#include <algorithm>
+#include <exception>
+
+#include <htm/engine/NetworkExecutor.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+NetworkExecutor::NetworkExecutor(size_t numThreads, size_t batchSize)
+    : batchSize_(batchSize), pool_(numThreads) {}
+
+size_t NetworkExecutor::add(std::shared_ptr<Network> network) {
+  NTA_CHECK(network != nullptr) << "NetworkExecutor: cannot add a null Network.";
+  NTA_CHECK(added_.insert(network.get()).second)
+      << "NetworkExecutor: this Network was added already.";
+  networks_.push_back(std::move(network));
+  return networks_.size() - 1u;
+}
+
+void NetworkExecutor::clear() {
+  networks_.clear();
+  added_.clear();
+}
+
+void NetworkExecutor::run(int n) {
+  const size_t count = networks_.size();
+  if (count == 0u)
+    return;
+  size_t batch = batchSize_;
+  if (batch == 0u) {
+    const size_t batches = 8u * pool_.size();
+    batch = std::max<size_t>(1u, (count + batches - 1u) / batches);
+  }
+  const size_t numBatches = (count + batch - 1u) / batch;
+
+  // One slot per Network, so the workers do not need a lock to report.
+  std::vector<std::exception_ptr> errors(count);
+  const LogLevel logLevel = NTA_LOG_LEVEL;
+
+  pool_.parallelFor(numBatches, [&](size_t b) {
+    NTA_LOG_LEVEL = logLevel; // thread_local, follow the caller.
+    const size_t end = std::min(count, (b + 1u) * batch);
+    for (size_t i = b * batch; i < end; i++) {
+      try {
+        networks_[i]->run(n);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    }
+  });
+
+  for (const auto &error : errors) {
+    if (error)
+      std::rethrow_exception(error);
+  }
+}
+
+} // namespace htm
@@ -0,0 +1,102 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Interface for the NetworkExecutor class
+ */
+
+#ifndef NTA_NETWORK_EXECUTOR_HPP
+#define NTA_NETWORK_EXECUTOR_HPP
+
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include <htm/engine/Network.hpp>
+#include <htm/types/Types.hpp>
+#include <htm/utils/ThreadPool.hpp>
+
+namespace htm {
+
+/**
+ * Runs many independent Networks on a shared pool of threads.
+ *
+ * Meant for hosting a large number of small Networks in one process (say one
+ * per metric), where each Network alone is too small to use threads well.
+ *
+ * Example:
+ *     NetworkExecutor executor(8);
+ *     for (auto &net : networks) executor.add(net);
+ *     while (...) {
+ *       // set the inputs of every network
+ *       executor.run(1);
+ *     }
+ *
+ * run() splits the Networks into batches of consecutive Networks.  Each worker
+ * claims the next unclaimed batch when it is done with its current one, so a
+ * slow Network does not hold up the others.  Handing out a batch is a single
+ * atomic increment; no lock is taken on this path.
+ *
+ * A Network must not be used by anyone else while run() is in progress, and
+ * must not be added twice.  Each worker uses the caller's log level.
+ */
+class NetworkExecutor {
+public:
+  /**
+   * @param numThreads - number of threads including the caller,
+   *   0 means std::thread::hardware_concurrency().
+   * @param batchSize - number of Networks handed to a worker at once,
+   *   0 picks about 8 batches per thread.
+   */
+  explicit NetworkExecutor(size_t numThreads = 0u, size_t batchSize = 0u);
+
+  /**
+   * Add a Network. It is initialized by the first run() if not yet.
+   * @returns the index of the Network in this executor.
+   */
+  size_t add(std::shared_ptr<Network> network);
+
+  /**
+   * Remove all Networks.
+   */
+  void clear();
+
+  size_t size() const noexcept { return networks_.size(); }
+  std::shared_ptr<Network> getNetwork(size_t index) const { return networks_.at(index); }
+  size_t getNumThreads() const noexcept { return pool_.size(); }
+
+  /**
+   * Call Network::run(n) on every Network, in parallel.
+   *
+   * Blocks until all Networks are done.  If some Networks throw, all the
+   * others still run; then the exception of the failed Network with the
+   * lowest index is rethrown.
+   *
+   * @param n - iterations for each Network.
+   */
+  void run(int n = 1);
+
+private:
+  std::vector<std::shared_ptr<Network>> networks_;
+  std::unordered_set<const Network *> added_;
+  size_t batchSize_;
+  ThreadPool pool_;
+};
+
+} // namespace htm
+
+#endif // NTA_NETWORK_EXECUTOR_HPP
@@ -26,6 +26,7 @@
 #include <htm/engine/Spec.hpp>
 #include <htm/ntypes/BasicType.hpp>
 #include <htm/engine/Region.hpp>
+#include <htm/utils/Arena.hpp>
 
 using namespace htm;
 
@@ -50,6 +51,11 @@ void Output::initialize() {
         << "Output Dimensions cannot be determined for Region "
         << region_->getName() << "; output " << name_;
 
+  // On the NUMA node of this region, see Network::setPlacement().
+  const std::shared_ptr<Arena> *current = Arena::current();
+  Arena::Scope scope(region_->arena_ != nullptr ? region_->arena_
+                                                : current != nullptr ? *current : nullptr);
+
   size_t count = dim_.getCount();
   if (data_.getType() == NTA_BasicType_SDR) {
       data_.allocateBuffer(dim_.asVector());
@@ -138,6 +144,38 @@ bool Output::hasOutgoingLinks() { return (!links_.empty()); }
 
 NTA_BasicType Output::getDataType() const { return data_.getType(); }
 
+namespace {
+  // FNV-1a
+  UInt64 hashBytes(const void *data, size_t bytes, UInt64 hash = 14695981039346656037ull) {
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < bytes; i++) {
+      hash ^= p[i];
+      hash *= 1099511628211ull;
+    }
+    return hash;
+  }
+} // namespace
+
+void Output::update() {
+  if (stale_ || !data_.has_buffer() || data_.getType() == NTA_BasicType_Str) {
+    touch(); // not filled in, or not hashed
+    return;
+  }
+  UInt64 hash;
+  if (data_.getType() == NTA_BasicType_SDR) {
+    const SDR &sdr = data_.getSDR();
+    const auto &sparse = sdr.getSparse();
+    hash = hashBytes(sparse.data(), sparse.size() * sizeof(sparse[0]), hashBytes(&sdr.size, sizeof(sdr.size)));
+  } else {
+    hash = hashBytes(data_.getBuffer(), data_.getCount() * BasicType::getSize(data_.getType()));
+  }
+  if (hashValid_ && hash == hash_)
+    return;
+  epoch_++;
+  hash_ = hash;
+  hashValid_ = true;
+}
+
 void Output::resize(size_t count) {
   NTA_CHECK(data_.getType() != NTA_BasicType_SDR) << "Cannot resize SDR buffer.";
   NTA_CHECK(data_.getType() != NTA_BasicType_Str) << "Cannot resize Str buffer.";
@@ -26,6 +26,7 @@
 #include <htm/types/Types.hpp>
 #include <htm/utils/Log.hpp> // temporary, while impl is in this file
 #include <set>
+#include <vector>
 namespace htm {
 
 class Link;
@@ -113,6 +114,49 @@ public:
    */
   bool hasOutgoingLinks();
 
+  /**
+   * @returns the number of outgoing links.
+   */
+  size_t getLinkCount() const { return links_.size(); }
+
+  /**
+   * Is the data of this output used: linked to an input, or demanded with
+   * addDemand(), eg. by a Watcher. A region may skip the outputs which are not
+   * demanded in compute() and mark them stale, Region::getOutputData() then
+   * fills them in from the state of the last compute(), see
+   * RegionImpl::computeOutput(). Output::getData() does not.
+   */
+  bool isDemanded() const { return !links_.empty() || demand_ > 0u; }
+  void addDemand() { demand_++; }
+  void removeDemand() {
+    NTA_CHECK(demand_ > 0u) << "Output " << name_ << ": removeDemand() without addDemand()";
+    demand_--;
+  }
+
+  /** Was this output skipped by the last compute()? */
+  bool isStale() const { return stale_; }
+  void setStale(bool stale) { stale_ = stale; }
+
+  /**
+   * The change epoch of the data, for skipping the regions whose inputs did
+   * not change, see Network::setSkipUnchanged().  touch() counts a write;
+   * update() counts it only if the data differs from the last update(), by a
+   * 64 bit hash of the content.
+   */
+  UInt64 getEpoch() const { return epoch_; }
+  void touch() { epoch_++; hashValid_ = false; }
+  void update();
+
+  /**
+   * Is the data that of an earlier compute(), held back until the region has
+   * a new value, eg. AggregatorRegion while a window is open?  The impl sets
+   * it in compute(), Region::compute() clears it before.  A region whose
+   * inputs all come from held outputs does not compute, and holds its own
+   * outputs in turn.
+   */
+  bool isHeld() const { return held_; }
+  void setHeld(bool held) { held_ = held; }
+
   /**
    * Get the data of the output.
    * @returns
@@ -124,11 +168,27 @@ public:
   Array &getData() { return data_; }
   const Array &getData() const { return data_;}
 
+  /**
+   * The records of a batched run, see Network::setBatchSize().
+   * Record i is the value of this output in the i-th iteration of the batch.
+   */
+  std::vector<Array> &getBatch() { return batch_; }
+  const std::vector<Array> &getBatch() const { return batch_; }
+
   /**
    *  Get the data type of the output
    */
   NTA_BasicType getDataType() const;
 
+  /**
+   * Change the data type given by the Spec, before the output buffer is
+   * allocated.  For regions which produce any type, see SharedMemoryInputRegion.
+   */
+  void setDataType(NTA_BasicType type) {
+    NTA_CHECK(!data_.has_buffer()) << "Output " << name_ << ": can't change the type once allocated";
+    data_ = Array(type);
+  }
+
 
   /**
    *
@@ -183,10 +243,17 @@ private:
   Region* region_;
   Dimensions dim_;
   Array data_;
+  std::vector<Array> batch_;
   // order of links never matters, so store as a set
   // this is different from Input, where they do matter
   std::set<std::shared_ptr<Link>> links_;
   std::string name_;
+  UInt32 demand_ = 0u;
+  bool stale_ = false;
+  UInt64 epoch_ = 0u;
+  UInt64 hash_ = 0u;       // of the data at epoch_, if hashValid_
+  bool hashValid_ = false;
+  bool held_ = false;
 };
 
 
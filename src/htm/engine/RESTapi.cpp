@@ -22,18 +22,46 @@ Implementation of the RESTapi class
 */
 #include <htm/engine/RESTapi.hpp>
 #include <htm/engine/Network.hpp>
+#include <htm/engine/Output.hpp>
+#include <htm/engine/Region.hpp>
 #include <htm/engine/Spec.hpp>
+#include <htm/os/Directory.hpp>
+#include <htm/os/Path.hpp>
+
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <sstream>
 
 const size_t ID_MAX = 9999; // maximum number of generated ids  (this is arbitrary)
+static const std::string STORE_EXTENSION = ".htmnet"; // files of open_store()
+static const std::string HIBERNATED_EXTENSION = ".hibernated"; // files of set_hibernation()
 
 using namespace htm;
 
 // Global values (singletons)
 static RESTapi rest;
-static unsigned int next_id = 1;
 
 RESTapi::RESTapi() {}
-RESTapi::~RESTapi() { }
+RESTapi::~RESTapi() {
+  {
+    std::lock_guard<std::mutex> lock(hibernationMutex_);
+    hibernateAfter_ = 0u;
+  }
+  hibernationWake_.notify_all();
+  if (hibernationThread_.joinable())
+    hibernationThread_.join();
+}
+
+RESTapi::ResourceContext::~ResourceContext() {
+  try {
+    if (!hibernated.empty() && Path::exists(hibernated))
+      Path::remove(hibernated);
+  } catch (...) {
+    // a stale checkpoint is not worth terminating for
+  }
+}
 
 RESTapi* RESTapi::getInstance() { return &rest; }
 
@@ -43,19 +71,19 @@ std::string RESTapi::get_new_id_() {
   //       starting with "1" and incrementing on each use with wrap at "9999".
   //       This will never return "0"
 
-  std::map<std::string, ResourceContext>::iterator itr;
   std::string id;
-  while (rest.resource_.size() < ID_MAX) {  // limit the total number of generated resources
-    unsigned int id_nbr = next_id++;
-    if (id_nbr > ID_MAX)
-      id_nbr = 1; // allow integer wrap of the id without using a "0" value.
+  while (resource_.size() < ID_MAX) {  // limit the total number of generated resources
+    unsigned int id_nbr = next_id_++;
+    if (id_nbr > ID_MAX) {
+      id_nbr = 1u; // allow integer wrap of the id without using a "0" value.
+      next_id_ = 2u;
+    }
     char buf[10];
     std::snprintf(buf, sizeof(buf), "%d", id_nbr);
     id = buf;
 
     // Make sure this new session id is not in use.
-    itr = resource_.find(id);
-    if (itr == resource_.end()) {
+    if (resource_.find(id) == resource_.end()) {
       // This is one we can use
       break;
     }
@@ -63,19 +91,300 @@ std::string RESTapi::get_new_id_() {
   return id;
 }
 
+// When the request of the thread found its Network, for the latencies of touch_().
+static thread_local UInt64 requestStart = 0u;
+
+std::shared_ptr<RESTapi::ResourceContext> RESTapi::find_(const std::string &id) const {
+  requestStart = LatencyHistogram::now();
+  std::shared_lock<std::shared_mutex> lock(resourceMutex_);
+  auto itr = resource_.find(id);
+  NTA_CHECK(itr != resource_.end()) << "Context for resource '" + id + "' not found.";
+  return itr->second;
+}
+
+void RESTapi::touch_(ResourceContext &ctx) {
+  NTA_CHECK(!ctx.deleted) << "Context for resource '" + ctx.id + "' not found.";
+  const bool hit = static_cast<bool>(ctx.net);
+  if (!hit) {
+    auto net = std::make_shared<Network>();
+    if (!ctx.hibernated.empty()) {
+      net->loadFromChunkedFile(ctx.hibernated);
+      Path::remove(ctx.hibernated);
+      ctx.hibernated.clear();
+      ctx.asleep = false;
+    } else {
+      // registered by open_store(), loaded on first use
+      net->loadFromFile(ctx.file);
+    }
+    ctx.net = net;
+  }
+  ctx.t = time(0);
+  const UInt64 latency = LatencyHistogram::now() - requestStart;
+  std::lock_guard<std::mutex> lock(statsMutex_);
+  (hit ? hitLatency_ : missLatency_).record(latency);
+}
+
+namespace {
+// File names of the store: ids with every character which is not safe in a
+// file name %-escaped, as in URLs.
+std::string escapeId(const std::string &id) {
+  static const char *hex = "0123456789ABCDEF";
+  std::string name;
+  for (size_t i = 0; i < id.size(); i++) {
+    const unsigned char c = static_cast<unsigned char>(id[i]);
+    if (std::isalnum(c) || c == '-' || c == '_' || c == '~' || (c == '.' && i > 0)) {
+      name += static_cast<char>(c);
+    } else {
+      name += '%';
+      name += hex[c >> 4];
+      name += hex[c & 0xF];
+    }
+  }
+  return name;
+}
+
+std::string unescapeId(const std::string &name) {
+  std::string id;
+  for (size_t i = 0; i < name.size(); i++) {
+    if (name[i] == '%' && i + 2 < name.size()) {
+      id += static_cast<char>(std::stoi(name.substr(i + 1, 2), nullptr, 16));
+      i += 2;
+    } else {
+      id += name[i];
+    }
+  }
+  return id;
+}
+} // namespace
+
+std::string RESTapi::store_file_(const std::string &id) const {
+  NTA_CHECK(!store_.empty()) << "No store for saving networks, see RESTapi::open_store().";
+  return Path::join(store_, escapeId(id) + STORE_EXTENSION);
+}
+
+size_t RESTapi::open_store(const std::string &directory) {
+  if (!Directory::exists(directory))
+    Directory::create(directory, false, true);
+
+  std::unique_lock<std::shared_mutex> lock(resourceMutex_);
+  store_ = directory;
+  size_t found = 0u;
+  Iterator dir(directory);
+  Entry e;
+  while (dir.next(e)) {
+    const std::string &name = e.filename;
+    if (e.type != Entry::FILE || name.size() <= STORE_EXTENSION.size() ||
+        name.compare(name.size() - STORE_EXTENSION.size(), STORE_EXTENSION.size(), STORE_EXTENSION) != 0)
+      continue;
+    const std::string id = unescapeId(name.substr(0u, name.size() - STORE_EXTENSION.size()));
+    if (resource_.find(id) != resource_.end())
+      continue; // the one in memory is newer
+    auto obj = std::make_shared<ResourceContext>();
+    obj->id = id;
+    obj->t = time(0);
+    obj->file = e.path;
+    resource_[id] = obj;
+    found++;
+  }
+  return found;
+}
+
+std::string RESTapi::save_request(const std::string &id, bool wait) {
+  try {
+    auto ctx = find_(id);
+    std::lock_guard<FifoMutex> guard(ctx->mutex);
+    touch_(*ctx);
+    if (ctx->file.empty()) {
+      std::shared_lock<std::shared_mutex> lock(resourceMutex_);
+      ctx->file = store_file_(id);
+    }
+
+    if (ctx->saving.valid())
+      ctx->saving.get(); // the previous save, rethrows its failure
+    ctx->net->initialize(); // the buffers of a Network which never ran, as run() does
+    ctx->saving = ctx->net->saveAsync(ctx->file);
+    if (wait)
+      ctx->saving.get();
+
+    return "{\"result\": \"OK\"}";
+  } catch (Exception &e) {
+    return "{\"err\": " + Value::json_string(e.getMessage()) + "}";
+  } catch (std::exception& e) {
+    return "{\"err\": " + Value::json_string(e.what()) + "}";
+  } catch (...) {
+    return "{\"err\": " + Value::json_string("Unknown Exception.") + "}";
+  }
+}
+
+std::string RESTapi::load_request(const std::string &id) {
+  try {
+    auto ctx = find_(id);
+    std::lock_guard<FifoMutex> guard(ctx->mutex);
+    NTA_CHECK(!ctx->deleted) << "Context for resource '" + id + "' not found.";
+    if (ctx->file.empty()) {
+      std::shared_lock<std::shared_mutex> lock(resourceMutex_);
+      ctx->file = store_file_(id);
+    }
+    if (ctx->saving.valid())
+      ctx->saving.wait();
+    NTA_CHECK(Path::exists(ctx->file)) << "Network '" << id << "' was not saved.";
+    ctx->net.reset();
+    if (!ctx->hibernated.empty()) {  // replaced by the saved one
+      Path::remove(ctx->hibernated);
+      ctx->hibernated.clear();
+      ctx->asleep = false;
+    }
+    touch_(*ctx);
+
+    return "{\"result\": \"OK\"}";
+  } catch (Exception &e) {
+    return "{\"err\": " + Value::json_string(e.getMessage()) + "}";
+  } catch (std::exception& e) {
+    return "{\"err\": " + Value::json_string(e.what()) + "}";
+  } catch (...) {
+    return "{\"err\": " + Value::json_string("Unknown Exception.") + "}";
+  }
+}
+
+void RESTapi::set_hibernation(unsigned int idle_seconds, const std::string &directory, bool compress) {
+  if (idle_seconds > 0u && !Directory::exists(directory))
+    Directory::create(directory, false, true);
+
+  std::thread stopped;
+  {
+    std::lock_guard<std::mutex> lock(hibernationMutex_);
+    hibernateAfter_ = idle_seconds;
+    hibernationDir_ = directory;
+    hibernationCompress_ = compress;
+    if (idle_seconds > 0u && !hibernationThread_.joinable())
+      hibernationThread_ = std::thread([this]() { hibernation_loop_(); });
+    else if (idle_seconds == 0u)
+      stopped = std::move(hibernationThread_);
+  }
+  hibernationWake_.notify_all();
+  if (stopped.joinable())
+    stopped.join();
+}
+
+void RESTapi::hibernation_loop_() {
+  std::unique_lock<std::mutex> lock(hibernationMutex_);
+  while (hibernateAfter_ > 0u) {
+    // often enough for any idle time, a sweep which finds nothing is cheap
+    hibernationWake_.wait_for(lock, std::chrono::seconds(1));
+    const unsigned int idle = hibernateAfter_;
+    if (idle == 0u)
+      break;
+    lock.unlock();
+    try {
+      hibernate_idle(idle);
+    } catch (Exception &e) {
+      NTA_WARN << "Hibernation: " << e.getMessage();
+    } catch (std::exception &e) {
+      NTA_WARN << "Hibernation: " << e.what();
+    }
+    lock.lock();
+  }
+}
+
+size_t RESTapi::hibernate_idle(unsigned int idle_seconds) {
+  std::vector<std::shared_ptr<ResourceContext>> contexts;
+  {
+    std::shared_lock<std::shared_mutex> lock(resourceMutex_);
+    contexts.reserve(resource_.size());
+    for (const auto &r : resource_)
+      contexts.push_back(r.second);
+  }
+  const time_t now = time(0);
+  size_t count = 0u;
+  for (const auto &ctx : contexts) {
+    if (!ctx->mutex.try_lock())
+      continue;  // in use, so not idle
+    std::lock_guard<FifoMutex> guard(ctx->mutex, std::adopt_lock);
+    if (hibernate_(*ctx, idle_seconds, now))
+      count++;
+  }
+  return count;
+}
+
+bool RESTapi::hibernate_(ResourceContext &ctx, unsigned int idle_seconds, time_t now) {
+  if (ctx.deleted || !ctx.net || difftime(now, ctx.t) < static_cast<double>(idle_seconds))
+    return false;
+  if (ctx.saving.valid() && ctx.saving.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    return false;
+  for (const auto &swap : ctx.swaps)
+    if (swap.second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+      return false;
+
+  std::string directory;
+  bool compress;
+  {
+    std::lock_guard<std::mutex> lock(hibernationMutex_);
+    directory = hibernationDir_;
+    compress = hibernationCompress_;
+  }
+  NTA_CHECK(!directory.empty()) << "No directory for hibernation, see RESTapi::set_hibernation().";
+  // numbered, as a replaced Network of the same id may still be hibernated
+  const std::string path = Path::join(directory, escapeId(ctx.id) + "." +
+                                      std::to_string(hibernations_++) + HIBERNATED_EXTENSION);
+  const UInt64 t0 = LatencyHistogram::now();
+  try {
+    ctx.net->applyRegionSwaps();  // loaded ones, or the checkpoint would lose them
+    ctx.net->initialize();        // the buffers of a Network which never ran, as run() does
+    ctx.net->saveToChunkedFile(path, 1u, compress);
+  } catch (...) {
+    if (Path::exists(path))
+      Path::remove(path);
+    throw;
+  }
+  ctx.net.reset();
+  ctx.hibernated = path;
+  ctx.asleep = true;
+  std::lock_guard<std::mutex> lock(statsMutex_);
+  hibernateLatency_.record(LatencyHistogram::now() - t0);
+  return true;
+}
+
+std::string RESTapi::hibernation_request() {
+  try {
+    size_t networks = 0u, hibernated = 0u;
+    {
+      std::shared_lock<std::shared_mutex> lock(resourceMutex_);
+      networks = resource_.size();
+      for (const auto &r : resource_)
+        if (r.second->asleep)
+          hibernated++;
+    }
+    std::stringstream ss;
+    ss << "{\"result\": {\"networks\": " << networks << ", \"hibernated\": " << hibernated;
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    ss << ", \"hibernations\": " << hibernateLatency_.getCount() << ", \"hits\": " << hitLatency_.toJSON()
+       << ", \"misses\": " << missLatency_.toJSON() << ", \"hibernate\": " << hibernateLatency_.toJSON() << "}}";
+    return ss.str();
+  } catch (Exception &e) {
+    return "{\"err\": " + Value::json_string(e.getMessage()) + "}";
+  } catch (std::exception& e) {
+    return "{\"err\": " + Value::json_string(e.what()) + "}";
+  } catch (...) {
+    return "{\"err\": " + Value::json_string("Unknown Exception.") + "}";
+  }
+}
+
 
 
 std::string RESTapi::create_network_request(const std::string &specified_id, const std::string &config) {
   try {
+    auto obj = std::make_shared<ResourceContext>();
+    obj->t = time(0);
+    obj->net.reset(new htm::Network);  // Allocate a Network object.
+
+    obj->net->configure(config);       // without holding the lock of the map
+
     std::string id = specified_id;
+    std::unique_lock<std::shared_mutex> lock(resourceMutex_);
     if (id.empty()) id = get_new_id_();
-    ResourceContext obj;
-    obj.id = id;
-    obj.t = time(0);
-    obj.net.reset(new htm::Network);  // Allocate a Network object.
-
-    obj.net->configure(config);
-    resource_[id] = obj;              // assign the resource (deleting any previous value)
+    obj->id = id;
+    // assign the resource; requests still queued on a replaced one finish with it.
+    resource_[id] = obj;
 
     return "{\"result\": " + Value::json_string(id) + "}";
   } catch (Exception& e) {
@@ -91,14 +400,14 @@ std::string RESTapi::put_input_request(const std::string &id,
                                        const std::string &input_name,
                                        const std::string &data) {
   try {
-    auto itr = resource_.find(id);
-    NTA_CHECK(itr != resource_.end()) << "Context for resource '" + id + "' not found.";
-    itr->second.t = time(0);
+    auto ctx = find_(id);
+    std::lock_guard<FifoMutex> guard(ctx->mutex);
+    touch_(*ctx);
 
     Value vm;
     vm.parse(data);
 
-    itr->second.net->setInputData(input_name, vm);
+    ctx->net->setInputData(input_name, vm);
 
     return "{\"result\": \"OK\"}";
   }
@@ -115,16 +424,17 @@ std::string RESTapi::get_input_request(const std::string &id,
                                        const std::string &region_name,
                                        const std::string &input_name) {
   try {
-    auto itr = resource_.find(id);
-    NTA_CHECK(itr != resource_.end()) << "Context for resource '" + id + "' not found.";
-    itr->second.t = time(0);
-    auto region = itr->second.net->getRegion(region_name);
+    auto ctx = find_(id);
+    std::lock_guard<FifoMutex> guard(ctx->mutex);
+    touch_(*ctx);
+    auto region = ctx->net->getRegion(region_name);
     const Array &b = region->getInputData(input_name);
-    std::string data = b.toJSON();
-    std::string type = BasicType::getName(b.getType());
-    std::string dim = region->getInputDimensions(input_name).toString(false);
-
-    return "{\"result\": " + data + ", \"type\": \"" + type + "\", \"dim\": " + dim +"}";
+    std::string result = "{\"result\": ";
+    result.reserve(64u + b.getCount() * 4u);
+    b.appendJSON(result);
+    result += ", \"type\": \"" + std::string(BasicType::getName(b.getType())) + "\", \"dim\": " +
+              region->getInputDimensions(input_name).toString(false) + "}";
+    return result;
 
   } catch (Exception &e) {
     return "{\"err\": " + Value::json_string(e.getMessage()) + "}";
@@ -139,16 +449,17 @@ std::string RESTapi::get_output_request(const std::string &id,
                                         const std::string &region_name,
                                         const std::string &output_name) {
   try {
-    auto itr = resource_.find(id);
-    NTA_CHECK(itr != resource_.end()) << "Context for resource '" + id + "' not found.";
-    itr->second.t = time(0);
-    auto region = itr->second.net->getRegion(region_name);
+    auto ctx = find_(id);
+    std::lock_guard<FifoMutex> guard(ctx->mutex);
+    touch_(*ctx);
+    auto region = ctx->net->getRegion(region_name);
     const Array &b = region->getOutputData(output_name);
-    std::string data = b.toJSON();
-    std::string type = BasicType::getName(b.getType());
-    std::string dim = region->getOutputDimensions(output_name).toString(false);
-
-    return "{\"result\": " + data + ", \"type\": \"" + type + "\", \"dim\": " + dim +"}";
+    std::string result = "{\"result\": ";
+    result.reserve(64u + b.getCount() * 4u);
+    b.appendJSON(result);
+    result += ", \"type\": \"" + std::string(BasicType::getName(b.getType())) + "\", \"dim\": " +
+              region->getOutputDimensions(output_name).toString(false) + "}";
+    return result;
   } catch (Exception &e) {
     return "{\"err\": " + Value::json_string(e.getMessage()) + "}";
   } catch (std::exception& e) {
@@ -163,11 +474,11 @@ std::string RESTapi::put_param_request(const std::string &id,
                                        const std::string &param_name,
                                        const std::string &data) {
   try {
-    auto itr = resource_.find(id);
-    NTA_CHECK(itr != resource_.end()) << "Context for resource '" + id + "' not found.";
-    itr->second.t = time(0);
+    auto ctx = find_(id);
+    std::lock_guard<FifoMutex> guard(ctx->mutex);
+    touch_(*ctx);
 
-    itr->second.net->getRegion(region_name)->setParameterJSON(param_name, data);
+    ctx->net->getRegion(region_name)->setParameterJSON(param_name, data);
 
     return "{\"result\": \"OK\"}";
   } catch (Exception &e) {
@@ -183,12 +494,12 @@ std::string RESTapi::get_param_request(const std::string &id,
                                        const std::string &region_name,
                                        const std::string &param_name) {
   try {
-    auto itr = resource_.find(id);
-    NTA_CHECK(itr != resource_.end()) << "Context for resource '" + id + "' not found.";
-    itr->second.t = time(0);
+    auto ctx = find_(id);
+    std::lock_guard<FifoMutex> guard(ctx->mutex);
+    touch_(*ctx);
 
     std::string response;
-    response = "{\"result\": " + itr->second.net->getRegion(region_name)->getParameterJSON(param_name) + "}";
+    response = "{\"result\": " + ctx->net->getRegion(region_name)->getParameterJSON(param_name) + "}";
 
     return response;
   } catch (Exception &e) {
@@ -202,11 +513,11 @@ std::string RESTapi::get_param_request(const std::string &id,
 
 std::string RESTapi::delete_region_request(const std::string &id, const std::string &region_name) {
   try {
-    auto itr = resource_.find(id);
-    NTA_CHECK(itr != resource_.end()) << "Context for resource '" + id + "' not found.";
-    itr->second.t = time(0);
+    auto ctx = find_(id);
+    std::lock_guard<FifoMutex> guard(ctx->mutex);
+    touch_(*ctx);
 
-    itr->second.net->removeRegion(region_name);
+    ctx->net->removeRegion(region_name);
 
     return "{\"result\": \"OK\"}";
   } catch (Exception &e) {
@@ -222,9 +533,9 @@ std::string RESTapi::delete_link_request(const std::string &id,
                                          const std::string &source_name,
                                          const std::string &dest_name) {
   try {
-    auto itr = resource_.find(id);
-    NTA_CHECK(itr != resource_.end()) << "Context for resource '" + id + "' not found.";
-    itr->second.t = time(0);
+    auto ctx = find_(id);
+    std::lock_guard<FifoMutex> guard(ctx->mutex);
+    touch_(*ctx);
 
     std::vector<std::string> args;
     args = Path::split(source_name, '.');
@@ -237,7 +548,7 @@ std::string RESTapi::delete_link_request(const std::string &id,
     std::string dest_region = args[0];
     std::string dest_input = args[1];
 
-    itr->second.net->removeLink(source_region, dest_region, source_output, dest_input);
+    ctx->net->removeLink(source_region, dest_region, source_output, dest_input);
 
     return "{\"result\": \"OK\"}";
   } catch (Exception &e) {
@@ -252,10 +563,21 @@ std::string RESTapi::delete_link_request(const std::string &id,
 std::string RESTapi::delete_network_request(const std::string &id) {
   try {
 
-    auto itr = resource_.find(id);
-    NTA_CHECK(itr != resource_.end()) << "Context for resource '" + id + "' not found.";
-
-    resource_.erase(itr);
+    auto ctx = find_(id);
+    std::lock_guard<FifoMutex> guard(ctx->mutex);
+    NTA_CHECK(!ctx->deleted) << "Context for resource '" + id + "' not found.";
+    ctx->deleted = true;  // for the requests queued behind this one, a hibernated net is not restored
+    if (ctx->saving.valid())
+      ctx->saving.wait();
+    if (!ctx->file.empty() && Path::exists(ctx->file))
+      Path::remove(ctx->file);  // or it would be loaded again after a restart
+    {
+      std::unique_lock<std::shared_mutex> lock(resourceMutex_);
+      auto itr = resource_.find(id);
+      if (itr != resource_.end() && itr->second == ctx)
+        resource_.erase(itr);
+    }
+    ctx->net.reset();
 
     return "{\"result\": \"OK\"}";
   } catch (Exception &e) {
@@ -270,15 +592,15 @@ std::string RESTapi::delete_network_request(const std::string &id) {
 
 std::string RESTapi::run_request(const std::string &id, const std::string &iterations) {
   try {
-    auto itr = resource_.find(id);
-    NTA_CHECK(itr != resource_.end()) << "Context for resource '" + id + "' not found.";
-    itr->second.t = time(0);
+    auto ctx = find_(id);
+    std::lock_guard<FifoMutex> guard(ctx->mutex);
+    touch_(*ctx);
 
     int iter = 1;
     if (!iterations.empty()) {
       iter = std::strtol(iterations.c_str(), nullptr, 10);
     }
-    itr->second.net->run(iter);
+    ctx->net->run(iter);
     return "{\"result\": \"OK\"}";
   }
   catch (Exception &e) {
@@ -294,14 +616,14 @@ std::string RESTapi::command_request(const std::string& id,
                                      const std::string& region_name,
                                      const std::string& command) {
   try {
-    auto itr = resource_.find(id);
-    NTA_CHECK(itr != resource_.end()) << "Context for resource '" + id + "' not found.";
-    itr->second.t = time(0);
+    auto ctx = find_(id);
+    std::lock_guard<FifoMutex> guard(ctx->mutex);
+    touch_(*ctx);
 
     std::string response;
     std::vector<std::string> args;
     args = Path::split(command, ' ');
-    response = itr->second.net->getRegion(region_name)->executeCommand(args);
+    response = ctx->net->getRegion(region_name)->executeCommand(args);
 
     return "{\"result\": " + response + "}";
   } catch (Exception &e) {
@@ -312,3 +634,316 @@ std::string RESTapi::command_request(const std::string& id,
     return "{\"err\": " + Value::json_string("Unknown Exception.") + "}";
   }
 }
+
+std::string RESTapi::swap_request(const std::string &id,
+                                  const std::string &region_name,
+                                  const std::string &file) {
+  try {
+    auto ctx = find_(id);
+    std::lock_guard<FifoMutex> guard(ctx->mutex);
+    touch_(*ctx);
+
+    if (!file.empty()) {
+      ctx->net->initialize(); // the buffers of a Network which never ran, as run() does
+      ctx->swaps[region_name] = ctx->net->swapRegionAsync(region_name, file);
+      return "{\"result\": \"OK\"}";
+    }
+    const auto swap = ctx->swaps.find(region_name);
+    NTA_CHECK(swap != ctx->swaps.end()) << "No swap of region '" << region_name << "'.";
+    if (swap->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+      return "{\"result\": \"pending\"}";
+    swap->second.get(); // rethrows a failed load
+    return "{\"result\": \"swapped\"}";
+  } catch (Exception &e) {
+    return "{\"err\": " + Value::json_string(e.getMessage()) + "}";
+  } catch (std::exception& e) {
+    return "{\"err\": " + Value::json_string(e.what()) + "}";
+  } catch (...) {
+    return "{\"err\": " + Value::json_string("Unknown Exception.") + "}";
+  }
+}
+
+std::string RESTapi::metrics_request(const std::string &id) {
+  try {
+    auto ctx = find_(id);
+    std::lock_guard<FifoMutex> guard(ctx->mutex);
+    touch_(*ctx);
+
+    return ctx->net->getMetrics("network=" + Value::json_string(id));
+  } catch (Exception &e) {
+    return "{\"err\": " + Value::json_string(e.getMessage()) + "}";
+  } catch (std::exception& e) {
+    return "{\"err\": " + Value::json_string(e.what()) + "}";
+  } catch (...) {
+    return "{\"err\": " + Value::json_string("Unknown Exception.") + "}";
+  }
+}
+
+std::string RESTapi::memory_request(const std::string &id) {
+  try {
+    auto ctx = find_(id);
+    std::lock_guard<FifoMutex> guard(ctx->mutex);
+    touch_(*ctx);
+
+    const MemoryUsage usage = ctx->net->memoryUsage();
+    std::stringstream ss;
+    ss << "{\"result\": {";
+    for (const auto &category : usage)
+      ss << Value::json_string(category.first) << ": " << category.second << ", ";
+    ss << "\"total\": " << memory::total(usage) << "}}";
+    return ss.str();
+  } catch (Exception &e) {
+    return "{\"err\": " + Value::json_string(e.getMessage()) + "}";
+  } catch (std::exception& e) {
+    return "{\"err\": " + Value::json_string(e.what()) + "}";
+  } catch (...) {
+    return "{\"err\": " + Value::json_string("Unknown Exception.") + "}";
+  }
+}
+
+std::string RESTapi::profile_request(const std::string &id, const std::string &action) {
+  try {
+    auto ctx = find_(id);
+    std::lock_guard<FifoMutex> guard(ctx->mutex);
+    touch_(*ctx);
+
+    Network &net = *ctx->net;
+    if (action.empty() || action == "get")
+      return "{\"result\": " + net.getProfile() + "}";
+    if (action == "enable")
+      net.enableProfiling();
+    else if (action == "disable")
+      net.disableProfiling();
+    else if (action == "reset")
+      net.resetProfiling();
+    else
+      NTA_THROW << "Unknown profile action '" << action << "', expected enable, disable, reset or get.";
+    return "{\"result\": \"OK\"}";
+  } catch (Exception &e) {
+    return "{\"err\": " + Value::json_string(e.getMessage()) + "}";
+  } catch (std::exception& e) {
+    return "{\"err\": " + Value::json_string(e.what()) + "}";
+  } catch (...) {
+    return "{\"err\": " + Value::json_string("Unknown Exception.") + "}";
+  }
+}
+
+const std::string RESTapi::BINARY_CONTENT_TYPE = "application/x-htm-array";
+
+namespace {
+// Header of a binary frame, see BINARY PROTOCOL in RESTapi.hpp
+struct BinaryHeader {
+  uint32_t type;
+  uint32_t encoding;
+  uint64_t count;
+  uint64_t bytes;
+};
+static_assert(sizeof(BinaryHeader) == 24u, "binary frame header must be packed");
+
+enum BinaryEncoding : uint32_t { BINARY_RAW = 0u, BINARY_SPARSE = 1u };
+
+// Copies a decoded frame into the buffer behind the "INPUT" link, keeping
+// the type and dimensions of that buffer.
+void setInputFrame(Network &net, const std::string &input_name, const Array &frame) {
+  std::shared_ptr<Output> out = net.getRegion("INPUT")->getOutput(input_name);
+  Array &a = out->getData();
+  NTA_CHECK(a.getCount() == frame.getCount())
+      << "Input '" << input_name << "' has " << a.getCount() << " elements, the frame has "
+      << frame.getCount() << ".";
+  if (a.getType() == NTA_BasicType_SDR && frame.getType() == NTA_BasicType_SDR) {
+    SDR_sparse_t sparse = frame.getSDR().getSparse();
+    a.getSDR().setSparse(sparse);
+  } else if (a.getType() == frame.getType()) {
+    std::memcpy(a.getBuffer(), frame.getBuffer(), frame.getCount() * BasicType::getSize(frame.getType()));
+  } else {
+    frame.convertInto(a);
+  }
+  out->update(); // see Network::setSkipUnchanged()
+}
+} // namespace
+
+void RESTapi::encode_binary(const Array &a, std::string &frames) {
+  NTA_CHECK(a.getType() != NTA_BasicType_Str && a.getType() != NTA_BasicType_Handle)
+      << "Binary frame: " << BasicType::getName(a.getType()) << " arrays are not plain data.";
+  std::vector<uint8_t> indices;
+  BinaryHeader header{static_cast<uint32_t>(a.getType()), BINARY_RAW, a.getCount(), 0u};
+  const char *payload;
+  if (a.getType() == NTA_BasicType_SDR) {
+    indices = SDR::encodeSparse(a.getSDR().getSparse());
+    header.encoding = BINARY_SPARSE;
+    header.bytes = indices.size();
+    payload = reinterpret_cast<const char *>(indices.data());
+  } else {
+    header.bytes = a.getCount() * BasicType::getSize(a.getType());
+    payload = static_cast<const char *>(a.getBuffer());
+  }
+  frames.append(reinterpret_cast<const char *>(&header), sizeof(header));
+  frames.append(payload, header.bytes);
+}
+
+Array RESTapi::decode_binary(const std::string &data, size_t &pos) {
+  BinaryHeader header;
+  NTA_CHECK(pos + sizeof(header) <= data.size()) << "Binary frame: truncated header.";
+  std::memcpy(&header, data.data() + pos, sizeof(header));
+  pos += sizeof(header);
+  NTA_CHECK(header.bytes <= data.size() - pos) << "Binary frame: truncated payload.";
+  const NTA_BasicType type = static_cast<NTA_BasicType>(header.type);
+  NTA_CHECK(BasicType::isValid(type)) << "Binary frame: invalid type " << header.type << ".";
+  NTA_CHECK(type != NTA_BasicType_Str && type != NTA_BasicType_Handle)
+      << "Binary frame: " << BasicType::getName(type) << " arrays are not plain data.";
+  NTA_CHECK(header.count <= std::numeric_limits<UInt>::max())
+      << "Binary frame: " << header.count << " elements are too many.";
+  const char *payload = data.data() + pos;
+  pos += header.bytes;
+
+  if (header.encoding == BINARY_SPARSE) {
+    NTA_CHECK(type == NTA_BasicType_SDR) << "Binary frame: sparse encoding requires type SDR.";
+    SDR sdr({static_cast<UInt>(header.count)});
+    SDR_sparse_t sparse = SDR::decodeSparse(std::vector<uint8_t>(payload, payload + header.bytes));
+    NTA_CHECK(sparse.empty() || sparse.back() < sdr.size) << "Binary frame: sparse index out of range.";
+    sdr.setSparse(sparse);
+    return Array(sdr);
+  }
+  NTA_CHECK(header.encoding == BINARY_RAW) << "Binary frame: unknown encoding " << header.encoding << ".";
+  // count is bounded first, the product can not overflow
+  const size_t size = BasicType::getSize(type);
+  NTA_CHECK(header.count <= header.bytes / size && header.bytes == header.count * size)
+      << "Binary frame: " << header.bytes << " bytes do not hold " << header.count << " elements of "
+      << BasicType::getName(type) << ".";
+  return Array(type, payload, header.count);
+}
+
+std::string RESTapi::put_input_binary_request(const std::string &id,
+                                              const std::string &input_name,
+                                              const std::string &data) {
+  try {
+    auto ctx = find_(id);
+    std::lock_guard<FifoMutex> guard(ctx->mutex);
+    touch_(*ctx);
+
+    size_t pos = 0u;
+    const Array frame = decode_binary(data, pos);
+    NTA_CHECK(pos == data.size()) << "Expected exactly one binary frame.";
+    setInputFrame(*ctx->net, input_name, frame);
+
+    return "{\"result\": \"OK\"}";
+  } catch (Exception &e) {
+    return "{\"err\": " + Value::json_string(e.getMessage()) + "}";
+  } catch (std::exception& e) {
+    return "{\"err\": " + Value::json_string(e.what()) + "}";
+  } catch (...) {
+    return "{\"err\": " + Value::json_string("Unknown Exception.") + "}";
+  }
+}
+
+std::string RESTapi::get_output_binary_request(const std::string &id,
+                                               const std::string &region_name,
+                                               const std::string &output_name) {
+  try {
+    auto ctx = find_(id);
+    std::lock_guard<FifoMutex> guard(ctx->mutex);
+    touch_(*ctx);
+
+    std::string frame;
+    encode_binary(ctx->net->getRegion(region_name)->getOutputData(output_name), frame);
+    return frame;
+  } catch (Exception &e) {
+    return "{\"err\": " + Value::json_string(e.getMessage()) + "}";
+  } catch (std::exception& e) {
+    return "{\"err\": " + Value::json_string(e.what()) + "}";
+  } catch (...) {
+    return "{\"err\": " + Value::json_string("Unknown Exception.") + "}";
+  }
+}
+
+std::string RESTapi::stream_request(const std::string &id,
+                                    const std::string &input_name,
+                                    const std::string &region_name,
+                                    const std::string &output_name,
+                                    const std::string &data) {
+  try {
+    auto ctx = find_(id);
+    std::lock_guard<FifoMutex> guard(ctx->mutex);
+    touch_(*ctx);
+
+    Network &net = *ctx->net;
+    auto region = net.getRegion(region_name);
+    std::string frames;
+    for (size_t pos = 0u; pos < data.size();) {
+      setInputFrame(net, input_name, decode_binary(data, pos));
+      net.run(1);
+      encode_binary(region->getOutputData(output_name), frames);
+    }
+    return frames;
+  } catch (Exception &e) {
+    return "{\"err\": " + Value::json_string(e.getMessage()) + "}";
+  } catch (std::exception& e) {
+    return "{\"err\": " + Value::json_string(e.what()) + "}";
+  } catch (...) {
+    return "{\"err\": " + Value::json_string("Unknown Exception.") + "}";
+  }
+}
+
+std::string RESTapi::step_request(const std::string &id, const std::string &data) {
+  try {
+    Value vm;
+    vm.parse(data);
+    NTA_CHECK(vm.contains("inputs") || vm.contains("records"))
+        << "Unexpected step format. Expecting something like {inputs: {<name>: {data: [1,0,1]}}, outputs: [\"<region>.<output>\"]}";
+    const int iterations = vm.contains("iterations") ? vm["iterations"].as<int>() : 1;
+
+    std::vector<std::pair<std::string, std::string>> outputs;
+    if (vm.contains("outputs")) {
+      const Value &names = vm["outputs"];
+      NTA_CHECK(names.isSequence()) << "Expected a sequence of \"<region>.<output>\" for outputs.";
+      for (size_t i = 0; i < names.size(); i++) {
+        std::vector<std::string> args = Path::split(names[i].str(), '.');
+        NTA_CHECK(args.size() == 2) << "Expected syntax <region>.<output> for outputs. Found " << names[i].str();
+        outputs.emplace_back(args[0], args[1]);
+      }
+    }
+
+    auto ctx = find_(id);
+    std::lock_guard<FifoMutex> guard(ctx->mutex);
+    touch_(*ctx);
+    Network &net = *ctx->net;
+
+    const auto step = [&](const Value &inputs) {
+      NTA_CHECK(inputs.isMap()) << "Expected a map of <input name>: {data: [...]} for inputs.";
+      for (auto itr = inputs.begin(); itr != inputs.end(); itr++)
+        net.setInputData(itr->first, itr->second);
+      net.run(iterations);
+      std::string result = "{";
+      for (size_t i = 0; i < outputs.size(); i++) {
+        auto region = net.getRegion(outputs[i].first);
+        const Array &b = region->getOutputData(outputs[i].second);
+        if (i > 0)
+          result += ", ";
+        result += Value::json_string(outputs[i].first + "." + outputs[i].second) + ": {\"data\": ";
+        b.appendJSON(result);
+        result += std::string(", \"type\": \"") + BasicType::getName(b.getType()) +
+                  "\", \"dim\": " + region->getOutputDimensions(outputs[i].second).toString(false) + "}";
+      }
+      return result + "}";
+    };
+
+    if (vm.contains("inputs"))
+      return "{\"result\": " + step(vm["inputs"]) + "}";
+
+    const Value &records = vm["records"];
+    NTA_CHECK(records.isSequence()) << "Expected a sequence of records.";
+    std::string result = "{\"result\": [";
+    for (size_t r = 0; r < records.size(); r++) {
+      if (r > 0)
+        result += ", ";
+      result += step(records[r]);
+    }
+    return result + "]}";
+  } catch (Exception &e) {
+    return "{\"err\": " + Value::json_string(e.getMessage()) + "}";
+  } catch (std::exception& e) {
+    return "{\"err\": " + Value::json_string(e.what()) + "}";
+  } catch (...) {
+    return "{\"err\": " + Value::json_string("Unknown Exception.") + "}";
+  }
+}
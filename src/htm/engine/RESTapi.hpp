@@ -46,19 +46,70 @@
  *       which is compiled with the rest server.  An application can use the server
  *       AS-IS or replace the server and server_core.hpp to sute its needs.
  *
+ * CONCURRENCY:
+ *       The handlers may be called concurrently, ie. from the thread pool of
+ *       the httplib server.  The map of resources is guarded by a shared
+ *       mutex, which is only held exclusively while a Network is added or
+ *       removed.  Each Network has its own lock: requests for different
+ *       Networks run in parallel, requests for the same Network are executed
+ *       one at a time, in the order they arrived (FIFO).
+ *
+ * BINARY PROTOCOL:
+ *       Arrays can also be sent and received as binary frames, with the content
+ *       type RESTapi::BINARY_CONTENT_TYPE, instead of JSON text. A frame is a
+ *       24 byte header in host byte order followed by the payload:
+ *           uint32 type      NTA_BasicType of the array
+ *           uint32 encoding  0: raw buffer, 1: sparse indices (SDR only)
+ *           uint64 count     number of elements of the array
+ *           uint64 bytes     size of the payload in bytes
+ *       The raw payload is the Array buffer itself. The sparse payload is the
+ *       delta + varint encoding of SDR::encodeSparse(), typically 1-2 bytes per
+ *       active bit, which is what SDRs are always sent as.
+ *       A stream request sends many input frames in one message and receives
+ *       one output frame per iteration, see stream_request().
+ *
+ * PERSISTENCE:
+ *       With open_store(directory) every Network can be saved to, and is
+ *       restored from, a file "<id>.htmnet" in that directory (the id is
+ *       %-escaped where it is not a safe file name).  open_store() only lists
+ *       the directory; a Network is loaded when its id is first used, so a
+ *       server with thousands of saved Networks starts at once.
+ *       save_request() writes with Network::saveAsync(), in the background,
+ *       while further requests for the Network are already served.
+ *
+ * HIBERNATION:
+ *       A server with many Networks of which few are used at a time can
+ *       page the idle ones out: with set_hibernation(seconds, directory) a
+ *       background thread saves every Network which was not used for that
+ *       long to a chunked checkpoint in the directory (see
+ *       Network::saveToChunkedFile()) and releases it.  The next request for
+ *       it restores it before it is served; the client does not notice,
+ *       apart from the latency.  A Network which is in use, or has a save or
+ *       a region swap pending, is not hibernated.  The checkpoints are not a
+ *       store: they are removed when restored or deleted, and by a restart.
+ *       hibernation_request() reports the hits and misses with their latency.
+ *
  * LIMITATIONS:
  *       1) Only built-in C++ regions can be used.  There are plans to
  *          eventually allow connecting to Python regions and dynamically 
  *          loaded C++ regions.
- *       2) Save and Load operations via REST on the Network object have not 
- *          yet been implemented.
  */
 
 #ifndef NTA_REST_API_HPP
 #define NTA_REST_API_HPP
 
 
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+
 #include <htm/engine/Network.hpp>
+#include <htm/utils/LatencyHistogram.hpp>
 
 namespace htm {
 
@@ -333,18 +384,298 @@ public:
    */
   std::string command_request(const std::string &id, const std::string &region_name, const std::string& command);
 
+  /**
+   * @b Description:
+   * Handler for a "swap" request message: the hot swap of a region, see
+   * Network::swapRegionAsync(). The replacement is loaded in the background
+   * while the network keeps running, and swapped in before the next
+   * iteration of a "run" request.
+   *
+   * @param id  Identifier for the resource context (a Network class instance).
+   *            Client should pass the id returned by the previous "configure"
+   *            request message.
+   *
+   * @param region_name  The name of the region.
+   *
+   * @param file  A save of the region to load (see Region::saveToFile()), or
+   *              "" for the state of the last swap of the region.
+   *
+   * @retval            "OK" when the load started; for "" "pending" or "swapped".
+   *                    Otherwise returns a JSON error message {"err": ...}, also
+   *                    when the load failed.
+   */
+  std::string swap_request(const std::string &id, const std::string &region_name, const std::string &file);
+
+  /**
+   * @b Description:
+   * Handler for a "profile" request message.
+   * Controls the profiling of the Network or returns the latency histograms
+   * recorded so far, see Network::getProfile().
+   *
+   * @param id  Identifier for the resource context (a Network class instance).
+   *            Client should pass the id returned by the previous "configure"
+   *            request message.
+   *
+   * @param action  "enable", "disable", "reset" or "" to get the profile.
+   *
+   * @retval            The profile in JSON for "", otherwise "OK".
+   *                    Otherwise returns error message starting with "ERROR: ".
+   */
+  std::string profile_request(const std::string &id, const std::string &action);
+
+  /**
+   * @b Description:
+   * Handler for a "metrics" request message, for scraping by Prometheus.
+   * See Network::getMetrics(); every sample is labeled with network="<id>".
+   *
+   * @param id  Identifier for the resource context (a Network class instance).
+   *            Client should pass the id returned by the previous "configure"
+   *            request message.
+   *
+   * @retval            The metrics in the Prometheus text exposition format.
+   *                    Otherwise returns a JSON error message {"err": ...}.
+   */
+  std::string metrics_request(const std::string &id);
+
+  /**
+   * @b Description:
+   * Handler for a "memory" request message.
+   * Returns the bytes of memory of the Network by category, see
+   * Network::memoryUsage(), and their "total".
+   *
+   * @param id  Identifier for the resource context (a Network class instance).
+   *            Client should pass the id returned by the previous "configure"
+   *            request message.
+   *
+   * @retval            {"result": {"<category>": bytes, ..., "total": bytes}}
+   *                    Otherwise returns a JSON error message {"err": ...}.
+   */
+  std::string memory_request(const std::string &id);
+
+  /**
+   * @b Description:
+   * Handler for a PUT "input" request message with a binary frame as its body.
+   * Same as put_input_request() but the data is one binary frame, see
+   * BINARY PROTOCOL above.  The frame is converted to the type of the input.
+   *
+   * @retval            If successful it returns "OK".
+   *                    Otherwise returns a JSON encoded error message {"err": ...}.
+   */
+  std::string put_input_binary_request(const std::string &id,
+                                       const std::string &input_name,
+                                       const std::string &data);
+
+  /**
+   * @b Description:
+   * Handler for a GET "output" request message asking for a binary frame.
+   * Same as get_output_request() but returns one binary frame.
+   *
+   * @retval            If success returns the binary frame of the output.
+   *                    Otherwise returns a JSON encoded error message {"err": ...}.
+   */
+  std::string get_output_binary_request(const std::string &id,
+                                        const std::string &region_name,
+                                        const std::string &output_name);
+
+  /**
+   * @b Description:
+   * Handler for a "stream" request message: many iterations in one message.
+   * For each binary input frame in data, in order, the input is set, the
+   * Network is run one iteration and the output is captured.
+   *
+   * @param id          Identifier for the resource context (a Network class instance).
+   * @param input_name  The name of the input that receives the frames.
+   * @param region_name The name of the region with the output to capture.
+   * @param output_name The name of the output to capture.
+   * @param data        A sequence of binary frames, one per iteration.
+   *
+   * @retval            If success returns the sequence of binary output frames,
+   *                    one per input frame.
+   *                    Otherwise returns a JSON encoded error message {"err": ...}.
+   */
+  std::string stream_request(const std::string &id,
+                             const std::string &input_name,
+                             const std::string &region_name,
+                             const std::string &output_name,
+                             const std::string &data);
+
+  /**
+   * @b Description:
+   * Handler for a "step" request message: sets inputs, runs and returns
+   * outputs in one round trip, instead of PUT input, GET run and GET output.
+   *
+   * @param id    Identifier for the resource context (a Network class instance).
+   *
+   * @param data  JSON or YAML encoded request:
+   *                {inputs: {<input name>: {data: [...]}, ...},
+   *                 outputs: ["<region name>.<output name>", ...],
+   *                 iterations: <iterations>}
+   *              Each input is in the same format as for put_input_request().
+   *              iterations is optional, default 1.  Instead of 'inputs' a
+   *              batch of records may be given as
+   *                {records: [{<input name>: {data: [...]}, ...}, ...], ...}
+   *              For each record, in order, its inputs are set, the Network
+   *              runs 'iterations' times and the outputs are captured.
+   *
+   * @retval      If success returns
+   *                {"result": {"<region>.<output>": {"data": [...], "type": ..., "dim": [...]}, ...}}
+   *              or for records a "result" sequence with one such map per record.
+   *              Otherwise returns a JSON encoded error message {"err": ...}.
+   */
+  std::string step_request(const std::string &id, const std::string &data);
+
+  /**
+   * @b Description:
+   * Sets the directory where Networks are saved and registers every Network
+   * saved there, without loading them; see PERSISTENCE above.
+   * The directory is created if it does not exist.
+   *
+   * @retval  The number of saved Networks found. Throws on error.
+   */
+  size_t open_store(const std::string &directory);
+
+  /**
+   * @b Description:
+   * Handler for a "save" request message. Saves the Network to the store in
+   * the background, see Network::saveAsync().  A save waits for the previous
+   * save of the same Network.
+   *
+   * @param id    Identifier for the resource context (a Network class instance).
+   * @param wait  If true, returns only after the file is written.
+   *
+   * @retval      If success returns "OK".
+   *              Otherwise returns a JSON encoded error message {"err": ...}.
+   */
+  std::string save_request(const std::string &id, bool wait);
+
+  /**
+   * @b Description:
+   * Handler for a "load" request message. Replaces the Network with the
+   * one last saved in the store.
+   *
+   * @retval      If success returns "OK".
+   *              Otherwise returns a JSON encoded error message {"err": ...}.
+   */
+  std::string load_request(const std::string &id);
+
+  /**
+   * @b Description:
+   * Turns hibernation on or off, see HIBERNATION above.  The directory is
+   * created if it does not exist.  Turning it off keeps the hibernated
+   * Networks where they are until they are used.
+   *
+   * @param idle_seconds  Hibernate the Networks idle for this long, 0 is off.
+   * @param directory     Where the checkpoints are written.
+   * @param compress      Compress the checkpoints: smaller, slower to restore.
+   */
+  void set_hibernation(unsigned int idle_seconds, const std::string &directory, bool compress = true);
+
+  /**
+   * @b Description:
+   * Hibernates now every Network idle for at least idle_seconds, which is
+   * not in use, as the background thread of set_hibernation() does.
+   * Requires the directory of set_hibernation().
+   *
+   * @retval  The number of Networks hibernated.
+   */
+  size_t hibernate_idle(unsigned int idle_seconds);
+
+  /**
+   * @b Description:
+   * Handler for a "hibernation" request message.  A request for a Network
+   * in memory is a hit, one which has to load it first a miss; the
+   * latencies are from finding the Network until it is ready, which
+   * includes waiting for the requests queued before.
+   *
+   * @retval      {"result": {"networks": n, "hibernated": n, "hibernations": n,
+   *                          "hits": {latency}, "misses": {latency}, "hibernate": {latency}}}
+   *              where each {latency} is a LatencyHistogram::toJSON().
+   */
+  std::string hibernation_request();
+
+  // Content type of binary frames.
+  static const std::string BINARY_CONTENT_TYPE;
+
+  // Appends the binary frame of 'a' to 'frames'. Str and Handle arrays are
+  // not plain data and throw.
+  static void encode_binary(const Array &a, std::string &frames);
+
+  // Decodes the binary frame starting at data[pos] and moves pos past it.
+  // Throws on a malformed frame, or one of type Str or Handle.
+  static Array decode_binary(const std::string &data, size_t &pos);
+
 
 
 private:
+  // A mutex which grants the lock in the order it was requested.
+  class FifoMutex {
+  public:
+    void lock() {
+      std::unique_lock<std::mutex> lock(mutex_);
+      const UInt64 ticket = next_++;
+      turn_.wait(lock, [&] { return serving_ == ticket; });
+    }
+    bool try_lock() {  // only if nobody holds or waits for it
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (next_ != serving_)
+        return false;
+      next_++;
+      return true;
+    }
+    void unlock() {
+      std::lock_guard<std::mutex> lock(mutex_);
+      serving_++;
+      turn_.notify_all();
+    }
+  private:
+    std::mutex mutex_;
+    std::condition_variable turn_;
+    UInt64 next_ = 0u;
+    UInt64 serving_ = 0u;
+  };
+
   struct ResourceContext {
     std::string id;               // id for the resource
     time_t t;                     // last access time
     std::shared_ptr<Network> net; // context for this resource instance
+    FifoMutex mutex;              // held while a request uses net
+    bool deleted = false;         // removed while requests were queued
+    std::string file;             // in the store, empty without a store
+    std::future<void> saving;     // the last save_request()
+    std::map<std::string, std::shared_future<void>> swaps; // the last swap_request() by region
+    std::string hibernated;       // the checkpoint of net while it is released
+    std::atomic<bool> asleep{false}; // !hibernated.empty(), readable without the lock
+    ~ResourceContext();           // removes the checkpoint
   };
 
+  // Find the resource, throws if not found. The caller must lock its mutex
+  // and then call touch_() before using it.  touch_() loads the Network
+  // from the store on first use, or restores it from hibernation.
+  std::shared_ptr<ResourceContext> find_(const std::string &id) const;
+  void touch_(ResourceContext &ctx);
+  std::string store_file_(const std::string &id) const;  // requires resourceMutex_
+  std::string store_;  // directory of open_store(), guarded by resourceMutex_
+
   // A map of open resources. 
-  std::map<std::string, ResourceContext> resource_;
-  std::string get_new_id_(); 
+  std::map<std::string, std::shared_ptr<ResourceContext>> resource_;
+  mutable std::shared_mutex resourceMutex_;  // guards resource_ and next_id_
+  unsigned int next_id_ = 1u;
+  std::string get_new_id_();  // requires resourceMutex_ held exclusively
+
+  // Hibernation, see set_hibernation().
+  bool hibernate_(ResourceContext &ctx, unsigned int idle_seconds, time_t now);  // requires ctx.mutex
+  void hibernation_loop_();
+  std::mutex hibernationMutex_;   // guards the settings and the thread
+  std::condition_variable hibernationWake_;
+  std::thread hibernationThread_;
+  unsigned int hibernateAfter_ = 0u;
+  std::string hibernationDir_;
+  bool hibernationCompress_ = true;
+  std::atomic<UInt64> hibernations_{0u};  // also numbers the checkpoint files
+  std::mutex statsMutex_;          // guards the histograms
+  LatencyHistogram hitLatency_;
+  LatencyHistogram missLatency_;
+  LatencyHistogram hibernateLatency_;
 };
 
 } // namespace htm
@@ -23,6 +23,7 @@ Methods related to inputs and outputs are in Region_io.cpp
 
 */
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <set>
@@ -38,8 +39,10 @@ Methods related to inputs and outputs are in Region_io.cpp
 #include <htm/engine/Spec.hpp>
 #include <htm/ntypes/Array.hpp>
 #include <htm/ntypes/BasicType.hpp>
+#include <htm/os/Path.hpp>
 #include <htm/types/Sdr.hpp>
 #include <htm/utils/Log.hpp>
+#include <htm/utils/Tracer.hpp>
 
 namespace htm {
 
@@ -151,6 +154,9 @@ void Region::initialize() {
   if (initialized_)
     return;
 
+  // The memory which the impl touches first is on the node of its CPUs.
+  ThreadPool::PinScope pin(cpus_);
+
   // Make sure all unconnected outputs have a buffer.
   for(auto out: outputs_) {
     if (!out.second->getData().has_buffer()) {
@@ -175,6 +181,7 @@ std::string Region::executeCommand(const std::vector<std::string> &args) {
   if (profilingEnabled_)
     executeTimer_.start();
 
+  computed_ = false;
   retVal = impl_->executeCommand(args, (UInt64)(-1));
 
   if (profilingEnabled_)
@@ -183,20 +190,221 @@ std::string Region::executeCommand(const std::vector<std::string> &args) {
   return retVal;
 }
 
-void Region::compute() {
+std::map<std::string, Real64> Region::getMetrics() const {
+  return impl_->getMetrics();
+}
+
+MemoryUsage Region::memoryUsage() const {
+  return impl_->memoryUsage();
+}
+
+void Region::compute(bool skipUnchanged) {
+  UInt64 epoch = 0u;
+  if (!beginCompute_(skipUnchanged, epoch))
+    return;
+
+  Tracer::Span span("compute", name_);
+  ThreadPool::PinScope pin(cpus_);
+  if (!profilingEnabled_) {
+    impl_->compute();
+  } else {
+    computeTimer_.start();
+    if (perfCountersEnabled_)
+      computeCounters_.start();
+    const UInt64 t0 = LatencyHistogram::now();
+    impl_->compute();
+    computeProfile_.record(LatencyHistogram::now() - t0);
+    if (perfCountersEnabled_)
+      computeCounters_.stop();
+    computeTimer_.stop();
+  }
+  endCompute_(skipUnchanged, epoch);
+}
+
+namespace {
+  std::future<void> readyFuture_() {
+    std::promise<void> done;
+    done.set_value();
+    return done.get_future();
+  }
+} // namespace
+
+std::future<void> Region::computeAsync(bool skipUnchanged) {
+  if (!impl_->isAsync()) {
+    compute(skipUnchanged);
+    return readyFuture_();
+  }
+  UInt64 epoch = 0u;
+  if (!beginCompute_(skipUnchanged, epoch))
+    return readyFuture_();
+
+  // The profile is the time until the result is waited for; the perf
+  // counters count this thread only, they are left out.
+  const UInt64 t0 = profilingEnabled_ ? LatencyHistogram::now() : 0u;
+  if (profilingEnabled_)
+    computeTimer_.start();
+  std::shared_future<void> running = impl_->computeAsync().share();
+  return std::async(std::launch::deferred, [this, running, skipUnchanged, epoch, t0]() {
+    running.get();
+    if (profilingEnabled_) {
+      computeProfile_.record(LatencyHistogram::now() - t0);
+      computeTimer_.stop();
+    }
+    endCompute_(skipUnchanged, epoch);
+  });
+}
+
+bool Region::isAsync() const { return impl_->isAsync(); }
+
+bool Region::canDegrade() const { return impl_->canDegrade(); }
+
+void Region::setDegraded(bool degraded) { impl_->setDegraded(degraded); }
+
+bool Region::beginCompute_(bool skipUnchanged, UInt64 &epoch) {
   if (!initialized_)
     NTA_THROW << "Region " << getName()
               << " unable to compute because not initialized";
 
-  if (profilingEnabled_)
-    computeTimer_.start();
+  if (inputsHeld_()) {
+    for (const auto &output : outputs_)
+      output.second->setHeld(true);
+    skipped_++;
+    return false;
+  }
+  epoch = 0u;
+  if (skipUnchanged) {
+    epoch = inputsEpoch_();
+    if (computed_ && epoch == computedEpoch_ && impl_->isPure()) {
+      for (const auto &output : outputs_)
+        output.second->setHeld(false); // unchanged, but not held back
+      skipped_++;
+      return false;
+    }
+  }
+  computed_ = false;
+  for (const auto &output : outputs_)
+    output.second->setHeld(false);
+  return true;
+}
 
-  impl_->compute();
+void Region::endCompute_(bool skipUnchanged, UInt64 epoch) {
+  for (const auto &output : outputs_) {
+    if (output.second->isHeld())
+      continue;
+    if (skipUnchanged)
+      output.second->update();
+    else
+      output.second->touch();
+  }
+  computed_ = skipUnchanged;
+  computedEpoch_ = epoch;
+}
+
+bool Region::inputsHeld_() const {
+  bool held = false;
+  for (const auto &input : inputs_) {
+    if (input.second->getLinks().empty())
+      continue;
+    if (!input.second->isHeld())
+      return false;
+    held = true;
+  }
+  return held;
+}
 
+UInt64 Region::inputsEpoch_() const {
+  UInt64 epoch = 0u;
+  for (const auto &input : inputs_) {
+    for (const auto &link : input.second->getLinks())
+      epoch += link->getEpoch();
+  }
+  return epoch;
+}
+
+namespace {
+  // Copy the content of a record, reusing the destination buffer.
+  void copyRecord(const Array &from, Array &to) {
+    if (to.getType() != from.getType() || to.getCount() != from.getCount()) {
+      to = from.copy();
+    } else if (from.getType() == NTA_BasicType_SDR) {
+      to.getSDRNoRefresh().setSDR(from.getSDR());
+    } else {
+      from.convertInto(to, 0u, to.getCount());
+    }
+  }
+} // namespace
+
+void Region::computeBatch(size_t n) {
+  if (!initialized_)
+    NTA_THROW << "Region " << getName()
+              << " unable to compute because not initialized";
+  if (n == 0u)
+    return;
+  Tracer::Span span("computeBatch", name_);
+  ThreadPool::PinScope pin(cpus_);
+  const bool atOnce = impl_->canComputeBatch();
+  const UInt64 t0 = profilingEnabled_ ? LatencyHistogram::now() : 0u;
   if (profilingEnabled_)
-    computeTimer_.stop();
+    computeTimer_.start();
+  if (profilingEnabled_ && perfCountersEnabled_)
+    computeCounters_.start();
+
+  // The sources' own data is put back when all records are read.
+  std::vector<std::pair<Output *, Array>> sources;
+  for (const auto &input : inputs_) {
+    for (const auto &link : input.second->getLinks()) {
+      Output *src = link->getSrc();
+      if (src->getBatch().size() < n)
+        continue; // not batched, all records read its current data
+      if (std::none_of(sources.begin(), sources.end(),
+                       [src](const std::pair<Output *, Array> &s) { return s.first == src; }))
+        sources.emplace_back(src, src->getData());
+    }
+    if (atOnce)
+      input.second->getBatch().resize(n);
+  }
+  for (const auto &output : outputs_)
+    output.second->getBatch().resize(n);
+
+  for (size_t i = 0; i < n; i++) {
+    for (auto &source : sources)
+      source.first->getData() = source.first->getBatch()[i];
+    prepareInputs();
+    if (atOnce) {
+      for (const auto &input : inputs_)
+        copyRecord(input.second->getData(), input.second->getBatch()[i]);
+    } else {
+      impl_->compute();
+      for (const auto &output : outputs_)
+        copyRecord(output.second->getData(), output.second->getBatch()[i]);
+    }
+  }
+  for (auto &source : sources)
+    source.first->getData() = source.second;
+
+  if (atOnce) {
+    for (const auto &output : outputs_) {
+      const Array &data = output.second->getData();
+      for (Array &record : output.second->getBatch()) {
+        if (record.getType() != data.getType() || record.getCount() != data.getCount())
+          record = data.copy();
+      }
+    }
+    impl_->computeBatch(n);
+    for (const auto &output : outputs_)
+      copyRecord(output.second->getBatch()[n - 1u], output.second->getData());
+  }
+  for (const auto &output : outputs_) {
+    output.second->setHeld(false);
+    output.second->touch();
+  }
+  computed_ = false;
 
-  return;
+  if (profilingEnabled_) {
+    computeProfile_.record(LatencyHistogram::now() - t0);
+    computeCounters_.stop();
+    computeTimer_.stop();
+  }
 }
 
 /**
@@ -303,13 +511,33 @@ void Region::removeAllIncomingLinks() {
 }
 
 void Region::uninitialize() { initialized_ = false; }
-void Region::enableProfiling() { profilingEnabled_ = true; }
+void Region::enableProfiling(bool perfCounters) {
+  profilingEnabled_ = true;
+  perfCountersEnabled_ = perfCounters;
+  for (const auto &input : inputs_) {
+    for (const auto &link : input.second->getLinks())
+      link->enableProfiling();
+  }
+}
 
-void Region::disableProfiling() { profilingEnabled_ = false; }
+void Region::disableProfiling() {
+  profilingEnabled_ = false;
+  for (const auto &input : inputs_) {
+    for (const auto &link : input.second->getLinks())
+      link->disableProfiling();
+  }
+}
 
 void Region::resetProfiling() {
   computeTimer_.reset();
   executeTimer_.reset();
+  computeProfile_.reset();
+  prepareInputsProfile_.reset();
+  computeCounters_.reset();
+  for (const auto &input : inputs_) {
+    for (const auto &link : input.second->getLinks())
+      link->resetProfiling();
+  }
 }
 
 const Timer &Region::getComputeTimer() const { return computeTimer_; }
@@ -429,10 +657,17 @@ const Array& Region::getOutputData(const std::string &outputName) const {
     NTA_THROW << "getOutputData -- unknown output '" << outputName
               << "' on region " << getName();
 
+  refreshOutput_(*oi->second);
   const Array& data = oi->second->getData();
   return data;
 }
 
+void Region::refreshOutput_(Output &output) const {
+  if (!output.isStale()) return;
+  impl_->computeOutput(output.getName());
+  output.setStale(false);
+}
+
 const Array& Region::getInputData(const std::string &inputName) const {
   auto ii = inputs_.find(inputName);
   if (ii == inputs_.end())
@@ -443,53 +678,73 @@ const Array& Region::getInputData(const std::string &inputName) const {
   return data;
 }
 
-void Region::prepareInputs() {
+void Region::prepareInputs(bool snapshot) {
+  Tracer::Span span("prepareInputs", name_);
+  const UInt64 t0 = profilingEnabled_ ? LatencyHistogram::now() : 0u;
   // Ask each input to prepare itself
   for (InputMap::const_iterator i = inputs_.begin(); i != inputs_.end(); i++) {
-    i->second->prepare();
+    i->second->prepare(snapshot);
   }
+  if (profilingEnabled_)
+    prepareInputsProfile_.record(LatencyHistogram::now() - t0);
 }
 
 
 // setParameter
 void Region::setParameterByte(const std::string &name, Byte value) {
+  computed_ = false;
   impl_->setParameterByte(name, (Int64)-1, value);
 }
 
 void Region::setParameterInt32(const std::string &name, Int32 value) {
+  computed_ = false;
   impl_->setParameterInt32(name, (Int64)-1, value);
 }
 
 void Region::setParameterUInt32(const std::string &name, UInt32 value) {
+  computed_ = false;
   impl_->setParameterUInt32(name, (Int64)-1, value);
 }
 
 void Region::setParameterInt64(const std::string &name, Int64 value) {
+  computed_ = false;
   impl_->setParameterInt64(name, (Int64)-1, value);
 }
 
 void Region::setParameterUInt64(const std::string &name, UInt64 value) {
+  computed_ = false;
   impl_->setParameterUInt64(name, (Int64)-1, value);
 }
 
 void Region::setParameterReal32(const std::string &name, Real32 value) {
+  computed_ = false;
   impl_->setParameterReal32(name, (Int64)-1, value);
 }
 
 void Region::setParameterReal64(const std::string &name, Real64 value) {
+  computed_ = false;
   impl_->setParameterReal64(name, (Int64)-1, value);
 }
 
 void Region::setParameterBool(const std::string &name, bool value) {
-impl_->setParameterBool(name, (Int64)-1, value);
+  computed_ = false;
+  impl_->setParameterBool(name, (Int64)-1, value);
 }
 
 void Region::setParameterJSON(const std::string &name, const std::string &value) {
   try {
+    const ParameterSpec &p = spec_->parameters.getByName(name);
+    NTA_BasicType type = p.dataType;
+    if (p.count != 1) {
+      // An array, e.g. [1, 2, 3], see ArrayBase::fromJSON().
+      Array a(type);
+      a.fromJSON(value);
+      setParameterArray(name, a);
+      return;
+    }
     Value vm;
     vm.parse(value);
 
-    NTA_BasicType type = spec_->parameters.getByName(name).dataType;
     switch (type) {
     case NTA_BasicType_Byte:
       setParameterByte(name, vm.as<Byte>());
@@ -621,7 +876,9 @@ std::string Region::getParameterJSON(const std::string &name, bool withType) con
       Array a(type);
       a.allocateBuffer(len);
       getParameterArray(name, a);
-      std::string data = a.toJSON();
+      std::string data;
+      data.reserve(16u + len * 4u);
+      a.appendJSON(data);
       if (!withType)
         return data;
 
@@ -645,7 +902,7 @@ std::string Region::getParameterJSON(const std::string &name, bool withType) con
 
       return "{\"value\": " + data +
               ", \"type\": \"" + std::string(BasicType::getName(type)) +
-              ", \"dim\": " + dimStr + "}";
+              "\", \"dim\": " + dimStr + "}";
 
     }
   } catch (Exception &e) {
@@ -662,6 +919,7 @@ void Region::getParameterArray(const std::string &name, Array &array) const {
 }
 
 void Region::setParameterArray(const std::string &name, const Array &array) {
+  computed_ = false;
   impl_->setParameterArray(name, (Int64)-1, array);
 }
 
@@ -670,6 +928,7 @@ size_t Region::getParameterArrayCount(const std::string &name) const {
 }
 
 void Region::setParameterString(const std::string &name, const std::string &s) {
+  computed_ = false;
   impl_->setParameterString(name, (Int64)-1, s);
 }
 
@@ -711,6 +970,7 @@ void Region::loadDims_(std::map<std::string,Dimensions>& outDims,
 
 void Region::getOutputBuffers_(std::map<std::string, Array>& buffers) const {
 	for (auto iter : outputs_) {
+    refreshOutput_(*iter.second);
     buffers[iter.first] = iter.second->getData();
 	}
 }
@@ -726,6 +986,74 @@ void Region::restoreOutputBuffers_(const std::map<std::string, Array>& buffers)
 }
 
 
+namespace {
+  // Reads a save of a Region (see Region::save_ar()) into a new impl of
+  // another region, of the same type and dimensions.
+  class ImplLoader : public Serializable {
+  public:
+    ImplLoader(Region *region, const std::map<std::string, Dimensions> &outDims,
+               const std::map<std::string, Dimensions> &inDims)
+      : region_(region), outDims_(outDims), inDims_(inDims) {}
+
+    std::unique_ptr<RegionImpl> impl;
+
+    CerealAdapter;
+    template<class Archive>
+    void save_ar(Archive &) const {
+      NTA_THROW << "Region::loadImpl: can not save.";
+    }
+    template<class Archive>
+    void load_ar(Archive &ar) {
+      std::string name, type;
+      bool init;
+      Dimensions dim;
+      std::map<std::string, Dimensions> outDims, inDims;
+      std::map<std::string, Array> buffers;  // the outputs of the region stay
+      ar(cereal::make_nvp("name", name));
+      ar(cereal::make_nvp("nodeType", type));
+      ar(cereal::make_nvp("initialized", init));
+      ar(cereal::make_nvp("dim", dim));
+      ar(cereal::make_nvp("output_dims", outDims));
+      ar(cereal::make_nvp("input_dims",  inDims));
+      ar(cereal::make_nvp("outputs", buffers));
+      NTA_CHECK(type == region_->getType())
+        << "Region::loadImpl: region " << region_->getName() << " is a " << region_->getType()
+        << ", the saved region " << name << " a " << type << ".";
+      NTA_CHECK(init) << "Region::loadImpl: the saved region " << name << " was not initialized.";
+      checkDims_("output", outDims, outDims_);
+      checkDims_("input", inDims, inDims_);
+
+      ArWrapper arw(&ar);
+      impl.reset(RegionImplFactory::getInstance().deserializeRegionImpl(type, arw, region_));
+    }
+
+  private:
+    void checkDims_(const char *what, const std::map<std::string, Dimensions> &saved,
+                    const std::map<std::string, Dimensions> &current) const {
+      for (const auto &dims : current) {
+        const auto found = saved.find(dims.first);
+        NTA_CHECK(found != saved.end() && found->second == dims.second)
+          << "Region::loadImpl: the " << what << " " << dims.first << " of region "
+          << region_->getName() << " is " << dims.second << ", saved "
+          << (found == saved.end() ? Dimensions() : found->second) << ".";
+      }
+    }
+
+    Region *region_;
+    std::map<std::string, Dimensions> outDims_, inDims_;
+  };
+} // namespace
+
+RegionImpl *Region::loadImpl(const std::string &path, SerializableFormat fmt) {
+  NTA_CHECK(Path::exists(path)) << "Region::loadImpl: " << path << " does not exist.";
+  std::map<std::string, Dimensions> outDims, inDims;
+  getDims_(outDims, inDims);
+  ImplLoader loader(this, outDims, inDims);
+  loader.loadFromFile(path, fmt);
+  NTA_CHECK(loader.impl != nullptr) << "Region::loadImpl: nothing loaded from " << path;
+  return loader.impl.release();
+}
+
 void Region::serializeImpl(ArWrapper& arw) const{
     impl_->cereal_adapter_save(arw);
 }
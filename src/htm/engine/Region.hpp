@@ -25,7 +25,9 @@
 #ifndef NTA_REGION_HPP
 #define NTA_REGION_HPP
 
+#include <future>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -34,7 +36,11 @@
 // objects are returned by value.
 #include <htm/engine/Spec.hpp>
 #include <htm/ntypes/Dimensions.hpp>
+#include <htm/os/PerfCounters.hpp>
 #include <htm/os/Timer.hpp>
+#include <htm/utils/LatencyHistogram.hpp>
+#include <htm/utils/MemoryUsage.hpp>
+#include <htm/utils/ThreadPool.hpp>
 #include <htm/types/Serializable.hpp>
 #include <htm/types/Types.hpp>
 #include <htm/ntypes/Value.hpp>
@@ -42,6 +48,7 @@
 
 namespace htm {
 
+class Arena;
 class RegionImpl;
 class Output;
 class Input;
@@ -305,8 +312,10 @@ public:
   /**
    * Copies data into the inputs of this region, using
    * the links that are attached to each input.
+   *
+   * @param snapshot - deep copy all data, see Link::compute()
    */
-  void prepareInputs();
+  void prepareInputs(bool snapshot = false);
 
   /**
    * Get the input data.
@@ -335,6 +344,9 @@ public:
    *        Note that this is read-only.
    *        To obtain a writeable Array use
    *			  region->getOutput(name)->getData();
+   *        Unlike that, getOutputData() fills in an output which the last
+   *        compute() skipped because nothing linked or watched it, see
+   *        Output::isDemanded().
    */
   virtual const Array &getOutputData(const std::string &outputName) const;
 
@@ -363,9 +375,81 @@ public:
   virtual std::string executeCommand(const std::vector<std::string> &args);
 
   /**
-   * Perform one step of the region computation.
+   * Runtime statistics reported by the underlying region, see
+   * RegionImpl::getMetrics(). Computed on each call.
+   */
+  std::map<std::string, Real64> getMetrics() const;
+
+  /**
+   * Bytes of memory of the underlying region by category, see
+   * RegionImpl::memoryUsage(). The buffers of the inputs and outputs are
+   * counted by Network::memoryUsage().
+   */
+  MemoryUsage memoryUsage() const;
+
+  /**
+   * Perform one step of the region computation, unless all linked inputs
+   * are held (see Output::isHeld()), then its outputs are held too.
+   *
+   * @param skipUnchanged - keep the outputs of the last compute() if it was
+   *   on the same inputs and the impl isPure(), see Network::setSkipUnchanged().
+   *   Either way, each output counts a change of its data, see
+   *   Output::getEpoch(): by a hash of the data when skipUnchanged, else
+   *   on every compute().
+   */
+  void compute(bool skipUnchanged = false);
+
+  /**
+   * As compute(), but if the impl isAsync() its computeAsync() runs in the
+   * background and this returns at once.  The future is ready when the
+   * outputs are; until then nothing may read the outputs of this region or
+   * change its inputs, and get() (or wait()) must be called before the next
+   * compute.  Other regions compute before this returns a ready future.
    */
-  void compute();
+  std::future<void> computeAsync(bool skipUnchanged = false);
+
+  /** Does the impl compute in the background, see RegionImpl::isAsync()? */
+  bool isAsync() const;
+
+  /** Can the impl trade quality for time, see RegionImpl::canDegrade()? */
+  bool canDegrade() const;
+  /** Degrade the following computes, see Network::setIterationBudget(). */
+  void setDegraded(bool degraded);
+
+  /**
+   * Where this region computes, and where its buffers are: see
+   * Network::setPlacement(). Not serialized.
+   */
+  void setPlacement(const Placement &placement) { placement_ = placement; }
+  const Placement &getPlacement() const { return placement_; }
+
+  /**
+   * Loads a save of a region (see saveToFile()) as a new impl of this
+   * region, which is left as it is; see Network::swapRegionAsync(). The
+   * saved region must be of the same type, with the same dimensions of its
+   * inputs and outputs. Only reads the dimensions of this region, so it may
+   * run while the region computes.
+   *
+   * @returns the new impl, owned by the caller.
+   */
+  RegionImpl *loadImpl(const std::string &path, SerializableFormat fmt = SerializableFormat::BINARY);
+
+  /**
+   * The computes which were skipped: by compute(true), or because all the
+   * inputs were held, see Output::isHeld().
+   */
+  UInt64 getSkippedComputes() const { return skipped_; }
+
+  /**
+   * Compute n iterations as one batch, see Network::setBatchSize(). Each
+   * input takes record i from the batch of its source outputs (or their
+   * current data, if they hold no batch), and record i of every output is
+   * kept in Output::getBatch(). Afterwards the outputs hold the last record.
+   *
+   * Regions whose impl canComputeBatch() get all records at once, others
+   * compute them one by one.
+   */
+  void computeBatch(size_t n);
 
   /**
    * @}
@@ -377,9 +461,13 @@ public:
    */
 
   /**
-   * Enable profiling of the compute and execute operations
+   * Enable profiling of the compute and execute operations, of
+   * prepareInputs() and of the incoming links.
+   *
+   * @param perfCounters - also count the hardware events of compute(), see
+   *        getComputeCounters(). Costs a few system calls per compute().
    */
-  void enableProfiling();
+  void enableProfiling(bool perfCounters = false);
 
   /**
    * Disable profiling of the compute and execute operations
@@ -387,10 +475,22 @@ public:
   void disableProfiling();
 
   /**
-   * Reset the compute and execute timers
+   * Reset the compute and execute timers and the latency histograms
    */
   void resetProfiling();
 
+  /**
+   * Latency histograms of compute() and of prepareInputs(), one record per call.
+   */
+  const LatencyHistogram &getComputeProfile() const { return computeProfile_; }
+  const LatencyHistogram &getPrepareInputsProfile() const { return prepareInputsProfile_; }
+
+  /**
+   * Hardware counters accumulated over compute() while profiling with
+   * perfCounters. They count the thread which runs the network.
+   */
+  const PerfCounters &getComputeCounters() const { return computeCounters_; }
+
   /**
    * Get the timer used to profile the compute operation.
    *
@@ -536,6 +636,7 @@ public:
   }
 
   friend class Network;  // so Network can set Network* network_; during addRegion( ).
+  friend class Output;   // for arena_
   friend std::ostream &operator<<(std::ostream &f, const Region &r);
 
 
@@ -545,6 +646,8 @@ private:
   // local functions
   void createInputsAndOutputs_();
   void getOutputBuffers_(std::map<std::string, Array>& buffers) const;
+  // Fill an output the last compute() skipped, see RegionImpl::computeOutput().
+  void refreshOutput_(Output &output) const;
   void restoreOutputBuffers_(const std::map<std::string, Array>& buffers);
   void getDims_(std::map<std::string,Dimensions>& outDims,
                std::map<std::string,Dimensions>& inDims) const;
@@ -552,6 +655,14 @@ private:
                std::map<std::string,Dimensions>& inDims) const;
   void serializeImpl(ArWrapper& ar) const;
   void deserializeImpl(ArWrapper& ar);
+  // The sum of the epochs of the data of all incoming links.
+  UInt64 inputsEpoch_() const;
+  // Are all linked inputs held, see Input::isHeld()?
+  bool inputsHeld_() const;
+  // The parts of compute() before and after impl_->compute(). beginCompute_
+  // returns false if the compute is skipped.
+  bool beginCompute_(bool skipUnchanged, UInt64 &epoch);
+  void endCompute_(bool skipUnchanged, UInt64 epoch);
 
   std::string name_;
 
@@ -567,6 +678,20 @@ private:
   InputMap inputs_;
   bool initialized_;
 
+  // The outputs are those of compute(true) on the inputs of computedEpoch_,
+  // unless a parameter or command changed the region since.
+  bool computed_ = false;
+  UInt64 computedEpoch_ = 0u;
+  UInt64 skipped_ = 0u;
+
+  Placement placement_;
+  // The CPUs which initialize() and compute run on, empty for any: of the
+  // placement, or of the network's default, set by Network::initialize().
+  std::vector<int> cpus_;
+  // The arena of the buffers of the outputs, by whichever region's links
+  // create them; null for that of the caller. Set by Network::initialize().
+  std::shared_ptr<Arena> arena_;
+
   // Region contains a backpointer to network_ only to be able
   // to retrieve the containing network via getNetwork() for inspectors.
   // The implementation should not use network_ in any other methods.
@@ -575,8 +700,12 @@ private:
 
   // Profiling related methods and variables.
   bool profilingEnabled_;
+  bool perfCountersEnabled_ = false;
   Timer computeTimer_;
   Timer executeTimer_;
+  LatencyHistogram computeProfile_;
+  LatencyHistogram prepareInputsProfile_;
+  PerfCounters computeCounters_;
 };
 
 } // namespace htm
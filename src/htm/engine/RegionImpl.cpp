@@ -15,7 +15,11 @@
  * along with this program.  If not, see http://www.gnu.org/licenses.
  * --------------------------------------------------------------------- */
 
+#include <condition_variable>
+#include <functional>
 #include <iostream>
+#include <mutex>
+#include <thread>
 
 #include <htm/engine/Region.hpp>
 #include <htm/engine/RegionImpl.hpp>
@@ -26,10 +30,64 @@
 
 namespace htm {
 
+// One task at a time: Region::computeAsync() waits for the last before it
+// starts the next.
+class RegionImpl::AsyncWorker_ {
+public:
+  AsyncWorker_() : thread_([this]() { loop_(); }) {}
+  ~AsyncWorker_() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+  }
+
+  std::future<void> run(std::function<void()> task) {
+    std::packaged_task<void()> packaged(std::move(task));
+    std::future<void> result = packaged.get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      NTA_CHECK(!task_.valid()) << "computeAsync: the last compute did not finish.";
+      task_ = std::move(packaged);
+    }
+    wake_.notify_one();
+    return result;
+  }
+
+private:
+  void loop_() {
+    for (;;) {
+      std::packaged_task<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [this]() { return stop_ || task_.valid(); });
+        if (!task_.valid())
+          return;
+        task = std::move(task_);
+      }
+      task(); // an exception is kept in the future
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::packaged_task<void()> task_;
+  bool stop_ = false;
+  std::thread thread_; // last, starts when the rest is constructed
+};
+
 RegionImpl::RegionImpl(Region *region) : region_(region) {}
 
 RegionImpl::~RegionImpl() {}
 
+std::future<void> RegionImpl::computeAsync() {
+  if (asyncWorker_ == nullptr)
+    asyncWorker_.reset(new AsyncWorker_());
+  return asyncWorker_->run([this]() { compute(); });
+}
+
 // convenience method
 std::string RegionImpl::getType() const { return region_->getType(); }
 
@@ -212,6 +270,22 @@ std::string RegionImpl::executeCommand(const std::vector<std::string> &args, Int
   return "";
 }
 
+void RegionImpl::computeBatch(size_t n) {
+  NTA_THROW << "Region " << getName() << " of type " << getType()
+            << " does not implement computeBatch().";
+}
+
+void RegionImpl::computeOutput(const std::string &name) {
+  NTA_THROW << "Region " << getName() << " of type " << getType()
+            << " skipped output " << name << " but does not implement computeOutput().";
+}
+
+bool RegionImpl::isDemanded(const OutputHandle &output) {
+  const bool demanded = output->isDemanded();
+  output->setStale(!demanded);
+  return demanded;
+}
+
 // Provide data access for subclasses
 
 std::shared_ptr<Input> RegionImpl::getInput(const std::string &name) const { return region_->getInput(name); }
@@ -131,8 +131,12 @@
 #ifndef NTA_REGION_IMPL_HPP
 #define NTA_REGION_IMPL_HPP
 
+#include <future>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include <htm/engine/Output.hpp>
@@ -255,6 +259,59 @@ public:
   virtual std::string executeCommand(const std::vector<std::string> &args,
                                      Int64 index);
 
+  // Batched run, see Network::setBatchSize(). If canComputeBatch() is true,
+  // computeBatch(n) is called once for n iterations instead of compute():
+  // record i of each input is getInput(name)->getBatch()[i], and record i of
+  // each output must be written into getOutput(name)->getBatch()[i], which is
+  // allocated like getOutput(name)->getData(). Otherwise compute() is called
+  // n times, once per record.
+  virtual bool canComputeBatch() const { return false; }
+  virtual void computeBatch(size_t n);
+
+  // For regions which block on I/O (files, databases, sockets): if true, the
+  // serial Network::run() starts computeAsync() instead of compute(),
+  // computes the regions which do not read from this one meanwhile, and
+  // waits for it before a region reads one of its outputs, or at the end of
+  // the iteration. The default computeAsync() runs compute() on a thread of
+  // this region, which must then touch nothing but its own inputs, outputs
+  // and state.
+  virtual bool isAsync() const { return false; }
+  virtual std::future<void> computeAsync();
+
+  // The threads of the region's placement pool (see Network::addThreadPool()),
+  // for algorithms which split their work between threads. Called after
+  // initialize(); by default they are not used.
+  virtual void setThreadPool(const std::shared_ptr<ThreadPool> &) {}
+
+  // Is compute() now a function of the inputs only, which leaves the state
+  // as it is (eg. no learning)? Then compute() on the same inputs gives the
+  // same outputs, and Network::setSkipUnchanged() skips it.
+  virtual bool isPure() const { return false; }
+
+  // Graceful degradation under a deadline, see Network::setIterationBudget().
+  // If canDegrade(), the compute()s while isDegraded() may trade quality for
+  // time, eg. SPRegion, TMRegion and ClassifierRegion skip learning then.
+  // The Network sets it around a single compute(), it is not serialized.
+  virtual bool canDegrade() const { return false; }
+  void setDegraded(bool degraded) { degraded_ = degraded; }
+  bool isDegraded() const { return degraded_; }
+
+  // Outputs on demand. compute() may skip the outputs which nobody uses, see
+  // isDemanded() below. When one of them is read with Region::getOutputData()
+  // (or saved), computeOutput(name) is called to fill it from the state left
+  // by the last compute(). A region which skips outputs must override it.
+  virtual void computeOutput(const std::string &name);
+
+  // Runtime statistics of the algorithm, e.g. sizes of its Connections,
+  // exported by Network::getMetrics(). Only called when metrics are scraped.
+  // Names ending in "_total" are exported as counters, all others as gauges.
+  virtual std::map<std::string, Real64> getMetrics() const { return {}; }
+
+  // Bytes of memory of the algorithm by category, e.g. of its Connections,
+  // reported by Network::memoryUsage(). The buffers of the inputs and outputs
+  // are counted there, not here.
+  virtual MemoryUsage memoryUsage() const { return {}; }
+
 
   // Buffer size (in elements) of the given input/output.
   // It is the total element count.
@@ -332,6 +389,54 @@ protected:
   Dimensions getInputDimensions(const std::string &name="") const;
   Dimensions getOutputDimensions(const std::string &name="") const;
 
+  // A handle on one input or output, for compute() methods which would
+  // otherwise look it up by name in every iteration. It is looked up at its
+  // first use, normally in initialize() (or in the first compute() after the
+  // region was deserialized), and then is a plain pointer. Declare it as a
+  // member of the RegionImpl:
+  //     InputHandle bottomUpIn_{this, "bottomUpIn"};
+  //     ...
+  //     Array &input = bottomUpIn_->getData();
+  template <typename Port>
+  class PortHandle {
+  public:
+    PortHandle(const RegionImpl *impl, std::string name)
+      : impl_(impl), name_(std::move(name)) {}
+
+    Port *get() const {
+      if (port_ == nullptr) {
+        if constexpr (std::is_same<Port, Input>::value)
+          port_ = impl_->getInput(name_).get();
+        else
+          port_ = impl_->getOutput(name_).get();
+        NTA_CHECK(port_ != nullptr) << "Region " << impl_->getName() << " has no "
+            << (std::is_same<Port, Input>::value ? "input " : "output ") << name_;
+      }
+      return port_;
+    }
+    Port *operator->() const { return get(); }
+    Port &operator*() const { return *get(); }
+    const std::string &getName() const { return name_; }
+
+  private:
+    const RegionImpl *impl_;
+    std::string name_;
+    mutable Port *port_ = nullptr; // owned by the Region, lives as long as the impl
+  };
+  typedef PortHandle<Input> InputHandle;
+  typedef PortHandle<Output> OutputHandle;
+
+  // For compute(): is the output linked, watched or otherwise demanded (see
+  // Output::isDemanded())? If not it is marked stale, to be filled by
+  // computeOutput() if read.
+  static bool isDemanded(const OutputHandle &output);
+
+private:
+  // The thread of the default computeAsync(), started at its first call.
+  class AsyncWorker_;
+  std::unique_ptr<AsyncWorker_> asyncWorker_;
+
+  bool degraded_ = false; // see setDegraded()
 };
 
 } // namespace htm
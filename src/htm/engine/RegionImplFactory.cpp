@@ -36,7 +36,14 @@
 #include <htm/regions/DateEncoderRegion.hpp>
 #include <htm/regions/ScalarEncoderRegion.hpp>
 #include <htm/regions/RDSEEncoderRegion.hpp>
+#include <htm/regions/MultiEncoderRegion.hpp>
+#include <htm/regions/AggregatorRegion.hpp>
 #include <htm/regions/FileOutputRegion.hpp>
+#include <htm/regions/RemoteInputRegion.hpp>
+#include <htm/regions/RemoteOutputRegion.hpp>
+#include <htm/regions/SharedMemoryInputRegion.hpp>
+#include <htm/regions/SharedMemoryOutputRegion.hpp>
+#include <htm/regions/StreamInputRegion.hpp>
 #include <htm/regions/FileInputRegion.hpp>
 #include <htm/regions/DatabaseRegion.hpp>
 #include <htm/regions/SPRegion.hpp>
@@ -46,16 +53,22 @@
 
 #include <htm/utils/Log.hpp>
 
+#include <mutex>
+
 // from http://stackoverflow.com/a/9096509/1781435
 #define stringify(x) #x
 #define expand_and_stringify(x) stringify(x)
 
 namespace htm {
 
+// Guards the registrations. Networks on several threads may add regions
+// at the same time; the lock is not taken while a Network runs.
+static std::mutex registryMutex;
 
 
 void RegionImplFactory::registerRegion(const std::string& nodeType, RegisteredRegionImpl *wrapper) {
   RegionImplFactory& instance = getInstance();
+  std::lock_guard<std::mutex> lock(registryMutex);
   if (instance.regionTypeMap.find(nodeType) != instance.regionTypeMap.end()) {
 	std::shared_ptr<RegisteredRegionImpl>& reg = instance.regionTypeMap[nodeType];
 	if (reg->className() == wrapper->className() && reg->moduleName() == wrapper->moduleName()) {
@@ -78,6 +91,7 @@ void RegionImplFactory::registerRegion(const std::string& nodeType, RegisteredRe
 
 void RegionImplFactory::unregisterRegion(const std::string nodeType) {
   RegionImplFactory& instance = getInstance();
+  std::lock_guard<std::mutex> lock(registryMutex);
   if (instance.regionTypeMap.find(nodeType) != instance.regionTypeMap.end()) {
     instance.regionTypeMap.erase(nodeType);
   }
@@ -85,7 +99,8 @@ void RegionImplFactory::unregisterRegion(const std::string nodeType) {
 
 std::string RegionImplFactory::getRegistrations() {
   RegionImplFactory& instance = getInstance();  // force load of built-ins.
-  
+  std::lock_guard<std::mutex> lock(registryMutex);
+
   std::string json = "{\n";
   for (auto iter = instance.regionTypeMap.begin(); iter != instance.regionTypeMap.end(); ++iter) {
      if (iter->first != "RawInput") {
@@ -101,6 +116,7 @@ std::string RegionImplFactory::getRegistrations() {
 
 RegionImplFactory &RegionImplFactory::getInstance() {
   static RegionImplFactory instance;
+  std::lock_guard<std::mutex> lock(registryMutex);
 
   // Initialize the Built-in Regions
   if (instance.regionTypeMap.empty()) {
@@ -108,6 +124,7 @@ RegionImplFactory &RegionImplFactory::getInstance() {
 	  instance.addRegionType("DateEncoderRegion",  new RegisteredRegionImplCpp<DateEncoderRegion>());
     instance.addRegionType("ScalarEncoderRegion", new RegisteredRegionImplCpp<ScalarEncoderRegion>());
     instance.addRegionType("RDSEEncoderRegion",  new RegisteredRegionImplCpp<RDSEEncoderRegion>());
+    instance.addRegionType("MultiEncoderRegion", new RegisteredRegionImplCpp<MultiEncoderRegion>());
     instance.addRegionType("TestNode",           new RegisteredRegionImplCpp<TestNode>());
     instance.addRegionType("FileOutputRegion",   new RegisteredRegionImplCpp<FileOutputRegion>());
     instance.addRegionType("FileInputRegion",    new RegisteredRegionImplCpp<FileInputRegion>());
@@ -115,6 +132,12 @@ RegionImplFactory &RegionImplFactory::getInstance() {
     instance.addRegionType("SPRegion",           new RegisteredRegionImplCpp<SPRegion>());
     instance.addRegionType("TMRegion",           new RegisteredRegionImplCpp<TMRegion>());
     instance.addRegionType("ClassifierRegion",   new RegisteredRegionImplCpp<ClassifierRegion>());
+    instance.addRegionType("RemoteInputRegion",        new RegisteredRegionImplCpp<RemoteInputRegion>());
+    instance.addRegionType("RemoteOutputRegion",       new RegisteredRegionImplCpp<RemoteOutputRegion>());
+    instance.addRegionType("SharedMemoryInputRegion",  new RegisteredRegionImplCpp<SharedMemoryInputRegion>());
+    instance.addRegionType("SharedMemoryOutputRegion", new RegisteredRegionImplCpp<SharedMemoryOutputRegion>());
+    instance.addRegionType("StreamInputRegion",        new RegisteredRegionImplCpp<StreamInputRegion>());
+    instance.addRegionType("AggregatorRegion",         new RegisteredRegionImplCpp<AggregatorRegion>());
 
     // Renamed Regions
     instance.addRegionType("ScalarSensor", new RegisteredRegionImplCpp<ScalarEncoderRegion>());
@@ -142,13 +165,16 @@ RegionImpl *RegionImplFactory::createRegionImpl(const std::string nodeType,
                                                 ValueMap vm,
                                                 Region *region) {
 
-  RegionImpl *impl = nullptr;
-
-  if (regionTypeMap.find(nodeType) != regionTypeMap.end()) {
-    impl = regionTypeMap[nodeType]->createRegionImpl(vm, region);
-  } else {
-    NTA_THROW << "Unregistered node type '" << nodeType << "'";
+  std::shared_ptr<RegisteredRegionImpl> reg;
+  {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto it = regionTypeMap.find(nodeType);
+    if (it == regionTypeMap.end()) {
+      NTA_THROW << "Unregistered node type '" << nodeType << "'";
+    }
+    reg = it->second;
   }
+  RegionImpl *impl = reg->createRegionImpl(vm, region);
 
   // If the parameter 'dim' was defined, parse that out as a global parameter.
   // This parameter can be used with any Region without the region needing to define it in its Spec.
@@ -196,18 +222,22 @@ RegionImpl *RegionImplFactory::createRegionImpl(const std::string nodeType,
 RegionImpl *RegionImplFactory::deserializeRegionImpl(const std::string nodeType,
                                                      ArWrapper &wrapper,
                                                      Region *region) {
-  RegionImpl *impl = nullptr;
-  if (regionTypeMap.find(nodeType) != regionTypeMap.end()) {
-    impl = regionTypeMap[nodeType]->deserializeRegionImpl(wrapper, region);
-  } else {
-    NTA_THROW << "Unsupported node type '" << nodeType << "'";
+  std::shared_ptr<RegisteredRegionImpl> reg;
+  {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto it = regionTypeMap.find(nodeType);
+    if (it == regionTypeMap.end()) {
+      NTA_THROW << "Unsupported node type '" << nodeType << "'";
+    }
+    reg = it->second;
   }
-  return impl;
+  return reg->deserializeRegionImpl(wrapper, region);
 }
 
 
 
 std::shared_ptr<Spec> RegionImplFactory::getSpec(const std::string nodeType) {
+  std::lock_guard<std::mutex> lock(registryMutex);
   auto it = regionSpecMap.find(nodeType);
   if (it == regionSpecMap.end()) {
 	NTA_THROW << "getSpec() -- unknown node type: '" << nodeType
@@ -219,9 +249,9 @@ std::shared_ptr<Spec> RegionImplFactory::getSpec(const std::string nodeType) {
 
 
 void RegionImplFactory::cleanup() {
-  RegionImplFactory& instance = getInstance();
-  instance.regionTypeMap.clear();
-  instance.regionSpecMap.clear();
+  std::lock_guard<std::mutex> lock(registryMutex);
+  regionTypeMap.clear();
+  regionSpecMap.clear();
 }
 
 // definitions for our class variables.
@@ -23,6 +23,8 @@
  * Because all C++ RegionImpls are compiled in to NuPIC,
  * the RegionImpl factory knows about them explicitly.
  *
+ * The registrations are shared by all Networks of the process, all methods
+ * may be called from several threads.
  */
 
 #ifndef NTA_REGION_IMPL_FACTORY_HPP
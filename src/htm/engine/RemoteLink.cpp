@@ -0,0 +1,333 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of RemoteLink
+ */
+
+#include <chrono>
+#include <cstring> // memcpy, strerror
+#include <thread>
+
+#if !defined(NTA_OS_WINDOWS)
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <htm/engine/RemoteLink.hpp>
+#include <htm/ntypes/BasicType.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+namespace {
+  const UInt32 MAGIC = 0x46544d48u; // "HTMF"
+  const UInt32 MAX_DIMS = 8u;
+
+  // Each Array is this header, numDims dimensions, then payloadBytes of data.
+  struct FrameHeader {
+    UInt32 magic;
+    UInt32 type;
+    UInt32 numDims;      // 0 unless an SDR
+    UInt32 payloadBytes; // varint encoded sparse indices, or the buffer
+  };
+
+  using Clock = std::chrono::steady_clock;
+
+  // Milliseconds left until deadline, for poll().
+  int msLeft(const Clock::time_point deadline) {
+    const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+    return left > 0 ? static_cast<int>(left) : 0;
+  }
+
+#if !defined(NTA_OS_WINDOWS)
+  // false on timeout.
+  bool waitFor(const int fd, const short events, const Clock::time_point deadline) {
+    while (true) {
+      struct pollfd p = {fd, events, 0};
+      const int n = poll(&p, 1, msLeft(deadline));
+      if (n > 0)
+        return true;
+      if (n == 0)
+        return false;
+      NTA_CHECK(errno == EINTR) << "RemoteLink: poll failed: " << strerror(errno);
+    }
+  }
+
+  void setNoDelay(const int fd) {
+    // Frames are small and each one is waited for, don't let Nagle hold them back.
+    const int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#if defined(SO_NOSIGPIPE)
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+  }
+#endif
+
+#if defined(MSG_NOSIGNAL)
+  const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+  const int SEND_FLAGS = 0;
+#endif
+} // namespace
+
+
+RemoteLink::RemoteLink(UInt16 port) {
+#if defined(NTA_OS_WINDOWS)
+  NTA_THROW << "RemoteLink: not available on Windows";
+#else
+  listenFd_ = socket(AF_INET6, SOCK_STREAM, 0);
+  bool v6 = listenFd_ >= 0;
+  if (!v6)
+    listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+  NTA_CHECK(listenFd_ >= 0) << "RemoteLink: can't create a socket: " << strerror(errno);
+  const int one = 1, zero = 0;
+  setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+  int result;
+  if (v6) {
+    setsockopt(listenFd_, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero)); // IPv4 too
+    struct sockaddr_in6 addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin6_family = AF_INET6;
+    addr.sin6_addr = in6addr_any;
+    addr.sin6_port = htons(port);
+    result = bind(listenFd_, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr));
+  } else {
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    result = bind(listenFd_, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr));
+  }
+  if (result != 0 || listen(listenFd_, 1) != 0) {
+    const int error = errno;
+    ::close(listenFd_);
+    listenFd_ = -1;
+    NTA_THROW << "RemoteLink: can't listen on port " << port << ": " << strerror(error);
+  }
+
+  struct sockaddr_storage bound;
+  socklen_t len = sizeof(bound);
+  getsockname(listenFd_, reinterpret_cast<struct sockaddr *>(&bound), &len);
+  port_ = ntohs(bound.ss_family == AF_INET6 ? reinterpret_cast<struct sockaddr_in6 *>(&bound)->sin6_port
+                                            : reinterpret_cast<struct sockaddr_in *>(&bound)->sin_port);
+#endif
+}
+
+
+RemoteLink::RemoteLink(const std::string &host, UInt16 port, UInt32 timeoutMs) : port_(port) {
+#if defined(NTA_OS_WINDOWS)
+  NTA_THROW << "RemoteLink: not available on Windows";
+#else
+  struct addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo *addrs = nullptr;
+  const int error = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addrs);
+  NTA_CHECK(error == 0) << "RemoteLink: can't resolve " << host << ": " << gai_strerror(error);
+
+  // The receiving end may not be listening yet, retry until the deadline.
+  const auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+  while (fd_ < 0) {
+    for (struct addrinfo *a = addrs; a != nullptr && fd_ < 0; a = a->ai_next) {
+      const int fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+      if (fd < 0)
+        continue;
+      if (connect(fd, a->ai_addr, a->ai_addrlen) == 0)
+        fd_ = fd;
+      else
+        ::close(fd);
+    }
+    if (fd_ < 0) {
+      if (Clock::now() >= deadline) {
+        freeaddrinfo(addrs);
+        NTA_THROW << "RemoteLink: nobody listened on " << host << ":" << port << " within " << timeoutMs << " ms";
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+  freeaddrinfo(addrs);
+  setNoDelay(fd_);
+#endif
+}
+
+
+RemoteLink::~RemoteLink() {
+#if !defined(NTA_OS_WINDOWS)
+  if (fd_ >= 0)
+    ::close(fd_);
+  if (listenFd_ >= 0)
+    ::close(listenFd_);
+#endif
+}
+
+
+bool RemoteLink::accept_(UInt32 timeoutMs) {
+#if !defined(NTA_OS_WINDOWS)
+  if (!waitFor(listenFd_, POLLIN, Clock::now() + std::chrono::milliseconds(timeoutMs)))
+    return false;
+  fd_ = ::accept(listenFd_, nullptr, nullptr);
+  NTA_CHECK(fd_ >= 0) << "RemoteLink: accept on port " << port_ << " failed: " << strerror(errno);
+  setNoDelay(fd_);
+  // A single sender per link.
+  ::close(listenFd_);
+  listenFd_ = -1;
+#endif
+  return true;
+}
+
+
+bool RemoteLink::write_(const char *data, size_t bytes, UInt32 timeoutMs) {
+#if !defined(NTA_OS_WINDOWS)
+  const auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+  const size_t wanted = bytes;
+  while (bytes > 0u) {
+    const ssize_t n = ::send(fd_, data, bytes, SEND_FLAGS | MSG_DONTWAIT);
+    if (n > 0) {
+      data += n;
+      bytes -= static_cast<size_t>(n);
+      bytesSent_ += static_cast<UInt64>(n);
+    } else if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+      if (!waitFor(fd_, POLLOUT, deadline)) {
+        NTA_CHECK(bytes == wanted)
+            << "RemoteLink: a frame to port " << port_ << " could not be sent in full within " << timeoutMs << " ms";
+        return false;
+      }
+    } else {
+      NTA_THROW << "RemoteLink: send to port " << port_ << " failed: " << strerror(errno);
+    }
+  }
+#endif
+  return true;
+}
+
+
+bool RemoteLink::read_(char *data, size_t bytes, UInt32 timeoutMs) {
+#if !defined(NTA_OS_WINDOWS)
+  const auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+  const size_t wanted = bytes;
+  while (bytes > 0u) {
+    const ssize_t n = ::recv(fd_, data, bytes, MSG_DONTWAIT);
+    if (n > 0) {
+      data += n;
+      bytes -= static_cast<size_t>(n);
+      bytesReceived_ += static_cast<UInt64>(n);
+    } else if (n == 0) {
+      NTA_THROW << "RemoteLink: the sender on port " << port_ << " closed the connection";
+    } else if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+      if (!waitFor(fd_, POLLIN, deadline)) {
+        // Half a frame would leave the stream out of step.
+        NTA_CHECK(bytes == wanted)
+            << "RemoteLink: a frame on port " << port_ << " did not arrive in full within " << timeoutMs << " ms";
+        return false;
+      }
+    } else {
+      NTA_THROW << "RemoteLink: receive on port " << port_ << " failed: " << strerror(errno);
+    }
+  }
+#endif
+  return true;
+}
+
+
+bool RemoteLink::send(const Array &a, UInt32 timeoutMs) {
+  NTA_CHECK(fd_ >= 0 && listenFd_ < 0) << "RemoteLink: send() on the receiving end";
+  const NTA_BasicType type = a.getType();
+  NTA_CHECK(type != NTA_BasicType_Str) << "RemoteLink: Str arrays are not plain data";
+
+  FrameHeader header;
+  header.magic = MAGIC;
+  header.type = static_cast<UInt32>(type);
+  if (type == NTA_BasicType_SDR) {
+    const SDR &sdr = a.getSDR();
+    NTA_CHECK(sdr.dimensions.size() <= MAX_DIMS)
+        << "RemoteLink: SDRs of more than " << MAX_DIMS << " dimensions are not supported";
+    const std::vector<uint8_t> bytes = SDR::encodeSparse(sdr.getSparse());
+    header.numDims = static_cast<UInt32>(sdr.dimensions.size());
+    header.payloadBytes = static_cast<UInt32>(bytes.size());
+    buffer_.resize(sizeof(header) + header.numDims * sizeof(UInt32) + bytes.size());
+    char *p = buffer_.data() + sizeof(header);
+    for (const UInt dim : sdr.dimensions) {
+      const UInt32 d = static_cast<UInt32>(dim);
+      std::memcpy(p, &d, sizeof(d));
+      p += sizeof(d);
+    }
+    std::memcpy(p, bytes.data(), bytes.size());
+  } else {
+    const size_t bytes = a.getCount() * BasicType::getSize(type);
+    header.numDims = 0u;
+    header.payloadBytes = static_cast<UInt32>(bytes);
+    buffer_.resize(sizeof(header) + bytes);
+    std::memcpy(buffer_.data() + sizeof(header), a.getBuffer(), bytes);
+  }
+  std::memcpy(buffer_.data(), &header, sizeof(header));
+  return write_(buffer_.data(), buffer_.size(), timeoutMs);
+}
+
+
+bool RemoteLink::receive(Array &a, UInt32 timeoutMs) {
+  const auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+  if (fd_ < 0 && !accept_(timeoutMs))
+    return false;
+
+  FrameHeader header;
+  if (!read_(reinterpret_cast<char *>(&header), sizeof(header), static_cast<UInt32>(msLeft(deadline))))
+    return false;
+  NTA_CHECK(header.magic == MAGIC) << "RemoteLink: corrupt frame on port " << port_;
+  NTA_CHECK(header.numDims <= MAX_DIMS) << "RemoteLink: corrupt frame on port " << port_;
+  // The rest of the frame is on its way, wait for it in full.
+  buffer_.resize(header.numDims * sizeof(UInt32) + header.payloadBytes);
+  NTA_CHECK(buffer_.empty() || read_(buffer_.data(), buffer_.size(), timeoutMs))
+      << "RemoteLink: a frame on port " << port_ << " did not arrive in full within " << timeoutMs << " ms";
+
+  const NTA_BasicType type = static_cast<NTA_BasicType>(header.type);
+  NTA_CHECK(type == a.getType())
+      << "RemoteLink on port " << port_ << ": received " << BasicType::getName(type)
+      << ", expected " << BasicType::getName(a.getType());
+  if (type == NTA_BasicType_SDR) {
+    SDR &sdr = a.getSDR();
+    UInt size = 1u;
+    for (UInt32 d = 0u; d < header.numDims; d++) {
+      UInt32 dim;
+      std::memcpy(&dim, buffer_.data() + d * sizeof(UInt32), sizeof(dim));
+      size *= dim;
+    }
+    NTA_CHECK(size == sdr.size)
+        << "RemoteLink on port " << port_ << ": received an SDR of size " << size << ", expected " << sdr.size;
+    const char *payload = buffer_.data() + header.numDims * sizeof(UInt32);
+    SDR_sparse_t sparse = SDR::decodeSparse(std::vector<uint8_t>(payload, payload + header.payloadBytes));
+    NTA_CHECK(sparse.empty() || sparse.back() < sdr.size) << "RemoteLink on port " << port_ << ": corrupt SDR";
+    sdr.setSparse(sparse);
+  } else {
+    const size_t bytes = a.getCount() * BasicType::getSize(type);
+    NTA_CHECK(header.payloadBytes == bytes)
+        << "RemoteLink on port " << port_ << ": received " << header.payloadBytes << " bytes, expected " << bytes;
+    std::memcpy(a.getBuffer(), buffer_.data(), bytes);
+  }
+  return true;
+}
+
+} // namespace htm
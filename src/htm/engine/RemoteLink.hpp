@@ -0,0 +1,113 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * A stream of Arrays over TCP, between Networks on different hosts
+ */
+
+#ifndef NTA_REMOTE_LINK_HPP
+#define NTA_REMOTE_LINK_HPP
+
+#include <string>
+#include <vector>
+
+#include <htm/ntypes/Array.hpp>
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * @Responsibility
+ * Passes Arrays from a Network on one host to a Network on another.
+ *
+ * @Description
+ * One TCP connection, from the sending end to the receiving end.  The
+ * receiving end listens on a port, the sending end connects to it.  Each
+ * Array is one frame: its type and dimensions, then an SDR as its sparse
+ * indices in the compact encoding of SDR::encodeSparse(), a numeric buffer
+ * as it is.  Both hosts must have the same byte order.  Str arrays are not
+ * supported.
+ *
+ * Frames queue up in the socket buffers, so a sender does not wait for the
+ * receiver to compute, and a receiver whose data was sent a few computes
+ * earlier (a delayed link) does not wait for the network.
+ *
+ * Not available on Windows.
+ *
+ * Example Usage:
+ *    // host B
+ *    RemoteLink in(9000);
+ *    in.receive(sdrArray, 10000);
+ *
+ *    // host A
+ *    RemoteLink out("hostB", 9000, 10000);
+ *    out.send(sdrArray, 10000);
+ */
+class RemoteLink {
+public:
+  /**
+   * The receiving end, listens on the port.  The sending end is accepted by
+   * the first receive().
+   * @param port - 0 picks a free port, see getPort().
+   */
+  explicit RemoteLink(UInt16 port);
+
+  /**
+   * The sending end, connects to the receiving end on host:port.
+   * @param timeoutMs - how long to retry while the receiving end is not listening yet.
+   */
+  RemoteLink(const std::string &host, UInt16 port, UInt32 timeoutMs);
+
+  ~RemoteLink();
+  RemoteLink(const RemoteLink &) = delete;
+  RemoteLink &operator=(const RemoteLink &) = delete;
+
+  /**
+   * Send the Array.  Waits up to timeoutMs while the socket buffers are full.
+   * @returns false on timeout.
+   */
+  bool send(const Array &a, UInt32 timeoutMs);
+
+  /**
+   * Receive the next Array into a, which must have the same type and size.
+   * Waits up to timeoutMs for the sender.
+   * @returns false on timeout.
+   */
+  bool receive(Array &a, UInt32 timeoutMs);
+
+  /** The port listened on, for the receiving end. */
+  UInt16 getPort() const { return port_; }
+
+  UInt64 getBytesSent() const { return bytesSent_; }
+  UInt64 getBytesReceived() const { return bytesReceived_; }
+
+private:
+  bool accept_(UInt32 timeoutMs);
+  bool write_(const char *data, size_t bytes, UInt32 timeoutMs);
+  bool read_(char *data, size_t bytes, UInt32 timeoutMs);
+
+  int listenFd_ = -1;
+  int fd_ = -1;
+  UInt16 port_ = 0u;
+  UInt64 bytesSent_ = 0u;
+  UInt64 bytesReceived_ = 0u;
+  std::vector<char> buffer_; // a frame
+};
+
+} // namespace htm
+
+#endif // NTA_REMOTE_LINK_HPP
@@ -0,0 +1,427 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of SharedMemoryRing
+ */
+
+#include <algorithm> // max, copy
+#include <atomic>
+#include <chrono>
+#include <climits> // INT_MAX
+#include <cstring> // memcpy, strerror
+#include <new>     // placement new
+#include <thread>
+
+#if !defined(NTA_OS_WINDOWS)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
+#include <htm/engine/SharedMemoryRing.hpp>
+#include <htm/ntypes/BasicType.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+// Lives at the start of the shared memory, the slots follow.
+struct SharedMemoryRing::Header {
+  std::atomic<UInt64> magic;  // set last by the creator
+  UInt32 slots;
+  UInt32 broadcast;
+  UInt64 slotBytes;
+
+  // Counters of slots written and read; they wrap, slots is a power of 2.
+  alignas(64) std::atomic<UInt32> head;
+  std::atomic<UInt32> readerWaiting;
+  alignas(64) std::atomic<UInt32> tail;
+  std::atomic<UInt32> writerWaiting;
+
+  // Of a broadcast ring: the Arrays written, it does not wrap.
+  alignas(64) std::atomic<UInt64> published;
+};
+
+namespace {
+  const UInt64 MAGIC = 0x48544d52696e6732ull; // "HTMRing2"
+  const size_t ALIGN = 64u;
+  const UInt32 MAX_DIMS = 8u;
+
+  // Each slot holds one Array: this header, then the buffer or the sparse indices.
+  struct Frame {
+    UInt32 type;
+    UInt32 numDims; // 0 unless an SDR
+    UInt64 count;   // elements, or active bits of an SDR
+    UInt32 dims[MAX_DIMS];
+  };
+
+  // Each slot starts with its sequence word, 2n+1 while Array n is written
+  // into it and 2n+2 once it is there; only a broadcast ring uses it.
+  const size_t SEQUENCE_BYTES = sizeof(UInt64);
+
+  static_assert(sizeof(std::atomic<UInt32>) == sizeof(UInt32), "futex needs a plain 32 bit word");
+  static_assert(std::atomic<UInt64>::is_always_lock_free, "the sequence words are shared between processes");
+  static_assert(sizeof(Frame) % sizeof(UInt64) == 0u, "the payload must stay aligned");
+
+  size_t roundUp(const size_t n, const size_t align)
+    { return (n + align - 1u) / align * align; }
+
+  const size_t HEADER_BYTES = 5u * ALIGN; // the Header, padded
+
+  // Sleep until word is no longer value, at most timeoutMs.  The waiting
+  // counter lets the other side skip the wake up call when nobody sleeps.
+  bool waitForChange(std::atomic<UInt32> &word, const UInt32 value,
+                     std::atomic<UInt32> &waiting, const UInt32 timeoutMs) {
+    if (word.load() != value)
+      return true;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    waiting.fetch_add(1u);
+    bool changed = true;
+    while (word.load() == value) {
+      const auto now = std::chrono::steady_clock::now();
+      if (now >= deadline) {
+        changed = false;
+        break;
+      }
+#if defined(__linux__)
+      const auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count();
+      struct timespec ts;
+      ts.tv_sec = static_cast<time_t>(left / 1000000000);
+      ts.tv_nsec = static_cast<long>(left % 1000000000);
+      // Shared (not FUTEX_PRIVATE) since the word is in another process' mapping too.
+      syscall(SYS_futex, reinterpret_cast<UInt32 *>(&word), FUTEX_WAIT, value, &ts, nullptr, 0);
+#else
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+#endif
+    }
+    waiting.fetch_sub(1u);
+    return changed;
+  }
+
+  void publish(std::atomic<UInt32> &word, std::atomic<UInt32> &waiting, const int wake = 1) {
+    word.fetch_add(1u);
+#if defined(__linux__)
+    if (waiting.load() != 0u)
+      syscall(SYS_futex, reinterpret_cast<UInt32 *>(&word), FUTEX_WAKE, wake, nullptr, nullptr, 0);
+#else
+    (void)waiting;
+    (void)wake;
+#endif
+  }
+
+  std::atomic<UInt64> &sequence(char *slot) { return *reinterpret_cast<std::atomic<UInt64> *>(slot); }
+  const std::atomic<UInt64> &sequence(const char *slot)
+    { return *reinterpret_cast<const std::atomic<UInt64> *>(slot); }
+
+  // The bytes of the Array's payload and where they are.
+  size_t payloadBytes(const Array &a) {
+    if (a.getType() == NTA_BasicType_SDR)
+      return a.getSDR().getSparse().size() * sizeof(ElemSparse);
+    return a.getCount() * BasicType::getSize(a.getType());
+  }
+
+  void writeFrame(char *slot, const Array &a, const size_t bytes) {
+    const NTA_BasicType type = a.getType();
+    Frame *frame = reinterpret_cast<Frame *>(slot);
+    frame->type = static_cast<UInt32>(type);
+    if (type == NTA_BasicType_SDR) {
+      const SDR &sdr = a.getSDR();
+      const SDR_sparse_t &sparse = sdr.getSparse();
+      frame->numDims = static_cast<UInt32>(sdr.dimensions.size());
+      std::copy(sdr.dimensions.begin(), sdr.dimensions.end(), frame->dims);
+      frame->count = sparse.size();
+      std::memcpy(slot + sizeof(Frame), sparse.data(), bytes);
+    } else {
+      frame->numDims = 0u;
+      frame->count = a.getCount();
+      std::memcpy(slot + sizeof(Frame), a.getBuffer(), bytes);
+    }
+  }
+
+  void readFrame(const char *slot, Array &a, const std::string &name) {
+    const Frame *frame = reinterpret_cast<const Frame *>(slot);
+    const NTA_BasicType type = static_cast<NTA_BasicType>(frame->type);
+    NTA_CHECK(type == a.getType())
+        << "SharedMemoryRing " << name << ": received " << BasicType::getName(type)
+        << ", expected " << BasicType::getName(a.getType());
+    if (type == NTA_BasicType_SDR) {
+      SDR &sdr = a.getSDR();
+      UInt size = 1u;
+      for (UInt32 d = 0u; d < frame->numDims; d++)
+        size *= frame->dims[d];
+      NTA_CHECK(size == sdr.size)
+          << "SharedMemoryRing " << name << ": received an SDR of size " << size << ", expected " << sdr.size;
+      sdr.setSparse(reinterpret_cast<const ElemSparse *>(slot + sizeof(Frame)), static_cast<UInt>(frame->count));
+    } else {
+      NTA_CHECK(frame->count == a.getCount())
+          << "SharedMemoryRing " << name << ": received " << frame->count << " elements, expected " << a.getCount();
+      std::memcpy(a.getBuffer(), slot + sizeof(Frame), frame->count * BasicType::getSize(type));
+    }
+  }
+} // namespace
+
+
+SharedMemoryRing::SharedMemoryRing(const std::string &name, UInt32 slots, size_t slotBytes, bool broadcast)
+    : name_(name), owner_(true), broadcast_(broadcast) {
+#if defined(NTA_OS_WINDOWS)
+  NTA_THROW << "SharedMemoryRing: not available on Windows";
+#else
+  NTA_CHECK(name.size() > 1u && name[0] == '/' && name.find('/', 1u) == std::string::npos)
+      << "SharedMemoryRing: the name must be '/' and a name without slashes, got '" << name << "'";
+  NTA_CHECK(slots > 0u && slots <= (1u << 20)) << "SharedMemoryRing: bad number of slots " << slots;
+  static_assert(sizeof(Header) <= HEADER_BYTES, "the Header must fit");
+  slots_ = 1u;
+  while (slots_ < slots)
+    slots_ <<= 1;
+  slotBytes_ = roundUp(SEQUENCE_BYTES + std::max(slotBytes, sizeof(Frame)), ALIGN);
+  mappedBytes_ = HEADER_BYTES + slots_ * slotBytes_;
+
+  shm_unlink(name.c_str()); // left over by a writer which crashed
+  const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  NTA_CHECK(fd >= 0) << "SharedMemoryRing: can't create " << name << ": " << strerror(errno);
+  void *p = MAP_FAILED;
+  if (ftruncate(fd, static_cast<off_t>(mappedBytes_)) == 0)
+    p = mmap(nullptr, mappedBytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  const int error = errno;
+  ::close(fd);
+  if (p == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    NTA_THROW << "SharedMemoryRing: can't map " << mappedBytes_ << " bytes for " << name << ": " << strerror(error);
+  }
+
+  header_ = new (p) Header();
+  header_->slots = slots_;
+  header_->broadcast = broadcast_ ? 1u : 0u;
+  header_->slotBytes = slotBytes_;
+  header_->published = 0u;
+  header_->head = 0u;
+  header_->tail = 0u;
+  header_->readerWaiting = 0u;
+  header_->writerWaiting = 0u;
+  slotData_ = static_cast<char *>(p) + HEADER_BYTES;
+  for (UInt32 i = 0u; i < slots_; i++)
+    new (slotData_ + i * slotBytes_) std::atomic<UInt64>(0u);
+  header_->magic.store(MAGIC, std::memory_order_release);
+#endif
+}
+
+
+SharedMemoryRing::SharedMemoryRing(const std::string &name, UInt32 timeoutMs)
+    : name_(name), owner_(false) {
+#if defined(NTA_OS_WINDOWS)
+  NTA_THROW << "SharedMemoryRing: not available on Windows";
+#else
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+  while (true) {
+    const int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd >= 0) {
+      struct stat st;
+      void *p = MAP_FAILED;
+      size_t bytes = 0u;
+      if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= HEADER_BYTES) {
+        bytes = static_cast<size_t>(st.st_size);
+        p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      }
+      ::close(fd);
+      if (p != MAP_FAILED) {
+        Header *header = static_cast<Header *>(p);
+        if (header->magic.load(std::memory_order_acquire) == MAGIC) {
+          header_ = header;
+          slots_ = header->slots;
+          slotBytes_ = static_cast<size_t>(header->slotBytes);
+          broadcast_ = header->broadcast != 0u;
+          mappedBytes_ = bytes;
+          slotData_ = static_cast<char *>(p) + HEADER_BYTES;
+          NTA_CHECK(mappedBytes_ >= HEADER_BYTES + slots_ * slotBytes_)
+              << "SharedMemoryRing: " << name << " is truncated";
+          if (broadcast_) {
+            // Start with the oldest Array still in the ring.
+            const UInt64 published = header_->published.load(std::memory_order_acquire);
+            next_ = published > slots_ ? published - slots_ : 0u;
+            scratch_.resize(slotBytes_ - SEQUENCE_BYTES);
+          }
+          return;
+        }
+        munmap(p, bytes); // still being created
+      }
+    }
+    NTA_CHECK(std::chrono::steady_clock::now() < deadline)
+        << "SharedMemoryRing: nobody created " << name << " within " << timeoutMs << " ms";
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+#endif
+}
+
+
+SharedMemoryRing::~SharedMemoryRing() {
+#if !defined(NTA_OS_WINDOWS)
+  if (header_ != nullptr)
+    munmap(header_, mappedBytes_);
+  if (owner_)
+    shm_unlink(name_.c_str());
+#endif
+}
+
+
+UInt32 SharedMemoryRing::size() const {
+  if (broadcast_) {
+    const UInt64 published = header_->published.load();
+    return static_cast<UInt32>(std::min<UInt64>(published - std::min(next_, published), slots_));
+  }
+  return header_->head.load() - header_->tail.load();
+}
+
+
+size_t SharedMemoryRing::frameBytes(const Array &a) {
+  NTA_CHECK(a.getType() != NTA_BasicType_Str) << "SharedMemoryRing: Str arrays are not plain data";
+  if (a.getType() == NTA_BasicType_SDR)
+    return sizeof(Frame) + a.getSDR().size * sizeof(ElemSparse);
+  return sizeof(Frame) + a.getCount() * BasicType::getSize(a.getType());
+}
+
+
+char *SharedMemoryRing::beginWrite_(UInt32 timeoutMs) {
+  const UInt32 head = header_->head.load(std::memory_order_relaxed); // only the writer changes it
+  const UInt32 tail = header_->tail.load(std::memory_order_acquire);
+  if (head - tail == slots_) {
+    // Full, any read frees a slot.
+    if (!waitForChange(header_->tail, tail, header_->writerWaiting, timeoutMs))
+      return nullptr;
+  }
+  return slotData_ + (head & (slots_ - 1u)) * slotBytes_ + SEQUENCE_BYTES;
+}
+
+void SharedMemoryRing::commitWrite_() { publish(header_->head, header_->readerWaiting); }
+
+const char *SharedMemoryRing::beginRead_(UInt32 timeoutMs) {
+  const UInt32 tail = header_->tail.load(std::memory_order_relaxed); // only the reader changes it
+  const UInt32 head = header_->head.load(std::memory_order_acquire);
+  if (head == tail) {
+    if (!waitForChange(header_->head, head, header_->readerWaiting, timeoutMs))
+      return nullptr;
+  }
+  return slotData_ + (tail & (slots_ - 1u)) * slotBytes_ + SEQUENCE_BYTES;
+}
+
+void SharedMemoryRing::commitRead_() { publish(header_->tail, header_->writerWaiting); }
+
+
+bool SharedMemoryRing::push(const Array &a, UInt32 timeoutMs) {
+  const NTA_BasicType type = a.getType();
+  NTA_CHECK(type != NTA_BasicType_Str) << "SharedMemoryRing: Str arrays are not plain data";
+  const size_t bytes = payloadBytes(a);
+  NTA_CHECK(SEQUENCE_BYTES + sizeof(Frame) + bytes <= slotBytes_)
+      << "SharedMemoryRing " << name_ << ": an Array of " << bytes << " bytes does not fit its "
+      << slotBytes_ << " byte slots";
+  if (type == NTA_BasicType_SDR) {
+    NTA_CHECK(a.getSDR().dimensions.size() <= MAX_DIMS)
+        << "SharedMemoryRing: SDRs of more than " << MAX_DIMS << " dimensions are not supported";
+  }
+
+  if (broadcast_) {
+    // Never waits: a reader which is a ring behind loses the oldest Array.
+    const UInt64 n = header_->published.load(std::memory_order_relaxed); // only the writer changes it
+    char *slot = slotData_ + (n & (slots_ - 1u)) * slotBytes_;
+    sequence(slot).store(2u * n + 1u, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    writeFrame(slot + SEQUENCE_BYTES, a, bytes);
+    sequence(slot).store(2u * n + 2u, std::memory_order_release);
+    header_->published.store(n + 1u, std::memory_order_release);
+    publish(header_->head, header_->readerWaiting, INT_MAX);
+    return true;
+  }
+  char *slot = beginWrite_(timeoutMs);
+  if (slot == nullptr)
+    return false;
+  writeFrame(slot, a, bytes);
+  commitWrite_();
+  return true;
+}
+
+
+bool SharedMemoryRing::pop(Array &a, UInt32 timeoutMs) {
+  if (broadcast_)
+    return popBroadcast_(a, timeoutMs);
+  const char *slot = beginRead_(timeoutMs);
+  if (slot == nullptr)
+    return false;
+  try {
+    readFrame(slot, a, name_);
+  } catch (...) {
+    commitRead_(); // drop the mismatched Array, else the ring is stuck on it
+    throw;
+  }
+  commitRead_();
+  return true;
+}
+
+
+bool SharedMemoryRing::popBroadcast_(Array &a, UInt32 timeoutMs) {
+  NTA_CHECK(!owner_) << "SharedMemoryRing " << name_ << ": the writer of a broadcast ring can't read it";
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+  while (true) {
+    const UInt32 head = header_->head.load(std::memory_order_acquire);
+    const UInt64 published = header_->published.load(std::memory_order_acquire);
+    if (published - next_ > slots_) {
+      lost_ += published - slots_ - next_; // overwritten
+      next_ = published - slots_;
+    }
+    if (next_ == published) {
+      const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+          deadline - std::chrono::steady_clock::now()).count();
+      if (!waitForChange(header_->head, head, header_->readerWaiting, left > 0 ? static_cast<UInt32>(left) : 0u))
+        return false;
+      continue;
+    }
+
+    // Copy the slot, then check the writer did not start on it meanwhile:
+    // first the Frame, which gives the size of the payload.
+    const char *slot = slotData_ + (next_ & (slots_ - 1u)) * slotBytes_;
+    const UInt64 expected = 2u * next_ + 2u;
+    const auto copied = [&](size_t from, size_t bytes) {
+      if (sequence(slot).load(std::memory_order_acquire) != expected)
+        return false;
+      std::memcpy(scratch_.data() + from, slot + SEQUENCE_BYTES + from, bytes);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      return sequence(slot).load(std::memory_order_relaxed) == expected;
+    };
+    bool ok = copied(0u, sizeof(Frame));
+    if (ok) {
+      const Frame *frame = reinterpret_cast<const Frame *>(scratch_.data());
+      const NTA_BasicType type = static_cast<NTA_BasicType>(frame->type);
+      const size_t bytes = type == NTA_BasicType_SDR ? frame->count * sizeof(ElemSparse)
+                                                     : frame->count * BasicType::getSize(type);
+      ok = sizeof(Frame) + bytes <= scratch_.size() && copied(sizeof(Frame), bytes);
+    }
+    next_++;
+    if (!ok) {
+      lost_++;
+      continue;
+    }
+    readFrame(scratch_.data(), a, name_);
+    return true;
+  }
+}
+
+} // namespace htm
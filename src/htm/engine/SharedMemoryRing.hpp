@@ -0,0 +1,152 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Single producer, single consumer ring of Arrays in shared memory
+ */
+
+#ifndef NTA_SHARED_MEMORY_RING_HPP
+#define NTA_SHARED_MEMORY_RING_HPP
+
+#include <string>
+#include <vector>
+
+#include <htm/ntypes/Array.hpp>
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * @Responsibility
+ * Passes Arrays from one process to another on the same host.
+ *
+ * @Description
+ * A POSIX shared memory object holding a ring of fixed size slots, one
+ * Array per slot.  One process creates it and writes, one other process
+ * opens it by name and reads, in order.  The writer blocks while all slots
+ * are full, the reader while all are empty; on Linux they sleep on a futex
+ * in the shared memory, elsewhere they poll.
+ *
+ * Arrays of plain numeric types are copied as they are, an SDR as its
+ * dimensions and sparse indices; there is no serialization.  Str arrays are
+ * not supported.
+ *
+ * A broadcast ring is for one writer and any number of readers, eg. the
+ * dashboards and alerting services watching the anomaly scores: the writer
+ * never waits, it overwrites the oldest slot; each reader follows the
+ * sequence numbers of the Arrays on its own, and a reader which falls more
+ * than a ring behind skips the Arrays it lost (see lost()).  Reading one
+ * that is there costs no system call and no lock, a slot is checked with
+ * its sequence number before and after the copy.
+ *
+ * The creator owns the name: it removes a stale object of that name when it
+ * starts and unlinks the name when it is destroyed.  Not available on Windows.
+ *
+ * Example Usage:
+ *    // process A
+ *    SharedMemoryRing ring("/htm_sp_to_tm", 4, SharedMemoryRing::frameBytes(sdrArray));
+ *    ring.push(sdrArray, 10000);
+ *
+ *    // process B, waits up to 10 seconds for process A to create the ring
+ *    SharedMemoryRing ring("/htm_sp_to_tm", 10000);
+ *    ring.pop(sdrArray, 10000);
+ *
+ *    // broadcast: the writer, then in each of the readers
+ *    SharedMemoryRing scores("/htm_scores", 64, SharedMemoryRing::frameBytes(scoreArray), true);
+ *    SharedMemoryRing scores("/htm_scores", 10000);
+ *    while (scores.pop(scoreArray, 0)) { ... }
+ */
+class SharedMemoryRing {
+public:
+  /**
+   * Create the ring, for the writer.
+   * @param name - of the shared memory object, "/" and a name without slashes.
+   * @param slots - how many Arrays the writer may be ahead of the reader.
+   * @param slotBytes - room for one Array, see frameBytes().
+   * @param broadcast - for any number of readers, see above.
+   */
+  SharedMemoryRing(const std::string &name, UInt32 slots, size_t slotBytes, bool broadcast = false);
+
+  /**
+   * Open the ring created by another process, for the reader.
+   * @param timeoutMs - how long to wait for the ring to be created.
+   */
+  SharedMemoryRing(const std::string &name, UInt32 timeoutMs);
+
+  ~SharedMemoryRing();
+  SharedMemoryRing(const SharedMemoryRing &) = delete;
+  SharedMemoryRing &operator=(const SharedMemoryRing &) = delete;
+
+  /**
+   * Copy the Array into the next slot.  Waits up to timeoutMs for a free slot,
+   * a broadcast ring does not wait.
+   * @returns false on timeout.
+   */
+  bool push(const Array &a, UInt32 timeoutMs);
+
+  /**
+   * Copy the oldest Array into a, which must have the same type and size,
+   * else it throws and the Array is dropped.
+   * Waits up to timeoutMs for the writer.
+   * @returns false on timeout.
+   */
+  bool pop(Array &a, UInt32 timeoutMs);
+
+  /**
+   * The number of Arrays written and not read yet.  Of a broadcast ring, not
+   * read yet by this reader, at most the slots.
+   */
+  UInt32 size() const;
+
+  bool isBroadcast() const { return broadcast_; }
+
+  /** Of a broadcast ring: the Arrays this reader skipped since it fell behind. */
+  UInt64 lost() const { return lost_; }
+
+  UInt32 getSlots() const { return slots_; }
+  size_t getSlotBytes() const { return slotBytes_; }
+  const std::string &getName() const { return name_; }
+
+  /** The slot size needed for Arrays of the type and size of a. */
+  static size_t frameBytes(const Array &a);
+
+private:
+  struct Header;
+
+  // The raw slots: nullptr on timeout.  commit*() hands the slot over.
+  char *beginWrite_(UInt32 timeoutMs);
+  void commitWrite_();
+  const char *beginRead_(UInt32 timeoutMs);
+  void commitRead_();
+  bool popBroadcast_(Array &a, UInt32 timeoutMs);
+
+  std::string name_;
+  bool owner_;
+  Header *header_ = nullptr;
+  char *slotData_ = nullptr;
+  size_t mappedBytes_ = 0u;
+  UInt32 slots_ = 0u;
+  size_t slotBytes_ = 0u;
+  bool broadcast_ = false;
+  UInt64 next_ = 0u;          // broadcast reader: the sequence number to read
+  UInt64 lost_ = 0u;
+  std::vector<char> scratch_; // broadcast reader: a slot, copied before it is checked
+};
+
+} // namespace htm
+
+#endif // NTA_SHARED_MEMORY_RING_HPP
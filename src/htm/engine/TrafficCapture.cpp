@@ -0,0 +1,188 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the TrafficCapture and TrafficReplay classes
+ */
+
+#include <htm/engine/TrafficCapture.hpp>
+
+#include <cstring>
+
+#include <htm/ntypes/BasicType.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/utils/LatencyHistogram.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+namespace {
+const char CAPTURE_MAGIC[8] = {'H', 'T', 'M', 'C', 'A', 'P', 'T', 'R'};
+const UInt32 CAPTURE_VERSION = 1u;
+
+template <typename T> void appendPod(std::vector<char> &buf, const T &value) {
+  const char *p = reinterpret_cast<const char *>(&value);
+  buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+// 7 bit groups, low first, high bit set on all but the last byte.
+void appendVarint(std::vector<char> &buf, UInt64 value) {
+  while (value >= 0x80u) {
+    buf.push_back(static_cast<char>(value | 0x80u));
+    value >>= 7u;
+  }
+  buf.push_back(static_cast<char>(value));
+}
+} // namespace
+
+
+TrafficCapture::TrafficCapture(const std::string &path, const std::vector<std::string> &names,
+                               const std::vector<const Array *> &prototypes)
+    : last_(LatencyHistogram::now()), writer_(path, false) {
+  NTA_CHECK(names.size() == prototypes.size()) << "TrafficCapture: a prototype per source.";
+  std::vector<char> header(CAPTURE_MAGIC, CAPTURE_MAGIC + sizeof(CAPTURE_MAGIC));
+  appendPod(header, CAPTURE_VERSION);
+  appendPod(header, static_cast<UInt32>(names.size()));
+  for (size_t i = 0; i < names.size(); i++) {
+    const Array &a = *prototypes[i];
+    NTA_CHECK(a.getType() != NTA_BasicType_Str) << "TrafficCapture: source '" << names[i] << "' is a string.";
+    appendPod(header, static_cast<UInt32>(names[i].size()));
+    header.insert(header.end(), names[i].begin(), names[i].end());
+    appendPod(header, static_cast<UInt32>(a.getType()));
+    const std::vector<UInt> dimensions = a.getType() == NTA_BasicType_SDR
+                                           ? a.getSDR().dimensions
+                                           : std::vector<UInt>{static_cast<UInt>(a.getCount())};
+    appendPod(header, static_cast<UInt32>(dimensions.size()));
+    for (const UInt d : dimensions)
+      appendPod(header, static_cast<UInt32>(d));
+    types_.push_back(a.getType());
+    counts_.push_back(a.getCount());
+  }
+  writer_.write(header.data(), header.size());
+}
+
+
+void TrafficCapture::record(const std::vector<const Array *> &data) {
+  NTA_ASSERT(data.size() == types_.size());
+  const UInt64 now = LatencyHistogram::now();
+  buf_.clear();
+  appendVarint(buf_, now - last_);
+  last_ = now;
+  for (size_t i = 0; i < data.size(); i++) {
+    const Array &a = *data[i];
+    NTA_CHECK(a.getType() == types_[i] && a.getCount() == counts_[i])
+        << "TrafficCapture: source " << i << " changed its type or size.";
+    if (types_[i] == NTA_BasicType_SDR) {
+      // The encoding of SDR::encodeSparse(), without its temporary vector.
+      sparse_.clear();
+      UInt32 previous = 0u;
+      for (const UInt32 idx : a.getSDR().getSparse()) {
+        appendVarint(sparse_, idx - previous);
+        previous = idx;
+      }
+      appendVarint(buf_, sparse_.size());
+      buf_.insert(buf_.end(), sparse_.begin(), sparse_.end());
+    } else {
+      const char *p = static_cast<const char *>(a.getBuffer());
+      buf_.insert(buf_.end(), p, p + counts_[i] * BasicType::getSize(types_[i]));
+    }
+  }
+  writer_.write(buf_.data(), buf_.size());
+  records_++;
+}
+
+
+TrafficReplay::TrafficReplay(const std::string &path) : path_(path), in_(path, std::ios::binary) {
+  NTA_CHECK(in_.is_open()) << "TrafficReplay: cannot open " << path;
+  const auto read = [&](void *p, size_t bytes) {
+    in_.read(static_cast<char *>(p), static_cast<std::streamsize>(bytes));
+    return static_cast<size_t>(in_.gcount()) == bytes;
+  };
+
+  char magic[sizeof(CAPTURE_MAGIC)];
+  UInt32 version = 0u, numSources = 0u;
+  NTA_CHECK(read(magic, sizeof(magic)) && std::memcmp(magic, CAPTURE_MAGIC, sizeof(magic)) == 0)
+      << "TrafficReplay: " << path << " is not a capture file.";
+  NTA_CHECK(read(&version, sizeof(version)) && version == CAPTURE_VERSION)
+      << "TrafficReplay: unsupported version " << version;
+  NTA_CHECK(read(&numSources, sizeof(numSources))) << "TrafficReplay: truncated header.";
+  for (UInt32 i = 0; i < numSources; i++) {
+    UInt32 length, type, numDims;
+    NTA_CHECK(read(&length, sizeof(length))) << "TrafficReplay: truncated header.";
+    std::string name(length, '\0');
+    NTA_CHECK(read(&name[0], length) && read(&type, sizeof(type)) && read(&numDims, sizeof(numDims)))
+        << "TrafficReplay: truncated header.";
+    std::vector<UInt> dimensions(numDims);
+    for (UInt &d : dimensions) {
+      UInt32 v;
+      NTA_CHECK(read(&v, sizeof(v))) << "TrafficReplay: truncated header.";
+      d = v;
+    }
+    Array a(static_cast<NTA_BasicType>(type));
+    if (a.getType() == NTA_BasicType_SDR) {
+      a.allocateBuffer(dimensions);
+    } else {
+      NTA_CHECK(numDims == 1u && a.getType() != NTA_BasicType_Str && BasicType::isValid(a.getType()))
+          << "TrafficReplay: source '" << name << "' has an unexpected type or shape.";
+      a.allocateBuffer(dimensions[0]);
+    }
+    names_.push_back(name);
+    data_.push_back(a);
+  }
+}
+
+
+bool TrafficReplay::readVarint_(UInt64 &value) {
+  value = 0u;
+  for (UInt shift = 0u; ; shift += 7u) {
+    const int c = in_.get();
+    if (c == std::char_traits<char>::eof()) {
+      NTA_CHECK(shift == 0u) << "TrafficReplay: truncated record in " << path_;
+      return false;
+    }
+    NTA_CHECK(shift < 64u) << "TrafficReplay: corrupt record in " << path_;
+    value |= static_cast<UInt64>(c & 0x7F) << shift;
+    if (c < 0x80)
+      return true;
+  }
+}
+
+
+bool TrafficReplay::next() {
+  if (!readVarint_(delay_))
+    return false; // the end of the log
+  for (Array &a : data_) {
+    if (a.getType() == NTA_BasicType_SDR) {
+      UInt64 bytes;
+      NTA_CHECK(readVarint_(bytes)) << "TrafficReplay: truncated record in " << path_;
+      sparse_.resize(bytes);
+      in_.read(reinterpret_cast<char *>(sparse_.data()), static_cast<std::streamsize>(bytes));
+      NTA_CHECK(static_cast<UInt64>(in_.gcount()) == bytes) << "TrafficReplay: truncated record in " << path_;
+      SDR &sdr = a.getSDRNoRefresh();
+      SDR_sparse_t sparse = SDR::decodeSparse(sparse_);
+      NTA_CHECK(sparse.empty() || sparse.back() < sdr.size) << "TrafficReplay: corrupt record in " << path_;
+      sdr.setSparse(sparse);
+    } else {
+      const size_t bytes = a.getCount() * BasicType::getSize(a.getType());
+      in_.read(static_cast<char *>(a.getBuffer()), static_cast<std::streamsize>(bytes));
+      NTA_CHECK(static_cast<size_t>(in_.gcount()) == bytes) << "TrafficReplay: truncated record in " << path_;
+    }
+  }
+  return true;
+}
+
+} // namespace htm
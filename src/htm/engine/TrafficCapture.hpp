@@ -0,0 +1,132 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the TrafficCapture and TrafficReplay classes
+ */
+
+#ifndef NTA_TRAFFIC_CAPTURE_HPP
+#define NTA_TRAFFIC_CAPTURE_HPP
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <htm/ntypes/Array.hpp>
+#include <htm/os/AsyncFileWriter.hpp>
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * A log of the data which entered a Network, one record per iteration: the
+ * data of its "INPUT" outputs (see RawInput), however they were set, with
+ * the time between the records.  Network::startCapture() writes it from
+ * live traffic, Network::replayCapture() feeds it back into a Network, eg.
+ * a benchmark on the input distribution of production rather than on
+ * synthetic data.
+ *
+ * Recording only copies the data into a buffer, which a background thread
+ * writes to the file (see AsyncFileWriter); SDRs take their sparse indices
+ * in the compact encoding of SDR::encodeSparse(), typically 1-2 bytes per
+ * active bit.
+ *
+ * File layout, all in host byte order:
+ *   "HTMCAPTR", uint32 version (1), uint32 number of sources
+ *   per source: uint32 name length, name, uint32 type (NTA_BasicType),
+ *               uint32 number of dimensions, the uint32 dimensions
+ *               (an SDR; else 1 and the number of values)
+ *   records:    varint nanoseconds since the previous record (since the
+ *               capture began for the first), then per source an SDR as a
+ *               varint byte count and its encoded sparse indices, other
+ *               types as their values.
+ */
+class TrafficCapture {
+public:
+  /**
+   * @param path - the file, truncated.
+   * @param names - of the sources.
+   * @param prototypes - the type and size of the data of each source, Str
+   *   is not supported.
+   */
+  TrafficCapture(const std::string &path, const std::vector<std::string> &names,
+                 const std::vector<const Array *> &prototypes);
+
+  TrafficCapture(const TrafficCapture &) = delete;
+  TrafficCapture &operator=(const TrafficCapture &) = delete;
+
+  /** Append a record, data[i] of source i, of the type and size of its prototype. */
+  void record(const std::vector<const Array *> &data);
+
+  /** Writes the rest and closes the file. Called by the destructor. */
+  void close() { writer_.close(); }
+
+  UInt64 getRecords() const noexcept { return records_; }
+  const std::string &getPath() const noexcept { return writer_.getPath(); }
+
+private:
+  std::vector<NTA_BasicType> types_;
+  std::vector<size_t> counts_;
+  std::vector<char> buf_;    // one record, reused
+  std::vector<char> sparse_; // encoded sparse indices of an SDR, reused
+  UInt64 records_ = 0u;
+  UInt64 last_;              // time of the previous record
+  AsyncFileWriter writer_;
+};
+
+
+/**
+ * Reads a log of TrafficCapture, one record after the other.
+ *
+ * Example:
+ *    TrafficReplay replay("capture.bin");
+ *    while (replay.next()) {
+ *      const Array &value = replay[0]; // of replay.names()[0]
+ *    }
+ */
+class TrafficReplay {
+public:
+  explicit TrafficReplay(const std::string &path);
+
+  TrafficReplay(const TrafficReplay &) = delete;
+  TrafficReplay &operator=(const TrafficReplay &) = delete;
+
+  const std::vector<std::string> &names() const noexcept { return names_; }
+  size_t size() const noexcept { return names_.size(); }
+
+  /** Read the next record, false at the end of the log. */
+  bool next();
+
+  /** The data of source i in the current record. */
+  const Array &operator[](size_t source) const { return data_[source]; }
+  /** Nanoseconds between the previous record and the current one, when captured. */
+  UInt64 getDelay() const noexcept { return delay_; }
+
+private:
+  bool readVarint_(UInt64 &value);
+
+  std::string path_;
+  std::ifstream in_;
+  std::vector<std::string> names_;
+  std::vector<Array> data_;
+  std::vector<uint8_t> sparse_; // encoded, reused
+  UInt64 delay_ = 0u;
+};
+
+} // namespace htm
+
+#endif // NTA_TRAFFIC_CAPTURE_HPP
@@ -19,6 +19,7 @@
  * Implementation of the Watcher class
  */
 
+#include <cstring>
 #include <exception>
 #include <sstream>
 #include <string>
@@ -37,11 +38,76 @@
 
 namespace htm {
 
-Watcher::Watcher(std::string fileName) {
+namespace {
+const char BINARY_MAGIC[8] = {'H', 'T', 'M', 'W', 'A', 'T', 'C', 'H'};
+const UInt32 BINARY_VERSION = 1u;
+
+#pragma pack(push, 1)
+struct RecordHeader {
+  UInt64 iteration;
+  UInt32 watchID;
+  UInt16 type;
+  UInt16 encoding; // 0 raw values, 1 sparse indices
+  UInt64 size;
+  UInt64 count;
+};
+#pragma pack(pop)
+static_assert(sizeof(RecordHeader) == 32u, "watcher record header must be packed");
+
+template <typename T> void appendPod(std::vector<char> &buf, const T &value) {
+  const char *p = reinterpret_cast<const char *>(&value);
+  buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+void appendRecord(std::vector<char> &buf, UInt64 iteration, UInt32 watchID, NTA_BasicType type,
+                  UInt16 encoding, size_t size, const void *payload, size_t count, size_t elemSize) {
+  RecordHeader header{iteration, watchID, static_cast<UInt16>(type), encoding, size, count};
+  appendPod(buf, header);
+  const char *p = static_cast<const char *>(payload);
+  buf.insert(buf.end(), p, p + count * elemSize);
+}
+
+template <typename T> void writeValues(std::ostream &out, const char *p, size_t count) {
+  for (size_t j = 0; j < count; j++) {
+    T v;
+    std::memcpy(&v, p + j * sizeof(T), sizeof(T));
+    out << (j ? " " : "") << +v;  // + prints Byte and bool as numbers
+  }
+}
+
+// Records an Array: sparse indices for SDRs, the raw buffer otherwise.
+void appendArray(std::vector<char> &buf, UInt64 iteration, UInt32 watchID, const ArrayBase &a) {
+  if (a.getType() == NTA_BasicType_SDR) {
+    const SDR_sparse_t &sparse = a.getSDR().getSparse();
+    appendRecord(buf, iteration, watchID, NTA_BasicType_SDR, 1u, a.getCount(), sparse.data(),
+                 sparse.size(), sizeof(UInt32));
+  } else if (a.getType() == NTA_BasicType_Str) {
+    std::string text;
+    const std::string *s = static_cast<const std::string *>(a.getBuffer());
+    for (size_t j = 0; j < a.getCount(); j++)
+      text += (j ? " " : "") + s[j];
+    appendRecord(buf, iteration, watchID, NTA_BasicType_Str, 0u, text.size(), text.data(), text.size(), 1u);
+  } else {
+    appendRecord(buf, iteration, watchID, a.getType(), 0u, a.getCount(), a.getBuffer(), a.getCount(),
+                 BasicType::getSize(a.getType()));
+  }
+}
+} // namespace
+
+Watcher::Watcher(std::string fileName) : Watcher(fileName, TEXT) {}
+
+Watcher::Watcher(const std::string fileName, Format format, UInt32 sampleEvery) {
+    NTA_CHECK(sampleEvery > 0u) << "Watcher: sampleEvery must be at least 1.";
     std::string d = Path::getParent(fileName);
     if (!d.empty())
       Directory::create(d);
   data_.fileName = fileName;
+  data_.format = format;
+  data_.sampleEvery = sampleEvery;
+  if (format == BINARY) {
+    data_.writer.reset(new AsyncFileWriter(fileName, false));
+    return;
+  }
   try {
       data_.outStream.open(fileName.c_str());
   } catch (std::exception &) {
@@ -50,7 +116,7 @@ Watcher::Watcher(std::string fileName) {
   }
 
 Watcher::~Watcher() {
-  if (data_.outStream.is_open()) {
+  if (data_.outStream.is_open() || data_.writer) {
   	this->flushFile();
   	this->closeFile();
   }
@@ -88,6 +154,12 @@ UInt32 Watcher::watchOutput(std::string regionName,
 // add support for output of a different type than Real32
 void Watcher::watcherCallback(Network *net, UInt64 iteration, void *dataIn) {
   allData &data = *(static_cast<allData *>(dataIn));
+  if (data.sampleEvery > 1u && iteration % data.sampleEvery != 0u)
+    return;
+  if (data.format == BINARY) {
+    binaryCallback_(data, iteration);
+    return;
+  }
   // iterate through each watch
   for (auto &elem : data.watches) {
     watchData watch = elem;
@@ -384,7 +456,119 @@ void Watcher::watcherCallback(Network *net, UInt64 iteration, void *dataIn) {
   data.outStream.flush();
 }
 
+void Watcher::binaryCallback_(allData &data, UInt64 iteration) {
+  std::vector<char> &buf = data.record;
+  buf.clear();
+  for (const auto &watch : data.watches) {
+    if (watch.wType == output) {
+      appendArray(buf, iteration, watch.watchID, *watch.array);
+    } else if (watch.isArray) {
+      Array a(watch.varType);
+      watch.region->getParameterArray(watch.varName, a);
+      appendArray(buf, iteration, watch.watchID, a);
+    } else {
+      // a scalar parameter, as one value of its type
+      union {
+        Int32 i32; UInt32 u32; Int64 i64; UInt64 u64; Real32 r32; Real64 r64;
+      } v;
+      switch (watch.varType) {
+      case NTA_BasicType_Int32:  v.i32 = watch.region->getParameterInt32(watch.varName); break;
+      case NTA_BasicType_UInt32: v.u32 = watch.region->getParameterUInt32(watch.varName); break;
+      case NTA_BasicType_Int64:  v.i64 = watch.region->getParameterInt64(watch.varName); break;
+      case NTA_BasicType_UInt64: v.u64 = watch.region->getParameterUInt64(watch.varName); break;
+      case NTA_BasicType_Real32: v.r32 = watch.region->getParameterReal32(watch.varName); break;
+      case NTA_BasicType_Real64: v.r64 = watch.region->getParameterReal64(watch.varName); break;
+      case NTA_BasicType_Byte:
+      case NTA_BasicType_Str: {
+        const std::string s = watch.region->getParameterString(watch.varName);
+        appendRecord(buf, iteration, watch.watchID, NTA_BasicType_Str, 0u, s.size(), s.data(), s.size(), 1u);
+        continue;
+      }
+      default:
+        NTA_THROW << "Internal error.";
+      }
+      appendRecord(buf, iteration, watch.watchID, watch.varType, 0u, 1u, &v, 1u,
+                   BasicType::getSize(watch.varType));
+    }
+  }
+  data.writer->write(buf.data(), buf.size());
+}
+
+void Watcher::toCSV(const std::string &binaryFile, const std::string &csvFile) {
+  std::ifstream in(binaryFile, std::ios::binary);
+  NTA_CHECK(in.is_open()) << "Watcher::toCSV: cannot open " << binaryFile;
+  const auto read = [&](void *p, size_t bytes) {
+    in.read(static_cast<char *>(p), static_cast<std::streamsize>(bytes));
+    return static_cast<size_t>(in.gcount()) == bytes;
+  };
+
+  char magic[sizeof(BINARY_MAGIC)];
+  UInt32 version = 0u, numWatches = 0u;
+  NTA_CHECK(read(magic, sizeof(magic)) && std::memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0)
+      << "Watcher::toCSV: " << binaryFile << " is not a binary watcher file.";
+  NTA_CHECK(read(&version, sizeof(version)) && version == BINARY_VERSION)
+      << "Watcher::toCSV: unsupported version " << version;
+  NTA_CHECK(read(&numWatches, sizeof(numWatches))) << "Watcher::toCSV: truncated header.";
+  std::map<UInt32, std::string> names;
+  for (UInt32 i = 0; i < numWatches; i++) {
+    UInt32 id, type, length;
+    NTA_CHECK(read(&id, sizeof(id)) && read(&type, sizeof(type)) && read(&length, sizeof(length)))
+        << "Watcher::toCSV: truncated header.";
+    std::string name(length, '\0');
+    NTA_CHECK(read(&name[0], length)) << "Watcher::toCSV: truncated header.";
+    names[id] = name;
+  }
+
+  std::ofstream out(csvFile);
+  NTA_CHECK(out.is_open()) << "Watcher::toCSV: cannot open " << csvFile;
+  out << "iteration,watchID,name,type,size,values\n";
+  RecordHeader header;
+  std::vector<char> payload;
+  while (read(&header, sizeof(header))) {
+    const NTA_BasicType type = static_cast<NTA_BasicType>(header.type);
+    const size_t elemSize = header.encoding == 1u ? sizeof(UInt32)
+                          : type == NTA_BasicType_Str ? 1u : BasicType::getSize(type);
+    payload.resize(header.count * elemSize);
+    NTA_CHECK(read(payload.data(), payload.size())) << "Watcher::toCSV: truncated record.";
+
+    out << header.iteration << "," << header.watchID << "," << names[header.watchID] << ","
+        << BasicType::getName(type) << "," << header.size << ",";
+    if (type == NTA_BasicType_Str) {
+      std::string s(payload.begin(), payload.end());
+      std::string::size_type q = 0u;
+      while ((q = s.find('"', q)) != std::string::npos) {
+        s.insert(q, 1u, '"');
+        q += 2u;
+      }
+      out << '"' << s << '"';
+    } else {
+      const char *p = payload.data();
+      const size_t n = header.count;
+      switch (header.encoding == 1u ? NTA_BasicType_UInt32 : type) {
+      case NTA_BasicType_Byte:   writeValues<Byte>(out, p, n); break;
+      case NTA_BasicType_Bool:   writeValues<bool>(out, p, n); break;
+      case NTA_BasicType_Int16:  writeValues<Int16>(out, p, n); break;
+      case NTA_BasicType_UInt16: writeValues<UInt16>(out, p, n); break;
+      case NTA_BasicType_Int32:  writeValues<Int32>(out, p, n); break;
+      case NTA_BasicType_UInt32: writeValues<UInt32>(out, p, n); break;
+      case NTA_BasicType_Int64:  writeValues<Int64>(out, p, n); break;
+      case NTA_BasicType_UInt64: writeValues<UInt64>(out, p, n); break;
+      case NTA_BasicType_Real32: writeValues<Real32>(out, p, n); break;
+      case NTA_BasicType_Real64: writeValues<Real64>(out, p, n); break;
+      default:
+        NTA_THROW << "Watcher::toCSV: unexpected type " << header.type;
+      }
+    }
+    out << "\n";
+  }
+  NTA_CHECK(in.eof() && in.gcount() == 0) << "Watcher::toCSV: truncated record.";
+}
+
 void Watcher::closeFile() {
+  if (data_.writer) {
+    data_.writer->close();
+    return;
+  }
   if (data_.outStream.is_open()) {
 //    data_.outStream << "Closing...\n";
     data_.outStream.flush();
@@ -393,14 +577,18 @@ void Watcher::closeFile() {
 }
 
 void Watcher::flushFile() {
-  if (data_.outStream.is_open())
+  if (data_.writer)
+    data_.writer->flush();
+  else if (data_.outStream.is_open())
     data_.outStream.flush();
 }
 
 //attach Watcher to a network and do initial writing to files
 void Watcher::attachToNetwork(Network& net)
 {
-  std::ostream &out = data_.outStream;
+  // The text header goes to a buffer which BINARY files do not use.
+  std::stringstream info;
+  std::ostream &out = data_.format == TEXT ? static_cast<std::ostream &>(data_.outStream) : info;
   out << "Info: watchID, regionName, nodeType, nodeIndex, varName" << std::endl;
 
   // go through each watch
@@ -443,6 +631,7 @@ void Watcher::attachToNetwork(Network& net)
         out << watch.varName << "\n";
     } else if (watch.wType == output) {
       watch.output = watch.region->getOutput(watch.varName);
+      watch.output->addDemand();
         out << watch.varName << "\n";
 
       watch.array = &(watch.output->getData());
@@ -463,6 +652,20 @@ void Watcher::attachToNetwork(Network& net)
 
     out << "Data: watchID, iteration, paramValue" << std::endl;
 
+  if (data_.format == BINARY) {
+    std::vector<char> header(BINARY_MAGIC, BINARY_MAGIC + sizeof(BINARY_MAGIC));
+    appendPod(header, BINARY_VERSION);
+    appendPod(header, static_cast<UInt32>(data_.watches.size()));
+    for (const auto &watch : data_.watches) {
+      const std::string name = watch.regionName + "." + watch.varName;
+      appendPod(header, watch.watchID);
+      appendPod(header, static_cast<UInt32>(watch.varType));
+      appendPod(header, static_cast<UInt32>(name.size()));
+      header.insert(header.end(), name.begin(), name.end());
+    }
+    data_.writer->write(header.data(), header.size());
+  }
+
   // actually attach to the network
   Collection<Network::callbackItem> &callbacks = net.getCallbacks();
   Network::callbackItem callback(watcherCallback, (void *)(&data_));
@@ -476,5 +679,8 @@ void Watcher::detachFromNetwork(Network &net) {
   std::string callbackName = "Watcher: ";
   callbackName += data_.fileName;
   callbacks.remove(callbackName);
+  for (const auto &watch : data_.watches) {
+    if (watch.wType == output && watch.output != nullptr) watch.output->removeDemand();
+  }
 }
 } // namespace htm
@@ -26,8 +26,10 @@
 #include <vector>
 #include <iostream>
 #include <fstream>
+#include <memory>
 
 #include <htm/engine/Output.hpp>
+#include <htm/os/AsyncFileWriter.hpp>
 
 namespace htm {
 class ArrayBase;
@@ -56,11 +58,36 @@ enum watcherType { parameter, output };
  * net.run();
  *
  * w.detachFromNetwork(net);
+ *
+ * The TEXT format writes a line per watch and iteration, synchronously, on
+ * the thread which runs the network.  The BINARY format only copies the raw
+ * values (the sparse indices of SDRs) into a buffer, which a background
+ * thread writes to the file (see AsyncFileWriter), and is cheap enough to
+ * stay on in production; sampling every Nth iteration makes it cheaper still.
+ * Convert binary files with Watcher::toCSV() or with
+ * py/htm/advanced/support/watcher_reader.py (CSV or Parquet).
+ *
+ * Binary file layout, all in host byte order:
+ *   "HTMWATCH", uint32 version (1), uint32 number of watches
+ *   per watch:  uint32 watchID, uint32 type (NTA_BasicType),
+ *               uint32 name length, name ("regionName.varName")
+ *   records:    uint64 iteration, uint32 watchID, uint16 type,
+ *               uint16 encoding (0 raw values, 1 sparse UInt32 indices),
+ *               uint64 size (number of values, dense), uint64 count (in the payload),
+ *               then count values of the type (bytes for Str, UInt32 if sparse).
  */
 class Watcher {
 public:
+  enum Format { TEXT, BINARY };
+
   Watcher(const std::string fileName);
 
+  /**
+   * @param format      TEXT or BINARY, see above.
+   * @param sampleEvery Records only the iterations which are a multiple of it.
+   */
+  Watcher(const std::string fileName, Format format, UInt32 sampleEvery = 1u);
+
   // calls flushFile() and closeFile()
   ~Watcher();
 
@@ -88,6 +115,11 @@ public:
   // Flushes the Stream.
   void flushFile();
 
+  // Converts a BINARY watcher file to CSV: one row per watch and iteration
+  // with the columns iteration, watchID, name, type, size and the values
+  // (separated by spaces; positions of the active bits for sparse records).
+  static void toCSV(const std::string &binaryFile, const std::string &csvFile);
+
 private:
 
     // Contains data specific for each individual parameter
@@ -114,8 +146,14 @@ private:
         std::ofstream outStream;
         std::string fileName;
         std::vector<watchData> watches;
+        Format format = TEXT;
+        UInt32 sampleEvery = 1u;
+        std::unique_ptr<AsyncFileWriter> writer;  // BINARY
+        std::vector<char> record;                 // reused by each callback
     };
 
+  static void binaryCallback_(allData &data, UInt64 iteration);
+
   typedef std::vector<watchData> allWatchData;
 
   // private data structure
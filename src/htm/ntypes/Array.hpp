@@ -102,9 +102,11 @@
 // A.getBuffer()                     -- returns a void* pointer to beginning of buffer.
 // A.setBuffer(ptr, count)           -- set un-owned buffer
 // A.setBuffer(sdr)                  -- set un-owned SDR
+// A.setBuffer(B, offset, count)     -- share a slice of B's buffer, no copy.
 // A.zeroBuffer()                    -- fills A with 0's, A retains type and size.
 // A.releaseBuffer()                 -- free everything (if owned)
 // A.getSDR()                        -- get reference to enclosed SDR
+// A.getSDRNoRefresh()               -- same, without refreshing SDR cache from dense
 // A.getBufferSize( )                -- size of buffer in bytes
 // A.getMaxElementsCount()           -- capacity in number of elements 
 // A.setCount(count)                 -- truncate buffer size to this length, keeping capacity.   (not SDR)
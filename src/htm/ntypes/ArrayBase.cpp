@@ -19,15 +19,20 @@
  * Implementation of the ArrayBase class
  */
 
+#include <cctype>
+#include <charconv> // for to_chars, from_chars
 #include <cstdlib>  // for size_t
 #include <cstring>  // for memcpy, memcmp
 #include <iostream> // for ostream
+#include <limits>
 #include <sstream>  // for stringstream
+#include <type_traits>
 #include <vector>
 
 #include <htm/ntypes/ArrayBase.hpp>
 #include <htm/ntypes/Value.hpp>
 
+#include <htm/utils/Arena.hpp>
 #include <htm/utils/Log.hpp>
 
 namespace htm {
@@ -112,6 +117,9 @@ char *ArrayBase::allocateBuffer(size_t count) {
     //Need to allocate and delete std::string such that it can initialize.
     char *s = reinterpret_cast<char *>(new std::string[count_]);
     buffer_.reset(s, StrDeleter());
+  } else if (const std::shared_ptr<Arena> *arena = Arena::current()) {
+    // Shares the arena's reference count, no allocation of its own.
+    buffer_ = std::shared_ptr<char>(*arena, static_cast<char *>((*arena)->allocate(count_ * BasicType::getSize(type_))));
   } else {
     std::shared_ptr<char> sp(new char[count_ * BasicType::getSize(type_)], std::default_delete<char[]>());
     buffer_ = sp;
@@ -121,6 +129,12 @@ char *ArrayBase::allocateBuffer(size_t count) {
 
 char *ArrayBase::allocateBuffer(const std::vector<UInt> &dimensions) { // only for SDR
   NTA_CHECK(type_ == NTA_BasicType_SDR) << "Dimensions can only be set on the SDR payload";
+  if (const std::shared_ptr<Arena> *arena = Arena::current()) {
+    SDR *sdr = (*arena)->create<SDR>(dimensions);
+    buffer_ = std::shared_ptr<char>(*arena, reinterpret_cast<char *>(sdr));
+    count_ = sdr->size;
+    return buffer_.get();
+  }
   SDR *sdr = new SDR(dimensions);
   std::shared_ptr<char> sp(reinterpret_cast<char *>(sdr));
   buffer_ = sp;
@@ -159,6 +173,16 @@ void ArrayBase::setBuffer(void *buffer, size_t count) {
   count_ = count;
   buffer_ = std::shared_ptr<char>(reinterpret_cast<char *>(buffer), nonDeleter());
 }
+void ArrayBase::setBuffer(ArrayBase &a, size_t offset, size_t count) {
+  NTA_CHECK(type_ == a.type_) << "setBuffer: the slice must have the same type as its owner.";
+  NTA_CHECK(type_ != NTA_BasicType_SDR && type_ != NTA_BasicType_Str)
+      << "setBuffer: cannot share a slice of an SDR or Str buffer.";
+  NTA_CHECK(a.has_buffer() && offset + count <= a.getCount())
+      << "setBuffer: slice offset(" << offset << ")+count(" << count
+      << ") is out of range of the owner's buffer (" << a.getCount() << ").";
+  count_ = count;
+  buffer_ = std::shared_ptr<char>(a.buffer_, a.buffer_.get() + offset * BasicType::getSize(type_));
+}
 void ArrayBase::setBuffer(SDR &sdr) {
   type_ = NTA_BasicType_SDR;
   buffer_ = std::shared_ptr<char>(reinterpret_cast<char *>(&sdr), nonDeleter());
@@ -212,6 +236,14 @@ const SDR& ArrayBase::getSDR() const {
   sdr.setDense(sdr.getDense()); // cleanup cache
   return sdr;
 }
+SDR& ArrayBase::getSDRNoRefresh() {
+  NTA_CHECK(type_ == NTA_BasicType_SDR && buffer_ != nullptr) << "Does not contain an SDR object";
+  return *(reinterpret_cast<SDR *>(buffer_.get()));
+}
+const SDR& ArrayBase::getSDRNoRefresh() const {
+  NTA_CHECK(type_ == NTA_BasicType_SDR && buffer_ != nullptr) << "Does not contain an SDR object";
+  return *(reinterpret_cast<const SDR *>(buffer_.get()));
+}
 
 /**
  * number of elements of the given type in the buffer.
@@ -563,7 +595,7 @@ void ArrayBase::fromYAML(const std::string &data) { // handles both YAML and JSO
       << "Unexpected YAML or JSON format. Expecting something like {type: \"Int32\", data: [1,0,1]}";
 
   vm2 = vm["data"];
-  NTA_CHECK(vm2 && vm.isSequence())
+  NTA_CHECK(vm2 && vm2.isSequence())
       << "Unexpected YAML or JSON format. Expecting something like {type: \"SDR(1000)\", data: [1,2,3]}";
 
   std::string typeStr = vm1.as<std::string>();
@@ -699,74 +731,362 @@ void ArrayBase::fromValue(const Value &vm_) {
   }
 }
 
-std::string ArrayBase::toJSON() const {
-  std::stringstream json;
-  if (type_ == NTA_BasicType_SDR) {
-    const SDR &sdr = getSDR();
-    json << "[";
-    auto sparse = sdr.getSparse();
-    for (size_t i = 0; i < sparse.size(); i++) {
-      int v = sparse[i];
-      if (i == 0) {
-        json << v;
-      } else
-        json << ", " << v;
-    }
-    json << "]";
+namespace {
+
+// Upper bound of the characters of one number written by std::to_chars.
+template <typename T> constexpr size_t maxChars() {
+  if constexpr (std::is_floating_point<T>::value)
+    return std::numeric_limits<T>::max_digits10 + 10u; // sign, '.', "e-308"
+  else
+    return std::numeric_limits<T>::digits10 + 3u;      // sign, rounding
+}
+
+// Writes "v0, v1, ..." into a buffer grown once for all the elements.
+template <typename T> void appendNumbers(std::string &out, const T *data, size_t count) {
+  using Text = typename std::conditional<std::is_same<T, Byte>::value, int, T>::type; // Byte as a number
+  const size_t start = out.size();
+  out.resize(start + count * (maxChars<Text>() + 2u));
+  char *p = &out[start];
+  char *const end = &out[0] + out.size();
+  for (size_t i = 0; i < count; i++) {
+    if (i != 0) {
+      *p++ = ',';
+      *p++ = ' ';
+    }
+    p = std::to_chars(p, end, static_cast<Text>(data[i])).ptr;
+  }
+  out.resize(static_cast<size_t>(p - &out[0]));
+}
+
+
+// A cursor over JSON text.  Each read skips the white space before its token
+// and returns false if the token is not what it expected.
+class JsonReader {
+public:
+  JsonReader(const char *begin, const char *end) : p_(begin), end_(end) {}
+
+  const char *position() { space_(); return p_; }
+  bool atEnd() { space_(); return p_ == end_; }
+  bool next(const char c) {
+    space_();
+    if (p_ == end_ || *p_ != c) return false;
+    p_++;
+    return true;
+  }
+  bool peek(const char c) { space_(); return p_ != end_ && *p_ == c; }
+
+  template <typename T> bool number(T &value) {
+    space_();
+    if (p_ != end_ && *p_ == '+') p_++; // not JSON, but YAML accepts it
+    const auto result = std::from_chars(p_, end_, value);
+    if (result.ec != std::errc()) return false;
+    p_ = result.ptr;
+    return delimited_();
+  }
+
+  bool boolean(bool &value) {
+    space_();
+    if (word_("true"))  { value = true;  return true; }
+    if (word_("false")) { value = false; return true; }
+    int number;
+    if (!this->number(number) || number < 0 || number > 1) return false;
+    value = number != 0;
+    return true;
+  }
+
+  // A quoted string with its escapes, or null, or a bare word (a number, an
+  // unquoted key) as Value::json_string() writes them.
+  bool string(std::string &value) {
+    space_();
+    value.clear();
+    if (p_ == end_) return false;
+    if (*p_ != '"') {
+      if (word_("null")) return true;
+      const char *start = p_;
+      while (p_ != end_ && (std::isalnum(static_cast<unsigned char>(*p_)) || std::strchr("_+-.", *p_)))
+        p_++;
+      value.assign(start, p_);
+      return !value.empty() && delimited_();
+    }
+    for (p_++; p_ != end_ && *p_ != '"'; p_++) {
+      if (*p_ != '\\') {
+        value.push_back(*p_);
+        continue;
+      }
+      if (++p_ == end_) return false;
+      switch (*p_) {
+      case 'b': value.push_back('\b'); break;
+      case 'f': value.push_back('\f'); break;
+      case 'n': value.push_back('\n'); break;
+      case 'r': value.push_back('\r'); break;
+      case 't': value.push_back('\t'); break;
+      case 'u': {
+        if (end_ - p_ < 5) return false;
+        unsigned int code;
+        const auto result = std::from_chars(p_ + 1, p_ + 5, code, 16);
+        if (result.ptr != p_ + 5) return false;
+        p_ += 4;
+        utf8_(code, value);
+        break;
+      }
+      default: value.push_back(*p_); break; // '"', '\\', '/'
+      }
+    }
+    if (p_ == end_) return false;
+    p_++;
+    return true;
+  }
+
+  // Skips any value: a string, an array, an object or a scalar.
+  bool skip() {
+    space_();
+    if (p_ == end_) return false;
+    if (*p_ == '"') {
+      std::string ignored;
+      return string(ignored);
+    }
+    if (*p_ != '[' && *p_ != '{') {
+      while (p_ != end_ && !std::strchr(",]} \t\r\n", *p_))
+        p_++;
+      return true;
+    }
+    int depth = 0;
+    for (; p_ != end_; p_++) {
+      if (*p_ == '"') {
+        std::string ignored;
+        if (!string(ignored)) return false;
+        p_--;
+      } else if (*p_ == '[' || *p_ == '{') {
+        depth++;
+      } else if ((*p_ == ']' || *p_ == '}') && --depth == 0) {
+        p_++;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // The number of elements of the array at the cursor, which stays there.
+  bool count(size_t &elements) {
+    JsonReader r(*this);
+    elements = 0u;
+    if (!r.next('[')) return false;
+    if (r.next(']')) return true;
+    do {
+      if (!r.skip()) return false;
+      elements++;
+    } while (r.next(','));
+    return r.next(']');
+  }
+
+private:
+  void space_() {
+    while (p_ != end_ && std::isspace(static_cast<unsigned char>(*p_)))
+      p_++;
+  }
+  bool word_(const char *word) {
+    const size_t n = std::strlen(word);
+    if (static_cast<size_t>(end_ - p_) < n || std::strncmp(p_, word, n) != 0) return false;
+    const char *start = p_;
+    p_ += n;
+    if (delimited_()) return true;
+    p_ = start;
+    return false;
+  }
+  // A scalar ends at white space or punctuation.
+  bool delimited_() const { return p_ == end_ || std::strchr(",]}: \t\r\n", *p_) != nullptr; }
+
+  static void utf8_(const unsigned int code, std::string &out) {
+    if (code < 0x80u) {
+      out.push_back(static_cast<char>(code));
+    } else if (code < 0x800u) {
+      out.push_back(static_cast<char>(0xC0u | (code >> 6)));
+      out.push_back(static_cast<char>(0x80u | (code & 0x3Fu)));
+    } else {
+      out.push_back(static_cast<char>(0xE0u | (code >> 12)));
+      out.push_back(static_cast<char>(0x80u | ((code >> 6) & 0x3Fu)));
+      out.push_back(static_cast<char>(0x80u | (code & 0x3Fu)));
+    }
+  }
+
+  const char *p_;
+  const char *end_;
+};
+
+// Reads the "count" elements of an array into a buffer.
+template <typename T> bool readNumbers(JsonReader &in, T *data, const size_t count) {
+  if (!in.next('[')) return false;
+  for (size_t i = 0; i < count; i++) {
+    if (i != 0 && !in.next(',')) return false;
+    if constexpr (std::is_same<T, Byte>::value) {
+      int value;
+      if (!in.number(value) || value < std::numeric_limits<Byte>::min() || value > std::numeric_limits<Byte>::max())
+        return false;
+      data[i] = static_cast<Byte>(value);
+    } else if constexpr (std::is_same<T, bool>::value) {
+      if (!in.boolean(data[i])) return false;
+    } else if constexpr (std::is_same<T, std::string>::value) {
+      if (!in.string(data[i])) return false;
+    } else {
+      if (!in.number(data[i])) return false;
+    }
+  }
+  return in.next(']');
+}
+
+} // namespace
+
+
+void ArrayBase::fromJSON(const std::string &data) {
+  if (!parseJSON_(data))
+    fromYAML(data);
+}
+
+
+bool ArrayBase::parseJSON_(const std::string &data) {
+  JsonReader in(data.data(), data.data() + data.size());
+  NTA_BasicType type = type_;
+  std::vector<UInt> dim;
+  bool reallocate = true;
+  JsonReader values(in);
+
+  if (in.next('{')) {
+    // {"type": "...", "data": [...], "dim": [...]}, in any order.
+    std::string key, typeStr;
+    bool hasData = false;
+    if (!in.next('}')) {
+      do {
+        if (!in.string(key) || !in.next(':')) return false;
+        if (key == "type") {
+          if (!in.string(typeStr)) return false;
+        } else if (key == "data") {
+          values = in;
+          if (!in.skip()) return false;
+          hasData = true;
+        } else if (key == "dim") {
+          size_t n;
+          if (!in.count(n)) return false;
+          dim.resize(n);
+          if (!readNumbers(in, dim.data(), n)) return false;
+        } else if (!in.skip()) {
+          return false;
+        }
+      } while (in.next(','));
+      if (!in.next('}')) return false;
+    }
+    if (!hasData || !in.atEnd()) return false;
+    if (typeStr.empty()) {  // {"data": [...]} of this Array's type
+      if (!BasicType::isValid(type)) return false;
+      reallocate = type != NTA_BasicType_SDR || getCount() == 0u || !dim.empty();
+    } else if (typeStr.compare(0, 3, "SDR") == 0) {
+      type = NTA_BasicType_SDR;
+      if (typeStr.find('(') != std::string::npos)
+        dim = parseDim(typeStr);
+      else if (dim.empty())
+        return false;
+    } else {
+      type = BasicType::parse(typeStr);
+    }
   } else {
+    // Just the data, of this Array's type.
+    if (!BasicType::isValid(type) || !in.skip() || !in.atEnd()) return false;
+    reallocate = type != NTA_BasicType_SDR || getCount() == 0u;
+  }
+
+  size_t num;
+  if (!values.count(num)) return false;
+  if (type == NTA_BasicType_SDR) {
+    // Sparse indices, or the dense bits when there are as many as the SDR's
+    // size and the third is 0 or 1 (the same guess as fromValue()).
+    SDR_sparse_t indices(num);
+    JsonReader bits(values);
+    if (!readNumbers(values, indices.data(), num)) {  // true, false
+      for (size_t i = 0; i < num; i++) {
+        bool b;
+        if (!bits.next(i == 0u ? '[' : ',') || !bits.boolean(b)) return false;
+        indices[i] = b;
+      }
+    }
+    type_ = type;
+    if (reallocate)
+      allocateBuffer(dim.empty() ? std::vector<UInt>{static_cast<UInt>(num)} : dim);
+    SDR &sdr = getSDR();
+    const bool isDense = num == getCount() && (num <= 2u || indices[2] <= 1u);
+    if (isDense) {
+      SDR_dense_t dense(num);
+      for (size_t i = 0; i < num; i++)
+        dense[i] = indices[i] != 0u;
+      sdr.setDense(dense);
+    } else {
+      sdr.setSparse(indices);
+    }
+    return true;
+  }
+
+  type_ = type;
+  allocateBuffer(num);
+  void *buffer = getBuffer();
+  switch (type_) {
+  case NTA_BasicType_Byte:   return readNumbers(values, static_cast<Byte *>(buffer), num);
+  case NTA_BasicType_Int16:  return readNumbers(values, static_cast<Int16 *>(buffer), num);
+  case NTA_BasicType_UInt16: return readNumbers(values, static_cast<UInt16 *>(buffer), num);
+  case NTA_BasicType_Int32:  return readNumbers(values, static_cast<Int32 *>(buffer), num);
+  case NTA_BasicType_UInt32: return readNumbers(values, static_cast<UInt32 *>(buffer), num);
+  case NTA_BasicType_Int64:  return readNumbers(values, static_cast<Int64 *>(buffer), num);
+  case NTA_BasicType_UInt64: return readNumbers(values, static_cast<UInt64 *>(buffer), num);
+  case NTA_BasicType_Real32: return readNumbers(values, static_cast<Real32 *>(buffer), num);
+  case NTA_BasicType_Real64: return readNumbers(values, static_cast<Real64 *>(buffer), num);
+  case NTA_BasicType_Bool:   return readNumbers(values, static_cast<bool *>(buffer), num);
+  case NTA_BasicType_Str:    return readNumbers(values, static_cast<std::string *>(buffer), num);
+  default:
+    return false;
+  }
+}
 
-    json << "[";
-    size_t num = getCount();
+
+void ArrayBase::appendJSON(std::string &json) const {
+  json.push_back('[');
+  if (type_ == NTA_BasicType_SDR) {
+    const SDR_sparse_t &sparse = getSDR().getSparse();
+    appendNumbers(json, sparse.data(), sparse.size());
+  } else {
+    const size_t num = getCount();
     const void *inbuf = getBuffer();
-    bool first = true;
-    for (size_t i = 0; i < num; i++) {
-      if (first)
-        first = false;
-      else
-        json << ", ";
-      switch (type_) {
-      case NTA_BasicType_Byte:
-        json << (int)((Byte *)inbuf)[i];
-        break;
-      case NTA_BasicType_Int16:
-        json << ((Int16 *)inbuf)[i];
-        break;
-      case NTA_BasicType_UInt16:
-        json << ((UInt16 *)inbuf)[i];
-        break;
-      case NTA_BasicType_Int32:
-        json << ((Int32 *)inbuf)[i];
-        break;
-      case NTA_BasicType_UInt32:
-        json << ((UInt32 *)inbuf)[i];
-        break;
-      case NTA_BasicType_Int64:
-        json << ((Int64 *)inbuf)[i];
-        break;
-      case NTA_BasicType_UInt64:
-        json << ((UInt64 *)inbuf)[i];
-        break;
-      case NTA_BasicType_Real32:
-        json << ((Real32 *)inbuf)[i];
-        break;
-      case NTA_BasicType_Real64:
-        json << ((Real64 *)inbuf)[i];
-        break;
-      case NTA_BasicType_Bool: 
-          json << ((((bool *)inbuf)[i]) ? "true" : "false");
-        break;
-      case NTA_BasicType_Str:
-        json << Value::json_string(((std::string *)inbuf)[i]);
-        break;
-      default:
-        NTA_THROW << "Unexpected Element Type: " << type_;
-        break;
+    switch (type_) {
+    case NTA_BasicType_Byte:   appendNumbers(json, static_cast<const Byte *>(inbuf), num); break;
+    case NTA_BasicType_Int16:  appendNumbers(json, static_cast<const Int16 *>(inbuf), num); break;
+    case NTA_BasicType_UInt16: appendNumbers(json, static_cast<const UInt16 *>(inbuf), num); break;
+    case NTA_BasicType_Int32:  appendNumbers(json, static_cast<const Int32 *>(inbuf), num); break;
+    case NTA_BasicType_UInt32: appendNumbers(json, static_cast<const UInt32 *>(inbuf), num); break;
+    case NTA_BasicType_Int64:  appendNumbers(json, static_cast<const Int64 *>(inbuf), num); break;
+    case NTA_BasicType_UInt64: appendNumbers(json, static_cast<const UInt64 *>(inbuf), num); break;
+    case NTA_BasicType_Real32: appendNumbers(json, static_cast<const Real32 *>(inbuf), num); break;
+    case NTA_BasicType_Real64: appendNumbers(json, static_cast<const Real64 *>(inbuf), num); break;
+    case NTA_BasicType_Bool:
+      json.reserve(json.size() + num * 7u);
+      for (size_t i = 0; i < num; i++) {
+        if (i != 0) json.append(", ");
+        json.append(static_cast<const bool *>(inbuf)[i] ? "true" : "false");
       }
+      break;
+    case NTA_BasicType_Str:
+      for (size_t i = 0; i < num; i++) {
+        if (i != 0) json.append(", ");
+        json.append(Value::json_string(static_cast<const std::string *>(inbuf)[i]));
+      }
+      break;
+    default:
+      NTA_THROW << "Unexpected Element Type: " << type_;
+      break;
     }
-    json << "]";
   }
+  json.push_back(']');
+}
 
-  return json.str();
+std::string ArrayBase::toJSON() const {
+  std::string json;
+  appendJSON(json);
+  return json;
 }
 
 } // namespace htm
@@ -125,6 +125,14 @@ namespace htm
     SDR& getSDR();
     const SDR& getSDR() const;
 
+    /**
+     * Returns a reference to the underlining SDR without refreshing its cache.
+     * getSDR() assumes the dense buffer from getBuffer() may have been written;
+     * use this only on buffers that are only modified through the SDR.
+     */
+    SDR& getSDRNoRefresh();
+    const SDR& getSDRNoRefresh() const;
+
     /**
      * number of elements of given type in the buffer
      */
@@ -152,6 +160,15 @@ namespace htm
     virtual void setBuffer(void *buffer, size_t count);
     virtual void setBuffer(SDR &sdr);
 
+    /**
+     * Use a slice of another ArrayBase's buffer as the buffer, without copying.
+     * Writes through this instance show up in 'a' at 'offset' and the other way
+     * around. The slice shares ownership, so a's buffer stays valid for the life
+     * of this instance even if 'a' is released or reallocated.
+     * Both must have the same numeric type (not SDR or Str).
+     */
+    void setBuffer(ArrayBase &a, size_t offset, size_t count);
+
 
     /**
      * Return the type of data contained in the ArrayBase object.
@@ -244,7 +261,22 @@ namespace htm
     void fromValue(const Value &vm);      //handles both YAML and JSON syntax
     // Serialization and Deserialization using YAML parser
     void fromYAML(const std::string& data);      //handles both YAML and JSON syntax
-    void fromJSON(const std::string &data) { return fromYAML(data); }
+
+    /**
+     * JSON codec, without the YAML parser and without iostreams.
+     *
+     * fromJSON() parses {"type": "Int32", "data": [1, 0, 1]} (with an
+     * optional "dim" for an SDR), or without the "type", or just the data
+     * [1, 0, 1], into an Array which has a type.  An SDR keeps its
+     * dimensions unless given.  It falls back to fromYAML() for what it does not
+     * understand, e.g. YAML syntax.
+     *
+     * appendJSON() writes the data, e.g. [1, 0, 1], at the end of a buffer
+     * which can be reused; numbers with std::to_chars, the shortest text
+     * which reads back the same value.  An SDR writes its sparse indices.
+     */
+    void fromJSON(const std::string &data);
+    void appendJSON(std::string &buffer) const;
     std::string toJSON() const;
 
 
@@ -264,6 +296,9 @@ namespace htm
     // Buffer array conversion routines
     void convertInto(ArrayBase &a, size_t offset=0, size_t maxsize=0) const;
 
+    // The fast path of fromJSON(), false if it must use fromYAML().
+    bool parseJSON_(const std::string &data);
+
   private:
     // helpers for Cereal Serialization of raw pointers to arrays
 		// copy the array to a vector and let Cereal handle it.
@@ -18,6 +18,7 @@
 #include <limits>
 #include <cerrno>
 #include <cstring> // std::strerror(errno)
+#include <type_traits>
 
 #include <htm/ntypes/BasicType.hpp>
 
@@ -186,7 +187,7 @@ NTA_BasicType BasicType::parse(const std::string &s) {
     return NTA_BasicType_Bool;
   else if (s == std::string("SDR"))
     return NTA_BasicType_SDR;
-  else if (s == std::string("String") || s == std::string("std::string"))
+  else if (s == std::string("String") || s == std::string("Str") || s == std::string("std::string"))
     return NTA_BasicType_Str;
   else if (s == std::string("Last"))
     return NTA_BasicType_Last;  // Means none-of-the-above.
@@ -203,10 +204,15 @@ NTA_BasicType BasicType::parse(const std::string &s) {
 */
 template <typename T, typename F>
 static void cpyarray(void *toPtr, const void *fromPtr, size_t count) {
-  T *ptr1 = static_cast<T *>(toPtr);
-  const F *ptr2 = reinterpret_cast<const F *>(fromPtr);
-  for (size_t i = 0; i < count; i++) {
-    *ptr1++ = static_cast<T>(*ptr2++);
+  if constexpr (std::is_same<T, F>::value && std::is_trivially_copyable<T>::value) {
+    std::memcpy(toPtr, fromPtr, count * sizeof(T));
+  } else {
+    // Indexed loop without early exits, which the compiler vectorizes.
+    T *ptr1 = static_cast<T *>(toPtr);
+    const F *ptr2 = reinterpret_cast<const F *>(fromPtr);
+    for (size_t i = 0; i < count; i++) {
+      ptr1[i] = static_cast<T>(ptr2[i]);
+    }
   }
 }
 
@@ -216,13 +222,20 @@ static void cpyarray(void *toPtr, const void *fromPtr, size_t count) {
  */
 template <typename T, typename F>
 static void cpyarray(void *toPtr, const void *fromPtr, size_t count, F minVal, F maxVal) {
-  T *ptr1 = static_cast<T *>(toPtr);
   const F *ptr2 = reinterpret_cast<const F *>(fromPtr);
+  // Check all values first, without branches so that both loops vectorize;
+  // a NaN fails the check as well.
+  int outOfRange = 0;
   for (size_t i = 0; i < count; i++) {
-    NTA_CHECK(*ptr2 >= minVal && *ptr2 <= maxVal)
-          << "Value Out of range. Value: " << *ptr2 << " ";
-    *ptr1++ = static_cast<T>(*ptr2++);
+    outOfRange |= !((ptr2[i] >= minVal) & (ptr2[i] <= maxVal));
   }
+  if (outOfRange) {
+    for (size_t i = 0; i < count; i++) {
+      NTA_CHECK(ptr2[i] >= minVal && ptr2[i] <= maxVal)
+            << "Value Out of range. Value: " << ptr2[i] << " ";
+    }
+  }
+  cpyarray<T, F>(toPtr, fromPtr, count);
 }
 
 template <typename T>
@@ -279,6 +292,12 @@ void BasicType::convertArray(void *ptr1, NTA_BasicType toType, const void *ptr2,
   if (ptr2 == nullptr || count == 0)
     return;
   NTA_CHECK(ptr1 != nullptr);
+  // The common case of Link::compute(), a plain copy.
+  if (fromType == toType && fromType != NTA_BasicType_Str && fromType != NTA_BasicType_SDR
+      && fromType != NTA_BasicType_Handle && isValid(fromType)) {
+    std::memcpy(ptr1, ptr2, count * getSize(fromType));
+    return;
+  }
   try {
     switch (fromType) {
     case NTA_BasicType_Byte: // char.  This might be signed or unsigned.
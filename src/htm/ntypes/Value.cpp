@@ -24,15 +24,12 @@
 #include <htm/os/Path.hpp>  // for trim()
 
 #include <algorithm> // transform
+#include <cctype> // isdigit
 #include <cerrno>
 #include <cstring> // std::strerror(errno)
 #include <iomanip>
 #include <iostream>
-#include <regex>
 #include <stack>
-#include <mutex>
-
-static std::mutex g_tree_mutex;
 
 using namespace htm;
 
@@ -131,11 +128,11 @@ Value &Value::parse(const std::string &yaml_string) {
           break;
         case seq_state:
           stack.push(node);
-          node = &node->operator[](node->size());
+          node = &node->parsedChild_(std::to_string(node->size()), false);
           break;
         case map_key:
           stack.push(node);
-          node = &node->operator[](key);
+          node = &node->parsedChild_(key, true);
           break;
         default:
           break;
@@ -145,6 +142,7 @@ Value &Value::parse(const std::string &yaml_string) {
       case YAML_MAPPING_END_EVENT:
       case YAML_SEQUENCE_END_EVENT:
         if (stack.size() > 0) {
+          node->parsedEnd_();
           node = stack.top();
           stack.pop();
           state = (node->isSequence()) ? seq_state : (node->isMap()) ? map_state : start_state;
@@ -163,12 +161,12 @@ Value &Value::parse(const std::string &yaml_string) {
           break;
         case map_key:
           VERBOSE << "map Scalar value: " << val << std::endl;
-          (*node)[key] = val;
+          node->parsedChild_(key, true).parsedScalar_(val);
           state = map_state;
           break;
         case seq_state:
           VERBOSE << "Seq Scalar value: " << val << std::endl;
-          (*node)[node->size()] = val;
+          node->parsedChild_(std::to_string(node->size()), false).parsedScalar_(val);
           state = seq_state;
           break;
         default:
@@ -203,6 +201,62 @@ Value &Value::parse(const std::string &yaml_string) {
 #endif // YAML_PARSER_yamlcpp
 /////////////////////////////////////////////////////////////////////////////////////////
 
+// Tree building for the parser.
+// The parser owns the tree it is building, so it links each new node directly
+// into its parent instead of going through operator[] and operator=, which
+// allocate and register a per-thread zombie for every node and then walk
+// addToParent() to attach it.
+
+// Return the child with this key, adding an Empty child if there is none.
+// Sequence keys get the same '-' suffixes as operator[](size_t).
+Value &Value::parsedChild_(const std::string &key, bool isMapKey) {
+  if (core_->type_ == Value::Category::Empty && core_->parent_)
+    core_->addToParent(*this); // parse() into a zombie, or a container emptied by parsedEnd_()
+  std::string k = key;
+  auto itr = core_->map_.find(k);
+  if (itr != core_->map_.end()) {
+    if (isMapKey)
+      return itr->second; // duplicate map key replaces the value
+    while (core_->map_.find(k) != core_->map_.end())
+      k += "-";
+  }
+  auto ret = core_->map_.emplace(k, Value());
+  Value &child = ret.first->second;
+  child.core_->parent_ = core_;
+  child.core_->key_ = k;
+  child.core_->index_ = core_->vec_.size();
+  core_->vec_.push_back(ret.first);
+  if (isMapKey)
+    core_->type_ = Value::Category::Map;
+  else if (core_->type_ == Value::Category::Empty)
+    core_->type_ = Value::Category::Sequence;
+  return child;
+}
+
+// Assign a scalar to a node returned by parsedChild_().
+void Value::parsedScalar_(const std::string &val) {
+  if (core_->type_ != Value::Category::Scalar) {
+    core_->map_.clear();
+    core_->vec_.clear();
+    core_->type_ = Value::Category::Scalar;
+  }
+  core_->scalar_ = val;
+}
+
+// End of a parsed map or sequence.  Like a zombie that was never assigned,
+// a container that received no values is not kept in the tree.
+void Value::parsedEnd_() {
+  if (!core_->vec_.empty() || core_->type_ == Value::Category::Scalar || !core_->parent_)
+    return;
+  auto &parent = *core_->parent_;
+  NTA_CHECK(!parent.vec_.empty() && parent.vec_.back()->second.core_ == core_);
+  auto itr = parent.vec_.back();
+  parent.vec_.pop_back();
+  parent.map_.erase(itr); // deletes 'this'. Do not access it.
+  if (parent.vec_.empty())
+    parent.type_ = Value::Category::Empty;
+}
+
 
 // The remaining code is independent of the parser
 
@@ -362,19 +416,13 @@ void Value::internals::addToParent(Value& node) {
   bool isKeyForMap = (index_ == ZOMBIE_MAP);
 
   // Add the node to the parent.
-  g_tree_mutex.lock();
-  try {
-    auto itr = parent_->map_.find(key_);
-    if (itr == parent_->map_.end()) {
-      index_ = parent_->vec_.size();
-      auto ret = parent_->map_.insert(std::pair<std::string, Value>(key_, node));
-      parent_->vec_.push_back(ret.first);
-    }
-  } catch (std::exception &e) {
-    g_tree_mutex.unlock();
-    NTA_THROW << e.what();
+  // A tree is not shared between threads, like any std container.
+  auto itr = parent_->map_.find(key_);
+  if (itr == parent_->map_.end()) {
+    index_ = parent_->vec_.size();
+    auto ret = parent_->map_.insert(std::pair<std::string, Value>(key_, node));
+    parent_->vec_.push_back(ret.first);
   }
-  g_tree_mutex.unlock();
 
   NTA_CHECK(parent_->map_.size() == parent_->vec_.size())
       << "Detected Corruption of ValueMap structure";
@@ -449,18 +497,11 @@ void Value::copy(Value *target) const {
     std::string key = core_->vec_[i]->first;
     Value child_target; 
     child_target.core_->parent_ = target->core_;
-    g_tree_mutex.lock();
-    try {
-      auto itr = target->core_->map_.find(key);
-      if (itr == target->core_->map_.end()) {
-        ret = target->core_->map_.insert(std::pair<std::string, Value>(key, child_target));
-        target->core_->vec_.push_back(ret.first);
-      }
-    } catch (std::exception &e) {
-      g_tree_mutex.unlock();
-      NTA_THROW << e.what();
+    auto itr = target->core_->map_.find(key);
+    if (itr == target->core_->map_.end()) {
+      ret = target->core_->map_.insert(std::pair<std::string, Value>(key, child_target));
+      target->core_->vec_.push_back(ret.first);
     }
-    g_tree_mutex.unlock();
     core_->vec_[i]->second.copy(&ret.first->second);
   }
 }
@@ -578,6 +619,27 @@ bool Value::asBool() const {
   ;
 }
 
+// Same as std::regex_match(s, std::regex("^[-+]?[0-9]+([.][0-9]+)?$")),
+// without constructing a regex for every scalar written.
+static bool isJsonNumber(const std::string &s) {
+  size_t i = 0;
+  if (i < s.size() && (s[i] == '-' || s[i] == '+'))
+    i++;
+  const size_t intStart = i;
+  while (i < s.size() && std::isdigit(static_cast<unsigned char>(s[i])))
+    i++;
+  if (i == intStart)
+    return false;
+  if (i == s.size())
+    return true;
+  if (s[i] != '.')
+    return false;
+  const size_t fracStart = ++i;
+  while (i < s.size() && std::isdigit(static_cast<unsigned char>(s[i])))
+    i++;
+  return i > fracStart && i == s.size();
+}
+
 /**
  * A function to apply escapes for a JSON string.
  * It is assumed that std::strings are UTF8.
@@ -588,7 +650,7 @@ std::string Value::json_string(const std::string &str) {
   if (s.empty()) 
     return "null";  // The JSON identifier for empty.
     
-  if (std::regex_match(s, std::regex("^[-+]?[0-9]+([.][0-9]+)?$"))) {
+  if (isJsonNumber(s)) {
     // This is numeric so does not need quotes or escapes.
     return s;
   }
@@ -390,6 +390,9 @@ private:
   void assign(std::string val); // add a scalar
   void copy(Value *target) const;
   void cleanup();
+  Value &parsedChild_(const std::string &key, bool isMapKey);
+  void parsedScalar_(const std::string &val);
+  void parsedEnd_();
 
   int8_t asInt8() const;
   int16_t asInt16() const;
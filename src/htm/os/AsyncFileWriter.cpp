@@ -0,0 +1,112 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of AsyncFileWriter
+ */
+
+#include <algorithm>
+
+#include <htm/os/AsyncFileWriter.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+AsyncFileWriter::AsyncFileWriter(const std::string &path, bool append, size_t flushBytes)
+    : path_(path), flushBytes_(std::max<size_t>(flushBytes, 1u)) {
+  out_.open(path, std::ios_base::out | std::ios_base::binary |
+                      (append ? std::ios_base::app : std::ios_base::trunc));
+  NTA_CHECK(out_.is_open()) << "AsyncFileWriter: unable to create or open file: " << path;
+  front_.reserve(flushBytes_);
+  back_.reserve(flushBytes_);
+  thread_ = std::thread(&AsyncFileWriter::run_, this);
+}
+
+AsyncFileWriter::~AsyncFileWriter() {
+  try {
+    close();
+  } catch (const std::exception &e) {
+    NTA_WARN << e.what();
+  }
+}
+
+void AsyncFileWriter::checkError_() const {
+  NTA_CHECK(!failed_) << "AsyncFileWriter: there was an error writing to the file " << path_;
+}
+
+void AsyncFileWriter::write(const char *data, size_t bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  checkError_();
+  NTA_CHECK(!stop_) << "AsyncFileWriter: " << path_ << " is closed";
+  front_.insert(front_.end(), data, data + bytes);
+  if (front_.size() >= flushBytes_ && !writing_)
+    wake_.notify_one();
+}
+
+void AsyncFileWriter::flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (stop_)
+    return;
+  flushWanted_ = true;
+  wake_.notify_one();
+  idle_.wait(lock, [&]() { return !flushWanted_ && !writing_; });
+  checkError_();
+}
+
+void AsyncFileWriter::close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stop_)
+      return;
+    stop_ = true;
+  }
+  wake_.notify_one();
+  thread_.join();
+  out_.close();
+  failed_ = failed_ || out_.fail();
+  checkError_();
+}
+
+void AsyncFileWriter::run_() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    wake_.wait(lock, [&]() { return stop_ || flushWanted_ || front_.size() >= flushBytes_; });
+    const bool flush = flushWanted_;
+    if (!front_.empty()) {
+      back_.swap(front_); // keeps the capacity of both buffers
+      writing_ = true;
+      lock.unlock();
+      out_.write(back_.data(), static_cast<std::streamsize>(back_.size()));
+      if (flush)
+        out_.flush();
+      const bool failed = out_.fail();
+      back_.clear();
+      lock.lock();
+      writing_ = false;
+      failed_ = failed_ || failed;
+    } else if (flush) {
+      out_.flush();
+    }
+    if (flush)
+      flushWanted_ = false;
+    idle_.notify_all();
+    if (stop_ && front_.empty())
+      break;
+  }
+}
+
+} // namespace htm
@@ -0,0 +1,89 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Buffered file writer with a background thread
+ */
+
+#ifndef NTA_ASYNC_FILE_WRITER_HPP
+#define NTA_ASYNC_FILE_WRITER_HPP
+
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace htm {
+
+/**
+ * Writes a file from a background thread, so the caller never blocks on
+ * disk. write() only appends to an in-memory buffer; once it holds
+ * flushBytes the writer thread swaps it for its own (empty) buffer and
+ * writes that out while the caller keeps appending. If the disk falls
+ * behind the buffer grows rather than blocking the caller.
+ *
+ * A write error on the thread is thrown from the next write(), flush() or
+ * close(). Designed for a single producer thread.
+ */
+class AsyncFileWriter {
+public:
+  /**
+   * @param path       - the file, created if missing.
+   * @param append     - keep the existing content, else truncate.
+   * @param flushBytes - buffered bytes that wake the writer thread.
+   */
+  explicit AsyncFileWriter(const std::string &path, bool append = true,
+                           size_t flushBytes = 1u << 20u);
+  ~AsyncFileWriter();
+  AsyncFileWriter(const AsyncFileWriter &) = delete;
+  AsyncFileWriter &operator=(const AsyncFileWriter &) = delete;
+
+  void write(const char *data, size_t bytes);
+  void write(const std::string &s) { write(s.data(), s.size()); }
+
+  /** Blocks until everything written so far is in the file. */
+  void flush();
+
+  /** Writes the rest and closes the file. Called by the destructor. */
+  void close();
+
+  const std::string &getPath() const noexcept { return path_; }
+
+private:
+  void run_();
+  void checkError_() const; // with mutex_ held
+
+  std::string path_;
+  size_t flushBytes_;
+  std::ofstream out_;
+  std::vector<char> front_; // filled by write()
+  std::vector<char> back_;  // being written by the thread
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable idle_;
+  bool flushWanted_ = false;
+  bool writing_ = false;
+  bool stop_ = false;
+  bool failed_ = false;
+  std::thread thread_;
+};
+
+} // namespace htm
+
+#endif // NTA_ASYNC_FILE_WRITER_HPP
@@ -0,0 +1,87 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of MappedFile
+ */
+
+#include <algorithm>
+#include <fstream>
+
+#if !defined(NTA_OS_WINDOWS)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <htm/os/MappedFile.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+MappedFile::MappedFile(const std::string &path) : path_(path) {
+#if !defined(NTA_OS_WINDOWS)
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  NTA_CHECK(fd >= 0) << "MappedFile: can't open " << path;
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    size_ = static_cast<size_t>(st.st_size);
+    void *p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p != MAP_FAILED) {
+      data_ = static_cast<const char *>(p);
+      mapped_ = true;
+    }
+  }
+  ::close(fd);
+#endif
+  if (!mapped_) {
+    std::ifstream in(path, std::ios_base::in | std::ios_base::binary | std::ios_base::ate);
+    NTA_CHECK(in.is_open()) << "MappedFile: can't open " << path;
+    buffer_.resize(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    in.read(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    NTA_CHECK(!in.fail()) << "MappedFile: failed to read " << path;
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+  }
+}
+
+MappedFile::~MappedFile() {
+#if !defined(NTA_OS_WINDOWS)
+  if (mapped_)
+    munmap(const_cast<char *>(data_), size_);
+#endif
+}
+
+void MappedFile::willNeed(const void *p, size_t bytes) const noexcept {
+#if !defined(NTA_OS_WINDOWS)
+  if (!mapped_ || !contains(p))
+    return;
+  // madvise wants a page aligned start
+  const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  const size_t begin = static_cast<size_t>(static_cast<const char *>(p) - data_) / page * page;
+  const size_t end = std::min(size_, static_cast<size_t>(static_cast<const char *>(p) - data_) + bytes);
+  if (end > begin)
+    madvise(const_cast<char *>(data_ + begin), end - begin, MADV_WILLNEED);
+#else
+  (void)p;
+  (void)bytes;
+#endif
+}
+
+} // namespace htm
@@ -0,0 +1,72 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Read-only memory mapped file
+ */
+
+#ifndef NTA_MAPPED_FILE_HPP
+#define NTA_MAPPED_FILE_HPP
+
+#include <string>
+#include <vector>
+
+namespace htm {
+
+/**
+ * A whole file mapped read-only into memory, so its contents are paged in
+ * by the OS on demand instead of being read up front. Where mmap is not
+ * available (Windows) or fails, the file is read into a buffer instead;
+ * data() behaves the same either way.
+ *
+ * The pointers into data() are valid for the lifetime of the MappedFile.
+ */
+class MappedFile {
+public:
+  explicit MappedFile(const std::string &path);
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const char *data() const noexcept { return data_; }
+  size_t size() const noexcept { return size_; }
+  bool isMapped() const noexcept { return mapped_; }
+  const std::string &getPath() const noexcept { return path_; }
+
+  bool contains(const void *p) const noexcept {
+    const char *c = static_cast<const char *>(p);
+    return data_ != nullptr && c >= data_ && c < data_ + size_;
+  }
+
+  /**
+   * Read-ahead: hints that [p, p + bytes) will be read soon, so the OS can
+   * start paging it in. The range is clipped to the file; no-op when the
+   * file is not mapped.
+   */
+  void willNeed(const void *p, size_t bytes) const noexcept;
+
+private:
+  std::string path_;
+  const char *data_ = nullptr;
+  size_t size_ = 0u;
+  bool mapped_ = false;
+  std::vector<char> buffer_; // fallback if the file can't be mapped
+};
+
+} // namespace htm
+
+#endif // NTA_MAPPED_FILE_HPP
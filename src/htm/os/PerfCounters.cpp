@@ -0,0 +1,186 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of PerfCounters
+ */
+
+#include <htm/os/PerfCounters.hpp>
+
+#include <sstream>
+
+#if defined(__linux__)
+#include <cstring> // memset
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace htm {
+
+PerfCounters::PerfCounters(bool startme) {
+  for (int e = 0; e < NUM_EVENTS; e++)
+    fds_[e] = -1;
+  reset();
+  if (startme)
+    start();
+}
+
+PerfCounters::~PerfCounters() { close_(); }
+
+PerfCounters::PerfCounters(const PerfCounters &other) : PerfCounters() {
+  for (int e = 0; e < NUM_EVENTS; e++)
+    counts_[e] = other.counts_[e];
+}
+
+PerfCounters &PerfCounters::operator=(const PerfCounters &other) {
+  if (this != &other) {
+    stop();
+    for (int e = 0; e < NUM_EVENTS; e++)
+      counts_[e] = other.counts_[e];
+  }
+  return *this;
+}
+
+
+void PerfCounters::start() {
+  if (started_)
+    return;
+  if (!opened_)
+    open_();
+  read_(startValues_);
+  started_ = true;
+}
+
+
+void PerfCounters::stop() {
+  if (!started_)
+    return;
+  UInt64 values[NUM_EVENTS];
+  read_(values);
+  for (int e = 0; e < NUM_EVENTS; e++)
+    counts_[e] += values[e] - startValues_[e];
+  started_ = false;
+}
+
+
+void PerfCounters::reset() {
+  for (int e = 0; e < NUM_EVENTS; e++) {
+    counts_[e] = 0u;
+    startValues_[e] = 0u;
+  }
+  if (started_)
+    read_(startValues_);
+}
+
+
+bool PerfCounters::isAvailable() const {
+  for (int e = 0; e < NUM_EVENTS; e++) {
+    if (fds_[e] >= 0)
+      return true;
+  }
+  return false;
+}
+
+
+const char *PerfCounters::getName(Event e) {
+  switch (e) {
+  case CYCLES:        return "cycles";
+  case INSTRUCTIONS:  return "instructions";
+  case CACHE_MISSES:  return "cacheMisses";
+  case BRANCH_MISSES: return "branchMisses";
+  default:            return "";
+  }
+}
+
+
+std::string PerfCounters::toJSON(Real64 divisor) const {
+  std::stringstream ss;
+  ss << "{";
+  const char *sep = "";
+  for (int e = 0; e < NUM_EVENTS; e++) {
+    if (fds_[e] < 0)
+      continue;
+    ss << sep << "\"" << getName(static_cast<Event>(e)) << "\": ";
+    if (divisor == 1.0)
+      ss << counts_[e];
+    else
+      ss << static_cast<Real64>(counts_[e]) / divisor;
+    sep = ", ";
+  }
+  ss << "}";
+  return ss.str();
+}
+
+
+#if defined(__linux__)
+
+void PerfCounters::open_() {
+  static const UInt64 config[NUM_EVENTS] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+  opened_ = true;
+  for (int e = 0; e < NUM_EVENTS; e++) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config[e];
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // Scale for the time the counter was not on the PMU, when there are
+    // more events than hardware counters.
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // this thread, any cpu
+    fds_[e] = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+}
+
+void PerfCounters::close_() {
+  for (int e = 0; e < NUM_EVENTS; e++) {
+    if (fds_[e] >= 0)
+      close(fds_[e]);
+    fds_[e] = -1;
+  }
+  opened_ = false;
+}
+
+void PerfCounters::read_(UInt64 *values) const {
+  for (int e = 0; e < NUM_EVENTS; e++) {
+    values[e] = 0u;
+    UInt64 data[3]; // value, time enabled, time running
+    if (fds_[e] < 0 || ::read(fds_[e], data, sizeof(data)) != sizeof(data))
+      continue;
+    values[e] = data[2] == 0u || data[2] == data[1]
+                  ? data[0]
+                  : static_cast<UInt64>(static_cast<Real64>(data[0]) * data[1] / data[2]);
+  }
+}
+
+#else // not Linux: no counters
+
+void PerfCounters::open_() { opened_ = true; }
+void PerfCounters::close_() { opened_ = false; }
+void PerfCounters::read_(UInt64 *values) const {
+  for (int e = 0; e < NUM_EVENTS; e++)
+    values[e] = 0u;
+}
+
+#endif
+
+} // namespace htm
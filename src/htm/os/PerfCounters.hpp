@@ -0,0 +1,101 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * PerfCounters interface
+ */
+
+#ifndef NTA_PERF_COUNTERS_HPP
+#define NTA_PERF_COUNTERS_HPP
+
+#include <htm/types/Types.hpp>
+#include <string>
+
+namespace htm {
+
+/**
+ * @Responsibility
+ * Hardware performance counters, a companion of Timer.
+ *
+ * @Description
+ * Like a Timer, it is started and stopped around a section of code and
+ * accumulates, but counts CPU cycles, retired instructions, last level cache
+ * misses and mispredicted branches of the calling thread (user space only).
+ *
+ * Uses Linux perf_event. Where that is not available (other OS, no permission
+ * in /proc/sys/kernel/perf_event_paranoid, a VM without a PMU) the counters
+ * which cannot be opened read 0 and isAvailable() is false; nothing fails.
+ * The counters are opened on the first start(), so an unused object costs nothing.
+ *
+ * The counters belong to the thread which called the first start(); start()
+ * and stop() must be called from that thread.
+ */
+class PerfCounters {
+public:
+  enum Event { CYCLES = 0, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, NUM_EVENTS };
+
+  PerfCounters(bool startme = false);
+  ~PerfCounters();
+
+  /** Copies the accumulated counts, the copy opens its own counters. */
+  PerfCounters(const PerfCounters &other);
+  PerfCounters &operator=(const PerfCounters &other);
+
+  void start();
+
+  /** Stop counting. When restarted, the counts accumulate. */
+  void stop();
+
+  /** Set the accumulated counts to zero. */
+  void reset();
+
+  bool isStarted() const { return started_; }
+
+  /** Accumulated count of the event, 0 if it could not be opened. */
+  UInt64 get(Event e) const { return counts_[e]; }
+
+  /** True if the event could be opened, after the first start(). */
+  bool isAvailable(Event e) const { return fds_[e] >= 0; }
+
+  /** True if any event could be opened on this system and thread. */
+  bool isAvailable() const;
+
+  /** Names used in toJSON(): cycles, instructions, cacheMisses, branchMisses. */
+  static const char *getName(Event e);
+
+  /**
+   * The counts as a JSON object, e.g. {"cycles": 123, "instructions": 456, ...}.
+   * Events which are not available are left out, so this is {} if none is.
+   * @param divisor - the counts are divided by it, e.g. per iteration.
+   */
+  std::string toJSON(Real64 divisor = 1.0) const;
+
+private:
+  void open_();
+  void close_();
+  void read_(UInt64 *values) const;
+
+  int fds_[NUM_EVENTS];
+  bool opened_ = false;
+  bool started_ = false;
+  UInt64 counts_[NUM_EVENTS];
+  UInt64 startValues_[NUM_EVENTS];
+}; // class PerfCounters
+
+} // namespace htm
+
+#endif // NTA_PERF_COUNTERS_HPP
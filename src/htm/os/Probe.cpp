@@ -0,0 +1,187 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Probe implementation
+ */
+
+#include <htm/os/Probe.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <limits>
+#include <mutex>
+#include <sstream>
+
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+namespace {
+
+Real64 calibrate() {
+#if defined(__aarch64__) && !defined(_MSC_VER)
+  UInt64 frequency;
+  asm volatile("mrs %0, cntfrq_el0" : "=r"(frequency));
+  if (frequency != 0u) return static_cast<Real64>(frequency);
+#endif
+  // Count the ticks of 20 ms of steady_clock.
+  using clock = std::chrono::steady_clock;
+  const auto t0 = clock::now();
+  const UInt64 c0 = TscClock::now();
+  auto t1 = t0;
+  while (t1 - t0 < std::chrono::milliseconds(20))
+    t1 = clock::now();
+  const UInt64 c1 = TscClock::now();
+  return static_cast<Real64>(c1 - c0) / std::chrono::duration<Real64>(t1 - t0).count();
+}
+
+// The counters of one probe in one thread.  Only the thread writes them,
+// the relaxed atomics let snapshot() read them meanwhile.
+struct Slot {
+  std::atomic<UInt64> calls{0u};
+  std::atomic<UInt64> ticks{0u};
+  std::atomic<UInt64> minTicks{std::numeric_limits<UInt64>::max()};
+  std::atomic<UInt64> maxTicks{0u};
+
+  void clear() {
+    calls.store(0u, std::memory_order_relaxed);
+    ticks.store(0u, std::memory_order_relaxed);
+    minTicks.store(std::numeric_limits<UInt64>::max(), std::memory_order_relaxed);
+    maxTicks.store(0u, std::memory_order_relaxed);
+  }
+};
+
+void mergeInto(ProbeStats &stats, const Slot &slot) {
+  const UInt64 calls = slot.calls.load(std::memory_order_relaxed);
+  if (calls == 0u) return;
+  const UInt64 minTicks = slot.minTicks.load(std::memory_order_relaxed);
+  stats.minTicks = stats.calls == 0u ? minTicks : std::min(stats.minTicks, minTicks);
+  stats.maxTicks = std::max(stats.maxTicks, slot.maxTicks.load(std::memory_order_relaxed));
+  stats.calls += calls;
+  stats.ticks += slot.ticks.load(std::memory_order_relaxed);
+}
+
+struct ThreadCounters;
+
+struct Registry {
+  std::mutex mutex;
+  std::vector<const char *> names;          // of the probes, by id
+  std::vector<ThreadCounters *> threads;    // running
+  std::vector<ProbeStats> retired;          // totals of the threads which exited
+};
+
+// Never destroyed: threads may exit after the static destructors ran.
+Registry &registry() {
+  static Registry *instance = new Registry();
+  return *instance;
+}
+
+struct ThreadCounters {
+  Slot slots[Probe::MAX_PROBES];
+
+  ThreadCounters() {
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.threads.push_back(this);
+  }
+
+  ~ThreadCounters() {
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.retired.resize(r.names.size());
+    for (size_t i = 0; i < r.names.size(); i++)
+      mergeInto(r.retired[i], slots[i]);
+    r.threads.erase(std::find(r.threads.begin(), r.threads.end(), this));
+  }
+};
+
+thread_local ThreadCounters threadCounters;
+
+} // namespace
+
+
+Real64 TscClock::ticksPerSecond() {
+  static const Real64 rate = calibrate();
+  return rate;
+}
+
+
+Probe::Probe(const char *name) : name_(name) {
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  NTA_CHECK(r.names.size() < MAX_PROBES) << "Probe: more than " << MAX_PROBES << " probes, at " << name;
+  id_ = r.names.size();
+  r.names.push_back(name);
+}
+
+
+void Probe::add(const UInt64 ticks) {
+  Slot &slot = threadCounters.slots[id_];
+  slot.calls.store(slot.calls.load(std::memory_order_relaxed) + 1u, std::memory_order_relaxed);
+  slot.ticks.store(slot.ticks.load(std::memory_order_relaxed) + ticks, std::memory_order_relaxed);
+  if (ticks < slot.minTicks.load(std::memory_order_relaxed))
+    slot.minTicks.store(ticks, std::memory_order_relaxed);
+  if (ticks > slot.maxTicks.load(std::memory_order_relaxed))
+    slot.maxTicks.store(ticks, std::memory_order_relaxed);
+}
+
+
+std::vector<ProbeStats> Probe::snapshot() {
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  std::vector<ProbeStats> stats(r.names.size());
+  for (size_t i = 0; i < stats.size(); i++) {
+    if (i < r.retired.size()) stats[i] = r.retired[i];
+    stats[i].name = r.names[i];
+    for (const ThreadCounters *thread : r.threads)
+      mergeInto(stats[i], thread->slots[i]);
+  }
+  return stats;
+}
+
+
+void Probe::reset() {
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  r.retired.clear();
+  for (ThreadCounters *thread : r.threads)
+    for (auto &slot : thread->slots)
+      slot.clear();
+}
+
+
+std::string Probe::report() {
+  const Real64 nsPerTick = 1.0e9 / TscClock::ticksPerSecond();
+  std::ostringstream out;
+  out << std::left << std::setw(40) << "probe" << std::right << std::setw(12) << "calls"
+      << std::setw(12) << "total ms" << std::setw(12) << "mean ns" << std::setw(12) << "min ns"
+      << std::setw(12) << "max ns" << "\n";
+  out << std::fixed;
+  for (const auto &s : snapshot()) {
+    out << std::left << std::setw(40) << s.name << std::right << std::setw(12) << s.calls
+        << std::setprecision(3) << std::setw(12) << s.seconds() * 1.0e3
+        << std::setprecision(1) << std::setw(12) << s.meanSeconds() * 1.0e9
+        << std::setw(12) << static_cast<Real64>(s.minTicks) * nsPerTick
+        << std::setw(12) << static_cast<Real64>(s.maxTicks) * nsPerTick << "\n";
+  }
+  return out.str();
+}
+
+} // namespace htm
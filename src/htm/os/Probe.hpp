@@ -0,0 +1,167 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Probe interface: scoped timers on the CPU's time stamp counter
+ */
+
+#ifndef NTA_PROBE_HPP
+#define NTA_PROBE_HPP
+
+#include <htm/types/Types.hpp>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+namespace htm {
+
+/**
+ * @Responsibility
+ * The cheapest clock of the CPU.
+ *
+ * @Description
+ * rdtsc on x86 (invariant on every CPU of the last decade), cntvct_el0 on
+ * ARM64, std::chrono::steady_clock elsewhere.  A read costs a few ns
+ * instead of the 20-30 ns of a Timer's now().  The ticks per second are
+ * calibrated against steady_clock on the first call of ticksPerSecond().
+ */
+class TscClock {
+public:
+  static inline UInt64 now() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    UInt64 ticks;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return static_cast<UInt64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+  }
+
+  static Real64 ticksPerSecond();
+  static Real64 toSeconds(UInt64 ticks) { return static_cast<Real64>(ticks) / ticksPerSecond(); }
+};
+
+
+/** The totals of a Probe, over all threads. */
+struct ProbeStats {
+  std::string name;
+  UInt64 calls = 0u;
+  UInt64 ticks = 0u;      // TscClock ticks, in total
+  UInt64 minTicks = 0u;   // of one call
+  UInt64 maxTicks = 0u;
+
+  Real64 seconds() const { return TscClock::toSeconds(ticks); }
+  Real64 meanSeconds() const { return calls == 0u ? 0.0 : seconds() / static_cast<Real64>(calls); }
+};
+
+
+/**
+ * @Responsibility
+ * A named point of fine-grained instrumentation.
+ *
+ * @Description
+ * Every thread adds the time of a probe to its own counters, without
+ * locking or atomic read-modify-writes; snapshot() merges the counters of
+ * the running threads and of those which exited.  Probes are meant to be
+ * static, see HTM_PROBE, and live until the end of the program.  At most
+ * MAX_PROBES can exist.
+ *
+ * Example:
+ *     void Connections::computeActivity(...) {
+ *       HTM_PROBE("Connections::computeActivity");
+ *       ...
+ *     }
+ *     ...
+ *     std::cout << Probe::report();
+ */
+class Probe {
+public:
+  static constexpr size_t MAX_PROBES = 256u;
+
+  /** @param name - a string literal, it is not copied. */
+  explicit Probe(const char *name);
+  Probe(const Probe &) = delete;
+  Probe &operator=(const Probe &) = delete;
+
+  const char *name() const { return name_; }
+
+  /** Add one call of "ticks" to the calling thread's counters. */
+  void add(UInt64 ticks);
+
+  /** The totals of every probe, in the order they were created. */
+  static std::vector<ProbeStats> snapshot();
+
+  /**
+   * Set the counters of all probes, of all threads, to 0.  Call it while no
+   * probe runs, else a running thread may keep part of its counts.
+   */
+  static void reset();
+
+  /** A table of snapshot(): name, calls, total ms, mean ns, min ns, max ns. */
+  static std::string report();
+
+private:
+  const char *name_;
+  size_t id_;
+};
+
+
+/**
+ * @Responsibility
+ * Adds the time of its scope to a Probe.
+ */
+class ScopedTimer {
+public:
+  explicit ScopedTimer(Probe &probe) : probe_(probe), start_(TscClock::now()) {}
+  ~ScopedTimer() { probe_.add(TscClock::now() - start_); }
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+  Probe &probe_;
+  UInt64 start_;
+};
+
+} // namespace htm
+
+
+// HTM_PROBE("name") times the rest of its scope.  Without the compile
+// definition HTM_PROBES (CMake option HTM_PROBES) it compiles to nothing.
+#define HTM_PROBE_CAT_(a, b) a##b
+#define HTM_PROBE_NAME_(a, b) HTM_PROBE_CAT_(a, b)
+#ifdef HTM_PROBES
+#define HTM_PROBE(name)                                                        \
+  static htm::Probe HTM_PROBE_NAME_(htm_probe_, __LINE__)(name);               \
+  htm::ScopedTimer HTM_PROBE_NAME_(htm_probe_timer_, __LINE__)(                \
+      HTM_PROBE_NAME_(htm_probe_, __LINE__))
+#else
+#define HTM_PROBE(name) static_cast<void>(0)
+#endif
+
+#endif // NTA_PROBE_HPP
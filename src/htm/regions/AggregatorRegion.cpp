@@ -0,0 +1,215 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the AggregatorRegion
+ */
+
+#include <htm/regions/AggregatorRegion.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <htm/engine/Input.hpp>
+#include <htm/engine/Output.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/engine/Spec.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+/* static */ Spec *AggregatorRegion::createSpec() {
+  Spec *ns = new Spec();
+  ns->parseSpec(R"(
+  {name: "AggregatorRegion",
+      description: "Aggregates the records of each window into one: a window of records, or of time.",
+      parameters: {
+          operation:     {description: "Of each value over a window: mean, min, max, sum or last.",
+                          type: String, default: "mean"},
+          windowSize:    {description: "Records per window, or 0 for windows of windowSeconds.",
+                          type: UInt32, default: "0"},
+          windowSeconds: {description: "Seconds per window, by input timestamp, or 0 for windows of windowSize.",
+                          type: Int64, default: "0"},
+          windows:       {description: "Windows closed so far.",
+                          type: UInt64, access: ReadOnly}},
+      inputs: {
+          values:        {description: "The values of a record.",
+                          type: Real64, count: 0, isDefaultInput: yes, isRegionLevel: yes},
+          timestamp:     {description: "The time of the record, in seconds since the Unix epoch.",
+                          type: Int64, count: 1, isRegionLevel: no}},
+      outputs: {
+          values:        {description: "The aggregated values of the last closed window, held while a window is open.",
+                          type: Real64, count: 0, isDefaultOutput: yes, isRegionLevel: yes},
+          timestamp:     {description: "The start of the last closed window.",
+                          type: Int64, count: 1, isRegionLevel: no}}
+  } )");
+  return ns;
+}
+
+
+AggregatorRegion::AggregatorRegion(const ValueMap &par, Region *region)
+    : RegionImpl(region) {
+  spec_.reset(createSpec());
+  ValueMap params = ValidateParameters(par, spec_.get());
+  operation_ = params.getString("operation", "mean");
+  op_ = parseOperation_(operation_);
+  windowSize_ = params.getScalarT<UInt32>("windowSize");
+  windowSeconds_ = params.getScalarT<Int64>("windowSeconds");
+  NTA_CHECK((windowSize_ > 0u) != (windowSeconds_ > 0))
+      << "AggregatorRegion: set one of windowSize or windowSeconds, got "
+      << windowSize_ << " and " << windowSeconds_;
+}
+
+AggregatorRegion::AggregatorRegion(ArWrapper &wrapper, Region *region)
+    : RegionImpl(region) {
+  cereal_adapter_load(wrapper);
+  op_ = parseOperation_(operation_);
+}
+
+AggregatorRegion::~AggregatorRegion() {}
+
+
+/* static */ AggregatorRegion::Operation AggregatorRegion::parseOperation_(const std::string &name) {
+  if (name == "mean") return Operation::MEAN;
+  if (name == "min")  return Operation::MIN;
+  if (name == "max")  return Operation::MAX;
+  if (name == "sum")  return Operation::SUM;
+  if (name == "last") return Operation::LAST;
+  NTA_THROW << "AggregatorRegion: unknown operation '" << name << "', expected mean, min, max, sum or last.";
+}
+
+
+void AggregatorRegion::initialize() {
+  NTA_CHECK(windowSeconds_ == 0 || timestamp_->hasIncomingLinks())
+      << "AggregatorRegion: windowSeconds needs a link to input timestamp.";
+  const size_t count = valuesOut_->getData().getCount();
+  if (accumulated_.size() != count) {  // else restored
+    accumulated_.assign(count, 0.0);
+    counts_.assign(count, 0u);
+    records_ = 0u;
+  }
+  // Nothing to read downstream until the first window closes.
+  std::fill_n(static_cast<Real64 *>(valuesOut_->getData().getBuffer()), count,
+              std::numeric_limits<Real64>::quiet_NaN());
+}
+
+
+void AggregatorRegion::compute() {
+  const Array &in = values_->getData();
+  NTA_CHECK(in.getCount() == accumulated_.size())
+      << "AggregatorRegion: expected " << accumulated_.size() << " values, got " << in.getCount();
+  const Int64 time = timestamp_->hasIncomingLinks()
+      ? static_cast<const Int64 *>(timestamp_->getData().getBuffer())[0] : 0;
+
+  bool closed = false;
+  if (windowSeconds_ > 0) {
+    // Floor, so that windows line up across zero as well.
+    const Int64 start = (time >= 0 ? time : time - windowSeconds_ + 1) / windowSeconds_ * windowSeconds_;
+    if (records_ > 0u && start != start_) {
+      close_();
+      closed = true;
+    }
+    if (records_ == 0u) start_ = start;
+  } else if (records_ == 0u) {
+    start_ = time;
+  }
+
+  add_(static_cast<const Real64 *>(in.getBuffer()), in.getCount());
+
+  if (windowSize_ > 0u && records_ == windowSize_) {
+    close_();
+    closed = true;
+  }
+  // The engine keeps the regions behind from computing on a window still open.
+  valuesOut_->setHeld(!closed);
+  timestampOut_->setHeld(!closed);
+}
+
+
+void AggregatorRegion::add_(const Real64 *values, const size_t count) {
+  for (size_t i = 0u; i < count; i++) {
+    const Real64 value = values[i];
+    if (!std::isfinite(value)) continue;
+    Real64 &acc = accumulated_[i];
+    if (counts_[i] == 0u) {
+      acc = value;
+    } else {
+      switch (op_) {
+        case Operation::MEAN:
+        case Operation::SUM:  acc += value; break;
+        case Operation::MIN:  acc = std::min(acc, value); break;
+        case Operation::MAX:  acc = std::max(acc, value); break;
+        case Operation::LAST: acc = value; break;
+      }
+    }
+    counts_[i]++;
+  }
+  records_++;
+}
+
+
+void AggregatorRegion::close_() {
+  Real64 *out = static_cast<Real64 *>(valuesOut_->getData().getBuffer());
+  for (size_t i = 0u; i < accumulated_.size(); i++) {
+    if (counts_[i] == 0u)
+      out[i] = std::numeric_limits<Real64>::quiet_NaN();
+    else if (op_ == Operation::MEAN)
+      out[i] = accumulated_[i] / counts_[i];
+    else
+      out[i] = accumulated_[i];
+  }
+  static_cast<Int64 *>(timestampOut_->getData().getBuffer())[0] = start_;
+
+  std::fill(accumulated_.begin(), accumulated_.end(), 0.0);
+  std::fill(counts_.begin(), counts_.end(), 0u);
+  records_ = 0u;
+  windows_++;
+}
+
+
+std::string AggregatorRegion::getParameterString(const std::string &name, Int64 index) const {
+  if (name == "operation") return operation_;
+  return RegionImpl::getParameterString(name, index);
+}
+
+UInt32 AggregatorRegion::getParameterUInt32(const std::string &name, Int64 index) const {
+  if (name == "windowSize") return windowSize_;
+  return RegionImpl::getParameterUInt32(name, index);
+}
+
+Int64 AggregatorRegion::getParameterInt64(const std::string &name, Int64 index) const {
+  if (name == "windowSeconds") return windowSeconds_;
+  return RegionImpl::getParameterInt64(name, index);
+}
+
+UInt64 AggregatorRegion::getParameterUInt64(const std::string &name, Int64 index) const {
+  if (name == "windows") return windows_;
+  return RegionImpl::getParameterUInt64(name, index);
+}
+
+
+bool AggregatorRegion::operator==(const RegionImpl &o) const {
+  if (o.getType() != "AggregatorRegion") return false;
+  const AggregatorRegion &other = static_cast<const AggregatorRegion &>(o);
+  return operation_ == other.operation_ && windowSize_ == other.windowSize_
+      && windowSeconds_ == other.windowSeconds_ && accumulated_ == other.accumulated_
+      && counts_ == other.counts_ && records_ == other.records_ && start_ == other.start_
+      && windows_ == other.windows_;
+}
+
+} // namespace htm
@@ -0,0 +1,146 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Defines AggregatorRegion, which downsamples a stream of records.
+ */
+
+#ifndef NTA_AGGREGATOR_REGION_HPP
+#define NTA_AGGREGATOR_REGION_HPP
+
+#include <string>
+#include <vector>
+
+#include <htm/engine/RegionImpl.hpp>
+#include <htm/ntypes/Value.hpp>
+#include <htm/types/Serializable.hpp>
+
+namespace htm {
+
+/**
+ * A network region which aggregates the records of a window into one, ahead
+ * of the encoders, eg. samples at 1 Hz into a model at 1 minute resolution.
+ *
+ * @b Description
+ * Each compute adds the record on input "values" to the open window.  A
+ * window is "windowSize" records, or with "windowSeconds" the records whose
+ * input "timestamp" (Unix time in seconds, as for DateEncoderRegion) falls
+ * in the same interval [k * windowSeconds, (k + 1) * windowSeconds); a
+ * record of a later interval closes the window before it is added.
+ *
+ * When a window closes, the output "values" is the "operation" of each
+ * value over the window: mean, min, max, sum or last; values which are not
+ * finite are left out (NaN if there was none).  The output "timestamp" is
+ * the start of the window: the start of its interval, or the time of its
+ * first record.  While the window is open both outputs are held (see
+ * Output::isHeld()), so the regions which read only from them (eg. the
+ * encoders, SP and TM behind) do not compute.
+ *
+ * Parameters:
+ *   operation      - mean, min, max, sum or last.
+ *   windowSize     - records per window, or 0 for windows by time.
+ *   windowSeconds  - length of a window by time, or 0.
+ *   windows        - (read only) the windows closed so far.
+ *
+ * Not for a batched run (Network::setBatchSize()), which computes every
+ * record behind it.
+ *
+ * Example:
+ *    net.addRegion("agg", "AggregatorRegion", "{operation: mean, windowSeconds: 60}");
+ *    net.addRegion("enc", "RDSEEncoderRegion", ...);
+ *    net.addRegion("date", "DateEncoderRegion", ...);
+ *    net.link("INPUT", "agg", "", "{dim: 1}", "value", "values");
+ *    net.link("INPUT", "agg", "", "{dim: 1}", "time", "timestamp");
+ *    net.link("agg", "enc", "", "", "values", "values");
+ *    net.link("agg", "date", "", "", "timestamp", "values");
+ */
+class AggregatorRegion : public RegionImpl, Serializable {
+public:
+  AggregatorRegion(const ValueMap &params, Region *region);
+  AggregatorRegion(ArWrapper &wrapper, Region *region);
+  virtual ~AggregatorRegion() override;
+
+  static Spec *createSpec();
+
+  void initialize() override;
+  void compute() override;
+
+  std::string getParameterString(const std::string &name, Int64 index = -1) const override;
+  UInt32 getParameterUInt32(const std::string &name, Int64 index = -1) const override;
+  Int64 getParameterInt64(const std::string &name, Int64 index = -1) const override;
+  UInt64 getParameterUInt64(const std::string &name, Int64 index = -1) const override;
+
+  CerealAdapter;  // see Serializable.hpp
+  // FOR Cereal Serialization
+  template<class Archive>
+  void save_ar(Archive& ar) const {
+    ar(cereal::make_nvp("operation", operation_),
+       cereal::make_nvp("windowSize", windowSize_),
+       cereal::make_nvp("windowSeconds", windowSeconds_),
+       cereal::make_nvp("accumulated", accumulated_),
+       cereal::make_nvp("counts", counts_),
+       cereal::make_nvp("records", records_),
+       cereal::make_nvp("start", start_),
+       cereal::make_nvp("windows", windows_));
+  }
+  // FOR Cereal Deserialization
+  template<class Archive>
+  void load_ar(Archive& ar) {
+    ar(cereal::make_nvp("operation", operation_),
+       cereal::make_nvp("windowSize", windowSize_),
+       cereal::make_nvp("windowSeconds", windowSeconds_),
+       cereal::make_nvp("accumulated", accumulated_),
+       cereal::make_nvp("counts", counts_),
+       cereal::make_nvp("records", records_),
+       cereal::make_nvp("start", start_),
+       cereal::make_nvp("windows", windows_));
+  }
+
+  bool operator==(const RegionImpl &other) const override;
+  inline bool operator!=(const AggregatorRegion &other) const {
+    return !operator==(other);
+  }
+
+private:
+  enum class Operation { MEAN, MIN, MAX, SUM, LAST };
+  static Operation parseOperation_(const std::string &name);
+
+  void add_(const Real64 *values, size_t count);
+  void close_();  // writes the outputs, empties the window
+
+  std::string operation_;
+  Operation op_ = Operation::MEAN;
+  UInt32 windowSize_;
+  Int64 windowSeconds_;
+
+  // The open window: per value the accumulated value and the number of
+  // finite values, the number of records and its start.
+  std::vector<Real64> accumulated_;
+  std::vector<UInt32> counts_;
+  UInt32 records_ = 0u;
+  Int64 start_ = 0;
+  UInt64 windows_ = 0u;
+
+  InputHandle values_{this, "values"};
+  InputHandle timestamp_{this, "timestamp"};
+  OutputHandle valuesOut_{this, "values"};
+  OutputHandle timestampOut_{this, "timestamp"};
+};
+
+} // namespace htm
+
+#endif // NTA_AGGREGATOR_REGION_HPP
@@ -32,6 +32,9 @@
  * The 'predicted' output is an index into the 'pdf' and 'titles' arrays corresponding
  * to the bucket that has the highest probability of a match with the given pattern.
  *
+ * With the parameter 'topK' > 0, 'pdf' and 'titles' are only the k most likely buckets,
+ * most likely first, so 'predicted' is 0.
+ *
  * An example of the bucket values are:
  *   Assume the radius of the encoder is 0.01
  *   The bucket 1.00 will contain all values >= 1.00 and < 1.01.
@@ -61,9 +64,11 @@
 #include <htm/ntypes/Array.hpp>
 #include <htm/utils/Log.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <memory>
 #include <vector>
-#include <map>
 
 namespace htm {
 
@@ -75,6 +80,8 @@ namespace htm {
     parameters: {
       learn:    { description: "if true, it performs the learn step",
                            type: Bool, access: ReadWrite, default: "true"},
+      topK:     { description: "if > 0, pdf and titles are only the k most likely buckets, most likely first",
+                           type: UInt32, access: ReadWrite, default: "0"},
     },
     inputs: {
       bucket:  { description: "The quantized value of the current sample, one from each encoder if more than one, for the learn step",
@@ -83,7 +90,7 @@ namespace htm {
                            type: SDR, count: 0} 
     }, 
     outputs: {
-      pdf:       { description: "probability distribution function (pdf) for each category or bucket. Sorted by title.  Warning, buffer length will grow.",
+      pdf:       { description: "probability distribution function (pdf) for each category or bucket. Sorted by title, or the topK most likely.  Warning, buffer length will grow.",
                            type: Real64, count: 0},
       titles:    { description: "Quantized values of used samples which are the Titles corresponding to the pdf indexes. Sorted by title. Warning, buffer length will grow.",
                            type: Real64, count: 0},
@@ -102,6 +109,7 @@ ClassifierRegion::ClassifierRegion(const ValueMap &par, Region *region) : Region
   spec_.reset(createSpec());
   ValueMap params = ValidateParameters(par, spec_.get());
   learn_ = params["learn"].as<bool>();
+  topK_ = params.getScalarT<UInt32>("topK");
   Real32 alpha = 0.001f;
 
   classifier_ = std::make_shared<Classifier>(alpha);
@@ -138,12 +146,12 @@ Dimensions ClassifierRegion::askImplForOutputDimensions(const std::string &name)
 
 
 void ClassifierRegion::compute() {
-  SDR &pattern = getInput("pattern")->getData().getSDR();
+  SDR &pattern = pattern_->getData().getSDR();
   // Note: if there is no link to 'pattern' input, the 'pattern' SDR length is 0
   //       and SDRClassifier::infer() will throw an exception.
 
-  if (learn_) {
-    Array &b = getInput("bucket")->getData();
+  if (learn_ && !isDegraded()) {
+    Array &b = bucket_->getData();
     // 'bucket' is a list of quantized samples being processed for this iteration.
     // There are one of these for each encoder (or value being encoded).
     // The values might not be consecutive, or in different ranges, or different things entirely.
@@ -152,49 +160,119 @@ void ClassifierRegion::compute() {
     // we can presented to the Classifier which produces the pdf.  Note that the indexes used
     // by the classifier are not sorted by title but rather by the order in which an index is first seen.
     std::vector<UInt> categoryIdxList;
-    Real64 *quantizedSample = reinterpret_cast<Real64*>(b.getBuffer());
-    UInt c = 0;
+    const Real64 *quantizedSample = reinterpret_cast<const Real64*>(b.getBuffer());
     for (size_t i = 0; i < b.getCount(); i++) {
-      auto it = bucketListMap.find(quantizedSample[i]);
-      if (it == bucketListMap.end()) {
-        // This is a sample we have not seen before. Add it to the bucketList.
-        c = static_cast<UInt>(bucketList.size());
-        bucketList.push_back(quantizedSample[i]);
-        bucketListMap[quantizedSample[i]] = c;
-      } else {
-        c = it->second;
-      }
-      categoryIdxList.push_back(c);
+      const auto it = bucketIndex_.find(quantizedSample[i]);
+      categoryIdxList.push_back(it != bucketIndex_.end() ? it->second : addBucket_(quantizedSample[i]));
     }
     classifier_->learn(pattern, categoryIdxList);
   }
-  PDF pdf = classifier_->infer(pattern);
+
+  // Infer only if an output is linked or watched, else when one is read.
+  const bool pdf = isDemanded(pdf_);
+  const bool titles = isDemanded(titles_);
+  const bool predicted = isDemanded(predicted_);
+  if (pdf || titles || predicted)
+    infer_();
+}
+
+
+void ClassifierRegion::computeOutput(const std::string &name) {
+  // All three outputs come from one infer().
+  infer_();
+  pdf_->setStale(false);
+  titles_->setStale(false);
+  predicted_->setStale(false);
+}
+
+
+UInt32 ClassifierRegion::addBucket_(const Real64 title) {
+  // This is a sample we have not seen before. Add it to the bucketList, and
+  // its category at the place of its title in the title order.
+  const UInt32 c = static_cast<UInt32>(bucketList.size());
+  bucketList.push_back(title);
+  bucketIndex_[title] = c;
+  const auto pos = std::upper_bound(titleOrder_.begin(), titleOrder_.end(), title,
+      [this](const Real64 t, const UInt32 other) { return t < bucketList[other]; });
+  titleOrder_.insert(pos, c);
+  return c;
+}
+
+
+void ClassifierRegion::indexBuckets_() {
+  bucketIndex_.clear();
+  titleOrder_.resize(bucketList.size());
+  for (UInt32 c = 0; c < bucketList.size(); c++) {
+    bucketIndex_[bucketList[c]] = c;
+    titleOrder_[c] = c;
+  }
+  std::stable_sort(titleOrder_.begin(), titleOrder_.end(),
+      [this](const UInt32 a, const UInt32 b) { return bucketList[a] < bucketList[b]; });
+  titlesWritten_ = 0u;
+}
+
+
+void ClassifierRegion::infer_() {
+  if (topK_ > 0u) {
+    inferTopK_();
+    return;
+  }
+  const PDF pdf = classifier_->infer(pattern_->getData().getSDR());
+  const size_t n = std::min(pdf.size(), titleOrder_.size());
 
   // Adjust the buffer size to match the pdf.
-  if (getOutput("pdf")->getData().getCount() < pdf.size()) {
-    UInt size = static_cast<UInt>(pdf.size());
-    getOutput("pdf")->resize(size);
-    getOutput("titles")->resize(size);
+  if (pdf_->getData().getCount() != std::max<size_t>(n, 1u)) {
+    pdf_->resize(std::max<size_t>(n, 1u));
+    titles_->resize(std::max<size_t>(n, 1u));
+    titlesWritten_ = 0u;
+  }
+
+  // Populate the outputs. pdf and titles output arrays are sorted by the title,
+  // a gather through titleOrder_. The titles only change with a new bucket.
+  Real64 *out = reinterpret_cast<Real64 *>(pdf_->getData().getBuffer());
+  const UInt32 *order = titleOrder_.data();
+  for (size_t j = 0; j < n; j++)
+    out[j] = pdf[order[j]];
+  if (titlesWritten_ != n) {
+    Real64 *titles = reinterpret_cast<Real64 *>(titles_->getData().getBuffer());
+    for (size_t j = 0; j < n; j++)
+      titles[j] = bucketList[order[j]];
+    titlesWritten_ = n;
+  }
+  // The index of the quantized sample with the highest probability of matching the pattern, the first of equals.
+  UInt32 *predicted = reinterpret_cast<UInt32 *>(predicted_->getData().getBuffer());
+  predicted[0] = n == 0u ? 0u : static_cast<UInt32>(std::max_element(out, out + n) - out);
+}
+
+
+void ClassifierRegion::inferTopK_() {
+  const TopK top = classifier_->inferTopK(pattern_->getData().getSDR(), topK_);
+  if (pdf_->getData().getCount() != topK_) {
+    pdf_->resize(topK_);
+    titles_->resize(topK_);
   }
+  titlesWritten_ = 0u;
 
-  // Populate the outputs. pdf and titles output arrays will be sorted by the title.
-  // The predicted output is an index into those sorted arrays.
-  Real64 *out = reinterpret_cast<Real64 *>(getOutput("pdf")->getData().getBuffer());
-  Real64 *titles = reinterpret_cast<Real64 *>(getOutput("titles")->getData().getBuffer());
-  UInt32 *predicted = reinterpret_cast<UInt32 *>(getOutput("predicted")->getData().getBuffer());
-  Real64 m = 0.0;
-  size_t j = 0;
-  predicted[0] = 0;
-  for (auto itm: bucketListMap) {
-    size_t i = itm.second;
-    if (pdf[i] > m) {
-      m = pdf[i];
-      predicted[0] = static_cast<UInt32>(j);  // index of the quantized sample with the highest probability of matching the pattern
+  // Most likely first; if there are fewer buckets than k, the rest is NaN.
+  Real64 *out = reinterpret_cast<Real64 *>(pdf_->getData().getBuffer());
+  Real64 *titles = reinterpret_cast<Real64 *>(titles_->getData().getBuffer());
+  for (size_t j = 0; j < topK_; j++) {
+    if (j < top.size()) {
+      out[j] = top[j].second;
+      titles[j] = bucketList[top[j].first];
+    } else {
+      out[j] = 0.0;
+      titles[j] = std::numeric_limits<Real64>::quiet_NaN();
     }
-    out[j] = pdf[i];
-    titles[j] = bucketList[i];
-    j++;
   }
+  reinterpret_cast<UInt32 *>(predicted_->getData().getBuffer())[0] = 0u;
+}
+
+
+MemoryUsage ClassifierRegion::memoryUsage() const {
+  MemoryUsage usage = classifier_ ? classifier_->memoryUsage() : MemoryUsage();
+  usage["buckets"] = memory::bytes(bucketList) + memory::bytes(bucketIndex_) + memory::bytes(titleOrder_);
+  return usage;
 }
 
 
@@ -211,10 +289,25 @@ bool ClassifierRegion::getParameterBool(const std::string &name, Int64 index) co
   else  return RegionImpl::getParameterBool(name, index);
 }
 
+void ClassifierRegion::setParameterUInt32(const std::string &name, Int64 index, UInt32 val) {
+  if (name == "topK")
+    topK_ = val;
+  else
+    RegionImpl::setParameterUInt32(name, index, val);
+}
+
+UInt32 ClassifierRegion::getParameterUInt32(const std::string &name, Int64 index) const {
+  if (name == "topK")
+    return topK_;
+  else  return RegionImpl::getParameterUInt32(name, index);
+}
+
 bool ClassifierRegion::operator==(const RegionImpl &other) const {
   if (other.getType() != "ClassifierRegion") return false;
   const ClassifierRegion &o = reinterpret_cast<const ClassifierRegion &>(other);
   if (learn_ != o.learn_)  return false;
+  if (topK_ != o.topK_)  return false;
+  if (bucketList.size() != o.bucketList.size())  return false;
   for (size_t i = 0; i < bucketList.size(); i++) {
     if (bucketList[i] != o.bucketList[i])
       return false;
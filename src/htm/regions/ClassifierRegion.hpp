@@ -24,7 +24,9 @@
 #ifndef NTA_CLASSIFIERREGION_HPP
 #define NTA_CLASSIFIERREGION_HPP
 
+#include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <htm/engine/RegionImpl.hpp>
@@ -43,7 +45,10 @@ namespace htm {
  * This is used when you need to "explain" the HTM network back to real-world,
  * ie. mapping SDRs back to digits in MNIST digit classification task.
  *
- *
+ * The outputs "pdf" and "titles" are in the order of the titles, through a
+ * permutation which changes only when a new bucket is learned.  With the
+ * parameter "topK" they are only the k most likely buckets instead, most
+ * likely first, and the full pdf is never built.
  */
 class ClassifierRegion : public RegionImpl, Serializable {
 public:
@@ -56,20 +61,32 @@ public:
 
   virtual bool getParameterBool(const std::string &name,   Int64 index = -1) const override;
   virtual void setParameterBool(const std::string &name, Int64 index, bool value) override;
+  virtual UInt32 getParameterUInt32(const std::string &name, Int64 index = -1) const override;
+  virtual void setParameterUInt32(const std::string &name, Int64 index, UInt32 value) override;
 
   virtual void initialize() override;
 
   void compute() override;
+  bool isPure() const override { return !learn_; }
+  bool canDegrade() const override { return true; } // skips learning
+  void computeOutput(const std::string &name) override;
+
+  MemoryUsage memoryUsage() const override;
 
   virtual Dimensions askImplForOutputDimensions(const std::string &name) override;
 
   CerealAdapter;  // see Serializable.hpp
   // FOR Cereal Serialization
+  // The map from title to category is saved as before, though only bucketList is needed.
   template<class Archive> void save_ar(Archive &ar) const {
+    std::map<Real64, UInt32> bucketListMap;
+    for (UInt32 c = 0; c < bucketList.size(); c++)
+      bucketListMap[bucketList[c]] = c;
     ar(cereal::make_nvp("learn", learn_));
     ar(cereal::make_nvp("bucketListMap", bucketListMap));
     ar(cereal::make_nvp("bucketList", bucketList));
     ar(cereal::make_nvp("classifier", classifier_));
+    ar(cereal::make_nvp("topK", topK_));
   }
   // FOR Cereal Deserialization
   // NOTE: the Region Implementation must have been allocated
@@ -78,10 +95,13 @@ public:
   //       the region_ field in the Base class.
   template<class Archive>
   void load_ar(Archive& ar) {
+    std::map<Real64, UInt32> bucketListMap;
     ar(cereal::make_nvp("learn", learn_));
     ar(cereal::make_nvp("bucketListMap", bucketListMap));
     ar(cereal::make_nvp("bucketList", bucketList));
     ar(cereal::make_nvp("classifier", classifier_));
+    ar(cereal::make_nvp("topK", topK_));
+    indexBuckets_();
   }
 
 
@@ -93,9 +113,23 @@ public:
 private:
   std::shared_ptr<Classifier> classifier_;
   bool learn_;
+  UInt32 topK_ = 0u;  // 0 for the full pdf
 
-  std::map<Real64, UInt32> bucketListMap;  //  Map containing titles or buckets ordered by quantized values.
   std::vector<Real64> bucketList;          //  Vector of titles ordered by order in which they were first seen to match Classifier.
+  std::unordered_map<Real64, UInt32> bucketIndex_;  // title -> index into bucketList, the Classifier's category
+  std::vector<UInt32> titleOrder_;         // the categories in the order of their titles
+  size_t titlesWritten_ = 0u;              // titles in the titles output, in the full pdf mode
+
+  InputHandle pattern_{this, "pattern"};
+  InputHandle bucket_{this, "bucket"};
+  OutputHandle pdf_{this, "pdf"};
+  OutputHandle titles_{this, "titles"};
+  OutputHandle predicted_{this, "predicted"};
+
+  UInt32 addBucket_(Real64 title);
+  void indexBuckets_();  // bucketIndex_ and titleOrder_ from bucketList
+  void infer_();  // all outputs
+  void inferTopK_();
 };
 } // namespace htm
 
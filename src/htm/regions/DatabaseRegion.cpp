@@ -44,7 +44,12 @@ static int SQLcallback(void *data, int argc, char **argv, char **azColName);
 
 DatabaseRegion::DatabaseRegion(const ValueMap &params, Region* region)
     : RegionImpl(region), filename_(""),
-	  dbHandle(nullptr),xTransactionActive(false) {
+	  dbHandle(nullptr),xTransactionActive(false),
+	  batchSize_(1000u), commitInterval_(0.0), walMode_(false), pendingRows_(0u) {
+  batchSize_      = params.getScalarT<UInt32>("batchSize", 1000u);
+  commitInterval_ = params.getScalarT<Real64>("commitInterval", 0.0);
+  walMode_        = params.getScalarT<bool>("walMode", false);
+  NTA_CHECK(commitInterval_ >= 0.0) << "DatabaseRegion: commitInterval must not be negative.";
   if (params.contains("outputFile")) {
     std::string s = params.getString("outputFile", "");
     openFile(s);
@@ -56,7 +61,8 @@ DatabaseRegion::DatabaseRegion(const ValueMap &params, Region* region)
 
 DatabaseRegion::DatabaseRegion(ArWrapper& wrapper, Region* region)
     : RegionImpl(region), filename_(""),
-	  dbHandle(nullptr),xTransactionActive(false) {
+	  dbHandle(nullptr),xTransactionActive(false),
+	  batchSize_(1000u), commitInterval_(0.0), walMode_(false), pendingRows_(0u) {
   cereal_adapter_load(wrapper);
 }
 
@@ -71,73 +77,112 @@ void DatabaseRegion::initialize() {
 
   NTA_ASSERT(inputs.size()!=0) << "DatabaseRegion::initialize - no inputs configured\n";
 
-  iTableCount = 0;
+  finalizeStatements();
+  streams_.clear();
 	for (const auto & inp : inputs) {
 		const auto inObj = inp.second;
 		if (inObj->hasIncomingLinks() && inObj->getData().getCount() != 0) { //create tables only for those, whose was configured
-			createTable("dataStream_" + inp.first);
-			iTableCount++;
+			Stream stream;
+			stream.tableName = "dataStream_" + inp.first;
+			stream.input = inObj;
+			streams_.push_back(stream);
 		}
 	}
-
+	if (dbHandle != nullptr)
+		createTables();
 }
 
-void DatabaseRegion::createTable(const std::string &sTableName){
+// Creates the table of each stream and prepares its INSERT statement,
+// so compute() only binds a value and steps the statement.
+void DatabaseRegion::createTables(){
 
-	/* Create SQL statement */
-	std::string  sql = "CREATE TABLE "+sTableName+" (iteration INTEGER PRIMARY KEY, value REAL);";
+	for (auto &stream : streams_) {
+		/* Create SQL statement */
+		ExecuteSQLcommand("CREATE TABLE IF NOT EXISTS " + stream.tableName
+		                  + " (iteration INTEGER PRIMARY KEY, value REAL);");
 
-	char *zErrMsg;
-	/* Execute SQL statement */
-	int returnCode = sqlite3_exec(dbHandle, sql.c_str(), nullptr, 0, &zErrMsg);
+		const std::string sql = "INSERT INTO " + stream.tableName + "(value) VALUES (?);";
+		int returnCode = sqlite3_prepare_v2(dbHandle, sql.c_str(), -1, &stream.insert, nullptr);
+		if( returnCode != SQLITE_OK ){
+			NTA_THROW << "Error preparing insert into SQL table " << stream.tableName
+			          << ", message:" << sqlite3_errmsg(dbHandle);
+		}
+	}
+}
 
-	if( returnCode != SQLITE_OK ){
-		NTA_THROW << "Error creating SQL table, message:"
-				  << zErrMsg;
-		sqlite3_free(zErrMsg);
+void DatabaseRegion::finalizeStatements(){
+	for (auto &stream : streams_) {
+		sqlite3_finalize(stream.insert); // harmless on nullptr
+		stream.insert = nullptr;
 	}
 }
 
-void DatabaseRegion::insertData(const std::string &sTableName, const std::shared_ptr<Input> inputData){
+void DatabaseRegion::beginTransaction(){
+	//starts transaction, for speedup. Transaction ends by a commit or by closing the file
+	ExecuteSQLcommand("BEGIN TRANSACTION");
+	xTransactionActive = true;
+	pendingRows_ = 0u;
+	lastCommit_ = std::chrono::steady_clock::now();
+}
 
-	NTA_ASSERT(inputData->getData().getCount()==1);
+void DatabaseRegion::commitTransaction(){
+	ExecuteSQLcommand("END TRANSACTION");//ends transaction. Now it flushes cache to the file.
+	xTransactionActive = false;
+	pendingRows_ = 0u;
+}
 
-	if(!xTransactionActive){
-		//starts transaction, for speedup. Transaction ends by closing the file
-		ExecuteSQLcommand("BEGIN TRANSACTION");
-		xTransactionActive = true;
+void DatabaseRegion::applyJournalMode(){
+	if (dbHandle == nullptr) return;
+	if (xTransactionActive) commitTransaction(); // journal mode cannot change inside a transaction
+	if (walMode_) {
+		// Readers (ie. HTMPandaVis) do not block the writer and a commit
+		// appends to the log without waiting for the disk.
+		ExecuteSQLcommand("PRAGMA journal_mode=WAL");
+		ExecuteSQLcommand("PRAGMA synchronous=NORMAL");
+	} else {
+		ExecuteSQLcommand("PRAGMA journal_mode=DELETE");
+		ExecuteSQLcommand("PRAGMA synchronous=FULL");
 	}
+}
 
-	Real32* value = (Real32 *)inputData->getData().getBuffer();
-	/* Create SQL statement */
-	std::string  sql = "INSERT INTO "+sTableName+"(value) VALUES ("+std::to_string(*value) + ");";
+void DatabaseRegion::insertData(sqlite3_stmt *stmt, const std::shared_ptr<Input> inputData){
 
-	char *zErrMsg;
+	NTA_ASSERT(inputData->getData().getCount()==1);
+	NTA_CHECK(stmt != nullptr) << "DatabaseRegion: no database file is open.";
 
-	int returnCode = sqlite3_exec(dbHandle, sql.c_str(), nullptr, 0, &zErrMsg);
+	const Real32* value = (const Real32 *)inputData->getData().getBuffer();
 
-	if( returnCode != SQLITE_OK ){
+	sqlite3_bind_double(stmt, 1, static_cast<double>(*value));
+	int returnCode = sqlite3_step(stmt);
+	sqlite3_reset(stmt);
+
+	if( returnCode != SQLITE_DONE ){
 		NTA_THROW << "Error inserting data to SQL table, message:"
-				  << zErrMsg;
-		sqlite3_free(zErrMsg);
+				  << sqlite3_errmsg(dbHandle);
 	}
 }
 
 void DatabaseRegion::compute() {
 
+	NTA_ASSERT(streams_.size()!=0) << "DatabaseRegion::compute - no inputs configured\n";
+	NTA_CHECK(dbHandle != nullptr) << "DatabaseRegion::compute - outputFile is not set.";
 
-	const std::map<std::string, std::shared_ptr<Input>> inputs = region_->getInputs();
-
-
-	NTA_ASSERT(inputs.size()!=0) << "DatabaseRegion::initialize - no inputs configured\n";
-
-	for (const auto & inp : inputs)
-	{
-		const auto inObj = inp.second;
-		if (inObj->hasIncomingLinks() && inObj->getData().getCount() != 0) { //create tables only for those, whose was configured
-			insertData("dataStream_" + inp.first, inObj);
+	// The previous batch is committed before this iteration is written, so a
+	// transaction is always open after compute() and 'commitTransaction' works.
+	if (xTransactionActive) {
+		bool commit = batchSize_ > 0u && pendingRows_ >= batchSize_;
+		if (!commit && commitInterval_ > 0.0) {
+			const std::chrono::duration<Real64> elapsed = std::chrono::steady_clock::now() - lastCommit_;
+			commit = elapsed.count() >= commitInterval_;
 		}
+		if (commit) commitTransaction();
 	}
+	if (!xTransactionActive)
+		beginTransaction();
+
+	for (const auto &stream : streams_)
+		insertData(stream.insert, stream.input);
+	pendingRows_++;
 }
 
 void DatabaseRegion::ExecuteSQLcommand(std::string sqlCommand){
@@ -157,10 +202,9 @@ void DatabaseRegion::ExecuteSQLcommand(std::string sqlCommand){
 void DatabaseRegion::closeFile() {
   if (dbHandle!=NULL) {
 
-  	if(xTransactionActive){
-  		ExecuteSQLcommand("END TRANSACTION");//ends transaction. Now it flushes cache to the file for.
-  		xTransactionActive=false;
-  	}
+  	if(xTransactionActive)
+  		commitTransaction();
+  	finalizeStatements();
 
 		sqlite3_close(dbHandle);
 		dbHandle = nullptr;
@@ -207,6 +251,10 @@ void DatabaseRegion::openFile(const std::string &filename) {
 
   //number of disk pages that will be hold in memory, adjust this to set up size of the cache
   ExecuteSQLcommand("PRAGMA cache_size=10000");
+  applyJournalMode();
+
+  // reopened after initialize(), the new file needs its tables again
+  createTables();
 
 }
 
@@ -226,10 +274,8 @@ UInt DatabaseRegion::getRowCount(){
 
 	UInt sumRowCount = 0;
 
-	for (UInt i = 0; i< iTableCount; i ++){
-		std::string sTableName = "dataStream_dataIn"+std::to_string(i);
-
-		std::string sql = "SELECT COUNT(*) FROM "+sTableName+";";
+	for (const auto &stream : streams_){
+		std::string sql = "SELECT COUNT(*) FROM "+stream.tableName+";";
 
 		char *zErrMsg;
 		int returnCode = sqlite3_exec(dbHandle, sql.c_str(), SQLcallback, 0, &zErrMsg);
@@ -270,6 +316,63 @@ std::string DatabaseRegion::getParameterString(const std::string &paramName,
   }
 }
 
+void DatabaseRegion::setParameterUInt32(const std::string &paramName,
+                                        Int64 index, UInt32 value) {
+  if (paramName == "batchSize") {
+    batchSize_ = value;
+  } else {
+    NTA_THROW << "DatabaseRegion -- Unknown UInt32 parameter " << paramName;
+  }
+}
+
+UInt32 DatabaseRegion::getParameterUInt32(const std::string &paramName,
+                                          Int64 index) const {
+  if (paramName == "batchSize") {
+    return batchSize_;
+  } else {
+    NTA_THROW << "DatabaseRegion -- unknown parameter " << paramName;
+  }
+}
+
+void DatabaseRegion::setParameterReal64(const std::string &paramName,
+                                        Int64 index, Real64 value) {
+  if (paramName == "commitInterval") {
+    NTA_CHECK(value >= 0.0) << "DatabaseRegion: commitInterval must not be negative.";
+    commitInterval_ = value;
+  } else {
+    NTA_THROW << "DatabaseRegion -- Unknown Real64 parameter " << paramName;
+  }
+}
+
+Real64 DatabaseRegion::getParameterReal64(const std::string &paramName,
+                                          Int64 index) const {
+  if (paramName == "commitInterval") {
+    return commitInterval_;
+  } else {
+    NTA_THROW << "DatabaseRegion -- unknown parameter " << paramName;
+  }
+}
+
+void DatabaseRegion::setParameterBool(const std::string &paramName,
+                                      Int64 index, bool value) {
+  if (paramName == "walMode") {
+    if (value == walMode_) return;
+    walMode_ = value;
+    applyJournalMode();
+  } else {
+    NTA_THROW << "DatabaseRegion -- Unknown bool parameter " << paramName;
+  }
+}
+
+bool DatabaseRegion::getParameterBool(const std::string &paramName,
+                                      Int64 index) const {
+  if (paramName == "walMode") {
+    return walMode_;
+  } else {
+    NTA_THROW << "DatabaseRegion -- unknown parameter " << paramName;
+  }
+}
+
 std::string
 DatabaseRegion::executeCommand(const std::vector<std::string> &args,
                                    Int64 index) {
@@ -281,8 +384,7 @@ DatabaseRegion::executeCommand(const std::vector<std::string> &args,
     return std::to_string(getRowCount());
   }else if (args[0] == "commitTransaction") {
   	if(xTransactionActive){
-			ExecuteSQLcommand("END TRANSACTION");//ends transaction. Now it flushes cache to the file.
-			xTransactionActive=false;
+			commitTransaction();
 		}else NTA_THROW << "DatabaseRegion: Cannot commit transaction, transaction is not active!";
   }
   else {
@@ -327,6 +429,38 @@ Spec *DatabaseRegion::createSpec() {
                             "", // defaultValue
                             ParameterSpec::ReadWriteAccess));
 
+  ns->parameters.add("batchSize",
+              ParameterSpec("Number of iterations written in one transaction. "
+                            "The transaction is committed when it is full. "
+                            "0 commits only on 'commitTransaction', "
+                            "'commitInterval' or when the file is closed.",
+                            NTA_BasicType_UInt32,
+                            1,      // elementCount
+                            "",     // constraints
+                            "1000", // defaultValue
+                            ParameterSpec::ReadWriteAccess));
+
+  ns->parameters.add("commitInterval",
+              ParameterSpec("Seconds after which the active transaction is "
+                            "committed, even if it holds less than 'batchSize' "
+                            "iterations. 0 turns the time limit off.",
+                            NTA_BasicType_Real64,
+                            1,     // elementCount
+                            "",    // constraints
+                            "0",   // defaultValue
+                            ParameterSpec::ReadWriteAccess));
+
+  ns->parameters.add("walMode",
+              ParameterSpec("Use write-ahead logging with asynchronous commits "
+                            "(PRAGMA synchronous=NORMAL). Faster and readers do "
+                            "not block writing, but the last transactions may "
+                            "be lost on a power failure.",
+                            NTA_BasicType_Bool,
+                            1,       // elementCount
+                            "bool",  // constraints
+                            "false", // defaultValue
+                            ParameterSpec::ReadWriteAccess));
+
   ns->commands.add("closeFile",
                    CommandSpec("Close the current database file, if open."));
   ns->commands.add("getRowCount",
@@ -350,6 +484,9 @@ bool DatabaseRegion::operator==(const RegionImpl &o) const {
   if (o.getType() != "DatabaseRegion") return false;
   DatabaseRegion& other = (DatabaseRegion&)o;
   if (filename_ != other.filename_) return false;
+  if (batchSize_ != other.batchSize_) return false;
+  if (commitInterval_ != other.commitInterval_) return false;
+  if (walMode_ != other.walMode_) return false;
 
   return true;
 }
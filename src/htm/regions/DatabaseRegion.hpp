@@ -32,6 +32,9 @@
 #include <htm/types/Serializable.hpp>
 #include <htm/ntypes/Value.hpp>
 
+#include <chrono>
+#include <vector>
+
 #include <sqlite3.h>
 
 namespace htm {
@@ -51,6 +54,12 @@ namespace htm {
  *  value. Iteration is incremented automatically by SQLite, since
  *  it is INTEGER PRIMARY KEY.
  *
+ *  Rows are written through one prepared INSERT statement per table
+ *  inside a transaction. The transaction is committed every 'batchSize'
+ *  iterations and/or every 'commitInterval' seconds, whichever comes first.
+ *  With 'walMode' the database uses write-ahead logging and commits do
+ *  not wait for the data to reach the disk (PRAGMA synchronous=NORMAL).
+ *
  */
 class DatabaseRegion : public RegionImpl, Serializable {
 public:
@@ -59,6 +68,12 @@ public:
   void setParameterString(const std::string &name, Int64 index,
                           const std::string &s) override;
   std::string getParameterString(const std::string &name, Int64 index) const override;
+  void setParameterUInt32(const std::string &name, Int64 index, UInt32 value) override;
+  UInt32 getParameterUInt32(const std::string &name, Int64 index) const override;
+  void setParameterReal64(const std::string &name, Int64 index, Real64 value) override;
+  Real64 getParameterReal64(const std::string &name, Int64 index) const override;
+  void setParameterBool(const std::string &name, Int64 index, bool value) override;
+  bool getParameterBool(const std::string &name, Int64 index) const override;
 
   void initialize() override;
 
@@ -73,6 +88,9 @@ public:
   // FOR Cereal Serialization
   template<class Archive>
   void save_ar(Archive& ar) const {
+    ar(cereal::make_nvp("batchSize", batchSize_));
+    ar(cereal::make_nvp("commitInterval", commitInterval_));
+    ar(cereal::make_nvp("walMode", walMode_));
     ar(cereal::make_nvp("outputFile", filename_));
     ar(CEREAL_NVP(dim_));  // in base class
   }
@@ -80,6 +98,9 @@ public:
   // FOR Cereal Deserialization
   template<class Archive>
   void load_ar(Archive& ar) {
+    ar(cereal::make_nvp("batchSize", batchSize_));
+    ar(cereal::make_nvp("commitInterval", commitInterval_));
+    ar(cereal::make_nvp("walMode", walMode_));
     ar(cereal::make_nvp("outputFile", filename_));
 		if (filename_ != "")
 		      openFile(filename_);
@@ -93,6 +114,7 @@ public:
 
 
   void compute() override;
+  bool isAsync() const override { return true; } // writes the database while the network computes on
 
   virtual std::string executeCommand(const std::vector<std::string> &args,
                                      Int64 index) override;
@@ -100,17 +122,34 @@ public:
 private:
   void closeFile();
   void openFile(const std::string &filename);
-  void createTable(const std::string &sTableName);
-  void insertData(const std::string &sTableName, const std::shared_ptr<Input> inputData);
+  void createTables();
+  void finalizeStatements();
+  void beginTransaction();
+  void commitTransaction();
+  void applyJournalMode();
+  void insertData(sqlite3_stmt *stmt, const std::shared_ptr<Input> inputData);
   UInt getRowCount();
   void ExecuteSQLcommand(std::string sqlCommand);
 
+  // One configured input and the prepared INSERT into its table.
+  struct Stream {
+    std::string tableName;
+    std::shared_ptr<Input> input;
+    sqlite3_stmt *insert = nullptr;
+  };
+
     std::string filename_;          // Name of the output file
 
     sqlite3 *dbHandle;		//Sqlite3 connection handle
-    htm::UInt iTableCount;
     bool xTransactionActive;
 
+    std::vector<Stream> streams_;   // filled by initialize()
+    UInt32 batchSize_;              // iterations per commit, 0 = no limit
+    Real64 commitInterval_;         // seconds between commits, 0 = no limit
+    bool walMode_;                  // write-ahead log, no fsync on commit
+    UInt32 pendingRows_;            // iterations written since the last commit
+    std::chrono::steady_clock::time_point lastCommit_;
+
   /// Disable unsupported default constructors
     DatabaseRegion(const DatabaseRegion &);
     DatabaseRegion &operator=(const DatabaseRegion &);
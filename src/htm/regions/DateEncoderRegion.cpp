@@ -144,11 +144,11 @@ Dimensions DateEncoderRegion::askImplForOutputDimensions(const std::string &name
 }
 
 void DateEncoderRegion::compute() {
-  if (hasInput("values")) {
-    Array &a = getInput("values")->getData();
+  if (values_->hasIncomingLinks()) {
+    Array &a = values_->getData();
     sensedTime_ = (time_t)((Int64 *)(a.getBuffer()))[0];
   }
-  SDR &output = getOutput("encoded")->getData().getSDR();
+  SDR &output = encoded_->getData().getSDR();
   encoder_->encode(sensedTime_, output);
 
   // Add some noise.
@@ -157,7 +157,7 @@ void DateEncoderRegion::compute() {
     output.addNoise(noise_, rnd_);
 
   // get the bucket values for each attribute configured.
-  Array &bucket_array = getOutput("bucket")->getData();
+  Array &bucket_array = bucket_->getData();
   Real64 *ptr = reinterpret_cast<Real64*>(bucket_array.getBuffer());
   for (size_t i = 0; i < encoder_->buckets.size(); i++) {
     ptr[i] = encoder_->buckets[i];
@@ -62,6 +62,7 @@ public:
   virtual void initialize() override;
 
   void compute() override;
+  bool isPure() const override { return noise_ == 0.0f; }
 
   virtual Dimensions askImplForOutputDimensions(const std::string &name) override;
 
@@ -99,6 +100,9 @@ private:
   Real32 noise_;
   Random rnd_;
   std::shared_ptr<DateEncoder> encoder_;
+  InputHandle values_{this, "values"};
+  OutputHandle encoded_{this, "encoded"};
+  OutputHandle bucket_{this, "bucket"};
 };
 } // namespace htm
 
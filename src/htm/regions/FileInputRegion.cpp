@@ -20,6 +20,8 @@
  *   (was VectorFileSensor )
  */
 
+#include <algorithm>
+#include <chrono>
 #include <cstring> // strlen
 #include <iostream>
 #include <list>
@@ -55,6 +57,8 @@ FileInputRegion::FileInputRegion(const ValueMap &params, Region *region)
       resetOut_(NTA_BasicType_Real32), filename_(""),
       recentFile_("") {
   repeatCount_ = params.getScalarT<UInt32>("repeatCount", 1);
+  readAhead_ = params.getScalarT<UInt32>("readAhead", 1024);
+  prefetchDepth_ = params.getScalarT<UInt32>("prefetchDepth", 0);
   activeOutputCount_ = params.getScalarT<UInt32>("activeOutputCount", 0);
   hasCategoryOut_ = params.getScalarT<UInt32>("hasCategoryOut", 0) == 1;
   hasResetOut_ = params.getScalarT<UInt32>("hasResetOut", 0) == 1;
@@ -67,7 +71,7 @@ FileInputRegion::FileInputRegion(const ValueMap &params, Region *region)
 }
 
 FileInputRegion::FileInputRegion(ArWrapper &wrapper, Region *region) 
-    : RegionImpl(region), repeatCount_(1), iterations_(0), curVector_(-1),
+    : RegionImpl(region), repeatCount_(1), readAhead_(1024), prefetchDepth_(0), iterations_(0), curVector_(-1),
       activeOutputCount_(0), hasCategoryOut_(false), hasResetOut_(false),
       dataOut_(NTA_BasicType_Real64), categoryOut_(NTA_BasicType_Real32),
       resetOut_(NTA_BasicType_Real32), filename_(""), scalingMode_("none"),
@@ -90,14 +94,14 @@ void FileInputRegion::initialize() {
   }
 }
 
-FileInputRegion::~FileInputRegion() {}
+FileInputRegion::~FileInputRegion() { stopPrefetch(); }
 
 //----------------------------------------------------------------------------
 
 void FileInputRegion::compute() {
   // It's not necessarily an error to have no outputs. In this case we just
   // return
-  dataOut_ = region_->getOutput("dataOut")->getData();
+  dataOut_ = dataOutHandle_->getData();
   if (dataOut_.getCount() == 0)
     return;
 
@@ -113,9 +117,50 @@ void FileInputRegion::compute() {
       << " execute command.";
 
   if (iterations_ % repeatCount_ == 0) {
-    // Get index to next vector and copy scaled vector to our output
-    curVector_++;
-    curVector_ %= vectorFile_.vectorCount();
+    if (prefetchDepth_ > 0) {
+      // Take the next staged vector from the producer thread.
+      if (!producer_.joinable())
+        startPrefetch();
+      if (holdingStaged_) {
+        staged_->pop();
+        holdingStaged_ = false;
+      }
+      Staged *next;
+      while ((next = staged_->front()) == nullptr) {
+        if (producerFailed_.load(std::memory_order_acquire)) {
+          std::exception_ptr error = producerError_;
+          stopPrefetch();
+          std::rethrow_exception(error);
+        }
+        std::this_thread::yield();
+      }
+      holdingStaged_ = true;
+      curVector_ = next->index;
+    } else {
+      // Get index to next vector and copy scaled vector to our output
+      curVector_++;
+      curVector_ %= vectorFile_.vectorCount();
+      // Memory mapped files: ask for the next batch of vectors ahead of time.
+      if (readAhead_ > 0 && curVector_ % readAhead_ == 0)
+        vectorFile_.prefetch(static_cast<Size>(curVector_), 2u * readAhead_);
+    }
+  }
+
+  if (holdingStaged_) {
+    // The producer did the scaling already; only copy it out.
+    const Staged &cur = *staged_->front();
+    if (hasCategoryOut_) {
+      categoryOut_ = categoryOutHandle_->getData();
+      *reinterpret_cast<Real64 *>(categoryOut_.getBuffer()) = cur.category;
+    }
+    if (hasResetOut_) {
+      resetOut_ = resetOutHandle_->getData();
+      *reinterpret_cast<Real64 *>(resetOut_.getBuffer()) = cur.reset;
+    }
+    NTA_ASSERT(cur.data.size() == dataOut_.getCount());
+    std::copy(cur.data.begin(), cur.data.end(), (Real64 *)dataOut_.getBuffer());
+    iterations_++;
+    return;
   }
 
   Real64 *out = (Real64 *)dataOut_.getBuffer();
@@ -124,32 +169,88 @@ void FileInputRegion::compute() {
   UInt offset = 0;
 
   if (hasCategoryOut_) {
-    categoryOut_ = region_->getOutput("categoryOut")->getData();
+    categoryOut_ = categoryOutHandle_->getData();
     Real64 *categoryOut = reinterpret_cast<Real64 *>(categoryOut_.getBuffer());
     vectorFile_.getRawVector((htm::UInt)curVector_, categoryOut, offset, 1);
     offset++;
 
     // trace facility
-    NTA_DEBUG << "compute " << region_->getOutput("categoryOut") << std::endl;
+    NTA_DEBUG << "compute " << *categoryOutHandle_ << std::endl;
   }
 
   if (hasResetOut_) {
-    resetOut_ = region_->getOutput("resetOut")->getData();
+    resetOut_ = resetOutHandle_->getData();
     Real64 *resetOut = reinterpret_cast<Real64 *>(resetOut_.getBuffer());
     vectorFile_.getRawVector((htm::UInt)curVector_, resetOut, offset, 1);
     offset++;
 
     // trace facility
-    NTA_DEBUG << "compute " << *region_->getOutput("reset") << std::endl;
+    NTA_DEBUG << "compute " << *resetOutHandle_ << std::endl;
   }
 
   vectorFile_.getScaledVector((htm::UInt)curVector_, out, offset, count);
 
   // trace facility
-  NTA_DEBUG << "compute " << *region_->getOutput("dataOut") << std::endl;
+  NTA_DEBUG << "compute " << *dataOutHandle_ << std::endl;
   iterations_++;
 }
 
+//--------------------------------------------------------------------------------
+// The producer thread only reads vectorFile_ and the configuration, so every
+// setter and command calls stopPrefetch() before it changes them.
+void FileInputRegion::startPrefetch() {
+  NTA_ASSERT(!producer_.joinable());
+  const Size nVectors = vectorFile_.vectorCount();
+  Staged prototype;
+  prototype.data.resize(dataOut_.getCount());
+  staged_.reset(new SpscQueue<Staged>(prefetchDepth_, prototype));
+  holdingStaged_ = false;
+  stopProducer_ = false;
+  producerFailed_ = false;
+  producerError_ = nullptr;
+  const int first = static_cast<int>((static_cast<Size>(curVector_ + 1)) % nVectors);
+  producer_ = std::thread(&FileInputRegion::produce, this, first);
+}
+
+void FileInputRegion::stopPrefetch() {
+  if (producer_.joinable()) {
+    stopProducer_ = true;
+    producer_.join();
+  }
+  // staged vectors are dropped, the next compute() continues from curVector_
+  staged_.reset();
+  holdingStaged_ = false;
+}
+
+void FileInputRegion::produce(int first) {
+  try {
+    const int nVectors = static_cast<int>(vectorFile_.vectorCount());
+    int index = first;
+    while (!stopProducer_.load(std::memory_order_relaxed)) {
+      Staged *slot = staged_->back();
+      if (slot == nullptr) { // queue is full, compute() is behind
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+        continue;
+      }
+      if (readAhead_ > 0 && index % readAhead_ == 0)
+        vectorFile_.prefetch(static_cast<Size>(index), 2u * readAhead_);
+
+      UInt offset = 0;
+      slot->index = index;
+      if (hasCategoryOut_)
+        vectorFile_.getRawVector((htm::UInt)index, &slot->category, offset++, 1);
+      if (hasResetOut_)
+        vectorFile_.getRawVector((htm::UInt)index, &slot->reset, offset++, 1);
+      vectorFile_.getScaledVector((htm::UInt)index, slot->data.data(), offset, slot->data.size());
+      staged_->push();
+      index = (index + 1) % nVectors;
+    }
+  } catch (...) {
+    producerError_ = std::current_exception();
+    producerFailed_.store(true, std::memory_order_release);
+  }
+}
+
 //--------------------------------------------------------------------------------
 inline const char *checkExtensions(const std::string &filename,
                                    const char *const *extensions) {
@@ -168,6 +269,7 @@ inline const char *checkExtensions(const std::string &filename,
 std::string FileInputRegion::executeCommand(const std::vector<std::string> &args, Int64 index)
 
 {
+  stopPrefetch();
   UInt32 argCount = (UInt32)args.size();
   // Get the first argument (command string)
   NTA_CHECK(argCount > 0) << "FileInputRegion: No command name";
@@ -278,7 +380,8 @@ std::string FileInputRegion::executeCommand(const std::vector<std::string> &args
 
     NTA_CHECK(argCount <= 5) << "FileInputRegion: too many arguments";
 
-    std::ofstream f(filename.c_str());
+    std::ofstream f(filename.c_str(), (format >= 4) ? std::ios_base::out | std::ios_base::binary
+                                                    : std::ios_base::out);
     if (!hasEnd)
       end = vectorFile_.vectorCount() - 1;
     vectorFile_.saveVectors(f, dataOut_.getCount(), format, begin, end);
@@ -413,6 +516,26 @@ Spec *FileInputRegion::createSpec() {
 					          "1",                  // defaultValue
 					          ParameterSpec::ReadWriteAccess));
 
+  ns->parameters.add( "readAhead",
+			      ParameterSpec(
+					          "Number of vectors to read ahead from memory mapped files (formats 4 and 7).\n"
+					          "The OS is asked to page them in before they are output. 0 turns it off.",
+					          NTA_BasicType_UInt32,
+					          1,                    // elementCount
+					          "interval: [0, ...]", // constraints
+					          "1024",               // defaultValue
+					          ParameterSpec::ReadWriteAccess));
+
+  ns->parameters.add( "prefetchDepth",
+			      ParameterSpec(
+					          "Number of scaled vectors a background thread prepares ahead of compute().\n"
+					          "Hides file access and scaling behind the rest of the network. 0 turns it off.",
+					          NTA_BasicType_UInt32,
+					          1,                    // elementCount
+					          "interval: [0, ...]", // constraints
+					          "0",                  // defaultValue
+					          ParameterSpec::ReadWriteAccess));
+
   ns->parameters.add("recentFile",
                    ParameterSpec("Writes output vectors to this file on each "
                                    "compute. Will append to any\n"
@@ -534,6 +657,10 @@ UInt32 FileInputRegion::getParameterUInt32(const std::string &name, Int64 index)
     return (UInt32)vectorFile_.vectorCount();
   } else if (name == "repeatCount") {
     return repeatCount_;
+  } else if (name == "readAhead") {
+    return readAhead_;
+  } else if (name == "prefetchDepth") {
+    return prefetchDepth_;
   } else if (name == "activeOutputCount") {
     return activeOutputCount_;
   } else if (name == "maxOutputVectorCount") {
@@ -592,6 +719,7 @@ void FileInputRegion::getParameterArray(const std::string &name, Int64 index, Ar
 //--------------------------------------------------------------------------------
 void FileInputRegion::setParameterUInt32(const std::string &name, Int64 index, UInt32 value) {
   const char *where = "setParameterUInt32() FileInputRegion, parameter ";
+  stopPrefetch();
 
   if (name == "repeatCount") {
     NTA_CHECK(value > 0)
@@ -600,6 +728,12 @@ void FileInputRegion::setParameterUInt32(const std::string &name, Int64 index, U
 
     repeatCount_ = value;
   }
+  else if (name == "readAhead") {
+    readAhead_ = value;
+  }
+  else if (name == "prefetchDepth") {
+    prefetchDepth_ = value;
+  }
   else if (name == "hasCategoryOut") {
     hasCategoryOut_ = (value == 1);
   }
@@ -612,6 +746,7 @@ void FileInputRegion::setParameterUInt32(const std::string &name, Int64 index, U
 
 void FileInputRegion::setParameterInt32(const std::string &name, Int64 index, Int32 value) {
   const char *where = "setParameterInt32() FileInputRegion, parameter ";
+  stopPrefetch();
   if (name == "position") {
     if (vectorFile_.vectorCount() == 0) return; // not yet initialized.
     NTA_CHECK(value >= 0 && value < static_cast<Int32>(vectorFile_.vectorCount()))
@@ -625,6 +760,7 @@ void FileInputRegion::setParameterInt32(const std::string &name, Int64 index, In
 
 void FileInputRegion::setParameterString(const std::string &name, Int64 index, const std::string &value) {
   const char *where = "setParameterString() FileInputRegion ";
+  stopPrefetch();
   if (name == "scalingMode") {
     if (value == "none")
       vectorFile_.resetScaling();
@@ -642,6 +778,7 @@ void FileInputRegion::setParameterString(const std::string &name, Int64 index, c
 
 void FileInputRegion::setParameterArray(const std::string &name, Int64 index,
                                          const Array &a) {
+  stopPrefetch();
   NTA_CHECK (a.getCount() == dataOut_.getCount())
          << "setParameterArray(), array size is: " << a.getCount()
          << "instead of : " << dataOut_.getCount();
@@ -675,6 +812,8 @@ bool FileInputRegion::operator==(const RegionImpl &o) const {
   if (o.getType() != "FileInputRegion") return false;
   FileInputRegion &other = (FileInputRegion &)o;
   if (repeatCount_ != other.repeatCount_) return false;
+  if (readAhead_ != other.readAhead_) return false;
+  if (prefetchDepth_ != other.prefetchDepth_) return false;
   if (activeOutputCount_ != other.activeOutputCount_) return false;
   if (curVector_ != other.curVector_) return false;
   if (iterations_ != other.iterations_) return false;
@@ -27,6 +27,10 @@
 
 //----------------------------------------------------------------------
 
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <thread>
 #include <vector>
 
 #include <htm/engine/RegionImpl.hpp>
@@ -35,6 +39,7 @@
 #include <htm/types/Types.hpp>
 #include <htm/types/Serializable.hpp>
 #include <htm/ntypes/Value.hpp>
+#include <htm/utils/SpscQueue.hpp>
 
 namespace htm {
 
@@ -89,6 +94,11 @@ namespace htm {
  *  The full list of vectors is read into memory when the loadFile command
  *  is executed.
  *
+ *  With the 'prefetchDepth' parameter a background thread scales the next
+ *  vectors into a queue ahead of time, so compute() only copies a staged
+ *  vector to the outputs. Changing any parameter or executing a command
+ *  stops the thread; the next compute() restarts it.
+ *
  */
 
 class FileInputRegion : public RegionImpl, Serializable {
@@ -293,6 +303,8 @@ public:
   template<class Archive>
   void save_ar(Archive& ar) const {
     ar(cereal::make_nvp("repeatCount_", repeatCount_));
+    ar(cereal::make_nvp("readAhead_", readAhead_));
+    ar(cereal::make_nvp("prefetchDepth_", prefetchDepth_));
     ar(cereal::make_nvp("iterations_", iterations_));
     ar(cereal::make_nvp("activeOutputCount_", activeOutputCount_));
     ar(cereal::make_nvp("curVector_", curVector_));
@@ -308,6 +320,8 @@ public:
   template<class Archive>
   void load_ar(Archive& ar) {
     ar(cereal::make_nvp("repeatCount_", repeatCount_));
+    ar(cereal::make_nvp("readAhead_", readAhead_));
+    ar(cereal::make_nvp("prefetchDepth_", prefetchDepth_));
     ar(cereal::make_nvp("iterations_", iterations_));
     ar(cereal::make_nvp("activeOutputCount_", activeOutputCount_));
     ar(cereal::make_nvp("curVector_", curVector_));
@@ -332,9 +346,14 @@ public:
 private:
   void closeFile();
   void openFile(const std::string &filename);
+  void startPrefetch();
+  void stopPrefetch();
+  void produce(int first);
 
 private:
   UInt32 repeatCount_; // Repeat count for output vectors
+  UInt32 readAhead_;   // Vectors to prefetch from memory mapped files
+  UInt32 prefetchDepth_; // Scaled vectors staged by the producer thread, 0 = off
   UInt32 iterations_;  // Number of times compute() has been called
   int curVector_;      // The index of the vector that was just output
   UInt32 activeOutputCount_; // The number of elements in each input vector
@@ -347,11 +366,28 @@ private:
   Array dataOut_;
   Array categoryOut_;
   Array resetOut_;
+  OutputHandle dataOutHandle_{this, "dataOut"};
+  OutputHandle categoryOutHandle_{this, "categoryOut"};
+  OutputHandle resetOutHandle_{this, "resetOut"};
   std::string filename_; // Name of the output file
 
   std::string scalingMode_;
   std::string recentFile_; // The most recently loaded or appended file
 
+  // One vector as it will be output, prepared by the producer thread.
+  struct Staged {
+    int index = 0;
+    Real64 category = 0.0;
+    Real64 reset = 0.0;
+    std::vector<Real64> data;
+  };
+  std::unique_ptr<SpscQueue<Staged>> staged_;
+  std::thread producer_;
+  std::atomic<bool> stopProducer_{false};
+  std::atomic<bool> producerFailed_{false};
+  std::exception_ptr producerError_;
+  bool holdingStaged_ = false;  // front() of staged_ is the current output
+
   //------------------- Utility routines and debugging support
 
   // Seek to the n'th vector in the list. n should be between 0 and
@@ -20,6 +20,8 @@
  *     (was VectorFileEffector)
  */
 
+#include <charconv> // to_chars
+#include <cstdio>
 #include <iostream>
 #include <list>
 #include <sstream>
@@ -30,14 +32,17 @@
 #include <htm/engine/Input.hpp>
 #include <htm/engine/Region.hpp>
 #include <htm/engine/Spec.hpp>
+#include <htm/os/Path.hpp>
 #include <htm/regions/FileOutputRegion.hpp>
+#include <htm/regions/VectorFile.hpp>
 #include <htm/utils/Log.hpp>
 
 namespace htm {
 
 FileOutputRegion::FileOutputRegion(const ValueMap &params, Region* region)
     : RegionImpl(region), dataIn_(NTA_BasicType_Real64), filename_(""),
-      outFile_(nullptr) {
+      outputFormat_("csv") {
+  setParameterString("outputFormat", -1, params.getString("outputFormat", "csv"));
   if (params.contains("outputFile")) {
     std::string s = params.getString("outputFile", "");
     openFile(s);
@@ -48,12 +53,12 @@ FileOutputRegion::FileOutputRegion(const ValueMap &params, Region* region)
 
 FileOutputRegion::FileOutputRegion(ArWrapper& wrapper, Region* region)
     : RegionImpl(region), dataIn_(NTA_BasicType_Real64), filename_(""),
-      outFile_(nullptr) {
+      outputFormat_("csv") {
   cereal_adapter_load(wrapper);
 }
 
 
-FileOutputRegion::~FileOutputRegion() { closeFile(); }
+FileOutputRegion::~FileOutputRegion() { outFile_.reset(); } // no throw, warns on errors
 
 void FileOutputRegion::initialize() {
   NTA_CHECK(region_ != nullptr);
@@ -69,8 +74,8 @@ void FileOutputRegion::initialize() {
 
 void FileOutputRegion::compute() {
   // trace facility
-  NTA_DEBUG << "compute " << *region_->getInput("dataIn") << "\n";
-  dataIn_ = region_->getInput("dataIn")->getData();
+  NTA_DEBUG << "compute " << *dataInHandle_ << "\n";
+  dataIn_ = dataInHandle_->getData();
   // It's not necessarily an error to have no inputs. In this case we just
   // return
   if (dataIn_.getCount() == 0)
@@ -83,50 +88,66 @@ void FileOutputRegion::compute() {
     return;
   }
 
-  // Ensure we can write to it
-  if (outFile_->fail()) {
-    NTA_THROW << "FileOutputRegion: There was an error writing to the file "
-              << filename_.c_str() << "\n";
+  const Real64 *inputVec = (const Real64 *)(dataIn_.getBuffer());
+  NTA_CHECK(inputVec != nullptr);
+  const Size count = dataIn_.getCount();
+
+  if (outputFormat_ == "binary") {
+    if (!started_) {
+      // A new file gets a header, an existing one must match it.
+      const std::string header = VectorFile::binaryHeader(count);
+      if (Path::getFileSize(filename_) == 0) {
+        outFile_->write(header);
+      } else {
+        std::ifstream existing(filename_, std::ios_base::binary);
+        std::string head(header.size(), '\0');
+        existing.read(&head[0], static_cast<std::streamsize>(head.size()));
+        NTA_CHECK(existing && head == header)
+            << "FileOutputRegion: can't append " << count << " wide vectors to " << filename_;
+      }
+      started_ = true;
+    }
+    outFile_->write(reinterpret_cast<const char *>(inputVec), count * sizeof(Real64));
+    return;
   }
 
-
-  Real64 *inputVec = (Real64 *)(dataIn_.getBuffer());
-  NTA_CHECK(inputVec != nullptr);
-  std::ofstream &outFile = *outFile_;
-  for (Size offset = 0; offset < dataIn_.getCount(); ++offset) {
-    if (offset == 0)
-      outFile << inputVec[offset];
-    else
-      outFile << "," << inputVec[offset];
+  // Same text as ostream << Real64 with its default precision of 6.
+  line_.clear();
+  char number[32];
+  for (Size offset = 0; offset < count; ++offset) {
+    if (offset > 0)
+      line_ += ',';
+#if defined(__cpp_lib_to_chars)
+    const auto result = std::to_chars(number, number + sizeof(number), inputVec[offset],
+                                      std::chars_format::general, 6);
+    line_.append(number, result.ptr);
+#else
+    line_.append(number, std::snprintf(number, sizeof(number), "%g", inputVec[offset]));
+#endif
   }
-  outFile << "\n";
+  line_ += '\n';
+  outFile_->write(line_);
+  started_ = true;
 }
 
 void FileOutputRegion::closeFile() {
   if (outFile_) {
-    outFile_->close();
-    outFile_ = nullptr;
+    std::unique_ptr<AsyncFileWriter> file = std::move(outFile_);
     filename_ = "";
+    file->close();
   }
 }
 
 void FileOutputRegion::openFile(const std::string &filename) {
 
-  if (outFile_ && !outFile_->fail())
+  if (outFile_)
     closeFile();
   if (filename == "")
     return;
 
-  outFile_ = new std::ofstream(filename.c_str(), std::ios::app);
-  if (outFile_->fail())
-  {
-    delete outFile_;
-    outFile_ = nullptr;
-    NTA_THROW
-        << "FileOutputRegion::openFile -- unable to create or open file: "
-        << filename.c_str();
-  }
+  outFile_.reset(new AsyncFileWriter(filename));
   filename_ = filename;
+  started_ = false;
 }
 
 void FileOutputRegion::setParameterString(const std::string &paramName,
@@ -138,6 +159,11 @@ void FileOutputRegion::setParameterString(const std::string &paramName,
     if (outFile_)
       closeFile();
     openFile(s);
+  } else if (paramName == "outputFormat") {
+    NTA_CHECK(s == "csv" || s == "binary") << "FileOutputRegion -- unknown outputFormat " << s;
+    NTA_CHECK(!started_ || s == outputFormat_)
+        << "FileOutputRegion -- outputFormat can't change while writing " << filename_;
+    outputFormat_ = s;
   } else {
     NTA_THROW << "FileOutputRegion -- Unknown string parameter " << paramName;
   }
@@ -147,6 +173,8 @@ std::string FileOutputRegion::getParameterString(const std::string &paramName,
                                                    Int64 index) const {
   if (paramName == "outputFile") {
     return filename_;
+  } else if (paramName == "outputFormat") {
+    return outputFormat_;
   } else {
     NTA_THROW << "FileOutputRegion -- unknown parameter " << paramName;
   }
@@ -159,22 +187,23 @@ FileOutputRegion::executeCommand(const std::vector<std::string> &args,
   // Process the flushFile command
   if (args[0] == "flushFile") {
     // Ensure we have a valid file before flushing, otherwise fail silently.
-    if (!((outFile_ == nullptr) || (outFile_->fail()))) {
+    if (outFile_ != nullptr) {
       outFile_->flush();
     }
   } else if (args[0] == "closeFile") {
     closeFile();
   } else if (args[0] == "echo") {
     // Ensure we have a valid file before flushing, otherwise fail silently.
-    if ((outFile_ == nullptr) || (outFile_->fail())) {
+    if (outFile_ == nullptr) {
       NTA_THROW << "VectorFileEffector: echo command failed because there is "
                    "no file open";
     }
+    NTA_CHECK(outputFormat_ != "binary") << "VectorFileEffector: echo into a binary file";
 
     for (size_t i = 1; i < args.size(); i++) {
-      *outFile_ << args[i];
+      outFile_->write(args[i]);
     }
-    *outFile_ << "\n";
+    outFile_->write("\n");
   } else {
     NTA_THROW << "VectorFileEffector: Unknown execute '" << args[0] << "'";
   }
@@ -216,6 +245,16 @@ Spec *FileOutputRegion::createSpec() {
                             "", // defaultValue
                             ParameterSpec::ReadWriteAccess));
 
+  ns->parameters.add("outputFormat",
+              ParameterSpec("'csv' writes comma separated text, 'binary' a VectorFile "
+                            "format 7 file of Real64 that FileInputRegion reads back "
+                            "without parsing. Set it before the first compute.\n",
+                            NTA_BasicType_Byte,
+                            0,      // elementCount
+                            "",     // constraints
+                            "csv",  // defaultValue
+                            ParameterSpec::ReadWriteAccess));
+
   ns->commands.add("flushFile", CommandSpec("Flush file data to disk"));
 
   ns->commands.add("closeFile",
@@ -236,6 +275,7 @@ bool FileOutputRegion::operator==(const RegionImpl &o) const {
   if (o.getType() != "FileOutputRegion") return false;
   FileOutputRegion& other = (FileOutputRegion&)o;
   if (filename_ != other.filename_) return false;
+  if (outputFormat_ != other.outputFormat_) return false;
 
   return true;
 }
@@ -27,7 +27,10 @@
 
 //----------------------------------------------------------------------
 
+#include <memory>
+
 #include <htm/engine/RegionImpl.hpp>
+#include <htm/os/AsyncFileWriter.hpp>
 #include <htm/ntypes/Array.hpp>
 #include <htm/types/Types.hpp>
 #include <htm/types/Serializable.hpp>
@@ -43,13 +46,19 @@ namespace htm {
  *  The current input vector is written (but not flushed) to the file
  *  each time the effector's compute() method is called.
  *
- *  The file format for the file is a space-separated list of numbers, with
+ *  The file format for the file is a comma-separated list of numbers, with
  *  one vector per line:
  *
- *        e11 e12 e13 ... e1N
- *        e21 e22 e23 ... e2N
+ *        e11,e12,e13,...,e1N
+ *        e21,e22,e23,...,e2N
  *           :
- *        eM1 eM2 eM3 ... eMN
+ *        eM1,eM2,eM3,...,eMN
+ *
+ *  With outputFormat "binary" the vectors are written as a VectorFile
+ *  format 7 file instead, which FileInputRegion maps back without parsing.
+ *
+ *  Writing goes through an AsyncFileWriter: compute() only formats into a
+ *  buffer, a background thread does the disk I/O.
  *
  *  VectorFileEffector implements the execute() commands as defined in the
  *  nodeSpec.
@@ -76,6 +85,7 @@ public:
   // FOR Cereal Serialization
   template<class Archive>
   void save_ar(Archive& ar) const {
+    ar(cereal::make_nvp("outputFormat", outputFormat_));
     ar(cereal::make_nvp("outputFile", filename_));
     ar(CEREAL_NVP(dim_));  // in base class
   }
@@ -83,6 +93,7 @@ public:
   // FOR Cereal Deserialization
   template<class Archive>
   void load_ar(Archive& ar) {
+    ar(cereal::make_nvp("outputFormat", outputFormat_));
     ar(cereal::make_nvp("outputFile", filename_));
 		if (filename_ != "")
 		      openFile(filename_);
@@ -96,6 +107,7 @@ public:
 
 
   void compute() override;
+  bool isAsync() const override { return true; } // writes the file while the network computes on
 
   virtual std::string executeCommand(const std::vector<std::string> &args,
                                      Int64 index) override;
@@ -105,8 +117,12 @@ private:
   void openFile(const std::string &filename);
 
     Array dataIn_;
+    InputHandle dataInHandle_{this, "dataIn"};
     std::string filename_;          // Name of the output file
-    std::ofstream *outFile_;        // Handle to current file
+    std::string outputFormat_;      // "csv" or "binary"
+    std::unique_ptr<AsyncFileWriter> outFile_; // Handle to current file
+    bool started_ = false;          // a vector was written to the file
+    std::string line_;              // formatting buffer
 
   /// Disable unsupported default constructors
   FileOutputRegion(const FileOutputRegion &);
@@ -0,0 +1,167 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the MultiEncoderRegion Region
+ */
+
+#include <htm/regions/MultiEncoderRegion.hpp>
+
+#include <htm/engine/Input.hpp>
+#include <htm/engine/Output.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/engine/Spec.hpp>
+#include <htm/ntypes/Array.hpp>
+#include <htm/os/Path.hpp>  // trim(), split()
+#include <htm/utils/Log.hpp>
+
+#include <memory>
+
+namespace htm {
+
+
+/* static */ Spec *MultiEncoderRegion::createSpec() {
+  Spec *ns = new Spec();
+  ns->parseSpec(R"(
+  {name: "MultiEncoderRegion",
+      parameters: {
+          resolutions: {description: "Comma separated list with the resolution of each field, ie '0.5, 10, 1'. Sets the number of fields.",
+                        type: String, default: ""},
+          size:        {description: "Number of output bits per field.",
+                        type: UInt32, default: "0"},
+          activeBits:  {type: UInt32, default: "0"},
+          sparsity:    {type: Real32, default: "0.0"},
+          seed:        {description: "Seed of the first field, the following fields use seed+1, seed+2, ... 0 is random.",
+                        type: UInt32, default: "0"},
+          numThreads:  {description: "Number of threads encoding the fields, see MultiEncoder::setNumThreads.",
+                        type: UInt32, default: "1", access: ReadWrite }},
+      inputs: {
+          values:      {description: "One value to encode per field.",
+                        type: Real64, count: 0, isDefaultInput: yes, isRegionLevel: yes}},
+      outputs: {
+          encoded:     {description: "Encoded bits of all fields. Not a true Sparse Data Representation (SP does that).",
+                        type: SDR,    count: 0, isDefaultOutput: yes, isRegionLevel: yes }}
+  } )");
+
+  return ns;
+}
+
+
+MultiEncoderRegion::MultiEncoderRegion(const ValueMap &par, Region *region) : RegionImpl(region) {
+  spec_.reset(createSpec());
+  ValueMap params = ValidateParameters(par, spec_.get());
+
+  RDSE_Parameters args;
+  args.size =       params.getScalarT<UInt32>("size");
+  args.activeBits = params.getScalarT<UInt32>("activeBits");
+  args.sparsity =   params.getScalarT<Real32>("sparsity");
+  args.seed =       params.getScalarT<UInt32>("seed");
+
+  resolutions_ = params.getString("resolutions", "");
+  std::vector<std::shared_ptr<BaseEncoder<Real64>>> fields;
+  for (const auto &field : Path::split(resolutions_, ',')) {
+    const std::string resolution = Path::trim(field);
+    NTA_CHECK(!resolution.empty()) << "MultiEncoderRegion: resolutions; parse error in '" << resolutions_ << "'";
+    args.resolution = std::stof(resolution);
+    fields.push_back(std::make_shared<RandomDistributedScalarEncoder>(args));
+    if (args.seed != 0u) args.seed++;
+  }
+  NTA_CHECK(!fields.empty()) << "MultiEncoderRegion: parameter 'resolutions' is required, one per field.";
+
+  encoder_ = std::make_shared<MultiEncoder>(fields);
+  encoder_->setNumThreads(params.getScalarT<UInt32>("numThreads"));
+  sensedValues_.assign(encoder_->numFields(), 0.0);
+}
+
+MultiEncoderRegion::MultiEncoderRegion(ArWrapper &wrapper, Region *region)
+    : RegionImpl(region) {
+  cereal_adapter_load(wrapper);
+}
+MultiEncoderRegion::~MultiEncoderRegion() {}
+
+void MultiEncoderRegion::initialize() { }
+
+Dimensions MultiEncoderRegion::askImplForOutputDimensions(const std::string &name) {
+  if (name == "encoded") {
+    Dimensions encoderDim(encoder_->dimensions);
+    return encoderDim;
+  }
+  return RegionImpl::askImplForOutputDimensions(name);
+}
+
+void MultiEncoderRegion::compute() {
+  if (values_->hasIncomingLinks()) {
+    Array &a = values_->getData();
+    NTA_CHECK(a.getCount() == sensedValues_.size())
+        << "MultiEncoderRegion: input 'values' has " << a.getCount() << " values for "
+        << sensedValues_.size() << " fields.";
+    const Real64 *values = (const Real64 *)a.getBuffer();
+    for (size_t i = 0; i < sensedValues_.size(); i++) {
+      // prevents an exception in case of nan or inf
+      sensedValues_[i] = std::isfinite(values[i]) ? values[i] : 0.0;
+    }
+  }
+
+  SDR &output = encoded_->getData().getSDR();
+  encoder_->encode(sensedValues_, output);
+}
+
+
+void MultiEncoderRegion::setParameterUInt32(const std::string &name, Int64 index, UInt32 value) {
+  if (name == "numThreads") encoder_->setNumThreads(value);
+  else RegionImpl::setParameterUInt32(name, index, value);
+}
+
+Real32 MultiEncoderRegion::getParameterReal32(const std::string &name, Int64 index) const {
+  const auto &field = dynamic_cast<const RandomDistributedScalarEncoder &>(*encoder_->getEncoder(0));
+  if (name == "sparsity") return field.parameters.sparsity;
+  else return RegionImpl::getParameterReal32(name, index);
+}
+
+UInt32 MultiEncoderRegion::getParameterUInt32(const std::string &name, Int64 index) const {
+  const auto &field = dynamic_cast<const RandomDistributedScalarEncoder &>(*encoder_->getEncoder(0));
+  if (name == "size")            return field.parameters.size;
+  else if (name == "activeBits") return field.parameters.activeBits;
+  else if (name == "seed")       return field.parameters.seed;
+  else if (name == "numThreads") return encoder_->getNumThreads();
+  else return RegionImpl::getParameterUInt32(name, index);
+}
+
+std::string MultiEncoderRegion::getParameterString(const std::string &name, Int64 index) const {
+  if (name == "resolutions") return resolutions_;
+  else return RegionImpl::getParameterString(name, index);
+}
+
+bool MultiEncoderRegion::operator==(const RegionImpl &other) const {
+  if (other.getType() != "MultiEncoderRegion") return false;
+  const MultiEncoderRegion &o = reinterpret_cast<const MultiEncoderRegion&>(other);
+  if (resolutions_ != o.resolutions_) return false;
+  if (encoder_->numFields() != o.encoder_->numFields()) return false;
+  for (size_t i = 0; i < encoder_->numFields(); i++) {
+    const auto &a = dynamic_cast<const RandomDistributedScalarEncoder &>(*encoder_->getEncoder(i)).parameters;
+    const auto &b = dynamic_cast<const RandomDistributedScalarEncoder &>(*o.encoder_->getEncoder(i)).parameters;
+    if (a.size != b.size || a.activeBits != b.activeBits || a.sparsity != b.sparsity ||
+        a.resolution != b.resolution || a.seed != b.seed)
+      return false;
+  }
+  if (sensedValues_ != o.sensedValues_) return false;
+
+  return true;
+}
+
+
+} // namespace htm
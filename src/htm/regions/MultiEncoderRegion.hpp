@@ -0,0 +1,101 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Defines MultiEncoderRegion, a Region implementation for the MultiEncoder.
+ */
+
+#ifndef NTA_MULTIENCODERREGION_HPP
+#define NTA_MULTIENCODERREGION_HPP
+
+#include <string>
+#include <vector>
+
+#include <htm/engine/RegionImpl.hpp>
+#include <htm/ntypes/Value.hpp>
+#include <htm/types/Serializable.hpp>
+#include <htm/encoders/MultiEncoder.hpp>
+
+namespace htm {
+/**
+ * A network region that encodes a record of several numeric fields with a
+ * MultiEncoder, one RandomDistributedScalarEncoder per field.
+ *
+ * @b Description
+ * The input "values" holds one value per field; its length must match the
+ * number of entries in the "resolutions" parameter. On each compute, the
+ * record is encoded into the single output SDR "encoded", where field i takes
+ * the bits [i * size, (i + 1) * size). This replaces one encoder region per
+ * field fanned into the next region.
+ */
+class MultiEncoderRegion : public RegionImpl, Serializable {
+public:
+  MultiEncoderRegion(const ValueMap &params, Region *region);
+  MultiEncoderRegion(ArWrapper &wrapper, Region *region);
+
+  virtual ~MultiEncoderRegion() override;
+
+  static Spec *createSpec();
+
+  virtual Real32 getParameterReal32(const std::string &name, Int64 index = -1) const override;
+  virtual UInt32 getParameterUInt32(const std::string &name, Int64 index = -1) const override;
+  virtual std::string getParameterString(const std::string &name, Int64 index = -1) const override;
+  virtual void setParameterUInt32(const std::string &name, Int64 index, UInt32 value) override;
+  virtual void initialize() override;
+
+  void compute() override;
+  bool isPure() const override { return true; }
+
+  virtual Dimensions askImplForOutputDimensions(const std::string &name) override;
+
+  CerealAdapter;  // see Serializable.hpp
+  // FOR Cereal Serialization
+  template<class Archive>
+  void save_ar(Archive& ar) const {
+    ar(CEREAL_NVP(sensedValues_));
+    ar(CEREAL_NVP(resolutions_));
+    ar(cereal::make_nvp("encoder", encoder_));
+  }
+  // FOR Cereal Deserialization
+  // NOTE: the Region Implementation must have been allocated
+  //       using the RegionImplFactory so that it is connected
+  //       to the Network and Region objects. This will populate
+  //       the region_ field in the Base class.
+  template<class Archive>
+  void load_ar(Archive& ar) {
+    ar(CEREAL_NVP(sensedValues_));
+    ar(CEREAL_NVP(resolutions_));
+    ar(cereal::make_nvp("encoder", encoder_));
+    setDimensions(encoder_->dimensions);
+  }
+
+
+  bool operator==(const RegionImpl &other) const override;
+  inline bool operator!=(const MultiEncoderRegion &other) const {
+    return !operator==(other);
+  }
+
+private:
+  std::vector<Real64> sensedValues_;
+  std::string resolutions_;
+  std::shared_ptr<MultiEncoder> encoder_;
+  InputHandle values_{this, "values"};
+  OutputHandle encoded_{this, "encoded"};
+};
+} // namespace htm
+
+#endif // NTA_MULTIENCODERREGION_HPP
@@ -32,6 +32,7 @@
 #include "htm/utils/Random.hpp"
 #include <htm/utils/Log.hpp>
 
+#include <cmath>
 #include <memory>
 
 namespace htm {
@@ -52,10 +53,14 @@ namespace htm {
           noise:       {description: "amount of noise to add to the output SDR. 0.01 is 1%",
                         type: Real32, default: "0.0", access: ReadWrite },
           sensedValue: {description: "The value to encode. Overriden by input 'values'.",
-                        type: Real64, default: "0.0", access: ReadWrite }},
+                        type: Real64, default: "0.0", access: ReadWrite },
+          delta:       {description: "Encode the change since the previous value instead of the value: 'difference' or 'rate'. The default '' encodes the value.",
+                        type: String, default: ""}},
       inputs: {
           values:      {description: "Values to encode. Overrides sensedValue.",
-                        type: Real64, count: 1, isDefaultInput: yes, isRegionLevel: yes}}, 
+                        type: Real64, count: 1, isDefaultInput: yes, isRegionLevel: yes},
+          timestamps:  {description: "Time of the values, a delta 'rate' is per unit of this time. If not linked, one unit per compute.",
+                        type: Real64, count: 1, isDefaultInput: no, isRegionLevel: yes}}, 
       outputs: {
           bucket:      {description: "Quantized sample based on the radius. Becomes the title for this sample in Classifier.",
                         type: Real64, count: 1, isDefaultOutput: false, isRegionLevel: false },
@@ -84,6 +89,19 @@ RDSEEncoderRegion::RDSEEncoderRegion(const ValueMap &par, Region *region) : Regi
   encoder_ = std::make_shared<RandomDistributedScalarEncoder>(args);
   sensedValue_ = params.getScalarT<Real64>("sensedValue");
   noise_ = params.getScalarT<Real32>("noise");
+  delta_ = params.getString("delta", "");
+  initializeDelta_();
+}
+
+void RDSEEncoderRegion::initializeDelta_() {
+  deltaEncoder_.reset();
+  if (delta_.empty())
+    return;
+  NTA_CHECK(delta_ == "difference" || delta_ == "rate")
+    << "RDSEEncoderRegion: parameter 'delta' must be '', 'difference' or 'rate', got '" << delta_ << "'";
+  DeltaEncoderParameters args;
+  args.rate = (delta_ == "rate");
+  deltaEncoder_ = std::make_shared<DeltaEncoder>(encoder_, args);
 }
 
 RDSEEncoderRegion::RDSEEncoderRegion(ArWrapper &wrapper, Region *region)
@@ -103,16 +121,29 @@ Dimensions RDSEEncoderRegion::askImplForOutputDimensions(const std::string &name
 }
 
 void RDSEEncoderRegion::compute() {
-  if (hasInput("values")) {
-    Array &a = getInput("values")->getData();
+  if (values_->hasIncomingLinks()) {
+    Array &a = values_->getData();
     sensedValue_ = ((Real64 *)(a.getBuffer()))[0];
   }
   if (!std::isfinite(sensedValue_))
     sensedValue_ = 0;  // prevents an exception in case of nan or inf
   //std::cout << "RDSEEncoderRegion compute() sensedValue=" << sensedValue_ << std::endl;
 
-  SDR &output = getOutput("encoded")->getData().getSDR();
-  encoder_->encode((Real64)sensedValue_, output);
+  SDR &output = encoded_->getData().getSDR();
+  Real64 encodedValue = sensedValue_;
+  if (deltaEncoder_) {
+    if (timestamps_->hasIncomingLinks()) {
+      Array &t = timestamps_->getData();
+      deltaEncoder_->encode(sensedValue_, ((Real64 *)(t.getBuffer()))[0], output);
+    } else {
+      deltaEncoder_->encode(sensedValue_, output);
+    }
+    encodedValue = deltaEncoder_->getDelta();
+    if (std::isnan(encodedValue))
+      encodedValue = 0; // the first value, nothing was encoded
+  } else {
+    encoder_->encode(sensedValue_, output);
+  }
 
   // Add some noise.
   // noise_ = 0.01 means change 1% of the SDR for each iteration, this makes a random sequence, but seemingly stable
@@ -123,8 +154,8 @@ void RDSEEncoderRegion::compute() {
   // This is a quantification of the data being encoded (the sample) 
   // and becomes the title in the Classifier.
   if (encoder_->parameters.radius != 0.0f) {
-    Real64 *buf = (Real64 *)getOutput("bucket")->getData().getBuffer();
-    buf[0] = sensedValue_ - std::fmod(sensedValue_, encoder_->parameters.radius);
+    Real64 *buf = (Real64 *)bucket_->getData().getBuffer();
+    buf[0] = encodedValue - std::fmod(encodedValue, encoder_->parameters.radius);
     //std::cout << "RDSEEncoderRegion compute() bucket=" << buf[0] << std::endl;
   }
   
@@ -165,6 +196,11 @@ bool RDSEEncoderRegion::getParameterBool(const std::string &name, Int64 index) c
   else  return RegionImpl::getParameterBool(name, index);
 }
 
+std::string RDSEEncoderRegion::getParameterString(const std::string &name, Int64 index) const {
+  if (name == "delta") return delta_;
+  else return RegionImpl::getParameterString(name, index);
+}
+
 bool RDSEEncoderRegion::operator==(const RegionImpl &other) const {
   if (other.getType() != "RDSEEncoderRegion") return false;
   const RDSEEncoderRegion &o = reinterpret_cast<const RDSEEncoderRegion&>(other);
@@ -183,6 +219,7 @@ bool RDSEEncoderRegion::operator==(const RegionImpl &other) const {
   if (encoder_->parameters.seed != o.encoder_->parameters.seed)
     return false;
   if (sensedValue_ != o.sensedValue_) return false;
+  if (delta_ != o.delta_) return false;
 
   return true;
 }
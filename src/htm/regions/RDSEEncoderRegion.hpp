@@ -31,6 +31,7 @@
 #include <htm/ntypes/Value.hpp>
 #include <htm/types/Serializable.hpp>
 #include <htm/encoders/RandomDistributedScalarEncoder.hpp>
+#include <htm/encoders/DeltaEncoder.hpp>
 
 namespace htm {
 /**
@@ -41,6 +42,11 @@ namespace htm {
  * API. As a network runs, the client will specify new encoder inputs by
  * setting the "sensedValue" parameter or connecting a link which provides values for "sensedValue". 
  * On each compute, the ScalarSensor will encode its "sensedValue" to output.
+ *
+ * With the parameter "delta" set to "difference" or "rate" the region keeps
+ * the previous value, and encodes the change since it instead, see
+ * DeltaEncoder.  A rate is per unit of the optional input "timestamps", or per
+ * compute if that is not linked.
  */
 class RDSEEncoderRegion : public RegionImpl, Serializable {
 public:
@@ -55,11 +61,13 @@ public:
   virtual Real32 getParameterReal32(const std::string &name, Int64 index = -1) const override;
   virtual UInt32 getParameterUInt32(const std::string &name, Int64 index = -1) const override;
   virtual bool getParameterBool(const std::string &name,   Int64 index = -1) const override;
+  virtual std::string getParameterString(const std::string &name, Int64 index = -1) const override;
   virtual void setParameterReal32(const std::string &name, Int64 index, Real32 value) override;
   virtual void setParameterReal64(const std::string &name, Int64 index, Real64 value) override;
   virtual void initialize() override;
 
   void compute() override;
+  bool isPure() const override { return deltaEncoder_ == nullptr && noise_ == 0.0f; }
 
   virtual Dimensions askImplForOutputDimensions(const std::string &name) override;
 
@@ -71,6 +79,9 @@ public:
     ar(CEREAL_NVP(noise_));
     ar(CEREAL_NVP(rnd_));
     ar(cereal::make_nvp("encoder", encoder_));
+    ar(cereal::make_nvp("delta", delta_));
+    if (deltaEncoder_)
+      ar(cereal::make_nvp("deltaEncoder", *deltaEncoder_));
   }
   // FOR Cereal Deserialization
   // NOTE: the Region Implementation must have been allocated
@@ -83,6 +94,10 @@ public:
     ar(CEREAL_NVP(noise_));
     ar(CEREAL_NVP(rnd_));
     ar(cereal::make_nvp("encoder", encoder_));
+    ar(cereal::make_nvp("delta", delta_));
+    initializeDelta_();
+    if (deltaEncoder_)
+      ar(cereal::make_nvp("deltaEncoder", *deltaEncoder_));
     setDimensions(encoder_->dimensions); 
   }
 
@@ -97,6 +112,14 @@ private:
   Real32 noise_;
   Random rnd_;
   std::shared_ptr<RandomDistributedScalarEncoder> encoder_;
+  std::string delta_;
+  std::shared_ptr<DeltaEncoder> deltaEncoder_; // null: encode the value itself
+  InputHandle values_{this, "values"};
+  InputHandle timestamps_{this, "timestamps"};
+  OutputHandle encoded_{this, "encoded"};
+  OutputHandle bucket_{this, "bucket"};
+
+  void initializeDelta_();
 };
 } // namespace htm
 
@@ -0,0 +1,121 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the RemoteInputRegion
+ */
+
+#include <htm/regions/RemoteInputRegion.hpp>
+
+#include <htm/engine/Output.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/engine/Spec.hpp>
+#include <htm/ntypes/BasicType.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+/* static */ Spec *RemoteInputRegion::createSpec() {
+  Spec *ns = new Spec();
+  ns->parseSpec(R"(
+  {name: "RemoteInputRegion",
+      description: "Outputs what a RemoteOutputRegion on another host sends.",
+      parameters: {
+          port:             {description: "Port to listen on, 0 picks a free one.",
+                             type: UInt32, default: "0"},
+          dataType:         {description: "Type of dataOut, must be the sender's.",
+                             type: String, default: "SDR"},
+          propagationDelay: {description: "Computes which output zeros before the sender's data, like the delay of a Link.",
+                             type: UInt32, default: "0"},
+          timeout:          {description: "Milliseconds compute() waits for the sender before it throws.",
+                             type: UInt32, default: "10000"},
+          bytesReceived:    {description: "Bytes received so far.",
+                             type: UInt64, access: ReadOnly}},
+      outputs: {
+          dataOut:          {description: "The data received, of type dataType.",
+                             type: SDR, count: 0, isDefaultOutput: yes, isRegionLevel: yes}}
+  } )");
+  return ns;
+}
+
+
+RemoteInputRegion::RemoteInputRegion(const ValueMap &par, Region *region)
+    : RegionImpl(region) {
+  spec_.reset(createSpec());
+  ValueMap params = ValidateParameters(par, spec_.get());
+  port_ = params.getScalarT<UInt32>("port");
+  dataType_ = params.getString("dataType", "SDR");
+  propagationDelay_ = params.getScalarT<UInt32>("propagationDelay");
+  timeout_ = params.getScalarT<UInt32>("timeout");
+  NTA_CHECK(port_ <= 0xFFFFu) << "RemoteInputRegion: bad port " << port_;
+  region->getOutput("dataOut")->setDataType(BasicType::parse(dataType_));
+}
+
+RemoteInputRegion::RemoteInputRegion(ArWrapper &wrapper, Region *region)
+    : RegionImpl(region) {
+  cereal_adapter_load(wrapper);
+}
+
+RemoteInputRegion::~RemoteInputRegion() {}
+
+
+void RemoteInputRegion::initialize() {
+  link_.reset(new RemoteLink(static_cast<UInt16>(port_)));
+  port_ = link_->getPort();
+}
+
+
+void RemoteInputRegion::compute() {
+  if (computes_ < propagationDelay_) {
+    // Like the initial contents of a delayed Link, the output is still zero.
+    computes_++;
+    return;
+  }
+  NTA_CHECK(link_->receive(dataOut_->getData(), timeout_))
+      << "RemoteInputRegion " << getName() << ": nothing was sent to port " << port_
+      << " for " << timeout_ << " ms";
+  computes_++;
+}
+
+
+std::string RemoteInputRegion::getParameterString(const std::string &name, Int64 index) const {
+  if (name == "dataType") return dataType_;
+  return RegionImpl::getParameterString(name, index);
+}
+
+UInt32 RemoteInputRegion::getParameterUInt32(const std::string &name, Int64 index) const {
+  if (name == "port")             return port_;
+  if (name == "propagationDelay") return propagationDelay_;
+  if (name == "timeout")          return timeout_;
+  return RegionImpl::getParameterUInt32(name, index);
+}
+
+UInt64 RemoteInputRegion::getParameterUInt64(const std::string &name, Int64 index) const {
+  if (name == "bytesReceived") return link_ ? link_->getBytesReceived() : 0u;
+  return RegionImpl::getParameterUInt64(name, index);
+}
+
+
+bool RemoteInputRegion::operator==(const RegionImpl &o) const {
+  if (o.getType() != "RemoteInputRegion") return false;
+  const RemoteInputRegion &other = static_cast<const RemoteInputRegion &>(o);
+  return port_ == other.port_ && dataType_ == other.dataType_
+      && propagationDelay_ == other.propagationDelay_ && timeout_ == other.timeout_
+      && computes_ == other.computes_;
+}
+
+} // namespace htm
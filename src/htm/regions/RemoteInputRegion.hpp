@@ -0,0 +1,119 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Defines RemoteInputRegion, the receiving end of a link between hosts.
+ */
+
+#ifndef NTA_REMOTE_INPUT_REGION_HPP
+#define NTA_REMOTE_INPUT_REGION_HPP
+
+#include <memory>
+#include <string>
+
+#include <htm/engine/RegionImpl.hpp>
+#include <htm/engine/RemoteLink.hpp>
+#include <htm/ntypes/Value.hpp>
+#include <htm/types/Serializable.hpp>
+
+namespace htm {
+
+/**
+ * The receiving end of a link from a Network on another host, see
+ * RemoteOutputRegion.
+ *
+ * @b Description
+ * On each compute the next Array sent by the RemoteOutputRegion connected to
+ * "port" is put on output "dataOut".  If it was not sent yet, compute() waits
+ * for it.
+ *
+ * Parameters:
+ *   port             - to listen on; 0 picks a free one, read it back with
+ *                      getParameterUInt32("port") after initialize().
+ *   dataType         - of "dataOut", must be the sender's, default SDR.
+ *   dim              - the dimensions of "dataOut", unless the linked input
+ *                      determines them.  Their size must be the sender's.
+ *   propagationDelay - like the delay of a Link: the first propagationDelay
+ *                      computes output zeros, after that compute N outputs
+ *                      what the sender sent on its compute N - propagationDelay.
+ *                      The transfer then overlaps with that many computes.
+ *   timeout          - milliseconds compute() waits for the sender before it throws.
+ *
+ * This region listens from initialize() on and accepts the sender on the first
+ * compute that needs its data.
+ *
+ * Example (host B):
+ *    net.addRegion("fromSP", "RemoteInputRegion", "{port: 9000, dim: [2048], propagationDelay: 1}");
+ *    net.addRegion("tm", "TMRegion", "{cellsPerColumn: 8}");
+ *    net.link("fromSP", "tm", "", "", "dataOut", "bottomUpIn");
+ */
+class RemoteInputRegion : public RegionImpl, Serializable {
+public:
+  RemoteInputRegion(const ValueMap &params, Region *region);
+  RemoteInputRegion(ArWrapper &wrapper, Region *region);
+  virtual ~RemoteInputRegion() override;
+
+  static Spec *createSpec();
+
+  void initialize() override;
+  void compute() override;
+
+  std::string getParameterString(const std::string &name, Int64 index = -1) const override;
+  UInt32 getParameterUInt32(const std::string &name, Int64 index = -1) const override;
+  UInt64 getParameterUInt64(const std::string &name, Int64 index = -1) const override;
+
+  CerealAdapter;  // see Serializable.hpp
+  // FOR Cereal Serialization
+  template<class Archive>
+  void save_ar(Archive& ar) const {
+    ar(cereal::make_nvp("port", port_),
+       cereal::make_nvp("dataType", dataType_),
+       cereal::make_nvp("propagationDelay", propagationDelay_),
+       cereal::make_nvp("timeout", timeout_),
+       cereal::make_nvp("computes", computes_),
+       CEREAL_NVP(dim_));  // in base class
+  }
+  // FOR Cereal Deserialization
+  // The output keeps its type, initialize() listens again.
+  template<class Archive>
+  void load_ar(Archive& ar) {
+    ar(cereal::make_nvp("port", port_),
+       cereal::make_nvp("dataType", dataType_),
+       cereal::make_nvp("propagationDelay", propagationDelay_),
+       cereal::make_nvp("timeout", timeout_),
+       cereal::make_nvp("computes", computes_),
+       CEREAL_NVP(dim_));  // in base class
+  }
+
+  bool operator==(const RegionImpl &other) const override;
+  inline bool operator!=(const RemoteInputRegion &other) const {
+    return !operator==(other);
+  }
+
+private:
+  UInt32 port_;
+  std::string dataType_;
+  UInt32 propagationDelay_;
+  UInt32 timeout_;
+  UInt64 computes_ = 0u;
+  std::unique_ptr<RemoteLink> link_;
+  OutputHandle dataOut_{this, "dataOut"};
+};
+
+} // namespace htm
+
+#endif // NTA_REMOTE_INPUT_REGION_HPP
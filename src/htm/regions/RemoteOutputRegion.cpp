@@ -0,0 +1,117 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the RemoteOutputRegion
+ */
+
+#include <htm/regions/RemoteOutputRegion.hpp>
+
+#include <htm/engine/Input.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/engine/Spec.hpp>
+#include <htm/ntypes/BasicType.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+/* static */ Spec *RemoteOutputRegion::createSpec() {
+  Spec *ns = new Spec();
+  ns->parseSpec(R"(
+  {name: "RemoteOutputRegion",
+      description: "Sends its input to a RemoteInputRegion on another host.",
+      parameters: {
+          host:          {description: "Host the RemoteInputRegion runs on.",
+                          type: String, default: "localhost"},
+          port:          {description: "Port the RemoteInputRegion listens on.",
+                          type: UInt32, default: "0"},
+          dataType:      {description: "Type of dataIn, the type of the linked output avoids a conversion.",
+                          type: String, default: "SDR"},
+          timeout:       {description: "Milliseconds compute() waits for the receiver before it throws.",
+                          type: UInt32, default: "10000"},
+          bytesSent:     {description: "Bytes sent so far.",
+                          type: UInt64, access: ReadOnly}},
+      inputs: {
+          dataIn:        {description: "The data to send, of type dataType.",
+                          type: SDR, count: 0, isDefaultInput: yes, isRegionLevel: yes}}
+  } )");
+  return ns;
+}
+
+
+RemoteOutputRegion::RemoteOutputRegion(const ValueMap &par, Region *region)
+    : RegionImpl(region) {
+  spec_.reset(createSpec());
+  ValueMap params = ValidateParameters(par, spec_.get());
+  host_ = params.getString("host", "localhost");
+  port_ = params.getScalarT<UInt32>("port");
+  dataType_ = params.getString("dataType", "SDR");
+  timeout_ = params.getScalarT<UInt32>("timeout");
+  NTA_CHECK(port_ > 0u && port_ <= 0xFFFFu) << "RemoteOutputRegion: parameter 'port' is required";
+  region->getInput("dataIn")->setDataType(BasicType::parse(dataType_));
+}
+
+RemoteOutputRegion::RemoteOutputRegion(ArWrapper &wrapper, Region *region)
+    : RegionImpl(region) {
+  cereal_adapter_load(wrapper);
+  region->getInput("dataIn")->setDataType(BasicType::parse(dataType_));
+}
+
+RemoteOutputRegion::~RemoteOutputRegion() {}
+
+
+void RemoteOutputRegion::initialize() {
+  NTA_CHECK(dataIn_->hasIncomingLinks())
+      << "RemoteOutputRegion " << getName() << ": 'dataIn' is not linked";
+}
+
+
+void RemoteOutputRegion::compute() {
+  if (!link_)
+    link_.reset(new RemoteLink(host_, static_cast<UInt16>(port_), timeout_));
+  NTA_CHECK(link_->send(dataIn_->getData(), timeout_))
+      << "RemoteOutputRegion " << getName() << ": the receiver on " << host_ << ":" << port_
+      << " did not take any data for " << timeout_ << " ms";
+}
+
+
+std::string RemoteOutputRegion::getParameterString(const std::string &name, Int64 index) const {
+  if (name == "host")     return host_;
+  if (name == "dataType") return dataType_;
+  return RegionImpl::getParameterString(name, index);
+}
+
+UInt32 RemoteOutputRegion::getParameterUInt32(const std::string &name, Int64 index) const {
+  if (name == "port")    return port_;
+  if (name == "timeout") return timeout_;
+  return RegionImpl::getParameterUInt32(name, index);
+}
+
+UInt64 RemoteOutputRegion::getParameterUInt64(const std::string &name, Int64 index) const {
+  if (name == "bytesSent") return link_ ? link_->getBytesSent() : 0u;
+  return RegionImpl::getParameterUInt64(name, index);
+}
+
+
+bool RemoteOutputRegion::operator==(const RegionImpl &o) const {
+  if (o.getType() != "RemoteOutputRegion") return false;
+  const RemoteOutputRegion &other = static_cast<const RemoteOutputRegion &>(o);
+  return host_ == other.host_ && port_ == other.port_
+      && dataType_ == other.dataType_ && timeout_ == other.timeout_;
+}
+
+} // namespace htm
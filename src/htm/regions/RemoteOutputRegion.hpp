@@ -0,0 +1,117 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Defines RemoteOutputRegion, the sending end of a link between hosts.
+ */
+
+#ifndef NTA_REMOTE_OUTPUT_REGION_HPP
+#define NTA_REMOTE_OUTPUT_REGION_HPP
+
+#include <memory>
+#include <string>
+
+#include <htm/engine/RegionImpl.hpp>
+#include <htm/engine/RemoteLink.hpp>
+#include <htm/ntypes/Value.hpp>
+#include <htm/types/Serializable.hpp>
+
+namespace htm {
+
+/**
+ * The sending end of a link from a Network on one host to a Network on
+ * another, over TCP.
+ *
+ * @b Description
+ * Like SharedMemoryOutputRegion, but between hosts: together with a
+ * RemoteInputRegion listening on "port" of "host", this stands in for a Link
+ * between two Networks.  On each compute the Array on input "dataIn" is sent
+ * through a RemoteLink, an SDR as its compactly encoded sparse indices.
+ *
+ * A distributed Network is a Network per host, each run by its own process
+ * with run(n).  The links between them carry one Array per compute, in order,
+ * and the receiving ends wait for them, so the hosts keep in step by
+ * themselves.  A propagationDelay on the RemoteInputRegion lets the sender's
+ * next compute overlap with the transfer.
+ *
+ * Parameters:
+ *   host     - where the RemoteInputRegion runs, default "localhost".
+ *   port     - it listens on.
+ *   dataType - of "dataIn", default SDR; use the type of the linked output
+ *              so the Link does not need to convert.
+ *   timeout  - milliseconds compute() waits for the receiver, to connect or
+ *              while the socket buffers are full, before it throws.
+ *
+ * The connection is made on the first compute, so the hosts may start their
+ * Networks in any order.
+ *
+ * Example (host A):
+ *    net.addRegion("sp",  "SPRegion", "{columnCount: 2048}");
+ *    net.addRegion("toTM", "RemoteOutputRegion", "{host: hostB, port: 9000}");
+ *    net.link("sp", "toTM", "", "", "bottomUpOut", "dataIn");
+ */
+class RemoteOutputRegion : public RegionImpl, Serializable {
+public:
+  RemoteOutputRegion(const ValueMap &params, Region *region);
+  RemoteOutputRegion(ArWrapper &wrapper, Region *region);
+  virtual ~RemoteOutputRegion() override;
+
+  static Spec *createSpec();
+
+  void initialize() override;
+  void compute() override;
+
+  std::string getParameterString(const std::string &name, Int64 index = -1) const override;
+  UInt32 getParameterUInt32(const std::string &name, Int64 index = -1) const override;
+  UInt64 getParameterUInt64(const std::string &name, Int64 index = -1) const override;
+
+  CerealAdapter;  // see Serializable.hpp
+  // FOR Cereal Serialization
+  template<class Archive>
+  void save_ar(Archive& ar) const {
+    ar(cereal::make_nvp("host", host_),
+       cereal::make_nvp("port", port_),
+       cereal::make_nvp("dataType", dataType_),
+       cereal::make_nvp("timeout", timeout_));
+  }
+  // FOR Cereal Deserialization
+  // Connects again on the next compute.
+  template<class Archive>
+  void load_ar(Archive& ar) {
+    ar(cereal::make_nvp("host", host_),
+       cereal::make_nvp("port", port_),
+       cereal::make_nvp("dataType", dataType_),
+       cereal::make_nvp("timeout", timeout_));
+  }
+
+  bool operator==(const RegionImpl &other) const override;
+  inline bool operator!=(const RemoteOutputRegion &other) const {
+    return !operator==(other);
+  }
+
+private:
+  std::string host_;
+  UInt32 port_;
+  std::string dataType_;
+  UInt32 timeout_;
+  std::unique_ptr<RemoteLink> link_;
+  InputHandle dataIn_{this, "dataIn"};
+};
+
+} // namespace htm
+
+#endif // NTA_REMOTE_OUTPUT_REGION_HPP
@@ -139,6 +139,7 @@ void SPRegion::initialize() {
       args_.synPermInactiveDec, args_.synPermActiveInc, args_.synPermConnected,
       args_.minPctOverlapDutyCycles, args_.dutyCyclePeriod, args_.boostStrength,
       args_.seed, args_.spVerbosity, args_.wrapAround));
+  if(auto budget = SynapseBudget::getProcessBudget()) sp_->setSynapseBudget(budget);
 }
 
 
@@ -151,19 +152,48 @@ void SPRegion::compute() {
 
 
   // prepare the input
-  Array &inputBuffer  = getInput("bottomUpIn")->getData();
-  Array &outputBuffer = getOutput("bottomUpOut")->getData();
-  NTA_DEBUG  << "compute " << *getInput("bottomUpIn") << "\n";
+  Array &inputBuffer  = bottomUpIn_->getData();
+  Array &outputBuffer = bottomUpOut_->getData();
+  NTA_DEBUG  << "compute " << *bottomUpIn_ << "\n";
 
 
   // Call SpatialPooler compute
-  sp_->compute(inputBuffer.getSDR(), args_.learningMode, outputBuffer.getSDR());
+  sp_->compute(inputBuffer.getSDR(), args_.learningMode && !isDegraded(), outputBuffer.getSDR());
 
   // trace facility
-  NTA_DEBUG << "compute " << *getOutput("bottomUpOut") << "\n";
+  NTA_DEBUG << "compute " << *bottomUpOut_ << "\n";
 
 }
 
+void SPRegion::computeBatch(size_t n) {
+  NTA_ASSERT(sp_) << "SP not initialized";
+  const std::vector<Array> &inputs = bottomUpIn_->getBatch();
+  std::vector<Array> &outputs = bottomUpOut_->getBatch();
+
+  batchInputs_.resize(n, SDR(sp_->getInputDimensions()));
+  batchOutputs_.resize(n, SDR(sp_->getColumnDimensions()));
+  for (size_t i = 0; i < n; i++)
+    batchInputs_[i].setSDR(inputs[i].getSDR());
+
+  sp_->computeBatch(batchInputs_, batchOutputs_);
+  for (size_t i = 0; i < n; i++)
+    outputs[i].getSDRNoRefresh().setSDR(batchOutputs_[i]);
+}
+
+std::map<std::string, Real64> SPRegion::getMetrics() const {
+  if (!sp_)
+    return {};
+  const Connections &c = sp_->getConnections();
+  return {{"connections_segments", (Real64)c.numSegments()},
+          {"connections_synapses", (Real64)c.numSynapses()},
+          {"connections_pruned_segments_total", (Real64)c.numPrunedSegments()},
+          {"connections_pruned_synapses_total", (Real64)c.numPrunedSynapses()}};
+}
+
+MemoryUsage SPRegion::memoryUsage() const {
+  return sp_ ? sp_->memoryUsage() : MemoryUsage();
+}
+
 std::string SPRegion::executeCommand(const std::vector<std::string> &args, Int64 index) {
 
   UInt32 argCount = (UInt32)args.size();
@@ -184,6 +214,12 @@ std::string SPRegion::executeCommand(const std::vector<std::string> &args, Int64
 
     return "done";
   }
+  if (command == "prune") {
+    // prune <minPermanence>, see SpatialPooler::prune()
+    NTA_CHECK(argCount > 1) << "SPRegion: no minPermanence specified for " << command;
+    NTA_CHECK(sp_) << "SPRegion: " << command << " before initialization";
+    return std::to_string(sp_->prune(std::stof(args[1])));
+  }
   NTA_THROW << "SPRegion - Unknown command:" << command;
 }
 
@@ -558,7 +594,9 @@ Spec *SPRegion::createSpec() {
 
 
   /* ----- commands ------ */
-  // commands TBD
+  ns->commands.add("saveConnectionsToFile",
+                   CommandSpec("saveConnectionsToFile <path>: dump the connections to <path>.dump"));
+  ns->commands.add("prune", CommandSpec("prune <minPermanence>: destroy the synapses with a lower permanence, see SpatialPooler::prune(). Returns the number destroyed."));
 
   return ns;
 }
@@ -729,8 +767,7 @@ bool SPRegion::getParameterBool(const std::string &name, Int64 index) const {
   return this->RegionImpl::getParameterBool(name, index); // default
 }
 
-// copy the contents of the requested array into the caller's array.
-// Allocate the buffer in the Array object if one is not provided.  Convert data types if needed.
+// Answers the requested array in the caller's array.
 //
 // This may be confusing.  These 4 'array parameters' were part of the original function set so 
 // I am keeping them in the function for backward compatibility but they are removed from the
@@ -740,23 +777,31 @@ bool SPRegion::getParameterBool(const std::string &name, Int64 index) const {
 // the more generic functions the Array parameters in SPRegion are redundant.  
 // Also note that 'spInputNonZeros' and 'spOutputNonZeros' were a way to get the sparse arrays 
 // from the buffers.   Now that we have the SDR type there is a better way to get the sparse array.
+//
+// For monitors which poll them every step, the arrays are read-only views of the buffers,
+// valid until the next compute (copy() them to keep them): the non-zeros always, the dense
+// arrays if the caller's array is of type SDR or Byte.  Other types get a UInt32 copy.
 void SPRegion::getParameterArray(const std::string &name, Int64 index, Array &array) const {
   if (!region_->isInitialized())
     return;
-  if (name == "spatialPoolerInput") { 
-    // returns the dense array from the SDR
-    array = getInput("bottomUpIn")->getData().get_as(NTA_BasicType_UInt32);
-  } else if (name == "spatialPoolerOutput") {
-    // returns the dense array from the SDR
-    array = getOutput("bottomUpOut")->getData().get_as(NTA_BasicType_UInt32);
-  } else if (name == "spInputNonZeros") {
-    // returns the sparse array from the SDR
-    const SDR_sparse_t& v = getInput("bottomUpIn")->getData().getSDR().getSparse();
-    array = Array(v);
-  } else if (name == "spOutputNonZeros") {
-    // returns the sparse array from the SDR
-    const SDR_sparse_t& v = getOutput("bottomUpOut")->getData().getSDR().getSparse();
-    array = Array(v);
+  if (name == "spatialPoolerInput" || name == "spatialPoolerOutput") {
+    // the dense array from the SDR
+    Array &data = (name == "spatialPoolerInput") ? getInput("bottomUpIn")->getData()
+                                                 : getOutput("bottomUpOut")->getData();
+    if (array.getType() == NTA_BasicType_SDR) {
+      array.setBuffer(data.getSDR());
+    } else if (array.getType() == NTA_BasicType_Byte) {
+      array.setBuffer(data.getBuffer(), data.getCount());
+    } else {
+      array = data.get_as(NTA_BasicType_UInt32);
+    }
+  } else if (name == "spInputNonZeros" || name == "spOutputNonZeros") {
+    // the sparse array from the SDR
+    Array &data = (name == "spInputNonZeros") ? getInput("bottomUpIn")->getData()
+                                              : getOutput("bottomUpOut")->getData();
+    const SDR_sparse_t& v = data.getSDR().getSparse();
+    array = Array(NTA_BasicType_UInt32);
+    array.setBuffer(const_cast<UInt *>(v.data()), v.size());
   }
   else {
     this->RegionImpl::getParameterArray(name, index, array);
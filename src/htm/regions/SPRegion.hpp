@@ -56,7 +56,15 @@ class SPRegion  : public RegionImpl, Serializable
 
     // Compute outputs from inputs and internal state
     void compute() override;
+    // Inference only, through SpatialPooler::computeBatch().
+    bool canComputeBatch() const override { return !args_.learningMode && computeCallback_ == nullptr; }
+    void computeBatch(size_t n) override;
+    bool isPure() const override { return canComputeBatch(); }
+    bool canDegrade() const override { return true; } // skips learning
     std::string executeCommand(const std::vector<std::string>& args, Int64 index) override;
+    std::map<std::string, Real64> getMetrics() const override;
+    MemoryUsage memoryUsage() const override;
+    void setThreadPool(const std::shared_ptr<ThreadPool> &pool) override { if (sp_) sp_->setThreadPool(pool); }
 
     /**
     * Inputs/Outputs are made available in initialize()
@@ -122,6 +130,7 @@ class SPRegion  : public RegionImpl, Serializable
 	      SpatialPooler* sp = new SpatialPooler();
 	      sp_.reset(sp);
 	      ar(cereal::make_nvp("SP", sp_));
+	      if(auto budget = SynapseBudget::getProcessBudget()) sp_->setSynapseBudget(budget);
 	    }
 	  }
 
@@ -188,6 +197,12 @@ private:
 
     std::unique_ptr<SpatialPooler> sp_;
 
+    InputHandle bottomUpIn_{this, "bottomUpIn"};
+    OutputHandle bottomUpOut_{this, "bottomUpOut"};
+
+    // reused by computeBatch()
+    std::vector<SDR> batchInputs_;
+    std::vector<SDR> batchOutputs_;
 };
 } // namespace htm
 
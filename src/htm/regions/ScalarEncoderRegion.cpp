@@ -46,6 +46,19 @@ ScalarEncoderRegion::ScalarEncoderRegion(const ValueMap &params, Region *region)
 
 
   sensedValue_ = params.getScalarT<Real64>("sensedValue", -1.0);
+  delta_ = params.getString("delta", "");
+  initializeDelta_();
+}
+
+void ScalarEncoderRegion::initializeDelta_() {
+  deltaEncoder_.reset();
+  if (delta_.empty())
+    return;
+  NTA_CHECK(delta_ == "difference" || delta_ == "rate")
+    << "ScalarEncoderRegion: parameter 'delta' must be '', 'difference' or 'rate', got '" << delta_ << "'";
+  DeltaEncoderParameters args;
+  args.rate = (delta_ == "rate");
+  deltaEncoder_ = std::make_shared<DeltaEncoder>(encoder_, args);
 }
 
 ScalarEncoderRegion::ScalarEncoderRegion(ArWrapper &wrapper, Region *region):RegionImpl(region) {
@@ -101,19 +114,32 @@ std::string ScalarEncoderRegion::executeCommand(const std::vector<std::string> &
 
 void ScalarEncoderRegion::compute()
 {
-  if (hasInput("values")) {
-    Array &a = getInput("values")->getData();
+  if (values_->hasIncomingLinks()) {
+    Array &a = values_->getData();
     sensedValue_ = ((Real64 *)(a.getBuffer()))[0];
   }
-  SDR &output = getOutput("encoded")->getData().getSDR();
-  encoder_->encode((Real64)sensedValue_, output);
+  SDR &output = encoded_->getData().getSDR();
+  Real64 encodedValue = sensedValue_;
+  if (deltaEncoder_) {
+    if (timestamps_->hasIncomingLinks()) {
+      Array &t = timestamps_->getData();
+      deltaEncoder_->encode(sensedValue_, ((Real64 *)(t.getBuffer()))[0], output);
+    } else {
+      deltaEncoder_->encode(sensedValue_, output);
+    }
+    encodedValue = deltaEncoder_->getDelta();
+    if (std::isnan(encodedValue))
+      encodedValue = 0; // the first value, nothing was encoded
+  } else {
+    encoder_->encode((Real64)sensedValue_, output);
+  }
 
   // create the quantized sample or bucket. This becomes the title in the ClassifierRegion.
-  Real64 *quantizedSample = (Real64*)getOutput("bucket")->getData().getBuffer();
-  quantizedSample[0] = sensedValue_ - std::fmod(sensedValue_, encoder_->parameters.radius);
+  Real64 *quantizedSample = (Real64*)bucket_->getData().getBuffer();
+  quantizedSample[0] = encodedValue - std::fmod(encodedValue, encoder_->parameters.radius);
 
   // trace facility
-  NTA_DEBUG << "compute " << getOutput("encoded") << std::endl;
+  NTA_DEBUG << "compute " << *encoded_ << std::endl;
 }
 
 ScalarEncoderRegion::~ScalarEncoderRegion() {}
@@ -206,6 +232,16 @@ ScalarEncoderRegion::~ScalarEncoderRegion() {}
                                   "false", // defaultValue
                                   ParameterSpec::CreateAccess));
 
+  ns->parameters.add("delta",
+                    ParameterSpec(
+                                  "Encode the change since the previous value instead of the value: "
+                                  "'difference' or 'rate'. The default '' encodes the value.",
+                                  NTA_BasicType_Str,
+                                  1,       // elementCount
+                                  "",      // constraints
+                                  "",      // defaultValue
+                                  ParameterSpec::CreateAccess));
+
    /* ----- inputs ------- */
   ns->inputs.add("values",
                  InputSpec("The input values to be encoded.", // description
@@ -216,6 +252,16 @@ ScalarEncoderRegion::~ScalarEncoderRegion() {}
                            true                 // isDefaultInput
                            ));
 
+  ns->inputs.add("timestamps",
+                 InputSpec("Time of the values, a delta 'rate' is per unit of this time. "
+                           "If not linked, one unit per compute.", // description
+                           NTA_BasicType_Real64,   // type
+                           1,                   // count.
+                           false,                // required?
+                           false,               // isRegionLevel,
+                           false                // isDefaultInput
+                           ));
+
   /* ----- outputs ----- */
 
   ns->outputs.add("encoded", OutputSpec("Encoded value", NTA_BasicType_SDR,
@@ -279,6 +325,11 @@ void ScalarEncoderRegion::setParameterReal64(const std::string &name, Int64 inde
   }
 }
 
+std::string ScalarEncoderRegion::getParameterString(const std::string &name, Int64 index) const {
+  if (name == "delta") return delta_;
+  else return RegionImpl::getParameterString(name, index);
+}
+
 bool ScalarEncoderRegion::operator==(const RegionImpl &o) const {
   if (o.getType() != "ScalarEncoderRegion") return false;
   ScalarEncoderRegion &other = (ScalarEncoderRegion &)o;
@@ -292,6 +343,7 @@ bool ScalarEncoderRegion::operator==(const RegionImpl &o) const {
   if (params_.radius != other.params_.radius) return false;
   if (params_.resolution != other.params_.resolution) return false;
   if (sensedValue_ != other.sensedValue_) return false;
+  if (delta_ != other.delta_) return false;
 
   return true;
 }
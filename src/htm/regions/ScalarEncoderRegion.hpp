@@ -30,6 +30,7 @@
 #include <htm/ntypes/Value.hpp>
 #include <htm/types/Serializable.hpp>
 #include <htm/encoders/ScalarEncoder.hpp>
+#include <htm/encoders/DeltaEncoder.hpp>
 
 namespace htm {
 /**
@@ -40,6 +41,12 @@ namespace htm {
  * API. As a network runs, the client will specify new encoder inputs by
  * setting the "sensedValue" parameter. On each compute, the ScalarEncoderRegion will
  * encode its "sensedValue" to output.
+ *
+ * With the parameter "delta" set to "difference" or "rate" the region keeps
+ * the previous value, and encodes the change since it instead, see
+ * DeltaEncoder.  The range [minValue, maxValue] is then the range of the
+ * changes.  A rate is per unit of the optional input "timestamps", or per
+ * compute if that is not linked.
  */
 class ScalarEncoderRegion : public RegionImpl, Serializable {
 public:
@@ -53,10 +60,12 @@ public:
   virtual Real64 getParameterReal64(const std::string &name, Int64 index = -1) const override;
   virtual UInt32 getParameterUInt32(const std::string &name, Int64 index = -1) const override;
   virtual bool getParameterBool(const std::string &name, Int64 index = -1) const override;
+  virtual std::string getParameterString(const std::string &name, Int64 index = -1) const override;
   virtual void setParameterReal64(const std::string &name, Int64 index, Real64 value) override;
   virtual void initialize() override;
 
   void compute() override;
+  bool isPure() const override { return deltaEncoder_ == nullptr; }
   virtual std::string executeCommand(const std::vector<std::string> &args,
                                      Int64 index) override;
 
@@ -77,6 +86,9 @@ public:
        cereal::make_nvp("radius", params_.radius),
        cereal::make_nvp("resolution", params_.resolution),
        cereal::make_nvp("sensedValue_", sensedValue_));
+    ar(cereal::make_nvp("delta", delta_));
+    if (deltaEncoder_)
+      ar(cereal::make_nvp("deltaEncoder", *deltaEncoder_));
   }
   // FOR Cereal Deserialization
   // NOTE: the Region Implementation must have been allocated
@@ -97,6 +109,10 @@ public:
        cereal::make_nvp("resolution", params_.resolution),
        cereal::make_nvp("sensedValue_", sensedValue_));
     encoder_ = std::make_shared<ScalarEncoder>( params_ );
+    ar(cereal::make_nvp("delta", delta_));
+    initializeDelta_();
+    if (deltaEncoder_)
+      ar(cereal::make_nvp("deltaEncoder", *deltaEncoder_));
     setDimensions(encoder_->dimensions); 
   }
 
@@ -111,6 +127,14 @@ private:
   ScalarEncoderParameters params_;
 
   std::shared_ptr<ScalarEncoder> encoder_;
+  std::string delta_;
+  std::shared_ptr<DeltaEncoder> deltaEncoder_; // null: encode the value itself
+  InputHandle values_{this, "values"};
+  InputHandle timestamps_{this, "timestamps"};
+  OutputHandle encoded_{this, "encoded"};
+  OutputHandle bucket_{this, "bucket"};
+
+  void initializeDelta_();
 };
 } // namespace htm
 
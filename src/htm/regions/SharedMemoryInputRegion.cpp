@@ -0,0 +1,120 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the SharedMemoryInputRegion
+ */
+
+#include <htm/regions/SharedMemoryInputRegion.hpp>
+
+#include <htm/engine/Output.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/engine/Spec.hpp>
+#include <htm/ntypes/BasicType.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+/* static */ Spec *SharedMemoryInputRegion::createSpec() {
+  Spec *ns = new Spec();
+  ns->parseSpec(R"(
+  {name: "SharedMemoryInputRegion",
+      description: "Outputs what a SharedMemoryOutputRegion in another process sends.",
+      parameters: {
+          channel:          {description: "Name of the shared memory, as given to the sender.",
+                             type: String, default: ""},
+          dataType:         {description: "Type of dataOut, must be the sender's.",
+                             type: String, default: "SDR"},
+          propagationDelay: {description: "Computes which output zeros before the sender's data, like the delay of a Link.",
+                             type: UInt32, default: "0"},
+          timeout:          {description: "Milliseconds compute() waits for the sender before it throws.",
+                             type: UInt32, default: "10000"},
+          lost:             {description: "Of a broadcast sender, the data skipped since this region fell behind.",
+                             type: UInt64, access: ReadOnly}},
+      outputs: {
+          dataOut:          {description: "The data received, of type dataType.",
+                             type: SDR, count: 0, isDefaultOutput: yes, isRegionLevel: yes}}
+  } )");
+  return ns;
+}
+
+
+SharedMemoryInputRegion::SharedMemoryInputRegion(const ValueMap &par, Region *region)
+    : RegionImpl(region) {
+  spec_.reset(createSpec());
+  ValueMap params = ValidateParameters(par, spec_.get());
+  channel_ = params.getString("channel", "");
+  dataType_ = params.getString("dataType", "SDR");
+  propagationDelay_ = params.getScalarT<UInt32>("propagationDelay");
+  timeout_ = params.getScalarT<UInt32>("timeout");
+  NTA_CHECK(!channel_.empty()) << "SharedMemoryInputRegion: parameter 'channel' is required";
+  region->getOutput("dataOut")->setDataType(BasicType::parse(dataType_));
+}
+
+SharedMemoryInputRegion::SharedMemoryInputRegion(ArWrapper &wrapper, Region *region)
+    : RegionImpl(region) {
+  cereal_adapter_load(wrapper);
+}
+
+SharedMemoryInputRegion::~SharedMemoryInputRegion() {}
+
+
+void SharedMemoryInputRegion::initialize() {}
+
+
+void SharedMemoryInputRegion::compute() {
+  if (computes_ < propagationDelay_) {
+    // Like the initial contents of a delayed Link, the output is still zero.
+    computes_++;
+    return;
+  }
+  if (!ring_)
+    ring_.reset(new SharedMemoryRing(channel_, timeout_));
+  NTA_CHECK(ring_->pop(dataOut_->getData(), timeout_))
+      << "SharedMemoryInputRegion " << getName() << ": nothing was sent on " << channel_
+      << " for " << timeout_ << " ms";
+  computes_++;
+}
+
+
+std::string SharedMemoryInputRegion::getParameterString(const std::string &name, Int64 index) const {
+  if (name == "channel")  return channel_;
+  if (name == "dataType") return dataType_;
+  return RegionImpl::getParameterString(name, index);
+}
+
+UInt32 SharedMemoryInputRegion::getParameterUInt32(const std::string &name, Int64 index) const {
+  if (name == "propagationDelay") return propagationDelay_;
+  if (name == "timeout")          return timeout_;
+  return RegionImpl::getParameterUInt32(name, index);
+}
+
+UInt64 SharedMemoryInputRegion::getParameterUInt64(const std::string &name, Int64 index) const {
+  if (name == "lost") return ring_ ? ring_->lost() : 0u;
+  return RegionImpl::getParameterUInt64(name, index);
+}
+
+
+bool SharedMemoryInputRegion::operator==(const RegionImpl &o) const {
+  if (o.getType() != "SharedMemoryInputRegion") return false;
+  const SharedMemoryInputRegion &other = static_cast<const SharedMemoryInputRegion &>(o);
+  return channel_ == other.channel_ && dataType_ == other.dataType_
+      && propagationDelay_ == other.propagationDelay_ && timeout_ == other.timeout_
+      && computes_ == other.computes_;
+}
+
+} // namespace htm
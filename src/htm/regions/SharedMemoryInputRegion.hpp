@@ -0,0 +1,121 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Defines SharedMemoryInputRegion, the receiving end of a link between processes.
+ */
+
+#ifndef NTA_SHARED_MEMORY_INPUT_REGION_HPP
+#define NTA_SHARED_MEMORY_INPUT_REGION_HPP
+
+#include <memory>
+#include <string>
+
+#include <htm/engine/RegionImpl.hpp>
+#include <htm/engine/SharedMemoryRing.hpp>
+#include <htm/ntypes/Value.hpp>
+#include <htm/types/Serializable.hpp>
+
+namespace htm {
+
+/**
+ * The receiving end of a link from a Network in another process on the same
+ * host, see SharedMemoryOutputRegion.
+ *
+ * @b Description
+ * On each compute the oldest Array sent by the SharedMemoryOutputRegion of the
+ * same "channel" is put on output "dataOut".  If it was not sent yet, compute()
+ * waits for it.
+ *
+ * Parameters:
+ *   channel          - name of the shared memory, as given to the sender.
+ *   dataType         - of "dataOut", must be the sender's, default SDR.
+ *   dim              - the dimensions of "dataOut", unless the linked input
+ *                      determines them.  Their size must be the sender's.
+ *   propagationDelay - like the delay of a Link: the first propagationDelay
+ *                      computes output zeros, after that compute N outputs
+ *                      what the sender sent on its compute N - propagationDelay.
+ *                      The sender may run ahead by as many computes, if it has
+ *                      that many slots.
+ *   timeout          - milliseconds compute() waits for the sender before it throws.
+ *   lost             - (read only) of a broadcast sender, the Arrays skipped
+ *                      since this region fell more than a ring behind.
+ *
+ * The shared memory is opened on the first compute that needs it, so the two
+ * processes may start and initialize their Networks in any order.
+ *
+ * Example (process B):
+ *    net.addRegion("fromSP", "SharedMemoryInputRegion", "{channel: /htm_sp_to_tm, dim: [2048]}");
+ *    net.addRegion("tm", "TMRegion", "{cellsPerColumn: 8}");
+ *    net.link("fromSP", "tm", "", "", "dataOut", "bottomUpIn");
+ */
+class SharedMemoryInputRegion : public RegionImpl, Serializable {
+public:
+  SharedMemoryInputRegion(const ValueMap &params, Region *region);
+  SharedMemoryInputRegion(ArWrapper &wrapper, Region *region);
+  virtual ~SharedMemoryInputRegion() override;
+
+  static Spec *createSpec();
+
+  void initialize() override;
+  void compute() override;
+
+  std::string getParameterString(const std::string &name, Int64 index = -1) const override;
+  UInt32 getParameterUInt32(const std::string &name, Int64 index = -1) const override;
+  UInt64 getParameterUInt64(const std::string &name, Int64 index = -1) const override;
+
+  CerealAdapter;  // see Serializable.hpp
+  // FOR Cereal Serialization
+  template<class Archive>
+  void save_ar(Archive& ar) const {
+    ar(cereal::make_nvp("channel", channel_),
+       cereal::make_nvp("dataType", dataType_),
+       cereal::make_nvp("propagationDelay", propagationDelay_),
+       cereal::make_nvp("timeout", timeout_),
+       cereal::make_nvp("computes", computes_),
+       CEREAL_NVP(dim_));  // in base class
+  }
+  // FOR Cereal Deserialization
+  // The output keeps its type, the shared memory is opened again when needed.
+  template<class Archive>
+  void load_ar(Archive& ar) {
+    ar(cereal::make_nvp("channel", channel_),
+       cereal::make_nvp("dataType", dataType_),
+       cereal::make_nvp("propagationDelay", propagationDelay_),
+       cereal::make_nvp("timeout", timeout_),
+       cereal::make_nvp("computes", computes_),
+       CEREAL_NVP(dim_));  // in base class
+  }
+
+  bool operator==(const RegionImpl &other) const override;
+  inline bool operator!=(const SharedMemoryInputRegion &other) const {
+    return !operator==(other);
+  }
+
+private:
+  std::string channel_;
+  std::string dataType_;
+  UInt32 propagationDelay_;
+  UInt32 timeout_;
+  UInt64 computes_ = 0u;
+  std::unique_ptr<SharedMemoryRing> ring_;
+  OutputHandle dataOut_{this, "dataOut"};
+};
+
+} // namespace htm
+
+#endif // NTA_SHARED_MEMORY_INPUT_REGION_HPP
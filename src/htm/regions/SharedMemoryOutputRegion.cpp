@@ -0,0 +1,117 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the SharedMemoryOutputRegion
+ */
+
+#include <htm/regions/SharedMemoryOutputRegion.hpp>
+
+#include <htm/engine/Input.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/engine/Spec.hpp>
+#include <htm/ntypes/BasicType.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+/* static */ Spec *SharedMemoryOutputRegion::createSpec() {
+  Spec *ns = new Spec();
+  ns->parseSpec(R"(
+  {name: "SharedMemoryOutputRegion",
+      description: "Sends its input to a SharedMemoryInputRegion in another process.",
+      parameters: {
+          channel:  {description: "Name of the shared memory, '/' and a name without slashes.",
+                     type: String, default: ""},
+          dataType: {description: "Type of dataIn, the type of the linked output avoids a conversion.",
+                     type: String, default: "SDR"},
+          slots:    {description: "How many computes this region may be ahead of the reader.",
+                     type: UInt32, default: "4"},
+          timeout:  {description: "Milliseconds compute() waits for the reader before it throws.",
+                     type: UInt32, default: "10000"},
+          broadcast: {description: "For any number of readers, compute() never waits and slow readers lose data.",
+                     type: Bool, default: "false"}},
+      inputs: {
+          dataIn:   {description: "The data to send, of type dataType.",
+                     type: SDR, count: 0, isDefaultInput: yes, isRegionLevel: yes}}
+  } )");
+  return ns;
+}
+
+
+SharedMemoryOutputRegion::SharedMemoryOutputRegion(const ValueMap &par, Region *region)
+    : RegionImpl(region) {
+  spec_.reset(createSpec());
+  ValueMap params = ValidateParameters(par, spec_.get());
+  channel_ = params.getString("channel", "");
+  dataType_ = params.getString("dataType", "SDR");
+  slots_ = params.getScalarT<UInt32>("slots");
+  timeout_ = params.getScalarT<UInt32>("timeout");
+  broadcast_ = params.getScalarT<bool>("broadcast", false);
+  NTA_CHECK(!channel_.empty()) << "SharedMemoryOutputRegion: parameter 'channel' is required";
+  region->getInput("dataIn")->setDataType(BasicType::parse(dataType_));
+}
+
+SharedMemoryOutputRegion::SharedMemoryOutputRegion(ArWrapper &wrapper, Region *region)
+    : RegionImpl(region) {
+  cereal_adapter_load(wrapper);
+  region->getInput("dataIn")->setDataType(BasicType::parse(dataType_));
+}
+
+SharedMemoryOutputRegion::~SharedMemoryOutputRegion() {}
+
+
+void SharedMemoryOutputRegion::initialize() {
+  NTA_CHECK(dataIn_->hasIncomingLinks())
+      << "SharedMemoryOutputRegion " << getName() << ": 'dataIn' is not linked";
+  ring_.reset(new SharedMemoryRing(channel_, slots_, SharedMemoryRing::frameBytes(dataIn_->getData()), broadcast_));
+}
+
+
+void SharedMemoryOutputRegion::compute() {
+  NTA_CHECK(ring_->push(dataIn_->getData(), timeout_))
+      << "SharedMemoryOutputRegion " << getName() << ": the reader of " << channel_
+      << " did not take any data for " << timeout_ << " ms";
+}
+
+
+std::string SharedMemoryOutputRegion::getParameterString(const std::string &name, Int64 index) const {
+  if (name == "channel")  return channel_;
+  if (name == "dataType") return dataType_;
+  return RegionImpl::getParameterString(name, index);
+}
+
+UInt32 SharedMemoryOutputRegion::getParameterUInt32(const std::string &name, Int64 index) const {
+  if (name == "slots")   return slots_;
+  if (name == "timeout") return timeout_;
+  return RegionImpl::getParameterUInt32(name, index);
+}
+
+bool SharedMemoryOutputRegion::getParameterBool(const std::string &name, Int64 index) const {
+  if (name == "broadcast") return broadcast_;
+  return RegionImpl::getParameterBool(name, index);
+}
+
+
+bool SharedMemoryOutputRegion::operator==(const RegionImpl &o) const {
+  if (o.getType() != "SharedMemoryOutputRegion") return false;
+  const SharedMemoryOutputRegion &other = static_cast<const SharedMemoryOutputRegion &>(o);
+  return channel_ == other.channel_ && dataType_ == other.dataType_
+      && slots_ == other.slots_ && timeout_ == other.timeout_ && broadcast_ == other.broadcast_;
+}
+
+} // namespace htm
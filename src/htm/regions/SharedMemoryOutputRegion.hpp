@@ -0,0 +1,119 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Defines SharedMemoryOutputRegion, the sending end of a link between processes.
+ */
+
+#ifndef NTA_SHARED_MEMORY_OUTPUT_REGION_HPP
+#define NTA_SHARED_MEMORY_OUTPUT_REGION_HPP
+
+#include <memory>
+#include <string>
+
+#include <htm/engine/RegionImpl.hpp>
+#include <htm/engine/SharedMemoryRing.hpp>
+#include <htm/ntypes/Value.hpp>
+#include <htm/types/Serializable.hpp>
+
+namespace htm {
+
+/**
+ * The sending end of a link from a Network in one process to a Network in
+ * another process on the same host.
+ *
+ * @b Description
+ * Together with a SharedMemoryInputRegion of the same "channel" in the other
+ * process, this stands in for a Link that Network::link() can't make since
+ * its ends are in different processes.  On each compute the Array on input
+ * "dataIn" is copied into a SharedMemoryRing, which the SharedMemoryInputRegion
+ * puts on its output "dataOut".  Plain numeric buffers are copied as they are,
+ * SDRs as their sparse indices, nothing is serialized.
+ *
+ * Parameters:
+ *   channel  - name of the shared memory, "/" and a name without slashes.
+ *   dataType - of "dataIn", default SDR; use the type of the linked output
+ *              so the Link does not need to convert.
+ *   slots    - how many computes this region may be ahead of the reader
+ *              before compute() waits, default 4.
+ *   timeout  - milliseconds compute() waits for a free slot before it throws.
+ *   broadcast - for any number of readers, which may be other programs: the
+ *              region never waits, a reader which falls behind by more than
+ *              "slots" loses the oldest data.  See SharedMemoryRing.
+ *
+ * This region creates the shared memory in initialize() and removes it when
+ * destroyed.  The propagation delay is a parameter of the SharedMemoryInputRegion.
+ *
+ * Example (process A):
+ *    net.addRegion("sp",  "SPRegion", "{columnCount: 2048}");
+ *    net.addRegion("toTM", "SharedMemoryOutputRegion", "{channel: /htm_sp_to_tm}");
+ *    net.link("sp", "toTM", "", "", "bottomUpOut", "dataIn");
+ */
+class SharedMemoryOutputRegion : public RegionImpl, Serializable {
+public:
+  SharedMemoryOutputRegion(const ValueMap &params, Region *region);
+  SharedMemoryOutputRegion(ArWrapper &wrapper, Region *region);
+  virtual ~SharedMemoryOutputRegion() override;
+
+  static Spec *createSpec();
+
+  void initialize() override;
+  void compute() override;
+
+  std::string getParameterString(const std::string &name, Int64 index = -1) const override;
+  UInt32 getParameterUInt32(const std::string &name, Int64 index = -1) const override;
+  bool getParameterBool(const std::string &name, Int64 index = -1) const override;
+
+  CerealAdapter;  // see Serializable.hpp
+  // FOR Cereal Serialization
+  template<class Archive>
+  void save_ar(Archive& ar) const {
+    ar(cereal::make_nvp("channel", channel_),
+       cereal::make_nvp("dataType", dataType_),
+       cereal::make_nvp("slots", slots_),
+       cereal::make_nvp("timeout", timeout_),
+       cereal::make_nvp("broadcast", broadcast_));
+  }
+  // FOR Cereal Deserialization
+  // The shared memory is created again by initialize().
+  template<class Archive>
+  void load_ar(Archive& ar) {
+    ar(cereal::make_nvp("channel", channel_),
+       cereal::make_nvp("dataType", dataType_),
+       cereal::make_nvp("slots", slots_),
+       cereal::make_nvp("timeout", timeout_),
+       cereal::make_nvp("broadcast", broadcast_));
+  }
+
+  bool operator==(const RegionImpl &other) const override;
+  inline bool operator!=(const SharedMemoryOutputRegion &other) const {
+    return !operator==(other);
+  }
+
+private:
+  std::string channel_;
+  std::string dataType_;
+  UInt32 slots_;
+  UInt32 timeout_;
+  bool broadcast_;
+  std::unique_ptr<SharedMemoryRing> ring_;
+  InputHandle dataIn_{this, "dataIn"};
+};
+
+} // namespace htm
+
+#endif // NTA_SHARED_MEMORY_OUTPUT_REGION_HPP
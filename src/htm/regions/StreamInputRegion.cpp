@@ -0,0 +1,437 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the StreamInputRegion
+ */
+
+#include <htm/regions/StreamInputRegion.hpp>
+
+#include <chrono>
+#include <cstring> // memcpy, strerror
+#include <map>
+#include <mutex>
+
+#if !defined(NTA_OS_WINDOWS)
+#include <cerrno>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <htm/engine/Output.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/engine/Spec.hpp>
+#include <htm/ntypes/BasicType.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+namespace {
+  using Clock = std::chrono::steady_clock;
+
+  // How long the thread sleeps or polls before it looks at the stop flag again.
+  const std::chrono::milliseconds IDLE(1);
+  const int POLL_MS = 50;
+  const size_t RECV_BYTES = 64u * 1024u;
+
+  std::mutex sourcesMutex;
+  std::map<std::string, StreamInputRegion::Source> &sources() {
+    static std::map<std::string, StreamInputRegion::Source> registered;
+    return registered;
+  }
+
+#if !defined(NTA_OS_WINDOWS)
+  // false on timeout.
+  bool waitFor(const int fd, const int timeoutMs) {
+    struct pollfd p = {fd, POLLIN, 0};
+    const int n = poll(&p, 1, timeoutMs);
+    NTA_CHECK(n >= 0 || errno == EINTR) << "StreamInputRegion: poll failed: " << strerror(errno);
+    return n > 0;
+  }
+
+  // A socket on the port, both IPv6 and IPv4 when it can.
+  int openSocket(const int type, const UInt16 port) {
+    int fd = socket(AF_INET6, type, 0);
+    const bool v6 = fd >= 0;
+    if (!v6)
+      fd = socket(AF_INET, type, 0);
+    NTA_CHECK(fd >= 0) << "StreamInputRegion: can't create a socket: " << strerror(errno);
+    const int one = 1, zero = 0;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    int result;
+    if (v6) {
+      setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero)); // IPv4 too
+      struct sockaddr_in6 addr;
+      std::memset(&addr, 0, sizeof(addr));
+      addr.sin6_family = AF_INET6;
+      addr.sin6_addr = in6addr_any;
+      addr.sin6_port = htons(port);
+      result = bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr));
+    } else {
+      struct sockaddr_in addr;
+      std::memset(&addr, 0, sizeof(addr));
+      addr.sin_family = AF_INET;
+      addr.sin_addr.s_addr = htonl(INADDR_ANY);
+      addr.sin_port = htons(port);
+      result = bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr));
+    }
+    if (result != 0 || (type == SOCK_STREAM && listen(fd, 1) != 0)) {
+      const int error = errno;
+      ::close(fd);
+      NTA_THROW << "StreamInputRegion: can't open port " << port << ": " << strerror(error);
+    }
+    return fd;
+  }
+
+  UInt16 boundPort(const int fd) {
+    struct sockaddr_storage bound;
+    socklen_t len = sizeof(bound);
+    getsockname(fd, reinterpret_cast<struct sockaddr *>(&bound), &len);
+    return ntohs(bound.ss_family == AF_INET6 ? reinterpret_cast<struct sockaddr_in6 *>(&bound)->sin6_port
+                                             : reinterpret_cast<struct sockaddr_in *>(&bound)->sin_port);
+  }
+#endif
+} // namespace
+
+
+/* static */ void StreamInputRegion::registerSource(const std::string &name, Source source) {
+  NTA_CHECK(source) << "StreamInputRegion: source '" << name << "' is empty";
+  const std::lock_guard<std::mutex> lock(sourcesMutex);
+  sources()[name] = std::move(source);
+}
+
+/* static */ void StreamInputRegion::unregisterSource(const std::string &name) {
+  const std::lock_guard<std::mutex> lock(sourcesMutex);
+  sources().erase(name);
+}
+
+
+/* static */ Spec *StreamInputRegion::createSpec() {
+  Spec *ns = new Spec();
+  ns->parseSpec(R"(
+  {name: "StreamInputRegion",
+      description: "Outputs the records read from a socket or a registered source, one per compute.",
+      parameters: {
+          transport:     {description: "tcp, udp, or source for a callback registered with registerSource().",
+                          type: String, default: "tcp"},
+          port:          {description: "Port to read tcp or udp from, 0 picks a free one.",
+                          type: UInt32, default: "0"},
+          source:        {description: "Name of the registered callback, for transport source.",
+                          type: String, default: ""},
+          dataType:      {description: "Type of dataOut. Not String or Handle. An SDR record is its sorted sparse indices as UInt32.",
+                          type: String, default: "Real32"},
+          queueCapacity: {description: "Records buffered between the reading thread and compute().",
+                          type: UInt32, default: "1024"},
+          batchSize:     {description: "Records the thread passes to compute() at once.",
+                          type: UInt32, default: "64"},
+          timeout:       {description: "Milliseconds compute() waits for a record before it throws.",
+                          type: UInt32, default: "10000"},
+          available:     {description: "Records waiting for compute().",
+                          type: UInt32, access: ReadOnly},
+          received:      {description: "Records read so far.",
+                          type: UInt64, access: ReadOnly},
+          dropped:       {description: "Records dropped so far, udp only: the queue was full or a datagram was malformed.",
+                          type: UInt64, access: ReadOnly}},
+      outputs: {
+          dataOut:       {description: "The current record, of type dataType.",
+                          type: Real32, count: 0, isDefaultOutput: yes, isRegionLevel: yes}}
+  } )");
+  return ns;
+}
+
+
+StreamInputRegion::StreamInputRegion(const ValueMap &par, Region *region)
+    : RegionImpl(region) {
+  spec_.reset(createSpec());
+  ValueMap params = ValidateParameters(par, spec_.get());
+  transport_ = params.getString("transport", "tcp");
+  port_ = params.getScalarT<UInt32>("port");
+  source_ = params.getString("source", "");
+  dataType_ = params.getString("dataType", "Real32");
+  queueCapacity_ = params.getScalarT<UInt32>("queueCapacity");
+  batchSize_ = params.getScalarT<UInt32>("batchSize");
+  timeout_ = params.getScalarT<UInt32>("timeout");
+  NTA_CHECK(transport_ == "tcp" || transport_ == "udp" || transport_ == "source")
+      << "StreamInputRegion: unknown transport '" << transport_ << "', expected tcp, udp or source.";
+  NTA_CHECK(port_ <= 0xFFFFu) << "StreamInputRegion: bad port " << port_;
+  NTA_CHECK(batchSize_ > 0u && queueCapacity_ >= batchSize_)
+      << "StreamInputRegion: need 0 < batchSize <= queueCapacity, got " << batchSize_ << " and " << queueCapacity_;
+  const NTA_BasicType type = BasicType::parse(dataType_);
+  NTA_CHECK(type != NTA_BasicType_Str && type != NTA_BasicType_Handle)
+      << "StreamInputRegion: dataType " << dataType_ << " is not plain data";
+  region->getOutput("dataOut")->setDataType(type);
+}
+
+StreamInputRegion::StreamInputRegion(ArWrapper &wrapper, Region *region)
+    : RegionImpl(region) {
+  cereal_adapter_load(wrapper);
+}
+
+StreamInputRegion::~StreamInputRegion() { stop_(); }
+
+
+void StreamInputRegion::stop_() {
+  stop_flag_ = true;
+  if (thread_.joinable())
+    thread_.join();
+#if !defined(NTA_OS_WINDOWS)
+  if (fd_ >= 0)
+    ::close(fd_);
+#endif
+  fd_ = -1;
+}
+
+
+void StreamInputRegion::initialize() {
+  const Array &out = dataOut_->getData();
+  maxBytes_ = out.getType() == NTA_BasicType_SDR ? out.getCount() * sizeof(UInt32)
+                                                 : out.getCount() * BasicType::getSize(out.getType());
+
+  // Whole batches, so the thread never waits for compute() to finish one.
+  Batch prototype;
+  prototype.data.reserve(batchSize_ * maxBytes_);
+  prototype.ends.reserve(batchSize_);
+  queue_.reset(new SpscQueue<Batch>(queueCapacity_ / batchSize_, prototype));
+
+  Source source;
+  if (transport_ == "source") {
+    const std::lock_guard<std::mutex> lock(sourcesMutex);
+    const auto found = sources().find(source_);
+    NTA_CHECK(found != sources().end()) << "StreamInputRegion: no source registered as '" << source_ << "'";
+    source = found->second;
+  } else {
+#if defined(NTA_OS_WINDOWS)
+    NTA_THROW << "StreamInputRegion: transport " << transport_ << " is not available on Windows";
+#else
+    fd_ = openSocket(transport_ == "tcp" ? SOCK_STREAM : SOCK_DGRAM, static_cast<UInt16>(port_));
+    port_ = boundPort(fd_);
+#endif
+  }
+  thread_ = std::thread([this, source]() {
+    try {
+      if (transport_ == "tcp")      runTcp_();
+      else if (transport_ == "udp") runUdp_();
+      else                          runSource_(source);
+    } catch (const std::exception &e) {
+      error_ = e.what();
+      failed_ = true;
+    }
+  });
+}
+
+
+bool StreamInputRegion::add_(const char *record, const size_t bytes, const bool drop) {
+  NTA_CHECK(bytes <= maxBytes_) << "StreamInputRegion: a record of " << bytes
+      << " bytes, dataOut holds " << maxBytes_;
+  while (filling_ == nullptr) {
+    filling_ = queue_->back();
+    if (filling_ != nullptr) {
+      filling_->data.clear();
+      filling_->ends.clear();
+    } else if (drop) {
+      dropped_++;
+      return true;
+    } else if (stop_flag_) {
+      return false;
+    } else {
+      std::this_thread::sleep_for(IDLE); // backpressure: compute() is behind
+    }
+  }
+  filling_->data.insert(filling_->data.end(), record, record + bytes);
+  filling_->ends.push_back(filling_->data.size());
+  received_++;
+  if (filling_->ends.size() == batchSize_)
+    publish_();
+  return true;
+}
+
+
+void StreamInputRegion::publish_() {
+  if (filling_ == nullptr)
+    return;
+  const size_t records = filling_->ends.size();
+  queue_->push();
+  published_ += records;
+  filling_ = nullptr;
+}
+
+
+// Records from a buffer, returns the bytes used: a partial record at the end is left.
+size_t StreamInputRegion::parse_(const char *data, const size_t bytes, const bool drop) {
+  size_t used = 0u;
+  while (bytes - used >= sizeof(UInt32)) {
+    UInt32 length;
+    std::memcpy(&length, data + used, sizeof(length));
+    if (bytes - used - sizeof(length) < length)
+      break;
+    if (!add_(data + used + sizeof(length), length, drop))
+      return bytes;
+    used += sizeof(length) + length;
+  }
+  return used;
+}
+
+
+void StreamInputRegion::runTcp_() {
+#if !defined(NTA_OS_WINDOWS)
+  std::vector<char> pending;
+  while (!stop_flag_) {
+    if (!waitFor(fd_, POLL_MS))
+      continue;
+    const int connection = ::accept(fd_, nullptr, nullptr);
+    NTA_CHECK(connection >= 0) << "StreamInputRegion: accept on port " << port_ << " failed: " << strerror(errno);
+    pending.clear();
+    while (!stop_flag_) {
+      if (!waitFor(connection, POLL_MS))
+        continue;
+      const size_t have = pending.size();
+      pending.resize(have + RECV_BYTES);
+      const ssize_t n = ::recv(connection, pending.data() + have, RECV_BYTES, 0);
+      if (n <= 0) {
+        pending.resize(have);
+        if (n < 0 && errno == EINTR)
+          continue;
+        break; // the sender closed, accept the next one
+      }
+      pending.resize(have + static_cast<size_t>(n));
+      // While add_() waits for room in the queue nothing is read, so TCP's
+      // flow control holds the sender back.
+      const size_t used = parse_(pending.data(), pending.size(), false);
+      pending.erase(pending.begin(), pending.begin() + used);
+      publish_(); // what arrived together, so compute() sees it without waiting for a full batch
+    }
+    ::close(connection);
+    if (!pending.empty()) {
+      NTA_WARN << "StreamInputRegion: the sender on port " << port_ << " closed in the middle of a record, "
+               << pending.size() << " bytes lost";
+    }
+  }
+#endif
+}
+
+
+void StreamInputRegion::runUdp_() {
+#if !defined(NTA_OS_WINDOWS)
+  std::vector<char> datagram(RECV_BYTES);
+  while (!stop_flag_) {
+    if (!waitFor(fd_, POLL_MS))
+      continue;
+    const ssize_t n = ::recv(fd_, datagram.data(), datagram.size(), 0);
+    if (n <= 0)
+      continue;
+    // Drop what does not fit in the queue, UDP can't hold the sender back.
+    if (parse_(datagram.data(), static_cast<size_t>(n), true) != static_cast<size_t>(n))
+      dropped_++; // a truncated record
+    publish_();
+  }
+#endif
+}
+
+
+void StreamInputRegion::runSource_(const Source &source) {
+  std::vector<char> record;
+  while (!stop_flag_) {
+    record.clear();
+    if (!source(record)) {
+      publish_();
+      std::this_thread::sleep_for(IDLE);
+      continue;
+    }
+    if (!add_(record.data(), record.size(), false))
+      break;
+  }
+}
+
+
+void StreamInputRegion::compute() {
+  const auto deadline = Clock::now() + std::chrono::milliseconds(timeout_);
+  Batch *batch;
+  while ((batch = queue_->front()) == nullptr) {
+    NTA_CHECK(!failed_) << "StreamInputRegion " << getName() << ": " << error_;
+    NTA_CHECK(Clock::now() < deadline) << "StreamInputRegion " << getName() << ": no record for "
+        << timeout_ << " ms";
+    std::this_thread::sleep_for(IDLE);
+  }
+  const size_t begin = next_ == 0u ? 0u : batch->ends[next_ - 1u];
+  output_(batch->data.data() + begin, batch->ends[next_] - begin);
+  if (++next_ == batch->ends.size()) {
+    next_ = 0u;
+    queue_->pop();
+  }
+  consumed_++;
+}
+
+
+void StreamInputRegion::output_(const char *record, const size_t bytes) {
+  Array &out = dataOut_->getData();
+  if (out.getType() == NTA_BasicType_SDR) {
+    NTA_CHECK(bytes % sizeof(UInt32) == 0u) << "StreamInputRegion " << getName()
+        << ": an SDR record of " << bytes << " bytes, not whole UInt32 indices";
+    SDR &sdr = out.getSDR();
+    sparse_.resize(bytes / sizeof(UInt32));
+    std::memcpy(sparse_.data(), record, bytes);
+    // setSparse() only checks the order with NTA_ASSERTIONS_ON.
+    for (size_t i = 1u; i < sparse_.size(); i++) {
+      NTA_CHECK(sparse_[i - 1u] < sparse_[i]) << "StreamInputRegion " << getName()
+          << ": SDR indices are not strictly increasing, " << sparse_[i - 1u] << " then " << sparse_[i];
+    }
+    NTA_CHECK(sparse_.empty() || sparse_.back() < sdr.size) << "StreamInputRegion " << getName()
+        << ": index " << sparse_.back() << " out of an SDR of " << sdr.size;
+    sdr.setSparse(sparse_);
+  } else {
+    NTA_CHECK(bytes == maxBytes_) << "StreamInputRegion " << getName() << ": a record of " << bytes
+        << " bytes, dataOut is " << maxBytes_;
+    std::memcpy(out.getBuffer(), record, bytes);
+  }
+}
+
+
+std::string StreamInputRegion::getParameterString(const std::string &name, Int64 index) const {
+  if (name == "transport") return transport_;
+  if (name == "source")    return source_;
+  if (name == "dataType")  return dataType_;
+  return RegionImpl::getParameterString(name, index);
+}
+
+UInt32 StreamInputRegion::getParameterUInt32(const std::string &name, Int64 index) const {
+  if (name == "port")          return port_;
+  if (name == "queueCapacity") return queueCapacity_;
+  if (name == "batchSize")     return batchSize_;
+  if (name == "timeout")       return timeout_;
+  if (name == "available")     return static_cast<UInt32>(published_ - consumed_);
+  return RegionImpl::getParameterUInt32(name, index);
+}
+
+UInt64 StreamInputRegion::getParameterUInt64(const std::string &name, Int64 index) const {
+  if (name == "received") return received_;
+  if (name == "dropped")  return dropped_;
+  return RegionImpl::getParameterUInt64(name, index);
+}
+
+
+bool StreamInputRegion::operator==(const RegionImpl &o) const {
+  if (o.getType() != "StreamInputRegion") return false;
+  const StreamInputRegion &other = static_cast<const StreamInputRegion &>(o);
+  return transport_ == other.transport_ && port_ == other.port_ && source_ == other.source_
+      && dataType_ == other.dataType_ && queueCapacity_ == other.queueCapacity_
+      && batchSize_ == other.batchSize_ && timeout_ == other.timeout_;
+}
+
+} // namespace htm
@@ -0,0 +1,187 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Defines StreamInputRegion, a sensor fed by a socket or an ingest callback.
+ */
+
+#ifndef NTA_STREAM_INPUT_REGION_HPP
+#define NTA_STREAM_INPUT_REGION_HPP
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <htm/engine/RegionImpl.hpp>
+#include <htm/ntypes/Value.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/types/Serializable.hpp>
+#include <htm/utils/SpscQueue.hpp>
+
+namespace htm {
+
+/**
+ * A sensor region which outputs one record per compute, from a stream of
+ * records read by a background thread.
+ *
+ * @b Description
+ * A record is a UInt32 length, in bytes and in the host's byte order, then
+ * the payload: the values of "dataOut" as they are in memory, or for an SDR
+ * its sparse indices as UInt32.  Records come from:
+ *   transport: tcp     - a connection to "port"; when the sender closes it,
+ *                        the next one is accepted.
+ *   transport: udp     - datagrams to "port", each one or more records.
+ *   transport: source  - a callback registered with registerSource() under
+ *                        the name "source", eg. a Kafka consumer.
+ *
+ * The thread groups the records into batches of up to "batchSize", and
+ * passes them to compute() through a lock-free queue of "queueCapacity"
+ * records, so neither side takes a lock or allocates per record.  When the
+ * queue is full the thread stops reading: a TCP sender is then held back by
+ * the socket buffers, a source is not called, UDP datagrams are dropped (see
+ * "dropped").
+ *
+ * compute() waits up to "timeout" ms for the next record, then throws.  To
+ * run the Network on what arrived, without waiting:
+ *    net.run(region->getParameterUInt32("available"));
+ *
+ * Parameters:
+ *   transport, port, source - see above; port 0 picks a free one, read it
+ *                      back with getParameterUInt32("port") after initialize().
+ *   dataType         - of "dataOut", default Real32.
+ *   dim              - the dimensions of "dataOut".
+ *   queueCapacity    - records buffered between the thread and compute().
+ *   batchSize        - records per queue slot.
+ *   timeout          - milliseconds compute() waits before it throws.
+ *   available        - (read only) records waiting in the queue.
+ *   received, dropped - (read only) records so far.
+ *
+ * Not available on Windows, except for transport source.  The queued
+ * records are not serialized.
+ *
+ * Example:
+ *    net.addRegion("sensor", "StreamInputRegion", "{transport: tcp, port: 9100, dim: [16]}");
+ *    net.addRegion("encoder", "MultiEncoderRegion", ...);
+ *    net.link("sensor", "encoder", "", "", "dataOut", "values");
+ */
+class StreamInputRegion : public RegionImpl, Serializable {
+public:
+  /**
+   * Called from the region's thread for the next record, which it appends to
+   * `record` (empty on entry).  Returns false when there is none yet, then it
+   * is called again a little later.
+   */
+  using Source = std::function<bool(std::vector<char> &record)>;
+
+  /** Register a source for transport "source", by name. */
+  static void registerSource(const std::string &name, Source source);
+  static void unregisterSource(const std::string &name);
+
+  StreamInputRegion(const ValueMap &params, Region *region);
+  StreamInputRegion(ArWrapper &wrapper, Region *region);
+  virtual ~StreamInputRegion() override;
+
+  static Spec *createSpec();
+
+  void initialize() override;
+  void compute() override;
+
+  std::string getParameterString(const std::string &name, Int64 index = -1) const override;
+  UInt32 getParameterUInt32(const std::string &name, Int64 index = -1) const override;
+  UInt64 getParameterUInt64(const std::string &name, Int64 index = -1) const override;
+
+  CerealAdapter;  // see Serializable.hpp
+  // FOR Cereal Serialization
+  template<class Archive>
+  void save_ar(Archive& ar) const {
+    ar(cereal::make_nvp("transport", transport_),
+       cereal::make_nvp("port", port_),
+       cereal::make_nvp("source", source_),
+       cereal::make_nvp("dataType", dataType_),
+       cereal::make_nvp("queueCapacity", queueCapacity_),
+       cereal::make_nvp("batchSize", batchSize_),
+       cereal::make_nvp("timeout", timeout_),
+       CEREAL_NVP(dim_));  // in base class
+  }
+  // FOR Cereal Deserialization
+  // The output keeps its type, initialize() starts reading again.
+  template<class Archive>
+  void load_ar(Archive& ar) {
+    ar(cereal::make_nvp("transport", transport_),
+       cereal::make_nvp("port", port_),
+       cereal::make_nvp("source", source_),
+       cereal::make_nvp("dataType", dataType_),
+       cereal::make_nvp("queueCapacity", queueCapacity_),
+       cereal::make_nvp("batchSize", batchSize_),
+       cereal::make_nvp("timeout", timeout_),
+       CEREAL_NVP(dim_));  // in base class
+  }
+
+  bool operator==(const RegionImpl &other) const override;
+  inline bool operator!=(const StreamInputRegion &other) const {
+    return !operator==(other);
+  }
+
+private:
+  // Records back to back, each ending at ends[i].
+  struct Batch {
+    std::vector<char>   data;
+    std::vector<size_t> ends;
+  };
+
+  void stop_();
+  void run_();             // the thread
+  void runTcp_();
+  void runUdp_();
+  void runSource_(const Source &source);
+  size_t parse_(const char *data, size_t bytes, bool drop);
+  // To the batch being filled, when the queue is full drop it or wait; false if stopped.
+  bool add_(const char *record, size_t bytes, bool drop);
+  void publish_();         // the batch being filled
+  void output_(const char *record, size_t bytes);
+
+  std::string transport_;
+  UInt32 port_;
+  std::string source_;
+  std::string dataType_;
+  UInt32 queueCapacity_;
+  UInt32 batchSize_;
+  UInt32 timeout_;
+
+  int fd_ = -1;  // the listening TCP, or the UDP socket
+  size_t maxBytes_ = 0u;      // of a record
+  std::unique_ptr<SpscQueue<Batch>> queue_;
+  Batch *filling_ = nullptr;  // producer, the slot being filled
+  size_t next_ = 0u;          // consumer, the next record of front()
+  SDR_sparse_t sparse_;       // consumer
+  std::atomic<bool>   stop_flag_{false};
+  std::atomic<bool>   failed_{false};
+  std::string error_;         // of the thread, once failed_
+  std::atomic<UInt64> received_{0u};
+  std::atomic<UInt64> published_{0u};
+  std::atomic<UInt64> consumed_{0u};
+  std::atomic<UInt64> dropped_{0u};
+  std::thread thread_;
+  OutputHandle dataOut_{this, "dataOut"};
+};
+
+} // namespace htm
+
+#endif // NTA_STREAM_INPUT_REGION_HPP
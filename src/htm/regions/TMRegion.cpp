@@ -173,6 +173,7 @@ void TMRegion::initialize() {
       args_.predictedSegmentDecrement, args_.seed, args_.maxSegmentsPerCell,
       args_.maxSynapsesPerSegment, args_.checkInputs, args_.externalPredictiveInputs);
   tm_.reset(tm);
+  if(auto budget = SynapseBudget::getProcessBudget()) tm_->setSynapseBudget(budget);
 
   args_.iter = 0;
   args_.sequencePos = 0;
@@ -188,8 +189,8 @@ void TMRegion::compute() {
   args_.iter++;
 
   // Handle reset signal
-  if (getInput("resetIn")->hasIncomingLinks()) {
-    Array &reset = getInput("resetIn")->getData();
+  if (resetIn_->hasIncomingLinks()) {
+    Array &reset = resetIn_->getData();
     NTA_ASSERT(reset.getType() == NTA_BasicType_Real32);
     if (reset.getCount() == 1 && ((Real32 *)(reset.getBuffer()))[0] != 0) {
       tm_->reset();
@@ -199,25 +200,26 @@ void TMRegion::compute() {
 
   // Check the input buffer
   // The buffer width is the number of columns.
-  std::shared_ptr<Input> in = getInput("bottomUpIn");
+  Input *in = bottomUpIn_.get();
   Array &bottomUpIn = in->getData();
   NTA_ASSERT(bottomUpIn.getType() == NTA_BasicType_SDR);
   SDR& activeColumns = bottomUpIn.getSDR();
 
   // Check for 'externalPredictiveInputs' inputs
-  static SDR nullSDR({0});
-  Array &externalPredictiveInputsActive = getInput("externalPredictiveInputsActive")->getData();
-  SDR& externalPredictiveInputsActiveCells = (args_.externalPredictiveInputs) ? (externalPredictiveInputsActive.getSDR()) : nullSDR;
+  SDR::Scratch nullSDR({0});
+  Array &externalPredictiveInputsActive = externalPredictiveInputsActive_->getData();
+  SDR& externalPredictiveInputsActiveCells = (args_.externalPredictiveInputs) ? (externalPredictiveInputsActive.getSDR()) : *nullSDR;
 
-  Array &externalPredictiveInputsWinners = getInput("externalPredictiveInputsWinners")->getData();
-  SDR& externalPredictiveInputsWinnerCells = (args_.externalPredictiveInputs) ? (externalPredictiveInputsWinners.getSDR()) : nullSDR;
+  Array &externalPredictiveInputsWinners = externalPredictiveInputsWinners_->getData();
+  SDR& externalPredictiveInputsWinnerCells = (args_.externalPredictiveInputs) ? (externalPredictiveInputsWinners.getSDR()) : *nullSDR;
 
   // Trace facility
   NTA_DEBUG << "compute " << *in << std::endl;
 
   // Perform Bottom up compute()
 
-  tm_->compute(activeColumns, args_.learningMode, externalPredictiveInputsActiveCells, externalPredictiveInputsWinnerCells);
+  tm_->compute(activeColumns, args_.learningMode && !isDegraded(), externalPredictiveInputsActiveCells,
+               externalPredictiveInputsWinnerCells);
 
   args_.sequencePos++;
 
@@ -231,49 +233,66 @@ void TMRegion::compute() {
   //         or explicitly for each output region->setOutputDimensions(output_name).
   //       - The total number of elements in the outputs must be
   //         numberOfCols * cellsPerColumn unless args_.orColumnOutputs is set.
+  //       - Only the outputs which are linked or watched are filled in here,
+  //         the others when read, see computeOutput().
   //
-  std::shared_ptr<Output> out;
-  out = getOutput("bottomUpOut");
-    //call Network::setLogLevel(LogLevel::LogLevel_Verbose);
-    //     to output the NTA_DEBUG statements below
-    
-    // The dimensions should already be set on output buffers.
-    std::vector<UInt> out_dims = out->getDimensions().asVector(); // column dimensions (eg 10x100), makes copy.
-    if (args_.orColumnOutputs)                    // if we are outputing only columns, we expect one more dimension in active cells.
-      out_dims.push_back(args_.cellsPerColumn);   // add n+1-th dimension for cellsPerColumn (eg. 10x100x8)
-    SDR active(out_dims);                         // create an SDR with the dimensions of active cells.
-
-    tm_->getActiveCells(active); //active cells
+  tm_->activateDendrites();
+  for (const OutputHandle *out : {&bottomUpOut_, &activeCells_, &predictedActiveCells_, &predictiveCells_}) {
+    if (isDemanded(*out))
+      computeOutput_(**out);
+  }
+  computeOutput_(*anomaly_);
+}
+
+
+void TMRegion::computeOutput(const std::string &name) {
+  computeOutput_(*getOutput(name));
+}
+
+
+void TMRegion::computeOutput_(Output &out) {
+  //call Network::setLogLevel(LogLevel::LogLevel_Verbose);
+  //     to output the NTA_DEBUG statements below
+  if (&out == bottomUpOut_.get()) {
+    // Straight from the TM's vector of active cells, no intermediate SDR.
     if (args_.orColumnOutputs) // output as columns
-      out->getData().getSDR() = tm_->cellsToColumns(active);
+      tm_->cellsToColumns(tm_->getActiveCellsView(), out.getData().getSDR());
     else
-      out->getData().getSDR() = active;
-    NTA_DEBUG << "compute " << *out << std::endl;
-  
-  out = getOutput("activeCells");
-    tm_->getActiveCells(out->getData().getSDR());
-    NTA_DEBUG << "compute "<< *out << std::endl;
-  
-  out = getOutput("predictedActiveCells");
-    tm_->activateDendrites();
-    tm_->getWinnerCells(out->getData().getSDR());
-    NTA_DEBUG << "compute "<< *out << std::endl;
-  
-  out = getOutput("anomaly");
-    Real32* buffer = reinterpret_cast<Real32*>(out->getData().getBuffer());
+      tm_->getActiveCellsView().copyTo(out.getData().getSDR());
+  } else if (&out == activeCells_.get()) {
+    tm_->getActiveCellsView().copyTo(out.getData().getSDR());
+  } else if (&out == predictedActiveCells_.get()) {
+    tm_->getWinnerCellsView().copyTo(out.getData().getSDR());
+  } else if (&out == anomaly_.get()) {
+    Real32* buffer = reinterpret_cast<Real32*>(out.getData().getBuffer());
     buffer[0] = tm_->anomaly; //only the first field is valid
-    NTA_DEBUG << "compute "<< *out << std::endl;
-  
-  out = getOutput("predictiveCells");
-    SDR predictive = tm_->getPredictiveCells();
+  } else if (&out == predictiveCells_.get()) {
+    const SDR &predictive = tm_->getPredictiveCellsRef();
     if (args_.orColumnOutputs)  // output as columns
-      out->getData().getSDR() = tm_->cellsToColumns(predictive);
+      tm_->cellsToColumns(predictive, out.getData().getSDR());
     else
-      out->getData().getSDR() = predictive;
-    NTA_DEBUG << "compute " << *out << std::endl;
+      out.getData().getSDR() = predictive;
+  } else {
+    NTA_THROW << "TMRegion: no output " << out.getName();
+  }
+  NTA_DEBUG << "compute " << out << std::endl;
 }
 
 
+std::map<std::string, Real64> TMRegion::getMetrics() const {
+  if (!tm_)
+    return {};
+  const Connections &c = tm_->connections;
+  return {{"connections_segments", (Real64)c.numSegments()},
+          {"connections_synapses", (Real64)c.numSynapses()},
+          {"connections_pruned_segments_total", (Real64)c.numPrunedSegments()},
+          {"connections_pruned_synapses_total", (Real64)c.numPrunedSynapses()}};
+}
+
+MemoryUsage TMRegion::memoryUsage() const {
+  return tm_ ? tm_->memoryUsage() : MemoryUsage();
+}
+
 std::string TMRegion::executeCommand(const std::vector<std::string> &args, Int64 index) {
 
   UInt32 argCount = (UInt32)args.size();
@@ -294,6 +313,14 @@ std::string TMRegion::executeCommand(const std::vector<std::string> &args, Int64
 
     return "done";
   }
+  else if (command == "prune") {
+    // prune <minPermanence> [<maxSegmentAge>], see TemporalMemory::prune()
+    NTA_CHECK(argCount > 1) << "TMRegion: no minPermanence specified for " << command;
+    NTA_CHECK(tm_) << "TMRegion: " << command << " before initialization";
+    const UInt32 maxSegmentAge = argCount > 2 ? static_cast<UInt32>(std::stoul(args[2])) : 0u;
+    const auto destroyed = tm_->prune(std::stof(args[1]), maxSegmentAge);
+    return std::to_string(destroyed.first) + " " + std::to_string(destroyed.second);
+  }
   else
   NTA_THROW << "TMRegion - Unknown command:" << command;
 }
@@ -474,6 +501,26 @@ Spec *TMRegion::createSpec() {
                     ParameterSpec::CreateAccess)); // access
 
 
+  ns->parameters.add(
+      "activeCellsNonZeros",
+      ParameterSpec("The indices of the active cells, a read-only view valid until the "
+                    "next compute.",
+                    NTA_BasicType_UInt32,            // type
+                    0,                               // elementCount
+                    "",                              // constraints
+                    "",                              // defaultValue
+                    ParameterSpec::ReadOnlyAccess)); // access
+
+  ns->parameters.add(
+      "winnerCellsNonZeros",
+      ParameterSpec("The indices of the winner cells, a read-only view valid until the "
+                    "next compute.",
+                    NTA_BasicType_UInt32,            // type
+                    0,                               // elementCount
+                    "",                              // constraints
+                    "",                              // defaultValue
+                    ParameterSpec::ReadOnlyAccess)); // access
+
   ns->parameters.add(
       "activeOutputCount",
       ParameterSpec("(int)Number of active elements.",
@@ -618,7 +665,9 @@ Spec *TMRegion::createSpec() {
 
 
   /* ----- commands ------ */
-  // commands TBD
+  ns->commands.add("saveConnectionsToFile",
+                   CommandSpec("saveConnectionsToFile <path>: dump the connections to <path>.dump"));
+  ns->commands.add("prune", CommandSpec("prune <minPermanence> [<maxSegmentAge>]: destroy the synapses with a lower permanence and the segments unused for longer, see TemporalMemory::prune(). Returns the numbers of synapses and segments destroyed."));
 
   return ns;
 }
@@ -757,6 +806,30 @@ std::string TMRegion::getParameterString(const std::string &name, Int64 index) c
 }
 
 
+// The cell indices are not copied: the array becomes a read-only view of the
+// TM's vector, valid until the next compute.  copy() it to keep it.
+void TMRegion::getParameterArray(const std::string &name, Int64 index, Array &array) const {
+  if (name == "activeCellsNonZeros" || name == "winnerCellsNonZeros") {
+    array = Array(NTA_BasicType_UInt32);
+    if (!tm_)
+      return;
+    const auto &cells = (name == "activeCellsNonZeros") ? tm_->getActiveCellsRef() : tm_->getWinnerCellsRef();
+    array.setBuffer(const_cast<CellIdx *>(cells.data()), cells.size());
+    return;
+  }
+  this->RegionImpl::getParameterArray(name, index, array);
+}
+
+
+size_t TMRegion::getParameterArrayCount(const std::string &name, Int64 index) const {
+  if (name == "activeCellsNonZeros")
+    return tm_ ? tm_->getActiveCellsRef().size() : 0u;
+  if (name == "winnerCellsNonZeros")
+    return tm_ ? tm_->getWinnerCellsRef().size() : 0u;
+  return this->RegionImpl::getParameterArrayCount(name, index);
+}
+
+
 void TMRegion::setParameterUInt32(const std::string &name, Int64 index, UInt32 value) {
   if (name == "maxNewSynapseCount") {
     if (tm_) {
@@ -53,6 +53,10 @@ public:
 
   // Compute outputs from inputs and internal state
   void compute() override;
+  bool canDegrade() const override { return true; } // skips learning
+  // An output compute() skipped, from the state of the last compute()
+  void computeOutput(const std::string &name) override;
+  void setThreadPool(const std::shared_ptr<ThreadPool> &pool) override { if (tm_) tm_->setThreadPool(pool); }
 
   /**
    * Inputs/Outputs are made available in initialize()
@@ -119,6 +123,7 @@ public:
     if (init) {
       // Restore algorithm state
       ar(cereal::make_nvp("TM", tm_));
+      if(auto budget = SynapseBudget::getProcessBudget()) tm_->setSynapseBudget(budget);
     }
   }
 
@@ -141,6 +146,8 @@ public:
   Real32 getParameterReal32(const std::string &name, Int64 index) const override;
   bool getParameterBool(const std::string &name, Int64 index) const override;
   std::string getParameterString(const std::string &name, Int64 index) const override;
+  void getParameterArray(const std::string &name, Int64 index, Array &array) const override;
+  size_t getParameterArrayCount(const std::string &name, Int64 index) const override;
 
   void setParameterUInt32(const std::string &name, Int64 index,UInt32 value) override;
   void setParameterInt32(const std::string &name, Int64 index,Int32 value) override;
@@ -149,6 +156,8 @@ public:
   void setParameterString(const std::string &name, Int64 index, const std::string &s) override;
 
   std::string executeCommand(const std::vector<std::string> &args, Int64 index) override;
+  std::map<std::string, Real64> getMetrics() const override;
+  MemoryUsage memoryUsage() const override;
 
 private:
   Dimensions columnDimensions_;
@@ -188,6 +197,18 @@ private:
 
   computeCallbackFunc computeCallback_;
   std::unique_ptr<TemporalMemory> tm_;
+
+  InputHandle bottomUpIn_{this, "bottomUpIn"};
+  InputHandle resetIn_{this, "resetIn"};
+  InputHandle externalPredictiveInputsActive_{this, "externalPredictiveInputsActive"};
+  InputHandle externalPredictiveInputsWinners_{this, "externalPredictiveInputsWinners"};
+  OutputHandle bottomUpOut_{this, "bottomUpOut"};
+  OutputHandle activeCells_{this, "activeCells"};
+  OutputHandle predictedActiveCells_{this, "predictedActiveCells"};
+  OutputHandle anomaly_{this, "anomaly"};
+  OutputHandle predictiveCells_{this, "predictiveCells"};
+
+  void computeOutput_(Output &out);
 };
 
 } // namespace htm
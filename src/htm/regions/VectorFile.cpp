@@ -19,14 +19,19 @@
  * Implementation for VectorFile class
  */
 
+#include <algorithm>
+#include <cctype>
+#include <charconv> // from_chars
 #include <cstring> // memset
 #include <cmath>
+#include <cstdlib> // strtod
 #include <cstdio> //fopen
 #include <iostream>
 #include <math.h>
 #include <htm/os/Path.hpp>
 #include <htm/regions/VectorFile.hpp>
 #include <htm/utils/Log.hpp>
+#include <htm/utils/ThreadPool.hpp>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -34,6 +39,12 @@
 using namespace std;
 using namespace htm;
 
+// Native binary vector file (format 7): header, then the rows as Real64.
+static const char BINARY_MAGIC[8] = {'H', 'T', 'M', 'V', 'E', 'C', 'T', '\0'};
+static const UInt32 BINARY_VERSION = 1u;
+static const UInt32 BINARY_BYTE_ORDER_MARK = 0x01020304u;
+static const size_t BINARY_HEADER_BYTES = 64u; // keeps the rows aligned
+
 //----------------------------------------------------------------------------
 VectorFile::VectorFile() {}
 
@@ -54,6 +65,7 @@ void VectorFile::clear(bool clearScaling) {
   }
   fileVectors_.clear();
   own_.clear();
+  mapped_.clear();
 
   elementLabels_.clear();
   vectorLabels_.clear();
@@ -66,12 +78,22 @@ void VectorFile::clear(bool clearScaling) {
 //----------------------------------------------------------------------------
 void VectorFile::appendFile(const string &fileName,
                             Size expectedElementCount, UInt32 fileFormat) {
-  bool handled = false;
+  bool handled = true;
   switch (fileFormat) {
-  case 4: // Little-endian.  //TODO supporting just 1 format, remove this switch and fileFormat
+  case 3:
+    appendCSVFile(fileName, expectedElementCount);
+    break;
+  case 4: // Little-endian.
     appendFloat64File(fileName, expectedElementCount);
-    handled = true;
     break;
+  case 6:
+    appendIDXFile(fileName, static_cast<int>(expectedElementCount));
+    break;
+  case 7:
+    appendBinaryFile(fileName, expectedElementCount);
+    break;
+  default:
+    handled = false;
   }
 
   if (!handled) {
@@ -88,11 +110,7 @@ void VectorFile::appendFile(const string &fileName,
     }
 
     try {
-      if (fileFormat == 3) {
-        appendCSVFile(inFile, expectedElementCount);
-      } else {
-        loadVectors(inFile, 0, expectedElementCount, fileFormat);
-      }
+      loadVectors(inFile, 0, expectedElementCount, fileFormat);
     } catch (ios_base::failure &) {
       if (!inFile.eof())
         NTA_THROW << "VectorFile::appendFile"
@@ -179,29 +197,6 @@ void VectorFile::loadVectors(std::istream& inFile,
 }
 
 
-// Determine if the file is a DOS file (ASCII 13, or CTRL-M line ending)
-// Searches for ASCII 13 or 10. Return true if ASCII 13 is found before ASCII 10
-// False otherwise.
-// This is a bit of a hack - if a string contains 13 or 10 it should not count,
-// but we don't support strings in files anyway.
-static bool dosEndings(std::istream &inFile) {
-  bool unixLines = true;
-  std::streampos pos = inFile.tellg();
-  while (!inFile.eof()) {
-    int c = inFile.get();
-    if (c == 10) {
-      unixLines = false;
-      break;
-    } else if (c == 13) {
-      unixLines = true;
-      break;
-    }
-  }
-  inFile.seekg(pos); // Reset back to where we were
-  return unixLines;
-}
-
-
 void VectorFile::saveVectors(ostream &out, Size nColumns, UInt32 fileFormat,
                              Int64 begin, Int64 end, const char *lineEndings) const {
   out.exceptions(ios_base::failbit | ios_base::badbit);
@@ -306,6 +301,13 @@ void VectorFile::saveVectors(ostream &out, Size nColumns, UInt32 fileFormat,
 
     break;
   }
+  case 7: {
+    const std::string header = binaryHeader(nColumns, static_cast<UInt64>(end - begin));
+    out.write(header.data(), streamsize(header.size()));
+    for (; i != iend; ++i)
+      out.write(reinterpret_cast<const char *>(*i), streamsize(nColumns * sizeof(Real64)));
+    break;
+  }
   case 4:
   case 5: {
     if (end <= begin)
@@ -344,73 +346,89 @@ void VectorFile::saveVectors(ostream &out, Size nColumns, UInt32 fileFormat,
 }
 
 
-class AutoReleaseFile {  //TODO rm this class
-public:
-  FILE *file_;
-  AutoReleaseFile(const string &filename) : file_(fopen(filename.c_str(), "rb")) {
-    NTA_CHECK (file_) << "Unable to open file '" + filename + "'.";
-  }
-  ~AutoReleaseFile() {
-    fclose(file_);
-    file_ = nullptr;
-  }
-  void read(void *out, size_t objSize, int n) {
-    size_t result = fread(out, objSize, n, file_); //TODO remove this class? use fstream instead of cstdio::fread
-    NTA_CHECK ((int)result == n) << "Failed to read requested bytes from file.";
+std::string VectorFile::binaryHeader(Size nColumns, UInt64 nRows) {
+  std::string header(BINARY_HEADER_BYTES, '\0');
+  const UInt64 nCols = static_cast<UInt64>(nColumns);
+  std::memcpy(&header[0], BINARY_MAGIC, sizeof(BINARY_MAGIC));
+  std::memcpy(&header[8], &BINARY_VERSION, sizeof(UInt32));
+  std::memcpy(&header[12], &BINARY_BYTE_ORDER_MARK, sizeof(UInt32));
+  std::memcpy(&header[16], &nRows, sizeof(UInt64));
+  std::memcpy(&header[24], &nCols, sizeof(UInt64));
+  return header;
+}
+
+void VectorFile::appendMappedRows(const std::shared_ptr<MappedFile> &file, const char *rows,
+                                  Size nRows, Size nCols) {
+  const Size offset = fileVectors_.size();
+  NTA_CHECK(offset == own_.size()) << "Invalid ownership flags.";
+  const Size nRowLabels = vectorLabels_.size();
+  NTA_CHECK(!nRowLabels || (nRowLabels == offset)) << "Invalid number of row labels.";
+  NTA_CHECK(reinterpret_cast<uintptr_t>(rows) % alignof(Real64) == 0u)
+      << "VectorFile: misaligned vectors in " << file->getPath();
+
+  // The vectors are read only, they point into the mapping.
+  fileVectors_.reserve(offset + nRows);
+  for (Size r = 0; r < nRows; ++r) {
+    const Real64 *row = reinterpret_cast<const Real64 *>(rows) + r * nCols;
+    fileVectors_.push_back(const_cast<Real64 *>(row));
   }
-};
+  own_.resize(offset + nRows, false);
+  if (nRowLabels)
+    vectorLabels_.resize(offset + nRows);
+  mapped_.push_back(file);
+}
 
 void VectorFile::appendFloat64File(const string &filename,
                                    Size expectedElements) {
-  AutoReleaseFile file(filename);
-
-  Size totalBytes = Path::getFileSize(filename);
+  auto file = std::make_shared<MappedFile>(filename);
+  const Size totalBytes = file->size();
   if (totalBytes == 0)
     return; // Early exit when there are no new vectors.
 
-  Size nRows = totalBytes / (expectedElements * sizeof(Real64));
-  Size totalElements = nRows * expectedElements;
-  NTA_CHECK ((totalElements * sizeof(Real64)) == totalBytes)
+  const Size rowBytes = expectedElements * sizeof(Real64);
+  NTA_CHECK (rowBytes > 0 && totalBytes % rowBytes == 0)
         << "Binary file size (" << totalBytes
         << "b) is not a multiple of expected elements ("
         << expectedElements
-        << ") and 32-bit float size.";
-
-
-  Size offset = fileVectors_.size();
-  NTA_CHECK (offset == own_.size()) << "Invalid ownership flags.";
-  Size nRowLabels = vectorLabels_.size();
-  NTA_CHECK (nRowLabels && (nRowLabels == offset)) << "Invalid number of row labels.";
-
-  Real64 *block = nullptr; //TODO use Real[] block; instead of pointers! will require more changes in the file
-
-  try {
-    // Set up the ownership.
-    own_.resize(offset + nRows, false);
-    own_[offset] = true; // The first vector pointer points to the whole block.
-
-    if (nRowLabels)
-      vectorLabels_.resize(offset + nRows);
+        << ") and 64-bit float size.";
+  appendMappedRows(file, file->data(), totalBytes / rowBytes, expectedElements);
+}
 
-    block = new Real64[nRows * expectedElements];
+void VectorFile::appendBinaryFile(const string &filename, Size expectedElements) {
+  auto file = std::make_shared<MappedFile>(filename);
+  const char *data = file->data();
+  NTA_CHECK(file->size() >= BINARY_HEADER_BYTES && std::memcmp(data, BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0)
+      << "VectorFile: " << filename << " is not a binary vector file";
+  UInt32 version, bom;
+  UInt64 nRows, nCols;
+  std::memcpy(&version, data + 8, sizeof(UInt32));
+  std::memcpy(&bom, data + 12, sizeof(UInt32));
+  std::memcpy(&nRows, data + 16, sizeof(UInt64));
+  std::memcpy(&nCols, data + 24, sizeof(UInt64));
+  NTA_CHECK(version == BINARY_VERSION) << "VectorFile: " << filename << " has unsupported version " << version;
+  NTA_CHECK(bom == BINARY_BYTE_ORDER_MARK)
+      << "VectorFile: " << filename << " was written on a machine with a different byte order";
+  NTA_CHECK(nCols == expectedElements)
+      << "VectorFile::appendFile - number of elements in file (" << nCols
+      << ") does not match output element count (" << expectedElements << ")";
+  const UInt64 rowsInFile = (nCols == 0u) ? 0u : (file->size() - BINARY_HEADER_BYTES) / (nCols * sizeof(Real64));
+  if (nRows == BINARY_OPEN_ENDED)
+    nRows = rowsInFile; // still being written, whole rows only
+  NTA_CHECK(rowsInFile >= nRows) << "VectorFile: " << filename << " is truncated";
+  appendMappedRows(file, data + BINARY_HEADER_BYTES, static_cast<Size>(nRows), expectedElements);
+}
 
-    // Set all the row pointers.
-    fileVectors_.resize(offset + nRows);
-    auto cur = fileVectors_.begin() + offset;
-    Real64 *pEnd = block + (nRows * expectedElements);
-    for (Real64 *pBlock = block; pBlock != pEnd; pBlock += expectedElements) {
-      *(cur++) = pBlock;
+void VectorFile::prefetch(Size first, Size count) const {
+  if (mapped_.empty() || count == 0 || first >= fileVectors_.size())
+    return;
+  const Size last = std::min(first + count, fileVectors_.size()) - 1;
+  const char *begin = reinterpret_cast<const char *>(fileVectors_[first]);
+  const char *end = reinterpret_cast<const char *>(fileVectors_[last] + getElementCount());
+  for (const auto &file : mapped_) {
+    if (file->contains(begin)) {
+      file->willNeed(begin, end > begin ? static_cast<size_t>(end - begin) : 0u);
+      return;
     }
-
-    file.read(&block, sizeof block[0] ,int(totalBytes));
-
-  } catch (...) {
-    delete[] block;
-    fileVectors_.resize(offset);
-    own_.resize(offset);
-    if (nRowLabels)
-      vectorLabels_.resize(offset);
-    throw;
   }
 }
 
@@ -427,113 +445,167 @@ void VectorFile::appendFloat64File(const string &filename,
 //    23443 w4343
 //    23,24,
 //    23,"42,d",55
+//
+// The file is mapped, cut into chunks at line ends, and the chunks are parsed
+// in parallel with std::from_chars. Commas and blanks both separate values,
+// and empty values are skipped. A line ends with '\n' or '\r'.
+
+static const size_t CSV_CHUNK_BYTES = 1u << 20u;
+
+// Parses one value at p, returns nullptr if there is no number there.
+static const char *parseCSVValue(const char *p, const char *end, Real64 &value) {
+  if (p < end && *p == '+')
+    ++p; // from_chars does not take a leading +
+  if (p == end || !(std::isdigit(static_cast<unsigned char>(*p)) || *p == '.' || *p == '-'))
+    return nullptr; // this also rejects inf and nan
+#if defined(__cpp_lib_to_chars)
+  const auto result = std::from_chars(p, end, value);
+  return (result.ec == std::errc()) ? result.ptr : nullptr;
+#else
+  char buffer[64]; // strtod needs a terminated string
+  const size_t n = std::min<size_t>(static_cast<size_t>(end - p), sizeof(buffer) - 1u);
+  std::memcpy(buffer, p, n);
+  buffer[n] = '\0';
+  char *stop = nullptr;
+  value = std::strtod(buffer, &stop);
+  return (stop == buffer) ? nullptr : p + (stop - buffer);
+#endif
+}
 
-void VectorFile::appendCSVFile(istream &inFile, Size expectedElements) {
-  // Read in csv file one line at a time. If that line contains any errors,
-  // skip it and move onto the next one.
-  try {
-    bool dosLines = dosEndings(inFile);
-    while (!inFile.eof()) {
-      Size elementsFound = 0;
-      auto b = new Real64[expectedElements];
-      // Read and parse a single line
-      string sLine;           // We'll use string for robust line parsing
-      stringstream converted; // We'll use stringstream for robust ascii text to
-                              // Real conversion
-      size_t beg = 0, pos = 0;
-
-      // Read the next line, using the appropriate delimiter
-      try {
-        if (dosLines)
-          getline(inFile, sLine, '\r');
-        else
-          getline(inFile, sLine);
-      } catch (...) {
-        // An exception here is ok
+// Parses the lines in [p, end) into rows of expectedElements values.
+static void parseCSVChunk(const char *p, const char *end, Size expectedElements,
+                          std::vector<Real64> &rows) {
+  const auto isSeparator = [](char c) { return c == ',' || c == ' ' || c == '\t' || c == '\f' || c == '\v'; };
+  while (p < end) {
+    const char *lineEnd = p;
+    while (lineEnd < end && *lineEnd != '\n' && *lineEnd != '\r')
+      ++lineEnd;
+
+    const size_t rowStart = rows.size();
+    Size found = 0;
+    while (found < expectedElements) {
+      while (p < lineEnd && isSeparator(*p))
+        ++p;
+      Real64 value;
+      const char *next = parseCSVValue(p, lineEnd, value);
+      if (next == nullptr)
         break;
-      }
+      rows.push_back(value);
+      found++;
+      p = next; // like stream extraction, the next value starts right here
+    }
+    if (found < expectedElements)
+      rows.resize(rowStart); // skip the line
 
-      while (pos != string::npos) {
-        pos = sLine.find(',', beg);
-        converted << sLine.substr(beg, pos - beg) << " ";
-        beg = pos + 1;
-      }
-      for (Size i = 0; i < expectedElements; i++) {
-        converted >> b[i];
-        if (converted.fail())
-          break;
-        elementsFound++;
-      }
+    p = (lineEnd < end) ? lineEnd + 1 : end;
+  }
+}
 
-      // Validate the parsed line and store it.
-      // At this point b will have some numbers. If elementsFound ==
-      // expectedElements then everything went well and we can insert the array
-      // into fileVectors_ If not, then we deallocate the memory for b
-      if (elementsFound == expectedElements) {
-        fileVectors_.push_back(b);
-        own_.push_back(true);
-        vectorLabels_.push_back(string());
-        b = nullptr;
-      } else {
-        delete[] b;
-        b = nullptr;
-      }
-    }
+void VectorFile::appendCSVFile(const string &filename, Size expectedElements) {
+  const MappedFile file(filename);
+  const char *data = file.data();
+  const char *end = data + file.size();
+  if (expectedElements == 0 || data == end)
+    return;
+
+  // Cut at line ends.
+  std::vector<const char *> cuts = {data};
+  while (end - cuts.back() > static_cast<std::ptrdiff_t>(CSV_CHUNK_BYTES)) {
+    const char *cut = cuts.back() + CSV_CHUNK_BYTES;
+    while (cut < end && *cut != '\n' && *cut != '\r')
+      ++cut;
+    if (cut == end)
+      break;
+    cuts.push_back(cut + 1);
+  }
+  cuts.push_back(end);
+
+  const size_t numChunks = cuts.size() - 1u;
+  std::vector<std::vector<Real64>> chunks(numChunks);
+  ThreadPool pool(std::min<size_t>(numChunks, std::max(1u, std::thread::hardware_concurrency())));
+  pool.parallelFor(numChunks, [&](size_t c) {
+    parseCSVChunk(cuts[c], cuts[c + 1], expectedElements, chunks[c]);
+  });
+
+  // Copy into a single block, owned by its first vector.
+  Size nValues = 0;
+  for (const auto &chunk : chunks)
+    nValues += chunk.size();
+  const Size nRows = nValues / expectedElements;
+  if (nRows == 0)
+    return;
+  Size offset = fileVectors_.size();
+  NTA_CHECK (offset == own_.size()) << "Invalid ownership flags.";
 
-    // any bizarre errors and cleanup
-  } catch (...) {
-    NTA_THROW << "VectorFile - Error reading CSV file";
+  std::unique_ptr<Real64[]> block(new Real64[nValues]);
+  Real64 *pBlock = block.get();
+  for (const auto &chunk : chunks) {
+    std::copy(chunk.begin(), chunk.end(), pBlock);
+    pBlock += chunk.size();
   }
+  own_.resize(offset + nRows, false);
+  own_[offset] = true;
+  vectorLabels_.resize(offset + nRows);
+  fileVectors_.resize(offset + nRows);
+  for (Size r = 0; r < nRows; ++r)
+    fileVectors_[offset + r] = block.get() + r * expectedElements;
+  block.release(); // owned by fileVectors_ now.
 }
 
-template <typename T1, typename T2, typename TSize>
-void convert(T2 *pOut, const T1 *pIn, TSize n, TSize fill) {
-  for (TSize i = 0; i < n; ++i)
-    *(pOut++) = T2(*(pIn++));
-  if (fill)
-    ::memset(pOut, 0, fill * sizeof(T2));
+// IDX values are big-endian.
+template <typename T> static Real64 idxValue(const char *p) {
+  const UInt32 one = 1u;
+  const bool littleEndian = *reinterpret_cast<const char *>(&one) == 1;
+  char bytes[sizeof(T)];
+  for (size_t b = 0; b < sizeof(T); ++b)
+    bytes[b] = p[littleEndian ? sizeof(T) - 1 - b : b];
+  T value;
+  std::memcpy(&value, bytes, sizeof(T));
+  return static_cast<Real64>(value);
+}
+
+template <typename T>
+static void convertIDXRows(Real64 *pBlock, const char *pRead, Size nRows, Size vectorSize,
+                           Size expectedElements) {
+  const Size copy = std::min(expectedElements, vectorSize);
+  for (Size row = 0; row < nRows; ++row) {
+    for (Size i = 0; i < copy; ++i)
+      pBlock[i] = idxValue<T>(pRead + i * sizeof(T));
+    for (Size i = copy; i < expectedElements; ++i)
+      pBlock[i] = 0.0;
+    pRead += vectorSize * sizeof(T);
+    pBlock += expectedElements;
+  }
 }
 
 void VectorFile::appendIDXFile(const string &filename, int expectedElements) {
-  AutoReleaseFile file(filename);
-
-  char header[4];
-  file.read(header, sizeof header[0], 4);
-
-  int nDims = header[3];
-  if (nDims < 1)
-    throw runtime_error("Invalid number of dimensions.");
-  int dims[256];
-  file.read(dims, sizeof dims[0], nDims * sizeof(int));
-
-  int vectorSize = 1;
-  for (int i = 1; i < nDims; ++i)
-    vectorSize *= dims[i];
-  int nRows = dims[0];
-
-  int elSize = 0;
-  switch (header[2]) {
-  case 0x08:
-    elSize = 1;
-    break; // unsigned byte.
-  case 0x09:
-    elSize = 1;
-    break; // signed byte.
-  case 0x0B:
-    elSize = 2;
-    break; // signed short.
-  case 0x0C:
-    elSize = 4;
-    break; // signed int.
-  case 0x0D:
-    elSize = 4;
-    break; // 32-bit float.
-  case 0x0E:
-    elSize = 8;
-    break; // 64-bit float.
+  const MappedFile file(filename);
+  const char *data = file.data();
+  NTA_CHECK(file.size() >= 4u && data[0] == 0 && data[1] == 0)
+      << "VectorFile: " << filename << " is not an IDX file";
+
+  const Size nDims = static_cast<unsigned char>(data[3]);
+  NTA_CHECK(nDims >= 1u) << "Invalid number of dimensions.";
+  const Size headerBytes = 4u + 4u * nDims;
+  NTA_CHECK(file.size() >= headerBytes) << "VectorFile: " << filename << " is truncated";
+  const Size nRows = static_cast<Size>(idxValue<UInt32>(data + 4));
+  Size vectorSize = 1u;
+  for (Size i = 1u; i < nDims; ++i)
+    vectorSize *= static_cast<Size>(idxValue<UInt32>(data + 4 + 4 * i));
+
+  Size elSize = 0;
+  switch (data[2]) {
+  case 0x08: elSize = 1; break; // unsigned byte.
+  case 0x09: elSize = 1; break; // signed byte.
+  case 0x0B: elSize = 2; break; // signed short.
+  case 0x0C: elSize = 4; break; // signed int.
+  case 0x0D: elSize = 4; break; // 32-bit float.
+  case 0x0E: elSize = 8; break; // 64-bit float.
   default:
-    throw runtime_error("Unknown element type.");
+    NTA_THROW << "Unknown element type.";
   }
+  NTA_CHECK((file.size() - headerBytes) / elSize / std::max<Size>(vectorSize, 1u) >= nRows)
+      << "VectorFile: " << filename << " is truncated";
 
   Size offset = fileVectors_.size();
   NTA_CHECK (offset == own_.size()) << "Invalid ownership flags.";
@@ -541,114 +613,35 @@ void VectorFile::appendIDXFile(const string &filename, int expectedElements) {
   Size nRowLabels = vectorLabels_.size();
   NTA_CHECK (!nRowLabels || (nRowLabels == offset)) << "Invalid number of row labels.";
 
-  // We will read into one block and copy across to the final destination.
-  // This is not as efficient as it could be in the optimized case, but that
-  // is only one of many possible configurations.
-
-  int readRow = vectorSize * elSize;
-  auto readBuffer = new char[readRow];
-
-  auto block = new Real64[nRows * expectedElements];
-  Real64 *pBlock = block;
-
-  int copy = (expectedElements < vectorSize) ? expectedElements : vectorSize;
-  int fill = expectedElements - copy;
-
-  try {
-    switch (header[2]) {
-    case 0x08: // unsigned byte.
-    {
-      unsigned char *pRead = reinterpret_cast<unsigned char *>(readBuffer);
-      for (int row = 0; row < nRows; ++row) {
-        file.read(pRead, sizeof(char), readRow);
-        // No need for byte swapping.
-        convert(pBlock, pRead, copy, fill);
-        pBlock += expectedElements;
-      }
-      break;
-    }
-    case 0x09: // signed byte.
-    {
-      signed char *pRead = reinterpret_cast<signed char *>(readBuffer);
-      for (int row = 0; row < nRows; ++row) {
-        file.read(pRead, sizeof(char), readRow);
-        // No need for byte swapping.
-        convert(pBlock, pRead, copy, fill);
-        pBlock += expectedElements;
-      }
-      break;
-    }
-    case 0x0B: // signed short.
-    {
-      short *pRead = reinterpret_cast<short *>(readBuffer);
-      for (int row = 0; row < nRows; ++row) {
-        file.read(pRead, sizeof(short), readRow);
-        convert(pBlock, pRead, copy, fill);
-        pBlock += expectedElements;
-      }
-      break;
-    }
-    case 0x0C: // signed int.
-    {
-      int *pRead = reinterpret_cast<int *>(readBuffer);
-      for (int row = 0; row < nRows; ++row) {
-        file.read(pRead, sizeof(int), readRow);
-        convert(pBlock, pRead, copy, fill);
-        pBlock += expectedElements;
-      }
-      break;
-    }
-    case 0x0D: // 32-bit float. //TODO this is super-ugly code! use templates to avoid the switch!
-    {
-      float *pRead = reinterpret_cast<float *>(readBuffer);
-      for (int row = 0; row < nRows; ++row) {
-        file.read(pRead, sizeof(float), readRow);
-        convert(pBlock, pRead, copy, fill);
-        pBlock += expectedElements;
-      }
-      break;
-    }
-    case 0x0E: // 64-bit float.
-    {
-      double *pRead = reinterpret_cast<double *>(readBuffer);
-      for (int row = 0; row < nRows; ++row) {
-        file.read(pRead, sizeof(double), readRow);
-        convert(pBlock, pRead, copy, fill);
-        pBlock += expectedElements;
-      }
-      break;
-    }
-    default:
-      NTA_THROW << "Unsupported type.";
-      break;
-    }
-
-    // Set up the ownership.
-    own_.resize(offset + nRows, false);
-    own_[offset] = true; // The first vector pointer points to the whole block.
-
-    if (nRowLabels)
-      vectorLabels_.resize(offset + nRows);
-
-    // Set all the row pointers.
-    fileVectors_.resize(offset + nRows);
-    auto cur = fileVectors_.begin() + offset;
-    Real64 *pEnd = block + (nRows * expectedElements);
-    for (Real64 *pCur = block; pCur != pEnd; pCur += expectedElements)
-      *(cur++) = pCur;
-  } catch (...) {
-    delete[] block;
-    delete[] readBuffer;
-    fileVectors_.resize(offset);
-    own_.resize(offset);
-    if (nRowLabels)
-      vectorLabels_.resize(offset);
-    throw;
+  // Convert the rows straight from the mapped file into one block.
+  const Size nElements = static_cast<Size>(expectedElements);
+  std::unique_ptr<Real64[]> block(new Real64[nRows * nElements]);
+  const char *pRead = data + headerBytes;
+  switch (data[2]) {
+  case 0x08: convertIDXRows<uint8_t>(block.get(), pRead, nRows, vectorSize, nElements); break;
+  case 0x09: convertIDXRows<int8_t>(block.get(), pRead, nRows, vectorSize, nElements); break;
+  case 0x0B: convertIDXRows<int16_t>(block.get(), pRead, nRows, vectorSize, nElements); break;
+  case 0x0C: convertIDXRows<int32_t>(block.get(), pRead, nRows, vectorSize, nElements); break;
+  case 0x0D: convertIDXRows<float>(block.get(), pRead, nRows, vectorSize, nElements); break;
+  case 0x0E: convertIDXRows<double>(block.get(), pRead, nRows, vectorSize, nElements); break;
   }
-
-  delete[] readBuffer;
-  readBuffer = nullptr;
-  // Don't delete block, as it is owned by fileVectors_ now.
+  if (nRows == 0)
+    return;
+
+  // Set up the ownership.
+  own_.resize(offset + nRows, false);
+  own_[offset] = true; // The first vector pointer points to the whole block.
+
+  if (nRowLabels)
+    vectorLabels_.resize(offset + nRows);
+
+  // Set all the row pointers.
+  fileVectors_.resize(offset + nRows);
+  auto cur = fileVectors_.begin() + offset;
+  Real64 *pEnd = block.get() + (nRows * nElements);
+  for (Real64 *pCur = block.get(); pCur != pEnd; pCur += nElements)
+    *(cur++) = pCur;
+  block.release(); // owned by fileVectors_ now.
 }
 
 /// Reset scaling to have no effect (unitary scaling vector and zero offset
@@ -27,7 +27,9 @@
 //----------------------------------------------------------------------
 
 #include <fstream>
+#include <memory>
 #include <sstream>
+#include <htm/os/MappedFile.hpp>
 #include <htm/types/Types.hpp>
 #include <htm/types/Serializable.hpp>
 #include <vector>
@@ -44,7 +46,7 @@ public:
   VectorFile();
   virtual ~VectorFile();
 
-  static Int32 maxFormat() { return 6; }
+  static Int32 maxFormat() { return 7; }
 
   /// Read in vectors from the given filename. All vectors are expected to
   /// have the same size (i.e. same number of elements).
@@ -60,6 +62,11 @@ public:
   ///           4        # Reads in a little-endian float32 binary file
   ///           5        # Reads in a big-endian float32 binary file
   ///           6        # Reads in a big-endian IDX binary file
+  ///           7        # Reads in a native binary vector file (saveVectors)
+  ///
+  /// Formats 4 and 7 are memory mapped: the vectors point into the file and
+  /// are paged in on demand, so files larger than memory can be replayed.
+  /// IDX files are converted to Real64 straight from the mapped file.
   void appendFile(const std::string &fileName, Size expectedElementCount,
                   UInt32 fileFormat);
 
@@ -71,6 +78,15 @@ public:
   /// output must have size at least 'count' elements
   void getRawVector(const UInt i, Real64 *out, UInt offset, Size count);
 
+  /// The header of a format 7 file. With nRows = BINARY_OPEN_ENDED the
+  /// rows run to the end of the file, so a writer can keep appending.
+  static constexpr UInt64 BINARY_OPEN_ENDED = ~UInt64(0u);
+  static std::string binaryHeader(Size nColumns, UInt64 nRows = BINARY_OPEN_ENDED);
+
+  /// Read-ahead for memory mapped files: hints that the vectors
+  /// [first, first + count) will be read soon. No-op for loaded text files.
+  void prefetch(Size first, Size count) const;
+
   /// Return the number of stored vectors
   size_t vectorCount() const { return fileVectors_.size(); }
 
@@ -114,6 +130,9 @@ public:
   void readState(std::istream &state);
 
   /// Save vectors, unscaled, to a file with the specified format.
+  /// Format 7 is a 64 byte header (magic, version, byte order mark, number
+  /// of rows and columns) followed by the rows as native Real64, so it is
+  /// read back without parsing or copying. Open the stream as binary.
   void saveVectors(std::ostream &out, Size nColumns, UInt32 fileFormat,
                    Int64 begin, Int64 end, const char *lineEndings = nullptr) const;
 
@@ -148,6 +167,7 @@ public:
 private:
   std::vector<Real64 *> fileVectors_; // list of vectors
   std::vector<bool> own_;           // memory ownership flags
+  std::vector<std::shared_ptr<MappedFile>> mapped_; // files that vectors point into
   std::vector<Real64> scaleVector_;   // the scaling vector
   std::vector<Real64> offsetVector_;  // the offset vector
 
@@ -155,13 +175,19 @@ private:
   std::vector<std::string> vectorLabels_; // a string label for each vector
 
   //------------------- Utility routines
-  void appendCSVFile(std::istream &inFile, Size expectedElementCount);
+  /// Read vectors from a CSV file, parsed in parallel.
+  void appendCSVFile(const std::string &filename, Size expectedElementCount);
 
   /// Read vectors from a binary file.
   void appendFloat64File(const std::string &filename, Size expectedElements);
 
   /// Read vectors from a binary IDX file.
   void appendIDXFile(const std::string &filename, int expectedElements);
+  /// Map vectors from a native binary vector file.
+  void appendBinaryFile(const std::string &filename, Size expectedElements);
+  /// Append row pointers into a mapped file, which is kept open.
+  void appendMappedRows(const std::shared_ptr<MappedFile> &file, const char *rows,
+                        Size nRows, Size nCols);
   void loadVectors(std::istream &f, size_t nRows, size_t nCols, int format);
 }; // end class VectorFile
 
@@ -0,0 +1,158 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the CoordinateConverter class
+ */
+
+#include "htm/types/Coordinates.hpp"
+#include "htm/utils/CpuDispatch.hpp"
+#include "htm/utils/Log.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <mutex>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #define HTM_COORDINATES_X86
+  #include <immintrin.h>
+#endif
+
+namespace htm {
+
+FastDivider::FastDivider(const UInt32 d) : divisor(d) {
+  NTA_CHECK(d > 0u) << "FastDivider: division by 0";
+  if (d == 1u) return;
+  const UInt64 m = UINT64_C(0xFFFFFFFFFFFFFFFF) / d + 1u;
+  mHigh = static_cast<UInt32>(m >> 32);
+  mLow  = static_cast<UInt32>(m);
+}
+
+namespace {
+
+// Returns the number of indices done, the rest is left for the scalar code.
+using AxisFn = size_t (*)(const UInt *, size_t, const FastDivider &, const FastDivider &, UInt *);
+
+#ifdef HTM_COORDINATES_X86
+  // n / d of four 32 bit values in 64 bit lanes.
+  __attribute__((target("avx2"), always_inline)) inline
+  __m256i divide4_(const __m256i n, const __m256i mHigh, const __m256i mLow) {
+    const __m256i high = _mm256_mul_epu32(n, mHigh);
+    const __m256i low  = _mm256_mul_epu32(n, mLow);
+    return _mm256_srli_epi64(_mm256_add_epi64(high, _mm256_srli_epi64(low, 32)), 32);
+  }
+
+  __attribute__((target("avx2")))
+  size_t axisAvx2_(const UInt *indices, const size_t count, const FastDivider &stride,
+                   const FastDivider &dimension, UInt *out) {
+    const __m256i sHigh = _mm256_set1_epi64x(stride.mHigh);
+    const __m256i sLow  = _mm256_set1_epi64x(stride.mLow);
+    const __m256i dHigh = _mm256_set1_epi64x(dimension.mHigh);
+    const __m256i dLow  = _mm256_set1_epi64x(dimension.mLow);
+    const __m256i d     = _mm256_set1_epi64x(dimension.divisor);
+    const __m256i lanes = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    const bool strideOne = stride.divisor == 1u;
+    size_t i = 0u;
+    for(; i + 4u <= count; i += 4u) {
+      __m256i n = _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i *>(indices + i)));
+      if (!strideOne) n = divide4_(n, sHigh, sLow);
+      const __m256i q = divide4_(n, dHigh, dLow);
+      const __m256i c = _mm256_sub_epi64(n, _mm256_mul_epu32(q, d));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+                       _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(c, lanes)));
+    }
+    return i;
+  }
+#endif
+
+} // namespace
+
+
+CoordinateConverter::CoordinateConverter(const std::vector<UInt> &dimensions)
+    : dimensions_(dimensions), strides_(dimensions.size()) {
+  NTA_CHECK(!dimensions.empty()) << "CoordinateConverter: no dimensions";
+  UInt64 stride = 1u;
+  for (size_t i = dimensions.size(); i > 0u; i--) {
+    NTA_CHECK(dimensions[i - 1u] > 0u) << "CoordinateConverter: all dimensions must be > 0";
+    strides_[i - 1u] = static_cast<UInt>(stride);
+    stride *= dimensions[i - 1u];
+    NTA_CHECK(stride <= UINT64_C(0xFFFFFFFF)) << "CoordinateConverter: more than 2^32 indices";
+  }
+  for (size_t i = 0; i < dimensions.size(); i++) {
+    strideDiv_.emplace_back(strides_[i]);
+    dimensionDiv_.emplace_back(dimensions[i]);
+  }
+}
+
+
+std::shared_ptr<const CoordinateConverter> CoordinateConverter::get(const std::vector<UInt> &dimensions) {
+  static std::mutex mutex;
+  static std::map<std::vector<UInt>, std::weak_ptr<const CoordinateConverter>> cache;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto &entry = cache[dimensions];
+  auto converter = entry.lock();
+  if (!converter) {
+    for (auto it = cache.begin(); it != cache.end();)  // forget the unused ones
+      it = it->second.expired() && &it->second != &entry ? cache.erase(it) : std::next(it);
+    converter = std::make_shared<const CoordinateConverter>(dimensions);
+    entry = converter;
+  }
+  return converter;
+}
+
+
+void CoordinateConverter::toCoordinates(UInt index, std::vector<UInt> &coordinates) const {
+  coordinates.resize(dimensions_.size());
+  for (size_t i = dimensions_.size(); i > 1u; i--) {
+    const UInt q = dimensionDiv_[i - 1u].divide(index);
+    coordinates[i - 1u] = index - q * dimensions_[i - 1u];
+    index = q;
+  }
+  coordinates[0] = index;
+}
+
+
+void CoordinateConverter::axis(const UInt *indices, const size_t count, const size_t axis, UInt *out) const {
+  NTA_ASSERT(axis < dimensions_.size());
+  static const AxisFn simd = CpuDispatch::bind<AxisFn>("coordinates.axis", {
+  #ifdef HTM_COORDINATES_X86
+      {"avx2", CPU_AVX2, axisAvx2_},
+  #endif
+      {"scalar", 0u, [](const UInt *, size_t, const FastDivider &, const FastDivider &, UInt *) -> size_t {
+        return 0u; }}});
+  const FastDivider &stride = strideDiv_[axis];
+  const FastDivider &dimension = dimensionDiv_[axis];
+  if (dimension.divisor == 1u) {
+    std::fill(out, out + count, 0u);
+    return;
+  }
+  for (size_t i = simd(indices, count, stride, dimension, out); i < count; i++)
+    out[i] = dimension.modulo(stride.divide(indices[i]));
+}
+
+
+void CoordinateConverter::toCoordinates(const std::vector<UInt> &indices,
+                                        std::vector<std::vector<UInt>> &coordinates) const {
+  coordinates.resize(dimensions_.size());
+  for (size_t i = 0; i < dimensions_.size(); i++) {
+    coordinates[i].resize(indices.size());
+    axis(indices.data(), indices.size(), i, coordinates[i].data());
+  }
+}
+
+} // namespace htm
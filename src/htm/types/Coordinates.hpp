@@ -0,0 +1,165 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the CoordinateConverter class, conversions between flat
+ * indices and N-D coordinates without division.
+ */
+
+#ifndef HTM_COORDINATES_HPP
+#define HTM_COORDINATES_HPP
+
+#include <memory>
+#include <vector>
+
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * Division by a constant as a multiplication, for 32 bit dividends.
+ *
+ * M = ceil(2^64 / d) and n / d = (M * n) >> 64 for every 32 bit n
+ * (D. Lemire, O. Kaser, N. Kurz, "Faster Remainder by Direct Computation",
+ * 2019).  The 64 x 32 bit product is done in two 32 x 32 bit halves, as
+ * SIMD units can do them.
+ */
+struct FastDivider {
+  UInt32 divisor = 1u;
+  UInt32 mHigh   = 0u;  // M >> 32, 0 for divisor 1, where M would be 2^64
+  UInt32 mLow    = 0u;
+
+  FastDivider() = default;
+  explicit FastDivider(UInt32 d);
+
+  UInt32 divide(const UInt32 n) const {
+    if (divisor == 1u) return n;
+    const UInt64 high = static_cast<UInt64>(mHigh) * n;
+    const UInt64 low  = static_cast<UInt64>(mLow) * n;
+    return static_cast<UInt32>((high + (low >> 32)) >> 32);
+  }
+  UInt32 modulo(const UInt32 n) const { return n - divide(n) * divisor; }
+};
+
+
+/**
+ * CoordinateConverter class
+ *
+ * ### Description
+ * Converts between the flat indices of a space of dimensions (row major, the
+ * last dimension varies fastest, as in an SDR) and their coordinates.  The
+ * strides and the dividers are computed once, get() shares them between all
+ * users of the same dimensions.
+ *
+ * The batch conversions use AVX2 where the CPU has it (see CpuDispatch).
+ *
+ * Example Usage:
+ *    const auto conv = CoordinateConverter::get({ 4, 5, 6 });
+ *    conv->coordinate( 37, 1 )       -> 1
+ *    conv->toCoordinates( 37, c )    -> c = { 1, 1, 1 }
+ *    conv->toIndex( c.data() )       -> 37
+ */
+class CoordinateConverter {
+public:
+  explicit CoordinateConverter(const std::vector<UInt> &dimensions);
+
+  /** The converter of these dimensions, shared while anyone uses it. */
+  static std::shared_ptr<const CoordinateConverter> get(const std::vector<UInt> &dimensions);
+
+  const std::vector<UInt> &dimensions() const { return dimensions_; }
+  const std::vector<UInt> &strides() const { return strides_; }
+  size_t numDimensions() const { return dimensions_.size(); }
+
+  /** The coordinate of a flat index along one axis. */
+  UInt coordinate(const UInt index, const size_t axis) const {
+    return dimensionDiv_[axis].modulo(strideDiv_[axis].divide(index));
+  }
+
+  /** All coordinates of a flat index. */
+  void toCoordinates(UInt index, std::vector<UInt> &coordinates) const;
+
+  /** The flat index of numDimensions() coordinates. */
+  UInt toIndex(const UInt *coordinates) const {
+    UInt index = 0u;
+    for (size_t i = 0; i < strides_.size(); i++)
+      index += coordinates[i] * strides_[i];
+    return index;
+  }
+  UInt toIndex(const std::vector<UInt> &coordinates) const { return toIndex(coordinates.data()); }
+
+  /** The coordinates along one axis of count flat indices, into out[count]. */
+  void axis(const UInt *indices, size_t count, size_t axis, UInt *out) const;
+
+  /** The coordinates of flat indices, one vector per axis as SDR_coordinate_t. */
+  void toCoordinates(const std::vector<UInt> &indices, std::vector<std::vector<UInt>> &coordinates) const;
+
+private:
+  std::vector<UInt> dimensions_;
+  std::vector<UInt> strides_;
+  std::vector<FastDivider> strideDiv_;
+  std::vector<FastDivider> dimensionDiv_;
+};
+
+
+/**
+ * CoordinateAxis class
+ *
+ * ### Description
+ * The coordinates of a list of flat indices along one axis, computed when
+ * read, see SDR::getCoordinateAxis().  The indices must outlive the view
+ * and must not change while it is used.
+ */
+class CoordinateAxis {
+public:
+  CoordinateAxis(const UInt *indices, size_t size, std::shared_ptr<const CoordinateConverter> converter,
+                 size_t axis)
+      : indices_(indices), size_(size), converter_(std::move(converter)), axis_(axis) {}
+
+  size_t size() const { return size_; }
+  UInt operator[](const size_t i) const { return converter_->coordinate(indices_[i], axis_); }
+
+  class const_iterator {
+  public:
+    const_iterator(const CoordinateAxis *view, size_t i) : view_(view), i_(i) {}
+    UInt operator*() const { return (*view_)[i_]; }
+    const_iterator &operator++() { i_++; return *this; }
+    bool operator!=(const const_iterator &other) const { return i_ != other.i_; }
+    bool operator==(const const_iterator &other) const { return i_ == other.i_; }
+  private:
+    const CoordinateAxis *view_;
+    size_t i_;
+  };
+  const_iterator begin() const { return const_iterator(this, 0u); }
+  const_iterator end() const { return const_iterator(this, size_); }
+
+  /** All of the coordinates, converted in a batch. */
+  std::vector<UInt> toVector() const {
+    std::vector<UInt> out(size_);
+    converter_->axis(indices_, size_, axis_, out.data());
+    return out;
+  }
+
+private:
+  const UInt *indices_;
+  size_t size_;
+  std::shared_ptr<const CoordinateConverter> converter_;
+  size_t axis_;
+};
+
+} // namespace htm
+
+#endif // HTM_COORDINATES_HPP
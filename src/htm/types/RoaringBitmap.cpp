@@ -0,0 +1,157 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the RoaringBitmap class
+ */
+
+#include <htm/types/RoaringBitmap.hpp>
+
+#include <algorithm> // lower_bound
+
+using namespace std;
+
+namespace htm {
+
+namespace {
+    inline UInt32 popcount64_(const UInt64 word) {
+    #if defined(__GNUC__)
+        return static_cast<UInt32>(__builtin_popcountll(word));
+    #else
+        UInt32 count = 0u;
+        for(UInt64 w = word; w != 0u; w &= w - 1u) count++;
+        return count;
+    #endif
+    }
+
+    inline bool testBit_(const vector<UInt64> &bitmap, const UInt16 low) {
+        return ((bitmap[low >> 6] >> (low & 63u)) & 1u) != 0u;
+    }
+} // end anonymous namespace
+
+
+void RoaringBitmap::assign(const vector<UInt32> &sorted) {
+    clear();
+    cardinality_ = sorted.size();
+    for(size_t begin = 0; begin < sorted.size(); ) {
+        const UInt16 key = static_cast<UInt16>(sorted[begin] >> 16);
+        size_t end = begin + 1u;
+        while( end < sorted.size() and (sorted[end] >> 16) == key ) end++;
+
+        keys_.push_back(key);
+        containers_.emplace_back();
+        Container &container = containers_.back();
+        container.cardinality = static_cast<UInt32>(end - begin);
+        if( container.cardinality <= ARRAY_MAX ) {
+            container.array.reserve(container.cardinality);
+            for(size_t i = begin; i < end; i++)
+                container.array.push_back(static_cast<UInt16>(sorted[i] & 0xFFFFu));
+        }
+        else {
+            container.bitmap.assign(BITMAP_WORDS, 0u);
+            for(size_t i = begin; i < end; i++) {
+                const UInt32 low = sorted[i] & 0xFFFFu;
+                container.bitmap[low >> 6] |= UInt64(1u) << (low & 63u);
+            }
+        }
+        begin = end;
+    }
+}
+
+
+void RoaringBitmap::toSparse(vector<UInt32> &out) const {
+    out.clear();
+    out.reserve(cardinality_);
+    forEach([&out](const UInt32 index) { out.push_back(index); });
+}
+
+
+void RoaringBitmap::clear() {
+    keys_.clear();
+    containers_.clear();
+    cardinality_ = 0u;
+}
+
+
+bool RoaringBitmap::contains(const UInt32 index) const {
+    const UInt16 key = static_cast<UInt16>(index >> 16);
+    const auto it = lower_bound(keys_.begin(), keys_.end(), key);
+    if( it == keys_.end() or *it != key )
+        return false;
+    const Container &container = containers_[static_cast<size_t>(it - keys_.begin())];
+    const UInt16 low = static_cast<UInt16>(index & 0xFFFFu);
+    if( not container.bitmap.empty() )
+        return testBit_(container.bitmap, low);
+    return binary_search(container.array.begin(), container.array.end(), low);
+}
+
+
+size_t RoaringBitmap::overlap(const RoaringBitmap &other) const {
+    size_t count = 0u;
+    size_t a = 0u, b = 0u;
+    while( a < keys_.size() and b < other.keys_.size() ) {
+        if( keys_[a] < other.keys_[b] ) { a++; continue; }
+        if( keys_[a] > other.keys_[b] ) { b++; continue; }
+        const Container &x = containers_[a++];
+        const Container &y = other.containers_[b++];
+        if( not x.bitmap.empty() and not y.bitmap.empty() ) {
+            for(UInt32 w = 0; w < BITMAP_WORDS; w++)
+                count += popcount64_(x.bitmap[w] & y.bitmap[w]);
+        }
+        else if( not x.bitmap.empty() or not y.bitmap.empty() ) {
+            const Container &array  = x.bitmap.empty() ? x : y;
+            const Container &bitmap = x.bitmap.empty() ? y : x;
+            for(const UInt16 low : array.array)
+                count += testBit_(bitmap.bitmap, low) ? 1u : 0u;
+        }
+        else {
+            // both sorted arrays: merge
+            auto i = x.array.begin(), j = y.array.begin();
+            while( i != x.array.end() and j != y.array.end() ) {
+                if( *i < *j )      ++i;
+                else if( *j < *i ) ++j;
+                else { count++; ++i; ++j; }
+            }
+        }
+    }
+    return count;
+}
+
+
+size_t RoaringBitmap::memoryUsage() const {
+    size_t bytes = keys_.size() * (sizeof(UInt16) + sizeof(Container));
+    for(const auto &container : containers_) {
+        bytes += container.array.size() * sizeof(UInt16) + container.bitmap.size() * sizeof(UInt64);
+    }
+    return bytes;
+}
+
+
+bool RoaringBitmap::operator==(const RoaringBitmap &other) const {
+    if( cardinality_ != other.cardinality_ or keys_ != other.keys_ )
+        return false;
+    for(size_t c = 0; c < containers_.size(); c++) {
+        const Container &x = containers_[c];
+        const Container &y = other.containers_[c];
+        // The container kind follows from the cardinality, so equal sets have equal containers.
+        if( x.array != y.array or x.bitmap != y.bitmap )
+            return false;
+    }
+    return true;
+}
+
+} // end namespace htm
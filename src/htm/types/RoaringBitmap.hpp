@@ -0,0 +1,128 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the RoaringBitmap class, the compressed format of an SDR.
+ */
+
+#ifndef NTA_ROARING_BITMAP_HPP
+#define NTA_ROARING_BITMAP_HPP
+
+#include <vector>
+
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * RoaringBitmap class
+ *
+ * ### Description
+ * A compressed set of 32 bit indices, for very large and very sparse SDRs.
+ * The indices are split into chunks of 2^16 by their upper 16 bits, only the
+ * chunks with any index are stored.  A chunk ("container") with up to
+ * ARRAY_MAX indices keeps the lower 16 bits in a sorted array, a fuller one
+ * is a bitmap of 2^16 bits (8 KiB).  So the memory is about 2 bytes per
+ * active index, whatever the size of the SDR, and a membership test is two
+ * binary searches or one bit test.
+ *
+ * See Chambi, Lemire et al. "Better bitmap performance with Roaring bitmaps" (2016).
+ * This is the subset needed by the SDR: no run containers, no set operations
+ * except overlap.
+ *
+ * Example Usage:
+ *    RoaringBitmap r;
+ *    r.assign({ 3, 70000, 9000000 });
+ *    r.contains( 70000 )  -> true
+ *    r.cardinality()      -> 3
+ *    r.forEach([](UInt32 index) { ... });  // in ascending order
+ */
+class RoaringBitmap
+{
+public:
+    /** Containers with more indices than this are bitmaps. */
+    static constexpr UInt32 ARRAY_MAX = 4096u;
+
+    /** Replace the value with the sorted, unique indices. */
+    void assign(const std::vector<UInt32> &sorted);
+
+    /** The indices, sorted, written to `out` (its previous content is discarded). */
+    void toSparse(std::vector<UInt32> &out) const;
+
+    /** Remove all indices. */
+    void clear();
+
+    bool contains(const UInt32 index) const;
+
+    /** Number of indices. */
+    size_t cardinality() const noexcept { return cardinality_; }
+    bool empty() const noexcept { return cardinality_ == 0u; }
+
+    /** Number of indices in both this and `other`. */
+    size_t overlap(const RoaringBitmap &other) const;
+
+    /** Call f(index) for each index, in ascending order. */
+    template<typename F>
+    void forEach(F &&f) const {
+        for(size_t c = 0; c < keys_.size(); c++) {
+            const UInt32 high = static_cast<UInt32>(keys_[c]) << 16;
+            const Container &container = containers_[c];
+            if( container.bitmap.empty() ) {
+                for(const UInt16 low : container.array) f(high | low);
+            }
+            else {
+                for(UInt32 w = 0; w < BITMAP_WORDS; w++) {
+                    for(UInt64 word = container.bitmap[w]; word != 0u; word &= word - 1u) {
+                        f(high | (w * 64u + lowestBit_(word)));
+                    }
+                }
+            }
+        }
+    }
+
+    /** Bytes used by the containers (not counting allocator overhead). */
+    size_t memoryUsage() const;
+
+    bool operator==(const RoaringBitmap &other) const;
+    bool operator!=(const RoaringBitmap &other) const { return not (*this == other); }
+
+private:
+    static constexpr UInt32 BITMAP_WORDS = 1024u; // 2^16 bits
+
+    struct Container {
+        std::vector<UInt16> array;  // sorted lower 16 bits, if not a bitmap
+        std::vector<UInt64> bitmap; // BITMAP_WORDS words, or empty
+        UInt32 cardinality = 0u;
+    };
+
+    static UInt32 lowestBit_(const UInt64 word) {
+    #if defined(__GNUC__)
+        return static_cast<UInt32>(__builtin_ctzll(word));
+    #else
+        UInt32 bit = 0u;
+        while( ((word >> bit) & 1u) == 0u ) bit++;
+        return bit;
+    #endif
+    }
+
+    std::vector<UInt16>    keys_;       // upper 16 bits of each container, ascending
+    std::vector<Container> containers_; // parallel to keys_
+    size_t                 cardinality_ = 0u;
+};
+
+} // end namespace htm
+#endif // end NTA_ROARING_BITMAP_HPP
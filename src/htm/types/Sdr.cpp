@@ -22,27 +22,328 @@
  */
 
 #include "htm/types/Sdr.hpp"
+#include "htm/utils/CpuDispatch.hpp"
 
 #include <numeric>
 #include <algorithm> // std::sort, std::accumulate
+#include <cstring>   // memcpy
+#include <memory>    // unique_ptr
+#include <unordered_set>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #define HTM_SDR_X86_POPCNT
+  #include <immintrin.h>
+#endif
 
 using namespace std;
 
 namespace htm {
 
+namespace {
+    constexpr UInt BITS_PER_WORD = 64u;
+
+    inline size_t numWords_(const UInt size)
+        { return (static_cast<size_t>(size) + BITS_PER_WORD - 1u) / BITS_PER_WORD; }
+
+    inline UInt popcount64_(UInt64 word) {
+    #if defined(__GNUC__)
+        return static_cast<UInt>(__builtin_popcountll(word));
+    #else
+        word = word - ((word >> 1) & 0x5555555555555555ull);
+        word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+        word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+        return static_cast<UInt>((word * 0x0101010101010101ull) >> 56);
+    #endif
+    }
+
+    // Index of the lowest set bit, word must not be 0.
+    inline UInt lowestBit64_(const UInt64 word) {
+    #if defined(__GNUC__)
+        return static_cast<UInt>(__builtin_ctzll(word));
+    #else
+        UInt bit = 0u;
+        while( ((word >> bit) & 1u) == 0u ) bit++;
+        return bit;
+    #endif
+    }
+
+    // Number of bits set in both a and b.
+    UInt countAndScalar_(const UInt64 *a, const UInt64 *b, const size_t n) {
+        UInt count = 0u;
+        for(size_t w = 0; w < n; w++)
+            count += popcount64_(a[w] & b[w]);
+        return count;
+    }
+
+#ifdef HTM_SDR_X86_POPCNT
+    // Same as above, compiled to the popcnt instruction.
+    __attribute__((target("popcnt")))
+    UInt countAndPopcnt_(const UInt64 *a, const UInt64 *b, const size_t n) {
+        UInt count = 0u;
+        for(size_t w = 0; w < n; w++)
+            count += static_cast<UInt>(__builtin_popcountll(a[w] & b[w]));
+        return count;
+    }
+#endif
+
+    using CountAndFn = UInt (*)(const UInt64 *, const UInt64 *, size_t);
+    UInt countAnd_(const UInt64 *a, const UInt64 *b, const size_t n) {
+        static const CountAndFn fn = CpuDispatch::bind<CountAndFn>("sdr.countAnd", {
+        #ifdef HTM_SDR_X86_POPCNT
+            {"popcnt", CPU_POPCNT, countAndPopcnt_},
+        #endif
+            {"scalar", 0u, countAndScalar_}});
+        return fn(a, b, n);
+    }
+
+    // Sets out to nChoices distinct values of [0, n), sorted, uniformly at
+    // random.  Robert Floyd's algorithm: one draw per choice and no buffer of
+    // the whole range.  For more than half of the range, samples the values
+    // left out instead.
+    void sampleSorted_(Random &rng, const UInt n, const UInt nChoices, SDR_sparse_t &out) {
+        NTA_ASSERT( nChoices <= n );
+        const bool complement = nChoices > n / 2u;
+        const UInt k = complement ? n - nChoices : nChoices;
+
+        out.clear();
+        out.reserve( nChoices );
+        std::unordered_set<UInt> chosen;
+        chosen.reserve( k );
+        for( UInt j = n - k; j < n; j++ ) {
+            const UInt t = rng.getUInt32( j + 1u );
+            const UInt pick = chosen.insert( t ).second ? t : j;
+            if( pick == j ) chosen.insert( j );
+            out.push_back( pick );
+        }
+        std::sort( out.begin(), out.end() );
+        if( not complement )
+            return;
+
+        SDR_sparse_t skip;
+        skip.swap( out );
+        out.reserve( nChoices );
+        auto it = skip.cbegin();
+        for( UInt i = 0u; i < n; i++ ) {
+            if( it != skip.cend() and *it == i ) ++it;
+            else out.push_back( i );
+        }
+    }
+
+    // Append the indices of the non-zero bytes of dense[begin, end) to sparse.
+    void denseToSparseScalar_(const ElemDense *dense, const UInt begin, const UInt end,
+                              SDR_sparse_t &sparse) {
+        static_assert( sizeof(ElemDense) == 1u, "dense to sparse kernels assume byte values" );
+        UInt idx = begin;
+        for(; idx + 8u <= end; idx += 8u) {
+            UInt64 word;
+            std::memcpy( &word, dense + idx, sizeof(word) );
+            if( word == 0u ) continue; // skip 8 zeros at a time
+            for(UInt i = idx; i < idx + 8u; i++)
+                if( dense[i] != 0 ) sparse.push_back( i );
+        }
+        for(; idx < end; idx++)
+            if( dense[idx] != 0 ) sparse.push_back( idx );
+    }
+
+#ifdef HTM_SDR_X86_POPCNT
+    // A mask of the non-zero bytes of each block, then one index per set bit.
+    // Return the number of bytes done, the rest is left for the scalar code.
+    __attribute__((target("avx512bw")))
+    UInt denseToSparseAvx512_(const ElemDense *dense, const UInt size, SDR_sparse_t &sparse) {
+        UInt idx = 0u;
+        for(; idx + 64u <= size; idx += 64u) {
+            const __m512i v = _mm512_loadu_si512( reinterpret_cast<const void*>(dense + idx) );
+            for(UInt64 mask = _mm512_test_epi8_mask(v, v); mask != 0u; mask &= mask - 1u)
+                sparse.push_back( idx + lowestBit64_(mask) );
+        }
+        return idx;
+    }
+
+    __attribute__((target("avx2")))
+    UInt denseToSparseAvx2_(const ElemDense *dense, const UInt size, SDR_sparse_t &sparse) {
+        const __m256i zero = _mm256_setzero_si256();
+        UInt idx = 0u;
+        for(; idx + 32u <= size; idx += 32u) {
+            const __m256i v = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(dense + idx) );
+            const UInt32 zeros = static_cast<UInt32>( _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, zero)) );
+            for(UInt32 mask = ~zeros; mask != 0u; mask &= mask - 1u)
+                sparse.push_back( idx + static_cast<UInt>(__builtin_ctz(mask)) );
+        }
+        return idx;
+    }
+#endif
+
+#ifdef HTM_SDR_X86_POPCNT
+    // The same masks are the packed words. Return the number of words done.
+    __attribute__((target("avx2")))
+    size_t denseToPackedAvx2_(const ElemDense *dense, const UInt size, UInt64 *packed) {
+        const __m256i zero = _mm256_setzero_si256();
+        size_t w = 0u;
+        for(; (w + 1u) * BITS_PER_WORD <= size; w++) {
+            const ElemDense *block = dense + w * BITS_PER_WORD;
+            const __m256i lo = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(block) );
+            const __m256i hi = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(block + 32u) );
+            const UInt64 zerosLo = static_cast<UInt32>( _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, zero)) );
+            const UInt64 zerosHi = static_cast<UInt32>( _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, zero)) );
+            packed[w] = ~(zerosLo | (zerosHi << 32));
+        }
+        return w;
+    }
+#endif
+
+    // Packed words of a dense array, packed must be zeroed and numWords_(size) long.
+    void denseToPacked_(const ElemDense *dense, const UInt size, UInt64 *packed) {
+        using DenseToPackedFn = size_t (*)(const ElemDense *, UInt, UInt64 *);
+        static const DenseToPackedFn simd = CpuDispatch::bind<DenseToPackedFn>("sdr.denseToPacked", {
+        #ifdef HTM_SDR_X86_POPCNT
+            {"avx2", CPU_AVX2, denseToPackedAvx2_},
+        #endif
+            {"scalar", 0u, [](const ElemDense *, UInt, UInt64 *) -> size_t { return 0u; }}});
+        const size_t done = simd( dense, size, packed );
+        for(UInt idx = static_cast<UInt>(done * BITS_PER_WORD); idx < size; idx++) {
+            if( dense[idx] != 0 )
+                packed[idx / BITS_PER_WORD] |= UInt64(1u) << (idx % BITS_PER_WORD);
+        }
+    }
+
+    // Sparse indices of a dense array, appended to sparse.
+    void denseToSparse_(const ElemDense *dense, const UInt size, SDR_sparse_t &sparse) {
+        using DenseToSparseFn = UInt (*)(const ElemDense *, UInt, SDR_sparse_t &);
+        static const DenseToSparseFn simd = CpuDispatch::bind<DenseToSparseFn>("sdr.denseToSparse", {
+        #ifdef HTM_SDR_X86_POPCNT
+            {"avx512", CPU_AVX512BW, denseToSparseAvx512_},
+            {"avx2", CPU_AVX2, denseToSparseAvx2_},
+        #endif
+            {"scalar", 0u, [](const ElemDense *, UInt, SDR_sparse_t &) -> UInt { return 0u; }}});
+        const UInt done = simd( dense, size, sparse );
+        denseToSparseScalar_( dense, done, size, sparse );
+    }
+
+    // First position in [first, last) with *pos >= value. Galloping: cheap when
+    // the answer is near `first`, as when walking a much longer sorted list.
+    inline const ElemSparse *gallop_(const ElemSparse *first, const ElemSparse *last,
+                                     const ElemSparse value) {
+        size_t step = 1u;
+        while( first + step < last and first[step] < value ) {
+            first += step;
+            step  *= 2u;
+        }
+        return std::lower_bound(first, std::min(first + step + 1u, last), value);
+    }
+
+    // Keep only the indices of `result` which are also in `other`, both sorted.
+    void intersectSparse_(SDR_sparse_t &result, const SDR_sparse_t &other) {
+        const ElemSparse *pos = other.data();
+        const ElemSparse *end = other.data() + other.size();
+        size_t kept = 0u;
+        for(size_t i = 0u; i < result.size() and pos != end; i++) {
+            pos = gallop_(pos, end, result[i]);
+            if( pos != end and *pos == result[i] )
+                result[kept++] = result[i];
+        }
+        result.resize(kept);
+    }
+
+    // Merge the sorted lists, without duplicates, into `out`.
+    void unionSparse_(const vector<const SDR_sparse_t*> &inputs, SDR_sparse_t &out) {
+        using Cursor = std::pair<const ElemSparse*, const ElemSparse*>; //position, end
+        vector<Cursor> heap;
+        heap.reserve(inputs.size());
+        size_t total = 0u;
+        for(const auto *in : inputs) {
+            total += in->size();
+            if( not in->empty() )
+                heap.emplace_back(in->data(), in->data() + in->size());
+        }
+        const auto greater = [](const Cursor &a, const Cursor &b) { return *a.first > *b.first; };
+        std::make_heap(heap.begin(), heap.end(), greater);
+        out.clear();
+        out.reserve(total);
+        while( not heap.empty() ) {
+            std::pop_heap(heap.begin(), heap.end(), greater);
+            Cursor &c = heap.back();
+            if( out.empty() or out.back() != *c.first )
+                out.push_back(*c.first);
+            if( ++c.first == c.second )
+                heap.pop_back();
+            else
+                std::push_heap(heap.begin(), heap.end(), greater);
+        }
+    }
+} // end anonymous namespace
+
     void SparseDistributedRepresentation::clear() const {
         dense_valid       = false;
         sparse_valid      = false;
         coordinates_valid = false;
+        packed_valid      = false;
+        compressed_valid  = false;
     }
 
-    void SparseDistributedRepresentation::do_callbacks() const {
+namespace {
+    // See SDR::DeferCallbacks.
+    thread_local UInt deferDepth_ = 0u;
+    thread_local std::vector<const SparseDistributedRepresentation*> deferred_;
+
+    // See SDR::Scratch, the free SDRs of this thread.
+    thread_local std::vector<std::unique_ptr<SparseDistributedRepresentation>> scratchPool_;
+}
+
+    void SparseDistributedRepresentation::notify_() const {
+        if( deferDepth_ > 0u ) {
+            if( not callbacksPending_ ) {
+                callbacksPending_ = true;
+                deferred_.push_back( this );
+            }
+            return;
+        }
         for(const auto &func_ptr : callbacks) {
             if( func_ptr != nullptr )
                 func_ptr();
         }
     }
 
+    SparseDistributedRepresentation::Scratch::Scratch( const vector<UInt> &dimensions ) {
+        if( scratchPool_.empty() ) {
+            sdr_ = new SparseDistributedRepresentation( dimensions );
+            return;
+        }
+        // Prefer a free SDR of these dimensions, its buffers have the right capacity.
+        auto it = std::find_if( scratchPool_.rbegin(), scratchPool_.rend(),
+            [&dimensions](const std::unique_ptr<SparseDistributedRepresentation> &sdr)
+                { return sdr->dimensions == dimensions; });
+        if( it == scratchPool_.rend() )
+            it = scratchPool_.rbegin();
+        std::swap( *it, scratchPool_.back() );
+        sdr_ = scratchPool_.back().release();
+        scratchPool_.pop_back();
+        sdr_->reset( dimensions );
+    }
+
+    SparseDistributedRepresentation::Scratch::~Scratch()
+        { scratchPool_.emplace_back( sdr_ ); }
+
+    SparseDistributedRepresentation::DeferCallbacks::DeferCallbacks()
+        { deferDepth_++; }
+
+    SparseDistributedRepresentation::DeferCallbacks::~DeferCallbacks() {
+        if( --deferDepth_ > 0u )
+            return;
+        // The callbacks may change or destroy SDRs: changes now notify
+        // immediately, destroyed SDRs are set to NULL in deferred_.
+        for( size_t i = 0; i < deferred_.size(); i++ ) {
+            const SparseDistributedRepresentation *sdr = deferred_[i];
+            if( sdr == nullptr ) continue;
+            deferred_[i] = nullptr;
+            sdr->callbacksPending_ = false;
+            for(const auto &func_ptr : sdr->callbacks) {
+                if( func_ptr != nullptr )
+                    func_ptr();
+            }
+        }
+        deferred_.clear();
+    }
+
     void SparseDistributedRepresentation::setDenseInplace() const {
         // Check data is valid.
         NTA_ASSERT( dense_.size() == size );
@@ -97,7 +398,33 @@ namespace htm {
         do_callbacks();
     }
 
+    void SparseDistributedRepresentation::setPackedInplace() const {
+        // Check data is valid.
+        NTA_ASSERT( packed_.size() == numWords_(size) );
+        #ifdef NTA_ASSERTIONS_ON
+            if( size % BITS_PER_WORD != 0u ) {
+                NTA_ASSERT( (packed_.back() >> (size % BITS_PER_WORD)) == 0u )
+                    << "Packed data must be zero past the end of the SDR!";
+            }
+        #endif
+        // Set the valid flags.
+        clear();
+        packed_valid = true;
+        do_callbacks();
+    }
+
+    void SparseDistributedRepresentation::setCompressedInplace() const {
+        // Set the valid flags.
+        clear();
+        compressed_valid = true;
+        do_callbacks();
+    }
+
     void SparseDistributedRepresentation::deconstruct() {
+        if( callbacksPending_ ) {
+            *std::find(deferred_.begin(), deferred_.end(), this) = nullptr;
+            callbacksPending_ = false;
+        }
         clear();
         size_ = 0;
         dimensions_.clear();
@@ -106,6 +433,7 @@ namespace htm {
                 func();
         }
         callbacks.clear();
+        numCallbacks_ = 0u;
         destroyCallbacks.clear();
     }
 
@@ -129,6 +457,8 @@ namespace htm {
 
         // Initialize the dense array storage, when it's needed.
         dense_valid = false;
+        packed_valid = false;
+        compressed_valid = false;
         // Initialize the flatSparse array, nothing to do.
         sparse_valid = true;
         // Initialize the index tuple.
@@ -136,6 +466,21 @@ namespace htm {
         coordinates_valid = true;
     }
 
+    void SparseDistributedRepresentation::reset( const vector<UInt> &dimensions ) {
+        if( dimensions != dimensions_ ) {
+            NTA_CHECK( dimensions.size() > 0 ) << "SDR has no dimensions!";
+            const UInt newSize = std::accumulate(dimensions.begin(), dimensions.end(), 1u, std::multiplies<int>());
+            if(dimensions != vector<UInt>{0}) {
+                NTA_CHECK(newSize > 0) << "SDR: all dimensions must be > 0";
+            }
+            dimensions_.assign( dimensions.begin(), dimensions.end() );
+            size_ = newSize;
+            coordinates_.resize( dimensions.size() );
+        }
+        sparse_.clear();
+        setSparseInplace();
+    }
+
     SparseDistributedRepresentation::SparseDistributedRepresentation(
                                 const SparseDistributedRepresentation &value )
         : SparseDistributedRepresentation( value.dimensions )
@@ -148,7 +493,7 @@ namespace htm {
     void SparseDistributedRepresentation::reshape(const vector<UInt> &dimensions) const {
         // Make sure we have the data in a format which does not care about the
         // dimensions, IE: dense or sparse but not coordinates
-        if( not dense_valid and not sparse_valid )
+        if( not dense_valid and not sparse_valid and not packed_valid and not compressed_valid )
             getSparse();
         coordinates_valid = false;
         coordinates_.assign( dimensions.size(), {} );
@@ -173,16 +518,88 @@ namespace htm {
 
     SDR_dense_t& SparseDistributedRepresentation::getDense() const {
         if( !dense_valid ) {
-            // Convert from flatSparse to dense.
-            dense_.assign( size, 0 );
-            for(const auto &idx : getSparse()) {
-                dense_[idx] = 1;
+            if( packed_valid and not sparse_valid ) {
+                // Convert from packed to dense.
+                dense_.resize( size );
+                for(UInt idx = 0; idx < size; idx++) {
+                    dense_[idx] = static_cast<ElemDense>((packed_[idx / BITS_PER_WORD] >> (idx % BITS_PER_WORD)) & 1u);
+                }
+            }
+            else {
+                // Convert from flatSparse to dense.
+                dense_.assign( size, 0 );
+                for(const auto &idx : getSparse()) {
+                    dense_[idx] = 1;
+                }
             }
             dense_valid = true;
         }
         return dense_;
     }
 
+
+    void SparseDistributedRepresentation::setPacked( SDR_packed_t &value ) {
+        NTA_ASSERT(value.size() == numWords_(size));
+        packed_.swap( value );
+        setPackedInplace();
+    }
+
+    SDR_packed_t& SparseDistributedRepresentation::getPacked() const {
+        if( !packed_valid ) {
+            packed_.assign( numWords_(size), 0u );
+            if( dense_valid and not sparse_valid ) {
+                // Convert from dense to packed.
+                denseToPacked_( dense_.data(), size, packed_.data() );
+            }
+            else {
+                // Convert from flatSparse to packed.
+                for(const auto &idx : getSparse()) {
+                    packed_[idx / BITS_PER_WORD] |= UInt64(1u) << (idx % BITS_PER_WORD);
+                }
+            }
+            packed_valid = true;
+        }
+        return packed_;
+    }
+
+    void SparseDistributedRepresentation::setCompressed( SDR_compressed_t &value ) {
+        NTA_ASSERT( value.empty() or not value.contains(size) ); // cheap partial check
+        std::swap( compressed_, value );
+        setCompressedInplace();
+    }
+
+    SDR_compressed_t& SparseDistributedRepresentation::getCompressed() const {
+        if( !compressed_valid ) {
+            compressed_.assign( getSparse() );
+            compressed_valid = true;
+        }
+        return compressed_;
+    }
+
+    bool SparseDistributedRepresentation::contains(const ElemSparse index) const {
+        NTA_ASSERT( index < size ) << "SDR::contains() index out of bounds";
+        if( dense_valid )
+            return dense_[index] != 0;
+        if( packed_valid )
+            return ((packed_[index / BITS_PER_WORD] >> (index % BITS_PER_WORD)) & 1u) != 0u;
+        if( compressed_valid )
+            return compressed_.contains( index );
+        const auto &sparse = getSparse(); // converts only from the coordinates
+        return std::binary_search( sparse.begin(), sparse.end(), index );
+    }
+
+    size_t SparseDistributedRepresentation::memoryUsage() const {
+        size_t bytes = dense_.capacity() * sizeof(ElemDense) +
+                       sparse_.capacity() * sizeof(ElemSparse) +
+                       coordinates_.capacity() * sizeof(SDR_sparse_t) +
+                       packed_.capacity() * sizeof(UInt64) +
+                       compressed_.memoryUsage() +
+                       dimensions_.capacity() * sizeof(UInt);
+        for(const auto &coordinate : coordinates_)
+            bytes += coordinate.capacity() * sizeof(UInt);
+        return bytes;
+    }
+
     Byte SparseDistributedRepresentation::at(const vector<UInt> &coordinates) const {
         UInt flat = 0;
         NTA_ASSERT(coordinates.size() == dimensions.size())
@@ -202,6 +619,43 @@ namespace htm {
         setSparseInplace();
     }
 
+    std::vector<uint8_t> SparseDistributedRepresentation::encodeSparse(const SDR_sparse_t &sparse) {
+        std::vector<uint8_t> bytes;
+        bytes.reserve( sparse.size() * 2u );
+        ElemSparse previous = 0u;
+        for( const auto idx : sparse ) {
+            UInt32 gap = idx - previous;
+            previous = idx;
+            while( gap >= 0x80u ) {
+                bytes.push_back( static_cast<uint8_t>( gap | 0x80u ));
+                gap >>= 7u;
+            }
+            bytes.push_back( static_cast<uint8_t>( gap ));
+        }
+        return bytes;
+    }
+
+    SDR_sparse_t SparseDistributedRepresentation::decodeSparse(const std::vector<uint8_t> &bytes) {
+        SDR_sparse_t sparse;
+        sparse.reserve( bytes.size() );
+        UInt64 previous = 0u;
+        size_t i = 0u;
+        while( i < bytes.size() ) {
+            UInt64 gap = 0u;
+            for( UInt shift = 0u; ; shift += 7u ) {
+                NTA_CHECK( i < bytes.size() && shift < 35u ) << "SDR: corrupt sparse data";
+                const uint8_t b = bytes[i++];
+                gap |= static_cast<UInt64>( b & 0x7Fu ) << shift;
+                if( b < 0x80u ) break;
+            }
+            NTA_CHECK( sparse.empty() || gap > 0u ) << "SDR: corrupt sparse data";
+            previous += gap;
+            NTA_CHECK( previous <= std::numeric_limits<ElemSparse>::max() ) << "SDR: corrupt sparse data";
+            sparse.push_back( static_cast<ElemSparse>( previous ));
+        }
+        return sparse;
+    }
+
     SDR_sparse_t& SparseDistributedRepresentation::getSparse() const {
         if( !sparse_valid ) {
             sparse_.clear(); // Clear out any old data.
@@ -209,22 +663,28 @@ namespace htm {
                 // Convert from coordinates to flat-sparse.
                 const auto &coords = getCoordinates();
                 const auto num_nz = size ? coords[0].size() : 0u;
-                sparse_.reserve( num_nz );
-                for(UInt nz = 0; nz < num_nz; ++nz) {
-                    UInt flat = 0;
-                    for(UInt dim = 0; dim < dimensions.size(); ++dim) {
-                        flat *= dimensions[dim];
-                        flat += coords[dim][nz];
-                    }
-                    sparse_.push_back(flat);
+                sparse_.assign( num_nz, 0u );
+                for(UInt dim = 0; num_nz > 0u and dim < dimensions.size(); ++dim) {
+                    const UInt stride = getCoordinateConverter()->strides()[dim];
+                    const auto &axis = coords[dim];
+                    for(UInt nz = 0; nz < num_nz; ++nz)
+                        sparse_[nz] += axis[nz] * stride;
                 }
             }
             else if( dense_valid ) {
                 // Convert from dense to flatSparse.
-                const auto &dense = getDense();
-                for(UInt idx = 0; idx < size; idx++)
-                    if( dense[idx] != 0 )
-                        sparse_.push_back( idx );
+                denseToSparse_( dense_.data(), size, sparse_ );
+            }
+            else if( packed_valid ) {
+                // Convert from packed to flatSparse, one set bit at a time.
+                for(size_t w = 0; w < packed_.size(); w++) {
+                    for(UInt64 word = packed_[w]; word != 0u; word &= word - 1u) {
+                        sparse_.push_back( static_cast<ElemSparse>(w * BITS_PER_WORD + lowestBit64_(word)) );
+                    }
+                }
+            }
+            else if( compressed_valid ) {
+                compressed_.toSparse( sparse_ );
             }
             else
                 NTA_THROW << "SDR has no data!";
@@ -241,24 +701,28 @@ namespace htm {
 
     SDR_coordinate_t& SparseDistributedRepresentation::getCoordinates() const {
       if( !coordinates_valid ) {
-        // Clear out any old data.
-        for( auto& vec : coordinates_ ) {
-          vec.clear();
-        }
-        // Convert from sparse to coordinates.
-        for( auto idx : getSparse() ) {
-          for(UInt dim = (UInt)(dimensions.size() - 1); dim > 0; --dim) {
-            const auto dim_sz = dimensions[dim];
-            coordinates_[dim].push_back( idx % dim_sz );
-            idx /= dim_sz;
-          }
-          coordinates_[0].push_back(idx);
-        }
+        // Convert from sparse to coordinates, one axis at a time.
+        if( size == 0u )
+            coordinates_.assign( dimensions.size(), {} );
+        else
+            getCoordinateConverter()->toCoordinates( getSparse(), coordinates_ );
         coordinates_valid = true;
       }
       return coordinates_;
     }
 
+    CoordinateAxis SparseDistributedRepresentation::getCoordinateAxis( const UInt axis ) const {
+      NTA_CHECK( axis < dimensions.size() ) << "SDR::getCoordinateAxis: no axis " << axis;
+      const auto &sparse = getSparse();
+      return CoordinateAxis( sparse.data(), sparse.size(), getCoordinateConverter(), axis );
+    }
+
+    std::shared_ptr<const CoordinateConverter> SparseDistributedRepresentation::getCoordinateConverter() const {
+      if( !converter_ || converter_->dimensions() != dimensions_ )
+        converter_ = CoordinateConverter::get( dimensions_ );
+      return converter_;
+    }
+
 
     void SparseDistributedRepresentation::setSDR( const SparseDistributedRepresentation &value ) {
         reshape( value.dimensions );
@@ -282,12 +746,26 @@ namespace htm {
     UInt SparseDistributedRepresentation::getOverlap(const SparseDistributedRepresentation &sdr) const {
         NTA_ASSERT( dimensions == sdr.dimensions );
 
-        UInt ovlp = 0u;
-        const auto a = this->getDense();
-        const auto b = sdr.getDense();
-        for( UInt i = 0u; i < size; i++ )
-            ovlp += a[i] && b[i];
-        return ovlp;
+        // Both compressed: per chunk, without expanding either.
+        if( compressed_valid and sdr.compressed_valid )
+            return static_cast<UInt>( compressed_.overlap( sdr.compressed_ ));
+
+        // Two short sparse lists: merge them, cheaper than packing both.
+        if( sparse_valid and sdr.sparse_valid and
+            (sparse_.size() + sdr.sparse_.size()) * BITS_PER_WORD < size ) {
+            UInt ovlp = 0u;
+            auto a = sparse_.cbegin();
+            auto b = sdr.sparse_.cbegin();
+            while( a != sparse_.cend() and b != sdr.sparse_.cend() ) {
+                if( *a < *b )      ++a;
+                else if( *b < *a ) ++b;
+                else { ovlp++; ++a; ++b; }
+            }
+            return ovlp;
+        }
+        const auto &a = this->getPacked();
+        const auto &b = sdr.getPacked();
+        return countAnd_( a.data(), b.data(), a.size() );
     }
 
 
@@ -296,14 +774,19 @@ namespace htm {
         randomize( sparsity, rng );
     }
 
-    void SparseDistributedRepresentation::randomize(Real sparsity, Random &rng) {
+    void SparseDistributedRepresentation::randomize(Real sparsity, Random &rng, const bool sampled) {
         NTA_ASSERT( sparsity >= 0.0f and sparsity <= 1.0f );
         UInt nbits = (UInt) std::round( size * sparsity );
 
-        SDR_sparse_t range( size );
-        iota( range.begin(), range.end(), 0u );
-        sparse_ = rng.sample( range, nbits);
-        sort( sparse_.begin(), sparse_.end() );
+        if( sampled ) {
+            sampleSorted_( rng, size, nbits, sparse_ );
+        }
+        else {
+            SDR_sparse_t range( size );
+            iota( range.begin(), range.end(), 0u );
+            sparse_ = rng.sample( range, nbits);
+            sort( sparse_.begin(), sparse_.end() );
+        }
         setSparseInplace();
     }
 
@@ -313,28 +796,68 @@ namespace htm {
         addNoise( fractionNoise, rng );
     }
 
-    void SparseDistributedRepresentation::addNoise(Real fractionNoise, Random &rng) {
+    void SparseDistributedRepresentation::addNoise(Real fractionNoise, Random &rng, const bool sampled) {
         NTA_ASSERT( fractionNoise >= 0. and fractionNoise <= 1. );
         NTA_CHECK( ( 1 + fractionNoise) * getSparsity() <= 1. );
 
-        const UInt num_move_bits = (UInt) std::round( fractionNoise * getSum() );
-        const auto& turn_off = rng.sample(getSparse(), num_move_bits);
+        if( not sampled ) {
+            const UInt num_move_bits = (UInt) std::round( fractionNoise * getSum() );
+            const auto& turn_off = rng.sample(getSparse(), num_move_bits);
 
-        auto& dns = getDense();
+            auto& dns = getDense();
 
-        vector<UInt> off_pop;
-        for(UInt idx = 0; idx < size; idx++) {
-            if( dns[idx] == 0 )
-                off_pop.push_back( idx );
+            vector<UInt> off_pop;
+            for(UInt idx = 0; idx < size; idx++) {
+                if( dns[idx] == 0 )
+                    off_pop.push_back( idx );
+            }
+            const vector<UInt> turn_on = rng.sample(off_pop, num_move_bits);
+
+            for( auto idx : turn_on )
+                dns[ idx ] = 1;
+            for( auto idx : turn_off )
+                dns[ idx ] = 0;
+
+            setDenseInplace();
+            return;
         }
-        const vector<UInt> turn_on = rng.sample(off_pop, num_move_bits);
 
-        for( auto idx : turn_on )
-            dns[ idx ] = 1;
-        for( auto idx : turn_off )
-            dns[ idx ] = 0;
+        const auto &active = getSparse();
+        const UInt numActive = static_cast<UInt>( active.size() );
+        const UInt num_move_bits = (UInt) std::round( fractionNoise * numActive );
+
+        // Which active bits to turn off, by their rank among the active bits,
+        // and which inactive bits to turn on, by their rank among the
+        // inactive bits.  Both sorted.
+        SDR_sparse_t turn_off, turn_on;
+        sampleSorted_( rng, numActive, num_move_bits, turn_off );
+        sampleSorted_( rng, size - numActive, num_move_bits, turn_on );
+
+        // The r-th inactive bit is r plus the number of active bits before it.
+        UInt before = 0u;
+        for( auto &rank : turn_on ) {
+            while( before < numActive and active[before] <= rank + before )
+                before++;
+            rank += before;
+        }
 
-        setDenseInplace();
+        SDR_sparse_t next;
+        next.reserve( numActive );
+        auto on  = turn_on.cbegin();
+        auto off = turn_off.cbegin();
+        for( UInt rank = 0u; rank < numActive; rank++ ) {
+            if( off != turn_off.cend() and *off == rank ) {
+                ++off;
+                continue;
+            }
+            while( on != turn_on.cend() and *on < active[rank] )
+                next.push_back( *on++ );
+            next.push_back( active[rank] );
+        }
+        next.insert( next.end(), on, turn_on.cend() );
+
+        sparse_.swap( next );
+        setSparseInplace();
     }
 
 
@@ -354,6 +877,32 @@ namespace htm {
     }
 
 
+    bool SparseDistributedRepresentation::useSparseSetOperation_(
+            const vector<const SDR*> &inputs, const bool inplace, const bool intersect) const {
+        // The packed loop costs one operation per word and input. Walking the
+        // sorted indices costs a few per active bit (galloping, or a heap of
+        // the inputs), which is less for very sparse inputs.  Only used when
+        // all inputs have the sparse format already: a conversion costs more.
+        if( inplace and not sparse_valid )
+            return false;
+        size_t minSum = inplace ? sparse_.size() : size;
+        size_t total  = inplace ? sparse_.size() : 0u;
+        for(const auto *sdr_ptr : inputs) {
+            if( not sdr_ptr->sparse_valid )
+                return false;
+            minSum = std::min(minSum, sdr_ptr->sparse_.size());
+            total += sdr_ptr->sparse_.size();
+        }
+        const size_t numInputs = inputs.size() + (inplace ? 1u : 0u);
+        const size_t packedCost = numWords_(size) * numInputs;
+        if( intersect )
+            return minSum * numInputs < packedCost;
+        size_t log2Inputs = 1u;
+        while( (size_t(1u) << log2Inputs) < numInputs ) log2Inputs++;
+        return total * log2Inputs < packedCost;
+    }
+
+
     void SparseDistributedRepresentation::intersection(
             const SDR &input1,
             const SDR &input2) {
@@ -373,23 +922,37 @@ namespace htm {
                 inputs.pop_back();
             }
         }
+        if( useSparseSetOperation_(inputs, inplace, true) ) {
+            // Galloping through the sorted indices, starting with the fewest.
+            std::sort(inputs.begin(), inputs.end(), [](const SDR *a, const SDR *b)
+                { return a->getSparse().size() < b->getSparse().size(); });
+            if( not inplace ) {
+                const auto &sparseIn = inputs.front()->getSparse();
+                sparse_.assign( sparseIn.begin(), sparseIn.end() );
+            }
+            for(size_t i = inplace ? 0u : 1u; i < inputs.size() and not sparse_.empty(); i++) {
+                intersectSparse_(sparse_, inputs[i]->getSparse());
+            }
+            SDR::setSparseInplace();
+            return;
+        }
         if( inplace ) {
-            getDense(); // Make sure that the dense data is valid.
+            getPacked(); // Make sure that the packed data is valid.
         }
         if( not inplace ) {
             // Copy one of the SDRs over to the output SDR.
-            const auto &denseIn = inputs.back()->getDense();
-            dense_.assign( denseIn.begin(), denseIn.end() );
+            const auto &packedIn = inputs.back()->getPacked();
+            packed_.assign( packedIn.begin(), packedIn.end() );
             inputs.pop_back();
             // inplace = true; // Now it's an inplace operation.
         }
         for(const auto &sdr_ptr : inputs) {
-            const auto &data = sdr_ptr->getDense();
-            for(auto z = 0u; z < data.size(); ++z) {
-                dense_[z] = dense_[z] && data[z];
+            const auto &data = sdr_ptr->getPacked();
+            for(size_t w = 0u; w < data.size(); ++w) {
+                packed_[w] &= data[w];
             }
         }
-        SDR::setDenseInplace();
+        SDR::setPackedInplace();
     }
 
 
@@ -411,23 +974,38 @@ namespace htm {
                 inputs.pop_back();
             }
         }
+        if( useSparseSetOperation_(inputs, inplace, false) ) {
+            // k-way merge of the sorted indices.
+            SDR_sparse_t own;
+            vector<const SDR_sparse_t*> lists;
+            lists.reserve(inputs.size() + 1u);
+            if( inplace ) {
+                own.swap(sparse_); // the output buffer is an input too
+                lists.push_back(&own);
+            }
+            for(const auto *sdr_ptr : inputs)
+                lists.push_back(&sdr_ptr->getSparse());
+            unionSparse_(lists, sparse_);
+            SDR::setSparseInplace();
+            return;
+        }
         if( inplace ) {
-            getDense(); // Make sure that the dense data is valid.
+            getPacked(); // Make sure that the packed data is valid.
         }
         if( not inplace ) {
             // Copy one of the SDRs over to the output SDR.
-            const auto &denseIn = inputs.back()->getDense();
-            dense_.assign( denseIn.begin(), denseIn.end() );
+            const auto &packedIn = inputs.back()->getPacked();
+            packed_.assign( packedIn.begin(), packedIn.end() );
             inputs.pop_back();
             // inplace = true; // Now it's an inplace operation.
         }
         for(const auto &sdr_ptr : inputs) {
-            const auto &data = sdr_ptr->getDense();
-            for(auto z = 0u; z < data.size(); ++z) {
-                dense_[z] = dense_[z] || data[z];
+            const auto &data = sdr_ptr->getPacked();
+            for(size_t w = 0u; w < data.size(); ++w) {
+                packed_[w] |= data[w];
             }
         }
-        SDR::setDenseInplace();
+        SDR::setPackedInplace();
     }
 
 
@@ -495,14 +1073,15 @@ namespace htm {
                 return false;
         }
         // Check data
-        return std::equal(
-            getDense().begin(),
-            getDense().end(), 
-            sdr.getDense().begin());
+        if( compressed_valid and sdr.compressed_valid )
+            return compressed_ == sdr.compressed_;
+        return getPacked() == sdr.getPacked();
     }
 
 
     UInt SparseDistributedRepresentation::addCallback(SDR_callback_t callback) const {
+        NTA_CHECK( callback != nullptr );
+        numCallbacks_++;
         UInt index = 0;
         for( ; index < callbacks.size(); index++ ) {
             if( callbacks[index] == nullptr ) {
@@ -520,6 +1099,7 @@ namespace htm {
         NTA_CHECK( callbacks[index] != nullptr )
             << "SparseDistributedRepresentation::removeCallback, Callback already removed!";
         callbacks[index] = nullptr;
+        numCallbacks_--;
     }
 
 
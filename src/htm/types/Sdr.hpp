@@ -25,9 +25,12 @@
 
 #include <algorithm> //sort
 #include <functional>
+#include <numeric> // adjacent_difference, partial_sum
 #include <vector>
 
 #include <htm/types/Types.hpp>
+#include <htm/types/Coordinates.hpp>
+#include <htm/types/RoaringBitmap.hpp>
 #include <htm/types/Serializable.hpp>
 #include <htm/utils/Random.hpp>
 
@@ -39,6 +42,8 @@ using ElemSparse       = UInt32; //must match with connections::CellIdx
 using SDR_dense_t      = std::vector<ElemDense>;
 using SDR_sparse_t     = std::vector<ElemSparse>;
 using SDR_coordinate_t = std::vector<std::vector<UInt>>;
+using SDR_packed_t     = std::vector<UInt64>;
+using SDR_compressed_t = RoaringBitmap;
 using SDR_callback_t   = std::function<void()>;
 
 /**
@@ -71,6 +76,16 @@ using SDR_callback_t   = std::function<void()>;
  *    useful because it contains the location of each true bit inside of the
  *    SDR's dimensional space.
  *
+ *    Packed Format: The dense format with 64 bits per word, bit (i % 64) of
+ *    word (i / 64) is the value at index i.  The bits past the end of the SDR
+ *    are zero.  This format is 8x smaller than the dense one, the overlap,
+ *    intersection and union work on it one word at a time.
+ *
+ *    Compressed Format: A RoaringBitmap of the sparse indices, about 2 bytes
+ *    per active bit and independent of the size.  For SDRs of millions of bits
+ *    at very low sparsity, where even the packed format is large.  Use
+ *    contains() to test single bits without converting to the dense format.
+ *
  * Array Memory Layout: This class uses C-order throughout, meaning that when
  * iterating through the SDR, the last/right-most index changes fastest.
  *
@@ -136,6 +151,8 @@ protected:
     mutable SDR_dense_t      dense_;
     mutable SDR_sparse_t     sparse_;
     mutable SDR_coordinate_t coordinates_;
+    mutable SDR_packed_t     packed_;
+    mutable SDR_compressed_t compressed_;
 
     /**
      * These flags remember which data formats are up-to-date and which formats
@@ -144,6 +161,8 @@ protected:
     mutable bool dense_valid;
     mutable bool sparse_valid;
     mutable bool coordinates_valid;
+    mutable bool packed_valid;
+    mutable bool compressed_valid = false;
 
 private:
     /**
@@ -159,6 +178,25 @@ private:
      */
     mutable std::vector<SDR_callback_t> destroyCallbacks;
 
+    mutable std::shared_ptr<const CoordinateConverter> converter_; //see getCoordinateConverter()
+
+    mutable UInt   numCallbacks_     = 0u;    //non-NULL entries of callbacks
+    mutable UInt64 epoch_            = 0u;    //see getEpoch()
+    mutable bool   callbacksPending_ = false; //see DeferCallbacks
+
+    /**
+     * Runs the callbacks now, or once later if they are deferred.
+     */
+    void notify_() const;
+
+    /**
+     * Should intersection() / set_union() merge the sparse indices instead of
+     * combining the packed words? The inputs exclude this SDR, `inplace` says
+     * if it is one of them too.
+     */
+    bool useSparseSetOperation_(const std::vector<const SparseDistributedRepresentation*> &inputs,
+                                const bool inplace, const bool intersect) const;
+
 protected:
     /**
      * Remove the value from this SDR by clearing all of the valid flags.  Does
@@ -168,9 +206,14 @@ protected:
     virtual void clear() const;
 
     /**
-     * Notify everyone that this SDR's value has officially changed.
+     * Notify everyone that this SDR's value has officially changed.  Without
+     * any callbacks, this only counts the epoch.
      */
-    void do_callbacks() const;
+    inline void do_callbacks() const {
+        epoch_++;
+        if( numCallbacks_ != 0u )
+            notify_();
+    }
 
     /**
      * Update the SDR to reflect the value currently inside of the dense array.
@@ -193,6 +236,19 @@ protected:
      */
     virtual void setCoordinatesInplace() const;
 
+    /**
+     * Update the SDR to reflect the value currently inside of the packed
+     * vector. Use this method after modifying the packed vector inplace, in
+     * order to propagate any changes to the other formats.
+     */
+    virtual void setPackedInplace() const;
+
+    /**
+     * Update the SDR to reflect the value currently inside of the compressed
+     * format. Use this method after modifying it inplace.
+     */
+    virtual void setCompressedInplace() const;
+
     /**
      * Destroy this SDR.  Makes SDR unusable, should error or clearly fail if
      * used.  Also sends notification to all watchers via destroyCallbacks.
@@ -217,6 +273,16 @@ public:
 
     void initialize( const std::vector<UInt> &dimensions );
 
+    /**
+     * Change the dimensions of the SDR and set its value to all zeros.  Unlike
+     * initialize(), the size may change and the data buffers keep their
+     * capacity, so resetting an SDR to the dimensions it had before allocates
+     * nothing.
+     *
+     * @param dimensions A list of dimension sizes, defining the shape of the SDR.
+     */
+    void reset( const std::vector<UInt> &dimensions );
+
     /**
      * Initialize this SDR as a deep copy of the given SDR.  This SDR and the
      * given SDR will have no shared data and they can be modified without
@@ -294,6 +360,46 @@ public:
      */
     virtual SDR_dense_t& getDense() const;
 
+    /**
+     * Swap a new value into the SDR, see the Packed Format above.
+     *
+     * @param value A vector of (size + 63) / 64 words, the bits past the end
+     * of the SDR must be zero.  The value is swapped with the SDR's internal
+     * buffer.
+     */
+    void setPacked( SDR_packed_t &value );
+
+    /**
+     * Gets the current value of the SDR in the packed format, see above.  The
+     * result is cached like the other formats.  After modifying the packed
+     * array you MUST call sdr.setPacked().
+     *
+     * @returns A reference to the (size + 63) / 64 words of the SDR.
+     */
+    virtual SDR_packed_t& getPacked() const;
+
+    /**
+     * Swap a new value into the SDR, see the Compressed Format above.
+     *
+     * @param value A RoaringBitmap of indices less than size.  The value is
+     * swapped with the SDR's internal buffer.
+     */
+    void setCompressed( SDR_compressed_t &value );
+
+    /**
+     * Gets the current value of the SDR in the compressed format, see above.
+     * The result is cached like the other formats.
+     */
+    virtual SDR_compressed_t& getCompressed() const;
+
+    /**
+     * Is the bit at a flat index active?  Answered from a format which is
+     * valid already, in the order dense, packed, compressed, sparse (binary
+     * search); no other format is made.  So unlike getDense() this is safe for
+     * huge SDRs, and for concurrent readers once any format is valid.
+     */
+    bool contains(const ElemSparse index) const;
+
     /**
      * Query the value of the SDR at a single location.
      *
@@ -406,6 +512,25 @@ public:
      */
     virtual SDR_coordinate_t& getCoordinates() const;
 
+    /**
+     * The coordinates of the true values along one axis, computed as they
+     * are read, without the coordinates of the other axes.  The view is
+     * valid until the SDR's value changes.
+     *
+     * Example:
+     *    SDR X({ 4, 5, 6 });
+     *    X.setSparse({ 37, 119 });
+     *    X.getCoordinateAxis( 1 )[1]           -> 4
+     *    X.getCoordinateAxis( 1 ).toVector()   -> { 1, 4 }
+     */
+    CoordinateAxis getCoordinateAxis( UInt axis ) const;
+
+    /**
+     * The converter between flat indices and coordinates of this SDR's
+     * dimensions, shared by all SDRs of the same dimensions.
+     */
+    std::shared_ptr<const CoordinateConverter> getCoordinateConverter() const;
+
     /**
      * Deep Copy the given SDR to this SDR.  This overwrites the current value of
      * this SDR.  This SDR and the given SDR will have no shared data and they
@@ -435,6 +560,12 @@ public:
     inline Real getSparsity() const
         { return (Real) getSum() / size; }
 
+    /**
+     * Bytes of memory held by the SDR: its buffers of all formats, which are
+     * kept and reused once a format was used, whether it is current or not.
+     */
+    size_t memoryUsage() const;
+
     /**
      * Calculates the number of true bits which both SDRs have in common.
      *
@@ -454,10 +585,15 @@ public:
      *
      * @param rng The random number generator to draw from.  If not given, this
      * makes one using the magic seed 0.
+     *
+     * @param sampled If true, draws one random number per active bit (Floyd's
+     * algorithm) instead of shuffling the whole range, so the cost is in the
+     * number of active bits, not the size of the SDR.  The bits drawn for a
+     * seed differ from the default.  Default false.
      */
     void randomize(Real sparsity);
 
-    void randomize(Real sparsity, Random &rng);
+    void randomize(Real sparsity, Random &rng, bool sampled = false);
 
     /**
      * Modify the SDR by moving a fraction of the active bits to different
@@ -470,10 +606,13 @@ public:
      *
      * @param rng The random number generator to draw from.  If not given, this
      * makes one using the magic seed 0.
+     *
+     * @param sampled If true, draws only the moved bits instead of listing
+     * every inactive bit, see randomize().  Default false.
      */
     void addNoise(Real fractionNoise);
 
-    void addNoise(Real fractionNoise, Random &rng);
+    void addNoise(Real fractionNoise, Random &rng, bool sampled = false);
 
     /**
      * Modify the SDR by setting a fraction of the bits to zero.
@@ -499,6 +638,10 @@ public:
      * @returns In both cases the output is stored in this SDR.  This method
      * modifies this SDR and discards its current value!
      *
+     * Very sparse inputs which have the sparse format are intersected by
+     * galloping through their indices, fewest first; otherwise the packed
+     * words are combined.  Neither allocates a dense temporary.
+     *
      * Example Usage:
      *     SDR A({ 10 });
      *     SDR B({ 10 });
@@ -524,6 +667,9 @@ public:
      * @returns In both cases the output is stored in this SDR.  This method
      * modifies this SDR and discards its current value!
      *
+     * Very sparse inputs which have the sparse format are k-way merged;
+     * otherwise the packed words are combined, see intersection().
+     *
      * Example Usage:
      *     SDR A({ 10 });
      *     SDR B({ 10 });
@@ -606,17 +752,47 @@ public:
     void save_ar(Archive & ar) const
     {
         getSparse(); // to make sure sparse is valid.
-        ar(cereal::make_nvp("dimensions", dimensions_), cereal::make_nvp("sparse", sparse_) );
+        // The sorted sparse indices are saved as the gaps between them: as
+        // varint bytes in binary archives, as small numbers in text archives.
+        if constexpr( isBinaryArchive<Archive>() ) {
+            const std::vector<uint8_t> bytes = encodeSparse( sparse_ );
+            ar(cereal::make_nvp("dimensions", dimensions_), cereal::make_nvp("sparse", bytes) );
+        }
+        else {
+            SDR_sparse_t gaps( sparse_.size() );
+            std::adjacent_difference( sparse_.begin(), sparse_.end(), gaps.begin() );
+            ar(cereal::make_nvp("dimensions", dimensions_), cereal::make_nvp("gaps", gaps) );
+        }
     }
 
     template<class Archive>
     void load_ar(Archive & ar)
     {
-        ar( dimensions_, sparse_ );
-        initialize( dimensions_ );
+        std::vector<UInt> dimensions;
+        SDR_sparse_t sparse;
+        if constexpr( isBinaryArchive<Archive>() ) {
+            std::vector<uint8_t> bytes;
+            ar( dimensions, bytes );
+            sparse = decodeSparse( bytes );
+        }
+        else {
+            ar( dimensions, sparse );
+            std::partial_sum( sparse.begin(), sparse.end(), sparse.begin() );
+        }
+        initialize( dimensions );
+        NTA_CHECK( sparse.empty() || sparse.back() < size ) << "SDR: corrupt sparse data";
+        sparse_ = std::move( sparse );
         setSparseInplace();
     }
 
+    /**
+     * Delta + varint encoding of sorted, unique sparse indices: each gap to
+     * the previous index in 7 bit groups, low first, high bit set on all but
+     * the last byte. Typically 1-2 bytes per active bit instead of 4.
+     */
+    static std::vector<uint8_t> encodeSparse(const SDR_sparse_t &sparse);
+    static SDR_sparse_t decodeSparse(const std::vector<uint8_t> &bytes);
+
     /**
      * Callbacks notify you when this SDR's value changes.
      *
@@ -660,6 +836,63 @@ public:
      */
     void removeDestroyCallback(UInt index) const;
 
+    /**
+     * @returns The number of times the value of this SDR has changed, ie. the
+     * number of calls to its setter methods.  Cheaper than a callback to find
+     * out if an SDR changed since it was last looked at.
+     */
+    UInt64 getEpoch() const { return epoch_; }
+
+    /**
+     * Coalesces the callbacks of all SDRs, on the calling thread.
+     *
+     * While a DeferCallbacks exists, an SDR whose value changes does not run
+     * its callbacks.  When the last (outermost) one is destroyed, each SDR
+     * which changed runs its callbacks once, however often it changed.
+     * Network::run() defers the callbacks during each iteration.
+     *
+     * Example Usage:
+     *     {
+     *         SDR::DeferCallbacks defer;
+     *         A.setSparse({ 1 });
+     *         A.setSparse({ 2 }); // A's callbacks did not run yet
+     *     }                       // A's callbacks run once, for { 2 }
+     */
+    class DeferCallbacks {
+    public:
+        DeferCallbacks();
+        ~DeferCallbacks();
+        DeferCallbacks(const DeferCallbacks&) = delete;
+        DeferCallbacks &operator=(const DeferCallbacks&) = delete;
+    };
+
+    /**
+     * A temporary SDR, borrowed from a pool on the calling thread.
+     *
+     * The SDR is all zeros when borrowed and goes back to the pool when the
+     * Scratch is destroyed.  Free SDRs of the requested dimensions are reused
+     * first, so a computation which needs the same temporaries every step
+     * allocates nothing once it ran once.  Do not keep pointers to the SDR or
+     * add callbacks to it.
+     *
+     * Example Usage:
+     *     SDR::Scratch both( active.dimensions );
+     *     both->intersection( active, predicted );
+     *     return both->getSum();
+     */
+    class Scratch {
+    public:
+        Scratch( const std::vector<UInt> &dimensions );
+        ~Scratch();
+        Scratch(const Scratch&) = delete;
+        Scratch &operator=(const Scratch&) = delete;
+
+        SparseDistributedRepresentation &operator*()  const { return *sdr_; }
+        SparseDistributedRepresentation *operator->() const { return sdr_; }
+
+    private:
+        SparseDistributedRepresentation *sdr_;
+    };
 };
 
 typedef SparseDistributedRepresentation SDR;
@@ -0,0 +1,159 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the SDRView class
+ */
+
+#include "htm/types/SdrView.hpp"
+
+#include <algorithm> // std::lower_bound
+#include <numeric>   // std::accumulate
+#include <functional> // std::less
+
+using namespace std;
+
+namespace htm {
+
+    static UInt sizeOf_( const vector<UInt> &dimensions ) {
+        NTA_CHECK( not dimensions.empty() ) << "SDRView has no dimensions!";
+        return std::accumulate(dimensions.begin(), dimensions.end(), 1u, std::multiplies<UInt>());
+    }
+
+    SDRView::SDRView( const SparseDistributedRepresentation &sdr )
+        : SDRView( sdr.dimensions, sdr.getSparse().data(), sdr.getSparse().size() )
+        {}
+
+    SDRView::SDRView( const vector<UInt> &dimensions,
+                      const ElemSparse *sparse, const size_t numActive )
+        : dimensions_( dimensions ),
+          size_( sizeOf_(dimensions) ),
+          sparseBegin_( sparse ),
+          sparseEnd_( sparse + numActive ) {
+        NTA_CHECK( sparse != nullptr or numActive == 0u );
+        NTA_ASSERT( std::is_sorted(sparseBegin_, sparseEnd_) )
+            << "Sparse data must be sorted!";
+        NTA_ASSERT( numActive == 0u or sparseEnd_[-1] < size_ )
+            << "Index out of bounds of the SDRView!";
+    }
+
+    SDRView::SDRView( const vector<UInt> &dimensions, const ElemDense *dense )
+        : dimensions_( dimensions ),
+          size_( sizeOf_(dimensions) ),
+          dense_( dense ) {
+        NTA_CHECK( dense != nullptr );
+    }
+
+
+    SDRView SDRView::reshape( const vector<UInt> &dimensions ) const {
+        SDRView view( *this );
+        view.dimensions_ = dimensions;
+        view.size_       = sizeOf_( dimensions );
+        NTA_CHECK( view.size_ == size_ ) << "SDRView.reshape changed the size of the SDR!";
+        return view;
+    }
+
+
+    SDRView SDRView::slice( const UInt begin, const UInt end ) const {
+        NTA_CHECK( begin < end and end <= size_ )
+            << "SDRView.slice [" << begin << ", " << end << ") out of bounds of " << size_;
+        SDRView view( *this );
+        view.dimensions_ = { end - begin };
+        view.size_       = end - begin;
+        if( isSparse() ) {
+            view.offset_      = offset_ + begin;
+            view.sparseBegin_ = std::lower_bound( sparseBegin_, sparseEnd_, offset_ + begin );
+            view.sparseEnd_   = std::lower_bound( view.sparseBegin_, sparseEnd_, offset_ + end );
+        }
+        else {
+            view.dense_ = dense_ + begin;
+        }
+        return view;
+    }
+
+
+    UInt SDRView::getSum() const {
+        if( isSparse() )
+            return static_cast<UInt>(sparseEnd_ - sparseBegin_);
+        UInt sum = 0u;
+        for( UInt i = 0u; i < size_; i++ )
+            sum += dense_[i] != 0;
+        return sum;
+    }
+
+
+    bool SDRView::at( const UInt index ) const {
+        NTA_ASSERT( index < size_ ) << "SDRView.at() index out of bounds!";
+        if( isSparse() )
+            return std::binary_search( sparseBegin_, sparseEnd_, offset_ + index );
+        return dense_[index] != 0;
+    }
+
+
+    UInt SDRView::getOverlap( const SDRView &other ) const {
+        NTA_CHECK( size_ == other.size_ ) << "SDRView.getOverlap size mismatch!";
+        UInt overlap = 0u;
+        if( isSparse() and other.isSparse() ) {
+            // Merge the two sorted lists.
+            const ElemSparse *a = sparseBegin_;
+            const ElemSparse *b = other.sparseBegin_;
+            while( a != sparseEnd_ and b != other.sparseEnd_ ) {
+                const ElemSparse ia = *a - offset_;
+                const ElemSparse ib = *b - other.offset_;
+                if( ia < ib )      ++a;
+                else if( ib < ia ) ++b;
+                else { overlap++; ++a; ++b; }
+            }
+        }
+        else if( not isSparse() and not other.isSparse() ) {
+            for( UInt i = 0u; i < size_; i++ )
+                overlap += dense_[i] != 0 and other.dense_[i] != 0;
+        }
+        else {
+            const SDRView &sparse = isSparse() ? *this : other;
+            const SDRView &dense  = isSparse() ? other : *this;
+            sparse.forEach([&](const UInt i) { overlap += dense.dense_[i] != 0; });
+        }
+        return overlap;
+    }
+
+
+    void SDRView::copyTo( SparseDistributedRepresentation &sdr ) const {
+        NTA_CHECK( sdr.size == size_ ) << "SDRView.copyTo size mismatch!";
+        sdr.reshape( dimensions_ );
+        if( isSparse() ) {
+            // Into the SDR's own buffer, unless this is a view of it.
+            SDR_sparse_t &own = sdr.getSparse();
+            const std::less<const ElemSparse*> before;
+            if( before( sparseBegin_, own.data() ) or not before( sparseBegin_, own.data() + own.size() )) {
+                own.clear();
+                forEach([&](const UInt i) { own.push_back( i ); });
+                sdr.setSparse( own );
+            }
+            else {
+                SDR_sparse_t sparse;
+                sparse.reserve( sparseEnd_ - sparseBegin_ );
+                forEach([&](const UInt i) { sparse.push_back( i ); });
+                sdr.setSparse( sparse );
+            }
+        }
+        else {
+            sdr.setDense( dense_ );
+        }
+    }
+
+} // end namespace htm
@@ -0,0 +1,152 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the SDRView class, a read-only view of an SDR value.
+ */
+
+#ifndef SDR_VIEW_HPP
+#define SDR_VIEW_HPP
+
+#include <vector>
+
+#include <htm/types/Types.hpp>
+#include <htm/types/Sdr.hpp>
+
+namespace htm {
+
+/**
+ * SDRView class
+ *
+ * ### Description
+ * A non-owning, read-only view of an SDR value which lives in someone else's
+ * buffer: the sparse indices or the dense bytes of an SDR, a numpy array, a
+ * memory mapped file, etc.  Nothing is copied when the view is made, the
+ * buffer must outlive the view and must not change while it is used.
+ *
+ * A view has its own dimensions, the product of which is its size.  A slice
+ * is a view of the range [begin, end) of the flat indices, ie. of one of the
+ * inputs of an SDR made by concatenate() along axis 0.
+ *
+ * Use copyTo() to get an SDR for the APIs which need one.
+ *
+ * Example Usage:
+ *    SDR A({ 10 });
+ *    SDR B({ 20 });
+ *    SDR C({ 30 });
+ *    A.setSparse({ 1, 2 });
+ *    B.setSparse({ 0, 5 });
+ *    C.concatenate( A, B );
+ *    SDRView view( C );
+ *    view.slice( 10, 30 ).getSum()  -> 2
+ *    view.slice( 10, 30 ).at( 5 )   -> true
+ *    view.slice( 10, 30 ).copyTo( B ); // B.getSparse() -> { 0, 5 }
+ */
+class SDRView
+{
+public:
+    /**
+     * View of the sparse indices of an SDR.  Valid until the SDR changes.
+     */
+    explicit SDRView( const SparseDistributedRepresentation &sdr );
+
+    /**
+     * View of an external buffer of sorted, unique flat indices.
+     *
+     * @param dimensions Shape of the SDR.
+     * @param sparse, numActive The indices of the true values.
+     */
+    SDRView( const std::vector<UInt> &dimensions,
+             const ElemSparse *sparse, const size_t numActive );
+
+    /**
+     * View of an external dense buffer with one byte per value, any non-zero
+     * byte is true.
+     *
+     * @param dimensions Shape of the SDR.
+     * @param dense Buffer of the product of the dimensions bytes.
+     */
+    SDRView( const std::vector<UInt> &dimensions, const ElemDense *dense );
+
+    const std::vector<UInt> &getDimensions() const { return dimensions_; }
+    UInt getSize() const { return size_; }
+    bool isSparse() const { return dense_ == nullptr; }
+
+    /**
+     * @returns A view with the same values and other dimensions, the size
+     * must not change.
+     */
+    SDRView reshape( const std::vector<UInt> &dimensions ) const;
+
+    /**
+     * @returns A one dimensional view of the flat indices [begin, end), the
+     * index begin of this view is index 0 of the slice.
+     */
+    SDRView slice( const UInt begin, const UInt end ) const;
+
+    /**
+     * @returns The number of true values.
+     */
+    UInt getSum() const;
+
+    /**
+     * @returns The value at a flat index.
+     */
+    bool at( const UInt index ) const;
+
+    /**
+     * Calls visit(index) for the flat index of each true value, in ascending
+     * order.
+     */
+    template<typename Visit>
+    void forEach( Visit &&visit ) const {
+        if( isSparse() ) {
+            for( const ElemSparse *it = sparseBegin_; it != sparseEnd_; ++it )
+                visit( static_cast<UInt>(*it - offset_) );
+        }
+        else {
+            for( UInt i = 0u; i < size_; i++ )
+                if( dense_[i] != 0 ) visit( i );
+        }
+    }
+
+    /**
+     * @returns The number of true values which both views have in common,
+     * the sizes must match.
+     */
+    UInt getOverlap( const SDRView &other ) const;
+
+    /**
+     * Copies the value into an SDR, which must have the same size.  The SDR
+     * is reshaped to the dimensions of this view.
+     */
+    void copyTo( SparseDistributedRepresentation &sdr ) const;
+
+private:
+    std::vector<UInt> dimensions_;
+    UInt              size_ = 0u;
+
+    // Sparse: the indices in [sparseBegin_, sparseEnd_), minus offset_.
+    const ElemSparse *sparseBegin_ = nullptr;
+    const ElemSparse *sparseEnd_   = nullptr;
+    ElemSparse        offset_      = 0u;
+    // Dense: size_ bytes, nullptr for sparse views.
+    const ElemDense  *dense_       = nullptr;
+};
+
+} // end namespace htm
+#endif // end ifndef SDR_VIEW_HPP
@@ -78,7 +78,7 @@
 #include <cereal/types/set.hpp>     // for serializing std::set
 #include <cereal/types/deque.hpp>   // for serializing std::deque
 
-#define SERIALIZABLE_VERSION 3
+#define SERIALIZABLE_VERSION 4
 
 
 namespace htm {
@@ -92,6 +92,17 @@ namespace htm {
  */
 typedef enum {BINARY, PORTABLE, JSON, XML} SerializableFormat;
 
+/**
+ * True for the BINARY and PORTABLE archives, so save_ar()/load_ar() can pick
+ * a compact byte encoding there and a readable one for JSON and XML.
+ */
+template <class Archive> constexpr bool isBinaryArchive() {
+  return std::is_same<Archive, cereal::BinaryOutputArchive>::value ||
+         std::is_same<Archive, cereal::BinaryInputArchive>::value ||
+         std::is_same<Archive, cereal::PortableBinaryOutputArchive>::value ||
+         std::is_same<Archive, cereal::PortableBinaryInputArchive>::value;
+}
+
 // Design explanation:
 //
 // Archive?
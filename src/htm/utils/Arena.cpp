@@ -0,0 +1,102 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the Arena class
+ */
+
+#include <algorithm>
+
+#include <htm/utils/Arena.hpp>
+#include <htm/utils/Log.hpp>
+#include <htm/utils/MemoryResource.hpp>
+
+namespace htm {
+
+static const size_t HUGE_PAGE = 2u << 20u; // 2 MiB
+static const size_t MAX_ALIGNMENT = 4096u;
+
+static thread_local const std::shared_ptr<Arena> *currentArena = nullptr;
+
+Arena::Arena(size_t chunkSize, int numaNode)
+    : chunkSize_(std::max<size_t>(chunkSize, MAX_ALIGNMENT)), numaNode_(numaNode) {}
+
+Arena::~Arena() {
+  for (auto d = destructors_.rbegin(); d != destructors_.rend(); ++d) {
+    d->second(d->first);
+  }
+  for (const Chunk &chunk : chunks_) {
+    if (chunk.mapped) {
+      unmapPages(chunk.data, chunk.size);
+      continue;
+    }
+    ::operator delete(chunk.data, std::align_val_t(MAX_ALIGNMENT));
+  }
+}
+
+void Arena::addChunk_(size_t minBytes) {
+  Chunk chunk{nullptr, std::max(chunkSize_, minBytes + MAX_ALIGNMENT), false, false, false};
+  // The node of a page is set by mbind, so the chunks of a node are mapped.
+  if (pagesSupported() && (chunk.size >= HUGE_PAGE || numaNode_ >= 0)) {
+    const PageMapping pages = mapPages(chunk.size, true, numaNode_);
+    if (pages.data != nullptr) {
+      chunk.data = pages.data;
+      chunk.size = pages.size;
+      chunk.mapped = true;
+      chunk.hugePages = pages.hugePages;
+      chunk.numaBound = pages.numaBound;
+    }
+  }
+  if (chunk.data == nullptr)
+    chunk.data = static_cast<char *>(::operator new(chunk.size, std::align_val_t(MAX_ALIGNMENT)));
+  chunks_.push_back(chunk);
+  used_ = 0u;
+  reserved_ += chunk.size;
+}
+
+void *Arena::allocate(size_t bytes, size_t alignment) {
+  NTA_ASSERT(alignment > 0u && alignment <= MAX_ALIGNMENT && (alignment & (alignment - 1u)) == 0u)
+      << "Arena: bad alignment " << alignment;
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t start = (used_ + alignment - 1u) & ~(alignment - 1u);
+  if (chunks_.empty() || start + bytes > chunks_.back().size) {
+    addChunk_(bytes);
+    start = 0u;
+  }
+  used_ = start + bytes;
+  allocated_ += bytes;
+  return chunks_.back().data + start;
+}
+
+bool Arena::hasHugePages() const noexcept {
+  return std::any_of(chunks_.begin(), chunks_.end(), [](const Chunk &c) { return c.hugePages; });
+}
+
+bool Arena::isNumaBound() const noexcept {
+  return std::any_of(chunks_.begin(), chunks_.end(), [](const Chunk &c) { return c.numaBound; });
+}
+
+Arena::Scope::Scope(std::shared_ptr<Arena> arena)
+    : arena_(std::move(arena)), previous_(currentArena) {
+  currentArena = arena_ == nullptr ? nullptr : &arena_;
+}
+
+Arena::Scope::~Scope() { currentArena = previous_; }
+
+const std::shared_ptr<Arena> *Arena::current() noexcept { return currentArena; }
+
+} // namespace htm
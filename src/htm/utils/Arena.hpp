@@ -0,0 +1,130 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the Arena class
+ */
+
+#ifndef HTM_UTIL_ARENA_HPP
+#define HTM_UTIL_ARENA_HPP
+
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace htm {
+
+/**
+ * Monotonic memory arena: allocations are carved out of a few large chunks,
+ * one after the other, and are all released at once when the Arena is
+ * destroyed. Chunks of 2 MiB and more are backed by transparent huge pages
+ * where the system offers them (Linux).
+ *
+ * The ArrayBase buffers (Input/Output data, link delay buffers, the SDR
+ * objects of the SDR buffers) which are allocated while an Arena::Scope is
+ * active on the thread come from that arena, see Network::initialize().
+ * Each such buffer holds a reference on the arena, so the arena lives until
+ * its last buffer is released. Memory is not reused within the arena: a
+ * buffer which is reallocated leaves its old space unused until then.
+ *
+ * Allocation and releasing buffers are thread safe, so the regions of a
+ * Network can be initialized on several threads.
+ *
+ * An arena of a NUMA node maps all its chunks, and asks the system to place
+ * their pages on that node (Linux, best effort); a Network keeps one per
+ * node of its regions, see Network::setPlacement().
+ */
+class Arena {
+public:
+  /**
+   * @param chunkSize - bytes of each chunk; larger requests get a chunk of
+   *                    their own.
+   * @param numaNode - the NUMA node of the memory, -1 for any.
+   */
+  explicit Arena(size_t chunkSize = 1u << 20u, int numaNode = -1);
+  ~Arena();
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  /**
+   * @return uninitialized memory of the given size, aligned to `alignment`
+   *         (a power of two, at most 4096).
+   */
+  void *allocate(size_t bytes, size_t alignment = 64u);
+
+  /**
+   * Constructs an object in the arena; it is destroyed with the arena.
+   */
+  template <typename T, typename... Args> T *create(Args &&... args) {
+    T *obj = new (allocate(sizeof(T), alignof(T) < 64u ? 64u : alignof(T))) T(std::forward<Args>(args)...);
+    std::lock_guard<std::mutex> lock(mutex_);
+    destructors_.emplace_back(obj, [](void *p) { static_cast<T *>(p)->~T(); });
+    return obj;
+  }
+
+  size_t getAllocatedBytes() const noexcept { return allocated_; } // handed out
+  size_t getReservedBytes() const noexcept { return reserved_; }   // in chunks
+  size_t getNumChunks() const noexcept { return chunks_.size(); }
+  bool hasHugePages() const noexcept; // is any chunk backed by huge pages?
+  int getNumaNode() const noexcept { return numaNode_; }
+  bool isNumaBound() const noexcept;  // is any chunk bound to the node?
+
+  /**
+   * Makes `arena` the arena of the ArrayBase buffers allocated by this
+   * thread until the Scope ends. Scopes nest; a null arena turns it off.
+   */
+  class Scope {
+  public:
+    explicit Scope(std::shared_ptr<Arena> arena);
+    ~Scope();
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+  private:
+    std::shared_ptr<Arena> arena_;
+    const std::shared_ptr<Arena> *previous_;
+  };
+
+  /**
+   * @return the arena of the innermost Scope on this thread, or null.
+   */
+  static const std::shared_ptr<Arena> *current() noexcept;
+
+private:
+  struct Chunk {
+    char *data;
+    size_t size;
+    bool mapped; // mmap'ed, else operator new
+    bool hugePages;
+    bool numaBound;
+  };
+  void addChunk_(size_t minBytes);
+
+  size_t chunkSize_;
+  int numaNode_;
+  std::vector<Chunk> chunks_;
+  size_t used_ = 0u; // bytes used of the last chunk
+  size_t allocated_ = 0u;
+  size_t reserved_ = 0u;
+  std::vector<std::pair<void *, void (*)(void *)>> destructors_;
+  std::mutex mutex_; // guards the above
+};
+
+} // namespace htm
+
+#endif // HTM_UTIL_ARENA_HPP
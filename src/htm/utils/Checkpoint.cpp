@@ -0,0 +1,294 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the CheckpointWriter and CheckpointReader classes, and of
+ * the checkpoint sinks and sources
+ */
+
+#include <htm/utils/Checkpoint.hpp>
+
+#include <algorithm>
+
+namespace htm {
+
+static const char MAGIC[8] = {'H', 'T', 'M', 'C', 'K', 'P', 'T', '\0'};
+static const UInt32 BYTE_ORDER_MARK = 0x01020304u;
+static const UInt64 ALIGNMENT = 64u;
+static const size_t HEADER_BYTES = sizeof(MAGIC) + 2u * sizeof(UInt32) + 2u * sizeof(UInt64);
+static const size_t TRAILER_BYTES = 2u * sizeof(UInt64) + sizeof(MAGIC);
+
+template <typename T> static T get(const char *data, size_t size, size_t &pos, const std::string &path) {
+  NTA_CHECK(pos + sizeof(T) <= size) << "Checkpoint " << path << " is truncated";
+  T value;
+  std::memcpy(&value, data + pos, sizeof(T));
+  pos += sizeof(T);
+  return value;
+}
+
+
+FileSink::FileSink(const std::string &path)
+    : path_(path), out_(path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc) {
+  NTA_CHECK(out_.is_open()) << "Checkpoint: can't create " << path;
+}
+
+void FileSink::write(const char *data, size_t bytes) {
+  out_.write(data, static_cast<std::streamsize>(bytes));
+  NTA_CHECK(out_.good()) << "Checkpoint: failed to write " << path_;
+}
+
+void FileSink::close() {
+  if (!out_.is_open())
+    return;
+  out_.close();
+  NTA_CHECK(!out_.fail()) << "Checkpoint: failed to write " << path_;
+}
+
+
+StdioSink::StdioSink(std::FILE *file, const std::string &name) : file_(file), name_(name) {
+  NTA_CHECK(file_ != nullptr) << "Checkpoint: no stream for " << name;
+}
+
+void StdioSink::write(const char *data, size_t bytes) {
+  NTA_CHECK(std::fwrite(data, 1u, bytes, file_) == bytes) << "Checkpoint: failed to write " << name_;
+}
+
+void StdioSink::close() {
+  NTA_CHECK(std::fflush(file_) == 0) << "Checkpoint: failed to write " << name_;
+}
+
+
+MultipartSink::MultipartSink(const Upload &upload, const Complete &complete, size_t partBytes,
+                             size_t numThreads, const std::string &name)
+    : upload_(upload), complete_(complete), partBytes_(partBytes),
+      numThreads_(std::max<size_t>(1u, numThreads)), name_(name) {
+  NTA_CHECK(upload_) << "Checkpoint: no upload for " << name;
+  NTA_CHECK(partBytes_ > 0u) << "Checkpoint: " << name << " needs parts of at least one byte";
+  buffer_.reserve(partBytes_);
+}
+
+MultipartSink::~MultipartSink() {
+  for (auto &upload : uploads_) {
+    try {
+      upload.get();
+    } catch (const std::exception &) {
+    }
+  }
+}
+
+void MultipartSink::wait_(size_t inFlight) {
+  while (uploads_.size() > inFlight) {
+    auto upload = std::move(uploads_.front());
+    uploads_.pop_front();
+    upload.get(); // rethrows an error of the upload
+  }
+}
+
+void MultipartSink::flush_() {
+  wait_(numThreads_ - 1u);
+  auto part = std::make_shared<std::string>();
+  part->reserve(partBytes_);
+  part->swap(buffer_);
+  const size_t number = numParts_++;
+  const Upload &upload = upload_;
+  uploads_.push_back(std::async(std::launch::async,
+                                [&upload, part, number]() { upload(number, part->data(), part->size()); }));
+}
+
+void MultipartSink::write(const char *data, size_t bytes) {
+  NTA_CHECK(!closed_) << "Checkpoint: " << name_ << " is closed";
+  while (bytes > 0u) {
+    const size_t n = std::min(bytes, partBytes_ - buffer_.size());
+    buffer_.append(data, n);
+    data += n;
+    bytes -= n;
+    if (buffer_.size() == partBytes_)
+      flush_();
+  }
+}
+
+void MultipartSink::close() {
+  if (closed_)
+    return;
+  closed_ = true;
+  if (!buffer_.empty() || numParts_ == 0u)
+    flush_();
+  wait_(0u);
+  if (complete_)
+    complete_(numParts_);
+}
+
+
+FileSource::FileSource(const std::string &path)
+    : path_(path), in_(path, std::ios_base::in | std::ios_base::binary) {
+  NTA_CHECK(in_.is_open()) << "Checkpoint: can't open " << path;
+  in_.seekg(0, std::ios_base::end);
+  size_ = static_cast<UInt64>(in_.tellg());
+}
+
+void FileSource::read(UInt64 offset, char *data, size_t bytes) const {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  in_.seekg(static_cast<std::streamoff>(offset));
+  in_.read(data, static_cast<std::streamsize>(bytes));
+  NTA_CHECK(in_.good()) << "Checkpoint: failed to read " << path_;
+}
+
+
+CheckpointWriter::CheckpointWriter(const std::string &path) : file_(new FileSink(path)), sink_(file_.get()) {
+  start_();
+}
+
+CheckpointWriter::CheckpointWriter(CheckpointSink &sink) : sink_(&sink) { start_(); }
+
+void CheckpointWriter::start_() {
+  sink_->write(MAGIC, sizeof(MAGIC));
+  put_(VERSION);
+  put_(BYTE_ORDER_MARK);
+  put_(UInt64(0u)); // the table is found by the trailer
+  put_(UInt64(0u));
+  offset_ = HEADER_BYTES;
+  open_ = true;
+}
+
+CheckpointWriter::~CheckpointWriter() {
+  try {
+    close();
+  } catch (const std::exception &) {
+  }
+}
+
+void CheckpointWriter::write(const std::string &name, const void *data, size_t bytes) {
+  NTA_CHECK(open_) << "Checkpoint " << sink_->describe() << " is closed";
+  for (const auto &entry : entries_)
+    NTA_CHECK(entry.name != name) << "Checkpoint " << sink_->describe() << ": duplicate section " << name;
+  static const char zeros[ALIGNMENT] = {};
+  const UInt64 padding = (ALIGNMENT - offset_ % ALIGNMENT) % ALIGNMENT;
+  if (padding > 0u)
+    sink_->write(zeros, static_cast<size_t>(padding));
+  offset_ += padding;
+  if (bytes > 0u)
+    sink_->write(static_cast<const char *>(data), bytes);
+  entries_.push_back({name, offset_, bytes});
+  offset_ += bytes;
+}
+
+void CheckpointWriter::close() {
+  if (!open_)
+    return;
+  open_ = false;
+  const UInt64 tableOffset = offset_;
+  for (const auto &entry : entries_) {
+    put_(entry.offset);
+    put_(entry.bytes);
+    put_(static_cast<UInt32>(entry.name.size()));
+    sink_->write(entry.name.data(), entry.name.size());
+  }
+  put_(tableOffset);
+  put_(static_cast<UInt64>(entries_.size()));
+  sink_->write(MAGIC, sizeof(MAGIC));
+  sink_->close();
+}
+
+
+CheckpointReader::CheckpointReader(const std::string &path)
+    : path_(path), file_(new MappedFile(path)), data_(file_->data()), size_(file_->size()) {
+  parse_();
+}
+
+CheckpointReader::CheckpointReader(const CheckpointSource &source)
+    : path_(source.describe()), source_(&source), size_(source.size()) {
+  parse_();
+}
+
+void CheckpointReader::fetch_(UInt64 offset, char *data, size_t bytes) const {
+  NTA_CHECK(offset <= size_ && bytes <= size_ - offset) << "Checkpoint " << path_ << " is truncated";
+  if (bytes == 0u)
+    return;
+  if (source_ != nullptr)
+    source_->read(offset, data, bytes);
+  else
+    std::memcpy(data, data_ + offset, bytes);
+}
+
+void CheckpointReader::parse_() {
+  char header[HEADER_BYTES];
+  NTA_CHECK(size_ >= HEADER_BYTES) << "Checkpoint: " << path_ << " is not a checkpoint file";
+  fetch_(0u, header, HEADER_BYTES);
+  NTA_CHECK(std::memcmp(header, MAGIC, sizeof(MAGIC)) == 0) << "Checkpoint: " << path_ << " is not a checkpoint file";
+  size_t pos = sizeof(MAGIC);
+  version_ = get<UInt32>(header, HEADER_BYTES, pos, path_);
+  NTA_CHECK(version_ >= 1u && version_ <= CheckpointWriter::VERSION)
+      << "Checkpoint " << path_ << ": unsupported version " << version_;
+  NTA_CHECK(get<UInt32>(header, HEADER_BYTES, pos, path_) == BYTE_ORDER_MARK)
+      << "Checkpoint " << path_ << " was written on a machine with a different byte order";
+  UInt64 tableOffset = get<UInt64>(header, HEADER_BYTES, pos, path_);
+  UInt64 numSections = get<UInt64>(header, HEADER_BYTES, pos, path_);
+  UInt64 tableEnd = size_;
+  if (version_ >= 2u) {
+    char trailer[TRAILER_BYTES];
+    NTA_CHECK(size_ >= HEADER_BYTES + TRAILER_BYTES) << "Checkpoint " << path_ << " is truncated";
+    tableEnd = size_ - TRAILER_BYTES;
+    fetch_(tableEnd, trailer, TRAILER_BYTES);
+    NTA_CHECK(std::memcmp(trailer + 2u * sizeof(UInt64), MAGIC, sizeof(MAGIC)) == 0)
+        << "Checkpoint " << path_ << " is truncated";
+    pos = 0u;
+    tableOffset = get<UInt64>(trailer, TRAILER_BYTES, pos, path_);
+    numSections = get<UInt64>(trailer, TRAILER_BYTES, pos, path_);
+  }
+  NTA_CHECK(tableOffset <= tableEnd) << "Checkpoint " << path_ << " is truncated";
+
+  std::string table(static_cast<size_t>(tableEnd - tableOffset), '\0');
+  fetch_(tableOffset, &table[0], table.size());
+  const char *data = table.data();
+  const size_t size = table.size();
+  pos = 0u;
+  for (UInt64 i = 0u; i < numSections; i++) {
+    const UInt64 offset = get<UInt64>(data, size, pos, path_);
+    const UInt64 bytes = get<UInt64>(data, size, pos, path_);
+    const UInt32 nameLength = get<UInt32>(data, size, pos, path_);
+    NTA_CHECK(pos + nameLength <= size && offset <= size_ && bytes <= size_ - offset)
+        << "Checkpoint " << path_ << " is truncated";
+    sections_[std::string(data + pos, nameLength)] = {offset, bytes};
+    pos += nameLength;
+  }
+}
+
+const std::pair<UInt64, UInt64> &CheckpointReader::find_(const std::string &name) const {
+  const auto it = sections_.find(name);
+  NTA_CHECK(it != sections_.end()) << "Checkpoint " << path_ << " has no section " << name;
+  return it->second;
+}
+
+std::pair<const char *, size_t> CheckpointReader::section(const std::string &name) const {
+  const auto &s = find_(name);
+  if (source_ == nullptr)
+    return {data_ + s.first, static_cast<size_t>(s.second)};
+  const std::lock_guard<std::mutex> lock(mutex_);
+  auto it = fetched_.find(name);
+  if (it == fetched_.end())
+    it = fetched_.emplace(name, readSection(name)).first;
+  return {it->second.data(), it->second.size()};
+}
+
+std::string CheckpointReader::readSection(const std::string &name) const {
+  const auto &s = find_(name);
+  std::string bytes(static_cast<size_t>(s.second), '\0');
+  fetch_(s.first, &bytes[0], bytes.size());
+  return bytes;
+}
+
+} // namespace htm
@@ -0,0 +1,340 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the CheckpointWriter and CheckpointReader classes, and the
+ * sinks and sources they write to and read from
+ */
+
+#ifndef HTM_UTIL_CHECKPOINT_HPP
+#define HTM_UTIL_CHECKPOINT_HPP
+
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <htm/os/MappedFile.hpp>
+#include <htm/types/Types.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+/**
+ * Where a CheckpointWriter puts the bytes of a checkpoint, strictly in order:
+ * a checkpoint is written in one pass, never seeked, so it can go straight
+ * to a pipe or an upload instead of a local file first.
+ */
+class CheckpointSink {
+public:
+  virtual ~CheckpointSink() = default;
+
+  /** Appends bytes. Called from one thread at a time. */
+  virtual void write(const char *data, size_t bytes) = 0;
+
+  /** After the last write(): flushes, completes the upload. Throws on errors. */
+  virtual void close() = 0;
+
+  /** Names the sink in error messages. */
+  virtual std::string describe() const = 0;
+};
+
+/** A local file, created or truncated. */
+class FileSink : public CheckpointSink {
+public:
+  explicit FileSink(const std::string &path);
+  void write(const char *data, size_t bytes) override;
+  void close() override;
+  std::string describe() const override { return path_; }
+
+private:
+  std::string path_;
+  std::ofstream out_;
+};
+
+/**
+ * A stdio stream, eg. a pipe of popen() into a compressor or an upload
+ * tool. close() flushes; the stream is the caller's to close.
+ */
+class StdioSink : public CheckpointSink {
+public:
+  explicit StdioSink(std::FILE *file, const std::string &name = "stream");
+  void write(const char *data, size_t bytes) override;
+  void close() override;
+  std::string describe() const override { return name_; }
+
+private:
+  std::FILE *file_;
+  std::string name_;
+};
+
+/**
+ * A streaming multipart upload, as object stores take large objects: the
+ * bytes are cut into parts of partBytes (the last one shorter), and each
+ * part is handed to "upload" as soon as it is full, on up to numThreads
+ * threads at once while the checkpoint is still being written. write()
+ * waits while numThreads parts are in flight, so at most numThreads + 1
+ * parts are in memory whatever the size of the checkpoint.
+ *
+ * close() uploads the last part, waits for all of them and then calls
+ * "complete" with the number of parts. An upload which throws fails the
+ * next write() or close().
+ *
+ * Example, with some client of an object store:
+ *     MultipartSink sink(
+ *         [&](size_t part, const char *data, size_t bytes) { client.uploadPart(id, part + 1, data, bytes); },
+ *         [&](size_t parts) { client.completeUpload(id, parts); });
+ *     net.saveToChunkedFile(sink);
+ */
+class MultipartSink : public CheckpointSink {
+public:
+  using Upload = std::function<void(size_t part, const char *data, size_t bytes)>;
+  using Complete = std::function<void(size_t numParts)>;
+
+  MultipartSink(const Upload &upload, const Complete &complete = nullptr,
+                size_t partBytes = 8u << 20u, size_t numThreads = 4u,
+                const std::string &name = "multipart upload");
+  ~MultipartSink() override; // waits for the uploads in flight, errors are lost
+  MultipartSink(const MultipartSink &) = delete;
+  MultipartSink &operator=(const MultipartSink &) = delete;
+
+  void write(const char *data, size_t bytes) override;
+  void close() override;
+  std::string describe() const override { return name_; }
+
+  size_t getNumParts() const noexcept { return numParts_; }
+
+private:
+  void flush_(); // hands the buffer to an upload thread
+  void wait_(size_t inFlight);
+
+  Upload upload_;
+  Complete complete_;
+  size_t partBytes_;
+  size_t numThreads_;
+  std::string name_;
+  std::string buffer_;
+  size_t numParts_ = 0u;
+  std::deque<std::future<void>> uploads_;
+  bool closed_ = false;
+};
+
+
+/**
+ * Random access to the bytes of a checkpoint, for a CheckpointReader which
+ * does not map a local file: it reads the header and section table, then
+ * each section only when it is asked for. Against object storage read() is
+ * a ranged GET, so a model restores straight from it, one section at a time.
+ */
+class CheckpointSource {
+public:
+  virtual ~CheckpointSource() = default;
+
+  virtual UInt64 size() const = 0;
+
+  /** Reads [offset, offset + bytes). Called from several threads at once. */
+  virtual void read(UInt64 offset, char *data, size_t bytes) const = 0;
+
+  virtual std::string describe() const = 0;
+};
+
+/** A local file, read with seeks instead of mapped. */
+class FileSource : public CheckpointSource {
+public:
+  explicit FileSource(const std::string &path);
+  UInt64 size() const override { return size_; }
+  void read(UInt64 offset, char *data, size_t bytes) const override;
+  std::string describe() const override { return path_; }
+
+private:
+  std::string path_;
+  mutable std::ifstream in_;
+  mutable std::mutex mutex_;
+  UInt64 size_ = 0u;
+};
+
+/** Ranged reads by a user function, eg. a GET with a Range header. */
+class RangeSource : public CheckpointSource {
+public:
+  using Read = std::function<void(UInt64 offset, char *data, size_t bytes)>;
+
+  RangeSource(const Read &read, UInt64 size, const std::string &name = "range source")
+      : read_(read), size_(size), name_(name) {}
+  UInt64 size() const override { return size_; }
+  void read(UInt64 offset, char *data, size_t bytes) const override { read_(offset, data, bytes); }
+  std::string describe() const override { return name_; }
+
+private:
+  Read read_;
+  UInt64 size_;
+  std::string name_;
+};
+
+
+/**
+ * Flat, versioned checkpoint file of a model: a set of named sections, each
+ * a raw array of plain values. Used by Connections, SpatialPooler and
+ * TemporalMemory saveCheckpoint() / loadCheckpoint().
+ *
+ * Layout (native byte order, which is checked on load):
+ *   header:   "HTMCKPT\0", UInt32 version, UInt32 byte order mark,
+ *             UInt64 0, UInt64 0 (version 1: the offset of the section
+ *             table and the number of sections)
+ *   sections: the raw bytes of each section, every one aligned to 64 bytes
+ *   table:    per section UInt64 offset, UInt64 bytes, UInt32 name length, name
+ *   trailer:  UInt64 offset of the section table, UInt64 number of sections,
+ *             "HTMCKPT\0" (since version 2, so the file is written in one
+ *             pass, see CheckpointSink)
+ *
+ * The reader maps the file into memory (read only, private) instead of
+ * parsing it, so a section is either used in place, see view(), or copied
+ * out with a single memcpy, see read(). Unlike the cereal formats there is
+ * no per element decoding, loading costs about the same as reading the file.
+ * A reader of a CheckpointSource fetches each section the first time it is
+ * used instead, or readSection() copies one out without keeping it.
+ */
+class CheckpointWriter {
+public:
+  static constexpr UInt32 VERSION = 2u;
+
+  /** Writes a file, through a FileSink. */
+  explicit CheckpointWriter(const std::string &path);
+  /** Writes to the sink, which must outlive the writer. close() closes it. */
+  explicit CheckpointWriter(CheckpointSink &sink);
+  ~CheckpointWriter(); // calls close(), errors are lost; call close() to see them
+  CheckpointWriter(const CheckpointWriter &) = delete;
+  CheckpointWriter &operator=(const CheckpointWriter &) = delete;
+
+  /** Appends a section. The names must be unique. */
+  void write(const std::string &name, const void *data, size_t bytes);
+
+  template <typename T, typename A> void write(const std::string &name, const std::vector<T, A> &values) {
+    static_assert(std::is_trivially_copyable<T>::value, "Checkpoint sections hold plain values");
+    write(name, values.data(), values.size() * sizeof(T));
+  }
+
+  /** Section of a single value. */
+  template <typename T> void writeValue(const std::string &name, const T &value) {
+    static_assert(std::is_trivially_copyable<T>::value, "Checkpoint sections hold plain values");
+    write(name, &value, sizeof(T));
+  }
+
+  /** Writes the section table and closes the sink. */
+  void close();
+
+  /**
+   * Stops after an error, without the section table and without closing the
+   * sink: what was written is not a checkpoint, and an upload not completed.
+   */
+  void abandon() noexcept { open_ = false; }
+
+private:
+  struct Entry {
+    std::string name;
+    UInt64 offset;
+    UInt64 bytes;
+  };
+  template <typename T> void put_(const T &value) {
+    sink_->write(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+  void start_();
+
+  std::unique_ptr<CheckpointSink> file_; // of the path constructor
+  CheckpointSink *sink_;
+  bool open_ = false;
+  UInt64 offset_ = 0u;
+  std::vector<Entry> entries_;
+};
+
+
+class CheckpointReader {
+public:
+  /** Maps the file. */
+  explicit CheckpointReader(const std::string &path);
+  /** Reads from the source, which must outlive the reader. */
+  explicit CheckpointReader(const CheckpointSource &source);
+  CheckpointReader(const CheckpointReader &) = delete;
+  CheckpointReader &operator=(const CheckpointReader &) = delete;
+
+  bool has(const std::string &name) const { return sections_.count(name) > 0u; }
+
+  /**
+   * @return start and size in bytes of a section, throws if it is missing.
+   * Of a source, the section is fetched once and kept with the reader.
+   */
+  std::pair<const char *, size_t> section(const std::string &name) const;
+
+  /** A copy of a section; of a source it is fetched and not kept. */
+  std::string readSection(const std::string &name) const;
+
+  /**
+   * Zero copy access to an array section. The pointer is valid as long as
+   * the reader.
+   */
+  template <typename T> std::pair<const T *, size_t> view(const std::string &name) const {
+    static_assert(std::is_trivially_copyable<T>::value, "Checkpoint sections hold plain values");
+    const auto s = section(name);
+    NTA_CHECK(s.second % sizeof(T) == 0u)
+        << "Checkpoint " << path_ << ": section " << name << " is not an array of " << sizeof(T) << " byte values";
+    return {reinterpret_cast<const T *>(s.first), s.second / sizeof(T)};
+  }
+
+  template <typename T, typename A> void read(const std::string &name, std::vector<T, A> &values) const {
+    const auto v = view<T>(name);
+    values.resize(v.second);
+    if (v.second > 0u)
+      std::memcpy(values.data(), v.first, v.second * sizeof(T));
+  }
+
+  template <typename T> T readValue(const std::string &name) const {
+    const auto v = view<T>(name);
+    NTA_CHECK(v.second == 1u) << "Checkpoint " << path_ << ": section " << name << " is not a single value";
+    T value;
+    std::memcpy(&value, v.first, sizeof(T));
+    return value;
+  }
+
+  UInt32 getVersion() const noexcept { return version_; }
+
+private:
+  void fetch_(UInt64 offset, char *data, size_t bytes) const;
+  void parse_();
+  const std::pair<UInt64, UInt64> &find_(const std::string &name) const;
+
+  std::string path_;
+  std::unique_ptr<MappedFile> file_;
+  const CheckpointSource *source_ = nullptr;
+  const char *data_ = nullptr;
+  UInt64 size_ = 0u;
+  UInt32 version_ = 0u;
+  std::map<std::string, std::pair<UInt64, UInt64>> sections_; // offset, bytes
+  mutable std::mutex mutex_;
+  mutable std::map<std::string, std::string> fetched_; // of a source
+};
+
+} // namespace htm
+
+#endif // HTM_UTIL_CHECKPOINT_HPP
@@ -0,0 +1,170 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the Compression class
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <htm/types/Types.hpp>
+#include <htm/utils/Compression.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+static const size_t MIN_MATCH = 4u;
+static const size_t MAX_OFFSET = 0xFFFFu;
+static const UInt32 HASH_BITS = 16u;
+
+static inline UInt32 read32(const char *p) {
+  UInt32 v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline UInt32 hash32(const UInt32 v) { return (v * 2654435761u) >> (32u - HASH_BITS); }
+
+static void putVarint(std::string &out, size_t v) {
+  while (v >= 0x80u) {
+    out.push_back(static_cast<char>((v & 0x7Fu) | 0x80u));
+    v >>= 7u;
+  }
+  out.push_back(static_cast<char>(v));
+}
+
+static size_t getVarint(const unsigned char *&p, const unsigned char *end) {
+  size_t v = 0u;
+  for (unsigned shift = 0u;; shift += 7u) {
+    NTA_CHECK(p < end && shift < 64u) << "Compression: corrupt data";
+    const unsigned char b = *p++;
+    v |= static_cast<size_t>(b & 0x7Fu) << shift;
+    if (b < 0x80u)
+      return v;
+  }
+}
+
+// lengths of 15 and more continue in bytes of 255 ... and a last one < 255
+static void putLength(std::string &out, size_t length) {
+  for (; length >= 255u; length -= 255u)
+    out.push_back(static_cast<char>(255));
+  out.push_back(static_cast<char>(length));
+}
+
+static size_t getLength(const unsigned char *&p, const unsigned char *end, size_t length) {
+  if (length < 15u)
+    return length;
+  unsigned char b;
+  do {
+    NTA_CHECK(p < end) << "Compression: corrupt data";
+    b = *p++;
+    length += b;
+  } while (b == 255u);
+  return length;
+}
+
+static void putSequence(std::string &out, const char *literals, size_t numLiterals, size_t offset, size_t matchLength) {
+  const size_t matchCode = matchLength == 0u ? 0u : matchLength - MIN_MATCH;
+  out.push_back(static_cast<char>((std::min<size_t>(numLiterals, 15u) << 4u) | std::min<size_t>(matchCode, 15u)));
+  if (numLiterals >= 15u)
+    putLength(out, numLiterals - 15u);
+  out.append(literals, numLiterals);
+  if (matchLength == 0u)
+    return; // the last sequence
+  out.push_back(static_cast<char>(offset & 0xFFu));
+  out.push_back(static_cast<char>(offset >> 8u));
+  if (matchCode >= 15u)
+    putLength(out, matchCode - 15u);
+}
+
+
+std::string Compression::compress(const char *data, size_t size) {
+  std::string out;
+  out.reserve(size / 2u + 16u);
+  out.push_back(1);
+  putVarint(out, size);
+
+  std::vector<Int32> table(size_t(1u) << HASH_BITS, -1);
+  size_t anchor = 0u;
+  size_t i = 0u;
+  while (i + MIN_MATCH <= size) {
+    const UInt32 v = read32(data + i);
+    Int32 &slot = table[hash32(v)];
+    const Int32 candidate = slot;
+    slot = static_cast<Int32>(i);
+    if (candidate < 0 || i - static_cast<size_t>(candidate) > MAX_OFFSET || read32(data + candidate) != v) {
+      i++;
+      continue;
+    }
+    size_t length = MIN_MATCH;
+    while (i + length < size && data[candidate + length] == data[i + length])
+      length++;
+    putSequence(out, data + anchor, i - anchor, i - static_cast<size_t>(candidate), length);
+    i += length;
+    anchor = i;
+  }
+  putSequence(out, data + anchor, size - anchor, 0u, 0u);
+
+  if (out.size() >= size) { // not worth it, store
+    out.clear();
+    out.push_back(0);
+    putVarint(out, size);
+    out.append(data, size);
+  }
+  return out;
+}
+
+
+std::string Compression::decompress(const char *data, size_t size) {
+  const unsigned char *p = reinterpret_cast<const unsigned char *>(data);
+  const unsigned char *end = p + size;
+  NTA_CHECK(p < end && *p <= 1u) << "Compression: corrupt data";
+  const bool compressed = *p++ == 1u;
+  const size_t rawSize = getVarint(p, end);
+  std::string out;
+  if (!compressed) {
+    NTA_CHECK(static_cast<size_t>(end - p) == rawSize) << "Compression: corrupt data";
+    out.assign(reinterpret_cast<const char *>(p), rawSize);
+    return out;
+  }
+
+  out.resize(rawSize);
+  size_t pos = 0u;
+  while (p < end) {
+    const unsigned token = *p++;
+    const size_t numLiterals = getLength(p, end, token >> 4u);
+    NTA_CHECK(numLiterals <= static_cast<size_t>(end - p) && numLiterals <= rawSize - pos) << "Compression: corrupt data";
+    std::memcpy(&out[pos], p, numLiterals);
+    p += numLiterals;
+    pos += numLiterals;
+    if (p == end)
+      break; // the last sequence has no match
+    NTA_CHECK(end - p >= 2) << "Compression: corrupt data";
+    const size_t offset = static_cast<size_t>(p[0]) | (static_cast<size_t>(p[1]) << 8u);
+    p += 2;
+    const size_t length = getLength(p, end, token & 15u) + MIN_MATCH;
+    NTA_CHECK(offset > 0u && offset <= pos && length <= rawSize - pos) << "Compression: corrupt data";
+    for (size_t k = 0u; k < length; k++, pos++) // may overlap
+      out[pos] = out[pos - offset];
+  }
+  NTA_CHECK(pos == rawSize) << "Compression: corrupt data";
+  return out;
+}
+
+} // namespace htm
@@ -0,0 +1,53 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the Compression class
+ */
+
+#ifndef HTM_UTIL_COMPRESSION_HPP
+#define HTM_UTIL_COMPRESSION_HPP
+
+#include <string>
+
+namespace htm {
+
+/**
+ * Fast byte compression for serialized state, a small LZ77 format in the
+ * spirit of LZ4: sequences of literals and back references into the
+ * previous 64 KiB, found with a hash of 4 bytes. It is meant to be cheap
+ * enough to run on each save (hundreds of MB/s), not to compress well;
+ * the zero filled and repetitive parts of the models (duty cycles,
+ * unused buffers, quantized permanences) are what it takes out.
+ *
+ * Layout: a byte 0 (stored) or 1 (compressed), the uncompressed size as a
+ * varint, then the bytes or the sequences. Data which does not get smaller
+ * is stored as is.
+ */
+class Compression {
+public:
+  static std::string compress(const char *data, size_t size);
+  static std::string compress(const std::string &data) { return compress(data.data(), data.size()); }
+
+  /** Throws if `data` is not the output of compress(). */
+  static std::string decompress(const char *data, size_t size);
+  static std::string decompress(const std::string &data) { return decompress(data.data(), data.size()); }
+};
+
+} // namespace htm
+
+#endif // HTM_UTIL_COMPRESSION_HPP
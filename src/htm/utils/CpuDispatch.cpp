@@ -0,0 +1,112 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the CpuDispatch class
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <mutex>
+
+#include <htm/os/Env.hpp>
+#include <htm/utils/CpuDispatch.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+static const std::pair<UInt32, const char *> FEATURE_NAMES[] = {
+    {CPU_POPCNT, "popcnt"},   {CPU_AVX2, "avx2"},         {CPU_BMI2, "bmi2"},
+    {CPU_AVX512F, "avx512f"}, {CPU_AVX512BW, "avx512bw"}, {CPU_AVX512VPOPCNTDQ, "avx512vpopcntdq"},
+    {CPU_NEON, "neon"}};
+
+static std::mutex registryMutex;
+static std::map<std::string, std::string> &registry() {
+  static std::map<std::string, std::string> variants;
+  return variants;
+}
+
+
+UInt32 CpuDispatch::detected() {
+  static const UInt32 mask = []() {
+    UInt32 found = 0u;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("popcnt"))          found |= CPU_POPCNT;
+    if (__builtin_cpu_supports("avx2"))            found |= CPU_AVX2;
+    if (__builtin_cpu_supports("bmi2"))            found |= CPU_BMI2;
+    if (__builtin_cpu_supports("avx512f"))         found |= CPU_AVX512F;
+    if (__builtin_cpu_supports("avx512bw"))        found |= CPU_AVX512BW;
+    if (__builtin_cpu_supports("avx512vpopcntdq")) found |= CPU_AVX512VPOPCNTDQ;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    found |= CPU_NEON; //part of every aarch64 CPU
+#endif
+    return found;
+  }();
+  return mask;
+}
+
+
+UInt32 CpuDispatch::cap(const UInt32 detected, const std::string &simd) {
+  std::string level = simd;
+  std::transform(level.begin(), level.end(), level.begin(), [](unsigned char c) { return std::tolower(c); });
+  if (level.empty() or level == "native") return detected;
+  if (level == "scalar") return 0u;
+  if (level == "popcnt") return detected & CPU_POPCNT;
+  if (level == "avx2")   return detected & (CPU_POPCNT | CPU_AVX2 | CPU_BMI2);
+  if (level == "avx512") return detected & ~UInt32(CPU_NEON);
+  NTA_THROW << "HTM_SIMD: unknown value '" << simd << "', expected scalar, popcnt, avx2, avx512 or native.";
+}
+
+
+UInt32 CpuDispatch::features() {
+  static const UInt32 mask = []() {
+    std::string simd;
+    Env::get("HTM_SIMD", simd);
+    const UInt32 capped = cap(detected(), simd);
+    if (capped != detected()) {
+      NTA_INFO << "HTM_SIMD=" << simd << ": using [" << toString(capped) << "] of [" << toString(detected()) << "]";
+    }
+    return capped;
+  }();
+  return mask;
+}
+
+
+std::string CpuDispatch::toString(const UInt32 mask) {
+  std::string names;
+  for (const auto &feature : FEATURE_NAMES) {
+    if ((mask & feature.first) == 0u) continue;
+    if (not names.empty()) names += " ";
+    names += feature.second;
+  }
+  return names;
+}
+
+
+void CpuDispatch::report(const std::string &family, const std::string &variant) {
+  const std::lock_guard<std::mutex> lock(registryMutex);
+  registry()[family] = variant;
+}
+
+
+std::map<std::string, std::string> CpuDispatch::chosenVariants() {
+  const std::lock_guard<std::mutex> lock(registryMutex);
+  return registry();
+}
+
+} // namespace htm
@@ -0,0 +1,115 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the CpuDispatch class
+ */
+
+#ifndef HTM_UTIL_CPU_DISPATCH_HPP
+#define HTM_UTIL_CPU_DISPATCH_HPP
+
+#include <initializer_list>
+#include <map>
+#include <string>
+
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * The instruction sets a kernel variant may need, as bits of a mask.
+ */
+enum CpuFeature : UInt32 {
+  CPU_POPCNT          = 1u << 0,
+  CPU_AVX2            = 1u << 1,
+  CPU_BMI2            = 1u << 2,
+  CPU_AVX512F         = 1u << 3,
+  CPU_AVX512BW        = 1u << 4,
+  CPU_AVX512VPOPCNTDQ = 1u << 5,
+  CPU_NEON            = 1u << 6,
+};
+
+/**
+ * Runtime selection of the SIMD kernels, so that one binary runs on mixed
+ * hardware without -march=native.
+ *
+ * The features of the CPU are detected once, at the first use. Each kernel
+ * family binds a function pointer once, to the first of its variants whose
+ * features are all present, and the last variant (scalar) needs none:
+ *
+ *     using CountFn = UInt (*)(const UInt64*, const UInt64*, size_t);
+ *     static const CountFn count = CpuDispatch::bind<CountFn>("sdr.countAnd", {
+ *         {"popcnt", CPU_POPCNT, countAndPopcnt_},
+ *         {"scalar", 0u,         countAndScalar_}});
+ *
+ * The environment variable HTM_SIMD caps the features, for benchmarks and to
+ * rule out a kernel: "scalar" (none), "popcnt", "avx2" (with bmi2),
+ * "avx512" or "native" (default, all detected). It is read once, before the
+ * first kernel is bound.
+ */
+class CpuDispatch {
+public:
+  template <typename Fn> struct Variant {
+    const char *name;
+    UInt32      features; //mask of CpuFeature
+    Fn          fn;
+  };
+
+  /** The features in use: detected, capped by HTM_SIMD. */
+  static UInt32 features();
+
+  /** The features of the CPU, without HTM_SIMD. */
+  static UInt32 detected();
+
+  /** All of the mask in features()? */
+  static bool has(UInt32 mask) { return (features() & mask) == mask; }
+
+  /**
+   * @returns the detected features capped by an HTM_SIMD value, see above.
+   * Throws on an unknown value.
+   */
+  static UInt32 cap(UInt32 detected, const std::string &simd);
+
+  /** The names of the features in the mask, eg. "popcnt avx2 bmi2". */
+  static std::string toString(UInt32 mask);
+
+  /**
+   * The first variant whose features are present, recorded in
+   * chosenVariants() under `family`.
+   */
+  template <typename Fn>
+  static Fn bind(const char *family, std::initializer_list<Variant<Fn>> variants) {
+    for (const auto &variant : variants) {
+      if (has(variant.features)) {
+        report(family, variant.name);
+        return variant.fn;
+      }
+    }
+    report(family, "none");
+    return nullptr;
+  }
+
+  /** Record the variant of a family which binds without bind(). */
+  static void report(const std::string &family, const std::string &variant);
+
+  /** The variant of each family bound so far (families bind at their first use). */
+  static std::map<std::string, std::string> chosenVariants();
+};
+
+} // namespace htm
+
+#endif // HTM_UTIL_CPU_DISPATCH_HPP
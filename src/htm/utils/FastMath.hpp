@@ -0,0 +1,138 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Approximations of exp, log and softmax for the hot loops of the algorithms.
+ *
+ * They are branch free and inline, so that the loops calling them vectorize,
+ * which std::exp and std::log calls prevent.  The algorithms keep a switch to
+ * the exact <cmath> functions, for reproducing results of older versions:
+ * SpatialPooler::setFastBoosting(), Classifier::setFastSoftmax().
+ */
+
+#ifndef HTM_UTIL_FAST_MATH_HPP
+#define HTM_UTIL_FAST_MATH_HPP
+
+#include <algorithm> // min, max, max_element
+#include <cstddef>
+#include <cstring> // memcpy
+
+#include <htm/types/Types.hpp>
+
+namespace htm {
+namespace fastmath {
+
+/**
+ * exp(x) computed as 2^n * e^g, with n integer, g in [-ln(2)/2, ln(2)/2] and
+ * a polynomial for e^g.  The relative error is below 5e-7 for x in [-87, 88],
+ * outside the result is clipped.
+ */
+inline Real32 exp(const Real32 x) {
+  const Real32 clipped = std::min(std::max(x, -87.0f), 88.0f);
+  constexpr Real32 roundMagic = 12582912.0f; //1.5 * 2^23, rounds to the nearest integer
+  const Real32 n = (clipped * 1.44269504088896341f + roundMagic) - roundMagic; //log2(e)
+  // ln(2) split in two, so that g is exact for large n (Cody & Waite)
+  const Real32 g = (clipped - n * 0.693359375f) + n * 2.12194440e-4f;
+  const Real32 p = 1.0f + g * (1.0f + g * (0.5f + g * (1.0f / 6 + g * (1.0f / 24 + g * (1.0f / 120 + g * (1.0f / 720))))));
+  Int32 bits;
+  std::memcpy(&bits, &p, sizeof(bits));
+  bits += static_cast<Int32>(n) * (1 << 23); //multiply by 2^n in the exponent
+  Real32 result;
+  std::memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+/**
+ * exp(x) in double precision, as exp() above with the degree 11 Taylor
+ * polynomial.  The relative error is below 1e-14 for x in [-700, 709],
+ * outside the result is clipped.
+ */
+inline Real64 exp(const Real64 x) {
+  const Real64 clipped = std::min(std::max(x, -700.0), 709.0);
+  constexpr Real64 roundMagic = 6755399441055744.0; //1.5 * 2^52
+  const Real64 n = (clipped * 1.4426950408889634 + roundMagic) - roundMagic;
+  // ln(2) split in two, so that g is exact for large n (Cody & Waite)
+  const Real64 g = (clipped - n * 0.693145751953125) - n * 1.42860682030941723212e-6;
+  Real64 p = 1.0 / 39916800; //1 / 11!
+  p = p * g + 1.0 / 3628800;
+  p = p * g + 1.0 / 362880;
+  p = p * g + 1.0 / 40320;
+  p = p * g + 1.0 / 5040;
+  p = p * g + 1.0 / 720;
+  p = p * g + 1.0 / 120;
+  p = p * g + 1.0 / 24;
+  p = p * g + 1.0 / 6;
+  p = p * g + 0.5;
+  p = p * g + 1.0;
+  p = p * g + 1.0;
+  Int64 bits;
+  std::memcpy(&bits, &p, sizeof(bits));
+  bits += static_cast<Int64>(n) * (static_cast<Int64>(1) << 52);
+  Real64 result;
+  std::memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+/**
+ * log(x) computed as e * ln(2) + log(m), x = m * 2^e with m in
+ * [sqrt(1/2), sqrt(2)), and the atanh series for log(m).  The absolute error
+ * is below 3e-7 plus the rounding of the result to float, for x >= 1.2e-38
+ * (the smallest normal float); smaller x,
+ * also 0, give log(1.2e-38) = -87.3 instead of -inf.  Undefined for
+ * negative x, infinity and NaN.
+ */
+inline Real32 log(const Real32 x) {
+  const Real32 clipped = std::max(x, 1.17549435e-38f);
+  Int32 bits;
+  std::memcpy(&bits, &clipped, sizeof(bits));
+  constexpr Int32 sqrtHalf = 0x3f3504f3; //the bits of sqrt(1/2)
+  bits -= sqrtHalf;
+  const Int32 e = bits >> 23; //arithmetic shift, the exponent of m
+  bits = (bits & 0x007fffff) + sqrtHalf;
+  Real32 m;
+  std::memcpy(&m, &bits, sizeof(m));
+  const Real32 s  = (m - 1.0f) / (m + 1.0f); //|s| < 0.172
+  const Real32 s2 = s * s;
+  const Real32 logM = 2.0f * s * (1.0f + s2 * (1.0f / 3 + s2 * (1.0f / 5 + s2 * (1.0f / 7 + s2 * (1.0f / 9)))));
+  const Real32 n = static_cast<Real32>(e);
+  return n * 0.693359375f + (logM - n * 2.12194440e-4f); //ln(2) split as in exp()
+}
+
+/**
+ * In place softmax of [begin, end), with exp() above.  The probabilities
+ * differ from the exact ones by less than 1e-14, relative.
+ */
+inline void softmax(Real64 *begin, Real64 *end) {
+  if (begin == end) return;
+  const Real64 maxVal = *std::max_element(begin, end);
+  for (Real64 *itr = begin; itr != end; ++itr) {
+    *itr = exp(*itr - maxVal);
+  }
+  Real64 sum = 0.0; //a loop of its own, the ordered sum does not vectorize
+  for (const Real64 *itr = begin; itr != end; ++itr) {
+    sum += *itr;
+  }
+  const Real64 scale = 1.0 / sum;
+  for (Real64 *itr = begin; itr != end; ++itr) {
+    *itr *= scale;
+  }
+}
+
+} // namespace fastmath
+} // namespace htm
+
+#endif // HTM_UTIL_FAST_MATH_HPP
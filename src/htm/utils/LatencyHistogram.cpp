@@ -0,0 +1,135 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the LatencyHistogram class
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+
+#include <htm/utils/LatencyHistogram.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+static const UInt SUB_BITS = 4u;              // 16 buckets per power of two
+static const UInt64 SUB_COUNT = 1u << SUB_BITS;
+static const size_t NUM_BUCKETS = (64u - SUB_BITS + 1u) * SUB_COUNT;
+static const Real64 TO_SECONDS = 1.0e-9;
+
+static UInt log2Floor(UInt64 v) {
+  UInt r = 0u;
+  while (v >>= 1u) r++;
+  return r;
+}
+
+// Values below SUB_COUNT have a bucket each, above that a power of two
+// 2^e is split in SUB_COUNT buckets by the bits following the leading one.
+static size_t bucketOf(const UInt64 v) {
+  if (v < SUB_COUNT)
+    return static_cast<size_t>(v);
+  const UInt e = log2Floor(v);
+  const UInt64 sub = (v >> (e - SUB_BITS)) & (SUB_COUNT - 1u);
+  return static_cast<size_t>((e - SUB_BITS + 1u) * SUB_COUNT + sub);
+}
+
+static UInt64 bucketUpperBound(const size_t i) {
+  if (i < SUB_COUNT)
+    return i;
+  const UInt e = static_cast<UInt>(i / SUB_COUNT) + SUB_BITS - 1u;
+  const UInt64 sub = i % SUB_COUNT;
+  const UInt64 lower = (SUB_COUNT + sub) << (e - SUB_BITS);
+  return lower + ((UInt64(1u) << (e - SUB_BITS)) - 1u);
+}
+
+
+UInt64 LatencyHistogram::now() {
+  return static_cast<UInt64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void LatencyHistogram::record(const UInt64 nanoseconds) {
+  if (buckets_.empty())
+    buckets_.assign(NUM_BUCKETS, 0u);
+  buckets_[bucketOf(nanoseconds)]++;
+  if (count_ == 0u || nanoseconds < min_)
+    min_ = nanoseconds;
+  if (nanoseconds > max_)
+    max_ = nanoseconds;
+  sum_ += nanoseconds;
+  count_++;
+}
+
+void LatencyHistogram::reset() {
+  buckets_.clear();
+  count_ = sum_ = min_ = max_ = 0u;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other) {
+  if (other.count_ == 0u)
+    return;
+  if (buckets_.empty())
+    buckets_.assign(NUM_BUCKETS, 0u);
+  for (size_t i = 0u; i < NUM_BUCKETS; i++)
+    buckets_[i] += other.buckets_[i];
+  if (count_ == 0u || other.min_ < min_)
+    min_ = other.min_;
+  max_ = std::max(max_, other.max_);
+  sum_ += other.sum_;
+  count_ += other.count_;
+}
+
+Real64 LatencyHistogram::getMean() const {
+  return count_ == 0u ? 0.0 : static_cast<Real64>(sum_) / static_cast<Real64>(count_) * TO_SECONDS;
+}
+
+Real64 LatencyHistogram::getMin() const { return static_cast<Real64>(min_) * TO_SECONDS; }
+
+Real64 LatencyHistogram::getMax() const { return static_cast<Real64>(max_) * TO_SECONDS; }
+
+Real64 LatencyHistogram::getPercentile(const Real64 percent) const {
+  NTA_CHECK(percent >= 0.0 && percent <= 100.0) << "Percentile must be in [0, 100], got " << percent;
+  if (count_ == 0u)
+    return 0.0;
+  const UInt64 rank = static_cast<UInt64>(std::ceil(percent / 100.0 * static_cast<Real64>(count_)));
+  if (rank <= 1u) // the smallest and the largest record are known exactly
+    return getMin();
+  if (rank >= count_)
+    return getMax();
+  UInt64 seen = 0u;
+  for (size_t i = 0u; i < buckets_.size(); i++) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      const UInt64 upper = std::min(std::max(bucketUpperBound(i), min_), max_);
+      return static_cast<Real64>(upper) * TO_SECONDS;
+    }
+  }
+  return getMax();
+}
+
+std::string LatencyHistogram::toJSON() const {
+  std::stringstream ss;
+  ss << "{\"count\": " << count_ << ", \"mean\": " << getMean() << ", \"min\": " << getMin()
+     << ", \"p50\": " << getPercentile(50.0) << ", \"p90\": " << getPercentile(90.0)
+     << ", \"p99\": " << getPercentile(99.0) << ", \"max\": " << getMax() << "}";
+  return ss.str();
+}
+
+} // namespace htm
@@ -0,0 +1,97 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the LatencyHistogram class
+ */
+
+#ifndef HTM_UTIL_LATENCY_HISTOGRAM_HPP
+#define HTM_UTIL_LATENCY_HISTOGRAM_HPP
+
+#include <string>
+#include <vector>
+
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * Histogram of durations, for tail latencies (p50, p99, max) of hot paths.
+ *
+ * The buckets are logarithmic: each power of two is split into 16 buckets,
+ * so a percentile is off by at most 1/16 (6.25%) of its value. Count, mean,
+ * min and max are exact. record() is O(1) and does not allocate after the
+ * first call; an unused histogram holds no buckets.
+ *
+ * Example:
+ *     const UInt64 t0 = LatencyHistogram::now();
+ *     doSomething();
+ *     hist.record(LatencyHistogram::now() - t0);
+ *     hist.getPercentile(99.0); // seconds
+ */
+class LatencyHistogram {
+public:
+  /**
+   * @return a steady clock time stamp, in nanoseconds.
+   */
+  static UInt64 now();
+
+  /**
+   * Add one duration, in nanoseconds.
+   */
+  void record(UInt64 nanoseconds);
+
+  void reset();
+
+  /**
+   * Adds all the records of another histogram, eg. of one per thread.
+   */
+  void merge(const LatencyHistogram &other);
+
+  UInt64 getCount() const noexcept { return count_; }
+
+  /**
+   * Durations in seconds, 0 when empty.
+   */
+  Real64 getMean() const;
+  Real64 getMin() const;
+  Real64 getMax() const;
+
+  /**
+   * @param percent - in [0, 100].
+   * @return the duration in seconds which percent of the records do not
+   *   exceed, rounded up to the upper end of its bucket but within
+   *   [min, max], or 0 when empty.
+   */
+  Real64 getPercentile(Real64 percent) const;
+
+  /**
+   * @return {"count": n, "mean": s, "min": s, "p50": s, "p90": s, "p99": s, "max": s}
+   */
+  std::string toJSON() const;
+
+private:
+  std::vector<UInt64> buckets_;
+  UInt64 count_ = 0u;
+  UInt64 sum_ = 0u;
+  UInt64 min_ = 0u;
+  UInt64 max_ = 0u;
+};
+
+} // namespace htm
+
+#endif // HTM_UTIL_LATENCY_HISTOGRAM_HPP
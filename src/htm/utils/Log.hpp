@@ -24,7 +24,16 @@
 #define NTA_LOG2_HPP
 
 #include <iostream>
+#include <type_traits>
 #include <htm/types/Exception.hpp>
+#include <htm/utils/Logger.hpp>
+
+// Log statements above this level are compiled out, whatever NTA_LOG_LEVEL
+// says: 2 (Normal) removes all NTA_DEBUG from the hot paths. Set with the
+// CMake option HTM_LOG_MIN_LEVEL.
+#ifndef NTA_LOG_MIN_LEVEL
+#define NTA_LOG_MIN_LEVEL 3
+#endif
 
 namespace htm {
 enum class LogLevel { LogLevel_None = 0, LogLevel_Minimal=1, LogLevel_Normal=2, LogLevel_Verbose=3 };
@@ -33,31 +42,34 @@ extern thread_local LogLevel NTA_LOG_LEVEL;
 
 //this code intentionally uses "if() dosomething" instead of "if() { dosomething }" 
 // as the macro expects another "<< "my clever message";
-// so it eventually becomes: `if() std::cout << "DEBUG:\t" << "users message";`
+// so it eventually becomes: `if() LogMessage("DEBUG", ...) << "users message";`
+// The arguments are captured and written as one line by the Logger (see
+// Logger.hpp), at the end of the statement or on its background thread.
 //
 //Expected usage: 
 //<your class>:
 //Network::setLogLevel(LogLevel::LogLevel_Verbose);
 //NTA_WARN << "Hello World!" << std::endl; //shows
 //NTA_DEBUG << "more details how cool this is"; //not showing under "Normal" log level
-//NTA_ERR << "You'll always see this, HAHA!";
 //NTA_THROW << "crashing for a good cause";
 
-#define NTA_DEBUG                                                \
-  if (NTA_LOG_LEVEL >= LogLevel::LogLevel_Verbose)               \
-    std::cout << "DEBUG:\t" << Path::getBasename(__FILE__) << ":" << __LINE__ << ": " 
+// The file name of __FILE__, without its directories, at compile time.
+#define NTA_FILE_NAME \
+  (&__FILE__[std::integral_constant<size_t, htm::logBasenameOffset(__FILE__)>::value])
+
+#define NTA_LOG_(level, name)                                                  \
+  if (static_cast<int>(level) <= NTA_LOG_MIN_LEVEL && htm::NTA_LOG_LEVEL >= level) \
+    htm::LogMessage(name, NTA_FILE_NAME, __LINE__)
+
+#define NTA_DEBUG NTA_LOG_(htm::LogLevel::LogLevel_Verbose, "DEBUG")
 
 // For informational messages that report status but do not indicate that
 // anything is wrong
-#define NTA_INFO                                                               \
-  if (NTA_LOG_LEVEL >= LogLevel::LogLevel_Normal)                              \
-  std::cout << "INFO:\t" << Path::getBasename(__FILE__) << ":" << __LINE__ << ": "
+#define NTA_INFO NTA_LOG_(htm::LogLevel::LogLevel_Normal, "INFO")
 
 // For messages that indicate a recoverable error or something else that it may
 // be important for the end user to know about.
-#define NTA_WARN                                                               \
-  if (NTA_LOG_LEVEL >= LogLevel::LogLevel_Normal)                              \
-  std::cout << "WARN:\t" << Path::getBasename(__FILE__) << ":" << __LINE__ << ": "
+#define NTA_WARN NTA_LOG_(htm::LogLevel::LogLevel_Normal, "WARN")
 
 // To throw an exception and make sure the exception message is logged
 // appropriately
@@ -0,0 +1,270 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the Logger and LogMessage classes
+ */
+
+#include <htm/utils/Logger.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <htm/utils/SpscQueue.hpp>
+
+namespace htm {
+
+namespace {
+
+struct Record {
+  const char *level = nullptr;
+  const char *file = nullptr;
+  int line = 0;
+  std::string args;  // keeps its capacity in the queue's slot
+};
+
+Record emptyRecord() {
+  Record record;
+  record.args.reserve(256u);
+  return record;
+}
+
+/** The queue of one thread which logs, the background thread consumes it. */
+struct ThreadQueue {
+  explicit ThreadQueue(size_t capacity) : queue(capacity, emptyRecord()) {}
+  SpscQueue<Record> queue;
+  std::atomic<bool> closed{false};  // the thread exited
+};
+
+class State {
+public:
+  ~State() { setAsync(false, 0u); }
+
+  void setOutput(std::ostream &out) {
+    std::lock_guard<std::mutex> lock(outMutex_);
+    out_ = &out;
+  }
+
+  void setAsync(const bool enable, const size_t capacity) {
+    std::lock_guard<std::mutex> lock(controlMutex_);
+    if (enable) {
+      capacity_.store(std::max<size_t>(capacity, 1u));
+      if (thread_.joinable()) return;
+      stop_ = false;
+      async_.store(true);
+      thread_ = std::thread([this]() { run_(); });
+    } else {
+      async_.store(false);
+      if (thread_.joinable()) {
+        {
+          std::lock_guard<std::mutex> wake(wakeMutex_);
+          stop_ = true;
+        }
+        wakeUp_.notify_one();
+        thread_.join();
+      }
+      drain_();
+    }
+  }
+
+  bool isAsync() const { return async_.load(std::memory_order_relaxed); }
+
+  void flush() {
+    drain_();
+    std::lock_guard<std::mutex> lock(outMutex_);
+    out_->flush();
+  }
+
+  void submit(const char *level, const char *file, const int line, const std::string &args) {
+    if (!isAsync()) {
+      std::lock_guard<std::mutex> lock(outMutex_);
+      write_(level, file, line, args);
+      return;
+    }
+    ThreadQueue &queue = threadQueue_();
+    Record *record;
+    while ((record = queue.queue.back()) == nullptr) {  // full, wait for the background thread
+      full_.store(true);
+      wakeUp_.notify_one();
+      std::this_thread::yield();
+    }
+    record->level = level;
+    record->file = file;
+    record->line = line;
+    record->args.assign(args);
+    queue.queue.push();
+  }
+
+private:
+  /** The queue of the calling thread, registered on its first message. */
+  ThreadQueue &threadQueue_() {
+    struct Owner {
+      std::shared_ptr<ThreadQueue> queue;
+      ~Owner() { if (queue) queue->closed.store(true); }
+    };
+    thread_local Owner owner;
+    if (!owner.queue) {
+      owner.queue = std::make_shared<ThreadQueue>(capacity_.load());
+      std::lock_guard<std::mutex> lock(queuesMutex_);
+      queues_.push_back(owner.queue);
+    }
+    return *owner.queue;
+  }
+
+  void run_() {
+    std::unique_lock<std::mutex> lock(wakeMutex_);
+    while (!stop_) {
+      lock.unlock();
+      drain_();
+      lock.lock();
+      wakeUp_.wait_for(lock, std::chrono::milliseconds(10), [this]() { return stop_ || full_.exchange(false); });
+    }
+  }
+
+  /** Writes the queued messages, and forgets the queues of exited threads. */
+  void drain_() {
+    std::lock_guard<std::mutex> consume(consumeMutex_);  // one consumer per queue at a time
+    std::vector<std::shared_ptr<ThreadQueue>> queues;
+    {
+      std::lock_guard<std::mutex> lock(queuesMutex_);
+      queues = queues_;
+    }
+    bool wrote = false;
+    for (const auto &queue : queues) {
+      while (Record *record = queue->queue.front()) {
+        std::lock_guard<std::mutex> lock(outMutex_);
+        write_(record->level, record->file, record->line, record->args);
+        queue->queue.pop();
+        wrote = true;
+      }
+    }
+    if (wrote) {
+      std::lock_guard<std::mutex> lock(outMutex_);
+      out_->flush();
+    }
+    std::lock_guard<std::mutex> lock(queuesMutex_);
+    queues_.erase(std::remove_if(queues_.begin(), queues_.end(),
+                                 [](const std::shared_ptr<ThreadQueue> &q) { return q->closed.load() && q->queue.empty(); }),
+                  queues_.end());
+  }
+
+  /** One line "LEVEL:\tfile:line: message", call with outMutex_ locked. */
+  void write_(const char *level, const char *file, const int line, const std::string &args) {
+    line_.str(std::string());
+    line_.clear();
+    line_.copyfmt(defaultFormat_);
+    line_ << level << ":\t" << file << ":" << line << ": ";
+    LogMessage::format(line_, args);
+    std::string text = line_.str();
+    if (text.empty() || text.back() != '\n') text.push_back('\n');
+    *out_ << text;
+  }
+
+  std::ostream *out_ = &std::cout;
+  std::ostringstream line_;            // reused by write_()
+  const std::ostringstream defaultFormat_;
+  std::mutex outMutex_;
+
+  std::atomic<bool> async_{false};
+  std::atomic<size_t> capacity_{1024u};
+  std::mutex controlMutex_;            // setAsync()
+  std::thread thread_;
+  std::mutex wakeMutex_;
+  std::condition_variable wakeUp_;
+  bool stop_ = false;
+  std::atomic<bool> full_{false};      // a thread waits for space in its queue
+
+  std::mutex queuesMutex_;
+  std::vector<std::shared_ptr<ThreadQueue>> queues_;
+  std::mutex consumeMutex_;
+};
+
+State &state() {
+  static State instance;
+  return instance;
+}
+
+thread_local std::string threadArgs;  // the arguments of the thread's current message
+thread_local bool threadArgsInUse = false;
+
+} // namespace
+
+
+void Logger::setOutput(std::ostream &out) { state().setOutput(out); }
+void Logger::setAsync(const bool enable, const size_t queueCapacity) { state().setAsync(enable, queueCapacity); }
+bool Logger::isAsync() { return state().isAsync(); }
+void Logger::flush() { state().flush(); }
+
+void Logger::submit(const char *level, const char *file, const int line, const std::string &args) {
+  state().submit(level, file, line, args);
+}
+
+
+LogMessage::LogMessage(const char *level, const char *file, const int line)
+    : level_(level), file_(file), line_(line) {
+  if (threadArgsInUse) {  // a message formatted while formatting another one
+    args_ = &own_;
+  } else {
+    threadArgsInUse = true;
+    args_ = &threadArgs;
+    args_->clear();
+  }
+}
+
+LogMessage::~LogMessage() {
+  try {
+    Logger::submit(level_, file_, line_, *args_);
+  } catch (...) {
+    // a log message is not worth terminating for
+  }
+  if (args_ == &threadArgs) threadArgsInUse = false;
+}
+
+
+void LogMessage::append(const Format format, const void *data, const size_t size) {
+  args_->append(reinterpret_cast<const char *>(&format), sizeof(Format));
+  args_->append(reinterpret_cast<const char *>(&size), sizeof(size_t));
+  args_->append(static_cast<const char *>(data), size);
+}
+
+
+void LogMessage::format(std::ostream &out, const std::string &args) {
+  size_t at = 0u;
+  while (at + sizeof(Format) + sizeof(size_t) <= args.size()) {
+    Format format;
+    size_t size;
+    std::memcpy(&format, args.data() + at, sizeof(Format));
+    std::memcpy(&size, args.data() + at + sizeof(Format), sizeof(size_t));
+    at += sizeof(Format) + sizeof(size_t);
+    format(out, args.data() + at, size);
+    at += size;
+  }
+}
+
+
+void LogMessage::formatString(std::ostream &out, const char *data, const size_t size) {
+  out.write(data, static_cast<std::streamsize>(size));
+}
+
+} // namespace htm
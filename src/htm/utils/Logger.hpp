@@ -0,0 +1,162 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the Logger and LogMessage classes, the backend of the
+ * NTA_DEBUG, NTA_INFO and NTA_WARN macros in Log.hpp
+ */
+
+#ifndef HTM_UTIL_LOGGER_HPP
+#define HTM_UTIL_LOGGER_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <iomanip>
+#include <ios>
+#include <iosfwd>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+namespace htm {
+
+/** Offset of the file name in a path, so that the macros resolve it at compile time. */
+constexpr size_t logBasenameOffset(const char *path) {
+  size_t offset = 0u;
+  for (size_t i = 0u; path[i] != '\0'; i++) {
+    if (path[i] == '/' || path[i] == '\\') offset = i + 1u;
+  }
+  return offset;
+}
+
+
+/**
+ * Where the messages of the NTA_* macros go.
+ *
+ * By default each message is formatted and written to std::cout at the end
+ * of its statement, under a lock.  With setAsync(true) the statement only
+ * appends the message to a lock-free queue of its thread, and a background
+ * thread formats and writes the messages of all threads.  Every message is
+ * one line.
+ */
+class Logger {
+public:
+  /** The stream to write to, default std::cout.  It must outlive its use. */
+  static void setOutput(std::ostream &out);
+
+  /**
+   * Turn the background thread on or off.  Turning it off writes the
+   * queued messages first.  A thread which logs faster than the
+   * background thread writes waits when its queue is full.
+   *
+   * @param queueCapacity - messages per thread, for the threads which log
+   *                        for the first time after this call.
+   */
+  static void setAsync(bool enable, size_t queueCapacity = 1024u);
+  static bool isAsync();
+
+  /** Write the messages queued so far, of all threads. */
+  static void flush();
+
+  /** Called by ~LogMessage: a message and its captured arguments, see LogMessage. */
+  static void submit(const char *level, const char *file, int line, const std::string &args);
+};
+
+
+/**
+ * One message of the NTA_* macros, submitted to the Logger at the end of
+ * the statement.  Instead of formatting on the calling thread it captures
+ * the arguments, to be formatted when written:
+ *  - numbers, enums and the stream manipulators (std::setw(), std::endl,
+ *    ...) are copied and formatted later,
+ *  - strings (std::string, char pointers) are copied,
+ *  - anything else (an Array, an SDR, ...) is formatted at once, since it
+ *    may change before the message is written.
+ */
+class LogMessage {
+public:
+  /** Formats a captured argument of "size" bytes at "data". */
+  using Format = void (*)(std::ostream &out, const char *data, size_t size);
+
+  LogMessage(const char *level, const char *file, int line);
+  ~LogMessage();
+  LogMessage(const LogMessage &) = delete;
+  LogMessage &operator=(const LogMessage &) = delete;
+
+  template <class T> LogMessage &operator<<(const T &value) {
+    using V = typename std::decay<T>::type;
+    if constexpr (std::is_same<V, char *>::value || std::is_same<V, const char *>::value) {
+      if constexpr (std::is_array<T>::value) appendString(value);
+      else appendString(value == nullptr ? "(null)" : value);
+    } else if constexpr (std::is_same<V, std::string>::value) {
+      appendString(value);
+    } else if constexpr (std::is_arithmetic<V>::value || std::is_enum<V>::value || isIomanip_<V>()) {
+      append(&formatValue<V>, &value, sizeof(V));
+    } else {
+      std::ostringstream text;
+      text << value;
+      appendString(text.str());
+    }
+    return *this;
+  }
+
+  // std::endl, std::hex, ... are overloaded names, T could not be deduced.
+  LogMessage &operator<<(std::ostream &(*manipulator)(std::ostream &)) { return capture_(manipulator); }
+  LogMessage &operator<<(std::ios_base &(*manipulator)(std::ios_base &)) { return capture_(manipulator); }
+
+  /** Writes the captured arguments to out. */
+  static void format(std::ostream &out, const std::string &args);
+
+private:
+  // The results of the <iomanip> functions, which hold only their argument.
+  // Other trivially copyable types, such as std::string_view, may point to
+  // data which changes before the message is written.
+  template <class V> static constexpr bool isIomanip_() {
+    return std::is_same<V, decltype(std::setw(0))>::value ||
+           std::is_same<V, decltype(std::setprecision(0))>::value ||
+           std::is_same<V, decltype(std::setbase(0))>::value ||
+           std::is_same<V, decltype(std::setfill(' '))>::value ||
+           std::is_same<V, decltype(std::setiosflags(std::ios_base::fmtflags()))>::value ||
+           std::is_same<V, decltype(std::resetiosflags(std::ios_base::fmtflags()))>::value;
+  }
+
+  template <class T> static void formatValue(std::ostream &out, const char *data, size_t) {
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type value;
+    std::memcpy(&value, data, sizeof(T));
+    out << *reinterpret_cast<const T *>(&value);
+  }
+  static void formatString(std::ostream &out, const char *data, size_t size);
+
+  template <class T> LogMessage &capture_(const T &value) {
+    append(&formatValue<T>, &value, sizeof(T));
+    return *this;
+  }
+
+  void appendString(const char *s) { append(&formatString, s, std::strlen(s)); }
+  void appendString(const std::string &s) { append(&formatString, s.data(), s.size()); }
+  void append(Format format, const void *data, size_t size);
+
+  const char *level_;
+  const char *file_;
+  int line_;
+  std::string *args_;   // a buffer of the thread, or own_ when nested
+  std::string own_;
+};
+
+} // namespace htm
+
+#endif // HTM_UTIL_LOGGER_HPP
@@ -0,0 +1,154 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the MemoryResource classes
+ */
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <htm/utils/MemoryResource.hpp>
+
+namespace htm {
+
+static const size_t SMALL_PAGE = 4096u;
+static const size_t HUGE_PAGE  = 2u << 20u; // 2 MiB
+
+namespace {
+
+class NewDeleteResource : public MemoryResource {
+public:
+  void *allocate(const size_t bytes, const size_t alignment) override {
+    if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+      return ::operator new(bytes, std::align_val_t(alignment));
+    return ::operator new(bytes);
+  }
+  void deallocate(void *p, const size_t, const size_t alignment) noexcept override {
+    if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+      ::operator delete(p, std::align_val_t(alignment));
+    else
+      ::operator delete(p);
+  }
+};
+
+#if defined(__linux__) && defined(SYS_mbind)
+// Prefer the pages of [p, p + size) on `node`, by the mbind() syscall (no
+// libnuma): MPOL_PREFERRED falls back to other nodes when this one is full.
+bool preferNode(void *p, size_t size, int node) {
+  const int MPOL_PREFERRED_ = 1;
+  const unsigned long BITS = 8u * sizeof(unsigned long);
+  if (node < 0 || static_cast<unsigned long>(node) >= 64u * BITS) return false;
+  unsigned long mask[64] = {0u};
+  mask[node / BITS] = 1ul << (node % BITS);
+  return syscall(SYS_mbind, p, size, MPOL_PREFERRED_, mask, 64u * BITS, 0u) == 0;
+}
+#endif
+
+size_t pageSize(const size_t bytes, const bool hugePages) {
+  return hugePages && bytes >= HUGE_PAGE ? HUGE_PAGE : SMALL_PAGE;
+}
+
+} // namespace
+
+
+MemoryResource *MemoryResource::defaultResource() noexcept {
+  static NewDeleteResource instance;
+  return &instance;
+}
+
+
+bool pagesSupported() noexcept {
+#if defined(__linux__)
+  return true;
+#else
+  return false;
+#endif
+}
+
+PageMapping mapPages(const size_t bytes, const bool hugePages, const int numaNode) {
+  PageMapping pages;
+#if defined(__linux__)
+  const size_t page = pageSize(bytes, hugePages);
+  const size_t size = (bytes + page - 1u) / page * page;
+  void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) return pages;
+  pages.data = static_cast<char *>(p);
+  pages.size = size;
+#if defined(MADV_HUGEPAGE)
+  if (page == HUGE_PAGE)
+    pages.hugePages = madvise(p, size, MADV_HUGEPAGE) == 0;
+#endif
+#if defined(SYS_mbind)
+  if (numaNode >= 0) // before the first touch
+    pages.numaBound = preferNode(p, size, numaNode);
+#endif
+#else
+  (void)bytes;
+  (void)hugePages;
+  (void)numaNode;
+#endif
+  return pages;
+}
+
+void unmapPages(void *data, const size_t size) noexcept {
+#if defined(__linux__)
+  if (data != nullptr) munmap(data, size);
+#else
+  (void)data;
+  (void)size;
+#endif
+}
+
+
+PageResource::PageResource(const bool hugePages, const int numaNode, const size_t minMappedBytes)
+    : useHugePages_(hugePages), numaNode_(numaNode), minMappedBytes_(minMappedBytes) {}
+
+bool PageResource::isMapped_(const size_t bytes, const size_t alignment) const noexcept {
+  return pagesSupported() && bytes >= minMappedBytes_ && alignment <= SMALL_PAGE;
+}
+
+size_t PageResource::mappedSize_(const size_t bytes) const noexcept {
+  const size_t page = pageSize(bytes, useHugePages_);
+  return (bytes + page - 1u) / page * page;
+}
+
+void *PageResource::allocate(const size_t bytes, const size_t alignment) {
+  if (!isMapped_(bytes, alignment))
+    return defaultResource()->allocate(bytes, alignment);
+  const PageMapping pages = mapPages(bytes, useHugePages_, numaNode_);
+  if (pages.data == nullptr) throw std::bad_alloc();
+  mappedBytes_ += pages.size;
+  if (pages.hugePages) hugePages_.store(true, std::memory_order_relaxed);
+  if (pages.numaBound) numaBound_.store(true, std::memory_order_relaxed);
+  return pages.data;
+}
+
+void PageResource::deallocate(void *p, const size_t bytes, const size_t alignment) noexcept {
+  if (!isMapped_(bytes, alignment)) {
+    defaultResource()->deallocate(p, bytes, alignment);
+    return;
+  }
+  const size_t size = mappedSize_(bytes);
+  unmapPages(p, size);
+  mappedBytes_ -= size;
+}
+
+} // namespace htm
@@ -0,0 +1,181 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the MemoryResource classes and the ResourceAllocator
+ */
+
+#ifndef HTM_UTIL_MEMORY_RESOURCE_HPP
+#define HTM_UTIL_MEMORY_RESOURCE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace htm {
+
+/**
+ * Where the large arrays of a model (e.g. the synapses of a Connections)
+ * get their memory, see Connections::setMemoryResource().
+ *
+ * This is the interface of std::pmr::memory_resource, which is not in all
+ * standard libraries the project supports.  Implementations must be thread
+ * safe.
+ */
+class MemoryResource {
+public:
+  virtual ~MemoryResource() = default;
+
+  /** @return memory of `bytes` aligned to `alignment`, throws std::bad_alloc. */
+  virtual void *allocate(size_t bytes, size_t alignment) = 0;
+
+  /** Releases memory of allocate(bytes, alignment). */
+  virtual void deallocate(void *p, size_t bytes, size_t alignment) noexcept = 0;
+
+  /** Can either release the memory of the other? */
+  virtual bool isEqual(const MemoryResource &other) const noexcept { return this == &other; }
+
+  /** operator new and delete, the resource of all containers by default. */
+  static MemoryResource *defaultResource() noexcept;
+};
+
+
+/**
+ * Anonymous pages from the system, see mapPages().
+ */
+struct PageMapping {
+  char  *data      = nullptr;
+  size_t size      = 0u;      // rounded up to the page size
+  bool   hugePages = false;   // madvise(MADV_HUGEPAGE) succeeded
+  bool   numaBound = false;   // the pages prefer numaNode
+};
+
+/** Are mapPages() supported on this system (Linux)? */
+bool pagesSupported() noexcept;
+
+/**
+ * Map `bytes` of anonymous pages, rounded up to 4 KiB, or to 2 MiB with
+ * hugePages for 2 MiB and more, which are then backed by transparent huge
+ * pages where the system offers them.  With numaNode >= 0 the pages prefer
+ * that node (mbind, best effort; before the first touch).
+ *
+ * @return the mapping, data is null where not supported or on failure.
+ */
+PageMapping mapPages(size_t bytes, bool hugePages, int numaNode);
+
+/** Release a mapping of mapPages(), of its data and size. */
+void unmapPages(void *data, size_t size) noexcept;
+
+
+/**
+ * Large allocations (minMappedBytes and more) are pages of their own, see
+ * mapPages(): on transparent huge pages, and/or on a NUMA node.  Smaller
+ * allocations come from operator new.  Where pages are not supported, all
+ * allocations come from operator new.
+ *
+ * A 2 GB model on 4 KiB pages needs half a million TLB entries, on huge
+ * pages a thousand.
+ */
+class PageResource : public MemoryResource {
+public:
+  /**
+   * @param hugePages - back the allocations of 2 MiB and more by huge pages.
+   * @param numaNode - the NUMA node of the pages, -1 for any.
+   * @param minMappedBytes - smaller allocations come from operator new.
+   */
+  explicit PageResource(bool hugePages = true, int numaNode = -1, size_t minMappedBytes = 64u << 10u);
+
+  void *allocate(size_t bytes, size_t alignment) override;
+  void deallocate(void *p, size_t bytes, size_t alignment) noexcept override;
+
+  size_t getMappedBytes() const noexcept { return mappedBytes_.load(std::memory_order_relaxed); } // currently
+  bool hasHugePages() const noexcept { return hugePages_.load(std::memory_order_relaxed); } // any mapping so far
+  bool isNumaBound() const noexcept { return numaBound_.load(std::memory_order_relaxed); }    // any mapping so far
+  int getNumaNode() const noexcept { return numaNode_; }
+
+private:
+  bool isMapped_(size_t bytes, size_t alignment) const noexcept;
+  size_t mappedSize_(size_t bytes) const noexcept;
+
+  const bool   useHugePages_;
+  const int    numaNode_;
+  const size_t minMappedBytes_;
+  std::atomic<size_t> mappedBytes_{0u};
+  std::atomic<bool>   hugePages_{false};
+  std::atomic<bool>   numaBound_{false};
+};
+
+/** Large allocations on transparent huge pages. */
+class HugePageResource : public PageResource {
+public:
+  HugePageResource() : PageResource(true, -1) {}
+};
+
+/** Large allocations on the pages of one NUMA node, see ThreadPool::numNumaNodes(). */
+class NumaResource : public PageResource {
+public:
+  explicit NumaResource(int numaNode, bool hugePages = true) : PageResource(hugePages, numaNode) {}
+};
+
+
+/**
+ * A standard allocator of a MemoryResource, like std::pmr::polymorphic_allocator.
+ * A container keeps its resource when assigned or swapped; copies of a
+ * container use the same resource.
+ */
+template <class T> class ResourceAllocator {
+public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::false_type;
+  using propagate_on_container_move_assignment = std::false_type;
+  using propagate_on_container_swap            = std::false_type;
+  using is_always_equal                        = std::false_type;
+
+  ResourceAllocator() noexcept : resource_(MemoryResource::defaultResource()) {}
+  ResourceAllocator(MemoryResource *resource) noexcept // implicit, as std::pmr
+      : resource_(resource != nullptr ? resource : MemoryResource::defaultResource()) {}
+  template <class U>
+  ResourceAllocator(const ResourceAllocator<U> &other) noexcept : resource_(other.resource()) {}
+
+  T *allocate(const size_t n) {
+    if (n > std::numeric_limits<size_t>::max() / sizeof(T)) throw std::bad_array_new_length();
+    return static_cast<T *>(resource_->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T *p, const size_t n) noexcept { resource_->deallocate(p, n * sizeof(T), alignof(T)); }
+
+  MemoryResource *resource() const noexcept { return resource_; }
+
+  template <class U> bool operator==(const ResourceAllocator<U> &other) const noexcept {
+    return resource_ == other.resource() or resource_->isEqual(*other.resource());
+  }
+  template <class U> bool operator!=(const ResourceAllocator<U> &other) const noexcept {
+    return not operator==(other);
+  }
+
+private:
+  MemoryResource *resource_;
+};
+
+/** A std::vector of a MemoryResource. */
+template <class T> using ResourceVector = std::vector<T, ResourceAllocator<T>>;
+
+} // namespace htm
+
+#endif // HTM_UTIL_MEMORY_RESOURCE_HPP
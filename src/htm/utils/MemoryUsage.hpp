@@ -0,0 +1,97 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Byte accounting of the models, see memoryUsage() of Connections,
+ * SpatialPooler, TemporalMemory, Network, ...
+ */
+
+#ifndef HTM_UTIL_MEMORY_USAGE_HPP
+#define HTM_UTIL_MEMORY_USAGE_HPP
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace htm {
+
+/**
+ * Bytes of heap memory held by an object, by category, e.g. {"synapses": ..,
+ * "segments": ..}.
+ *
+ * These are estimates from the sizes of the containers: vectors count their
+ * capacity, hash maps their buckets and nodes. The overhead of the allocator
+ * and the object itself (sizeof) are not included.
+ */
+using MemoryUsage = std::map<std::string, size_t>;
+
+namespace memory {
+
+  template<typename T, typename A>
+  size_t bytes(const std::vector<T, A> &v) { return v.capacity() * sizeof(T); }
+
+  template<typename A>
+  size_t bytes(const std::vector<bool, A> &v) { return v.capacity() / 8u; }
+
+  /** The vector and the vectors in it. */
+  template<typename T, typename A, typename B>
+  size_t bytes(const std::vector<std::vector<T, A>, B> &v) {
+    size_t sum = v.capacity() * sizeof(std::vector<T, A>);
+    for(const auto &inner : v) sum += bytes(inner);
+    return sum;
+  }
+
+  /** The bucket array, and a node with the next pointer and the hash per element. */
+  template<typename K, typename V, typename H, typename E, typename A>
+  size_t bytes(const std::unordered_map<K, V, H, E, A> &m) {
+    return m.bucket_count() * sizeof(void *) +
+           m.size() * (sizeof(std::pair<const K, V>) + sizeof(void *) + sizeof(size_t));
+  }
+
+  /** The hash map and the vectors in it. */
+  template<typename K, typename T, typename H, typename E, typename A>
+  size_t bytes(const std::unordered_map<K, std::vector<T>, H, E, A> &m) {
+    size_t sum = m.bucket_count() * sizeof(void *) +
+                 m.size() * (sizeof(std::pair<const K, std::vector<T>>) + sizeof(void *) + sizeof(size_t));
+    for(const auto &entry : m) sum += bytes(entry.second);
+    return sum;
+  }
+
+  /** A node with the parent, child pointers and the color per element. */
+  template<typename K, typename V, typename C, typename A>
+  size_t bytes(const std::map<K, V, C, A> &m) {
+    return m.size() * (sizeof(std::pair<const K, V>) + 4u * sizeof(void *));
+  }
+
+  /** Sum of all categories. */
+  inline size_t total(const MemoryUsage &usage) {
+    size_t sum = 0u;
+    for(const auto &category : usage) sum += category.second;
+    return sum;
+  }
+
+  /** Adds the categories of `part` to `usage`, as "<prefix><category>". */
+  inline void add(MemoryUsage &usage, const std::string &prefix, const MemoryUsage &part) {
+    for(const auto &category : part) usage[prefix + category.first] += category.second;
+  }
+
+} // namespace memory
+} // namespace htm
+
+#endif // HTM_UTIL_MEMORY_USAGE_HPP
@@ -42,6 +42,9 @@ public:
 
   inline Real getTotal() const { return total_; }
 
+  /** Bytes of the window. */
+  size_t memoryUsage() const { return slidingWindow_.memoryUsage(); }
+
   inline bool operator==(const MovingAverage& r2) const {
     return (slidingWindow_ == r2.slidingWindow_ &&
           total_ == r2.total_);
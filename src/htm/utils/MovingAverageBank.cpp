@@ -0,0 +1,106 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the MovingAverageBank
+ */
+
+#include <cmath> // isnan
+
+#include <htm/utils/MovingAverageBank.hpp>
+#include <htm/utils/Log.hpp>
+
+using namespace std;
+
+namespace htm {
+
+MovingAverageBank::MovingAverageBank(UInt numStreams, UInt windowSize)
+  { initialize(numStreams, windowSize); }
+
+
+void MovingAverageBank::initialize(UInt numStreams, UInt windowSize) {
+  NTA_CHECK(numStreams > 0u);
+  NTA_CHECK(windowSize > 0u);
+  numStreams_ = numStreams;
+  windowSize_ = windowSize;
+  size_       = 0u;
+  idxNext_    = 0u;
+  window_.assign(static_cast<size_t>(windowSize_) * numStreams_, 0.0f);
+  total_.assign(numStreams_, 0.0f);
+}
+
+
+void MovingAverageBank::compute(const vector<Real> &values, vector<Real> &averages) {
+  NTA_CHECK(values.size() == numStreams_)
+    << "MovingAverageBank: expected " << numStreams_ << " values, got " << values.size();
+  averages.resize(numStreams_);
+  const size_t n = numStreams_;
+
+  // The slot being overwritten still holds zeros until the window is full,
+  // so subtracting it unconditionally keeps the loop free of branches.
+  if (size_ < windowSize_) size_++;
+  const Real size = static_cast<Real>(size_);
+  Real *slot = window_.data() + static_cast<size_t>(idxNext_) * n;
+  Real *totals = total_.data();
+  Real *out = averages.data();
+  const Real *in = values.data();
+  for (size_t i = 0u; i < n; i++) {
+    NTA_ASSERT(not std::isnan(in[i]));
+    const Real total = totals[i] - slot[i] + in[i];
+    slot[i]   = in[i];
+    totals[i] = total;
+    out[i]    = total / size;
+  }
+  idxNext_ = (idxNext_ + 1u) % windowSize_;
+}
+
+
+Real MovingAverageBank::getCurrentAvg(UInt stream) const {
+  NTA_ASSERT(stream < numStreams_);
+  if (size_ == 0u) {
+    return 0.0f; //avoid division by zero/nan!
+  }
+  return total_[stream] / static_cast<Real>(size_);
+}
+
+
+Real MovingAverageBank::getTotal(UInt stream) const {
+  NTA_ASSERT(stream < numStreams_);
+  return total_[stream];
+}
+
+
+vector<Real> MovingAverageBank::getData(UInt stream) const {
+  NTA_ASSERT(stream < numStreams_);
+  vector<Real> data(size_);
+  for (UInt s = 0u; s < size_; s++) {
+    data[s] = window_[static_cast<size_t>(s) * numStreams_ + stream];
+  }
+  return data;
+}
+
+
+bool MovingAverageBank::operator==(const MovingAverageBank &o) const {
+  return numStreams_ == o.numStreams_ and
+         windowSize_ == o.windowSize_ and
+         size_ == o.size_ and
+         idxNext_ == o.idxNext_ and
+         window_ == o.window_ and
+         total_ == o.total_;
+}
+
+} // namespace htm
@@ -0,0 +1,119 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the MovingAverageBank
+ */
+
+#ifndef HTM_UTIL_MOVING_AVERAGE_BANK_HPP
+#define HTM_UTIL_MOVING_AVERAGE_BANK_HPP
+
+#include <vector>
+
+#include <htm/types/Serializable.hpp>
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * Moving averages of many series at once.
+ *
+ * Equivalent to one MovingAverage per stream, all of them updated in the
+ * same iteration. Because the streams advance in lockstep, the window
+ * position is shared and the windows are stored as one 2-D ring: window
+ * slot s of all streams is one contiguous row. compute() is a single
+ * branch-free pass over that row and the totals, which the compiler
+ * vectorizes, instead of a loop over separately allocated objects.
+ *
+ * Example usage:
+ *
+ *     MovingAverageBank bank(numMetrics, 10);
+ *     vector<Real> averages;
+ *     while(true) {
+ *       <read the current value of each metric into values>
+ *       bank.compute(values, averages);
+ *     }
+ */
+class MovingAverageBank : public Serializable {
+public:
+  MovingAverageBank() {}
+
+  /**
+   * @param numStreams - number of independent series.
+   * @param windowSize - number of values in each moving average.
+   */
+  MovingAverageBank(UInt numStreams, UInt windowSize);
+
+  void initialize(UInt numStreams, UInt windowSize);
+
+  /**
+   * Same as MovingAverage::compute(), for each stream.
+   *
+   * @param values - the new value of each stream, numStreams long.
+   * @param averages - output, the current average of each stream.
+   */
+  void compute(const std::vector<Real> &values, std::vector<Real> &averages);
+
+  /** Same as MovingAverage::getCurrentAvg() of the given stream. */
+  Real getCurrentAvg(UInt stream) const;
+
+  /** Same as MovingAverage::getTotal() of the given stream. */
+  Real getTotal(UInt stream) const;
+
+  /** Same as MovingAverage::getData() of the given stream: the window in ring order. */
+  std::vector<Real> getData(UInt stream) const;
+
+  UInt getNumStreams() const { return numStreams_; }
+  UInt getWindowSize() const { return windowSize_; }
+  /** Number of values currently in each window. */
+  UInt size() const { return size_; }
+
+  CerealAdapter;
+  template<class Archive>
+  void save_ar(Archive & ar) const {
+    ar(CEREAL_NVP(numStreams_),
+       CEREAL_NVP(windowSize_),
+       CEREAL_NVP(size_),
+       CEREAL_NVP(idxNext_),
+       CEREAL_NVP(window_),
+       CEREAL_NVP(total_));
+  }
+  template<class Archive>
+  void load_ar(Archive & ar) {
+    ar(CEREAL_NVP(numStreams_),
+       CEREAL_NVP(windowSize_),
+       CEREAL_NVP(size_),
+       CEREAL_NVP(idxNext_),
+       CEREAL_NVP(window_),
+       CEREAL_NVP(total_));
+  }
+
+  bool operator==(const MovingAverageBank &o) const;
+  inline bool operator!=(const MovingAverageBank &o) const { return not (*this == o); }
+
+private:
+  UInt numStreams_ = 0u;
+  UInt windowSize_ = 0u;
+  UInt size_ = 0u;    // the same for all streams
+  UInt idxNext_ = 0u; // slot of the next value, the same for all streams
+
+  std::vector<Real> window_; // [slot * numStreams_ + stream]
+  std::vector<Real> total_;  // [stream]
+};
+
+} // namespace htm
+#endif // HTM_UTIL_MOVING_AVERAGE_BANK_HPP
@@ -26,12 +26,13 @@ using namespace htm;
 bool Random::operator==(const Random &o) const {
   return seed_ == o.seed_ && \
 	 steps_ == o.steps_ && \
-	 gen == o.gen;
+	 engine_ == o.engine_ && \
+	 (engine_ == COUNTER || gen == o.gen);
 }
 
 std::random_device rd; //HW RNG, undeterministic, platform dependant. Use only for seeding rng if random seed wanted (seed=0)
 
-Random::Random(const UInt64 seed) {
+Random::Random(const UInt64 seed, const Engine engine) : engine_(engine) {
   if (seed == 0) {
     std::mt19937 static_gen(rd());
     seed_ = static_gen(); //generate random value from HW RNG
@@ -39,10 +40,31 @@ Random::Random(const UInt64 seed) {
     seed_ = seed;
   }
   NTA_CHECK(seed_ != 0) << "Random: if seed is zero at this point, there is a logic error";
-  gen.seed(static_cast<unsigned int>(seed_)); //seed the generator
+  if (engine_ == MT19937)
+    gen.seed(static_cast<unsigned int>(seed_)); //seed the generator
   steps_ = 0;
 }
 
+void Random::seek(const UInt64 steps) {
+  if (engine_ == COUNTER) {
+    steps_ = steps;
+    return;
+  }
+  NTA_CHECK(steps >= steps_) << "Random::seek: the MT19937 engine can not go back "
+                             << steps_ - steps << " steps";
+  gen.discard(steps - steps_); //advance n steps
+  steps_ = steps;
+}
+
+Random Random::split(const UInt64 stream) const {
+  // A different hash than the streams' numbers; seed 0 would self-seed.
+  UInt64 z = (seed_ ^ 0x6A09E667F3BCC909ull) + (stream + 1u) * 0xD1B54A32D192ED03ull;
+  z = (z ^ (z >> 33u)) * 0xFF51AFD7ED558CCDull;
+  z = (z ^ (z >> 33u)) * 0xC4CEB9FE1A85EC53ull;
+  z ^= z >> 33u;
+  return Random(z == 0u ? 1u : z, COUNTER);
+}
+
 namespace htm {
 // helper function for seeding RNGs across the plugin barrier
 UInt32 GetRandomSeed(const UInt seed) {
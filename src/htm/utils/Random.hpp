@@ -66,31 +66,65 @@ namespace htm {
  * such as the ones used in release mode, simply change this definition and
  * recompile.
  *
- * @TODO Make extend random engine type.
- * @TODO Add ability to specify different rng algorithms.
+ * There are two engines, both with the same 32 bit output range:
+ * - MT19937 (default): std::mt19937. Restoring or seek() replays all the
+ *   draws made so far, O(steps).
+ * - COUNTER: the n-th number is a hash (the SplitMix64 finalizer) of the
+ *   seed and n, so the whole state is (seed, steps), seek() is O(1) and
+ *   split() creates cheap independent streams, ie. one per thread.
  */
 class Random : public Serializable  {
 public:
-  Random(const UInt64 seed = 0);
+  enum Engine { MT19937 = 0, COUNTER = 1 };
+
+  Random(const UInt64 seed = 0, const Engine engine = MT19937);
 
 
   // Serialization
   CerealAdapter;
   template<class Archive>
   void save_ar(Archive & ar) const {
+    const UInt32 engine = engine_;
     ar( CEREAL_NVP(seed_),
-        CEREAL_NVP(steps_)
+        CEREAL_NVP(steps_),
+        CEREAL_NVP(engine)
     );  
   }
   template<class Archive>
   void load_ar(Archive & ar) {
+    UInt32 engine;
+    UInt64 steps;
     ar( CEREAL_NVP(seed_), 
-	CEREAL_NVP(steps_)
+	cereal::make_nvp("steps_", steps),
+        CEREAL_NVP(engine)
     );  
-    gen.seed(static_cast<UInt32>(seed_)); //reseed
-    gen.discard(steps_); //advance n steps
+    NTA_CHECK(engine <= COUNTER) << "Random: unknown engine " << engine;
+    engine_ = static_cast<Engine>(engine);
+    if (engine_ == MT19937)
+      gen.seed(static_cast<UInt32>(seed_)); //reseed
+    steps_ = 0;
+    seek(steps);
   }
 
+  Engine getEngine() const { return engine_; }
+
+  /**
+   * Number of random numbers drawn since seeding.
+   */
+  UInt64 getSteps() const { return steps_; }
+
+  /**
+   * Continue as if exactly steps numbers had been drawn since seeding.
+   * O(1) for the COUNTER engine; MT19937 can only move forward, one draw at a time.
+   */
+  void seek(const UInt64 steps);
+
+  /**
+   * @return an independent COUNTER stream, determined by this generator's seed
+   *   and stream alone, so the same on every run and platform.
+   */
+  Random split(const UInt64 stream) const;
+
   bool operator==(const Random &other) const;
   inline bool operator!=(const Random &other) const {
     return !operator==(other);
@@ -101,16 +135,14 @@ public:
    */
   inline UInt32 getUInt32(const UInt32 max = MAX32) {
     NTA_ASSERT(max > 0);
-    steps_++;
-    return gen() % max; //uniform_int_distribution(gen) replaced, as is not same on all platforms! 
+    return next_() % max; //uniform_int_distribution(gen) replaced, as is not same on all platforms! 
   }
 
   /** return a double uniformly distributed on [0,1.0)
    * May not be cross-platform (but currently is to our experience)
    */
   inline Real64 getReal64() {
-    steps_++;
-    return gen() / static_cast<Real64>(max());
+    return next_() / static_cast<Real64>(max());
   }
 
   // populate choices with a random selection of nChoices elements from
@@ -129,6 +161,36 @@ public:
     return pop;
   }
 
+  /**
+   * Partial Fisher-Yates shuffle: moves a uniform random selection of
+   * nChoices elements of [first, last), in random order, to its front.
+   * O(nChoices) and in place; draws exactly nChoices random numbers, so it is
+   * as platform independent as shuffle(). The selection differs from
+   * sample(), which shuffles the whole population.
+   * @return first + nChoices, the end of the selection.
+   */
+  template<class RandomIt>
+  RandomIt sampleInPlace(RandomIt first, RandomIt last, UInt nChoices) {
+    const auto n = last - first;
+    NTA_CHECK(static_cast<decltype(n)>(nChoices) <= n) << "population size must be greater than number of choices";
+    for (UInt i = 0; i < nChoices; ++i) {
+      const UInt remaining = static_cast<UInt>(n) - i;
+      std::swap(first[i], first[i + this->getUInt32(remaining)]);
+    }
+    return first + nChoices;
+  }
+
+  /**
+   * Like sample(population, nChoices), but with sampleInPlace() on a copy
+   * in choices, which reuses its capacity: no allocation once it is large
+   * enough and O(nChoices) random numbers instead of O(population).
+   */
+  template <class T>
+  void sample(const std::vector<T>& population, UInt nChoices, std::vector<T>& choices) {
+    choices.assign(population.begin(), population.end());
+    choices.erase(sampleInPlace(choices.begin(), choices.end(), nChoices), choices.end());
+  }
+
 
   /**
    * return random from range [from, to)
@@ -170,7 +232,23 @@ private:
   UInt64 seed_;
   UInt64 steps_ = 0;  //step counter, used in serialization. It is important that steps_ is in sync with number of 
   // calls to RNG
+  Engine engine_ = MT19937;
   std::mt19937 gen; //Standard mersenne_twister_engine 64bit seeded with seed_
+
+  static UInt32 counterAt_(const UInt64 seed, const UInt64 n) {
+    UInt64 z = seed + (n + 1u) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30u)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27u)) * 0x94D049BB133111EBull;
+    return static_cast<UInt32>((z ^ (z >> 31u)) >> 32u);
+  }
+
+  inline UInt32 next_() {
+    const UInt64 n = steps_++;
+    if (engine_ == COUNTER)
+      return counterAt_(seed_, n);
+    return static_cast<UInt32>(gen());
+  }
+
 //  std::random_device rd; //HW random for random seed cases, undeterministic -> problems with op= and copy-constructor, therefore disabled
 
   // our reimpementation of std::shuffle, 
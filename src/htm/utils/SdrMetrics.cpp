@@ -134,15 +134,51 @@ ActivationFrequency::ActivationFrequency( const SDR &dataSource,
     { initialize( dataSource.size, initialValue ); }
 
 void ActivationFrequency::initialize( UInt size, Real initialValue ) {
+    updatedAt_.assign( size, 0u );
     if( initialValue == -1 ) {
+        // The first sample has a weight of 1, which erases this value.
         activationFrequency_.assign( size, 1234.567f );
         alwaysExponential_ = false;
+        sum_ = 0.0;
     }
     else {
         NTA_CHECK( initialValue >= 0.0f );
         NTA_CHECK( initialValue <= 1.0f );
         activationFrequency_.assign( size, initialValue );
         alwaysExponential_ = true;
+        sum_ = static_cast<Real64>( initialValue ) * size;
+    }
+}
+
+Real64 ActivationFrequency::decay_( UInt from, UInt to ) const {
+    const Real expDecay = 1.0f - 1.0f / period;
+    if( alwaysExponential_ )
+        return std::pow( static_cast<Real64>( expDecay ), to - from );
+    // Sample s has a weight of 1/s until the period is reached, and the
+    // product of (1 - 1/s) over (from, to] is from / to.
+    Real64 factor = 1.0;
+    if( from < period ) {
+        factor = static_cast<Real64>( from ) / std::min( to, period );
+        from   = period;
+    }
+    if( to > from )
+        factor *= std::pow( static_cast<Real64>( expDecay ), to - from );
+    return factor;
+}
+
+Real ActivationFrequency::frequency_( size_t bit ) const {
+    const UInt at = updatedAt_[bit];
+    if( at == samples_ )
+        return activationFrequency_[bit];
+    // A product of two floats is exact in double, so a single step rounds
+    // the same as multiplying in Real.
+    return static_cast<Real>( activationFrequency_[bit] * decay_( at, samples_ ));
+}
+
+void ActivationFrequency::synchronize_() const {
+    for( size_t bit = 0u; bit < activationFrequency_.size(); bit++ ) {
+        activationFrequency_[bit] = frequency_( bit );
+        updatedAt_[bit] = samples_;
     }
 }
 
@@ -152,30 +188,28 @@ void ActivationFrequency::callback(const SDR &dataSource, Real alpha)
         alpha = 1.0f / period;
     }
 
-    const auto decay = 1.0f - alpha;
-    for(auto &value : activationFrequency_)
-        value *= decay;
-
     const auto &sparse = dataSource.getSparse();
-    for(const auto &idx : sparse)
-        activationFrequency_[idx] += alpha;
+    sum_ = sum_ * decay_( samples_ - 1u, samples_ ) + static_cast<Real64>( alpha ) * sparse.size();
+    for(const auto &idx : sparse) {
+        activationFrequency_[idx] = frequency_( idx ) + alpha;
+        updatedAt_[idx] = samples_;
+    }
 }
 
 Real ActivationFrequency::min() const {
-    return *std::min_element(activationFrequency_.begin(),
-                             activationFrequency_.end());
+    const auto &frequencies = activationFrequency.vector();
+    return *std::min_element(frequencies.begin(), frequencies.end());
 }
 
 Real ActivationFrequency::max() const {
-    return *std::max_element(activationFrequency_.begin(),
-                             activationFrequency_.end());
+    const auto &frequencies = activationFrequency.vector();
+    return *std::max_element(frequencies.begin(), frequencies.end());
 }
 
 Real ActivationFrequency::mean() const  {
-    const auto sum = std::accumulate( activationFrequency_.begin(),
-                                      activationFrequency_.end(),
-                                      0.0f);
-    return (Real) sum / activationFrequency_.size();
+    if( samples_ == 0u and not alwaysExponential_ )
+        return 1234.567f; // not yet initialized, as before any data
+    return static_cast<Real>( sum_ / activationFrequency_.size() );
 }
 
 Real ActivationFrequency::std() const {
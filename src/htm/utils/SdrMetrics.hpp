@@ -164,6 +164,11 @@ private:
  * Activation frequencies are Real numbers in the range [0, 1], where zero
  * indicates never active, and one indicates always active.
  *
+ * Adding an SDR costs O(active bits): each bit remembers the sample at which
+ * it was last updated, and its pending decay is applied when it activates
+ * again or when it is read.  The mean is kept up to date; min, max, std and
+ * entropy visit every bit when they are called.
+ *
  * Example Usage:
  *      SDR A( 2 )
  *      ActivationFrequency B( A, 1000 )
@@ -211,7 +216,37 @@ public:
     ActivationFrequency( const std::vector<UInt> &dimensions, UInt period,
                          Real initialValue = -1 );
 
-    const std::vector<Real> &activationFrequency = activationFrequency_;
+    /**
+     * Read-only view of the activation frequency of every bit.  Reading a
+     * single bit applies its pending decay on the fly; the whole vector
+     * accessors bring all the bits up to date first, in O(size).
+     */
+    class Frequencies {
+    public:
+        using value_type     = Real;
+        using iterator       = std::vector<Real>::const_iterator;
+        using const_iterator = std::vector<Real>::const_iterator;
+
+        explicit Frequencies( const ActivationFrequency &owner ) : owner_( owner ) {}
+
+        size_t size() const { return owner_.activationFrequency_.size(); }
+        Real operator[]( size_t bit ) const { return owner_.frequency_( bit ); }
+
+        const std::vector<Real> &vector() const
+            { owner_.synchronize_(); return owner_.activationFrequency_; }
+        operator const std::vector<Real> &() const { return vector(); }
+        const Real *data() const { return vector().data(); }
+        const_iterator begin() const { return vector().begin(); }
+        const_iterator end() const { return vector().end(); }
+
+        bool operator==( const std::vector<Real> &other ) const { return vector() == other; }
+        bool operator!=( const std::vector<Real> &other ) const { return vector() != other; }
+
+    private:
+        const ActivationFrequency &owner_;
+    };
+
+    const Frequencies activationFrequency{ *this };
 
     Real min() const;
     Real max() const;
@@ -234,11 +269,19 @@ public:
     friend std::ostream& operator<< (std::ostream &, const ActivationFrequency &);
 
 private:
-    std::vector<Real> activationFrequency_;
+    // as of the sample in updatedAt_, see frequency_()
+    mutable std::vector<Real> activationFrequency_;
+    mutable std::vector<UInt> updatedAt_;
+    Real64 sum_;  // of all the up to date frequencies
     bool alwaysExponential_;
 
     void initialize(UInt size, Real initialValue);
 
+    // Product of the decays of the samples in (from, to].
+    Real64 decay_( UInt from, UInt to ) const;
+    Real frequency_( size_t bit ) const;
+    void synchronize_() const;
+
     static Real binary_entropy_(const std::vector<Real> &frequencies);
 
     void callback(const SDR &dataSource, Real alpha) override;
@@ -3,9 +3,12 @@
 
 #include <vector>
 #include <algorithm>
+#include <array>
 #include <iterator>
 #include <cmath>
 #include <string>
+#include <type_traits>
+#include <utility>
 
 #include <htm/types/Serializable.hpp>
 #include <htm/types/Types.hpp>
@@ -13,32 +16,98 @@
 
 namespace htm {
 
-template<class T> 
+namespace sliding_window {
+  /** Inline storage with the part of the std::vector interface SlidingWindow uses. */
+  template<class T, UInt N>
+  class InlineBuffer {
+    public:
+      size_t size() const { return size_; }
+      void clear() { size_ = 0u; }
+      void reserve(size_t) {}
+      void push_back(const T &value) {
+        NTA_ASSERT(size_ < N);
+        data_[size_++] = value;
+      }
+      T &operator[](size_t i) { return data_[i]; }
+      const T &operator[](size_t i) const { return data_[i]; }
+      const T *data() const { return data_.data(); }
+      const T *begin() const { return data_.data(); }
+      const T *end() const { return data_.data() + size_; }
+      bool operator==(const InlineBuffer &o) const {
+        return size_ == o.size_ && std::equal(begin(), end(), o.begin());
+      }
+      bool operator!=(const InlineBuffer &o) const { return !operator==(o); }
+
+    private:
+      std::array<T, N> data_;
+      size_t size_ = 0u;
+  };
+} // end namespace sliding_window
+
+/**
+ * A window of the last maxCapacity values, stored in a ring buffer.
+ *
+ * @param Capacity 0 (default): the capacity is given to the constructor and
+ *   the values are stored in a std::vector. Otherwise the capacity is fixed
+ *   at compile time and the values are stored inline, without allocations.
+ *
+ * For arithmetic T the window keeps a running sum and sum of squares, so
+ * sum(), mean() and variance() are O(1).
+ */
+template<class T, UInt Capacity = 0u>
 class SlidingWindow : public Serializable {
   // Note: member veriables need to be declared before constructor.
   //       Otherwise we get "will be initialized after [-Werror=reorder]"
-  public: 
+  public:
     const UInt maxCapacity;
     const std::string ID; //name of this object
     const int DEBUG;
+
+    using Buffer = typename std::conditional<Capacity == 0u, std::vector<T>,
+                                             sliding_window::InlineBuffer<T, Capacity>>::type;
+
+    /** A contiguous run of values in the window, valid until the next change. */
+    class Span {
+      public:
+        Span(const T *data, size_t size) : data_(data), size_(size) {}
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0u; }
+        const T *data() const { return data_; }
+        const T *begin() const { return data_; }
+        const T *end() const { return data_ + size_; }
+        const T &operator[](size_t i) const { return data_[i]; }
+      private:
+        const T *data_;
+        size_t size_;
+    };
+
   private:
-    std::vector<T> buffer_;
+    Buffer buffer_;
     UInt idxNext_;
-				
+    Real64 sum_ = 0.0;
+    Real64 sumSquares_ = 0.0;
+
   public:
-    SlidingWindow(UInt max_capacity, std::string id="SlidingWindow", int debug=0) : 
+    SlidingWindow(UInt max_capacity, std::string id="SlidingWindow", int debug=0) :
       maxCapacity(max_capacity),
       ID(id),
       DEBUG(debug)
     {
+      NTA_CHECK(Capacity == 0u || max_capacity == Capacity)
+        << "SlidingWindow: capacity " << max_capacity << " differs from the fixed capacity " << Capacity;
       buffer_.reserve(max_capacity);
       idxNext_ = 0;
-    } 
+    }
+
+    /** Constructor of the fixed capacity window. */
+    template<UInt C = Capacity, typename = typename std::enable_if<C != 0u>::type>
+    explicit SlidingWindow(std::string id="SlidingWindow", int debug=0) :
+      SlidingWindow(Capacity, id, debug) {}
 
 
-    template<class IteratorT> 
-    SlidingWindow(UInt max_capacity, IteratorT initialData_begin, 
-      IteratorT initialData_end, std::string id="SlidingWindow", int debug=0): 
+    template<class IteratorT>
+    SlidingWindow(UInt max_capacity, IteratorT initialData_begin,
+      IteratorT initialData_end, std::string id="SlidingWindow", int debug=0):
       SlidingWindow(max_capacity, id, debug) {
       // Assert that It obeys the STL forward iterator concept
       for(IteratorT it = initialData_begin; it != initialData_end; ++it) {
@@ -47,22 +116,36 @@ class SlidingWindow : public Serializable {
     }
 
 
+    /** remove all values */
+    void clear() {
+      buffer_.clear();
+      idxNext_ = 0;
+      sum_ = 0.0;
+      sumSquares_ = 0.0;
+    }
+
+
     size_t size() const {
       NTA_ASSERT(buffer_.size() <= maxCapacity);
       return buffer_.size();
     }
 
 
-    /** append new value to the end of the buffer and handle the 
-       "overflows"-may pop the oldest element if full. 
+    /** append new value to the end of the buffer and handle the
+       "overflows"-may pop the oldest element if full.
       */
     void append(T newValue) {
       if(size() < maxCapacity) {
         buffer_.push_back(newValue);
+        addStats_(newValue);
       } else {
+        removeStats_(buffer_[idxNext_]);
         buffer_[idxNext_] = newValue;
+        addStats_(newValue);
       }
       idxNext_ = (idxNext_ +1 ) %maxCapacity;
+      // Once per round, sum from scratch so rounding errors don't accumulate.
+      if(idxNext_ == 0u) recomputeStats_();
     }
 
 
@@ -70,8 +153,8 @@ class SlidingWindow : public Serializable {
         :param T newValue - new value to append to the sliding window
         :param T* - a return pass-by-value with the removed element,
           if this function returns false, this value will remain unchanged.
-        :return bool if some value has been dropped (and updated as 
-          droppedValue) 
+        :return bool if some value has been dropped (and updated as
+          droppedValue)
       */
       bool append(T newValue, T* droppedValue) {
         //only in this case we drop oldest; this happens always after
@@ -86,17 +169,34 @@ class SlidingWindow : public Serializable {
 
 
       /**
-        :return unordered content (data ) of this sl. window; 
-          call getLinearizedData() if you need them oredered from 
+        :return unordered content (data ) of this sl. window;
+          call getLinearizedData() if you need them oredered from
           oldest->newest
         This direct access method is fast.
       */
-      const std::vector<T>& getData() const {
+      const Buffer& getData() const {
         return buffer_;
       }
 
+      /** Bytes of the buffer, up to maxCapacity values. */
+      size_t memoryUsage() const {
+        if constexpr (Capacity == 0u) return buffer_.capacity() * sizeof(T);
+        else return Capacity * sizeof(T);
+      }
+
+
+      /**
+        The values ordered from oldest to newest, as two contiguous runs of
+        the internal buffer: first the older, then the newer part. Either may
+        be empty. Does not copy or allocate.
+      */
+      std::pair<Span, Span> getSpans() const {
+        const T *data = size() == 0u ? nullptr : &buffer_[0];
+        return { Span(data + idxNext_, size() - idxNext_), Span(data, idxNext_) };
+      }
 
-      /** linearize method for the internal buffer; this is slower than 
+
+      /** linearize method for the internal buffer; this is slower than
         the pure getData() but ensures that the data are ordered (oldest at
         the beginning, newest at the end of the vector
         This handles case of |5,6;1,2,3,4| => |1,2,3,4,5,6|
@@ -105,21 +205,47 @@ class SlidingWindow : public Serializable {
       std::vector<T> getLinearizedData() const {
         std::vector<T> lin;
         lin.reserve(buffer_.size());
-
+        const auto spans = getSpans();
         //insert the "older" part at the beginning
-        lin.insert(std::begin(lin), std::begin(buffer_) + idxNext_, std::end(buffer_));
+        lin.insert(std::end(lin), spans.first.begin(), spans.first.end());
         //append the "newer" part to the end of the constructed vect
-        lin.insert(std::end(lin), std::begin(buffer_), std::begin(buffer_) + idxNext_);
+        lin.insert(std::end(lin), spans.second.begin(), spans.second.end());
         return lin;
       }
 
 
+      /** Sum of the values in the window, O(1). */
+      Real64 sum() const {
+        static_assert(std::is_arithmetic<T>::value, "SlidingWindow::sum needs an arithmetic type");
+        return sum_;
+      }
+
+      /** Sum of the squared values in the window, O(1). */
+      Real64 sumOfSquares() const {
+        static_assert(std::is_arithmetic<T>::value, "SlidingWindow::sumOfSquares needs an arithmetic type");
+        return sumSquares_;
+      }
+
+      /** Mean of the values in the window, 0 if empty. O(1). */
+      Real64 mean() const {
+        return size() == 0u ? 0.0 : sum() / static_cast<Real64>(size());
+      }
+
+      /** Population variance of the values in the window, 0 if empty. O(1). */
+      Real64 variance() const {
+        if(size() == 0u) return 0.0;
+        const Real64 m = mean();
+        return std::max(0.0, sumOfSquares() / static_cast<Real64>(size()) - m * m);
+      }
+
+
       bool operator==(const SlidingWindow& r2) const {
         const bool sameSizes = (this->size() == r2.size()) && (this->maxCapacity == r2.maxCapacity);
-        if(!sameSizes) return false; 
-        const std::vector<T> v1 = this->getLinearizedData(); 
-        const std::vector<T> v2 = r2.getLinearizedData();
-        return sameSizes && std::equal(v1.cbegin(), v1.cend(), v2.cbegin()); //also content must be same
+        if(!sameSizes) return false;
+        for(UInt i = 0u; i < size(); i++) { //also content must be same
+          if(!((*this)[i] == r2[i])) return false;
+        }
+        return true;
       }
 
 
@@ -129,12 +255,12 @@ class SlidingWindow : public Serializable {
 
 
       /** operator[] provides fast access to the elements indexed relatively
-        to the oldest element. So slidingWindow[0] returns oldest element, 
-        slidingWindow[size()] returns the newest. 
+        to the oldest element. So slidingWindow[0] returns oldest element,
+        slidingWindow[size()] returns the newest.
       :param UInt index - index/offset from the oldest element, values 0..size()
       :return T - i-th oldest value in the buffer
       :throws 0<=index<=size()
-      */ 
+      */
       T operator[](UInt index) const {
         NTA_ASSERT(index <= size());
         NTA_ASSERT(size() > 0);
@@ -150,16 +276,42 @@ class SlidingWindow : public Serializable {
       CerealAdapter;
       template<class Archive>
       void save_ar(Archive & ar) const {
-        ar(CEREAL_NVP(ID), 
-           CEREAL_NVP(buffer_), 
+        const std::vector<T> buffer(buffer_.begin(), buffer_.end());
+        ar(CEREAL_NVP(ID),
+           cereal::make_nvp("buffer_", buffer),
            CEREAL_NVP(idxNext_));
       }
       template<class Archive>
       void load_ar(Archive & ar) {
         std::string name; // for debugging. ID should be already set from constructor.
-        ar( name, buffer_, idxNext_);
+        std::vector<T> buffer;
+        ar( name, buffer, idxNext_);
         // Note: ID, maxCapacity, DEBUG are already set from constructor.
+        NTA_CHECK(buffer.size() <= maxCapacity) << "SlidingWindow: " << buffer.size()
+          << " values do not fit the capacity " << maxCapacity;
+        buffer_.clear();
+        for(const auto &value : buffer) buffer_.push_back(value);
+        recomputeStats_();
+      }
+
+  private:
+      void addStats_(const T &value) {
+        if constexpr (std::is_arithmetic<T>::value) {
+          sum_        += static_cast<Real64>(value);
+          sumSquares_ += static_cast<Real64>(value) * static_cast<Real64>(value);
+        }
+      }
+      void removeStats_(const T &value) {
+        if constexpr (std::is_arithmetic<T>::value) {
+          sum_        -= static_cast<Real64>(value);
+          sumSquares_ -= static_cast<Real64>(value) * static_cast<Real64>(value);
+        }
+      }
+      void recomputeStats_() {
+        sum_ = 0.0;
+        sumSquares_ = 0.0;
+        for(size_t i = 0u; i < buffer_.size(); i++) addStats_(buffer_[i]);
       }
-}; 
+};
 } //end ns
 #endif //header
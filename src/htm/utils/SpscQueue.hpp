@@ -0,0 +1,112 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the SpscQueue class
+ */
+
+#ifndef HTM_UTIL_SPSC_QUEUE_HPP
+#define HTM_UTIL_SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <vector>
+
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+/**
+ * Bounded lock-free queue for exactly one producer and one consumer thread.
+ *
+ * Elements live in a fixed ring of slots which are reused, so a slot may own
+ * buffers (ie. a std::vector) that keep their capacity between uses.
+ * The producer fills the slot returned by back() and makes it visible with
+ * push(); the consumer reads front() in place and releases it with pop().
+ *
+ * Example Usage:
+ *    SpscQueue<std::vector<Real>> q(8, std::vector<Real>(100));
+ *    // producer thread
+ *    if (auto *slot = q.back()) { fill(*slot); q.push(); }
+ *    // consumer thread
+ *    if (auto *slot = q.front()) { use(*slot); q.pop(); }
+ */
+template<class T>
+class SpscQueue {
+public:
+  /**
+   * @param capacity Number of elements the queue can hold, at least 1.
+   * @param prototype Initial value of every slot.
+   */
+  explicit SpscQueue(size_t capacity, const T &prototype = T())
+    : slots_(capacity + 1u, prototype) {
+    NTA_CHECK(capacity > 0u) << "SpscQueue: capacity must be at least 1.";
+  }
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue &operator=(const SpscQueue&) = delete;
+
+  size_t capacity() const { return slots_.size() - 1u; }
+
+  /** Producer: the free slot to fill next, or nullptr when the queue is full. */
+  T *back() {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (next(tail) == head_.load(std::memory_order_acquire)) return nullptr;
+    return &slots_[tail];
+  }
+
+  /** Producer: publishes the slot returned by back(). */
+  void push() {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    NTA_ASSERT(next(tail) != head_.load(std::memory_order_acquire)) << "SpscQueue: push on a full queue";
+    tail_.store(next(tail), std::memory_order_release);
+  }
+
+  /** Consumer: the oldest element, or nullptr when the queue is empty. */
+  T *front() {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) return nullptr;
+    return &slots_[head];
+  }
+
+  /** Consumer: releases the element returned by front() to the producer. */
+  void pop() {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    NTA_ASSERT(head != tail_.load(std::memory_order_acquire)) << "SpscQueue: pop on an empty queue";
+    head_.store(next(head), std::memory_order_release);
+  }
+
+  /** Not thread safe: only call when neither side is running. */
+  void clear() {
+    head_.store(0u, std::memory_order_relaxed);
+    tail_.store(0u, std::memory_order_relaxed);
+  }
+
+  bool empty() const {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+  }
+
+private:
+  size_t next(size_t i) const { return i + 1u == slots_.size() ? 0u : i + 1u; }
+
+  std::vector<T> slots_;  // one slot stays empty to tell full from empty
+  // owned by the consumer and the producer; separate cache lines avoid false sharing
+  alignas(64) std::atomic<size_t> head_{0u};
+  alignas(64) std::atomic<size_t> tail_{0u};
+};
+
+} // end namespace htm
+#endif // HTM_UTIL_SPSC_QUEUE_HPP
@@ -0,0 +1,116 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the TaskQueue class
+ */
+
+#include <htm/utils/TaskQueue.hpp>
+
+#include <algorithm> // max
+#include <exception>
+
+#include <htm/utils/Log.hpp>
+
+using namespace htm;
+
+TaskQueue::TaskQueue(size_t numThreads) {
+  if(numThreads == 0u) {
+    numThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1u);
+  }
+  workers_.reserve(numThreads);
+  for(size_t i = 0u; i < numThreads; i++) {
+    workers_.emplace_back([this]() { work_(); });
+  }
+}
+
+
+TaskQueue::~TaskQueue() {
+  wait();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  ready_.notify_all();
+  for(auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+
+void TaskQueue::submit(const void *key, std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_++;
+    if(key != nullptr) {
+      const auto busy = busy_.find(key);
+      if(busy != busy_.end()) { // runs after the task of this key
+        busy->second.push_back(std::move(task));
+        return;
+      }
+      busy_[key];
+    }
+    runnable_.emplace_back(key, std::move(task));
+  }
+  ready_.notify_one();
+}
+
+
+void TaskQueue::wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_.wait(lock, [this]() { return pending_ == 0u; });
+}
+
+
+size_t TaskQueue::pending() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pending_;
+}
+
+
+void TaskQueue::work_() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while(true) {
+    ready_.wait(lock, [this]() { return stop_ or not runnable_.empty(); });
+    if(runnable_.empty()) return; // stop_
+    Task task = std::move(runnable_.front());
+    runnable_.pop_front();
+    lock.unlock();
+    try {
+      task.second();
+    } catch(const std::exception &e) {
+      NTA_WARN << "TaskQueue: a task failed: " << e.what();
+    } catch(...) {
+      NTA_WARN << "TaskQueue: a task failed.";
+    }
+    task.second = nullptr; // destroy its captures outside of the lock
+    lock.lock();
+    if(task.first != nullptr) {
+      auto busy = busy_.find(task.first);
+      if(busy->second.empty()) {
+        busy_.erase(busy);
+      } else {
+        runnable_.emplace_back(task.first, std::move(busy->second.front()));
+        busy->second.pop_front();
+        ready_.notify_one();
+      }
+    }
+    if(--pending_ == 0u) {
+      idle_.notify_all();
+    }
+  }
+}
@@ -0,0 +1,103 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the TaskQueue class
+ */
+
+#ifndef HTM_UTIL_TASK_QUEUE_HPP
+#define HTM_UTIL_TASK_QUEUE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace htm {
+
+/**
+ * Worker threads which run submitted tasks in the background, eg. the
+ * compute_async() and run_async() methods of the Python bindings.
+ *
+ * Unlike ThreadPool (a fork-join loop the caller waits for), submit() returns
+ * at once.  Tasks of the same key run one at a time, in the order they were
+ * submitted, so the steps of one model never overlap; tasks of different
+ * keys run in parallel.
+ *
+ * Example:
+ *     TaskQueue queue(4);
+ *     for (auto &net : networks)
+ *       queue.submit(net.get(), [net]() { net->run(1); });
+ *     queue.wait();
+ *
+ * An exception escaping a task is logged and dropped, a task which can fail
+ * should report its own errors.
+ */
+class TaskQueue {
+public:
+  /**
+   * @param numThreads - number of worker threads, 0 means
+   *   std::thread::hardware_concurrency().
+   */
+  explicit TaskQueue(size_t numThreads = 0u);
+
+  /** Runs the tasks submitted so far, then stops the workers. */
+  ~TaskQueue();
+
+  TaskQueue(const TaskQueue &) = delete;
+  TaskQueue &operator=(const TaskQueue &) = delete;
+
+  size_t size() const noexcept { return workers_.size(); }
+
+  /**
+   * Run task on a worker thread.
+   *
+   * @param key - tasks of the same key run in order, one at a time;
+   *   nullptr for a task without order.
+   */
+  void submit(const void *key, std::function<void()> task);
+
+  /** Block until all tasks submitted so far are done. */
+  void wait();
+
+  /** The number of tasks submitted and not yet done. */
+  size_t pending() const;
+
+private:
+  void work_();
+
+  using Task = std::pair<const void *, std::function<void()>>;
+
+  mutable std::mutex mutex_;
+  std::condition_variable ready_;  // a task is runnable, or stopping
+  std::condition_variable idle_;   // pending_ became 0
+  std::deque<Task> runnable_;
+  // The keys with a runnable or running task, with their tasks waiting for it.
+  std::unordered_map<const void *, std::deque<std::function<void()>>> busy_;
+  size_t pending_ = 0u;
+  bool stop_ = false;
+  std::vector<std::thread> workers_;
+};
+
+} // namespace htm
+
+#endif // HTM_UTIL_TASK_QUEUE_HPP
@@ -0,0 +1,282 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the ThreadPool class
+ */
+
+#include <htm/utils/ThreadPool.hpp>
+
+#include <algorithm> // find, max
+
+#if defined(__linux__)
+#include <fstream>
+#include <pthread.h>
+#include <sched.h>
+#include <sstream>
+#include <string>
+#endif
+
+using namespace htm;
+
+namespace {
+#if defined(__linux__)
+// CPUs of each NUMA node, from /sys/devices/system/node/node<N>/cpulist ("0-3,8-11").
+const std::vector<std::vector<int>> &numaCpus_() {
+  static const std::vector<std::vector<int>> nodes = []() {
+    std::vector<std::vector<int>> result;
+    for(size_t node = 0; ; node++) {
+      std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+      if(not file) break;
+      std::vector<int> cpus;
+      std::string range;
+      while(std::getline(file, range, ',')) {
+        int first = 0, last = 0;
+        char dash = 0;
+        std::istringstream in(range);
+        if(not (in >> first)) continue;
+        last = (in >> dash >> last) ? last : first;
+        for(int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+      }
+      result.push_back(cpus);
+    }
+    return result;
+  }();
+  return nodes;
+}
+
+// The CPUs of the process when it started, which "all CPUs" restores.
+const cpu_set_t &processCpus_() {
+  static const cpu_set_t cpus = []() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if(sched_getaffinity(0, sizeof(set), &set) != 0) {
+      for(int cpu = 0; cpu < CPU_SETSIZE; cpu++) CPU_SET(cpu, &set);
+    }
+    return set;
+  }();
+  return cpus;
+}
+[[maybe_unused]] const cpu_set_t &processCpusAtLoad_ = processCpus_(); //before any thread is pinned
+
+void pinToNode_(const size_t index) {
+  const auto &nodes = numaCpus_();
+  if(nodes.empty()) return;
+  ThreadPool::pinCurrentThread(nodes[index % nodes.size()]); //best effort
+}
+#else
+void pinToNode_(const size_t) {}
+#endif
+} // anonymous namespace
+
+
+std::vector<int> Placement::cpuSet() const {
+  if(not cpus.empty() or numaNode < 0) return cpus;
+  return ThreadPool::numaNodeCpus(static_cast<size_t>(numaNode));
+}
+
+
+int Placement::node() const {
+  if(numaNode >= 0 or cpus.empty()) return numaNode;
+  return ThreadPool::numaNodeOf(cpus.front());
+}
+
+
+size_t ThreadPool::numNumaNodes() {
+#if defined(__linux__)
+  return std::max<size_t>(numaCpus_().size(), 1u);
+#else
+  return 1u;
+#endif
+}
+
+
+std::vector<int> ThreadPool::numaNodeCpus(const size_t node) {
+#if defined(__linux__)
+  const auto &nodes = numaCpus_();
+  if(node < nodes.size()) return nodes[node];
+#endif
+  return {};
+}
+
+
+int ThreadPool::numaNodeOf(const int cpu) {
+#if defined(__linux__)
+  const auto &nodes = numaCpus_();
+  for(size_t node = 0; node < nodes.size(); node++) {
+    if(std::find(nodes[node].begin(), nodes[node].end(), cpu) != nodes[node].end())
+      return static_cast<int>(node);
+  }
+#endif
+  return -1;
+}
+
+
+bool ThreadPool::pinCurrentThread(const std::vector<int> &cpus) {
+#if defined(__linux__)
+  cpu_set_t set;
+  if(cpus.empty()) {
+    set = processCpus_();
+  } else {
+    CPU_ZERO(&set);
+    for(const int cpu : cpus) {
+      if(cpu >= 0 and cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    if(CPU_COUNT(&set) == 0) return false;
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  (void)cpus;
+  return false;
+#endif
+}
+
+
+std::vector<int> ThreadPool::currentThreadCpus() {
+  std::vector<int> cpus;
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if(pthread_getaffinity_np(pthread_self(), sizeof(set), &set) != 0) return cpus;
+  for(int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if(CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+  }
+#endif
+  return cpus;
+}
+
+
+ThreadPool::PinScope::PinScope(const std::vector<int> &cpus) {
+  if(cpus.empty()) return;
+  previous_ = currentThreadCpus();
+  pinned_ = not previous_.empty() and previous_ != cpus and pinCurrentThread(cpus);
+}
+
+
+ThreadPool::PinScope::~PinScope() {
+  if(pinned_) pinCurrentThread(previous_);
+}
+
+
+void ThreadPool::pinWorkers(const std::vector<int> &cpus) {
+  forEachWorker([&cpus](size_t) { pinCurrentThread(cpus); });
+}
+
+
+ThreadPool::ThreadPool(size_t numThreads, bool pinWorkers) {
+  if(numThreads == 0) numThreads = std::thread::hardware_concurrency();
+  if(numThreads == 0) numThreads = 1; //unknown
+  for(size_t i = 1; i < numThreads; i++) {
+    const size_t index = i - 1u;
+    workers_.emplace_back([this, index, pinWorkers]() {
+      if(pinWorkers) pinToNode_(index);
+      workerLoop_(index);
+    });
+  }
+}
+
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for(auto &w : workers_) w.join();
+}
+
+
+void ThreadPool::runTask_(const size_t i) {
+  try {
+    (*task_)(i);
+  } catch(...) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(not error_) error_ = std::current_exception();
+  }
+}
+
+
+void ThreadPool::runTasks_() {
+  for(size_t i = nextTask_++; i < numTasks_; i = nextTask_++) {
+    runTask_(i);
+  }
+}
+
+
+void ThreadPool::workerLoop_(const size_t index) {
+  size_t seen = 0;
+  while(true) {
+    bool each;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [&]() { return stop_ or generation_ != seen; });
+      if(stop_) return;
+      seen = generation_;
+      each = eachWorker_;
+    }
+    if(each) runTask_(index);
+    else     runTasks_();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      busy_--;
+    }
+    done_.notify_one();
+  }
+}
+
+
+void ThreadPool::parallelFor(const size_t numTasks, const std::function<void(size_t)> &task) {
+  if(numTasks == 0) return;
+  if(workers_.empty() or numTasks == 1) { //nothing to share
+    for(size_t i = 0; i < numTasks; i++) task(i);
+    return;
+  }
+  run_(numTasks, task, false);
+}
+
+
+void ThreadPool::forEachWorker(const std::function<void(size_t)> &task) {
+  if(workers_.empty()) return;
+  run_(workers_.size(), task, true);
+}
+
+
+void ThreadPool::run_(const size_t numTasks, const std::function<void(size_t)> &task, const bool eachWorker) {
+  std::lock_guard<std::mutex> callerLock(callerMutex_);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_       = &task;
+    numTasks_   = numTasks;
+    nextTask_   = 0;
+    busy_       = workers_.size();
+    error_      = nullptr;
+    eachWorker_ = eachWorker;
+    generation_++;
+  }
+  wake_.notify_all();
+
+  if(not eachWorker) runTasks_();
+
+  std::exception_ptr error;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [&]() { return busy_ == 0; });
+    task_ = nullptr;
+    error = error_;
+  }
+  if(error) std::rethrow_exception(error);
+}
@@ -0,0 +1,180 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the ThreadPool class
+ */
+
+#ifndef HTM_UTIL_THREAD_POOL_HPP
+#define HTM_UTIL_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace htm {
+
+/**
+ * Where work runs and where its memory is, eg. of a region of a Network (see
+ * Network::setPlacement()). All of it are hints, which are ignored where the
+ * system does not support them; an empty member means anywhere.
+ */
+struct Placement {
+  std::vector<int> cpus;  // the CPUs to run on
+  int numaNode = -1;      // the NUMA node to run on, and of the memory
+  std::string pool;       // name of a thread pool, eg. Network::addThreadPool()
+
+  bool empty() const noexcept { return cpus.empty() and numaNode < 0 and pool.empty(); }
+
+  /**
+   * @return the CPUs to run on: cpus, else the CPUs of numaNode, else none.
+   */
+  std::vector<int> cpuSet() const;
+
+  /**
+   * @return the NUMA node of the memory: numaNode, else the node of the
+   *   first of cpus, else -1.
+   */
+  int node() const;
+};
+
+/**
+ * A small fork-join pool of worker threads for data-parallel loops in the
+ * algorithms.
+ *
+ * Example:
+ *     ThreadPool pool(4);
+ *     pool.parallelFor(numChunks, [&](size_t chunk) { ... });
+ *
+ * `parallelFor` blocks until all tasks finished. The calling thread works on
+ * the tasks too, so a pool of size N starts N-1 extra threads. Tasks are
+ * handed out dynamically; a task must not depend on which worker runs it.
+ * Only one `parallelFor` runs at a time, concurrent callers wait.
+ * If a task throws, the first exception is rethrown in the caller.
+ *
+ * For data which belongs to one thread (e.g. memory allocated NUMA-locally by
+ * first touch) `forEachWorker` runs task i always on worker i, and the workers
+ * can be pinned to the NUMA nodes.
+ */
+class ThreadPool {
+public:
+  /**
+   * @param numThreads - total number of threads working on a loop, including
+   *   the caller. 0 means std::thread::hardware_concurrency().
+   * @param pinWorkers - pin worker i to the CPUs of NUMA node i % numNumaNodes().
+   *   Linux only, elsewhere (or if it fails) the workers are not pinned.
+   */
+  explicit ThreadPool(size_t numThreads = 0, bool pinWorkers = false);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool &operator=(const ThreadPool&) = delete;
+
+  /**
+   * @return number of threads working on a parallelFor(), including the caller.
+   */
+  size_t size() const noexcept { return workers_.size() + 1u; }
+
+  /**
+   * Run task(i) for all i in [0, numTasks), in parallel.
+   */
+  void parallelFor(const size_t numTasks, const std::function<void(size_t)> &task);
+
+  /**
+   * Run task(i) on worker thread i, for all i in [0, size() - 1), in parallel.
+   * The caller only waits. The same i always runs on the same thread.
+   */
+  void forEachWorker(const std::function<void(size_t)> &task);
+
+  /**
+   * Pin all worker threads (not the caller) to the given CPUs, empty for
+   * all CPUs. Best effort, as pinCurrentThread().
+   */
+  void pinWorkers(const std::vector<int> &cpus);
+
+  /**
+   * @return number of NUMA nodes of this machine, 1 if unknown.
+   */
+  static size_t numNumaNodes();
+
+  /**
+   * @return the CPUs of NUMA node `node`, empty if unknown.
+   */
+  static std::vector<int> numaNodeCpus(const size_t node);
+
+  /**
+   * @return the NUMA node of CPU `cpu`, -1 if unknown.
+   */
+  static int numaNodeOf(const int cpu);
+
+  /**
+   * Pin the calling thread to the given CPUs, empty for all CPUs of the
+   * process. Linux only.
+   * @return whether the thread was pinned.
+   */
+  static bool pinCurrentThread(const std::vector<int> &cpus);
+
+  /**
+   * @return the CPUs the calling thread may run on, empty if unknown.
+   */
+  static std::vector<int> currentThreadCpus();
+
+  /**
+   * Pins the calling thread to `cpus` until the scope ends, then restores
+   * its CPUs. Empty `cpus` leave the thread as it is.
+   */
+  class PinScope {
+  public:
+    explicit PinScope(const std::vector<int> &cpus);
+    ~PinScope();
+    PinScope(const PinScope&) = delete;
+    PinScope &operator=(const PinScope&) = delete;
+  private:
+    std::vector<int> previous_;
+    bool pinned_ = false;
+  };
+
+private:
+  void workerLoop_(const size_t index);
+  void runTasks_();
+  void runTask_(const size_t i);
+  void run_(const size_t numTasks, const std::function<void(size_t)> &task, const bool eachWorker);
+
+  std::vector<std::thread> workers_;
+  std::mutex               callerMutex_; //one parallelFor at a time
+  std::mutex               mutex_;
+  std::condition_variable  wake_;
+  std::condition_variable  done_;
+
+  const std::function<void(size_t)> *task_ = nullptr;
+  size_t                   numTasks_ = 0;
+  std::atomic<size_t>      nextTask_{0};
+  size_t                   busy_ = 0;       //workers still inside runTasks_()
+  size_t                   generation_ = 0; //incremented for each parallelFor
+  bool                     eachWorker_ = false; //forEachWorker(): worker i runs task i
+  bool                     stop_ = false;
+  std::exception_ptr       error_;
+};
+
+} // namespace htm
+
+#endif // HTM_UTIL_THREAD_POOL_HPP
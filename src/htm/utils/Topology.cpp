@@ -22,6 +22,7 @@
 #include <htm/utils/Topology.hpp>
 #include <htm/utils/Log.hpp>
 #include <algorithm> // sort
+#include <memory>
 
 using namespace htm;
 using namespace std;
@@ -37,6 +38,8 @@ Topology_t  DefaultTopology(
   NTA_CHECK( potentialPct >= 0.0f );
   NTA_CHECK( potentialPct <= 1.0f );
   NTA_CHECK( potentialRadius >= 0.0f );
+  // The stencil of the input space, rebuilt only when the dimensions change.
+  auto neighborhood = std::make_shared<std::unique_ptr<NeighborhoodStencil>>();
   return [=] (const SDR& cell, const vector<UInt>& potentialPoolDimensions, Random &rng) -> SDR {
     // Uniform topology over trailing input dimensions.
     auto inputTopology = potentialPoolDimensions;
@@ -61,12 +64,17 @@ Topology_t  DefaultTopology(
     inputTopologySDR.setCoordinates( inputCoords );
     const auto centerInput = inputTopologySDR.getSparse()[0];
 
+    auto &hood = *neighborhood;
+    if( hood == nullptr or hood->dimensions() != inputTopology ) {
+      hood.reset( new NeighborhoodStencil((UInt)floor(potentialRadius), inputTopology, wrapAround /*wrapping*/) );
+    }
     vector<UInt> columnInputs;
-    for( UInt input : Neighborhood(centerInput, (UInt)floor(potentialRadius), inputTopology, wrapAround /*wrapping*/)) {
+    hood->forEachNeighbor(centerInput, [&](const UInt input) {
         for( UInt extra = 0; extra < extraDimensions; ++extra ) {
           columnInputs.push_back( input * extraDimensions + extra );
         }
-    }
+        return true;
+    });
  
 
     const UInt numPotential = (UInt)round(columnInputs.size() * potentialPct);
@@ -231,6 +239,80 @@ void Neighborhood::Iterator::advance_() {
   }
 }
 
+NeighborhoodStencil::NeighborhoodStencil(const UInt radius,
+                                         const vector<UInt> &dimensions,
+                                         const bool wrap,
+                                         const bool skipCenter)
+    : dimensions_(dimensions), strides_(dimensions.size(), 1u),
+      radius_(radius), wrap_(wrap), skipCenter_(skipCenter),
+      coordinates_(dimensions.size()), numCoordinates_(dimensions.size(), 0u) {
+  NTA_CHECK(not dimensions.empty());
+  for(size_t i = dimensions.size() - 1u; i > 0u; i--) {
+    strides_[i - 1u] = strides_[i] * dimensions[i];
+  }
+  bool hasInterior = true;
+  for(size_t i = 0; i < dimensions.size(); i++) {
+    const UInt side = std::min<UInt>(2u * radius + 1u, dimensions[i]);
+    coordinates_[i].resize(side);
+    hasInterior = hasInterior and 2u * radius + 1u <= dimensions[i];
+  }
+  if(not hasInterior) return;
+
+  // Offsets in the order of Neighborhood::Iterator: the last dimension
+  // changes fastest, each from -radius to +radius.
+  stencil_.push_back(0);
+  for(size_t i = 0; i < dimensions.size(); i++) {
+    vector<Int> next;
+    next.reserve(stencil_.size() * (2u * radius + 1u));
+    for(const Int base : stencil_) {
+      for(Int offset = -(Int)radius; offset <= (Int)radius; offset++) {
+        next.push_back(base + offset * (Int)strides_[i]);
+      }
+    }
+    stencil_.swap(next);
+  }
+  if(skipCenter) {
+    stencil_.erase(std::find(stencil_.begin(), stencil_.end(), 0));
+  }
+}
+
+
+bool NeighborhoodStencil::setCenter_(const UInt centerIndex) {
+  bool interior = not stencil_.empty();
+  UInt rest = centerIndex;
+  for(size_t i = 0; i < dimensions_.size() and interior; i++) {
+    const UInt center = rest / strides_[i];
+    rest %= strides_[i];
+    interior = center >= radius_ and center + radius_ < dimensions_[i];
+  }
+  if(interior) return true;
+
+  rest = centerIndex;
+  for(size_t i = 0; i < dimensions_.size(); i++) {
+    const Int dim    = static_cast<Int>(dimensions_[i]);
+    const Int center = static_cast<Int>(rest / strides_[i]);
+    rest %= strides_[i];
+    auto &coords = coordinates_[i];
+    UInt n = 0u;
+    if(not wrap_) {
+      const Int last = std::min<Int>(center + (Int)radius_, dim - 1);
+      for(Int c = std::max<Int>(center - (Int)radius_, 0); c <= last; c++) {
+        coords[n++] = static_cast<UInt>(c) * strides_[i];
+      }
+    } else {
+      // Stop before the points repeat when the side is larger than the dimension.
+      for(Int offset = -(Int)radius_; offset <= (Int)radius_ and offset + (Int)radius_ < dim; offset++) {
+        Int c = (center + offset) % dim;
+        if(c < 0) c += dim;
+        coords[n++] = static_cast<UInt>(c) * strides_[i];
+      }
+    }
+    numCoordinates_[i] = n;
+  }
+  return false;
+}
+
+
 unordered_map<CellIdx, vector<CellIdx>> Neighborhood::updateAllNeighbors(
 		const UInt radius,
                 const vector<UInt> dimensions,
@@ -261,3 +343,56 @@ unordered_map<CellIdx, vector<CellIdx>> Neighborhood::updateAllNeighbors(
 
 Neighborhood::Iterator Neighborhood::begin() const { return {*this, false}; }
 Neighborhood::Iterator Neighborhood::end() const { return {*this, true}; }
+
+
+NeighborhoodRanges::NeighborhoodRanges(const UInt radius,
+                                       const vector<UInt> &dimensions,
+                                       const bool wrap)
+    : dimensions_(dimensions), strides_(dimensions.size(), 1u),
+      radius_(radius), wrap_(wrap),
+      ranges_(dimensions.size()), numRanges_(dimensions.size(), 0u) {
+  NTA_CHECK(not dimensions.empty());
+  for(size_t i = dimensions.size() - 1u; i > 0u; i--) {
+    strides_[i - 1u] = strides_[i] * dimensions[i];
+  }
+}
+
+
+UInt NeighborhoodRanges::setCenter(const UInt centerIndex) {
+  UInt numPoints = 1u;
+  UInt rest = centerIndex;
+  for(size_t i = 0; i < dimensions_.size(); i++) {
+    const Int dim    = static_cast<Int>(dimensions_[i]);
+    const Int center = static_cast<Int>(rest / strides_[i]);
+    rest %= strides_[i];
+    auto &ranges = ranges_[i];
+
+    if(not wrap_) {
+      ranges[0] = { static_cast<UInt>(std::max<Int>(center - (Int)radius_, 0)),
+                    static_cast<UInt>(std::min<Int>(center + (Int)radius_ + 1, dim)) };
+      numRanges_[i] = 1u;
+    } else if(static_cast<Int>(2u * radius_ + 1u) >= dim) {
+      ranges[0] = { 0u, static_cast<UInt>(dim) }; //covers the whole dimension, each point once
+      numRanges_[i] = 1u;
+    } else {
+      const Int first = center - (Int)radius_;
+      const Int last  = center + (Int)radius_; //inclusive
+      if(first < 0) {
+        ranges[0] = { 0u, static_cast<UInt>(last + 1) };
+        ranges[1] = { static_cast<UInt>(first + dim), static_cast<UInt>(dim) };
+        numRanges_[i] = 2u;
+      } else if(last >= dim) {
+        ranges[0] = { 0u, static_cast<UInt>(last + 1 - dim) };
+        ranges[1] = { static_cast<UInt>(first), static_cast<UInt>(dim) };
+        numRanges_[i] = 2u;
+      } else {
+        ranges[0] = { static_cast<UInt>(first), static_cast<UInt>(last + 1) };
+        numRanges_[i] = 1u;
+      }
+    }
+    UInt size = 0u;
+    for(UInt r = 0u; r < numRanges_[i]; r++) size += ranges[r].end - ranges[r].begin;
+    numPoints *= size;
+  }
+  return numPoints;
+}
@@ -23,6 +23,7 @@
 #define NTA_TOPOLOGY_HPP
 
 #include <vector>
+#include <array>
 #include <functional>
 #include <unordered_map>
 
@@ -226,6 +227,11 @@ public:
   Iterator begin() const;
   Iterator end() const;
 
+  /**
+   * Materializes the (sorted) neighborhoods of all points, which takes
+   * O(points * neighborhood) time and memory. The SpatialPooler does not use
+   * it anymore, prefer walking NeighborhoodRanges on the fly.
+   */
 static  std::unordered_map<htm::CellIdx, std::vector<htm::CellIdx>> updateAllNeighbors(
     const UInt radius,
     const std::vector<UInt> dimensions,
@@ -242,6 +248,145 @@ private:
 };
 
 
+/**
+ * The same points as Neighborhood(center, radius, dimensions, wrap), stored
+ * as ranges of coordinates instead of being iterated one by one.
+ *
+ * The points are visited in ascending order of their index, without the
+ * per-point index arithmetic of Neighborhood and without a materialized list
+ * of neighbors: the last dimension is walked as contiguous runs of indices.
+ * The center is included.
+ *
+ * Reuse one instance for many centers, only the constructor allocates.
+ * Example:
+ *
+ *   NeighborhoodRanges hood(radius, dimensions, wrap);
+ *   for(UInt column = 0; column < numColumns; column++) {
+ *     const UInt numPoints = hood.setCenter(column);
+ *     hood.forEach([&](const UInt neighbor) { ...; return true; });
+ *   }
+ */
+class NeighborhoodRanges {
+public:
+  NeighborhoodRanges(const UInt radius,
+                     const std::vector<UInt> &dimensions,
+                     const bool wrap = false);
+
+  /**
+   * Moves the neighborhood to a new center.
+   * @returns number of points in the neighborhood, including the center.
+   */
+  UInt setCenter(const UInt centerIndex);
+
+  /**
+   * Calls visit(index) for each point in the neighborhood, in ascending order.
+   * visit returns a bool, false stops the iteration.
+   */
+  template<typename Visit>
+  void forEach(Visit &&visit) const {
+    forEachInDim_(0u, 0u, visit);
+  }
+
+private:
+  struct Range { UInt begin; UInt end; }; //coordinates [begin, end)
+
+  template<typename Visit>
+  bool forEachInDim_(const size_t dim, const UInt base, Visit &visit) const {
+    const bool last = dim + 1u == dimensions_.size();
+    for(UInt r = 0u; r < numRanges_[dim]; r++) {
+      const Range &range = ranges_[dim][r];
+      for(UInt coordinate = range.begin; coordinate < range.end; coordinate++) {
+        const UInt index = base + coordinate * strides_[dim];
+        if(not (last ? visit(index) : forEachInDim_(dim + 1u, index, visit))) return false;
+      }
+    }
+    return true;
+  }
+
+  const std::vector<UInt> dimensions_;
+  std::vector<UInt> strides_;
+  const UInt radius_;
+  const bool wrap_;
+  std::vector<std::array<Range, 2>> ranges_; //per dimension, a wrapped range is split into 2
+  std::vector<UInt> numRanges_;
+};
+
+
+/**
+ * The points of Neighborhood(center, radius, dimensions, wrap, skipCenter),
+ * visited in exactly the same order, for many centers.
+ *
+ * The constructor precomputes the flat index offsets of the whole hypercube
+ * (the stencil).  Centers which are at least radius away from every edge
+ * are then walked as center + offset, without any coordinate arithmetic.
+ * Centers near an edge precompute the valid (truncated or wrapped)
+ * coordinates of each dimension once, and combine them with a running
+ * index.  Prefer NeighborhoodRanges when the order does not matter.
+ *
+ * Only the constructor allocates; an instance is not thread safe.
+ * Example:
+ *
+ *   NeighborhoodStencil hood(radius, dimensions, wrap);
+ *   for(UInt column = 0; column < numColumns; column++) {
+ *     hood.forEachNeighbor(column, [&](const UInt neighbor) { ...; return true; });
+ *   }
+ */
+class NeighborhoodStencil {
+public:
+  NeighborhoodStencil(const UInt radius,
+                      const std::vector<UInt> &dimensions,
+                      const bool wrap = false,
+                      const bool skipCenter = false);
+
+  /**
+   * Calls visit(index) for each point in the neighborhood of centerIndex.
+   * visit returns a bool, false stops the iteration.
+   */
+  template<typename Visit>
+  void forEachNeighbor(const UInt centerIndex, Visit &&visit) {
+    if(setCenter_(centerIndex)) {
+      for(const Int offset : stencil_) {
+        if(not visit(static_cast<UInt>(static_cast<Int>(centerIndex) + offset))) return;
+      }
+    } else {
+      forEachInDim_(0u, 0u, centerIndex, visit);
+    }
+  }
+
+  const std::vector<UInt> &dimensions() const { return dimensions_; }
+  UInt radius() const { return radius_; }
+  bool wrap() const { return wrap_; }
+
+private:
+  /** @returns true if the center is in the interior, ie. the stencil applies. */
+  bool setCenter_(const UInt centerIndex);
+
+  template<typename Visit>
+  bool forEachInDim_(const size_t dim, const UInt base, const UInt center, Visit &visit) const {
+    const bool last = dim + 1u == dimensions_.size();
+    const auto &coords = coordinates_[dim];
+    for(UInt c = 0u; c < numCoordinates_[dim]; c++) {
+      const UInt index = base + coords[c];
+      if(last) {
+        if(skipCenter_ and index == center) continue;
+        if(not visit(index)) return false;
+      } else if(not forEachInDim_(dim + 1u, index, center, visit)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  const std::vector<UInt> dimensions_;
+  std::vector<UInt> strides_;
+  const UInt radius_;
+  const bool wrap_;
+  const bool skipCenter_;
+  std::vector<Int> stencil_; //flat offsets, empty if no center is interior
+  std::vector<std::vector<UInt>> coordinates_; //per dimension: coordinate * stride, in order
+  std::vector<UInt> numCoordinates_;
+};
+
 } // end namespace htm
 
 #endif // NTA_TOPOLOGY_HPP
@@ -0,0 +1,200 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the Tracer class
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include <htm/ntypes/Value.hpp>
+#include <htm/utils/LatencyHistogram.hpp>
+#include <htm/utils/Log.hpp>
+#include <htm/utils/Tracer.hpp>
+
+namespace htm {
+
+namespace {
+  struct Event {
+    UInt64 start;
+    UInt64 duration;
+    UInt64 count;
+    const char *category;
+    const char *copy;
+    const char *type;
+    char name[64];
+  };
+
+  // Written only by the thread which owns it, read by the exports while no
+  // network runs.  A buffer outlives its thread and is reused by the next one.
+  struct ThreadBuffer {
+    UInt32 tid;
+    bool owned = true;
+    std::vector<Event> events;
+    UInt64 next = 0u; // total number of events recorded, the ring index is next % size
+  };
+
+  std::mutex buffersMutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+  bool enabled = false;
+  UInt32 sampleEvery = 1u;
+  size_t capacity = 65536u;
+
+  ThreadBuffer *acquireBuffer() {
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    for (const auto &b : buffers) {
+      if (!b->owned) {
+        b->owned = true;
+        return b.get();
+      }
+    }
+    buffers.emplace_back(new ThreadBuffer());
+    ThreadBuffer *b = buffers.back().get();
+    b->tid = static_cast<UInt32>(buffers.size());
+    b->events.resize(capacity);
+    return b;
+  }
+
+  struct ThreadBufferHolder {
+    ThreadBuffer *buffer = nullptr;
+    ~ThreadBufferHolder() {
+      if (buffer == nullptr) return;
+      std::lock_guard<std::mutex> lock(buffersMutex);
+      buffer->owned = false;
+    }
+  };
+
+  ThreadBuffer &threadBuffer() {
+    thread_local ThreadBufferHolder holder;
+    if (holder.buffer == nullptr)
+      holder.buffer = acquireBuffer();
+    return *holder.buffer;
+  }
+
+  void writeMicroseconds(std::ostream &out, UInt64 nanoseconds) {
+    out << nanoseconds / 1000u << "." << std::setw(3) << std::setfill('0') << nanoseconds % 1000u;
+  }
+} // namespace
+
+std::atomic<bool> Tracer::active_{false};
+
+void Tracer::enable(UInt32 every, size_t cap) {
+  NTA_CHECK(every > 0u) << "Tracer::enable: sampleEvery must be at least 1.";
+  NTA_CHECK(cap > 0u) << "Tracer::enable: capacity must be at least 1.";
+  std::lock_guard<std::mutex> lock(buffersMutex);
+  enabled = true;
+  sampleEvery = every;
+  if (cap != capacity) {
+    capacity = cap;
+    for (const auto &b : buffers) {
+      b->events.assign(capacity, Event());
+      b->next = 0u;
+    }
+  }
+}
+
+void Tracer::disable() {
+  enabled = false;
+  active_.store(false, std::memory_order_relaxed);
+}
+
+bool Tracer::isEnabled() { return enabled; }
+
+void Tracer::beginIteration(UInt64 iteration) {
+  active_.store(enabled && iteration % sampleEvery == 0u, std::memory_order_relaxed);
+}
+
+void Tracer::record(const char *category, const std::string &name, UInt64 start,
+                    UInt64 count, const char *copy, const char *type) {
+  const UInt64 end = LatencyHistogram::now();
+  ThreadBuffer &b = threadBuffer();
+  Event &e = b.events[b.next % b.events.size()];
+  b.next++;
+  e.start = start;
+  e.duration = end - start;
+  e.count = count;
+  e.category = category;
+  e.copy = copy;
+  e.type = type;
+  const size_t n = std::min(name.size(), sizeof(e.name) - 1u);
+  std::memcpy(e.name, name.data(), n);
+  e.name[n] = '\0';
+}
+
+Tracer::Span::Span(const char *category, const std::string &name)
+    : category_(category), name_(&name),
+      start_(isActive() ? LatencyHistogram::now() : 0u) {}
+
+Tracer::Span::~Span() {
+  if (start_ != 0u)
+    record(category_, *name_, start_);
+}
+
+void Tracer::clear() {
+  std::lock_guard<std::mutex> lock(buffersMutex);
+  for (const auto &b : buffers)
+    b->next = 0u;
+}
+
+std::string Tracer::toChromeJSON() {
+  std::lock_guard<std::mutex> lock(buffersMutex);
+  std::stringstream ss;
+  ss << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+  const char *sep = "";
+  for (const auto &b : buffers) {
+    if (b->next == 0u)
+      continue;
+    ss << sep << "\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << b->tid
+       << ", \"args\": {\"name\": \"htm " << b->tid << "\"}}";
+    sep = ",";
+    const UInt64 size = b->events.size();
+    const UInt64 first = b->next > size ? b->next - size : 0u;
+    for (UInt64 i = first; i < b->next; i++) {
+      const Event &e = b->events[i % size];
+      ss << ",\n{\"name\": " << Value::json_string(e.name) << ", \"cat\": \"" << e.category
+         << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << b->tid << ", \"ts\": ";
+      writeMicroseconds(ss, e.start);
+      ss << ", \"dur\": ";
+      writeMicroseconds(ss, e.duration);
+      if (e.copy != nullptr) {
+        ss << ", \"args\": {\"count\": " << e.count << ", \"copy\": \"" << e.copy << "\"";
+        if (e.type != nullptr)
+          ss << ", \"type\": \"" << e.type << "\"";
+        ss << "}";
+      }
+      ss << "}";
+    }
+  }
+  ss << "\n]}\n";
+  return ss.str();
+}
+
+void Tracer::saveChromeTrace(const std::string &path) {
+  std::ofstream out(path);
+  NTA_CHECK(out.is_open()) << "Tracer::saveChromeTrace: cannot open " << path;
+  out << toChromeJSON();
+  NTA_CHECK(out.good()) << "Tracer::saveChromeTrace: writing " << path << " failed";
+}
+
+} // end namespace htm
@@ -0,0 +1,124 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the Tracer class
+ */
+
+#ifndef HTM_UTIL_TRACER_HPP
+#define HTM_UTIL_TRACER_HPP
+
+#include <atomic>
+#include <string>
+
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * Process wide tracer of where the time of Network::run() goes.
+ *
+ * While enabled, Network::run() records a span for every sampled iteration,
+ * and within it for each Region::prepareInputs(), Region::compute(),
+ * Link::compute() (with the number of elements, the type and whether the
+ * data was shared, shallow or deep copied) and callback.  Every thread
+ * writes to its own ring of events without locking, which keeps the newest
+ * events when full.  Iterations which are not sampled cost one relaxed
+ * atomic load per span, so sampling every Nth iteration is cheap enough to
+ * leave on in production.
+ *
+ * The trace is exported in the Chrome trace event JSON format, which both
+ * chrome://tracing and the Perfetto UI (ui.perfetto.dev) open.  Regions
+ * computed by the parallel scheduler (Network::setNumThreads) show up on
+ * the thread which ran them.
+ *
+ * Example:
+ *     Tracer::enable(100);          // trace every 100th iteration
+ *     net.run(10000);
+ *     Tracer::saveChromeTrace("trace.json");
+ *     Tracer::disable();
+ *
+ * enable(), disable(), clear() and the exports must not be called while a
+ * network runs.
+ */
+class Tracer {
+public:
+  /**
+   * @param sampleEvery Traces the iterations which are a multiple of it.
+   * @param capacity    Number of events kept per thread.
+   */
+  static void enable(UInt32 sampleEvery = 1u, size_t capacity = 65536u);
+  static void disable();
+  static bool isEnabled();
+
+  /**
+   * Called by Network::run() when an iteration starts; decides whether the
+   * spans of this iteration are recorded.
+   */
+  static void beginIteration(UInt64 iteration);
+  static void endIteration() { active_.store(false, std::memory_order_relaxed); }
+
+  /**
+   * @return true while the current iteration is traced.
+   */
+  static bool isActive() { return active_.load(std::memory_order_relaxed); }
+
+  /**
+   * Records one complete event on the calling thread.
+   * @param category  A string literal, it is not copied.
+   * @param name      Copied, truncated to 63 characters.
+   * @param start     LatencyHistogram::now() at the start of the span.
+   * @param count     Number of elements, written when copy is not null.
+   * @param copy      A string literal, how the data was moved (ie. "deep"), or null.
+   * @param type      A string literal, the type of the data (see BasicType::getName).
+   */
+  static void record(const char *category, const std::string &name, UInt64 start,
+                     UInt64 count = 0u, const char *copy = nullptr, const char *type = nullptr);
+
+  /**
+   * Records the duration of its own lifetime, if the iteration is traced.
+   */
+  class Span {
+  public:
+    Span(const char *category, const std::string &name);
+    ~Span();
+    Span(const Span &) = delete;
+    Span &operator=(const Span &) = delete;
+
+  private:
+    const char *category_;
+    const std::string *name_;
+    UInt64 start_;
+  };
+
+  /**
+   * Drops all recorded events.
+   */
+  static void clear();
+
+  /**
+   * @return the recorded events as Chrome trace event JSON, in time order per thread.
+   */
+  static std::string toChromeJSON();
+  static void saveChromeTrace(const std::string &path);
+
+private:
+  static std::atomic<bool> active_;
+};
+
+} // end namespace htm
+#endif // HTM_UTIL_TRACER_HPP
@@ -0,0 +1,85 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of unit tests for AnomalyLikelihoodBank
+ */
+
+#include <sstream>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include <htm/algorithms/AnomalyLikelihood.hpp>
+#include <htm/algorithms/AnomalyLikelihoodBank.hpp>
+#include <htm/utils/Random.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+TEST(AnomalyLikelihoodBankTest, SameAsStreamingAnomalyLikelihood) {
+  const UInt numStreams = 7u;
+  // learningPeriod, estimationSamples, historicWindowSize, aggregationWindow
+  AnomalyLikelihoodBank bank(numStreams, 10u, 20u, 60u, 3u);
+  std::vector<AnomalyLikelihood> single;
+  for(UInt s = 0; s < numStreams; s++) {
+    single.emplace_back(10u, 20u, 60u, 20u, 3u, /*streaming*/ true);
+  }
+
+  Random rng(42);
+  std::vector<Real> scores(numStreams);
+  std::vector<Real> likelihoods;
+  for(UInt step = 0; step < 300u; step++) {
+    for(UInt s = 0; s < numStreams; s++) {
+      // each stream has its own level, with occasional spikes
+      scores[s] = 0.1f * s / numStreams + 0.1f * (Real)rng.getReal64();
+      if(rng.getUInt32(50u) == 0u) scores[s] = 1.0f;
+    }
+    bank.anomalyProbability(scores, likelihoods);
+    ASSERT_EQ(likelihoods.size(), numStreams);
+    for(UInt s = 0; s < numStreams; s++) {
+      ASSERT_EQ(likelihoods[s], single[s].anomalyProbability(scores[s]))
+        << "step " << step << " stream " << s;
+    }
+  }
+  EXPECT_EQ(bank.getIteration(), 300u);
+}
+
+
+TEST(AnomalyLikelihoodBankTest, Serialization) {
+  AnomalyLikelihoodBank a(5u, 5u, 5u, 20u, 2u);
+  Random rng(1);
+  std::vector<Real> scores(5u);
+  std::vector<Real> la, lb;
+  for(UInt step = 0; step < 40u; step++) {
+    for(auto &x : scores) x = (Real)rng.getReal64();
+    a.anomalyProbability(scores, la);
+  }
+  std::stringstream ss;
+  a.save(ss);
+  AnomalyLikelihoodBank b;
+  b.load(ss);
+  ASSERT_EQ(a, b);
+
+  for(auto &x : scores) x = (Real)rng.getReal64();
+  a.anomalyProbability(scores, la);
+  b.anomalyProbability(scores, lb);
+  EXPECT_EQ(la, lb);
+  EXPECT_ANY_THROW(a.anomalyProbability(std::vector<Real>(4u), la));
+}
+
+} // namespace testing
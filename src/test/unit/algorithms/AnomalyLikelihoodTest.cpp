@@ -3,6 +3,7 @@
 
 #include "gtest/gtest.h"
 #include <htm/algorithms/AnomalyLikelihood.hpp>
+#include <htm/utils/Random.hpp>
 
 namespace testing {
 
@@ -42,4 +43,70 @@ TEST(DISABLED_AnomalyLikelihood, SerializationLikelihood)
   EXPECT_EQ(a, b);
 }
 
+TEST(AnomalyLikelihood, Streaming)
+{
+  // learningPeriod, estimationSamples, historicWindowSize, reestimationPeriod, aggregationWindow, streaming
+  AnomalyLikelihood a(10, 20, 100, 20, 2, true);
+  Random rng(42);
+  const auto noise = [&](Real base) { return base + 0.05f * rng.getReal64(); };
+
+  for(UInt i = 0; i < a.probationaryPeriod; i++) {
+    ASSERT_EQ(a.anomalyProbability(noise(0.1f)), a.DEFAULT_ANOMALY);
+  }
+  Real likelihood = 0.0f;
+  for(UInt i = 0; i < 50u; i++) {
+    likelihood = a.anomalyProbability(noise(0.1f));
+    ASSERT_GE(likelihood, 0.0f);
+    ASSERT_LE(likelihood, 1.0f);
+  }
+  EXPECT_LT(likelihood, 0.9f);
+
+  // a sustained jump is anomalous at first (both scores averaged in)
+  a.anomalyProbability(0.9f);
+  EXPECT_GT(a.anomalyProbability(0.9f), 0.99f);
+
+  // Serialization keeps the running statistics.
+  std::stringstream ss;
+  a.save(ss);
+  AnomalyLikelihood b(10, 20, 100, 20, 2, true);
+  b.load(ss); // MovingAverage recomputes its total on load, so only near equal
+
+  // ... and once the old scores left the window, it is the new normal.
+  for(UInt i = 0; i < 200u; i++) {
+    const Real score = noise(0.8f);
+    likelihood = a.anomalyProbability(score);
+    ASSERT_NEAR(likelihood, b.anomalyProbability(score), 1.0e-4f);
+  }
+  EXPECT_LT(likelihood, 0.9f);
+}
+
+TEST(AnomalyLikelihood, CompactSerialization)
+{
+  for(const bool streaming : {false, true}) {
+    AnomalyLikelihood a(10, 20, 500, 20, 3, streaming);
+    Random rng(7);
+    for(UInt i = 0; i < 700u; i++) {
+      a.anomalyProbability(0.2f + 0.1f * (Real)rng.getReal64());
+    }
+    std::stringstream full, compact;
+    a.save(full);
+    a.setCompactSerialization(true);
+    a.save(compact);
+    EXPECT_LT(compact.str().size(), full.str().size() * 6u / 10u) << "streaming " << streaming;
+
+    AnomalyLikelihood b(10, 20, 500, 20, 3, streaming);
+    b.load(compact); // the format is detected when loading
+    EXPECT_EQ(b.getCompactSerialization(), false);
+    AnomalyLikelihood c(10, 20, 500, 20, 3, not streaming);
+    compact.seekg(0);
+    EXPECT_ANY_THROW(c.load(compact));
+
+    for(UInt i = 0; i < 100u; i++) {
+      const Real score = (i == 50u) ? 1.0f : 0.2f + 0.1f * (Real)rng.getReal64();
+      ASSERT_NEAR(a.anomalyProbability(score), b.anomalyProbability(score), 1.0e-3f)
+        << "streaming " << streaming << " step " << i;
+    }
+  }
+}
+
 }
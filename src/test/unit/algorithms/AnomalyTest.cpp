@@ -23,6 +23,7 @@
 
 #include "htm/algorithms/Anomaly.hpp"
 #include "htm/types/Types.hpp"
+#include "htm/utils/Random.hpp"
 
 namespace testing {
 
@@ -69,4 +70,63 @@ TEST(ComputeRawAnomalyScore, PartialMatch) {
   ASSERT_FLOAT_EQ(computeRawAnomalyScore(active, predicted), 2.0f / 3.0f);
 };
 
+TEST(ComputeRawAnomalyScore, OverlapKernels) {
+  Random rng(42);
+  for (const Real sparsity : {0.002f, 0.02f, 0.2f, 0.8f}) {
+    SDR a({2000});
+    SDR b({2000});
+    a.randomize(sparsity, rng);
+    b.randomize(0.02f, rng);
+    const UInt expected = a.getOverlap(b);
+
+    const auto &sa = a.getSparse();
+    const auto &sb = b.getSparse();
+    ASSERT_EQ(sparseOverlap(sa.data(), sa.size(), sb.data(), sb.size()), expected);
+    ASSERT_EQ(sparseOverlap(sb.data(), sb.size(), sa.data(), sa.size()), expected);
+
+    const auto &pa = a.getPacked();
+    const auto &pb = b.getPacked();
+    ASSERT_EQ(packedOverlap(pa.data(), pb.data(), pa.size()), expected);
+  }
+  ASSERT_EQ(sparseOverlap(nullptr, 0u, nullptr, 0u), 0u);
+};
+
+TEST(ComputeRawAnomalyScore, Batch) {
+  Random rng(7);
+  std::vector<SDR> active, predicted;
+  std::vector<ElemSparse> flatActive, flatPredicted;
+  std::vector<size_t> activeEnds, predictedEnds;
+  for (UInt i = 0; i < 20; i++) {
+    active.emplace_back(std::vector<UInt>{500});
+    predicted.emplace_back(std::vector<UInt>{500});
+    active.back().randomize(i == 0 ? 0.0f : 0.04f, rng);
+    predicted.back().randomize(0.04f, rng);
+    if (i % 2 == 1) {  // half of them mostly predicted
+      predicted.back().setSDR(active.back());
+      predicted.back().addNoise(0.25f, rng);
+    }
+    const auto &sa = active.back().getSparse();
+    const auto &sp = predicted.back().getSparse();
+    flatActive.insert(flatActive.end(), sa.begin(), sa.end());
+    flatPredicted.insert(flatPredicted.end(), sp.begin(), sp.end());
+    activeEnds.push_back(flatActive.size());
+    predictedEnds.push_back(flatPredicted.size());
+  }
+
+  const auto scores = computeRawAnomalyScores(active, predicted);
+  std::vector<Real> flatScores(active.size());
+  computeRawAnomalyScores(flatActive.data(), activeEnds.data(),
+                          flatPredicted.data(), predictedEnds.data(),
+                          active.size(), flatScores.data());
+  ASSERT_EQ(scores.size(), active.size());
+  for (size_t i = 0; i < active.size(); i++) {
+    const Real expected = computeRawAnomalyScore(active[i], predicted[i]);
+    ASSERT_FLOAT_EQ(scores[i], expected);
+    ASSERT_FLOAT_EQ(flatScores[i], expected);
+  }
+  ASSERT_FLOAT_EQ(scores[0], 0.0f);
+
+  EXPECT_ANY_THROW(computeRawAnomalyScores(active, std::vector<SDR>(1, SDR({500}))));
+};
+
 }
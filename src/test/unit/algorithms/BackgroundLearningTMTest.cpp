@@ -0,0 +1,106 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of unit tests for BackgroundLearningTM
+ */
+
+#include "gtest/gtest.h"
+#include <vector>
+
+#include "htm/algorithms/BackgroundLearningTM.hpp"
+#include "htm/algorithms/TemporalMemory.hpp"
+#include "htm/utils/Random.hpp"
+
+namespace testing {
+
+using namespace htm;
+using std::vector;
+
+// A repeating sequence of random column SDRs.
+static vector<SDR> sequence(const UInt length) {
+  Random rng(17);
+  vector<SDR> steps;
+  for(UInt i = 0u; i < length; i++) {
+    steps.emplace_back(vector<UInt>{100u});
+    steps.back().randomize(0.2f, rng);
+  }
+  return steps;
+}
+
+TEST(BackgroundLearningTMTest, LearnsAsSerialTM) {
+  const auto steps = sequence(8u);
+  BackgroundLearningTM tm(vector<CellIdx>{100u}, 8u);
+  TemporalMemory serial(vector<CellIdx>{100u}, 8u);
+  tm.setQueueCapacity(128u); //all steps, so none is dropped
+  for(UInt repeat = 0u; repeat < 10u; repeat++) {
+    tm.reset();
+    serial.reset();
+    for(const auto &step : steps) {
+      tm.compute(step);
+      serial.compute(step, true);
+    }
+  }
+  tm.sync();
+  EXPECT_EQ(tm.getLag(), 0u);
+  EXPECT_EQ(tm.getDropped(), 0u);
+  EXPECT_GT(tm.getEpoch(), 0u);
+  EXPECT_EQ(tm.getLearner(), serial);
+
+  // after sync() inference uses all that was learned
+  tm.reset();
+  serial.reset();
+  for(const auto &step : steps) {
+    tm.compute(step, false);
+    serial.compute(step, false);
+    EXPECT_EQ(tm.getInference().getActiveCells(), serial.getActiveCells());
+    EXPECT_EQ(tm.getInference().anomaly, serial.anomaly);
+  }
+  EXPECT_LT(tm.getInference().anomaly, 0.5f); //the sequence is known
+  tm.sync();
+  EXPECT_EQ(tm.getLearner(), serial); //learn=false was not learned
+}
+
+TEST(BackgroundLearningTMTest, FullQueue) {
+  const auto steps = sequence(6u);
+  BackgroundLearningTM tm(vector<CellIdx>{100u}, 8u);
+  tm.setQueueCapacity(1u);
+  tm.setPublishInterval(3u);
+  for(UInt repeat = 0u; repeat < 40u; repeat++) {
+    for(const auto &step : steps) tm.compute(step); //never waits for the learner
+    tm.reset();
+  }
+  tm.sync();
+  EXPECT_EQ(tm.getLag(), 0u);
+  EXPECT_LT(tm.getDropped(), 240u); //the first step at least is learned
+  EXPECT_TRUE(tm.getInference().connections.sharesTopology(tm.getLearner().connections));
+}
+
+TEST(BackgroundLearningTMTest, Settings) {
+  BackgroundLearningTM tm(vector<CellIdx>{100u}, 8u);
+  EXPECT_ANY_THROW(tm.setPublishInterval(0u));
+  EXPECT_ANY_THROW(tm.setQueueCapacity(0u));
+  tm.setQueueCapacity(4u);
+  EXPECT_EQ(tm.getQueueCapacity(), 4u);
+  SDR columns({100u});
+  tm.compute(columns);
+  EXPECT_ANY_THROW(tm.setQueueCapacity(8u));
+  EXPECT_ANY_THROW(tm.setPublishInterval(2u));
+  EXPECT_ANY_THROW(BackgroundLearningTM(vector<CellIdx>{100u}, 8u, 13u, 0.21f, 0.5f, 10u, 10u, 0.1f, 0.1f, 0.0f, 42, 255u, 255u, true, 10u));
+}
+
+} // namespace testing
@@ -22,7 +22,14 @@
 #include "gtest/gtest.h"
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <type_traits>
 #include <htm/algorithms/Connections.hpp>
+#include <htm/algorithms/ConnectionsDelta.hpp>
+#include <htm/os/Path.hpp>
 
 using namespace std;
 using namespace htm;
@@ -412,6 +419,52 @@ TEST(ConnectionsTest, testAdaptSynapses) {
   }
 }
 
+TEST(ConnectionsTest, testAdaptSegments) {
+  // batched adaptSegments == adaptSegment one by one, also with pruning
+  const auto exists = [](const Connections &c, const Segment seg) {
+    const auto &onCell = c.segmentsForCell(seg); //segment i is on cell i
+    return std::find(onCell.begin(), onCell.end(), seg) != onCell.end();
+  };
+  for(const bool prune : {false, true}) {
+    Connections single(100, 0.5f);
+    Random rng(23);
+    for(UInt i = 0; i < 20; i++) {
+      const Segment seg = single.createSegment(i);
+      for(UInt j = 0; j < 10; j++) {
+        single.createSynapse(seg, rng.getUInt32(100), static_cast<Permanence>(rng.getReal64() * 0.2));
+      }
+    }
+    Connections batched = single;
+
+    SDR input({100u});
+    const vector<Segment> segments = {13, 2, 7, 19, 0, 5};
+    for(UInt iter = 0; iter < 5; iter++) {
+      input.randomize(0.3f, rng);
+      for(const auto seg : segments) {
+        if(not exists(single, seg)) continue;
+        single.adaptSegment(seg, input, 0.05f, 0.04f, prune, prune ? 8 : 0);
+      }
+      vector<Segment> existing;
+      for(const auto seg : segments) {
+        if(exists(batched, seg)) existing.push_back(seg);
+      }
+      batched.adaptSegments(existing, input, 0.05f, 0.04f, prune, prune ? 8 : 0);
+      if(not prune) single.adaptSegments({}, input, 0.05f, 0.04f); //no-op
+    }
+
+    ASSERT_EQ(single.numSegments(), batched.numSegments());
+    ASSERT_EQ(single.numSynapses(), batched.numSynapses());
+    for(Segment seg = 0; seg < single.segmentFlatListLength(); seg++) {
+      ASSERT_EQ(exists(single, seg), exists(batched, seg));
+      if(not exists(single, seg)) continue;
+      ASSERT_EQ(single.synapsesForSegment(seg), batched.synapsesForSegment(seg));
+      for(const auto syn : single.synapsesForSegment(seg)) {
+        ASSERT_EQ(single.permanenceForSynapse(syn), batched.permanenceForSynapse(syn));
+      }
+    }
+  }
+}
+
 TEST(ConnectionsTest, testRaisePermanencesToThreshold) {
   UInt stimulusThreshold = 3;
   Real synPermConnected = 0.1f;
@@ -871,3 +924,1060 @@ TEST(ConnectionsTest, testTimeseries) {
     ASSERT_TRUE( (synData.permanence == 0.0f) or (synData.permanence == 1.0f) );
   }
 }
+
+TEST(ConnectionsTest, testTimeseriesPreparedAdapt) {
+  // The timeseries updates of prepareAdaptSegments() on threads are the same
+  // as of adaptSegment().
+  Connections serial(20, .5f, true), parallel(20, .5f, true);
+  parallel.setNumThreads(3);
+  Random rng(3);
+  vector<Segment> segments;
+  for(CellIdx cell = 10; cell < 20; cell++) {
+    const Segment seg = serial.createSegment(cell);
+    parallel.createSegment(cell);
+    segments.push_back(seg);
+    for(CellIdx presyn = 0; presyn < 10; presyn++) {
+      const Permanence perm = rng.getReal64() < 0.5 ? 0.3f : 0.6f;
+      serial.createSynapse(seg, presyn, perm);
+      parallel.createSynapse(seg, presyn, perm);
+    }
+  }
+  SDR presyn({20u});
+  for(int step = 0; step < 12; step++) {
+    if(step % 4 == 0) presyn.randomize(0.3f, rng); //hold the input for a few steps
+    serial.computeActivity(presyn.getSparse());
+    parallel.computeActivity(presyn.getSparse());
+    vector<SegmentAdaptation> adaptations;
+    for(const auto seg : segments) {
+      serial.adaptSegment(seg, presyn, 0.05f, 0.02f, false);
+      adaptations.push_back({seg, 0.05f, 0.02f, {}, {}, {}});
+    }
+    parallel.prepareAdaptSegments(adaptations, presyn, false);
+    for(const auto &adaptation : adaptations) parallel.finishAdaptSegment(adaptation, false);
+    ASSERT_EQ(serial, parallel) << "step " << step;
+  }
+}
+
+TEST(ConnectionsTest, testSynapseArrays) {
+  // the per-synapse data must not carry a vtable
+  static_assert(not std::is_polymorphic<SynapseData>::value, "SynapseData must be a plain struct");
+  static_assert(not std::is_polymorphic<SegmentData>::value, "SegmentData must be a plain struct");
+
+  Connections connections(10, 0.5f);
+  const Segment segment = connections.createSegment(3);
+  const Synapse syn1 = connections.createSynapse(segment, 7, 0.6f);
+  const Synapse syn2 = connections.createSynapse(segment, 2, 0.2f);
+
+  for(const Synapse syn : {syn1, syn2}) {
+    const SynapseData data = connections.dataForSynapse(syn);
+    ASSERT_EQ(data.permanence,      connections.permanenceForSynapse(syn));
+    ASSERT_EQ(data.presynapticCell, connections.presynapticCellForSynapse(syn));
+    ASSERT_EQ(data.segment,         connections.segmentForSynapse(syn));
+  }
+  ASSERT_EQ(connections.presynapticCellForSynapse(syn1), 7u);
+  ASSERT_FLOAT_EQ(connections.permanenceForSynapse(syn2), 0.2f);
+
+  connections.destroySynapse(syn1);
+  ASSERT_EQ(connections.presynapticCellForSynapse(syn2), 2u);
+  ASSERT_EQ(connections.synapsesForSegment(segment), vector<Synapse>{syn2});
+}
+
+TEST(ConnectionsTest, testPermanencePrecision) {
+  for(const auto precision : {PermanencePrecision::UINT16, PermanencePrecision::UINT8}) {
+    Connections c(10, 0.5f, false, precision);
+    ASSERT_EQ(c.getPermanencePrecision(), precision);
+    const Real step = 1.0f / (precision == PermanencePrecision::UINT8 ? 254.0f : 65534.0f);
+
+    const Segment segment = c.createSegment(0);
+    const Synapse low  = c.createSynapse(segment, 1, 0.3f);
+    const Synapse high = c.createSynapse(segment, 2, 0.7f);
+    ASSERT_NEAR(c.permanenceForSynapse(low),  0.3f, step);
+    ASSERT_NEAR(c.permanenceForSynapse(high), 0.7f, step);
+    ASSERT_EQ(c.dataForSegment(segment).numConnected, 1u);
+
+    // (dis)connecting at the threshold
+    c.updateSynapsePermanence(low, 0.5f);
+    ASSERT_EQ(c.dataForSegment(segment).numConnected, 2u);
+    c.updateSynapsePermanence(low, 0.5f - 2 * step);
+    ASSERT_EQ(c.dataForSegment(segment).numConnected, 1u);
+
+    // bumps are never rounded away
+    c.synapseCompetition(segment, 2, 2);
+    ASSERT_EQ(c.dataForSegment(segment).numConnected, 2u);
+
+    stringstream ss;
+    c.save(ss);
+    Connections loaded;
+    loaded.load(ss);
+    ASSERT_EQ(c, loaded);
+    ASSERT_EQ(loaded.getPermanencePrecision(), precision);
+
+    c.destroySynapse(high);
+    ASSERT_EQ(c.synapsesForSegment(segment), vector<Synapse>{low});
+  }
+
+  // converting keeps the values, within the precision
+  Connections c(10, 0.5f);
+  const Segment segment = c.createSegment(0);
+  const Synapse syn = c.createSynapse(segment, 1, 0.123456f);
+  c.setPermanencePrecision(PermanencePrecision::UINT8);
+  ASSERT_NEAR(c.permanenceForSynapse(syn), 0.123456f, 0.5f / 254.0f);
+  c.setPermanencePrecision(PermanencePrecision::FLOAT32);
+  ASSERT_NEAR(c.permanenceForSynapse(syn), 0.123456f, 0.5f / 254.0f);
+}
+
+TEST(ConnectionsTest, testPermanencePrecisionAtThreshold) {
+  // 0.499 rounds up to the threshold 0.5 (connects), 0.5015 rounds down
+  // below the threshold 0.501 (disconnects), both on the UINT8 grid.
+  for(const bool flat : {false, true}) {
+    for(const auto &threshold_perm : vector<pair<Real, Real>>{{0.5f, 0.499f}, {0.501f, 0.5015f}}) {
+      const Real threshold = threshold_perm.first;
+      const Real perm      = threshold_perm.second;
+      Connections c(10, threshold);
+      Connections expected(10, threshold, false, PermanencePrecision::UINT8);
+      c.setFlatIndex(flat);
+      expected.setFlatIndex(flat);
+      for(Connections *con : {&c, &expected}) {
+        const Segment segment = con->createSegment(0);
+        con->createSynapse(segment, 1, perm);
+        con->createSynapse(segment, 2, 0.9f);
+      }
+      const vector<CellIdx> input{1, 2};
+      vector<SynapseIdx> potential;
+      ASSERT_EQ(c.computeActivity(potential, input, false), vector<SynapseIdx>{static_cast<SynapseIdx>(perm >= threshold ? 2u : 1u)});
+
+      c.setPermanencePrecision(PermanencePrecision::UINT8);
+      const Segment segment = c.getSegment(0, 0);
+      ASSERT_EQ(c.dataForSegment(segment).numConnected, expected.dataForSegment(segment).numConnected);
+      ASSERT_EQ(c.dataForSegment(segment).numConnected, perm >= threshold ? 1u : 2u);
+      vector<SynapseIdx> expectedPotential;
+      ASSERT_EQ(c.computeActivity(potential, input, false), expected.computeActivity(expectedPotential, input, false));
+      ASSERT_EQ(potential, expectedPotential);
+
+      // and back, the stored values are on the grid so nothing flips
+      c.setPermanencePrecision(PermanencePrecision::FLOAT32);
+      ASSERT_EQ(c.dataForSegment(segment).numConnected, expected.dataForSegment(segment).numConnected);
+      ASSERT_EQ(c.computeActivity(potential, input, false), expected.computeActivity(expectedPotential, input, false));
+    }
+  }
+}
+
+TEST(ConnectionsTest, testCheckpoint) {
+  const char *filename = "ConnectionsCheckpoint.tmp";
+  for(const auto precision : {PermanencePrecision::FLOAT32, PermanencePrecision::UINT16, PermanencePrecision::UINT8}) {
+    Connections c(20, 0.5f, true, precision);
+    Random rng(42);
+    for(CellIdx cell = 0; cell < 10; cell++) {
+      for(int s = 0; s < 3; s++) {
+        const Segment segment = c.createSegment(cell);
+        for(CellIdx pre = 0; pre < 8; pre++) {
+          c.createSynapse(segment, rng.getUInt32(20), rng.getReal64() > 0.5 ? 0.6f : 0.3f);
+        }
+      }
+    }
+    c.destroySegment(c.getSegment(3, 1)); //leaves holes
+    c.destroySynapse(c.synapsesForSegment(c.getSegment(4, 0))[0]);
+    SDR input({20u});
+    input.setSparse(SDR_sparse_t{0, 2, 4, 6});
+    c.computeActivity(input.getSparse());
+    c.adaptSegment(c.getSegment(0, 0), input, 0.05f, 0.01f); //timeseries updates
+
+    c.saveCheckpoint(filename);
+    Connections loaded;
+    loaded.loadCheckpoint(filename);
+    ASSERT_EQ(c, loaded);
+    ASSERT_EQ(loaded.getPermanencePrecision(), precision);
+
+    // both keep working the same
+    SDR active({20u});
+    active.setSparse(SDR_sparse_t{1, 3, 5, 7, 9, 11});
+    vector<SynapseIdx> potential1(c.segmentFlatListLength(), 0);
+    vector<SynapseIdx> potential2(loaded.segmentFlatListLength(), 0);
+    const auto connected1 = c.computeActivity(potential1, active.getSparse());
+    const auto connected2 = loaded.computeActivity(potential2, active.getSparse());
+    ASSERT_EQ(connected1, connected2);
+    ASSERT_EQ(potential1, potential2);
+    for(CellIdx cell = 0; cell < 20; cell += 4) {
+      const Segment s1 = c.createSegment(cell);
+      const Segment s2 = loaded.createSegment(cell);
+      ASSERT_EQ(s1, s2);
+      c.createSynapse(s1, 19, 0.7f);
+      loaded.createSynapse(s2, 19, 0.7f);
+      c.adaptSegment(s1, active, 0.1f, 0.1f, true);
+      loaded.adaptSegment(s2, active, 0.1f, 0.1f, true);
+    }
+    ASSERT_EQ(c, loaded);
+  }
+
+  // several models in one file
+  Connections a(5, 0.5f), b(7, 0.4f);
+  a.createSynapse(a.createSegment(1), 2, 0.6f);
+  {
+    CheckpointWriter writer(filename);
+    a.saveCheckpoint(writer, "a.");
+    b.saveCheckpoint(writer, "b.");
+    writer.close();
+  }
+  {
+    const CheckpointReader reader(filename);
+    ASSERT_EQ(reader.getVersion(), CheckpointWriter::VERSION);
+    ASSERT_TRUE(reader.has("a.synapses.id"));
+    ASSERT_EQ(reader.view<Synapse>("a.synapses.id").second, 1u);
+    Connections a2, b2;
+    a2.loadCheckpoint(reader, "a.");
+    b2.loadCheckpoint(reader, "b.");
+    ASSERT_EQ(a, a2);
+    ASSERT_EQ(b, b2);
+    EXPECT_ANY_THROW(a2.loadCheckpoint(reader)); //no such sections
+  }
+
+  // streamed: uploaded in parts, restored with ranged reads
+  {
+    std::mutex mutex;
+    std::map<size_t, std::string> parts;
+    size_t completed = 0u;
+    MultipartSink sink([&](size_t part, const char *data, size_t bytes) {
+                         const std::lock_guard<std::mutex> lock(mutex);
+                         parts[part].assign(data, bytes);
+                       },
+                       [&](size_t numParts) { completed = numParts; }, 100u, 3u);
+    {
+      CheckpointWriter writer(sink);
+      a.saveCheckpoint(writer, "a.");
+      b.saveCheckpoint(writer, "b.");
+      writer.close();
+    }
+    ASSERT_GT(completed, 3u);
+    ASSERT_EQ(completed, parts.size());
+    std::string object;
+    for (const auto &part : parts) {
+      ASSERT_TRUE(part.second.size() == 100u || part.first + 1u == completed);
+      object += part.second;
+    }
+    ASSERT_EQ(object, std::string(std::istreambuf_iterator<char>(std::ifstream(filename, std::ios_base::binary).rdbuf()),
+                                  std::istreambuf_iterator<char>()));
+
+    size_t reads = 0u;
+    const RangeSource source([&](UInt64 offset, char *data, size_t bytes) {
+                               reads++;
+                               ASSERT_LE(offset + bytes, object.size());
+                               std::memcpy(data, object.data() + offset, bytes);
+                             }, object.size());
+    const CheckpointReader reader(source);
+    Connections a2, b2;
+    a2.loadCheckpoint(reader, "a.");
+    b2.loadCheckpoint(reader, "b.");
+    ASSERT_EQ(a, a2);
+    ASSERT_EQ(b, b2);
+    ASSERT_GT(reads, 2u); // header, trailer, table and sections apart
+
+    const FileSource file(filename);
+    const CheckpointReader fileReader(file);
+    ASSERT_EQ(fileReader.readSection("a.synapses.id"), reader.readSection("a.synapses.id"));
+
+    // a part which fails to upload fails the checkpoint, which is not completed
+    completed = 0u;
+    MultipartSink failing([](size_t part, const char *, size_t) { if (part == 1u) throw std::runtime_error("upload"); },
+                          [&](size_t numParts) { completed = numParts; }, 100u, 1u);
+    CheckpointWriter writer(failing);
+    EXPECT_ANY_THROW({
+      a.saveCheckpoint(writer, "a.");
+      b.saveCheckpoint(writer, "b.");
+      writer.close();
+    });
+    writer.abandon();
+    ASSERT_EQ(completed, 0u);
+  }
+
+  // not a checkpoint
+  {
+    std::ofstream out(filename, std::ios_base::binary | std::ios_base::trunc);
+    out << "something else entirely, long enough for a header";
+  }
+  Connections other;
+  EXPECT_ANY_THROW(other.loadCheckpoint(filename));
+  int ret = ::remove(filename);
+  ASSERT_TRUE(ret == 0) << "Failed to delete " << filename;
+}
+
+TEST(ConnectionsTest, testDeltaCheckpoint) {
+  const char *baseFile  = "ConnectionsDeltaBase.tmp";
+  const char *deltaFile = "ConnectionsDeltaDelta.tmp";
+  Connections c(1000, 0.5f);
+  Random rng(7);
+  auto grow = [&](CellIdx first, CellIdx last) {
+    for(CellIdx cell = first; cell < last; cell++) {
+      const Segment segment = c.createSegment(cell);
+      for(int i = 0; i < 20; i++) {
+        c.createSynapse(segment, rng.getUInt32(1000), rng.getReal64() > 0.5 ? 0.55f : 0.45f);
+      }
+    }
+  };
+  grow(0, 500);
+
+  ConnectionsDelta delta(c);
+  ASSERT_TRUE(delta.needsBase());
+  {
+    CheckpointWriter writer(baseFile);
+    delta.saveBase(writer);
+  }
+  ASSERT_FALSE(delta.needsBase());
+  ASSERT_EQ(delta.numChangedSegments(), 0u);
+
+  // a few changes of all kinds
+  grow(500, 510);
+  c.destroySegment(c.getSegment(3, 0));
+  const Segment adapted = c.getSegment(7, 0);
+  c.destroySynapse(c.synapsesForSegment(adapted)[0]);
+  SDR active({1000u});
+  active.randomize(0.5f, rng);
+  c.adaptSegment(adapted, active, 0.1f, 0.1f, false); //(dis)connects some
+  c.dataForSegment(c.getSegment(9, 0)).lastUsed = 1234u;
+  EXPECT_EQ(delta.numChangedSegments(), 12u);
+  EXPECT_EQ(delta.numChangedCells(), 11u);
+
+  {
+    const CheckpointReader base(baseFile);
+    CheckpointWriter writer(deltaFile);
+    delta.saveDelta(writer, base);
+  }
+  EXPECT_LT(Path::getFileSize(deltaFile) * 4u, Path::getFileSize(baseFile));
+
+  Connections restored;
+  {
+    const CheckpointReader base(baseFile);
+    const CheckpointReader changes(deltaFile);
+    ConnectionsDelta::load(restored, base, changes);
+  }
+  ASSERT_EQ(c, restored);
+  ASSERT_EQ(restored.dataForSegment(restored.getSegment(9, 0)).lastUsed, 1234u);
+
+  // compacting renumbers all, a new base is needed
+  c.compact();
+  ASSERT_TRUE(delta.needsBase());
+  {
+    const CheckpointReader base(baseFile);
+    CheckpointWriter writer(deltaFile);
+    EXPECT_ANY_THROW(delta.saveDelta(writer, base));
+  }
+
+  Path::remove(baseFile);
+  Path::remove(deltaFile);
+}
+
+class CompactEventHandler : public ConnectionsEventHandler {
+public:
+  void onCompact(const vector<Segment> &segments, const vector<Synapse> &synapses) override {
+    newSegments = segments;
+    newSynapses = synapses;
+  }
+  vector<Segment> newSegments;
+  vector<Synapse> newSynapses;
+};
+
+TEST(ConnectionsTest, testCompact) {
+  Connections connections(10, 0.5f);
+  Random rng(5);
+  for(CellIdx cell = 0; cell < 10; cell++) {
+    for(UInt i = 0; i < 3; i++) {
+      const Segment segment = connections.createSegment(cell);
+      for(CellIdx presyn = 0; presyn < 10; presyn++) {
+        connections.createSynapse(segment, presyn, static_cast<Permanence>(rng.getReal64()));
+      }
+    }
+  }
+  connections.destroySegment(connections.getSegment(3, 1));
+  connections.destroySegment(connections.getSegment(7, 0));
+  const Segment segment = connections.getSegment(5, 2);
+  const Synapse destroyed = connections.synapsesForSegment(segment)[4];
+  const CellIdx destroyedPresyn = connections.presynapticCellForSynapse(destroyed);
+  connections.destroySynapse(destroyed);
+
+  const vector<CellIdx> input = {0, 2, 3, 8};
+  vector<SynapseIdx> potentialBefore(connections.segmentFlatListLength(), 0);
+  const auto connectedBefore = connections.computeActivity(potentialBefore, input, false);
+  const Connections before = connections;
+
+  CompactEventHandler handler;
+  connections.subscribe(&handler);
+  connections.compact();
+
+  ASSERT_EQ(connections.segmentFlatListLength(), connections.numSegments());
+  ASSERT_EQ(connections.numSegments(), 28u);
+  ASSERT_EQ(connections.numSynapses(), 28u * 10u - 1u);
+  ASSERT_EQ(handler.newSegments.size(), before.segmentFlatListLength());
+
+  // same segments & synapses & activity, just renumbered
+  vector<SynapseIdx> potentialAfter(connections.segmentFlatListLength(), 0);
+  const auto connectedAfter = connections.computeActivity(potentialAfter, input, false);
+  for(Segment old = 0; old < handler.newSegments.size(); old++) {
+    const Segment seg = handler.newSegments[old];
+    if(seg == std::numeric_limits<Segment>::max()) continue;
+    ASSERT_EQ(connections.cellForSegment(seg), before.cellForSegment(old));
+    ASSERT_EQ(connectedAfter[seg], connectedBefore[old]);
+    ASSERT_EQ(potentialAfter[seg], potentialBefore[old]);
+    const auto &oldSynapses = before.synapsesForSegment(old);
+    const auto &newSynapses = connections.synapsesForSegment(seg);
+    ASSERT_EQ(oldSynapses.size(), newSynapses.size());
+    for(size_t i = 0; i < oldSynapses.size(); i++) {
+      ASSERT_EQ(handler.newSynapses[oldSynapses[i]], newSynapses[i]);
+      ASSERT_EQ(connections.dataForSynapse(newSynapses[i]).id, before.dataForSynapse(oldSynapses[i]).id);
+      ASSERT_EQ(connections.permanenceForSynapse(newSynapses[i]), before.permanenceForSynapse(oldSynapses[i]));
+    }
+  }
+  ASSERT_EQ(handler.newSynapses[destroyed], std::numeric_limits<Synapse>::max());
+  ASSERT_EQ(handler.newSegments[before.getSegment(5, 2)], connections.getSegment(5, 2));
+
+  // still fully functional
+  const Segment seg = connections.getSegment(5, 2);
+  connections.createSynapse(seg, destroyedPresyn, 0.9f);
+  ASSERT_EQ(connections.numSynapses(seg), 10u);
+  connections.destroySegment(seg);
+  ASSERT_EQ(connections.numSegments(), 27u);
+
+  // automatic compaction
+  ASSERT_ANY_THROW(connections.setCompactThreshold(1.5f));
+  connections.setCompactThreshold(0.01f);
+  connections.computeActivity(input, false);
+  ASSERT_EQ(connections.segmentFlatListLength(), 27u);
+}
+
+TEST(ConnectionsTest, testFlatIndex) {
+  // The flat presynaptic index must give exactly the same activity as the
+  // default path, while synapses are created, (dis)connected and destroyed.
+  Connections hashed(100, 0.5f);
+  Connections flat(100, 0.5f);
+  flat.setFlatIndex(true);
+  ASSERT_TRUE(flat.getFlatIndex());
+
+  Random rng(42);
+  SDR input({ 200u });
+  for(UInt iter = 0; iter < 100; iter++) {
+    input.randomize(0.1f, rng);
+    for(auto *C : {&hashed, &flat}) {
+      if(iter % 10 == 0) {
+        const auto seg = C->createSegment(iter % 100);
+        for(UInt i = 0; i < 20; i++) {
+          C->createSynapse(seg, (iter * 7 + i * 13) % 200, 0.45f + (i % 3) * 0.05f);
+        }
+      }
+      if(iter % 25 == 24) {
+        C->destroySegment(0);
+      }
+    }
+
+    vector<SynapseIdx> potentialHashed(hashed.segmentFlatListLength(), 0);
+    vector<SynapseIdx> potentialFlat(flat.segmentFlatListLength(), 0);
+    const auto connectedHashed = hashed.computeActivity(potentialHashed, input.getSparse());
+    const auto connectedFlat   = flat.computeActivity(potentialFlat, input.getSparse());
+    ASSERT_EQ(connectedHashed, connectedFlat) << "iteration " << iter;
+    ASSERT_EQ(potentialHashed, potentialFlat) << "iteration " << iter;
+
+    for(Segment seg = 0; seg < hashed.segmentFlatListLength(); seg++) {
+      if(hashed.numSynapses(seg) == 0) continue;
+      hashed.adaptSegment(seg, input, 0.05f, 0.02f, true);
+      flat.adaptSegment(seg, input, 0.05f, 0.02f, true);
+    }
+  }
+  ASSERT_EQ(hashed, flat);
+}
+
+TEST(ConnectionsTest, testNumThreads) {
+  // Threaded activity must be identical to the single threaded one,
+  // for both the hash-map and the flat index.
+  Connections serial(2000, 0.5f);
+  ASSERT_EQ(serial.getNumThreads(), 1u);
+  Random rng(11);
+  for(CellIdx cell = 0; cell < 2000; cell += 2) {
+    const auto seg = serial.createSegment(cell);
+    for(UInt i = 0; i < 30; i++) {
+      serial.createSynapse(seg, rng.getUInt32(2000), static_cast<Permanence>(rng.getReal64()));
+    }
+  }
+
+  for(const bool flatIndex : {false, true}) {
+    Connections threaded = serial;
+    threaded.setFlatIndex(flatIndex);
+    threaded.setNumThreads(4);
+    ASSERT_EQ(threaded.getNumThreads(), 4u);
+
+    SDR input({ 2000u });
+    for(const Real sparsity : {0.01f, 0.2f, 0.9f}) {
+      input.randomize(sparsity, rng);
+      vector<SynapseIdx> potentialSerial(serial.segmentFlatListLength(), 0);
+      vector<SynapseIdx> potentialThreaded(threaded.segmentFlatListLength(), 0);
+      const auto connectedSerial   = serial.computeActivity(potentialSerial, input.getSparse(), false);
+      const auto connectedThreaded = threaded.computeActivity(potentialThreaded, input.getSparse(), false);
+      ASSERT_EQ(connectedSerial, connectedThreaded) << "sparsity " << sparsity;
+      ASSERT_EQ(potentialSerial, potentialThreaded) << "sparsity " << sparsity;
+    }
+    threaded.setNumThreads(0);
+    ASSERT_EQ(threaded.getNumThreads(), 1u);
+  }
+}
+
+TEST(ConnectionsTest, testCreateSynapses) {
+  Connections bulk(100, 0.5f);
+  Connections single(100, 0.5f);
+  const vector<CellIdx>    cells = { 3, 10, 11, 42, 99 };
+  const vector<Permanence> perms = { 0.1f, 0.6f, 0.4f, 0.9f, 0.5f };
+  const vector<CellIdx>    more  = { 11, 7, 11 }; //duplicates of existing and new
+  const vector<Permanence> morePerms = { 0.7f, 0.2f, 0.3f };
+  for(Connections *c : {&bulk, &single}) {
+    c->createSegment(1);
+    c->createSegment(2);
+  }
+  bulk.createSynapses(0, cells, perms);
+  bulk.createSynapses(1, more, morePerms);
+  bulk.createSynapses(0, more, morePerms);
+  for(size_t i = 0; i < cells.size(); i++) single.createSynapse(0, cells[i], perms[i]);
+  for(size_t i = 0; i < more.size(); i++)  single.createSynapse(1, more[i], morePerms[i]);
+  for(size_t i = 0; i < more.size(); i++)  single.createSynapse(0, more[i], morePerms[i]);
+
+  EXPECT_EQ(bulk, single);
+  EXPECT_EQ(bulk.numSynapses(), 8u);
+  EXPECT_EQ(bulk.dataForSegment(0).numConnected, 4u);
+  EXPECT_ANY_THROW(bulk.createSynapses(0, cells, morePerms));
+}
+
+TEST(ConnectionsTest, testGrowSynapsesBatched) {
+  // growSynapses() inserts at once, the result is as with one createSynapse() per candidate.
+  const auto reference = [](Connections &c, const Segment segment, const vector<CellIdx> &growthCandidates,
+                            const Permanence permanence, Random &rng, const size_t maxNew, const size_t maxSynapses,
+                            const bool sampled) {
+    vector<CellIdx> candidates = growthCandidates;
+    size_t nActual = maxNew == 0 ? candidates.size() : std::min(maxNew, candidates.size());
+    if(maxSynapses > 0) {
+      const Int overrun = static_cast<Int>(c.numSynapses(segment) + nActual - maxSynapses);
+      if(overrun > 0) c.destroyMinPermanenceSynapses(segment, overrun, candidates);
+      nActual = std::min(nActual, maxSynapses - c.numSynapses(segment));
+    }
+    const size_t nDesired = c.numSynapses(segment) + nActual;
+    const bool pickRandomly = maxNew > 0 and maxNew < candidates.size();
+    if(pickRandomly and not sampled) rng.shuffle(candidates.begin(), candidates.end());
+    for(size_t i = 0; i < candidates.size() and c.numSynapses(segment) < nDesired; i++) {
+      if(pickRandomly and sampled) rng.sampleInPlace(candidates.begin() + i, candidates.end(), 1u);
+      c.createSynapse(segment, candidates[i], permanence);
+    }
+  };
+
+  for(const bool flatIndex : {false, true}) {
+    for(const bool sampled : {false, true}) {
+      Connections batched(1024, 0.5f);
+      Connections single(1024, 0.5f);
+      batched.setSampledGrowth(sampled);
+      Random rngBatched(7), rngSingle(7), data(11);
+      for(Connections *c : {&batched, &single}) {
+        c->setFlatIndex(flatIndex);
+        for(CellIdx cell = 0; cell < 8; cell++) c->createSegment(cell);
+        c->createSynapse(0, 5, 0.3f);
+        c->createSynapse(0, 9, 0.7f);
+      }
+      for(UInt round = 0; round < 40; round++) {
+        const Segment segment = data.getUInt32(8);
+        vector<CellIdx> candidates(data.getUInt32(30));
+        for(auto &cell : candidates) cell = data.getUInt32(40); //duplicates, also of existing synapses
+        if(not flatIndex and round % 5 == 0) candidates.push_back((1u << 24) + round % 2); //beyond the bitmap
+        const Permanence permanence = round % 2 ? 0.6f : 0.2f;
+        const size_t maxNew      = data.getUInt32(12);
+        const size_t maxSynapses = round % 3 ? 0u : 24u;
+        batched.growSynapses(segment, candidates, permanence, rngBatched, maxNew, maxSynapses);
+        reference(single, segment, candidates, permanence, rngSingle, maxNew, maxSynapses, sampled);
+        ASSERT_EQ(batched, single) << "round " << round << (sampled ? ", sampled" : "");
+        ASSERT_EQ(batched.numSynapses(), single.numSynapses());
+        for(Segment seg = 0; seg < 8; seg++) {
+          ASSERT_EQ(batched.dataForSegment(seg).numConnected, single.dataForSegment(seg).numConnected);
+          ASSERT_EQ(batched.synapsesForSegment(seg), single.synapsesForSegment(seg));
+        }
+      }
+      SDR input({ 1024u });
+      input.setSparse(SDR_sparse_t{1u, 5u, 9u, 17u, 33u});
+      EXPECT_EQ(batched.computeActivity(input.getSparse(), false),
+                single.computeActivity(input.getSparse(), false));
+    }
+  }
+}
+
+TEST(ConnectionsTest, testBulkLoad) {
+  // Same state as creating the segments and synapses one by one.
+  Random rng(5);
+  vector<CellIdx> segmentCells;
+  vector<Synapse> offsets = { 0u };
+  vector<CellIdx> presynaptic;
+  vector<Permanence> permanences;
+  for(UInt s = 0; s < 300; s++) {
+    segmentCells.push_back(rng.getUInt32(100));
+    vector<CellIdx> inputs(500);
+    std::iota(inputs.begin(), inputs.end(), 0u);
+    for(const auto cell : rng.sample<CellIdx>(inputs, rng.getUInt32(40))) {
+      presynaptic.push_back(cell);
+      permanences.push_back(static_cast<Permanence>(rng.getReal64() * 1.2 - 0.1));
+    }
+    offsets.push_back(static_cast<Synapse>(presynaptic.size()));
+  }
+
+  for(const auto precision : {PermanencePrecision::FLOAT32, PermanencePrecision::UINT8}) {
+    Connections single(100, 0.5f, false, precision);
+    for(UInt s = 0; s < segmentCells.size(); s++) {
+      const Segment segment = single.createSegment(segmentCells[s]);
+      for(Synapse i = offsets[s]; i < offsets[s + 1]; i++) {
+        single.createSynapse(segment, presynaptic[i], permanences[i]);
+      }
+    }
+    for(const UInt numThreads : {1u, 3u}) {
+      Connections bulk(100, 0.5f, false, precision);
+      bulk.setNumThreads(numThreads);
+      bulk.bulkLoad(segmentCells, offsets, presynaptic, permanences);
+      ASSERT_EQ(bulk, single) << "threads " << numThreads;
+
+      bulk.setFlatIndex(true);
+      SDR input({ 500u });
+      input.randomize(0.1f, rng);
+      vector<SynapseIdx> potentialBulk(bulk.segmentFlatListLength(), 0);
+      vector<SynapseIdx> potentialSingle(single.segmentFlatListLength(), 0);
+      ASSERT_EQ(bulk.computeActivity(potentialBulk, input.getSparse(), false),
+                single.computeActivity(potentialSingle, input.getSparse(), false));
+      ASSERT_EQ(potentialBulk, potentialSingle);
+      EXPECT_ANY_THROW(bulk.bulkLoad(segmentCells, offsets, presynaptic, permanences)); //not empty
+    }
+  }
+
+  Connections c(100, 0.5f);
+  EXPECT_ANY_THROW(c.bulkLoad({ 1u }, { 0u, 2u }, { 7u, 7u }, { 0.1f, 0.2f })); //repeated cell
+  EXPECT_ANY_THROW(c.bulkLoad({ 1u }, { 0u, 2u }, { 7u, 8u }, { 0.1f }));
+  EXPECT_ANY_THROW(c.bulkLoad({ 1u }, { 0u, 1u }, { 7u, 8u }, { 0.1f, 0.2f }));
+  EXPECT_ANY_THROW(c.bulkLoad({ 100u }, { 0u, 1u }, { 7u }, { 0.1f }));
+  EXPECT_EQ(c.numSegments(), 0u);
+  c.bulkLoad({ 1u, 1u }, { 0u, 0u, 1u }, { 7u }, { 0.7f });
+  EXPECT_EQ(c.numSegments(1u), 2u);
+  EXPECT_EQ(c.numSynapses(), 1u);
+}
+
+TEST(ConnectionsTest, testBulkExport) {
+  // Export, edit and load again, for every precision.
+  for(const auto precision : {PermanencePrecision::FLOAT32, PermanencePrecision::UINT8}) {
+    Connections c(100, 0.5f, false, precision);
+    Random rng(9);
+    for(UInt s = 0; s < 50; s++) {
+      const Segment segment = c.createSegment(rng.getUInt32(100));
+      for(CellIdx cell = 0; cell < 20; cell++) {
+        c.createSynapse(segment, (s * 7u + cell * 13u) % 300u, static_cast<Permanence>(rng.getReal64()));
+      }
+    }
+    c.destroySegment(7);
+    c.destroySynapse(c.synapsesForSegment(3)[0]);
+
+    const auto view = c.synapseArrays();
+    ASSERT_EQ(view.size, c.numSynapses() + 21u); //with the destroyed ones
+    EXPECT_EQ(view.permanence == nullptr, precision != PermanencePrecision::FLOAT32);
+    const auto permanences = c.synapsePermanences();
+    for(const auto synapse : c.synapsesForSegment(5)) {
+      EXPECT_EQ(view.presynapticCell[synapse], c.dataForSynapse(synapse).presynapticCell);
+      EXPECT_EQ(view.segment[synapse], 5u);
+      EXPECT_EQ(permanences[synapse], c.dataForSynapse(synapse).permanence);
+    }
+    vector<CellIdx> cells;
+    vector<UInt32> lastUsed;
+    c.segmentArrays(cells, lastUsed);
+    ASSERT_EQ(cells.size(), 50u);
+    EXPECT_EQ(cells[7], c.numCells());
+    EXPECT_EQ(cells[8], c.cellForSegment(8));
+    EXPECT_EQ(lastUsed[8], c.dataForSegment(8).lastUsed);
+
+    // The view is a snapshot, learning copies the topology.
+    const Synapse synapse = c.synapsesForSegment(5)[0];
+    c.destroySegment(5);
+    EXPECT_EQ(c.synapsePermanences()[synapse], -1.0f);
+    if(view.permanence != nullptr) EXPECT_EQ(view.permanence[synapse], permanences[synapse]);
+
+    vector<CellIdx> segmentCells, presynaptic;
+    vector<Synapse> offsets;
+    vector<Permanence> perms;
+    c.bulkExport(segmentCells, offsets, presynaptic, perms, lastUsed);
+    ASSERT_EQ(segmentCells.size(), c.numSegments());
+    ASSERT_EQ(presynaptic.size(), c.numSynapses());
+    ASSERT_EQ(offsets.back(), c.numSynapses());
+
+    Connections loaded(100, 0.5f, false, precision);
+    loaded.bulkLoad(segmentCells, offsets, presynaptic, perms, lastUsed);
+    EXPECT_EQ(loaded.numSegments(), c.numSegments());
+    EXPECT_EQ(loaded.numSynapses(), c.numSynapses());
+    vector<CellIdx> segmentCells2, presynaptic2;
+    vector<Synapse> offsets2;
+    vector<Permanence> perms2;
+    vector<UInt32> lastUsed2;
+    loaded.bulkExport(segmentCells2, offsets2, presynaptic2, perms2, lastUsed2);
+    EXPECT_EQ(segmentCells2, segmentCells);
+    EXPECT_EQ(offsets2, offsets);
+    EXPECT_EQ(presynaptic2, presynaptic);
+    EXPECT_EQ(perms2, perms);
+    EXPECT_EQ(lastUsed2, lastUsed);
+
+    // Edited offline.
+    perms.assign(perms.size(), 0.9f);
+    Connections edited(100, 0.5f, false, precision);
+    edited.bulkLoad(segmentCells, offsets, presynaptic, perms);
+    EXPECT_EQ(edited.dataForSegment(0).numConnected, edited.numSynapses(0));
+    EXPECT_ANY_THROW(edited.bulkLoad(segmentCells, offsets, presynaptic, perms, lastUsed)); //not empty
+    Connections wrong(100, 0.5f, false, precision);
+    lastUsed.pop_back();
+    EXPECT_ANY_THROW(wrong.bulkLoad(segmentCells, offsets, presynaptic, perms, lastUsed));
+  }
+}
+
+TEST(ConnectionsTest, testComputeActivityBuffers) {
+  // The buffered overload must give the same counts as the allocating one,
+  // while the buffers are reused and segments are added / destroyed.
+  for(const UInt threads : {1u, 2u}) {
+    Connections connections(200, 0.5f);
+    connections.setNumThreads(threads);
+    SegmentActivity activity;
+    Random rng(17);
+    SDR input({ 200u });
+    for(UInt iter = 0; iter < 30; iter++) {
+      for(UInt i = 0; i < 5; i++) {
+        const Segment seg = connections.createSegment(rng.getUInt32(200));
+        for(UInt j = 0; j < 15; j++) {
+          connections.createSynapse(seg, rng.getUInt32(200), static_cast<Permanence>(rng.getReal64()));
+        }
+      }
+      if(iter % 7 == 6) connections.destroySegment(iter);
+
+      input.randomize(0.05f, rng);
+      vector<SynapseIdx> potential(connections.segmentFlatListLength(), 0);
+      const auto connected = connections.computeActivity(potential, input.getSparse(), false);
+      connections.computeActivity(activity, input.getSparse(), false);
+      ASSERT_EQ(activity.numActiveConnected, connected) << "iteration " << iter;
+      ASSERT_EQ(activity.numActivePotential, potential) << "iteration " << iter;
+
+      vector<Segment> touched = activity.touched;
+      std::sort(touched.begin(), touched.end());
+      vector<Segment> expected;
+      for(Segment seg = 0; seg < potential.size(); seg++) {
+        if(potential[seg] > 0) expected.push_back(seg);
+      }
+      ASSERT_EQ(touched, expected);
+    }
+  }
+}
+
+TEST(ConnectionsTest, testComputeActivityExternalRange) {
+  // Cells 0-149 and external inputs 150-199: the same counts as the
+  // concatenated cells, also for connected only and with threads.
+  for(const UInt threads : {1u, 2u}) {
+    Connections connections(200, 0.5f);
+    connections.setNumThreads(threads);
+    Random rng(5);
+    for(UInt i = 0; i < 60; i++) {
+      const Segment seg = connections.createSegment(rng.getUInt32(150));
+      for(UInt j = 0; j < 20; j++) {
+        connections.createSynapse(seg, rng.getUInt32(200), static_cast<Permanence>(rng.getReal64()));
+      }
+    }
+    SDR cells({ 150u });
+    SDR external({ 50u });
+    for(UInt iter = 0; iter < 10; iter++) {
+      cells.randomize(0.1f, rng);
+      external.randomize(0.2f, rng);
+      vector<CellIdx> all = cells.getSparse();
+      for(const auto e : external.getSparse()) all.push_back(e + 150u);
+      for(const bool countPotential : {true, false}) {
+        SegmentActivity expected, activity;
+        connections.computeActivity(expected, all, false, countPotential);
+        connections.computeActivity(activity, cells.getSparse(), external.getSparse(), 150u, false, countPotential);
+        ASSERT_EQ(activity.numActiveConnected, expected.numActiveConnected) << "iteration " << iter;
+        ASSERT_EQ(activity.numActivePotential, expected.numActivePotential) << "iteration " << iter;
+      }
+    }
+
+    // Growing from both ranges is growing from the concatenation.
+    Connections a = connections, b = connections;
+    Random rngA(3), rngB(3);
+    vector<CellIdx> all = cells.getSparse();
+    for(const auto e : external.getSparse()) all.push_back(e + 150u);
+    a.growSynapses(0u, all, 0.3f, rngA, 8u);
+    b.growSynapses(0u, cells.getSparse(), external.getSparse(), 150u, 0.3f, rngB, 8u);
+    ASSERT_EQ(a, b);
+  }
+}
+
+TEST(ConnectionsTest, testFilterSegmentsByActivity) {
+  Random rng(7);
+  for(const size_t n : {0u, 5u, 16u, 33u, 1000u}) {
+    vector<SynapseIdx> connected(n), potential(n);
+    for(size_t i = 0; i < n; i++) {
+      connected[i] = (rng.getReal64() < 0.9) ? 0 : static_cast<SynapseIdx>(rng.getUInt32(40000));
+      potential[i] = static_cast<SynapseIdx>(connected[i] + rng.getUInt32(20));
+    }
+    vector<Segment> expectedActive, expectedMatching;
+    for(size_t i = 0; i < n; i++) {
+      if(connected[i] >= 13) expectedActive.push_back(static_cast<Segment>(i));
+      if(potential[i] >= 10) expectedMatching.push_back(static_cast<Segment>(i));
+    }
+    vector<Segment> active = {1, 2, 3}, matching; //output is cleared first
+    Connections::filterSegmentsByActivity(connected, 13, potential, 10, active, matching);
+    EXPECT_EQ(expectedActive, active) << "n = " << n;
+    EXPECT_EQ(expectedMatching, matching) << "n = " << n;
+  }
+}
+
+TEST(ConnectionsTest, testSegmentEviction) {
+  // 20 segments on cell 0, segment i last used at iteration 100 + i.
+  const auto fill = [](Connections &c) {
+    for(UInt i = 0; i < 20u; i++) {
+      const Segment seg = c.createSegment(0);
+      c.dataForSegment(seg).lastUsed = 100u + i;
+    }
+  };
+
+  Connections exact(10);
+  EXPECT_EQ(exact.getSegmentEviction(), SegmentEviction::LRU);
+  fill(exact);
+  exact.createSegment(0, 20u);
+  EXPECT_EQ(exact.numSegments(0), 20u);
+  for(const auto seg : exact.segmentsForCell(0)) EXPECT_NE(exact.dataForSegment(seg).lastUsed, 100u);
+
+  // sampled: keeps the limit, destroys one of the older segments, reproducible
+  Connections sampled(10), again(10);
+  sampled.setSegmentEviction(SegmentEviction::SAMPLED_LRU, 3u, 7u);
+  again.setSegmentEviction(SegmentEviction::SAMPLED_LRU, 3u, 7u);
+  fill(sampled);
+  fill(again);
+  for(UInt i = 0; i < 10u; i++) {
+    sampled.createSegment(0, 20u);
+    again.createSegment(0, 20u);
+    EXPECT_EQ(sampled.numSegments(0), 20u);
+  }
+  EXPECT_EQ(sampled.segmentsForCell(0), again.segmentsForCell(0));
+  // the most recently used of the original segments is never the oldest of a sample
+  bool kept = false;
+  for(const auto seg : sampled.segmentsForCell(0)) kept = kept or sampled.dataForSegment(seg).lastUsed == 119u;
+  EXPECT_TRUE(kept);
+
+  // the sample covers the whole cell: same as the exact LRU
+  Connections wide(10);
+  wide.setSegmentEviction(SegmentEviction::SAMPLED_LRU, 20u);
+  fill(wide);
+  wide.createSegment(0, 20u);
+  for(const auto seg : wide.segmentsForCell(0)) EXPECT_NE(wide.dataForSegment(seg).lastUsed, 100u);
+
+  EXPECT_ANY_THROW(wide.setSegmentEviction(SegmentEviction::SAMPLED_LRU, 0u));
+}
+
+TEST(ConnectionsTest, testChangeLog) {
+  Connections c(10, 0.5f);
+  EXPECT_FALSE(c.getChangeLog());
+  c.createSegment(0); //not recorded
+  c.setChangeLog(true);
+
+  const Segment seg = c.createSegment(1);
+  const Synapse connected = c.createSynapse(seg, 5, 0.6f);
+  const Synapse potential = c.createSynapse(seg, 6, 0.2f);
+  c.updateSynapsePermanence(potential, 0.3f); //stays disconnected: not an event
+  c.updateSynapsePermanence(connected, 0.1f);
+  c.destroySynapse(potential);
+
+  vector<ConnectionsChange> log = {{ConnectionsChange::COMPACT, 1u, 1.0f}}; //replaced
+  c.takeChangeLog(log);
+  const vector<ConnectionsChange> expected = {
+    {ConnectionsChange::CREATE_SEGMENT, seg, 0.0f},
+    {ConnectionsChange::CREATE_SYNAPSE, connected, 0.0f},
+    {ConnectionsChange::UPDATE_SYNAPSE_PERMANENCE, connected, 0.6f},
+    {ConnectionsChange::CREATE_SYNAPSE, potential, 0.0f},
+    {ConnectionsChange::UPDATE_SYNAPSE_PERMANENCE, connected, 0.1f},
+    {ConnectionsChange::DESTROY_SYNAPSE, potential, 0.0f},
+  };
+  EXPECT_EQ(log, expected);
+  c.takeChangeLog(log);
+  EXPECT_TRUE(log.empty());
+
+  c.destroySegment(seg);
+  c.compact();
+  c.takeChangeLog(log);
+  ASSERT_FALSE(log.empty());
+  EXPECT_EQ(log.front().kind, ConnectionsChange::DESTROY_SEGMENT);
+  EXPECT_EQ(log.back().kind, ConnectionsChange::COMPACT);
+
+  c.setChangeLog(false);
+  c.createSegment(2);
+  c.takeChangeLog(log);
+  EXPECT_TRUE(log.empty());
+}
+
+TEST(ConnectionsTest, testBumpSegmentBulk) {
+  // bumpSegment() updates all permanences at once, it must give the same result
+  // as updateSynapsePermanence() of each synapse, also when the synapses of a
+  // segment are not one contiguous run.
+  for(const auto precision : {PermanencePrecision::FLOAT32, PermanencePrecision::UINT16, PermanencePrecision::UINT8}) {
+    Connections bulk(10, 0.5f, false, precision);
+    Connections single(10, 0.5f, false, precision);
+    bulk.setFlatIndex(true);
+    single.setFlatIndex(true);
+    // whole steps of the precision, so there is no rounding in quantizeDelta()
+    const Real step = precision == PermanencePrecision::UINT8  ? 1.0f / 254.0f :
+                      precision == PermanencePrecision::UINT16 ? 1.0f / 65534.0f : 0.001f;
+    const vector<Real> deltas = {20 * step, -35 * step, 400 * step, -1000 * step};
+    Random rng(42);
+
+    for(auto *C : {&bulk, &single}) {
+      const Segment run = C->createSegment(0);
+      for(UInt i = 0; i < 16; i++) C->createSynapse(run, i, 0.4f + i * 0.01f);
+      // interleaved synapses of two segments
+      const Segment a = C->createSegment(1);
+      const Segment b = C->createSegment(2);
+      for(UInt i = 0; i < 16; i++) {
+        C->createSynapse(a, 20 + i, 0.45f + i * 0.007f);
+        C->createSynapse(b, 40 + i, 0.5f  - i * 0.009f);
+      }
+    }
+
+    for(const Real delta : deltas) {
+      for(Segment seg = 0; seg < 3; seg++) {
+        bulk.bumpSegment(seg, delta);
+        for(const auto syn : single.synapsesForSegment(seg)) {
+          single.updateSynapsePermanence(syn, single.permanenceForSynapse(syn) + delta);
+        }
+        ASSERT_EQ(bulk.dataForSegment(seg).numConnected, single.dataForSegment(seg).numConnected);
+      }
+      for(Synapse syn = 0; syn < 48; syn++) {
+        ASSERT_EQ(bulk.permanenceForSynapse(syn), single.permanenceForSynapse(syn));
+      }
+      SDR input({ 60u });
+      input.randomize(0.5f, rng);
+      vector<SynapseIdx> potentialBulk(bulk.segmentFlatListLength(), 0);
+      vector<SynapseIdx> potentialSingle(single.segmentFlatListLength(), 0);
+      ASSERT_EQ(bulk.computeActivity(potentialBulk, input.getSparse(), false),
+                single.computeActivity(potentialSingle, input.getSparse(), false));
+      ASSERT_EQ(potentialBulk, potentialSingle);
+    }
+    ASSERT_EQ(bulk, single);
+  }
+}
+
+TEST(ConnectionsTest, testAdaptSegmentHugeInput) {
+  // Inputs above 1M bits are looked up in their sparse / compressed format
+  // instead of a dense array; the learning must be the same.
+  const UInt hugeSize = 4000000u;
+  const vector<CellIdx> presyn = {3u, 1000u, 2000000u, 3999999u};
+  Connections small(1, 0.5f), huge(1, 0.5f);
+  for(auto *C : {&small, &huge}) {
+    const Segment seg = C->createSegment(0);
+    for(const auto cell : presyn) C->createSynapse(seg, cell, 0.5f);
+  }
+  SDR smallInput({ hugeSize });
+  smallInput.setSparse(SDR_sparse_t{1000u, 3999999u});
+  smallInput.getDense(); // as a small input would be
+  SDR hugeInput({ hugeSize });
+  hugeInput.setSparse(SDR_sparse_t{1000u, 3999999u});
+  hugeInput.getCompressed();
+
+  small.adaptSegment(0, smallInput, 0.1f, 0.05f);
+  huge.adaptSegment(0, hugeInput, 0.1f, 0.05f);
+  ASSERT_EQ(small, huge);
+  ASSERT_NEAR(huge.permanenceForSynapse(1), 0.6f, htm::Epsilon);
+  ASSERT_NEAR(huge.permanenceForSynapse(0), 0.45f, htm::Epsilon);
+
+  vector<SegmentAdaptation> adaptations = {{0u, 0.1f, 0.05f, {}, {}, {}}};
+  huge.prepareAdaptSegments(adaptations, hugeInput, false);
+  huge.finishAdaptSegment(adaptations[0], false, 0u);
+  ASSERT_NEAR(huge.permanenceForSynapse(1), 0.7f, htm::Epsilon);
+}
+
+TEST(ConnectionsTest, testShareFrom) {
+  Connections original(10, 0.5f);
+  original.setFlatIndex(true);
+  const Segment seg = original.createSegment(1);
+  original.createSynapse(seg, 5, 0.6f);
+  original.createSynapse(seg, 6, 0.2f);
+  original.setChangeLog(true);
+
+  Connections copy;
+  copy.shareFrom(original);
+  EXPECT_TRUE(copy.sharesTopology(original));
+  EXPECT_EQ(copy, original);
+  EXPECT_FALSE(copy.getChangeLog()); // listeners are not copied
+
+  // inference reads the shared topology, flat index included
+  SDR input({ 10u });
+  input.setSparse(SDR_sparse_t{5u, 6u});
+  EXPECT_EQ(copy.computeActivity(input.getSparse(), false), vector<SynapseIdx>({1u}));
+  EXPECT_TRUE(copy.sharesTopology(original));
+
+  // learning copies it first, the original stays as it was
+  copy.adaptSegment(seg, input, 0.1f, 0.05f);
+  EXPECT_FALSE(copy.sharesTopology(original));
+  EXPECT_NEAR(copy.permanenceForSynapse(1), 0.3f, htm::Epsilon);
+  EXPECT_NEAR(original.permanenceForSynapse(1), 0.2f, htm::Epsilon);
+  vector<ConnectionsChange> log;
+  original.takeChangeLog(log);
+  EXPECT_TRUE(log.empty());
+
+  // and so does the original when it changes
+  Connections other;
+  other.shareFrom(original);
+  original.createSegment(2);
+  EXPECT_FALSE(other.sharesTopology(original));
+  EXPECT_EQ(other.numSegments(), 1u);
+  EXPECT_EQ(original.numSegments(), 2u);
+}
+
+TEST(ConnectionsTest, testTrackChangedSegments) {
+  Connections c(10, 0.5f);
+  const Segment a = c.createSegment(1);
+  const Segment b = c.createSegment(2);
+  const Synapse s = c.createSynapse(a, 5, 0.45f);
+  c.createSynapse(b, 6, 0.6f);
+  vector<Segment> changed;
+  c.setTrackChangedSegments(true);
+  ASSERT_TRUE(c.takeChangedSegments(changed));
+  EXPECT_TRUE(changed.empty());
+
+  c.updateSynapsePermanence(s, 0.46f); // still disconnected
+  ASSERT_TRUE(c.takeChangedSegments(changed));
+  EXPECT_TRUE(changed.empty());
+
+  c.updateSynapsePermanence(s, 0.55f); // connects
+  c.createSynapse(a, 7, 0.1f);
+  const Segment d = c.createSegment(3);
+  ASSERT_TRUE(c.takeChangedSegments(changed));
+  EXPECT_EQ(changed, vector<Segment>({a, d})); // each once
+  ASSERT_TRUE(c.takeChangedSegments(changed));
+  EXPECT_TRUE(changed.empty());
+
+  c.destroySegment(b);
+  c.compact();
+  EXPECT_FALSE(c.takeChangedSegments(changed)); // renumbered, all changed
+  ASSERT_TRUE(c.takeChangedSegments(changed));
+  EXPECT_TRUE(changed.empty());
+
+  c.setTrackChangedSegments(false);
+  c.createSegment(4);
+  ASSERT_TRUE(c.takeChangedSegments(changed));
+  EXPECT_TRUE(changed.empty());
+}
+
+TEST(ConnectionsTest, testMemoryUsage) {
+  Connections c(100, 0.5f);
+  const MemoryUsage empty = c.memoryUsage();
+  for(const auto *category : {"cells", "segments", "synapses", "presynapticMaps", "flatIndex", "caches"}) {
+    EXPECT_EQ(empty.count(category), 1u) << category;
+  }
+  EXPECT_EQ(empty.at("synapses"), 0u);
+
+  for(CellIdx cell = 0; cell < 100; cell++) {
+    const Segment seg = c.createSegment(cell);
+    for(CellIdx presyn = 0; presyn < 20; presyn++) c.createSynapse(seg, presyn, 0.6f);
+  }
+  const MemoryUsage full = c.memoryUsage();
+  EXPECT_GE(full.at("synapses"), 2000u * (sizeof(CellIdx) + sizeof(Permanence) + sizeof(Segment)));
+  EXPECT_GT(full.at("segments"), 100u * sizeof(SegmentData));
+  EXPECT_GT(full.at("presynapticMaps"), 0u);
+  EXPECT_EQ(full.at("flatIndex"), 0u);
+  EXPECT_GT(memory::total(full), memory::total(empty));
+
+  c.setFlatIndex(true);
+  SDR input({ 100u });
+  input.setSparse(SDR_sparse_t{1u, 2u});
+  c.computeActivity(input.getSparse(), false);
+  EXPECT_GT(c.memoryUsage().at("flatIndex"), 0u);
+}
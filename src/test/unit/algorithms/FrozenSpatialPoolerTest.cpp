@@ -0,0 +1,111 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+
+#include "gtest/gtest.h"
+
+#include <sstream>
+#include <vector>
+
+#include "htm/algorithms/FrozenSpatialPooler.hpp"
+#include "htm/algorithms/SpatialPooler.hpp"
+#include "htm/utils/Random.hpp"
+
+namespace testing {
+
+using namespace htm;
+
+/** A trained SP, with boosting and one of the inhibitions. */
+static SpatialPooler trainedSP(const bool global, const UInt stimulusThreshold = 0u) {
+  SpatialPooler sp({20, 20}, {30, 30});
+  sp.setGlobalInhibition(global);
+  sp.setInhibitionRadius(4);
+  sp.setBoostStrength(2.0f);
+  sp.setStimulusThreshold(stimulusThreshold);
+  Random rng(11);
+  SDR input({20, 20});
+  SDR active({30, 30});
+  for(UInt step = 0; step < 30; step++) {
+    input.randomize(0.05f, rng);
+    sp.compute(input, true, active);
+  }
+  return sp;
+}
+
+
+TEST(FrozenSpatialPoolerTest, SameAsInference) {
+  for(const bool global : {true, false}) {
+    for(const UInt stimulusThreshold : {0u, 2u}) {
+      SpatialPooler sp = trainedSP(global, stimulusThreshold);
+      FrozenSpatialPooler frozen(sp);
+      ASSERT_EQ(frozen.getNumInputs(), sp.getNumInputs());
+      ASSERT_EQ(frozen.getNumColumns(), sp.getNumColumns());
+
+      Random rng(3);
+      SDR input({20, 20});
+      SDR expected({30, 30});
+      SDR active({30, 30});
+      for(UInt i = 0; i < 20; i++) {
+        input.randomize(i % 2 ? 0.1f : 0.01f, rng); //sparse inputs leave most columns at 0
+        const auto overlaps = sp.compute(input, false, expected);
+        ASSERT_EQ(frozen.compute(input, active), overlaps);
+        ASSERT_EQ(active.getSparse(), expected.getSparse())
+            << "global " << global << " threshold " << stimulusThreshold << " input " << i;
+      }
+    }
+  }
+}
+
+
+TEST(FrozenSpatialPoolerTest, OnlyConnectedSynapses) {
+  SpatialPooler sp = trainedSP(true);
+  FrozenSpatialPooler frozen(sp);
+  size_t connected = 0;
+  vector<UInt> counts(sp.getNumColumns());
+  sp.getConnectedCounts(counts.data());
+  for(const auto count : counts) connected += count;
+  ASSERT_EQ(frozen.getNumSynapses(), connected);
+  ASSERT_LT(frozen.getNumSynapses(), sp.getConnections().numSynapses());
+}
+
+
+TEST(FrozenSpatialPoolerTest, Serialization) {
+  SpatialPooler sp = trainedSP(false);
+  FrozenSpatialPooler frozen(sp);
+
+  std::stringstream spStream, frozenStream;
+  sp.save(spStream);
+  frozen.save(frozenStream);
+  ASSERT_LT(frozenStream.str().size(), spStream.str().size() / 2u);
+
+  FrozenSpatialPooler loaded;
+  loaded.load(frozenStream);
+  ASSERT_EQ(loaded, frozen);
+
+  Random rng(5);
+  SDR input({20, 20});
+  SDR expected({30, 30});
+  SDR active({30, 30});
+  for(UInt i = 0; i < 5; i++) {
+    input.randomize(0.05f, rng);
+    frozen.compute(input, expected);
+    loaded.compute(input, active);
+    ASSERT_EQ(active, expected);
+  }
+}
+
+} // end namespace testing
@@ -0,0 +1,124 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of unit tests for FrozenTemporalMemory
+ */
+
+#include "gtest/gtest.h"
+
+#include <sstream>
+#include <vector>
+
+#include "htm/algorithms/FrozenTemporalMemory.hpp"
+#include "htm/algorithms/TemporalMemory.hpp"
+#include "htm/utils/Random.hpp"
+
+namespace testing {
+
+using namespace htm;
+
+/** A repeating sequence of random column SDRs. */
+static vector<SDR> sequence(const UInt length, const UInt seed) {
+  Random rng(seed);
+  vector<SDR> steps;
+  for(UInt i = 0; i < length; i++) {
+    steps.emplace_back(vector<UInt>{10u, 10u});
+    steps.back().randomize(0.2f, rng);
+  }
+  return steps;
+}
+
+/** A TM trained on the sequence. */
+static void train(TemporalMemory &tm, const vector<SDR> &steps, const UInt repeats = 15u) {
+  for(UInt repeat = 0; repeat < repeats; repeat++) {
+    tm.reset();
+    for(const auto &step : steps) tm.compute(step, true);
+  }
+}
+
+
+TEST(FrozenTemporalMemoryTest, SameAsInference) {
+  TemporalMemory tm({10u, 10u}, 8u);
+  const auto steps = sequence(10u, 7u);
+  train(tm, steps);
+  FrozenTemporalMemory frozen(tm);
+  ASSERT_EQ(frozen.numberOfCells(), tm.numberOfCells());
+  ASSERT_GT(frozen.getNumSegments(), 0u);
+
+  // the known sequence, then a new one, then noise
+  vector<SDR> inputs = steps;
+  for(const auto &step : sequence(10u, 8u)) inputs.push_back(step);
+  tm.reset();
+  frozen.reset();
+  for(size_t i = 0; i < inputs.size(); i++) {
+    tm.compute(inputs[i], false);
+    frozen.compute(inputs[i]);
+    ASSERT_EQ(frozen.getActiveCells(), tm.getActiveCells()) << "input " << i;
+    ASSERT_EQ(frozen.getAnomaly(), tm.anomaly) << "input " << i;
+    tm.activateDendrites(false);
+    ASSERT_EQ(frozen.getPredictiveCells(), tm.getPredictiveCells()) << "input " << i;
+  }
+  SDR none({10u, 10u});
+  tm.compute(none, false);
+  frozen.compute(none);
+  EXPECT_TRUE(frozen.getActiveCells().empty());
+  EXPECT_EQ(frozen.getAnomaly(), tm.anomaly);
+}
+
+
+TEST(FrozenTemporalMemoryTest, OnlyConnectedSynapses) {
+  TemporalMemory tm({10u, 10u}, 8u);
+  train(tm, sequence(10u, 7u), 3u); //some synapses are still disconnected
+  FrozenTemporalMemory frozen(tm);
+  size_t connected = 0;
+  for(Segment segment = 0; segment < tm.connections.segmentFlatListLength(); segment++) {
+    if(tm.connections.dataForSegment(segment).numConnected >= tm.getActivationThreshold()) {
+      connected += tm.connections.dataForSegment(segment).numConnected;
+    }
+  }
+  ASSERT_EQ(frozen.getNumSynapses(), connected);
+  ASSERT_LT(frozen.getNumSynapses(), tm.connections.numSynapses());
+  ASSERT_LE(frozen.getNumSegments(), tm.connections.numSegments());
+}
+
+
+TEST(FrozenTemporalMemoryTest, Serialization) {
+  TemporalMemory tm({10u, 10u}, 8u);
+  const auto steps = sequence(10u, 7u);
+  train(tm, steps);
+  FrozenTemporalMemory frozen(tm);
+
+  std::stringstream tmStream, frozenStream;
+  tm.save(tmStream);
+  frozen.save(frozenStream);
+  ASSERT_LT(frozenStream.str().size(), tmStream.str().size() / 2u);
+
+  FrozenTemporalMemory loaded;
+  loaded.load(frozenStream);
+  ASSERT_EQ(loaded, frozen);
+
+  frozen.reset();
+  for(const auto &step : steps) {
+    frozen.compute(step);
+    loaded.compute(step);
+    ASSERT_EQ(loaded.getActiveCells(), frozen.getActiveCells());
+    ASSERT_EQ(loaded.getPredictiveCells(), frozen.getPredictiveCells());
+  }
+}
+
+} // end namespace testing
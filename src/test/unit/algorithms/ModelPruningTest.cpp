@@ -0,0 +1,185 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of unit tests for the offline pruning of models
+ */
+
+#include "gtest/gtest.h"
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "htm/algorithms/ModelPruning.hpp"
+#include "htm/algorithms/SpatialPooler.hpp"
+#include "htm/algorithms/TemporalMemory.hpp"
+#include "htm/engine/Network.hpp"
+#include "htm/utils/Random.hpp"
+
+namespace testing {
+
+using namespace htm;
+using std::vector;
+
+// A repeating sequence of 5 noisy patterns.
+static vector<SDR> sequence(const vector<UInt> &dimensions, const Real sparsity, const UInt length,
+                            const Real noise = 0.02f) {
+  Random rng(7);
+  vector<SDR> patterns(5u, SDR(dimensions));
+  for(auto &pattern : patterns) pattern.randomize(sparsity, rng);
+  vector<SDR> records;
+  for(UInt i = 0u; i < length; i++) {
+    records.push_back(patterns[i % 5u]);
+    records.back().addNoise(noise, rng);
+  }
+  return records;
+}
+
+
+TEST(ModelPruningTest, Connections) {
+  Connections c(4u, 0.5f);
+  const Segment a = c.createSegment(0u);
+  const Segment b = c.createSegment(1u);
+  const Segment d = c.createSegment(2u);
+  c.createSynapse(a, 1u, 0.05f);
+  c.createSynapse(a, 2u, 0.3f);
+  c.createSynapse(a, 3u, 0.6f);
+  c.createSynapse(b, 0u, 0.02f);
+  c.createSynapse(d, 0u, 0.9f);
+  c.dataForSegment(d).lastUsed = 0u;
+  SDR none({4u});
+  for(int i = 0; i < 10; i++) c.computeActivity(none.getSparse(), true);
+  c.dataForSegment(a).lastUsed = c.iteration();
+  c.dataForSegment(b).lastUsed = c.iteration();
+
+  // Keep the empty segment b, and all by age.
+  Connections keep = c;
+  const auto kept = keep.prune(0.1f, 0u, false);
+  EXPECT_EQ(kept.first, 2u);
+  EXPECT_EQ(kept.second, 0u);
+  EXPECT_EQ(keep.numSegments(), 3u);
+  EXPECT_EQ(keep.numSynapses(), 3u);
+  EXPECT_EQ(keep.segmentFlatListLength(), 3u);
+  EXPECT_EQ(keep.numSynapses(0u), 2u);
+
+  // Destroy b, empty, and d, unused for 10 iterations.
+  const auto destroyed = c.prune(0.1f, 5u, true);
+  EXPECT_EQ(destroyed.first, 3u);
+  EXPECT_EQ(destroyed.second, 2u);
+  ASSERT_EQ(c.numSegments(), 1u);
+  EXPECT_EQ(c.segmentFlatListLength(), 1u);
+  EXPECT_EQ(c.cellForSegment(0u), 0u);
+  EXPECT_EQ(c.numSynapses(), 2u);
+  for(const Synapse s : c.synapsesForSegment(0u))
+    EXPECT_GE(c.dataForSynapse(s).permanence, 0.1f);
+}
+
+
+TEST(ModelPruningTest, TemporalMemory) {
+  // Noisy, to keep weak synapses.  Two equal TMs, as copies share the public
+  // connections view.
+  const auto columns = sequence({500u}, 0.04f, 200u, 0.2f);
+  const auto trained = [&]() {
+    std::unique_ptr<TemporalMemory> tm(new TemporalMemory({500u}, 8u, 8u, 0.21f, 0.5f, 6u, 15u, 0.1f, 0.1f, 0.01f, 42));
+    for(const auto &c : columns) tm->compute(c, true);
+    return tm;
+  };
+  auto original = trained();
+  auto tm = trained();
+
+  // Below the connected permanence the predictions do not change.
+  const PruneReport report = prune(*tm, PruneOptions{0.45f, 0u});
+  EXPECT_LT(report.synapsesAfter, report.synapsesBefore);
+  EXPECT_EQ(report.synapsesAfter, tm->connections.numSynapses());
+  EXPECT_LT(report.bytesAfter, report.bytesBefore);
+  const vector<SDR> stream(columns.begin(), columns.begin() + 50);
+  const ValidationReport same = validate(*original, *tm, stream);
+  EXPECT_EQ(same.steps, 50u);
+  EXPECT_EQ(same.predictionsChanged, 0u);
+  EXPECT_EQ(same.anomalyChanged, 0u);
+  EXPECT_EQ(same.maxAnomalyDelta, 0.0f);
+
+  // Without any synapse, nothing is predicted.
+  const PruneReport all = prune(*tm, PruneOptions{1.1f, 0u});
+  EXPECT_EQ(all.synapsesAfter, 0u);
+  EXPECT_EQ(all.segmentsAfter, 0u);
+  const ValidationReport changed = validate(*original, *tm, stream);
+  EXPECT_GT(changed.predictionsChanged, 0u);
+  EXPECT_GT(changed.anomalyChanged, 0u);
+  EXPECT_GT(changed.maxAnomalyDelta, 0.5f);
+  // The pruned model still learns.
+  for(const auto &c : columns) tm->compute(c, true);
+  EXPECT_GT(tm->connections.numSynapses(), 0u);
+}
+
+
+TEST(ModelPruningTest, SpatialPooler) {
+  const auto inputs = sequence({400u}, 0.1f, 200u);
+  const auto trained = [&]() {
+    std::unique_ptr<SpatialPooler> sp(new SpatialPooler({400u}, {256u}));
+    sp->setLocalAreaDensity(0.04f);
+    SDR active({256u});
+    for(const auto &input : inputs) sp->compute(input, true, active);
+    return sp;
+  };
+  auto original = trained();
+  auto sp = trained();
+
+  const PruneReport report = prune(*sp, PruneOptions{sp->getSynPermConnected() * 0.9f, 100u});
+  EXPECT_LT(report.synapsesAfter, report.synapsesBefore);
+  EXPECT_EQ(report.segmentsAfter, 256u) << "One segment per column, also when empty";
+  const ValidationReport same = validate(*original, *sp, inputs);
+  EXPECT_EQ(same.steps, inputs.size());
+  EXPECT_EQ(same.activeChanged, 0u);
+}
+
+
+TEST(ModelPruningTest, Network) {
+  const std::string config = R"(
+    {network: [
+      {addRegion: {name: encoder, type: RDSEEncoderRegion, params: {size: 400, sparsity: 0.1, radius: 0.5, seed: 1}}},
+      {addRegion: {name: sp, type: SPRegion, params: {columnCount: 256, globalInhibition: true}}},
+      {addRegion: {name: tm, type: TMRegion, params: {cellsPerColumn: 4}}},
+      {addLink: {src: encoder.encoded, dest: sp.bottomUpIn}},
+      {addLink: {src: sp.bottomUpOut, dest: tm.bottomUpIn}}
+    ]})";
+  // Two equal networks, trained alike.
+  Network original, pruned;
+  for(Network *net : {&original, &pruned}) {
+    net->configure(config);
+    net->initialize();
+    for(int i = 0; i < 300; i++) {
+      net->getRegion("encoder")->setParameterReal64("sensedValue", static_cast<Real64>(i % 7));
+      net->run(1);
+    }
+  }
+
+  const PruneReport report = prune(pruned, PruneOptions{0.09f, 0u});
+  EXPECT_LT(report.synapsesAfter, report.synapsesBefore);
+  EXPECT_LT(report.bytesAfter, report.bytesBefore);
+  EXPECT_EQ(original.getRegion("tm")->executeCommand({"prune", "0", "0"}), "0 0");
+
+  const ValidationReport same = validate(original, pruned, 20u);
+  EXPECT_EQ(same.steps, 20u);
+  EXPECT_EQ(same.activeChanged, 0u);
+  EXPECT_EQ(same.predictionsChanged, 0u);
+  EXPECT_EQ(same.anomalyChanged, 0u);
+  EXPECT_FALSE(pruned.getRegion("tm")->getParameterBool("learningMode"));
+}
+
+} // namespace testing
@@ -0,0 +1,114 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of unit tests for ParameterSweep
+ */
+
+#include "gtest/gtest.h"
+#include <cmath>
+#include <vector>
+
+#include "htm/algorithms/ParameterSweep.hpp"
+#include "htm/utils/Random.hpp"
+
+namespace testing {
+
+using namespace htm;
+using std::vector;
+
+// A repeating sequence of 4 noisy patterns, labeled by pattern.
+static EncodedDataset dataset(const UInt length) {
+  Random rng(5);
+  vector<SDR> patterns(4u, SDR({200u}));
+  for(auto &pattern : patterns) pattern.randomize(0.1f, rng);
+  EncodedDataset data({200u});
+  SDR record({200u});
+  for(UInt i = 0u; i < length; i++) {
+    record = patterns[i % 4u];
+    record.addNoise(0.05f, rng);
+    data.add(record, i % 4u);
+  }
+  return data;
+}
+
+
+TEST(ParameterSweepTest, Dataset) {
+  EncodedDataset data({10u, 10u});
+  SDR a({10u, 10u});
+  a.setSparse(SDR_sparse_t{1u, 50u, 99u});
+  data.add(a, 3u);
+  a.zero();
+  data.add(a);
+  ASSERT_EQ(data.size(), 2u);
+  EXPECT_EQ(data[0].getSum(), 3u);
+  EXPECT_EQ(data[1].getSum(), 0u);
+  EXPECT_EQ(data.getLabel(0), 3u);
+  EXPECT_EQ(data.getLabel(1), EncodedDataset::NO_LABEL);
+  SDR b({10u, 10u});
+  data[0].copyTo(b);
+  EXPECT_EQ(b.getSparse(), SDR_sparse_t({1u, 50u, 99u}));
+  EXPECT_ANY_THROW(data.add(SDR({100u})));
+}
+
+
+TEST(ParameterSweepTest, Sweep) {
+  const EncodedDataset data = dataset(400u);
+  vector<SweepConfig> configs;
+  for(const bool useTM : {false, true}) {
+    for(const Real inc : {0.02f, 0.1f}) {
+      SweepConfig config;
+      config.name = std::string(useTM ? "tm " : "sp ") + std::to_string(inc);
+      config.columnDimensions = {256u};
+      config.localAreaDensity = 0.04f;
+      config.synPermActiveInc = inc;
+      config.useTM = useTM;
+      config.cellsPerColumn = 4u;
+      config.activationThreshold = 6u;
+      config.minThreshold = 4u;
+      config.maxNewSynapseCount = 10u;
+      config.classifierAlpha = 0.1f;
+      configs.push_back(config);
+    }
+  }
+
+  const ParameterSweep sweep(data, 300u, 2u);
+  const auto results = sweep.run(configs);
+  ASSERT_EQ(results.size(), configs.size());
+  for(size_t i = 0u; i < results.size(); i++) {
+    const auto &result = results[i];
+    EXPECT_EQ(result.name, configs[i].name);
+    EXPECT_GT(result.accuracy, 0.9f) << result;
+    EXPECT_NEAR(result.spSparsity, 0.04f, 0.01f) << result;
+    EXPECT_GT(result.spEntropy, 0.0f) << result;
+    EXPECT_GT(result.recordsPerSecond, 0.0) << result;
+    if(configs[i].useTM) {
+      EXPECT_LT(result.meanAnomaly, 0.5f) << result;  // learned the sequence
+    } else {
+      EXPECT_TRUE(std::isnan(result.meanAnomaly));
+    }
+    // The same as on its own.
+    const SweepResult alone = sweep.run(configs[i]);
+    EXPECT_EQ(alone.accuracy, result.accuracy);
+    EXPECT_TRUE(alone.meanAnomaly == result.meanAnomaly || std::isnan(result.meanAnomaly));
+    EXPECT_EQ(alone.spEntropy, result.spEntropy);
+  }
+
+  EXPECT_ANY_THROW(ParameterSweep(data, 401u));
+}
+
+} // namespace testing
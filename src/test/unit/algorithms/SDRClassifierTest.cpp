@@ -31,6 +31,7 @@
 
 #include <htm/algorithms/SDRClassifier.hpp>
 #include <htm/utils/Log.hpp>
+#include <htm/utils/Random.hpp>
 
 using namespace std;
 using namespace htm;
@@ -196,6 +197,104 @@ TEST(SDRClassifierTest, MultipleCategories) {
 }
 
 
+TEST(SDRClassifierTest, BatchInfer) {
+  Classifier c;
+  vector<SDR> inputs( 5, SDR({ 200u }) );
+  Random rng(42);
+  for( UInt i = 0; i < 50u; i++ ) {
+    auto &input = inputs[i % inputs.size()];
+    input.randomize( 0.05f, rng );
+    c.learn( input, { i % 7u } ); // categories appear one by one, weights grow
+  }
+  const auto batch = c.infer( inputs );
+  ASSERT_EQ( batch.size(), inputs.size() );
+  for( size_t i = 0; i < inputs.size(); i++ ) {
+    ASSERT_EQ( batch[i], c.infer( inputs[i] ) );
+    ASSERT_EQ( batch[i].size(), 7u );
+  }
+  EXPECT_TRUE( c.infer( vector<SDR>{} ).empty() );
+
+  // Growing the categories keeps the known weights.
+  const auto before = c.infer( inputs[0] );
+  stringstream ss;
+  c.save(ss);
+  Classifier d;
+  d.load(ss);
+  ASSERT_EQ( c, d );
+  d.learn( inputs[1], { 9u } );
+  ASSERT_EQ( d.infer( inputs[0] ).size(), 10u );
+  ASSERT_EQ( argmax(d.infer( inputs[0] )), argmax(before) );
+}
+
+
+TEST(SDRClassifierTest, LearnGrowsCategories) {
+  // Rows are over-allocated when new categories show up, a freshly loaded
+  // Classifier has tight rows. Both must keep learning identically.
+  Classifier a( 0.1f );
+  SDR input({ 100u });
+  Random rng(3);
+  for( UInt cat = 0; cat < 20u; cat++ ) {
+    input.randomize( 0.1f, rng );
+    a.learn( input, { cat } );
+  }
+  stringstream ss;
+  a.save(ss);
+  Classifier b;
+  b.load(ss);
+  for( UInt cat = 20u; cat < 40u; cat++ ) {
+    input.randomize( 0.1f, rng );
+    a.learn( input, { cat, cat / 2u, cat } );
+    b.learn( input, { cat, cat / 2u, cat } );
+    ASSERT_EQ( a, b );
+  }
+  ASSERT_EQ( a.infer( input ), b.infer( input ) );
+  ASSERT_EQ( a.infer( input ).size(), 40u );
+}
+
+
+TEST(SDRClassifierTest, InferTopK) {
+  Predictor p( vector<UInt>{ 1u, 2u } );
+  const UInt length = 6u;
+  vector<SDR> sequence( length, SDR({ 300u }) );
+  Random rng(1);
+  for( auto &input : sequence ) input.randomize( 0.05f, rng );
+  for( UInt i = 0; i < 300u; i++ ) {
+    p.learn( i, sequence[i % length], { (i % length) * 3u } );
+  }
+  const SDR &pattern = sequence[2];
+  const auto full = p.infer( pattern );
+  const auto top  = p.inferTopK( pattern, 4u );
+  for( const UInt step : { 1u, 2u } ) {
+    const PDF &pdf  = full.at(step);
+    const TopK &best = top.at(step);
+    ASSERT_EQ( best.size(), 4u );
+    EXPECT_EQ( best[0].first, argmax(pdf) );
+    EXPECT_EQ( best[0].first, (2u + step) * 3u );
+    for( size_t i = 0; i < best.size(); i++ ) {
+      EXPECT_NEAR( best[i].second, pdf[best[i].first], 1.0e-6 );
+      if( i > 0 ) {
+        EXPECT_GE( best[i - 1].second, best[i].second );
+      }
+    }
+    // the k-th best is at least as likely as every category left out
+    for( UInt cat = 0; cat < pdf.size(); cat++ ) {
+      bool listed = false;
+      for( const auto &entry : best ) listed |= entry.first == cat;
+      if( not listed ) {
+        EXPECT_LE( pdf[cat], best.back().second + 1.0e-6 );
+      }
+    }
+  }
+  // k larger than the number of categories returns all of them
+  EXPECT_EQ( p.inferTopK( pattern, 1000u ).at(1u).size(), full.at(1u).size() );
+  // k == 0 returns nothing
+  EXPECT_TRUE( p.inferTopK( pattern, 0u ).at(1u).empty() );
+  EXPECT_TRUE( p.inferTopK( pattern, 0u ).at(2u).empty() );
+  Classifier empty;
+  EXPECT_TRUE( empty.inferTopK( pattern ).empty() );
+}
+
+
 TEST(SDRClassifierTest, SaveLoad) {
   vector<UInt> steps{ 1u };
   Predictor c1(steps, 0.1f);
@@ -225,6 +324,118 @@ TEST(SDRClassifierTest, SaveLoad) {
 }
 
 
+TEST(SDRClassifierTest, PredictorHistoryWraps) {
+  // Save while the history ring has wrapped around, then keep learning
+  // (with gaps in the record numbers) on both copies.
+  Predictor a( vector<UInt>{ 1u, 3u }, 0.1f );
+  vector<SDR> sequence( 5, SDR({ 10u, 10u }) );
+  Random rng(5);
+  for( auto &input : sequence ) input.randomize( 0.1f, rng );
+  for( UInt i = 0; i < 13u; i++ ) {
+    a.learn( i, sequence[i % 5u], { i % 5u } );
+  }
+  stringstream ss;
+  a.save(ss);
+  Predictor b;
+  b.load(ss);
+  for( UInt i = 13u; i < 60u; i += 1u + (i % 4u == 0u) ) {
+    a.learn( i, sequence[i % 5u], { i % 5u } );
+    b.learn( i, sequence[i % 5u], { i % 5u } );
+  }
+  for( const auto &input : sequence ) {
+    ASSERT_EQ( a.infer( input ), b.infer( input ) );
+  }
+  EXPECT_ANY_THROW( a.learn( 0u, sequence[0], { 0u } ) ); // not monotonic
+  EXPECT_ANY_THROW( a.learn( 100u, SDR({ 100u }), { 0u } ) ); // other dimensions
+}
+
+
+TEST(SDRClassifierTest, PredictorManySteps) {
+  // 24 steps: the fused inference matches a Classifier per step, and the
+  // threaded Predictor matches the single threaded one.
+  vector<UInt> steps;
+  for( UInt step = 24u; step > 0u; step-- ) steps.push_back( step );
+  steps.push_back( 3u ); // duplicates are ignored
+  Predictor single( steps, 0.1f );
+  Predictor threaded( steps, 0.1f );
+  threaded.setNumThreads( 4u );
+  ASSERT_EQ( threaded.getNumThreads(), 4u );
+  Classifier reference( 0.1f );
+
+  Random rng(11);
+  vector<SDR> sequence( 100u, SDR({ 300u }) );
+  for( auto &input : sequence ) input.randomize( 0.05f, rng );
+  for( UInt i = 0u; i < sequence.size(); i++ ) {
+    const vector<UInt> label = { i % 7u, 10u + i % 3u };
+    single.learn( i, sequence[i], label );
+    threaded.learn( i, sequence[i], label );
+    if( i >= 3u ) reference.learn( sequence[i - 3u], label );
+  }
+
+  for( UInt i = 0u; i < 10u; i++ ) {
+    const Predictions a = single.infer( sequence[i] );
+    ASSERT_EQ( a.size(), 24u );
+    ASSERT_EQ( a, threaded.infer( sequence[i] ) );
+    ASSERT_EQ( a.at(3u), reference.infer( sequence[i] ) );
+    const auto best = single.inferTopK( sequence[i], 2u );
+    ASSERT_EQ( best, threaded.inferTopK( sequence[i], 2u ) );
+    ASSERT_EQ( best.at(3u), reference.inferTopK( sequence[i], 2u ) );
+  }
+
+  // Before learning, each step has an empty PDF.
+  Predictor fresh( steps );
+  fresh.setNumThreads( 4u );
+  for( const auto &pdf : fresh.infer( sequence[0] ) ) {
+    EXPECT_TRUE( pdf.second.empty() );
+  }
+  threaded.setNumThreads( 1u );
+  EXPECT_EQ( threaded.getNumThreads(), 1u );
+}
+
+
+TEST(SDRClassifierTest, FastSoftmax) {
+  Random rng(3);
+  vector<SDR> patterns( 10u, SDR({ 500u }) );
+  for( auto &p : patterns ) p.randomize( 0.05f, rng );
+  Classifier exact, fast;
+  EXPECT_TRUE( fast.getFastSoftmax() );
+  exact.setFastSoftmax( false );
+  for( UInt i = 0u; i < 200u; i++ ) {
+    exact.learn( patterns[i % 10u], {i % 10u} );
+    fast.learn(  patterns[i % 10u], {i % 10u} );
+  }
+  for( const auto &p : patterns ) {
+    const PDF a = exact.infer( p );
+    const PDF b = fast.infer( p );
+    ASSERT_EQ( a.size(), b.size() );
+    for( size_t i = 0u; i < a.size(); i++ ) {
+      ASSERT_NEAR( b[i], a[i], a[i] * 1.0e-7 );
+    }
+    const TopK top = fast.inferTopK( p, 3u );
+    ASSERT_EQ( top.size(), 3u );
+    EXPECT_NEAR( top[0].second, b[top[0].first], 1.0e-12 );
+  }
+
+  // The Predictor keeps the setting for the classifiers of initialize().
+  Predictor exactPred, fastPred;
+  exactPred.setFastSoftmax( false );
+  exactPred.initialize( {1u, 2u} );
+  fastPred.initialize( {1u, 2u} );
+  EXPECT_FALSE( exactPred.getFastSoftmax() );
+  for( UInt i = 0u; i < 100u; i++ ) {
+    exactPred.learn( i, patterns[i % 10u], {i % 10u} );
+    fastPred.learn(  i, patterns[i % 10u], {i % 10u} );
+  }
+  const auto a = exactPred.infer( patterns[4] );
+  const auto b = fastPred.infer( patterns[4] );
+  for( const UInt step : {1u, 2u} ) {
+    for( size_t i = 0u; i < a.at(step).size(); i++ ) {
+      ASSERT_NEAR( b.at(step)[i], a.at(step)[i], a.at(step)[i] * 1.0e-7 );
+    }
+  }
+}
+
+
 TEST(SDRClassifierTest, testSoftmaxOverflow) {
   PDF values({ numeric_limits<Real>::max() });
   softmax(values.begin(), values.end());
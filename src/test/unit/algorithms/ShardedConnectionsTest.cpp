@@ -0,0 +1,124 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+#include "gtest/gtest.h"
+
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "htm/algorithms/ShardedConnections.hpp"
+#include "htm/types/Sdr.hpp"
+#include "htm/utils/Random.hpp"
+
+namespace testing {
+
+using namespace htm;
+using std::vector;
+
+TEST(ShardedConnectionsTest, Shards) {
+  ShardedConnections sharded(10, 3);
+  ASSERT_EQ(sharded.numShards(), 3u);
+  ASSERT_EQ(sharded.numCells(), 10u);
+  CellIdx cells = 0;
+  for(UInt s = 0; s < 3; s++) {
+    ASSERT_EQ(sharded.firstCell(s), cells);
+    cells += sharded.shard(s).numCells();
+  }
+  ASSERT_EQ(cells, 10u);
+  for(CellIdx cell = 0; cell < 10; cell++) {
+    const UInt s = sharded.shardForCell(cell);
+    ASSERT_GE(cell, sharded.firstCell(s));
+    ASSERT_LT(cell, sharded.firstCell(s + 1));
+  }
+
+  const ShardSegment seg = sharded.createSegment(9);
+  ASSERT_EQ(seg.shard, 2u);
+  ASSERT_EQ(sharded.cellForSegment(seg), 9u);
+  ASSERT_EQ(sharded.numSegments(), 1u);
+
+  EXPECT_ANY_THROW(ShardedConnections(10, 0));
+  EXPECT_ANY_THROW(ShardedConnections(2, 3));
+}
+
+TEST(ShardedConnectionsTest, ForEachShardOnOwnThread) {
+  ShardedConnections sharded(100, 4);
+  vector<std::thread::id> first(4), second(4);
+  sharded.forEachShard([&](Connections &, UInt s) { first[s]  = std::this_thread::get_id(); });
+  sharded.forEachShard([&](Connections &, UInt s) { second[s] = std::this_thread::get_id(); });
+  ASSERT_EQ(first, second);
+  ASSERT_EQ(std::set<std::thread::id>(first.begin(), first.end()).size(), 4u);
+
+  EXPECT_ANY_THROW(sharded.forEachShard([](Connections &, UInt s) {
+    if(s == 1) NTA_THROW << "shard failed"; }));
+}
+
+TEST(ShardedConnectionsTest, SameActivityAsConnections) {
+  // The shards must find the same active and matching segments as one Connections.
+  const CellIdx numCells = 200;
+  Connections single(numCells, 0.5f);
+  ShardedConnections sharded(numCells, 3, 0.5f);
+  Random rng(42);
+  for(CellIdx cell = 0; cell < numCells; cell++) {
+    for(UInt i = 0; i < 2; i++) {
+      const Segment seg = single.createSegment(cell);
+      const ShardSegment shardSeg = sharded.createSegment(cell);
+      for(UInt j = 0; j < 12; j++) {
+        const CellIdx presyn = rng.getUInt32(400);
+        const Permanence perm = rng.getReal64() < 0.5 ? 0.3f : 0.6f;
+        single.createSynapse(seg, presyn, perm);
+        sharded.shard(shardSeg.shard).createSynapse(shardSeg.segment, presyn, perm);
+      }
+    }
+  }
+  ASSERT_EQ(single.numSynapses(), sharded.numSynapses());
+
+  SDR input({ 400u });
+  vector<SegmentActivity> activity;
+  SegmentActivity singleActivity;
+  for(UInt iter = 0; iter < 10; iter++) {
+    input.randomize(0.2f, rng);
+    single.computeActivity(singleActivity, input.getSparse());
+    vector<Segment> active, matching;
+    Connections::filterSegmentsByActivity(singleActivity.numActiveConnected, 3,
+                                          singleActivity.numActivePotential, 2, active, matching);
+
+    sharded.computeActivity(activity, input.getSparse());
+    vector<ShardSegment> shardActive, shardMatching;
+    sharded.filterSegmentsByActivity(activity, 3, 2, shardActive, shardMatching);
+
+    // compare as (cell, index of segment on cell)
+    const auto expected = [&](const vector<Segment> &segments) {
+      std::set<std::pair<CellIdx, SegmentIdx>> result;
+      for(const auto seg : segments) result.emplace(single.cellForSegment(seg), single.idxOnCellForSegment(seg));
+      return result;
+    };
+    const auto actual = [&](const vector<ShardSegment> &segments) {
+      std::set<std::pair<CellIdx, SegmentIdx>> result;
+      for(const auto seg : segments) {
+        result.emplace(sharded.cellForSegment(seg), sharded.shard(seg.shard).idxOnCellForSegment(seg.segment));
+      }
+      return result;
+    };
+    ASSERT_EQ(expected(active), actual(shardActive)) << "iteration " << iter;
+    ASSERT_EQ(expected(matching), actual(shardMatching)) << "iteration " << iter;
+    ASSERT_EQ(active.size(), shardActive.size());
+  }
+}
+
+} // namespace testing
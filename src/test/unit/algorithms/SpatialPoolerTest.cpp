@@ -24,12 +24,20 @@
 #include <fstream>
 #include <stdio.h>
 #include <numeric>
+#include <set>
 
 #include "gtest/gtest.h"
 #include <htm/algorithms/SpatialPooler.hpp>
+#include <htm/algorithms/SpatialPoolerBitset.hpp>
+#include <htm/algorithms/SpatialPoolerIncremental.hpp>
+#include <htm/algorithms/SpatialPoolerLocality.hpp>
+#include <htm/algorithms/SpatialPoolerGpu.hpp>
 
 #include <htm/types/Types.hpp>
 #include <htm/utils/Log.hpp>
+#include <htm/os/Directory.hpp>
+#include <htm/os/ImportFilesystem.hpp>
+#include <htm/os/Path.hpp>
 #include <htm/os/Timer.hpp>
 
 namespace testing {
@@ -996,8 +1004,9 @@ TEST(SpatialPoolerTest, testUpdateBoostFactors) {
   {
   Real32 initActiveDutyCycles3[] = {0.1f, 0.3f, 0.02f, 0.04f, 0.7f, 0.12f};
   Real initBoostFactors3[] = {0, 0, 0, 0, 0, 0};
-  const vector<Real32> trueBoostFactors3 = {1.28586f, 0.795669f, 1.40094f,
-	                                    1.62534f, 0.367879f, 1.16682f};
+  // radius 5 covers all 6 columns, so every column's target density is the mean duty cycle
+  const vector<Real32> trueBoostFactors3 = {1.25441f, 0.840857f, 1.47207f,
+	                                    1.41435f, 0.377822f, 1.20523f};
   vector<Real32> resultBoostFactors3(6, 0);
   sp.setWrapAround(true);
   sp.setGlobalInhibition(false);
@@ -1195,6 +1204,527 @@ TEST(SpatialPoolerTest, testInhibitColumnsGlobal) {
 }
 
 
+TEST(SpatialPoolerTest, testInhibitColumnsGlobalTies) {
+  // Compare with sorting the columns by (overlap, index), for integer
+  // overlaps with many ties and for boosted (real valued) overlaps.
+  const UInt numColumns = 500;
+  SpatialPooler sp({10}, {numColumns});
+  Random rng(42);
+  for(const UInt stimulusThreshold : {0u, 3u}) {
+    sp.setStimulusThreshold(stimulusThreshold);
+    for(const bool boosted : {false, true}) {
+      for(const Real density : {0.002f, 0.02f, 0.1f, 0.5f, 1.0f}) {
+        vector<Real> overlaps(numColumns);
+        for(auto &overlap : overlaps) {
+          overlap = static_cast<Real>(rng.getUInt32(8));
+          if(boosted) overlap *= static_cast<Real>(rng.getReal64() + 0.5);
+        }
+
+        vector<UInt> expected(numColumns);
+        std::iota(expected.begin(), expected.end(), 0u);
+        std::sort(expected.begin(), expected.end(), [&](const UInt a, const UInt b) {
+          return (overlaps[a] == overlaps[b]) ? (a > b) : (overlaps[a] > overlaps[b]); });
+        expected.resize(static_cast<UInt>(density * numColumns));
+        while(!expected.empty() && overlaps[expected.back()] < stimulusThreshold) expected.pop_back();
+
+        const auto active = sp.inhibitColumnsGlobal_(overlaps, density);
+        ASSERT_EQ(active, expected) << "density " << density << " boosted " << boosted;
+      }
+    }
+  }
+}
+
+
+TEST(SpatialPoolerTest, testInhibitColumnsLocalTiles) {
+  // Compare with the column by column reference algorithm, for integer
+  // overlaps with many ties, with and without wrap around, and with threads.
+  SpatialPooler sp({10, 10}, {32, 32});
+  sp.setGlobalInhibition(false);
+  const UInt numColumns = sp.getNumColumns();
+  Random rng(42);
+  for(const UInt numThreads : {1u, 3u}) {
+    sp.setNumThreads(numThreads);
+    for(const bool wrap : {false, true}) {
+      sp.setWrapAround(wrap);
+      for(const UInt radius : {1u, 3u, 20u}) {
+        sp.setInhibitionRadius(radius);
+        const Real density = 0.2f;
+        vector<Real> overlaps(numColumns);
+        for(auto &overlap : overlaps) overlap = static_cast<Real>(rng.getUInt32(6));
+
+        vector<UInt> expected;
+        vector<bool> used(numColumns, false);
+        for(UInt column = 0; column < numColumns; column++) {
+          if(overlaps[column] < sp.getStimulusThreshold()) continue;
+          std::set<UInt> hood; //the box of +-radius around column, clipped or wrapped
+          for(Int dx = -(Int)radius; dx <= (Int)radius; dx++) {
+            for(Int dy = -(Int)radius; dy <= (Int)radius; dy++) {
+              Int x = (Int)(column / 32) + dx, y = (Int)(column % 32) + dy;
+              if(wrap) { x = (x % 32 + 32) % 32; y = (y % 32 + 32) % 32; }
+              if(x >= 0 && x < 32 && y >= 0 && y < 32) hood.insert(x * 32 + y);
+            }
+          }
+          const UInt numPoints = static_cast<UInt>(hood.size());
+          UInt bigger = 0;
+          for(const auto n : hood) {
+            if(n == column) continue;
+            if(overlaps[n] > overlaps[column] || (overlaps[n] == overlaps[column] && used[n])) bigger++;
+          }
+          if(bigger < static_cast<UInt>(0.5f + density * numPoints)) {
+            expected.push_back(column);
+            used[column] = true;
+          }
+        }
+
+        const auto active = sp.inhibitColumnsLocal_(overlaps, density);
+        ASSERT_EQ(active, expected) << "threads " << numThreads << " wrap " << wrap << " radius " << radius;
+      }
+    }
+  }
+}
+
+
+TEST(SpatialPoolerTest, testSparseBoostedOverlaps) {
+  // compute() boosts and inhibits only the columns with overlap > 0,
+  // which must give the same as the dense computation.
+  SpatialPooler sp({100}, {200});
+  sp.setBoostStrength(3.0f);
+  Random rng(5);
+  SDR input({100});
+  SDR active({200});
+  vector<Real> boostFactors(200);
+  for(UInt step = 0; step < 50; step++) {
+    input.randomize(0.05f, rng);
+    sp.getBoostFactors(boostFactors.data()); //learning updates them after the boosting
+    const auto overlaps = sp.compute(input, true, active);
+
+    vector<CellIdx> nonZero;
+    for(UInt column = 0; column < 200; column++) {
+      if(overlaps[column] > 0) nonZero.push_back(column);
+    }
+    const auto &boosted = sp.getBoostedOverlaps();
+    ASSERT_EQ(boosted.size(), 200u);
+    for(UInt column = 0; column < 200; column++) {
+      ASSERT_EQ(boosted[column], static_cast<Real>(overlaps[column]) * boostFactors[column]) << "column " << column;
+    }
+
+    // few inputs: sometimes less columns have an overlap than are desired
+    for(const UInt stimulusThreshold : {0u, 1u}) {
+      sp.setStimulusThreshold(stimulusThreshold);
+      for(const Real density : {0.02f, 0.2f, 0.6f}) {
+        ASSERT_EQ(sp.inhibitColumnsGlobal_(boosted, density, &nonZero),
+                  sp.inhibitColumnsGlobal_(boosted, density)) << "step " << step;
+      }
+    }
+    sp.setStimulusThreshold(0u);
+  }
+}
+
+
+TEST(SpatialPoolerTest, testUpdateColumnStates) {
+  // The fused bookkeeping pass must equal the separate steps,
+  // for global and local inhibition.
+  for(const bool global : {true, false}) {
+    SpatialPooler sp({64}, {128});
+    sp.setGlobalInhibition(global);
+    sp.setInhibitionRadius(5);
+    sp.setBoostStrength(2.0f);
+    sp.setMinPctOverlapDutyCycles(0.3f);
+    Random rng(9);
+    SDR input({64});
+    SDR active({128});
+    for(UInt step = 0; step < 20; step++) {
+      input.randomize(0.05f, rng);
+      sp.compute(input, true, active);
+    }
+    input.randomize(0.05f, rng);
+    vector<SynapseIdx> overlaps(128);
+    for(auto &overlap : overlaps) overlap = static_cast<SynapseIdx>(rng.getUInt32(3));
+    active.randomize(0.1f, rng);
+
+    auto separate = sp;
+    separate.updateDutyCycles_(overlaps, active);
+    separate.bumpUpWeakColumns_();
+    separate.updateBoostFactors_();
+    sp.updateColumnStates_(overlaps, active);
+    ASSERT_TRUE(sp == separate) << "global " << global;
+
+    // approximate exp()
+    auto fast = separate;
+    fast.setFastBoosting(true);
+    fast.updateBoostFactors_();
+    vector<Real> exact(128), approximate(128);
+    separate.getBoostFactors(exact.data());
+    fast.getBoostFactors(approximate.data());
+    for(UInt i = 0; i < 128; i++) {
+      ASSERT_NEAR(approximate[i], exact[i], exact[i] * 1.0e-6f) << "column " << i;
+    }
+  }
+}
+
+
+TEST(SpatialPoolerTest, testLearningThrottle) {
+  SpatialPooler sp({100}, {200});
+  EXPECT_ANY_THROW(sp.setLearningThrottle(0.0f, 1u));
+  EXPECT_ANY_THROW(sp.setLearningThrottle(1.5f, 1u));
+  EXPECT_ANY_THROW(sp.setLearningThrottle(0.5f, 0u));
+  EXPECT_FLOAT_EQ(sp.getEffectiveLearningRate(), 1.0f);
+
+  // no throttle learns as before
+  SpatialPooler plain = sp;
+  SpatialPooler none = sp;
+  none.setLearningThrottle(1.0f, 1u);
+  Random rng(17);
+  SDR input({100});
+  SDR active({200});
+  for(UInt step = 0; step < 10; step++) {
+    input.randomize(0.1f, rng);
+    plain.compute(input, true, active);
+    none.compute(input, true, active);
+  }
+  EXPECT_TRUE(plain == none);
+
+  // learnEvery: the synapses change only every 3rd compute
+  const auto permanences = [](const SpatialPooler &pooler) {
+    vector<Permanence> all;
+    const auto &c = pooler.getConnections();
+    for(Segment column = 0; column < pooler.getNumColumns(); column++) {
+      for(const auto synapse : c.synapsesForSegment(column)) all.push_back(c.permanenceForSynapse(synapse));
+    }
+    return all;
+  };
+  SpatialPooler every = sp;
+  every.setLearningThrottle(1.0f, 3u, false);
+  EXPECT_EQ(every.getLearnEvery(), 3u);
+  const auto before = permanences(every);
+  input.randomize(0.1f, rng);
+  every.compute(input, true, active);
+  every.compute(input, true, active);
+  EXPECT_EQ(permanences(every), before);
+  every.compute(input, true, active);
+  EXPECT_NE(permanences(every), before);
+
+  // learnFraction: the effective rate, and the same seed learns the same
+  SpatialPooler half = sp;
+  half.setLearningThrottle(0.5f, 2u, false, 5u);
+  SpatialPooler halfAgain = sp;
+  halfAgain.setLearningThrottle(0.5f, 2u, false, 5u);
+  SpatialPooler scaled = sp;
+  scaled.setLearningThrottle(0.5f, 2u, true, 5u);
+  for(UInt step = 0; step < 40; step++) {
+    input.randomize(0.1f, rng);
+    half.compute(input, true, active);
+    halfAgain.compute(input, true, active);
+    scaled.compute(input, true, active);
+  }
+  EXPECT_EQ(half.getConnections(), halfAgain.getConnections());
+  EXPECT_NEAR(half.getEffectiveLearningRate(), 0.25f, 0.03f);
+  EXPECT_NEAR(scaled.getEffectiveLearningRate(), 1.0f, 0.1f);
+}
+
+
+TEST(SpatialPoolerTest, testBitset) {
+  // the bitset overlaps must give the same columns as the Connections, while
+  // both learn, and in computeBatch()
+  for(const bool global : {true, false}) {
+    SpatialPooler plain({130}, {200});
+    plain.setGlobalInhibition(global);
+    plain.setInhibitionRadius(10);
+    plain.setBoostStrength(2.0f);
+    SpatialPooler bitset = plain;
+    bitset.setBitsetEnabled(true);
+    EXPECT_TRUE(bitset.isBitsetEnabled());
+    EXPECT_ANY_THROW(bitset.setGpuEnabled(true));
+    Random rng(13);
+    SDR input({130});
+    SDR expected({200});
+    SDR actual({200});
+    for(UInt step = 0; step < 50; step++) {
+      input.randomize(step % 2 ? 0.05f : 0.4f, rng);
+      const bool learn = step % 7 != 6;
+      const auto plainOverlaps  = plain.compute(input, learn, expected);
+      const auto bitsetOverlaps = bitset.compute(input, learn, actual);
+      ASSERT_EQ(bitsetOverlaps, plainOverlaps) << "step " << step << " global " << global;
+      ASSERT_EQ(actual, expected) << "step " << step << " global " << global;
+    }
+
+    vector<SDR> inputs(9, SDR({130}));
+    vector<SDR> expectedBatch(9, SDR({200}));
+    vector<SDR> actualBatch(9, SDR({200}));
+    for(auto &in : inputs) in.randomize(0.2f, rng);
+    plain.computeBatch(inputs, expectedBatch);
+    bitset.computeBatch(inputs, actualBatch);
+    for(size_t i = 0; i < inputs.size(); i++) {
+      ASSERT_EQ(actualBatch[i], expectedBatch[i]) << "input " << i << " global " << global;
+    }
+
+    // a copy builds its own matrix
+    SpatialPooler copy = bitset;
+    copy.compute(input, true, actual);
+    plain.compute(input, true, expected);
+    EXPECT_EQ(actual, expected);
+  }
+}
+
+
+TEST(SpatialPoolerTest, testBitsetFixedShape) {
+  // the kernels specialized for 1024 inputs give the same overlaps
+  SpatialPooler plain({1024}, {64});
+  SpatialPooler bitset = plain;
+  bitset.setBitsetEnabled(true);
+  Random rng(19);
+  SDR input({1024});
+  SDR expected({64});
+  SDR actual({64});
+  for(UInt step = 0; step < 10; step++) {
+    input.randomize(0.2f, rng);
+    ASSERT_EQ(bitset.compute(input, true, actual), plain.compute(input, true, expected)) << "step " << step;
+    ASSERT_EQ(actual, expected) << "step " << step;
+  }
+  Connections c(1024, 0.5f);
+  c.createSegment(0);
+  EXPECT_TRUE(SpatialPoolerBitset(c, 1024u, 1u).isFixedShape());
+  EXPECT_TRUE(SpatialPoolerBitset(c, 1000u, 1u).isFixedShape()); // rounded up to 1024
+  EXPECT_FALSE(SpatialPoolerBitset(c, 900u, 1u).isFixedShape());
+}
+
+
+TEST(SpatialPoolerTest, testIncremental) {
+  // the incremental overlaps must give the same columns as the Connections,
+  // while both learn, for slowly changing and for unrelated inputs
+  for(const bool global : {true, false}) {
+    SpatialPooler plain({150}, {200});
+    plain.setGlobalInhibition(global);
+    plain.setInhibitionRadius(10);
+    plain.setBoostStrength(2.0f);
+    SpatialPooler incremental = plain;
+    incremental.setIncrementalEnabled(true);
+    EXPECT_TRUE(incremental.isIncrementalEnabled());
+    EXPECT_ANY_THROW(incremental.setBitsetEnabled(true));
+    EXPECT_ANY_THROW(incremental.setGpuEnabled(true));
+    Random rng(23);
+    SDR input({150});
+    input.randomize(0.1f, rng);
+    SDR expected({200});
+    SDR actual({200});
+    for(UInt step = 0; step < 60; step++) {
+      if(step % 20 == 19) input.randomize(0.1f, rng);
+      else input.addNoise(0.05f, rng);
+      const bool learn = step % 7 != 6;
+      const auto plainOverlaps       = plain.compute(input, learn, expected);
+      const auto incrementalOverlaps = incremental.compute(input, learn, actual);
+      ASSERT_EQ(incrementalOverlaps, plainOverlaps) << "step " << step << " global " << global;
+      ASSERT_EQ(actual, expected) << "step " << step << " global " << global;
+    }
+
+    // a copy starts over from an empty input
+    SpatialPooler copy = incremental;
+    copy.compute(input, true, actual);
+    plain.compute(input, true, expected);
+    EXPECT_EQ(actual, expected);
+  }
+
+  // Only the changed bits are visited.
+  Connections c(100, 0.5f);
+  for(UInt column = 0; column < 10; column++) {
+    const Segment segment = c.createSegment(column);
+    for(UInt i = 0; i < 100; i += 10) c.createSynapse(segment, i + column, 0.6f);
+  }
+  SpatialPoolerIncremental overlaps(c, 100u, 10u);
+  SegmentActivity activity;
+  SDR input({100});
+  input.setSparse(SDR_sparse_t{0u, 1u, 10u, 55u});
+  overlaps.sync();
+  overlaps.computeOverlaps(input, activity);
+  EXPECT_EQ(overlaps.getNumChangedInputs(), 4u);
+  EXPECT_EQ(activity.numActiveConnected, vector<SynapseIdx>({2, 1, 0, 0, 0, 1, 0, 0, 0, 0}));
+  EXPECT_EQ(activity.touched, vector<Segment>({0u, 1u, 5u}));
+  input.setSparse(SDR_sparse_t{0u, 1u, 10u, 56u});
+  c.updateSynapsePermanence(c.synapsesForSegment(0u)[0], 0.1f); // input 0 disconnects from column 0
+  overlaps.sync();
+  overlaps.computeOverlaps(input, activity);
+  EXPECT_EQ(overlaps.getNumChangedInputs(), 2u);
+  EXPECT_EQ(activity.numActiveConnected, vector<SynapseIdx>({1, 1, 0, 0, 0, 0, 1, 0, 0, 0}));
+}
+
+
+TEST(SpatialPoolerTest, testLocality) {
+  EXPECT_EQ(SpatialPoolerLocality::zOrder({4, 4}),
+            vector<UInt>({0, 1, 4, 5, 2, 3, 6, 7, 8, 9, 12, 13, 10, 11, 14, 15}));
+  EXPECT_EQ(SpatialPoolerLocality::zOrder({2, 3}), vector<UInt>({0, 1, 4, 2, 3, 5}));
+  EXPECT_EQ(SpatialPoolerLocality::zOrder({5}), vector<UInt>({0, 1, 2, 3, 4}));
+
+  // the renumbered overlaps must give the same columns as the Connections,
+  // while both learn
+  for(const bool global : {true, false}) {
+    SpatialPooler plain({24, 20}, {12, 10}, 4u);
+    plain.setGlobalInhibition(global);
+    plain.setBoostStrength(2.0f);
+    SpatialPooler locality = plain;
+    locality.setLocalityEnabled(true);
+    EXPECT_TRUE(locality.isLocalityEnabled());
+    EXPECT_ANY_THROW(locality.setBitsetEnabled(true));
+    EXPECT_ANY_THROW(locality.setIncrementalEnabled(true));
+    EXPECT_ANY_THROW(locality.setGpuEnabled(true));
+    Random rng(29);
+    SDR input({24, 20});
+    SDR expected({12, 10});
+    SDR actual({12, 10});
+    for(UInt step = 0; step < 60; step++) {
+      input.randomize(0.1f, rng);
+      const bool learn = step % 7 != 6;
+      const auto plainOverlaps    = plain.compute(input, learn, expected);
+      const auto localityOverlaps = locality.compute(input, learn, actual);
+      ASSERT_EQ(localityOverlaps, plainOverlaps) << "step " << step << " global " << global;
+      ASSERT_EQ(actual, expected) << "step " << step << " global " << global;
+    }
+    EXPECT_GT(locality.memoryUsage().at("caches"), plain.memoryUsage().at("caches"));
+
+    SpatialPooler copy = locality;
+    copy.compute(input, true, actual);
+    plain.compute(input, true, expected);
+    EXPECT_EQ(actual, expected);
+  }
+
+  // A synapse crossing the threshold updates the lists.
+  Connections c(16, 0.5f);
+  for(UInt column = 0; column < 4; column++) {
+    const Segment segment = c.createSegment(column);
+    for(UInt i = 0; i < 16; i += 4) c.createSynapse(segment, i + column, 0.6f);
+  }
+  SpatialPoolerLocality overlaps(c, {4u, 4u}, {2u, 2u});
+  SegmentActivity activity;
+  SDR input({4, 4});
+  input.setSparse(SDR_sparse_t{0u, 1u, 4u, 13u});
+  overlaps.sync();
+  overlaps.computeOverlaps(input, activity);
+  EXPECT_EQ(activity.numActiveConnected, vector<SynapseIdx>({2, 2, 0, 0}));
+  std::sort(activity.touched.begin(), activity.touched.end());
+  EXPECT_EQ(activity.touched, vector<Segment>({0u, 1u}));
+  c.updateSynapsePermanence(c.synapsesForSegment(1u)[3], 0.1f); // input 13 disconnects from column 1
+  c.updateSynapsePermanence(c.synapsesForSegment(2u)[0], 0.4f); // below, input 2 is not active anyway
+  overlaps.sync();
+  overlaps.computeOverlaps(input, activity);
+  EXPECT_EQ(activity.numActiveConnected, vector<SynapseIdx>({2, 1, 0, 0}));
+  c.updateSynapsePermanence(c.synapsesForSegment(1u)[3], 0.7f);
+  overlaps.sync();
+  overlaps.computeOverlaps(input, activity);
+  EXPECT_EQ(activity.numActiveConnected, vector<SynapseIdx>({2, 2, 0, 0}));
+}
+
+
+TEST(SpatialPoolerTest, testGpu) {
+  // the GPU must give the same columns as the host, while both learn
+  if(not SpatialPoolerGpu::available()) {
+    SpatialPooler sp({10}, {20});
+    EXPECT_ANY_THROW(sp.setGpuEnabled(true));
+    EXPECT_FALSE(sp.isGpuEnabled());
+    GTEST_SKIP() << "built without HTM_CUDA, or no CUDA device";
+  }
+  for(const bool global : {true, false}) {
+    SpatialPooler host({100}, {300});
+    host.setGlobalInhibition(global);
+    host.setInhibitionRadius(10);
+    host.setBoostStrength(2.0f);
+    SpatialPooler gpu = host;
+    gpu.setGpuEnabled(true);
+    EXPECT_TRUE(gpu.isGpuEnabled());
+    Random rng(11);
+    SDR input({100});
+    SDR expected({300});
+    SDR actual({300});
+    for(UInt step = 0; step < 50; step++) {
+      input.randomize(0.1f, rng);
+      const bool learn = step % 7 != 6;
+      const auto hostOverlaps = host.compute(input, learn, expected);
+      const auto gpuOverlaps  = gpu.compute(input, learn, actual);
+      ASSERT_EQ(gpuOverlaps, hostOverlaps) << "step " << step << " global " << global;
+      ASSERT_EQ(actual, expected) << "step " << step << " global " << global;
+    }
+    // a copy makes its own device copy
+    SpatialPooler copy = gpu;
+    copy.compute(input, true, actual);
+    host.compute(input, true, expected);
+    EXPECT_EQ(actual, expected);
+  }
+}
+
+
+TEST(SpatialPoolerTest, testComputeBatch) {
+  // computeBatch() must give the same columns as compute() without learning,
+  // with global and local inhibition, with and without threads.
+  for(const bool global : {true, false}) {
+    SpatialPooler sp({100}, {300});
+    sp.setGlobalInhibition(global);
+    sp.setInhibitionRadius(10);
+    sp.setBoostStrength(2.0f);
+    Random rng(7);
+    SDR input({100});
+    SDR active({300});
+    for(UInt step = 0; step < 20; step++) { //learn some, so the boost factors differ
+      input.randomize(0.1f, rng);
+      sp.compute(input, true, active);
+    }
+
+    vector<SDR> inputs(23, SDR({100}));
+    for(auto &sdr : inputs) sdr.randomize(0.1f, rng);
+    vector<SDR> expected(inputs.size(), SDR({300}));
+    SpatialPooler reference(sp);
+    for(size_t i = 0; i < inputs.size(); i++) {
+      reference.compute(inputs[i], false, expected[i]);
+    }
+
+    for(const UInt numThreads : {1u, 3u}) {
+      sp.setNumThreads(numThreads);
+      const auto boosted   = sp.getBoostedOverlaps();
+      const auto iteration = sp.getIterationNum();
+      vector<SDR> outputs(inputs.size(), SDR({300}));
+      sp.computeBatch(inputs, outputs);
+      for(size_t i = 0; i < inputs.size(); i++) {
+        ASSERT_EQ(outputs[i].getSparse(), expected[i].getSparse())
+            << "global " << global << " threads " << numThreads << " input " << i;
+      }
+      EXPECT_EQ(sp.getIterationNum(), iteration + inputs.size());
+      EXPECT_EQ(sp.getBoostedOverlaps(), boosted); //no side effects
+    }
+
+    vector<SDR> outputs(2, SDR({300}));
+    EXPECT_ANY_THROW(sp.computeBatch(inputs, outputs));
+  }
+}
+
+
+TEST(SpatialPoolerTest, testParallelInitialize) {
+  // Per column random streams give the same model for any number of threads.
+  const auto init = [](SpatialPooler &sp, const Random::Engine engine) {
+    sp.initialize({30, 20}, {40, 32}, /*potentialRadius*/ 6u, 0.5f, /*globalInhibition*/ false,
+                  0.05f, 0u, 0u, 0.01f, 0.1f, 0.1f, 0.001f, 1000u, 0.0f, /*seed*/ 7,
+                  0u, /*wrapAround*/ true, engine);
+  };
+  SpatialPooler serial;
+  init(serial, Random::COUNTER);
+  EXPECT_EQ(serial.getConnections().numSegments(), 40u * 32u);
+  for(const UInt numThreads : {2u, 5u}) {
+    SpatialPooler threaded;
+    threaded.setNumThreads(numThreads);
+    init(threaded, Random::COUNTER);
+    EXPECT_TRUE(serial == threaded) << "threads " << numThreads;
+  }
+
+  // the default engine keeps its single stream
+  SpatialPooler legacy;
+  legacy.setNumThreads(3u);
+  init(legacy, Random::MT19937);
+  SpatialPooler legacySerial;
+  init(legacySerial, Random::MT19937);
+  EXPECT_TRUE(legacy == legacySerial);
+  vector<UInt> potentialLegacy(legacy.getNumInputs()), potentialCounter(serial.getNumInputs());
+  legacy.getPotential(0u, potentialLegacy.data());
+  serial.getPotential(0u, potentialCounter.data());
+  EXPECT_NE(potentialLegacy, potentialCounter);
+}
+
+
 TEST(SpatialPoolerTest, testValidateGlobalInhibitionParameters) {
   // With 10 columns the minimum sparsity for global inhibition is 10%
   // Setting sparsity to 2% should throw an exception
@@ -1940,6 +2470,89 @@ TEST(SpatialPoolerTest, testSaveLoad_ar) {
 }
 
 
+TEST(SpatialPoolerTest, testCheckpoint) {
+  const char *filename = "SpatialPoolerCheckpoint.tmp";
+  Random random(10);
+  SpatialPooler sp1({200u}, {200u});
+  SDR input({200u});
+  SDR output1({200u});
+  for (UInt i = 0; i < 50; ++i) {
+    input.randomize(0.05f, random);
+    sp1.compute(input, true, output1);
+  }
+
+  sp1.saveCheckpoint(filename);
+  SpatialPooler sp2;
+  sp2.loadCheckpoint(filename);
+  int ret = ::remove(filename);
+  ASSERT_TRUE(ret == 0) << "Failed to delete " << filename;
+
+  ASSERT_EQ(sp1, sp2);
+  // same learning afterwards
+  SDR output2({200u});
+  for (UInt i = 0; i < 10; ++i) {
+    input.randomize(0.05f, random);
+    sp1.compute(input, true, output1);
+    sp2.compute(input, true, output2);
+    ASSERT_EQ(output1, output2);
+  }
+  ASSERT_EQ(sp1, sp2);
+}
+
+
+TEST(SpatialPoolerTest, testInitializationCache) {
+  const string directory = "SpatialPoolerInitializationCache.tmp";
+  Directory::removeTree(directory, true);
+  struct Disable { // also when an assertion fails
+    const string &directory;
+    ~Disable() { SpatialPooler::setInitializationCache(""); Directory::removeTree(directory, true); }
+  } disable{directory};
+  SpatialPooler::setInitializationCache(directory);
+  EXPECT_EQ(SpatialPooler::getInitializationCache(), directory);
+
+  const auto entries = [&]() {
+    vector<string> files;
+    for (const auto &entry : fs::directory_iterator(directory)) files.push_back(entry.path().string());
+    return files;
+  };
+  SpatialPooler sp1({200u}, {300u}, 16u, 0.5f, false, 0.1f, 0u, 0u, 0.008f, 0.05f, 0.1f, 0.001f, 1000u, 0.0f, 42);
+  const auto files = entries();
+  ASSERT_EQ(files.size(), 1u) << "initialize() writes its cache entry";
+
+  // a second initialization loads the entry
+  SpatialPooler sp2({200u}, {300u}, 16u, 0.5f, false, 0.1f, 0u, 0u, 0.008f, 0.05f, 0.1f, 0.001f, 1000u, 0.0f, 42);
+  EXPECT_EQ(entries().size(), 1u);
+  ASSERT_EQ(sp1, sp2);
+  Random random(10);
+  SDR input({200u});
+  SDR output1({300u});
+  SDR output2({300u});
+  for (UInt i = 0; i < 10; ++i) {
+    input.randomize(0.05f, random);
+    sp1.compute(input, true, output1);
+    sp2.compute(input, true, output2);
+    ASSERT_EQ(output1, output2);
+  }
+
+  // other parameters, other entry; a random seed is not cached
+  SpatialPooler sp3({200u}, {300u}, 16u, 0.5f, false, 0.1f, 0u, 0u, 0.008f, 0.05f, 0.1f, 0.001f, 1000u, 0.0f, 43);
+  EXPECT_EQ(entries().size(), 2u);
+  SpatialPooler sp4({200u}, {300u}, 16u, 0.5f, false, 0.1f, 0u, 0u, 0.008f, 0.05f, 0.1f, 0.001f, 1000u, 0.0f, 0);
+  EXPECT_EQ(entries().size(), 2u);
+
+  // a damaged entry is recomputed and replaced
+  Path::write_all(files[0], "not a checkpoint");
+  SpatialPooler sp5({200u}, {300u}, 16u, 0.5f, false, 0.1f, 0u, 0u, 0.008f, 0.05f, 0.1f, 0.001f, 1000u, 0.0f, 42);
+  SpatialPooler fresh({200u}, {300u}, 16u, 0.5f, false, 0.1f, 0u, 0u, 0.008f, 0.05f, 0.1f, 0.001f, 1000u, 0.0f, 42);
+  EXPECT_EQ(entries().size(), 2u);
+  EXPECT_GT(Path::getFileSize(files[0]), 100u);
+  SpatialPooler::setInitializationCache("");
+  SpatialPooler plain({200u}, {300u}, 16u, 0.5f, false, 0.1f, 0u, 0u, 0.008f, 0.05f, 0.1f, 0.001f, 1000u, 0.0f, 42);
+  EXPECT_EQ(sp5, plain);
+  EXPECT_EQ(fresh, plain);
+}
+
+
 
 TEST(SpatialPoolerTest, testSerialization_ar) {
   Random random(10);
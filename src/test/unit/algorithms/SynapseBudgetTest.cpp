@@ -0,0 +1,171 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2014-2016, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of unit tests for SynapseBudget
+ */
+
+#include "gtest/gtest.h"
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "htm/algorithms/Connections.hpp"
+#include "htm/algorithms/SynapseBudget.hpp"
+
+namespace testing {
+
+using namespace htm;
+using std::vector;
+
+// numSegments segments of synapsesPerSegment synapses, segment i last used in iteration i.
+static void grow(Connections &c, UInt numSegments, UInt synapsesPerSegment) {
+  for(UInt s = 0u; s < numSegments; s++) {
+    const Segment seg = c.createSegment(s % c.numCells(), 1000u);
+    c.dataForSegment(seg).lastUsed = s;
+    for(UInt i = 0u; i < synapsesPerSegment; i++) {
+      c.createSynapse(seg, i, 0.1f + 0.01f * static_cast<Real>(i));
+    }
+  }
+}
+
+TEST(SynapseBudgetTest, FairShares) {
+  SynapseBudget budget(300u, 0u);
+  auto a = budget.attach();
+  auto b = budget.attach();
+  auto c = budget.attach();
+  const size_t unlimited = std::numeric_limits<size_t>::max();
+
+  a->synapses = 50u; b->synapses = 100u; c->synapses = 100u;
+  budget.rebalance();
+  EXPECT_EQ(budget.numModels(), 3u);
+  EXPECT_EQ(budget.numSynapses(), 250u);
+  EXPECT_EQ(a->target, unlimited);
+  EXPECT_EQ(c->target, unlimited);
+
+  // 150 over the budget, taken from b and c, the furthest over the most.
+  a->synapses = 50u; b->synapses = 150u; c->synapses = 250u;
+  budget.rebalance();
+  EXPECT_EQ(a->target, unlimited);
+  EXPECT_EQ(b->target, 112u);
+  EXPECT_EQ(c->target, 137u);
+
+  a->synapses = 10u; b->synapses = 120u; c->synapses = 270u;
+  budget.rebalance();
+  EXPECT_EQ(a->target, unlimited);
+  EXPECT_GE(b->target, 100u);
+  EXPECT_GE(c->target, 100u);
+  EXPECT_LE(10u + b->target + c->target, 300u);
+
+  // A detached model drops out.
+  c.reset();
+  budget.rebalance();
+  EXPECT_EQ(budget.numModels(), 2u);
+  EXPECT_EQ(b->target, unlimited);
+}
+
+TEST(SynapseBudgetTest, PruneSegments) {
+  auto budget = std::make_shared<SynapseBudget>(200u, 0u);
+  Connections big(100u, 0.5f);
+  Connections small(100u, 0.5f);
+  grow(big, 50u, 10u);
+  grow(small, 5u, 10u);
+  big.setSynapseBudget(budget);
+  small.setSynapseBudget(budget);
+  EXPECT_EQ(big.getSynapseBudget(), budget);
+
+  // Published at the next learning compute.
+  big.computeActivity({}, true);
+  small.computeActivity({}, true);
+  budget->rebalance();
+  EXPECT_EQ(budget->numSynapses(), 550u);
+
+  // Inference does not prune.
+  big.computeActivity({}, false);
+  EXPECT_EQ(big.numSynapses(), 500u);
+
+  big.computeActivity({}, true);
+  small.computeActivity({}, true);
+  EXPECT_EQ(big.numSynapses(), 150u);
+  EXPECT_EQ(big.numSegments(), 15u);
+  EXPECT_EQ(small.numSynapses(), 50u);
+  EXPECT_EQ(big.numBudgetPrunedSynapses(), 350u);
+  // The least recently used went first.
+  for(CellIdx cell = 0u; cell < big.numCells(); cell++) {
+    for(const Segment seg : big.segmentsForCell(cell)) {
+      EXPECT_GE(big.dataForSegment(seg).lastUsed, 35u);
+    }
+  }
+
+  budget->rebalance();
+  EXPECT_EQ(budget->numSynapses(), 200u);
+}
+
+TEST(SynapseBudgetTest, PruneWeakestSynapses) {
+  auto budget = std::make_shared<SynapseBudget>(100u, 0u);
+  Connections c(100u, 0.5f);
+  grow(c, 10u, 20u);
+  c.setSynapseBudget(budget, false);
+  c.computeActivity({}, true);
+  budget->rebalance();
+  c.computeActivity({}, true);
+
+  EXPECT_EQ(c.numSynapses(), 100u);
+  EXPECT_EQ(c.numSegments(), 10u); // the segments are kept
+  for(CellIdx cell = 0u; cell < c.numCells(); cell++) {
+    for(const Segment seg : c.segmentsForCell(cell)) {
+      EXPECT_EQ(c.numSynapses(seg), 10u);
+      for(const Synapse syn : c.synapsesForSegment(seg)) {
+        EXPECT_GE(c.dataForSynapse(syn).permanence, 0.19f);
+      }
+    }
+  }
+}
+
+TEST(SynapseBudgetTest, PruneInSteps) {
+  auto budget = std::make_shared<SynapseBudget>(100u, 0u);
+  budget->setMaxPrunePerCompute(30u);
+  Connections c(100u, 0.5f);
+  grow(c, 20u, 10u);
+  c.setSynapseBudget(budget);
+  c.computeActivity({}, true);
+  budget->rebalance();
+  c.computeActivity({}, true);
+  EXPECT_EQ(c.numSynapses(), 170u);
+  for(int i = 0; i < 5; i++) c.computeActivity({}, true);
+  EXPECT_EQ(c.numSynapses(), 100u);
+}
+
+TEST(SynapseBudgetTest, BackgroundThread) {
+  auto budget = std::make_shared<SynapseBudget>(100u, 1u);
+  Connections c(100u, 0.5f);
+  grow(c, 20u, 10u);
+  c.setSynapseBudget(budget);
+  for(int i = 0; i < 1000 and c.numSynapses() > 100u; i++) {
+    c.computeActivity({}, true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(c.numSynapses(), 100u);
+
+  c.setSynapseBudget(nullptr);
+  budget->rebalance();
+  EXPECT_EQ(budget->numModels(), 0u);
+}
+
+} // namespace testing
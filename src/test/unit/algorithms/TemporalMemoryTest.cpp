@@ -21,6 +21,7 @@
 
 #include <cstring>
 #include <fstream>
+#include <numeric>
 
 #include <htm/types/Types.hpp>
 #include <htm/types/Sdr.hpp>
@@ -29,6 +30,7 @@
 #include <cstdio>
 
 #include "gtest/gtest.h"
+#include <htm/algorithms/Anomaly.hpp>
 #include <htm/algorithms/TemporalMemory.hpp>
 
 
@@ -88,6 +90,50 @@ TEST(TemporalMemoryTest, ActivateCorrectlyPredictiveCells) {
   EXPECT_EQ(expectedActiveCells, tm.getActiveCells());
 }
 
+/**
+ * The predictive cells are kept by the TM, each cell is listed once even
+ * with several active segments, and reset() clears them.
+ */
+TEST(TemporalMemoryTest, PredictiveCellsRef) {
+  TemporalMemory tm(
+      /*columnDimensions*/ {32},
+      /*cellsPerColumn*/ 4,
+      /*activationThreshold*/ 3,
+      /*initialPermanence*/ 0.21f,
+      /*connectedPermanence*/ 0.50f,
+      /*minThreshold*/ 2,
+      /*maxNewSynapseCount*/ 3,
+      /*permanenceIncrement*/ 0.10f,
+      /*permanenceDecrement*/ 0.10f,
+      /*predictedSegmentDecrement*/ 0.0f,
+      /*seed*/ 42);
+
+  SDR previousActiveColumns({32});
+  previousActiveColumns.setSparse(SDR_sparse_t{0});
+  const vector<CellIdx> previousActiveCells = {0, 1, 2, 3};
+
+  for(const CellIdx cell : {9u, 4u, 4u}) {
+    Segment segment = tm.createSegment(cell);
+    for(const auto presyn : previousActiveCells)
+      tm.createSynapse(segment, presyn, 0.5f);
+  }
+
+  tm.compute(previousActiveColumns, false);
+  tm.activateDendrites();
+  EXPECT_EQ(tm.getActiveSegments().size(), 3u);
+
+  const SDR &predictive = tm.getPredictiveCellsRef();
+  EXPECT_EQ(predictive.dimensions, vector<UInt>({32u, 4u}));
+  EXPECT_EQ(predictive.getSparse(), SDR_sparse_t({4u, 9u}));
+  EXPECT_EQ(&predictive, &tm.getPredictiveCellsRef());
+  EXPECT_EQ(predictive, tm.getPredictiveCells());
+
+  tm.reset();
+  EXPECT_ANY_THROW(tm.getPredictiveCellsRef());
+  tm.activateDendrites();
+  EXPECT_EQ(predictive.getSum(), 0u);
+}
+
 /**
  * When an unpredicted column is activated, every cell in the column should
  * become active.
@@ -1020,6 +1066,30 @@ TEST(TemporalMemoryTest, PunishMatchingSegmentsInInactiveColumns) {
               EPSILON);
 }
 
+/**
+ * setSinglePassLeastUsedCell(): the winner of a bursting column without
+ * matching segments is one of the cells with the fewest segments, each of them
+ * chosen sometimes.
+ */
+TEST(TemporalMemoryTest, SinglePassLeastUsedCell) {
+  TemporalMemory tm({32}, 4, 3, 0.2f, 0.5f, 2, 4, 0.1f, 0.1f, 0.02f, /*seed*/ 1);
+  EXPECT_FALSE(tm.getSinglePassLeastUsedCell());
+  tm.setSinglePassLeastUsedCell(true);
+  tm.createSegment(0);
+  tm.createSegment(3);
+
+  SDR activeColumns({32});
+  activeColumns.setSparse(SDR_sparse_t{0});
+  set<CellIdx> winners;
+  for(int i = 0; i < 50; i++) {
+    tm.reset();
+    tm.compute(activeColumns, false);
+    ASSERT_EQ(tm.getWinnerCells().size(), 1u);
+    winners.insert(tm.getWinnerCells()[0]);
+  }
+  EXPECT_EQ(winners, set<CellIdx>({1, 2}));
+}
+
 /**
  * In a bursting column with no matching segments, a segment should be added
  * to the cell with the fewest segments. When there's a tie, choose "the first". 
@@ -1339,6 +1409,23 @@ TEST(TemporalMemoryTest, testColumnForCell2D) {
   ASSERT_EQ(4095ul, tm.columnForCell(16383));
 }
 
+TEST(TemporalMemoryTest, testCellsForColumn) {
+  for(const UInt cellsPerColumn : {1u, 5u, 8u, 32u}) {
+    TemporalMemory tm;
+    tm.initialize(vector<UInt>{100}, cellsPerColumn);
+    const auto cells = tm.cellsForColumn(7);
+    ASSERT_EQ(cells.size(), cellsPerColumn);
+    ASSERT_EQ(cells.front(), 7u * cellsPerColumn);
+    vector<CellIdx> expected(cellsPerColumn);
+    std::iota(expected.begin(), expected.end(), 7u * cellsPerColumn);
+    EXPECT_EQ(static_cast<vector<CellIdx>>(cells), expected);
+    for(const auto cell : cells) {
+      EXPECT_EQ(tm.columnForCell(cell), 7u);
+    }
+    EXPECT_EQ(tm.columnForCell(static_cast<CellIdx>(100u * cellsPerColumn - 1u)), 99u);
+  }
+}
+
 TEST(TemporalMemoryTest, testColumnForCellInvalidCell) {
   TemporalMemory tm;
   tm.initialize(vector<UInt>{64, 64}, 4);
@@ -1369,6 +1456,13 @@ TEST(TemporalMemoryTest, testCellsToColumns)
   res = tm.cellsToColumns(v1);
   EXPECT_TRUE(res.getSparse().empty());
 
+  SDR cols({3});
+  v1.setSparse(SDR_sparse_t{0, 1, 4, 5, 8});
+  tm.cellsToColumns(v1, cols);
+  ASSERT_EQ(cols.getSparse(), SDR_sparse_t({0u, 1u, 2u}));
+  SDR tooSmall({2});
+  EXPECT_ANY_THROW(tm.cellsToColumns(v1, tooSmall));
+
   SDR larger({10,10, 3});
   EXPECT_ANY_THROW(tm.cellsToColumns(larger));
 
@@ -1536,6 +1630,33 @@ TEST(TemporalMemoryTest, testSaveLoad) {
   serializationTestVerify(tm2);
 }
 
+TEST(TemporalMemoryTest, testCheckpoint) {
+  const char *filename = "TemporalMemoryCheckpoint.tmp";
+  TemporalMemory tm1(
+      /*columnDimensions*/ {32},
+      /*cellsPerColumn*/ 4,
+      /*activationThreshold*/ 3,
+      /*initialPermanence*/ 0.21f,
+      /*connectedPermanence*/ 0.50f,
+      /*minThreshold*/ 2,
+      /*maxNewSynapseCount*/ 3,
+      /*permanenceIncrement*/ 0.10f,
+      /*permanenceDecrement*/ 0.10f,
+      /*predictedSegmentDecrement*/ 0.0f,
+      /*seed*/ 42);
+
+  serializationTestPrepare(tm1);
+
+  tm1.saveCheckpoint(filename);
+  TemporalMemory tm2;
+  tm2.loadCheckpoint(filename);
+  int ret = ::remove(filename);
+  ASSERT_TRUE(ret == 0) << "Failed to delete " << filename;
+
+  ASSERT_TRUE(tm1 == tm2);
+  serializationTestVerify(tm2);
+}
+
 TEST(TemporalMemoryTest, testSaveArLoadAr) {
   TemporalMemory tm1(
       /*columnDimensions*/ {32},
@@ -1638,6 +1759,275 @@ TEST(TemporalMemoryTest, testExtraActive) {
   }
 }
 
+TEST(TemporalMemoryTest, testCellsView) {
+  SDR columns({50});
+  TemporalMemory tm(columns.dimensions, 4, 3, 0.5f, 0.5f, 2, 4, 0.1f, 0.0f, 0.0f, 42,
+                    255, 255, true, /* externalPredictiveInputs */ 20u);
+  SDR extraActive({20u});
+  SDR extraWinners({20u});
+  extraActive.setSparse(SDR_sparse_t{1u, 7u});
+  extraWinners.setSparse(SDR_sparse_t{7u});
+  SDR cells({50u, 4u});
+  SDR cols({50u});
+
+  Random rng(7);
+  for(UInt step = 0u; step < 10u; step++) {
+    columns.randomize(0.1f, rng);
+    tm.compute(columns, true, extraActive, extraWinners);
+
+    const SDRView active = tm.getActiveCellsView();
+    ASSERT_EQ(active.getDimensions(), cells.dimensions);
+    tm.getActiveCells(cells);
+    SDR copy(cells.dimensions);
+    active.copyTo(copy);
+    ASSERT_EQ(copy, cells);
+    tm.cellsToColumns(active, cols);
+    ASSERT_EQ(cols, columns);
+
+    tm.getWinnerCells(cells);
+    const UInt numWinners = cells.getSum();
+    ASSERT_EQ(tm.getWinnerCellsView().getOverlap(SDRView(cells)), numWinners);
+
+    // The external inputs are not part of the active cells.
+    tm.activateDendrites(true, extraActive, extraWinners);
+    ASSERT_EQ(tm.getActiveCells().size(), active.getSum());
+    ASSERT_EQ(tm.getActiveCellsView().getSum(), active.getSum());
+    ASSERT_EQ(tm.getWinnerCellsView().getSum(), numWinners);
+    tm.getActiveCells(cells);
+  }
+}
+
+TEST(TemporalMemoryTest, testExternalInputsSeparateCalls) {
+  // compute() reads the external inputs from its SDRs, activateDendrites()
+  // keeps them for activateCells(): both learn the same.
+  SDR columns({64});
+  const auto make = []() {
+    return TemporalMemory({64}, 4, 3, 0.21f, 0.5f, 2, 8, 0.1f, 0.05f, 0.01f, 42,
+                          255, 255, true, /* externalPredictiveInputs */ 30u);
+  };
+  TemporalMemory fused = make();
+  TemporalMemory split = make();
+  SDR extraActive({30u});
+  SDR extraWinners({30u});
+  Random rng(11);
+  for(UInt step = 0u; step < 40u; step++) {
+    columns.randomize(0.1f, rng);
+    extraActive.randomize(0.2f, rng);
+    SDR_sparse_t winners;
+    for(size_t i = 0u; i < extraActive.getSparse().size(); i += 2u) winners.push_back(extraActive.getSparse()[i]);
+    extraWinners.setSparse(winners);
+    fused.compute(columns, true, extraActive, extraWinners);
+    split.activateDendrites(true, extraActive, extraWinners);
+    split.activateCells(columns, true);
+    ASSERT_EQ(fused.getActiveCells(), split.getActiveCells()) << step;
+    ASSERT_EQ(fused.getWinnerCells(), split.getWinnerCells()) << step;
+  }
+  ASSERT_EQ(fused.connections, split.connections);
+
+  // Saved between the two calls, the external inputs are kept.
+  columns.randomize(0.1f, rng);
+  split.activateDendrites(true, extraActive, extraWinners);
+  stringstream ss;
+  split.save(ss);
+  TemporalMemory loaded;
+  loaded.load(ss);
+  split.activateCells(columns, true);
+  loaded.activateCells(columns, true);
+  ASSERT_EQ(split.getWinnerCells(), loaded.getWinnerCells());
+  ASSERT_EQ(split.connections, loaded.connections);
+
+  // Synapses grew from the external inputs, which follow the cells.
+  size_t external = 0u;
+  for(Segment segment = 0u; segment < fused.connections.segmentFlatListLength(); segment++) {
+    for(const Synapse s : fused.connections.synapsesForSegment(segment)) {
+      if(fused.connections.dataForSynapse(s).presynapticCell >= fused.numberOfCells()) external++;
+    }
+  }
+  EXPECT_GT(external, 0u);
+}
+
+TEST(TemporalMemoryTest, testRawAnomalyCounted) {
+  // The anomaly counted in activateCells() equals the one computed from SDRs.
+  TemporalMemory tm({64}, 4, 3, 0.21f, 0.5f, 2, 8, 0.1f, 0.1f, 0.0f, 42);
+  Random rng(7);
+  vector<SDR> sequence(5, SDR({64}));
+  for(auto &x : sequence) x.randomize(0.1f, rng);
+  for(UInt step = 0; step < 60u; step++) {
+    SDR x = sequence[step % sequence.size()];
+    if(step % 7u == 0u) x.addNoise(0.5f, rng);
+    tm.activateDendrites(true);
+    const Real expected = computeRawAnomalyScore(x, tm.cellsToColumns(tm.getPredictiveCells()));
+    tm.compute(x, true);
+    ASSERT_EQ(tm.anomaly, expected) << "step " << step;
+  }
+}
+
+TEST(TemporalMemoryTest, testCompactThreshold) {
+  // Compacting the connections must not change the results of the TM.
+  // Few segments per cell, so that segments get destroyed and recreated.
+  const auto makeTM = []() {
+    return TemporalMemory({50},
+      /* cellsPerColumn */               4,
+      /* activationThreshold */          3,
+      /* initialPermanence */            0.21f,
+      /* connectedPermanence */          0.50f,
+      /* minThreshold */                 2,
+      /* maxNewSynapseCount */           6,
+      /* permanenceIncrement */          0.10f,
+      /* permanenceDecrement */          0.10f,
+      /* predictedSegmentDecrement */    0.02f,
+      /* seed */                         42,
+      /* maxSegmentsPerCell */           2,
+      /* maxSynapsesPerSegment */        8);
+  };
+  auto tm        = makeTM();
+  auto compacted = makeTM();
+  compacted.setCompactThreshold(0.05f);
+
+  Random rng(3);
+  SDR columns({50});
+  size_t lengthTM = 0, lengthCompacted = 0;
+  for(UInt step = 0; step < 300; step++) {
+    columns.randomize(0.1f, rng);
+    tm.compute(columns, true);
+    compacted.compute(columns, true);
+    ASSERT_EQ(tm.getActiveCells(), compacted.getActiveCells()) << "step " << step;
+    ASSERT_EQ(tm.getWinnerCells(), compacted.getWinnerCells()) << "step " << step;
+    lengthTM        = tm.connections.segmentFlatListLength();
+    lengthCompacted = compacted.connections.segmentFlatListLength();
+  }
+  ASSERT_EQ(tm.connections.numSegments(), compacted.connections.numSegments());
+  ASSERT_LT(lengthCompacted, lengthTM);
+}
+
+TEST(TemporalMemoryTest, testSegmentsInCellOrder) {
+  // The active & matching segments are sorted by cell without compareSegments(),
+  // with many segments (radix sort) and cells beyond 8 bits.
+  TemporalMemory tm({2048}, 32,
+      /* activationThreshold */          3,
+      /* initialPermanence */            0.21f,
+      /* connectedPermanence */          0.50f,
+      /* minThreshold */                 2);
+  Random rng(7);
+  vector<Segment> active, matching;
+  for(UInt i = 0; i < 500; i++) {
+    const CellIdx cell = rng.getUInt32(i % 2 ? 64u : static_cast<UInt32>(tm.numberOfCells())); //repeats on few cells
+    const Segment segment = tm.createSegment(cell);
+    const Permanence permanence = i % 3 ? 0.6f : 0.3f; //connected: active, else matching
+    for(CellIdx presyn = 0; presyn < 3; presyn++) tm.createSynapse(segment, presyn, permanence);
+    (i % 3 ? active : matching).push_back(segment);
+  }
+  const auto compareSegments = [&](const Segment a, const Segment b) { return tm.connections.compareSegments(a, b); };
+  std::stable_sort(active.begin(), active.end(), compareSegments);
+  std::stable_sort(matching.begin(), matching.end(), compareSegments);
+
+  SDR columns({2048});
+  columns.setSparse(SDR_sparse_t{0u}); //bursts: cells 0..31 active
+  tm.compute(columns, false);
+  tm.activateDendrites(false);
+  ASSERT_EQ(tm.getActiveSegments(), active);
+  vector<Segment> allMatching = active; //active are matching too
+  allMatching.insert(allMatching.end(), matching.begin(), matching.end());
+  std::stable_sort(allMatching.begin(), allMatching.end(), [&](const Segment a, const Segment b) {
+    return compareSegments(a, b) or (not compareSegments(b, a) and a < b); });
+  ASSERT_EQ(tm.getMatchingSegments(), allMatching);
+}
+
+TEST(TemporalMemoryTest, testParallelLearning) {
+  // Learning with several threads must give exactly the same model as with one.
+  const auto makeTM = []() {
+    return TemporalMemory({64},
+      /* cellsPerColumn */               4,
+      /* activationThreshold */          3,
+      /* initialPermanence */            0.41f,
+      /* connectedPermanence */          0.50f,
+      /* minThreshold */                 2,
+      /* maxNewSynapseCount */           6,
+      /* permanenceIncrement */          0.10f,
+      /* permanenceDecrement */          0.05f,
+      /* predictedSegmentDecrement */    0.02f,
+      /* seed */                         42,
+      /* maxSegmentsPerCell */           3,
+      /* maxSynapsesPerSegment */        10);
+  };
+  auto serial   = makeTM();
+  auto parallel = makeTM();
+  parallel.setNumThreads(3);
+
+  // a repeating sequence with noise, so that columns are predicted, bursting & punished
+  Random rng(7);
+  vector<SDR> sequence(8, SDR({64}));
+  for(auto &x : sequence) x.randomize(0.1f, rng);
+  SDR columns({64});
+  for(UInt step = 0; step < 400; step++) {
+    columns.setSDR(sequence[step % sequence.size()]);
+    columns.addNoise(0.1f, rng);
+    serial.compute(columns, true);
+    parallel.compute(columns, true);
+    ASSERT_EQ(serial.getActiveCells(), parallel.getActiveCells()) << "step " << step;
+    ASSERT_EQ(serial.getWinnerCells(), parallel.getWinnerCells()) << "step " << step;
+  }
+  ASSERT_GT(serial.connections.numSegments(), 0u);
+  ASSERT_TRUE(serial == parallel);
+}
+
+TEST(TemporalMemoryTest, testStreams) {
+  // Streams sharing one TM must behave like separate copies of that TM.
+  TemporalMemory model({64},
+      /* cellsPerColumn */               4,
+      /* activationThreshold */          3,
+      /* initialPermanence */            0.41f,
+      /* connectedPermanence */          0.50f,
+      /* minThreshold */                 2,
+      /* maxNewSynapseCount */           6);
+  Random rng(7);
+  vector<SDR> sequence(6, SDR({64}));
+  for(auto &x : sequence) x.randomize(0.1f, rng);
+  for(UInt step = 0; step < 60; step++) {
+    model.compute(sequence[step % sequence.size()], true);
+  }
+  ASSERT_GT(model.connections.numSegments(), 0u);
+
+  // copies via serialization, TM's copy constructor shares `anomaly` with the original
+  stringstream ss;
+  model.save(ss);
+  const string saved = ss.str();
+  TemporalMemory reference, copyA, copyB;
+  for(auto tm : {&reference, &copyA, &copyB}) {
+    stringstream in(saved);
+    tm->load(in);
+  }
+  copyA.reset();
+  copyB.reset();
+  TMStreamState streamA, streamB;
+  SDR columns({64});
+  for(UInt step = 0; step < 20; step++) {
+    columns.setSDR(sequence[step % sequence.size()]);
+    model.compute(streamA, columns);
+    copyA.compute(columns, false);
+    columns.setSDR(sequence[(step + 3) % sequence.size()]);
+    columns.addNoise(0.2f, rng);
+    model.compute(streamB, columns);
+    copyB.compute(columns, false);
+
+    ASSERT_EQ(streamA.getActiveCells(), copyA.getActiveCells()) << "step " << step;
+    ASSERT_EQ(streamA.getWinnerCells(), copyA.getWinnerCells()) << "step " << step;
+    ASSERT_EQ(streamA.getAnomaly(),     copyA.anomaly)          << "step " << step;
+    ASSERT_EQ(streamB.getActiveCells(), copyB.getActiveCells()) << "step " << step;
+    ASSERT_EQ(streamB.getAnomaly(),     copyB.anomaly)          << "step " << step;
+  }
+  EXPECT_EQ(streamA.getAnomaly(), 0.0f);
+  // learn=false leaves the shared connections and the TM's own state alone
+  EXPECT_EQ(model, reference);
+  EXPECT_EQ(model.getActiveCells(), reference.getActiveCells());
+
+  streamA.reset();
+  EXPECT_TRUE(streamA.getActiveCells().empty());
+
+  model.activateDendrites(false);
+  EXPECT_ANY_THROW(model.compute(streamA, columns));
+}
+
 TEST(TemporalMemoryTest, testEquals) {
   TemporalMemory tm({10,10});
   auto tmCopy = tm;
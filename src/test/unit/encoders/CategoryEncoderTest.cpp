@@ -0,0 +1,140 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Unit tests for the CategoryEncoder
+ */
+
+#include "gtest/gtest.h"
+#include <htm/encoders/CategoryEncoder.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace testing {
+
+using namespace htm;
+
+static CategoryEncoderParameters params() {
+  CategoryEncoderParameters p;
+  p.size       = 1000u;
+  p.activeBits = 25u;
+  p.seed       = 42u;
+  return p;
+}
+
+TEST(CategoryEncoder, testConstruct) {
+  CategoryEncoder encoder( params() );
+  ASSERT_EQ( encoder.size, 1000u );
+  ASSERT_NEAR( encoder.parameters.sparsity, 0.025f, 1e-6f );
+
+  auto p = params();
+  p.sparsity = 0.02f; // and activeBits
+  EXPECT_ANY_THROW( CategoryEncoder both( p ));
+  p = params();
+  p.activeBits = 1001u;
+  EXPECT_ANY_THROW( CategoryEncoder tooMany( p ));
+}
+
+TEST(CategoryEncoder, testEncode) {
+  CategoryEncoder encoder( params() );
+  SDR A( encoder.dimensions );
+  SDR B( encoder.dimensions );
+  SDR again( encoder.dimensions );
+  encoder.encode( "eu-west-1", A );
+  encoder.encode( "us-east-1", B );
+  encoder.encode( "eu-west-1", again );
+
+  // At most a few bits lost to hash collisions.
+  EXPECT_GT( A.getSum(), 20u );
+  EXPECT_LE( A.getSum(), 25u );
+  EXPECT_LT( A.getOverlap( B ), 5u );
+  EXPECT_EQ( A, again );
+
+  ASSERT_EQ( encoder.categories, std::vector<std::string>({ "eu-west-1", "us-east-1" }) );
+  EXPECT_EQ( encoder.getCategoryId( "eu-west-1" ), 0 );
+  EXPECT_EQ( encoder.getCategoryId( "us-east-1" ), 1 );
+  EXPECT_EQ( encoder.getCategoryId( "ap-south-1" ), -1 );
+
+  // The same category with another seed is encoded differently.
+  auto p = params();
+  p.seed = 43u;
+  CategoryEncoder other( p );
+  SDR C( other.dimensions );
+  other.encode( "eu-west-1", C );
+  EXPECT_LT( A.getOverlap( C ), 5u );
+}
+
+TEST(CategoryEncoder, testMaxCategories) {
+  auto p = params();
+  CategoryEncoder unlimited( p );
+  p.maxCategories = 2u;
+  CategoryEncoder limited( p );
+
+  SDR A( unlimited.dimensions );
+  SDR B( limited.dimensions );
+  for( UInt pass = 0; pass < 2; ++pass ) {
+    for( const std::string status : { "200", "404", "500", "503" } ) {
+      unlimited.encode( status, A );
+      limited.encode( status, B );
+      ASSERT_EQ( A, B ) << "at " << status;
+    }
+  }
+  EXPECT_EQ( unlimited.categories.size(), 4u );
+  EXPECT_EQ( limited.categories, std::vector<std::string>({ "200", "404" }) );
+}
+
+TEST(CategoryEncoder, testEncodeBatch) {
+  CategoryEncoder encoder( params() );
+  const std::vector<std::string> column = { "a", "b", "a", "c" };
+  std::vector<SDR> outputs( column.size(), SDR( encoder.dimensions ));
+  encoder.encodeBatch( column, outputs );
+
+  SDR expected( encoder.dimensions );
+  for( size_t i = 0; i < column.size(); ++i ) {
+    encoder.encode( column[i], expected );
+    ASSERT_EQ( outputs[i], expected ) << "at " << i;
+  }
+  EXPECT_EQ( outputs[0], outputs[2] );
+
+  std::vector<SDR> tooFew( 2u, SDR( encoder.dimensions ));
+  EXPECT_ANY_THROW( encoder.encodeBatch( column, tooFew ));
+}
+
+TEST(CategoryEncoder, testSerialize) {
+  auto p = params();
+  p.seed = 0u;
+  CategoryEncoder encoder1( p );
+  SDR A( encoder1.dimensions );
+  encoder1.encode( "bravo", A );
+  encoder1.encode( "alpha", A );
+  std::stringstream buf;
+  encoder1.save( buf );
+
+  CategoryEncoder encoder2;
+  encoder2.load( buf );
+  ASSERT_EQ( encoder2.parameters.seed, encoder1.parameters.seed );
+  ASSERT_EQ( encoder2.categories, encoder1.categories );
+
+  SDR B( encoder2.dimensions );
+  encoder1.encode( "charlie", A );
+  encoder2.encode( "charlie", B );
+  ASSERT_EQ( A, B );
+  EXPECT_EQ( encoder2.getCategoryId( "charlie" ), 2 );
+}
+
+} // end namespace testing
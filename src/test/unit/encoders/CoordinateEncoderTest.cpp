@@ -0,0 +1,114 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Unit tests for the CoordinateEncoder
+ */
+
+#include "gtest/gtest.h"
+#include <htm/encoders/CoordinateEncoder.hpp>
+#include <sstream>
+#include <vector>
+
+namespace testing {
+
+using namespace htm;
+
+static CoordinateEncoderParameters params2D() {
+  CoordinateEncoderParameters p;
+  p.size          = 1000u;
+  p.activeBits    = 25u;
+  p.numDimensions = 2u;
+  p.radius        = 5u;
+  p.seed          = 42u;
+  return p;
+}
+
+TEST(CoordinateEncoder, testConstruct) {
+  CoordinateEncoder encoder( params2D() );
+  ASSERT_EQ( encoder.size, 1000u );
+  ASSERT_NEAR( encoder.parameters.sparsity, 0.025f, 1e-6f );
+
+  auto p = params2D();
+  p.radius = 2u; // 5x5 = 25 points, just enough
+  CoordinateEncoder justEnough( p );
+  p.radius = 1u; // 3x3 = 9 points
+  EXPECT_ANY_THROW( CoordinateEncoder tooSmall( p ));
+  p = params2D();
+  p.sparsity = 0.02f; // and activeBits
+  EXPECT_ANY_THROW( CoordinateEncoder both( p ));
+
+  SDR output( encoder.dimensions );
+  EXPECT_ANY_THROW( encoder.encode({ 1, 2, 3 }, output ));
+}
+
+TEST(CoordinateEncoder, testSimilarity) {
+  CoordinateEncoder encoder( params2D() );
+  SDR center( encoder.dimensions );
+  SDR near( encoder.dimensions );
+  SDR far( encoder.dimensions );
+  encoder.encode({ 100, -300 }, center );
+  encoder.encode({ 101, -300 }, near );
+  encoder.encode({ 120, -300 }, far );
+
+  // At most a few bits lost to hash collisions.
+  EXPECT_GT( center.getSum(), 20u );
+  EXPECT_LE( center.getSum(), 25u );
+  EXPECT_GT( center.getOverlap( near ), 12u );
+  EXPECT_LT( center.getOverlap( far ), 5u );
+
+  SDR again( encoder.dimensions );
+  encoder.encode({ 100, -300 }, again );
+  EXPECT_EQ( center, again );
+}
+
+TEST(CoordinateEncoder, testCache) {
+  auto p = params2D();
+  CoordinateEncoder plain( p );
+  p.cacheSize = 200u; // holds one neighborhood (121 points), but not a whole track
+  CoordinateEncoder cached( p );
+
+  SDR A( plain.dimensions );
+  SDR B( cached.dimensions );
+  for( UInt pass = 0; pass < 2; ++pass ) {
+    for( Int64 x = -20; x < 20; x += 3 ) {
+      plain.encode({ x, x / 2 }, A );
+      cached.encode({ x, x / 2 }, B );
+      ASSERT_EQ( A, B ) << "at " << x;
+    }
+  }
+}
+
+TEST(CoordinateEncoder, testSerialize) {
+  auto p = params2D();
+  p.seed = 0u;
+  CoordinateEncoder encoder1( p );
+  std::stringstream buf;
+  encoder1.save( buf );
+
+  CoordinateEncoder encoder2;
+  encoder2.load( buf );
+  ASSERT_EQ( encoder2.parameters.seed, encoder1.parameters.seed );
+
+  SDR A( encoder1.dimensions );
+  SDR B( encoder2.dimensions );
+  encoder1.encode({ 7, 11 }, A );
+  encoder2.encode({ 7, 11 }, B );
+  ASSERT_EQ( A, B );
+}
+
+} // end namespace testing
@@ -249,6 +249,36 @@ TEST(DateEncoderTest, combined) {
 }
 
 
+TEST(DateEncoderTest, reusedFieldsMatchFreshEncoder) {
+  DateEncoderParameters p;
+  p.verbose = verbose;
+  p.season_width = 5;
+  p.dayOfWeek_width = 2;
+  p.weekend_width = 2;
+  p.custom_width = 2;
+  p.custom_days = {"Mon, Wed, Fri"};
+  p.holiday_width = 2;
+  p.holiday_dates = {{2020, 1, 1}, {7, 4}, {2019, 12, 25}};
+  p.timeOfDay_width = 4;
+  p.timeOfDay_radius = 4;
+  DateEncoder encoder(p);
+
+  // Steps of 1 second up to several hours, crossing days, holidays and years.
+  time_t t = DateEncoder::mktime(2019, 12, 23, 22, 0);
+  const time_t steps[] = {1, 1, 59, 3600, 7201, 86399, 1, 43200};
+  SDR actual(encoder.dimensions);
+  for (int i = 0; i < 48; i++) {
+    t += steps[i % 8];
+    encoder.encode(t, actual);
+    DateEncoder fresh(p);
+    SDR expected(fresh.dimensions);
+    fresh.encode(t, expected);
+    ASSERT_EQ(actual, expected) << "at " << t;
+    ASSERT_EQ(encoder.buckets, fresh.buckets) << "at " << t;
+  }
+}
+
+
 TEST(DateEncoderTest, Serialization) {
   DateEncoderParameters p;
   p.verbose = verbose;
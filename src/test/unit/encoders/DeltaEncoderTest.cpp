@@ -0,0 +1,135 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Unit tests for the DeltaEncoder
+ */
+
+#include "gtest/gtest.h"
+#include <htm/encoders/DeltaEncoder.hpp>
+#include <htm/encoders/RandomDistributedScalarEncoder.hpp>
+#include <sstream>
+#include <vector>
+
+namespace testing {
+
+using namespace htm;
+
+static std::shared_ptr<RDSE> makeRDSE() {
+  RDSE_Parameters p;
+  p.size       = 400u;
+  p.activeBits = 21u;
+  p.resolution = 0.5f;
+  p.seed       = 42u;
+  return std::make_shared<RDSE>( p );
+}
+
+TEST(DeltaEncoder, testDifference) {
+  auto rdse = makeRDSE();
+  DeltaEncoder encoder( rdse );
+  ASSERT_EQ( encoder.dimensions, rdse->dimensions );
+
+  SDR output( encoder.dimensions );
+  SDR expected( encoder.dimensions );
+  encoder.encode( 10.0, output );
+  EXPECT_EQ( output.getSum(), 0u );
+  EXPECT_TRUE( std::isnan( encoder.getDelta() ));
+
+  encoder.encode( 12.5, output );
+  rdse->encode( 2.5, expected );
+  EXPECT_EQ( output, expected );
+  EXPECT_EQ( encoder.getDelta(), 2.5 );
+
+  encoder.encode( 7.5, output );
+  rdse->encode( -5.0, expected );
+  EXPECT_EQ( output, expected );
+
+  // After a reset the next value is the first one again.
+  encoder.reset();
+  encoder.encode( 100.0, output );
+  EXPECT_EQ( output.getSum(), 0u );
+}
+
+TEST(DeltaEncoder, testRate) {
+  auto rdse = makeRDSE();
+  DeltaEncoderParameters p;
+  p.rate = true;
+  DeltaEncoder encoder( rdse, p );
+
+  SDR output( encoder.dimensions );
+  SDR expected( encoder.dimensions );
+  encoder.encode( 10.0, 100.0, output );
+  encoder.encode( 20.0, 104.0, output );
+  EXPECT_EQ( encoder.getDelta(), 2.5 );
+  rdse->encode( 2.5, expected );
+  EXPECT_EQ( output, expected );
+
+  // Without a time, inputs are one time unit apart.
+  encoder.encode( 23.0, output );
+  EXPECT_EQ( encoder.getDelta(), 3.0 );
+
+  EXPECT_ANY_THROW( encoder.encode( 30.0, 105.0, output )); // time 105 is not after 105
+}
+
+TEST(DeltaEncoder, testEncodeBatch) {
+  DeltaEncoderParameters p;
+  p.rate = true;
+  DeltaEncoder batch( makeRDSE(), p );
+  DeltaEncoder single( makeRDSE(), p );
+
+  const std::vector<Real64> values = { 1.0, 2.0, 4.0, 3.0 };
+  const std::vector<Real64> times  = { 0.0, 1.0, 3.0, 4.0 };
+  std::vector<SDR> outputs( values.size(), SDR( batch.dimensions ));
+  batch.encodeBatch( values, times, outputs );
+
+  SDR expected( single.dimensions );
+  for( size_t i = 0; i < values.size(); ++i ) {
+    single.encode( values[i], times[i], expected );
+    ASSERT_EQ( outputs[i], expected ) << "at " << i;
+  }
+
+  // The batch continues from the last value of the previous batch.
+  std::vector<SDR> next( 1u, SDR( batch.dimensions ));
+  batch.encodeBatch({ 5.0 }, next );
+  single.encode( 5.0, expected );
+  EXPECT_EQ( next[0], expected );
+
+  EXPECT_ANY_THROW( batch.encodeBatch( values, { 5.0 }, outputs ));
+}
+
+TEST(DeltaEncoder, testSerialize) {
+  auto rdse = makeRDSE();
+  DeltaEncoder encoder1( rdse );
+  SDR A( encoder1.dimensions );
+  encoder1.encode( 10.0, A );
+  std::stringstream buf;
+  encoder1.save( buf );
+
+  DeltaEncoder unwrapped;
+  std::stringstream copy( buf.str() );
+  EXPECT_ANY_THROW( unwrapped.load( copy ));
+
+  DeltaEncoder encoder2( makeRDSE() );
+  encoder2.load( buf );
+  SDR B( encoder2.dimensions );
+  encoder1.encode( 13.0, A );
+  encoder2.encode( 13.0, B );
+  EXPECT_EQ( A, B );
+  EXPECT_EQ( encoder2.getDelta(), 3.0 );
+}
+
+} // end namespace testing
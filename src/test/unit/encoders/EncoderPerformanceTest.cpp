@@ -0,0 +1,256 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+#include "gtest/gtest.h"
+
+/** @file
+ * Micro-benchmarks for the encoders.
+ *
+ * Every test encodes a stream of inputs and reports the throughput, both to
+ * stdout and as one line appended to the CSV file ENCODER_RESULTS in the
+ * working directory, for tracking the trend of the encoders' performance:
+ *    timestamp,encoder,unit,count,seconds,per_second
+ * where unit is what one encoding is: a "value", "record" or "document".
+ */
+
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <htm/encoders/CategoryEncoder.hpp>
+#include <htm/encoders/CoordinateEncoder.hpp>
+#include <htm/encoders/DateEncoder.hpp>
+#include <htm/encoders/MultiEncoder.hpp>
+#include <htm/encoders/RandomDistributedScalarEncoder.hpp>
+#include <htm/encoders/ScalarEncoder.hpp>
+#include <htm/encoders/SimHashDocumentEncoder.hpp>
+#include <htm/os/Path.hpp>
+#include <htm/os/Timer.hpp>
+#include <htm/types/Types.hpp> // macro "UNUSED"
+
+namespace testing {
+
+using namespace std;
+using namespace htm;
+
+#if defined( NDEBUG) && !defined(NTA_OS_WINDOWS)
+  const UInt ENCODINGS = 1000000u;
+#else
+  const UInt ENCODINGS = 10000u;
+#endif
+
+const string ENCODER_RESULTS = "EncoderPerformance.csv";
+
+/**
+ * Appends one result line to ENCODER_RESULTS, writing the header first if the
+ * file is new.
+ */
+void writeEncoderResult(const string &label, const string &unit, UInt count, float seconds) {
+  const bool isNew = not Path::exists( ENCODER_RESULTS );
+  ofstream f( ENCODER_RESULTS, ios::app );
+  if( isNew ) {
+    f << "timestamp,encoder,unit,count,seconds,per_second" << endl;
+  }
+  f << std::time(nullptr) << "," << label << "," << unit << "," << count << ","
+    << seconds << "," << (seconds > 0.0f ? count / seconds : 0.0f) << endl;
+}
+
+/**
+ * Encodes count inputs input(0) ... input(count - 1) and reports the elapsed
+ * seconds.  The inputs are generated before the timer starts.  The output SDR
+ * is read back as dense every step, as a region would do, so that the
+ * encoder can not rely on the sparse buffer staying valid between calls.
+ */
+template<typename Encoder, typename Input>
+float runEncoderTest(Encoder &enc, UInt count, function<Input(UInt)> input,
+                     const string &label, const string &unit = "value") {
+  vector<Input> inputs;
+  inputs.reserve( count );
+  for(UInt i = 0; i < count; i++) {
+    inputs.push_back( input(i) );
+  }
+  SDR output( enc.dimensions );
+  UInt checksum = 0u;
+
+  Timer timer(true);
+  for(UInt i = 0; i < count; i++) {
+    enc.encode( inputs[i], output );
+    checksum += output.getDense()[i % output.size];
+  }
+  timer.stop();
+  const auto tim = (float)timer.getElapsed();
+
+  cout << tim << " in " << label << ": " << count << " encodings, "
+       << (tim > 0.0f ? count / tim : 0.0f) << " " << unit << "s/sec"
+       << " (checksum " << checksum << ")" << endl;
+  writeEncoderResult( label, unit, count, tim );
+  return tim;
+}
+
+TEST(EncoderPerformanceTest, testScalarEncoder) {
+  ScalarEncoderParameters p;
+  p.minimum    = 0.0;
+  p.maximum    = 100.0;
+  p.size       = 2048u;
+  p.activeBits = 41u;
+  ScalarEncoder enc( p );
+
+  auto tim = runEncoderTest<ScalarEncoder, Real64>(enc, ENCODINGS,
+    [](UInt i) { return 100.0 * i / ENCODINGS; }, "scalar encoder");
+#ifdef NDEBUG
+  ASSERT_LE(tim, 1.0f*Timer::getSpeed());
+#endif
+  UNUSED(tim);
+}
+
+TEST(EncoderPerformanceTest, testScalarEncoderPeriodic) {
+  ScalarEncoderParameters p;
+  p.minimum    = 0.0;
+  p.maximum    = 100.0;
+  p.size       = 2048u;
+  p.activeBits = 41u;
+  p.periodic   = true;
+  ScalarEncoder enc( p );
+
+  // Stay below the maximum, which is excluded from the periodic input range.
+  auto tim = runEncoderTest<ScalarEncoder, Real64>(enc, ENCODINGS,
+    [](UInt i) { return 99.0 * i / ENCODINGS; }, "scalar encoder (periodic)");
+#ifdef NDEBUG
+  ASSERT_LE(tim, 1.0f*Timer::getSpeed());
+#endif
+  UNUSED(tim);
+}
+
+TEST(EncoderPerformanceTest, testRDSE) {
+  RDSE_Parameters p;
+  p.size       = 2048u;
+  p.activeBits = 41u;
+  p.resolution = 0.1f;
+  p.seed       = 42u;
+  RDSE enc( p );
+
+  auto tim = runEncoderTest<RDSE, Real64>(enc, ENCODINGS,
+    [](UInt i) { return 100.0 * i / ENCODINGS; }, "random distributed scalar encoder");
+#ifdef NDEBUG
+  ASSERT_LE(tim, 3.0f*Timer::getSpeed());
+#endif
+  UNUSED(tim);
+}
+
+TEST(EncoderPerformanceTest, testDateEncoder) {
+  DateEncoderParameters p;
+  p.season_width    = 5u;
+  p.dayOfWeek_width = 5u;
+  p.weekend_width   = 5u;
+  p.holiday_width   = 5u;
+  p.timeOfDay_width = 5u;
+  DateEncoder enc( p );
+
+  // One sample every 15 minutes, starting at 2020-01-01.
+  const auto count = ENCODINGS / 10u;
+  auto tim = runEncoderTest<DateEncoder, time_t>(enc, count,
+    [](UInt i) { return (time_t)(1577836800 + 900 * (int64_t)i); }, "date encoder");
+#ifdef NDEBUG
+  ASSERT_LE(tim, 2.0f*Timer::getSpeed());
+#endif
+  UNUSED(tim);
+}
+
+TEST(EncoderPerformanceTest, testSimHashDocumentEncoder) {
+  SimHashDocumentEncoderParameters p;
+  p.size       = 400u;
+  p.activeBits = 21u;
+  SimHashDocumentEncoder enc( p );
+
+  // Documents of 10 tokens, drawn from a vocabulary of 1000 words.
+  const auto count = ENCODINGS / 100u;
+  auto tim = runEncoderTest<SimHashDocumentEncoder, vector<string>>(enc, count,
+    [](UInt i) {
+      vector<string> document;
+      for(UInt t = 0; t < 10u; t++) {
+        document.push_back( "word" + to_string((i * 7u + t * 131u) % 1000u) );
+      }
+      return document;
+    }, "simhash document encoder", "document");
+#ifdef NDEBUG
+  ASSERT_LE(tim, 2.0f*Timer::getSpeed());
+#endif
+  UNUSED(tim);
+}
+
+TEST(EncoderPerformanceTest, testCategoryEncoder) {
+  CategoryEncoderParameters p;
+  p.size       = 2048u;
+  p.activeBits = 41u;
+  p.seed       = 42u;
+  CategoryEncoder enc( p );
+
+  // A column of 100 distinct host names.
+  auto tim = runEncoderTest<CategoryEncoder, string>(enc, ENCODINGS,
+    [](UInt i) { return "host-" + to_string(i % 100u); }, "category encoder");
+#ifdef NDEBUG
+  ASSERT_LE(tim, 1.0f*Timer::getSpeed());
+#endif
+  UNUSED(tim);
+}
+
+TEST(EncoderPerformanceTest, testCoordinateEncoder) {
+  CoordinateEncoderParameters p;
+  p.size          = 2048u;
+  p.activeBits    = 41u;
+  p.numDimensions = 2u;
+  p.radius        = 5u;
+  p.seed          = 42u;
+  CoordinateEncoder enc( p );
+
+  // A walk along a diagonal line.
+  const auto count = ENCODINGS / 100u;
+  auto tim = runEncoderTest<CoordinateEncoder, vector<Int64>>(enc, count,
+    [](UInt i) { return vector<Int64>{ (Int64)i, (Int64)(i / 2u) }; },
+    "coordinate encoder");
+#ifdef NDEBUG
+  ASSERT_LE(tim, 2.0f*Timer::getSpeed());
+#endif
+  UNUSED(tim);
+}
+
+TEST(EncoderPerformanceTest, testMultiEncoder) {
+  ScalarEncoderParameters sp;
+  sp.minimum    = 0.0;
+  sp.maximum    = 100.0;
+  sp.size       = 1000u;
+  sp.activeBits = 21u;
+  RDSE_Parameters rp;
+  rp.size       = 1000u;
+  rp.activeBits = 21u;
+  rp.resolution = 0.1f;
+  rp.seed       = 42u;
+  MultiEncoder enc({ make_shared<ScalarEncoder>( sp ), make_shared<RDSE>( rp ) });
+
+  auto tim = runEncoderTest<MultiEncoder, vector<Real64>>(enc, ENCODINGS / 10u,
+    [](UInt i) { return vector<Real64>{ 100.0 * i / ENCODINGS, 0.5 * i }; },
+    "multi encoder", "record");
+#ifdef NDEBUG
+  ASSERT_LE(tim, 1.0f*Timer::getSpeed());
+#endif
+  UNUSED(tim);
+}
+
+} // end namespace
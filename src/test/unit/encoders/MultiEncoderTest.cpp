@@ -0,0 +1,116 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Unit tests for the MultiEncoder
+ */
+
+#include "gtest/gtest.h"
+#include <htm/encoders/MultiEncoder.hpp>
+#include <sstream>
+#include <vector>
+
+namespace testing {
+
+using namespace htm;
+
+static std::vector<std::shared_ptr<BaseEncoder<Real64>>> makeFields() {
+  ScalarEncoderParameters scalar;
+  scalar.minimum    = 0.0;
+  scalar.maximum    = 100.0;
+  scalar.activeBits = 5;
+  scalar.size       = 50;
+  RDSE_Parameters rdse;
+  rdse.size       = 200;
+  rdse.activeBits = 10;
+  rdse.resolution = 0.5f;
+  rdse.seed       = 7;
+  auto rdse2 = rdse;
+  rdse2.seed = 8;
+  return { std::make_shared<ScalarEncoder>( scalar ),
+           std::make_shared<RandomDistributedScalarEncoder>( rdse ),
+           std::make_shared<RandomDistributedScalarEncoder>( rdse2 ) };
+}
+
+// The output is the concatenation of the sub-encodings.
+static SDR concatenated(const std::vector<std::shared_ptr<BaseEncoder<Real64>>> &fields,
+                        const std::vector<Real64> &record) {
+  std::vector<SDR> outputs;
+  for( size_t i = 0; i < fields.size(); ++i ) {
+    outputs.emplace_back( fields[i]->dimensions );
+    fields[i]->encode( record[i], outputs.back() );
+  }
+  std::vector<const SDR*> inputs;
+  for( const auto &sdr : outputs ) inputs.push_back( &sdr );
+  SDR result({ 450u });
+  result.concatenate( inputs );
+  return result;
+}
+
+TEST(MultiEncoder, EncodeMatchesConcatenate) {
+  const auto fields = makeFields();
+  MultiEncoder encoder( fields );
+  ASSERT_EQ( encoder.size, 450u );
+  ASSERT_EQ( encoder.numFields(), 3u );
+  ASSERT_EQ( encoder.offsets, std::vector<UInt>({ 0u, 50u, 250u }));
+
+  const std::vector<std::vector<Real64>> records = {
+    { 0.0, 0.0, 0.0 }, { 33.3, -12.0, 1e4 }, { 100.0, 7.25, 7.25 }};
+  SDR output( encoder.dimensions );
+  for( const auto &record : records ) {
+    encoder.encode( record, output );
+    EXPECT_EQ( output, concatenated( fields, record ));
+  }
+
+  EXPECT_ANY_THROW( encoder.encode({ 1.0, 2.0 }, output ));
+  SDR wrongSize({ 449u });
+  EXPECT_ANY_THROW( encoder.encode({ 1.0, 2.0, 3.0 }, wrongSize ));
+}
+
+TEST(MultiEncoder, Threads) {
+  MultiEncoder serial( makeFields() );
+  MultiEncoder threaded( makeFields() );
+  threaded.setNumThreads( 3u );
+  ASSERT_EQ( threaded.getNumThreads(), 3u );
+
+  SDR A( serial.dimensions );
+  SDR B( threaded.dimensions );
+  for( Real64 x = 0.0; x < 100.0; x += 3.7 ) {
+    serial.encode({ x, x * 2.0, -x }, A );
+    threaded.encode({ x, x * 2.0, -x }, B );
+    ASSERT_EQ( A, B );
+  }
+}
+
+TEST(MultiEncoder, Serialization) {
+  MultiEncoder encoder1( makeFields() );
+  std::stringstream buf;
+  encoder1.save( buf );
+
+  MultiEncoder encoder2;
+  encoder2.load( buf );
+  ASSERT_EQ( encoder2.dimensions, encoder1.dimensions );
+  ASSERT_EQ( encoder2.offsets, encoder1.offsets );
+
+  SDR A( encoder1.dimensions );
+  SDR B( encoder2.dimensions );
+  encoder1.encode({ 42.0, 4.2, 0.42 }, A );
+  encoder2.encode({ 42.0, 4.2, 0.42 }, B );
+  ASSERT_EQ( A, B );
+}
+
+} // end namespace testing
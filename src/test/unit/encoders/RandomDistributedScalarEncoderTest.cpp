@@ -57,3 +57,45 @@ TEST(RDSE, testSerialize) {
 
   ASSERT_EQ( A, B );
 }
+
+TEST(RDSE, testEncodeBatch) {
+  RDSE_Parameters P;
+  P.size       = 1000;
+  P.sparsity   = 0.05f;
+  P.resolution = 1.23f;
+  P.seed       = 42u;
+  RDSE R( P );
+
+  const std::vector<Real64> inputs = { 0.0, 44.4, -12.0, 1e6, 44.4 };
+  std::vector<SDR> outputs( inputs.size(), SDR( R.dimensions ));
+  R.encodeBatch( inputs, outputs );
+  for( size_t i = 0; i < inputs.size(); ++i ) {
+    SDR expected( R.dimensions );
+    R.encode( inputs[i], expected );
+    EXPECT_EQ( outputs[i], expected );
+    // Hash collisions may drop a few bits, but not many.
+    EXPECT_GT( outputs[i].getSum(), 45u );
+  }
+  ASSERT_EQ( outputs[1], outputs[4] );
+}
+
+TEST(RDSE, testBucketCache) {
+  RDSE_Parameters P;
+  P.size       = 1000;
+  P.sparsity   = 0.05f;
+  P.resolution = 1.0f;
+  P.seed       = 42u;
+  RDSE plain( P );
+  P.cacheSize  = 8u; // smaller than the number of buckets below
+  RDSE cached( P );
+
+  SDR A( plain.dimensions );
+  SDR B( cached.dimensions );
+  for( UInt pass = 0; pass < 2; ++pass ) {
+    for( Real64 x = 0.0; x < 20.0; x += 0.5 ) {
+      plain.encode( x, A );
+      cached.encode( x, B );
+      ASSERT_EQ( A, B ) << "Input " << x;
+    }
+  }
+}
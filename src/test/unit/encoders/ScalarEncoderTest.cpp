@@ -166,6 +166,28 @@ TEST(ScalarEncoder, PeriodicRoundNearestMultipleOfResolution) {
   doScalarValueCases(encoder, cases);
 }
 
+TEST(ScalarEncoder, EncodeBatch) {
+  ScalarEncoderParameters p;
+  p.activeBits = 3;
+  p.minimum    = 10.0;
+  p.maximum    = 20.0;
+  p.resolution = 1;
+  p.periodic   = true;
+  ScalarEncoder encoder( p );
+
+  const std::vector<Real64> inputs = { 10.0, 14.5, 19.49, 20.0, 11.2 };
+  std::vector<SDR> outputs( inputs.size(), SDR( encoder.dimensions ));
+  encoder.encodeBatch( inputs, outputs );
+  for( size_t i = 0; i < inputs.size(); ++i ) {
+    SDR expected( encoder.dimensions );
+    encoder.encode( inputs[i], expected );
+    EXPECT_EQ( outputs[i], expected );
+  }
+
+  std::vector<SDR> tooFew( 2u, SDR( encoder.dimensions ));
+  EXPECT_ANY_THROW( encoder.encodeBatch( inputs, tooFew ));
+}
+
 TEST(ScalarEncoder, Serialization) {
   std::vector<ScalarEncoder*> inputs;
   ScalarEncoderParameters p;
@@ -448,4 +448,83 @@ namespace testing {
     ASSERT_LT(output1.getOverlap(output2), 65u);
   }
 
+  // The token digest cache must not change the output, including when it is
+  // too small for the documents and keeps evicting.
+  TEST(SimHashDocumentEncoder, testTokenCache) {
+    const std::vector<std::vector<std::string>> docs = {
+      { "alpha", "bravo", "charlie" },
+      { "bravo", "delta", "echo", "bravo" },
+      { "charlie", "alpha", "foxtrot", "golf" },
+      { "alpha", "bravo", "charlie" }};
+
+    SimHashDocumentEncoderParameters params;
+    params.size = 401u;
+    params.activeBits = 21u;
+    params.tokenSimilarity = true;
+    params.tokenCacheSize = 0u;
+    SimHashDocumentEncoder uncached(params);
+    params.tokenCacheSize = 3u;
+    SimHashDocumentEncoder small(params);
+    params.tokenCacheSize = 1024u;
+    SimHashDocumentEncoder cached(params);
+
+    SDR expected({ params.size });
+    SDR output({ params.size });
+    for (UInt pass = 0u; pass < 2u; pass++) {
+      for (const auto &doc : docs) {
+        uncached.encode(doc, expected);
+        small.encode(doc, output);
+        ASSERT_EQ(expected, output);
+        cached.encode(doc, output);
+        ASSERT_EQ(expected, output);
+      }
+    }
+  }
+
+  // A parallel batch gives the outputs of encode(), in order, with a token
+  // cache which holds some of the tokens and with none.
+  TEST(SimHashDocumentEncoder, testEncodeBatch) {
+    std::vector<std::vector<std::string>> docs;
+    const std::vector<std::string> words = {
+      "alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel" };
+    for (UInt doc = 0u; doc < 50u; doc++) {
+      std::vector<std::string> tokens;
+      for (UInt token = 0u; token <= doc % 5u; token++) {
+        tokens.push_back(words[(doc * 3u + token * 5u) % words.size()]);
+      }
+      docs.push_back(tokens);
+    }
+    docs.push_back({});
+
+    for (const UInt cacheSize : { 0u, 3u }) {
+      SimHashDocumentEncoderParameters params;
+      params.size = 401u;
+      params.activeBits = 21u;
+      params.tokenSimilarity = true;
+      params.tokenCacheSize = cacheSize;
+      SimHashDocumentEncoder serial(params);
+      SimHashDocumentEncoder parallel(params);
+      parallel.setNumThreads(4u);
+      ASSERT_EQ(parallel.getNumThreads(), 4u);
+
+      std::vector<SDR> expected(docs.size(), SDR({ params.size }));
+      std::vector<SDR> outputs(docs.size(), SDR({ params.size }));
+      for (size_t i = 0u; i < docs.size(); i++) {
+        serial.encode(docs[i], expected[i]);
+      }
+      parallel.encode(docs[0], outputs[0]); // fill the cache
+      parallel.encodeBatch(docs, outputs);
+      for (size_t i = 0u; i < docs.size(); i++) {
+        ASSERT_EQ(expected[i], outputs[i]) << "document " << i;
+      }
+
+      parallel.setNumThreads(1u);
+      ASSERT_EQ(parallel.getNumThreads(), 1u);
+      parallel.encodeBatch(docs, outputs);
+      for (size_t i = 0u; i < docs.size(); i++) {
+        ASSERT_EQ(expected[i], outputs[i]) << "document " << i;
+      }
+    }
+  }
+
 } // end namespace testing
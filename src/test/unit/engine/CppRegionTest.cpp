@@ -105,6 +105,43 @@ TEST(CppRegionTest, testCppLinkingFanIn) {
   }
 }
 
+TEST(CppRegionTest, testCppLinkingFanInSharedBuffer) {
+  Network net;
+  std::shared_ptr<Region> region1 = net.addRegion("region1", "TestNode", "dim: [64]");
+  std::shared_ptr<Region> region2 = net.addRegion("region2", "TestNode", "dim: [64]");
+  std::shared_ptr<Region> region3 = net.addRegion("region3", "TestNode", "");
+
+  net.link("region1", "region3");
+  net.link("region2", "region3");
+  net.initialize();
+
+  // Both sources write into their slice of the Fan-In buffer, no copy.
+  const Array r1OutputArray = region1->getOutputData("bottomUpOut");
+  const Array r2OutputArray = region2->getOutputData("bottomUpOut");
+  const Array r3InputArray  = region3->getInputData("bottomUpIn");
+  const Real64 *buffer3 = (const Real64 *)r3InputArray.getBuffer();
+  EXPECT_EQ(r1OutputArray.getBuffer(), buffer3);
+  EXPECT_EQ(r2OutputArray.getBuffer(), buffer3 + 64);
+
+  region1->compute();
+  region2->compute();
+  region3->prepareInputs();
+  EXPECT_EQ(region3->getInputData("bottomUpIn").getBuffer(), buffer3);
+  for (size_t i = 1; i < 64; i++) {
+    ASSERT_EQ(buffer3[i], (Real64)(i - 1));
+    ASSERT_EQ(buffer3[i + 64], (Real64)(i - 1));
+  }
+
+  // A snapshot gives the sources their own buffers again, the data stays.
+  region3->prepareInputs(true);
+  const Array r1Own = region1->getOutputData("bottomUpOut");
+  EXPECT_NE(r1Own.getBuffer(), buffer3);
+  EXPECT_EQ(r1Own, r1OutputArray);
+  region1->compute();
+  region3->prepareInputs();
+  EXPECT_EQ(buffer3[0], ((const Real64 *)region1->getOutputData("bottomUpOut").getBuffer())[0]);
+}
+
 
 TEST(CppRegionTest, testCppLinkingSDR) {
   Network net;
@@ -298,4 +335,23 @@ TEST(CppRegionTest, ValidateParameters) {
   
 }
 
+TEST(CppRegionTest, ArrayParameterJSON) {
+  Network n;
+  std::shared_ptr<Region> r1 = n.addRegion("testnode", "TestNode", "{dim: [2]}");
+
+  r1->setParameterJSON("int64ArrayParam", "[1, -2, 3000000000]");
+  EXPECT_EQ(r1->getParameterJSON("int64ArrayParam"), "[1, -2, 3000000000]");
+  r1->setParameterJSON("real32ArrayParam", "{\"data\": [0.1, 2.5e-3]}");
+  EXPECT_EQ(r1->getParameterJSON("real32ArrayParam"), "[0.1, 0.0025]");
+
+  // withType is a JSON object.
+  Value vm;
+  vm.parse(r1->getParameterJSON("int64ArrayParam", true));
+  EXPECT_EQ(vm["type"].str(), "Int64");
+  EXPECT_EQ(vm["dim"][0].as<UInt>(), 3u);
+  EXPECT_EQ(vm["value"][2].as<Int64>(), 3000000000);
+
+  EXPECT_ANY_THROW(r1->setParameterJSON("int64ArrayParam", "[1, 2"));
+}
+
 } // namespace testing
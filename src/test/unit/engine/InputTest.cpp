@@ -446,4 +446,35 @@ TEST(InputTest, LinkFromAppSDRFanIn) {
 }
 
 
+TEST(InputTest, LinkFromAppSDRFanInDelayed) {
+  Network net;
+  VERBOSE << "With two SDR Inputs from an App Fan-In to one input, one of them delayed.\n";
+  // The SDR links pass sparse indices, a delayed one from its delay queue.
+  const std::vector<std::vector<UInt>> testdata1 = {{0, 1, 2, 3}, {4, 5, 6, 7}, {8, 9, 10, 11}};
+  const std::vector<std::vector<UInt>> testdata2 = {{10, 25, 26, 75}, {11, 26, 27, 31}, {5, 10, 15, 80}};
+  std::shared_ptr<Region> region1 = net.addRegion("region1", "SPRegion", "{dim: [1000]}");
+
+  net.link("INPUT", "region1", "", "{dim: 20}",  "app_source1", "bottomUpIn");
+  net.link("INPUT", "region1", "", "{dim: 100}", "app_source2", "bottomUpIn", 1); // one step behind
+  net.initialize();
+
+  SDR previous2({100});
+  for (size_t i = 0; i < 3; i++) {
+    SDR data1({20});
+    data1.setSparse(testdata1[i]);
+    net.setInputData("app_source1", Array(data1));
+    SDR data2({100});
+    data2.setSparse(testdata2[i]);
+    net.setInputData("app_source2", Array(data2));
+
+    net.run(1);
+
+    SDR expectedData({120});
+    expectedData.concatenate(data1, previous2);
+    EXPECT_EQ(expectedData.getSparse(), region1->getInputData("bottomUpIn").getSDR().getSparse()) << "Iteration " << i;
+    previous2 = data2;
+  }
+}
+
+
 } // namespace
\ No newline at end of file
@@ -21,6 +21,7 @@
 
 #include <sstream>
 #include <iostream>
+#include <set>
 
 #include "gtest/gtest.h"
 #include <htm/engine/Input.hpp>
@@ -176,6 +177,13 @@ TEST(LinkTest, DelayedLink) {
       idata[i] = 1.0;
   }
 
+  // The delay slots are allocated once, then rotated in place.
+  std::set<const void *> slots;
+  const std::shared_ptr<Link> link = net.getLinks()[0];
+  for (const auto &slot : link->getDelayBuffer())
+    slots.insert(slot.getBuffer());
+  ASSERT_EQ(slots.size(), 2u);
+
   // set out1 to all 10's
   {
     const Array& ao1 = out1->getData();
@@ -237,6 +245,8 @@ TEST(LinkTest, DelayedLink) {
     for (UInt i = 0; i < 4; i++)
       ASSERT_EQ(100.0, idata[i]);
   }
+  for (const auto &slot : link->getDelayBuffer())
+    EXPECT_EQ(slots.count(slot.getBuffer()), 1u);
   RegionImplFactory::unregisterRegion("MyTestNode");
 }
 
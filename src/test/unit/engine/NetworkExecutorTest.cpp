@@ -0,0 +1,112 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of NetworkExecutor test
+ */
+
+#include "gtest/gtest.h"
+
+#include <thread>
+
+#include <htm/engine/NetworkExecutor.hpp>
+#include <htm/engine/Region.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+static std::shared_ptr<Network> buildSmall(UInt seed) {
+  auto net = std::make_shared<Network>();
+  net->addRegion("enc", "RDSEEncoderRegion",
+                 "{size: 100, activeBits: 10, resolution: 1, seed: " + std::to_string(seed) + "}");
+  net->addRegion("sp", "SPRegion", "{columnCount: 50}");
+  net->link("enc", "sp", "", "", "encoded", "bottomUpIn");
+  return net;
+}
+
+TEST(NetworkExecutorTest, RunMatchesSerial) {
+  const UInt count = 40u;
+  // Build the networks on several threads at once, the region registry is shared.
+  std::vector<std::shared_ptr<Network>> parallel(count);
+  std::vector<std::thread> builders;
+  for (UInt t = 0; t < 4u; t++) {
+    builders.emplace_back([&parallel, t, count]() {
+      for (UInt i = t; i < count; i += 4u) parallel[i] = buildSmall(i + 1u);
+    });
+  }
+  for (auto &b : builders) b.join();
+
+  std::vector<std::shared_ptr<Network>> serial;
+  NetworkExecutor executor(4u, 3u);
+  ASSERT_EQ(executor.getNumThreads(), 4u);
+  for (UInt i = 0; i < count; i++) {
+    serial.push_back(buildSmall(i + 1u));
+    ASSERT_EQ(executor.add(parallel[i]), i);
+  }
+  ASSERT_EQ(executor.size(), count);
+  EXPECT_EQ(executor.getNetwork(5u), parallel[5]);
+
+  for (UInt iter = 0; iter < 10u; iter++) {
+    for (UInt i = 0; i < count; i++) {
+      const Real64 value = (iter * 7u + i * 13u) % 40u;
+      serial[i]->getRegion("enc")->setParameterReal64("sensedValue", value);
+      parallel[i]->getRegion("enc")->setParameterReal64("sensedValue", value);
+      serial[i]->run(1);
+    }
+    executor.run(1);
+    for (UInt i = 0; i < count; i++) {
+      ASSERT_EQ(serial[i]->getRegion("sp")->getOutputData("bottomUpOut"),
+                parallel[i]->getRegion("sp")->getOutputData("bottomUpOut")) << "network " << i << " at " << iter;
+    }
+  }
+
+  executor.clear();
+  EXPECT_EQ(executor.size(), 0u);
+  executor.run(1); // nothing to do
+}
+
+TEST(NetworkExecutorTest, Errors) {
+  NetworkExecutor executor(2u);
+  EXPECT_ANY_THROW(executor.add(nullptr));
+
+  auto good1 = buildSmall(1u);
+  auto good2 = buildSmall(2u);
+  auto reference = buildSmall(2u);
+  // The dimensions of the link do not match, initialize() fails.
+  auto bad = std::make_shared<Network>();
+  bad->addRegion("region1", "TestNode", "{dim: [8]}");
+  bad->addRegion("region2", "TestNode", "");
+  bad->getRegion("region2")->setInputDimensions("bottomUpIn", {4});
+  bad->link("region1", "region2");
+
+  executor.add(good1);
+  executor.add(bad);
+  executor.add(good2);
+  EXPECT_ANY_THROW(executor.add(good1));
+  ASSERT_EQ(executor.size(), 3u);
+
+  good2->getRegion("enc")->setParameterReal64("sensedValue", 4.0);
+  reference->getRegion("enc")->setParameterReal64("sensedValue", 4.0);
+  reference->run(1);
+  EXPECT_ANY_THROW(executor.run(1));
+  // The failure of one network does not hold up the others.
+  EXPECT_EQ(reference->getRegion("sp")->getOutputData("bottomUpOut"),
+            good2->getRegion("sp")->getOutputData("bottomUpOut"));
+}
+
+} // namespace testing
@@ -21,6 +21,16 @@
 
 #include "gtest/gtest.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <htm/engine/IngestQueue.hpp>
 #include <htm/engine/Network.hpp>
 #include <htm/engine/Region.hpp>
 #include <htm/engine/Input.hpp>
@@ -28,6 +38,8 @@
 #include <htm/ntypes/Dimensions.hpp>
 #include <htm/engine/RegionImpl.hpp>
 #include <htm/engine/RegisteredRegionImplCpp.hpp>
+#include <htm/engine/TrafficCapture.hpp>
+#include <htm/os/Path.hpp>
 #include <htm/utils/Log.hpp>
 
 namespace testing {
@@ -471,6 +483,81 @@ TEST(NetworkTest, Callback) {
   EXPECT_STREQ("level3", mydata[5].c_str());
 }
 
+TEST(NetworkTest, Profile) {
+  Network n;
+  n.addRegion("level1", "TestNode", "{dim: [4]}");
+  n.addRegion("level2", "TestNode", "");
+  n.link("level1", "level2");
+  Collection<Network::callbackItem> &callbacks = n.getCallbacks();
+  callbacks.add("Test Callback", Network::callbackItem(testCallback, (void *)(&mydata)));
+
+  n.run(2); // not recorded
+  n.enableProfiling();
+  n.run(5);
+  const auto &link = n.getRegion("level2")->getInput("bottomUpIn")->getLinks()[0];
+  EXPECT_EQ(n.getRegion("level1")->getComputeProfile().getCount(), 5u);
+  EXPECT_EQ(n.getRegion("level2")->getPrepareInputsProfile().getCount(), 5u);
+  EXPECT_EQ(link->getProfile().getCount(), 5u);
+  EXPECT_GE(link->getProfile().getMax(), link->getProfile().getPercentile(50.0));
+
+  Value profile;
+  profile.parse(n.getProfile());
+  EXPECT_EQ(profile["regions"]["level2"]["compute"]["count"].as<UInt>(), 5u);
+  EXPECT_EQ(profile["links"][link->getMoniker()]["count"].as<UInt>(), 5u);
+  EXPECT_EQ(profile["callbacks"]["Test Callback"]["count"].as<UInt>(), 5u);
+
+  n.disableProfiling();
+  n.run(1);
+  EXPECT_EQ(link->getProfile().getCount(), 5u);
+  n.resetProfiling();
+  EXPECT_EQ(n.getRegion("level1")->getComputeProfile().getCount(), 0u);
+  EXPECT_EQ(link->getProfile().getCount(), 0u);
+  profile.parse(n.getProfile());
+  EXPECT_FALSE(profile["callbacks"].contains("Test Callback"));
+
+  // with hardware counters, if this system has them
+  n.enableProfiling(true);
+  n.run(2);
+  const PerfCounters &counters = n.getRegion("level1")->getComputeCounters();
+  profile.parse(n.getProfile());
+  EXPECT_EQ(profile["regions"]["level1"].contains("counters"), counters.isAvailable());
+  if (counters.isAvailable(PerfCounters::INSTRUCTIONS)) {
+    EXPECT_GT(counters.get(PerfCounters::INSTRUCTIONS), 0u);
+  }
+}
+
+TEST(NetworkTest, Metrics) {
+  Network n;
+  n.addRegion("encoder", "RDSEEncoderRegion", "{size: 100, sparsity: 0.1, radius: 0.03, seed: 2019}");
+  n.addRegion("sp", "SPRegion", "{columnCount: 200, globalInhibition: true}");
+  n.addRegion("tm", "TMRegion", "{cellsPerColumn: 4}");
+  n.link("encoder", "sp", "", "", "encoded", "bottomUpIn");
+  n.link("sp", "tm", "", "", "bottomUpOut", "bottomUpIn");
+  n.enableProfiling();
+  n.run(3);
+
+  const std::string metrics = n.getMetrics("network=\"1\"");
+  EXPECT_NE(metrics.find("# TYPE htm_network_iterations_total counter\n"
+                         "htm_network_iterations_total{network=\"1\"} 3\n"), std::string::npos) << metrics;
+  EXPECT_NE(metrics.find("htm_region_compute_seconds_count{region=\"sp\",network=\"1\"} 3\n"),
+            std::string::npos) << metrics;
+  EXPECT_NE(metrics.find("htm_region_compute_seconds{region=\"tm\",quantile=\"0.99\",network=\"1\"} "),
+            std::string::npos) << metrics;
+  EXPECT_NE(metrics.find("htm_region_output_sparsity{region=\"sp\",output=\"bottomUpOut\",network=\"1\"} 0.05\n"),
+            std::string::npos) << metrics;
+  EXPECT_NE(metrics.find("htm_region_connections_synapses{region=\"sp\",network=\"1\"} "),
+            std::string::npos) << metrics;
+  EXPECT_NE(metrics.find("# TYPE htm_region_connections_pruned_synapses_total counter\n"), std::string::npos);
+  EXPECT_NE(metrics.find("htm_region_connections_segments{region=\"tm\",network=\"1\"} "), std::string::npos);
+
+  // A network that was never profiled still has its state, but no timings.
+  Network quiet;
+  quiet.addRegion("level1", "TestNode", "{dim: [4]}");
+  quiet.run(1);
+  EXPECT_EQ(quiet.getMetrics().find("htm_region_compute_seconds"), std::string::npos);
+  EXPECT_NE(quiet.getMetrics().find("htm_network_iterations_total 1\n"), std::string::npos);
+}
+
 /**
  * Test operator '=='
  */
@@ -585,6 +672,47 @@ private:
   int param;
 };
 
+// Adds 1 to its input, slowly, in the background unless {async: false}.
+class SlowRegion : public RegionImpl {
+public:
+  static std::atomic<int> running;
+  static std::atomic<int> maxRunning;
+
+  SlowRegion(const ValueMap &params, Region *region) : RegionImpl(region) {
+    async_ = params.getScalarT<bool>("async", true);
+    offset_ = params.getScalarT<Real64>("offset", 1.0);
+  }
+  SlowRegion(ArWrapper &wrapper, Region *region) : RegionImpl(region) {}
+
+  void initialize() override {}
+  void compute() override {
+    const int now = ++running;
+    for (int max = maxRunning; now > max && !maxRunning.compare_exchange_weak(max, now);) {}
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    running--;
+    const Real64 in = static_cast<const Real64 *>(getInput("in")->getData().getBuffer())[0];
+    NTA_CHECK(in >= 0.0) << "SlowRegion: negative input";
+    static_cast<Real64 *>(getOutput("out")->getData().getBuffer())[0] = in + offset_;
+  }
+  bool isAsync() const override { return async_; }
+
+  static Spec *createSpec() {
+    Spec *ns = new Spec();
+    ns->parseSpec(R"({name: "SlowRegion",
+        parameters: {async: {type: Bool, default: "true"}, offset: {type: Real64, default: "1"}},
+        inputs:  {in:  {type: Real64, count: 1, isDefaultInput: yes, isRegionLevel: no}},
+        outputs: {out: {type: Real64, count: 1, isDefaultOutput: yes, isRegionLevel: no}}})");
+    return ns;
+  }
+  bool operator==(const RegionImpl &other) const override { return false; }
+
+private:
+  bool async_ = true;
+  Real64 offset_ = 1.0;
+};
+std::atomic<int> SlowRegion::running{0};
+std::atomic<int> SlowRegion::maxRunning{0};
+
 } // namespace htm
 
 namespace testing {
@@ -615,4 +743,887 @@ TEST(NetworkTest, SaveRestore) {
   ASSERT_STREQ(s1.c_str(), s2.c_str());
 }
 
+// Four encoder -> SP branches merging into one SP, one phase per layer.
+// Two of the SPs read the same encoder output.
+static void buildBranches(Network &net, UInt initThreads = 1u) {
+  std::set<UInt32> encoders = {0}, sps = {1}, merge = {2};
+  net.addRegion("merge", "SPRegion", "{columnCount: 100}");
+  net.setPhases("merge", merge);
+  for (int i = 0; i < 4; i++) {
+    const std::string enc = "enc" + std::to_string(i);
+    const std::string sp = "sp" + std::to_string(i);
+    net.addRegion(enc, "RDSEEncoderRegion",
+                  "{size: 100, activeBits: 10, resolution: 1, seed: " + std::to_string(i + 1) + "}");
+    net.addRegion(sp, "SPRegion", "{columnCount: 50}");
+    net.setPhases(enc, encoders);
+    net.setPhases(sp, sps);
+    net.link(enc, sp, "", "", "encoded", "bottomUpIn");
+    net.link(sp, "merge", "", "", "bottomUpOut", "bottomUpIn");
+  }
+  net.addRegion("spShared", "SPRegion", "{columnCount: 50}");
+  net.setPhases("spShared", sps);
+  net.link("enc0", "spShared", "", "", "encoded", "bottomUpIn");
+  net.setNumThreads(initThreads);
+  net.initialize();
+}
+
+TEST(NetworkTest, ParallelRun) {
+  Network serial;
+  Network parallel;
+  buildBranches(serial);
+  buildBranches(parallel);
+  ASSERT_EQ(parallel.getNumThreads(), 1u);
+  parallel.setNumThreads(4);
+  ASSERT_EQ(parallel.getNumThreads(), 4u);
+
+  for (int iter = 0; iter < 20; iter++) {
+    for (int i = 0; i < 4; i++) {
+      const std::string enc = "enc" + std::to_string(i);
+      serial.getRegion(enc)->setParameterReal64("sensedValue", (iter * 7 + i * 13) % 40);
+      parallel.getRegion(enc)->setParameterReal64("sensedValue", (iter * 7 + i * 13) % 40);
+    }
+    if (iter == 10) {
+      parallel.setNumThreads(1); // back to the serial run, and again
+      parallel.setNumThreads(3);
+    }
+    serial.run(1);
+    parallel.run(1);
+    ASSERT_EQ(serial.getRegion("merge")->getOutputData("bottomUpOut"),
+              parallel.getRegion("merge")->getOutputData("bottomUpOut")) << "at " << iter;
+    ASSERT_EQ(serial.getRegion("spShared")->getOutputData("bottomUpOut"),
+              parallel.getRegion("spShared")->getOutputData("bottomUpOut")) << "at " << iter;
+  }
+}
+
+TEST(NetworkTest, ParallelInitialize) {
+  Network serial;
+  Network parallel;
+  buildBranches(serial);
+  buildBranches(parallel, 4u);
+
+  for (const std::string name : {"merge", "sp0", "spShared"}) {
+    ASSERT_EQ(serial.getRegion(name)->getInputDimensions("bottomUpIn"),
+              parallel.getRegion(name)->getInputDimensions("bottomUpIn")) << name;
+    ASSERT_EQ(serial.getRegion(name)->getOutputDimensions("bottomUpOut"),
+              parallel.getRegion(name)->getOutputDimensions("bottomUpOut")) << name;
+  }
+  ASSERT_EQ(parallel.getRegion("merge")->getInputDimensions("bottomUpIn").getCount(), 200u);
+
+  parallel.setNumThreads(1u);
+  for (int iter = 0; iter < 5; iter++) {
+    for (int i = 0; i < 4; i++) {
+      const std::string enc = "enc" + std::to_string(i);
+      serial.getRegion(enc)->setParameterReal64("sensedValue", (iter * 7 + i * 13) % 40);
+      parallel.getRegion(enc)->setParameterReal64("sensedValue", (iter * 7 + i * 13) % 40);
+    }
+    serial.run(1);
+    parallel.run(1);
+    ASSERT_EQ(serial.getRegion("merge")->getOutputData("bottomUpOut"),
+              parallel.getRegion("merge")->getOutputData("bottomUpOut")) << "at " << iter;
+  }
+}
+
+// One encoder and SP feeding three TMs, which read the SP's SDR concurrently.
+static std::vector<std::shared_ptr<Region>> buildEnsemble(Network &net) {
+  net.addRegion("enc", "RDSEEncoderRegion", "{size: 200, activeBits: 20, resolution: 1, seed: 3}");
+  net.addRegion("sp", "SPRegion", "{columnCount: 200, globalInhibition: true}");
+  net.link("enc", "sp", "", "", "encoded", "bottomUpIn");
+  auto tms = net.addEnsemble("tm", "TMRegion", {"{cellsPerColumn: 4, seed: 1}", "{cellsPerColumn: 4, seed: 2}",
+                                                "{cellsPerColumn: 8, seed: 3}"}, "sp", "bottomUpOut", "bottomUpIn");
+  net.initialize();
+  return tms;
+}
+
+TEST(NetworkTest, Ensemble) {
+  Network serial;
+  Network parallel;
+  const auto serialTMs = buildEnsemble(serial);
+  const auto parallelTMs = buildEnsemble(parallel);
+  ASSERT_EQ(parallelTMs.size(), 3u);
+  EXPECT_EQ(parallelTMs[2]->getName(), "tm2");
+  EXPECT_EQ(parallel.getRegion("tm1")->getInput("bottomUpIn")->getLinks().size(), 1u);
+  parallel.setNumThreads(4);
+
+  for (int iter = 0; iter < 30; iter++) {
+    serial.getRegion("enc")->setParameterReal64("sensedValue", iter % 10);
+    parallel.getRegion("enc")->setParameterReal64("sensedValue", iter % 10);
+    if (iter == 15) {
+      parallel.setNumThreads(1); // the TMs share the SP's SDR again
+    } else if (iter == 20) {
+      parallel.setNumThreads(3);
+    }
+    serial.run(1);
+    parallel.run(1);
+    for (size_t i = 0; i < 3u; i++) {
+      ASSERT_EQ(serialTMs[i]->getOutputData("bottomUpOut"), parallelTMs[i]->getOutputData("bottomUpOut"))
+          << "tm" << i << " at " << iter;
+      ASSERT_EQ(parallelTMs[i]->getInputData("bottomUpIn").getSDR().getSparse(),
+                parallel.getRegion("sp")->getOutputData("bottomUpOut").getSDR().getSparse());
+    }
+  }
+  // The SP's output is not changed by its readers.
+  EXPECT_EQ(serial.getRegion("sp")->getOutputData("bottomUpOut"),
+            parallel.getRegion("sp")->getOutputData("bottomUpOut"));
+  EXPECT_ANY_THROW(parallel.addEnsemble("more", "TMRegion", {}, "sp"));
+  EXPECT_ANY_THROW(parallel.addEnsemble("more", "TMRegion", {"{}"}, "nosuchregion"));
+}
+
+TEST(NetworkTest, SkipUnchanged) {
+  Network skipping;
+  Network full;
+  for (Network *net : {&skipping, &full}) {
+    net->addRegion("enc", "RDSEEncoderRegion", "{size: 200, activeBits: 20, resolution: 1, seed: 3}");
+    net->addRegion("sp", "SPRegion", "{columnCount: 200, globalInhibition: true, learningMode: 0}");
+    net->addRegion("tm", "TMRegion", "{cellsPerColumn: 4}");
+    net->link("INPUT", "enc", "", "{dim: 1}", "value", "values");
+    net->link("enc", "sp", "", "", "encoded", "bottomUpIn");
+    net->link("sp", "tm", "", "", "bottomUpOut", "bottomUpIn");
+    net->initialize();
+  }
+  skipping.setSkipUnchanged(true);
+  EXPECT_TRUE(skipping.isSkipUnchanged());
+  const auto enc = skipping.getRegion("enc");
+  const auto sp = skipping.getRegion("sp");
+  const auto tm = skipping.getRegion("tm");
+
+  const std::vector<Real64> values = {1, 1, 1, 1, 5, 5, 1, 1, 1, 1};
+  for (size_t iter = 0; iter < values.size(); iter++) {
+    Array value(std::vector<Real64>{values[iter]});
+    skipping.setInputData("value", value);
+    full.setInputData("value", value);
+    skipping.run(1);
+    full.run(1);
+    ASSERT_EQ(sp->getOutputData("bottomUpOut"), full.getRegion("sp")->getOutputData("bottomUpOut")) << "at " << iter;
+    ASSERT_EQ(tm->getOutputData("bottomUpOut"), full.getRegion("tm")->getOutputData("bottomUpOut")) << "at " << iter;
+  }
+  EXPECT_EQ(enc->getSkippedComputes(), 7u);
+  EXPECT_EQ(sp->getSkippedComputes(), 7u);
+  EXPECT_EQ(tm->getSkippedComputes(), 0u); // learns
+  EXPECT_EQ(full.getRegion("sp")->getSkippedComputes(), 0u);
+
+  // A parameter makes the region compute again, a learning SP is not pure.
+  sp->setParameterUInt32("learningMode", 1u);
+  skipping.run(2);
+  EXPECT_EQ(enc->getSkippedComputes(), 9u);
+  EXPECT_EQ(sp->getSkippedComputes(), 7u);
+}
+
+TEST(NetworkTest, IterationBudget) {
+  Network budgeted;
+  Network frozen; // what a degraded SP and TM compute
+  Network relaxed;
+  for (Network *net : {&budgeted, &frozen, &relaxed}) {
+    const std::string learn = net == &frozen ? "0" : "1";
+    net->addRegion("enc", "RDSEEncoderRegion", "{size: 200, activeBits: 20, resolution: 1, seed: 3}");
+    net->addRegion("sp", "SPRegion", "{columnCount: 200, globalInhibition: true, seed: 3, learningMode: " + learn + "}");
+    net->addRegion("tm", "TMRegion", "{cellsPerColumn: 4, seed: 3, learningMode: " + learn + "}");
+    net->link("INPUT", "enc", "", "{dim: 1}", "value", "values");
+    net->link("enc", "sp", "", "", "encoded", "bottomUpIn");
+    net->link("sp", "tm", "", "", "bottomUpOut", "bottomUpIn");
+    net->initialize();
+  }
+  EXPECT_ANY_THROW(budgeted.setIterationBudget(0.001, {"enc"}));
+  EXPECT_ANY_THROW(budgeted.setIterationBudget(0.001, {"nosuchregion"}));
+  EXPECT_ANY_THROW(budgeted.setIterationBudget(-1.0, {"tm"}));
+  budgeted.setIterationBudget(1.0e-12, {"tm", "sp"}); // always over
+  relaxed.setIterationBudget(1000.0, {"tm", "sp"});   // never over
+  EXPECT_EQ(budgeted.getIterationBudget(), 1.0e-12);
+
+  for (int iter = 0; iter < 10; iter++) {
+    Array value(std::vector<Real64>{Real64(iter % 4)});
+    for (Network *net : {&budgeted, &frozen, &relaxed}) {
+      net->setInputData("value", value);
+      net->run(1);
+    }
+    ASSERT_EQ(budgeted.getRegion("sp")->getOutputData("bottomUpOut"),
+              frozen.getRegion("sp")->getOutputData("bottomUpOut")) << "at " << iter;
+    ASSERT_EQ(budgeted.getRegion("tm")->getOutputData("bottomUpOut"),
+              frozen.getRegion("tm")->getOutputData("bottomUpOut")) << "at " << iter;
+  }
+  EXPECT_EQ(budgeted.getDeadlineMisses(), 10u);
+  EXPECT_EQ(budgeted.getDegradedComputes(), (std::map<std::string, UInt64>{{"sp", 10u}, {"tm", 10u}}));
+  EXPECT_EQ(relaxed.getDeadlineMisses(), 0u);
+  EXPECT_TRUE(relaxed.getDegradedComputes().empty());
+  EXPECT_TRUE(budgeted.getMetrics().find("htm_region_degraded_computes_total{region=\"tm\"} 10") != std::string::npos);
+
+  // Off again, the regions learn.
+  budgeted.setIterationBudget(0.0, {});
+  budgeted.resetDegradationCounts();
+  budgeted.run(2);
+  EXPECT_EQ(budgeted.getDeadlineMisses(), 0u);
+  EXPECT_TRUE(budgeted.getDegradedComputes().empty());
+  EXPECT_EQ(budgeted.getRegion("sp")->getParameterUInt32("learningMode"), 1u);
+}
+
+TEST(NetworkTest, IngestQueue) {
+  auto build = [](Network &net) {
+    net.addRegion("enc", "RDSEEncoderRegion", "{size: 200, activeBits: 20, resolution: 1, seed: 3}");
+    net.addRegion("sp", "SPRegion", "{columnCount: 100, globalInhibition: true, seed: 3}");
+    net.link("INPUT", "enc", "", "{dim: 1}", "value", "values");
+    net.link("enc", "sp", "", "", "encoded", "bottomUpIn");
+    net.initialize();
+  };
+  const int records = 200;
+  auto value = [](int t) { return Real64((t * 7) % 30); };
+  Network serial;
+  build(serial);
+  for (int t = 0; t < records; t++) {
+    serial.setInputData("value", std::vector<Real64>{value(t)});
+    serial.run(1);
+  }
+
+  for (const UInt batchSize : {1u, 8u}) {
+    Network queued;
+    build(queued);
+    queued.setBatchSize(batchSize);
+    IngestQueue queue(queued, {"value"}, 4);
+    ASSERT_EQ(queue.capacity(), 4u);
+    std::thread producer([&]() {
+      for (int t = 0; t < records; t++) {
+        IngestQueue::Record &record = *queue.beginPush();
+        static_cast<Real64 *>(record[0].getBuffer())[0] = value(t);
+        queue.endPush();
+      }
+      queue.close();
+    });
+    EXPECT_EQ(queued.runFromQueue(queue), size_t(records)) << "batch " << batchSize;
+    producer.join();
+    EXPECT_EQ(queue.available(), 0u);
+    EXPECT_EQ(queue.getPushed(), UInt64(records));
+    EXPECT_ANY_THROW(queue.beginPush());
+    EXPECT_EQ(serial.getRegion("sp")->getOutputData("bottomUpOut"),
+              queued.getRegion("sp")->getOutputData("bottomUpOut")) << "batch " << batchSize;
+  }
+
+  // Bounded runs, on records which are all there.
+  Network bounded;
+  build(bounded);
+  IngestQueue queue(bounded, {"value"}, 16);
+  for (int t = 0; t < 10; t++) {
+    IngestQueue::Record *record = queue.tryBeginPush();
+    ASSERT_NE(record, nullptr);
+    static_cast<Real64 *>((*record)[0].getBuffer())[0] = value(t);
+    queue.endPush();
+  }
+  EXPECT_EQ(bounded.runFromQueue(queue, 4u), 4u);
+  EXPECT_EQ(queue.available(), 6u);
+  queue.close();
+  EXPECT_EQ(bounded.runFromQueue(queue), 6u);
+  EXPECT_EQ(bounded.runFromQueue(queue), 0u);
+
+  EXPECT_ANY_THROW(IngestQueue(bounded, {"nosuchsource"}, 4));
+  EXPECT_ANY_THROW(IngestQueue(bounded, {}, 4));
+}
+
+// The dimensions are resolved in link order, whatever the phases.
+TEST(NetworkTest, InitializeInLinkOrder) {
+  Network net;
+  net.addRegion("sp2", "SPRegion", "{columnCount: 30}");
+  net.addRegion("sp1", "SPRegion", "{columnCount: 60}");
+  net.addRegion("enc", "RDSEEncoderRegion", "{size: 100, activeBits: 10, resolution: 1, seed: 5}");
+  std::set<UInt32> first = {0}, second = {1}, third = {2};
+  net.setPhases("sp2", first);
+  net.setPhases("sp1", second);
+  net.setPhases("enc", third);
+  net.link("enc", "sp1", "", "", "encoded", "bottomUpIn");
+  net.link("sp1", "sp2", "", "", "bottomUpOut", "bottomUpIn", 1);
+  net.initialize();
+  EXPECT_EQ(net.getRegion("sp1")->getInputDimensions("bottomUpIn").getCount(), 100u);
+  EXPECT_EQ(net.getRegion("sp2")->getInputDimensions("bottomUpIn").getCount(), 60u);
+}
+
+// A feed forward chain encoder -> SP -> SP -> SP, one phase per stage.
+static void buildChain(Network &net) {
+  net.addRegion("enc", "RDSEEncoderRegion", "{size: 100, activeBits: 10, resolution: 1, seed: 5}");
+  net.addRegion("sp1", "SPRegion", "{columnCount: 80}");
+  net.addRegion("sp2", "SPRegion", "{columnCount: 60}");
+  net.addRegion("sp3", "SPRegion", "{columnCount: 40}");
+  net.link("enc", "sp1", "", "", "encoded", "bottomUpIn");
+  net.link("sp1", "sp2", "", "", "bottomUpOut", "bottomUpIn");
+  net.link("sp2", "sp3", "", "", "bottomUpOut", "bottomUpIn");
+  net.initialize();
+}
+
+TEST(NetworkTest, PipelinedRun) {
+  Network serial;
+  Network pipelined;
+  buildChain(serial);
+  buildChain(pipelined);
+  pipelined.setNumThreads(4);
+  pipelined.setPipelined(true);
+  ASSERT_TRUE(pipelined.isPipelined());
+
+  // The last stage lags 3 records behind.
+  const int records = 15;
+  std::vector<Array> expected;
+  for (int t = 0; t < records; t++) {
+    serial.getRegion("enc")->setParameterReal64("sensedValue", (t * 7) % 30);
+    pipelined.getRegion("enc")->setParameterReal64("sensedValue", (t * 7) % 30);
+    serial.run(1);
+    pipelined.run(1);
+    expected.push_back(serial.getRegion("sp3")->getOutputData("bottomUpOut").copy());
+    ASSERT_EQ(serial.getRegion("enc")->getOutputData("encoded"),
+              pipelined.getRegion("enc")->getOutputData("encoded")) << "at " << t;
+    if (t >= 3) {
+      ASSERT_EQ(expected[t - 3], pipelined.getRegion("sp3")->getOutputData("bottomUpOut")) << "at " << t;
+    }
+  }
+
+  // Draining catches up with the serial run.
+  pipelined.setPipelined(false);
+  ASSERT_FALSE(pipelined.isPipelined());
+  for (const auto name : { "sp1", "sp2", "sp3" }) {
+    ASSERT_EQ(serial.getRegion(name)->getOutputData("bottomUpOut"),
+              pipelined.getRegion(name)->getOutputData("bottomUpOut")) << name;
+  }
+
+  // Links must go forward, without delay.
+  Network delayed;
+  delayed.addRegion("enc", "RDSEEncoderRegion", "{size: 100, activeBits: 10, resolution: 1}");
+  delayed.addRegion("sp", "SPRegion", "{columnCount: 40}");
+  delayed.link("enc", "sp", "", "", "encoded", "bottomUpIn", 1);
+  EXPECT_ANY_THROW(delayed.setPipelined(true));
+}
+
+// A noisy encoder -> inference SP (batched at once) -> learning SP (one by one).
+static void buildBatchChain(Network &net) {
+  net.addRegion("enc", "RDSEEncoderRegion", "{size: 100, activeBits: 10, resolution: 1, noise: 0.2, seed: 5}");
+  net.addRegion("sp1", "SPRegion", "{columnCount: 80, learningMode: 0}");
+  net.addRegion("sp2", "SPRegion", "{columnCount: 40}");
+  net.link("enc", "sp1", "", "", "encoded", "bottomUpIn");
+  net.link("sp1", "sp2", "", "", "bottomUpOut", "bottomUpIn");
+  net.initialize();
+}
+
+TEST(NetworkTest, BatchedRun) {
+  Network serial;
+  Network batched;
+  buildBatchChain(serial);
+  buildBatchChain(batched);
+  ASSERT_EQ(batched.getBatchSize(), 1u);
+  batched.setBatchSize(4);
+  ASSERT_EQ(batched.getBatchSize(), 4u);
+  UInt64 callbacks[2] = {0u, 0u}; // calls, last iteration
+  batched.getCallbacks().add("count", Network::callbackItem(
+      [](Network *, UInt64 iteration, void *p) {
+        static_cast<UInt64 *>(p)[0]++;
+        static_cast<UInt64 *>(p)[1] = iteration;
+      }, callbacks));
+
+  for (const int n : {10, 3, 1}) {
+    serial.run(n);
+    batched.run(n); // 4 + 4 + 2, 3 and 1 records
+    for (const auto name : {"sp1", "sp2"}) {
+      ASSERT_EQ(serial.getRegion(name)->getOutputData("bottomUpOut"),
+                batched.getRegion(name)->getOutputData("bottomUpOut")) << name << " after " << n;
+    }
+  }
+  EXPECT_EQ(callbacks[0], 5u); // one per batch
+  EXPECT_EQ(callbacks[1], 14u);
+  EXPECT_TRUE(batched.getRegion("sp1")->getOutput("bottomUpOut")->getBatch().empty());
+
+  EXPECT_ANY_THROW(batched.setPipelined(true));
+  batched.setBatchSize(0);
+  EXPECT_EQ(batched.getBatchSize(), 1u);
+  serial.run(2);
+  batched.run(2);
+  EXPECT_EQ(serial.getRegion("sp2")->getOutputData("bottomUpOut"),
+            batched.getRegion("sp2")->getOutputData("bottomUpOut"));
+
+  Network delayed;
+  delayed.addRegion("enc", "RDSEEncoderRegion", "{size: 100, activeBits: 10, resolution: 1}");
+  delayed.addRegion("sp", "SPRegion", "{columnCount: 40}");
+  delayed.link("enc", "sp", "", "", "encoded", "bottomUpIn", 1);
+  EXPECT_ANY_THROW(delayed.setBatchSize(8));
+}
+
+TEST(NetworkTest, AsyncCompute) {
+  // INPUT -> a -> c, INPUT -> b: a and b compute at once, c waits for a.
+  Network net;
+  net.registerRegion("SlowRegion", new RegisteredRegionImplCpp<SlowRegion>());
+  net.addRegion("a", "SlowRegion", "");
+  net.addRegion("b", "SlowRegion", "");
+  net.addRegion("c", "SlowRegion", "{async: false}");
+  net.link("INPUT", "a", "", "{dim: 1}", "value", "in");
+  net.link("INPUT", "b", "", "{dim: 1}", "value", "in");
+  net.link("a", "c", "", "", "out", "in");
+  net.initialize();
+  ASSERT_TRUE(net.getRegion("a")->isAsync());
+  ASSERT_FALSE(net.getRegion("c")->isAsync());
+
+  SlowRegion::maxRunning = 0;
+  for (const Real64 value : {1.0, 5.0}) {
+    net.setInputData("value", std::vector<Real64>{value});
+    net.run(1);
+    const auto out = [&](const char *name) {
+      return net.getRegion(name)->getOutputData("out").item<Real64>(0);
+    };
+    EXPECT_EQ(out("a"), value + 1.0);
+    EXPECT_EQ(out("b"), value + 1.0);
+    EXPECT_EQ(out("c"), value + 2.0);
+  }
+  EXPECT_EQ(SlowRegion::maxRunning, 2);
+  EXPECT_EQ(SlowRegion::running, 0);
+
+  // A failure in the background is rethrown by run().
+  net.setInputData("value", std::vector<Real64>{-10.0});
+  EXPECT_ANY_THROW(net.run(1));
+  net.setInputData("value", std::vector<Real64>{2.0});
+  net.run(1);
+  EXPECT_EQ(net.getRegion("c")->getOutputData("out").item<Real64>(0), 4.0);
+}
+
+TEST(NetworkTest, Placement) {
+  const std::vector<int> all = ThreadPool::currentThreadCpus();
+  const std::string cpu = std::to_string(all.empty() ? 0 : all.front());
+  const std::string yaml = R"(
+    network:
+      - placement: {numaNode: 0}
+      - addThreadPool: {name: "local", threads: 2, cpus: [)" + cpu + R"(]}
+      - addRegion: {name: "enc", type: "RDSEEncoderRegion", params: {size: 400, activeBits: 20, resolution: 1, seed: 3}}
+      - addRegion: {name: "sp", type: "SPRegion", params: {columnCount: 200, seed: 3},
+                    placement: {cpus: [)" + cpu + R"(], pool: "local"}}
+      - addRegion: {name: "tm", type: "TMRegion", params: {cellsPerColumn: 4, seed: 3},
+                    placement: {pool: "local"}}
+      - addLink: {src: "enc.encoded", dest: "sp.bottomUpIn"}
+      - addLink: {src: "sp.bottomUpOut", dest: "tm.bottomUpIn"}
+  )";
+  Network placed;
+  placed.configure(yaml);
+  ASSERT_NE(placed.getThreadPool("local"), nullptr);
+  EXPECT_EQ(placed.getThreadPool("local")->size(), 2u);
+  EXPECT_EQ(placed.getThreadPool("other"), nullptr);
+  EXPECT_EQ(placed.getRegion("sp")->getPlacement().cpus, std::vector<int>{std::stoi(cpu)});
+  EXPECT_EQ(placed.getRegion("enc")->getPlacement().numaNode, -1);
+  EXPECT_EQ(placed.getPlacement("enc").numaNode, 0); // the default
+  EXPECT_EQ(placed.getPlacement("tm").pool, "local");
+  placed.initialize();
+  ASSERT_NE(placed.getArena(0), nullptr);
+
+  // Placement changes where, not what is computed.
+  Network plain;
+  plain.addRegion("enc", "RDSEEncoderRegion", "{size: 400, activeBits: 20, resolution: 1, seed: 3}");
+  plain.addRegion("sp", "SPRegion", "{columnCount: 200, seed: 3}");
+  plain.addRegion("tm", "TMRegion", "{cellsPerColumn: 4, seed: 3}");
+  plain.link("enc", "sp", "", "", "encoded", "bottomUpIn");
+  plain.link("sp", "tm", "", "", "bottomUpOut", "bottomUpIn");
+  for (const Real64 value : {1.0, 7.0, 3.0, 1.0, 7.0, 3.0}) {
+    placed.getRegion("enc")->setParameterReal64("sensedValue", value);
+    plain.getRegion("enc")->setParameterReal64("sensedValue", value);
+    placed.run(1);
+    plain.run(1);
+    EXPECT_EQ(placed.getRegion("tm")->getOutputData("bottomUpOut").getSDR(),
+              plain.getRegion("tm")->getOutputData("bottomUpOut").getSDR());
+  }
+  EXPECT_EQ(ThreadPool::currentThreadCpus(), all); // unpinned after each compute
+
+  // A pool which was not added.
+  Network missing;
+  Placement pool;
+  pool.pool = "none";
+  missing.addRegion("enc", "RDSEEncoderRegion", "{size: 100, activeBits: 10, resolution: 1}", pool);
+  EXPECT_ANY_THROW(missing.initialize());
+}
+
+TEST(NetworkTest, HotSwap) {
+  Network net;
+  net.registerRegion("SlowRegion", new RegisteredRegionImplCpp<SlowRegion>());
+  net.addRegion("a", "SlowRegion", "{async: false}");
+  net.link("INPUT", "a", "", "{dim: 1}", "value", "in");
+  net.setInputData("value", std::vector<Real64>{1.0});
+  net.run(1);
+  const auto out = [&]() { return net.getRegion("a")->getOutputData("out").item<Real64>(0); };
+  EXPECT_EQ(out(), 2.0);
+
+  // Loaded in the background while the network runs on.
+  std::atomic<bool> release{false};
+  auto swapped = net.swapRegionAsync("a", [&release](Region *r) {
+    while (!release) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    ValueMap params;
+    params.parse("{async: false, offset: 10}");
+    return new SlowRegion(params, r);
+  });
+  EXPECT_TRUE(net.hasPendingSwaps());
+  net.run(2);
+  EXPECT_EQ(out(), 2.0);
+  EXPECT_NE(swapped.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+  release = true;
+  while (swapped.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    net.run(1);
+  swapped.get();
+  EXPECT_FALSE(net.hasPendingSwaps());
+  EXPECT_EQ(out(), 11.0); // computed after the swap, on the same links and buffers
+  net.setInputData("value", std::vector<Real64>{5.0});
+  net.run(1);
+  EXPECT_EQ(out(), 15.0);
+
+  // A failed load leaves the region as it was.
+  auto failed = net.swapRegionAsync("a", [](Region *) -> RegionImpl * { NTA_THROW << "corrupt"; });
+  while (net.hasPendingSwaps())
+    EXPECT_EQ(net.applyRegionSwaps(), 0u);
+  EXPECT_ANY_THROW(failed.get());
+  auto missing = net.swapRegionAsync("a", "NetworkTest_missing_region.tmp");
+  while (net.hasPendingSwaps())
+    net.applyRegionSwaps();
+  EXPECT_ANY_THROW(missing.get());
+  net.run(1);
+  EXPECT_EQ(out(), 15.0);
+  EXPECT_ANY_THROW(net.swapRegionAsync("b", "NetworkTest_missing_region.tmp"));
+}
+
+// INPUT -> inference SP (batched at once) -> learning SP, and INPUT -> encoder.
+static void buildInputChain(Network &net) {
+  net.addRegion("sp1", "SPRegion", "{columnCount: 80, learningMode: 0}");
+  net.addRegion("sp2", "SPRegion", "{columnCount: 40}");
+  net.addRegion("enc", "RDSEEncoderRegion", "{size: 100, activeBits: 10, resolution: 1, seed: 5}");
+  net.link("INPUT", "sp1", "", "{dim: 100}", "columns", "bottomUpIn");
+  net.link("sp1", "sp2", "", "", "bottomUpOut", "bottomUpIn");
+  net.link("INPUT", "enc", "", "{dim: 1}", "value", "values");
+  net.initialize();
+}
+
+TEST(NetworkTest, TypedInput) {
+  Network reference;
+  Network typed;
+  buildInputChain(reference);
+  buildInputChain(typed);
+  Random rng(11);
+  std::vector<SDR> records(9, SDR({100}));
+  for (auto &record : records)
+    record.randomize(0.1f, rng);
+
+  for (size_t i = 0; i < 5; i++) {
+    reference.setInputData("columns", Array(records[i]));
+    reference.setInputData("value", Array(std::vector<Real64>{static_cast<Real64>(i)}));
+    if (i % 2 == 0) {
+      typed.setInputSparse("columns", records[i].getSparse());
+    } else {
+      const auto dense = records[i].getDense();
+      typed.setInputData("columns", dense.data(), dense.size());
+    }
+    typed.setInputData("value", std::vector<Real64>{static_cast<Real64>(i)});
+    reference.run(1);
+    typed.run(1);
+    ASSERT_EQ(reference.getRegion("sp2")->getOutputData("bottomUpOut"),
+              typed.getRegion("sp2")->getOutputData("bottomUpOut")) << "at " << i;
+    ASSERT_EQ(reference.getRegion("enc")->getOutputData("encoded"),
+              typed.getRegion("enc")->getOutputData("encoded")) << "at " << i;
+  }
+
+  // The next 4 records at once, in one batch.
+  std::vector<UInt> sparse;
+  std::vector<size_t> ends;
+  const std::vector<Real64> values = {5, 6, 7, 8};
+  for (size_t i = 5; i < 9; i++) {
+    reference.setInputData("columns", Array(records[i]));
+    reference.setInputData("value", Array(std::vector<Real64>{values[i - 5]}));
+    reference.run(1);
+    sparse.insert(sparse.end(), records[i].getSparse().begin(), records[i].getSparse().end());
+    ends.push_back(sparse.size());
+  }
+  typed.setBatchSize(4);
+  typed.setInputSparseBatch("columns", sparse.data(), ends.data(), ends.size());
+  typed.setInputBatch("value", values.data(), values.size());
+  typed.run(4);
+  EXPECT_EQ(reference.getRegion("sp2")->getOutputData("bottomUpOut"),
+            typed.getRegion("sp2")->getOutputData("bottomUpOut"));
+  EXPECT_EQ(reference.getRegion("enc")->getOutputData("encoded"),
+            typed.getRegion("enc")->getOutputData("encoded"));
+
+  // Not converted, the type must be that of the output.
+  EXPECT_ANY_THROW(typed.setInputData("value", std::vector<Int32>{1}));
+  EXPECT_ANY_THROW(typed.setInputData("value", std::vector<Real64>{1, 2}));
+  EXPECT_ANY_THROW(typed.setInputSparse("value", std::vector<UInt>{0}));
+}
+
+TEST(NetworkTest, CaptureReplay) {
+  const std::string path = "NetworkCapture.tmp";
+  Network live;
+  buildInputChain(live);
+  Random rng(13);
+  std::vector<SDR> records(9, SDR({100}));
+  for (auto &record : records)
+    record.randomize(0.1f, rng);
+
+  live.startCapture(path);
+  EXPECT_TRUE(live.isCapturing());
+  EXPECT_ANY_THROW(live.startCapture(path));
+  for (size_t i = 0; i < 5; i++) {
+    live.setInputSparse("columns", records[i].getSparse());
+    live.setInputData("value", std::vector<Real64>{static_cast<Real64>(i)});
+    live.run(1);
+  }
+  // A batched run is captured record by record.
+  std::vector<UInt> sparse;
+  std::vector<size_t> ends;
+  const std::vector<Real64> values = {5, 6, 7, 8};
+  for (size_t i = 5; i < 9; i++) {
+    sparse.insert(sparse.end(), records[i].getSparse().begin(), records[i].getSparse().end());
+    ends.push_back(sparse.size());
+  }
+  live.setBatchSize(4);
+  live.setInputSparseBatch("columns", sparse.data(), ends.data(), ends.size());
+  live.setInputBatch("value", values.data(), values.size());
+  live.run(4);
+  EXPECT_EQ(live.stopCapture(), 9u);
+  EXPECT_FALSE(live.isCapturing());
+  EXPECT_ANY_THROW(live.stopCapture());
+
+  {
+    TrafficReplay replay(path);
+    ASSERT_EQ(replay.names(), std::vector<std::string>({"columns", "value"}));
+    for (size_t i = 0; i < 9; i++) {
+      ASSERT_TRUE(replay.next()) << "at " << i;
+      EXPECT_EQ(replay[0].getSDR(), records[i]) << "at " << i;
+      EXPECT_EQ(replay[1].item<Real64>(0), static_cast<Real64>(i)) << "at " << i;
+    }
+    EXPECT_FALSE(replay.next());
+  }
+
+  for (const UInt batchSize : {1u, 4u}) {
+    Network replayed;
+    buildInputChain(replayed);
+    replayed.setBatchSize(batchSize);
+    EXPECT_EQ(replayed.replayCapture(path), 9u) << "batch " << batchSize;
+    EXPECT_EQ(live.getRegion("sp2")->getOutputData("bottomUpOut"),
+              replayed.getRegion("sp2")->getOutputData("bottomUpOut")) << "batch " << batchSize;
+    EXPECT_EQ(live.getRegion("enc")->getOutputData("encoded"),
+              replayed.getRegion("enc")->getOutputData("encoded")) << "batch " << batchSize;
+  }
+
+  // At the pace of the capture, and bounded.
+  Network paced;
+  buildInputChain(paced);
+  EXPECT_EQ(paced.replayCapture(path, 1.0, 3u), 3u);
+  EXPECT_EQ(paced.getRegion("INPUT")->getOutputData("value").item<Real64>(0), 2.0);
+
+  // The log must match the INPUT outputs.
+  Network other;
+  other.addRegion("sp", "SPRegion", "{columnCount: 40}");
+  other.addRegion("enc", "RDSEEncoderRegion", "{size: 100, activeBits: 10, resolution: 1, seed: 5}");
+  other.link("INPUT", "sp", "", "{dim: 50}", "columns", "bottomUpIn");
+  other.link("INPUT", "enc", "", "{dim: 1}", "value", "values");
+  other.initialize();
+  EXPECT_ANY_THROW(other.replayCapture(path));
+  EXPECT_ANY_THROW(other.startCapture(path, {"nosuchsource"}));
+  EXPECT_ANY_THROW(other.replayCapture("NetworkCaptureMissing.tmp"));
+  Path::remove(path);
+}
+
+static void buildCheckpointChain(Network &net) {
+  net.addRegion("enc", "RDSEEncoderRegion", "{size: 100, activeBits: 10, resolution: 1}");
+  net.addRegion("sp", "SPRegion", "{columnCount: 100}");
+  net.addRegion("tm", "TMRegion", "{cellsPerColumn: 4}");
+  net.link("enc", "sp", "", "", "encoded", "bottomUpIn");
+  net.link("sp", "tm", "", "", "bottomUpOut", "bottomUpIn");
+}
+
+static void runCheckpointChain(Network &net, int first, int last) {
+  for (int i = first; i < last; i++) {
+    net.getRegion("enc")->setParameterReal64("sensedValue", static_cast<Real64>(i * 7 % 60));
+    net.run(1);
+  }
+}
+
+TEST(NetworkTest, DeltaCheckpoint) {
+  const std::string base = "NetworkCheckpointBase.tmp";
+  const std::string delta = "NetworkCheckpointDelta.tmp";
+  Network net;
+  buildCheckpointChain(net);
+  EXPECT_ANY_THROW(net.saveDeltaCheckpoint(delta)); // no base yet
+
+  runCheckpointChain(net, 0, 30);
+  net.saveCheckpoint(base);
+  runCheckpointChain(net, 30, 35);
+  net.saveDeltaCheckpoint(delta);
+  EXPECT_LT(Path::getFileSize(delta), Path::getFileSize(base));
+
+  Network restored;
+  restored.loadCheckpoint(base, delta);
+  EXPECT_TRUE(net == restored);
+  runCheckpointChain(net, 35, 40);
+  runCheckpointChain(restored, 35, 40);
+  EXPECT_EQ(net.getRegion("tm")->getOutputData("bottomUpOut"),
+            restored.getRegion("tm")->getOutputData("bottomUpOut"));
+
+  // the base alone is the state at saveCheckpoint()
+  Network fromBase;
+  fromBase.loadCheckpoint(base);
+  EXPECT_FALSE(net == fromBase);
+
+  // deltas are cumulative, and belong to their base only
+  net.saveDeltaCheckpoint(delta);
+  net.saveCheckpoint(base);
+  Network other;
+  EXPECT_ANY_THROW(other.loadCheckpoint(base, delta));
+
+  Path::remove(base);
+  Path::remove(delta);
+}
+
+TEST(NetworkTest, ChunkedSaveLoad) {
+  const std::string packed = "NetworkChunked.tmp";
+  const std::string stored = "NetworkChunkedStored.tmp";
+  Network net;
+  buildCheckpointChain(net);
+  runCheckpointChain(net, 0, 30);
+  net.saveToChunkedFile(packed, 2u);
+  net.saveToChunkedFile(stored, 2u, false);
+  EXPECT_LT(Path::getFileSize(packed), Path::getFileSize(stored));
+
+  for (const auto &path : {packed, stored}) {
+    Network restored;
+    restored.loadFromChunkedFile(path);
+    EXPECT_TRUE(net == restored);
+    EXPECT_ANY_THROW(restored.loadFromChunkedFile(path)); // not empty
+  }
+
+  Network restored;
+  restored.loadFromChunkedFile(packed, {}, 1u);
+  runCheckpointChain(net, 30, 35);
+  runCheckpointChain(restored, 30, 35);
+  EXPECT_EQ(net.getRegion("tm")->getOutputData("bottomUpOut"),
+            restored.getRegion("tm")->getOutputData("bottomUpOut"));
+
+  // selective load keeps only the links between loaded regions
+  Network partial;
+  partial.loadFromChunkedFile(packed, {"enc", "sp"});
+  EXPECT_EQ(partial.getRegions().size(), 2u);
+  EXPECT_EQ(partial.getLinks().size(), 1u);
+  partial.getRegion("enc")->setParameterReal64("sensedValue", 3.0);
+  partial.run(1);
+
+  Network missing;
+  EXPECT_ANY_THROW(missing.loadFromChunkedFile(packed, {"nope"}));
+
+  Path::remove(packed);
+  Path::remove(stored);
+}
+
+TEST(NetworkTest, ChunkedSinkSource) {
+  const std::string path = "NetworkChunkedSink.tmp";
+  Network net;
+  buildCheckpointChain(net);
+  runCheckpointChain(net, 0, 30);
+  net.saveToChunkedFile(path, 2u);
+
+  // uploaded in parts while the regions are serialized, same bytes as the file
+  std::mutex mutex;
+  std::map<size_t, std::string> parts;
+  MultipartSink sink([&](size_t part, const char *data, size_t bytes) {
+                       const std::lock_guard<std::mutex> lock(mutex);
+                       parts[part].assign(data, bytes);
+                     }, nullptr, 4096u, 2u);
+  net.saveToChunkedFile(sink, 2u);
+  std::string object;
+  for (const auto &part : parts)
+    object += part.second;
+  EXPECT_EQ(object.size(), Path::getFileSize(path));
+
+  const RangeSource source([&](UInt64 offset, char *data, size_t bytes) {
+                             std::memcpy(data, object.data() + offset, bytes);
+                           }, object.size());
+  Network restored;
+  restored.loadFromChunkedFile(source, {}, 2u);
+  EXPECT_TRUE(net == restored);
+
+  Network partial;
+  partial.loadFromChunkedFile(source, {"enc", "sp"});
+  EXPECT_EQ(partial.getRegions().size(), 2u);
+
+  // a stdio stream, as popen() gives for a pipe
+  std::FILE *pipe = std::fopen(path.c_str(), "wb");
+  ASSERT_TRUE(pipe != nullptr);
+  StdioSink stdio(pipe);
+  net.saveToChunkedFile(stdio, 1u, false);
+  std::fclose(pipe);
+  Network stored;
+  stored.loadFromChunkedFile(FileSource(path));
+  EXPECT_TRUE(net == stored);
+
+  Path::remove(path);
+}
+
+TEST(NetworkTest, SaveAsync) {
+  const std::string path = "NetworkAsync.tmp";
+  Network net;
+  buildCheckpointChain(net);
+  runCheckpointChain(net, 0, 20);
+  Network snapshot;
+  {
+    std::stringstream ss;
+    net.save(ss);
+    snapshot.load(ss);
+  }
+
+  auto done = net.saveAsync(path);
+  runCheckpointChain(net, 20, 30); // compute continues meanwhile
+  done.get();
+  EXPECT_FALSE(Path::exists(path + ".partial"));
+
+  Network restored;
+  restored.loadFromFile(path);
+  EXPECT_TRUE(snapshot == restored);
+  EXPECT_FALSE(net == restored);
+
+  EXPECT_ANY_THROW(net.saveAsync(path + "/under_a_file").get());
+  Path::remove(path);
+}
+
+TEST(NetworkTest, Clone) {
+  Network net;
+  buildCheckpointChain(net);
+  runCheckpointChain(net, 0, 30);
+  Network snapshot;
+  {
+    std::stringstream ss;
+    net.save(ss);
+    snapshot.load(ss);
+  }
+
+  Network learner = net.clone();
+  EXPECT_TRUE(net == learner);
+  runCheckpointChain(learner, 30, 40); // learns on its own copy
+  EXPECT_TRUE(net == snapshot);
+  runCheckpointChain(net, 30, 40);
+  EXPECT_TRUE(net == learner);
+
+  // many inference streams of one template, run concurrently
+  net.getRegion("sp")->setParameterUInt32("learningMode", 0u);
+  net.getRegion("tm")->setParameterBool("learningMode", false);
+  std::vector<Network> streams;
+  for (int i = 0; i < 4; i++)
+    streams.push_back(net.clone());
+  std::vector<std::thread> threads;
+  for (auto &stream : streams)
+    threads.emplace_back([&stream]() { runCheckpointChain(stream, 40, 50); });
+  for (auto &t : threads)
+    t.join();
+  runCheckpointChain(net, 40, 50);
+  for (auto &stream : streams) {
+    EXPECT_EQ(net.getRegion("tm")->getOutputData("bottomUpOut"),
+              stream.getRegion("tm")->getOutputData("bottomUpOut"));
+  }
+}
+
+TEST(NetworkTest, MemoryUsage) {
+  Network net;
+  buildCheckpointChain(net);
+  net.addRegion("delayed", "SPRegion", "{columnCount: 50}");
+  net.link("enc", "delayed", "", "", "encoded", "bottomUpIn", 2);
+  runCheckpointChain(net, 0, 10);
+
+  const MemoryUsage usage = net.memoryUsage();
+  EXPECT_GT(usage.at("sp.connections.synapses"), 0u);
+  EXPECT_GT(usage.at("tm.connections.segments"), 0u);
+  EXPECT_GT(usage.at("sp.dutyCycles"), 0u);
+  EXPECT_GT(usage.at("enc.outputs"), 0u);
+  EXPECT_GT(usage.at("links"), 0u);
+  EXPECT_EQ(usage.count("enc.connections.synapses"), 0u);
+  size_t sp = 0u;
+  for (const auto &category : net.getRegion("sp")->memoryUsage())
+    sp += category.second;
+  EXPECT_GT(memory::total(usage), sp);
+}
+
 } // namespace testing
@@ -24,14 +24,17 @@
 
 #include "gtest/gtest.h"
 
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <fstream>
 #include <string>
 #include <thread>
+#include <atomic>
 #include <chrono>
 
 #include <examples/rest/server_core.hpp>
+#include <htm/os/Directory.hpp>
 
 namespace testing {
 
@@ -304,6 +307,445 @@ TEST_F(RESTapiTest, test_delete) {
 }
 
 
+TEST_F(RESTapiTest, profile) {
+  char message[1000];
+  Value vm;
+
+  std::string config = R"(
+   {network: [
+       {addRegion: {name: "encoder", type: "RDSEEncoderRegion", params: {size: 100, sparsity: 0.1, radius: 0.03, seed: 2019}}},
+       {addRegion: {name: "sp", type: "SPRegion", params: {columnCount: 200, globalInhibition: true}}},
+       {addLink:   {src: "encoder.encoded", dest: "sp.bottomUpIn"}}
+    ]})";
+  auto res = client->Post("/network", config, "application/json");
+  ASSERT_TRUE(res && res->status / 100 == 2) << "Failed Response to POST /network request.";
+  vm.parse(res->body);
+  ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+  std::string id = vm["result"].str();
+
+  snprintf(message, sizeof(message), "/network/%s/profile?action=enable", id.c_str());
+  res = client->Get(message);
+  ASSERT_TRUE(res && res->status / 100 == 2) << " GET profile message failed.";
+  vm.parse(res->body);
+  EXPECT_STREQ(vm["result"].c_str(), "OK") << "Response to GET profile?action=enable";
+
+  snprintf(message, sizeof(message), "/network/%s/run?iterations=3", id.c_str());
+  res = client->Get(message);
+  ASSERT_TRUE(res && res->status / 100 == 2) << " GET run message failed.";
+
+  snprintf(message, sizeof(message), "/network/%s/profile", id.c_str());
+  res = client->Get(message);
+  ASSERT_TRUE(res && res->status / 100 == 2) << " GET profile message failed.";
+  vm.parse(res->body);
+  ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+  EXPECT_EQ(vm["result"]["regions"]["sp"]["compute"]["count"].as<UInt>(), 3u);
+  EXPECT_EQ(vm["result"]["links"]["encoder.encoded-->sp.bottomUpIn"]["count"].as<UInt>(), 3u);
+
+  snprintf(message, sizeof(message), "/network/%s/profile?action=bogus", id.c_str());
+  res = client->Get(message);
+  ASSERT_TRUE(res && res->status / 100 == 2);
+  vm.parse(res->body);
+  EXPECT_TRUE(vm.contains("err"));
+}
+
+TEST_F(RESTapiTest, metrics) {
+  char message[1000];
+  Value vm;
+
+  std::string config = R"(
+   {network: [
+       {addRegion: {name: "encoder", type: "RDSEEncoderRegion", params: {size: 100, sparsity: 0.1, radius: 0.03, seed: 2019}}},
+       {addRegion: {name: "sp", type: "SPRegion", params: {columnCount: 200, globalInhibition: true}}},
+       {addLink:   {src: "encoder.encoded", dest: "sp.bottomUpIn"}}
+    ]})";
+  auto res = client->Post("/network", config, "application/json");
+  ASSERT_TRUE(res && res->status / 100 == 2) << "Failed Response to POST /network request.";
+  vm.parse(res->body);
+  ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+  std::string id = vm["result"].str();
+
+  snprintf(message, sizeof(message), "/network/%s/run?iterations=2", id.c_str());
+  res = client->Get(message);
+  ASSERT_TRUE(res && res->status / 100 == 2) << " GET run message failed.";
+
+  snprintf(message, sizeof(message), "/network/%s/metrics", id.c_str());
+  res = client->Get(message);
+  ASSERT_TRUE(res && res->status / 100 == 2) << " GET metrics message failed.";
+  EXPECT_EQ(res->get_header_value("Content-Type"), "text/plain; version=0.0.4");
+  snprintf(message, sizeof(message), "htm_network_iterations_total{network=\"%s\"} 2\n", id.c_str());
+  EXPECT_NE(res->body.find(message), std::string::npos) << res->body;
+  EXPECT_NE(res->body.find("# TYPE htm_region_connections_synapses gauge\n"), std::string::npos) << res->body;
+
+  res = client->Get("/network/nonexistent/metrics");
+  ASSERT_TRUE(res && res->status / 100 == 2);
+  vm.parse(res->body);
+  EXPECT_TRUE(vm.contains("err"));
+}
+
+TEST_F(RESTapiTest, memory) {
+  char message[1000];
+  Value vm;
+
+  std::string config = R"(
+   {network: [
+       {addRegion: {name: "encoder", type: "RDSEEncoderRegion", params: {size: 100, sparsity: 0.1, radius: 0.03, seed: 2019}}},
+       {addRegion: {name: "sp", type: "SPRegion", params: {columnCount: 200, globalInhibition: true}}},
+       {addLink:   {src: "encoder.encoded", dest: "sp.bottomUpIn"}}
+    ]})";
+  auto res = client->Post("/network", config, "application/json");
+  ASSERT_TRUE(res && res->status / 100 == 2) << "Failed Response to POST /network request.";
+  vm.parse(res->body);
+  ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+  std::string id = vm["result"].str();
+
+  snprintf(message, sizeof(message), "/network/%s/run?iterations=2", id.c_str());
+  res = client->Get(message);
+  ASSERT_TRUE(res && res->status / 100 == 2) << " GET run message failed.";
+
+  snprintf(message, sizeof(message), "/network/%s/memory", id.c_str());
+  res = client->Get(message);
+  ASSERT_TRUE(res && res->status / 100 == 2) << " GET memory message failed.";
+  vm.parse(res->body);
+  ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+  EXPECT_GT(vm["result"]["sp.connections.synapses"].as<UInt64>(), 0u);
+  EXPECT_GT(vm["result"]["total"].as<UInt64>(), vm["result"]["sp.connections.synapses"].as<UInt64>());
+
+  res = client->Get("/network/nonexistent/memory");
+  ASSERT_TRUE(res && res->status / 100 == 2);
+  vm.parse(res->body);
+  EXPECT_TRUE(vm.contains("err"));
+}
+
+TEST_F(RESTapiTest, binary) {
+  char message[1000];
+  Value vm;
+
+  std::string config = R"(
+   {network: [
+       {addRegion: {name: "sp", type: "SPRegion", params: {columnCount: 200, globalInhibition: true}}},
+       {addLink:   {src: "INPUT.src", dest: "sp.bottomUpIn", dim: [100]}}
+    ]})";
+  auto res = client->Post("/network", config, "application/json");
+  ASSERT_TRUE(res && res->status / 100 == 2) << "Failed Response to POST /network request.";
+  vm.parse(res->body);
+  ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+  std::string id = vm["result"].str();
+
+  SDR input({100});
+  input.setSparse(SDR_sparse_t{1u, 5u, 50u, 99u});
+  std::string frame;
+  RESTapi::encode_binary(Array(input), frame);
+  EXPECT_EQ(frame.size(), 24u + 4u) << "4 active bits with small gaps take 1 byte each";
+
+  snprintf(message, sizeof(message), "/network/%s/input/src", id.c_str());
+  res = client->Put(message, frame, RESTapi::BINARY_CONTENT_TYPE.c_str());
+  ASSERT_TRUE(res && res->status / 100 == 2) << " PUT binary input failed.";
+  EXPECT_EQ(res->body, "{\"result\": \"OK\"}\n");
+
+  // Three iterations in one request.
+  snprintf(message, sizeof(message), "/network/%s/stream?input=src&output=sp.bottomUpOut", id.c_str());
+  res = client->Post(message, frame + frame + frame, RESTapi::BINARY_CONTENT_TYPE.c_str());
+  ASSERT_TRUE(res && res->status / 100 == 2) << " POST stream failed.";
+  EXPECT_EQ(res->get_header_value("Content-Type"), RESTapi::BINARY_CONTENT_TYPE);
+  size_t pos = 0u;
+  size_t outputs = 0u;
+  while (pos < res->body.size()) {
+    Array output = RESTapi::decode_binary(res->body, pos);
+    EXPECT_EQ(output.getCount(), 200u);
+    EXPECT_GT(output.getSDR().getSum(), 0u);
+    outputs++;
+  }
+  EXPECT_EQ(outputs, 3u);
+
+  snprintf(message, sizeof(message), "/network/%s/region/sp/output/bottomUpOut", id.c_str());
+  res = client->Get(message, {{"Accept", RESTapi::BINARY_CONTENT_TYPE}});
+  ASSERT_TRUE(res && res->status / 100 == 2) << " GET binary output failed.";
+  pos = 0u;
+  EXPECT_EQ(RESTapi::decode_binary(res->body, pos).getCount(), 200u);
+  EXPECT_EQ(pos, res->body.size());
+
+  // a truncated frame is an error
+  snprintf(message, sizeof(message), "/network/%s/input/src", id.c_str());
+  res = client->Put(message, frame.substr(0u, 10u), RESTapi::BINARY_CONTENT_TYPE.c_str());
+  ASSERT_TRUE(res && res->status / 100 == 2);
+  vm.parse(res->body);
+  EXPECT_TRUE(vm.contains("err"));
+  // frames of a type which is not plain data, or whose count overflows
+  // count * size, are errors
+  const auto rawFrame = [](NTA_BasicType type, uint64_t count, const std::string &payload) {
+    std::string f(24u, '\0');
+    const uint32_t t = static_cast<uint32_t>(type), raw = 0u;
+    const uint64_t bytes = payload.size();
+    std::memcpy(&f[0], &t, 4u);
+    std::memcpy(&f[4], &raw, 4u);
+    std::memcpy(&f[8], &count, 8u);
+    std::memcpy(&f[16], &bytes, 8u);
+    return f + payload;
+  };
+  const std::vector<std::string> bad = {
+      rawFrame(NTA_BasicType_Str, 1u, std::string(sizeof(std::string), 'x')),
+      rawFrame(NTA_BasicType_Handle, 1u, std::string(sizeof(void *), 'x')),
+      rawFrame(NTA_BasicType_Real32, uint64_t(1) << 62, ""),
+  };
+  for (const std::string &f : bad) {
+    pos = 0u;
+    EXPECT_ANY_THROW(RESTapi::decode_binary(f, pos));
+    res = client->Put(message, f, RESTapi::BINARY_CONTENT_TYPE.c_str());
+    ASSERT_TRUE(res && res->status / 100 == 2);
+    vm.parse(res->body);
+    EXPECT_TRUE(vm.contains("err"));
+  }
+  std::string out;
+  Array str(NTA_BasicType_Str);
+  str.allocateBuffer(1u);
+  EXPECT_ANY_THROW(RESTapi::encode_binary(str, out));
+}
+TEST_F(RESTapiTest, step) {
+  char message[1000];
+  Value vm;
+
+  std::string config = R"(
+   {network: [
+       {addRegion: {name: "sp", type: "SPRegion", params: {columnCount: 20, globalInhibition: true}}},
+       {addLink:   {src: "INPUT.src", dest: "sp.bottomUpIn", dim: [10]}}
+    ]})";
+  auto res = client->Post("/network", config, "application/json");
+  ASSERT_TRUE(res && res->status / 100 == 2) << "Failed Response to POST /network request.";
+  vm.parse(res->body);
+  ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+  std::string id = vm["result"].str();
+  snprintf(message, sizeof(message), "/network/%s/step", id.c_str());
+
+  // one step
+  res = client->Post(message, R"({inputs: {src: {data: [1,0,1,0,1,0,1,0,1,0]}}, outputs: ["sp.bottomUpOut"]})",
+                     "application/json");
+  ASSERT_TRUE(res && res->status / 100 == 2) << " POST step failed.";
+  vm.parse(res->body);
+  ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+  EXPECT_EQ(vm["result"]["sp.bottomUpOut"]["type"].str(), "SDR");
+  EXPECT_EQ(vm["result"]["sp.bottomUpOut"]["dim"][0].as<UInt>(), 20u);
+
+  // a batch of records, 2 iterations each
+  res = client->Post(message, R"({records: [{src: {data: [1,0,1,0,1,0,1,0,1,0]}}, {src: {data: [0,1,0,1,0,1,0,1,0,1]}}],
+                                  outputs: ["sp.bottomUpOut"], iterations: 2})",
+                     "application/json");
+  ASSERT_TRUE(res && res->status / 100 == 2) << " POST step with records failed.";
+  vm.parse(res->body);
+  ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+  ASSERT_EQ(vm["result"].size(), 2u);
+  EXPECT_TRUE(vm["result"][1].contains("sp.bottomUpOut"));
+
+  res = client->Post(message, R"({outputs: ["sp.bottomUpOut"]})", "application/json");
+  ASSERT_TRUE(res && res->status / 100 == 2);
+  vm.parse(res->body);
+  EXPECT_TRUE(vm.contains("err"));
+}
+
+TEST_F(RESTapiTest, save_load) {
+  char message[1000];
+  Value vm;
+  const std::string store = "TestOutputDir/rest_store";
+  Directory::removeTree(store, true);
+  EXPECT_EQ(RESTapi::getInstance()->open_store(store), 0u);
+
+  std::string config = R"(
+   {network: [
+       {addRegion: {name: "sp", type: "SPRegion", params: {columnCount: 20, globalInhibition: true}}},
+       {addLink:   {src: "INPUT.src", dest: "sp.bottomUpIn", dim: [10]}}
+    ]})";
+  auto res = client->Post("/network/saved", config, "application/json");
+  ASSERT_TRUE(res && res->status / 100 == 2) << "Failed Response to POST /network request.";
+  const std::string step = R"({inputs: {src: {data: [1,0,1,0,1,0,1,0,1,0]}}, outputs: ["sp.bottomUpOut"]})";
+  res = client->Post("/network/saved/step", step, "application/json");
+  ASSERT_TRUE(res && res->status / 100 == 2);
+
+  res = client->Get("/network/saved/save?wait=true");
+  ASSERT_TRUE(res && res->status / 100 == 2) << " GET save failed.";
+  EXPECT_EQ(res->body, "{\"result\": \"OK\"}\n");
+  res = client->Post("/network/saved/step", step, "application/json");
+  ASSERT_TRUE(res && res->status / 100 == 2);
+  const std::string next = res->body;
+
+  // A restarted server finds the network in the store and loads it on first use.
+  RESTapi restarted;
+  EXPECT_EQ(restarted.open_store(store), 1u);
+  EXPECT_EQ(restarted.step_request("saved", step) + "\n", next);
+
+  // load_request() goes back to the saved state
+  res = client->Get("/network/saved/load");
+  ASSERT_TRUE(res && res->status / 100 == 2) << " GET load failed.";
+  EXPECT_EQ(res->body, "{\"result\": \"OK\"}\n");
+  res = client->Post("/network/saved/step", step, "application/json");
+  ASSERT_TRUE(res && res->status / 100 == 2);
+  EXPECT_EQ(res->body, next);
+
+  // deleting the network removes it from the store
+  res = client->Delete("/network/saved/ALL");
+  ASSERT_TRUE(res && res->status / 100 == 2);
+  RESTapi again;
+  EXPECT_EQ(again.open_store(store), 0u);
+}
+
+TEST_F(RESTapiTest, hibernation) {
+  Value vm;
+  const std::string dir = "TestOutputDir/rest_hibernation";
+  Directory::removeTree(dir, true);
+  RESTapi api;
+  api.set_hibernation(3600u, dir);  // the test hibernates itself, see hibernate_idle()
+
+  std::string config = R"(
+   {network: [
+       {addRegion: {name: "sp", type: "SPRegion", params: {columnCount: 20, globalInhibition: true}}},
+       {addLink:   {src: "INPUT.src", dest: "sp.bottomUpIn", dim: [10]}}
+    ]})";
+  const std::string step = R"({inputs: {src: {data: [1,0,1,0,1,0,1,0,1,0]}}, outputs: ["sp.bottomUpOut"]})";
+  // Two equal networks, one is hibernated between the steps.
+  EXPECT_EQ(api.create_network_request("asleep", config), "{\"result\": \"asleep\"}");
+  EXPECT_EQ(api.create_network_request("awake", config), "{\"result\": \"awake\"}");
+  EXPECT_EQ(api.step_request("asleep", step), api.step_request("awake", step));
+
+  EXPECT_EQ(api.hibernate_idle(3600u), 0u) << "Not idle for long";
+  EXPECT_EQ(api.hibernate_idle(0u), 2u);
+  EXPECT_EQ(api.hibernate_idle(0u), 0u) << "Already hibernated";
+  vm.parse(api.hibernation_request());
+  EXPECT_EQ(vm["result"]["networks"].as<int>(), 2);
+  EXPECT_EQ(vm["result"]["hibernated"].as<int>(), 2);
+  EXPECT_EQ(vm["result"]["hibernations"].as<int>(), 2);
+  EXPECT_EQ(vm["result"]["misses"]["count"].as<int>(), 0);
+
+  // Restored on the next request, in the same state.
+  const std::string awake = api.step_request("awake", step);
+  EXPECT_EQ(api.step_request("asleep", step), awake);
+  EXPECT_EQ(api.step_request("asleep", step), api.step_request("awake", step));
+  vm.parse(api.hibernation_request());
+  EXPECT_EQ(vm["result"]["hibernated"].as<int>(), 0);
+  EXPECT_EQ(vm["result"]["misses"]["count"].as<int>(), 2);
+  EXPECT_GE(vm["result"]["hits"]["count"].as<int>(), 4);
+
+  // A deleted network is not restored, its checkpoint is removed.
+  EXPECT_EQ(api.hibernate_idle(0u), 2u);
+  EXPECT_EQ(api.delete_network_request("asleep"), "{\"result\": \"OK\"}");
+  EXPECT_NE(api.step_request("asleep", step).find("err"), std::string::npos);
+  api.set_hibernation(0u, dir);
+  EXPECT_EQ(api.step_request("awake", step).find("err"), std::string::npos);
+  size_t files = 0u;
+  Iterator it(dir);
+  Entry e;
+  while (it.next(e))
+    files++;
+  EXPECT_EQ(files, 0u);
+}
+
+TEST_F(RESTapiTest, swap) {
+  Value vm;
+  std::string config = R"(
+   {network: [
+       {addRegion: {name: "sp", type: "SPRegion", params: {columnCount: 20, globalInhibition: true}}},
+       {addLink:   {src: "INPUT.src", dest: "sp.bottomUpIn", dim: [10]}}
+    ]})";
+  const std::string step = R"({inputs: {src: {data: [1,0,1,0,1,0,1,0,1,0]}}, outputs: ["sp.bottomUpOut"]})";
+
+  // The replacement, trained offline.
+  Network offline;
+  offline.configure(config);
+  offline.setInputData("src", std::vector<Real32>{0, 1, 0, 1, 0, 1, 0, 1, 0, 1});
+  offline.run(10);
+  const std::string file = "TestOutputDir/rest_swap_sp.bin";
+  offline.getRegion("sp")->saveToFile(file);
+
+  auto res = client->Post("/network/swapped", config, "application/json");
+  ASSERT_TRUE(res && res->status / 100 == 2) << "Failed Response to POST /network request.";
+  res = client->Post("/network/swapped/step", step, "application/json");
+  ASSERT_TRUE(res && res->status / 100 == 2);
+
+  res = client->Put(("/network/swapped/region/sp/swap?file=" + file).c_str(), "", "text/plain");
+  ASSERT_TRUE(res && res->status / 100 == 2) << " PUT swap failed.";
+  EXPECT_EQ(res->body, "{\"result\": \"OK\"}\n");
+
+  // Swapped in by a later run, the network is not stopped meanwhile.
+  for (int i = 0; i < 1000; i++) {
+    res = client->Post("/network/swapped/step", step, "application/json");
+    ASSERT_TRUE(res && res->status / 100 == 2);
+    res = client->Get("/network/swapped/region/sp/swap");
+    ASSERT_TRUE(res && res->status / 100 == 2);
+    vm.parse(res->body);
+    ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+    if (vm["result"].str() == "swapped")
+      break;
+    EXPECT_EQ(vm["result"].str(), "pending");
+  }
+  EXPECT_EQ(vm["result"].str(), "swapped");
+
+  // A region of another size does not fit the links.
+  std::string other = config;
+  other.replace(other.find("columnCount: 20"), 15, "columnCount: 30");
+  Network wrong;
+  wrong.configure(other);
+  wrong.run(1);
+  wrong.getRegion("sp")->saveToFile(file);
+  res = client->Put(("/network/swapped/region/sp/swap?file=" + file).c_str(), "", "text/plain");
+  ASSERT_TRUE(res && res->status / 100 == 2);
+  res = client->Get("/network/swapped/run?iterations=1");
+  ASSERT_TRUE(res && res->status / 100 == 2);
+  for (int i = 0; i < 1000; i++) {
+    res = client->Get("/network/swapped/region/sp/swap");
+    vm.parse(res->body);
+    if (vm.contains("err")) break;
+    client->Get("/network/swapped/run?iterations=1");
+  }
+  EXPECT_TRUE(vm.contains("err"));
+
+  res = client->Delete("/network/swapped/ALL");
+  ASSERT_TRUE(res && res->status / 100 == 2);
+}
+
+TEST_F(RESTapiTest, concurrent_clients) {
+  // Several clients run requests at the same time, two per network.
+  std::string config = R"(
+   {network: [
+       {addRegion: {name: "encoder", type: "RDSEEncoderRegion", params: {size: 100, sparsity: 0.1, radius: 0.03, seed: 2019}}},
+       {addRegion: {name: "sp", type: "SPRegion", params: {columnCount: 200, globalInhibition: true}}},
+       {addLink:   {src: "encoder.encoded", dest: "sp.bottomUpIn"}}
+    ]})";
+  std::vector<std::string> ids;
+  for (int i = 0; i < 3; i++) {
+    Value vm;
+    auto res = client->Post("/network", config, "application/json");
+    ASSERT_TRUE(res && res->status / 100 == 2) << "Failed Response to POST /network request.";
+    vm.parse(res->body);
+    ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+    ids.push_back(vm["result"].str());
+  }
+
+  std::atomic<int> failures{0};
+  std::vector<std::thread> clients;
+  for (size_t t = 0; t < 2 * ids.size(); t++) {
+    clients.emplace_back([&, t]() {
+      httplib::Client c(host, port);
+      char message[1000];
+      for (int i = 0; i < EPOCHS; i++) {
+        snprintf(message, sizeof(message), "/network/%s/region/encoder/param/sensedValue?data=%d", ids[t % ids.size()].c_str(), i);
+        auto res = c.Put(message, "", "application/json");
+        if (!res || res->body != "{\"result\": \"OK\"}\n") failures++;
+        snprintf(message, sizeof(message), "/network/%s/run?iterations=2", ids[t % ids.size()].c_str());
+        res = c.Get(message);
+        if (!res || res->body != "{\"result\": \"OK\"}\n") failures++;
+      }
+    });
+  }
+  for (auto &c : clients)
+    c.join();
+  EXPECT_EQ(failures, 0);
+
+  char message[1000];
+  for (const auto &id : ids) {
+    snprintf(message, sizeof(message), "/network/%s/ALL", id.c_str());
+    auto res = client->Delete(message);
+    ASSERT_TRUE(res && res->status / 100 == 2) << " DELETE ALL failed.";
+    EXPECT_EQ(res->body, "{\"result\": \"OK\"}\n");
+  }
+}
+
 TEST_F(RESTapiTest, alternative_ids) {
 
   // Client thread.
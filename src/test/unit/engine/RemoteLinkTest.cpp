@@ -0,0 +1,176 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of RemoteLink and the Remote regions tests
+ */
+
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <htm/engine/Network.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/engine/RemoteLink.hpp>
+
+#if !defined(NTA_OS_WINDOWS)
+
+namespace testing {
+
+using namespace htm;
+
+TEST(RemoteLinkTest, SendReceive) {
+  RemoteLink receiver(0u); // any free port
+  ASSERT_NE(receiver.getPort(), 0u);
+  RemoteLink sender("localhost", receiver.getPort(), 1000u);
+
+  Array in(NTA_BasicType_SDR);
+  in.allocateBuffer({10, 20});
+  Array out(NTA_BasicType_SDR);
+  out.allocateBuffer({200});
+  for (UInt i = 0; i < 10u; i++) {
+    in.getSDR().setSparse(SDR_sparse_t{i, 10u + i, 199u - i});
+    ASSERT_TRUE(sender.send(in, 1000u));
+    ASSERT_TRUE(receiver.receive(out, 1000u));
+    EXPECT_EQ(out.getSDR().getSparse(), in.getSDR().getSparse());
+  }
+  // The varint encoding: a small frame for a sparse SDR.
+  EXPECT_EQ(sender.getBytesSent(), receiver.getBytesReceived());
+  EXPECT_LT(sender.getBytesSent(), 10u * (16u + 8u + 3u * sizeof(ElemSparse)));
+
+  // Nothing sent.
+  EXPECT_FALSE(receiver.receive(out, 10u));
+
+  // Frames queue up.
+  in.getSDR().zero();
+  ASSERT_TRUE(sender.send(in, 1000u));
+  in.getSDR().setSparse(SDR_sparse_t{5u});
+  ASSERT_TRUE(sender.send(in, 1000u));
+  ASSERT_TRUE(receiver.receive(out, 1000u));
+  EXPECT_EQ(out.getSDR().getSum(), 0u);
+  ASSERT_TRUE(receiver.receive(out, 1000u));
+  EXPECT_EQ(out.getSDR().getSparse(), SDR_sparse_t{5u});
+
+  // Wrong size.
+  Array small(NTA_BasicType_SDR);
+  small.allocateBuffer({100});
+  ASSERT_TRUE(sender.send(in, 1000u));
+  EXPECT_ANY_THROW(receiver.receive(small, 1000u));
+}
+
+TEST(RemoteLinkTest, PlainData) {
+  RemoteLink receiver(0u);
+  RemoteLink sender("localhost", receiver.getPort(), 1000u);
+  Array in(NTA_BasicType_Real32);
+  in.allocateBuffer(5);
+  Real32 *p = reinterpret_cast<Real32 *>(in.getBuffer());
+  for (size_t i = 0; i < 5u; i++)
+    p[i] = 0.5f * static_cast<Real32>(i);
+  Array out(NTA_BasicType_Real32);
+  out.allocateBuffer(5);
+  ASSERT_TRUE(sender.send(in, 1000u));
+  ASSERT_TRUE(receiver.receive(out, 1000u));
+  EXPECT_EQ(out, in);
+
+  Array wrongType(NTA_BasicType_Int32);
+  wrongType.allocateBuffer(5);
+  ASSERT_TRUE(sender.send(in, 1000u));
+  EXPECT_ANY_THROW(receiver.receive(wrongType, 1000u));
+}
+
+TEST(RemoteLinkTest, NoReceiver) {
+  UInt16 port;
+  {
+    RemoteLink receiver(0u);
+    port = receiver.getPort();
+  }
+  EXPECT_ANY_THROW(RemoteLink("localhost", port, 50u));
+}
+
+TEST(RemoteLinkTest, BlockingReceiver) {
+  RemoteLink receiver(0u);
+  Array out(NTA_BasicType_SDR);
+  out.allocateBuffer({100});
+  std::thread sending([&receiver]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    RemoteLink sender("localhost", receiver.getPort(), 1000u);
+    Array in(NTA_BasicType_SDR);
+    in.allocateBuffer({100});
+    in.getSDR().setSparse(SDR_sparse_t{1u, 2u, 3u});
+    sender.send(in, 1000u);
+  });
+  ASSERT_TRUE(receiver.receive(out, 5000u));
+  sending.join();
+  EXPECT_EQ(out.getSDR().getSparse(), SDR_sparse_t({1u, 2u, 3u}));
+  // The sender is gone.
+  EXPECT_ANY_THROW(receiver.receive(out, 1000u));
+}
+
+TEST(RemoteLinkTest, Regions) {
+  // Two Networks, as if on two hosts.
+  Network receiver;
+  auto in = receiver.addRegion("in", "RemoteInputRegion", "{dim: [100]}");
+  auto delayed = receiver.addRegion("delayed", "RemoteInputRegion", "{dim: [100], propagationDelay: 2}");
+  receiver.initialize();
+  const std::string port = std::to_string(in->getParameterUInt32("port"));
+  const std::string delayedPort = std::to_string(delayed->getParameterUInt32("port"));
+
+  Network sender;
+  sender.addRegion("encoder", "ScalarEncoderRegion",
+                   "{size: 100, activeBits: 10, minValue: 0.0, maxValue: 100.0}");
+  auto out = sender.addRegion("out", "RemoteOutputRegion", "{host: localhost, port: " + port + "}");
+  sender.link("encoder", "out", "", "", "encoded", "dataIn");
+  sender.addRegion("outDelayed", "RemoteOutputRegion", "{port: " + delayedPort + "}");
+  sender.link("encoder", "outDelayed", "", "", "encoded", "dataIn");
+  sender.initialize();
+
+  std::vector<SDR_sparse_t> sent;
+  for (int i = 0; i < 6; i++) {
+    sender.getRegion("encoder")->setParameterReal64("sensedValue", 10.0 * i);
+    sender.run(1);
+    sent.push_back(sender.getRegion("encoder")->getOutputData("encoded").getSDR().getSparse());
+    receiver.run(1);
+    EXPECT_EQ(in->getOutputData("dataOut").getSDR().getSparse(), sent.back());
+    if (i < 2)
+      EXPECT_EQ(delayed->getOutputData("dataOut").getSDR().getSum(), 0u);
+    else
+      EXPECT_EQ(delayed->getOutputData("dataOut").getSDR().getSparse(), sent[i - 2]);
+  }
+  EXPECT_EQ(out->getParameterUInt64("bytesSent"), in->getParameterUInt64("bytesReceived"));
+}
+
+TEST(RemoteLinkTest, RegionsPlainData) {
+  Network receiver;
+  auto in = receiver.addRegion("in", "RemoteInputRegion", "{dataType: Real64, dim: [1]}");
+  receiver.initialize();
+  Network sender;
+  sender.addRegion("encoder", "ScalarEncoderRegion",
+                   "{activeBits: 10, minValue: 0.0, maxValue: 100.0, radius: 10.0}");
+  sender.addRegion("out", "RemoteOutputRegion",
+                   "{port: " + std::to_string(in->getParameterUInt32("port")) + ", dataType: Real64}");
+  sender.link("encoder", "out", "", "", "bucket", "dataIn");
+  sender.initialize();
+  sender.getRegion("encoder")->setParameterReal64("sensedValue", 42.0);
+  sender.run(1);
+  receiver.run(1);
+  EXPECT_EQ(in->getOutputData("dataOut").getType(), NTA_BasicType_Real64);
+  EXPECT_EQ(in->getOutputData("dataOut"), sender.getRegion("encoder")->getOutputData("bucket"));
+}
+
+} // namespace testing
+#endif // NTA_OS_WINDOWS
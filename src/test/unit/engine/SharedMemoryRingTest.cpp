@@ -0,0 +1,323 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of SharedMemoryRing and the SharedMemory regions tests
+ */
+
+#include <algorithm>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <htm/engine/Network.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/engine/SharedMemoryRing.hpp>
+
+#if !defined(NTA_OS_WINDOWS)
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace testing {
+
+using namespace htm;
+
+// Unique per test process, tests may run in parallel.
+static std::string channel(const std::string &name) {
+  return "/htm_test_" + name + "_" + std::to_string(getpid());
+}
+
+TEST(SharedMemoryRingTest, PushPop) {
+  SDR sdr({10, 20});
+  Array a(sdr);
+  SharedMemoryRing writer(channel("pushpop"), 3u, SharedMemoryRing::frameBytes(a));
+  EXPECT_EQ(writer.getSlots(), 4u); // power of 2
+  SharedMemoryRing reader(channel("pushpop"), 1000u);
+  EXPECT_EQ(reader.getSlots(), 4u);
+
+  Array in(NTA_BasicType_SDR);
+  in.allocateBuffer({10, 20});
+  Array out(NTA_BasicType_SDR);
+  out.allocateBuffer({200});
+  for (UInt i = 0; i < 10u; i++) {
+    in.getSDR().setSparse(SDR_sparse_t{i, 10u + i, 199u - i});
+    ASSERT_TRUE(writer.push(in, 1000u));
+    EXPECT_EQ(reader.size(), 1u);
+    ASSERT_TRUE(reader.pop(out, 1000u));
+    EXPECT_EQ(out.getSDR().getSparse(), in.getSDR().getSparse());
+  }
+  // Empty: the reader times out.
+  EXPECT_FALSE(reader.pop(out, 10u));
+
+  // Full: the writer times out.
+  for (UInt i = 0; i < 4u; i++)
+    ASSERT_TRUE(writer.push(in, 1000u));
+  EXPECT_FALSE(writer.push(in, 10u));
+  EXPECT_EQ(reader.size(), 4u);
+
+  // The type and size must match.
+  Array wrongSize(NTA_BasicType_SDR);
+  wrongSize.allocateBuffer({100});
+  EXPECT_ANY_THROW(reader.pop(wrongSize, 1000u));
+  Array wrongType(NTA_BasicType_Real32);
+  wrongType.allocateBuffer(200);
+  EXPECT_ANY_THROW(reader.pop(wrongType, 1000u));
+  // The mismatched Arrays are dropped, the next ones still arrive.
+  EXPECT_EQ(reader.size(), 2u);
+  ASSERT_TRUE(reader.pop(out, 1000u));
+  EXPECT_EQ(out.getSDR().getSparse(), in.getSDR().getSparse());
+  EXPECT_EQ(reader.size(), 1u);
+}
+
+TEST(SharedMemoryRingTest, PlainData) {
+  Array in(NTA_BasicType_Real64);
+  in.allocateBuffer(5);
+  SharedMemoryRing writer(channel("plain"), 2u, SharedMemoryRing::frameBytes(in));
+  SharedMemoryRing reader(channel("plain"), 1000u);
+  Real64 *values = reinterpret_cast<Real64 *>(in.getBuffer());
+  for (int i = 0; i < 5; i++)
+    values[i] = 0.5 * i;
+  ASSERT_TRUE(writer.push(in, 1000u));
+
+  Array out(NTA_BasicType_Real64);
+  out.allocateBuffer(5);
+  ASSERT_TRUE(reader.pop(out, 1000u));
+  EXPECT_EQ(out, in);
+
+  Array tooBig(NTA_BasicType_Real64);
+  tooBig.allocateBuffer(100);
+  EXPECT_ANY_THROW(writer.push(tooBig, 1000u));
+  Array str(NTA_BasicType_Str);
+  EXPECT_ANY_THROW(SharedMemoryRing::frameBytes(str));
+}
+
+TEST(SharedMemoryRingTest, NoWriter) {
+  EXPECT_ANY_THROW(SharedMemoryRing(channel("nobody"), 10u));
+  EXPECT_ANY_THROW(SharedMemoryRing("no_slash", 2u, 100u));
+}
+
+TEST(SharedMemoryRingTest, BlockingReader) {
+  Array in(NTA_BasicType_UInt32);
+  in.allocateBuffer(1);
+  SharedMemoryRing writer(channel("blocking"), 2u, SharedMemoryRing::frameBytes(in));
+  SharedMemoryRing reader(channel("blocking"), 1000u);
+  std::thread producer([&]() {
+    for (UInt32 i = 0; i < 1000u; i++) {
+      reinterpret_cast<UInt32 *>(in.getBuffer())[0] = i;
+      ASSERT_TRUE(writer.push(in, 10000u));
+    }
+  });
+  Array out(NTA_BasicType_UInt32);
+  out.allocateBuffer(1);
+  for (UInt32 i = 0; i < 1000u; i++) {
+    ASSERT_TRUE(reader.pop(out, 10000u));
+    ASSERT_EQ(reinterpret_cast<UInt32 *>(out.getBuffer())[0], i);
+  }
+  producer.join();
+}
+
+TEST(SharedMemoryRingTest, OtherProcess) {
+  SDR sdr({1000});
+  Array a(sdr);
+  const std::string name = channel("fork"); // before the child has another pid
+  SharedMemoryRing writer(name, 4u, SharedMemoryRing::frameBytes(a));
+  const pid_t child = fork();
+  ASSERT_GE(child, 0);
+  if (child == 0) {
+    // Echo the sum of each SDR back through the exit code.
+    int status = 0;
+    try {
+      SharedMemoryRing reader(name, 10000u);
+      Array out(NTA_BasicType_SDR);
+      out.allocateBuffer({1000});
+      size_t sum = 0u;
+      for (int i = 0; i < 100; i++) {
+        if (!reader.pop(out, 10000u))
+          _exit(101);
+        sum += out.getSDR().getSum();
+      }
+      status = sum == 100u * 10u ? 0 : 102;
+    } catch (...) {
+      status = 103;
+    }
+    _exit(status);
+  }
+  Random rng(7);
+  for (int i = 0; i < 100; i++) {
+    a.getSDR().randomize(0.01f, rng);
+    ASSERT_TRUE(writer.push(a, 10000u));
+  }
+  int status = -1;
+  ASSERT_EQ(waitpid(child, &status, 0), child);
+  ASSERT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(WEXITSTATUS(status), 0);
+}
+
+TEST(SharedMemoryRingTest, Broadcast) {
+  Array in(NTA_BasicType_Real64);
+  in.allocateBuffer(3);
+  Real64 *values = reinterpret_cast<Real64 *>(in.getBuffer());
+  SharedMemoryRing writer(channel("broadcast"), 4u, SharedMemoryRing::frameBytes(in), true);
+  EXPECT_TRUE(writer.isBroadcast());
+  values[0] = 1.0;
+  ASSERT_TRUE(writer.push(in, 0u));
+
+  // Both readers start with the oldest in the ring, each at its own pace.
+  SharedMemoryRing fast(channel("broadcast"), 1000u);
+  SharedMemoryRing slow(channel("broadcast"), 1000u);
+  EXPECT_TRUE(fast.isBroadcast());
+  Array out(NTA_BasicType_Real64);
+  out.allocateBuffer(3);
+  const Real64 *received = reinterpret_cast<const Real64 *>(out.getBuffer());
+  for (int i = 2; i <= 10; i++) {
+    values[0] = static_cast<Real64>(i);
+    ASSERT_TRUE(writer.push(in, 0u)); // never waits
+    ASSERT_TRUE(fast.pop(out, 0u));
+    EXPECT_EQ(received[0], static_cast<Real64>(i - 1));
+  }
+  ASSERT_TRUE(fast.pop(out, 0u));
+  EXPECT_EQ(received[0], 10.0);
+  EXPECT_FALSE(fast.pop(out, 0u));
+  EXPECT_EQ(fast.lost(), 0u);
+
+  // The slow reader lost all but the last 4.
+  EXPECT_EQ(slow.size(), 4u);
+  ASSERT_TRUE(slow.pop(out, 0u));
+  EXPECT_EQ(received[0], 7.0);
+  EXPECT_EQ(slow.lost(), 6u);
+  EXPECT_ANY_THROW(writer.pop(out, 0u));
+}
+
+TEST(SharedMemoryRingTest, BroadcastOtherProcess) {
+  // The reader checks each Array is whole while the writer overwrites the ring.
+  Array a(NTA_BasicType_UInt32);
+  a.allocateBuffer(1000);
+  const std::string name = channel("broadcast_fork");
+  SharedMemoryRing writer(name, 2u, SharedMemoryRing::frameBytes(a), true);
+  const pid_t child = fork();
+  ASSERT_GE(child, 0);
+  if (child == 0) {
+    int status = 0;
+    try {
+      SharedMemoryRing reader(name, 10000u);
+      Array out(NTA_BasicType_UInt32);
+      out.allocateBuffer(1000);
+      const UInt32 *p = reinterpret_cast<const UInt32 *>(out.getBuffer());
+      UInt32 last = 0u;
+      while (last != 100000u && status == 0) {
+        if (!reader.pop(out, 10000u))
+          _exit(101);
+        for (size_t i = 1u; i < 1000u; i++)
+          if (p[i] != p[0]) status = 102; // torn
+        if (p[0] <= last && last != 0u) status = 103; // out of order
+        last = p[0];
+      }
+    } catch (...) {
+      status = 104;
+    }
+    _exit(status);
+  }
+  UInt32 *p = reinterpret_cast<UInt32 *>(a.getBuffer());
+  for (UInt32 i = 1u; i <= 100000u; i++) {
+    std::fill(p, p + 1000u, i);
+    ASSERT_TRUE(writer.push(a, 0u));
+  }
+  int status = -1;
+  ASSERT_EQ(waitpid(child, &status, 0), child);
+  ASSERT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(WEXITSTATUS(status), 0);
+}
+
+TEST(SharedMemoryRingTest, Regions) {
+  // Two Networks, as if in two processes.
+  Network sender;
+  sender.addRegion("encoder", "ScalarEncoderRegion",
+                   "{size: 100, activeBits: 10, minValue: 0.0, maxValue: 100.0}");
+  sender.addRegion("out", "SharedMemoryOutputRegion", "{channel: " + channel("regions") + ", slots: 2}");
+  sender.link("encoder", "out", "", "", "encoded", "dataIn");
+  Network receiver;
+  auto in = receiver.addRegion("in", "SharedMemoryInputRegion",
+                               "{channel: " + channel("regions") + ", dim: [100]}");
+  auto delayed = receiver.addRegion("delayed", "SharedMemoryInputRegion",
+                                    "{channel: " + channel("regions_delay") + ", dim: [100], propagationDelay: 2}");
+  sender.addRegion("outDelayed", "SharedMemoryOutputRegion", "{channel: " + channel("regions_delay") + ", slots: 4}");
+  sender.link("encoder", "outDelayed", "", "", "encoded", "dataIn");
+  sender.initialize();
+  receiver.initialize();
+
+  std::vector<SDR_sparse_t> sent;
+  for (int i = 0; i < 6; i++) {
+    sender.getRegion("encoder")->setParameterReal64("sensedValue", 10.0 * i);
+    sender.run(1);
+    sent.push_back(sender.getRegion("encoder")->getOutputData("encoded").getSDR().getSparse());
+    receiver.run(1);
+    EXPECT_EQ(in->getOutputData("dataOut").getSDR().getSparse(), sent.back());
+    if (i < 2)
+      EXPECT_EQ(delayed->getOutputData("dataOut").getSDR().getSum(), 0u);
+    else
+      EXPECT_EQ(delayed->getOutputData("dataOut").getSDR().getSparse(), sent[i - 2]);
+  }
+}
+
+TEST(SharedMemoryRingTest, RegionsPlainData) {
+  Network sender;
+  sender.addRegion("encoder", "ScalarEncoderRegion",
+                   "{activeBits: 10, minValue: 0.0, maxValue: 100.0, radius: 10.0}");
+  sender.addRegion("out", "SharedMemoryOutputRegion", "{channel: " + channel("plainregions") + ", dataType: Real64}");
+  sender.link("encoder", "out", "", "", "bucket", "dataIn");
+  Network receiver;
+  auto in = receiver.addRegion("in", "SharedMemoryInputRegion",
+                               "{channel: " + channel("plainregions") + ", dataType: Real64, dim: [1]}");
+  sender.initialize();
+  receiver.initialize();
+  sender.getRegion("encoder")->setParameterReal64("sensedValue", 42.0);
+  sender.run(1);
+  receiver.run(1);
+  EXPECT_EQ(in->getOutputData("dataOut").getType(), NTA_BasicType_Real64);
+  EXPECT_EQ(in->getOutputData("dataOut"), sender.getRegion("encoder")->getOutputData("bucket"));
+}
+
+TEST(SharedMemoryRingTest, RegionsBroadcast) {
+  Network sender;
+  sender.addRegion("encoder", "ScalarEncoderRegion",
+                   "{size: 100, activeBits: 10, minValue: 0.0, maxValue: 100.0}");
+  auto out = sender.addRegion("out", "SharedMemoryOutputRegion",
+                              "{channel: " + channel("regionsbroadcast") + ", slots: 2, broadcast: true}");
+  sender.link("encoder", "out", "", "", "encoded", "dataIn");
+  sender.initialize();
+  EXPECT_TRUE(out->getParameterBool("broadcast"));
+
+  // Nobody reads yet, the sender does not wait.
+  std::vector<SDR_sparse_t> sent;
+  for (int i = 0; i < 5; i++) {
+    sender.getRegion("encoder")->setParameterReal64("sensedValue", 10.0 * i);
+    sender.run(1);
+    sent.push_back(sender.getRegion("encoder")->getOutputData("encoded").getSDR().getSparse());
+  }
+  Network receiver;
+  auto in = receiver.addRegion("in", "SharedMemoryInputRegion",
+                               "{channel: " + channel("regionsbroadcast") + ", dim: [100], timeout: 100}");
+  receiver.initialize();
+  receiver.run(2);
+  EXPECT_EQ(in->getOutputData("dataOut").getSDR().getSparse(), sent[4]);
+  EXPECT_EQ(in->getParameterUInt64("lost"), 0u);
+  EXPECT_ANY_THROW(receiver.run(1));
+}
+
+} // namespace testing
+#endif // NTA_OS_WINDOWS
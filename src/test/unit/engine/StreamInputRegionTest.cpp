@@ -0,0 +1,216 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the StreamInputRegion tests
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <htm/engine/Network.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/regions/StreamInputRegion.hpp>
+
+#if !defined(NTA_OS_WINDOWS)
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace testing {
+
+using namespace htm;
+
+namespace {
+  // Appends a record: its length, then the payload.
+  template <typename T> void appendRecord(std::vector<char> &stream, const std::vector<T> &values) {
+    const UInt32 bytes = static_cast<UInt32>(values.size() * sizeof(T));
+    const char *length = reinterpret_cast<const char *>(&bytes);
+    stream.insert(stream.end(), length, length + sizeof(bytes));
+    const char *payload = reinterpret_cast<const char *>(values.data());
+    stream.insert(stream.end(), payload, payload + bytes);
+  }
+
+  // Waits until the region has n records queued.
+  void waitAvailable(std::shared_ptr<Region> region, UInt32 n) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (region->getParameterUInt32("available") < n && std::chrono::steady_clock::now() < deadline)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    ASSERT_EQ(region->getParameterUInt32("available"), n);
+  }
+
+#if !defined(NTA_OS_WINDOWS)
+  int connectTo(int type, UInt32 port) {
+    const int fd = socket(AF_INET, type, 0);
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    EXPECT_EQ(connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)), 0);
+    return fd;
+  }
+#endif
+} // namespace
+
+
+TEST(StreamInputRegionTest, Source) {
+  std::atomic<int> next{0};
+  StreamInputRegion::registerSource("counter", [&next](std::vector<char> &record) {
+    if (next >= 10) return false;
+    const std::vector<Real32> values{static_cast<Real32>(next), 0.5f};
+    const char *p = reinterpret_cast<const char *>(values.data());
+    record.insert(record.end(), p, p + sizeof(Real32) * values.size());
+    next++;
+    return true;
+  });
+  {
+    Network net;
+    auto in = net.addRegion("in", "StreamInputRegion",
+                            "{transport: source, source: counter, dim: [2], batchSize: 4, queueCapacity: 8}");
+    net.initialize();
+    // 8 queued, the thread holds the rest back until there is room.
+    waitAvailable(in, 8u);
+    EXPECT_EQ(in->getParameterUInt64("dropped"), 0u);
+
+    for (int i = 0; i < 10; i++) {
+      net.run(1);
+      const Real32 *out = reinterpret_cast<const Real32 *>(in->getOutputData("dataOut").getBuffer());
+      EXPECT_EQ(out[0], static_cast<Real32>(i));
+      EXPECT_EQ(out[1], 0.5f);
+    }
+    EXPECT_EQ(in->getParameterUInt64("received"), 10u);
+    EXPECT_EQ(in->getParameterUInt32("available"), 0u);
+  }
+  StreamInputRegion::unregisterSource("counter");
+  Network net;
+  net.addRegion("in", "StreamInputRegion", "{transport: source, source: counter, dim: [2]}");
+  EXPECT_ANY_THROW(net.initialize());
+}
+
+TEST(StreamInputRegionTest, Parameters) {
+  Network net;
+  EXPECT_ANY_THROW(net.addRegion("a", "StreamInputRegion", "{transport: kafka}"));
+  EXPECT_ANY_THROW(net.addRegion("b", "StreamInputRegion", "{batchSize: 0}"));
+  EXPECT_ANY_THROW(net.addRegion("c", "StreamInputRegion", "{batchSize: 16, queueCapacity: 8}"));
+  // not plain data
+  EXPECT_ANY_THROW(net.addRegion("d", "StreamInputRegion", "{dataType: String}"));
+  EXPECT_ANY_THROW(net.addRegion("e", "StreamInputRegion", "{dataType: Handle}"));
+}
+
+TEST(StreamInputRegionTest, SdrIndices) {
+  // A good record, then one unsorted or with a duplicate index.
+  const std::vector<std::vector<UInt32>> records{{3u, 5u}, {5u, 3u}, {4u, 4u}};
+  for (size_t bad = 1u; bad < records.size(); bad++) {
+    size_t next = 0u;
+    StreamInputRegion::registerSource("indices", [&records, &next, bad](std::vector<char> &record) {
+      if (next == 2u) return false;
+      const std::vector<UInt32> &values = records[next++ == 0u ? 0u : bad];
+      const char *p = reinterpret_cast<const char *>(values.data());
+      record.insert(record.end(), p, p + sizeof(UInt32) * values.size());
+      return true;
+    });
+    Network net;
+    auto in = net.addRegion("in", "StreamInputRegion",
+                            "{transport: source, source: indices, dataType: SDR, dim: [10], timeout: 100}");
+    net.initialize();
+    net.run(1);
+    EXPECT_EQ(in->getOutputData("dataOut").getSDR().getSparse(), SDR_sparse_t({3u, 5u}));
+    EXPECT_ANY_THROW(net.run(1)) << "record " << bad;
+  }
+  StreamInputRegion::unregisterSource("indices");
+}
+
+#if !defined(NTA_OS_WINDOWS)
+
+TEST(StreamInputRegionTest, Tcp) {
+  Network net;
+  auto in = net.addRegion("in", "StreamInputRegion", "{dataType: SDR, dim: [100], timeout: 100}");
+  net.initialize();
+  const UInt32 port = in->getParameterUInt32("port");
+  ASSERT_NE(port, 0u);
+
+  std::vector<char> stream;
+  for (UInt32 i = 0; i < 5u; i++)
+    appendRecord(stream, std::vector<UInt32>{i, 50u + i});
+  appendRecord(stream, std::vector<UInt32>{});
+  int fd = connectTo(SOCK_STREAM, port);
+  // A record split over two sends.
+  ASSERT_EQ(send(fd, stream.data(), 10u, 0), 10);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ASSERT_EQ(send(fd, stream.data() + 10u, stream.size() - 10u, 0), static_cast<ssize_t>(stream.size() - 10u));
+  waitAvailable(in, 6u);
+  net.run(in->getParameterUInt32("available"));
+  EXPECT_EQ(in->getOutputData("dataOut").getSDR().getSum(), 0u);
+  EXPECT_EQ(in->getParameterUInt64("received"), 6u);
+  ::close(fd);
+
+  // The next sender.
+  fd = connectTo(SOCK_STREAM, port);
+  stream.clear();
+  appendRecord(stream, std::vector<UInt32>{7u, 99u});
+  ASSERT_EQ(send(fd, stream.data(), stream.size(), 0), static_cast<ssize_t>(stream.size()));
+  net.run(1);
+  EXPECT_EQ(in->getOutputData("dataOut").getSDR().getSparse(), SDR_sparse_t({7u, 99u}));
+
+  // Nothing sent.
+  EXPECT_ANY_THROW(net.run(1));
+  // Out of range.
+  stream.clear();
+  appendRecord(stream, std::vector<UInt32>{100u});
+  ASSERT_EQ(send(fd, stream.data(), stream.size(), 0), static_cast<ssize_t>(stream.size()));
+  EXPECT_ANY_THROW(net.run(1));
+  ::close(fd);
+}
+
+TEST(StreamInputRegionTest, Udp) {
+  Network net;
+  auto in = net.addRegion("in", "StreamInputRegion",
+                          "{transport: udp, dataType: Int32, dim: [3], batchSize: 2, queueCapacity: 6}");
+  net.initialize();
+  const int fd = connectTo(SOCK_DGRAM, in->getParameterUInt32("port"));
+  // Two datagrams of 3 records, the queue holds 3 batches: 2 + 1 of the first, 2 of the second.
+  for (Int32 d = 0; d < 2; d++) {
+    std::vector<char> datagram;
+    for (Int32 i = 0; i < 3; i++)
+      appendRecord(datagram, std::vector<Int32>{d, i, -1});
+    ASSERT_EQ(send(fd, datagram.data(), datagram.size(), 0), static_cast<ssize_t>(datagram.size()));
+  }
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (in->getParameterUInt64("received") + in->getParameterUInt64("dropped") < 6u &&
+         std::chrono::steady_clock::now() < deadline)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  EXPECT_EQ(in->getParameterUInt64("received"), 5u);
+  EXPECT_EQ(in->getParameterUInt64("dropped"), 1u);
+  net.run(5);
+  const Int32 *out = reinterpret_cast<const Int32 *>(in->getOutputData("dataOut").getBuffer());
+  EXPECT_EQ(out[0], 1);
+  EXPECT_EQ(out[1], 1);
+  EXPECT_EQ(out[2], -1);
+  ::close(fd);
+}
+
+#endif // NTA_OS_WINDOWS
+
+} // namespace testing
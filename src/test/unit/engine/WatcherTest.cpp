@@ -255,4 +255,40 @@ TEST(WatcherTest, FileTest2) {
 
   Path::remove("TestOutputDir/testfile2");
 }
-}
\ No newline at end of file
+TEST(WatcherTest, BinarySampled) {
+  Network n;
+  n.addRegion("level1", "TestNode", "{dim: [4,2]}");
+  n.initialize();
+  Directory::create("TestOutputDir");
+
+  {
+    Watcher w("TestOutputDir/watcher.bin", Watcher::BINARY, 2u);
+    w.watchParam("level1", "int32Param");
+    w.watchParam("level1", "stringParam");
+    w.watchParam("level1", "int64ArrayParam");
+    w.watchOutput("level1", "bottomUpOut");
+    w.attachToNetwork(n);
+    n.run(5); // records iterations 2 and 4
+    w.detachFromNetwork(n);
+  } // closes the file
+
+  Watcher::toCSV("TestOutputDir/watcher.bin", "TestOutputDir/watcher.csv");
+  std::ifstream csv("TestOutputDir/watcher.csv");
+  std::vector<std::string> lines;
+  for (std::string line; getline(csv, line);)
+    lines.push_back(line);
+  for (const auto &line : lines)
+    VERBOSE << line << "\n";
+  ASSERT_EQ(lines.size(), 1u + 2u * 4u);
+  EXPECT_EQ(lines[0], "iteration,watchID,name,type,size,values");
+  EXPECT_EQ(lines[1], "2,1,level1.int32Param,Int32,1,32");
+  EXPECT_EQ(lines[2], "2,2,level1.stringParam,String,14,\"nodespec value\"");
+  EXPECT_EQ(lines[3], "2,3,level1.int64ArrayParam,Int64,4,0 64 128 192");
+  EXPECT_EQ(lines[4].substr(0, 32), "2,4,level1.bottomUpOut,Real64,8,");
+  EXPECT_EQ(lines[5].substr(0, 2), "4,");
+  EXPECT_EQ(lines[8].substr(0, 4), "4,4,");
+
+  Path::remove("TestOutputDir/watcher.bin");
+  Path::remove("TestOutputDir/watcher.csv");
+}
+} // namespace testing
@@ -686,6 +686,78 @@ TEST_F(ArrayTest, testArrayBaseSerialization) {
   }
 }
 
+TEST_F(ArrayTest, testJSONCodec) {
+  setupArrayTests();
+
+  SDR_sparse_t testdata = {1, 4, 5, 8, 9}; // sparse
+  for (auto testCase = testCases_.begin(); testCase != testCases_.end(); testCase++) {
+    if (testCase->second.testUsesInvalidParameters) {
+      continue;
+    }
+    NTA_BasicType type = testCase->second.dataType;
+    size_t count = static_cast<size_t>(testCase->second.allocationSize);
+    Array a(type);
+    populateArray(testdata, count, a);
+    const std::string json = a.toJSON();
+
+    // Just the data, into an Array of the type.
+    Array b(type);
+    if (type == NTA_BasicType_SDR)
+      b = Array(SDR({(UInt)count}));
+    b.fromJSON(json);
+    SDR_sparse_t results;
+    toSparse(b, results);
+    EXPECT_EQ(testdata, results) << testCase->first << " " << json;
+    EXPECT_EQ(json, b.toJSON());
+
+    // With the type.
+    std::string typeStr = BasicType::getName(type);
+    if (type == NTA_BasicType_SDR)
+      typeStr = "SDR(" + std::to_string(count) + ")";
+    Array c;
+    c.fromJSON("{\"type\": \"" + typeStr + "\", \"data\": " + json + "}");
+    EXPECT_EQ(type, c.getType());
+    toSparse(c, results);
+    EXPECT_EQ(testdata, results) << testCase->first;
+  }
+
+  // Numbers read back the same value.
+  std::vector<Real64> reals = {0.1, 1.0 / 3.0, -2.5e-300, 1e20, 0.0};
+  Array r(NTA_BasicType_Real64, reals.data(), reals.size());
+  EXPECT_EQ(r.toJSON(), "[0.1, 0.3333333333333333, -2.5e-300, 1e+20, 0]");
+  Array r2(NTA_BasicType_Real64);
+  r2.fromJSON(r.toJSON());
+  EXPECT_EQ(reals, r2.asVector<Real64>());
+  Array bytes(NTA_BasicType_Byte);
+  bytes.fromJSON("[-128, 0, 127]");
+  EXPECT_EQ(bytes.toJSON(), "[-128, 0, 127]");
+
+  // Strings with escapes, in any order of the keys.
+  Array s;
+  s.fromJSON("{\"data\": [\"a \\\"b\\\"\\n\", \"\\u00e9]\", null], \"type\": \"Str\"}");
+  ASSERT_EQ(s.getCount(), 3u);
+  EXPECT_EQ(((std::string *)s.getBuffer())[0], "a \"b\"\n");
+  EXPECT_EQ(((std::string *)s.getBuffer())[1], "\xc3\xa9]");
+  EXPECT_EQ(((std::string *)s.getBuffer())[2], "");
+
+  // An SDR with its dimensions, sparse or dense.
+  Array sdr;
+  sdr.fromJSON("{\"type\": \"SDR\", \"dim\": [2, 3], \"data\": [1, 5]}");
+  EXPECT_EQ(sdr.getSDR().dimensions, std::vector<UInt>({2u, 3u}));
+  EXPECT_EQ(sdr.getSDR().getSparse(), SDR_sparse_t({1u, 5u}));
+  sdr.fromJSON("{\"data\": [0, 1, 1, 0, 0, 0]}");
+  EXPECT_EQ(sdr.getSDR().dimensions, std::vector<UInt>({2u, 3u}));
+  EXPECT_EQ(sdr.getSDR().getSparse(), SDR_sparse_t({1u, 2u}));
+
+  // YAML goes to fromYAML(), errors throw.
+  Array y;
+  y.fromJSON("type: Int32\ndata:\n  - 1\n  - 2\n");
+  EXPECT_EQ(y.toJSON(), "[1, 2]");
+  Array u(NTA_BasicType_UInt32);
+  EXPECT_ANY_THROW(u.fromJSON("[1, 2"));
+  EXPECT_ANY_THROW(u.fromJSON("{\"type\": \"Nonsense\", \"data\": [1]}"));
+}
+
 void ArrayTest::setupArrayTests() {
   // we're going to test using all types that can be stored in the ArrayBase...
   // the NTA_BasicType enum overrides the default incrementing values for
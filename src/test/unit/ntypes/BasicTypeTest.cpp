@@ -20,6 +20,7 @@
  */
 
 #include <limits>
+#include <vector>
 
 #include <gtest/gtest.h>
 #include <htm/ntypes/BasicType.hpp>
@@ -591,4 +592,24 @@ TEST(BasicTypeTest, convertArray) {
                           NTA_BasicType_Bool, 8);
   ASSERT_TRUE(ca.checkArrayBool<bool>(ca.dest)) << "bool to bool conversion";
 }
+
+TEST(BasicTypeTest, convertArrayLarge) {
+  // long enough for the vectorized loops, with a bad value in the middle
+  std::vector<Real32> from(1000u);
+  for (size_t i = 0; i < from.size(); i++) from[i] = static_cast<Real32>(i % 200u);
+  std::vector<UInt16> to(from.size());
+  BasicType::convertArray(to.data(), NTA_BasicType_UInt16, from.data(), NTA_BasicType_Real32, from.size());
+  for (size_t i = 0; i < from.size(); i++) ASSERT_EQ(to[i], static_cast<UInt16>(i % 200u));
+
+  std::vector<Real32> same(from.size());
+  BasicType::convertArray(same.data(), NTA_BasicType_Real32, from.data(), NTA_BasicType_Real32, from.size());
+  EXPECT_EQ(same, from);
+
+  from[517] = -1.0f;
+  EXPECT_THROW(BasicType::convertArray(to.data(), NTA_BasicType_UInt16, from.data(), NTA_BasicType_Real32, from.size()),
+               htm::Exception);
+  from[517] = std::numeric_limits<Real32>::quiet_NaN();
+  EXPECT_THROW(BasicType::convertArray(to.data(), NTA_BasicType_UInt16, from.data(), NTA_BasicType_Real32, from.size()),
+               htm::Exception);
+}
 }
@@ -26,6 +26,7 @@
 
 #include <map>
 #include <sstream>
+#include <thread>
 #include <vector>
 
 namespace testing {
@@ -469,4 +470,51 @@ TEST(ValueTest, from_Array) {
   }
 }
 
+TEST(ValueTest, parseTree) {
+  // The parser links nodes directly into the tree; the result must be the
+  // same as building it with operator[] and operator=.
+  ValueMap vm;
+  vm.parse("{a: 1, b: [x, [y, z], {c: 2}], d: {e: {f: 3}}, g: {}, h: [], i: {j: {}}, a: 4}");
+  EXPECT_TRUE(vm.check());
+  EXPECT_STREQ("{\"a\": 4, \"b\": [\"x\", [\"y\", \"z\"], {\"c\": 2}], \"d\": {\"e\": {\"f\": 3}}}",
+               vm.to_json().c_str());
+  EXPECT_FALSE(vm.contains("g"));
+  EXPECT_FALSE(vm.contains("i"));
+  EXPECT_TRUE(vm["b"].isSequence());
+  EXPECT_EQ(vm["b"][1].key(), "1");
+  EXPECT_EQ(vm["b"][2]["c"].as<int>(), 2);
+
+  ValueMap built;
+  built["a"] = 4;
+  built["b"][0] = "x";
+  built["b"][1][0] = "y";
+  built["b"][1][1] = "z";
+  built["b"][2]["c"] = 2;
+  built["d"]["e"]["f"] = 3;
+  EXPECT_TRUE(vm == built);
+
+  EXPECT_EQ(Value::json_string("-1.5"), "-1.5");
+  EXPECT_EQ(Value::json_string("+3"), "+3");
+  EXPECT_EQ(Value::json_string("1."), "\"1.\"");
+  EXPECT_EQ(Value::json_string(".5"), "\".5\"");
+  EXPECT_EQ(Value::json_string("12a"), "\"12a\"");
+
+  // A tree parsed in one thread is independent of trees in other threads.
+  std::vector<std::thread> threads;
+  std::vector<std::string> results(4);
+  for (size_t t = 0; t < results.size(); t++) {
+    threads.emplace_back([t, &results]() {
+      for (int n = 0; n < 100; n++) {
+        ValueMap v;
+        v.parse("{region: {dim: [" + std::to_string(t) + ", 2]}, params: {k: v}}");
+        results[t] = v.to_json();
+      }
+    });
+  }
+  for (auto &th : threads) th.join();
+  for (size_t t = 0; t < results.size(); t++) {
+    EXPECT_EQ(results[t], "{\"region\": {\"dim\": [" + std::to_string(t) + ", 2]}, \"params\": {\"k\": \"v\"}}");
+  }
+}
+
 } // namespace testing
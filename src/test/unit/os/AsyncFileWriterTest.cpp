@@ -0,0 +1,75 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Unit tests for AsyncFileWriter
+ */
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <htm/os/AsyncFileWriter.hpp>
+#include <htm/os/Path.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+static std::string readAll(const std::string &path) {
+  std::ifstream in(path, std::ios_base::binary);
+  std::stringstream ss;
+  ss << in.rdbuf();
+  return ss.str();
+}
+
+TEST(AsyncFileWriterTest, WriteFlushClose) {
+  const std::string path = "AsyncFileWriterTest.tmp";
+  std::string expected;
+  {
+    AsyncFileWriter writer(path, false, 64u); // small, so the thread swaps often
+    for (int i = 0; i < 1000; i++) {
+      const std::string line = std::to_string(i) + "\n";
+      writer.write(line);
+      expected += line;
+      if (i == 500) {
+        writer.flush();
+        EXPECT_EQ(readAll(path), expected);
+      }
+    }
+    writer.close();
+    writer.close(); // no-op
+    EXPECT_ANY_THROW(writer.write("x"));
+  }
+  EXPECT_EQ(readAll(path), expected);
+
+  {
+    AsyncFileWriter writer(path); // appends
+    writer.write("tail");
+  } // destructor writes the rest
+  EXPECT_EQ(readAll(path), expected + "tail");
+
+  Path::remove(path);
+}
+
+TEST(AsyncFileWriterTest, OpenFailure) {
+  EXPECT_ANY_THROW(AsyncFileWriter("no_such_dir/AsyncFileWriterTest.tmp"));
+}
+
+} // namespace testing
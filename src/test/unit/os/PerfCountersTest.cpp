@@ -0,0 +1,79 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/**
+ * @file
+ */
+#include <gtest/gtest.h>
+#include <htm/os/PerfCounters.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+namespace {
+  volatile UInt64 sink;
+  void work(UInt n) {
+    UInt64 x = 0u;
+    for (UInt i = 0u; i < n; i++) x += i * i;
+    sink = x;
+  }
+}
+
+// The counters may not be available (permissions, VM without a PMU), then
+// everything reads 0, which is all that can be tested.
+TEST(PerfCountersTest, Basic) {
+  PerfCounters c;
+  EXPECT_FALSE(c.isStarted());
+  EXPECT_EQ(c.get(PerfCounters::INSTRUCTIONS), 0u);
+  EXPECT_EQ(c.toJSON(), "{}");
+
+  c.start();
+  EXPECT_TRUE(c.isStarted());
+  work(100000u);
+  c.stop();
+  EXPECT_FALSE(c.isStarted());
+
+  if (!c.isAvailable(PerfCounters::INSTRUCTIONS)) {
+    EXPECT_EQ(c.get(PerfCounters::INSTRUCTIONS), 0u);
+    GTEST_SKIP() << "Hardware counters are not available.";
+  }
+  const UInt64 first = c.get(PerfCounters::INSTRUCTIONS);
+  EXPECT_GT(first, 100000u);
+  EXPECT_NE(c.toJSON().find("\"instructions\": "), std::string::npos);
+
+  // accumulates
+  c.start();
+  work(100000u);
+  c.stop();
+  EXPECT_GT(c.get(PerfCounters::INSTRUCTIONS), first);
+
+  const PerfCounters copy(c);
+  EXPECT_EQ(copy.get(PerfCounters::INSTRUCTIONS), c.get(PerfCounters::INSTRUCTIONS));
+
+  c.reset();
+  EXPECT_EQ(c.get(PerfCounters::INSTRUCTIONS), 0u);
+}
+
+TEST(PerfCountersTest, Names) {
+  EXPECT_STREQ(PerfCounters::getName(PerfCounters::CYCLES), "cycles");
+  EXPECT_STREQ(PerfCounters::getName(PerfCounters::INSTRUCTIONS), "instructions");
+  EXPECT_STREQ(PerfCounters::getName(PerfCounters::CACHE_MISSES), "cacheMisses");
+  EXPECT_STREQ(PerfCounters::getName(PerfCounters::BRANCH_MISSES), "branchMisses");
+}
+
+} // namespace testing
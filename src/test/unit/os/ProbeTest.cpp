@@ -0,0 +1,87 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/**
+ * @file
+ */
+
+// HTM_PROBE is compiled into this file.
+#define HTM_PROBES
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <htm/os/Probe.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+namespace {
+  const ProbeStats &find(const std::vector<ProbeStats> &stats, const std::string &name) {
+    for (const auto &s : stats)
+      if (s.name == name) return s;
+    static const ProbeStats none;
+    return none;
+  }
+
+  void probed() {
+    HTM_PROBE("ProbeTest::probed");
+  }
+}
+
+TEST(ProbeTest, Calibration) {
+  EXPECT_GT(TscClock::ticksPerSecond(), 1.0e6);
+  const UInt64 t0 = TscClock::now();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  const Real64 seconds = TscClock::toSeconds(TscClock::now() - t0);
+  EXPECT_GT(seconds, 0.045);
+  EXPECT_LT(seconds, 0.5);
+}
+
+TEST(ProbeTest, ScopedTimer) {
+  static Probe probe("ProbeTest.ScopedTimer");
+  Probe::reset();
+  for (int i = 0; i < 3; i++) {
+    ScopedTimer timer(probe);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  const ProbeStats s = find(Probe::snapshot(), "ProbeTest.ScopedTimer");
+  EXPECT_EQ(s.calls, 3u);
+  EXPECT_GE(s.meanSeconds(), 0.0019);
+  EXPECT_LE(s.minTicks, s.maxTicks);
+  EXPECT_GE(s.ticks, 3u * s.minTicks);
+  EXPECT_NE(Probe::report().find("ProbeTest.ScopedTimer"), std::string::npos);
+
+  Probe::reset();
+  EXPECT_EQ(find(Probe::snapshot(), "ProbeTest.ScopedTimer").calls, 0u);
+}
+
+TEST(ProbeTest, ThreadsMerge) {
+  probed(); // creates the probe
+  Probe::reset();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++)
+    threads.emplace_back([]() { for (int i = 0; i < 1000; i++) probed(); });
+  for (int i = 0; i < 500; i++) probed();
+  for (auto &t : threads) t.join();
+  // The counters of the threads which exited are kept.
+  EXPECT_EQ(find(Probe::snapshot(), "ProbeTest::probed").calls, 4500u);
+}
+
+} // namespace testing
@@ -0,0 +1,110 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Test of the AggregatorRegion.
+ */
+
+#include <cmath>
+#include <vector>
+
+#include <htm/regions/AggregatorRegion.hpp>
+#include <htm/engine/Network.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/ntypes/Array.hpp>
+
+#include "gtest/gtest.h"
+
+using namespace htm;
+namespace testing
+{
+
+  TEST(AggregatorRegionTest, windowOfRecords)
+  {
+    Network net;
+    std::shared_ptr<Region> agg = net.addRegion("agg", "AggregatorRegion", "{windowSize: 3}");
+    std::shared_ptr<Region> enc = net.addRegion("enc", "MultiEncoderRegion",
+        "{resolutions: '1, 1', size: 100, activeBits: 10, seed: 1}");
+    net.link("INPUT", "agg", "", "{dim: 2}", "value", "values");
+    net.link("agg", "enc", "", "", "values", "values");
+    net.initialize();
+    ASSERT_EQ(agg->getParameterString("operation"), "mean");
+
+    const std::vector<std::vector<Real64>> records = {
+        {1, 10}, {2, NAN}, {6, 40},  {3, NAN}, {3, NAN}, {3, NAN}};
+    for (size_t i = 0; i < records.size(); i++) {
+      net.setInputData("value", Array(records[i]));
+      net.run(1);
+      const Real64 *out = static_cast<const Real64 *>(agg->getOutputData("values").getBuffer());
+      if (i == 2) {
+        EXPECT_DOUBLE_EQ(out[0], 3.0);
+        EXPECT_DOUBLE_EQ(out[1], 25.0);  // NaN left out
+      }
+      if (i == 5) {
+        EXPECT_DOUBLE_EQ(out[0], 3.0);
+        EXPECT_TRUE(std::isnan(out[1]));
+      }
+    }
+    EXPECT_EQ(agg->getParameterUInt64("windows"), 2u);
+    EXPECT_EQ(agg->getSkippedComputes(), 0u);
+    // The encoder computed once per window.
+    EXPECT_EQ(enc->getSkippedComputes(), 4u);
+  }
+
+
+  TEST(AggregatorRegionTest, windowOfTime)
+  {
+    Network net;
+    std::shared_ptr<Region> agg = net.addRegion("agg", "AggregatorRegion",
+        "{operation: max, windowSeconds: 60}");
+    net.link("INPUT", "agg", "", "{dim: 1}", "value", "values");
+    net.link("INPUT", "agg", "", "{dim: 1}", "time", "timestamp");
+    net.initialize();
+
+    const std::vector<Int64> times = {100, 130, 179, 180, 200, 300, 301};
+    const std::vector<Real64> values = {5, 7, 2, 1, -4, 9, 0};
+    std::vector<Int64> starts;
+    std::vector<Real64> maxima;
+    for (size_t i = 0; i < times.size(); i++) {
+      net.setInputData("value", Array(std::vector<Real64>{values[i]}));
+      net.setInputData("time", Array(std::vector<Int64>{times[i]}));
+      net.run(1);
+      if (!agg->getOutput("values")->isHeld()) {
+        starts.push_back(static_cast<const Int64 *>(agg->getOutputData("timestamp").getBuffer())[0]);
+        maxima.push_back(static_cast<const Real64 *>(agg->getOutputData("values").getBuffer())[0]);
+      }
+    }
+    // [60, 120) closes at 130, [120, 180) at 180, [180, 240) at 300.
+    EXPECT_EQ(starts, std::vector<Int64>({60, 120, 180}));
+    EXPECT_EQ(maxima, std::vector<Real64>({5, 7, 1}));
+    EXPECT_EQ(agg->getParameterUInt64("windows"), 3u);
+  }
+
+
+  TEST(AggregatorRegionTest, badParameters)
+  {
+    Network net;
+    EXPECT_ANY_THROW(net.addRegion("none", "AggregatorRegion", "{}"));
+    EXPECT_ANY_THROW(net.addRegion("both", "AggregatorRegion", "{windowSize: 2, windowSeconds: 60}"));
+    EXPECT_ANY_THROW(net.addRegion("op", "AggregatorRegion", "{operation: median, windowSize: 2}"));
+
+    net.addRegion("time", "AggregatorRegion", "{windowSeconds: 60}");
+    net.link("INPUT", "time", "", "{dim: 1}", "value", "values");
+    EXPECT_ANY_THROW(net.initialize());  // no timestamp
+  }
+
+} // namespace testing
@@ -33,6 +33,8 @@
  *     EXPECT_THROW(statement, exception_type) -- nonfatal exception, cought and continues.
  *---------------------------------------------------------------------
  */
+#include <algorithm>
+
 #include <htm/engine/Input.hpp>
 #include <htm/engine/Link.hpp>
 #include <htm/engine/Network.hpp>
@@ -53,7 +55,7 @@
   std::cerr << "[          ] "
 static bool verbose = true; // turn this on to print extra stuff for debugging the test.
 
-const UInt EXPECTED_SPEC_COUNT = 1u; // The number of parameters expected in the ClassifierRegion Spec
+const UInt EXPECTED_SPEC_COUNT = 2u; // The number of parameters expected in the ClassifierRegion Spec
 
 using namespace htm;
 namespace testing {
@@ -186,6 +188,33 @@ TEST(ClassifierRegionTest, asRealDecoder) {
             << pdf[predicted] << std::endl;
     EXPECT_NEAR(titles[predicted], +0.8, 0.1);
     EXPECT_NEAR(pdf[predicted], 0.576886, 0.003);
+
+    // The titles are sorted, the pdf follows them.
+    const size_t count = classifier->getOutputData("titles").getCount();
+    EXPECT_TRUE(std::is_sorted(titles, titles + count));
+
+    // topK: the most likely first.
+    const Real64 best = pdf[predicted];
+    const Real64 bestTitle = titles[predicted];
+    classifier->setParameterUInt32("topK", 3u);
+    net.run(1);
+    ASSERT_EQ(classifier->getOutputData("pdf").getCount(), 3u);
+    const Real64 *top = reinterpret_cast<const Real64 *>(classifier->getOutputData("pdf").getBuffer());
+    const Real64 *topTitles = reinterpret_cast<const Real64 *>(classifier->getOutputData("titles").getBuffer());
+    EXPECT_EQ(classifier->getOutputData("predicted").item<UInt32>(0), 0u);
+    EXPECT_NEAR(top[0], best, 1e-6);
+    EXPECT_EQ(topTitles[0], bestTitle);
+    EXPECT_GE(top[0], top[1]);
+    EXPECT_GE(top[1], top[2]);
+
+    // And back to the full pdf.
+    classifier->setParameterUInt32("topK", 0u);
+    net.run(1);
+    EXPECT_EQ(classifier->getOutputData("titles").getCount(), count);
+    titles = reinterpret_cast<const Real64 *>(classifier->getOutputData("titles").getBuffer());
+    EXPECT_TRUE(std::is_sorted(titles, titles + count));
+    predicted = classifier->getOutputData("predicted").item<UInt32>(0);
+    EXPECT_EQ(titles[predicted], bestTitle);
   }
 }
 
@@ -253,6 +282,13 @@ TEST(ClassifierRegionTest, getSpecJSON) {
       "count": 1,
       "access": "ReadWrite",
       "defaultValue": "true"
+    },
+    "topK": {
+      "description": "if > 0, pdf and titles are only the k most likely buckets, most likely first",
+      "type": "UInt32",
+      "count": 1,
+      "access": "ReadWrite",
+      "defaultValue": "0"
     }
   },
   "inputs": {
@@ -275,7 +311,7 @@ TEST(ClassifierRegionTest, getSpecJSON) {
   },
   "outputs": {
     "pdf": {
-      "description": "probability distribution function (pdf) for each category or bucket. Sorted by title.  Warning, buffer length will grow.",
+      "description": "probability distribution function (pdf) for each category or bucket. Sorted by title, or the topK most likely.  Warning, buffer length will grow.",
       "type": "Real64",
       "count": 0,
       "regionLevel": 1,
@@ -303,7 +339,7 @@ TEST(ClassifierRegionTest, getSpecJSON) {
 }
 
 TEST(ClassifierRegionTest, getParameters) {
-  std::string expected = "{\n  \"learn\": true\n}";
+  std::string expected = "{\n  \"learn\": true,\n  \"topK\": 0\n}";
   Network net1;
   std::shared_ptr<Region> region1 = net1.addRegion("classifier", "ClassifierRegion", "{\"learn\": true}");
   std::string json = region1->getParameters();
@@ -29,6 +29,7 @@
 #include <htm/utils/Log.hpp>
 #include <htm/ntypes/Value.hpp>
 #include <htm/regions/DatabaseRegion.hpp>
+#include <htm/os/Directory.hpp>
 
 namespace testing {
 
@@ -111,6 +112,28 @@ TEST(DatabaseRegionTest, getSpecJSON) {
       "count": 1,
       "access": "ReadWrite",
       "defaultValue": ""
+    },
+    "batchSize": {
+      "description": "Number of iterations written in one transaction. The transaction is committed when it is full. 0 commits only on 'commitTransaction', 'commitInterval' or when the file is closed.",
+      "type": "UInt32",
+      "count": 1,
+      "access": "ReadWrite",
+      "defaultValue": "1000"
+    },
+    "commitInterval": {
+      "description": "Seconds after which the active transaction is committed, even if it holds less than 'batchSize' iterations. 0 turns the time limit off.",
+      "type": "Real64",
+      "count": 1,
+      "access": "ReadWrite",
+      "defaultValue": "0"
+    },
+    "walMode": {
+      "description": "Use write-ahead logging with asynchronous commits (PRAGMA synchronous=NORMAL). Faster and readers do not block writing, but the last transactions may be lost on a power failure.",
+      "type": "Bool",
+      "count": 1,
+      "access": "ReadWrite",
+      "constraints": "bool",
+      "defaultValue": "false"
     }
   },
   "commands": {
@@ -210,11 +233,57 @@ TEST(DatabaseRegionTest, getSpecJSON) {
 } // namespace testing
 
 TEST(DatabaseRegionTest, getParameters) {
-  std::string expected = "{\n  \"outputFile\": \":memory:\"\n}";
+  std::string expected = "{\n  \"outputFile\": \":memory:\",\n  \"batchSize\": 1000,\n"
+                         "  \"commitInterval\": 0.000000,\n  \"walMode\": false\n}";
   Network net1;
   std::string output_file = ":memory:"; // in memory for this unit test. or could be physical file like: NapiOutputDir/Output.db
   std::shared_ptr<Region> region1 = net1.addRegion("db", "DatabaseRegion", "{outputFile: '" + output_file + "'}");
   std::string json = region1->getParameters();
   EXPECT_STREQ(json.c_str(), expected.c_str());
 }
+
+// counts the committed rows of one stream, as seen by another connection
+static int committedRows(const std::string &file) {
+  sqlite3 *db = nullptr;
+  sqlite3_stmt *stmt = nullptr;
+  int count = -1;
+  if (sqlite3_open_v2(file.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK
+      && sqlite3_prepare_v2(db, "SELECT COUNT(*) FROM dataStream_dataIn0;", -1, &stmt, nullptr) == SQLITE_OK
+      && sqlite3_step(stmt) == SQLITE_ROW)
+    count = sqlite3_column_int(stmt, 0);
+  sqlite3_finalize(stmt);
+  sqlite3_close(db);
+  return count;
+}
+
+TEST(DatabaseRegionTest, batchedCommits) {
+  if (!Directory::exists("TestOutputDir")) Directory::create("TestOutputDir", false, true);
+  const std::string file = "TestOutputDir/DatabaseRegionTest.db";
+
+  Network net;
+  auto encoder = net.addRegion("encoder", "RDSEEncoderRegion", "{size: 100, sparsity: 0.1, radius: 0.1, seed: 42}");
+  auto output  = net.addRegion("output", "DatabaseRegion",
+                               "{outputFile: '" + file + "', batchSize: 5, walMode: true}");
+  net.link("encoder", "output", "", "", "bucket", "dataIn0");
+  net.initialize();
+  EXPECT_TRUE(output->getParameterBool("walMode"));
+
+  for (int i = 0; i < 12; i++) {
+    encoder->setParameterReal64("sensedValue", 0.1 * i);
+    net.run(1);
+  }
+  // a full batch is committed when the next iteration starts; 2 rows are pending
+  EXPECT_EQ(committedRows(file), 10);
+  EXPECT_EQ(output->executeCommand({ "getRowCount" }), "12");
+
+  output->setParameterUInt32("batchSize", 0u); // commit only on request
+  net.run(3);
+  EXPECT_EQ(committedRows(file), 10);
+  output->executeCommand({ "commitTransaction" });
+  EXPECT_EQ(committedRows(file), 15);
+
+  output->executeCommand({ "closeFile" });
+  EXPECT_ANY_THROW(net.run(1)) << "no file open";
+  Directory::removeTree("TestOutputDir", true);
+}
 } // testing namespace
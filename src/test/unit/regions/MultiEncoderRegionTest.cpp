@@ -0,0 +1,77 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Test of the MultiEncoderRegion plug-in. The MultiEncoder itself is tested
+ * by MultiEncoderTest.
+ */
+
+#include <htm/regions/MultiEncoderRegion.hpp>
+#include <htm/engine/Network.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/ntypes/Array.hpp>
+
+#include "gtest/gtest.h"
+
+using namespace htm;
+namespace testing
+{
+
+  TEST(MultiEncoderRegionTest, encodesAllFields)
+  {
+    Network net;
+    std::shared_ptr<Region> region1 = net.addRegion("region1", "MultiEncoderRegion",
+        "{resolutions: '0.5, 1, 10', size: 100, activeBits: 10, seed: 42}");
+    net.link("INPUT", "region1", "", "{dim: 3}", "app_source", "values");
+    net.initialize();
+
+    ASSERT_EQ(region1->getParameterString("resolutions"), "0.5, 1, 10");
+    ASSERT_EQ(region1->getParameterUInt32("size"), 100u);
+    ASSERT_EQ(region1->getParameterUInt32("numThreads"), 1u);
+
+    const std::vector<Real64> record = {3.5, -20.0, 1000.0};
+    net.setInputData("app_source", Array(record));
+    net.run(1);
+    const SDR &output = region1->getOutputData("encoded").getSDR();
+    ASSERT_EQ(output.size, 300u);
+
+    // Same as one RDSE per field, with seeds 42, 43, 44.
+    RDSE_Parameters p;
+    p.size = 100u;
+    p.activeBits = 10u;
+    const Real resolutions[] = {0.5f, 1.0f, 10.0f};
+    for (UInt field = 0; field < 3u; field++) {
+      p.resolution = resolutions[field];
+      p.seed = 42u + field;
+      RandomDistributedScalarEncoder rdse(p);
+      SDR expected(rdse.dimensions);
+      rdse.encode(record[field], expected);
+      SDR_sparse_t bits;
+      for (const auto bit : output.getSparse()) {
+        if (bit >= field * 100u && bit < (field + 1u) * 100u) bits.push_back(bit - field * 100u);
+      }
+      EXPECT_EQ(bits, expected.getSparse()) << "field " << field;
+    }
+
+    region1->setParameterUInt32("numThreads", 2u);
+    ASSERT_EQ(region1->getParameterUInt32("numThreads"), 2u);
+    SDR serial(output);
+    net.run(1);
+    EXPECT_EQ(region1->getOutputData("encoded").getSDR(), serial);
+  }
+
+} // namespace testing
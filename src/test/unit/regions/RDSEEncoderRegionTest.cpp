@@ -52,7 +52,7 @@
 #define VERBOSE if(verbose)std::cerr << "[          ] "
 static bool verbose = false;  // turn this on to print extra stuff for debugging the test.
 
-const UInt EXPECTED_SPEC_COUNT =  9u;  // The number of parameters expected in the RDSERegion Spec
+const UInt EXPECTED_SPEC_COUNT =  10u;  // The number of parameters expected in the RDSERegion Spec
 
 using namespace htm;
 namespace testing 
@@ -223,6 +223,39 @@ namespace testing
   }
 
 
+  TEST(RDSEEncoderRegionTest, testDelta) {
+    Network net;
+    std::shared_ptr<Region> region1 = net.addRegion("region1", "RDSEEncoderRegion",
+                    "{size: 100, activeBits: 10, resolution: 1, seed: 42, delta: difference}");
+    EXPECT_EQ(region1->getParameterString("delta"), "difference");
+    net.initialize();
+
+    RDSE_Parameters p;
+    p.size       = 100u;
+    p.activeBits = 10u;
+    p.resolution = 1.0f;
+    p.seed       = 42u;
+    RDSE rdse(p);
+    SDR expected(rdse.dimensions);
+
+    // The first value has nothing to be differenced against.
+    region1->setParameterReal64("sensedValue", 10.0);
+    net.run(1);
+    EXPECT_EQ(region1->getOutputData("encoded").getSDR().getSum(), 0u);
+
+    for (const Real64 value : { 13.0, 11.0, 30.0 }) {
+      const Real64 previous = region1->getParameterReal64("sensedValue");
+      region1->setParameterReal64("sensedValue", value);
+      net.run(1);
+      rdse.encode(value - previous, expected);
+      ASSERT_EQ(region1->getOutputData("encoded").getSDR(), expected) << "at " << value;
+    }
+
+    EXPECT_ANY_THROW(net.addRegion("region2", "RDSEEncoderRegion",
+                    "{size: 100, activeBits: 10, resolution: 1, delta: sideways}"));
+  }
+
+
   TEST(RDSEEncoderRegionTest, testSerialization) {
     // NOTE: this test does end-to-end serialize and deserialize with the following modules:
     //   Network, Region, Array, RDSERegion, SPRegion, SpatialPooler, Connections, Random, Links
@@ -50,6 +50,7 @@
 #include <htm/os/Timer.hpp>
 #include <htm/os/Directory.hpp>
 #include <htm/regions/SPRegion.hpp>
+#include <htm/utils/Random.hpp>
 
 
 #include <string>
@@ -378,6 +379,44 @@ TEST(SPRegionTest, testSerialization)
     Directory::removeTree("TestOutputDir", true);
 }
 
+TEST(SPRegionTest, testParameterViews)
+{
+  Network net;
+  std::shared_ptr<Region> sp = net.addRegion("sp", "SPRegion", "{columnCount: 100, globalInhibition: true}");
+  net.link("INPUT", "sp", "", "{dim: 200}", "in", "bottomUpIn");
+  net.initialize();
+  Random rng(7);
+  SDR input({200u});
+  input.randomize(0.1f, rng);
+  net.setInputData("in", Array(input));
+  net.run(1);
+  const Array &output = sp->getOutputData("bottomUpOut");
+
+  // The non-zeros alias the SDR's sparse indices.
+  Array nonZeros(NTA_BasicType_UInt32);
+  sp->getParameterArray("spOutputNonZeros", nonZeros);
+  EXPECT_EQ(nonZeros.getType(), NTA_BasicType_UInt32);
+  EXPECT_EQ(nonZeros.getBuffer(), static_cast<const void *>(output.getSDR().getSparse().data()));
+  EXPECT_EQ(nonZeros.asVector<UInt32>(), output.getSDR().getSparse());
+  sp->getParameterArray("spInputNonZeros", nonZeros);
+  EXPECT_EQ(nonZeros.asVector<UInt32>(), input.getSparse());
+
+  // Dense views as SDR or Byte, a copy as UInt32.
+  Array sdr(NTA_BasicType_SDR);
+  sp->getParameterArray("spatialPoolerOutput", sdr);
+  EXPECT_EQ(&sdr.getSDR(), &output.getSDR());
+  Array bytes(NTA_BasicType_Byte);
+  sp->getParameterArray("spatialPoolerOutput", bytes);
+  EXPECT_EQ(bytes.getBuffer(), output.getBuffer());
+  EXPECT_EQ(bytes.getCount(), 100u);
+  Array uints(NTA_BasicType_UInt32);
+  sp->getParameterArray("spatialPoolerInput", uints);
+  EXPECT_EQ(uints.getType(), NTA_BasicType_UInt32);
+  EXPECT_EQ(uints.getCount(), 200u);
+  EXPECT_EQ(uints.asVector<UInt32>(), Array(input).get_as(NTA_BasicType_UInt32).asVector<UInt32>());
+}
+
+
 TEST(SPRegionTest, testGetParameters)
 {
   Network net;
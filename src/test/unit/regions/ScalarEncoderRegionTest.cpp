@@ -52,7 +52,7 @@
 #define VERBOSE if(verbose)std::cerr << "[          ] "
 static bool verbose = false;  // turn this on to print extra stuff for debugging the test.
 
-const UInt EXPECTED_SPEC_COUNT =  11u;  // The number of parameters expected in the ScalarSensor Spec
+const UInt EXPECTED_SPEC_COUNT =  12u;  // The number of parameters expected in the ScalarSensor Spec
 
 using namespace htm;
 namespace testing 
@@ -355,6 +355,13 @@ namespace testing
       "count": 1,
       "access": "Create",
       "defaultValue": "false"
+    },
+    "delta": {
+      "description": "Encode the change since the previous value instead of the value: 'difference' or 'rate'. The default '' encodes the value.",
+      "type": "String",
+      "count": 1,
+      "access": "Create",
+      "defaultValue": ""
     }
   },
   "inputs": {
@@ -365,6 +372,14 @@ namespace testing
       "required": 0,
       "regionLevel": 0,
       "isDefaultInput": 1
+    },
+    "timestamps": {
+      "description": "Time of the values, a delta 'rate' is per unit of this time. If not linked, one unit per compute.",
+      "type": "Real64",
+      "count": 1,
+      "required": 0,
+      "regionLevel": 0,
+      "isDefaultInput": 0
     }
   },
   "outputs": {
@@ -402,7 +417,8 @@ namespace testing
   "minValue": -1.000000,
   "maxValue": 1.000000,
   "periodic": false,
-  "clipInput": false
+  "clipInput": false,
+  "delta": null
 })";
 
     Network net1;
@@ -52,6 +52,7 @@
 #include <htm/os/Timer.hpp>
 #include <htm/regions/TMRegion.hpp>
 #include <htm/types/Exception.hpp>
+#include <htm/utils/Random.hpp>
 #include <htm/utils/VectorHelpers.hpp>
 
 #include <cmath>   // fabs/abs
@@ -71,7 +72,7 @@ static bool verbose = false; // turn this on to print extra stuff for debugging
 
 // The following string should contain a valid expected Spec - manually
 // verified.
-#define EXPECTED_SPEC_COUNT 18 // The number of parameters expected in the TMRegion Spec
+#define EXPECTED_SPEC_COUNT 20 // The number of parameters expected in the TMRegion Spec
 
 using namespace htm;
 
@@ -331,6 +332,71 @@ TEST(TMRegionTest, testLinking) {
   region4->executeCommand({"closeFile"});
 }
 
+TEST(TMRegionTest, testOutputsOnDemand) {
+  // Outputs which nothing links or watches are filled when read, the same as
+  // when they are computed in every iteration.
+  const std::vector<std::string> outputs = {"bottomUpOut", "activeCells", "predictedActiveCells",
+                                            "anomaly", "predictiveCells"};
+  Network lazy, eager;
+  for (Network *net : {&lazy, &eager}) {
+    net->addRegion("tm", "TMRegion", "{cellsPerColumn: 4, activationThreshold: 3, minThreshold: 2}");
+    net->link("INPUT", "tm", "", "{dim: 50}", "columns", "bottomUpIn");
+    net->initialize();
+  }
+  std::shared_ptr<Region> tm = lazy.getRegion("tm");
+  for (const auto &name : outputs) {
+    EXPECT_FALSE(tm->getOutput(name)->isDemanded());
+    eager.getRegion("tm")->getOutput(name)->addDemand();
+  }
+
+  Random rng(42);
+  SDR columns({50u});
+  for (UInt i = 0; i < 30; i++) {
+    columns.randomize(0.1f, rng);
+    for (Network *net : {&lazy, &eager}) {
+      net->setInputData("columns", Array(columns));
+      net->run(1);
+    }
+    EXPECT_TRUE(tm->getOutput("predictiveCells")->isStale());
+    EXPECT_FALSE(tm->getOutput("anomaly")->isStale()); // always written
+    for (const auto &name : outputs) {
+      EXPECT_FALSE(eager.getRegion("tm")->getOutput(name)->isStale());
+      ASSERT_EQ(tm->getOutputData(name), eager.getRegion("tm")->getOutputData(name)) << name << " at " << i;
+      EXPECT_FALSE(tm->getOutput(name)->isStale());
+    }
+  }
+}
+
+
+TEST(TMRegionTest, testCellViews) {
+  Network net;
+  std::shared_ptr<Region> tm = net.addRegion("tm", "TMRegion", "{cellsPerColumn: 4}");
+  net.link("INPUT", "tm", "", "{dim: 50}", "columns", "bottomUpIn");
+  net.initialize();
+
+  Random rng(42);
+  SDR columns({50u});
+  for (UInt i = 0; i < 5; i++) {
+    columns.randomize(0.1f, rng);
+    net.setInputData("columns", Array(columns));
+    net.run(1);
+
+    Array active(NTA_BasicType_UInt32);
+    tm->getParameterArray("activeCellsNonZeros", active);
+    EXPECT_EQ(active.asVector<UInt32>(), tm->getOutputData("activeCells").getSDR().getSparse()) << "at " << i;
+    EXPECT_EQ(active.getCount(), tm->getParameterArrayCount("activeCellsNonZeros"));
+    Array winners(NTA_BasicType_UInt32);
+    tm->getParameterArray("winnerCellsNonZeros", winners);
+    EXPECT_EQ(winners.asVector<UInt32>(), tm->getOutputData("predictedActiveCells").getSDR().getSparse());
+
+    // A view, not a copy: reading it again gives the same storage.
+    Array again(NTA_BasicType_UInt32);
+    tm->getParameterArray("activeCellsNonZeros", again);
+    EXPECT_EQ(active.getBuffer(), again.getBuffer());
+  }
+}
+
+
 TEST(TMRegionTest, testSerialization) {
   // use default parameters the first time
   Network *net1 = new Network();
@@ -449,6 +515,8 @@ TEST(TMRegionTest, testGetParameters) {
   "seed": 42,
   "inputWidth": 0,
   "learningMode": true,
+  "activeCellsNonZeros": [],
+  "winnerCellsNonZeros": [],
   "activeOutputCount": 0,
   "anomaly": -1.000000,
   "orColumnOutputs": false
@@ -475,6 +543,8 @@ TEST(TMRegionTest, testGetParameters) {
   "seed": 42,
   "inputWidth": 100,
   "learningMode": true,
+  "activeCellsNonZeros": [],
+  "winnerCellsNonZeros": [],
   "activeOutputCount": 0,
   "anomaly": -1.000000,
   "orColumnOutputs": false
@@ -49,6 +49,7 @@
 #include <htm/os/Timer.hpp>
 #include <htm/os/Directory.hpp>
 #include <htm/regions/SPRegion.hpp>
+#include <htm/regions/VectorFile.hpp>
 
 
 #include <string>
@@ -71,8 +72,8 @@
 static bool verbose = false;  // turn this on to print extra stuff for debugging the test.
 
 // The following string should contain a valid expected Spec - manually verified. 
-#define EXPECTED_EFFECTOR_SPEC_COUNT  1   // The number of parameters expected in the FileOutputRegion Spec
-#define EXPECTED_SENSOR_SPEC_COUNT  11    // The number of parameters expected in the FileInputRegion Spec
+#define EXPECTED_EFFECTOR_SPEC_COUNT  2   // The number of parameters expected in the FileOutputRegion Spec
+#define EXPECTED_SENSOR_SPEC_COUNT  13    // The number of parameters expected in the FileInputRegion Spec
 
 using namespace htm;
 namespace testing 
@@ -268,6 +269,191 @@ TEST(VectorFileTest, testSerialization)
 
 	}
 	
+  // Binary formats are memory mapped and must serve the same vectors as the csv.
+  TEST(VectorFileTest, BinaryFormats)
+  {
+    std::string test_input_file = "TestOutputDir/TestInput.csv";
+    std::string test_output_file = "TestOutputDir/TestOutput.csv";
+    size_t dataWidth = 10;
+    size_t dataRows = 10;
+    createTestData(dataRows, dataWidth, test_input_file, test_output_file);
+
+    Network net;
+    std::shared_ptr<Region> csv = net.addRegion("csv", "FileInputRegion", "{activeOutputCount: 10}");
+    net.addRegion("bin7", "FileInputRegion", "{activeOutputCount: 10, readAhead: 4}");
+    net.addRegion("bin4", "FileInputRegion", "{activeOutputCount: 10, readAhead: 4}");
+    csv->executeCommand({ "loadFile", test_input_file });
+    net.initialize();
+    csv->executeCommand({ "saveFile", "TestOutputDir/TestInput.vec", "7", "0", "10" });
+    csv->executeCommand({ "saveFile", "TestOutputDir/TestInput.f64", "4", "0", "10" });
+
+    net.getRegion("bin7")->executeCommand({ "loadFile", "TestOutputDir/TestInput.vec", "7" });
+    net.getRegion("bin4")->executeCommand({ "loadFile", "TestOutputDir/TestInput.f64", "4" });
+    EXPECT_EQ(net.getRegion("bin7")->getParameterUInt32("vectorCount"), dataRows);
+    EXPECT_EQ(net.getRegion("bin4")->getParameterUInt32("vectorCount"), dataRows);
+    for (size_t i = 0; i < dataRows + 2; i++) {
+      net.run(1);
+      EXPECT_EQ(csv->getOutputData("dataOut"), net.getRegion("bin7")->getOutputData("dataOut")) << i;
+      EXPECT_EQ(csv->getOutputData("dataOut"), net.getRegion("bin4")->getOutputData("dataOut")) << i;
+    }
+
+    VectorFile vf;
+    EXPECT_ANY_THROW(vf.appendFile("TestOutputDir/TestInput.vec", 9, 7)); // wrong width
+    EXPECT_ANY_THROW(vf.appendFile(test_input_file, 10, 7));              // not binary
+
+    // IDX: big-endian header, 3 rows of 2x2 unsigned bytes.
+    {
+      std::ofstream f("TestOutputDir/TestInput.idx", std::ios::binary);
+      const unsigned char idx[] = { 0, 0, 0x08, 3,  0, 0, 0, 3,  0, 0, 0, 2,  0, 0, 0, 2,
+                                    1, 2, 3, 4,  5, 6, 7, 8,  9, 10, 11, 255 };
+      f.write(reinterpret_cast<const char *>(idx), sizeof(idx));
+    }
+    vf.appendFile("TestOutputDir/TestInput.idx", 5, 6); // one more than stored: zero filled
+    ASSERT_EQ(vf.vectorCount(), 3u);
+    Real64 row[5];
+    vf.getRawVector(2, row, 0, 5);
+    EXPECT_EQ(std::vector<Real64>(row, row + 5), std::vector<Real64>({ 9, 10, 11, 255, 0 }));
+
+    // cleanup
+    Directory::removeTree("TestOutputDir", true);
+  }
+
+  // The prefetching producer thread must output exactly what compute() would.
+  TEST(VectorFileTest, Prefetch)
+  {
+    std::string test_input_file = "TestOutputDir/TestInput.csv";
+    std::string test_output_file = "TestOutputDir/TestOutput.csv";
+    size_t dataWidth = 10;
+    size_t dataRows = 7;
+    createTestData(dataRows, dataWidth, test_input_file, test_output_file);
+
+    Network net;
+    const std::string params = "{activeOutputCount: 10, repeatCount: 2, scalingMode: standardForm";
+    std::shared_ptr<Region> sync = net.addRegion("sync", "FileInputRegion", params + "}");
+    std::shared_ptr<Region> staged = net.addRegion("staged", "FileInputRegion", params + ", prefetchDepth: 3}");
+    sync->executeCommand({ "loadFile", test_input_file });
+    staged->executeCommand({ "loadFile", test_input_file });
+    net.initialize();
+    EXPECT_EQ(staged->getParameterUInt32("prefetchDepth"), 3u);
+
+    for (size_t i = 0; i < 3 * dataRows; i++) {
+      net.run(1);
+      ASSERT_EQ(sync->getOutputData("dataOut"), staged->getOutputData("dataOut")) << i;
+      ASSERT_EQ(sync->getParameterInt32("position"), staged->getParameterInt32("position")) << i;
+    }
+
+    // seeking restarts the producer at the new position
+    sync->setParameterInt32("position", 4);
+    staged->setParameterInt32("position", 4);
+    for (size_t i = 0; i < 5; i++) {
+      net.run(1);
+      ASSERT_EQ(sync->getOutputData("dataOut"), staged->getOutputData("dataOut")) << "after seek " << i;
+    }
+
+    // switched off in the middle of a repeat
+    staged->setParameterUInt32("prefetchDepth", 0);
+    for (size_t i = 0; i < 5; i++) {
+      net.run(1);
+      ASSERT_EQ(sync->getOutputData("dataOut"), staged->getOutputData("dataOut")) << "sync again " << i;
+    }
+
+    // cleanup
+    Directory::removeTree("TestOutputDir", true);
+  }
+
+  // FileOutputRegion binary output is read back by FileInputRegion, also while it is written.
+  TEST(VectorFileTest, BinaryOutput)
+  {
+    std::string test_input_file = "TestOutputDir/TestInput.csv";
+    std::string test_output_file = "TestOutputDir/TestOutput.vec";
+    size_t dataWidth = 10;
+    size_t dataRows = 10;
+    createTestData(dataRows, dataWidth, test_input_file, test_output_file);
+
+    Network net;
+    std::shared_ptr<Region> input = net.addRegion("input", "FileInputRegion", "{activeOutputCount: 10}");
+    std::shared_ptr<Region> output = net.addRegion("output", "FileOutputRegion",
+                                                   "{outputFormat: binary, outputFile: '" + test_output_file + "'}");
+    net.link("input", "output", "", "", "dataOut", "dataIn");
+    input->executeCommand({ "loadFile", test_input_file });
+    net.initialize();
+    net.run(4);
+    EXPECT_ANY_THROW(output->setParameterString("outputFormat", "csv"));
+    EXPECT_ANY_THROW(output->executeCommand({ "echo", "text" }));
+
+    output->executeCommand({ "flushFile" });
+    VectorFile partial;
+    partial.appendFile(test_output_file, dataWidth, 7);
+    EXPECT_EQ(partial.vectorCount(), 4u);
+
+    net.run(6);
+    output->executeCommand({ "closeFile" });
+
+    std::shared_ptr<Region> replay = net.addRegion("replay", "FileInputRegion", "{activeOutputCount: 10}");
+    replay->executeCommand({ "loadFile", test_output_file, "7" });
+    EXPECT_EQ(replay->getParameterUInt32("vectorCount"), dataRows);
+    VectorFile csv, bin;
+    csv.appendFile(test_input_file, dataWidth, 3);
+    bin.appendFile(test_output_file, dataWidth, 7);
+    Real64 a[10], b[10];
+    for (UInt i = 0; i < dataRows; i++) {
+      csv.getRawVector(i, a, 0, dataWidth);
+      bin.getRawVector(i, b, 0, dataWidth);
+      EXPECT_EQ(std::vector<Real64>(a, a + dataWidth), std::vector<Real64>(b, b + dataWidth)) << i;
+    }
+
+    // cleanup
+    Directory::removeTree("TestOutputDir", true);
+  }
+
+  TEST(VectorFileTest, CSVParsing)
+  {
+    if (!Directory::exists("TestOutputDir")) Directory::create("TestOutputDir", false, true);
+    {
+      std::ofstream f("TestOutputDir/messy.csv", std::ios::binary);
+      f << "a,b,c\r\n"        // header: skipped
+        << "1,2,3\r\n"
+        << "23,,43,7\r\n"     // empty values are skipped, extra values ignored
+        << "23,hello,42\r\n"  // skipped
+        << ",+4.5,-1e2, 6\r"
+        << "23443 w4343\n"     // skipped
+        << "23,24,\n"          // skipped, too short
+        << "1-2,3";             // two values in "1-2", no final line end
+    }
+    VectorFile vf;
+    vf.appendFile("TestOutputDir/messy.csv", 3, 3);
+    ASSERT_EQ(vf.vectorCount(), 4u);
+    const std::vector<std::vector<Real64>> expected = { {1, 2, 3}, {23, 43, 7}, {4.5, -100, 6}, {1, -2, 3} };
+    Real64 row[3];
+    for (UInt i = 0; i < 4; i++) {
+      vf.getRawVector(i, row, 0, 3);
+      EXPECT_EQ(std::vector<Real64>(row, row + 3), expected[i]) << i;
+    }
+
+    // Large enough to be parsed in several chunks.
+    const size_t nRows = 200000;
+    {
+      std::ofstream f("TestOutputDir/large.csv");
+      for (size_t i = 0; i < nRows; i++)
+        f << i << "," << (i * 0.5) << "," << -static_cast<Int64>(i) << "\n";
+    }
+    VectorFile large;
+    large.appendFile("TestOutputDir/large.csv", 3, 3);
+    ASSERT_EQ(large.vectorCount(), nRows);
+    for (size_t i = 0; i < nRows; i += 997) {
+      large.getRawVector(static_cast<UInt>(i), row, 0, 3);
+      ASSERT_EQ(std::vector<Real64>(row, row + 3),
+                std::vector<Real64>({ Real64(i), i * 0.5, -Real64(i) })) << i;
+    }
+    large.setStandardScaling();
+    Real64 scale, offset;
+    large.getScaling(0, scale, offset);
+    EXPECT_NEAR(offset, -(nRows - 1.0) / 2.0, 1e-6);
+
+    // cleanup
+    Directory::removeTree("TestOutputDir", true);
+  }
+
 	//////////////////////////////////////////////////////////////////////////////////
 
 	static bool compareFiles(const std::string& p1, const std::string& p2) {
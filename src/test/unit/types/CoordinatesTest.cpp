@@ -0,0 +1,123 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of unit tests for the CoordinateConverter class
+ */
+
+#include <gtest/gtest.h>
+#include <vector>
+
+#include <htm/types/Coordinates.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/utils/Random.hpp>
+
+namespace testing {
+
+using namespace htm;
+using std::vector;
+
+TEST(CoordinatesTest, FastDivider) {
+  Random rng(42);
+  vector<UInt32> divisors = {1u, 2u, 3u, 5u, 7u, 10u, 64u, 100u, 641u, 65535u, 65536u, 65537u,
+                             0x7FFFFFFFu, 0x80000000u, 0xFFFFFFFFu};
+  for (int i = 0; i < 50; i++) divisors.push_back(rng.getUInt32() | 1u);
+  vector<UInt32> numbers = {0u, 1u, 2u, 0x7FFFFFFFu, 0x80000000u, 0xFFFFFFFEu, 0xFFFFFFFFu};
+  for (int i = 0; i < 1000; i++) numbers.push_back(rng.getUInt32());
+  for (const UInt32 d : divisors) {
+    const FastDivider div(d);
+    for (const UInt32 n : numbers) {
+      ASSERT_EQ(div.divide(n), n / d) << n << " / " << d;
+      ASSERT_EQ(div.modulo(n), n % d) << n << " % " << d;
+    }
+  }
+  EXPECT_ANY_THROW(FastDivider(0u));
+}
+
+TEST(CoordinatesTest, Converter) {
+  const vector<UInt> dimensions = {4u, 1u, 5u, 6u};
+  const CoordinateConverter conv(dimensions);
+  EXPECT_EQ(conv.strides(), vector<UInt>({30u, 30u, 6u, 1u}));
+  vector<UInt> indices, coordinates;
+  for (UInt index = 0u; index < 120u; index++) {
+    indices.push_back(index);
+    conv.toCoordinates(index, coordinates);
+    UInt rest = index;
+    for (size_t axis = dimensions.size(); axis > 0u; axis--) {
+      ASSERT_EQ(coordinates[axis - 1u], rest % dimensions[axis - 1u]);
+      ASSERT_EQ(conv.coordinate(index, axis - 1u), coordinates[axis - 1u]);
+      rest /= dimensions[axis - 1u];
+    }
+    ASSERT_EQ(conv.toIndex(coordinates), index);
+  }
+
+  // The batch, with a tail which is not a multiple of the SIMD width.
+  indices.resize(119u);
+  vector<vector<UInt>> axes;
+  conv.toCoordinates(indices, axes);
+  ASSERT_EQ(axes.size(), dimensions.size());
+  for (size_t axis = 0u; axis < dimensions.size(); axis++)
+    for (size_t i = 0u; i < indices.size(); i++)
+      ASSERT_EQ(axes[axis][i], conv.coordinate(indices[i], axis)) << "axis " << axis << " index " << i;
+
+  EXPECT_ANY_THROW(CoordinateConverter({}));
+  EXPECT_ANY_THROW(CoordinateConverter({3u, 0u}));
+  EXPECT_ANY_THROW(CoordinateConverter({65536u, 65536u}));
+}
+
+TEST(CoordinatesTest, Shared) {
+  const auto a = CoordinateConverter::get({10u, 20u});
+  const auto b = CoordinateConverter::get({10u, 20u});
+  const auto c = CoordinateConverter::get({20u, 10u});
+  EXPECT_EQ(a.get(), b.get());
+  EXPECT_NE(a.get(), c.get());
+
+  SDR x({10u, 20u});
+  SDR y({10u, 20u});
+  EXPECT_EQ(x.getCoordinateConverter().get(), a.get());
+  EXPECT_EQ(y.getCoordinateConverter().get(), a.get());
+  x.reshape({20u, 10u});
+  EXPECT_EQ(x.getCoordinateConverter().get(), c.get());
+}
+
+TEST(CoordinatesTest, SdrAxis) {
+  Random rng(7);
+  SDR x({16u, 9u, 7u});
+  x.randomize(0.1f, rng);
+  const SDR_coordinate_t all = x.getCoordinates();
+  for (UInt axis = 0u; axis < 3u; axis++) {
+    const CoordinateAxis view = x.getCoordinateAxis(axis);
+    ASSERT_EQ(view.size(), x.getSum());
+    EXPECT_EQ(view.toVector(), all[axis]);
+    size_t i = 0u;
+    for (const UInt c : view)
+      ASSERT_EQ(c, all[axis][i++]);
+  }
+  EXPECT_ANY_THROW(x.getCoordinateAxis(3u));
+
+  // From coordinates back to sparse.
+  SDR y({16u, 9u, 7u});
+  y.setCoordinates(all);
+  EXPECT_EQ(y.getSparse(), x.getSparse());
+
+  SDR example({4u, 5u, 6u});
+  example.setSparse(SDR_sparse_t{37u, 119u});
+  EXPECT_EQ(example.getCoordinateAxis(1u)[1], 4u);
+  EXPECT_EQ(example.getCoordinateAxis(1u).toVector(), vector<UInt>({1u, 4u}));
+}
+
+} // namespace testing
@@ -0,0 +1,88 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+#include <gtest/gtest.h>
+#include <htm/types/RoaringBitmap.hpp>
+#include <htm/utils/Random.hpp>
+#include <set>
+#include <vector>
+
+namespace testing {
+
+using namespace std;
+using namespace htm;
+
+TEST(RoaringBitmapTest, TestExampleUsage) {
+    RoaringBitmap r;
+    r.assign({ 3, 70000, 9000000 });
+    ASSERT_TRUE( r.contains( 70000 ));
+    ASSERT_FALSE( r.contains( 70001 ));
+    ASSERT_EQ( r.cardinality(), 3u );
+    vector<UInt32> visited;
+    r.forEach([&](UInt32 index) { visited.push_back( index ); });
+    ASSERT_EQ( visited, vector<UInt32>({ 3, 70000, 9000000 }));
+}
+
+TEST(RoaringBitmapTest, TestArrayAndBitmapContainers) {
+    // chunk 0 sparse (array), chunk 1 full (bitmap), chunk 5 a single index
+    vector<UInt32> sorted;
+    for(UInt32 i = 0; i < 100; i++)    sorted.push_back( i * 37u );
+    for(UInt32 i = 0; i < 10000; i++)  sorted.push_back( 65536u + i * 3u );
+    sorted.push_back( 5u * 65536u + 65535u );
+    RoaringBitmap r;
+    r.assign( sorted );
+    ASSERT_EQ( r.cardinality(), sorted.size() );
+
+    vector<UInt32> back;
+    r.toSparse( back );
+    ASSERT_EQ( back, sorted );
+
+    const set<UInt32> lookup( sorted.begin(), sorted.end() );
+    for(UInt32 i = 0; i < 6u * 65536u; i += 7u) {
+        ASSERT_EQ( r.contains( i ), lookup.count( i ) == 1u ) << i;
+    }
+    ASSERT_LT( r.memoryUsage(), 10000u + 100u * 2u + 1024u * 8u );
+
+    r.clear();
+    ASSERT_TRUE( r.empty() );
+    ASSERT_FALSE( r.contains( 0u ));
+}
+
+TEST(RoaringBitmapTest, TestOverlap) {
+    Random rng( 42 );
+    // array & array, bitmap & bitmap, array & bitmap containers
+    for(const auto counts : vector<pair<UInt32, UInt32>>{{ 50u, 50u }, { 20000u, 20000u }, { 50u, 20000u }}) {
+        set<UInt32> a, b;
+        while( a.size() < counts.first )  a.insert( rng.getUInt32( 200000u ));
+        while( b.size() < counts.second ) b.insert( rng.getUInt32( 200000u ));
+        size_t expected = 0u;
+        for(const auto i : a) expected += b.count( i );
+
+        RoaringBitmap ra, rb;
+        ra.assign( vector<UInt32>( a.begin(), a.end() ));
+        rb.assign( vector<UInt32>( b.begin(), b.end() ));
+        ASSERT_EQ( ra.overlap( rb ), expected ) << counts.first << " " << counts.second;
+        ASSERT_EQ( rb.overlap( ra ), expected ) << counts.first << " " << counts.second;
+        ASSERT_EQ( ra.overlap( ra ), ra.cardinality() );
+        ASSERT_NE( ra, rb );
+        RoaringBitmap copy;
+        copy.assign( vector<UInt32>( a.begin(), a.end() ));
+        ASSERT_EQ( ra, copy );
+    }
+}
+
+} // End namespace testing
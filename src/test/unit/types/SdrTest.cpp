@@ -149,6 +149,56 @@ TEST(SdrTest, TestReshape) {
     ASSERT_ANY_THROW( A.reshape({ 2 }) );
 }
 
+TEST(SdrTest, TestReset) {
+    SDR A({10, 10});
+    A.setSparse(SDR_sparse_t{ 1, 5, 99 });
+    A.getDense();
+    const ElemSparse *buffer = A.getSparse().data();
+    A.reset({10, 10});
+    ASSERT_EQ( A.getSum(), 0u );
+    ASSERT_EQ( A.getDense(), SDR_dense_t(100, 0) );
+    A.setSparse(SDR_sparse_t{ 2, 3 });
+    A.reset({ 7, 3 }); // size may change
+    ASSERT_EQ( A.size, 21u );
+    ASSERT_EQ( A.dimensions, vector<UInt>({ 7, 3 }) );
+    ASSERT_EQ( A.getSum(), 0u );
+    A.setCoordinates(SDR_coordinate_t{{ 6 }, { 2 }});
+    ASSERT_EQ( A.getSparse(), SDR_sparse_t({ 20 }) );
+    ASSERT_EQ( A.getSparse().data(), buffer ); // kept its capacity
+    ASSERT_ANY_THROW( A.reset({ 3, 0 }) );
+}
+
+TEST(SdrTest, TestScratch) {
+    const SDR *first;
+    const SDR *second;
+    {
+        SDR::Scratch A({ 100 });
+        ASSERT_EQ( A->dimensions, vector<UInt>({ 100 }) );
+        ASSERT_EQ( A->getSum(), 0u );
+        A->setSparse(SDR_sparse_t{ 1, 2, 3 });
+        first = &*A;
+    }
+    {
+        // Back from the pool, zeroed.
+        SDR::Scratch A({ 100 });
+        ASSERT_EQ( &*A, first );
+        ASSERT_EQ( A->getSum(), 0u );
+        // Borrowed at the same time: distinct.
+        SDR::Scratch B({ 100 });
+        ASSERT_NE( &*B, first );
+        second = &*B;
+        B->setSparse(SDR_sparse_t{ 4 });
+        ASSERT_EQ( A->getSum(), 0u );
+    }
+    {
+        // Other dimensions reuse a free SDR too.
+        SDR::Scratch C({ 2, 5 });
+        ASSERT_EQ( C->size, 10u );
+        ASSERT_EQ( C->getSum(), 0u );
+        ASSERT_TRUE( &*C == first or &*C == second );
+    }
+}
+
 TEST(SdrTest, TestSetDenseVec) {
     SDR a({11, 10, 4});
     Byte *before = a.getDense().data();
@@ -437,6 +487,69 @@ TEST(SdrTest, TestGetCoordinatesFromDense) {
     ASSERT_EQ( a.getCoordinates()[1].size(), 0ul );
 }
 
+TEST(SdrTest, TestPacked) {
+    // 70 bits: two words, the second one partially used.
+    SDR a({7, 10});
+    a.setSparse(SDR_sparse_t({0u, 5u, 63u, 64u, 69u}));
+    const auto &packed = a.getPacked();
+    ASSERT_EQ( packed.size(), 2u );
+    ASSERT_EQ( packed[0], (UInt64(1u) << 0) | (UInt64(1u) << 5) | (UInt64(1u) << 63) );
+    ASSERT_EQ( packed[1], (UInt64(1u) << 0) | (UInt64(1u) << 5) );
+
+    // Set packed, get the other formats.
+    SDR b({7, 10});
+    SDR_packed_t value(packed);
+    b.setPacked( value );
+    ASSERT_EQ( b.getSparse(), a.getSparse() );
+    b.setPacked( value = a.getPacked() );
+    ASSERT_EQ( b.getDense(), a.getDense() );
+    ASSERT_EQ( b.getCoordinates(), a.getCoordinates() );
+    b.setPacked( value = a.getPacked() );
+    b.reshape({70});
+    ASSERT_EQ( b.getSparse(), a.getSparse() );
+
+    // Dense to packed.
+    SDR c({7, 10});
+    c.setDense( a.getDense() );
+    ASSERT_EQ( c.getPacked(), a.getPacked() );
+    ASSERT_EQ( c, a );
+}
+
+TEST(SdrTest, TestPackedOps) {
+    // Overlap, intersection & union in the packed format must match the
+    // naive results, for sizes which are not a multiple of 64.
+    Random rng(42);
+    for(const UInt size : {1u, 63u, 64u, 65u, 1000u}) {
+        SDR A({size});
+        SDR B({size});
+        SDR X({size});
+        for(const Real sparsity : {0.0f, 0.01f, 0.5f}) {
+            A.randomize(sparsity, rng);
+            B.randomize(sparsity, rng);
+            UInt naiveOverlap = 0u;
+            SDR_dense_t naiveAnd(size), naiveOr(size);
+            for(UInt i = 0; i < size; i++) {
+                naiveOverlap += A.getDense()[i] && B.getDense()[i];
+                naiveAnd[i] = A.getDense()[i] && B.getDense()[i];
+                naiveOr[i]  = A.getDense()[i] || B.getDense()[i];
+            }
+            // sparse only, then packed
+            A.setSparse( SDR_sparse_t(A.getSparse()) );
+            B.setSparse( SDR_sparse_t(B.getSparse()) );
+            ASSERT_EQ( A.getOverlap(B), naiveOverlap ) << "size " << size;
+            A.getPacked(); B.getPacked();
+            ASSERT_EQ( A.getOverlap(B), naiveOverlap ) << "size " << size;
+            X.intersection(A, B);
+            ASSERT_EQ( X.getDense(), naiveAnd ) << "size " << size;
+            X.set_union(A, B);
+            ASSERT_EQ( X.getDense(), naiveOr ) << "size " << size;
+            X.setSDR(A);
+            X.intersection(X, B); //inplace
+            ASSERT_EQ( X.getDense(), naiveAnd ) << "size " << size;
+        }
+    }
+}
+
 TEST(SdrTest, TestAt) {
     SDR a({3, 3});
     a.setSparse(SDR_sparse_t( {4, 5, 8} ));
@@ -600,6 +713,38 @@ TEST(SdrTest, TestAddNoise) {
     }
 }
 
+TEST(SdrTest, TestRandomizeLarge) {
+    // A million bits, sampled without a buffer of the whole range.
+    SDR a({ 1000u, 1000u });
+    Random rng( 3 );
+    a.randomize( 0.02f, rng, true );
+    const SDR_sparse_t sparse = a.getSparse();
+    ASSERT_EQ( sparse.size(), 20000u );
+    ASSERT_TRUE( std::adjacent_find( sparse.begin(), sparse.end(),
+        [](UInt x, UInt y) { return x >= y; }) == sparse.end() );
+    ASSERT_LT( sparse.back(), a.size );
+
+    // Most of the bits, sampled as the complement.
+    SDR b( a.dimensions );
+    b.randomize( 0.9f, rng, true );
+    ASSERT_EQ( b.getSum(), 900000u );
+
+    SDR c( a );
+    c.addNoise( 0.5f, rng, true );
+    ASSERT_EQ( c.getSum(), 20000u );
+    ASSERT_EQ( a.getOverlap( c ), 10000u );
+
+    // The default keeps the draws of Random::sample(), reproducible per seed.
+    SDR d({ 100u });
+    Random rng1( 7 ), rng2( 7 );
+    d.randomize( 0.1f, rng1 );
+    SDR_sparse_t range( d.size );
+    std::iota( range.begin(), range.end(), 0u );
+    SDR_sparse_t expected = rng2.sample( range, 10u );
+    std::sort( expected.begin(), expected.end() );
+    ASSERT_EQ( d.getSparse(), expected );
+}
+
 TEST(SdrTest, TestIntersectionExampleUsage) {
     // Setup 2 SDRs to hold the inputs.
     SDR A({ 10 });
@@ -658,6 +803,118 @@ TEST(SdrTest, TestUnion) {
     ASSERT_EQ( U.getSparsity(), .5 );
 }
 
+TEST(SdrTest, TestSetOperationsManyInputs) {
+    // Very sparse inputs are merged as sparse indices, denser ones as packed
+    // words; both must match a plain dense computation, also inplace.
+    Random rng(7);
+    for(const Real sparsity : {0.002f, 0.3f}) {
+        vector<SDR> inputs(50, SDR({ 10000u }));
+        for(auto &sdr : inputs) {
+            sdr.randomize(sparsity, rng);
+            sdr.getSparse();
+        }
+        // a few common bits, so the intersection is not empty
+        for(auto &sdr : inputs) {
+            auto &dense = sdr.getDense();
+            dense[17] = dense[9001] = 1;
+            sdr.setDense(dense);
+            sdr.getSparse();
+        }
+        vector<const SDR*> ptrs;
+        SDR_dense_t all(10000u, 1), any(10000u, 0);
+        for(const auto &sdr : inputs) {
+            ptrs.push_back(&sdr);
+            const auto &dense = sdr.getDense();
+            for(UInt i = 0; i < 10000u; i++) {
+                all[i] = all[i] and dense[i];
+                any[i] = any[i] or  dense[i];
+            }
+        }
+        SDR expectAll({ 10000u }); expectAll.setDense(all);
+        SDR expectAny({ 10000u }); expectAny.setDense(any);
+
+        SDR X({ 10000u });
+        X.intersection(ptrs);
+        ASSERT_EQ(X.getSparse(), expectAll.getSparse()) << sparsity;
+        X.set_union(ptrs);
+        ASSERT_EQ(X.getSparse(), expectAny.getSparse()) << sparsity;
+
+        // inplace: the output is one of the inputs
+        SDR &first = inputs[0];
+        const SDR original(first);
+        first.intersection(ptrs);
+        ASSERT_EQ(first.getSparse(), expectAll.getSparse()) << sparsity;
+        first = original;
+        first.getSparse();
+        first.set_union(ptrs);
+        ASSERT_EQ(first.getSparse(), expectAny.getSparse()) << sparsity;
+    }
+}
+
+TEST(SdrTest, TestCompressed) {
+    // 10M bits, 0.01% active: the compressed format, never a dense array.
+    SDR A({ 10000000u });
+    SDR_sparse_t sparse;
+    for(UInt i = 0; i < 1000u; i++) sparse.push_back( i * 9973u );
+    const SDR_sparse_t &copyDontSwap = sparse;
+    A.setSparse( copyDontSwap );
+    auto &compressed = A.getCompressed();
+    ASSERT_EQ( compressed.cardinality(), 1000u );
+
+    // swap it in, the other formats are made from it
+    SDR B( A.dimensions );
+    RoaringBitmap value = compressed;
+    B.setCompressed( value );
+    ASSERT_EQ( B.getSparse(), sparse );
+    ASSERT_EQ( A, B );
+
+    ASSERT_TRUE( B.contains( 9973u * 5u ));
+    ASSERT_FALSE( B.contains( 9973u * 5u + 1u ));
+    ASSERT_EQ( B.getOverlap( A ), 1000u );
+
+    // contains() uses whichever format is valid
+    SDR C({ 100u });
+    C.setSparse( SDR_sparse_t{ 1u, 50u });
+    ASSERT_TRUE( C.contains( 50u ));
+    C.getDense();
+    ASSERT_TRUE( C.contains( 1u ));
+    ASSERT_FALSE( C.contains( 2u ));
+    SDR_packed_t packed = C.getPacked();
+    C.setPacked( packed );
+    ASSERT_TRUE( C.contains( 50u ));
+    ASSERT_FALSE( C.contains( 51u ));
+}
+
+TEST(SdrTest, TestDenseConversions) {
+    // The vectorized dense to sparse / packed kernels work on blocks, check
+    // sizes around the block sizes and values other than 1.
+    Random rng( 3 );
+    for(const UInt size : { 1u, 31u, 32u, 63u, 64u, 65u, 100u, 1000u, 100037u }) {
+        for(const Real sparsity : { 0.0f, 0.02f, 0.5f, 1.0f }) {
+            SDR_dense_t dense( size, 0 );
+            SDR_sparse_t expected;
+            for(UInt i = 0; i < size; i++) {
+                if( rng.getReal64() < sparsity ) {
+                    dense[i] = static_cast<ElemDense>( 1u + rng.getUInt32(255u) );
+                    expected.push_back( i );
+                }
+            }
+            SDR A({ size });
+            SDR_dense_t copy = dense;
+            A.setDense( copy );
+            ASSERT_EQ( A.getSparse(), expected ) << size << " " << sparsity;
+
+            SDR B({ size });
+            copy = dense;
+            B.setDense( copy );
+            SDR C({ size });
+            SDR_packed_t packed = B.getPacked();
+            C.setPacked( packed );
+            ASSERT_EQ( C.getSparse(), expected ) << size << " " << sparsity;
+        }
+    }
+}
+
 TEST(SdrTest, TestConcatenationExampleUsage) {
     SDR A({ 10 });
     SDR B({ 10 });
@@ -802,6 +1059,42 @@ TEST(SdrTest, TestSaveLoad) {
 
 }
 
+TEST(SdrTest, TestSparseEncoding) {
+    const SDR_sparse_t edges({ 0, 1, 127, 128, 255, 16383, 16384, 0xFFFFFFFEu, 0xFFFFFFFFu });
+    ASSERT_EQ( SDR::decodeSparse( SDR::encodeSparse( edges )), edges );
+    ASSERT_TRUE( SDR::encodeSparse( {} ).empty() );
+    ASSERT_EQ( SDR::encodeSparse({ 5, 6, 200 }), std::vector<uint8_t>({ 5, 1, 0xC2, 0x01 }) );
+
+    EXPECT_ANY_THROW( SDR::decodeSparse({ 0x80 }) );          // truncated varint
+    EXPECT_ANY_THROW( SDR::decodeSparse({ 3, 0 }) );          // not unique
+    EXPECT_ANY_THROW( SDR::decodeSparse({ 0xFF, 0xFF, 0xFF, 0xFF, 0x7F }) ); // > 32 bits
+
+    // A typical SDR needs about a byte per active bit.
+    Random rng(42);
+    SDR A({ 64, 64 });
+    A.randomize( 0.02f, rng );
+    ASSERT_LT( SDR::encodeSparse( A.getSparse() ).size(), A.getSum() * 2u );
+
+    for( const auto fmt : { SerializableFormat::BINARY, SerializableFormat::PORTABLE,
+                            SerializableFormat::JSON } ) {
+        stringstream ss;
+        A.save( ss, fmt );
+        SDR B;
+        B.load( ss, fmt );
+        ASSERT_TRUE( A == B );
+    }
+
+    // loading rejects indices outside of the dimensions
+    stringstream bad;
+    {
+        cereal::BinaryOutputArchive ar( bad );
+        ar( std::vector<UInt>({ 4 }), SDR::encodeSparse({ 5 }) );
+    }
+    cereal::BinaryInputArchive in( bad );
+    SDR small;
+    EXPECT_ANY_THROW( small.load_ar( in ) );
+}
+
 TEST(SdrTest, TestCallbacks) {
 
     SDR A({ 10, 20 });
@@ -870,6 +1163,47 @@ TEST(SdrTest, TestCallbacks) {
     ASSERT_ANY_THROW( B.removeCallback( 0 ) );
 }
 
+TEST(SdrTest, TestDeferCallbacks) {
+    SDR A({ 10 });
+    SDR B({ 10 });
+    UInt countA = 0u, countB = 0u;
+    SDR_sparse_t seenA;
+    A.addCallback( [&](){ countA++; seenA = A.getSparse(); } );
+    B.addCallback( [&](){ countB++; } );
+    const auto epoch = A.getEpoch();
+    {
+        SDR::DeferCallbacks defer;
+        A.setSparse(SDR_sparse_t({ 1 }));
+        {
+            SDR::DeferCallbacks nested;
+            A.setSparse(SDR_sparse_t({ 2 }));
+        }
+        A.setSparse(SDR_sparse_t({ 3 }));
+        ASSERT_EQ( countA, 0u );
+        ASSERT_EQ( countB, 0u );
+        // An SDR which is destroyed before the flush is skipped.
+        SDR C({ 10 });
+        C.addCallback( [&](){ FAIL() << "destroyed SDR notified"; } );
+        C.setSparse(SDR_sparse_t({ 4 }));
+    }
+    // Coalesced: once, with the last value.
+    ASSERT_EQ( countA, 1u );
+    ASSERT_EQ( seenA, SDR_sparse_t({ 3 }) );
+    ASSERT_EQ( countB, 0u );
+    ASSERT_EQ( A.getEpoch(), epoch + 3u );
+    // Not deferred anymore.
+    A.zero();
+    ASSERT_EQ( countA, 2u );
+
+    // Without callbacks only the epoch counts.
+    SDR D({ 10 });
+    const auto epochD = D.getEpoch();
+    D.setSparse(SDR_sparse_t({ 1 }));
+    D.zero();
+    ASSERT_EQ( D.getEpoch(), epochD + 2u );
+}
+
+
 
 TEST(SdrTest, TestAssignmentOperator) 
 {
@@ -0,0 +1,102 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+#include <gtest/gtest.h>
+#include <htm/types/SdrView.hpp>
+#include <vector>
+
+namespace testing {
+
+using namespace std;
+using namespace htm;
+
+TEST(SdrViewTest, TestExampleUsage) {
+    SDR A({ 10 });
+    SDR B({ 20 });
+    SDR C({ 30 });
+    A.setSparse(SDR_sparse_t{ 1, 2 });
+    B.setSparse(SDR_sparse_t{ 0, 5 });
+    C.concatenate( A, B );
+    SDRView view( C );
+    ASSERT_EQ( view.getSum(), 4u );
+    ASSERT_EQ( view.slice( 10, 30 ).getSum(), 2u );
+    ASSERT_TRUE( view.slice( 10, 30 ).at( 5 ) );
+    ASSERT_FALSE( view.slice( 10, 30 ).at( 1 ) );
+    SDR D({ 20 });
+    view.slice( 10, 30 ).copyTo( D );
+    ASSERT_EQ( D, B );
+    SDR E({ 10 });
+    view.slice( 0, 10 ).copyTo( E );
+    ASSERT_EQ( E, A );
+}
+
+TEST(SdrViewTest, TestExternalBuffers) {
+    // The view reads the caller's buffer, no copy.
+    vector<ElemSparse> sparse({ 3, 4, 8 });
+    const SDRView sparseView({ 3, 3 }, sparse.data(), sparse.size());
+    SDR_dense_t dense({ 0, 0, 0, 1, 1, 0, 0, 0, 1 });
+    const SDRView denseView({ 3, 3 }, dense.data());
+    ASSERT_TRUE( sparseView.isSparse() );
+    ASSERT_FALSE( denseView.isSparse() );
+    ASSERT_EQ( sparseView.getSize(), 9u );
+    ASSERT_EQ( sparseView.getSum(), 3u );
+    ASSERT_EQ( denseView.getSum(), 3u );
+    ASSERT_EQ( sparseView.getOverlap( denseView ), 3u );
+    dense[8] = 0;
+    ASSERT_EQ( sparseView.getOverlap( denseView ), 2u );
+    ASSERT_EQ( denseView.getOverlap( sparseView ), 2u );
+    ASSERT_EQ( denseView.getOverlap( denseView ), 2u );
+
+    SDR X({ 9 });
+    sparseView.copyTo( X );
+    ASSERT_EQ( X.dimensions, vector<UInt>({ 3, 3 }) );
+    ASSERT_EQ( X.getSparse(), sparse );
+    denseView.copyTo( X );
+    ASSERT_EQ( X.getSparse(), SDR_sparse_t({ 3, 4 }) );
+    SDRView( X ).copyTo( X ); // a view of the SDR it is copied into
+    ASSERT_EQ( X.getSparse(), SDR_sparse_t({ 3, 4 }) );
+
+    ASSERT_EQ( sparseView.reshape({ 9 }).getDimensions(), vector<UInt>({ 9 }) );
+    ASSERT_ANY_THROW( sparseView.reshape({ 10 }) );
+    ASSERT_ANY_THROW( sparseView.slice( 5, 10 ) );
+}
+
+TEST(SdrViewTest, TestSlices) {
+    // Slices of slices, sparse and dense, must agree with the SDR.
+    SDR A({ 100 });
+    Random rng( 7 );
+    A.randomize( 0.2f, rng );
+    const SDRView sparseView( A );
+    const SDRView denseView( A.dimensions, A.getDense().data() );
+    for( const auto &view : { sparseView, denseView } ) {
+        const SDRView outer = view.slice( 10, 90 );
+        const SDRView inner = outer.slice( 5, 45 ); //indices 15 .. 55 of A
+        vector<UInt> visited;
+        inner.forEach([&](const UInt i) { visited.push_back( i ); });
+        vector<UInt> expected;
+        for( const auto i : A.getSparse() )
+            if( i >= 15u and i < 55u ) expected.push_back( i - 15u );
+        ASSERT_EQ( visited, expected );
+        ASSERT_EQ( inner.getSum(), expected.size() );
+        for( UInt i = 0; i < inner.getSize(); i++ )
+            ASSERT_EQ( inner.at( i ), A.getDense()[i + 15u] != 0 );
+    }
+    ASSERT_EQ( sparseView.slice( 20, 60 ).getOverlap( denseView.slice( 20, 60 ) ),
+               sparseView.slice( 20, 60 ).getSum() );
+}
+
+} // namespace testing
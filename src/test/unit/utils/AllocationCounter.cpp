@@ -0,0 +1,104 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * The global operator new and delete of the unit_tests executable, which
+ * count the allocations of each thread, see AllocationCounter.hpp
+ */
+
+#include "AllocationCounter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+#if defined(NTA_OS_WINDOWS)
+#include <malloc.h> // _aligned_malloc
+#endif
+
+namespace {
+
+thread_local size_t allocations = 0u;
+
+void *allocate(std::size_t size) noexcept {
+  allocations++;
+  return std::malloc(size > 0u ? size : 1u);
+}
+
+void *allocateAligned(std::size_t size, std::align_val_t alignment) noexcept {
+  allocations++;
+  const std::size_t align = static_cast<std::size_t>(alignment);
+  size = size > 0u ? size : 1u;
+#if defined(NTA_OS_WINDOWS)
+  return _aligned_malloc(size, align);
+#else
+  void *p = nullptr;
+  return posix_memalign(&p, align < sizeof(void *) ? sizeof(void *) : align, size) == 0 ? p : nullptr;
+#endif
+}
+
+void releaseAligned(void *p) noexcept {
+#if defined(NTA_OS_WINDOWS)
+  _aligned_free(p);
+#else
+  std::free(p);
+#endif
+}
+
+void *orThrow(void *p) {
+  if (p == nullptr)
+    throw std::bad_alloc();
+  return p;
+}
+
+} // namespace
+
+namespace testing {
+
+AllocationCounter::AllocationCounter() noexcept : start_(allocations) {}
+
+size_t AllocationCounter::count() const noexcept { return allocations - start_; }
+
+size_t AllocationCounter::total() noexcept { return allocations; }
+
+} // namespace testing
+
+
+void *operator new(std::size_t size) { return orThrow(allocate(size)); }
+void *operator new[](std::size_t size) { return orThrow(allocate(size)); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept { return allocate(size); }
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept { return allocate(size); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { std::free(p); }
+
+void *operator new(std::size_t size, std::align_val_t a) { return orThrow(allocateAligned(size, a)); }
+void *operator new[](std::size_t size, std::align_val_t a) { return orThrow(allocateAligned(size, a)); }
+void *operator new(std::size_t size, std::align_val_t a, const std::nothrow_t &) noexcept {
+  return allocateAligned(size, a);
+}
+void *operator new[](std::size_t size, std::align_val_t a, const std::nothrow_t &) noexcept {
+  return allocateAligned(size, a);
+}
+void operator delete(void *p, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept { releaseAligned(p); }
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept { releaseAligned(p); }
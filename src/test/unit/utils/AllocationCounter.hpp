@@ -0,0 +1,62 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Counts the heap allocations of the unit tests, see AllocationCounter.
+ */
+
+#ifndef NTA_TEST_ALLOCATION_COUNTER_HPP
+#define NTA_TEST_ALLOCATION_COUNTER_HPP
+
+#include <cstddef>
+
+namespace testing {
+
+/**
+ * Counts the calls of the global operator new (every form, with arrays,
+ * nothrow and alignment) on the calling thread, from its construction until
+ * count() is called.
+ *
+ * AllocationCounter.cpp replaces the global operators of the unit_tests
+ * executable, and with it the ones used by htm_core, by malloc() and free()
+ * and a thread local count, so the other threads of a test (gtest, thread
+ * pools) do not add to it. Direct calls of malloc() are not counted.
+ *
+ * For the hot paths which should not allocate once warmed up:
+ *
+ *     for (int i = 0; i < 10; i++) sp.compute(input, true, output); // warm-up
+ *     AllocationCounter allocations;
+ *     for (int i = 0; i < 100; i++) sp.compute(input, true, output);
+ *     EXPECT_EQ(allocations.count(), 0u);
+ */
+class AllocationCounter {
+public:
+  AllocationCounter() noexcept;
+
+  /** Allocations on this thread since the construction. */
+  size_t count() const noexcept;
+
+  /** Allocations on this thread since the start of the process. */
+  static size_t total() noexcept;
+
+private:
+  size_t start_;
+};
+
+} // namespace testing
+
+#endif // NTA_TEST_ALLOCATION_COUNTER_HPP
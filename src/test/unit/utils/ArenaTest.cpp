@@ -0,0 +1,125 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <htm/engine/Network.hpp>
+#include <htm/ntypes/Array.hpp>
+#include <htm/utils/Arena.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+TEST(ArenaTest, Allocate) {
+  Arena arena(4096u);
+  char *a = static_cast<char *>(arena.allocate(10u));
+  char *b = static_cast<char *>(arena.allocate(100u, 16u));
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(a) % 64u, 0u);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(b) % 16u, 0u);
+  EXPECT_GE(b, a + 10);
+  EXPECT_EQ(arena.getNumChunks(), 1u);
+  EXPECT_EQ(arena.getAllocatedBytes(), 110u);
+
+  arena.allocate(10000u); // larger than a chunk
+  EXPECT_EQ(arena.getNumChunks(), 2u);
+  EXPECT_GE(arena.getReservedBytes(), 4096u + 10000u);
+
+  Arena big(4u << 20u);
+  big.allocate(1u);
+  EXPECT_EQ(big.getReservedBytes(), 4u << 20u); // huge pages are optional
+}
+
+TEST(ArenaTest, CreateDestroys) {
+  auto counter = std::make_shared<int>(0);
+  {
+    Arena arena;
+    auto *copy = arena.create<std::shared_ptr<int>>(counter);
+    EXPECT_EQ(counter.use_count(), 2);
+    EXPECT_EQ(copy->get(), counter.get());
+  }
+  EXPECT_EQ(counter.use_count(), 1);
+}
+
+TEST(ArenaTest, ArrayBuffers) {
+  auto arena = std::make_shared<Arena>();
+  Array real(NTA_BasicType_Real32);
+  Array sdr(NTA_BasicType_SDR);
+  Array outside(NTA_BasicType_Real32);
+  {
+    Arena::Scope scope(arena);
+    real.allocateBuffer(100u);
+    sdr.allocateBuffer({10u, 10u});
+    {
+      Arena::Scope off(nullptr);
+      outside.allocateBuffer(100u);
+    }
+  }
+  EXPECT_EQ(Arena::current(), nullptr);
+  EXPECT_EQ(arena->getAllocatedBytes(), 100u * sizeof(Real32) + sizeof(SDR));
+  sdr.getSDR().setSparse(SDR_sparse_t{1u, 5u, 99u});
+  EXPECT_EQ(sdr.getSDR().getSum(), 3u);
+
+  // The buffers keep the arena alive.
+  const Arena *raw = arena.get();
+  arena.reset();
+  reinterpret_cast<Real32 *>(real.getBuffer())[99] = 1.0f;
+  EXPECT_EQ(raw->getNumChunks(), 1u);
+}
+
+TEST(ArenaTest, Network) {
+  Network net;
+  net.addRegion("enc", "RDSEEncoderRegion", "{size: 100, activeBits: 10, resolution: 1}");
+  net.addRegion("sp", "SPRegion", "{columnCount: 200}");
+  net.link("enc", "sp", "", "", "encoded", "bottomUpIn", 2);
+  EXPECT_EQ(net.getArena(), nullptr);
+  net.initialize();
+  ASSERT_NE(net.getArena(), nullptr);
+  EXPECT_GE(net.getArena()->getAllocatedBytes(), 3u * sizeof(SDR)); // outputs and the delay buffers
+  net.run(3);
+
+  Network heap;
+  heap.setArenaEnabled(false);
+  heap.addRegion("enc", "RDSEEncoderRegion", "{size: 100, activeBits: 10, resolution: 1}");
+  heap.initialize();
+  EXPECT_EQ(heap.getArena(), nullptr);
+}
+
+TEST(ArenaTest, NumaNode) {
+  Arena arena(1u << 16u, 0);
+  EXPECT_EQ(arena.getNumaNode(), 0);
+  char *p = static_cast<char *>(arena.allocate(1000u));
+  p[999] = 1; // mapped, bound where the system supports it
+  EXPECT_EQ(arena.getNumChunks(), 1u);
+  EXPECT_EQ(arena.getReservedBytes(), 1u << 16u);
+
+  Network net;
+  Placement node0;
+  node0.numaNode = 0;
+  net.addRegion("enc", "RDSEEncoderRegion", "{size: 100, activeBits: 10, resolution: 1}", node0);
+  net.addRegion("sp", "SPRegion", "{columnCount: 200}");
+  net.link("enc", "sp", "", "", "encoded", "bottomUpIn");
+  net.initialize();
+  ASSERT_NE(net.getArena(0), nullptr);
+  EXPECT_EQ(net.getArena(0)->getNumaNode(), 0);
+  EXPECT_GE(net.getArena(0)->getAllocatedBytes(), sizeof(SDR)); // the output of enc
+  EXPECT_EQ(net.getArena(1), nullptr);
+  net.run(2);
+}
+
+} // namespace testing
@@ -0,0 +1,66 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <htm/utils/Compression.hpp>
+#include <htm/utils/Random.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+static void roundTrip(const std::string &data) {
+  const std::string packed = Compression::compress(data);
+  EXPECT_EQ(Compression::decompress(packed), data);
+}
+
+TEST(CompressionTest, RoundTrip) {
+  roundTrip("");
+  roundTrip("a");
+  roundTrip("abcabcabcabcabcabcabcabcabcabcabcabcabc");
+  roundTrip(std::string(100000u, '\0'));
+
+  Random rng(42);
+  std::string noise(70000u, '\0');
+  for (auto &c : noise) c = static_cast<char>(rng.getUInt32(256u));
+  roundTrip(noise);
+  roundTrip(noise + noise); // matches further back than the window
+}
+
+TEST(CompressionTest, Ratio) {
+  const std::string zeros(100000u, '\0');
+  EXPECT_LT(Compression::compress(zeros).size(), zeros.size() / 50u);
+
+  Random rng(7);
+  std::string noise(4096u, '\0');
+  for (auto &c : noise) c = static_cast<char>(rng.getUInt32(256u));
+  // incompressible input is stored, with only a small header
+  EXPECT_LE(Compression::compress(noise).size(), noise.size() + 4u);
+}
+
+TEST(CompressionTest, Corrupt) {
+  const std::string packed = Compression::compress(std::string(1000u, 'x'));
+  EXPECT_ANY_THROW(Compression::decompress(""));
+  EXPECT_ANY_THROW(Compression::decompress(packed.substr(0u, 3u)));
+  std::string bad = packed;
+  bad[0] = 7;
+  EXPECT_ANY_THROW(Compression::decompress(bad));
+}
+
+} // namespace testing
@@ -0,0 +1,70 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+#include "gtest/gtest.h"
+
+#include <htm/types/Sdr.hpp>
+#include <htm/utils/CpuDispatch.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+static int one() { return 1; }
+static int two() { return 2; }
+
+TEST(CpuDispatchTest, Cap) {
+  const UInt32 all = CPU_POPCNT | CPU_AVX2 | CPU_BMI2 | CPU_AVX512F | CPU_AVX512BW | CPU_AVX512VPOPCNTDQ;
+  EXPECT_EQ(CpuDispatch::cap(all, ""), all);
+  EXPECT_EQ(CpuDispatch::cap(all, "native"), all);
+  EXPECT_EQ(CpuDispatch::cap(all, "scalar"), 0u);
+  EXPECT_EQ(CpuDispatch::cap(all, "popcnt"), UInt32(CPU_POPCNT));
+  EXPECT_EQ(CpuDispatch::cap(all, "AVX2"), UInt32(CPU_POPCNT | CPU_AVX2 | CPU_BMI2));
+  EXPECT_EQ(CpuDispatch::cap(all, "avx512"), all);
+  EXPECT_EQ(CpuDispatch::cap(CPU_POPCNT, "avx512"), UInt32(CPU_POPCNT)); // never adds
+  EXPECT_EQ(CpuDispatch::cap(CPU_NEON, "scalar"), 0u);
+  EXPECT_ANY_THROW(CpuDispatch::cap(all, "sse9"));
+
+  EXPECT_EQ(CpuDispatch::toString(CPU_POPCNT | CPU_AVX2), "popcnt avx2");
+  EXPECT_EQ(CpuDispatch::toString(0u), "");
+  EXPECT_EQ(CpuDispatch::features() & ~CpuDispatch::detected(), 0u);
+}
+
+TEST(CpuDispatchTest, Bind) {
+  using Fn = int (*)();
+  // a feature no CPU has falls through to the scalar variant
+  const Fn fn = CpuDispatch::bind<Fn>("test.bind", {{"future", 1u << 31, one}, {"scalar", 0u, two}});
+  EXPECT_EQ(fn(), 2);
+  EXPECT_EQ(CpuDispatch::chosenVariants().at("test.bind"), "scalar");
+
+  const Fn first = CpuDispatch::bind<Fn>("test.first", {{"a", 0u, one}, {"b", 0u, two}});
+  EXPECT_EQ(first(), 1);
+  EXPECT_EQ(CpuDispatch::chosenVariants().at("test.first"), "a");
+}
+
+TEST(CpuDispatchTest, ReportsKernels) {
+  SDR a({1000});
+  SDR_dense_t dense(1000, 0);
+  dense[3] = dense[700] = 1;
+  a.setDense(dense);
+  EXPECT_EQ(a.getSparse(), SDR_sparse_t({3u, 700u}));
+  const auto variants = CpuDispatch::chosenVariants();
+  ASSERT_EQ(variants.count("sdr.denseToSparse"), 1u);
+  EXPECT_FALSE(variants.at("sdr.denseToSparse").empty());
+}
+
+} // namespace testing
@@ -0,0 +1,94 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of unit tests for the approximations of FastMath.hpp
+ */
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include <htm/utils/FastMath.hpp>
+#include <htm/utils/Random.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+TEST(FastMathTest, Exp32) {
+  for(Real32 x = -87.0f; x <= 88.0f; x += 0.01f) {
+    const Real64 exact = std::exp(static_cast<Real64>(x));
+    ASSERT_NEAR(fastmath::exp(x), exact, exact * 5.0e-7) << "x " << x;
+  }
+  EXPECT_EQ(fastmath::exp(0.0f), 1.0f);
+  // clipped
+  EXPECT_FLOAT_EQ(fastmath::exp(-1000.0f), fastmath::exp(-87.0f));
+  EXPECT_FLOAT_EQ(fastmath::exp(1000.0f),  fastmath::exp(88.0f));
+  EXPECT_FALSE(std::isinf(fastmath::exp(1000.0f)));
+}
+
+
+TEST(FastMathTest, Exp64) {
+  for(Real64 x = -700.0; x <= 709.0; x += 0.0137) {
+    const Real64 exact = std::exp(x);
+    ASSERT_NEAR(fastmath::exp(x), exact, exact * 1.0e-14) << "x " << x;
+  }
+  EXPECT_EQ(fastmath::exp(0.0), 1.0);
+  EXPECT_DOUBLE_EQ(fastmath::exp(-1.0e6), fastmath::exp(-700.0));
+  EXPECT_FALSE(std::isinf(fastmath::exp(1.0e6)));
+}
+
+
+TEST(FastMathTest, Log) {
+  for(Real32 x = std::numeric_limits<Real32>::min(); x < 1.0e38f; x *= 1.01f) {
+    const Real64 exact = std::log(static_cast<Real64>(x));
+    // and the rounding to float, half an ulp
+    ASSERT_NEAR(fastmath::log(x), exact, 3.0e-7 + std::fabs(exact) * 6.0e-8) << "x " << x;
+  }
+  for(Real32 x = 0.9f; x < 1.1f; x += 0.001f) {
+    ASSERT_NEAR(fastmath::log(x), std::log(static_cast<Real64>(x)), 3.0e-7) << "x " << x;
+  }
+  EXPECT_EQ(fastmath::log(1.0f), 0.0f);
+  const Real32 smallest = std::numeric_limits<Real32>::min();
+  EXPECT_FLOAT_EQ(fastmath::log(0.0f), std::log(smallest));
+  EXPECT_FLOAT_EQ(fastmath::log(smallest / 4.0f), std::log(smallest));
+}
+
+
+TEST(FastMathTest, Softmax) {
+  Random rng(5);
+  for(const size_t size : {1u, 3u, 17u, 100u}) {
+    std::vector<Real64> exact(size), approximate(size);
+    for(auto &x : exact) x = rng.getReal64() * 40.0 - 20.0;
+    approximate = exact;
+    const Real64 maxVal = *std::max_element(exact.begin(), exact.end());
+    Real64 sum = 0.0;
+    for(auto &x : exact) sum += (x = std::exp(x - maxVal));
+    for(auto &x : exact) x /= sum;
+
+    fastmath::softmax(approximate.data(), approximate.data() + size);
+    for(size_t i = 0u; i < size; i++) {
+      ASSERT_NEAR(approximate[i], exact[i], exact[i] * 1.0e-14) << "size " << size << " i " << i;
+    }
+  }
+  std::vector<Real64> none;
+  fastmath::softmax(none.data(), none.data());
+}
+
+} // namespace testing
@@ -0,0 +1,103 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+#include "gtest/gtest.h"
+
+#include <htm/utils/LatencyHistogram.hpp>
+#include <htm/ntypes/Value.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+TEST(LatencyHistogramTest, Empty) {
+  LatencyHistogram h;
+  EXPECT_EQ(h.getCount(), 0u);
+  EXPECT_EQ(h.getMean(), 0.0);
+  EXPECT_EQ(h.getMax(), 0.0);
+  EXPECT_EQ(h.getPercentile(99.0), 0.0);
+  EXPECT_ANY_THROW(h.getPercentile(101.0));
+}
+
+TEST(LatencyHistogramTest, Percentiles) {
+  LatencyHistogram h;
+  // 1..1000 microseconds
+  for (UInt64 us = 1u; us <= 1000u; us++) {
+    h.record(us * 1000u);
+  }
+  EXPECT_EQ(h.getCount(), 1000u);
+  EXPECT_NEAR(h.getMean(), 500.5e-6, 1e-12);
+  EXPECT_DOUBLE_EQ(h.getMin(), 1e-6);
+  EXPECT_DOUBLE_EQ(h.getMax(), 1e-3);
+  // within the 1/16 resolution of the buckets, never below the exact value
+  EXPECT_GE(h.getPercentile(50.0), 500e-6);
+  EXPECT_LE(h.getPercentile(50.0), 500e-6 * (1.0 + 1.0 / 16));
+  EXPECT_GE(h.getPercentile(99.0), 990e-6);
+  EXPECT_LE(h.getPercentile(99.0), 1e-3);
+  EXPECT_DOUBLE_EQ(h.getPercentile(100.0), 1e-3);
+  EXPECT_DOUBLE_EQ(h.getPercentile(0.0), 1e-6);
+
+  // small values are exact
+  LatencyHistogram small;
+  small.record(3u);
+  small.record(7u);
+  EXPECT_DOUBLE_EQ(small.getPercentile(50.0), 3e-9);
+
+  h.reset();
+  EXPECT_EQ(h.getCount(), 0u);
+  EXPECT_EQ(h.getPercentile(50.0), 0.0);
+}
+
+TEST(LatencyHistogramTest, TailAndJSON) {
+  LatencyHistogram h;
+  for (int i = 0; i < 990; i++) h.record(1000u);
+  for (int i = 0; i < 10; i++)  h.record(1000000u); // 1% slow outliers
+  EXPECT_LE(h.getPercentile(50.0), 1e-6 * (1.0 + 1.0 / 16));
+  EXPECT_LE(h.getPercentile(99.0), 1e-6 * (1.0 + 1.0 / 16));
+  EXPECT_GE(h.getPercentile(99.5), 1e-3);
+
+  Value v;
+  v.parse(h.toJSON());
+  EXPECT_EQ(v["count"].as<UInt>(), 1000u);
+  EXPECT_DOUBLE_EQ(v["max"].as<Real64>(), 1e-3);
+  EXPECT_TRUE(v.contains("p50") && v.contains("p90") && v.contains("p99") && v.contains("mean"));
+}
+
+TEST(LatencyHistogramTest, Merge) {
+  LatencyHistogram a, b, all;
+  for (UInt64 i = 1u; i <= 500u; i++) {
+    a.record(i * 1000u);
+    all.record(i * 1000u);
+  }
+  for (UInt64 i = 501u; i <= 1000u; i++) {
+    b.record(i * 1000u);
+    all.record(i * 1000u);
+  }
+  LatencyHistogram merged;
+  merged.merge(LatencyHistogram()); // empty, no change
+  EXPECT_EQ(merged.getCount(), 0u);
+  merged.merge(b);
+  merged.merge(a);
+  EXPECT_EQ(merged.getCount(), 1000u);
+  EXPECT_EQ(merged.getMin(), all.getMin());
+  EXPECT_EQ(merged.getMax(), all.getMax());
+  EXPECT_DOUBLE_EQ(merged.getMean(), all.getMean());
+  for (const Real64 p : {50.0, 99.0, 99.9})
+    EXPECT_EQ(merged.getPercentile(p), all.getPercentile(p));
+}
+
+} // namespace testing
@@ -0,0 +1,157 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of unit tests for the Logger behind the NTA_* log macros
+ */
+
+// NTA_DEBUG is compiled out of this file, whatever NTA_LOG_LEVEL says.
+#define NTA_LOG_MIN_LEVEL 2
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "htm/types/Sdr.hpp"
+#include "htm/utils/Log.hpp"
+
+namespace testing {
+
+using namespace htm;
+
+namespace {
+// Logs to a string at the Normal level, and restores std::cout after.
+class LoggerTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    level_ = NTA_LOG_LEVEL;
+    NTA_LOG_LEVEL = LogLevel::LogLevel_Normal;
+    Logger::setOutput(out);
+  }
+  void TearDown() override {
+    Logger::setAsync(false);
+    Logger::setOutput(std::cout);
+    NTA_LOG_LEVEL = level_;
+  }
+  std::stringstream out;
+private:
+  LogLevel level_;
+};
+} // namespace
+
+
+TEST(LoggerBasename, CompileTime) {
+  static_assert(logBasenameOffset("a/b\\c.cpp") == 4u, "both separators");
+  static_assert(logBasenameOffset("c.cpp") == 0u, "no directory");
+  EXPECT_STREQ(NTA_FILE_NAME, "LoggerTest.cpp");
+}
+
+
+TEST_F(LoggerTest, OneLinePerMessage) {
+  const int line = __LINE__ + 1;
+  NTA_WARN << "Hello " << 42;
+  NTA_INFO << "World" << std::endl;
+  EXPECT_EQ(out.str(), "WARN:\tLoggerTest.cpp:" + std::to_string(line) + ": Hello 42\n"
+                       "INFO:\tLoggerTest.cpp:" + std::to_string(line + 1) + ": World\n");
+}
+
+
+TEST_F(LoggerTest, DeferredFormatting) {
+  const char *none = nullptr;
+  std::string text = "text";
+  NTA_WARN << std::hex << 255 << std::dec << " " << std::setw(4) << 7 << " " << 1.5f << " "
+           << true << " " << 'c' << " " << none << " " << text;
+  // The flags of a message do not leak into the next one.
+  NTA_WARN << 255;
+  const std::string s = out.str();
+  EXPECT_NE(s.find(": ff    7 1.5 1 c (null) text\n"), std::string::npos) << s;
+  EXPECT_NE(s.find(": 255\n"), std::string::npos) << s;
+
+  // Other values are formatted at once, an SDR or a view which may change.
+  SDR sdr({4u});
+  sdr.setSparse(SDR_sparse_t{1u});
+  std::string backing = "view";
+  {
+    LogMessage message("WARN", "file", 1);
+    message << sdr << " " << std::string_view(backing);
+    sdr.zero();
+    text = "changed";
+    backing[0] = 'X';
+  }
+  EXPECT_NE(out.str().find("SDR( 4 ) 1"), std::string::npos) << out.str();
+  EXPECT_NE(out.str().find(" view"), std::string::npos) << out.str();
+}
+
+
+TEST_F(LoggerTest, MinimumLevel) {
+  NTA_LOG_LEVEL = LogLevel::LogLevel_Verbose;
+  int evaluated = 0;
+  NTA_DEBUG << ++evaluated;
+  NTA_INFO << ++evaluated;
+  EXPECT_EQ(evaluated, 1) << "NTA_DEBUG is compiled out, its arguments are not evaluated";
+
+  NTA_LOG_LEVEL = LogLevel::LogLevel_None;
+  NTA_WARN << ++evaluated;
+  EXPECT_EQ(evaluated, 1);
+  const std::string s = out.str();
+  EXPECT_EQ(std::count(s.begin(), s.end(), '\n'), 1);
+}
+
+
+TEST_F(LoggerTest, Async) {
+  Logger::setAsync(true, 16u);  // small queues, the threads have to wait
+  EXPECT_TRUE(Logger::isAsync());
+  const int threads = 4, messages = 500;
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([t]() {
+      NTA_LOG_LEVEL = LogLevel::LogLevel_Normal;  // thread_local
+      for (int i = 0; i < messages; i++)
+        NTA_WARN << "thread " << t << " message " << i;
+    });
+  }
+  for (auto &w : workers) w.join();
+  NTA_WARN << "main";
+  Logger::flush();
+
+  const std::string s = out.str();
+  EXPECT_EQ(std::count(s.begin(), s.end(), '\n'), threads * messages + 1);
+  for (int t = 0; t < threads; t++) {
+    // The messages of a thread keep their order.
+    const auto first = s.find("thread " + std::to_string(t) + " message 0\n");
+    const auto last = s.find("thread " + std::to_string(t) + " message " + std::to_string(messages - 1) + "\n");
+    ASSERT_NE(first, std::string::npos);
+    ASSERT_NE(last, std::string::npos);
+    EXPECT_LT(first, last);
+  }
+  EXPECT_NE(s.find(": main\n"), std::string::npos);
+
+  // Turning it off writes what is left.
+  NTA_WARN << "last";
+  Logger::setAsync(false);
+  EXPECT_FALSE(Logger::isAsync());
+  EXPECT_NE(out.str().find(": last\n"), std::string::npos);
+}
+
+} // namespace testing
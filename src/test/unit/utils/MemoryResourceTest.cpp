@@ -0,0 +1,152 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+
+/** @file
+ * Implementation of unit tests for the MemoryResource classes
+ */
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <htm/algorithms/Connections.hpp>
+#include <htm/algorithms/TemporalMemory.hpp>
+#include <htm/utils/MemoryResource.hpp>
+#include <htm/utils/Random.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+// Counts the bytes in use, from operator new.
+class CountingResource : public MemoryResource {
+public:
+  void *allocate(size_t bytes, size_t alignment) override {
+    inUse += bytes;
+    return defaultResource()->allocate(bytes, alignment);
+  }
+  void deallocate(void *p, size_t bytes, size_t alignment) noexcept override {
+    inUse -= bytes;
+    defaultResource()->deallocate(p, bytes, alignment);
+  }
+  std::atomic<size_t> inUse{0u};
+};
+
+
+TEST(MemoryResourceTest, ResourceVector) {
+  CountingResource counting;
+  {
+    ResourceVector<UInt> a(&counting);
+    a.assign(100u, 7u);
+    EXPECT_GE(counting.inUse, 100u * sizeof(UInt));
+
+    ResourceVector<UInt> copy(a); // copies use the same resource
+    EXPECT_EQ(copy.get_allocator().resource(), &counting);
+
+    ResourceVector<UInt> other; // assignment keeps the target's resource
+    other = a;
+    EXPECT_EQ(other.get_allocator().resource(), MemoryResource::defaultResource());
+    other = std::move(copy);
+    EXPECT_EQ(other.get_allocator().resource(), MemoryResource::defaultResource());
+    EXPECT_EQ(other, a);
+  }
+  EXPECT_EQ(counting.inUse, 0u);
+}
+
+
+TEST(MemoryResourceTest, PageResource) {
+  PageResource pages(true, -1, 1u << 16u);
+  char *small = static_cast<char *>(pages.allocate(100u, 8u));
+  EXPECT_EQ(pages.getMappedBytes(), 0u);
+  char *large = static_cast<char *>(pages.allocate(5u << 20u, 64u));
+  if (pagesSupported()) {
+    EXPECT_EQ(pages.getMappedBytes(), 6u << 20u); // whole 2 MiB pages
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(large) % 4096u, 0u);
+  }
+  std::memset(large, 1, 5u << 20u);
+  std::memset(small, 1, 100u);
+  pages.deallocate(large, 5u << 20u, 64u);
+  pages.deallocate(small, 100u, 8u);
+  EXPECT_EQ(pages.getMappedBytes(), 0u);
+
+  NumaResource node(0);
+  EXPECT_EQ(node.getNumaNode(), 0);
+  ResourceVector<Real> v(&node);
+  v.resize(1u << 20u, 1.0f);
+  EXPECT_EQ(v.back(), 1.0f);
+}
+
+
+TEST(MemoryResourceTest, Connections) {
+  auto counting = std::make_shared<CountingResource>();
+  Connections plain(100u, 0.5f);
+  Connections placed(100u, 0.5f);
+  placed.setMemoryResource(counting);
+  EXPECT_EQ(placed.getMemoryResource(), counting.get());
+  const size_t cells = counting->inUse;
+  EXPECT_GE(cells, 100u * sizeof(CellData));
+
+  for (Connections *c : {&plain, &placed}) {
+    for (CellIdx cell = 0u; cell < 100u; cell++) {
+      const Segment segment = c->createSegment(cell);
+      for (CellIdx presynaptic = 0u; presynaptic < 100u; presynaptic += 1u + cell % 7u)
+        c->createSynapse(segment, presynaptic, 0.3f + 0.004f * presynaptic);
+    }
+  }
+  EXPECT_GT(counting->inUse, cells);
+  EXPECT_EQ(plain, placed);
+
+  // Copies share the resource, and keep it when they change.
+  Connections copy = placed;
+  copy.destroySegment(0u);
+  copy.compact();
+  EXPECT_EQ(copy.getMemoryResource(), counting.get());
+  copy.initialize(10u, 0.5f);
+  EXPECT_EQ(copy.getMemoryResource(), counting.get());
+
+  // Back to operator new.
+  placed.setMemoryResource(nullptr);
+  EXPECT_EQ(placed.getMemoryResource(), nullptr);
+  EXPECT_EQ(plain, placed);
+  copy = Connections();
+  EXPECT_EQ(counting->inUse, 0u) << "everything was released";
+}
+
+
+TEST(MemoryResourceTest, TemporalMemory) {
+  TemporalMemory plain({64u}, 8u);
+  TemporalMemory placed({64u}, 8u);
+  placed.setMemoryResource(std::make_shared<HugePageResource>());
+  Random rng(5);
+  std::vector<SDR> sequence(4u, SDR({64u}));
+  for (auto &columns : sequence) columns.randomize(0.1f, rng);
+  for (int repeat = 0; repeat < 20; repeat++) {
+    for (const auto &columns : sequence) {
+      plain.compute(columns, true);
+      placed.compute(columns, true);
+      ASSERT_EQ(plain.getActiveCells(), placed.getActiveCells());
+    }
+  }
+  EXPECT_GT(placed.connections.numSynapses(), 0u);
+  EXPECT_EQ(plain.connections, placed.connections);
+}
+
+} // namespace testing
@@ -0,0 +1,80 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of unit tests for MovingAverageBank
+ */
+
+#include <sstream>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include <htm/utils/MovingAverage.hpp>
+#include <htm/utils/MovingAverageBank.hpp>
+#include <htm/utils/Random.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+TEST(MovingAverageBankTest, SameAsMovingAverage) {
+  const UInt numStreams = 9u;
+  MovingAverageBank bank(numStreams, 4u);
+  std::vector<MovingAverage> single(numStreams, MovingAverage(4u));
+  ASSERT_EQ(bank.getCurrentAvg(0u), 0.0f);
+
+  Random rng(42);
+  std::vector<Real> values(numStreams);
+  std::vector<Real> averages;
+  for(UInt step = 0; step < 30u; step++) {
+    for(auto &x : values) x = (Real)rng.getReal64() * 100.0f;
+    bank.compute(values, averages);
+    ASSERT_EQ(averages.size(), numStreams);
+    ASSERT_EQ(bank.size(), std::min(step + 1u, 4u));
+    for(UInt s = 0; s < numStreams; s++) {
+      ASSERT_EQ(averages[s], single[s].compute(values[s])) << "step " << step << " stream " << s;
+      ASSERT_EQ(bank.getCurrentAvg(s), single[s].getCurrentAvg());
+      ASSERT_EQ(bank.getTotal(s), single[s].getTotal());
+      ASSERT_EQ(bank.getData(s), single[s].getData());
+    }
+  }
+}
+
+
+TEST(MovingAverageBankTest, Serialization) {
+  MovingAverageBank a(5u, 3u);
+  Random rng(1);
+  std::vector<Real> values(5u);
+  std::vector<Real> va, vb;
+  for(UInt step = 0; step < 7u; step++) {
+    for(auto &x : values) x = (Real)rng.getReal64();
+    a.compute(values, va);
+  }
+  std::stringstream ss;
+  a.save(ss);
+  MovingAverageBank b;
+  b.load(ss);
+  ASSERT_EQ(a, b);
+
+  for(auto &x : values) x = (Real)rng.getReal64();
+  a.compute(values, va);
+  b.compute(values, vb);
+  EXPECT_EQ(va, vb);
+  EXPECT_ANY_THROW(a.compute(std::vector<Real>(4u), va));
+}
+
+} // namespace testing
@@ -25,7 +25,9 @@
 #include <htm/utils/Log.hpp>
 #include <htm/os/Timer.hpp>
 
+#include <algorithm>
 #include <fstream>
+#include <numeric>
 #include <sstream>
 #include <vector>
 
@@ -141,6 +143,58 @@ TEST(RandomTest, testSerialization) { // test serialization/deserialization usin
 }
 
 
+TEST(RandomTest, CounterEngine) {
+  Random r(42u, Random::COUNTER);
+  EXPECT_EQ(r.getEngine(), Random::COUNTER);
+  std::vector<UInt32> first;
+  for (int i = 0; i < 3; i++) first.push_back(r.getUInt32());
+  const std::vector<UInt32> exp = {3184996902u, 686809907u, 1196582743u};
+  EXPECT_EQ(first, exp) << "same on all platforms";
+  EXPECT_EQ(r.getSteps(), 3u);
+
+  // seek both ways
+  r.seek(1000000000000u);
+  const UInt32 far = r.getUInt32();
+  r.seek(1u);
+  EXPECT_EQ(r.getUInt32(), first[1]);
+  Random other(42u, Random::COUNTER);
+  other.seek(1000000000000u);
+  EXPECT_EQ(other.getUInt32(), far);
+  EXPECT_NE(Random(42u), Random(42u, Random::COUNTER));
+
+  // the state survives serialization
+  std::stringstream ss;
+  r.save(ss);
+  Random loaded;
+  loaded.load(ss);
+  EXPECT_EQ(loaded, r);
+  EXPECT_EQ(loaded.getUInt32(), r.getUInt32());
+
+  // streams are deterministic and differ from each other
+  Random s0 = r.split(0u), s1 = r.split(1u);
+  EXPECT_EQ(s0, Random(42u, Random::COUNTER).split(0u));
+  EXPECT_EQ(s0.getEngine(), Random::COUNTER);
+  EXPECT_NE(s0.getSeed(), s1.getSeed());
+  EXPECT_NE(s0.getUInt32(), s1.getUInt32());
+
+  // roughly uniform
+  std::vector<UInt> histogram(10u, 0u);
+  for (int i = 0; i < 10000; i++) histogram[s0.getUInt32(10u)]++;
+  for (const UInt h : histogram) {
+    EXPECT_GT(h, 900u);
+    EXPECT_LT(h, 1100u);
+  }
+  EXPECT_GE(s0.getReal64(), 0.0);
+
+  // MT19937 only seeks forward
+  Random mt(42u), ahead(42u);
+  for (int i = 0; i < 10; i++) mt.getUInt32();
+  ahead.seek(10u);
+  EXPECT_EQ(mt, ahead);
+  EXPECT_ANY_THROW(ahead.seek(5u));
+}
+
+
 TEST(RandomTest, ReturnInCorrectRange) {
   // make sure that we are returning values in the correct range
   // @todo perform statistical tests
@@ -232,6 +286,42 @@ TEST(RandomTest, Sampling) {
 }
 
 
+TEST(RandomTest, SamplingInPlace) {
+  vector<UInt> population(1000u);
+  std::iota(population.begin(), population.end(), 0u);
+  Random r(17);
+  Random same(17);
+
+  vector<UInt> pop(population);
+  const auto end = r.sampleInPlace(pop.begin(), pop.end(), 5u);
+  ASSERT_EQ(end, pop.begin() + 5);
+  const vector<UInt> choices(pop.begin(), end);
+  const vector<UInt> exp = {559u, 97u, 591u, 346u, 30u};
+  EXPECT_EQ(choices, exp) << "same on all platforms";
+  // the rest is still the population
+  std::sort(pop.begin(), pop.end());
+  EXPECT_EQ(pop, population);
+
+  // exactly one random number per choice
+  for (int i = 0; i < 5; i++) same.getUInt32();
+  EXPECT_EQ(r.getUInt32(), same.getUInt32());
+
+  // into a reused buffer, same as in place
+  Random r1(42), r2(42);
+  vector<UInt> buffer;
+  r1.sample(population, 10u, buffer);
+  pop = population;
+  EXPECT_EQ(buffer, vector<UInt>(pop.begin(), r2.sampleInPlace(pop.begin(), pop.end(), 10u)));
+  const auto capacity = buffer.capacity();
+  r1.sample(population, 3u, buffer);
+  EXPECT_EQ(buffer.size(), 3u);
+  EXPECT_EQ(buffer.capacity(), capacity);
+
+  EXPECT_EQ(r.sampleInPlace(pop.begin(), pop.end(), 0u), pop.begin());
+  EXPECT_ANY_THROW(r.sampleInPlace(pop.begin(), pop.begin() + 2, 3u));
+}
+
+
 TEST(RandomTest, Shuffling) {
   // tests for shuffling
   Random r(1);
@@ -261,6 +261,41 @@ TEST(SdrMetricsTest, TestAF_LongTerm) {
     }
 }
 
+/*
+ * ActivationFrequency
+ * Verify that the lazily decayed frequencies match a moving average which
+ * updates every bit, in both averaging modes.
+ */
+TEST(SdrMetricsTest, TestAF_Lazy) {
+    const UInt period = 50u;
+    for(const Real initialValue : { -1.0f, 0.1f }) {
+        SDR A({ 1000u });
+        ActivationFrequency F( A, period, initialValue );
+        vector<Real64> expected( A.size, initialValue );
+        Random rng( 42u );
+        for(UInt t = 1u; t <= 300u; t++) {
+            A.randomize( 0.02f, rng );
+            const Real64 alpha = initialValue == -1.0f ? 1.0 / std::min( t, period )
+                                                       : 1.0 / period;
+            for(auto &e : expected) e *= 1.0 - alpha;
+            for(const auto idx : A.getSparse()) expected[idx] += alpha;
+
+            if( t % 37u == 0u ) { // some bits are read before others
+                for(UInt bit = 0u; bit < A.size; bit += 7u)
+                    ASSERT_NEAR( F.activationFrequency[bit], expected[bit], 1e-5 ) << t;
+            }
+        }
+        ASSERT_EQ( F.activationFrequency.size(), A.size );
+        Real64 sum = 0.0;
+        for(UInt bit = 0u; bit < A.size; bit++) {
+            ASSERT_NEAR( F.activationFrequency.vector()[bit], expected[bit], 1e-5 );
+            sum += expected[bit];
+        }
+        EXPECT_NEAR( F.mean(), sum / A.size, 1e-5 );
+        EXPECT_NEAR( F.max(), *std::max_element( expected.begin(), expected.end() ), 1e-5 );
+    }
+}
+
 TEST(SdrMetricsTest, TestAF_Entropy) {
     const auto size    = 1000u; // Num bits in SDR.
     const auto period  =  100u; // For activation frequency exp-rolling-avg
@@ -3,7 +3,7 @@
 
 namespace testing { 
     
-using htm::util::SlidingWindow;
+using htm::SlidingWindow;
 
 
 TEST(SlidingWindow, Instance)
@@ -12,13 +12,13 @@ TEST(SlidingWindow, Instance)
   const std::vector<int> iv{1,2,3};
   const SlidingWindow<int> w2{3, std::begin(iv), std::end(iv)};
 
-    ASSERT_EQ(w.size(), 0);
+    ASSERT_EQ(w.size(), 0u);
     ASSERT_EQ(w.ID, "test");
     ASSERT_EQ(w.DEBUG, 1);
-    ASSERT_EQ(w2.size(), 3);
+    ASSERT_EQ(w2.size(), 3u);
     ASSERT_TRUE(w.maxCapacity == w2.maxCapacity ); // ==3
     w.append(4);
-    ASSERT_EQ(w.size(), 1);
+    ASSERT_EQ(w.size(), 1u);
     ASSERT_EQ(w.getData(), w.getLinearizedData());
     w.append(1);
     ASSERT_EQ(w[1], w2[0]); //==1
@@ -31,4 +31,51 @@ TEST(SlidingWindow, Instance)
     ASSERT_EQ(w, w2);
     ASSERT_NE(w.getData(), w2.getData()); // linearized data are same, but internal buffer representations are not
 }
-}
\ No newline at end of file
+
+
+TEST(SlidingWindow, SpansAndStatistics)
+{
+  SlidingWindow<htm::Real> dynamic{4};
+  SlidingWindow<htm::Real, 4> fixed;
+  ASSERT_EQ(fixed.maxCapacity, 4u);
+  ASSERT_TRUE(fixed.getSpans().first.empty());
+  ASSERT_EQ(fixed.mean(), 0.0);
+  ASSERT_ANY_THROW((SlidingWindow<htm::Real, 4>(5)));
+
+  const std::vector<htm::Real> values{1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f};
+  for(size_t n = 0; n < values.size(); n++) {
+    dynamic.append(values[n]);
+    fixed.append(values[n]);
+
+    // the spans are the linearized data, oldest first
+    const auto spans = fixed.getSpans();
+    std::vector<htm::Real> joined(spans.first.begin(), spans.first.end());
+    joined.insert(joined.end(), spans.second.begin(), spans.second.end());
+    ASSERT_EQ(joined, dynamic.getLinearizedData()) << n;
+    ASSERT_EQ(fixed.getLinearizedData(), dynamic.getLinearizedData()) << n;
+
+    htm::Real64 sum = 0.0, sumSquares = 0.0;
+    for(const auto v : joined) { sum += v; sumSquares += v * v; }
+    const htm::Real64 mean = sum / joined.size();
+    ASSERT_DOUBLE_EQ(dynamic.sum(), sum) << n;
+    ASSERT_DOUBLE_EQ(fixed.sum(), sum) << n;
+    ASSERT_DOUBLE_EQ(fixed.sumOfSquares(), sumSquares) << n;
+    ASSERT_DOUBLE_EQ(fixed.mean(), mean) << n;
+    ASSERT_NEAR(fixed.variance(), sumSquares / joined.size() - mean * mean, 1e-12) << n;
+  }
+  ASSERT_EQ(fixed.getSpans().first.size() + fixed.getSpans().second.size(), 4u);
+  ASSERT_DOUBLE_EQ(fixed.variance(), 1.25); // 6,7,8,9
+
+  // serialization restores the statistics
+  std::stringstream ss;
+  fixed.saveToStream_ar(ss);
+  SlidingWindow<htm::Real, 4> loaded;
+  loaded.loadFromStream_ar(ss);
+  ASSERT_EQ(loaded, fixed);
+  ASSERT_DOUBLE_EQ(loaded.sum(), 30.0);
+
+  fixed.clear();
+  ASSERT_EQ(fixed.size(), 0u);
+  ASSERT_EQ(fixed.sum(), 0.0);
+}
+}
@@ -0,0 +1,88 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+
+#include "gtest/gtest.h"
+
+#include <thread>
+#include <vector>
+
+#include "htm/utils/SpscQueue.hpp"
+
+namespace testing {
+
+using namespace htm;
+
+TEST(SpscQueue, FullAndEmpty) {
+  SpscQueue<int> q(2);
+  ASSERT_EQ(q.capacity(), 2u);
+  ASSERT_TRUE(q.empty());
+  ASSERT_EQ(q.front(), nullptr);
+
+  *q.back() = 1; q.push();
+  *q.back() = 2; q.push();
+  ASSERT_EQ(q.back(), nullptr) << "full";
+
+  ASSERT_EQ(*q.front(), 1); q.pop();
+  *q.back() = 3; q.push(); // wraps around
+  ASSERT_EQ(*q.front(), 2); q.pop();
+  ASSERT_EQ(*q.front(), 3); q.pop();
+  ASSERT_TRUE(q.empty());
+
+  ASSERT_ANY_THROW(SpscQueue<int>(0));
+}
+
+TEST(SpscQueue, SlotsKeepTheirBuffers) {
+  SpscQueue<std::vector<int>> q(3, std::vector<int>(5, 0));
+  for (int round = 0; round < 10; round++) {
+    auto *slot = q.back();
+    ASSERT_NE(slot, nullptr);
+    ASSERT_EQ(slot->size(), 5u);
+    (*slot)[0] = round;
+    q.push();
+    ASSERT_EQ((*q.front())[0], round);
+    q.pop();
+  }
+}
+
+TEST(SpscQueue, ProducerConsumer) {
+  const int N = 100000;
+  SpscQueue<int> q(16);
+  std::thread producer([&]() {
+    for (int i = 0; i < N; i++) {
+      int *slot;
+      while ((slot = q.back()) == nullptr) std::this_thread::yield();
+      *slot = i;
+      q.push();
+    }
+  });
+  long long sum = 0;
+  bool ordered = true;
+  for (int i = 0; i < N; i++) {
+    int *slot;
+    while ((slot = q.front()) == nullptr) std::this_thread::yield();
+    ordered = ordered && *slot == i;
+    sum += *slot;
+    q.pop();
+  }
+  producer.join();
+  ASSERT_TRUE(ordered);
+  ASSERT_EQ(sum, (long long)N * (N - 1) / 2);
+  ASSERT_TRUE(q.empty());
+}
+
+} // namespace testing
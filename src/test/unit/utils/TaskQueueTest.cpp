@@ -0,0 +1,99 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of unit tests for TaskQueue
+ */
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include <htm/utils/TaskQueue.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+TEST(TaskQueueTest, RunsAll) {
+  TaskQueue queue(4u);
+  EXPECT_EQ(queue.size(), 4u);
+  std::atomic<int> sum{0};
+  for(int i = 1; i <= 100; i++) {
+    queue.submit(nullptr, [&sum, i]() { sum += i; });
+  }
+  queue.wait();
+  EXPECT_EQ(sum.load(), 5050);
+  EXPECT_EQ(queue.pending(), 0u);
+}
+
+
+TEST(TaskQueueTest, SameKeyInOrder) {
+  // Many keys on few threads: each key's tasks never overlap and keep their
+  // order, while the keys run in parallel.
+  TaskQueue queue(4u);
+  constexpr int numKeys = 16, numSteps = 50;
+  std::vector<std::vector<int>> steps(numKeys);
+  std::vector<std::atomic<int>> running(numKeys);
+  std::atomic<bool> overlapped{false};
+  for(int step = 0; step < numSteps; step++) {
+    for(int key = 0; key < numKeys; key++) {
+      queue.submit(&steps[key], [&, key, step]() {
+        if(running[key]++ != 0) overlapped = true;
+        steps[key].push_back(step);
+        std::this_thread::sleep_for(std::chrono::microseconds(10));
+        running[key]--;
+      });
+    }
+  }
+  queue.wait();
+  EXPECT_FALSE(overlapped.load());
+  for(const auto &keySteps : steps) {
+    ASSERT_EQ(keySteps.size(), (size_t)numSteps);
+    for(int step = 0; step < numSteps; step++) {
+      ASSERT_EQ(keySteps[step], step);
+    }
+  }
+}
+
+
+TEST(TaskQueueTest, FailedTaskIsDropped) {
+  TaskQueue queue(2u);
+  int key = 0;
+  int after = 0;
+  queue.submit(&key, []() { throw std::runtime_error("bad step"); });
+  queue.submit(&key, [&after]() { after = 1; });
+  queue.wait();
+  EXPECT_EQ(after, 1) << "The next task of the key still runs";
+}
+
+
+TEST(TaskQueueTest, DestructorRunsQueued) {
+  std::atomic<int> done{0};
+  {
+    TaskQueue queue(1u);
+    for(int i = 0; i < 20; i++) {
+      queue.submit(&done, [&done]() { done++; });
+    }
+  }
+  EXPECT_EQ(done.load(), 20);
+}
+
+} // namespace testing
@@ -0,0 +1,104 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "htm/utils/ThreadPool.hpp"
+
+namespace testing {
+
+using namespace htm;
+
+TEST(ThreadPool, Size) {
+  ThreadPool one(1);
+  ASSERT_EQ(one.size(), 1u);
+  ThreadPool four(4);
+  ASSERT_EQ(four.size(), 4u);
+  ThreadPool automatic;
+  ASSERT_GE(automatic.size(), 1u);
+}
+
+TEST(ThreadPool, ParallelFor) {
+  ThreadPool pool(4);
+  for(const size_t n : {0u, 1u, 3u, 100u}) {
+    std::vector<int> visited(n, 0);
+    pool.parallelFor(n, [&](size_t i) { visited[i]++; });
+    ASSERT_EQ(visited, std::vector<int>(n, 1)) << "n = " << n;
+  }
+
+  // the pool is reused between loops
+  std::atomic<size_t> sum{0};
+  for(size_t round = 0; round < 50; round++) {
+    pool.parallelFor(10, [&](size_t i) { sum += i; });
+  }
+  ASSERT_EQ(sum, 50u * 45u);
+}
+
+TEST(ThreadPool, Exception) {
+  ThreadPool pool(3);
+  EXPECT_THROW(pool.parallelFor(20, [](size_t i) {
+      if(i == 7) throw std::runtime_error("task failed"); }),
+    std::runtime_error);
+
+  // still usable after the error
+  std::atomic<size_t> count{0};
+  pool.parallelFor(20, [&](size_t) { count++; });
+  ASSERT_EQ(count, 20u);
+}
+
+TEST(ThreadPool, Pinning) {
+  const std::vector<int> all = ThreadPool::currentThreadCpus();
+  if(all.empty()) GTEST_SKIP() << "no thread affinity on this system";
+  const std::vector<int> one = {all.back()};
+  {
+    ThreadPool::PinScope pin(one);
+    EXPECT_EQ(ThreadPool::currentThreadCpus(), one);
+  }
+  EXPECT_EQ(ThreadPool::currentThreadCpus(), all);
+
+  ThreadPool pool(3);
+  pool.pinWorkers(one);
+  std::atomic<size_t> pinned{0};
+  pool.forEachWorker([&](size_t) { if(ThreadPool::currentThreadCpus() == one) pinned++; });
+  EXPECT_EQ(pinned, 2u);
+  EXPECT_EQ(ThreadPool::currentThreadCpus(), all); // not the caller
+}
+
+TEST(ThreadPool, Placement) {
+  Placement any;
+  EXPECT_TRUE(any.empty());
+  EXPECT_TRUE(any.cpuSet().empty());
+  EXPECT_EQ(any.node(), -1);
+
+  Placement cpus;
+  cpus.cpus = {0, 1};
+  EXPECT_FALSE(cpus.empty());
+  EXPECT_EQ(cpus.cpuSet(), cpus.cpus);
+  EXPECT_EQ(cpus.node(), ThreadPool::numaNodeOf(0));
+
+  Placement node;
+  node.numaNode = 0;
+  EXPECT_EQ(node.node(), 0);
+  EXPECT_EQ(node.cpuSet(), ThreadPool::numaNodeCpus(0u));
+}
+
+} // namespace testing
@@ -19,6 +19,7 @@
  * Unit tests for Topology.hpp
  */
 
+#include <algorithm>
 #include "gtest/gtest.h"
 #include <htm/utils/Topology.hpp>
 
@@ -413,4 +414,66 @@ ASSERT_TRUE(centerFound_) << "Center was not included in hood!";
 
 }
 
+TEST(TopologyTest, NeighborhoodRanges) {
+  // Same points as Neighborhood (incl. center), in ascending order.
+  for(const vector<UInt> &dims : vector<vector<UInt>>{{10}, {7, 9}, {4, 5, 3}}) {
+    UInt numPoints = 1;
+    for(const auto d : dims) numPoints *= d;
+    for(const bool wrap : {false, true}) {
+      for(const UInt radius : {0u, 1u, 2u, 4u, 9u}) {
+        NeighborhoodRanges ranges(radius, dims, wrap);
+        for(UInt center = 0; center < numPoints; center++) {
+          vector<UInt> expected;
+          for(const auto i : Neighborhood(center, radius, dims, wrap)) {
+            expected.push_back(i);
+          }
+          std::sort(expected.begin(), expected.end());
+
+          const UInt size = ranges.setCenter(center);
+          vector<UInt> actual;
+          ranges.forEach([&](const UInt i) { actual.push_back(i); return true; });
+          ASSERT_EQ(expected, actual) << "center " << center << " radius " << radius << " wrap " << wrap;
+          ASSERT_EQ(size, actual.size());
+
+          // stops when visit returns false
+          actual.clear();
+          ranges.forEach([&](const UInt i) { actual.push_back(i); return actual.size() < 2u; });
+          ASSERT_EQ(actual.size(), std::min<size_t>(2u, expected.size()));
+        }
+      }
+    }
+  }
+}
+
+TEST(TopologyTest, NeighborhoodStencil) {
+  // Same points as Neighborhood, in the same order.
+  for(const vector<UInt> &dims : vector<vector<UInt>>{{10}, {7, 9}, {4, 5, 3}, {6, 6, 6}}) {
+    UInt numPoints = 1;
+    for(const auto d : dims) numPoints *= d;
+    for(const bool wrap : {false, true}) {
+      for(const bool skipCenter : {false, true}) {
+        for(const UInt radius : {0u, 1u, 2u, 4u, 9u}) {
+          NeighborhoodStencil stencil(radius, dims, wrap, skipCenter);
+          for(UInt center = 0; center < numPoints; center++) {
+            vector<UInt> expected;
+            for(const auto i : Neighborhood(center, radius, dims, wrap)) {
+              if(not (skipCenter and i == center)) expected.push_back(i);
+            }
+
+            vector<UInt> actual;
+            stencil.forEachNeighbor(center, [&](const UInt i) { actual.push_back(i); return true; });
+            ASSERT_EQ(expected, actual) << "center " << center << " radius " << radius
+                                        << " wrap " << wrap << " skipCenter " << skipCenter;
+
+            // stops when visit returns false
+            actual.clear();
+            stencil.forEachNeighbor(center, [&](const UInt i) { actual.push_back(i); return actual.size() < 2u; });
+            ASSERT_EQ(actual.size(), std::min<size_t>(2u, expected.size()));
+          }
+        }
+      }
+    }
+  }
+}
+
 } // namespace
@@ -0,0 +1,98 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+#include "gtest/gtest.h"
+
+#include <htm/engine/Network.hpp>
+#include <htm/ntypes/Value.hpp>
+#include <htm/utils/Tracer.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+static size_t countOf(const std::string &s, const std::string &what) {
+  size_t n = 0u;
+  for (size_t p = s.find(what); p != std::string::npos; p = s.find(what, p + 1u))
+    n++;
+  return n;
+}
+
+static void addTwoRegions(Network &net) {
+  net.addRegion("level1", "TestNode", "{dim: [4,2]}");
+  net.addRegion("level2", "TestNode", "{dim: [2,2]}");
+  net.link("level1", "level2");
+  net.initialize();
+}
+
+TEST(TracerTest, Disabled) {
+  Tracer::clear();
+  Network net;
+  addTwoRegions(net);
+  net.run(3);
+  EXPECT_FALSE(Tracer::isActive());
+  EXPECT_EQ(countOf(Tracer::toChromeJSON(), "\"ph\": \"X\""), 0u);
+}
+
+TEST(TracerTest, Sampled) {
+  Network net;
+  addTwoRegions(net);
+  Tracer::clear();
+  Tracer::enable(2u);
+  net.run(4);
+  Tracer::disable();
+
+  const std::string json = Tracer::toChromeJSON();
+  Value v;
+  v.parse(json); // valid JSON
+  EXPECT_EQ(countOf(json, "\"name\": \"iteration 2\""), 1u);
+  EXPECT_EQ(countOf(json, "\"name\": \"iteration 4\""), 1u);
+  EXPECT_EQ(countOf(json, "\"name\": \"iteration 1\""), 0u);
+  // per sampled iteration: 2 regions, their inputs and 1 link
+  EXPECT_EQ(countOf(json, "\"cat\": \"compute\""), 4u);
+  EXPECT_EQ(countOf(json, "\"cat\": \"prepareInputs\""), 4u);
+  EXPECT_EQ(countOf(json, "\"cat\": \"link\""), 2u);
+  EXPECT_NE(json.find("\"name\": \"level1.bottomUpOut-->level2.bottomUpIn\""), std::string::npos);
+  EXPECT_NE(json.find("\"copy\": \"shallow\", \"type\": \"Real64\""), std::string::npos);
+  EXPECT_FALSE(Tracer::isActive());
+
+  // nothing is recorded once disabled
+  net.run(2);
+  EXPECT_EQ(Tracer::toChromeJSON(), json);
+  Tracer::clear();
+}
+
+TEST(TracerTest, RingKeepsNewest) {
+  Network net;
+  addTwoRegions(net);
+  Tracer::enable(1u, 3u);
+  Tracer::clear();
+  net.run(5);
+  Tracer::disable();
+  const std::string json = Tracer::toChromeJSON();
+  EXPECT_EQ(countOf(json, "\"ph\": \"X\""), 3u);
+  // the iteration span ends last
+  EXPECT_EQ(countOf(json, "\"name\": \"iteration 5\""), 1u);
+  EXPECT_EQ(countOf(json, "\"name\": \"iteration 4\""), 0u);
+  Tracer::enable(1u, 65536u);
+  Tracer::disable();
+  Tracer::clear();
+
+  EXPECT_ANY_THROW(Tracer::enable(0u));
+}
+
+} // namespace testing
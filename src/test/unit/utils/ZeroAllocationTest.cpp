@@ -0,0 +1,177 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * The hot paths do not allocate once warmed up, see AllocationCounter.
+ */
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "AllocationCounter.hpp"
+
+#include <htm/algorithms/SDRClassifier.hpp>
+#include <htm/algorithms/SpatialPooler.hpp>
+#include <htm/algorithms/TemporalMemory.hpp>
+#include <htm/encoders/RandomDistributedScalarEncoder.hpp>
+#include <htm/encoders/ScalarEncoder.hpp>
+#include <htm/engine/Network.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/utils/Random.hpp>
+
+namespace testing {
+
+using namespace htm;
+using std::vector;
+
+static const size_t WARMUP = 20u; // steps before counting
+static const size_t STEPS = 100u; // steps counted
+static const size_t NUM_INPUTS = 10u;
+
+static vector<SDR> randomInputs(const vector<UInt> &dimensions, Real sparsity) {
+  Random rng(42);
+  vector<SDR> inputs(NUM_INPUTS, SDR(dimensions));
+  for (auto &input : inputs) input.randomize(sparsity, rng);
+  return inputs;
+}
+
+TEST(ZeroAllocationTest, Counter) {
+  AllocationCounter counter;
+  EXPECT_EQ(counter.count(), 0u);
+  int sum = 0;
+  for (int i = 0; i < 100; i++) sum += i;
+  EXPECT_EQ(counter.count(), 0u);
+  {
+    vector<int> v(10, sum);
+    auto p = std::make_shared<double>(1.0);
+    const std::string s(100u, 'x');
+    EXPECT_EQ(v[9] + static_cast<int>(*p) + s.size(), 5051u);
+  }
+  EXPECT_EQ(counter.count(), 3u);
+  EXPECT_GE(AllocationCounter::total(), 3u);
+}
+
+// The SP allocates the active columns of the inhibition and their ties, and
+// when learning the synapses which it grows, but nothing per column.
+TEST(ZeroAllocationTest, SpatialPooler) {
+  SpatialPooler sp({1000u}, {2048u});
+  const auto inputs = randomInputs({1000u}, 0.05f);
+  SDR columns({2048u});
+  for (size_t i = 0u; i < WARMUP; i++) sp.compute(inputs[i % NUM_INPUTS], true, columns);
+
+  AllocationCounter learning;
+  for (size_t i = 0u; i < STEPS; i++) sp.compute(inputs[i % NUM_INPUTS], true, columns);
+  EXPECT_LE(learning.count(), 16u * STEPS);
+
+  AllocationCounter inference;
+  for (size_t i = 0u; i < STEPS; i++) sp.compute(inputs[i % NUM_INPUTS], false, columns);
+  EXPECT_LE(inference.count(), 12u * STEPS);
+}
+
+// The TM allocates at most about once per active column (the least used
+// cells of a bursting column), never per cell or segment.
+TEST(ZeroAllocationTest, TemporalMemory) {
+  TemporalMemory tm({2048u}, 8u);
+  const auto inputs = randomInputs({2048u}, 0.02f);
+  const size_t activeColumns = inputs[0].getSum();
+  for (size_t epoch = 0u; epoch < WARMUP; epoch++) {
+    for (const auto &input : inputs) tm.compute(input, true);
+  }
+
+  AllocationCounter learning;
+  for (size_t i = 0u; i < STEPS; i++) tm.compute(inputs[i % NUM_INPUTS], true);
+  EXPECT_LE(learning.count(), activeColumns * STEPS);
+
+  AllocationCounter inference;
+  for (size_t i = 0u; i < STEPS; i++) tm.compute(inputs[i % NUM_INPUTS], false);
+  EXPECT_LE(inference.count(), activeColumns * STEPS);
+}
+
+// infer() allocates only the PDF it returns.
+TEST(ZeroAllocationTest, Classifier) {
+  Classifier classifier;
+  const auto inputs = randomInputs({1000u}, 0.05f);
+  for (UInt i = 0u; i < NUM_INPUTS; i++) classifier.learn(inputs[i], {i});
+  for (size_t i = 0u; i < WARMUP; i++) classifier.infer(inputs[i % NUM_INPUTS]);
+
+  AllocationCounter inference;
+  for (size_t i = 0u; i < STEPS; i++) classifier.infer(inputs[i % NUM_INPUTS]);
+  EXPECT_LE(inference.count(), STEPS);
+
+  AllocationCounter topK;
+  for (size_t i = 0u; i < STEPS; i++) classifier.inferTopK(inputs[i % NUM_INPUTS], 3u);
+  EXPECT_LE(topK.count(), 2u * STEPS);
+
+  AllocationCounter learning; // of known categories
+  for (size_t i = 0u; i < STEPS; i++) classifier.learn(inputs[i % NUM_INPUTS], {static_cast<UInt>(i % NUM_INPUTS)});
+  EXPECT_LE(learning.count(), STEPS);
+}
+
+TEST(ZeroAllocationTest, Encoders) {
+  RDSE_Parameters rdseParams;
+  rdseParams.size = 1000u;
+  rdseParams.sparsity = 0.02f;
+  rdseParams.resolution = 0.1f;
+  RandomDistributedScalarEncoder rdse(rdseParams);
+  SDR rdseOut({1000u});
+  ScalarEncoderParameters scalarParams;
+  scalarParams.minimum = -1.0;
+  scalarParams.maximum = 1.0;
+  scalarParams.size = 1000u;
+  scalarParams.activeBits = 20u;
+  ScalarEncoder scalar(scalarParams);
+  SDR scalarOut({1000u});
+  for (size_t i = 0u; i < WARMUP; i++) {
+    rdse.encode(std::sin(0.1 * i), rdseOut);
+    scalar.encode(std::sin(0.1 * i), scalarOut);
+  }
+
+  AllocationCounter allocations;
+  for (size_t i = 0u; i < STEPS; i++) {
+    rdse.encode(std::sin(0.1 * i), rdseOut);
+    scalar.encode(std::sin(0.1 * i), scalarOut);
+  }
+  EXPECT_EQ(allocations.count(), 0u);
+}
+
+// The engine adds a few allocations per step to those of the SP and TM.
+TEST(ZeroAllocationTest, NetworkRun) {
+  Network net;
+  auto encoder = net.addRegion("encoder", "RDSEEncoderRegion", "{size: 1000, sparsity: 0.2, radius: 0.03, seed: 2019}");
+  net.addRegion("sp", "SPRegion", "{columnCount: 1024, globalInhibition: true, learningMode: 0}");
+  net.addRegion("tm", "TMRegion", "{cellsPerColumn: 8, orColumnOutputs: true, learningMode: false}");
+  net.link("encoder", "sp", "", "", "encoded", "bottomUpIn");
+  net.link("sp", "tm", "", "", "bottomUpOut", "bottomUpIn");
+  net.initialize();
+  const auto step = [&](const size_t i) {
+    encoder->setParameterReal64("sensedValue", std::sin(0.1 * static_cast<Real64>(i % 20u)));
+    net.run(1);
+  };
+  for (size_t i = 0u; i < WARMUP; i++) step(i);
+
+  AllocationCounter allocations;
+  for (size_t i = 0u; i < STEPS; i++) step(i);
+  // the SP's and the TM's, see above; all columns burst in the untrained TM
+  const size_t activeColumns = net.getRegion("sp")->getOutputData("bottomUpOut").getSDR().getSum();
+  EXPECT_LE(allocations.count(), (16u + 2u * activeColumns) * STEPS);
+}
+
+} // namespace testing
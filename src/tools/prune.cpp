@@ -0,0 +1,165 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * htm_prune: prune a trained SpatialPooler, TemporalMemory or Network saved
+ * with saveToFile(), see htm/algorithms/ModelPruning.hpp.
+ *
+ *   htm_prune (--sp | --tm | --network) IN OUT
+ *             [--min-permanence P] [--max-segment-age N]
+ *             [--validate RECORDS] [--steps N] [--tolerance T]
+ *
+ * --validate: for --sp and --tm, a text file with one record per line, the
+ *   sparse indices of the SP's input or of the TM's active columns.  Both
+ *   models run on it without learning and the steps where they differ are
+ *   counted.
+ * --steps: for --network, run both networks N iterations; their sensors must
+ *   read their data themselves (e.g. a FileInputRegion).
+ *
+ * Exit status is 2 on errors.
+ */
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <htm/algorithms/ModelPruning.hpp>
+#include <htm/algorithms/SpatialPooler.hpp>
+#include <htm/algorithms/TemporalMemory.hpp>
+#include <htm/engine/Network.hpp>
+#include <htm/utils/Log.hpp>
+
+using namespace std;
+using namespace htm;
+
+namespace {
+
+struct Options {
+  string model;   // "sp", "tm" or "network"
+  string in;
+  string out;
+  PruneOptions prune;
+  string records; // validation stream of --sp, --tm
+  size_t steps = 0u;
+  Real tolerance = 0.0f;
+};
+
+/** One SDR of dimensions per line of sparse indices, separated by spaces or commas. */
+vector<SDR> readRecords(const string &path, const vector<UInt> &dimensions) {
+  ifstream f(path);
+  NTA_CHECK(f.is_open()) << "Cannot open " << path;
+  vector<SDR> records;
+  string line;
+  while (getline(f, line)) {
+    for (auto &c : line)
+      if (c == ',') c = ' ';
+    istringstream fields(line);
+    SDR_sparse_t sparse;
+    UInt index;
+    while (fields >> index)
+      sparse.push_back(index);
+    records.emplace_back(dimensions);
+    records.back().setSparse(sparse);
+  }
+  return records;
+}
+
+ValidationReport check(SpatialPooler &original, SpatialPooler &pruned, const vector<SDR> &records, Real) {
+  return validate(original, pruned, records);
+}
+
+ValidationReport check(TemporalMemory &original, TemporalMemory &pruned, const vector<SDR> &records,
+                       const Real tolerance) {
+  return validate(original, pruned, records, tolerance);
+}
+
+/** @param dimensions - of the validation records */
+template <class Model> void pruneModel(const Options &o, Model &model, const vector<UInt> &dimensions) {
+  unique_ptr<Model> original;
+  if (!o.records.empty()) {
+    original.reset(new Model());
+    original->loadFromFile(o.in);
+  }
+  cout << prune(model, o.prune);
+  model.saveToFile(o.out);
+  if (original)
+    cout << check(*original, model, readRecords(o.records, dimensions), o.tolerance);
+}
+
+} // namespace
+
+
+int main(int argc, char *argv[]) {
+  Options o;
+  try {
+    vector<string> paths;
+    for (int a = 1; a < argc; a++) {
+      const string arg = argv[a];
+      const auto value = [&]() -> string {
+        NTA_CHECK(a + 1 < argc) << "Missing value of " << arg;
+        return argv[++a];
+      };
+      if      (arg == "--sp")              o.model = "sp";
+      else if (arg == "--tm")              o.model = "tm";
+      else if (arg == "--network")         o.model = "network";
+      else if (arg == "--min-permanence")  o.prune.minPermanence = stof(value());
+      else if (arg == "--max-segment-age") o.prune.maxSegmentAge = static_cast<UInt32>(stoul(value()));
+      else if (arg == "--validate")        o.records = value();
+      else if (arg == "--steps")           o.steps = stoul(value());
+      else if (arg == "--tolerance")       o.tolerance = stof(value());
+      else if (arg.rfind("--", 0) == 0)    NTA_THROW << "Unknown argument " << arg << ", see the header of src/tools/prune.cpp";
+      else paths.push_back(arg);
+    }
+    NTA_CHECK(!o.model.empty() && paths.size() == 2u) << "Usage: htm_prune (--sp | --tm | --network) IN OUT [options]";
+    o.in = paths[0];
+    o.out = paths[1];
+    NTA_CHECK(o.records.empty() || o.model != "network") << "--validate is for --sp and --tm, use --steps";
+    NTA_CHECK(o.steps == 0u || o.model == "network") << "--steps is for --network, use --validate";
+
+    if (o.model == "sp") {
+      SpatialPooler sp;
+      sp.loadFromFile(o.in);
+      pruneModel(o, sp, sp.getInputDimensions());
+    } else if (o.model == "tm") {
+      TemporalMemory tm;
+      tm.loadFromFile(o.in);
+      pruneModel(o, tm, tm.getColumnDimensions());
+    } else {
+      Network net;
+      net.loadFromFile(o.in);
+      net.initialize();
+      cout << prune(net, o.prune);
+      net.saveToFile(o.out);
+      if (o.steps > 0u) {
+        Network original, pruned;
+        original.loadFromFile(o.in);
+        pruned.loadFromFile(o.out);
+        original.initialize();
+        pruned.initialize();
+        prune(original, PruneOptions()); // the same new sequence as the pruned TMs
+        cout << validate(original, pruned, o.steps, o.tolerance);
+      }
+    }
+    return 0;
+  } catch (const exception &e) {
+    cerr << "htm_prune: " << e.what() << endl;
+    return 2;
+  }
+}